@@ -0,0 +1,286 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "os/os.h"
+#include "mgmt/mgmt.h"
+#include "cborattr/cborattr.h"
+#include "host/ble_hs.h"
+#include "blebench.h"
+
+/**
+ * Newtmgr interface to the benchmarks (group MGMT_GROUP_ID_PERUSER):
+ *     o start (write): {"test": "conn" | "rtt" | "write" | "notify" | "coc",
+ *                       "addr": "aa:bb:cc:dd:ee:ff", "addr_type": n,
+ *                       "mtu": n, "tx_octets": n, "phy": 1 | 2,
+ *                       "duration": ms, "size": n, "count": n}
+ *     o result (read): parameters and figures of the last run, plus the
+ *       traffic this device has received as a benchmark peer.
+ */
+
+#define BLEBENCH_NMGR_ID_START      0
+#define BLEBENCH_NMGR_ID_RESULT     1
+
+static int blebench_nmgr_start(struct mgmt_cbuf *cb);
+static int blebench_nmgr_result(struct mgmt_cbuf *cb);
+
+static struct mgmt_group blebench_nmgr_group;
+
+static const struct mgmt_handler blebench_nmgr_handlers[] = {
+    [BLEBENCH_NMGR_ID_START] = { NULL, blebench_nmgr_start },
+    [BLEBENCH_NMGR_ID_RESULT] = { blebench_nmgr_result, NULL },
+};
+
+static const char * const blebench_nmgr_test_names[] = {
+    [BLEBENCH_TEST_CONN] = "conn",
+    [BLEBENCH_TEST_RTT] = "rtt",
+    [BLEBENCH_TEST_WRITE] = "write",
+    [BLEBENCH_TEST_NOTIFY] = "notify",
+    [BLEBENCH_TEST_COC] = "coc",
+};
+
+#define BLEBENCH_NMGR_NUM_TESTS                                             \
+    (sizeof blebench_nmgr_test_names / sizeof blebench_nmgr_test_names[0])
+
+/** Runs are started from the default task, like all other host activity. */
+static struct blebench_params blebench_nmgr_params;
+static struct os_event blebench_nmgr_start_ev;
+
+static void
+blebench_nmgr_start_ev_cb(struct os_event *ev)
+{
+    blebench_start(&blebench_nmgr_params);
+}
+
+/**
+ * Parses a colon-separated, most-significant-byte-first address string.
+ */
+static int
+blebench_nmgr_parse_addr(const char *str, uint8_t *val)
+{
+    unsigned long byte;
+    char *endptr;
+    int i;
+
+    for (i = 5; i >= 0; i--) {
+        byte = strtoul(str, &endptr, 16);
+        if (endptr == str || byte > 0xff) {
+            return -1;
+        }
+        if (i > 0 && *endptr != ':') {
+            return -1;
+        }
+        if (i == 0 && *endptr != '\0') {
+            return -1;
+        }
+
+        val[i] = byte;
+        str = endptr + 1;
+    }
+
+    return 0;
+}
+
+static int
+blebench_nmgr_start(struct mgmt_cbuf *cb)
+{
+    struct blebench_params *params;
+    long long int addr_type;
+    long long int tx_octets;
+    long long int duration;
+    long long int count;
+    long long int size;
+    long long int mtu;
+    long long int phy;
+    char test[8];
+    char addr[18];
+    int rc;
+    int i;
+
+    const struct cbor_attr_t attrs[] = {
+        { "test", CborAttrTextStringType, .addr.string = test,
+            .len = sizeof test },
+        { "addr", CborAttrTextStringType, .addr.string = addr,
+            .len = sizeof addr },
+        { "addr_type", CborAttrIntegerType, .addr.integer = &addr_type,
+            .dflt.integer = BLE_ADDR_PUBLIC },
+        { "mtu", CborAttrIntegerType, .addr.integer = &mtu,
+            .dflt.integer = BLE_ATT_MTU_DFLT },
+        { "tx_octets", CborAttrIntegerType, .addr.integer = &tx_octets,
+            .dflt.integer = 0 },
+        { "phy", CborAttrIntegerType, .addr.integer = &phy,
+            .dflt.integer = BLE_GAP_LE_PHY_1M },
+        { "duration", CborAttrIntegerType, .addr.integer = &duration,
+            .dflt.integer = 5000 },
+        { "size", CborAttrIntegerType, .addr.integer = &size,
+            .dflt.integer = 0 },
+        { "count", CborAttrIntegerType, .addr.integer = &count,
+            .dflt.integer = 100 },
+        { NULL },
+    };
+
+    test[0] = '\0';
+    addr[0] = '\0';
+    rc = cbor_read_object(&cb->it, attrs);
+    if (rc != 0) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    if (blebench_busy()) {
+        return MGMT_ERR_EBADSTATE;
+    }
+
+    params = &blebench_nmgr_params;
+    memset(params, 0, sizeof *params);
+
+    for (i = 0; i < BLEBENCH_NMGR_NUM_TESTS; i++) {
+        if (strcmp(test, blebench_nmgr_test_names[i]) == 0) {
+            break;
+        }
+    }
+    if (i >= BLEBENCH_NMGR_NUM_TESTS) {
+        return MGMT_ERR_EINVAL;
+    }
+    params->test = i;
+
+    if (blebench_nmgr_parse_addr(addr, params->peer_addr.val) != 0) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    if (addr_type < 0 || addr_type > BLE_ADDR_RANDOM_ID ||
+        mtu < 0 || mtu > BLE_ATT_MTU_MAX ||
+        tx_octets < 0 || tx_octets > 251 ||
+        (tx_octets != 0 && tx_octets < 27) ||
+        (phy != BLE_GAP_LE_PHY_1M && phy != BLE_GAP_LE_PHY_2M) ||
+        duration < 0 || duration > UINT32_MAX ||
+        size < 0 || size > BLE_ATT_ATTR_MAX_LEN ||
+        count < 0 || count > UINT16_MAX) {
+
+        return MGMT_ERR_EINVAL;
+    }
+
+    params->peer_addr.type = addr_type;
+    params->mtu = mtu;
+    params->tx_octets = tx_octets;
+    params->phy = phy;
+    params->duration_ms = duration;
+    params->size = size;
+    params->count = count;
+
+    os_eventq_put(os_eventq_dflt_get(), &blebench_nmgr_start_ev);
+
+    rc = cbor_encode_text_stringz(&cb->encoder, "rc");
+    rc |= cbor_encode_int(&cb->encoder, MGMT_ERR_EOK);
+    if (rc != 0) {
+        return MGMT_ERR_ENOMEM;
+    }
+
+    return 0;
+}
+
+static int
+blebench_nmgr_result(struct mgmt_cbuf *cb)
+{
+    const struct blebench_result *res;
+    CborError g_err = CborNoError;
+    CborEncoder rx;
+
+    res = blebench_last_result();
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "rc");
+    g_err |= cbor_encode_int(&cb->encoder, MGMT_ERR_EOK);
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "busy");
+    g_err |= cbor_encode_boolean(&cb->encoder, blebench_busy());
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "test");
+    g_err |= cbor_encode_text_stringz(&cb->encoder,
+        res->params.test < BLEBENCH_NMGR_NUM_TESTS ?
+            blebench_nmgr_test_names[res->params.test] : "");
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "status");
+    g_err |= cbor_encode_int(&cb->encoder, res->status);
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "mtu");
+    g_err |= cbor_encode_uint(&cb->encoder, res->mtu);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "tx_octets");
+    g_err |= cbor_encode_uint(&cb->encoder, res->tx_octets);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "phy");
+    g_err |= cbor_encode_uint(&cb->encoder, res->phy);
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "conn_us");
+    g_err |= cbor_encode_uint(&cb->encoder, res->conn_us);
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "elapsed_ms");
+    g_err |= cbor_encode_uint(&cb->encoder, res->elapsed_ms);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "bytes");
+    g_err |= cbor_encode_uint(&cb->encoder, res->bytes);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "packets");
+    g_err |= cbor_encode_uint(&cb->encoder, res->packets);
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "rtt_count");
+    g_err |= cbor_encode_uint(&cb->encoder, res->rtt_count);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "rtt_min_us");
+    g_err |= cbor_encode_uint(&cb->encoder, res->rtt_min_us);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "rtt_avg_us");
+    g_err |= cbor_encode_uint(&cb->encoder, res->rtt_avg_us);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "rtt_max_us");
+    g_err |= cbor_encode_uint(&cb->encoder, res->rtt_max_us);
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "rx");
+    g_err |= cbor_encoder_create_map(&cb->encoder, &rx, CborIndefiniteLength);
+    g_err |= cbor_encode_text_stringz(&rx, "write_bytes");
+    g_err |= cbor_encode_uint(&rx, blebench_rx.write_bytes);
+    g_err |= cbor_encode_text_stringz(&rx, "write_pkts");
+    g_err |= cbor_encode_uint(&rx, blebench_rx.write_pkts);
+    g_err |= cbor_encode_text_stringz(&rx, "coc_bytes");
+    g_err |= cbor_encode_uint(&rx, blebench_rx.coc_bytes);
+    g_err |= cbor_encode_text_stringz(&rx, "coc_sdus");
+    g_err |= cbor_encode_uint(&rx, blebench_rx.coc_sdus);
+    g_err |= cbor_encoder_close_container(&cb->encoder, &rx);
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+
+    return 0;
+}
+
+/**
+ * Register nmgr group handlers
+ */
+int
+blebench_nmgr_register_group(void)
+{
+    int rc;
+
+    blebench_nmgr_start_ev.ev_cb = blebench_nmgr_start_ev_cb;
+
+    MGMT_GROUP_SET_HANDLERS(&blebench_nmgr_group, blebench_nmgr_handlers);
+    blebench_nmgr_group.mg_group_id = MGMT_GROUP_ID_PERUSER;
+
+    rc = mgmt_group_register(&blebench_nmgr_group);
+    if (rc != 0) {
+        return rc;
+    }
+
+    return 0;
+}
@@ -0,0 +1,136 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_BLEBENCH_
+#define H_BLEBENCH_
+
+#include <inttypes.h>
+#include "log/log.h"
+#include "nimble/ble.h"
+#include "host/ble_uuid.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct ble_gatt_register_ctxt;
+
+extern struct log blebench_log;
+
+/* blebench uses the first "peruser" log module. */
+#define BLEBENCH_LOG_MODULE  (LOG_MODULE_PERUSER + 0)
+
+/* Convenience macro for logging to the blebench module. */
+#define BLEBENCH_LOG(lvl, ...) \
+    LOG_ ## lvl(&blebench_log, BLEBENCH_LOG_MODULE, __VA_ARGS__)
+
+/** Benchmark kinds (blebench_params::test). */
+#define BLEBENCH_TEST_CONN          0   /* Connection setup latency. */
+#define BLEBENCH_TEST_RTT           1   /* ATT read round-trip time. */
+#define BLEBENCH_TEST_WRITE         2   /* Write Without Response throughput. */
+#define BLEBENCH_TEST_NOTIFY        3   /* Notification throughput. */
+#define BLEBENCH_TEST_COC           4   /* L2CAP LE CoC throughput. */
+
+/** Parameters of a benchmark run, as supplied over newtmgr. */
+struct blebench_params {
+    uint8_t test;
+    ble_addr_t peer_addr;
+
+    /** ATT MTU to negotiate; <= 23 skips the exchange. */
+    uint16_t mtu;
+
+    /** LL TX octets to request; 0 leaves the data length untouched. */
+    uint16_t tx_octets;
+
+    /** BLE_GAP_LE_PHY_1M or BLE_GAP_LE_PHY_2M. */
+    uint8_t phy;
+
+    /** Length of a throughput run, in milliseconds. */
+    uint32_t duration_ms;
+
+    /** Payload size of each write, notification or SDU. */
+    uint16_t size;
+
+    /** Number of round trips (RTT) or connections (CONN) to measure. */
+    uint16_t count;
+};
+
+/** Outcome of the last benchmark run. */
+struct blebench_result {
+    struct blebench_params params;
+
+    /** 0 on success; BLE host error code on failure. */
+    int status;
+
+    /** Link parameters actually in effect during the measurement. */
+    uint16_t mtu;
+    uint16_t tx_octets;
+    uint8_t phy;
+
+    /** Connection setup latency (CONN: average over count attempts). */
+    uint32_t conn_us;
+
+    /** Throughput figures (WRITE, NOTIFY, COC). */
+    uint32_t elapsed_ms;
+    uint32_t bytes;
+    uint32_t packets;
+
+    /** Round-trip figures (RTT). */
+    uint32_t rtt_min_us;
+    uint32_t rtt_max_us;
+    uint32_t rtt_avg_us;
+    uint16_t rtt_count;
+};
+
+/** Traffic received while acting as the peer of a benchmark. */
+struct blebench_rx_stats {
+    uint32_t write_bytes;
+    uint32_t write_pkts;
+    uint32_t coc_bytes;
+    uint32_t coc_sdus;
+};
+
+/** GATT server. */
+extern uint16_t gatt_svr_sink_val_handle;
+extern uint16_t gatt_svr_source_val_handle;
+extern uint16_t gatt_svr_echo_val_handle;
+extern const ble_uuid128_t gatt_svr_svc_bench_uuid;
+extern const ble_uuid128_t gatt_svr_chr_sink_uuid;
+extern const ble_uuid128_t gatt_svr_chr_source_uuid;
+extern const ble_uuid128_t gatt_svr_chr_echo_uuid;
+
+void gatt_svr_register_cb(struct ble_gatt_register_ctxt *ctxt, void *arg);
+int gatt_svr_init(void);
+
+/** Benchmark engine. */
+extern struct blebench_rx_stats blebench_rx;
+
+int blebench_start(const struct blebench_params *params);
+int blebench_busy(void);
+const struct blebench_result *blebench_last_result(void);
+void blebench_notify_start(uint16_t conn_handle, uint32_t duration_ms,
+                           uint16_t size);
+
+/** Newtmgr. */
+int blebench_nmgr_register_group(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
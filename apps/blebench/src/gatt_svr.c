@@ -0,0 +1,211 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "os/endian.h"
+#include "host/ble_hs.h"
+#include "host/ble_uuid.h"
+#include "blebench.h"
+
+/**
+ * The benchmark service consists of three characteristics:
+ *     o sink: accepts writes (with or without response) and discards them,
+ *       counting the received bytes.
+ *     o source: notifies.  Writing a 6-byte control value
+ *       (duration_ms:le32, size:le16) makes the server flood notifications
+ *       of the given size for the given time.
+ *     o echo: a small readable / writable value, used to time ATT round
+ *       trips.
+ */
+
+/* 4c8c0d50-3c10-4bd2-a3d8-0e1f9d6b0a00 */
+const ble_uuid128_t gatt_svr_svc_bench_uuid =
+    BLE_UUID128_INIT(0x00, 0x0a, 0x6b, 0x9d, 0x1f, 0x0e, 0xd8, 0xa3,
+                     0xd2, 0x4b, 0x10, 0x3c, 0x50, 0x0d, 0x8c, 0x4c);
+
+/* 4c8c0d50-3c10-4bd2-a3d8-0e1f9d6b0a01 */
+const ble_uuid128_t gatt_svr_chr_sink_uuid =
+    BLE_UUID128_INIT(0x01, 0x0a, 0x6b, 0x9d, 0x1f, 0x0e, 0xd8, 0xa3,
+                     0xd2, 0x4b, 0x10, 0x3c, 0x50, 0x0d, 0x8c, 0x4c);
+
+/* 4c8c0d50-3c10-4bd2-a3d8-0e1f9d6b0a02 */
+const ble_uuid128_t gatt_svr_chr_source_uuid =
+    BLE_UUID128_INIT(0x02, 0x0a, 0x6b, 0x9d, 0x1f, 0x0e, 0xd8, 0xa3,
+                     0xd2, 0x4b, 0x10, 0x3c, 0x50, 0x0d, 0x8c, 0x4c);
+
+/* 4c8c0d50-3c10-4bd2-a3d8-0e1f9d6b0a03 */
+const ble_uuid128_t gatt_svr_chr_echo_uuid =
+    BLE_UUID128_INIT(0x03, 0x0a, 0x6b, 0x9d, 0x1f, 0x0e, 0xd8, 0xa3,
+                     0xd2, 0x4b, 0x10, 0x3c, 0x50, 0x0d, 0x8c, 0x4c);
+
+uint16_t gatt_svr_sink_val_handle;
+uint16_t gatt_svr_source_val_handle;
+uint16_t gatt_svr_echo_val_handle;
+
+static uint8_t gatt_svr_echo_val[8];
+
+static int
+gatt_svr_chr_access_bench(uint16_t conn_handle, uint16_t attr_handle,
+                          struct ble_gatt_access_ctxt *ctxt,
+                          void *arg);
+
+static const struct ble_gatt_svc_def gatt_svr_svcs[] = {
+    {
+        /*** Service: Benchmark. */
+        .type = BLE_GATT_SVC_TYPE_PRIMARY,
+        .uuid = &gatt_svr_svc_bench_uuid.u,
+        .characteristics = (struct ble_gatt_chr_def[]) { {
+            /*** Characteristic: Sink. */
+            .uuid = &gatt_svr_chr_sink_uuid.u,
+            .access_cb = gatt_svr_chr_access_bench,
+            .val_handle = &gatt_svr_sink_val_handle,
+            .flags = BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_WRITE_NO_RSP,
+        }, {
+            /*** Characteristic: Source. */
+            .uuid = &gatt_svr_chr_source_uuid.u,
+            .access_cb = gatt_svr_chr_access_bench,
+            .val_handle = &gatt_svr_source_val_handle,
+            .flags = BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_NOTIFY,
+        }, {
+            /*** Characteristic: Echo. */
+            .uuid = &gatt_svr_chr_echo_uuid.u,
+            .access_cb = gatt_svr_chr_access_bench,
+            .val_handle = &gatt_svr_echo_val_handle,
+            .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE,
+        }, {
+            0, /* No more characteristics in this service. */
+        } },
+    },
+
+    {
+        0, /* No more services. */
+    },
+};
+
+static int
+gatt_svr_chr_access_bench(uint16_t conn_handle, uint16_t attr_handle,
+                          struct ble_gatt_access_ctxt *ctxt,
+                          void *arg)
+{
+    uint8_t ctrl[6];
+    uint16_t len;
+    int rc;
+
+    if (attr_handle == gatt_svr_sink_val_handle) {
+        assert(ctxt->op == BLE_GATT_ACCESS_OP_WRITE_CHR);
+
+        blebench_rx.write_bytes += OS_MBUF_PKTLEN(ctxt->om);
+        blebench_rx.write_pkts++;
+        return 0;
+    }
+
+    if (attr_handle == gatt_svr_source_val_handle) {
+        assert(ctxt->op == BLE_GATT_ACCESS_OP_WRITE_CHR);
+
+        if (OS_MBUF_PKTLEN(ctxt->om) != sizeof ctrl) {
+            return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+        }
+        rc = ble_hs_mbuf_to_flat(ctxt->om, ctrl, sizeof ctrl, &len);
+        if (rc != 0) {
+            return BLE_ATT_ERR_UNLIKELY;
+        }
+
+        blebench_notify_start(conn_handle, get_le32(ctrl), get_le16(ctrl + 4));
+        return 0;
+    }
+
+    if (attr_handle == gatt_svr_echo_val_handle) {
+        switch (ctxt->op) {
+        case BLE_GATT_ACCESS_OP_READ_CHR:
+            rc = os_mbuf_append(ctxt->om, gatt_svr_echo_val,
+                                sizeof gatt_svr_echo_val);
+            return rc == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+
+        case BLE_GATT_ACCESS_OP_WRITE_CHR:
+            if (OS_MBUF_PKTLEN(ctxt->om) > sizeof gatt_svr_echo_val) {
+                return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+            }
+            rc = ble_hs_mbuf_to_flat(ctxt->om, gatt_svr_echo_val,
+                                     sizeof gatt_svr_echo_val, &len);
+            return rc == 0 ? 0 : BLE_ATT_ERR_UNLIKELY;
+
+        default:
+            assert(0);
+            return BLE_ATT_ERR_UNLIKELY;
+        }
+    }
+
+    /* Unknown characteristic; the nimble stack should not have called this
+     * function.
+     */
+    assert(0);
+    return BLE_ATT_ERR_UNLIKELY;
+}
+
+void
+gatt_svr_register_cb(struct ble_gatt_register_ctxt *ctxt, void *arg)
+{
+    char buf[BLE_UUID_STR_LEN];
+
+    switch (ctxt->op) {
+    case BLE_GATT_REGISTER_OP_SVC:
+        BLEBENCH_LOG(DEBUG, "registered service %s with handle=%d\n",
+                     ble_uuid_to_str(ctxt->svc.svc_def->uuid, buf),
+                     ctxt->svc.handle);
+        break;
+
+    case BLE_GATT_REGISTER_OP_CHR:
+        BLEBENCH_LOG(DEBUG, "registering characteristic %s with "
+                            "def_handle=%d val_handle=%d\n",
+                     ble_uuid_to_str(ctxt->chr.chr_def->uuid, buf),
+                     ctxt->chr.def_handle,
+                     ctxt->chr.val_handle);
+        break;
+
+    case BLE_GATT_REGISTER_OP_DSC:
+        BLEBENCH_LOG(DEBUG, "registering descriptor %s with handle=%d\n",
+                     ble_uuid_to_str(ctxt->dsc.dsc_def->uuid, buf),
+                     ctxt->dsc.handle);
+        break;
+
+    default:
+        assert(0);
+        break;
+    }
+}
+
+int
+gatt_svr_init(void)
+{
+    int rc;
+
+    rc = ble_gatts_count_cfg(gatt_svr_svcs);
+    if (rc != 0) {
+        return rc;
+    }
+
+    rc = ble_gatts_add_svcs(gatt_svr_svcs);
+    if (rc != 0) {
+        return rc;
+    }
+
+    return 0;
+}
@@ -0,0 +1,1086 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+#include "sysinit/sysinit.h"
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "os/endian.h"
+#include "console/console.h"
+
+/* BLE */
+#include "nimble/ble.h"
+#include "host/ble_hs.h"
+#include "services/gap/ble_svc_gap.h"
+
+/* Application-specified header. */
+#include "blebench.h"
+
+/**
+ * blebench measures host-level performance between two devices running this
+ * application.  An idle device advertises and serves the benchmark service.
+ * A device told (over newtmgr) to run a test connects to the specified peer
+ * as central, configures the link (ATT MTU, LL data length, PHY), runs the
+ * measurement and disconnects.  The outcome is kept for retrieval over
+ * newtmgr.
+ */
+
+/** Log data. */
+struct log blebench_log;
+
+struct blebench_rx_stats blebench_rx;
+
+/** Time allowed for queued notifications to drain after a NOTIFY run. */
+#define BLEBENCH_NOTIFY_GRACE_MS    500
+
+/** Time to wait for the controller to report a PHY update. */
+#define BLEBENCH_PHY_TMO_MS         2000
+
+#define BLEBENCH_CONN_TMO_MS        10000
+
+/** LL transmit time, in microseconds, of a 1M PDU with the given payload. */
+#define BLEBENCH_TX_TIME_1M(octets) (((octets) + 14) * 8)
+
+#define BLEBENCH_STATE_IDLE         0
+#define BLEBENCH_STATE_CONNECTING   1
+#define BLEBENCH_STATE_MTU          2
+#define BLEBENCH_STATE_PHY          3
+#define BLEBENCH_STATE_DISC         4
+#define BLEBENCH_STATE_RUN          5
+#define BLEBENCH_STATE_DRAIN        6
+#define BLEBENCH_STATE_TERMINATING  7
+
+/** State of the benchmark this device is driving (central role). */
+static struct {
+    struct blebench_result result;
+    uint8_t state;
+    uint16_t conn_handle;
+    uint16_t iter;
+
+    /** CPU time at which the current connection / round trip started. */
+    uint32_t t0;
+
+    /** OS time at which the current throughput run started / ends. */
+    os_time_t run_start;
+    os_time_t run_end;
+
+    /** CPU time of the first and last notification received. */
+    uint32_t ntf_first;
+    uint32_t ntf_last;
+    uint64_t rtt_sum;
+
+    /** Peer's benchmark characteristic value handles. */
+    uint16_t sink_handle;
+    uint16_t source_handle;
+    uint16_t echo_handle;
+
+    struct ble_l2cap_chan *chan;
+} blebench_run;
+
+/** State of a notification flood this device is serving (peer role). */
+static struct {
+    uint16_t conn_handle;
+    uint16_t size;
+    os_time_t end;
+    unsigned active:1;
+} blebench_ntf;
+
+static struct os_callout blebench_run_timer;
+static struct os_callout blebench_ntf_timer;
+
+static uint8_t blebench_payload[BLE_ATT_ATTR_MAX_LEN];
+
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) > 0
+#define BLEBENCH_COC_BUF_SIZE                                               \
+    (MYNEWT_VAL(BLEBENCH_COC_MTU) + sizeof (struct os_mbuf) +              \
+     sizeof (struct os_mbuf_pkthdr))
+
+static os_membuf_t blebench_coc_mem[
+    OS_MEMPOOL_SIZE(MYNEWT_VAL(BLEBENCH_COC_BUF_COUNT),
+                    BLEBENCH_COC_BUF_SIZE)];
+static struct os_mempool blebench_coc_mempool;
+static struct os_mbuf_pool blebench_coc_mbuf_pool;
+#endif
+
+static int blebench_gap_event(struct ble_gap_event *event, void *arg);
+static void blebench_phy_done(uint8_t phy);
+static void blebench_run_test(void);
+
+static uint32_t
+blebench_ms_to_ticks(uint32_t ms)
+{
+    uint32_t ticks;
+    int rc;
+
+    rc = os_time_ms_to_ticks(ms, &ticks);
+    assert(rc == 0);
+
+    return ticks;
+}
+
+static uint32_t
+blebench_ticks_to_ms(os_time_t ticks)
+{
+    return (uint64_t)ticks * 1000 / OS_TICKS_PER_SEC;
+}
+
+/**
+ * Enables advertising with the following parameters:
+ *     o General discoverable mode.
+ *     o Undirected connectable mode.
+ */
+static void
+blebench_advertise(void)
+{
+    struct ble_gap_adv_params adv_params;
+    struct ble_hs_adv_fields fields;
+    const char *name;
+    int rc;
+
+    memset(&fields, 0, sizeof fields);
+    fields.flags = BLE_HS_ADV_F_DISC_GEN |
+                   BLE_HS_ADV_F_BREDR_UNSUP;
+
+    name = ble_svc_gap_device_name();
+    fields.name = (uint8_t *)name;
+    fields.name_len = strlen(name);
+    fields.name_is_complete = 1;
+
+    rc = ble_gap_adv_set_fields(&fields);
+    if (rc != 0) {
+        BLEBENCH_LOG(ERROR, "error setting advertisement data; rc=%d\n", rc);
+        return;
+    }
+
+    memset(&adv_params, 0, sizeof adv_params);
+    adv_params.conn_mode = BLE_GAP_CONN_MODE_UND;
+    adv_params.disc_mode = BLE_GAP_DISC_MODE_GEN;
+    rc = ble_gap_adv_start(BLE_OWN_ADDR_PUBLIC, NULL, BLE_HS_FOREVER,
+                           &adv_params, blebench_gap_event, NULL);
+    if (rc != 0) {
+        BLEBENCH_LOG(ERROR, "error enabling advertisement; rc=%d\n", rc);
+        return;
+    }
+}
+
+/*****************************************************************************
+ * $peer role                                                                *
+ *****************************************************************************/
+
+static void
+blebench_ntf_fill(void)
+{
+    struct os_mbuf *om;
+    int rc;
+
+    while (blebench_ntf.active) {
+        if (OS_TIME_TICK_GEQ(os_time_get(), blebench_ntf.end)) {
+            blebench_ntf.active = 0;
+            return;
+        }
+
+        om = ble_hs_mbuf_from_flat(blebench_payload, blebench_ntf.size);
+        if (om == NULL) {
+            break;
+        }
+
+        rc = ble_gattc_notify_custom(blebench_ntf.conn_handle,
+                                     gatt_svr_source_val_handle, om);
+        if (rc != 0) {
+            break;
+        }
+    }
+
+    /* Out of buffers; continue on the next tick. */
+    os_callout_reset(&blebench_ntf_timer, 1);
+}
+
+static void
+blebench_ntf_timer_exp(struct os_event *ev)
+{
+    blebench_ntf_fill();
+}
+
+/**
+ * Starts a notification flood in response to a write to the source
+ * characteristic.
+ */
+void
+blebench_notify_start(uint16_t conn_handle, uint32_t duration_ms,
+                      uint16_t size)
+{
+    uint16_t mtu;
+
+    mtu = ble_att_mtu(conn_handle);
+    if (size == 0 || size > mtu - 3) {
+        size = mtu - 3;
+    }
+
+    blebench_ntf.conn_handle = conn_handle;
+    blebench_ntf.size = size;
+    blebench_ntf.end = os_time_get() + blebench_ms_to_ticks(duration_ms);
+    blebench_ntf.active = 1;
+
+    /* Don't flood from within the ATT write handler. */
+    os_callout_reset(&blebench_ntf_timer, 0);
+}
+
+/*****************************************************************************
+ * $l2cap                                                                    *
+ *****************************************************************************/
+
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) > 0
+
+static void blebench_coc_fill(void);
+static void blebench_finish(int status);
+
+static int
+blebench_coc_recv_ready(struct ble_l2cap_chan *chan)
+{
+    struct os_mbuf *sdu_rx;
+
+    sdu_rx = os_mbuf_get_pkthdr(&blebench_coc_mbuf_pool, 0);
+    if (sdu_rx == NULL) {
+        return BLE_HS_ENOMEM;
+    }
+
+    ble_l2cap_recv_ready(chan, sdu_rx);
+    return 0;
+}
+
+static int
+blebench_l2cap_event(struct ble_l2cap_event *event, void *arg)
+{
+    switch (event->type) {
+    case BLE_L2CAP_EVENT_COC_CONNECTED:
+        if (arg == NULL) {
+            /* Peer role; nothing to do until data arrives. */
+            return 0;
+        }
+
+        if (event->connect.status != 0) {
+            blebench_finish(event->connect.status);
+            return 0;
+        }
+
+        blebench_run.chan = event->connect.chan;
+        blebench_run.run_start = os_time_get();
+        blebench_run.run_end = blebench_run.run_start +
+            blebench_ms_to_ticks(blebench_run.result.params.duration_ms);
+        blebench_coc_fill();
+        return 0;
+
+    case BLE_L2CAP_EVENT_COC_DISCONNECTED:
+        if (event->disconnect.chan == blebench_run.chan) {
+            blebench_run.chan = NULL;
+        }
+        return 0;
+
+    case BLE_L2CAP_EVENT_COC_ACCEPT:
+        return blebench_coc_recv_ready(event->accept.chan);
+
+    case BLE_L2CAP_EVENT_COC_DATA_RECEIVED:
+        blebench_rx.coc_bytes += OS_MBUF_PKTLEN(event->receive.sdu_rx);
+        blebench_rx.coc_sdus++;
+        os_mbuf_free_chain(event->receive.sdu_rx);
+        blebench_coc_recv_ready(event->receive.chan);
+        return 0;
+
+    default:
+        return 0;
+    }
+}
+
+static void
+blebench_coc_fill(void)
+{
+    struct blebench_result *res;
+    struct os_mbuf *sdu_tx;
+    uint16_t len;
+    int rc;
+
+    res = &blebench_run.result;
+
+    len = res->params.size;
+    if (len == 0 || len > MYNEWT_VAL(BLEBENCH_COC_MTU)) {
+        len = MYNEWT_VAL(BLEBENCH_COC_MTU);
+    }
+
+    while (blebench_run.chan != NULL) {
+        if (OS_TIME_TICK_GEQ(os_time_get(), blebench_run.run_end)) {
+            res->elapsed_ms =
+                blebench_ticks_to_ms(os_time_get() - blebench_run.run_start);
+            blebench_finish(0);
+            return;
+        }
+
+        sdu_tx = os_msys_get_pkthdr(len, 0);
+        if (sdu_tx == NULL) {
+            break;
+        }
+
+        rc = os_mbuf_append(sdu_tx, blebench_payload, len);
+        if (rc != 0) {
+            os_mbuf_free_chain(sdu_tx);
+            break;
+        }
+
+        rc = ble_l2cap_send(blebench_run.chan, sdu_tx);
+        if (rc == BLE_HS_EBUSY) {
+            /* Previous SDU not sent yet. */
+            os_mbuf_free_chain(sdu_tx);
+            break;
+        }
+        if (rc != 0) {
+            blebench_finish(rc);
+            return;
+        }
+
+        res->bytes += len;
+        res->packets++;
+    }
+
+    os_callout_reset(&blebench_run_timer, 1);
+}
+
+#endif
+
+/*****************************************************************************
+ * $central role                                                             *
+ *****************************************************************************/
+
+static void
+blebench_log_result(const struct blebench_result *res)
+{
+    BLEBENCH_LOG(INFO, "test=%d status=%d mtu=%d tx_octets=%d phy=%d "
+                       "conn_us=%lu\n",
+                 res->params.test, res->status, res->mtu, res->tx_octets,
+                 res->phy, (unsigned long)res->conn_us);
+
+    switch (res->params.test) {
+    case BLEBENCH_TEST_RTT:
+        BLEBENCH_LOG(INFO, "rtt count=%d min=%luus avg=%luus max=%luus\n",
+                     res->rtt_count, (unsigned long)res->rtt_min_us,
+                     (unsigned long)res->rtt_avg_us,
+                     (unsigned long)res->rtt_max_us);
+        break;
+
+    case BLEBENCH_TEST_WRITE:
+    case BLEBENCH_TEST_NOTIFY:
+    case BLEBENCH_TEST_COC:
+        BLEBENCH_LOG(INFO, "bytes=%lu packets=%lu ms=%lu (%lu B/s)\n",
+                     (unsigned long)res->bytes, (unsigned long)res->packets,
+                     (unsigned long)res->elapsed_ms,
+                     res->elapsed_ms == 0 ? 0UL :
+                     (unsigned long)((uint64_t)res->bytes * 1000 /
+                                     res->elapsed_ms));
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * Ends the current run.  The result becomes available once the connection
+ * is gone.
+ */
+static void
+blebench_finish(int status)
+{
+    int rc;
+
+    os_callout_stop(&blebench_run_timer);
+
+    if (blebench_run.result.status == 0) {
+        blebench_run.result.status = status;
+    }
+
+    if (blebench_run.state == BLEBENCH_STATE_TERMINATING) {
+        return;
+    }
+
+    blebench_run.state = BLEBENCH_STATE_TERMINATING;
+    rc = ble_gap_terminate(blebench_run.conn_handle,
+                           BLE_ERR_REM_USER_CONN_TERM);
+    if (rc != 0) {
+        /* Not connected. */
+        blebench_run.state = BLEBENCH_STATE_IDLE;
+        blebench_log_result(&blebench_run.result);
+        blebench_advertise();
+    }
+}
+
+static int
+blebench_connect(void)
+{
+    int rc;
+
+    blebench_run.state = BLEBENCH_STATE_CONNECTING;
+    blebench_run.t0 = os_cputime_get32();
+
+    rc = ble_gap_connect(BLE_OWN_ADDR_PUBLIC,
+                         &blebench_run.result.params.peer_addr,
+                         BLEBENCH_CONN_TMO_MS, NULL, blebench_gap_event,
+                         &blebench_run);
+    if (rc != 0) {
+        blebench_run.state = BLEBENCH_STATE_IDLE;
+    }
+
+    return rc;
+}
+
+static void
+blebench_write_fill(void)
+{
+    struct blebench_result *res;
+    struct os_mbuf *om;
+    uint16_t len;
+    int rc;
+
+    res = &blebench_run.result;
+
+    len = res->params.size;
+    if (len == 0 || len > res->mtu - 3) {
+        len = res->mtu - 3;
+    }
+
+    while (1) {
+        if (OS_TIME_TICK_GEQ(os_time_get(), blebench_run.run_end)) {
+            res->elapsed_ms =
+                blebench_ticks_to_ms(os_time_get() - blebench_run.run_start);
+            blebench_finish(0);
+            return;
+        }
+
+        om = ble_hs_mbuf_from_flat(blebench_payload, len);
+        if (om == NULL) {
+            break;
+        }
+
+        rc = ble_gattc_write_no_rsp(blebench_run.conn_handle,
+                                    blebench_run.sink_handle, om);
+        if (rc == BLE_HS_ENOMEM) {
+            break;
+        }
+        if (rc != 0) {
+            blebench_finish(rc);
+            return;
+        }
+
+        res->bytes += len;
+        res->packets++;
+    }
+
+    /* Out of buffers; continue on the next tick. */
+    os_callout_reset(&blebench_run_timer, 1);
+}
+
+static int
+blebench_rtt_rx(uint16_t conn_handle, const struct ble_gatt_error *error,
+                struct ble_gatt_attr *attr, void *arg)
+{
+    struct blebench_result *res;
+    uint32_t us;
+    int rc;
+
+    res = &blebench_run.result;
+
+    if (error->status != 0) {
+        blebench_finish(error->status);
+        return 0;
+    }
+
+    us = os_cputime_ticks_to_usecs(os_cputime_get32() - blebench_run.t0);
+    if (res->rtt_count == 0 || us < res->rtt_min_us) {
+        res->rtt_min_us = us;
+    }
+    if (us > res->rtt_max_us) {
+        res->rtt_max_us = us;
+    }
+    blebench_run.rtt_sum += us;
+    res->rtt_count++;
+    res->rtt_avg_us = blebench_run.rtt_sum / res->rtt_count;
+
+    if (res->rtt_count >= res->params.count) {
+        blebench_finish(0);
+        return 0;
+    }
+
+    blebench_run.t0 = os_cputime_get32();
+    rc = ble_gattc_read(conn_handle, blebench_run.echo_handle,
+                        blebench_rtt_rx, NULL);
+    if (rc != 0) {
+        blebench_finish(rc);
+    }
+
+    return 0;
+}
+
+static int
+blebench_notify_ctrl_rx(uint16_t conn_handle,
+                        const struct ble_gatt_error *error,
+                        struct ble_gatt_attr *attr, void *arg)
+{
+    if (error->status != 0) {
+        blebench_finish(error->status);
+        return 0;
+    }
+
+    /* The peer is flooding; collect until the run plus a grace period is
+     * over.
+     */
+    blebench_run.state = BLEBENCH_STATE_DRAIN;
+    os_callout_reset(&blebench_run_timer,
+                     blebench_ms_to_ticks(
+                         blebench_run.result.params.duration_ms +
+                         BLEBENCH_NOTIFY_GRACE_MS));
+    return 0;
+}
+
+static void
+blebench_run_test(void)
+{
+    struct blebench_result *res;
+    struct os_mbuf *sdu_rx;
+    uint8_t ctrl[6];
+    int rc;
+
+    res = &blebench_run.result;
+    blebench_run.state = BLEBENCH_STATE_RUN;
+
+    switch (res->params.test) {
+    case BLEBENCH_TEST_RTT:
+        blebench_run.t0 = os_cputime_get32();
+        rc = ble_gattc_read(blebench_run.conn_handle,
+                            blebench_run.echo_handle, blebench_rtt_rx, NULL);
+        break;
+
+    case BLEBENCH_TEST_WRITE:
+        blebench_run.run_start = os_time_get();
+        blebench_run.run_end = blebench_run.run_start +
+                               blebench_ms_to_ticks(res->params.duration_ms);
+        blebench_write_fill();
+        rc = 0;
+        break;
+
+    case BLEBENCH_TEST_NOTIFY:
+        put_le32(ctrl, res->params.duration_ms);
+        put_le16(ctrl + 4, res->params.size);
+        rc = ble_gattc_write_flat(blebench_run.conn_handle,
+                                  blebench_run.source_handle,
+                                  ctrl, sizeof ctrl,
+                                  blebench_notify_ctrl_rx, NULL);
+        break;
+
+    case BLEBENCH_TEST_COC:
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) > 0
+        sdu_rx = os_mbuf_get_pkthdr(&blebench_coc_mbuf_pool, 0);
+        if (sdu_rx == NULL) {
+            rc = BLE_HS_ENOMEM;
+            break;
+        }
+        rc = ble_l2cap_connect(blebench_run.conn_handle,
+                               MYNEWT_VAL(BLEBENCH_COC_PSM),
+                               MYNEWT_VAL(BLEBENCH_COC_MTU), sdu_rx,
+                               blebench_l2cap_event, &blebench_run);
+#else
+        (void)sdu_rx;
+        rc = BLE_HS_ENOTSUP;
+#endif
+        break;
+
+    default:
+        rc = BLE_HS_EINVAL;
+        break;
+    }
+
+    if (rc != 0) {
+        blebench_finish(rc);
+    }
+}
+
+static int
+blebench_disc_chr(uint16_t conn_handle, const struct ble_gatt_error *error,
+                  const struct ble_gatt_chr *chr, void *arg)
+{
+    switch (error->status) {
+    case 0:
+        if (ble_uuid_cmp(&chr->uuid.u, &gatt_svr_chr_sink_uuid.u) == 0) {
+            blebench_run.sink_handle = chr->val_handle;
+        } else if (ble_uuid_cmp(&chr->uuid.u,
+                                &gatt_svr_chr_source_uuid.u) == 0) {
+            blebench_run.source_handle = chr->val_handle;
+        } else if (ble_uuid_cmp(&chr->uuid.u,
+                                &gatt_svr_chr_echo_uuid.u) == 0) {
+            blebench_run.echo_handle = chr->val_handle;
+        }
+        return 0;
+
+    case BLE_HS_EDONE:
+        if (blebench_run.sink_handle == 0 ||
+            blebench_run.source_handle == 0 ||
+            blebench_run.echo_handle == 0) {
+
+            /* Peer isn't running blebench. */
+            blebench_finish(BLE_HS_ENOENT);
+            return 0;
+        }
+
+        blebench_run_test();
+        return 0;
+
+    default:
+        blebench_finish(error->status);
+        return 0;
+    }
+}
+
+static void
+blebench_disc(void)
+{
+    int rc;
+
+    if (blebench_run.result.params.test == BLEBENCH_TEST_COC) {
+        /* CoC doesn't use GATT. */
+        blebench_run_test();
+        return;
+    }
+
+    blebench_run.state = BLEBENCH_STATE_DISC;
+    rc = ble_gattc_disc_all_chrs(blebench_run.conn_handle, 1, 0xffff,
+                                 blebench_disc_chr, NULL);
+    if (rc != 0) {
+        blebench_finish(rc);
+    }
+}
+
+static void
+blebench_phy_done(uint8_t phy)
+{
+    os_callout_stop(&blebench_run_timer);
+    blebench_run.result.phy = phy;
+    blebench_disc();
+}
+
+static void
+blebench_setup_phy(void)
+{
+    struct blebench_result *res;
+    uint8_t mask;
+    int rc;
+
+    res = &blebench_run.result;
+
+    if (res->params.tx_octets != 0) {
+        /* The requested length is reported back in a DATA_LEN event. */
+        rc = ble_gap_set_data_len(blebench_run.conn_handle,
+                                  res->params.tx_octets,
+                                  BLEBENCH_TX_TIME_1M(res->params.tx_octets));
+        if (rc != 0) {
+            BLEBENCH_LOG(WARN, "set data len failed; rc=%d\n", rc);
+        }
+    }
+
+    if (res->params.phy != BLE_GAP_LE_PHY_2M) {
+        blebench_phy_done(BLE_GAP_LE_PHY_1M);
+        return;
+    }
+
+    mask = BLE_GAP_LE_PHY_2M_MASK;
+    rc = ble_gap_set_phy(blebench_run.conn_handle, mask, mask);
+    if (rc != 0) {
+        BLEBENCH_LOG(WARN, "set phy failed; rc=%d\n", rc);
+        blebench_phy_done(BLE_GAP_LE_PHY_1M);
+        return;
+    }
+
+    blebench_run.state = BLEBENCH_STATE_PHY;
+    os_callout_reset(&blebench_run_timer,
+                     blebench_ms_to_ticks(BLEBENCH_PHY_TMO_MS));
+}
+
+static int
+blebench_mtu_rx(uint16_t conn_handle, const struct ble_gatt_error *error,
+                uint16_t mtu, void *arg)
+{
+    if (error->status == 0) {
+        blebench_run.result.mtu = mtu;
+    }
+
+    blebench_setup_phy();
+    return 0;
+}
+
+static void
+blebench_setup(void)
+{
+    struct blebench_result *res;
+    int rc;
+
+    res = &blebench_run.result;
+    res->mtu = ble_att_mtu(blebench_run.conn_handle);
+
+    if (res->params.mtu <= BLE_ATT_MTU_DFLT) {
+        blebench_setup_phy();
+        return;
+    }
+
+    blebench_run.state = BLEBENCH_STATE_MTU;
+    ble_att_set_preferred_mtu(res->params.mtu);
+    rc = ble_gattc_exchange_mtu(blebench_run.conn_handle, blebench_mtu_rx,
+                                NULL);
+    if (rc != 0) {
+        blebench_setup_phy();
+    }
+}
+
+static void
+blebench_run_timer_exp(struct os_event *ev)
+{
+    struct blebench_result *res;
+
+    res = &blebench_run.result;
+
+    switch (blebench_run.state) {
+    case BLEBENCH_STATE_PHY:
+        BLEBENCH_LOG(WARN, "no phy update; staying on 1M\n");
+        blebench_phy_done(BLE_GAP_LE_PHY_1M);
+        break;
+
+    case BLEBENCH_STATE_RUN:
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) > 0
+        if (res->params.test == BLEBENCH_TEST_COC) {
+            blebench_coc_fill();
+            break;
+        }
+#endif
+        blebench_write_fill();
+        break;
+
+    case BLEBENCH_STATE_DRAIN:
+        if (res->packets > 0) {
+            res->elapsed_ms = os_cputime_ticks_to_usecs(
+                blebench_run.ntf_last - blebench_run.ntf_first) / 1000;
+        }
+        blebench_finish(0);
+        break;
+
+    default:
+        break;
+    }
+}
+
+static void
+blebench_central_connected(uint16_t conn_handle)
+{
+    struct blebench_result *res;
+    uint32_t us;
+
+    res = &blebench_run.result;
+    blebench_run.conn_handle = conn_handle;
+
+    us = os_cputime_ticks_to_usecs(os_cputime_get32() - blebench_run.t0);
+    blebench_run.iter++;
+    res->conn_us += (us - res->conn_us) / blebench_run.iter;
+
+    if (res->params.test == BLEBENCH_TEST_CONN) {
+        if (blebench_run.iter >= res->params.count) {
+            blebench_finish(0);
+        } else {
+            /* Reconnect once this connection is gone. */
+            blebench_run.state = BLEBENCH_STATE_TERMINATING;
+            ble_gap_terminate(conn_handle, BLE_ERR_REM_USER_CONN_TERM);
+        }
+        return;
+    }
+
+    blebench_setup();
+}
+
+static void
+blebench_central_disconnected(int reason)
+{
+    struct blebench_result *res;
+    int rc;
+
+    res = &blebench_run.result;
+
+    if (res->params.test == BLEBENCH_TEST_CONN &&
+        res->status == 0 &&
+        blebench_run.iter < res->params.count) {
+
+        rc = blebench_connect();
+        if (rc == 0) {
+            return;
+        }
+        res->status = rc;
+    }
+
+    if (blebench_run.state != BLEBENCH_STATE_TERMINATING && res->status == 0) {
+        /* Link lost before the run completed. */
+        res->status = reason;
+    }
+
+    os_callout_stop(&blebench_run_timer);
+    blebench_run.chan = NULL;
+    blebench_run.state = BLEBENCH_STATE_IDLE;
+    blebench_log_result(res);
+    blebench_advertise();
+}
+
+/**
+ * The nimble host executes this callback when a GAP event occurs.  Events
+ * for the connection this device is driving carry a non-NULL arg; events for
+ * connections where we are the benchmark peer carry NULL.
+ */
+static int
+blebench_gap_event(struct ble_gap_event *event, void *arg)
+{
+    int central;
+
+    central = arg != NULL;
+
+    switch (event->type) {
+    case BLE_GAP_EVENT_CONNECT:
+        BLEBENCH_LOG(INFO, "connection %s; status=%d\n",
+                     event->connect.status == 0 ? "established" : "failed",
+                     event->connect.status);
+
+        if (central) {
+            if (event->connect.status != 0) {
+                if (blebench_run.result.status == 0) {
+                    blebench_run.result.status = event->connect.status;
+                }
+                blebench_run.state = BLEBENCH_STATE_TERMINATING;
+                blebench_central_disconnected(event->connect.status);
+            } else {
+                blebench_central_connected(event->connect.conn_handle);
+            }
+        } else if (event->connect.status != 0) {
+            blebench_advertise();
+        }
+        return 0;
+
+    case BLE_GAP_EVENT_DISCONNECT:
+        BLEBENCH_LOG(INFO, "disconnect; reason=%d\n",
+                     event->disconnect.reason);
+
+        if (central) {
+            blebench_central_disconnected(event->disconnect.reason);
+        } else {
+            if (blebench_ntf.conn_handle ==
+                event->disconnect.conn.conn_handle) {
+
+                blebench_ntf.active = 0;
+                os_callout_stop(&blebench_ntf_timer);
+            }
+            if (blebench_run.state == BLEBENCH_STATE_IDLE) {
+                blebench_advertise();
+            }
+        }
+        return 0;
+
+    case BLE_GAP_EVENT_MTU:
+        if (central) {
+            blebench_run.result.mtu = event->mtu.value;
+        }
+        return 0;
+
+    case BLE_GAP_EVENT_DATA_LEN:
+        if (central) {
+            blebench_run.result.tx_octets = event->data_len.max_tx_octets;
+        }
+        return 0;
+
+    case BLE_GAP_EVENT_PHY_UPDATE_COMPLETE:
+        if (central && blebench_run.state == BLEBENCH_STATE_PHY) {
+            if (event->phy_updated.status == 0) {
+                blebench_phy_done(event->phy_updated.tx_phy);
+            } else {
+                blebench_phy_done(BLE_GAP_LE_PHY_1M);
+            }
+        }
+        return 0;
+
+    case BLE_GAP_EVENT_NOTIFY_RX:
+        if (central &&
+            event->notify_rx.attr_handle == blebench_run.source_handle) {
+
+            blebench_run.ntf_last = os_cputime_get32();
+            if (blebench_run.result.packets == 0) {
+                blebench_run.ntf_first = blebench_run.ntf_last;
+            }
+            blebench_run.result.bytes += OS_MBUF_PKTLEN(event->notify_rx.om);
+            blebench_run.result.packets++;
+        }
+        return 0;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************
+ * $api                                                                      *
+ *****************************************************************************/
+
+/**
+ * Starts a benchmark run against the peer in params.  The result can be
+ * retrieved with blebench_last_result() once blebench_busy() returns 0.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_EBUSY if a run is already in progress;
+ *                              Other BLE host error code on failure to
+ *                                  connect.
+ */
+int
+blebench_start(const struct blebench_params *params)
+{
+    int rc;
+
+    if (blebench_run.state != BLEBENCH_STATE_IDLE) {
+        return BLE_HS_EBUSY;
+    }
+
+    memset(&blebench_run, 0, sizeof blebench_run);
+    blebench_run.result.params = *params;
+    if (blebench_run.result.params.count == 0) {
+        blebench_run.result.params.count = 1;
+    }
+    blebench_run.result.mtu = BLE_ATT_MTU_DFLT;
+    blebench_run.result.phy = BLE_GAP_LE_PHY_1M;
+
+    ble_gap_adv_stop();
+
+    rc = blebench_connect();
+    if (rc != 0) {
+        blebench_run.result.status = rc;
+        blebench_advertise();
+        return rc;
+    }
+
+    return 0;
+}
+
+int
+blebench_busy(void)
+{
+    return blebench_run.state != BLEBENCH_STATE_IDLE;
+}
+
+const struct blebench_result *
+blebench_last_result(void)
+{
+    return &blebench_run.result;
+}
+
+static void
+blebench_on_reset(int reason)
+{
+    BLEBENCH_LOG(ERROR, "Resetting state; reason=%d\n", reason);
+}
+
+static void
+blebench_on_sync(void)
+{
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) > 0
+    int rc;
+
+    rc = ble_l2cap_create_server(MYNEWT_VAL(BLEBENCH_COC_PSM),
+                                 MYNEWT_VAL(BLEBENCH_COC_MTU),
+                                 blebench_l2cap_event, NULL);
+    if (rc != 0 && rc != BLE_HS_EALREADY) {
+        BLEBENCH_LOG(ERROR, "error creating CoC server; rc=%d\n", rc);
+    }
+#endif
+
+    /* Begin advertising. */
+    blebench_advertise();
+}
+
+/**
+ * main
+ *
+ * The main task for the project. This function initializes the packages,
+ * then starts serving events from default event queue.
+ *
+ * @return int NOTE: this function should never return!
+ */
+int
+main(void)
+{
+    int rc;
+    int i;
+
+    /* Initialize OS */
+    sysinit();
+
+    /* Initialize the blebench log. */
+    log_register("blebench", &blebench_log, &log_console_handler, NULL,
+                 LOG_SYSLEVEL);
+
+    /* Initialize the NimBLE host configuration. */
+    log_register("ble_hs", &ble_hs_log, &log_console_handler, NULL,
+                 LOG_SYSLEVEL);
+    ble_hs_cfg.reset_cb = blebench_on_reset;
+    ble_hs_cfg.sync_cb = blebench_on_sync;
+    ble_hs_cfg.gatts_register_cb = gatt_svr_register_cb;
+
+    for (i = 0; i < sizeof blebench_payload; i++) {
+        blebench_payload[i] = i;
+    }
+
+    os_callout_init(&blebench_run_timer, os_eventq_dflt_get(),
+                    blebench_run_timer_exp, NULL);
+    os_callout_init(&blebench_ntf_timer, os_eventq_dflt_get(),
+                    blebench_ntf_timer_exp, NULL);
+
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) > 0
+    rc = os_mempool_init(&blebench_coc_mempool,
+                         MYNEWT_VAL(BLEBENCH_COC_BUF_COUNT),
+                         BLEBENCH_COC_BUF_SIZE, blebench_coc_mem,
+                         "blebench_coc");
+    assert(rc == 0);
+
+    rc = os_mbuf_pool_init(&blebench_coc_mbuf_pool, &blebench_coc_mempool,
+                           BLEBENCH_COC_BUF_SIZE,
+                           MYNEWT_VAL(BLEBENCH_COC_BUF_COUNT));
+    assert(rc == 0);
+#endif
+
+    rc = gatt_svr_init();
+    assert(rc == 0);
+
+    rc = blebench_nmgr_register_group();
+    assert(rc == 0);
+
+    /* Set the default device name. */
+    rc = ble_svc_gap_device_name_set("nimble-blebench");
+    assert(rc == 0);
+
+    /*
+     * As the last thing, process events from default event queue.
+     */
+    while (1) {
+        os_eventq_run(os_eventq_dflt_get());
+    }
+    return 0;
+}
@@ -259,8 +259,8 @@ blecent_scan(void)
 static int
 blecent_should_connect(const struct ble_gap_disc_desc *disc)
 {
-    struct ble_hs_adv_fields fields;
-    int rc;
+    const struct ble_hs_adv_field *field;
+    struct ble_hs_adv_iter iter;
     int i;
 
     /* The device has to be advertising connectability. */
@@ -270,17 +270,22 @@ blecent_should_connect(const struct ble_gap_disc_desc *disc)
         return 0;
     }
 
-    rc = ble_hs_adv_parse_fields(&fields, disc->data, disc->length_data);
-    if (rc != 0) {
-        return rc;
-    }
-
     /* The device has to advertise support for the Alert Notification
-     * service (0x1811).
+     * service (0x1811).  Walk the raw report rather than parsing every
+     * field; only the 16-bit UUID lists matter here.
      */
-    for (i = 0; i < fields.num_uuids16; i++) {
-        if (ble_uuid_u16(&fields.uuids16[i].u) == BLECENT_SVC_ALERT_UUID) {
-            return 1;
+    ble_hs_adv_iter_init(&iter, disc->data, disc->length_data);
+    while (ble_hs_adv_iter_next(&iter, &field) == 0) {
+        if (field->type != BLE_HS_ADV_TYPE_INCOMP_UUIDS16 &&
+            field->type != BLE_HS_ADV_TYPE_COMP_UUIDS16) {
+
+            continue;
+        }
+
+        for (i = 0; i + 2 <= field->length - 1; i += 2) {
+            if (get_le16(field->value + i) == BLECENT_SVC_ALERT_UUID) {
+                return 1;
+            }
         }
     }
 
@@ -262,6 +262,11 @@ uint32_t g_bletest_IVs = 0xDEAFBABE;
 #endif
 
 #if (BLETEST_THROUGHPUT_TEST == 1)
+/* Throughput is reported on the console every report interval */
+#define BLETEST_TPUT_RPT_SECS           (10)
+uint32_t g_bletest_tput_pkts;
+uint32_t g_bletest_tput_rpt_time;
+
 void
 bletest_completed_pkt(uint16_t handle)
 {
@@ -910,6 +915,49 @@ bletest_send_packet(uint16_t handle)
     return om;
 }
 
+#if (BLETEST_THROUGHPUT_TEST == 1)
+/**
+ * Accumulates the number of acknowledged packets and periodically prints
+ * the payload throughput of the test connection. Whether the link was
+ * encrypted is printed as well so that encrypted and plain links can be
+ * compared (the initiator starts encryption a few seconds into the test).
+ *
+ * @param completed_pkts Number of packets acked since the last call
+ */
+static void
+bletest_report_throughput(uint16_t completed_pkts)
+{
+    int encrypted;
+    uint32_t bps;
+    struct ble_ll_conn_sm *connsm;
+
+    if (g_bletest_tput_rpt_time == 0) {
+        g_bletest_tput_rpt_time = os_time_get() +
+                                  (BLETEST_TPUT_RPT_SECS * OS_TICKS_PER_SEC);
+        g_bletest_tput_pkts = 0;
+        return;
+    }
+
+    g_bletest_tput_pkts += completed_pkts;
+    if ((int32_t)(os_time_get() - g_bletest_tput_rpt_time) < 0) {
+        return;
+    }
+
+    encrypted = 0;
+    connsm = ble_ll_conn_find_active_conn(g_bletest_handle);
+    if (connsm && CONN_F_ENCRYPTED(connsm)) {
+        encrypted = 1;
+    }
+
+    bps = (g_bletest_tput_pkts * BLETEST_PKT_SIZE * 8) / BLETEST_TPUT_RPT_SECS;
+    console_printf("Throughput: %lu bps (%s)\n", (unsigned long)bps,
+                   encrypted ? "encrypted" : "plain");
+
+    g_bletest_tput_pkts = 0;
+    g_bletest_tput_rpt_time += BLETEST_TPUT_RPT_SECS * OS_TICKS_PER_SEC;
+}
+#endif
+
 static void
 bletest_execute_advertiser(void)
 {
@@ -1053,6 +1101,7 @@ bletest_execute_advertiser(void)
 
         assert(g_bletest_outstanding_pkts >= completed_pkts);
         g_bletest_outstanding_pkts -= completed_pkts;
+        bletest_report_throughput(completed_pkts);
 
         while (g_bletest_outstanding_pkts < 20) {
             om = bletest_send_packet(g_bletest_handle);
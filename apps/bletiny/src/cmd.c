@@ -1328,6 +1328,65 @@ cmd_l2cap_send(int argc, char **argv)
     return bletiny_l2cap_send(conn, idx, bytes);
 }
 
+static void
+bletiny_l2cap_bench_help(void)
+{
+    console_printf("Available l2cap bench commands: \n");
+    console_printf("\thelp\n");
+    console_printf("Available l2cap bench params: \n");
+    help_cmd_uint16("conn");
+    help_cmd_uint16("idx");
+    help_cmd_uint16("sdu_len");
+    help_cmd_uint32("bytes");
+    console_printf("\n Use 'b show coc' to get conn and idx parameters.\n");
+    console_printf("Sends 'bytes' bytes in SDUs of 'sdu_len' bytes as fast as "
+                   "credits allow and reports the throughput.\n");
+}
+
+static int
+cmd_l2cap_bench(int argc, char **argv)
+{
+    uint16_t sdu_len;
+    uint16_t conn;
+    uint16_t idx;
+    uint32_t bytes;
+    int rc;
+
+    if (argc > 1 && strcmp(argv[1], "help") == 0) {
+        bletiny_l2cap_bench_help();
+        return 0;
+    }
+    conn = parse_arg_uint16("conn", &rc);
+    if (rc != 0) {
+       console_printf("invalid 'conn' parameter\n");
+       help_cmd_uint16("conn");
+       return rc;
+    }
+
+    idx = parse_arg_uint16("idx", &rc);
+    if (rc != 0) {
+       console_printf("invalid 'idx' parameter\n");
+       help_cmd_uint16("idx");
+       return rc;
+    }
+
+    sdu_len = parse_arg_uint16("sdu_len", &rc);
+    if (rc != 0) {
+       console_printf("invalid 'sdu_len' parameter\n");
+       help_cmd_uint16("sdu_len");
+       return rc;
+    }
+
+    bytes = parse_arg_uint32("bytes", &rc);
+    if (rc != 0) {
+       console_printf("invalid 'bytes' parameter\n");
+       help_cmd_uint32("bytes");
+       return rc;
+    }
+
+    return bletiny_l2cap_bench(conn, idx, sdu_len, bytes);
+}
+
 static const struct cmd_entry cmd_l2cap_entries[];
 
 static int
@@ -1348,6 +1407,7 @@ static const struct cmd_entry cmd_l2cap_entries[] = {
     { "connect", cmd_l2cap_connect },
     { "disconnect", cmd_l2cap_disconnect },
     { "send", cmd_l2cap_send },
+    { "bench", cmd_l2cap_bench },
     { "help", cmd_l2cap_help },
     { NULL, NULL }
 };
@@ -1779,6 +1839,7 @@ cmd_show_conn(int argc, char **argv)
 static int
 cmd_show_coc(int argc, char **argv)
 {
+    struct ble_l2cap_chan_stats stats;
     struct bletiny_conn *conn = NULL;
     struct bletiny_l2cap_coc *coc;
     int i, j;
@@ -1797,6 +1858,21 @@ cmd_show_coc(int argc, char **argv)
         j = 0;
         SLIST_FOREACH(coc, &conn->coc_list, next) {
             console_printf("    idx: %i, chan pointer = %p\n", j++, coc->chan);
+            if (ble_l2cap_get_chan_stats(coc->chan, &stats) == 0) {
+                console_printf("        rx: bytes=%lu sdus=%lu frames=%lu "
+                               "credit_stalls=%lu credits_granted=%lu\n",
+                               (unsigned long)stats.rx_bytes,
+                               (unsigned long)stats.rx_sdus,
+                               (unsigned long)stats.rx_frames,
+                               (unsigned long)stats.rx_credit_stalls,
+                               (unsigned long)stats.credits_granted);
+                console_printf("        tx: bytes=%lu sdus=%lu frames=%lu "
+                               "credit_stalls=%lu\n",
+                               (unsigned long)stats.tx_bytes,
+                               (unsigned long)stats.tx_sdus,
+                               (unsigned long)stats.tx_frames,
+                               (unsigned long)stats.tx_credit_stalls);
+            }
         }
     }
 
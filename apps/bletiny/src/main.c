@@ -94,6 +94,20 @@ static struct os_mempool bletiny_coc_conn_pool;
 static void *bletiny_sdu_coc_mem;
 struct os_mbuf_pool sdu_os_mbuf_pool;
 static struct os_mempool sdu_coc_mbuf_mempool;
+
+/* State of the "l2cap bench" command. */
+static struct os_callout bletiny_coc_bench_timer;
+static struct {
+    struct ble_l2cap_chan *chan;
+    uint32_t bytes_left;
+    uint32_t bytes_queued;
+    uint32_t sdus_queued;
+    uint32_t tx_sdus_start;
+    os_time_t start;
+    uint16_t sdu_len;
+} bletiny_coc_bench;
+
+static void bletiny_coc_bench_done(int rc);
 #endif
 
 static struct os_callout bletiny_tx_timer;
@@ -1030,6 +1044,14 @@ bletiny_gap_event(struct ble_gap_event *event, void *arg)
                        event->mtu.value);
         return 0;
 
+    case BLE_GAP_EVENT_DATA_LEN:
+        console_printf("data length event; conn_handle=%d max_tx_octets=%d "
+                       "max_rx_octets=%d\n",
+                       event->data_len.conn_handle,
+                       event->data_len.max_tx_octets,
+                       event->data_len.max_rx_octets);
+        return 0;
+
     case BLE_GAP_EVENT_IDENTITY_RESOLVED:
         console_printf("identity resolved ");
         rc = ble_gap_conn_find(event->identity_resolved.conn_handle, &desc);
@@ -1417,7 +1439,7 @@ bletiny_datalen(uint16_t conn_handle, uint16_t tx_octets, uint16_t tx_time)
 {
     int rc;
 
-    rc = ble_hs_hci_util_set_data_len(conn_handle, tx_octets, tx_time);
+    rc = ble_gap_set_data_len(conn_handle, tx_octets, tx_time);
     return rc;
 }
 
@@ -1621,6 +1643,10 @@ bletiny_l2cap_coc_remove(uint16_t conn_handle, struct ble_l2cap_chan *chan)
         return;
     }
 
+    if (bletiny_coc_bench.chan == chan) {
+        bletiny_coc_bench_done(BLE_HS_ENOTCONN);
+    }
+
     SLIST_REMOVE(&conn->coc_list, coc, bletiny_l2cap_coc, next);
     os_memblock_put(&bletiny_coc_conn_pool, coc);
 }
@@ -1839,6 +1865,166 @@ bletiny_l2cap_send(uint16_t conn_handle, uint16_t idx, uint16_t bytes)
 
 #endif
 }
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) != 0
+static void
+bletiny_coc_bench_done(int rc)
+{
+    struct ble_l2cap_chan_stats stats;
+    uint32_t ms;
+
+    ms = (os_time_get() - bletiny_coc_bench.start) * 1000 / OS_TICKS_PER_SEC;
+    if (ms == 0) {
+        ms = 1;
+    }
+
+    console_printf("l2cap bench %s; rc=%d bytes=%lu sdus=%lu ms=%lu "
+                   "bps=%lu\n", rc == 0 ? "complete" : "failed", rc,
+                   (unsigned long)bletiny_coc_bench.bytes_queued,
+                   (unsigned long)bletiny_coc_bench.sdus_queued,
+                   (unsigned long)ms,
+                   (unsigned long)((uint64_t)bletiny_coc_bench.bytes_queued *
+                                   8 * 1000 / ms));
+
+    if (ble_l2cap_get_chan_stats(bletiny_coc_bench.chan, &stats) == 0) {
+        console_printf("    tx_frames=%lu tx_credit_stalls=%lu\n",
+                       (unsigned long)stats.tx_frames,
+                       (unsigned long)stats.tx_credit_stalls);
+    }
+
+    bletiny_coc_bench.chan = NULL;
+}
+
+static void
+bletiny_coc_bench_timer_cb(struct os_event *ev)
+{
+    struct ble_l2cap_chan_stats stats;
+    struct os_mbuf *sdu_tx;
+    uint16_t len;
+    uint8_t b;
+    int rc;
+    int i;
+
+    if (bletiny_coc_bench.chan == NULL) {
+        return;
+    }
+
+    while (bletiny_coc_bench.bytes_left > 0) {
+        len = min(bletiny_coc_bench.sdu_len, bletiny_coc_bench.bytes_left);
+
+        sdu_tx = os_mbuf_get_pkthdr(&sdu_os_mbuf_pool, 0);
+        if (sdu_tx == NULL) {
+            /* Previous SDUs still in use; try again later. */
+            os_callout_reset(&bletiny_coc_bench_timer, 1);
+            return;
+        }
+
+        for (i = 0; i < len; i++) {
+            b = i;
+            rc = os_mbuf_append(sdu_tx, &b, 1);
+            if (rc != 0) {
+                os_mbuf_free_chain(sdu_tx);
+                bletiny_coc_bench_done(rc);
+                return;
+            }
+        }
+
+        rc = ble_l2cap_send(bletiny_coc_bench.chan, sdu_tx);
+        if (rc == BLE_HS_EBUSY) {
+            /* Previous SDU not sent yet; try again on the next tick. */
+            os_mbuf_free_chain(sdu_tx);
+            os_callout_reset(&bletiny_coc_bench_timer, 1);
+            return;
+        }
+        if (rc != 0) {
+            bletiny_coc_bench_done(rc);
+            return;
+        }
+
+        bletiny_coc_bench.bytes_left -= len;
+        bletiny_coc_bench.bytes_queued += len;
+        bletiny_coc_bench.sdus_queued++;
+    }
+
+    /* Everything is queued; wait for the last SDU to go out. */
+    rc = ble_l2cap_get_chan_stats(bletiny_coc_bench.chan, &stats);
+    if (rc != 0) {
+        bletiny_coc_bench_done(rc);
+        return;
+    }
+
+    if (stats.tx_sdus - bletiny_coc_bench.tx_sdus_start <
+        bletiny_coc_bench.sdus_queued) {
+
+        os_callout_reset(&bletiny_coc_bench_timer, 1);
+        return;
+    }
+
+    bletiny_coc_bench_done(0);
+}
+#endif
+
+int
+bletiny_l2cap_bench(uint16_t conn_handle, uint16_t idx, uint16_t sdu_len,
+                    uint32_t bytes)
+{
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) == 0
+    console_printf("BLE L2CAP LE COC not supported.");
+    console_printf(" Configure nimble host to enable it\n");
+    return 0;
+#else
+
+    struct ble_l2cap_chan_stats stats;
+    struct bletiny_conn *conn;
+    struct bletiny_l2cap_coc *coc;
+    int i;
+    int rc;
+
+    if (bletiny_coc_bench.chan != NULL) {
+        console_printf("l2cap bench already in progress\n");
+        return BLE_HS_EALREADY;
+    }
+
+    if (sdu_len == 0 || bytes == 0) {
+        return BLE_HS_EINVAL;
+    }
+
+    conn = bletiny_conn_find(conn_handle);
+    if (conn == NULL) {
+        console_printf("conn=%d does not exist\n", conn_handle);
+        return 0;
+    }
+
+    i = 0;
+    SLIST_FOREACH(coc, &conn->coc_list, next) {
+        if (i == idx) {
+            break;
+        }
+        i++;
+    }
+    if (coc == NULL) {
+        console_printf("Are you sure your channel exist?\n");
+        return 0;
+    }
+
+    rc = ble_l2cap_get_chan_stats(coc->chan, &stats);
+    if (rc != 0) {
+        return rc;
+    }
+
+    bletiny_coc_bench.chan = coc->chan;
+    bletiny_coc_bench.sdu_len = sdu_len;
+    bletiny_coc_bench.bytes_left = bytes;
+    bletiny_coc_bench.bytes_queued = 0;
+    bletiny_coc_bench.sdus_queued = 0;
+    bletiny_coc_bench.tx_sdus_start = stats.tx_sdus;
+    bletiny_coc_bench.start = os_time_get();
+
+    os_callout_reset(&bletiny_coc_bench_timer, 0);
+
+    return 0;
+#endif
+}
+
 /**
  * main
  *
@@ -1940,6 +2126,12 @@ main(int argc, char **argv)
     os_callout_init(&bletiny_tx_timer, os_eventq_dflt_get(),
                     bletiny_tx_timer_cb, NULL);
 
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) != 0
+    /* Used by the "l2cap bench" command to keep a CoC channel busy. */
+    os_callout_init(&bletiny_coc_bench_timer, os_eventq_dflt_get(),
+                    bletiny_coc_bench_timer_cb, NULL);
+#endif
+
     while (1) {
         os_eventq_run(os_eventq_dflt_get());
     }
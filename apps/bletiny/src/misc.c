@@ -114,9 +114,10 @@ print_conn_desc(const struct ble_gap_conn_desc *desc)
                    desc->peer_id_addr.type);
     print_addr(desc->peer_id_addr.val);
     console_printf(" conn_itvl=%d conn_latency=%d supervision_timeout=%d "
-                   "encrypted=%d authenticated=%d bonded=%d\n",
+                   "max_tx_octets=%d encrypted=%d authenticated=%d "
+                   "bonded=%d\n",
                    desc->conn_itvl, desc->conn_latency,
-                   desc->supervision_timeout,
+                   desc->supervision_timeout, desc->max_tx_octets,
                    desc->sec_state.encrypted,
                    desc->sec_state.authenticated,
                    desc->sec_state.bonded);
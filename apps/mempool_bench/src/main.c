@@ -0,0 +1,140 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include "sysinit/sysinit.h"
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "console/console.h"
+
+/*
+ * Times batches of os_memblock_get()/os_memblock_put() pairs from task
+ * context, optionally while a timer interrupt allocates from the same pool,
+ * and prints the rate. Build once with OS_MEMPOOL_LOCKFREE set and once
+ * without to compare the two implementations.
+ */
+
+#define BENCH_BLOCK_SIZE    (32)
+#define BENCH_NUM_BLOCKS    (8)
+
+#define BENCH_BATCH         MYNEWT_VAL(MEMPOOL_BENCH_BATCH)
+#define BENCH_ISR_ITVL      MYNEWT_VAL(MEMPOOL_BENCH_ISR_ITVL)
+
+static struct os_mempool bench_pool;
+static os_membuf_t bench_pool_mem[
+    OS_MEMPOOL_SIZE(BENCH_NUM_BLOCKS, BENCH_BLOCK_SIZE)];
+
+#if BENCH_ISR_ITVL != 0
+static struct hal_timer bench_timer;
+static uint32_t bench_isr_pairs;
+
+static void
+bench_timer_cb(void *arg)
+{
+    void *a;
+    void *b;
+
+    a = os_memblock_get(&bench_pool);
+    b = os_memblock_get(&bench_pool);
+    if (b) {
+        os_memblock_put(&bench_pool, b);
+        bench_isr_pairs++;
+    }
+    if (a) {
+        os_memblock_put(&bench_pool, a);
+        bench_isr_pairs++;
+    }
+
+    os_cputime_timer_relative(&bench_timer, BENCH_ISR_ITVL);
+}
+#endif
+
+static uint32_t
+bench_run_batch(void)
+{
+    uint32_t start;
+    uint32_t ticks;
+    void *block;
+    int i;
+
+    start = os_cputime_get32();
+    for (i = 0; i < BENCH_BATCH; i++) {
+        block = os_memblock_get(&bench_pool);
+        assert(block != NULL);
+        os_memblock_put(&bench_pool, block);
+    }
+    ticks = os_cputime_get32() - start;
+
+    return os_cputime_ticks_to_usecs(ticks);
+}
+
+static void
+bench_report(uint32_t usecs)
+{
+    uint32_t rate;
+
+    if (usecs == 0) {
+        usecs = 1;
+    }
+    rate = (uint64_t)BENCH_BATCH * 1000000 / usecs;
+
+    console_printf("mempool lockfree=%d: %lu pairs in %lu us, %lu/s",
+                   MYNEWT_VAL(OS_MEMPOOL_LOCKFREE),
+                   (unsigned long)BENCH_BATCH, (unsigned long)usecs,
+                   (unsigned long)rate);
+#if BENCH_ISR_ITVL != 0
+    console_printf(", isr pairs %lu", (unsigned long)bench_isr_pairs);
+#endif
+    console_printf("\n");
+
+    /* Every block must be back in the pool between batches. */
+    assert(bench_pool.mp_num_free == BENCH_NUM_BLOCKS);
+}
+
+int
+main(int argc, char **argv)
+{
+    uint32_t usecs;
+    int rc;
+
+    sysinit();
+
+    rc = os_mempool_init(&bench_pool, BENCH_NUM_BLOCKS, BENCH_BLOCK_SIZE,
+                         bench_pool_mem, "bench_pool");
+    assert(rc == 0);
+
+#if BENCH_ISR_ITVL != 0
+    os_cputime_timer_init(&bench_timer, bench_timer_cb, NULL);
+#endif
+
+    while (1) {
+#if BENCH_ISR_ITVL != 0
+        bench_isr_pairs = 0;
+        os_cputime_timer_relative(&bench_timer, BENCH_ISR_ITVL);
+#endif
+        usecs = bench_run_batch();
+#if BENCH_ISR_ITVL != 0
+        os_cputime_timer_stop(&bench_timer);
+#endif
+        bench_report(usecs);
+        os_time_delay(OS_TICKS_PER_SEC);
+    }
+
+    return rc;
+}
@@ -0,0 +1,257 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sysinit/sysinit.h"
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "sysflash/sysflash.h"
+#include "flash_map/flash_map.h"
+#include "fcb/fcb.h"
+#include "fs/fs.h"
+#include "host/ble_hs.h"
+
+/*
+ * Runs fixed fcb, nffs and NimBLE host workloads on sim with virtual time
+ * (MCU_NATIVE_VIRTUAL_TIME), printing one JSON line per workload:
+ *
+ *   {"w":"<workload>","n":<ops>,"cyc":<cycles>,"ticks":<os ticks>}
+ *
+ * Every run of a given build prints the same numbers, so CI can compare
+ * them against the previous build.  Run without -f so that flash starts
+ * out erased.
+ */
+
+#define SIMPERF_FCB_MAX_SECTORS     4
+#define SIMPERF_FCB_ENTRY_LEN       32
+#define SIMPERF_NFFS_CHUNK          128
+#define SIMPERF_NFFS_FILE           "/simperf"
+
+#define SIMPERF_FCB_ENTRIES         MYNEWT_VAL(SIMPERF_FCB_ENTRIES)
+#define SIMPERF_NFFS_FILE_SIZE      MYNEWT_VAL(SIMPERF_NFFS_FILE_SIZE)
+#define SIMPERF_BLE_ADV_CYCLES      MYNEWT_VAL(SIMPERF_BLE_ADV_CYCLES)
+
+struct simperf_mark {
+    uint64_t cycles;
+    os_time_t ticks;
+};
+
+static struct fcb simperf_fcb;
+static struct flash_area simperf_fcb_sectors[SIMPERF_FCB_MAX_SECTORS];
+static uint8_t simperf_buf[SIMPERF_NFFS_CHUNK];
+static int simperf_walk_cnt;
+
+static void
+simperf_start(struct simperf_mark *mark)
+{
+    mark->cycles = os_arch_sim_cycles();
+    mark->ticks = os_time_get();
+}
+
+static void
+simperf_report(const char *name, int ops, const struct simperf_mark *mark)
+{
+    printf("{\"w\":\"%s\",\"n\":%d,\"cyc\":%llu,\"ticks\":%lu}\n",
+           name, ops,
+           (unsigned long long)(os_arch_sim_cycles() - mark->cycles),
+           (unsigned long)(os_time_get() - mark->ticks));
+}
+
+static int
+simperf_fcb_walk_cb(struct fcb_entry *loc, void *arg)
+{
+    int rc;
+
+    rc = flash_area_read(loc->fe_area, loc->fe_data_off, simperf_buf,
+                         loc->fe_data_len);
+    assert(rc == 0);
+    simperf_walk_cnt++;
+    return 0;
+}
+
+static void
+simperf_run_fcb(void)
+{
+    struct simperf_mark mark;
+    struct fcb_entry loc;
+    int cnt;
+    int rc;
+    int i;
+
+    rc = flash_area_to_sectors(FLASH_AREA_IMAGE_1, &cnt, NULL);
+    assert(rc == 0 && cnt > 0);
+    if (cnt > SIMPERF_FCB_MAX_SECTORS) {
+        cnt = SIMPERF_FCB_MAX_SECTORS;
+    }
+    flash_area_to_sectors(FLASH_AREA_IMAGE_1, &cnt, simperf_fcb_sectors);
+    for (i = 0; i < cnt; i++) {
+        rc = flash_area_erase(&simperf_fcb_sectors[i], 0,
+                              simperf_fcb_sectors[i].fa_size);
+        assert(rc == 0);
+    }
+
+    simperf_fcb.f_magic = 0x53504552;
+    simperf_fcb.f_sector_cnt = cnt;
+    simperf_fcb.f_scratch_cnt = 0;
+    simperf_fcb.f_sectors = simperf_fcb_sectors;
+    rc = fcb_init(&simperf_fcb);
+    assert(rc == 0);
+
+    memset(simperf_buf, 0xa5, sizeof(simperf_buf));
+
+    simperf_start(&mark);
+    for (i = 0; i < SIMPERF_FCB_ENTRIES; i++) {
+        rc = fcb_append(&simperf_fcb, SIMPERF_FCB_ENTRY_LEN, &loc);
+        assert(rc == 0);
+        rc = flash_area_write(loc.fe_area, loc.fe_data_off, simperf_buf,
+                              SIMPERF_FCB_ENTRY_LEN);
+        assert(rc == 0);
+        rc = fcb_append_finish(&simperf_fcb, &loc);
+        assert(rc == 0);
+    }
+    simperf_report("fcb_append", SIMPERF_FCB_ENTRIES, &mark);
+
+    simperf_walk_cnt = 0;
+    simperf_start(&mark);
+    rc = fcb_walk(&simperf_fcb, NULL, simperf_fcb_walk_cb, NULL);
+    assert(rc == 0);
+    simperf_report("fcb_walk", simperf_walk_cnt, &mark);
+    assert(simperf_walk_cnt == SIMPERF_FCB_ENTRIES);
+}
+
+static void
+simperf_run_nffs(void)
+{
+    struct simperf_mark mark;
+    struct fs_file *file;
+    uint32_t len;
+    int off;
+    int rc;
+
+    memset(simperf_buf, 0x5a, sizeof(simperf_buf));
+
+    simperf_start(&mark);
+    rc = fs_open(SIMPERF_NFFS_FILE, FS_ACCESS_WRITE | FS_ACCESS_TRUNCATE,
+                 &file);
+    assert(rc == 0);
+    for (off = 0; off < SIMPERF_NFFS_FILE_SIZE; off += SIMPERF_NFFS_CHUNK) {
+        rc = fs_write(file, simperf_buf, SIMPERF_NFFS_CHUNK);
+        assert(rc == 0);
+    }
+    rc = fs_close(file);
+    assert(rc == 0);
+    simperf_report("nffs_write", SIMPERF_NFFS_FILE_SIZE / SIMPERF_NFFS_CHUNK,
+                   &mark);
+
+    simperf_start(&mark);
+    rc = fs_open(SIMPERF_NFFS_FILE, FS_ACCESS_READ, &file);
+    assert(rc == 0);
+    for (off = 0; off < SIMPERF_NFFS_FILE_SIZE; off += SIMPERF_NFFS_CHUNK) {
+        rc = fs_read(file, SIMPERF_NFFS_CHUNK, simperf_buf, &len);
+        assert(rc == 0 && len == SIMPERF_NFFS_CHUNK);
+    }
+    rc = fs_close(file);
+    assert(rc == 0);
+    simperf_report("nffs_read", SIMPERF_NFFS_FILE_SIZE / SIMPERF_NFFS_CHUNK,
+                   &mark);
+
+    simperf_start(&mark);
+    rc = fs_unlink(SIMPERF_NFFS_FILE);
+    assert(rc == 0);
+    simperf_report("nffs_unlink", 1, &mark);
+}
+
+static int
+simperf_gap_event(struct ble_gap_event *event, void *arg)
+{
+    return 0;
+}
+
+/*
+ * Each cycle goes through the host's HCI command path to the controller
+ * three times.
+ */
+static void
+simperf_run_ble(void)
+{
+    static const uint8_t rnd_addr[6] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0xc6 };
+    struct ble_gap_adv_params adv_params;
+    struct ble_hs_adv_fields fields;
+    struct simperf_mark mark;
+    int rc;
+    int i;
+
+    rc = ble_hs_id_set_rnd(rnd_addr);
+    assert(rc == 0);
+
+    memset(&fields, 0, sizeof fields);
+    fields.flags = BLE_HS_ADV_F_DISC_GEN | BLE_HS_ADV_F_BREDR_UNSUP;
+    fields.name = (uint8_t *)"simperf";
+    fields.name_len = 7;
+    fields.name_is_complete = 1;
+
+    memset(&adv_params, 0, sizeof adv_params);
+    adv_params.conn_mode = BLE_GAP_CONN_MODE_NON;
+    adv_params.disc_mode = BLE_GAP_DISC_MODE_GEN;
+
+    simperf_start(&mark);
+    for (i = 0; i < SIMPERF_BLE_ADV_CYCLES; i++) {
+        rc = ble_gap_adv_set_fields(&fields);
+        assert(rc == 0);
+        rc = ble_gap_adv_start(BLE_OWN_ADDR_RANDOM, NULL, BLE_HS_FOREVER,
+                               &adv_params, simperf_gap_event, NULL);
+        assert(rc == 0);
+        rc = ble_gap_adv_stop();
+        assert(rc == 0);
+    }
+    simperf_report("ble_adv_cycle", SIMPERF_BLE_ADV_CYCLES, &mark);
+}
+
+static void
+simperf_on_sync(void)
+{
+    simperf_run_ble();
+
+    printf("{\"w\":\"total\",\"n\":1,\"cyc\":%llu,\"ticks\":%lu}\n",
+           (unsigned long long)os_arch_sim_cycles(),
+           (unsigned long)os_time_get());
+    fflush(stdout);
+    exit(0);
+}
+
+int
+main(int argc, char **argv)
+{
+    sysinit();
+
+    ble_hs_cfg.sync_cb = simperf_on_sync;
+
+    /* The flash workloads run before the host has synced. */
+    simperf_run_fcb();
+    simperf_run_nffs();
+
+    while (1) {
+        os_eventq_run(os_eventq_dflt_get());
+    }
+
+    return 0;
+}
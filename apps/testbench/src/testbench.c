@@ -368,6 +368,10 @@ TEST_SUITE_DECL(testbench_mempool);
 TEST_SUITE_DECL(testbench_mutex);
 TEST_SUITE_DECL(testbench_sem);
 TEST_SUITE_DECL(testbench_json);
+TEST_SUITE_DECL(testbench_crc);
+#if MYNEWT_VAL(TESTBENCH_BENCH)
+TEST_SUITE_DECL(testbench_bench);
+#endif
 
 /*
  * main()
@@ -403,6 +407,10 @@ main(int argc, char **argv)
     TEST_SUITE_REGISTER(testbench_mutex);
     TEST_SUITE_REGISTER(testbench_sem);
     TEST_SUITE_REGISTER(testbench_json);
+    TEST_SUITE_REGISTER(testbench_crc);
+#if MYNEWT_VAL(TESTBENCH_BENCH)
+    TEST_SUITE_REGISTER(testbench_bench);
+#endif
 
     rc = init_tasks();
 
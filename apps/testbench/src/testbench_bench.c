@@ -0,0 +1,405 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "testutil/testutil.h"
+#include "os/os.h"
+#include "os/os_cputime.h"
+
+#include "testbench.h"
+
+/*
+ * Kernel micro-benchmarks.  Each benchmark logs one JSON record:
+ *
+ *   {"k":"<token>","b":"<name>","n":<ops>,"t":<total>,"u":"cyc"|"tick"}
+ *
+ * "t" is the time taken by "n" operations, in CPU cycles (DWT cycle counter
+ * on Cortex-M3/M4/M7) or os_cputime ticks elsewhere.  The records are read
+ * back with "newtmgr log show" like the rest of the testbench results.
+ */
+
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+#define BENCH_USE_CYCCNT        1
+#define BENCH_UNIT              "cyc"
+#else
+#define BENCH_USE_CYCCNT        0
+#define BENCH_UNIT              "tick"
+#endif
+
+#define BENCH_ITERS             1000
+#define BENCH_SWITCH_ITERS      200
+#define BENCH_FIRE_ITERS        16
+
+#define BENCH_MEMPOOL_BLOCKS    4
+#define BENCH_MEMPOOL_BLOCK_SZ  32
+
+/* Raw mbuf block size, header included; small so that chains get long. */
+#define BENCH_MBUF_BLOCK_SZ     64
+#define BENCH_MBUF_BLOCKS       24
+#define BENCH_MBUF_MAX_LEN      1024
+#define BENCH_MBUF_ITERS        32
+
+#define BENCH_MODE_CTX_SW       1
+#define BENCH_MODE_MUTEX        2
+
+extern char runtest_token[];
+
+static struct os_sem bench_wake;
+static struct os_sem bench_sem;
+static struct os_mutex bench_mutex;
+static struct os_eventq bench_evq;
+static struct os_event bench_ev;
+static struct os_callout bench_callout;
+
+static volatile int bench_mode;
+static volatile uint32_t bench_stamp;
+static volatile uint32_t bench_acc;
+
+static const uint16_t bench_mbuf_lens[] = { 32, 256, BENCH_MBUF_MAX_LEN };
+
+static inline uint32_t
+bench_now(void)
+{
+#if BENCH_USE_CYCCNT
+    return (DWT->CYCCNT);
+#else
+    return (os_cputime_get32());
+#endif
+}
+
+static void
+bench_report(const char *name, uint32_t ops, uint32_t total)
+{
+    LOG_INFO(&testlog, LOG_MODULE_TEST,
+             "{\"k\":\"%s\",\"b\":\"%s\",\"n\":%lu,\"t\":%lu,\"u\":\"%s\"}",
+             runtest_token, name, (unsigned long)ops, (unsigned long)total,
+             BENCH_UNIT);
+}
+
+static void
+bench_ev_cb(struct os_event *ev)
+{
+}
+
+/*
+ * Runs above the main task, which drives the benchmarks.  Each release of
+ * bench_wake preempts the main task straight into this loop.
+ */
+static void
+bench_worker(void *arg)
+{
+    while (1) {
+        os_sem_pend(&bench_wake, OS_TIMEOUT_NEVER);
+        switch (bench_mode) {
+        case BENCH_MODE_CTX_SW:
+            bench_acc += bench_now() - bench_stamp;
+            break;
+        case BENCH_MODE_MUTEX:
+            /* Main task holds the mutex; block until it lets go. */
+            bench_stamp = bench_now();
+            os_mutex_pend(&bench_mutex, OS_TIMEOUT_NEVER);
+            bench_acc += bench_now() - bench_stamp;
+            os_mutex_release(&bench_mutex);
+            break;
+        }
+    }
+}
+
+/*
+ * Returns the time between the last two polls of the clock on either side
+ * of a tick, i.e. the time taken by the tick interrupt.  If 'c' is given it
+ * is armed to expire on that tick.
+ */
+static uint32_t
+bench_tick_gap(struct os_callout *c)
+{
+    os_time_t now;
+    uint32_t prev;
+    uint32_t cur;
+
+    now = os_time_get();
+    while (os_time_get() == now) {
+    }
+    if (c != NULL) {
+        os_callout_reset(c, 1);
+    }
+
+    now = os_time_get();
+    prev = bench_now();
+    while (1) {
+        cur = bench_now();
+        if (os_time_get() != now) {
+            break;
+        }
+        prev = cur;
+    }
+    return (cur - prev);
+}
+
+void
+testbench_bench_init(void *arg)
+{
+    LOG_DEBUG(&testlog, LOG_MODULE_TEST,
+             "%s testbench bench_init", buildID);
+
+#if BENCH_USE_CYCCNT
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
+    tu_suite_set_pass_cb(testbench_ts_pass, NULL);
+    tu_suite_set_fail_cb(testbench_ts_fail, NULL);
+}
+
+/*
+ * Time from releasing a semaphore to the higher priority task waiting on it
+ * running; this is the release path plus one context switch.
+ */
+TEST_CASE(test_bench_ctx_sw)
+{
+    os_error_t err;
+    int i;
+
+    os_sem_init(&bench_wake, 0);
+    bench_mode = BENCH_MODE_CTX_SW;
+    bench_acc = 0;
+
+    err = os_task_init(&task1, "bench", bench_worker, NULL,
+                       MYNEWT_VAL(TESTBENCH_BENCH_TASK_PRIO), OS_WAIT_FOREVER,
+                       stack1, TASK1_STACK_SIZE);
+    TEST_ASSERT_FATAL(err == OS_OK);
+
+    for (i = 0; i < BENCH_SWITCH_ITERS; i++) {
+        bench_stamp = bench_now();
+        os_sem_release(&bench_wake);
+    }
+    bench_report("ctx_sw", BENCH_SWITCH_ITERS, bench_acc);
+
+    /*
+     * Contended mutex: the worker blocks on the mutex held here and is
+     * handed it on release.  Covers blocking with priority inheritance, two
+     * context switches and the release.
+     */
+    os_mutex_init(&bench_mutex);
+    bench_mode = BENCH_MODE_MUTEX;
+    bench_acc = 0;
+    for (i = 0; i < BENCH_SWITCH_ITERS; i++) {
+        os_mutex_pend(&bench_mutex, OS_TIMEOUT_NEVER);
+        os_sem_release(&bench_wake);
+        os_mutex_release(&bench_mutex);
+    }
+    bench_report("mutex_contended", BENCH_SWITCH_ITERS, bench_acc);
+
+    err = os_task_remove(&task1);
+    TEST_ASSERT(err == OS_OK);
+}
+
+TEST_CASE(test_bench_sync)
+{
+    uint32_t start;
+    int i;
+
+    os_sem_init(&bench_sem, 0);
+    start = bench_now();
+    for (i = 0; i < BENCH_ITERS; i++) {
+        os_sem_release(&bench_sem);
+        os_sem_pend(&bench_sem, 0);
+    }
+    bench_report("sem_give_take", BENCH_ITERS, bench_now() - start);
+
+    os_mutex_init(&bench_mutex);
+    start = bench_now();
+    for (i = 0; i < BENCH_ITERS; i++) {
+        os_mutex_pend(&bench_mutex, 0);
+        os_mutex_release(&bench_mutex);
+    }
+    bench_report("mutex_uncontended", BENCH_ITERS, bench_now() - start);
+
+    TEST_ASSERT(bench_sem.sem_tokens == 0);
+}
+
+TEST_CASE(test_bench_eventq)
+{
+    struct os_event *ev;
+    uint32_t start;
+    int i;
+
+    os_eventq_init(&bench_evq);
+    memset(&bench_ev, 0, sizeof(bench_ev));
+    bench_ev.ev_cb = bench_ev_cb;
+
+    start = bench_now();
+    for (i = 0; i < BENCH_ITERS; i++) {
+        os_eventq_put(&bench_evq, &bench_ev);
+        ev = os_eventq_get_no_wait(&bench_evq);
+    }
+    bench_report("eventq_put_get", BENCH_ITERS, bench_now() - start);
+
+    TEST_ASSERT(ev == &bench_ev);
+}
+
+TEST_CASE(test_bench_callout)
+{
+    uint32_t start;
+    uint32_t base;
+    uint32_t fire;
+    int i;
+
+    os_eventq_init(&bench_evq);
+    os_callout_init(&bench_callout, &bench_evq, bench_ev_cb, NULL);
+
+    start = bench_now();
+    for (i = 0; i < BENCH_ITERS; i++) {
+        os_callout_reset(&bench_callout, OS_TICKS_PER_SEC);
+        os_callout_stop(&bench_callout);
+    }
+    bench_report("callout_arm_stop", BENCH_ITERS, bench_now() - start);
+
+    /*
+     * Firing happens in the tick interrupt: compare ticks which expire a
+     * callout against ticks which don't.
+     */
+    base = 0;
+    fire = 0;
+    for (i = 0; i < BENCH_FIRE_ITERS; i++) {
+        base += bench_tick_gap(NULL);
+        fire += bench_tick_gap(&bench_callout);
+        TEST_ASSERT(os_eventq_get_no_wait(&bench_evq) == &bench_callout.c_ev);
+    }
+    bench_report("callout_fire", BENCH_FIRE_ITERS,
+                 fire > base ? fire - base : 0);
+}
+
+TEST_CASE(test_bench_mempool)
+{
+    struct os_mempool mp;
+    os_membuf_t *mem;
+    uint32_t start;
+    void *block;
+    int rc;
+    int i;
+
+    mem = os_malloc(sizeof(os_membuf_t) *
+                    OS_MEMPOOL_SIZE(BENCH_MEMPOOL_BLOCKS,
+                                    BENCH_MEMPOOL_BLOCK_SZ));
+    TEST_ASSERT_FATAL(mem != NULL);
+
+    rc = os_mempool_init(&mp, BENCH_MEMPOOL_BLOCKS, BENCH_MEMPOOL_BLOCK_SZ,
+                         mem, "bench");
+    TEST_ASSERT_FATAL(rc == 0);
+
+    start = bench_now();
+    for (i = 0; i < BENCH_ITERS; i++) {
+        block = os_memblock_get(&mp);
+        os_memblock_put(&mp, block);
+    }
+    bench_report("mempool_get_put", BENCH_ITERS, bench_now() - start);
+
+    TEST_ASSERT(mp.mp_num_free == BENCH_MEMPOOL_BLOCKS);
+    os_free(mem);
+}
+
+TEST_CASE(test_bench_mbuf)
+{
+    struct os_mbuf_pool omp;
+    struct os_mempool mp;
+    struct os_mbuf *om;
+    os_membuf_t *mem;
+    uint32_t append;
+    uint32_t copy;
+    uint32_t start;
+    uint8_t *data;
+    char name[20];
+    int rc;
+    int i;
+    int j;
+
+    mem = os_malloc(sizeof(os_membuf_t) *
+                    OS_MEMPOOL_SIZE(BENCH_MBUF_BLOCKS, BENCH_MBUF_BLOCK_SZ));
+    data = os_malloc(BENCH_MBUF_MAX_LEN);
+    TEST_ASSERT_FATAL(mem != NULL && data != NULL);
+
+    rc = os_mempool_init(&mp, BENCH_MBUF_BLOCKS, BENCH_MBUF_BLOCK_SZ, mem,
+                         "bench_mbuf");
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_mbuf_pool_init(&omp, &mp, BENCH_MBUF_BLOCK_SZ, BENCH_MBUF_BLOCKS);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < BENCH_MBUF_MAX_LEN; i++) {
+        data[i] = i;
+    }
+
+    /* One record per length; longer lengths mean longer chains. */
+    for (j = 0; j < sizeof(bench_mbuf_lens) / sizeof(bench_mbuf_lens[0]);
+         j++) {
+        append = 0;
+        copy = 0;
+        for (i = 0; i < BENCH_MBUF_ITERS; i++) {
+            om = os_mbuf_get_pkthdr(&omp, 0);
+            TEST_ASSERT_FATAL(om != NULL);
+
+            start = bench_now();
+            rc = os_mbuf_append(om, data, bench_mbuf_lens[j]);
+            append += bench_now() - start;
+            TEST_ASSERT_FATAL(rc == 0);
+
+            start = bench_now();
+            rc = os_mbuf_copydata(om, 0, bench_mbuf_lens[j], data);
+            copy += bench_now() - start;
+            TEST_ASSERT(rc == 0);
+
+            os_mbuf_free_chain(om);
+        }
+
+        snprintf(name, sizeof(name), "mbuf_append_%u",
+                 (unsigned int)bench_mbuf_lens[j]);
+        bench_report(name, BENCH_MBUF_ITERS, append);
+        snprintf(name, sizeof(name), "mbuf_copydata_%u",
+                 (unsigned int)bench_mbuf_lens[j]);
+        bench_report(name, BENCH_MBUF_ITERS, copy);
+    }
+
+    TEST_ASSERT(mp.mp_num_free == BENCH_MBUF_BLOCKS);
+    os_free(data);
+    os_free(mem);
+}
+
+TEST_SUITE(testbench_bench_suite)
+{
+    LOG_DEBUG(&testlog, LOG_MODULE_TEST, "%s testbench_bench", buildID);
+
+    tu_suite_set_init_cb(testbench_bench_init, NULL);
+
+    test_bench_ctx_sw();
+    test_bench_sync();
+    test_bench_eventq();
+    test_bench_callout();
+    test_bench_mempool();
+    test_bench_mbuf();
+}
+
+int
+testbench_bench()
+{
+    tu_suite_set_init_cb(testbench_bench_init, NULL);
+    LOG_DEBUG(&testlog, LOG_MODULE_TEST, "%s testbench_bench", buildID);
+    testbench_bench_suite();
+
+    return tu_any_failed;
+}
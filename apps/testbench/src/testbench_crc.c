@@ -0,0 +1,130 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "testutil/testutil.h"
+#include "os/os.h"
+#include "os/os_cputime.h"
+#include "crc/crc8.h"
+#include "crc/crc16.h"
+#include "crc/crc32.h"
+
+#include "testbench.h"
+
+#define CRC_BENCH_BUF_SIZE      1024
+#define CRC_BENCH_ITERS         64
+
+static uint8_t crc_bench_buf[CRC_BENCH_BUF_SIZE];
+static const char crc_check_str[] = "123456789";
+
+void
+testbench_crc_init(void *arg)
+{
+    LOG_DEBUG(&testlog, LOG_MODULE_TEST,
+             "%s testbench crc_init", buildID);
+
+    tu_suite_set_pass_cb(testbench_ts_pass, NULL);
+    tu_suite_set_fail_cb(testbench_ts_fail, NULL);
+}
+
+/*
+ * Logs throughput in kB/s for running checksum 'kind' over the bench
+ * buffer, given the number of cputime ticks it took.
+ */
+static void
+testbench_crc_report(const char *kind, uint32_t ticks)
+{
+    uint32_t usecs;
+
+    usecs = os_cputime_ticks_to_usecs(ticks);
+    if (usecs == 0) {
+        usecs = 1;
+    }
+    LOG_INFO(&testlog, LOG_MODULE_TEST, "%s %s: %u kB/s", buildID, kind,
+             (unsigned int)((uint64_t)CRC_BENCH_BUF_SIZE * CRC_BENCH_ITERS *
+                            1000 / usecs));
+}
+
+TEST_CASE(test_crc_check_values)
+{
+    void *p;
+
+    p = (void *)crc_check_str;
+    TEST_ASSERT(crc8_calc(crc8_init(), p, 9) == 0xfb);
+    TEST_ASSERT(crc16_ccitt(CRC16_INITIAL_CRC, p, 9) == 0x31c3);
+    TEST_ASSERT(crc32_calc(CRC32_INITIAL_CRC, p, 9) == 0xcbf43926);
+
+    /* Computing in pieces matches computing in one go. */
+    TEST_ASSERT(crc16_ccitt(crc16_ccitt(CRC16_INITIAL_CRC, p, 5),
+                            crc_check_str + 5, 4) == 0x31c3);
+    TEST_ASSERT(crc32_calc(crc32_calc(CRC32_INITIAL_CRC, p, 5),
+                           crc_check_str + 5, 4) == 0xcbf43926);
+}
+
+TEST_CASE(test_crc_throughput)
+{
+    volatile uint32_t sink;
+    uint32_t start;
+    int i;
+
+    for (i = 0; i < CRC_BENCH_BUF_SIZE; i++) {
+        crc_bench_buf[i] = i * 7;
+    }
+
+    start = os_cputime_get32();
+    for (i = 0; i < CRC_BENCH_ITERS; i++) {
+        sink = crc8_calc(crc8_init(), crc_bench_buf, CRC_BENCH_BUF_SIZE);
+    }
+    testbench_crc_report("crc8", os_cputime_get32() - start);
+
+    start = os_cputime_get32();
+    for (i = 0; i < CRC_BENCH_ITERS; i++) {
+        sink = crc16_ccitt(CRC16_INITIAL_CRC, crc_bench_buf,
+                           CRC_BENCH_BUF_SIZE);
+    }
+    testbench_crc_report("crc16", os_cputime_get32() - start);
+
+    start = os_cputime_get32();
+    for (i = 0; i < CRC_BENCH_ITERS; i++) {
+        sink = crc32_calc(CRC32_INITIAL_CRC, crc_bench_buf,
+                          CRC_BENCH_BUF_SIZE);
+    }
+    testbench_crc_report("crc32", os_cputime_get32() - start);
+    (void)sink;
+}
+
+TEST_SUITE(testbench_crc_suite)
+{
+    LOG_DEBUG(&testlog, LOG_MODULE_TEST, "%s testbench_crc", buildID);
+
+    tu_suite_set_init_cb(testbench_crc_init, NULL);
+
+    test_crc_check_values();
+    test_crc_throughput();
+}
+
+int
+testbench_crc()
+{
+    tu_suite_set_init_cb(testbench_crc_init, NULL);
+    LOG_DEBUG(&testlog, LOG_MODULE_TEST, "%s testbench_crc", buildID);
+    testbench_crc_suite();
+
+    return tu_any_failed;
+}
@@ -22,12 +22,15 @@
 #include <ctype.h>
 #include <stdio.h>
 
+#include "syscfg/syscfg.h"
 #include "sysflash/sysflash.h"
 
 #include <bsp/bsp.h>
 
 #include <flash_map/flash_map.h>
 #include <hal/hal_flash.h>
+#include <hal/hal_flash_int.h>
+#include <hal/hal_bsp.h>
 #include <hal/hal_system.h>
 #include <hal/hal_gpio.h>
 #include <hal/hal_watchdog.h>
@@ -53,11 +56,14 @@
 #error "Boot serial needs OS_CPUTIME timer"
 #endif
 
-#define BOOT_SERIAL_INPUT_MAX   128
 #define BOOT_SERIAL_OUT_MAX	48
 
 static uint32_t curr_off;
 static uint32_t img_size;
+#if MYNEWT_VAL(BOOT_SERIAL_ERASE_AHEAD)
+static uint32_t erased_off;
+#endif
+static uint8_t bs_img_data[MYNEWT_VAL(BOOT_SERIAL_MAX_FRAME)];
 static struct nmgr_hdr *bs_hdr;
 
 static char bs_obuf[BOOT_SERIAL_OUT_MAX];
@@ -201,6 +207,45 @@ bs_list(char *buf, int len)
     boot_serial_output();
 }
 
+#if MYNEWT_VAL(BOOT_SERIAL_ERASE_AHEAD)
+/*
+ * Erase the sectors of slot which start below offset 'end', and have not
+ * been erased yet.
+ */
+static int
+bs_erase_ahead(const struct flash_area *fap, uint32_t end)
+{
+    const struct hal_flash *hf;
+    uint32_t start;
+    uint32_t size;
+    int rc;
+    int i;
+
+    if (end > fap->fa_size) {
+        end = fap->fa_size;
+    }
+    if (erased_off >= end) {
+        return 0;
+    }
+    hf = hal_bsp_flash_dev(fap->fa_device_id);
+    for (i = 0; i < hf->hf_sector_cnt; i++) {
+        hf->hf_itf->hff_sector_info(hf, i, &start, &size);
+        if (start < fap->fa_off + erased_off) {
+            continue;
+        }
+        if (start >= fap->fa_off + end) {
+            break;
+        }
+        rc = flash_area_erase(fap, start - fap->fa_off, size);
+        if (rc) {
+            return rc;
+        }
+        erased_off = start - fap->fa_off + size;
+    }
+    return 0;
+}
+#endif
+
 /*
  * Image upload request.
  */
@@ -211,7 +256,7 @@ bs_upload(char *buf, int len)
     struct cbor_buf_reader reader;
     struct CborValue root_value;
     struct CborValue value;
-    uint8_t img_data[512];
+    uint8_t *img_data = bs_img_data;
     long long int off = UINT_MAX;
     size_t img_blen = 0;
     long long int data_len = UINT_MAX;
@@ -224,7 +269,7 @@ bs_upload(char *buf, int len)
             .type = CborAttrByteStringType,
             .addr.bytestring.data = img_data,
             .addr.bytestring.len = &img_blen,
-            .len = sizeof(img_data)
+            .len = sizeof(bs_img_data)
         },
         [1] = {
             .attribute = "off",
@@ -243,7 +288,7 @@ bs_upload(char *buf, int len)
     const struct flash_area *fap = NULL;
     int rc;
 
-    memset(img_data, 0, sizeof(img_data));
+    memset(img_data, 0, sizeof(bs_img_data));
 
     cbor_buf_reader_init(&reader, (uint8_t *)buf, len);
     cbor_parser_init(&reader.r, 0, &parser, &root_value);
@@ -289,7 +334,7 @@ bs_upload(char *buf, int len)
                 goto out_invalid_data;
             }
             if (cbor_value_calculate_string_length(&value, &slen) ||
-                slen >= sizeof(img_data)) {
+                slen >= sizeof(bs_img_data)) {
                 goto out_invalid_data;
             }
             if (cbor_value_copy_byte_string(&value, img_data, &slen, &value)) {
@@ -350,7 +395,17 @@ bs_upload(char *buf, int len)
         if (data_len > fap->fa_size) {
             goto out_invalid_data;
         }
+#if MYNEWT_VAL(BOOT_SERIAL_ERASE_AHEAD)
+        /*
+         * Rest of the slot gets erased as data arrives.  Erase the last
+         * sector now, so that the old image trailer does not get paired
+         * with a partial upload.
+         */
+        erased_off = 0;
+        rc = flash_area_erase(fap, fap->fa_size - 1, 1);
+#else
         rc = flash_area_erase(fap, 0, fap->fa_size);
+#endif
         if (rc) {
             rc = MGMT_ERR_EINVAL;
             goto out;
@@ -361,9 +416,23 @@ bs_upload(char *buf, int len)
         rc = 0;
         goto out;
     }
+#if MYNEWT_VAL(BOOT_SERIAL_ERASE_AHEAD)
+    if (bs_erase_ahead(fap, curr_off + img_blen)) {
+        goto out_invalid_data;
+    }
+#endif
     rc = flash_area_write(fap, curr_off, img_data, img_blen);
     if (rc == 0) {
         curr_off += img_blen;
+#if MYNEWT_VAL(BOOT_SERIAL_ERASE_AHEAD)
+        if (curr_off == img_size) {
+            /* Done; clear what is left of the previous image. */
+            rc = bs_erase_ahead(fap, fap->fa_size);
+            if (rc) {
+                rc = MGMT_ERR_EINVAL;
+            }
+        }
+#endif
     } else {
 out_invalid_data:
         rc = MGMT_ERR_EINVAL;
@@ -579,7 +648,7 @@ boot_serial_start(int max_input)
     console_echo(0);
 
     buf = os_malloc(max_input);
-    dec = os_malloc(max_input);
+    dec = os_malloc(MYNEWT_VAL(BOOT_SERIAL_MAX_FRAME));
     assert(buf && dec);
 
     off = 0;
@@ -608,10 +677,12 @@ boot_serial_start(int max_input)
         if (buf[0] == SHELL_NLIP_PKT_START1 &&
           buf[1] == SHELL_NLIP_PKT_START2) {
             dec_off = 0;
-            rc = boot_serial_in_dec(&buf[2], off - 2, dec, &dec_off, max_input);
+            rc = boot_serial_in_dec(&buf[2], off - 2, dec, &dec_off,
+              MYNEWT_VAL(BOOT_SERIAL_MAX_FRAME));
         } else if (buf[0] == SHELL_NLIP_DATA_START1 &&
           buf[1] == SHELL_NLIP_DATA_START2) {
-            rc = boot_serial_in_dec(&buf[2], off - 2, dec, &dec_off, max_input);
+            rc = boot_serial_in_dec(&buf[2], off - 2, dec, &dec_off,
+              MYNEWT_VAL(BOOT_SERIAL_MAX_FRAME));
         }
         if (rc == 1) {
             boot_serial_input(&dec[2], dec_off - 2);
@@ -645,7 +716,7 @@ boot_serial_pkg_init(void)
      * If it matches, await for download commands from serial.
      */
     if (hal_gpio_read(BOOT_SERIAL_DETECT_PIN) == BOOT_SERIAL_DETECT_PIN_VAL) {
-        boot_serial_start(BOOT_SERIAL_INPUT_MAX);
+        boot_serial_start(MYNEWT_VAL(BOOT_SERIAL_MAX_INPUT));
         assert(0);
     }
 }
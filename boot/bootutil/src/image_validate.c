@@ -29,6 +29,9 @@
 #include "bootutil/image.h"
 #include "bootutil/sign_key.h"
 
+#if MYNEWT_VAL(BOOTUTIL_HASH_HAL)
+#include "hal/hal_sha256.h"
+#endif
 #include "mbedtls/sha256.h"
 #include "mbedtls/rsa.h"
 #include "mbedtls/ecdsa.h"
@@ -44,19 +47,32 @@ bootutil_img_hash(struct image_header *hdr, const struct flash_area *fap,
                   uint8_t *tmp_buf, uint32_t tmp_buf_sz,
                   uint8_t *hash_result, uint8_t *seed, int seed_len)
 {
+#if !MYNEWT_VAL(BOOTUTIL_HASH_HAL)
     mbedtls_sha256_context sha256_ctx;
+#endif
     uint32_t blk_sz;
     uint32_t size;
     uint32_t off;
     int rc;
 
+#if MYNEWT_VAL(BOOTUTIL_HASH_HAL)
+    rc = hal_sha256_start();
+    if (rc) {
+        return rc;
+    }
+#else
     mbedtls_sha256_init(&sha256_ctx);
     mbedtls_sha256_starts(&sha256_ctx, 0);
+#endif
 
     /* in some cases (split image) the hash is seeded with data from
      * the loader image */
     if(seed && (seed_len > 0)) {
+#if MYNEWT_VAL(BOOTUTIL_HASH_HAL)
+        hal_sha256_update(seed, seed_len);
+#else
         mbedtls_sha256_update(&sha256_ctx, seed, seed_len);
+#endif
     }
 
     size = hdr->ih_img_size + hdr->ih_hdr_size;
@@ -76,13 +92,24 @@ bootutil_img_hash(struct image_header *hdr, const struct flash_area *fap,
         }
         rc = flash_area_read(fap, off, tmp_buf, blk_sz);
         if (rc) {
+#if MYNEWT_VAL(BOOTUTIL_HASH_HAL)
+            hal_sha256_finish(hash_result);
+#endif
             return rc;
         }
+#if MYNEWT_VAL(BOOTUTIL_HASH_HAL)
+        hal_sha256_update(tmp_buf, blk_sz);
+#else
         mbedtls_sha256_update(&sha256_ctx, tmp_buf, blk_sz);
+#endif
     }
+#if MYNEWT_VAL(BOOTUTIL_HASH_HAL)
+    return hal_sha256_finish(hash_result);
+#else
     mbedtls_sha256_finish(&sha256_ctx, hash_result);
 
     return 0;
+#endif
 }
 
 /*
@@ -27,6 +27,7 @@
 #include <inttypes.h>
 #include <stdlib.h>
 #include <string.h>
+#include "syscfg/syscfg.h"
 #include "sysflash/sysflash.h"
 #include "flash_map/flash_map.h"
 #include <hal/hal_flash.h>
@@ -35,6 +36,9 @@
 #include "bootutil/bootutil.h"
 #include "bootutil/image.h"
 #include "bootutil_priv.h"
+#if MYNEWT_VAL(BOOTUTIL_WARM_BOOT)
+#include "bsp/bsp.h"
+#endif
 
 #define BOOT_MAX_IMG_SECTORS        120
 
@@ -53,6 +57,100 @@ static struct {
     uint8_t write_sz;
 } boot_data;
 
+/** Buffer for copying and comparing sectors. */
+static uint8_t boot_copy_buf[MYNEWT_VAL(BOOTUTIL_COPY_BUF_SIZE)];
+
+#if MYNEWT_VAL(BOOTUTIL_WARM_BOOT)
+#define BOOT_WARM_MAGIC             0xb0075a1e
+
+/**
+ * Record of the slot 0 image which was last validated and booted.  Lives
+ * in RAM which is not cleared at reset, so it is only trusted when the
+ * check value matches.
+ */
+struct boot_warm_rec {
+    uint32_t bw_magic;
+    struct image_header bw_hdr;
+    uint32_t bw_check;
+};
+
+static bssnz_t struct boot_warm_rec boot_warm_rec;
+
+static uint32_t
+boot_warm_check(const struct boot_warm_rec *rec)
+{
+    const uint8_t *p;
+    uint32_t check;
+    int i;
+
+    /* FNV-1a over the header. */
+    check = 2166136261UL ^ rec->bw_magic;
+    p = (const uint8_t *)&rec->bw_hdr;
+    for (i = 0; i < sizeof(rec->bw_hdr); i++) {
+        check = (check ^ p[i]) * 16777619UL;
+    }
+    return check;
+}
+
+static void
+boot_warm_clear(void)
+{
+    boot_warm_rec.bw_magic = 0;
+    boot_warm_rec.bw_check = 0;
+}
+
+static void
+boot_warm_set(const struct image_header *hdr)
+{
+    boot_warm_rec.bw_magic = BOOT_WARM_MAGIC;
+    boot_warm_rec.bw_hdr = *hdr;
+    boot_warm_rec.bw_check = boot_warm_check(&boot_warm_rec);
+}
+
+/**
+ * Boots slot 0 without further checks if it holds the image which was
+ * booted before the last reset, and the image trailers don't ask for a
+ * swap.  Any swap clears the record first, so an interrupted swap never
+ * takes this path.
+ *
+ * @return                      0 if rsp was filled in; nonzero if the full
+ *                                  boot sequence needs to run.
+ */
+static int
+boot_warm_go(struct boot_rsp *rsp)
+{
+    const struct flash_area *fap;
+    struct image_header *hdr;
+    int rc;
+
+    if (boot_warm_rec.bw_magic != BOOT_WARM_MAGIC ||
+        boot_warm_rec.bw_check != boot_warm_check(&boot_warm_rec)) {
+        return -1;
+    }
+
+    rc = flash_area_open(FLASH_AREA_IMAGE_0, &fap);
+    if (rc != 0) {
+        return -1;
+    }
+    hdr = &boot_data.imgs[0].hdr;
+    rc = flash_area_read(fap, 0, hdr, sizeof(*hdr));
+    if (rc == 0 && memcmp(hdr, &boot_warm_rec.bw_hdr, sizeof(*hdr)) != 0) {
+        rc = -1;
+    }
+    if (rc == 0 && boot_swap_type() != BOOT_SWAP_TYPE_NONE) {
+        rc = -1;
+    }
+    if (rc == 0) {
+        rsp->br_flash_id = fap->fa_device_id;
+        rsp->br_image_addr = fap->fa_off;
+        rsp->br_hdr = hdr;
+    }
+    flash_area_close(fap);
+
+    return rc;
+}
+#endif
+
 struct boot_status_table {
     /**
      * For each field, a value of 0 means "any".
@@ -309,6 +407,72 @@ boot_slots_compatible(void)
     return 1;
 }
 
+#if MYNEWT_VAL(BOOTUTIL_SWAP_MOVE)
+/*
+ * Number of status steps a move-mode swap takes: 3 for swapping the trailer
+ * sector through scratch, then one per sector moved, then two per sector
+ * swapped.
+ */
+#define BOOT_MOVE_STEPS(num_body)   (BOOT_STATUS_STATE_COUNT + 3 * (num_body))
+
+/**
+ * Indicates whether images get swapped by moving slot 0 up by one sector
+ * rather than through the scratch area.  This requires all sectors of the
+ * slots to be the same size.
+ *
+ * In this mode the last sector of each slot holds only the image trailer,
+ * and the one before it is left free for the move.  All other sectors (the
+ * "body") can hold image data.
+ *
+ * @param out_num_body          On success, the number of body sectors gets
+ *                                  written here.
+ *
+ * @return                      1 if moving is used; 0 otherwise.
+ */
+static int
+boot_swap_uses_move(int *out_num_body)
+{
+    int num_body;
+    int i;
+
+    num_body = boot_data.imgs[0].num_sectors - 2;
+    if (num_body < 1 ||
+        BOOT_MOVE_STEPS(num_body) >= BOOT_STATUS_MAX_ENTRIES ||
+        boot_data.scratch_sector.fa_size <
+        boot_data.imgs[0].sectors[0].fa_size) {
+
+        return 0;
+    }
+    for (i = 1; i < boot_data.imgs[0].num_sectors; i++) {
+        if (boot_data.imgs[0].sectors[i].fa_size !=
+            boot_data.imgs[0].sectors[0].fa_size) {
+            return 0;
+        }
+    }
+
+    *out_num_body = num_body;
+    return 1;
+}
+
+/**
+ * Indicates whether the image in a slot fits within the body sectors, and so
+ * can be swapped by moving.
+ */
+static int
+boot_move_img_fits(int slot, int num_body)
+{
+    const struct image_header *hdr;
+
+    hdr = &boot_data.imgs[slot].hdr;
+    if (hdr->ih_magic != IMAGE_MAGIC) {
+        return 1;
+    }
+
+    return IMAGE_SIZE(hdr) <=
+           num_body * boot_data.imgs[0].sectors[0].fa_size;
+}
+#endif
+
 /**
  * Determines the sector layout of both image slots and the scratch area.
  * This information is necessary for calculating the number of bytes to erase
@@ -602,6 +766,9 @@ boot_validated_swap_type(void)
 {
     int swap_type;
     int rc;
+#if MYNEWT_VAL(BOOTUTIL_SWAP_MOVE)
+    int num_body;
+#endif
 
     swap_type = boot_swap_type();
     if (swap_type == BOOT_SWAP_TYPE_NONE) {
@@ -615,6 +782,20 @@ boot_validated_swap_type(void)
         return BOOT_SWAP_TYPE_FAIL;
     }
 
+#if MYNEWT_VAL(BOOTUTIL_SWAP_MOVE)
+    if (boot_swap_uses_move(&num_body)) {
+        /* Moving would lose the end of an image which reaches into the
+         * free sector.
+         */
+        if (!boot_move_img_fits(1, num_body)) {
+            return BOOT_SWAP_TYPE_FAIL;
+        }
+        if (!boot_move_img_fits(0, num_body)) {
+            return BOOT_SWAP_TYPE_NONE;
+        }
+    }
+#endif
+
     return swap_type;
 }
 
@@ -715,8 +896,6 @@ boot_copy_sector(int flash_area_id_src, int flash_area_id_dst,
     int chunk_sz;
     int rc;
 
-    static uint8_t buf[1024];
-
     fap_src = NULL;
     fap_dst = NULL;
 
@@ -734,19 +913,21 @@ boot_copy_sector(int flash_area_id_src, int flash_area_id_dst,
 
     bytes_copied = 0;
     while (bytes_copied < sz) {
-        if (sz - bytes_copied > sizeof buf) {
-            chunk_sz = sizeof buf;
+        if (sz - bytes_copied > sizeof boot_copy_buf) {
+            chunk_sz = sizeof boot_copy_buf;
         } else {
             chunk_sz = sz - bytes_copied;
         }
 
-        rc = flash_area_read(fap_src, off_src + bytes_copied, buf, chunk_sz);
+        rc = flash_area_read(fap_src, off_src + bytes_copied, boot_copy_buf,
+                             chunk_sz);
         if (rc != 0) {
             rc = BOOT_EFLASH;
             goto done;
         }
 
-        rc = flash_area_write(fap_dst, off_dst + bytes_copied, buf, chunk_sz);
+        rc = flash_area_write(fap_dst, off_dst + bytes_copied, boot_copy_buf,
+                              chunk_sz);
         if (rc != 0) {
             rc = BOOT_EFLASH;
             goto done;
@@ -763,6 +944,71 @@ done:
     return rc;
 }
 
+#if MYNEWT_VAL(BOOTUTIL_SWAP_SKIP_UNCHANGED)
+/**
+ * Checks whether a region has the same contents in both image slots.
+ *
+ * @param img_off               The offset of the region from the start of
+ *                                  the image slots.
+ * @param sz                    The size of the region, in bytes.
+ *
+ * @return                      1 if the contents are identical; 0 if they
+ *                                  differ or can't be read.
+ */
+static int
+boot_sectors_equal(uint32_t img_off, uint32_t sz)
+{
+    const struct flash_area *fap0;
+    const struct flash_area *fap1;
+    uint32_t off;
+    uint8_t *buf0;
+    uint8_t *buf1;
+    int chunk_sz;
+    int rc;
+
+    fap0 = NULL;
+    fap1 = NULL;
+
+    /* Each slot gets half of the copy buffer. */
+    buf0 = boot_copy_buf;
+    buf1 = boot_copy_buf + sizeof boot_copy_buf / 2;
+
+    rc = flash_area_open(FLASH_AREA_IMAGE_0, &fap0);
+    if (rc != 0) {
+        rc = 0;
+        goto done;
+    }
+    rc = flash_area_open(FLASH_AREA_IMAGE_1, &fap1);
+    if (rc != 0) {
+        rc = 0;
+        goto done;
+    }
+
+    for (off = 0; off < sz; off += chunk_sz) {
+        if (sz - off > sizeof boot_copy_buf / 2) {
+            chunk_sz = sizeof boot_copy_buf / 2;
+        } else {
+            chunk_sz = sz - off;
+        }
+
+        if (flash_area_read(fap0, img_off + off, buf0, chunk_sz) != 0 ||
+            flash_area_read(fap1, img_off + off, buf1, chunk_sz) != 0 ||
+            memcmp(buf0, buf1, chunk_sz) != 0) {
+
+            rc = 0;
+            goto done;
+        }
+    }
+
+    rc = 1;
+
+done:
+    flash_area_close(fap0);
+    flash_area_close(fap1);
+    return rc;
+}
+#endif
+
 /**
  * Swaps the contents of two flash regions within the two image slots.
  *
@@ -777,14 +1023,31 @@ done:
 static int
 boot_swap_sectors(int idx, uint32_t sz, struct boot_status *bs)
 {
+    const struct flash_area *fap;
+    uint32_t slot0_end;
     uint32_t copy_sz;
     uint32_t img_off;
+    int last;
     int rc;
+#if MYNEWT_VAL(BOOTUTIL_SWAP_SKIP_UNCHANGED)
+    int filled_scratch;
+
+    filled_scratch = 0;
+#endif
 
     /* Calculate offset from start of image area. */
     img_off = boot_data.imgs[0].sectors[idx].fa_off -
               boot_data.imgs[0].sectors[0].fa_off;
 
+    /* The region reaching the end of slot 0 holds the image trailers. */
+    rc = flash_area_open(FLASH_AREA_IMAGE_0, &fap);
+    if (rc != 0) {
+        return BOOT_EFLASH;
+    }
+    slot0_end = fap->fa_off + fap->fa_size;
+    flash_area_close(fap);
+    last = boot_data.imgs[0].sectors[idx].fa_off + sz >= slot0_end;
+
     if (bs->state == 0) {
         rc = boot_erase_sector(FLASH_AREA_IMAGE_SCRATCH, 0, sz);
         if (rc != 0) {
@@ -799,7 +1062,28 @@ boot_swap_sectors(int idx, uint32_t sz, struct boot_status *bs)
 
         bs->state = 1;
         (void)boot_write_status(bs);
+#if MYNEWT_VAL(BOOTUTIL_SWAP_SKIP_UNCHANGED)
+        filled_scratch = 1;
+#endif
     }
+#if MYNEWT_VAL(BOOTUTIL_SWAP_SKIP_UNCHANGED)
+    /* Having just filled scratch, neither slot has been touched.  If the
+     * region is the same in both, skip erasing and rewriting the slots.
+     * Scratch is still filled, so that resuming in state 2 after a reset is
+     * safe.  A swap resumed in state 1 may have half-written slot 1, so
+     * it is always completed.  The last region holds the image trailers
+     * and always gets swapped.
+     */
+    if (filled_scratch && !last && boot_sectors_equal(img_off, sz)) {
+
+        bs->state = 2;
+        (void)boot_write_status(bs);
+        bs->idx++;
+        bs->state = 0;
+        (void)boot_write_status(bs);
+        return 0;
+    }
+#endif
     if (bs->state == 1) {
         rc = boot_erase_sector(FLASH_AREA_IMAGE_1, img_off, sz);
         if (rc != 0) {
@@ -807,9 +1091,7 @@ boot_swap_sectors(int idx, uint32_t sz, struct boot_status *bs)
         }
 
         copy_sz = sz;
-        if (boot_data.imgs[0].sectors[idx].fa_off + sz >=
-            boot_data.imgs[1].sectors[0].fa_off) {
-
+        if (last) {
             /* This is the end of the area.  Don't copy the image state into
              * slot 1.
              */
@@ -845,6 +1127,117 @@ boot_swap_sectors(int idx, uint32_t sz, struct boot_status *bs)
     return 0;
 }
 
+#if MYNEWT_VAL(BOOTUTIL_SWAP_MOVE)
+/**
+ * Performs one step of a move-mode swap.  Each step only destroys data which
+ * an earlier step has already copied elsewhere, so a step that was
+ * interrupted by a reset can simply be redone.
+ *
+ * Steps are:
+ *     o Move body sectors of slot 0 up by one sector, last one first.
+ *     o For each body sector i, first one first:
+ *         - Copy sector i of slot 1 into sector i of slot 0.
+ *         - Copy sector i + 1 of slot 0 (the original sector i) into sector
+ *           i of slot 1.
+ *
+ * @param step                  The step to perform, counting from the first
+ *                                  move.
+ * @param num_body              The number of body sectors.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+static int
+boot_move_step(int step, int num_body)
+{
+    uint32_t sz;
+    int src_area;
+    int dst_area;
+    int src_idx;
+    int dst_idx;
+    int rc;
+
+    sz = boot_data.imgs[0].sectors[0].fa_size;
+
+    if (step < num_body) {
+        src_area = FLASH_AREA_IMAGE_0;
+        dst_area = FLASH_AREA_IMAGE_0;
+        src_idx = num_body - 1 - step;
+        dst_idx = src_idx + 1;
+    } else {
+        step -= num_body;
+        if (step % 2 == 0) {
+            src_area = FLASH_AREA_IMAGE_1;
+            dst_area = FLASH_AREA_IMAGE_0;
+            src_idx = step / 2;
+            dst_idx = step / 2;
+        } else {
+            src_area = FLASH_AREA_IMAGE_0;
+            dst_area = FLASH_AREA_IMAGE_1;
+            src_idx = step / 2 + 1;
+            dst_idx = step / 2;
+        }
+    }
+
+    rc = boot_erase_sector(dst_area, dst_idx * sz, sz);
+    if (rc != 0) {
+        return rc;
+    }
+
+    return boot_copy_sector(src_area, dst_area, src_idx * sz, dst_idx * sz,
+                            sz);
+}
+
+/**
+ * Swaps the two images without using the scratch area for the image data.
+ * The trailer sectors are swapped through scratch first, as in a normal
+ * swap; this also takes care of the image state.  The body sectors are then
+ * swapped by moving slot 0 up by one sector, and copying each sector of
+ * slot 1 down into the place freed by the sector it replaces.  Every sector
+ * of the slots is written the same number of times as in a normal swap, but
+ * scratch is only erased once per swap.
+ *
+ * Progress is recorded using the same status entries as a normal swap, taken
+ * as a running step count.
+ *
+ * @param bs                    The current boot status.
+ * @param num_body              The number of body sectors.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+static int
+boot_move_image(struct boot_status *bs, int num_body)
+{
+    int step;
+    int rc;
+
+    if (bs->idx == 0) {
+        rc = boot_swap_sectors(boot_data.imgs[0].num_sectors - 1,
+                               boot_data.imgs[0].sectors[0].fa_size, bs);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    step = bs->idx * BOOT_STATUS_STATE_COUNT + bs->state;
+    while (step < BOOT_MOVE_STEPS(num_body)) {
+        /* Pet the watchdog, in case it is still enabled after a soft reset. */
+        hal_watchdog_tickle();
+
+        rc = boot_move_step(step - BOOT_STATUS_STATE_COUNT, num_body);
+        if (rc != 0) {
+            return rc;
+        }
+
+        step++;
+        bs->idx = step / BOOT_STATUS_STATE_COUNT;
+        bs->state = step % BOOT_STATUS_STATE_COUNT;
+        (void)boot_write_status(bs);
+    }
+
+    return 0;
+}
+#endif
+
 /**
  * Swaps the two images in flash.  If a prior copy operation was interrupted
  * by a system reset, this function completes that operation.
@@ -864,6 +1257,13 @@ boot_copy_image(struct boot_status *bs)
     int first_sector_idx;
     int last_sector_idx;
     int swap_idx;
+#if MYNEWT_VAL(BOOTUTIL_SWAP_MOVE)
+    int num_body;
+
+    if (boot_swap_uses_move(&num_body)) {
+        return boot_move_image(bs, num_body);
+    }
+#endif
 
     swap_idx = 0;
     last_sector_idx = boot_data.imgs[0].num_sectors - 1;
@@ -1024,6 +1424,13 @@ boot_go(struct boot_rsp *rsp)
     boot_data.imgs[0].sectors = slot0_sectors;
     boot_data.imgs[1].sectors = slot1_sectors;
 
+#if MYNEWT_VAL(BOOTUTIL_WARM_BOOT)
+    if (boot_warm_go(rsp) == 0) {
+        return 0;
+    }
+    boot_warm_clear();
+#endif
+
     /* Determine the sector layout of the image slots and scratch area. */
     rc = boot_read_sectors();
     if (rc != 0) {
@@ -1055,6 +1462,9 @@ boot_go(struct boot_rsp *rsp)
         if (rc != 0) {
             return BOOT_EBADIMAGE;
         }
+#endif
+#if MYNEWT_VAL(BOOTUTIL_WARM_BOOT)
+        boot_warm_set(&boot_data.imgs[0].hdr);
 #endif
         slot = 0;
         break;
@@ -46,6 +46,21 @@ extern "C" {
 
 #define MBEDTLS_SHA256_SMALLER		/* comes with performance hit */
 
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(MBEDTLS_AES_HAL)
+#define MBEDTLS_AES_HAL_C		/* AES-128 encryption via hal_aes */
+#endif
+#if MYNEWT_VAL(MBEDTLS_SHA256_HAL)
+#define MBEDTLS_SHA256_HAL_C		/* one-shot SHA-256 via hal_sha256 */
+#endif
+#if MYNEWT_VAL(MBEDTLS_MN_SOCKET)
+#define MBEDTLS_MN_SOCKET_C		/* TLS I/O over mn_socket mbufs */
+#endif
+#if MYNEWT_VAL(MBEDTLS_SSL_MAX_CONTENT_LEN) != 16384
+#define MBEDTLS_SSL_MAX_CONTENT_LEN	MYNEWT_VAL(MBEDTLS_SSL_MAX_CONTENT_LEN)
+#endif
+
 /**
  * \name SECTION: Module configuration options
  *
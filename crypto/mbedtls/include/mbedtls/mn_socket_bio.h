@@ -0,0 +1,150 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/**
+ * \file mn_socket_bio.h
+ *
+ * \brief TLS I/O callbacks over mn_socket, passing records as mbuf chains.
+ *
+ * Received segments are queued as they come from mn_recvfrom() and TLS
+ * pulls record bytes straight out of them into its input buffer, where
+ * they are decrypted in place.  Outgoing records are copied once into an
+ * mbuf chain handed to mn_sendto().  Applications exchange plaintext as
+ * mbuf chains too, so no flat staging buffer is needed on either side.
+ */
+#ifndef MBEDTLS_MN_SOCKET_BIO_H
+#define MBEDTLS_MN_SOCKET_BIO_H
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#include "ssl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct mn_socket;
+struct os_mbuf;
+
+/**
+ * I/O context; pass it as the p_bio argument of mbedtls_ssl_set_bio().
+ */
+typedef struct
+{
+    struct mn_socket *sock;     /*!< stream socket, owned by the caller  */
+    struct os_mbuf *rx;         /*!< received bytes not yet read by TLS  */
+    struct os_mbuf *tx;         /*!< record bytes waiting for mn_sendto() */
+}
+mbedtls_mn_sock_context;
+
+/**
+ * \brief          Initialize a context for a connected stream socket.
+ *
+ * \param ctx      Context to initialize
+ * \param sock     Socket to read from and write to
+ */
+void mbedtls_mn_sock_init( mbedtls_mn_sock_context *ctx,
+                           struct mn_socket *sock );
+
+/**
+ * \brief          Free queued mbufs. The socket is not closed.
+ *
+ * \param ctx      Context to free
+ */
+void mbedtls_mn_sock_free( mbedtls_mn_sock_context *ctx );
+
+/**
+ * \brief          Send callback for mbedtls_ssl_set_bio().
+ *
+ * \return         Number of bytes accepted, MBEDTLS_ERR_SSL_WANT_WRITE if
+ *                 the previous record is still queued or no mbufs are
+ *                 free, or MBEDTLS_ERR_NET_SEND_FAILED.
+ */
+int mbedtls_mn_sock_send( void *ctx, const unsigned char *buf, size_t len );
+
+/**
+ * \brief          Receive callback for mbedtls_ssl_set_bio().
+ *
+ * \return         Number of bytes read, MBEDTLS_ERR_SSL_WANT_READ if no
+ *                 data is queued, MBEDTLS_ERR_NET_CONN_RESET if the peer
+ *                 closed the connection or MBEDTLS_ERR_NET_RECV_FAILED.
+ */
+int mbedtls_mn_sock_recv( void *ctx, unsigned char *buf, size_t len );
+
+/**
+ * \brief          Retry sending a queued record. Call this from the
+ *                 socket's writable callback.
+ *
+ * \return         0 when nothing is left queued, MBEDTLS_ERR_SSL_WANT_WRITE
+ *                 if the socket is still busy, or
+ *                 MBEDTLS_ERR_NET_SEND_FAILED.
+ */
+int mbedtls_mn_sock_flush( mbedtls_mn_sock_context *ctx );
+
+/**
+ * \brief          Read plaintext, appending it to an mbuf chain.
+ *
+ * \param ssl      SSL context
+ * \param om       Chain to append to; new mbufs come from msys
+ * \param len      Maximum number of bytes to append
+ *
+ * \return         Number of bytes appended, 0 if the peer closed the
+ *                 connection, MBEDTLS_ERR_SSL_ALLOC_FAILED if the chain
+ *                 could not be extended, or an error from
+ *                 mbedtls_ssl_read().
+ */
+int mbedtls_mn_ssl_read_mbuf( mbedtls_ssl_context *ssl, struct os_mbuf *om,
+                              size_t len );
+
+/**
+ * \brief          Write a plaintext mbuf chain, segment by segment.
+ *
+ * \param ssl      SSL context
+ * \param om       Chain to write; freed once all of it has been written
+ *
+ * \return         0 if the whole chain was written, or an error from
+ *                 mbedtls_ssl_write(). On error the bytes already written
+ *                 have been removed from the front of \c om; after
+ *                 MBEDTLS_ERR_SSL_WANT_WRITE call again with the same chain.
+ */
+int mbedtls_mn_ssl_write_mbuf( mbedtls_ssl_context *ssl, struct os_mbuf *om );
+
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+/**
+ * \brief          Request the largest max fragment length which fits
+ *                 MBEDTLS_SSL_MAX_CONTENT_LEN. Needed when the I/O buffers
+ *                 have been shrunk below the 16384 byte TLS default, so
+ *                 that peers do not send records which cannot be received.
+ *
+ * \param conf     SSL configuration
+ *
+ * \return         0 on success, MBEDTLS_ERR_SSL_BAD_INPUT_DATA if
+ *                 MBEDTLS_SSL_MAX_CONTENT_LEN is below 512.
+ */
+int mbedtls_mn_ssl_conf_max_frag_len( mbedtls_ssl_config *conf );
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MBEDTLS_MN_SOCKET_BIO_H */
@@ -39,6 +39,9 @@
 #if defined(MBEDTLS_PADLOCK_C)
 #include "mbedtls/padlock.h"
 #endif
+#if defined(MBEDTLS_AES_HAL_C)
+#include "hal/hal_aes.h"
+#endif
 #if defined(MBEDTLS_AESNI_C)
 #include "mbedtls/aesni.h"
 #endif
@@ -820,6 +823,28 @@ void mbedtls_aes_decrypt( mbedtls_aes_context *ctx,
 }
 #endif /* !MBEDTLS_AES_DECRYPT_ALT */
 
+#if defined(MBEDTLS_AES_HAL_C)
+/*
+ * AES-128 block encryption with the MCU's AES engine.  The first four
+ * round keys are the cipher key itself.
+ */
+static int aes_hal_encrypt( mbedtls_aes_context *ctx,
+                            const unsigned char input[16],
+                            unsigned char output[16] )
+{
+    unsigned char key[16];
+    int i, ret;
+
+    for( i = 0; i < 4; i++ )
+        PUT_UINT32_LE( ctx->rk[i], key, 4 * i );
+
+    ret = hal_aes128_encrypt( key, input, output );
+    mbedtls_zeroize( key, sizeof( key ) );
+
+    return( ret );
+}
+#endif /* MBEDTLS_AES_HAL_C */
+
 /*
  * AES-ECB block encryption/decryption
  */
@@ -845,6 +870,14 @@ int mbedtls_aes_crypt_ecb( mbedtls_aes_context *ctx,
     }
 #endif
 
+#if defined(MBEDTLS_AES_HAL_C)
+    if( mode == MBEDTLS_AES_ENCRYPT && ctx->nr == 10 &&
+        aes_hal_encrypt( ctx, input, output ) == 0 )
+        return( 0 );
+
+    // No AES engine available; fall back to software
+#endif
+
     if( mode == MBEDTLS_AES_ENCRYPT )
         mbedtls_aes_encrypt( ctx, input, output );
     else
@@ -0,0 +1,260 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*
+ *  TLS I/O callbacks for mn_socket, exchanging records and plaintext as
+ *  mbuf chains.
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#if defined(MBEDTLS_MN_SOCKET_C)
+
+#include "mbedtls/mn_socket_bio.h"
+#include "mbedtls/net.h"
+
+#include <string.h>
+
+#include "os/os.h"
+#include "mn_socket/mn_socket.h"
+
+void mbedtls_mn_sock_init( mbedtls_mn_sock_context *ctx,
+                           struct mn_socket *sock )
+{
+    memset( ctx, 0, sizeof( *ctx ) );
+    ctx->sock = sock;
+}
+
+void mbedtls_mn_sock_free( mbedtls_mn_sock_context *ctx )
+{
+    if( ctx->rx != NULL )
+        os_mbuf_free_chain( ctx->rx );
+    if( ctx->tx != NULL )
+        os_mbuf_free_chain( ctx->tx );
+    ctx->rx = NULL;
+    ctx->tx = NULL;
+}
+
+int mbedtls_mn_sock_flush( mbedtls_mn_sock_context *ctx )
+{
+    int rc;
+
+    if( ctx->tx == NULL )
+        return( 0 );
+
+    /*
+     * mn_sendto() takes the chain on success; on failure it stays ours.
+     */
+    rc = mn_sendto( ctx->sock, ctx->tx, NULL );
+    switch( rc )
+    {
+        case 0:
+            ctx->tx = NULL;
+            return( 0 );
+        case MN_EAGAIN:
+        case MN_ENOBUFS:
+            return( MBEDTLS_ERR_SSL_WANT_WRITE );
+        default:
+            os_mbuf_free_chain( ctx->tx );
+            ctx->tx = NULL;
+            return( MBEDTLS_ERR_NET_SEND_FAILED );
+    }
+}
+
+int mbedtls_mn_sock_send( void *p_ctx, const unsigned char *buf, size_t len )
+{
+    mbedtls_mn_sock_context *ctx = p_ctx;
+    struct os_mbuf *om;
+    int ret;
+
+    /*
+     * Only one record is kept queued; TLS retries with the same bytes
+     * after MBEDTLS_ERR_SSL_WANT_WRITE.
+     */
+    ret = mbedtls_mn_sock_flush( ctx );
+    if( ret != 0 )
+        return( ret );
+
+    if( len > UINT16_MAX )
+        len = UINT16_MAX;
+
+    om = os_msys_get_pkthdr( len, 0 );
+    if( om == NULL )
+        return( MBEDTLS_ERR_SSL_WANT_WRITE );
+    if( os_mbuf_append( om, buf, len ) != 0 )
+    {
+        os_mbuf_free_chain( om );
+        return( MBEDTLS_ERR_SSL_WANT_WRITE );
+    }
+    ctx->tx = om;
+
+    /*
+     * The bytes are ours now. If the socket is busy they go out from the
+     * writable callback, or with the next record.
+     */
+    ret = mbedtls_mn_sock_flush( ctx );
+    if( ret == MBEDTLS_ERR_NET_SEND_FAILED )
+        return( ret );
+
+    return( (int) len );
+}
+
+int mbedtls_mn_sock_recv( void *p_ctx, unsigned char *buf, size_t len )
+{
+    mbedtls_mn_sock_context *ctx = p_ctx;
+    uint16_t pktlen;
+    int rc;
+
+    if( ctx->rx == NULL )
+    {
+        rc = mn_recvfrom( ctx->sock, &ctx->rx, NULL );
+        switch( rc )
+        {
+            case 0:
+                break;
+            case MN_EAGAIN:
+                return( MBEDTLS_ERR_SSL_WANT_READ );
+            case MN_ENOTCONN:
+            case MN_ECONNABORTED:
+                return( MBEDTLS_ERR_NET_CONN_RESET );
+            default:
+                return( MBEDTLS_ERR_NET_RECV_FAILED );
+        }
+    }
+
+    /*
+     * TLS asks for the record header, then for the rest of the record, so
+     * bytes go straight from the segment into its input buffer.
+     */
+    pktlen = OS_MBUF_PKTLEN( ctx->rx );
+    if( len > pktlen )
+        len = pktlen;
+    os_mbuf_copydata( ctx->rx, 0, len, buf );
+
+    if( len == pktlen )
+    {
+        os_mbuf_free_chain( ctx->rx );
+        ctx->rx = NULL;
+    }
+    else
+    {
+        os_mbuf_adj( ctx->rx, len );
+        ctx->rx = os_mbuf_trim_front( ctx->rx );
+    }
+
+    return( (int) len );
+}
+
+int mbedtls_mn_ssl_read_mbuf( mbedtls_ssl_context *ssl, struct os_mbuf *om,
+                              size_t len )
+{
+    unsigned char dummy;
+    int ret;
+
+    /*
+     * A zero length read processes the next record, leaving the plaintext
+     * where it was decrypted; append it to the chain from there.
+     */
+    ret = mbedtls_ssl_read( ssl, &dummy, 0 );
+    if( ret != 0 )
+        return( ret );
+    if( ssl->in_offt == NULL )
+        return( 0 );
+
+    if( len > ssl->in_msglen )
+        len = ssl->in_msglen;
+    if( len > UINT16_MAX )
+        len = UINT16_MAX;
+    if( os_mbuf_append( om, ssl->in_offt, len ) != 0 )
+        return( MBEDTLS_ERR_SSL_ALLOC_FAILED );
+
+    ssl->in_msglen -= len;
+    if( ssl->in_msglen == 0 )
+        ssl->in_offt = NULL;
+    else
+        ssl->in_offt += len;
+
+    return( (int) len );
+}
+
+int mbedtls_mn_ssl_write_mbuf( mbedtls_ssl_context *ssl, struct os_mbuf *om )
+{
+    struct os_mbuf *m;
+    size_t written;
+    size_t done;
+    int ret;
+
+    done = 0;
+    written = 0;
+    ret = 0;
+    for( m = om; m != NULL; m = SLIST_NEXT( m, om_next ) )
+    {
+        while( ret == 0 && written < m->om_len )
+        {
+            ret = mbedtls_ssl_write( ssl, m->om_data + written,
+                                     m->om_len - written );
+            if( ret > 0 )
+            {
+                written += ret;
+                ret = 0;
+            }
+        }
+        if( ret != 0 )
+            break;
+        done += written;
+        written = 0;
+    }
+
+    if( ret == 0 )
+    {
+        os_mbuf_free_chain( om );
+        return( 0 );
+    }
+
+    /*
+     * Drop what went out, so that a retry passes TLS the same bytes it
+     * already has a record for.
+     */
+    os_mbuf_adj( om, done + written );
+    return( ret );
+}
+
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+int mbedtls_mn_ssl_conf_max_frag_len( mbedtls_ssl_config *conf )
+{
+    unsigned char mfl_code;
+
+    if( MBEDTLS_SSL_MAX_CONTENT_LEN >= 16384 )
+        return( 0 );
+
+    for( mfl_code = MBEDTLS_SSL_MAX_FRAG_LEN_4096;
+         mfl_code > MBEDTLS_SSL_MAX_FRAG_LEN_NONE; mfl_code-- )
+    {
+        if( ( 256u << mfl_code ) <= MBEDTLS_SSL_MAX_CONTENT_LEN )
+            return( mbedtls_ssl_conf_max_frag_len( conf, mfl_code ) );
+    }
+
+    return( MBEDTLS_ERR_SSL_BAD_INPUT_DATA );
+}
+#endif /* MBEDTLS_SSL_MAX_FRAGMENT_LENGTH */
+
+#endif /* MBEDTLS_MN_SOCKET_C */
@@ -36,6 +36,10 @@
 
 #include <string.h>
 
+#if defined(MBEDTLS_SHA256_HAL_C)
+#include "hal/hal_sha256.h"
+#endif
+
 #if defined(MBEDTLS_SELF_TEST)
 #if defined(MBEDTLS_PLATFORM_C)
 #include "mbedtls/platform.h"
@@ -325,6 +329,16 @@ void mbedtls_sha256( const unsigned char *input, size_t ilen,
 {
     mbedtls_sha256_context ctx;
 
+#if defined(MBEDTLS_SHA256_HAL_C)
+    /* Only one-shot hashes can use the engine; contexts may interleave */
+    if( is224 == 0 && hal_sha256_start() == 0 )
+    {
+        hal_sha256_update( input, ilen );
+        hal_sha256_finish( output );
+        return;
+    }
+#endif
+
     mbedtls_sha256_init( &ctx );
     mbedtls_sha256_starts( &ctx, is224 );
     mbedtls_sha256_update( &ctx, input, ilen );
@@ -33,6 +33,10 @@
 #include <tinycrypt/aes.h>
 #include <tinycrypt/utils.h>
 #include <tinycrypt/constants.h>
+#include "syscfg/syscfg.h"
+#if MYNEWT_VAL(TINYCRYPT_AES_HAL)
+#include "hal/hal_aes.h"
+#endif
 
 static const uint8_t sbox[256] = {
 	0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b,
@@ -168,6 +172,22 @@ int32_t tc_aes_encrypt(uint8_t *out, const uint8_t *in, const TCAesKeySched_t s)
 		return TC_CRYPTO_FAIL;
 	}
 
+#if MYNEWT_VAL(TINYCRYPT_AES_HAL)
+	/* The first Nk words of the schedule are the cipher key itself. */
+	for (i = 0; i < Nk; ++i) {
+		state[Nb*i] = (uint8_t)(s->words[i] >> 24);
+		state[Nb*i+1] = (uint8_t)(s->words[i] >> 16);
+		state[Nb*i+2] = (uint8_t)(s->words[i] >> 8);
+		state[Nb*i+3] = (uint8_t)(s->words[i]);
+	}
+	i = hal_aes128_encrypt(state, in, out);
+	_set(state, TC_ZERO_BYTE, sizeof(state));
+	if (i == 0) {
+		return TC_CRYPTO_SUCCESS;
+	}
+	/* No AES engine available; fall back to software. */
+#endif
+
 	(void)_copy(state, sizeof(state), in, sizeof(state));
 	add_round_key(state, s->words);
 
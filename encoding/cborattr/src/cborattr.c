@@ -133,13 +133,57 @@ cbor_target_address(const struct cbor_attr_t *cursor,
     return targetaddr;
 }
 
+/*
+ * Find attribute matching key name and value type.  Search starts from the
+ * attribute after the one matched for the previous key; encoders usually
+ * emit keys in the same order as the attributes are listed, in which case
+ * every key matches on the first comparison.
+ */
+static const struct cbor_attr_t *
+cbor_find_attr(const struct cbor_attr_t *attrs, const struct cbor_attr_t *hint,
+               const char *name, size_t len, CborType type)
+{
+    const struct cbor_attr_t *cursor;
+    const struct cbor_attr_t *best_match;
+
+    if (name[0] == '\0') {
+        best_match = NULL;
+        for (cursor = attrs; cursor->attribute != NULL; cursor++) {
+            if (cursor->attribute == CBORATTR_ATTR_UNNAMED &&
+                valid_attr_type(type, cursor->type)) {
+                best_match = cursor;
+            }
+        }
+        return best_match;
+    }
+
+    if (!hint || !hint->attribute) {
+        hint = attrs;
+    }
+    cursor = hint;
+    do {
+        if (cursor->attribute != CBORATTR_ATTR_UNNAMED &&
+            cursor->attribute[0] == name[0] &&
+            valid_attr_type(type, cursor->type) &&
+            strlen(cursor->attribute) == len &&
+            !memcmp(cursor->attribute, name, len)) {
+            return cursor;
+        }
+        cursor++;
+        if (!cursor->attribute) {
+            cursor = attrs;
+        }
+    } while (cursor != hint);
+    return NULL;
+}
+
 static int
 cbor_internal_read_object(CborValue *root_value,
                           const struct cbor_attr_t *attrs,
                           const struct cbor_array_t *parent,
                           int offset)
 {
-    const struct cbor_attr_t *cursor, *best_match;
+    const struct cbor_attr_t *cursor, *hint;
     char attrbuf[MYNEWT_VAL(CBORATTR_MAX_SIZE) + 1];
     void *lptr;
     CborValue cur_value;
@@ -186,6 +230,7 @@ cbor_internal_read_object(CborValue *root_value,
     }
 
     /* contains key value pairs */
+    hint = NULL;
     while (cbor_value_is_valid(&cur_value)) {
         /* get the attribute */
         if (cbor_value_is_text_string(&cur_value)) {
@@ -196,6 +241,7 @@ cbor_internal_read_object(CborValue *root_value,
                 }
                 err |= cbor_value_copy_text_string(&cur_value, attrbuf, &len,
                                                      NULL);
+                attrbuf[len] = '\0';
             }
 
             /* at least get the type of the next value so we can match the
@@ -209,27 +255,15 @@ cbor_internal_read_object(CborValue *root_value,
             }
         } else {
             attrbuf[0] = '\0';
+            len = 0;
             type = cbor_value_get_type(&cur_value);
         }
 
         /* find this attribute in our list */
-        best_match = NULL;
-        for (cursor = attrs; cursor->attribute != NULL; cursor++) {
-            if (valid_attr_type(type, cursor->type)) {
-                if (cursor->attribute == CBORATTR_ATTR_UNNAMED &&
-                    attrbuf[0] == '\0') {
-                    best_match = cursor;
-                } else if (strlen(cursor->attribute) == len &&
-                    !memcmp(cursor->attribute, attrbuf, len)) {
-                    break;
-                }
-            }
-        }
-        if (!cursor->attribute && best_match) {
-            cursor = best_match;
-        }
+        cursor = cbor_find_attr(attrs, hint, attrbuf, len, type);
         /* we found a match */
-        if (cursor->attribute != NULL) {
+        if (cursor != NULL) {
+            hint = cursor + 1;
             lptr = cbor_target_address(cursor, parent, offset);
             switch (cursor->type) {
             case CborAttrNullType:
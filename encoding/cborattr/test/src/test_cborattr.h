@@ -48,6 +48,8 @@ TEST_CASE_DECL(test_cborattr_decode_string_array);
 TEST_CASE_DECL(test_cborattr_decode_object_array);
 TEST_CASE_DECL(test_cborattr_decode_unnamed_array);
 TEST_CASE_DECL(test_cborattr_decode_substring_key);
+TEST_CASE_DECL(test_cborattr_decode_key_order);
+TEST_CASE_DECL(test_cborattr_decode_bench);
 
 
 #ifdef __cplusplus
@@ -0,0 +1,69 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "test_cborattr.h"
+
+/*
+ * Not a functional test; reports the cost of decoding a flat map, with
+ * every key wanted and with only the last one wanted.
+ */
+TEST_CASE(test_cborattr_decode_bench)
+{
+    const uint8_t *data;
+    int len;
+    int rc;
+    char test_str_a[4];
+    char test_str_c[4];
+    char test_str_e[4];
+    struct cbor_attr_t test_attrs[] = {
+        [0] = {
+            .attribute = "a",
+            .type = CborAttrTextStringType,
+            .addr.string = test_str_a,
+            .len = sizeof(test_str_a),
+        },
+        [1] = {
+            .attribute = "c",
+            .type = CborAttrTextStringType,
+            .addr.string = test_str_c,
+            .len = sizeof(test_str_c),
+        },
+        [2] = {
+            .attribute = "e",
+            .type = CborAttrTextStringType,
+            .addr.string = test_str_e,
+            .len = sizeof(test_str_e),
+        },
+        [3] = {
+            .attribute = NULL
+        }
+    };
+
+    data = test_str1(&len);
+
+    TEST_BENCH_BEGIN("flat_3_of_5", 5000) {
+        rc = cbor_read_flat_attrs(data, len, test_attrs);
+        TEST_ASSERT_FATAL(rc == 0);
+    } TEST_BENCH_END();
+    TEST_ASSERT(!strcmp(test_str_e, "E"));
+
+    TEST_BENCH_BEGIN("flat_last_of_5", 5000) {
+        rc = cbor_read_flat_attrs(data, len, &test_attrs[2]);
+        TEST_ASSERT_FATAL(rc == 0);
+    } TEST_BENCH_END();
+}
@@ -0,0 +1,83 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "test_cborattr.h"
+#include <tinycbor/cbor_buf_writer.h>
+
+/*
+ * Keys in different order than attributes, and a key not in attributes.
+ */
+TEST_CASE(test_cborattr_decode_key_order)
+{
+    struct cbor_buf_writer writer;
+    struct CborEncoder enc;
+    struct CborEncoder map;
+    uint8_t data[64];
+    long long int a, b, bb;
+    char str[8];
+    int rc;
+    const struct cbor_attr_t test_attrs[] = {
+        [0] = {
+            .attribute = "a",
+            .type = CborAttrIntegerType,
+            .addr.integer = &a,
+        },
+        [1] = {
+            .attribute = "bb",
+            .type = CborAttrIntegerType,
+            .addr.integer = &bb,
+        },
+        [2] = {
+            .attribute = "b",
+            .type = CborAttrIntegerType,
+            .addr.integer = &b,
+        },
+        [3] = {
+            .attribute = "str",
+            .type = CborAttrTextStringType,
+            .addr.string = str,
+            .len = sizeof(str),
+        },
+        [4] = {
+            .attribute = NULL
+        }
+    };
+
+    cbor_buf_writer_init(&writer, data, sizeof(data));
+    cbor_encoder_init(&enc, &writer.enc, 0);
+    cbor_encoder_create_map(&enc, &map, CborIndefiniteLength);
+    cbor_encode_text_stringz(&map, "str");
+    cbor_encode_text_stringz(&map, "s");
+    cbor_encode_text_stringz(&map, "b");
+    cbor_encode_int(&map, 3);
+    cbor_encode_text_stringz(&map, "c");
+    cbor_encode_int(&map, 4);
+    cbor_encode_text_stringz(&map, "a");
+    cbor_encode_int(&map, 1);
+    cbor_encode_text_stringz(&map, "bb");
+    cbor_encode_int(&map, 2);
+    cbor_encoder_close_container(&enc, &map);
+
+    rc = cbor_read_flat_attrs(data, cbor_encode_bytes_written(&enc),
+                              test_attrs);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(a == 1);
+    TEST_ASSERT(bb == 2);
+    TEST_ASSERT(b == 3);
+    TEST_ASSERT(!strcmp(str, "s"));
+}
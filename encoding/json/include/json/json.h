@@ -88,11 +88,21 @@ struct json_encoder {
     void *je_arg;
     int je_wr_commas:1;
     char je_encode_buf[64];
+    char *je_buf;               /* Output buffer; NULL if unbuffered */
+    uint16_t je_buf_size;
+    uint16_t je_buf_len;
 };
 
 
 #define JSON_NITEMS(x) (int)(sizeof(x)/sizeof(x[0]))
 
+/*
+ * Collect output to buf, and pass it to je_write only when full.  Caller
+ * must call json_encode_flush() after encoding is done.
+ */
+void json_encode_set_buf(struct json_encoder *encoder, char *buf, int size);
+int json_encode_flush(struct json_encoder *encoder);
+
 int json_encode_object_start(struct json_encoder *);
 int json_encode_object_key(struct json_encoder *encoder, char *key);
 int json_encode_object_entry(struct json_encoder *, char *,
@@ -226,6 +236,55 @@ int json_read_array(struct json_buffer *, const struct json_array_t *);
 #define JSON_ERR_MISC        20  /* other data conversion error */
 #define JSON_ERR_BADNUM      21  /* error while parsing a numerical argument */
 #define JSON_ERR_NULLPTR     22  /* unexpected null value or attribute pointer */
+#define JSON_ERR_DEPTH       23  /* objects/arrays nested too deep */
+
+/*
+ * Incremental decoding.  Input is passed to json_stream_feed() in chunks
+ * as it arrives (e.g. one mbuf at a time), and the callback is called for
+ * each value once it is complete.  key is the member name for values
+ * inside objects, and NULL within arrays and at top level.  val is the
+ * NUL terminated value for strings, numbers, booleans and null; strings
+ * have escapes decoded.  Nonzero return from callback stops decoding, and
+ * is returned by json_stream_feed().
+ */
+#define JSON_STREAM_OBJ_START   1
+#define JSON_STREAM_OBJ_END     2
+#define JSON_STREAM_ARR_START   3
+#define JSON_STREAM_ARR_END     4
+#define JSON_STREAM_STRING      5
+#define JSON_STREAM_NUMBER      6
+#define JSON_STREAM_BOOL        7
+#define JSON_STREAM_NULL        8
+
+struct json_stream;
+typedef int (*json_stream_cb_t)(struct json_stream *js, int type,
+        const char *key, char *val, int len, void *arg);
+
+struct json_stream {
+    json_stream_cb_t js_cb;
+    void *js_arg;
+    char *js_buf;               /* Value being decoded */
+    uint16_t js_buf_len;
+    uint16_t js_len;
+    uint16_t js_u;              /* \u escape being decoded */
+    uint8_t js_state;
+    uint8_t js_esc;
+    uint8_t js_depth;
+    uint8_t js_key_valid:1;
+    int js_err;
+    uint32_t js_ctx;            /* Bit per depth; set if array */
+    char js_key[JSON_ATTR_MAX + 1];
+};
+
+/*
+ * buf holds one value at a time; longer strings fail with
+ * JSON_ERR_STRLONG.
+ */
+void json_stream_init(struct json_stream *js, char *buf, int buf_len,
+        json_stream_cb_t cb, void *arg);
+int json_stream_feed(struct json_stream *js, const char *data, int len);
+/* Returns 0 if input ended with a complete top level value. */
+int json_stream_finish(struct json_stream *js);
 
 /*
  * Use the following macros to declare template initializers for structobject
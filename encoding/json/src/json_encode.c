@@ -22,24 +22,81 @@
 
 #include <json/json.h>
 
+/*
+ * Output goes through the caller's buffer, if one was given with
+ * json_encode_set_buf(); otherwise straight to je_write.
+ */
+static void
+json_write(struct json_encoder *encoder, const char *data, int len)
+{
+    if (len == 0) {
+        return;
+    }
+    if (!encoder->je_buf) {
+        encoder->je_write(encoder->je_arg, (char *)data, len);
+        return;
+    }
+    if (encoder->je_buf_len + len > encoder->je_buf_size) {
+        json_encode_flush(encoder);
+        if (len >= encoder->je_buf_size) {
+            encoder->je_write(encoder->je_arg, (char *)data, len);
+            return;
+        }
+    }
+    memcpy(encoder->je_buf + encoder->je_buf_len, data, len);
+    encoder->je_buf_len += len;
+}
+
+/*
+ * Formats v in decimal to the end of buf.  Returns where the number starts.
+ */
+static char *
+json_fmt_u64(char *end, uint64_t v)
+{
+    do {
+        *--end = '0' + v % 10;
+        v /= 10;
+    } while (v);
+    return end;
+}
+
+void
+json_encode_set_buf(struct json_encoder *encoder, char *buf, int size)
+{
+    encoder->je_buf = buf;
+    encoder->je_buf_size = size;
+    encoder->je_buf_len = 0;
+}
+
+int
+json_encode_flush(struct json_encoder *encoder)
+{
+    if (encoder->je_buf && encoder->je_buf_len) {
+        encoder->je_write(encoder->je_arg, encoder->je_buf,
+                encoder->je_buf_len);
+        encoder->je_buf_len = 0;
+    }
+    return (0);
+}
+
 #define JSON_ENCODE_OBJECT_START(__e) \
-    (__e)->je_write((__e)->je_arg, "{", sizeof("{")-1);
+    json_write((__e), "{", sizeof("{")-1);
 
 #define JSON_ENCODE_OBJECT_END(__e) \
-    (__e)->je_write((__e)->je_arg, "}", sizeof("}")-1);
+    json_write((__e), "}", sizeof("}")-1);
 
 #define JSON_ENCODE_ARRAY_START(__e) \
-    (__e)->je_write((__e)->je_arg, "[", sizeof("[")-1);
+    json_write((__e), "[", sizeof("[")-1);
 
 #define JSON_ENCODE_ARRAY_END(__e) \
-    (__e)->je_write((__e)->je_arg, "]", sizeof("]")-1);
+    json_write((__e), "]", sizeof("]")-1);
 
 
 int
 json_encode_object_start(struct json_encoder *encoder)
 {
     if (encoder->je_wr_commas) {
-        encoder->je_write(encoder->je_arg, ",", sizeof(",")-1);
+        json_write(encoder, ",", sizeof(",")-1);
         encoder->je_wr_commas = 0;
     }
     JSON_ENCODE_OBJECT_START(encoder);
@@ -53,65 +110,73 @@ json_encode_value(struct json_encoder *encoder, struct json_value *jv)
 {
     int rc;
     int i;
-    int len;
+    char *str;
+    char *end;
+    const char *esc;
 
     switch (jv->jv_type) {
         case JSON_VALUE_TYPE_BOOL:
-            len = sprintf(encoder->je_encode_buf, "%s",
-                    jv->jv_val.u > 0 ? "true" : "false");
-            encoder->je_write(encoder->je_arg, encoder->je_encode_buf, len);
+            if (jv->jv_val.u > 0) {
+                json_write(encoder, "true", sizeof("true")-1);
+            } else {
+                json_write(encoder, "false", sizeof("false")-1);
+            }
             break;
         case JSON_VALUE_TYPE_UINT64:
-            len = sprintf(encoder->je_encode_buf, "%llu",
-                    jv->jv_val.u);
-            encoder->je_write(encoder->je_arg, encoder->je_encode_buf, len);
+            end = encoder->je_encode_buf + sizeof(encoder->je_encode_buf);
+            str = json_fmt_u64(end, jv->jv_val.u);
+            json_write(encoder, str, end - str);
             break;
         case JSON_VALUE_TYPE_INT64:
-            len = sprintf(encoder->je_encode_buf, "%lld",
-                    jv->jv_val.u);
-            encoder->je_write(encoder->je_arg, encoder->je_encode_buf, len);
+            end = encoder->je_encode_buf + sizeof(encoder->je_encode_buf);
+            if ((int64_t)jv->jv_val.u < 0) {
+                str = json_fmt_u64(end, -jv->jv_val.u);
+                *--str = '-';
+            } else {
+                str = json_fmt_u64(end, jv->jv_val.u);
+            }
+            json_write(encoder, str, end - str);
             break;
         case JSON_VALUE_TYPE_STRING:
-            encoder->je_write(encoder->je_arg, "\"", sizeof("\"")-1);
+            json_write(encoder, "\"", sizeof("\"")-1);
+            /* Characters not needing escape are written in runs. */
+            str = jv->jv_val.str;
             for (i = 0; i < jv->jv_len; i++) {
                 switch (jv->jv_val.str[i]) {
                     case '"':
                     case '/':
                     case '\\':
-                        encoder->je_write(encoder->je_arg, "\\",
-                                sizeof("\\")-1);
-                        encoder->je_write(encoder->je_arg,
-                                (char *) &jv->jv_val.str[i], 1);
-
+                        esc = NULL;
                         break;
                     case '\t':
-                        encoder->je_write(encoder->je_arg, "\\t",
-                                sizeof("\\t")-1);
+                        esc = "\\t";
                         break;
                     case '\r':
-                        encoder->je_write(encoder->je_arg, "\\r",
-                                sizeof("\\r")-1);
+                        esc = "\\r";
                         break;
                     case '\n':
-                        encoder->je_write(encoder->je_arg, "\\n",
-                                sizeof("\\n")-1);
+                        esc = "\\n";
                         break;
                     case '\f':
-                        encoder->je_write(encoder->je_arg, "\\f",
-                                sizeof("\\f")-1);
+                        esc = "\\f";
                         break;
                     case '\b':
-                        encoder->je_write(encoder->je_arg, "\\b",
-                                sizeof("\\b")-1);
+                        esc = "\\b";
                         break;
                    default:
-                        encoder->je_write(encoder->je_arg,
-                                (char *) &jv->jv_val.str[i], 1);
-                        break;
+                        continue;
+                }
+                json_write(encoder, str, &jv->jv_val.str[i] - str);
+                if (esc) {
+                    json_write(encoder, esc, 2);
+                    str = &jv->jv_val.str[i + 1];
+                } else {
+                    json_write(encoder, "\\", sizeof("\\")-1);
+                    str = &jv->jv_val.str[i];
                 }
-
             }
-            encoder->je_write(encoder->je_arg, "\"", sizeof("\"")-1);
+            json_write(encoder, str, &jv->jv_val.str[i] - str);
+            json_write(encoder, "\"", sizeof("\"")-1);
             break;
         case JSON_VALUE_TYPE_ARRAY:
             JSON_ENCODE_ARRAY_START(encoder);
@@ -121,7 +186,7 @@ json_encode_value(struct json_encoder *encoder, struct json_value *jv)
                     goto err;
                 }
                 if (i != jv->jv_len - 1) {
-                    encoder->je_write(encoder->je_arg, ",", sizeof(",")-1);
+                    json_write(encoder, ",", sizeof(",")-1);
                 }
             }
             JSON_ENCODE_ARRAY_END(encoder);
@@ -153,14 +218,14 @@ int
 json_encode_object_key(struct json_encoder *encoder, char *key)
 {
     if (encoder->je_wr_commas) {
-        encoder->je_write(encoder->je_arg, ",", sizeof(",")-1);
+        json_write(encoder, ",", sizeof(",")-1);
         encoder->je_wr_commas = 0;
     }
 
     /* Write the key entry */
-    encoder->je_write(encoder->je_arg, "\"", sizeof("\"")-1);
-    encoder->je_write(encoder->je_arg, key, strlen(key));
-    encoder->je_write(encoder->je_arg, "\": ", sizeof("\": ")-1);
+    json_write(encoder, "\"", sizeof("\"")-1);
+    json_write(encoder, key, strlen(key));
+    json_write(encoder, "\": ", sizeof("\": ")-1);
 
     return (0);
 }
@@ -172,13 +237,13 @@ json_encode_object_entry(struct json_encoder *encoder, char *key,
     int rc;
 
     if (encoder->je_wr_commas) {
-        encoder->je_write(encoder->je_arg, ",", sizeof(",")-1);
+        json_write(encoder, ",", sizeof(",")-1);
         encoder->je_wr_commas = 0;
     }
     /* Write the key entry */
-    encoder->je_write(encoder->je_arg, "\"", sizeof("\"")-1);
-    encoder->je_write(encoder->je_arg, key, strlen(key));
-    encoder->je_write(encoder->je_arg, "\": ", sizeof("\": ")-1);
+    json_write(encoder, "\"", sizeof("\"")-1);
+    json_write(encoder, key, strlen(key));
+    json_write(encoder, "\": ", sizeof("\": ")-1);
 
     rc = json_encode_value(encoder, val);
     if (rc != 0) {
@@ -222,7 +287,7 @@ json_encode_array_value(struct json_encoder *encoder, struct json_value *jv)
     int rc;
 
     if (encoder->je_wr_commas) {
-        encoder->je_write(encoder->je_arg, ",", sizeof(",")-1);
+        json_write(encoder, ",", sizeof(",")-1);
         encoder->je_wr_commas = 0;
     }
 
@@ -0,0 +1,386 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Incremental JSON tokenizer.  Input is fed in chunks as it arrives, and
+ * a callback is called for every value as soon as it is complete.  Only
+ * the current key and value are buffered.
+ */
+
+#include <string.h>
+
+#include <json/json.h>
+
+#define JSON_S_VALUE            0   /* expecting value */
+#define JSON_S_VALUE_OR_END     1   /* after '[' */
+#define JSON_S_KEY              2   /* after ',' in object */
+#define JSON_S_KEY_OR_END       3   /* after '{' */
+#define JSON_S_KEY_STR          4   /* inside key */
+#define JSON_S_COLON            5   /* after key */
+#define JSON_S_STR              6   /* inside string value */
+#define JSON_S_LIT              7   /* inside number, true, false or null */
+#define JSON_S_AFTER            8   /* after value */
+#define JSON_S_DONE             9   /* top level value complete */
+#define JSON_S_ERR              10
+
+#define JSON_STREAM_MAX_DEPTH   32
+
+void
+json_stream_init(struct json_stream *js, char *buf, int buf_len,
+                 json_stream_cb_t cb, void *arg)
+{
+    memset(js, 0, sizeof(*js));
+    js->js_buf = buf;
+    js->js_buf_len = buf_len;
+    js->js_cb = cb;
+    js->js_arg = arg;
+    js->js_state = JSON_S_VALUE;
+}
+
+static int
+json_stream_in_array(struct json_stream *js)
+{
+    return js->js_depth && (js->js_ctx & (1UL << (js->js_depth - 1)));
+}
+
+static int
+json_stream_emit(struct json_stream *js, int type, char *val, int len)
+{
+    const char *key;
+
+    key = js->js_key_valid ? js->js_key : NULL;
+    js->js_key_valid = 0;
+    return js->js_cb(js, type, key, val, len, js->js_arg);
+}
+
+/*
+ * Value has been completed; what's expected next.
+ */
+static void
+json_stream_value_done(struct json_stream *js)
+{
+    js->js_state = js->js_depth ? JSON_S_AFTER : JSON_S_DONE;
+}
+
+static int
+json_stream_push(struct json_stream *js, int type)
+{
+    int rc;
+
+    if (js->js_depth >= JSON_STREAM_MAX_DEPTH) {
+        return JSON_ERR_DEPTH;
+    }
+    rc = json_stream_emit(js, type, NULL, 0);
+    if (rc) {
+        return rc;
+    }
+    if (type == JSON_STREAM_ARR_START) {
+        js->js_ctx |= 1UL << js->js_depth;
+        js->js_state = JSON_S_VALUE_OR_END;
+    } else {
+        js->js_ctx &= ~(1UL << js->js_depth);
+        js->js_state = JSON_S_KEY_OR_END;
+    }
+    js->js_depth++;
+    return 0;
+}
+
+static int
+json_stream_pop(struct json_stream *js, char c)
+{
+    int rc;
+
+    if (json_stream_in_array(js) != (c == ']')) {
+        return JSON_ERR_BADTRAIL;
+    }
+    js->js_depth--;
+    rc = json_stream_emit(js, c == ']' ? JSON_STREAM_ARR_END :
+                          JSON_STREAM_OBJ_END, NULL, 0);
+    if (rc) {
+        return rc;
+    }
+    json_stream_value_done(js);
+    return 0;
+}
+
+static int
+json_stream_lit_done(struct json_stream *js)
+{
+    char *val;
+    int type;
+
+    val = js->js_buf;
+    val[js->js_len] = '\0';
+    if (!strcmp(val, "true") || !strcmp(val, "false")) {
+        type = JSON_STREAM_BOOL;
+    } else if (!strcmp(val, "null")) {
+        type = JSON_STREAM_NULL;
+    } else if (val[0] == '-' || (val[0] >= '0' && val[0] <= '9')) {
+        type = JSON_STREAM_NUMBER;
+    } else {
+        return JSON_ERR_BADNUM;
+    }
+    json_stream_value_done(js);
+    return json_stream_emit(js, type, val, js->js_len);
+}
+
+static int
+json_stream_is_lit(char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') ||
+      (c >= 'A' && c <= 'Z') || c == '-' || c == '+' || c == '.';
+}
+
+static int
+json_stream_is_ws(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static int
+json_stream_hex(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+/*
+ * Adds character of key or string value, handling escapes.  Returns 1 when
+ * the closing quote is seen.
+ */
+static int
+json_stream_str_char(struct json_stream *js, char c, char *buf, int size)
+{
+    int d;
+
+    if (js->js_esc == 1) {
+        js->js_esc = 0;
+        switch (c) {
+        case 'b':
+            c = '\b';
+            break;
+        case 'f':
+            c = '\f';
+            break;
+        case 'n':
+            c = '\n';
+            break;
+        case 'r':
+            c = '\r';
+            break;
+        case 't':
+            c = '\t';
+            break;
+        case 'u':
+            js->js_esc = 2;
+            js->js_u = 0;
+            return 0;
+        default:
+            break;
+        }
+    } else if (js->js_esc > 1) {
+        d = json_stream_hex(c);
+        if (d < 0) {
+            return -JSON_ERR_BADSTRING;
+        }
+        js->js_u = (js->js_u << 4) | d;
+        if (++js->js_esc < 6) {
+            return 0;
+        }
+        js->js_esc = 0;
+        /* Encode as UTF-8. */
+        if (js->js_u >= 0x800) {
+            if (js->js_len + 3 > size) {
+                return -JSON_ERR_STRLONG;
+            }
+            buf[js->js_len++] = 0xe0 | (js->js_u >> 12);
+            buf[js->js_len++] = 0x80 | ((js->js_u >> 6) & 0x3f);
+            c = 0x80 | (js->js_u & 0x3f);
+        } else if (js->js_u >= 0x80) {
+            if (js->js_len + 2 > size) {
+                return -JSON_ERR_STRLONG;
+            }
+            buf[js->js_len++] = 0xc0 | (js->js_u >> 6);
+            c = 0x80 | (js->js_u & 0x3f);
+        } else {
+            c = js->js_u;
+        }
+    } else if (c == '\\') {
+        js->js_esc = 1;
+        return 0;
+    } else if (c == '"') {
+        buf[js->js_len] = '\0';
+        return 1;
+    }
+    if (js->js_len + 1 > size) {
+        return -JSON_ERR_STRLONG;
+    }
+    buf[js->js_len++] = c;
+    return 0;
+}
+
+static int
+json_stream_char(struct json_stream *js, char c)
+{
+    int rc;
+
+    switch (js->js_state) {
+    case JSON_S_LIT:
+        if (json_stream_is_lit(c)) {
+            if (js->js_len + 1 >= js->js_buf_len) {
+                return JSON_ERR_TOKLONG;
+            }
+            js->js_buf[js->js_len++] = c;
+            return 0;
+        }
+        rc = json_stream_lit_done(js);
+        if (rc) {
+            return rc;
+        }
+        /* Character after the literal is handled in the new state. */
+        return json_stream_char(js, c);
+    case JSON_S_STR:
+        rc = json_stream_str_char(js, c, js->js_buf, js->js_buf_len - 1);
+        if (rc < 0) {
+            return -rc;
+        } else if (rc > 0) {
+            json_stream_value_done(js);
+            return json_stream_emit(js, JSON_STREAM_STRING, js->js_buf,
+                                    js->js_len);
+        }
+        return 0;
+    case JSON_S_KEY_STR:
+        rc = json_stream_str_char(js, c, js->js_key, JSON_ATTR_MAX);
+        if (rc < 0) {
+            return rc == -JSON_ERR_STRLONG ? JSON_ERR_ATTRLEN : -rc;
+        } else if (rc > 0) {
+            js->js_state = JSON_S_COLON;
+        }
+        return 0;
+    default:
+        break;
+    }
+
+    if (json_stream_is_ws(c)) {
+        return 0;
+    }
+
+    switch (js->js_state) {
+    case JSON_S_VALUE_OR_END:
+        if (c == ']') {
+            return json_stream_pop(js, c);
+        }
+        /* fallthrough */
+    case JSON_S_VALUE:
+        js->js_len = 0;
+        js->js_esc = 0;
+        if (c == '{') {
+            return json_stream_push(js, JSON_STREAM_OBJ_START);
+        } else if (c == '[') {
+            return json_stream_push(js, JSON_STREAM_ARR_START);
+        } else if (c == '"') {
+            js->js_state = JSON_S_STR;
+        } else if (json_stream_is_lit(c)) {
+            js->js_buf[js->js_len++] = c;
+            js->js_state = JSON_S_LIT;
+        } else {
+            return JSON_ERR_MISC;
+        }
+        return 0;
+    case JSON_S_KEY_OR_END:
+        if (c == '}') {
+            return json_stream_pop(js, c);
+        }
+        /* fallthrough */
+    case JSON_S_KEY:
+        if (c != '"') {
+            return JSON_ERR_ATTRSTART;
+        }
+        js->js_len = 0;
+        js->js_esc = 0;
+        js->js_state = JSON_S_KEY_STR;
+        return 0;
+    case JSON_S_COLON:
+        if (c != ':') {
+            return JSON_ERR_BADTRAIL;
+        }
+        js->js_key_valid = 1;
+        js->js_state = JSON_S_VALUE;
+        return 0;
+    case JSON_S_AFTER:
+        if (c == ',') {
+            js->js_state = json_stream_in_array(js) ? JSON_S_VALUE :
+              JSON_S_KEY;
+            return 0;
+        } else if (c == '}' || c == ']') {
+            return json_stream_pop(js, c);
+        }
+        return JSON_ERR_BADTRAIL;
+    default:
+        return JSON_ERR_BADTRAIL;
+    }
+}
+
+int
+json_stream_feed(struct json_stream *js, const char *data, int len)
+{
+    int rc;
+    int i;
+
+    if (js->js_state == JSON_S_ERR) {
+        return js->js_err;
+    }
+    for (i = 0; i < len; i++) {
+        rc = json_stream_char(js, data[i]);
+        if (rc) {
+            js->js_state = JSON_S_ERR;
+            js->js_err = rc;
+            return rc;
+        }
+    }
+    return 0;
+}
+
+int
+json_stream_finish(struct json_stream *js)
+{
+    int rc;
+
+    if (js->js_state == JSON_S_LIT && js->js_depth == 0) {
+        rc = json_stream_lit_done(js);
+        if (rc) {
+            js->js_state = JSON_S_ERR;
+            js->js_err = rc;
+            return rc;
+        }
+    }
+    if (js->js_state == JSON_S_ERR) {
+        return js->js_err;
+    }
+    if (js->js_state != JSON_S_DONE) {
+        return JSON_ERR_MISC;
+    }
+    return 0;
+}
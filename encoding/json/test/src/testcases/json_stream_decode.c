@@ -0,0 +1,108 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "test_json.h"
+
+static char *test_stream_input =
+    "{\"KeyInt\": -1234, \"KeyStr\": \"a\\\"b\\n\", "
+    "\"KeyArr\": [true, 15, {\"k\": null}]}";
+
+static int test_stream_cnt;
+
+static int
+test_stream_cb(struct json_stream *js, int type, const char *key, char *val,
+               int len, void *arg)
+{
+    switch (test_stream_cnt++) {
+    case 0:
+        TEST_ASSERT(type == JSON_STREAM_OBJ_START && key == NULL);
+        break;
+    case 1:
+        TEST_ASSERT(type == JSON_STREAM_NUMBER && !strcmp(key, "KeyInt"));
+        TEST_ASSERT(!strcmp(val, "-1234"));
+        break;
+    case 2:
+        TEST_ASSERT(type == JSON_STREAM_STRING && !strcmp(key, "KeyStr"));
+        TEST_ASSERT(len == 4 && !strcmp(val, "a\"b\n"));
+        break;
+    case 3:
+        TEST_ASSERT(type == JSON_STREAM_ARR_START && !strcmp(key, "KeyArr"));
+        break;
+    case 4:
+        TEST_ASSERT(type == JSON_STREAM_BOOL && key == NULL);
+        TEST_ASSERT(!strcmp(val, "true"));
+        break;
+    case 5:
+        TEST_ASSERT(type == JSON_STREAM_NUMBER && !strcmp(val, "15"));
+        break;
+    case 6:
+        TEST_ASSERT(type == JSON_STREAM_OBJ_START && key == NULL);
+        break;
+    case 7:
+        TEST_ASSERT(type == JSON_STREAM_NULL && !strcmp(key, "k"));
+        break;
+    case 8:
+        TEST_ASSERT(type == JSON_STREAM_OBJ_END);
+        break;
+    case 9:
+        TEST_ASSERT(type == JSON_STREAM_ARR_END);
+        break;
+    case 10:
+        TEST_ASSERT(type == JSON_STREAM_OBJ_END);
+        break;
+    default:
+        TEST_ASSERT(0);
+        break;
+    }
+    return 0;
+}
+
+/*
+ * Input is fed in chunks of every size up to its length.
+ */
+TEST_CASE(test_json_stream_decode)
+{
+    struct json_stream js;
+    char buf[16];
+    int chunk;
+    int len;
+    int off;
+    int rc;
+
+    len = strlen(test_stream_input);
+    for (chunk = 1; chunk <= len; chunk++) {
+        test_stream_cnt = 0;
+        json_stream_init(&js, buf, sizeof(buf), test_stream_cb, NULL);
+        for (off = 0; off < len; off += chunk) {
+            rc = json_stream_feed(&js, test_stream_input + off,
+                                  len - off < chunk ? len - off : chunk);
+            TEST_ASSERT(rc == 0);
+        }
+        rc = json_stream_finish(&js);
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(test_stream_cnt == 11);
+    }
+
+    /* Unterminated input. */
+    json_stream_init(&js, buf, sizeof(buf), test_stream_cb, NULL);
+    test_stream_cnt = 0;
+    rc = json_stream_feed(&js, "{\"KeyInt\": -1", 13);
+    TEST_ASSERT(rc == 0);
+    rc = json_stream_finish(&js);
+    TEST_ASSERT(rc != 0);
+}
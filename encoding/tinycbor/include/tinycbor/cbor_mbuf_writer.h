@@ -30,6 +30,7 @@ extern "C" {
 struct cbor_mbuf_writer {
     struct cbor_encoder_writer enc;
     struct os_mbuf *m;
+    struct os_mbuf *last;             /* last mbuf in chain */
 };
 
 void cbor_mbuf_writer_init(struct cbor_mbuf_writer *cb, struct os_mbuf *m);
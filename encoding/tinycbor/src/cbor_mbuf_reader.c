@@ -17,47 +17,95 @@
  * under the License.
  */
 
+#include <limits.h>
+#include <string.h>
 #include <tinycbor/cbor_mbuf_reader.h>
 #include <tinycbor/compilersupport_p.h>
 #include <os/os_mbuf.h>
 
+/*
+ * Returns the mbuf containing chain offset off, and sets *moff to offset
+ * within it.  Parser mostly reads forward, so search starts from the mbuf
+ * of the previous read.
+ */
+static struct os_mbuf *
+cbor_mbuf_reader_seek(struct cbor_mbuf_reader *cb, int off, int *moff)
+{
+    struct os_mbuf *m;
+
+    if (off < cb->cur_off) {
+        cb->cur = cb->m;
+        cb->cur_off = 0;
+    }
+    m = cb->cur;
+    off -= cb->cur_off;
+    while (m && off >= m->om_len) {
+        off -= m->om_len;
+        cb->cur_off += m->om_len;
+        m = SLIST_NEXT(m, om_next);
+        if (m) {
+            cb->cur = m;
+        }
+    }
+    *moff = off;
+    return m;
+}
+
+static int
+cbor_mbuf_reader_read(struct cbor_mbuf_reader *cb, int offset, void *dst,
+                      int len)
+{
+    struct os_mbuf *m;
+    int moff;
+
+    m = cbor_mbuf_reader_seek(cb, offset + cb->init_off, &moff);
+    if (!m) {
+        return -1;
+    }
+    if (moff + len <= m->om_len) {
+        memcpy(dst, m->om_data + moff, len);
+        return 0;
+    }
+    return os_mbuf_copydata(m, moff, len, dst);
+}
+
 static uint8_t
 cbor_mbuf_reader_get8(struct cbor_decoder_reader *d, int offset)
 {
-    uint8_t val;
+    uint8_t val = 0;
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
 
-    os_mbuf_copydata(cb->m, offset + cb->init_off, sizeof(val), &val);
+    cbor_mbuf_reader_read(cb, offset, &val, sizeof(val));
     return val;
 }
 
 static uint16_t
 cbor_mbuf_reader_get16(struct cbor_decoder_reader *d, int offset)
 {
-    uint16_t val;
+    uint16_t val = 0;
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
 
-    os_mbuf_copydata(cb->m, offset + cb->init_off, sizeof(val), &val);
+    cbor_mbuf_reader_read(cb, offset, &val, sizeof(val));
     return cbor_ntohs(val);
 }
 
 static uint32_t
 cbor_mbuf_reader_get32(struct cbor_decoder_reader *d, int offset)
 {
-    uint32_t val;
+    uint32_t val = 0;
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
 
-    os_mbuf_copydata(cb->m, offset + cb->init_off, sizeof(val), &val);
+    cbor_mbuf_reader_read(cb, offset, &val, sizeof(val));
     return cbor_ntohl(val);
 }
 
 static uint64_t
 cbor_mbuf_reader_get64(struct cbor_decoder_reader *d, int offset)
 {
-    uint64_t val;
+    uint64_t val = 0;
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
 
-    os_mbuf_copydata(cb->m, offset + cb->init_off, sizeof(val), &val);
+    cbor_mbuf_reader_read(cb, offset, &val, sizeof(val));
     return cbor_ntohll(val);
 }
 
@@ -66,7 +114,17 @@ cbor_mbuf_reader_cmp(struct cbor_decoder_reader *d, char *buf, int offset,
                      size_t len)
 {
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
-    return os_mbuf_cmpf(cb->m, offset + cb->init_off, buf, len);
+    struct os_mbuf *m;
+    int moff;
+
+    if (len == 0) {
+        return 0;
+    }
+    m = cbor_mbuf_reader_seek(cb, offset + cb->init_off, &moff);
+    if (!m) {
+        return INT_MAX;
+    }
+    return os_mbuf_cmpf(m, moff, buf, len);
 }
 
 static uintptr_t
@@ -76,7 +134,7 @@ cbor_mbuf_reader_cpy(struct cbor_decoder_reader *d, char *dst, int offset,
     int rc;
     struct cbor_mbuf_reader *cb = (struct cbor_mbuf_reader *) d;
 
-    rc = os_mbuf_copydata(cb->m, offset + cb->init_off, len, dst);
+    rc = cbor_mbuf_reader_read(cb, offset, dst, len);
     if (rc == 0) {
         return true;
     }
@@ -99,6 +157,8 @@ cbor_mbuf_reader_init(struct cbor_mbuf_reader *cb, struct os_mbuf *m,
     assert(OS_MBUF_IS_PKTHDR(m));
     hdr = OS_MBUF_PKTHDR(m);
     cb->m = m;
+    cb->cur = m;
+    cb->cur_off = 0;
     cb->init_off = initial_offset;
     cb->r.message_size = hdr->omp_len - initial_offset;
 }
@@ -17,9 +17,9 @@
  * under the License.
  */
 
+#include <string.h>
 #include <tinycbor/cbor.h>
 #include <os/os_mbuf.h>
-#include <tinycbor/cbor.h>
 #include <tinycbor/cbor_mbuf_writer.h>
 
 int
@@ -27,11 +27,34 @@ cbor_mbuf_writer(struct cbor_encoder_writer *arg, const char *data, int len)
 {
     int rc;
     struct cbor_mbuf_writer *cb = (struct cbor_mbuf_writer *) arg;
+    struct os_mbuf *last;
+
+    last = cb->last;
+    while (SLIST_NEXT(last, om_next)) {
+        last = SLIST_NEXT(last, om_next);
+    }
 
-    rc = os_mbuf_append(cb->m, data, len);
-    if (rc) {
-        return CborErrorOutOfMemory;
+    /*
+     * Most items are small, and fit in the space left in the last mbuf;
+     * copy those directly instead of having os_mbuf_append() walk the
+     * chain.
+     */
+    if (len <= OS_MBUF_TRAILINGSPACE(last)) {
+        memcpy(last->om_data + last->om_len, data, len);
+        last->om_len += len;
+        if (OS_MBUF_IS_PKTHDR(cb->m)) {
+            OS_MBUF_PKTHDR(cb->m)->omp_len += len;
+        }
+    } else {
+        rc = os_mbuf_append(cb->m, data, len);
+        if (rc) {
+            return CborErrorOutOfMemory;
+        }
+        while (SLIST_NEXT(last, om_next)) {
+            last = SLIST_NEXT(last, om_next);
+        }
     }
+    cb->last = last;
     cb->enc.bytes_written += len;
     return CborNoError;
 }
@@ -41,6 +64,7 @@ void
 cbor_mbuf_writer_init(struct cbor_mbuf_writer *cb, struct os_mbuf *m)
 {
     cb->m = m;
+    cb->last = m;
     cb->enc.bytes_written = 0;
     cb->enc.write = &cbor_mbuf_writer;
 }
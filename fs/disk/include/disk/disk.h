@@ -34,6 +34,7 @@ extern "C" {
 #define DISK_ENOENT       3  /* No such file or directory */
 #define DISK_EOS          4  /* OS error */
 #define DISK_EUNINIT      5  /* File system not initialized */
+#define DISK_EINVAL       6  /* Invalid argument */
 
 struct disk_ops {
     int (*read)(uint8_t, uint32_t, void *, uint32_t);
@@ -43,7 +44,45 @@ struct disk_ops {
     SLIST_ENTRY(disk_ops) sc_next;
 };
 
+#define DISK_REQ_READ     0
+#define DISK_REQ_WRITE    1
+
+struct disk_req;
+
+/**
+ * Called when a request submitted with disk_submit() completes.
+ *
+ * @param The request
+ * @param The disk driver's return code, negative on failure
+ */
+typedef void disk_req_func_t(struct disk_req *, int);
+
+/**
+ * A read or write of a registered disk.  Requests to adjacent addresses
+ * with adjacent buffers that are queued together are merged into a single
+ * call to the disk driver.
+ */
+struct disk_req {
+    /* DISK_REQ_READ or DISK_REQ_WRITE */
+    uint8_t dr_op;
+    /* Disk address, in bytes */
+    uint32_t dr_addr;
+    uint32_t dr_len;
+    void *dr_buf;
+    disk_req_func_t *dr_func;
+    void *dr_arg;
+
+    STAILQ_ENTRY(disk_req) dr_next;
+};
+
+struct os_eventq;
+
 int disk_register(const char *disk_name, const char *fs_name, struct disk_ops *dops);
+int disk_submit(const char *disk_name, struct disk_req *req);
+int disk_io_read(const char *disk_name, uint32_t addr, void *buf, uint32_t len);
+int disk_io_write(const char *disk_name, uint32_t addr, const void *buf,
+                  uint32_t len);
+int disk_evq_set(const char *disk_name, struct os_eventq *evq);
 struct disk_ops *disk_ops_for(const char *disk_name);
 char *disk_fs_for(const char *disk_name);
 char *disk_name_from_path(const char *path);
@@ -18,20 +18,156 @@
  */
 
 #include <syscfg/syscfg.h>
+#include <os/os.h>
 #include <disk/disk.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#if MYNEWT_VAL(DISK_STATS)
+#include <stats/stats.h>
+#endif
 
+#if MYNEWT_VAL(DISK_STATS)
+STATS_SECT_START(disk_stats)
+    STATS_SECT_ENTRY(reads)
+    STATS_SECT_ENTRY(writes)
+    STATS_SECT_ENTRY(read_bytes)
+    STATS_SECT_ENTRY(write_bytes)
+    STATS_SECT_ENTRY(merged)
+    STATS_SECT_ENTRY(ra_hits)
+    STATS_SECT_ENTRY(errors)
+STATS_SECT_END
+
+STATS_NAME_START(disk_stats)
+    STATS_NAME(disk_stats, reads)
+    STATS_NAME(disk_stats, writes)
+    STATS_NAME(disk_stats, read_bytes)
+    STATS_NAME(disk_stats, write_bytes)
+    STATS_NAME(disk_stats, merged)
+    STATS_NAME(disk_stats, ra_hits)
+    STATS_NAME(disk_stats, errors)
+STATS_NAME_END(disk_stats)
+
+/* Driver operations per second */
+STATS_SECT_START(disk_iops)
+    STATS_SECT_RATE(reads)
+    STATS_SECT_RATE(writes)
+STATS_SECT_END
+
+STATS_NAME_START(disk_iops)
+    STATS_NAME(disk_iops, reads)
+    STATS_NAME(disk_iops, writes)
+STATS_NAME_END(disk_iops)
+
+/* Driver operation latency, in microseconds */
+STATS_SECT_START(disk_latency)
+    STATS_SECT_GAUGE(read_usecs)
+    STATS_SECT_GAUGE(write_usecs)
+STATS_SECT_END
+
+STATS_NAME_START(disk_latency)
+    STATS_NAME(disk_latency, read_usecs)
+    STATS_NAME(disk_latency, write_usecs)
+STATS_NAME_END(disk_latency)
+#endif
+
+/*
+ * Requests submitted to a disk are queued and run from the disk's event
+ * queue, the default event queue unless set with disk_evq_set().
+ */
 struct disk_info {
     const char *disk_name;
     const char *fs_name;
     struct disk_ops *dops;
+    /* Passed to the disk driver; disks are numbered in registration order */
+    uint8_t disk_id;
+
+    struct os_eventq *evq;
+    struct os_event ev;
+    STAILQ_HEAD(, disk_req) queue;
+
+    /* End of the last read, to spot sequential reads */
+    uint32_t last_end;
+#if MYNEWT_VAL(DISK_READAHEAD_SIZE)
+    uint32_t ra_addr;
+    uint32_t ra_len;
+    uint8_t *ra_buf;
+#endif
+
+#if MYNEWT_VAL(DISK_STATS)
+    STATS_SECT_DECL(disk_stats) stats;
+    STATS_SECT_DECL(disk_iops) iops;
+    STATS_SECT_DECL(disk_latency) latency;
+#endif
 
     SLIST_ENTRY(disk_info) sc_next;
 };
 
 static SLIST_HEAD(, disk_info) disks = SLIST_HEAD_INITIALIZER();
 
+static void disk_event(struct os_event *ev);
+
+static struct disk_info *
+disk_info_for(const char *disk_name)
+{
+    struct disk_info *sc;
+
+    if (disk_name) {
+        SLIST_FOREACH(sc, &disks, sc_next) {
+            if (strcmp(sc->disk_name, disk_name) == 0) {
+                return sc;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+#if MYNEWT_VAL(DISK_STATS)
+static int
+disk_stats_init(struct disk_info *info)
+{
+    char *name;
+    size_t len;
+    int rc;
+
+    /* Stats names are kept by the stats registry, so are never freed */
+    len = strlen(info->disk_name) + sizeof("disk__latency");
+    name = malloc(3 * len);
+    if (!name) {
+        return DISK_ENOMEM;
+    }
+
+    sprintf(name, "disk_%s", info->disk_name);
+    rc = stats_init_and_reg(STATS_HDR(info->stats),
+            STATS_SIZE_INIT_PARMS(info->stats, STATS_SIZE_32),
+            STATS_NAME_INIT_PARMS(disk_stats), name);
+    if (rc) {
+        return DISK_EOS;
+    }
+
+    name += len;
+    sprintf(name, "disk_%s_iops", info->disk_name);
+    rc = stats_init_and_reg(STATS_HDR(info->iops),
+            STATS_SIZE_INIT_PARMS(info->iops, STATS_SIZE_RATE),
+            STATS_NAME_INIT_PARMS(disk_iops), name);
+    if (rc) {
+        return DISK_EOS;
+    }
+
+    name += len;
+    sprintf(name, "disk_%s_latency", info->disk_name);
+    rc = stats_init_and_reg(STATS_HDR(info->latency),
+            STATS_SIZE_INIT_PARMS(info->latency, STATS_SIZE_GAUGE),
+            STATS_NAME_INIT_PARMS(disk_latency), name);
+    if (rc) {
+        return DISK_EOS;
+    }
+
+    return 0;
+}
+#endif
+
 /**
  *
  */
@@ -39,14 +175,18 @@ int disk_register(const char *disk_name, const char *fs_name, struct disk_ops *d
 {
     struct disk_info *info = NULL;
     struct disk_info *sc;
+    int disk_id;
+    int rc;
 
+    disk_id = 0;
     SLIST_FOREACH(sc, &disks, sc_next) {
         if (strcmp(sc->disk_name, disk_name) == 0) {
             return DISK_ENOENT;
         }
+        disk_id++;
     }
 
-    info = malloc(sizeof(struct disk_info));
+    info = calloc(1, sizeof(struct disk_info));
     if (!info) {
         return DISK_ENOMEM;
     }
@@ -54,23 +194,350 @@ int disk_register(const char *disk_name, const char *fs_name, struct disk_ops *d
     info->disk_name = disk_name;
     info->fs_name = fs_name;
     info->dops = dops;
+    info->disk_id = disk_id;
+    info->evq = os_eventq_dflt_get();
+    info->ev.ev_cb = disk_event;
+    info->ev.ev_arg = info;
+    STAILQ_INIT(&info->queue);
+
+#if MYNEWT_VAL(DISK_READAHEAD_SIZE)
+    info->ra_buf = malloc(MYNEWT_VAL(DISK_READAHEAD_SIZE));
+    if (!info->ra_buf) {
+        free(info);
+        return DISK_ENOMEM;
+    }
+#endif
+
+#if MYNEWT_VAL(DISK_STATS)
+    rc = disk_stats_init(info);
+    if (rc) {
+        return rc;
+    }
+#else
+    (void)rc;
+#endif
 
     SLIST_INSERT_HEAD(&disks, info, sc_next);
 
     return 0;
 }
 
+static int
+disk_run_read(struct disk_info *info, uint32_t addr, void *buf, uint32_t len)
+{
+    int rc;
+
+#if MYNEWT_VAL(DISK_READAHEAD_SIZE)
+    if (info->ra_len && addr >= info->ra_addr &&
+        addr + len <= info->ra_addr + info->ra_len) {
+        memcpy(buf, info->ra_buf + (addr - info->ra_addr), len);
+        info->last_end = addr + len;
+#if MYNEWT_VAL(DISK_STATS)
+        STATS_INC(info->stats, ra_hits);
+#endif
+        return 0;
+    }
+
+    /*
+     * Reading on from where the last read ended; fetch a whole read-ahead
+     * buffer.  This fails near the end of the disk, where the request is
+     * read as is.
+     */
+    if (addr == info->last_end && len < MYNEWT_VAL(DISK_READAHEAD_SIZE)) {
+        rc = info->dops->read(info->disk_id, addr, info->ra_buf,
+                              MYNEWT_VAL(DISK_READAHEAD_SIZE));
+        if (rc >= 0) {
+            info->ra_addr = addr;
+            info->ra_len = MYNEWT_VAL(DISK_READAHEAD_SIZE);
+            memcpy(buf, info->ra_buf, len);
+            info->last_end = addr + len;
+            return rc;
+        }
+        info->ra_len = 0;
+    }
+#endif
+
+    rc = info->dops->read(info->disk_id, addr, buf, len);
+    info->last_end = addr + len;
+
+    return rc;
+}
+
+static int
+disk_run_write(struct disk_info *info, uint32_t addr, const void *buf,
+               uint32_t len)
+{
+#if MYNEWT_VAL(DISK_READAHEAD_SIZE)
+    if (info->ra_len && addr < info->ra_addr + info->ra_len &&
+        addr + len > info->ra_addr) {
+        info->ra_len = 0;
+    }
+#endif
+
+    return info->dops->write(info->disk_id, addr, buf, len);
+}
+
+/**
+ * Run an operation on a disk, from the calling task.
+ */
+static int
+disk_run(struct disk_info *info, uint8_t op, uint32_t addr, void *buf,
+         uint32_t len)
+{
+#if MYNEWT_VAL(DISK_STATS)
+    uint32_t start;
+    uint32_t usecs;
+#endif
+    int rc;
+
+#if MYNEWT_VAL(DISK_STATS)
+    start = os_cputime_get32();
+#endif
+
+    if (op == DISK_REQ_READ) {
+        rc = disk_run_read(info, addr, buf, len);
+    } else {
+        rc = disk_run_write(info, addr, buf, len);
+    }
+
+#if MYNEWT_VAL(DISK_STATS)
+    usecs = os_cputime_ticks_to_usecs(os_cputime_get32() - start);
+    if (rc < 0) {
+        STATS_INC(info->stats, errors);
+    } else if (op == DISK_REQ_READ) {
+        STATS_INC(info->stats, reads);
+        STATS_INCN(info->stats, read_bytes, len);
+        STATS_RATE_INC(info->iops, reads);
+        STATS_GAUGE_ADD(info->latency, read_usecs, usecs);
+    } else {
+        STATS_INC(info->stats, writes);
+        STATS_INCN(info->stats, write_bytes, len);
+        STATS_RATE_INC(info->iops, writes);
+        STATS_GAUGE_ADD(info->latency, write_usecs, usecs);
+    }
+#endif
+
+    return rc;
+}
+
+/**
+ * Disk event, runs the request at the head of the disk queue together with
+ * any queued behind it that continue it on the disk and in memory.  If more
+ * are queued the event is posted again, so other events on the queue are
+ * not held up behind a busy disk.
+ */
+static void
+disk_event(struct os_event *ev)
+{
+    STAILQ_HEAD(, disk_req) batch;
+    struct disk_info *info;
+    struct disk_req *req;
+    struct disk_req *next;
+    uint32_t len;
+    os_sr_t sr;
+    int rc;
+
+    info = ev->ev_arg;
+    STAILQ_INIT(&batch);
+
+    OS_ENTER_CRITICAL(sr);
+    req = STAILQ_FIRST(&info->queue);
+    if (!req) {
+        OS_EXIT_CRITICAL(sr);
+        return;
+    }
+    STAILQ_REMOVE_HEAD(&info->queue, dr_next);
+    STAILQ_INSERT_TAIL(&batch, req, dr_next);
+
+    len = req->dr_len;
+    while ((next = STAILQ_FIRST(&info->queue)) != NULL &&
+           next->dr_op == req->dr_op &&
+           next->dr_addr == req->dr_addr + len &&
+           (uint8_t *)next->dr_buf == (uint8_t *)req->dr_buf + len) {
+        STAILQ_REMOVE_HEAD(&info->queue, dr_next);
+        STAILQ_INSERT_TAIL(&batch, next, dr_next);
+        len += next->dr_len;
+#if MYNEWT_VAL(DISK_STATS)
+        STATS_INC(info->stats, merged);
+#endif
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    rc = disk_run(info, req->dr_op, req->dr_addr, req->dr_buf, len);
+
+    OS_ENTER_CRITICAL(sr);
+    if (!STAILQ_EMPTY(&info->queue)) {
+        os_eventq_put(info->evq, &info->ev);
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    /* A callback may resubmit its request */
+    while ((req = STAILQ_FIRST(&batch)) != NULL) {
+        STAILQ_REMOVE_HEAD(&batch, dr_next);
+        if (req->dr_func) {
+            req->dr_func(req, rc);
+        }
+    }
+}
+
+/**
+ * Queue a read or write of a disk.  The request runs from the disk's event
+ * queue, and its callback is called from there once it completes.
+ *
+ * @param disk_name The disk
+ * @param req The request to queue
+ *
+ * @return 0 on success, DISK_ENOENT if there is no such disk, DISK_EINVAL
+ *         on an invalid request.
+ */
+int
+disk_submit(const char *disk_name, struct disk_req *req)
+{
+    struct disk_info *info;
+    os_sr_t sr;
+
+    info = disk_info_for(disk_name);
+    if (!info) {
+        return DISK_ENOENT;
+    }
+    if (req->dr_op > DISK_REQ_WRITE || !req->dr_len) {
+        return DISK_EINVAL;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    STAILQ_INSERT_TAIL(&info->queue, req, dr_next);
+    os_eventq_put(info->evq, &info->ev);
+    OS_EXIT_CRITICAL(sr);
+
+    return 0;
+}
+
+/* A task blocked in disk_io_read() or disk_io_write() */
+struct disk_waiter {
+    struct os_sem dw_sem;
+    int dw_rc;
+};
+
+static void
+disk_req_done(struct disk_req *req, int rc)
+{
+    struct disk_waiter *waiter;
+
+    waiter = req->dr_arg;
+    waiter->dw_rc = rc;
+    os_sem_release(&waiter->dw_sem);
+}
+
+/**
+ * Run a request, blocking until it completes.  It is queued behind any
+ * others on the disk; when called from the disk's event queue itself, or
+ * before the OS has started, it is run directly.
+ */
+static int
+disk_io(const char *disk_name, uint8_t op, uint32_t addr, void *buf,
+        uint32_t len)
+{
+    struct disk_waiter waiter;
+    struct disk_info *info;
+    struct disk_req req;
+    struct os_task *owner;
+    int rc;
+
+    info = disk_info_for(disk_name);
+    if (!info) {
+        return DISK_ENOENT;
+    }
+
+    owner = info->evq->evq_owner;
+    if (!os_started() || !owner || owner == os_sched_get_current_task()) {
+        return disk_run(info, op, addr, buf, len);
+    }
+
+    os_sem_init(&waiter.dw_sem, 0);
+    req.dr_op = op;
+    req.dr_addr = addr;
+    req.dr_len = len;
+    req.dr_buf = buf;
+    req.dr_func = disk_req_done;
+    req.dr_arg = &waiter;
+
+    rc = disk_submit(disk_name, &req);
+    if (rc) {
+        return rc;
+    }
+
+    os_sem_pend(&waiter.dw_sem, OS_TIMEOUT_NEVER);
+
+    return waiter.dw_rc;
+}
+
+/**
+ * Read from a disk, blocking until done.
+ *
+ * @return The disk driver's return code, negative on failure;
+ *         DISK_ENOENT if there is no such disk.
+ */
+int
+disk_io_read(const char *disk_name, uint32_t addr, void *buf, uint32_t len)
+{
+    return disk_io(disk_name, DISK_REQ_READ, addr, buf, len);
+}
+
+/**
+ * Write to a disk, blocking until done.
+ *
+ * @return The disk driver's return code, negative on failure;
+ *         DISK_ENOENT if there is no such disk.
+ */
+int
+disk_io_write(const char *disk_name, uint32_t addr, const void *buf,
+              uint32_t len)
+{
+    return disk_io(disk_name, DISK_REQ_WRITE, addr, (void *)buf, len);
+}
+
+/**
+ * Run requests to a disk from "evq".  Must not be called while requests are
+ * queued on the disk.
+ *
+ * @return 0 on success, DISK_ENOENT if there is no such disk, DISK_EINVAL
+ *         if "evq" is NULL or requests are queued.
+ */
+int
+disk_evq_set(const char *disk_name, struct os_eventq *evq)
+{
+    struct disk_info *info;
+    os_sr_t sr;
+    int rc;
+
+    info = disk_info_for(disk_name);
+    if (!info) {
+        return DISK_ENOENT;
+    }
+    if (!evq) {
+        return DISK_EINVAL;
+    }
+
+    rc = 0;
+    OS_ENTER_CRITICAL(sr);
+    if (STAILQ_EMPTY(&info->queue)) {
+        info->evq = evq;
+    } else {
+        rc = DISK_EINVAL;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return rc;
+}
+
 struct disk_ops *
 disk_ops_for(const char *disk_name)
 {
     struct disk_info *sc;
 
-    if (disk_name) {
-        SLIST_FOREACH(sc, &disks, sc_next) {
-            if (strcmp(sc->disk_name, disk_name) == 0) {
-                return sc->dops;
-            }
-        }
+    sc = disk_info_for(disk_name);
+    if (sc) {
+        return sc->dops;
     }
 
     return NULL;
@@ -81,12 +548,9 @@ disk_fs_for(const char *disk_name)
 {
     struct disk_info *sc;
 
-    if (disk_name) {
-        SLIST_FOREACH(sc, &disks, sc_next) {
-            if (strcmp(sc->disk_name, disk_name) == 0) {
-                return ((char *) sc->fs_name);
-            }
-        }
+    sc = disk_info_for(disk_name);
+    if (sc) {
+        return ((char *) sc->fs_name);
     }
 
     return NULL;
@@ -17,6 +17,7 @@
  * under the License.
  */
 #include <assert.h>
+#include "syscfg/syscfg.h"
 #include <sysinit/sysinit.h>
 #include <hal/hal_flash.h>
 #include <disk/disk.h>
@@ -36,6 +37,8 @@ static int fatfs_open(const char *path, uint8_t access_flags,
 static int fatfs_close(struct fs_file *fs_file);
 static int fatfs_read(struct fs_file *fs_file, uint32_t len, void *out_data,
   uint32_t *out_len);
+static int fatfs_read_mbuf(struct fs_file *fs_file, uint32_t len,
+  struct os_mbuf *om, uint32_t *out_len);
 static int fatfs_write(struct fs_file *fs_file, const void *data, int len);
 static int fatfs_seek(struct fs_file *fs_file, uint32_t offset);
 static uint32_t fatfs_getpos(const struct fs_file *fs_file);
@@ -77,6 +80,7 @@ static struct fs_ops fatfs_ops = {
     .f_open = fatfs_open,
     .f_close = fatfs_close,
     .f_read = fatfs_read,
+    .f_read_mbuf = fatfs_read_mbuf,
     .f_write = fatfs_write,
 
     .f_seek = fatfs_seek,
@@ -170,6 +174,7 @@ struct mounted_disk {
     char *disk_name;
     int disk_number;
     struct disk_ops *dops;
+    FATFS *fs;
 
     SLIST_ENTRY(mounted_disk) sc_next;
 };
@@ -205,6 +210,7 @@ drivenumber_from_disk(char *disk_name)
     new_disk->disk_name = strdup(disk_name);
     new_disk->disk_number = disk_number;
     new_disk->dops = disk_ops_for(disk_name);
+    new_disk->fs = fs;
     SLIST_INSERT_HEAD(&mounted_disks, new_disk, sc_next);
 
     return disk_number;
@@ -333,6 +339,17 @@ fatfs_read(struct fs_file *fs_file, uint32_t len, void *out_data,
     return fatfs_to_vfs_error(res);
 }
 
+/*
+ * f_read() copies whole sectors straight into the caller's buffer, so the
+ * mbuf data areas are filled without going through the sector window.
+ */
+static int
+fatfs_read_mbuf(struct fs_file *fs_file, uint32_t len, struct os_mbuf *om,
+                uint32_t *out_len)
+{
+    return fs_read_mbuf_seg(fs_file, len, om, out_len, fatfs_read);
+}
+
 static int
 fatfs_write(struct fs_file *fs_file, const void *data, int len)
 {
@@ -494,41 +511,253 @@ disk_status(BYTE pdrv)
     return RES_OK;
 }
 
-static struct disk_ops *dops_from_handle(BYTE pdrv)
+static struct mounted_disk *
+disk_from_handle(BYTE pdrv)
 {
     struct mounted_disk *sc;
 
     SLIST_FOREACH(sc, &mounted_disks, sc_next) {
-        if (sc->disk_number == pdrv) {
-            return sc->dops;
+        if (sc->disk_number == pdrv && sc->dops != NULL) {
+            return sc;
+        }
+    }
+
+    return NULL;
+}
+
+static int
+disk_read_sectors(struct mounted_disk *sc, BYTE *buff, DWORD sector,
+                  UINT count)
+{
+    /* NOTE: safe to assume sector size as 512 for now, see ffconf.h */
+    return disk_io_read(sc->disk_name, (uint32_t) sector * 512,
+                        (void *) buff, (uint32_t) count * 512);
+}
+
+static int
+disk_write_sectors(struct mounted_disk *sc, const BYTE *buff, DWORD sector,
+                   UINT count)
+{
+    return disk_io_write(sc->disk_name, (uint32_t) sector * 512,
+                         (const void *) buff, (uint32_t) count * 512);
+}
+
+#if MYNEWT_VAL(FATFS_CACHE_SECTORS)
+
+/**
+ * Sector cache.  FatFs reads and writes FAT and directory sectors one at a
+ * time through its window buffer, re-reading them whenever the window moves;
+ * single sector accesses are served from here.  Multi-sector transfers
+ * (whole sectors of file data) go straight to the disk.
+ *
+ * Sectors before the data area (FATs, and the root directory on FAT12/16)
+ * are kept in preference to others: a data area sector never evicts them.
+ */
+#define CACHE_VALID     0x01
+#define CACHE_DIRTY     0x02
+#define CACHE_META      0x04
+
+struct fatfs_cache_entry {
+    BYTE pdrv;
+    BYTE flags;
+    DWORD sector;
+    uint32_t last_use;
+    BYTE data[512];
+};
+
+static struct fatfs_cache_entry fatfs_cache[MYNEWT_VAL(FATFS_CACHE_SECTORS)];
+static uint32_t fatfs_cache_clock;
+
+static int
+cache_sector_is_meta(struct mounted_disk *sc, DWORD sector)
+{
+    /* Everything read while mounting is metadata */
+    if (sc->fs == NULL || sc->fs->fs_type == 0) {
+        return 1;
+    }
+
+    return sector < sc->fs->database;
+}
+
+static struct fatfs_cache_entry *
+cache_find(BYTE pdrv, DWORD sector)
+{
+    struct fatfs_cache_entry *ce;
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(FATFS_CACHE_SECTORS); i++) {
+        ce = &fatfs_cache[i];
+        if ((ce->flags & CACHE_VALID) && ce->pdrv == pdrv &&
+            ce->sector == sector) {
+            return ce;
         }
     }
 
     return NULL;
 }
 
+static void
+cache_touch(struct fatfs_cache_entry *ce)
+{
+    ce->last_use = ++fatfs_cache_clock;
+}
+
+static int
+cache_flush_entry(struct fatfs_cache_entry *ce)
+{
+    struct mounted_disk *sc;
+    int rc;
+
+    if (!(ce->flags & CACHE_DIRTY)) {
+        return 0;
+    }
+
+    sc = disk_from_handle(ce->pdrv);
+    if (sc == NULL) {
+        return -1;
+    }
+
+    rc = disk_write_sectors(sc, ce->data, ce->sector, 1);
+    if (rc < 0) {
+        return rc;
+    }
+
+    ce->flags &= ~CACHE_DIRTY;
+    return 0;
+}
+
+/**
+ * Claim an entry for a sector which is not cached: a free entry, else the
+ * least recently used data sector, else (for metadata only) the least
+ * recently used metadata sector.  A dirty victim is written back first.
+ *
+ * @return The entry, or NULL if the sector should not be cached.
+ */
+static struct fatfs_cache_entry *
+cache_alloc(struct mounted_disk *sc, DWORD sector)
+{
+    struct fatfs_cache_entry *ce;
+    struct fatfs_cache_entry *lru_data;
+    struct fatfs_cache_entry *lru_meta;
+    int meta;
+    int i;
+
+    lru_data = NULL;
+    lru_meta = NULL;
+    for (i = 0; i < MYNEWT_VAL(FATFS_CACHE_SECTORS); i++) {
+        ce = &fatfs_cache[i];
+        if (!(ce->flags & CACHE_VALID)) {
+            lru_data = ce;
+            break;
+        }
+        if (ce->flags & CACHE_META) {
+            if (!lru_meta || (int32_t)(ce->last_use - lru_meta->last_use) < 0) {
+                lru_meta = ce;
+            }
+        } else {
+            if (!lru_data || (int32_t)(ce->last_use - lru_data->last_use) < 0) {
+                lru_data = ce;
+            }
+        }
+    }
+
+    meta = cache_sector_is_meta(sc, sector);
+    ce = lru_data;
+    if (ce == NULL && meta) {
+        ce = lru_meta;
+    }
+    if (ce == NULL) {
+        return NULL;
+    }
+
+    if (cache_flush_entry(ce)) {
+        return NULL;
+    }
+
+    ce->pdrv = sc->disk_number;
+    ce->sector = sector;
+    ce->flags = CACHE_VALID;
+    if (meta) {
+        ce->flags |= CACHE_META;
+    }
+
+    return ce;
+}
+
+static int
+cache_sync(BYTE pdrv)
+{
+    struct fatfs_cache_entry *ce;
+    int rc;
+    int i;
+
+    rc = 0;
+    for (i = 0; i < MYNEWT_VAL(FATFS_CACHE_SECTORS); i++) {
+        ce = &fatfs_cache[i];
+        if ((ce->flags & CACHE_VALID) && ce->pdrv == pdrv) {
+            if (cache_flush_entry(ce)) {
+                rc = -1;
+            }
+        }
+    }
+
+    return rc;
+}
+
+#endif
+
 DRESULT
 disk_read(BYTE pdrv, BYTE* buff, DWORD sector, UINT count)
 {
     int rc;
-    uint32_t address;
-    uint32_t num_bytes;
-    struct disk_ops *dops;
-
-    /* NOTE: safe to assume sector size as 512 for now, see ffconf.h */
-    address = (uint32_t) sector * 512;
-    num_bytes = (uint32_t) count * 512;
+    struct mounted_disk *sc;
+#if MYNEWT_VAL(FATFS_CACHE_SECTORS)
+    struct fatfs_cache_entry *ce;
+    int i;
+#endif
 
-    dops = dops_from_handle(pdrv);
-    if (dops == NULL) {
+    sc = disk_from_handle(pdrv);
+    if (sc == NULL) {
         return STA_NOINIT;
     }
 
-    rc = dops->read(pdrv, address, (void *) buff, num_bytes);
+#if MYNEWT_VAL(FATFS_CACHE_SECTORS)
+    if (count == 1) {
+        ce = cache_find(pdrv, sector);
+        if (ce == NULL) {
+            ce = cache_alloc(sc, sector);
+            if (ce != NULL) {
+                rc = disk_read_sectors(sc, ce->data, sector, 1);
+                if (rc < 0) {
+                    ce->flags = 0;
+                    return STA_NOINIT;
+                }
+            }
+        }
+        if (ce != NULL) {
+            memcpy(buff, ce->data, 512);
+            cache_touch(ce);
+            return RES_OK;
+        }
+    }
+#endif
+
+    rc = disk_read_sectors(sc, buff, sector, count);
     if (rc < 0) {
         return STA_NOINIT;
     }
 
+#if MYNEWT_VAL(FATFS_CACHE_SECTORS)
+    /* Sectors not yet written back are newer than what is on the disk */
+    for (i = 0; i < MYNEWT_VAL(FATFS_CACHE_SECTORS); i++) {
+        ce = &fatfs_cache[i];
+        if ((ce->flags & CACHE_DIRTY) && ce->pdrv == pdrv &&
+            ce->sector - sector < count) {
+            memcpy(buff + (ce->sector - sector) * 512, ce->data, 512);
+        }
+    }
+#endif
+
     return RES_OK;
 }
 
@@ -536,30 +765,62 @@ DRESULT
 disk_write(BYTE pdrv, const BYTE* buff, DWORD sector, UINT count)
 {
     int rc;
-    uint32_t address;
-    uint32_t num_bytes;
-    struct disk_ops *dops;
-
-    /* NOTE: safe to assume sector size as 512 for now, see ffconf.h */
-    address = (uint32_t) sector * 512;
-    num_bytes = (uint32_t) count * 512;
+    struct mounted_disk *sc;
+#if MYNEWT_VAL(FATFS_CACHE_SECTORS)
+    struct fatfs_cache_entry *ce;
+    int i;
+#endif
 
-    dops = dops_from_handle(pdrv);
-    if (dops == NULL) {
+    sc = disk_from_handle(pdrv);
+    if (sc == NULL) {
         return STA_NOINIT;
     }
 
-    rc = dops->write(pdrv, address, (const void *) buff, num_bytes);
+#if MYNEWT_VAL(FATFS_CACHE_SECTORS) && MYNEWT_VAL(FATFS_WRITE_BEHIND)
+    /* Hold single sectors until evicted or synced */
+    if (count == 1) {
+        ce = cache_find(pdrv, sector);
+        if (ce == NULL) {
+            ce = cache_alloc(sc, sector);
+        }
+        if (ce != NULL) {
+            memcpy(ce->data, buff, 512);
+            ce->flags |= CACHE_DIRTY;
+            cache_touch(ce);
+            return RES_OK;
+        }
+    }
+#endif
+
+    rc = disk_write_sectors(sc, buff, sector, count);
     if (rc < 0) {
         return STA_NOINIT;
     }
 
+#if MYNEWT_VAL(FATFS_CACHE_SECTORS)
+    for (i = 0; i < MYNEWT_VAL(FATFS_CACHE_SECTORS); i++) {
+        ce = &fatfs_cache[i];
+        if ((ce->flags & CACHE_VALID) && ce->pdrv == pdrv &&
+            ce->sector - sector < count) {
+            memcpy(ce->data, buff + (ce->sector - sector) * 512, 512);
+            ce->flags &= ~CACHE_DIRTY;
+        }
+    }
+#endif
+
     return RES_OK;
 }
 
 DRESULT
 disk_ioctl(BYTE pdrv, BYTE cmd, void* buff)
 {
+#if MYNEWT_VAL(FATFS_CACHE_SECTORS)
+    /* f_sync() and f_close() end with CTRL_SYNC */
+    if (cmd == CTRL_SYNC && cache_sync(pdrv)) {
+        return RES_ERROR;
+    }
+#endif
+
     return RES_OK;
 }
 
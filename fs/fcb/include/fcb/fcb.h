@@ -29,6 +29,7 @@ extern "C" {
 #include <inttypes.h>
 #include <limits.h>
 
+#include "syscfg/syscfg.h"
 #include "flash_map/flash_map.h"
 
 #include "os/os_mutex.h"
@@ -46,6 +47,20 @@ struct fcb_entry {
     uint16_t fe_data_len;	/* size of data area */
 };
 
+#if MYNEWT_VAL(FCB_INDEX)
+/*
+ * RAM-resident index of the entries in one sector.  fsi_marks[i] is the
+ * offset of valid entry number i * FCB_INDEX_STRIDE within the sector.
+ */
+struct fcb_sector_index {
+    uint16_t fsi_count;		/* Valid entries; FCB_INDEX_INVALID if unknown */
+    uint32_t fsi_last_off;	/* Offset of the last indexed entry */
+    uint32_t fsi_marks[MYNEWT_VAL(FCB_INDEX_MARKS)];
+};
+
+#define FCB_INDEX_INVALID	0xffff
+#endif
+
 struct fcb {
     /* Caller of fcb_init fills this in */
     uint32_t f_magic;		/* As placed on the disk */
@@ -53,6 +68,9 @@ struct fcb {
     uint8_t f_sector_cnt;	/* Number of elements in sector array */
     uint8_t f_scratch_cnt;	/* How many sectors should be kept empty */
     struct flash_area *f_sectors; /* Array of sectors, must be contiguous */
+#if MYNEWT_VAL(FCB_INDEX)
+    struct fcb_sector_index *f_index; /* Optional; one per sector */
+#endif
 
     /* Flash circular buffer internal state */
     struct os_mutex f_mtx;	/* Locking for accessing the FCB data */
@@ -60,6 +78,10 @@ struct fcb {
     struct fcb_entry f_active;
     uint16_t f_active_id;
     uint8_t f_align;		/* writes to flash have to aligned to this */
+#if MYNEWT_VAL(FCB_SUMMARY_SLOTS) > 0
+    uint16_t f_active_cnt;	/* Elements in active sector */
+    uint8_t f_active_sum;	/* Summary slots used in active sector */
+#endif
 };
 
 /*
@@ -95,6 +117,21 @@ int log_fcb_init(struct fcb_log *fcblog, struct fcb *fcb, uint16_t entries);
 int fcb_append(struct fcb *, uint16_t len, struct fcb_entry *loc);
 int fcb_append_finish(struct fcb *, struct fcb_entry *append_loc);
 
+/*
+ * fcb_append_batch() appends cnt complete entries from RAM, taking the lock
+ * once. Entries are laid out in a staging buffer of FCB_BATCH_BUF_SIZE
+ * bytes, and programmed to flash with one write per buffer-full.
+ * *out_cnt is set to the number of entries appended; on error, entries
+ * past those have not been stored.
+ */
+struct fcb_batch_entry {
+    const void *fbe_data;
+    uint16_t fbe_len;
+};
+
+int fcb_append_batch(struct fcb *, const struct fcb_batch_entry *entries,
+  int cnt, int *out_cnt);
+
 /*
  * Walk over all log entries in FCB, or entries in a given flash_area.
  * cb gets called for every entry. If cb wants to stop the walk, it should
@@ -134,6 +171,13 @@ int
 fcb_offset_last_n(struct fcb *fcb, uint8_t entries,
         struct fcb_entry *last_n_entry);
 
+/*
+ * Element at offset *n* from the oldest one (forwards).  With an index
+ * (f_index), whole sectors are skipped and the scan within a sector starts
+ * at most FCB_INDEX_STRIDE entries away.
+ */
+int fcb_get_nth(struct fcb *fcb, uint32_t n, struct fcb_entry *loc);
+
 /*
  * Clears FCB passed to it
  */
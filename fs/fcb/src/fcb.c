@@ -83,6 +83,12 @@ fcb_init(struct fcb *fcb)
     fcb->f_active.fe_elem_off = sizeof(struct fcb_disk_area);
     fcb->f_active_id = newest;
 
+#if MYNEWT_VAL(FCB_SUMMARY_SLOTS) > 0
+    /*
+     * Skip to last recorded write position, and count elements from there.
+     */
+    fcb_summary_restore(fcb);
+#endif
     while (1) {
         rc = fcb_getnext_in_area(fcb, &fcb->f_active);
         if (rc == FCB_ERR_NOVAR) {
@@ -93,6 +99,11 @@ fcb_init(struct fcb *fcb)
             break;
         }
     }
+#if MYNEWT_VAL(FCB_INDEX)
+    if (rc == 0) {
+        rc = fcb_index_build(fcb);
+    }
+#endif
     os_mutex_init(&fcb->f_mtx);
     return rc;
 }
@@ -220,12 +231,32 @@ fcb_offset_last_n(struct fcb *fcb, uint8_t entries,
 {
     struct fcb_entry loc;
     int i;
+#if MYNEWT_VAL(FCB_INDEX)
+    uint32_t total;
+    int rc;
+#endif
 
     /* assure a minimum amount of entries */
     if (!entries) {
         entries = 1;
     }
 
+#if MYNEWT_VAL(FCB_INDEX)
+    rc = os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+    if (rc && rc != OS_NOT_STARTED) {
+        return FCB_ERR_ARGS;
+    }
+    rc = fcb_index_count(fcb, &total);
+    os_mutex_release(&fcb->f_mtx);
+    if (rc == 0) {
+        if (total == 0) {
+            return OS_ENOENT;
+        }
+        return fcb_get_nth(fcb, total > entries ? total - entries : 0,
+          last_n_entry);
+    }
+#endif
+
     i = 0;
     memset(&loc, 0, sizeof(loc));
     while (!fcb_getnext(fcb, &loc)) {
@@ -17,6 +17,9 @@
  * under the License.
  */
 #include <stddef.h>
+#include <string.h>
+
+#include <crc/crc8.h>
 
 #include "fcb/fcb.h"
 #include "fcb_priv.h"
@@ -60,9 +63,46 @@ fcb_append_to_scratch(struct fcb *fcb)
     if (rc) {
         return rc;
     }
+#if MYNEWT_VAL(FCB_INDEX)
+    fcb_index_reset(fcb, fa);
+#endif
+    fcb->f_active.fe_area = fa;
+    fcb->f_active.fe_elem_off = sizeof(struct fcb_disk_area);
+    fcb->f_active_id++;
+#if MYNEWT_VAL(FCB_SUMMARY_SLOTS) > 0
+    fcb_summary_reset(fcb);
+#endif
+    return FCB_OK;
+}
+
+/*
+ * Move to the next sector, as an element of len bytes does not fit in the
+ * active one.
+ */
+static int
+fcb_append_next_area(struct fcb *fcb, int len)
+{
+    struct flash_area *fa;
+    int rc;
+
+    fa = fcb_new_area(fcb, fcb->f_scratch_cnt);
+    if (!fa ||
+      fcb_area_data_end(fcb, fa) < sizeof(struct fcb_disk_area) + len) {
+        return FCB_ERR_NOSPACE;
+    }
+    rc = fcb_sector_hdr_init(fcb, fa, fcb->f_active_id + 1);
+    if (rc) {
+        return rc;
+    }
+#if MYNEWT_VAL(FCB_INDEX)
+    fcb_index_reset(fcb, fa);
+#endif
     fcb->f_active.fe_area = fa;
     fcb->f_active.fe_elem_off = sizeof(struct fcb_disk_area);
     fcb->f_active_id++;
+#if MYNEWT_VAL(FCB_SUMMARY_SLOTS) > 0
+    fcb_summary_reset(fcb);
+#endif
     return FCB_OK;
 }
 
@@ -70,7 +110,6 @@ int
 fcb_append(struct fcb *fcb, uint16_t len, struct fcb_entry *append_loc)
 {
     struct fcb_entry *active;
-    struct flash_area *fa;
     uint8_t tmp_str[2];
     int cnt;
     int rc;
@@ -87,20 +126,12 @@ fcb_append(struct fcb *fcb, uint16_t len, struct fcb_entry *append_loc)
         return FCB_ERR_ARGS;
     }
     active = &fcb->f_active;
-    if (active->fe_elem_off + len + cnt > active->fe_area->fa_size) {
-        fa = fcb_new_area(fcb, fcb->f_scratch_cnt);
-        if (!fa || (fa->fa_size <
-            sizeof(struct fcb_disk_area) + len + cnt)) {
-            rc = FCB_ERR_NOSPACE;
-            goto err;
-        }
-        rc = fcb_sector_hdr_init(fcb, fa, fcb->f_active_id + 1);
+    if (active->fe_elem_off + len + cnt >
+      fcb_area_data_end(fcb, active->fe_area)) {
+        rc = fcb_append_next_area(fcb, len + cnt);
         if (rc) {
             goto err;
         }
-        fcb->f_active.fe_area = fa;
-        fcb->f_active.fe_elem_off = sizeof(struct fcb_disk_area);
-        fcb->f_active_id++;
     }
 
     rc = flash_area_write(active->fe_area, active->fe_elem_off, tmp_str, cnt);
@@ -113,6 +144,9 @@ fcb_append(struct fcb *fcb, uint16_t len, struct fcb_entry *append_loc)
     append_loc->fe_data_off = active->fe_elem_off + cnt;
 
     active->fe_elem_off = append_loc->fe_data_off + len;
+#if MYNEWT_VAL(FCB_SUMMARY_SLOTS) > 0
+    fcb_summary_note(fcb, 1);
+#endif
 
     os_mutex_release(&fcb->f_mtx);
 
@@ -139,5 +173,204 @@ fcb_append_finish(struct fcb *fcb, struct fcb_entry *loc)
     if (rc) {
         return FCB_ERR_FLASH;
     }
+#if MYNEWT_VAL(FCB_INDEX)
+    rc = os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+    if (rc && rc != OS_NOT_STARTED) {
+        return FCB_ERR_ARGS;
+    }
+    fcb_index_note(fcb, loc);
+    os_mutex_release(&fcb->f_mtx);
+#endif
     return 0;
 }
+
+/*
+ * Staging buffer for fcb_append_batch().  Holds the flash image of
+ * consecutive elements, starting at offset fb_off within the active sector.
+ */
+struct fcb_batch_buf {
+    uint32_t fb_off;
+    uint16_t fb_len;
+    uint8_t fb_data[MYNEWT_VAL(FCB_BATCH_BUF_SIZE)];
+};
+
+static int
+fcb_batch_flush(struct fcb *fcb, struct fcb_batch_buf *fb)
+{
+    int rc;
+
+    if (fb->fb_len) {
+        rc = flash_area_write(fcb->f_active.fe_area, fb->fb_off, fb->fb_data,
+          fb->fb_len);
+        if (rc) {
+            return FCB_ERR_FLASH;
+        }
+        fb->fb_off += fb->fb_len;
+        fb->fb_len = 0;
+    }
+    return 0;
+}
+
+/*
+ * Copy len bytes to staging buffer, followed by padding to flash_len bytes.
+ */
+static int
+fcb_batch_stage(struct fcb *fcb, struct fcb_batch_buf *fb, const void *data,
+  int len, int flash_len)
+{
+    const uint8_t *src;
+    int blk_sz;
+    int rc;
+
+    src = data;
+    while (flash_len > 0) {
+        if (fb->fb_len == sizeof(fb->fb_data)) {
+            rc = fcb_batch_flush(fcb, fb);
+            if (rc) {
+                return rc;
+            }
+        }
+        blk_sz = sizeof(fb->fb_data) - fb->fb_len;
+        if (blk_sz > flash_len) {
+            blk_sz = flash_len;
+        }
+        if (len > 0) {
+            if (blk_sz > len) {
+                blk_sz = len;
+            }
+            memcpy(&fb->fb_data[fb->fb_len], src, blk_sz);
+            src += blk_sz;
+            len -= blk_sz;
+        } else {
+            memset(&fb->fb_data[fb->fb_len], 0xff, blk_sz);
+        }
+        fb->fb_len += blk_sz;
+        flash_len -= blk_sz;
+    }
+    return 0;
+}
+
+int
+fcb_append_batch(struct fcb *fcb, const struct fcb_batch_entry *entries,
+  int cnt, int *out_cnt)
+{
+    struct fcb_batch_buf fb;
+    struct fcb_entry *active;
+    struct fcb_entry loc;
+    uint32_t done_off;
+    uint8_t tmp_str[2];
+    uint8_t crc8;
+    int hdr_len;
+    int elem_len;
+    int done;
+    int rc;
+    int i;
+
+    *out_cnt = 0;
+    for (i = 0; i < cnt; i++) {
+        if (entries[i].fbe_len >= FCB_MAX_LEN) {
+            return FCB_ERR_ARGS;
+        }
+    }
+
+    rc = os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+    if (rc && rc != OS_NOT_STARTED) {
+        return FCB_ERR_ARGS;
+    }
+    active = &fcb->f_active;
+    fb.fb_off = active->fe_elem_off;
+    fb.fb_len = 0;
+
+    /*
+     * Entries before index done, ending at done_off, are known to be
+     * in flash.
+     */
+    done = 0;
+    done_off = active->fe_elem_off;
+    for (i = 0; i < cnt; i++) {
+        hdr_len = fcb_put_len(tmp_str, entries[i].fbe_len);
+        elem_len = fcb_len_in_flash(fcb, hdr_len) +
+          fcb_len_in_flash(fcb, entries[i].fbe_len) +
+          fcb_len_in_flash(fcb, FCB_CRC_SZ);
+
+        if (active->fe_elem_off + elem_len >
+          fcb_area_data_end(fcb, active->fe_area)) {
+            rc = fcb_batch_flush(fcb, &fb);
+            if (rc) {
+                break;
+            }
+#if MYNEWT_VAL(FCB_SUMMARY_SLOTS) > 0
+            fcb_summary_note(fcb, i - done);
+#endif
+            done = i;
+            rc = fcb_append_next_area(fcb, elem_len);
+            if (rc) {
+                done_off = active->fe_elem_off;
+                break;
+            }
+            fb.fb_off = active->fe_elem_off;
+            done_off = active->fe_elem_off;
+        } else if (fb.fb_len + elem_len > sizeof(fb.fb_data)) {
+            rc = fcb_batch_flush(fcb, &fb);
+            if (rc) {
+                break;
+            }
+#if MYNEWT_VAL(FCB_SUMMARY_SLOTS) > 0
+            fcb_summary_note(fcb, i - done);
+#endif
+            done = i;
+            done_off = active->fe_elem_off;
+        }
+
+        crc8 = crc8_init();
+        crc8 = crc8_calc(crc8, tmp_str, hdr_len);
+        crc8 = crc8_calc(crc8, (void *)entries[i].fbe_data,
+          entries[i].fbe_len);
+
+        rc = fcb_batch_stage(fcb, &fb, tmp_str, hdr_len,
+          fcb_len_in_flash(fcb, hdr_len));
+        if (rc == 0) {
+            rc = fcb_batch_stage(fcb, &fb, entries[i].fbe_data,
+              entries[i].fbe_len, fcb_len_in_flash(fcb, entries[i].fbe_len));
+        }
+        if (rc == 0) {
+            rc = fcb_batch_stage(fcb, &fb, &crc8, sizeof(crc8),
+              fcb_len_in_flash(fcb, FCB_CRC_SZ));
+        }
+        if (rc) {
+            break;
+        }
+#if MYNEWT_VAL(FCB_INDEX)
+        loc.fe_area = active->fe_area;
+        loc.fe_elem_off = active->fe_elem_off;
+        fcb_index_note(fcb, &loc);
+#else
+        (void)loc;
+#endif
+        active->fe_elem_off += elem_len;
+    }
+    if (i == cnt) {
+        rc = fcb_batch_flush(fcb, &fb);
+        if (rc == 0) {
+#if MYNEWT_VAL(FCB_SUMMARY_SLOTS) > 0
+            fcb_summary_note(fcb, cnt - done);
+#endif
+            done = cnt;
+            done_off = active->fe_elem_off;
+        }
+    }
+    if (done < i) {
+        /*
+         * Elements which did not make it to flash will be overwritten by
+         * the next append.
+         */
+        active->fe_elem_off = done_off;
+#if MYNEWT_VAL(FCB_INDEX)
+        fcb_index_invalidate(fcb, active->fe_area);
+#endif
+    }
+    *out_cnt = done;
+
+    os_mutex_release(&fcb->f_mtx);
+    return rc;
+}
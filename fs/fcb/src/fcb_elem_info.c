@@ -38,7 +38,7 @@ fcb_elem_crc8(struct fcb *fcb, struct fcb_entry *loc, uint8_t *c8p)
     uint32_t end;
     int rc;
 
-    if (loc->fe_elem_off + 2 > loc->fe_area->fa_size) {
+    if (loc->fe_elem_off + 2 > fcb_area_data_end(fcb, loc->fe_area)) {
         return FCB_ERR_NOVAR;
     }
     rc = flash_area_read(loc->fe_area, loc->fe_elem_off, tmp_str, 2);
@@ -116,6 +116,50 @@ next_sector:
     return 0;
 }
 
+/*
+ * Skip n entries, starting from the first one in sector fap.
+ */
+int
+fcb_get_nth_from(struct fcb *fcb, struct flash_area *fap, uint32_t n,
+  struct fcb_entry *loc)
+{
+    int rc;
+
+    loc->fe_area = fap;
+    loc->fe_elem_off = 0;
+    rc = fcb_getnext_nolock(fcb, loc);
+    while (rc == 0 && n > 0) {
+        rc = fcb_getnext_nolock(fcb, loc);
+        n--;
+    }
+    return rc;
+}
+
+int
+fcb_get_nth(struct fcb *fcb, uint32_t n, struct fcb_entry *loc)
+{
+    int rc;
+
+    rc = os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+    if (rc && rc != OS_NOT_STARTED) {
+        return FCB_ERR_ARGS;
+    }
+    if (fcb_is_empty(fcb)) {
+        rc = FCB_ERR_NOVAR;
+    }
+#if MYNEWT_VAL(FCB_INDEX)
+    else if (fcb->f_index) {
+        rc = fcb_index_get_nth(fcb, n, loc);
+    }
+#endif
+    else {
+        rc = fcb_get_nth_from(fcb, fcb->f_oldest, n, loc);
+    }
+    os_mutex_release(&fcb->f_mtx);
+
+    return rc;
+}
+
 int
 fcb_getnext(struct fcb *fcb, struct fcb_entry *loc)
 {
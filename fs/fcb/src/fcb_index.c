@@ -0,0 +1,210 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "fcb/fcb.h"
+#include "fcb_priv.h"
+
+#if MYNEWT_VAL(FCB_INDEX)
+
+static struct fcb_sector_index *
+fcb_index_of(struct fcb *fcb, struct flash_area *fap)
+{
+    return &fcb->f_index[fap - fcb->f_sectors];
+}
+
+/*
+ * Forget the entries of a sector which has just been erased or taken into
+ * use.
+ */
+void
+fcb_index_reset(struct fcb *fcb, struct flash_area *fap)
+{
+    if (fcb->f_index) {
+        memset(fcb_index_of(fcb, fap), 0, sizeof(struct fcb_sector_index));
+    }
+}
+
+/*
+ * Stop using the index for a sector; lookups will scan it instead.
+ */
+void
+fcb_index_invalidate(struct fcb *fcb, struct flash_area *fap)
+{
+    if (fcb->f_index) {
+        fcb_index_of(fcb, fap)->fsi_count = FCB_INDEX_INVALID;
+    }
+}
+
+/*
+ * Account for a valid entry.  Entries must be noted in the order they are
+ * in flash; if they are not (appends finished out of order), the sector's
+ * index is given up on, and lookups scan it instead.
+ */
+void
+fcb_index_note(struct fcb *fcb, struct fcb_entry *loc)
+{
+    struct fcb_sector_index *fsi;
+    uint16_t mark;
+
+    if (!fcb->f_index) {
+        return;
+    }
+    fsi = fcb_index_of(fcb, loc->fe_area);
+    if (fsi->fsi_count == FCB_INDEX_INVALID) {
+        return;
+    }
+    if (fsi->fsi_count > 0 && loc->fe_elem_off <= fsi->fsi_last_off) {
+        fsi->fsi_count = FCB_INDEX_INVALID;
+        return;
+    }
+    if (fsi->fsi_count % MYNEWT_VAL(FCB_INDEX_STRIDE) == 0) {
+        mark = fsi->fsi_count / MYNEWT_VAL(FCB_INDEX_STRIDE);
+        if (mark < MYNEWT_VAL(FCB_INDEX_MARKS)) {
+            fsi->fsi_marks[mark] = loc->fe_elem_off;
+        }
+    }
+    fsi->fsi_last_off = loc->fe_elem_off;
+    fsi->fsi_count++;
+}
+
+/*
+ * Read all entries from flash to populate the index.  Called from fcb_init().
+ */
+int
+fcb_index_build(struct fcb *fcb)
+{
+    struct flash_area *fap;
+    struct fcb_entry loc;
+    int rc;
+    int i;
+
+    if (!fcb->f_index) {
+        return 0;
+    }
+    for (i = 0; i < fcb->f_sector_cnt; i++) {
+        fcb_index_reset(fcb, &fcb->f_sectors[i]);
+    }
+    if (fcb_is_empty(fcb)) {
+        return 0;
+    }
+
+    fap = fcb->f_oldest;
+    while (1) {
+        loc.fe_area = fap;
+        loc.fe_elem_off = 0;
+        while ((rc = fcb_getnext_nolock(fcb, &loc)) == 0) {
+            if (loc.fe_area != fap) {
+                break;
+            }
+            fcb_index_note(fcb, &loc);
+        }
+        if (rc && rc != FCB_ERR_NOVAR) {
+            return rc;
+        }
+        if (fap == fcb->f_active.fe_area) {
+            break;
+        }
+        fap = fcb_getnext_area(fcb, fap);
+    }
+    return 0;
+}
+
+/*
+ * Total number of valid entries.  Returns FCB_ERR_NOVAR if some sector is
+ * not indexed.
+ */
+int
+fcb_index_count(struct fcb *fcb, uint32_t *countp)
+{
+    struct fcb_sector_index *fsi;
+    struct flash_area *fap;
+    uint32_t count;
+
+    if (!fcb->f_index) {
+        return FCB_ERR_NOVAR;
+    }
+    count = 0;
+    fap = fcb->f_oldest;
+    while (1) {
+        fsi = fcb_index_of(fcb, fap);
+        if (fsi->fsi_count == FCB_INDEX_INVALID) {
+            return FCB_ERR_NOVAR;
+        }
+        count += fsi->fsi_count;
+        if (fap == fcb->f_active.fe_area) {
+            break;
+        }
+        fap = fcb_getnext_area(fcb, fap);
+    }
+    *countp = count;
+    return 0;
+}
+
+/*
+ * Locate the entry at offset n from the oldest one using the index.
+ */
+int
+fcb_index_get_nth(struct fcb *fcb, uint32_t n, struct fcb_entry *loc)
+{
+    struct fcb_sector_index *fsi;
+    struct flash_area *fap;
+    uint32_t mark;
+    int rc;
+
+    fap = fcb->f_oldest;
+    while (1) {
+        fsi = fcb_index_of(fcb, fap);
+        if (fsi->fsi_count == FCB_INDEX_INVALID) {
+            /*
+             * Count entries from the start of this sector.
+             */
+            return fcb_get_nth_from(fcb, fap, n, loc);
+        }
+        if (n < fsi->fsi_count) {
+            mark = n / MYNEWT_VAL(FCB_INDEX_STRIDE);
+            if (mark >= MYNEWT_VAL(FCB_INDEX_MARKS)) {
+                mark = MYNEWT_VAL(FCB_INDEX_MARKS) - 1;
+            }
+            loc->fe_area = fap;
+            loc->fe_elem_off = fsi->fsi_marks[mark];
+            rc = fcb_elem_info(fcb, loc);
+            if (rc) {
+                return rc;
+            }
+            n -= mark * MYNEWT_VAL(FCB_INDEX_STRIDE);
+            while (n > 0) {
+                rc = fcb_getnext_nolock(fcb, loc);
+                if (rc) {
+                    return rc;
+                }
+                n--;
+            }
+            return 0;
+        }
+        n -= fsi->fsi_count;
+        if (fap == fcb->f_active.fe_area) {
+            return FCB_ERR_NOVAR;
+        }
+        fap = fcb_getnext_area(fcb, fap);
+    }
+}
+
+#endif
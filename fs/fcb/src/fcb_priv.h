@@ -35,6 +35,17 @@ struct fcb_disk_area {
     uint16_t fd_id;
 };
 
+/*
+ * Slots at the end of a sector, filled in one after another as entries are
+ * appended.  Tell fcb_init() how far into the sector the entries reach.
+ */
+struct fcb_disk_summary {
+    uint32_t fds_off;		/* Offset of next element */
+    uint16_t fds_cnt;		/* Elements before that */
+    uint8_t  fds_crc8;		/* Over the above */
+    uint8_t  _pad;
+};
+
 int fcb_put_len(uint8_t *buf, uint16_t len);
 int fcb_get_len(uint8_t *buf, uint16_t *len);
 
@@ -47,6 +58,20 @@ fcb_len_in_flash(struct fcb *fcb, uint16_t len)
     return (len + (fcb->f_align - 1)) & ~(fcb->f_align - 1);
 }
 
+/*
+ * Offset within sector past which elements can't be stored.
+ */
+static inline uint32_t
+fcb_area_data_end(struct fcb *fcb, struct flash_area *fap)
+{
+#if MYNEWT_VAL(FCB_SUMMARY_SLOTS) > 0
+    return fap->fa_size - MYNEWT_VAL(FCB_SUMMARY_SLOTS) *
+      fcb_len_in_flash(fcb, sizeof(struct fcb_disk_summary));
+#else
+    return fap->fa_size;
+#endif
+}
+
 int fcb_getnext_in_area(struct fcb *fcb, struct fcb_entry *loc);
 struct flash_area *fcb_getnext_area(struct fcb *fcb, struct flash_area *fap);
 int fcb_getnext_nolock(struct fcb *fcb, struct fcb_entry *loc);
@@ -54,10 +79,28 @@ int fcb_getnext_nolock(struct fcb *fcb, struct fcb_entry *loc);
 int fcb_elem_info(struct fcb *, struct fcb_entry *);
 int fcb_elem_crc8(struct fcb *, struct fcb_entry *loc, uint8_t *crc8p);
 
+int fcb_get_nth_from(struct fcb *fcb, struct flash_area *fap, uint32_t n,
+  struct fcb_entry *loc);
+
 int fcb_sector_hdr_init(struct fcb *, struct flash_area *fap, uint16_t id);
 int fcb_sector_hdr_read(struct fcb *, struct flash_area *fap,
   struct fcb_disk_area *fdap);
 
+#if MYNEWT_VAL(FCB_SUMMARY_SLOTS) > 0
+void fcb_summary_reset(struct fcb *fcb);
+void fcb_summary_note(struct fcb *fcb, int cnt);
+void fcb_summary_restore(struct fcb *fcb);
+#endif
+
+#if MYNEWT_VAL(FCB_INDEX)
+void fcb_index_reset(struct fcb *fcb, struct flash_area *fap);
+void fcb_index_note(struct fcb *fcb, struct fcb_entry *loc);
+void fcb_index_invalidate(struct fcb *fcb, struct flash_area *fap);
+int fcb_index_build(struct fcb *fcb);
+int fcb_index_count(struct fcb *fcb, uint32_t *countp);
+int fcb_index_get_nth(struct fcb *fcb, uint32_t n, struct fcb_entry *loc);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
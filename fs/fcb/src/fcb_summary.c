@@ -0,0 +1,140 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stddef.h>
+
+#include <crc/crc8.h>
+
+#include "fcb/fcb.h"
+#include "fcb_priv.h"
+
+#if MYNEWT_VAL(FCB_SUMMARY_SLOTS) > 0
+
+static uint32_t
+fcb_summary_off(struct fcb *fcb, struct flash_area *fap, int slot)
+{
+    return fap->fa_size - (slot + 1) *
+      fcb_len_in_flash(fcb, sizeof(struct fcb_disk_summary));
+}
+
+static uint8_t
+fcb_summary_crc8(struct fcb_disk_summary *fds)
+{
+    return crc8_calc(crc8_init(), fds,
+      offsetof(struct fcb_disk_summary, fds_crc8));
+}
+
+/*
+ * New active sector.
+ */
+void
+fcb_summary_reset(struct fcb *fcb)
+{
+    fcb->f_active_cnt = 0;
+    fcb->f_active_sum = 0;
+}
+
+/*
+ * cnt more elements have been stored in the active sector, up to
+ * f_active.fe_elem_off.  Every FCB_SUMMARY_INTERVAL elements, record this
+ * in the next free slot.
+ */
+void
+fcb_summary_note(struct fcb *fcb, int cnt)
+{
+    struct fcb_disk_summary fds;
+    uint16_t prev;
+
+    prev = fcb->f_active_cnt;
+    fcb->f_active_cnt += cnt;
+    if (fcb->f_active_sum >= MYNEWT_VAL(FCB_SUMMARY_SLOTS) ||
+      prev / MYNEWT_VAL(FCB_SUMMARY_INTERVAL) ==
+      fcb->f_active_cnt / MYNEWT_VAL(FCB_SUMMARY_INTERVAL)) {
+        return;
+    }
+    fds.fds_off = fcb->f_active.fe_elem_off;
+    fds.fds_cnt = fcb->f_active_cnt;
+    fds.fds_crc8 = fcb_summary_crc8(&fds);
+    fds._pad = 0xff;
+
+    /*
+     * Failure here is not fatal; the slot is skipped by fcb_init(), and the
+     * entries after the previous one get scanned.
+     */
+    (void)flash_area_write(fcb->f_active.fe_area,
+      fcb_summary_off(fcb, fcb->f_active.fe_area, fcb->f_active_sum),
+      &fds, sizeof(fds));
+    fcb->f_active_sum++;
+}
+
+/*
+ * Called by fcb_init() to find end of data in the active sector, starting
+ * from the last valid summary slot.
+ */
+void
+fcb_summary_restore(struct fcb *fcb)
+{
+    struct fcb_disk_summary fds;
+    struct flash_area *fap;
+    struct fcb_entry loc;
+    uint32_t last;
+    int rc;
+    int i;
+
+    fap = fcb->f_active.fe_area;
+    fcb_summary_reset(fcb);
+    last = fcb->f_active.fe_elem_off;
+    for (i = 0; i < MYNEWT_VAL(FCB_SUMMARY_SLOTS); i++) {
+        rc = flash_area_read(fap, fcb_summary_off(fcb, fap, i), &fds,
+          sizeof(fds));
+        if (rc) {
+            break;
+        }
+        if (fds.fds_off == 0xffffffff && fds.fds_cnt == 0xffff &&
+          fds.fds_crc8 == 0xff) {
+            /*
+             * Erased; this is where next one will go.
+             */
+            break;
+        }
+        if (fds.fds_crc8 != fcb_summary_crc8(&fds) ||
+          fds.fds_off < last || fds.fds_off > fcb_area_data_end(fcb, fap)) {
+            continue;
+        }
+        last = fds.fds_off;
+        fcb->f_active_cnt = fds.fds_cnt;
+    }
+    fcb->f_active_sum = i;
+
+    loc.fe_area = fap;
+    loc.fe_elem_off = last;
+    while (1) {
+        rc = fcb_elem_info(fcb, &loc);
+        if (rc != 0 && rc != FCB_ERR_CRC) {
+            break;
+        }
+        loc.fe_elem_off = loc.fe_data_off +
+          fcb_len_in_flash(fcb, loc.fe_data_len) +
+          fcb_len_in_flash(fcb, FCB_CRC_SZ);
+        fcb->f_active_cnt++;
+    }
+    fcb->f_active.fe_elem_off = loc.fe_elem_off;
+}
+
+#endif
@@ -153,12 +153,16 @@ TEST_CASE_DECL(fcb_test_len)
 TEST_CASE_DECL(fcb_test_init)
 TEST_CASE_DECL(fcb_test_empty_walk)
 TEST_CASE_DECL(fcb_test_append)
+TEST_CASE_DECL(fcb_test_append_batch)
 TEST_CASE_DECL(fcb_test_append_too_big)
 TEST_CASE_DECL(fcb_test_append_fill)
 TEST_CASE_DECL(fcb_test_reset)
 TEST_CASE_DECL(fcb_test_rotate)
 TEST_CASE_DECL(fcb_test_multiple_scratch)
 TEST_CASE_DECL(fcb_test_last_of_n)
+TEST_CASE_DECL(fcb_test_index)
+TEST_CASE_DECL(fcb_test_summary)
+TEST_CASE_DECL(fcb_test_bench)
 
 TEST_SUITE(fcb_test_all)
 {
@@ -174,6 +178,9 @@ TEST_SUITE(fcb_test_all)
     tu_case_set_pre_cb(fcb_tc_pretest, (void*)2);
     fcb_test_append();
 
+    tu_case_set_pre_cb(fcb_tc_pretest, (void*)2);
+    fcb_test_append_batch();
+
     tu_case_set_pre_cb(fcb_tc_pretest, (void*)2);
     fcb_test_append_too_big();
 
@@ -191,6 +198,15 @@ TEST_SUITE(fcb_test_all)
 
     tu_case_set_pre_cb(fcb_tc_pretest, (void*)4);
     fcb_test_last_of_n();
+
+    tu_case_set_pre_cb(fcb_tc_pretest, (void*)4);
+    fcb_test_index();
+
+    tu_case_set_pre_cb(fcb_tc_pretest, (void*)2);
+    fcb_test_summary();
+
+    tu_case_set_pre_cb(fcb_tc_pretest, (void*)4);
+    fcb_test_bench();
 }
 
 #if MYNEWT_VAL(SELFTEST)
@@ -0,0 +1,67 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb_test.h"
+
+TEST_CASE(fcb_test_append_batch)
+{
+    int rc;
+    struct fcb *fcb;
+    struct fcb_batch_entry entries[16];
+    static uint8_t test_data[128][128];
+    int i;
+    int j;
+    int cnt;
+    int var_cnt;
+
+    fcb = &test_fcb;
+
+    for (i = 0; i < 128; i++) {
+        for (j = 0; j < i; j++) {
+            test_data[i][j] = fcb_test_append_data(i, j);
+        }
+    }
+
+    /*
+     * Entries of length 0..127, in batches of varying size.
+     */
+    for (i = 0; i < 128; i += cnt) {
+        cnt = (i % 16) + 1;
+        if (i + cnt > 128) {
+            cnt = 128 - i;
+        }
+        for (j = 0; j < cnt; j++) {
+            entries[j].fbe_data = test_data[i + j];
+            entries[j].fbe_len = i + j;
+        }
+        rc = fcb_append_batch(fcb, entries, cnt, &var_cnt);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT(var_cnt == cnt);
+    }
+
+    var_cnt = 0;
+    rc = fcb_walk(fcb, 0, fcb_test_data_walk_cb, &var_cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(var_cnt == 128);
+
+    entries[0].fbe_data = test_data[0];
+    entries[0].fbe_len = FCB_MAX_LEN;
+    rc = fcb_append_batch(fcb, entries, 1, &var_cnt);
+    TEST_ASSERT(rc == FCB_ERR_ARGS);
+    TEST_ASSERT(var_cnt == 0);
+}
@@ -55,7 +55,7 @@ TEST_CASE(fcb_test_append_too_big)
     rc = fcb_append(fcb, len, &elem_loc);
     TEST_ASSERT(rc != 0);
 
-    len = fcb->f_active.fe_area->fa_size -
+    len = fcb_area_data_end(fcb, fcb->f_active.fe_area) -
       (sizeof(struct fcb_disk_area) + 1 + 2);
     rc = fcb_append(fcb, len, &elem_loc);
     TEST_ASSERT(rc == 0);
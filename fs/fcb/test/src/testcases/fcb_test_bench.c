@@ -0,0 +1,64 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb_test.h"
+
+static int
+fcb_test_bench_walk_cb(struct fcb_entry *loc, void *arg)
+{
+    (*(int *)arg)++;
+    return 0;
+}
+
+/* Not a functional test; reports the cost of appending and walking. */
+TEST_CASE(fcb_test_bench)
+{
+    struct fcb *fcb;
+    struct fcb_entry loc;
+    uint8_t test_data[32];
+    int cnt;
+    int rc;
+    int i;
+
+    fcb = &test_fcb;
+
+    for (i = 0; i < sizeof(test_data); i++) {
+        test_data[i] = fcb_test_append_data(sizeof(test_data), i);
+    }
+
+    TEST_BENCH_BEGIN("append_32", 1000) {
+        rc = fcb_append(fcb, sizeof(test_data), &loc);
+        if (rc == FCB_ERR_NOSPACE) {
+            rc = fcb_rotate(fcb);
+            TEST_ASSERT_FATAL(rc == 0);
+            rc = fcb_append(fcb, sizeof(test_data), &loc);
+        }
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = flash_area_write(loc.fe_area, loc.fe_data_off, test_data,
+                              sizeof(test_data));
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = fcb_append_finish(fcb, &loc);
+        TEST_ASSERT_FATAL(rc == 0);
+    } TEST_BENCH_END();
+
+    TEST_BENCH_BEGIN("walk", 20) {
+        cnt = 0;
+        rc = fcb_walk(fcb, NULL, fcb_test_bench_walk_cb, &cnt);
+        TEST_ASSERT_FATAL(rc == 0 && cnt > 0);
+    } TEST_BENCH_END();
+}
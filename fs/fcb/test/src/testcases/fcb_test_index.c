@@ -0,0 +1,121 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb_test.h"
+
+#define FCB_TEST_INDEX_CNT      600
+
+static struct fcb_sector_index fcb_test_index_arr[4];
+static struct fcb_entry fcb_test_index_locs[FCB_TEST_INDEX_CNT];
+
+static void
+fcb_test_index_check(struct fcb *fcb, int first, int cnt)
+{
+    struct fcb_entry loc;
+    int rc;
+    int i;
+
+    for (i = 0; i < cnt; i++) {
+        rc = fcb_get_nth(fcb, i, &loc);
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(loc.fe_area == fcb_test_index_locs[first + i].fe_area);
+        TEST_ASSERT(loc.fe_elem_off ==
+          fcb_test_index_locs[first + i].fe_elem_off);
+    }
+    rc = fcb_get_nth(fcb, cnt, &loc);
+    TEST_ASSERT(rc == FCB_ERR_NOVAR);
+
+    rc = fcb_offset_last_n(fcb, 1, &loc);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(loc.fe_elem_off ==
+      fcb_test_index_locs[first + cnt - 1].fe_elem_off);
+
+    rc = fcb_offset_last_n(fcb, cnt + 10, &loc);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(loc.fe_elem_off == fcb_test_index_locs[first].fe_elem_off);
+}
+
+TEST_CASE(fcb_test_index)
+{
+    struct fcb *fcb;
+    struct fcb_entry loc;
+    uint8_t test_data[64];
+    int first;
+    int cnt;
+    int rc;
+
+    fcb = &test_fcb;
+    fcb->f_scratch_cnt = 1;
+    fcb->f_index = fcb_test_index_arr;
+    rc = fcb_init(fcb);
+    TEST_ASSERT(rc == 0);
+
+    rc = fcb_get_nth(fcb, 0, &loc);
+    TEST_ASSERT(rc == FCB_ERR_NOVAR);
+
+    memset(test_data, 0x5a, sizeof(test_data));
+    for (cnt = 0; cnt < FCB_TEST_INDEX_CNT; cnt++) {
+        rc = fcb_append(fcb, sizeof(test_data), &loc);
+        if (rc == FCB_ERR_NOSPACE) {
+            break;
+        }
+        TEST_ASSERT(rc == 0);
+        rc = flash_area_write(loc.fe_area, loc.fe_data_off, test_data,
+          sizeof(test_data));
+        TEST_ASSERT(rc == 0);
+        rc = fcb_append_finish(fcb, &loc);
+        TEST_ASSERT(rc == 0);
+        fcb_test_index_locs[cnt] = loc;
+    }
+    /*
+     * Entries should span more than one sector.
+     */
+    TEST_ASSERT(fcb_test_index_locs[cnt - 1].fe_area != &test_fcb_area[0]);
+    fcb_test_index_check(fcb, 0, cnt);
+
+    /*
+     * Same after rebuilding the index from flash.
+     */
+    rc = fcb_init(fcb);
+    TEST_ASSERT(rc == 0);
+    fcb_test_index_check(fcb, 0, cnt);
+
+    /*
+     * Drop the oldest sector.
+     */
+    rc = fcb_rotate(fcb);
+    TEST_ASSERT(rc == 0);
+    for (first = 0; first < cnt; first++) {
+        if (fcb_test_index_locs[first].fe_area != &test_fcb_area[0]) {
+            break;
+        }
+    }
+    fcb_test_index_check(fcb, first, cnt - first);
+
+    rc = fcb_init(fcb);
+    TEST_ASSERT(rc == 0);
+    fcb_test_index_check(fcb, first, cnt - first);
+
+    /*
+     * Without an index, lookup scans and returns the same results.
+     */
+    fcb->f_index = NULL;
+    rc = fcb_init(fcb);
+    TEST_ASSERT(rc == 0);
+    fcb_test_index_check(fcb, first, cnt - first);
+}
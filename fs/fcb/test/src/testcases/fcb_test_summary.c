@@ -0,0 +1,83 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb_test.h"
+
+TEST_CASE(fcb_test_summary)
+{
+    struct fcb *fcb;
+    struct fcb_entry loc;
+    uint8_t test_data[16];
+    uint32_t end_off;
+    int var_cnt;
+    int rc;
+    int i;
+
+    fcb = &test_fcb;
+
+    for (i = 0; i < sizeof(test_data); i++) {
+        test_data[i] = fcb_test_append_data(sizeof(test_data), i);
+    }
+    for (i = 0; i < 3 * MYNEWT_VAL(FCB_SUMMARY_INTERVAL) + 5; i++) {
+        rc = fcb_append(fcb, sizeof(test_data), &loc);
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = flash_area_write(loc.fe_area, loc.fe_data_off, test_data,
+          sizeof(test_data));
+        TEST_ASSERT(rc == 0);
+        rc = fcb_append_finish(fcb, &loc);
+        TEST_ASSERT(rc == 0);
+    }
+    end_off = fcb->f_active.fe_elem_off;
+#if MYNEWT_VAL(FCB_SUMMARY_SLOTS) > 0
+    TEST_ASSERT(fcb->f_active_sum == 3);
+#endif
+
+    /*
+     * Entry which was started but not finished.
+     */
+    rc = fcb_append(fcb, sizeof(test_data), &loc);
+    TEST_ASSERT(rc == 0);
+    end_off = fcb->f_active.fe_elem_off;
+
+    /*
+     * Pretend reset; write position must be found again.
+     */
+    rc = fcb_init(fcb);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb->f_active.fe_elem_off == end_off);
+#if MYNEWT_VAL(FCB_SUMMARY_SLOTS) > 0
+    TEST_ASSERT(fcb->f_active_sum == 3);
+    TEST_ASSERT(fcb->f_active_cnt == 3 * MYNEWT_VAL(FCB_SUMMARY_INTERVAL) + 6);
+#endif
+
+    rc = fcb_append(fcb, sizeof(test_data), &loc);
+    TEST_ASSERT(rc == 0);
+    rc = flash_area_write(loc.fe_area, loc.fe_data_off, test_data,
+      sizeof(test_data));
+    TEST_ASSERT(rc == 0);
+    rc = fcb_append_finish(fcb, &loc);
+    TEST_ASSERT(rc == 0);
+
+    memset(&loc, 0, sizeof(loc));
+    var_cnt = 0;
+    while (fcb_getnext(fcb, &loc) == 0) {
+        TEST_ASSERT(loc.fe_data_len == sizeof(test_data));
+        var_cnt++;
+    }
+    TEST_ASSERT(var_cnt == 3 * MYNEWT_VAL(FCB_SUMMARY_INTERVAL) + 6);
+}
@@ -33,10 +33,13 @@ extern "C" {
 struct fs_file;
 struct fs_dir;
 struct fs_dirent;
+struct os_mbuf;
 
 int fs_open(const char *filename, uint8_t access_flags, struct fs_file **);
 int fs_close(struct fs_file *);
 int fs_read(struct fs_file *, uint32_t len, void *out_data, uint32_t *out_len);
+int fs_read_mbuf(struct fs_file *, uint32_t len, struct os_mbuf *om,
+  uint32_t *out_len);
 int fs_write(struct fs_file *, const void *data, int len);
 int fs_seek(struct fs_file *, uint32_t offset);
 uint32_t fs_getpos(const struct fs_file *);
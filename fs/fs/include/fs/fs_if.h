@@ -26,6 +26,8 @@ extern "C" {
 
 #include <os/queue.h>
 
+struct os_mbuf;
+
 /*
  * Common interface filesystem(s) provide.
  */
@@ -36,6 +38,9 @@ struct fs_ops {
     int (*f_read)(struct fs_file *file, uint32_t len, void *out_data,
       uint32_t *out_len);
     int (*f_write)(struct fs_file *file, const void *data, int len);
+    /* Optional; fs_read_mbuf() falls back to f_read if NULL. */
+    int (*f_read_mbuf)(struct fs_file *file, uint32_t len, struct os_mbuf *om,
+      uint32_t *out_len);
 
     int (*f_seek)(struct fs_file *file, uint32_t offset);
     uint32_t (*f_getpos)(const struct fs_file *file);
@@ -90,6 +95,26 @@ struct fs_ops *fs_ops_for(const char *name);
 
 struct fs_ops *fs_ops_from_container(struct fops_container *container);
 
+typedef int (*fs_read_func_t)(struct fs_file *file, uint32_t len,
+  void *out_data, uint32_t *out_len);
+
+/**
+ * Reads file data straight into the data areas of an mbuf chain, for use by
+ * f_read_mbuf implementations.  The trailing space of the last mbuf is
+ * filled first; further mbufs are allocated from the chain's pool.
+ *
+ * @param file File to read from; read starts at its current position.
+ * @param len Maximum number of bytes to read.
+ * @param om Chain to append the data to.
+ * @param out_len On success, the number of bytes appended.
+ * @param read_fn Reads into a contiguous buffer; called once per mbuf.
+ *
+ * @return 0 on success, FS_ENOMEM if an mbuf could not be allocated, other
+ *         FS_Exxx on read failure.
+ */
+int fs_read_mbuf_seg(struct fs_file *file, uint32_t len, struct os_mbuf *om,
+  uint32_t *out_len, fs_read_func_t read_fn);
+
 #ifdef __cplusplus
 }
 #endif
@@ -20,6 +20,7 @@
 #include <fs/fs_if.h>
 
 #include <disk/disk.h>
+#include <os/os_mbuf.h>
 #include <string.h>
 #include <stdlib.h>
 
@@ -198,6 +199,70 @@ fs_read(struct fs_file *file, uint32_t len, void *out_data, uint32_t *out_len)
     return fops->f_read(file, len, out_data, out_len);
 }
 
+int
+fs_read_mbuf_seg(struct fs_file *file, uint32_t len, struct os_mbuf *om,
+                 uint32_t *out_len, fs_read_func_t read_fn)
+{
+    struct os_mbuf *last;
+    struct os_mbuf *m;
+    uint32_t chunk;
+    uint32_t got;
+    int rc;
+
+    *out_len = 0;
+
+    last = om;
+    while (SLIST_NEXT(last, om_next) != NULL) {
+        last = SLIST_NEXT(last, om_next);
+    }
+
+    while (len > 0) {
+        if (OS_MBUF_TRAILINGSPACE(last) == 0) {
+            m = os_mbuf_get(om->om_omp, 0);
+            if (m == NULL) {
+                return FS_ENOMEM;
+            }
+            SLIST_NEXT(last, om_next) = m;
+            last = m;
+        }
+
+        chunk = OS_MBUF_TRAILINGSPACE(last);
+        if (chunk > len) {
+            chunk = len;
+        }
+        rc = read_fn(file, chunk, last->om_data + last->om_len, &got);
+        if (rc != 0) {
+            return rc;
+        }
+
+        last->om_len += got;
+        if (OS_MBUF_IS_PKTHDR(om)) {
+            OS_MBUF_PKTHDR(om)->omp_len += got;
+        }
+        *out_len += got;
+        len -= got;
+
+        if (got < chunk) {
+            /* End of file. */
+            break;
+        }
+    }
+
+    return 0;
+}
+
+int
+fs_read_mbuf(struct fs_file *file, uint32_t len, struct os_mbuf *om,
+             uint32_t *out_len)
+{
+    struct fs_ops *fops = fops_from_file(file);
+
+    if (fops->f_read_mbuf == NULL) {
+        return fs_read_mbuf_seg(file, len, om, out_len, fops->f_read);
+    }
+    return fops->f_read_mbuf(file, len, om, out_len);
+}
+
 int
 fs_write(struct fs_file *file, const void *data, int len)
 {
@@ -45,6 +45,14 @@ static struct {
         const struct flash_area *fa;
         struct fs_file *file;
     } upload;
+    struct {
+        struct os_mutex mtx;
+        struct os_event ev;         /* Reads ahead the next chunk. */
+        struct fs_file *file;
+        struct os_mbuf *om;         /* Chunk read ahead; NULL if none. */
+        uint32_t off;               /* File offset of the next chunk. */
+        char name[FS_NMGR_MAX_NAME + 1];
+    } download;
 } fs_nmgr_state;
 
 static int fs_nmgr_file_download(struct mgmt_cbuf *cb);
@@ -66,12 +74,75 @@ static struct mgmt_group fs_nmgr_group = {
     .mg_group_id = MGMT_GROUP_ID_FS,
 };
 
+static void
+fs_nmgr_download_reset(void)
+{
+    if (fs_nmgr_state.download.om) {
+        os_mbuf_free_chain(fs_nmgr_state.download.om);
+        fs_nmgr_state.download.om = NULL;
+    }
+    if (fs_nmgr_state.download.file) {
+        fs_close(fs_nmgr_state.download.file);
+        fs_nmgr_state.download.file = NULL;
+    }
+}
+
+/*
+ * Reads the chunk at the current file position into a single msys mbuf,
+ * straight from the filesystem into the mbuf's data area.  Chunk is
+ * limited to what fits in the mbuf, so it can be encoded without
+ * gathering.
+ */
+static int
+fs_nmgr_download_read(struct os_mbuf **out_om)
+{
+    struct os_mbuf *om;
+    uint32_t len;
+    int rc;
+
+    om = os_msys_get_pkthdr(MYNEWT_VAL(FS_NMGR_DOWNLOAD_CHUNK_SIZE), 0);
+    if (!om) {
+        return MGMT_ERR_ENOMEM;
+    }
+
+    len = OS_MBUF_TRAILINGSPACE(om);
+    if (len > MYNEWT_VAL(FS_NMGR_DOWNLOAD_CHUNK_SIZE)) {
+        len = MYNEWT_VAL(FS_NMGR_DOWNLOAD_CHUNK_SIZE);
+    }
+    rc = fs_read_mbuf(fs_nmgr_state.download.file, len, om, &len);
+    if (rc) {
+        os_mbuf_free_chain(om);
+        return MGMT_ERR_EUNKNOWN;
+    }
+
+    *out_om = om;
+    return 0;
+}
+
+/*
+ * Runs after the response to a download request has been handed to the
+ * transport; reads the next chunk while the current one is being sent.
+ */
+static void
+fs_nmgr_download_ahead(struct os_event *ev)
+{
+    os_mutex_pend(&fs_nmgr_state.download.mtx, OS_TIMEOUT_NEVER);
+    if (fs_nmgr_state.download.file && !fs_nmgr_state.download.om) {
+        if (fs_nmgr_download_read(&fs_nmgr_state.download.om)) {
+            fs_nmgr_state.download.om = NULL;
+        } else if (OS_MBUF_PKTLEN(fs_nmgr_state.download.om) == 0) {
+            /* Previous chunk was the last one. */
+            fs_nmgr_download_reset();
+        }
+    }
+    os_mutex_release(&fs_nmgr_state.download.mtx);
+}
+
 static int
 fs_nmgr_file_download(struct mgmt_cbuf *cb)
 {
     long long unsigned int off = UINT_MAX;
     char tmp_str[FS_NMGR_MAX_NAME + 1];
-    uint8_t img_data[MYNEWT_VAL(FS_UPLOAD_MAX_CHUNK_SIZE)];
     const struct cbor_attr_t dload_attr[3] = {
         [0] = {
             .attribute = "off",
@@ -88,7 +159,7 @@ fs_nmgr_file_download(struct mgmt_cbuf *cb)
     };
     int rc;
     uint32_t out_len;
-    struct fs_file *file;
+    struct os_mbuf *om;
     CborError g_err = CborNoError;
 
     rc = cbor_read_object(&cb->it, dload_attr);
@@ -96,45 +167,77 @@ fs_nmgr_file_download(struct mgmt_cbuf *cb)
         return MGMT_ERR_EINVAL;
     }
 
-    rc = fs_open(tmp_str, FS_ACCESS_READ, &file);
-    if (rc || !file) {
-        return MGMT_ERR_ENOMEM;
+    os_mutex_pend(&fs_nmgr_state.download.mtx, OS_TIMEOUT_NEVER);
+
+    /*
+     * File is kept open between requests of the same download; the chunk
+     * read ahead is used if the peer asks for it.
+     */
+    if (!fs_nmgr_state.download.file ||
+        strcmp(fs_nmgr_state.download.name, tmp_str)) {
+        fs_nmgr_download_reset();
+        rc = fs_open(tmp_str, FS_ACCESS_READ, &fs_nmgr_state.download.file);
+        if (rc || !fs_nmgr_state.download.file) {
+            fs_nmgr_state.download.file = NULL;
+            rc = MGMT_ERR_ENOMEM;
+            goto out;
+        }
+        strcpy(fs_nmgr_state.download.name, tmp_str);
+        fs_nmgr_state.download.off = 0;
     }
 
-    rc = fs_seek(file, off);
-    if (rc) {
-        rc = MGMT_ERR_EUNKNOWN;
-        goto err_close;
+    om = NULL;
+    if (off == fs_nmgr_state.download.off) {
+        om = fs_nmgr_state.download.om;
+        fs_nmgr_state.download.om = NULL;
     }
-    rc = fs_read(file, 32, img_data, &out_len);
-    if (rc) {
-        rc = MGMT_ERR_EUNKNOWN;
-        goto err_close;
+    if (!om) {
+        if (fs_nmgr_state.download.om) {
+            os_mbuf_free_chain(fs_nmgr_state.download.om);
+            fs_nmgr_state.download.om = NULL;
+        }
+        rc = fs_seek(fs_nmgr_state.download.file, off);
+        if (rc == 0) {
+            rc = fs_nmgr_download_read(&om);
+        } else {
+            rc = MGMT_ERR_EUNKNOWN;
+        }
+        if (rc) {
+            fs_nmgr_download_reset();
+            goto out;
+        }
     }
 
     g_err |= cbor_encode_text_stringz(&cb->encoder, "off");
     g_err |= cbor_encode_uint(&cb->encoder, off);
 
     g_err |= cbor_encode_text_stringz(&cb->encoder, "data");
-    g_err |= cbor_encode_byte_string(&cb->encoder, img_data, out_len);
+    g_err |= cbor_encode_byte_string(&cb->encoder, om->om_data, om->om_len);
 
     g_err |= cbor_encode_text_stringz(&cb->encoder, "rc");
     g_err |= cbor_encode_int(&cb->encoder, MGMT_ERR_EOK);
     if (off == 0) {
-        rc = fs_filelen(file, &out_len);
+        rc = fs_filelen(fs_nmgr_state.download.file, &out_len);
         g_err |= cbor_encode_text_stringz(&cb->encoder, "len");
         g_err |= cbor_encode_uint(&cb->encoder, out_len);
     }
 
-    fs_close(file);
-    if (g_err) {
-        return MGMT_ERR_ENOMEM;
+    fs_nmgr_state.download.off = off + om->om_len;
+    if (om->om_len == 0) {
+        /* End of file. */
+        fs_nmgr_download_reset();
+    } else {
+        os_eventq_put(mgmt_evq_get(), &fs_nmgr_state.download.ev);
     }
+    os_mbuf_free_chain(om);
 
-    return 0;
+    rc = 0;
+    if (g_err) {
+        rc = MGMT_ERR_ENOMEM;
+    }
 
-err_close:
-    fs_close(file);
+out:
+    os_mutex_release(&fs_nmgr_state.download.mtx);
     return rc;
 }
 
@@ -247,6 +350,9 @@ fs_nmgr_init(void)
 {
     int rc;
 
+    os_mutex_init(&fs_nmgr_state.download.mtx);
+    fs_nmgr_state.download.ev.ev_cb = fs_nmgr_download_ahead;
+
     rc = mgmt_group_register(&fs_nmgr_group);
     return rc;
 }
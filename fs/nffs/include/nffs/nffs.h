@@ -62,6 +62,10 @@ struct nffs_area_desc {
 int nffs_init(void);
 int nffs_detect(const struct nffs_area_desc *area_descs);
 int nffs_format(const struct nffs_area_desc *area_descs);
+int nffs_ckpt_set_area(const struct nffs_area_desc *area_desc);
+int nffs_ckpt_write(void);
+int nffs_gc_step(uint32_t max_ticks, int *out_more);
+int nffs_flush(struct fs_file *file);
 
 int nffs_misc_desc_from_flash_area(int idx, int *cnt, struct nffs_area_desc *nad);
 
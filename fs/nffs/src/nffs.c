@@ -68,6 +68,8 @@ static int nffs_open(const char *path, uint8_t access_flags,
 static int nffs_close(struct fs_file *fs_file);
 static int nffs_read(struct fs_file *fs_file, uint32_t len, void *out_data,
   uint32_t *out_len);
+static int nffs_read_mbuf(struct fs_file *fs_file, uint32_t len,
+  struct os_mbuf *om, uint32_t *out_len);
 static int nffs_write(struct fs_file *fs_file, const void *data, int len);
 static int nffs_seek(struct fs_file *fs_file, uint32_t offset);
 static uint32_t nffs_getpos(const struct fs_file *fs_file);
@@ -86,6 +88,7 @@ struct fs_ops nffs_ops = {
     .f_open = nffs_open,
     .f_close = nffs_close,
     .f_read = nffs_read,
+    .f_read_mbuf = nffs_read_mbuf,
     .f_write = nffs_write,
 
     .f_seek = nffs_seek,
@@ -127,6 +130,16 @@ STATS_NAME_START(nffs_stats)
     STATS_NAME(nffs_stats, nffs_readcnt_filename)
     STATS_NAME(nffs_stats, nffs_readcnt_object)
     STATS_NAME(nffs_stats, nffs_readcnt_detect)
+    STATS_NAME(nffs_stats, nffs_cache_inode_hit)
+    STATS_NAME(nffs_stats, nffs_cache_inode_miss)
+    STATS_NAME(nffs_stats, nffs_cache_block_hit)
+    STATS_NAME(nffs_stats, nffs_cache_block_miss)
+    STATS_NAME(nffs_stats, nffs_cache_readahead)
+    STATS_NAME(nffs_stats, nffs_gc_steps)
+    STATS_NAME(nffs_stats, nffs_gc_stall_10ms)
+    STATS_NAME(nffs_stats, nffs_gc_stall_100ms)
+    STATS_NAME(nffs_stats, nffs_gc_stall_1s)
+    STATS_NAME(nffs_stats, nffs_gc_stall_long)
 STATS_NAME_END(nffs_stats)
 
 static void
@@ -232,6 +245,9 @@ done:
 static int
 nffs_close(struct fs_file *fs_file)
 {
+#if MYNEWT_VAL(NFFS_WRITE_BUF_COUNT) > 0
+    int flush_rc;
+#endif
     int rc;
     struct nffs_file *file = (struct nffs_file *)fs_file;
 
@@ -240,7 +256,16 @@ nffs_close(struct fs_file *fs_file)
     }
 
     nffs_lock();
+#if MYNEWT_VAL(NFFS_WRITE_BUF_COUNT) > 0
+    /* The handle goes away even if its buffered data cannot be written. */
+    flush_rc = nffs_wbuf_flush_file(file);
+#endif
     rc = nffs_file_close(file);
+#if MYNEWT_VAL(NFFS_WRITE_BUF_COUNT) > 0
+    if (flush_rc != 0) {
+        rc = flush_rc;
+    }
+#endif
     nffs_unlock();
 
     return rc;
@@ -263,7 +288,14 @@ nffs_seek(struct fs_file *fs_file, uint32_t offset)
     struct nffs_file *file = (struct nffs_file *)fs_file;
 
     nffs_lock();
+#if MYNEWT_VAL(NFFS_WRITE_BUF_COUNT) > 0
+    rc = nffs_wbuf_flush_inode(file->nf_inode_entry, NULL);
+    if (rc == 0) {
+        rc = nffs_file_seek(file, offset);
+    }
+#else
     rc = nffs_file_seek(file, offset);
+#endif
     nffs_unlock();
 
     return rc;
@@ -305,7 +337,14 @@ nffs_file_len(const struct fs_file *fs_file, uint32_t *out_len)
     const struct nffs_file *file = (const struct nffs_file *)fs_file;
 
     nffs_lock();
+#if MYNEWT_VAL(NFFS_WRITE_BUF_COUNT) > 0
+    rc = nffs_wbuf_flush_inode(file->nf_inode_entry, NULL);
+    if (rc == 0) {
+        rc = nffs_inode_data_len(file->nf_inode_entry, out_len);
+    }
+#else
     rc = nffs_inode_data_len(file->nf_inode_entry, out_len);
+#endif
     nffs_unlock();
 
     return rc;
@@ -331,7 +370,55 @@ nffs_read(struct fs_file *fs_file, uint32_t len, void *out_data,
     struct nffs_file *file = (struct nffs_file *)fs_file;
 
     nffs_lock();
+#if MYNEWT_VAL(NFFS_WRITE_BUF_COUNT) > 0
+    rc = nffs_wbuf_flush_inode(file->nf_inode_entry, NULL);
+    if (rc == 0) {
+        rc = nffs_file_read(file, len, out_data, out_len);
+    }
+#else
     rc = nffs_file_read(file, len, out_data, out_len);
+#endif
+    nffs_unlock();
+
+    return rc;
+}
+
+static int
+nffs_read_seg(struct fs_file *fs_file, uint32_t len, void *out_data,
+              uint32_t *out_len)
+{
+    return nffs_file_read((struct nffs_file *)fs_file, len, out_data, out_len);
+}
+
+/**
+ * Reads data from the specified file directly into the data areas of an mbuf
+ * chain.  The lock is held, and the write buffer flushed, once for the whole
+ * chain rather than once per mbuf.
+ *
+ * @param file              The file to read from.
+ * @param len               The number of bytes to attempt to read.
+ * @param om                The chain to append the data to.
+ * @param out_len           On success, the number of bytes actually read gets
+ *                              written here.
+ *
+ * @return                  0 on success; nonzero on failure.
+ */
+static int
+nffs_read_mbuf(struct fs_file *fs_file, uint32_t len, struct os_mbuf *om,
+               uint32_t *out_len)
+{
+    int rc;
+
+    nffs_lock();
+#if MYNEWT_VAL(NFFS_WRITE_BUF_COUNT) > 0
+    rc = nffs_wbuf_flush_inode(((struct nffs_file *)fs_file)->nf_inode_entry,
+                               NULL);
+    if (rc == 0) {
+        rc = fs_read_mbuf_seg(fs_file, len, om, out_len, nffs_read_seg);
+    }
+#else
+    rc = fs_read_mbuf_seg(fs_file, len, om, out_len, nffs_read_seg);
+#endif
     nffs_unlock();
 
     return rc;
@@ -359,7 +446,11 @@ nffs_write(struct fs_file *fs_file, const void *data, int len)
         goto done;
     }
 
+#if MYNEWT_VAL(NFFS_WRITE_BUF_COUNT) > 0
+    rc = nffs_wbuf_write(file, data, len);
+#else
     rc = nffs_write_to_file(file, data, len);
+#endif
     if (rc != 0) {
         goto done;
     }
@@ -673,6 +764,144 @@ nffs_detect(const struct nffs_area_desc *area_descs)
     return rc;
 }
 
+/**
+ * Sets the flash region used to hold checkpoints of the file system's RAM
+ * representation.  A checkpoint lets nffs_detect() skip reading the objects
+ * that existed when it was written.  The region must not overlap any nffs
+ * area and must consist of whole flash sectors.  This must be called before
+ * nffs_detect() for the checkpoint to be used.
+ *
+ * @param area_desc         The checkpoint region, or NULL to stop using
+ *                              checkpoints.
+ *
+ * @return                  0 on success;
+ *                          FS_EINVAL if checkpoints are not enabled.
+ */
+int
+nffs_ckpt_set_area(const struct nffs_area_desc *area_desc)
+{
+#if MYNEWT_VAL(NFFS_CKPT)
+    nffs_lock();
+    nffs_ckpt_set_area_full(area_desc);
+    nffs_unlock();
+
+    return 0;
+#else
+    return FS_EINVAL;
+#endif
+}
+
+/**
+ * Writes a checkpoint of the file system's RAM representation, replacing
+ * any existing one.  Call this at clean shutdown; objects written after the
+ * checkpoint are still restored by the next nffs_detect(), just more slowly.
+ *
+ * @return                  0 on success;
+ *                          FS_EINVAL if checkpoints are not enabled or
+ *                              configured, an unlinked file is still
+ *                              open, or a garbage collection cycle is in
+ *                              progress;
+ *                          FS_EFULL if the checkpoint region is too small;
+ *                          other nonzero on failure.
+ */
+int
+nffs_ckpt_write(void)
+{
+#if MYNEWT_VAL(NFFS_CKPT)
+    int rc;
+
+    nffs_lock();
+    rc = nffs_ckpt_write_full();
+    nffs_unlock();
+
+    return rc;
+#else
+    return FS_EINVAL;
+#endif
+}
+
+/**
+ * Writes any appends buffered for the specified file handle to flash.  Small
+ * appends are collected in RAM (NFFS_WRITE_BUF_COUNT); they are also written
+ * when the buffer fills, when the handle is closed, when the file is read,
+ * seeked or measured, and after NFFS_WRITE_BUF_TIMEOUT_MS.
+ *
+ * @param fs_file           The file handle to flush, or NULL to flush every
+ *                              buffer.
+ *
+ * @return                  0 on success; nonzero on failure.
+ */
+int
+nffs_flush(struct fs_file *fs_file)
+{
+#if MYNEWT_VAL(NFFS_WRITE_BUF_COUNT) > 0
+    struct nffs_file *file = (struct nffs_file *)fs_file;
+    int rc;
+
+    nffs_lock();
+    if (file == NULL) {
+        rc = nffs_wbuf_flush_all();
+    } else {
+        rc = nffs_wbuf_flush_file(file);
+    }
+    nffs_unlock();
+
+    return rc;
+#else
+    return 0;
+#endif
+}
+
+#if MYNEWT_VAL(NFFS_WRITE_BUF_COUNT) > 0 && \
+    MYNEWT_VAL(NFFS_WRITE_BUF_TIMEOUT_MS) > 0
+static void
+nffs_wbuf_timer_exp(struct os_event *ev)
+{
+    nffs_lock();
+    /* A failed write cannot be reported from here; the data is dropped. */
+    nffs_wbuf_flush_expired();
+    nffs_unlock();
+}
+#endif
+
+/**
+ * Performs a bounded amount of garbage collection work.  Call this
+ * periodically from a low priority task or an idle hook; a cycle is started
+ * once the free space outside the scratch area falls below
+ * NFFS_GC_INCREMENTAL_THRESH, and writers only have to wait for garbage
+ * collection if that space runs out before the cycle completes.
+ *
+ * @param max_ticks         The time budget for this step, in OS ticks.
+ * @param out_more          On success, set to 1 if a cycle is still in
+ *                              progress and more steps are needed, 0
+ *                              otherwise.  Pass null if you do not need this
+ *                              information.
+ *
+ * @return                  0 on success;
+ *                          FS_EINVAL if incremental garbage collection is not
+ *                              enabled;
+ *                          other nonzero on failure.
+ */
+int
+nffs_gc_step(uint32_t max_ticks, int *out_more)
+{
+#if MYNEWT_VAL(NFFS_GC_INCREMENTAL)
+    int rc;
+
+    nffs_lock();
+    if (!nffs_misc_ready()) {
+        rc = FS_EUNINIT;
+    } else {
+        rc = nffs_gc_step_full(max_ticks, out_more);
+    }
+    nffs_unlock();
+
+    return rc;
+#else
+    return FS_EINVAL;
+#endif
+}
+
 /**
  * Initializes internal nffs memory and data structures.  This must be called
  * before any nffs operations are attempted.
@@ -698,6 +927,13 @@ nffs_init(void)
         return FS_EOS;
     }
 
+#if MYNEWT_VAL(NFFS_WRITE_BUF_COUNT) > 0 && \
+    MYNEWT_VAL(NFFS_WRITE_BUF_TIMEOUT_MS) > 0
+    os_callout_stop(&nffs_wbuf_timer);
+    os_callout_init(&nffs_wbuf_timer, os_eventq_dflt_get(),
+                    nffs_wbuf_timer_exp, NULL);
+#endif
+
     free(nffs_file_mem);
     nffs_file_mem = malloc(
         OS_MEMPOOL_BYTES(nffs_config.nc_num_files, sizeof (struct nffs_file)));
@@ -758,6 +994,10 @@ void
 nffs_pkg_init(void)
 {
     struct nffs_area_desc descs[NFFS_AREA_MAX + 1];
+#if MYNEWT_VAL(NFFS_CKPT)
+    struct nffs_area_desc ckpt_desc;
+    const struct flash_area *fa;
+#endif
     int cnt;
     int rc;
 
@@ -776,6 +1016,18 @@ nffs_pkg_init(void)
         MYNEWT_VAL(NFFS_FLASH_AREA), &cnt, descs);
     SYSINIT_PANIC_ASSERT(rc == 0);
 
+#if MYNEWT_VAL(NFFS_CKPT)
+    if (MYNEWT_VAL(NFFS_CKPT_FLASH_AREA) >= 0) {
+        rc = flash_area_open(MYNEWT_VAL(NFFS_CKPT_FLASH_AREA), &fa);
+        SYSINIT_PANIC_ASSERT(rc == 0);
+
+        ckpt_desc.nad_offset = fa->fa_off;
+        ckpt_desc.nad_length = fa->fa_size;
+        ckpt_desc.nad_flash_id = fa->fa_device_id;
+        nffs_ckpt_set_area(&ckpt_desc);
+    }
+#endif
+
     /* Attempt to restore an existing nffs file system from flash. */
     rc = nffs_detect(descs);
     switch (rc) {
@@ -18,6 +18,7 @@
  */
 
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 #include "nffs/nffs.h"
 #include "nffs_priv.h"
@@ -28,6 +29,11 @@ static struct nffs_cache_inode_list nffs_cache_inode_list =
 
 static void nffs_cache_reclaim_blocks(void);
 
+#if MYNEWT_VAL(NFFS_CACHE_BLOCK_HEAP_MAX) > 0
+/** Number of cached blocks currently allocated from the heap. */
+static uint16_t nffs_cache_block_heap_count;
+#endif
+
 static struct nffs_cache_block *
 nffs_cache_block_alloc(void)
 {
@@ -36,7 +42,22 @@ nffs_cache_block_alloc(void)
     entry = os_memblock_get(&nffs_cache_block_pool);
     if (entry != NULL) {
         memset(entry, 0, sizeof *entry);
+        return entry;
+    }
+
+#if MYNEWT_VAL(NFFS_CACHE_BLOCK_HEAP_MAX) > 0
+    /* The pool is exhausted; grow the cache from the heap while there is
+     * room, rather than evicting.
+     */
+    if (nffs_cache_block_heap_count < MYNEWT_VAL(NFFS_CACHE_BLOCK_HEAP_MAX)) {
+        entry = malloc(sizeof *entry);
+        if (entry != NULL) {
+            memset(entry, 0, sizeof *entry);
+            entry->ncb_from_heap = 1;
+            nffs_cache_block_heap_count++;
+        }
     }
+#endif
 
     return entry;
 }
@@ -44,9 +65,19 @@ nffs_cache_block_alloc(void)
 static void
 nffs_cache_block_free(struct nffs_cache_block *entry)
 {
-    if (entry != NULL) {
-        os_memblock_put(&nffs_cache_block_pool, entry);
+    if (entry == NULL) {
+        return;
     }
+
+#if MYNEWT_VAL(NFFS_CACHE_BLOCK_HEAP_MAX) > 0
+    if (entry->ncb_from_heap) {
+        free(entry);
+        nffs_cache_block_heap_count--;
+        return;
+    }
+#endif
+
+    os_memblock_put(&nffs_cache_block_pool, entry);
 }
 
 static struct nffs_cache_block *
@@ -214,15 +245,30 @@ nffs_cache_inode_range(const struct nffs_cache_inode *cache_inode,
                cache_block->ncb_block.nb_data_len;
 }
 
+/**
+ * Frees a cached block belonging to the least recently used inode that has
+ * any.  Only the block with the lowest file offset is freed, so the rest of
+ * that inode's cache remains a contiguous run.  If the only inode with cached
+ * blocks is the one most recently used (i.e., the one being operated on), all
+ * of its blocks are freed; the caller is about to rebuild its cache.
+ */
 static void
 nffs_cache_reclaim_blocks(void)
 {
     struct nffs_cache_inode *cache_inode;
+    struct nffs_cache_block *cache_block;
 
     TAILQ_FOREACH_REVERSE(cache_inode, &nffs_cache_inode_list,
                           nffs_cache_inode_list, nci_link) {
         if (!TAILQ_EMPTY(&cache_inode->nci_block_list)) {
-            nffs_cache_inode_free_blocks(cache_inode);
+            if (cache_inode == TAILQ_FIRST(&nffs_cache_inode_list)) {
+                nffs_cache_inode_free_blocks(cache_inode);
+            } else {
+                cache_block = TAILQ_FIRST(&cache_inode->nci_block_list);
+                TAILQ_REMOVE(&cache_inode->nci_block_list, cache_block,
+                             ncb_link);
+                nffs_cache_block_free(cache_block);
+            }
             return;
         }
     }
@@ -253,10 +299,17 @@ nffs_cache_inode_ensure(struct nffs_cache_inode **out_cache_inode,
 
     cache_inode = nffs_cache_inode_find(inode_entry);
     if (cache_inode != NULL) {
+        /* Keep the list in least-recently-used order. */
+        if (cache_inode != TAILQ_FIRST(&nffs_cache_inode_list)) {
+            TAILQ_REMOVE(&nffs_cache_inode_list, cache_inode, nci_link);
+            TAILQ_INSERT_HEAD(&nffs_cache_inode_list, cache_inode, nci_link);
+        }
+        STATS_INC(nffs_stats, nffs_cache_inode_hit);
         rc = 0;
         goto done;
     }
 
+    STATS_INC(nffs_stats, nffs_cache_inode_miss);
     cache_inode = nffs_cache_inode_acquire();
     rc = nffs_cache_inode_populate(cache_inode, inode_entry);
     if (rc != 0) {
@@ -301,7 +354,8 @@ nffs_cache_inode_refresh(void)
             return rc;
         }
 
-        /* File size remains valid. */
+        /* File size remains valid, but blocks may have been merged. */
+        nffs_cache_index_clear(cache_inode);
     }
 
     return 0;
@@ -344,6 +398,225 @@ nffs_cache_insert_block(struct nffs_cache_inode *cache_inode,
     nffs_cache_log_insert_block(cache_inode, cache_block, tail);
 }
 
+#if MYNEWT_VAL(NFFS_CACHE_INDEX_SIZE) > 0
+/**
+ * Returns the position of the first index entry whose block ends after the
+ * specified file offset.
+ */
+static int
+nffs_cache_index_search(const struct nffs_cache_inode *cache_inode,
+                        uint32_t offset)
+{
+    int hi;
+    int lo;
+    int mid;
+
+    lo = 0;
+    hi = cache_inode->nci_index_count;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (cache_inode->nci_index[mid].ncie_block_end > offset) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+
+    return lo;
+}
+
+/**
+ * Makes room in a full index by doubling the minimum distance between
+ * entries and discarding entries that are now too close to their
+ * predecessor.
+ */
+static void
+nffs_cache_index_thin(struct nffs_cache_inode *cache_inode)
+{
+    struct nffs_cache_index_entry *index;
+    int count;
+    int i;
+
+    index = cache_inode->nci_index;
+    while (cache_inode->nci_index_count >= MYNEWT_VAL(NFFS_CACHE_INDEX_SIZE)) {
+        cache_inode->nci_index_gap *= 2;
+
+        count = 1;
+        for (i = 1; i < cache_inode->nci_index_count; i++) {
+            if (index[i].ncie_block_end - index[count - 1].ncie_block_end >=
+                cache_inode->nci_index_gap) {
+
+                index[count++] = index[i];
+            }
+        }
+        cache_inode->nci_index_count = count;
+    }
+}
+#endif
+
+/**
+ * Records the location of a data block in the inode's sparse offset index.
+ * The block is only added if no indexed block ends within the index's
+ * minimum gap of it, so the index stays spread across the whole file.
+ *
+ * @param cache_inode           The cached inode that owns the block.
+ * @param block_entry           The block's hash entry.
+ * @param block_end             The file offset of the end of the block.
+ */
+void
+nffs_cache_index_note(struct nffs_cache_inode *cache_inode,
+                      struct nffs_hash_entry *block_entry,
+                      uint32_t block_end)
+{
+#if MYNEWT_VAL(NFFS_CACHE_INDEX_SIZE) > 0
+    struct nffs_cache_index_entry *index;
+    int idx;
+
+    index = cache_inode->nci_index;
+
+    if (cache_inode->nci_index_gap == 0) {
+        cache_inode->nci_index_gap = cache_inode->nci_file_size /
+                                     MYNEWT_VAL(NFFS_CACHE_INDEX_SIZE);
+        if (cache_inode->nci_index_gap == 0) {
+            cache_inode->nci_index_gap = 1;
+        }
+    }
+
+    /* Index entries are unique by end offset. */
+    idx = nffs_cache_index_search(cache_inode, block_end - 1);
+    if (idx < cache_inode->nci_index_count &&
+        index[idx].ncie_block_end == block_end) {
+
+        index[idx].ncie_block_entry = block_entry;
+        return;
+    }
+
+    if (idx > 0 &&
+        block_end - index[idx - 1].ncie_block_end <
+        cache_inode->nci_index_gap) {
+
+        return;
+    }
+    if (idx < cache_inode->nci_index_count &&
+        index[idx].ncie_block_end - block_end < cache_inode->nci_index_gap) {
+
+        return;
+    }
+
+    if (cache_inode->nci_index_count >= MYNEWT_VAL(NFFS_CACHE_INDEX_SIZE)) {
+        nffs_cache_index_thin(cache_inode);
+        nffs_cache_index_note(cache_inode, block_entry, block_end);
+        return;
+    }
+
+    memmove(index + idx + 1, index + idx,
+            (cache_inode->nci_index_count - idx) * sizeof *index);
+    index[idx].ncie_block_entry = block_entry;
+    index[idx].ncie_block_end = block_end;
+    cache_inode->nci_index_count++;
+#endif
+}
+
+/**
+ * Finds the indexed block that ends closest after the specified file
+ * offset.  A backward walk for the offset can start at this block instead
+ * of the last block in the file.
+ *
+ * @param cache_inode           The cached inode to search.
+ * @param offset                The file offset being sought.
+ * @param out_block_entry       On success, the indexed block's hash entry
+ *                                  gets written here.
+ * @param out_block_end         On success, the file offset of the end of the
+ *                                  indexed block gets written here.
+ *
+ * @return                      0 on success;
+ *                              FS_ENOENT if no indexed block ends after the
+ *                                  offset.
+ */
+int
+nffs_cache_index_lookup(const struct nffs_cache_inode *cache_inode,
+                        uint32_t offset,
+                        struct nffs_hash_entry **out_block_entry,
+                        uint32_t *out_block_end)
+{
+#if MYNEWT_VAL(NFFS_CACHE_INDEX_SIZE) > 0
+    const struct nffs_cache_index_entry *entry;
+    int idx;
+
+    idx = nffs_cache_index_search(cache_inode, offset);
+    if (idx >= cache_inode->nci_index_count) {
+        return FS_ENOENT;
+    }
+
+    entry = cache_inode->nci_index + idx;
+    *out_block_entry = entry->ncie_block_entry;
+    *out_block_end = entry->ncie_block_end;
+    return 0;
+#else
+    return FS_ENOENT;
+#endif
+}
+
+/**
+ * Discards the inode's sparse offset index.  This must be called whenever
+ * the inode's existing blocks may have changed length or been freed.
+ */
+void
+nffs_cache_index_clear(struct nffs_cache_inode *cache_inode)
+{
+#if MYNEWT_VAL(NFFS_CACHE_INDEX_SIZE) > 0
+    cache_inode->nci_index_count = 0;
+    cache_inode->nci_index_gap = 0;
+#endif
+}
+
+#if MYNEWT_VAL(NFFS_CACHE_READ_AHEAD) > 0
+/**
+ * Records a block visited during a backward search.  Only the most recent
+ * NFFS_CACHE_READ_AHEAD blocks are kept; these are the ones that immediately
+ * follow the block being sought.
+ */
+static void
+nffs_cache_readahead_push(struct nffs_cache_readahead *ahead, int *num_ahead,
+                          const struct nffs_block *block, uint32_t file_offset)
+{
+    if (*num_ahead == MYNEWT_VAL(NFFS_CACHE_READ_AHEAD)) {
+        memmove(ahead, ahead + 1, (*num_ahead - 1) * sizeof *ahead);
+        (*num_ahead)--;
+    }
+
+    ahead[*num_ahead].ncr_block = *block;
+    ahead[*num_ahead].ncr_file_offset = file_offset;
+    (*num_ahead)++;
+}
+
+/**
+ * Appends the blocks remembered during a backward search to the end of the
+ * inode's cache, nearest first.  Read-ahead never evicts; it stops when the
+ * block pool is exhausted.
+ */
+static void
+nffs_cache_readahead_insert(struct nffs_cache_inode *cache_inode,
+                            const struct nffs_cache_readahead *ahead,
+                            int num_ahead)
+{
+    struct nffs_cache_block *cache_block;
+    int i;
+
+    for (i = num_ahead - 1; i >= 0; i--) {
+        cache_block = nffs_cache_block_alloc();
+        if (cache_block == NULL) {
+            return;
+        }
+
+        cache_block->ncb_block = ahead[i].ncr_block;
+        cache_block->ncb_file_offset = ahead[i].ncr_file_offset;
+        nffs_cache_insert_block(cache_inode, cache_block, 1);
+        STATS_INC(nffs_stats, nffs_cache_readahead);
+    }
+}
+#endif
+
 /**
  * Finds the data block containing the specified offset within a file inode.
  * If the block is not yet cached, it gets cached as a result of this
@@ -362,6 +635,13 @@ nffs_cache_insert_block(struct nffs_cache_inode *cache_inode,
  *         list.
  *      b. Else, clear the cache, and populate it with the single entry
  *         corresponding to the requested block.
+ *     The backward search in case 3 starts from the nearest block in the
+ *     inode's sparse offset index that ends after the requested offset, or
+ *     from the end of the file if there is none.  Blocks read during the
+ *     search are added to the index.  In case 3a the file is being read
+ *     sequentially, so the blocks that follow the requested one, which the
+ *     search has already read, are appended to the cache as well
+ *     (NFFS_CACHE_READ_AHEAD).
  *
  * @param cache_inode           The cached file inode to seek within.
  * @param seek_offset           The file offset to seek to.
@@ -384,8 +664,18 @@ nffs_cache_seek(struct nffs_cache_inode *cache_inode, uint32_t seek_offset,
     uint32_t cache_end;
     uint32_t block_start;
     uint32_t block_end;
+#if MYNEWT_VAL(NFFS_CACHE_READ_AHEAD) > 0
+    struct nffs_cache_readahead ahead[MYNEWT_VAL(NFFS_CACHE_READ_AHEAD)];
+    int num_ahead;
+#endif
+    int cached;
     int rc;
 
+#if MYNEWT_VAL(NFFS_CACHE_READ_AHEAD) > 0
+    num_ahead = 0;
+#endif
+    cached = 1;
+
     /* Empty files have no blocks that can be cached. */
     if (cache_inode->nci_file_size == 0) {
         return FS_ENOENT;
@@ -411,9 +701,13 @@ nffs_cache_seek(struct nffs_cache_inode *cache_inode, uint32_t seek_offset,
          * will be freed and replaced with the single requested block.
          */
         cache_block = NULL;
-        block_entry =
-            cache_inode->nci_inode.ni_inode_entry->nie_last_block_entry;
-        block_end = cache_inode->nci_file_size;
+        rc = nffs_cache_index_lookup(cache_inode, seek_offset,
+                                     &block_entry, &block_end);
+        if (rc != 0) {
+            block_entry =
+                cache_inode->nci_inode.ni_inode_entry->nie_last_block_entry;
+            block_end = cache_inode->nci_file_size;
+        }
     }
 
     /* Scan backwards until we find the block containing the seek offest. */
@@ -431,6 +725,7 @@ nffs_cache_seek(struct nffs_cache_inode *cache_inode, uint32_t seek_offset,
             }
 
             nffs_cache_insert_block(cache_inode, cache_block, 0);
+            cached = 0;
         }
 
         /* Calculate the file offset of the start of this block.  This is used
@@ -448,9 +743,22 @@ nffs_cache_seek(struct nffs_cache_inode *cache_inode, uint32_t seek_offset,
             if (rc != 0) {
                 return rc;
             }
+            cached = 0;
 
             block_start = block_end - block.nb_data_len;
             pred_entry = block.nb_prev;
+
+            nffs_cache_index_note(cache_inode, block_entry, block_end);
+
+#if MYNEWT_VAL(NFFS_CACHE_READ_AHEAD) > 0
+            /* Remember the blocks just past the one being sought; they can
+             * be cached for free if the access turns out to be sequential.
+             */
+            if (block_start > seek_offset) {
+                nffs_cache_readahead_push(ahead, &num_ahead, &block,
+                                          block_start);
+            }
+#endif
         }
 
         if (block_start <= seek_offset) {
@@ -472,12 +780,23 @@ nffs_cache_seek(struct nffs_cache_inode *cache_inode, uint32_t seek_offset,
                     last_cached_entry == pred_entry) {
 
                     nffs_cache_insert_block(cache_inode, cache_block, 1);
+#if MYNEWT_VAL(NFFS_CACHE_READ_AHEAD) > 0
+                    /* The file is being read sequentially. */
+                    nffs_cache_readahead_insert(cache_inode, ahead,
+                                                num_ahead);
+#endif
                 } else {
                     nffs_cache_inode_free_blocks(cache_inode);
                     nffs_cache_insert_block(cache_inode, cache_block, 0);
                 }
             }
 
+            if (cached) {
+                STATS_INC(nffs_stats, nffs_cache_block_hit);
+            } else {
+                STATS_INC(nffs_stats, nffs_cache_block_miss);
+            }
+
             if (out_cache_block != NULL) {
                 *out_cache_block = cache_block;
             }
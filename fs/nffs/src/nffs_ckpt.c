@@ -0,0 +1,626 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * Checkpoints of the nffs RAM representation.
+ *
+ * Restoring a file system normally requires every object in every area to be
+ * read and CRC-checked.  A checkpoint is a snapshot of the resulting RAM
+ * state, written to a dedicated flash region outside the nffs areas:
+ *
+ *     o Header (struct nffs_disk_ckpt).
+ *     o One struct nffs_disk_ckpt_area per area, in area index order.
+ *     o One struct nffs_disk_ckpt_inode per inode.  The root directory comes
+ *       first; every other inode appears after its siblings that precede it
+ *       in the parent's child list, so the lists can be rebuilt without
+ *       reading any filenames.
+ *     o One struct nffs_disk_ckpt_block per data block.
+ *
+ * The header is written last, so an interrupted write leaves no checkpoint.
+ * When a checkpoint is loaded:
+ *     o The header CRC and the CRC of the rest of the checkpoint must match.
+ *     o The ID and garbage collection sequence number of each area must
+ *       match the area's header on flash.  Any garbage collection cycle
+ *       changes these.
+ * The objects written to each area after the checkpoint are then restored
+ * normally.  This starts at the offset the area had reached when the
+ * checkpoint was written.
+ *
+ * The checkpoint is erased when the file system is formatted and before a
+ * garbage collection cycle.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include "hal/hal_flash.h"
+#include "nffs_priv.h"
+#include "nffs/nffs.h"
+
+#if MYNEWT_VAL(NFFS_CKPT)
+
+#define NFFS_CKPT_MAGIC             0x8a52c3f1
+
+/** On-disk representation of a checkpoint header. */
+struct nffs_disk_ckpt {
+    uint32_t ndc_magic;             /* NFFS_CKPT_MAGIC */
+    uint32_t ndc_next_dir_id;
+    uint32_t ndc_next_file_id;
+    uint32_t ndc_next_block_id;
+    uint32_t ndc_num_inodes;
+    uint32_t ndc_num_blocks;
+    uint16_t ndc_num_areas;
+    uint16_t ndc_block_max_data_sz;
+    uint16_t ndc_body_crc16;        /* Covers everything after the header. */
+    uint16_t ndc_crc16;             /* Covers rest of header. */
+};
+
+#define NFFS_DISK_CKPT_OFFSET_CRC   30
+
+struct nffs_disk_ckpt_area {
+    uint32_t ndca_offset;
+    uint32_t ndca_length;
+    uint32_t ndca_cur;
+    uint8_t ndca_flash_id;
+    uint8_t ndca_gc_seq;
+    uint8_t ndca_id;
+    uint8_t reserved8;
+};
+
+struct nffs_disk_ckpt_inode {
+    uint32_t ndci_id;
+    uint32_t ndci_flash_loc;
+    uint32_t ndci_parent_id;        /* NFFS_ID_NONE for the root. */
+    uint32_t ndci_lastblock_id;     /* NFFS_ID_NONE if not a file or empty. */
+};
+
+struct nffs_disk_ckpt_block {
+    uint32_t ndcb_id;
+    uint32_t ndcb_flash_loc;
+};
+
+static struct nffs_area_desc nffs_ckpt_area;
+
+static int
+nffs_ckpt_read_hdr(struct nffs_disk_ckpt *out_hdr)
+{
+    int rc;
+
+    rc = hal_flash_read(nffs_ckpt_area.nad_flash_id,
+                        nffs_ckpt_area.nad_offset, out_hdr, sizeof *out_hdr);
+    if (rc != 0) {
+        return FS_EHW;
+    }
+
+    if (out_hdr->ndc_magic != NFFS_CKPT_MAGIC) {
+        return FS_ENOENT;
+    }
+
+    if (crc16_ccitt(0, out_hdr, NFFS_DISK_CKPT_OFFSET_CRC) !=
+        out_hdr->ndc_crc16) {
+
+        return FS_ECORRUPT;
+    }
+
+    return 0;
+}
+
+/**
+ * Reads the next record of a checkpoint and folds it into the running CRC.
+ */
+static int
+nffs_ckpt_read(uint32_t *offset, void *dst, int len, uint16_t *crc)
+{
+    int rc;
+
+    if (*offset + len > nffs_ckpt_area.nad_offset + nffs_ckpt_area.nad_length) {
+        return FS_ECORRUPT;
+    }
+
+    rc = hal_flash_read(nffs_ckpt_area.nad_flash_id, *offset, dst, len);
+    if (rc != 0) {
+        return FS_EHW;
+    }
+
+    *crc = crc16_ccitt(*crc, dst, len);
+    *offset += len;
+
+    return 0;
+}
+
+/**
+ * Appends a record to the checkpoint being written and folds it into the
+ * running CRC.
+ */
+static int
+nffs_ckpt_append(uint32_t *offset, const void *src, int len, uint16_t *crc)
+{
+    int rc;
+
+    if (*offset + len > nffs_ckpt_area.nad_offset + nffs_ckpt_area.nad_length) {
+        return FS_EFULL;
+    }
+
+    rc = hal_flash_write(nffs_ckpt_area.nad_flash_id, *offset, src, len);
+    if (rc != 0) {
+        return FS_EHW;
+    }
+
+    *crc = crc16_ccitt(*crc, src, len);
+    *offset += len;
+
+    return 0;
+}
+
+static int
+nffs_ckpt_loc_is_valid(uint32_t flash_loc)
+{
+    uint32_t area_offset;
+    uint8_t area_idx;
+
+    nffs_flash_loc_expand(flash_loc, &area_idx, &area_offset);
+    return area_idx < nffs_num_areas &&
+           area_offset < nffs_areas[area_idx].na_cur;
+}
+
+static int
+nffs_ckpt_append_inode(uint32_t *offset,
+                       const struct nffs_inode_entry *inode_entry,
+                       uint32_t parent_id, uint16_t *crc)
+{
+    struct nffs_disk_ckpt_inode rec;
+
+    if (inode_entry->nie_hash_entry.nhe_flash_loc == NFFS_FLASH_LOC_NONE) {
+        /* Dummy inodes cannot be represented. */
+        return FS_ECORRUPT;
+    }
+
+    rec.ndci_id = inode_entry->nie_hash_entry.nhe_id;
+    rec.ndci_flash_loc = inode_entry->nie_hash_entry.nhe_flash_loc;
+    rec.ndci_parent_id = parent_id;
+    if (nffs_hash_id_is_file(rec.ndci_id) &&
+        inode_entry->nie_last_block_entry != NULL) {
+
+        rec.ndci_lastblock_id = inode_entry->nie_last_block_entry->nhe_id;
+    } else {
+        rec.ndci_lastblock_id = NFFS_ID_NONE;
+    }
+
+    return nffs_ckpt_append(offset, &rec, sizeof rec, crc);
+}
+
+/**
+ * Erases the checkpoint region if it contains a checkpoint.  This must be
+ * done before any operation that rewrites existing areas.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int
+nffs_ckpt_invalidate(void)
+{
+    struct nffs_disk_ckpt hdr;
+    int rc;
+
+    if (nffs_ckpt_area.nad_length == 0) {
+        return 0;
+    }
+
+    rc = nffs_ckpt_read_hdr(&hdr);
+    if (rc == FS_ENOENT) {
+        return 0;
+    }
+
+    rc = hal_flash_erase(nffs_ckpt_area.nad_flash_id,
+                         nffs_ckpt_area.nad_offset,
+                         nffs_ckpt_area.nad_length);
+    if (rc != 0) {
+        return FS_EHW;
+    }
+
+    return 0;
+}
+
+/**
+ * Writes a checkpoint of the current RAM representation, replacing any
+ * existing checkpoint.
+ *
+ * @return                      0 on success;
+ *                              FS_EINVAL if no checkpoint region is
+ *                                  configured or an unlinked file is still
+ *                                  open;
+ *                              FS_EFULL if the checkpoint does not fit in
+ *                                  the region;
+ *                              other nonzero on failure.
+ */
+int
+nffs_ckpt_write_full(void)
+{
+    struct nffs_disk_ckpt_block block_rec;
+    struct nffs_disk_ckpt_area area_rec;
+    struct nffs_inode_entry *inode_entry;
+    struct nffs_inode_entry *child;
+    struct nffs_hash_entry *entry;
+    struct nffs_hash_entry *next;
+    struct nffs_disk_ckpt hdr;
+    uint32_t num_inodes;
+    uint32_t offset;
+    uint16_t crc;
+    int rc;
+    int i;
+
+    if (nffs_ckpt_area.nad_length == 0 || !nffs_misc_ready()) {
+        return FS_EINVAL;
+    }
+
+#if MYNEWT_VAL(NFFS_GC_INCREMENTAL)
+    /* Two areas share an ID until the garbage collection cycle completes. */
+    if (nffs_gc_in_progress()) {
+        return FS_EINVAL;
+    }
+#endif
+
+    rc = hal_flash_erase(nffs_ckpt_area.nad_flash_id,
+                         nffs_ckpt_area.nad_offset,
+                         nffs_ckpt_area.nad_length);
+    if (rc != 0) {
+        return FS_EHW;
+    }
+
+    memset(&hdr, 0, sizeof hdr);
+    offset = nffs_ckpt_area.nad_offset + sizeof hdr;
+    crc = 0;
+
+    for (i = 0; i < nffs_num_areas; i++) {
+        memset(&area_rec, 0, sizeof area_rec);
+        area_rec.ndca_offset = nffs_areas[i].na_offset;
+        area_rec.ndca_length = nffs_areas[i].na_length;
+        area_rec.ndca_cur = nffs_areas[i].na_cur;
+        area_rec.ndca_flash_id = nffs_areas[i].na_flash_id;
+        area_rec.ndca_gc_seq = nffs_areas[i].na_gc_seq;
+        area_rec.ndca_id = nffs_areas[i].na_id;
+
+        rc = nffs_ckpt_append(&offset, &area_rec, sizeof area_rec, &crc);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    /* Root directory first, then the children of each directory in list
+     * order.  Every inode must be reachable from the root; otherwise the
+     * checkpoint would leave blocks without an owner.
+     */
+    rc = nffs_ckpt_append_inode(&offset, nffs_root_dir, NFFS_ID_NONE, &crc);
+    if (rc != 0) {
+        return rc;
+    }
+    hdr.ndc_num_inodes = 1;
+    num_inodes = 0;
+
+    NFFS_HASH_FOREACH(entry, i, next) {
+        if (!nffs_hash_id_is_inode(entry->nhe_id)) {
+            continue;
+        }
+        num_inodes++;
+
+        if (!nffs_hash_id_is_dir(entry->nhe_id)) {
+            continue;
+        }
+
+        inode_entry = (struct nffs_inode_entry *)entry;
+        SLIST_FOREACH(child, &inode_entry->nie_child_list, nie_sibling_next) {
+            rc = nffs_ckpt_append_inode(&offset, child, entry->nhe_id, &crc);
+            if (rc != 0) {
+                return rc;
+            }
+            hdr.ndc_num_inodes++;
+        }
+    }
+    if (num_inodes != hdr.ndc_num_inodes) {
+        return FS_EINVAL;
+    }
+
+    NFFS_HASH_FOREACH(entry, i, next) {
+        if (!nffs_hash_id_is_block(entry->nhe_id)) {
+            continue;
+        }
+
+        if (entry->nhe_flash_loc == NFFS_FLASH_LOC_NONE) {
+            return FS_ECORRUPT;
+        }
+
+        block_rec.ndcb_id = entry->nhe_id;
+        block_rec.ndcb_flash_loc = entry->nhe_flash_loc;
+        rc = nffs_ckpt_append(&offset, &block_rec, sizeof block_rec, &crc);
+        if (rc != 0) {
+            return rc;
+        }
+        hdr.ndc_num_blocks++;
+    }
+
+    /* Commit the checkpoint by writing its header. */
+    hdr.ndc_magic = NFFS_CKPT_MAGIC;
+    hdr.ndc_next_dir_id = nffs_hash_next_dir_id;
+    hdr.ndc_next_file_id = nffs_hash_next_file_id;
+    hdr.ndc_next_block_id = nffs_hash_next_block_id;
+    hdr.ndc_num_areas = nffs_num_areas;
+    hdr.ndc_block_max_data_sz = nffs_block_max_data_sz;
+    hdr.ndc_body_crc16 = crc;
+    hdr.ndc_crc16 = crc16_ccitt(0, &hdr, NFFS_DISK_CKPT_OFFSET_CRC);
+
+    rc = hal_flash_write(nffs_ckpt_area.nad_flash_id,
+                         nffs_ckpt_area.nad_offset, &hdr, sizeof hdr);
+    if (rc != 0) {
+        return FS_EHW;
+    }
+
+    NFFS_LOG(DEBUG, "wrote checkpoint; inodes=%u blocks=%u len=%u\n",
+             (unsigned int)hdr.ndc_num_inodes,
+             (unsigned int)hdr.ndc_num_blocks,
+             (unsigned int)(offset - nffs_ckpt_area.nad_offset));
+
+    return 0;
+}
+
+/**
+ * Builds the RAM representation from the checkpoint, then restores the
+ * objects that were written to the areas after the checkpoint.  The area
+ * headers must already have been read into nffs_areas.  On failure, the RAM
+ * representation is left partially built and must be reset.
+ *
+ * @param out_block_data_len    On success, the maximum block data length in
+ *                                  effect when the checkpoint was written
+ *                                  gets written here.
+ * @param out_replayed          On success, 1 gets written here if any
+ *                                  objects were restored on top of the
+ *                                  checkpoint; 0 otherwise.
+ *
+ * @return                      0 on success;
+ *                              FS_ENOENT if there is no checkpoint;
+ *                              FS_ECORRUPT if the checkpoint is invalid or
+ *                                  does not match the areas;
+ *                              other nonzero on failure.
+ */
+int
+nffs_ckpt_restore(uint16_t *out_block_data_len, int *out_replayed)
+{
+    struct nffs_disk_ckpt_inode inode_rec;
+    struct nffs_disk_ckpt_block block_rec;
+    struct nffs_disk_ckpt_area area_rec;
+    struct nffs_inode_entry *inode_entry;
+    struct nffs_inode_entry *prev_parent;
+    struct nffs_inode_entry *parent;
+    struct nffs_inode_entry *prev;
+    struct nffs_hash_entry *entry;
+    struct nffs_disk_ckpt hdr;
+    struct nffs_inode inode;
+    uint32_t inodes_offset;
+    uint32_t offset;
+    uint32_t cur;
+    uint32_t i;
+    uint16_t crc;
+    int rc;
+
+    if (nffs_ckpt_area.nad_length == 0) {
+        return FS_ENOENT;
+    }
+
+    rc = nffs_ckpt_read_hdr(&hdr);
+    if (rc != 0) {
+        return rc;
+    }
+
+    if (hdr.ndc_num_areas != nffs_num_areas) {
+        return FS_ECORRUPT;
+    }
+
+    offset = nffs_ckpt_area.nad_offset + sizeof hdr;
+    crc = 0;
+
+    /* The areas must be exactly as they were when the checkpoint was
+     * written, apart from objects appended since.
+     */
+    for (i = 0; i < nffs_num_areas; i++) {
+        rc = nffs_ckpt_read(&offset, &area_rec, sizeof area_rec, &crc);
+        if (rc != 0) {
+            return rc;
+        }
+
+        if (area_rec.ndca_offset != nffs_areas[i].na_offset ||
+            area_rec.ndca_length != nffs_areas[i].na_length ||
+            area_rec.ndca_flash_id != nffs_areas[i].na_flash_id ||
+            area_rec.ndca_gc_seq != nffs_areas[i].na_gc_seq ||
+            area_rec.ndca_id != nffs_areas[i].na_id ||
+            area_rec.ndca_cur > nffs_areas[i].na_length) {
+
+            return FS_ECORRUPT;
+        }
+
+        if (nffs_areas[i].na_id != NFFS_AREA_ID_NONE) {
+            nffs_areas[i].na_cur = area_rec.ndca_cur;
+        }
+    }
+
+    /* First pass: create every hash entry. */
+    inodes_offset = offset;
+    for (i = 0; i < hdr.ndc_num_inodes; i++) {
+        rc = nffs_ckpt_read(&offset, &inode_rec, sizeof inode_rec, &crc);
+        if (rc != 0) {
+            return rc;
+        }
+
+        if (!nffs_hash_id_is_inode(inode_rec.ndci_id) ||
+            !nffs_ckpt_loc_is_valid(inode_rec.ndci_flash_loc) ||
+            nffs_hash_find(inode_rec.ndci_id) != NULL) {
+
+            return FS_ECORRUPT;
+        }
+
+        inode_entry = nffs_inode_entry_alloc();
+        if (inode_entry == NULL) {
+            return FS_ENOMEM;
+        }
+        inode_entry->nie_hash_entry.nhe_id = inode_rec.ndci_id;
+        inode_entry->nie_hash_entry.nhe_flash_loc = inode_rec.ndci_flash_loc;
+        inode_entry->nie_refcnt = 1;
+        nffs_hash_insert(&inode_entry->nie_hash_entry);
+    }
+
+    for (i = 0; i < hdr.ndc_num_blocks; i++) {
+        rc = nffs_ckpt_read(&offset, &block_rec, sizeof block_rec, &crc);
+        if (rc != 0) {
+            return rc;
+        }
+
+        if (!nffs_hash_id_is_block(block_rec.ndcb_id) ||
+            !nffs_ckpt_loc_is_valid(block_rec.ndcb_flash_loc) ||
+            nffs_hash_find(block_rec.ndcb_id) != NULL) {
+
+            return FS_ECORRUPT;
+        }
+
+        entry = nffs_block_entry_alloc();
+        if (entry == NULL) {
+            return FS_ENOMEM;
+        }
+        entry->nhe_id = block_rec.ndcb_id;
+        entry->nhe_flash_loc = block_rec.ndcb_flash_loc;
+        nffs_hash_insert(entry);
+    }
+
+    if (crc != hdr.ndc_body_crc16) {
+        return FS_ECORRUPT;
+    }
+
+    /* Second pass: link each inode to its parent and last block.  Siblings
+     * are stored in list order.
+     */
+    offset = inodes_offset;
+    prev_parent = NULL;
+    prev = NULL;
+    for (i = 0; i < hdr.ndc_num_inodes; i++) {
+        rc = nffs_ckpt_read(&offset, &inode_rec, sizeof inode_rec, &crc);
+        if (rc != 0) {
+            return rc;
+        }
+
+        inode_entry = nffs_hash_find_inode(inode_rec.ndci_id);
+        assert(inode_entry != NULL);
+
+        if (inode_rec.ndci_lastblock_id != NFFS_ID_NONE) {
+            if (!nffs_hash_id_is_file(inode_rec.ndci_id) ||
+                !nffs_hash_id_is_block(inode_rec.ndci_lastblock_id)) {
+
+                return FS_ECORRUPT;
+            }
+
+            entry = nffs_hash_find_block(inode_rec.ndci_lastblock_id);
+            if (entry == NULL) {
+                return FS_ECORRUPT;
+            }
+            inode_entry->nie_last_block_entry = entry;
+        }
+
+        if (inode_rec.ndci_parent_id == NFFS_ID_NONE) {
+            if (inode_rec.ndci_id != NFFS_ID_ROOT_DIR) {
+                return FS_ECORRUPT;
+            }
+            nffs_root_dir = inode_entry;
+        } else {
+            if (!nffs_hash_id_is_dir(inode_rec.ndci_parent_id)) {
+                return FS_ECORRUPT;
+            }
+
+            parent = nffs_hash_find_inode(inode_rec.ndci_parent_id);
+            if (parent == NULL) {
+                return FS_ECORRUPT;
+            }
+
+            if (parent == prev_parent) {
+                SLIST_INSERT_AFTER(prev, inode_entry, nie_sibling_next);
+            } else {
+                SLIST_INSERT_HEAD(&parent->nie_child_list, inode_entry,
+                                  nie_sibling_next);
+            }
+            prev_parent = parent;
+            prev = inode_entry;
+
+            rc = nffs_inode_from_entry(&inode, inode_entry);
+            if (rc != 0) {
+                return FS_ECORRUPT;
+            }
+            rc = nffs_inode_filename_hash(&inode, &inode_entry->nie_name_hash);
+            if (rc != 0) {
+                return rc;
+            }
+        }
+        nffs_inode_setflags(inode_entry, NFFS_INODE_FLAG_INTREE);
+    }
+
+    if (hdr.ndc_next_dir_id > nffs_hash_next_dir_id) {
+        nffs_hash_next_dir_id = hdr.ndc_next_dir_id;
+    }
+    if (hdr.ndc_next_file_id > nffs_hash_next_file_id) {
+        nffs_hash_next_file_id = hdr.ndc_next_file_id;
+    }
+    if (hdr.ndc_next_block_id > nffs_hash_next_block_id) {
+        nffs_hash_next_block_id = hdr.ndc_next_block_id;
+    }
+
+    NFFS_LOG(DEBUG, "restored checkpoint; inodes=%u blocks=%u\n",
+             (unsigned int)hdr.ndc_num_inodes,
+             (unsigned int)hdr.ndc_num_blocks);
+
+    /* Restore everything written since the checkpoint. */
+    *out_replayed = 0;
+    for (i = 0; i < nffs_num_areas; i++) {
+        if (nffs_areas[i].na_id == NFFS_AREA_ID_NONE) {
+            continue;
+        }
+
+        cur = nffs_areas[i].na_cur;
+        rc = nffs_restore_area_contents(i);
+        if (rc != 0) {
+            return rc;
+        }
+        if (nffs_areas[i].na_cur != cur) {
+            *out_replayed = 1;
+        }
+    }
+
+    *out_block_data_len = hdr.ndc_block_max_data_sz;
+    return 0;
+}
+
+/**
+ * Sets the flash region used to hold checkpoints.  The region must not
+ * overlap any nffs area and must consist of whole flash sectors.
+ *
+ * @param area_desc             The checkpoint region, or NULL to stop using
+ *                                  checkpoints.
+ */
+void
+nffs_ckpt_set_area_full(const struct nffs_area_desc *area_desc)
+{
+    if (area_desc == NULL) {
+        memset(&nffs_ckpt_area, 0, sizeof nffs_ckpt_area);
+    } else {
+        nffs_ckpt_area = *area_desc;
+    }
+}
+
+#endif
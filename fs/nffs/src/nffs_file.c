@@ -236,6 +236,13 @@ nffs_file_open(struct nffs_file **out_file, const char *path,
     }
 
     if (access_flags & FS_ACCESS_APPEND) {
+#if MYNEWT_VAL(NFFS_WRITE_BUF_COUNT) > 0
+        /* Start after any data other handles have buffered. */
+        rc = nffs_wbuf_flush_inode(file->nf_inode_entry, NULL);
+        if (rc != 0) {
+            goto err;
+        }
+#endif
         rc = nffs_inode_data_len(file->nf_inode_entry, &file->nf_offset);
         if (rc != 0) {
             goto err;
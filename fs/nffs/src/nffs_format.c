@@ -113,6 +113,16 @@ nffs_format_full(const struct nffs_area_desc *area_descs)
     /* Start from a clean state. */
     nffs_misc_reset();
 
+#if MYNEWT_VAL(NFFS_CKPT)
+    /* A checkpoint of the old file system must not be applied to the new
+     * one.
+     */
+    rc = nffs_ckpt_invalidate();
+    if (rc != 0) {
+        goto err;
+    }
+#endif
+
     /* Select largest area to be the initial scratch area. */
     nffs_scratch_area_idx = 0;
     for (i = 1; area_descs[i].nad_length != 0; i++) {
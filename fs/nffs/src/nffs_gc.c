@@ -396,78 +396,64 @@ nffs_gc_inode_blocks(struct nffs_inode_entry *inode_entry,
 }
 
 /**
- * Triggers a garbage collection cycle.  This is implemented as follows:
+ * Starts a garbage collection cycle: selects the source area and turns the
+ * scratch area into its destination by giving it the source area's ID.
  *
- *  (1) The non-scratch area with the lowest garbage collection sequence
- *      number is selected as the "source area."  If there are other areas
- *      with the same sequence number, the first one encountered is selected.
+ * @param out_from_area_idx     On success, the index of the source area gets
+ *                                  written here.
  *
- *  (2) The source area's ID is written to the scratch area's header,
- *      transforming it into a non-scratch ID.  The former scratch area is now
- *      known as the "destination area."
- *
- *  (3) The RAM representation is exhaustively searched for objects which are
- *      resident in the source area.  The copy is accomplished as follows:
- *
- *      For each inode:
- *          (a) If the inode is resident in the source area, copy the inode
- *              record to the destination area.
- *
- *          (b) Walk the inode's list of data blocks, starting with the last
- *              block in the file.  Each block that is resident in the source
- *              area is copied to the destination area.  If there is a run of
- *              two or more blocks that are resident in the source area, they
- *              are consolidated and copied to the destination area as a single
- *              new block.
- *
- *  (4) The source area is reformatted as a scratch sector (i.e., its header
- *      indicates an ID of 0xffff).  The area's garbage collection sequence
- *      number is incremented prior to rewriting the header.  This area is now
- *      the new scratch sector.
- *
- * NOTE:
- *     Garbage collection invalidates all cached data blocks.  Whenever this
- *     function is called, all existing nffs_cache_block pointers are rendered
- *     invalid.  If you maintain any such pointers, you need to reset them
- *     after calling this function.  Cached inodes are not invalidated by
- *     garbage collection.
- *
- *     If a parent function potentially calls this function, the caller of the
- *     parent function needs to explicitly check if garbage collection
- *     occurred.  This is done by inspecting the nffs_gc_count variable before
- *     and after calling the function.
- *
- * @param out_area_idx      On success, the ID of the cleaned up area gets
- *                              written here.  Pass null if you do not need
- *                              this information.
- *
- * @return                  0 on success; nonzero on error.
+ * @return                      0 on success; nonzero on failure.
  */
-int
-nffs_gc(uint8_t *out_area_idx)
+static int
+nffs_gc_begin(uint8_t *out_from_area_idx)
 {
-    struct nffs_hash_entry *entry;
-    struct nffs_hash_entry *next;
-    struct nffs_area *from_area;
-    struct nffs_area *to_area;
-    struct nffs_inode_entry *inode_entry;
-    uint32_t area_offset;
     uint8_t from_area_idx;
-    uint8_t area_idx;
     int rc;
-    int i;
+
+#if MYNEWT_VAL(NFFS_CKPT)
+    /* The checkpoint describes the areas as they are before this cycle. */
+    rc = nffs_ckpt_invalidate();
+    if (rc != 0) {
+        return rc;
+    }
+#endif
 
     from_area_idx = nffs_gc_select_area();
-    from_area = nffs_areas + from_area_idx;
-    to_area = nffs_areas + nffs_scratch_area_idx;
 
     rc = nffs_format_from_scratch_area(nffs_scratch_area_idx,
-                                       from_area->na_id);
+                                       nffs_areas[from_area_idx].na_id);
     if (rc != 0) {
         return rc;
     }
 
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
+    *out_from_area_idx = from_area_idx;
+
+    return 0;
+}
+
+/**
+ * Copies the objects resident in the source area whose inodes lie in the
+ * specified range of hash buckets to the destination (scratch) area.
+ *
+ * @param from_area_idx         The index of the area being collected.
+ * @param first_bucket          The first hash bucket to process.
+ * @param end_bucket            One past the last hash bucket to process.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+static int
+nffs_gc_copy_buckets(uint8_t from_area_idx, uint32_t first_bucket,
+                     uint32_t end_bucket)
+{
+    struct nffs_hash_entry *entry;
+    struct nffs_hash_entry *next;
+    struct nffs_inode_entry *inode_entry;
+    uint32_t area_offset;
+    uint8_t area_idx;
+    uint32_t i;
+    int rc;
+
+    for (i = first_bucket; i < end_bucket; i++) {
         entry = SLIST_FIRST(nffs_hash + i);
         while (entry != NULL) {
             next = SLIST_NEXT(entry, nhe_next);
@@ -501,6 +487,30 @@ nffs_gc(uint8_t *out_area_idx)
         }
     }
 
+    return 0;
+}
+
+/**
+ * Completes a garbage collection cycle once every object has been copied out
+ * of the source area: the source area is reformatted as the new scratch area.
+ *
+ * @param from_area_idx         The index of the area being collected.
+ * @param out_area_idx          On success, the index of the cleaned up area
+ *                                  gets written here.  Pass null if you do not
+ *                                  need this information.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+static int
+nffs_gc_end(uint8_t from_area_idx, uint8_t *out_area_idx)
+{
+    struct nffs_area *from_area;
+    struct nffs_area *to_area;
+    int rc;
+
+    from_area = nffs_areas + from_area_idx;
+    to_area = nffs_areas + nffs_scratch_area_idx;
+
     /* The amount of written data should never increase as a result of a gc
      * cycle.
      */
@@ -535,9 +545,282 @@ nffs_gc(uint8_t *out_area_idx)
     nffs_gc_count++;
     STATS_INC(nffs_stats, nffs_gccnt);
 
+#if MYNEWT_VAL(NFFS_CKPT) && MYNEWT_VAL(NFFS_CKPT_ON_GC)
+    /* Garbage collection leaves the RAM representation consistent with the
+     * areas; take a fresh checkpoint.  Failure only costs restore time.
+     */
+    nffs_ckpt_write_full();
+#endif
+
     return 0;
 }
 
+#if MYNEWT_VAL(NFFS_GC_INCREMENTAL)
+
+/**
+ * State of the garbage collection cycle being performed in steps.  Between
+ * steps, the source area is not written to (its objects would be missed) and
+ * the destination area only receives copies (its contents are discarded if
+ * the cycle is interrupted by a reboot).
+ */
+static struct {
+    uint8_t active;
+    uint8_t from_area_idx;
+    uint32_t next_bucket;
+} nffs_gc_inc;
+
+int
+nffs_gc_in_progress(void)
+{
+    return nffs_gc_inc.active;
+}
+
+/**
+ * Abandons the stepped garbage collection cycle, if any.  This is only valid
+ * when the RAM representation is being discarded as well.
+ */
+void
+nffs_gc_inc_reset(void)
+{
+    memset(&nffs_gc_inc, 0, sizeof nffs_gc_inc);
+}
+
+/**
+ * Completes the stepped garbage collection cycle without regard for time.
+ *
+ * @param out_area_idx          On success, the index of the cleaned up area
+ *                                  gets written here.  Pass null if you do not
+ *                                  need this information.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int
+nffs_gc_inc_finish(uint8_t *out_area_idx)
+{
+    int rc;
+
+    assert(nffs_gc_inc.active);
+
+    rc = nffs_gc_copy_buckets(nffs_gc_inc.from_area_idx,
+                              nffs_gc_inc.next_bucket, nffs_hash_size);
+    if (rc != 0) {
+        return rc;
+    }
+
+    nffs_gc_inc.active = 0;
+
+    return nffs_gc_end(nffs_gc_inc.from_area_idx, out_area_idx);
+}
+
+/**
+ * Calculates the number of bytes that can still be written without garbage
+ * collection.
+ */
+static uint32_t
+nffs_gc_writable_space(void)
+{
+    uint32_t space;
+    int i;
+
+    space = 0;
+    for (i = 0; i < nffs_num_areas; i++) {
+        if (nffs_gc_area_is_writable(i)) {
+            space += nffs_area_free_space(nffs_areas + i);
+        }
+    }
+
+    return space;
+}
+
+/**
+ * Performs a bounded amount of garbage collection work.  If no cycle is in
+ * progress, one is started when the writable free space has fallen below
+ * NFFS_GC_INCREMENTAL_THRESH.  Hash buckets are then processed until the
+ * cycle completes or the time budget is spent; at least one bucket is
+ * processed per call.
+ *
+ * @param max_ticks             The time budget, in OS ticks.
+ * @param out_more              On success, set to 1 if a cycle is still in
+ *                                  progress, 0 otherwise.  Pass null if you
+ *                                  do not need this information.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int
+nffs_gc_step_full(os_time_t max_ticks, int *out_more)
+{
+    os_time_t start;
+    uint32_t bucket;
+    int rc;
+
+    if (!nffs_gc_inc.active) {
+        if (nffs_num_areas < 2 ||
+            nffs_gc_writable_space() >= MYNEWT_VAL(NFFS_GC_INCREMENTAL_THRESH)) {
+
+            rc = 0;
+            goto done;
+        }
+
+        rc = nffs_gc_begin(&nffs_gc_inc.from_area_idx);
+        if (rc != 0) {
+            goto done;
+        }
+        nffs_gc_inc.next_bucket = 0;
+        nffs_gc_inc.active = 1;
+    }
+
+    start = os_time_get();
+    do {
+        bucket = nffs_gc_inc.next_bucket;
+        rc = nffs_gc_copy_buckets(nffs_gc_inc.from_area_idx, bucket,
+                                  bucket + 1);
+        if (rc != 0) {
+            goto done;
+        }
+        nffs_gc_inc.next_bucket++;
+    } while (nffs_gc_inc.next_bucket < nffs_hash_size &&
+             os_time_get() - start < max_ticks);
+    STATS_INC(nffs_stats, nffs_gc_steps);
+
+    if (nffs_gc_inc.next_bucket >= nffs_hash_size) {
+        nffs_gc_inc.active = 0;
+        rc = nffs_gc_end(nffs_gc_inc.from_area_idx, NULL);
+    } else {
+        /* Copied blocks may have been collated; drop any cached pointers to
+         * their entries.
+         */
+        rc = nffs_cache_inode_refresh();
+    }
+
+done:
+    if (out_more != NULL) {
+        *out_more = nffs_gc_inc.active;
+    }
+    return rc;
+}
+
+#endif
+
+/**
+ * Indicates whether new objects may be written to the specified area.  The
+ * scratch area and an area being garbage collected in steps are not writable.
+ */
+int
+nffs_gc_area_is_writable(uint8_t area_idx)
+{
+    if (area_idx == nffs_scratch_area_idx) {
+        return 0;
+    }
+
+#if MYNEWT_VAL(NFFS_GC_INCREMENTAL)
+    if (nffs_gc_inc.active && area_idx == nffs_gc_inc.from_area_idx) {
+        return 0;
+    }
+#endif
+
+    return 1;
+}
+
+/**
+ * Records the time a writer spent waiting for garbage collection in the stall
+ * histogram.
+ *
+ * @param ticks                 The duration of the stall, in OS ticks.
+ */
+void
+nffs_gc_note_stall(os_time_t ticks)
+{
+    uint32_t ms;
+
+    ms = (uint64_t)ticks * 1000 / OS_TICKS_PER_SEC;
+    if (ms < 10) {
+        STATS_INC(nffs_stats, nffs_gc_stall_10ms);
+    } else if (ms < 100) {
+        STATS_INC(nffs_stats, nffs_gc_stall_100ms);
+    } else if (ms < 1000) {
+        STATS_INC(nffs_stats, nffs_gc_stall_1s);
+    } else {
+        STATS_INC(nffs_stats, nffs_gc_stall_long);
+    }
+}
+
+/**
+ * Triggers a garbage collection cycle.  This is implemented as follows:
+ *
+ *  (1) The non-scratch area with the lowest garbage collection sequence
+ *      number is selected as the "source area."  If there are other areas
+ *      with the same sequence number, the first one encountered is selected.
+ *
+ *  (2) The source area's ID is written to the scratch area's header,
+ *      transforming it into a non-scratch ID.  The former scratch area is now
+ *      known as the "destination area."
+ *
+ *  (3) The RAM representation is exhaustively searched for objects which are
+ *      resident in the source area.  The copy is accomplished as follows:
+ *
+ *      For each inode:
+ *          (a) If the inode is resident in the source area, copy the inode
+ *              record to the destination area.
+ *
+ *          (b) Walk the inode's list of data blocks, starting with the last
+ *              block in the file.  Each block that is resident in the source
+ *              area is copied to the destination area.  If there is a run of
+ *              two or more blocks that are resident in the source area, they
+ *              are consolidated and copied to the destination area as a single
+ *              new block.
+ *
+ *  (4) The source area is reformatted as a scratch sector (i.e., its header
+ *      indicates an ID of 0xffff).  The area's garbage collection sequence
+ *      number is incremented prior to rewriting the header.  This area is now
+ *      the new scratch sector.
+ *
+ * NOTE:
+ *     Garbage collection invalidates all cached data blocks.  Whenever this
+ *     function is called, all existing nffs_cache_block pointers are rendered
+ *     invalid.  If you maintain any such pointers, you need to reset them
+ *     after calling this function.  Cached inodes are not invalidated by
+ *     garbage collection.
+ *
+ *     With NFFS_GC_INCREMENTAL, a cycle may already have been started by
+ *     nffs_gc_step(); in that case this function completes that cycle.
+ *
+ *     If a parent function potentially calls this function, the caller of the
+ *     parent function needs to explicitly check if garbage collection
+ *     occurred.  This is done by inspecting the nffs_gc_count variable before
+ *     and after calling the function.
+ *
+ * @param out_area_idx      On success, the ID of the cleaned up area gets
+ *                              written here.  Pass null if you do not need
+ *                              this information.
+ *
+ * @return                  0 on success; nonzero on error.
+ */
+int
+nffs_gc(uint8_t *out_area_idx)
+{
+    uint8_t from_area_idx;
+    int rc;
+
+#if MYNEWT_VAL(NFFS_GC_INCREMENTAL)
+    /* A cycle is already under way; completing it counts as this one. */
+    if (nffs_gc_inc.active) {
+        return nffs_gc_inc_finish(out_area_idx);
+    }
+#endif
+
+    rc = nffs_gc_begin(&from_area_idx);
+    if (rc != 0) {
+        return rc;
+    }
+
+    rc = nffs_gc_copy_buckets(from_area_idx, 0, nffs_hash_size);
+    if (rc != 0) {
+        return rc;
+    }
+
+    return nffs_gc_end(from_area_idx, out_area_idx);
+}
+
 /**
  * Repeatedly performs garbage collection cycles until there is enough free
  * space to accommodate an object of the specified size.  If there still isn't
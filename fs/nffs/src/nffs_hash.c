@@ -24,6 +24,10 @@
 #include "nffs_priv.h"
 
 struct nffs_hash_list *nffs_hash;
+uint32_t nffs_hash_size;
+
+/** log2 of nffs_hash_size. */
+static uint8_t nffs_hash_bits;
 
 uint32_t nffs_hash_next_dir_id;
 uint32_t nffs_hash_next_file_id;
@@ -53,10 +57,18 @@ nffs_hash_id_is_block(uint32_t id)
     return id >= NFFS_ID_BLOCK_MIN && id < NFFS_ID_BLOCK_MAX;
 }
 
-static int
+/**
+ * Fibonacci hash: the multiplication spreads sequential IDs across the whole
+ * table, and the top bits of the product select the bucket.
+ */
+int
 nffs_hash_fn(uint32_t id)
 {
-    return id % NFFS_HASH_SIZE;
+    if (nffs_hash_bits == 0) {
+        return 0;
+    }
+
+    return (id * 0x9e3779b1) >> (32 - nffs_hash_bits);
 }
 
 static struct nffs_hash_entry *
@@ -194,21 +206,76 @@ nffs_hash_remove(struct nffs_hash_entry *entry)
     assert(nffs_hash_find(entry->nhe_id) == NULL);
 }
 
+static uint8_t
+nffs_hash_size_bits(uint32_t size)
+{
+    uint8_t bits;
+
+    bits = 0;
+    while (bits < 31 && (1UL << bits) < size) {
+        bits++;
+    }
+
+    return bits;
+}
+
+/**
+ * Changes the number of buckets in the hash table, moving every entry to its
+ * new bucket.  On failure, the existing table is left intact.
+ *
+ * @param size                  The new number of buckets; rounded up to a
+ *                                  power of two.
+ *
+ * @return                      0 on success; FS_ENOMEM on failure.
+ */
 int
-nffs_hash_init(void)
+nffs_hash_resize(uint32_t size)
 {
-    int i;
+    struct nffs_hash_list *old_hash;
+    struct nffs_hash_entry *entry;
+    uint32_t old_size;
+    uint32_t i;
+    uint8_t bits;
 
-    free(nffs_hash);
+    bits = nffs_hash_size_bits(size);
+    if (nffs_hash != NULL && bits == nffs_hash_bits) {
+        return 0;
+    }
+
+    old_hash = nffs_hash;
+    old_size = nffs_hash_size;
 
-    nffs_hash = malloc(NFFS_HASH_SIZE * sizeof *nffs_hash);
+    nffs_hash = malloc((1UL << bits) * sizeof *nffs_hash);
     if (nffs_hash == NULL) {
+        nffs_hash = old_hash;
         return FS_ENOMEM;
     }
 
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
+    nffs_hash_bits = bits;
+    nffs_hash_size = 1UL << bits;
+    for (i = 0; i < nffs_hash_size; i++) {
         SLIST_INIT(nffs_hash + i);
     }
 
+    for (i = 0; i < old_size; i++) {
+        while ((entry = SLIST_FIRST(old_hash + i)) != NULL) {
+            SLIST_REMOVE_HEAD(old_hash + i, nhe_next);
+            SLIST_INSERT_HEAD(nffs_hash + nffs_hash_fn(entry->nhe_id),
+                              entry, nhe_next);
+        }
+    }
+
+    free(old_hash);
+
     return 0;
 }
+
+int
+nffs_hash_init(void)
+{
+    free(nffs_hash);
+    nffs_hash = NULL;
+    nffs_hash_size = 0;
+
+    return nffs_hash_resize(MYNEWT_VAL(NFFS_HASH_SIZE));
+}
@@ -556,6 +556,7 @@ nffs_inode_rename(struct nffs_inode_entry *inode_entry,
     struct nffs_inode inode;
     uint32_t area_offset;
     uint8_t area_idx;
+    uint8_t name_hash;
     int filename_len;
     int ancestor;
     int rc;
@@ -604,6 +605,7 @@ nffs_inode_rename(struct nffs_inode_entry *inode_entry,
 
         new_filename = (char *)nffs_flash_buf;
     }
+    name_hash = nffs_inode_name_hash(new_filename, filename_len);
 
     rc = nffs_misc_reserve_space(sizeof disk_inode + filename_len,
                                  &area_idx, &area_offset);
@@ -633,6 +635,9 @@ nffs_inode_rename(struct nffs_inode_entry *inode_entry,
     inode_entry->nie_hash_entry.nhe_flash_loc =
         nffs_flash_loc(area_idx, area_offset);
 
+    /* The directory entry is now known by its new name. */
+    inode_entry->nie_name_hash = name_hash;
+
     return 0;
 }
 
@@ -774,6 +779,85 @@ nffs_inode_read_filename(struct nffs_inode_entry *inode_entry, size_t max_len,
     return 0;
 }
 
+/* FNV-1a, folded to 8 bits when finished. */
+#define NFFS_INODE_NAME_HASH_INIT   2166136261u
+
+static uint32_t
+nffs_inode_name_hash_add(uint32_t hash, const uint8_t *buf, int len)
+{
+    int i;
+
+    for (i = 0; i < len; i++) {
+        hash ^= buf[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static uint8_t
+nffs_inode_name_hash_fold(uint32_t hash)
+{
+    return hash ^ (hash >> 8) ^ (hash >> 16) ^ (hash >> 24);
+}
+
+/**
+ * Calculates the filename hash that is kept in RAM for each directory entry
+ * (nie_name_hash).  Path lookups only read the filename of children whose
+ * hash matches from flash.
+ */
+uint8_t
+nffs_inode_name_hash(const char *name, int name_len)
+{
+    uint32_t hash;
+
+    hash = nffs_inode_name_hash_add(NFFS_INODE_NAME_HASH_INIT,
+                                    (const uint8_t *)name, name_len);
+    return nffs_inode_name_hash_fold(hash);
+}
+
+/**
+ * Calculates the filename hash of an inode, reading its filename from flash.
+ */
+int
+nffs_inode_filename_hash(const struct nffs_inode *inode, uint8_t *out_hash)
+{
+    uint32_t hash;
+    int chunk_len;
+    int off;
+    int rc;
+
+    if (inode->ni_filename_len <= NFFS_SHORT_FILENAME_LEN) {
+        chunk_len = inode->ni_filename_len;
+    } else {
+        chunk_len = NFFS_SHORT_FILENAME_LEN;
+    }
+    hash = nffs_inode_name_hash_add(NFFS_INODE_NAME_HASH_INIT,
+                                    inode->ni_filename, chunk_len);
+
+    off = chunk_len;
+    while (off < inode->ni_filename_len) {
+        chunk_len = inode->ni_filename_len - off;
+        if (chunk_len > NFFS_INODE_FILENAME_BUF_SZ) {
+            chunk_len = NFFS_INODE_FILENAME_BUF_SZ;
+        }
+
+        rc = nffs_inode_read_filename_chunk(inode, off,
+                                            nffs_inode_filename_buf0,
+                                            chunk_len);
+        if (rc != 0) {
+            return rc;
+        }
+
+        hash = nffs_inode_name_hash_add(hash, nffs_inode_filename_buf0,
+                                        chunk_len);
+        off += chunk_len;
+    }
+
+    *out_hash = nffs_inode_name_hash_fold(hash);
+    return 0;
+}
+
 int
 nffs_inode_add_child(struct nffs_inode_entry *parent,
                      struct nffs_inode_entry *child)
@@ -793,6 +877,11 @@ nffs_inode_add_child(struct nffs_inode_entry *parent,
         return rc;
     }
 
+    rc = nffs_inode_filename_hash(&child_inode, &child->nie_name_hash);
+    if (rc != 0) {
+        return rc;
+    }
+
     prev = NULL;
     SLIST_FOREACH(cur, &parent->nie_child_list, nie_sibling_next) {
         assert(cur != child);
@@ -1002,14 +1091,22 @@ nffs_inode_seek(struct nffs_inode_entry *inode_entry, uint32_t offset,
 
     seek_end = offset + length;
 
-    cur_entry = inode_entry->nie_last_block_entry;
-    cur_offset = cache_inode->nci_file_size;
+    /* Start from the nearest indexed block if there is one; otherwise walk
+     * backwards from the end of the file.
+     */
+    rc = nffs_cache_index_lookup(cache_inode, seek_end - 1,
+                                 &cur_entry, &cur_offset);
+    if (rc != 0) {
+        cur_entry = inode_entry->nie_last_block_entry;
+        cur_offset = cache_inode->nci_file_size;
+    }
 
     while (1) {
         rc = nffs_block_from_hash_entry(&block, cur_entry);
         if (rc != 0) {
             return rc;
         }
+        nffs_cache_index_note(cache_inode, cur_entry, cur_offset);
 
         block_start = cur_offset - block.nb_data_len;
         if (seek_end > block_start) {
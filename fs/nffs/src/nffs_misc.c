@@ -136,6 +136,8 @@ nffs_misc_gc_if_oom(void *resource, int *out_rc)
      */
     static uint8_t total_gc_cycles;
 
+    os_time_t start;
+
     if (resource != NULL) {
         /* Allocation succeeded.  Reset cycle count in preparation for the next
          * allocation failure.
@@ -154,7 +156,9 @@ nffs_misc_gc_if_oom(void *resource, int *out_rc)
     }
 
     /* Attempt a garbage collection on the next area. */
+    start = os_time_get();
     *out_rc = nffs_gc(NULL);
+    nffs_gc_note_stall(os_time_get() - start);
     total_gc_cycles++;
     STATS_INC(nffs_stats, nffs_gccnt);
     if (*out_rc != 0) {
@@ -210,13 +214,14 @@ int
 nffs_misc_reserve_space(uint16_t space,
                         uint8_t *out_area_idx, uint32_t *out_area_offset)
 {
+    os_time_t start;
     uint8_t area_idx;
     int rc;
     int i;
 
     /* Find the first area with sufficient free space. */
     for (i = 0; i < nffs_num_areas; i++) {
-        if (i != nffs_scratch_area_idx) {
+        if (nffs_gc_area_is_writable(i)) {
             rc = nffs_misc_reserve_space_area(i, space, out_area_offset);
             if (rc == 0) {
                 *out_area_idx = i;
@@ -228,7 +233,9 @@ nffs_misc_reserve_space(uint16_t space,
     /* No area can accommodate the request.  Garbage collect until an area
      * has enough space.
      */
+    start = os_time_get();
     rc = nffs_gc_until(space, &area_idx);
+    nffs_gc_note_stall(os_time_get() - start);
     if (rc != 0) {
         return rc;
     }
@@ -364,6 +371,12 @@ nffs_misc_reset(void)
     int rc;
 
     nffs_cache_clear();
+#if MYNEWT_VAL(NFFS_GC_INCREMENTAL)
+    nffs_gc_inc_reset();
+#endif
+#if MYNEWT_VAL(NFFS_WRITE_BUF_COUNT) > 0
+    nffs_wbuf_reset();
+#endif
 
     rc = os_mempool_init(&nffs_file_pool, nffs_config.nc_num_files,
                          sizeof (struct nffs_file), nffs_file_mem,
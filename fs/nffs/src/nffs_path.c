@@ -72,10 +72,17 @@ nffs_path_find_child(struct nffs_inode_entry *parent,
 {
     struct nffs_inode_entry *cur;
     struct nffs_inode inode;
+    uint8_t hash;
     int cmp;
     int rc;
 
+    /* Only children with a matching filename hash are read from flash. */
+    hash = nffs_inode_name_hash(name, name_len);
     SLIST_FOREACH(cur, &parent->nie_child_list, nie_sibling_next) {
+        if (cur->nie_name_hash != hash) {
+            continue;
+        }
+
         rc = nffs_inode_from_entry(&inode, cur);
         if (rc != 0) {
             return rc;
@@ -90,9 +97,6 @@ nffs_path_find_child(struct nffs_inode_entry *parent,
             *out_inode_entry = cur;
             return 0;
         }
-        if (cmp > 0) {
-            break;
-        }
     }
 
     return FS_ENOENT;
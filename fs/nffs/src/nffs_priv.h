@@ -21,9 +21,12 @@
 #define H_NFFS_PRIV_
 
 #include <inttypes.h>
+#include "syscfg/syscfg.h"
 #include "log/log.h"
 #include "os/queue.h"
 #include "os/os_mempool.h"
+#include "os/os_time.h"
+#include "os/os_callout.h"
 #include "nffs/nffs.h"
 #include "fs/fs.h"
 #include "crc/crc16.h"
@@ -33,8 +36,6 @@
 extern "C" {
 #endif
 
-#define NFFS_HASH_SIZE               256
-
 #define NFFS_ID_DIR_MIN              0
 #define NFFS_ID_DIR_MAX              0x10000000
 #define NFFS_ID_FILE_MIN             0x10000000
@@ -133,7 +134,7 @@ struct nffs_inode_entry {
     uint8_t nie_refcnt;
     uint8_t nie_flags;
     uint8_t nie_blkcnt;
-    uint8_t reserved8;
+    uint8_t nie_name_hash;  /* Filename hash; valid while in a dir. */
 };
 
 #define    NFFS_INODE_FLAG_FREE        0x00
@@ -226,16 +227,40 @@ struct nffs_cache_block {
     TAILQ_ENTRY(nffs_cache_block) ncb_link; /* Next / prev cached block. */
     struct nffs_block ncb_block;            /* Full data block. */
     uint32_t ncb_file_offset;               /* File offset of this block. */
+#if MYNEWT_VAL(NFFS_CACHE_BLOCK_HEAP_MAX) > 0
+    uint8_t ncb_from_heap;                  /* Not from the block pool. */
+#endif
+};
+
+/** A block read during a backward search; a read-ahead candidate. */
+struct nffs_cache_readahead {
+    struct nffs_block ncr_block;
+    uint32_t ncr_file_offset;
 };
 
 TAILQ_HEAD(nffs_cache_block_list, nffs_cache_block);
 
+/** A known block location within a file; sorted by end offset. */
+struct nffs_cache_index_entry {
+    struct nffs_hash_entry *ncie_block_entry;
+    uint32_t ncie_block_end;                /* File offset of block end. */
+};
+
 /** Represents a single cached file inode. */
 struct nffs_cache_inode {
-    TAILQ_ENTRY(nffs_cache_inode) nci_link;        /* Sorted; LRU at tail. */
+    TAILQ_ENTRY(nffs_cache_inode) nci_link;        /* LRU at tail. */
     struct nffs_inode nci_inode;                   /* Full inode. */
     struct nffs_cache_block_list nci_block_list;   /* List of cached blocks. */
     uint32_t nci_file_size;                        /* Total file size. */
+#if MYNEWT_VAL(NFFS_CACHE_INDEX_SIZE) > 0
+    /* Sparse block offset index; entries are at least nci_index_gap bytes
+     * apart.
+     */
+    struct nffs_cache_index_entry
+        nci_index[MYNEWT_VAL(NFFS_CACHE_INDEX_SIZE)];
+    uint32_t nci_index_gap;
+    uint8_t nci_index_count;
+#endif
 };
 
 struct nffs_dirent {
@@ -269,6 +294,16 @@ STATS_SECT_START(nffs_stats)
     STATS_SECT_ENTRY(nffs_readcnt_filename)
     STATS_SECT_ENTRY(nffs_readcnt_object)
     STATS_SECT_ENTRY(nffs_readcnt_detect)
+    STATS_SECT_ENTRY(nffs_cache_inode_hit)
+    STATS_SECT_ENTRY(nffs_cache_inode_miss)
+    STATS_SECT_ENTRY(nffs_cache_block_hit)
+    STATS_SECT_ENTRY(nffs_cache_block_miss)
+    STATS_SECT_ENTRY(nffs_cache_readahead)
+    STATS_SECT_ENTRY(nffs_gc_steps)
+    STATS_SECT_ENTRY(nffs_gc_stall_10ms)
+    STATS_SECT_ENTRY(nffs_gc_stall_100ms)
+    STATS_SECT_ENTRY(nffs_gc_stall_1s)
+    STATS_SECT_ENTRY(nffs_gc_stall_long)
 STATS_SECT_END
 extern STATS_SECT_DECL(nffs_stats) nffs_stats;
 
@@ -298,6 +333,7 @@ extern struct nffs_area_desc *nffs_current_area_descs;
 extern uint8_t nffs_flash_buf[NFFS_FLASH_BUF_SZ];
 
 extern struct nffs_hash_list *nffs_hash;
+extern uint32_t nffs_hash_size;
 extern struct nffs_inode_entry *nffs_root_dir;
 extern struct nffs_inode_entry *nffs_lost_found_dir;
 
@@ -349,6 +385,14 @@ void nffs_cache_inode_range(const struct nffs_cache_inode *cache_inode,
 int nffs_cache_seek(struct nffs_cache_inode *cache_inode, uint32_t to,
                     struct nffs_cache_block **out_cache_block);
 void nffs_cache_clear(void);
+void nffs_cache_index_note(struct nffs_cache_inode *cache_inode,
+                           struct nffs_hash_entry *block_entry,
+                           uint32_t block_end);
+int nffs_cache_index_lookup(const struct nffs_cache_inode *cache_inode,
+                            uint32_t offset,
+                            struct nffs_hash_entry **out_block_entry,
+                            uint32_t *out_block_end);
+void nffs_cache_index_clear(struct nffs_cache_inode *cache_inode);
 
 /* @crc */
 int nffs_crc_flash(uint16_t initial_crc, uint8_t area_idx,
@@ -390,6 +434,14 @@ int nffs_format_full(const struct nffs_area_desc *area_descs);
 /* @gc */
 int nffs_gc(uint8_t *out_area_idx);
 int nffs_gc_until(uint32_t space, uint8_t *out_area_idx);
+int nffs_gc_area_is_writable(uint8_t area_idx);
+void nffs_gc_note_stall(os_time_t ticks);
+#if MYNEWT_VAL(NFFS_GC_INCREMENTAL)
+int nffs_gc_in_progress(void);
+void nffs_gc_inc_reset(void);
+int nffs_gc_inc_finish(uint8_t *out_area_idx);
+int nffs_gc_step_full(os_time_t max_ticks, int *out_more);
+#endif
 
 /* @flash */
 struct nffs_area *nffs_flash_find_area(uint16_t logical_id);
@@ -415,6 +467,8 @@ struct nffs_hash_entry *nffs_hash_find_block(uint32_t id);
 void nffs_hash_insert(struct nffs_hash_entry *entry);
 void nffs_hash_remove(struct nffs_hash_entry *entry);
 int nffs_hash_init(void);
+int nffs_hash_resize(uint32_t size);
+int nffs_hash_fn(uint32_t id);
 int nffs_hash_entry_is_dummy(struct nffs_hash_entry *he);
 int nffs_hash_id_is_dummy(uint32_t id);
 
@@ -457,6 +511,9 @@ int nffs_inode_filename_cmp_ram(const struct nffs_inode *inode,
 int nffs_inode_filename_cmp_flash(const struct nffs_inode *inode1,
                                   const struct nffs_inode *inode2,
                                   int *result);
+uint8_t nffs_inode_name_hash(const char *name, int name_len);
+int nffs_inode_filename_hash(const struct nffs_inode *inode,
+                             uint8_t *out_hash);
 int nffs_inode_read(struct nffs_inode_entry *inode_entry, uint32_t offset,
                     uint32_t len, void *data, uint32_t *out_len);
 int nffs_inode_seek(struct nffs_inode_entry *inode_entry, uint32_t offset,
@@ -501,13 +558,36 @@ int nffs_path_new_dir(const char *path,
 
 /* @restore */
 int nffs_restore_full(const struct nffs_area_desc *area_descs);
+int nffs_restore_area_contents(int area_idx);
+int nffs_restore_detect_one_area(uint8_t flash_id, uint32_t area_offset,
+                                 struct nffs_disk_area *out_disk_area);
+
+/* @ckpt */
+#if MYNEWT_VAL(NFFS_CKPT)
+int nffs_ckpt_invalidate(void);
+int nffs_ckpt_write_full(void);
+int nffs_ckpt_restore(uint16_t *out_block_data_len, int *out_replayed);
+void nffs_ckpt_set_area_full(const struct nffs_area_desc *area_desc);
+#endif
 
 /* @write */
 int nffs_write_to_file(struct nffs_file *file, const void *data, int len);
 
+/* @wbuf */
+#if MYNEWT_VAL(NFFS_WRITE_BUF_COUNT) > 0
+extern struct os_callout nffs_wbuf_timer;
+int nffs_wbuf_write(struct nffs_file *file, const void *data, int len);
+int nffs_wbuf_flush_file(struct nffs_file *file);
+int nffs_wbuf_flush_inode(const struct nffs_inode_entry *inode_entry,
+                          const struct nffs_file *skip);
+int nffs_wbuf_flush_all(void);
+int nffs_wbuf_flush_expired(void);
+void nffs_wbuf_reset(void);
+#endif
+
 
 #define NFFS_HASH_FOREACH(entry, i, next)                               \
-    for ((i) = 0; (i) < NFFS_HASH_SIZE; (i)++)                          \
+    for ((i) = 0; (i) < nffs_hash_size; (i)++)                          \
         for ((entry) = SLIST_FIRST(nffs_hash + (i));                    \
              (entry) && (((next)) = SLIST_NEXT((entry), nhe_next), 1);  \
              (entry) = ((next)))
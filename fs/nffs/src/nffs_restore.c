@@ -288,7 +288,7 @@ nffs_restore_sweep(void)
     /* Iterate through every object in the hash table, deleting all inodes that
      * should be removed.
      */
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
+    for (i = 0; i < nffs_hash_size; i++) {
         list = nffs_hash + i;
 
         entry = SLIST_FIRST(list);
@@ -1031,13 +1031,14 @@ nffs_restore_disk_object_size(const struct nffs_disk_object *disk_object)
 
 /**
  * Reads the specified area from disk and loads its contents into the RAM
- * representation.
+ * representation.  Reading starts at the area's current offset (na_cur) and
+ * continues until the end of the written region.
  *
  * @param area_idx              The index of the area to read.
  *
  * @return                      0 on success; nonzero on failure.
  */
-static int
+int
 nffs_restore_area_contents(int area_idx)
 {
     struct nffs_disk_object disk_object;
@@ -1046,7 +1047,6 @@ nffs_restore_area_contents(int area_idx)
 
     area = nffs_areas + area_idx;
 
-    area->na_cur = sizeof (struct nffs_disk_area);
     while (1) {
         rc = nffs_restore_disk_object(area_idx, area->na_cur,  &disk_object);
         switch (rc) {
@@ -1100,7 +1100,7 @@ nffs_restore_area_contents(int area_idx)
  * @return                      0 on success;
  *                              nonzero on failure.
  */
-static int
+int
 nffs_restore_detect_one_area(uint8_t flash_id, uint32_t area_offset,
                              struct nffs_disk_area *out_disk_area)
 {
@@ -1160,7 +1160,7 @@ nffs_restore_corrupt_scratch(void)
     }
 
     /* Invalidate all objects resident in the bad area. */
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
+    for (i = 0; i < nffs_hash_size; i++) {
         entry = SLIST_FIRST(&nffs_hash[i]);
         while (entry != NULL) {
             next = SLIST_NEXT(entry, nhe_next);
@@ -1186,6 +1186,7 @@ nffs_restore_corrupt_scratch(void)
     /* Now that the objects in the scratch area have been invalidated, reload
      * everything from the good area.
      */
+    nffs_areas[good_idx].na_cur = sizeof (struct nffs_disk_area);
     rc = nffs_restore_area_contents(good_idx);
     if (rc != 0) {
         return rc;
@@ -1274,21 +1275,46 @@ nffs_log_contents(void)
     }
 }
 
+#if MYNEWT_VAL(NFFS_HASH_AUTO_SIZE)
+static void
+nffs_restore_size_hash(void)
+{
+    struct nffs_hash_entry *entry;
+    struct nffs_hash_entry *next;
+    uint32_t num_objs;
+    uint32_t size;
+    int i;
+
+    num_objs = 0;
+    NFFS_HASH_FOREACH(entry, i, next) {
+        num_objs++;
+    }
+
+    size = num_objs / 2;
+    if (size < MYNEWT_VAL(NFFS_HASH_SIZE)) {
+        size = MYNEWT_VAL(NFFS_HASH_SIZE);
+    }
+    if (size > MYNEWT_VAL(NFFS_HASH_MAX_SIZE)) {
+        size = MYNEWT_VAL(NFFS_HASH_MAX_SIZE);
+    }
+
+    nffs_hash_resize(size);
+}
+#endif
+
 /**
- * Searches for a valid nffs file system among the specified areas.  This
- * function succeeds if a file system is detected among any subset of the
- * supplied areas.  If the area set does not contain a valid file system,
- * a new one can be created via a call to nffs_format().
+ * Reads the header of each of the specified areas and adds each usable area
+ * to the RAM representation.
  *
  * @param area_descs        The area set to search.  This array must be
  *                              terminated with a 0-length area.
+ * @param read_contents     Whether to also restore the objects contained in
+ *                              each non-scratch area.
  *
- * @return                  0 on success;
- *                          FS_ECORRUPT if no valid file system was detected;
- *                          other nonzero on error.
+ * @return                  0 on success; nonzero on failure.
  */
-int
-nffs_restore_full(const struct nffs_area_desc *area_descs)
+static int
+nffs_restore_areas(const struct nffs_area_desc *area_descs, int read_contents)
 {
     struct nffs_disk_area disk_area;
     int cur_area_idx;
@@ -1296,19 +1322,10 @@ nffs_restore_full(const struct nffs_area_desc *area_descs)
     int rc;
     int i;
 
-    /* Start from a clean state. */
-    rc = nffs_misc_reset();
-    if (rc) {
-        return rc;
-    }
-    nffs_restore_largest_block_data_len = 0;
-    nffs_current_area_descs = (struct nffs_area_desc*) area_descs;
-
     /* Read each area from flash. */
     for (i = 0; area_descs[i].nad_length != 0; i++) {
         if (i > NFFS_MAX_AREAS) {
-            rc = FS_EINVAL;
-            goto err;
+            return FS_EINVAL;
         }
 
         rc = nffs_restore_detect_one_area(area_descs[i].nad_flash_id,
@@ -1325,7 +1342,7 @@ nffs_restore_full(const struct nffs_area_desc *area_descs)
             break;
 
         default:
-            goto err;
+            return rc;
         }
 
         if (use_area) {
@@ -1343,7 +1360,7 @@ nffs_restore_full(const struct nffs_area_desc *area_descs)
 
             rc = nffs_misc_set_num_areas(nffs_num_areas + 1);
             if (rc != 0) {
-                goto err;
+                return rc;
             }
 
             nffs_areas[cur_area_idx].na_offset = area_descs[i].nad_offset;
@@ -1358,11 +1375,78 @@ nffs_restore_full(const struct nffs_area_desc *area_descs)
             } else {
                 nffs_areas[cur_area_idx].na_cur =
                     sizeof (struct nffs_disk_area);
-                nffs_restore_area_contents(cur_area_idx);
+                if (read_contents) {
+                    nffs_restore_area_contents(cur_area_idx);
+                }
             }
         }
     }
 
+    return 0;
+}
+
+/**
+ * Searches for a valid nffs file system among the specified areas.  This
+ * function succeeds if a file system is detected among any subset of the
+ * supplied areas.  If the area set does not contain a valid file system,
+ * a new one can be created via a call to nffs_format().
+ *
+ * @param area_descs        The area set to search.  This array must be
+ *                              terminated with a 0-length area.
+ *
+ * @return                  0 on success;
+ *                          FS_ECORRUPT if no valid file system was detected;
+ *                          other nonzero on error.
+ */
+int
+nffs_restore_full(const struct nffs_area_desc *area_descs)
+{
+    int need_sweep;
+    int rc;
+#if MYNEWT_VAL(NFFS_CKPT)
+    uint16_t ckpt_block_data_len;
+#endif
+
+    /* Start from a clean state. */
+    rc = nffs_misc_reset();
+    if (rc) {
+        return rc;
+    }
+    nffs_restore_largest_block_data_len = 0;
+    nffs_current_area_descs = (struct nffs_area_desc*) area_descs;
+    need_sweep = 1;
+
+#if MYNEWT_VAL(NFFS_CKPT)
+    /* Try to load the RAM representation from a checkpoint.  Only the objects
+     * written since the checkpoint need to be read from the areas.
+     */
+    rc = nffs_restore_areas(area_descs, 0);
+    if (rc == 0) {
+        rc = nffs_ckpt_restore(&ckpt_block_data_len, &need_sweep);
+    }
+    if (rc == 0) {
+        if (ckpt_block_data_len > nffs_restore_largest_block_data_len) {
+            nffs_restore_largest_block_data_len = ckpt_block_data_len;
+        }
+    } else {
+        /* No usable checkpoint; fall back to a full scan. */
+        rc = nffs_misc_reset();
+        if (rc) {
+            return rc;
+        }
+        nffs_restore_largest_block_data_len = 0;
+        nffs_current_area_descs = (struct nffs_area_desc*) area_descs;
+        need_sweep = 1;
+
+        rc = nffs_restore_areas(area_descs, 1);
+    }
+#else
+    rc = nffs_restore_areas(area_descs, 1);
+#endif
+    if (rc != 0) {
+        goto err;
+    }
+
     /* All areas have been restored from flash. */
 
     if (nffs_scratch_area_idx == NFFS_AREA_ID_NONE) {
@@ -1397,9 +1481,19 @@ nffs_restore_full(const struct nffs_area_desc *area_descs)
     }
 
     /* Delete from RAM any objects that were invalidated when subsequent areas
-     * were restored.
+     * were restored.  A checkpoint describes a consistent state, so sweeping
+     * is only necessary if objects were restored on top of it.
      */
-    nffs_restore_sweep();
+    if (need_sweep) {
+        nffs_restore_sweep();
+    }
+
+#if MYNEWT_VAL(NFFS_HASH_AUTO_SIZE)
+    /* Now that the object count is known, grow the hash table so chains stay
+     * short.  Failure to grow is not fatal.
+     */
+    nffs_restore_size_hash();
+#endif
 
     /* Set the maximum data block size according to the size of the smallest
      * area.
@@ -0,0 +1,397 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include "nffs_priv.h"
+#include "nffs/nffs.h"
+
+#if MYNEWT_VAL(NFFS_WRITE_BUF_COUNT) > 0
+
+/**
+ * Collects small appends to a file in RAM so that they reach flash as a
+ * single data block.  The buffered bytes always extend the file: nwb_offset
+ * is the length of the file on flash, and the data is written there when the
+ * buffer is flushed.
+ */
+struct nffs_wbuf {
+    struct nffs_file *nwb_file;     /* Owning handle; null if unused. */
+    uint32_t nwb_offset;            /* File offset of nwb_data[0]. */
+    os_time_t nwb_start;            /* When the first byte was buffered. */
+    uint16_t nwb_len;
+    uint8_t nwb_data[MYNEWT_VAL(NFFS_WRITE_BUF_SIZE)];
+};
+
+static struct nffs_wbuf nffs_wbufs[MYNEWT_VAL(NFFS_WRITE_BUF_COUNT)];
+
+/** Flushes buffers that have been holding data for too long. */
+struct os_callout nffs_wbuf_timer;
+
+#define NFFS_WBUF_TIMEOUT_TICKS                                     \
+    (MYNEWT_VAL(NFFS_WRITE_BUF_TIMEOUT_MS) * OS_TICKS_PER_SEC / 1000)
+
+static struct nffs_wbuf *
+nffs_wbuf_find(const struct nffs_file *file)
+{
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(NFFS_WRITE_BUF_COUNT); i++) {
+        if (nffs_wbufs[i].nwb_file == file) {
+            return nffs_wbufs + i;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Writes a buffer's contents to flash and releases the buffer.  The buffer is
+ * released even if the write fails.
+ */
+static int
+nffs_wbuf_flush_one(struct nffs_wbuf *wbuf)
+{
+    struct nffs_file *file;
+    uint32_t offset;
+    int rc;
+
+    file = wbuf->nwb_file;
+    if (file == NULL) {
+        return 0;
+    }
+
+    /* Write at the buffered offset; the handle's position stays where the
+     * caller left it.
+     */
+    offset = file->nf_offset;
+    file->nf_offset = wbuf->nwb_offset;
+    rc = nffs_write_to_file(file, wbuf->nwb_data, wbuf->nwb_len);
+    file->nf_offset = offset;
+
+    wbuf->nwb_file = NULL;
+    wbuf->nwb_len = 0;
+
+    return rc;
+}
+
+/**
+ * Flushes the buffer owned by the specified file handle, if any.
+ *
+ * @param file                  The file handle to flush.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int
+nffs_wbuf_flush_file(struct nffs_file *file)
+{
+    struct nffs_wbuf *wbuf;
+
+    wbuf = nffs_wbuf_find(file);
+    if (wbuf == NULL) {
+        return 0;
+    }
+
+    return nffs_wbuf_flush_one(wbuf);
+}
+
+/**
+ * Flushes all buffers holding data for the specified file, so that its
+ * contents and length on flash are up to date.
+ *
+ * @param inode_entry           The file to flush.
+ * @param skip                  A handle whose buffer is left alone; pass null
+ *                                  to flush every buffer.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int
+nffs_wbuf_flush_inode(const struct nffs_inode_entry *inode_entry,
+                      const struct nffs_file *skip)
+{
+    struct nffs_wbuf *wbuf;
+    int rc;
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(NFFS_WRITE_BUF_COUNT); i++) {
+        wbuf = nffs_wbufs + i;
+        if (wbuf->nwb_file != NULL && wbuf->nwb_file != skip &&
+            wbuf->nwb_file->nf_inode_entry == inode_entry) {
+
+            rc = nffs_wbuf_flush_one(wbuf);
+            if (rc != 0) {
+                return rc;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Flushes every buffer.  All buffers are released even if a write fails; the
+ * first error is reported.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int
+nffs_wbuf_flush_all(void)
+{
+    int flush_rc;
+    int rc;
+    int i;
+
+    rc = 0;
+    for (i = 0; i < MYNEWT_VAL(NFFS_WRITE_BUF_COUNT); i++) {
+        flush_rc = nffs_wbuf_flush_one(nffs_wbufs + i);
+        if (rc == 0) {
+            rc = flush_rc;
+        }
+    }
+
+    return rc;
+}
+
+static void
+nffs_wbuf_timer_arm(void)
+{
+#if MYNEWT_VAL(NFFS_WRITE_BUF_TIMEOUT_MS) > 0
+    os_time_t earliest;
+    os_time_t now;
+    int32_t ticks;
+    int found;
+    int i;
+
+    found = 0;
+    earliest = 0;
+    for (i = 0; i < MYNEWT_VAL(NFFS_WRITE_BUF_COUNT); i++) {
+        if (nffs_wbufs[i].nwb_file != NULL &&
+            (!found ||
+             OS_TIME_TICK_LT(nffs_wbufs[i].nwb_start, earliest))) {
+
+            earliest = nffs_wbufs[i].nwb_start;
+            found = 1;
+        }
+    }
+
+    if (!found) {
+        os_callout_stop(&nffs_wbuf_timer);
+        return;
+    }
+
+    now = os_time_get();
+    ticks = (int32_t)(earliest + NFFS_WBUF_TIMEOUT_TICKS - now);
+    if (ticks < 0) {
+        ticks = 0;
+    }
+    os_callout_reset(&nffs_wbuf_timer, ticks);
+#endif
+}
+
+/**
+ * Flushes the buffers whose oldest byte has been held for at least
+ * NFFS_WRITE_BUF_TIMEOUT_MS, then re-arms the flush timer for the rest.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int
+nffs_wbuf_flush_expired(void)
+{
+    struct nffs_wbuf *wbuf;
+    os_time_t now;
+    int flush_rc;
+    int rc;
+    int i;
+
+    now = os_time_get();
+
+    rc = 0;
+    for (i = 0; i < MYNEWT_VAL(NFFS_WRITE_BUF_COUNT); i++) {
+        wbuf = nffs_wbufs + i;
+        if (wbuf->nwb_file != NULL &&
+            (os_time_t)(now - wbuf->nwb_start) >= NFFS_WBUF_TIMEOUT_TICKS) {
+
+            flush_rc = nffs_wbuf_flush_one(wbuf);
+            if (rc == 0) {
+                rc = flush_rc;
+            }
+        }
+    }
+
+    nffs_wbuf_timer_arm();
+
+    return rc;
+}
+
+/**
+ * Discards all buffered data.  This is only valid when every file handle is
+ * being invalidated as well.
+ */
+void
+nffs_wbuf_reset(void)
+{
+    memset(nffs_wbufs, 0, sizeof nffs_wbufs);
+#if MYNEWT_VAL(NFFS_WRITE_BUF_TIMEOUT_MS) > 0
+    os_callout_stop(&nffs_wbuf_timer);
+#endif
+}
+
+static int
+nffs_wbuf_alloc(struct nffs_file *file, uint32_t offset,
+                struct nffs_wbuf **out_wbuf)
+{
+    struct nffs_wbuf *oldest;
+    struct nffs_wbuf *wbuf;
+    int rc;
+    int i;
+
+    /* Use a free buffer, or take over the one that has been filling the
+     * longest.
+     */
+    wbuf = NULL;
+    oldest = nffs_wbufs;
+    for (i = 0; i < MYNEWT_VAL(NFFS_WRITE_BUF_COUNT); i++) {
+        if (nffs_wbufs[i].nwb_file == NULL) {
+            wbuf = nffs_wbufs + i;
+            break;
+        }
+        if (OS_TIME_TICK_LT(nffs_wbufs[i].nwb_start, oldest->nwb_start)) {
+            oldest = nffs_wbufs + i;
+        }
+    }
+
+    if (wbuf == NULL) {
+        rc = nffs_wbuf_flush_one(oldest);
+        if (rc != 0) {
+            return rc;
+        }
+        wbuf = oldest;
+    }
+
+    wbuf->nwb_file = file;
+    wbuf->nwb_offset = offset;
+    wbuf->nwb_start = os_time_get();
+    wbuf->nwb_len = 0;
+
+    *out_wbuf = wbuf;
+
+    return 0;
+}
+
+/**
+ * Writes data to a file through its write buffer.  Appends that fit are
+ * collected in RAM, up to the maximum data block size; anything else flushes
+ * the buffer and is written directly.
+ *
+ * @param file                  The file to write to.
+ * @param data                  The data to write.
+ * @param len                   The length of data to write.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int
+nffs_wbuf_write(struct nffs_file *file, const void *data, int len)
+{
+    struct nffs_wbuf *wbuf;
+    uint32_t capacity;
+    uint32_t flash_len;
+    uint32_t file_len;
+    int rc;
+
+    if (!(file->nf_access_flags & FS_ACCESS_WRITE)) {
+        return FS_EACCESS;
+    }
+
+    if (len == 0) {
+        return 0;
+    }
+
+    /* Data buffered through other handles is older; it goes first. */
+    rc = nffs_wbuf_flush_inode(file->nf_inode_entry, file);
+    if (rc != 0) {
+        return rc;
+    }
+
+    rc = nffs_inode_data_len(file->nf_inode_entry, &flash_len);
+    if (rc != 0) {
+        return rc;
+    }
+
+    wbuf = nffs_wbuf_find(file);
+    file_len = flash_len;
+    if (wbuf != NULL) {
+        assert(wbuf->nwb_offset == flash_len);
+        file_len += wbuf->nwb_len;
+    }
+
+    if (file->nf_access_flags & FS_ACCESS_APPEND) {
+        file->nf_offset = file_len;
+    }
+
+    capacity = MYNEWT_VAL(NFFS_WRITE_BUF_SIZE);
+    if (capacity > nffs_block_max_data_sz) {
+        capacity = nffs_block_max_data_sz;
+    }
+
+    if (file->nf_offset != file_len || len >= capacity) {
+        /* Not a small append; write through. */
+        rc = nffs_wbuf_flush_file(file);
+        if (rc != 0) {
+            return rc;
+        }
+        return nffs_write_to_file(file, data, len);
+    }
+
+    if (wbuf != NULL && wbuf->nwb_len + len > capacity) {
+        rc = nffs_wbuf_flush_one(wbuf);
+        if (rc != 0) {
+            return rc;
+        }
+        wbuf = NULL;
+    }
+
+    if (wbuf == NULL) {
+        rc = nffs_inode_data_len(file->nf_inode_entry, &flash_len);
+        if (rc != 0) {
+            return rc;
+        }
+
+        rc = nffs_wbuf_alloc(file, flash_len, &wbuf);
+        if (rc != 0) {
+            return rc;
+        }
+
+#if MYNEWT_VAL(NFFS_WRITE_BUF_TIMEOUT_MS) > 0
+        if (!os_callout_queued(&nffs_wbuf_timer)) {
+            os_callout_reset(&nffs_wbuf_timer, NFFS_WBUF_TIMEOUT_TICKS);
+        }
+#endif
+    }
+
+    memcpy(wbuf->nwb_data + wbuf->nwb_len, data, len);
+    wbuf->nwb_len += len;
+    file->nf_offset += len;
+
+    if (wbuf->nwb_len == capacity) {
+        return nffs_wbuf_flush_one(wbuf);
+    }
+
+    return 0;
+}
+
+#endif
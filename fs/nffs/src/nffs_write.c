@@ -369,6 +369,11 @@ nffs_write_chunk(struct nffs_inode_entry *inode_entry, uint32_t file_offset,
         }
     } while (data_offset > 0);
 
+    if (append_len > 0) {
+        /* The last block grew; its indexed end offset is stale. */
+        nffs_cache_index_clear(cache_inode);
+    }
+
     cache_inode->nci_file_size += append_len;
     return 0;
 }
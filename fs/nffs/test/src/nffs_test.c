@@ -108,6 +108,10 @@ TEST_CASE_DECL(nffs_test_lost_found)
 TEST_CASE_DECL(nffs_test_readdir)
 TEST_CASE_DECL(nffs_test_split_file)
 TEST_CASE_DECL(nffs_test_gc_on_oom)
+TEST_CASE_DECL(nffs_test_ckpt)
+TEST_CASE_DECL(nffs_test_gc_incremental)
+TEST_CASE_DECL(nffs_test_dir_index)
+TEST_CASE_DECL(nffs_test_bench)
 
 void
 nffs_test_suite_gen_1_1_init(void)
@@ -174,9 +178,15 @@ TEST_SUITE(nffs_test_suite)
     nffs_test_readdir();
     nffs_test_split_file();
     nffs_test_gc_on_oom();
+    nffs_test_ckpt();
+    nffs_test_gc_incremental();
+    nffs_test_dir_index();
+    nffs_test_bench();
 }
 
 TEST_CASE_DECL(nffs_test_cache_large_file)
+TEST_CASE_DECL(nffs_test_cache_index)
+TEST_CASE_DECL(nffs_test_cache_lru)
 
 TEST_SUITE(nffs_suite_cache)
 {
@@ -186,6 +196,8 @@ TEST_SUITE(nffs_suite_cache)
     TEST_ASSERT(rc == 0);
 
     nffs_test_cache_large_file();
+    nffs_test_cache_index();
+    nffs_test_cache_lru();
 }
 
 void
@@ -406,12 +418,6 @@ print_nffs_flash_areas(int verbose)
     }
 }
 
-static int
-nffs_hash_fn(uint32_t id)
-{
-    return id % NFFS_HASH_SIZE;
-}
-
 void
 print_hashlist(struct nffs_hash_entry *he)
 {
@@ -687,7 +693,7 @@ print_hash_entries(int verbose)
     struct nffs_hash_entry *next;
 
     printf("\nnffs_hash_entries:\n");
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
+    for (i = 0; i < nffs_hash_size; i++) {
         he = SLIST_FIRST(nffs_hash + i);
         while (he != NULL) {
             next = SLIST_NEXT(he, nhe_next);
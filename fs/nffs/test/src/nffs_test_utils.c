@@ -475,6 +475,7 @@ nffs_test_assert_child_inode_present(struct nffs_inode_entry *child)
     const struct nffs_inode_entry *inode_entry;
     const struct nffs_inode_entry *parent;
     struct nffs_inode inode;
+    uint8_t name_hash;
     int rc;
 
     /*
@@ -483,6 +484,13 @@ nffs_test_assert_child_inode_present(struct nffs_inode_entry *child)
     rc = nffs_inode_from_entry(&inode, child);
     TEST_ASSERT(rc == 0);
 
+    /*
+     * RAM name index agrees with the filename in flash
+     */
+    rc = nffs_inode_filename_hash(&inode, &name_hash);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(child->nie_name_hash == name_hash);
+
     /*
      * Validate parent
      */
@@ -0,0 +1,66 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "nffs_test_utils.h"
+
+/* Not a functional test; reports the cost of common file operations. */
+TEST_CASE(nffs_test_bench)
+{
+    struct fs_file *file;
+    uint8_t buf[128];
+    uint32_t bytes_read;
+    int rc;
+    int i;
+
+    rc = nffs_format(nffs_current_area_descs);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < sizeof buf; i++) {
+        buf[i] = i;
+    }
+
+    rc = fs_open("/bench", FS_ACCESS_WRITE | FS_ACCESS_APPEND, &file);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_BENCH_BEGIN("append_128", 200) {
+        rc = fs_write(file, buf, sizeof buf);
+        TEST_ASSERT_FATAL(rc == 0);
+    } TEST_BENCH_END();
+    rc = fs_close(file);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    TEST_BENCH_BEGIN("open_close", 200) {
+        rc = fs_open("/bench", FS_ACCESS_READ, &file);
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = fs_close(file);
+        TEST_ASSERT_FATAL(rc == 0);
+    } TEST_BENCH_END();
+
+    rc = fs_open("/bench", FS_ACCESS_READ, &file);
+    TEST_ASSERT_FATAL(rc == 0);
+    i = 0;
+    TEST_BENCH_BEGIN("seek_read_128", 200) {
+        /* Stride through the file so reads do not hit the same block. */
+        i = (i + 37) % 200;
+        rc = fs_seek(file, i * sizeof buf);
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = fs_read(file, sizeof buf, buf, &bytes_read);
+        TEST_ASSERT_FATAL(rc == 0 && bytes_read == sizeof buf);
+    } TEST_BENCH_END();
+    rc = fs_close(file);
+    TEST_ASSERT_FATAL(rc == 0);
+}
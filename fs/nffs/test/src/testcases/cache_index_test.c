@@ -0,0 +1,88 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "nffs_test_utils.h"
+
+TEST_CASE(nffs_test_cache_index)
+{
+    static char data[NFFS_BLOCK_MAX_DATA_SZ_MAX * 24];
+    static const uint8_t order[] = {
+        20, 3, 17, 9, 23, 0, 12, 5, 21, 14, 1, 18, 7, 11, 22, 2,
+    };
+    struct fs_file *file;
+    uint32_t off;
+    uint8_t b;
+    int rc;
+    int i;
+
+    /*** Setup. */
+    rc = nffs_format(nffs_current_area_descs);
+    TEST_ASSERT(rc == 0);
+
+    for (i = 0; i < sizeof data; i++) {
+        data[i] = i * 7;
+    }
+
+    nffs_test_util_create_file("/myfile.txt", data, sizeof data);
+    nffs_cache_clear();
+
+    rc = fs_open("/myfile.txt", FS_ACCESS_READ | FS_ACCESS_WRITE, &file);
+    TEST_ASSERT(rc == 0);
+
+    /* Seek around the file out of order; each non-adjacent seek replaces the
+     * cache with the single requested block.
+     */
+    for (i = 0; i < sizeof order; i++) {
+        off = nffs_block_max_data_sz * order[i] + i;
+
+        rc = fs_seek(file, off);
+        TEST_ASSERT(rc == 0);
+        rc = fs_read(file, 1, &b, NULL);
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(b == (uint8_t)data[off]);
+    }
+
+    /* Extend the last block and ensure reads are still correct. */
+    rc = fs_seek(file, sizeof data - 1);
+    TEST_ASSERT(rc == 0);
+    b = 0xab;
+    rc = fs_write(file, &b, 1);
+    TEST_ASSERT(rc == 0);
+    rc = fs_write(file, &b, 1);
+    TEST_ASSERT(rc == 0);
+
+    for (i = sizeof order - 1; i >= 0; i--) {
+        off = nffs_block_max_data_sz * order[i];
+
+        rc = fs_seek(file, off);
+        TEST_ASSERT(rc == 0);
+        rc = fs_read(file, 1, &b, NULL);
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(b == (uint8_t)data[off]);
+    }
+
+    rc = fs_seek(file, sizeof data);
+    TEST_ASSERT(rc == 0);
+    rc = fs_read(file, 1, &b, NULL);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(b == 0xab);
+
+    rc = fs_close(file);
+    TEST_ASSERT(rc == 0);
+}
@@ -0,0 +1,52 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "nffs_test_utils.h"
+
+TEST_CASE(nffs_test_cache_lru)
+{
+    char filename[16];
+    int rc;
+    int i;
+
+    /*** Setup. */
+    rc = nffs_format(nffs_current_area_descs);
+    TEST_ASSERT(rc == 0);
+
+    /* One more file than there are cached inodes. */
+    TEST_ASSERT_FATAL(nffs_config.nc_num_cache_inodes == 4);
+    for (i = 0; i < 5; i++) {
+        sprintf(filename, "/file%d.txt", i);
+        nffs_test_util_create_file(filename, "abcd", 4);
+    }
+    nffs_cache_clear();
+
+    /* Cache files 0-3, then use file 0 again. */
+    for (i = 0; i < 4; i++) {
+        sprintf(filename, "/file%d.txt", i);
+        nffs_test_util_assert_contents(filename, "abcd", 4);
+    }
+    nffs_test_util_assert_contents("/file0.txt", "abcd", 4);
+
+    /* Caching file 4 evicts the least recently used inode: file 1. */
+    nffs_test_util_assert_contents("/file4.txt", "abcd", 4);
+    nffs_test_util_assert_cache_range("/file0.txt", 0, 4);
+    nffs_test_util_assert_cache_range("/file4.txt", 0, 4);
+    nffs_test_util_assert_cache_range("/file1.txt", 0, 0);
+}
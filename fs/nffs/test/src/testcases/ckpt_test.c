@@ -0,0 +1,151 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "nffs_test_utils.h"
+
+static uint32_t
+nffs_test_ckpt_first_word(const struct nffs_area_desc *area_desc)
+{
+    uint32_t word;
+    int rc;
+
+    rc = hal_flash_read(area_desc->nad_flash_id, area_desc->nad_offset,
+                        &word, sizeof word);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    return word;
+}
+
+TEST_CASE(nffs_test_ckpt)
+{
+    int rc;
+
+    static const struct nffs_area_desc area_descs[] = {
+        { 0x00020000, 128 * 1024 },
+        { 0x00040000, 128 * 1024 },
+        { 0x00060000, 128 * 1024 },
+        { 0, 0 },
+    };
+
+    static const struct nffs_area_desc ckpt_desc = {
+        0x000a0000, 128 * 1024
+    };
+
+    struct nffs_test_file_desc *expected_ckpt =
+        (struct nffs_test_file_desc[]) { {
+            .filename = "",
+            .is_dir = 1,
+            .children = (struct nffs_test_file_desc[]) { {
+                .filename = "b.txt",
+                .contents = "bbbb",
+                .contents_len = 4,
+            }, {
+                .filename = "dir",
+                .is_dir = 1,
+                .children = (struct nffs_test_file_desc[]) { {
+                    .filename = "a.txt",
+                    .contents = "aaaaaaaaaaaa",
+                    .contents_len = 12,
+                }, {
+                    .filename = "c.txt",
+                    .contents = "c",
+                    .contents_len = 1,
+                }, {
+                    .filename = NULL,
+                } },
+            }, {
+                .filename = NULL,
+            } },
+    } };
+
+    struct nffs_test_file_desc *expected_replay =
+        (struct nffs_test_file_desc[]) { {
+            .filename = "",
+            .is_dir = 1,
+            .children = (struct nffs_test_file_desc[]) { {
+                .filename = "b.txt",
+                .contents = "bbbbBB",
+                .contents_len = 6,
+            }, {
+                .filename = "d.txt",
+                .contents = "dd",
+                .contents_len = 2,
+            }, {
+                .filename = "dir",
+                .is_dir = 1,
+                .children = (struct nffs_test_file_desc[]) { {
+                    .filename = "a.txt",
+                    .contents = "aaaaaaaaaaaa",
+                    .contents_len = 12,
+                }, {
+                    .filename = NULL,
+                } },
+            }, {
+                .filename = NULL,
+            } },
+    } };
+
+    rc = nffs_ckpt_set_area(&ckpt_desc);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = nffs_format(area_descs);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(nffs_test_ckpt_first_word(&ckpt_desc) == 0xffffffff);
+
+    rc = fs_mkdir("/dir");
+    TEST_ASSERT_FATAL(rc == 0);
+    nffs_test_util_create_file("/dir/a.txt", "aaaa", 4);
+    nffs_test_util_append_file("/dir/a.txt", "aaaa", 4);
+    nffs_test_util_append_file("/dir/a.txt", "aaaa", 4);
+    nffs_test_util_create_file("/dir/c.txt", "c", 1);
+    nffs_test_util_create_file("/b.txt", "bbbb", 4);
+
+    /*** Restore from a checkpoint with nothing written after it. */
+    rc = nffs_ckpt_write();
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(nffs_test_ckpt_first_word(&ckpt_desc) != 0xffffffff);
+
+    rc = nffs_misc_reset();
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = nffs_detect(area_descs);
+    TEST_ASSERT_FATAL(rc == 0);
+    nffs_test_assert_system_once(expected_ckpt);
+
+    /*** Restore from a checkpoint followed by newer objects. */
+    rc = nffs_ckpt_write();
+    TEST_ASSERT_FATAL(rc == 0);
+
+    nffs_test_util_append_file("/b.txt", "BB", 2);
+    nffs_test_util_create_file("/d.txt", "dd", 2);
+    rc = fs_unlink("/dir/c.txt");
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = nffs_misc_reset();
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = nffs_detect(area_descs);
+    TEST_ASSERT_FATAL(rc == 0);
+    nffs_test_assert_system_once(expected_replay);
+
+    /*** Garbage collection invalidates the checkpoint. */
+    nffs_test_assert_system(expected_replay, area_descs);
+    TEST_ASSERT(nffs_test_ckpt_first_word(&ckpt_desc) == 0xffffffff);
+
+    rc = nffs_ckpt_set_area(NULL);
+    TEST_ASSERT(rc == 0);
+}
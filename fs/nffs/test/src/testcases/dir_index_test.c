@@ -0,0 +1,112 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include "nffs_test_utils.h"
+
+TEST_CASE(nffs_test_dir_index)
+{
+    struct fs_file *file;
+    char path[32];
+    int rc;
+    int i;
+
+    /*** Setup. */
+    rc = nffs_format(nffs_current_area_descs);
+    TEST_ASSERT(rc == 0);
+
+    rc = fs_mkdir("/dir");
+    TEST_ASSERT(rc == 0);
+
+    for (i = 0; i < 40; i++) {
+        sprintf(path, "/dir/file%d.txt", i);
+        nffs_test_util_create_file(path, path, strlen(path));
+    }
+
+    /* Every child is found through the name index. */
+    for (i = 0; i < 40; i++) {
+        sprintf(path, "/dir/file%d.txt", i);
+        nffs_test_util_assert_contents(path, path, strlen(path));
+    }
+
+    rc = fs_open("/dir/file40.txt", FS_ACCESS_READ, &file);
+    TEST_ASSERT(rc == FS_ENOENT);
+    rc = fs_open("/dir/file1", FS_ACCESS_READ, &file);
+    TEST_ASSERT(rc == FS_ENOENT);
+
+    /* Rename within the directory; only the new name must resolve. */
+    rc = fs_rename("/dir/file7.txt", "/dir/a_renamed.txt");
+    TEST_ASSERT(rc == 0);
+    rc = fs_open("/dir/file7.txt", FS_ACCESS_READ, &file);
+    TEST_ASSERT(rc == FS_ENOENT);
+    nffs_test_util_assert_contents("/dir/a_renamed.txt", "/dir/file7.txt",
+                                   strlen("/dir/file7.txt"));
+
+    /* Move into another directory. */
+    rc = fs_rename("/dir/file8.txt", "/file8.txt");
+    TEST_ASSERT(rc == 0);
+    nffs_test_util_assert_contents("/file8.txt", "/dir/file8.txt",
+                                   strlen("/dir/file8.txt"));
+
+    /* Unlink. */
+    for (i = 9; i < 40; i++) {
+        sprintf(path, "/dir/file%d.txt", i);
+        rc = fs_unlink(path);
+        TEST_ASSERT(rc == 0);
+        rc = fs_open(path, FS_ACCESS_READ, &file);
+        TEST_ASSERT(rc == FS_ENOENT);
+    }
+
+    struct nffs_test_file_desc *expected_system =
+        (struct nffs_test_file_desc[]) { {
+            .filename = "",
+            .is_dir = 1,
+            .children = (struct nffs_test_file_desc[]) { {
+                .filename = "dir",
+                .is_dir = 1,
+                .children = (struct nffs_test_file_desc[]) {
+                    { "file0.txt", .contents = "/dir/file0.txt",
+                      .contents_len = 14 },
+                    { "file1.txt", .contents = "/dir/file1.txt",
+                      .contents_len = 14 },
+                    { "file2.txt", .contents = "/dir/file2.txt",
+                      .contents_len = 14 },
+                    { "file3.txt", .contents = "/dir/file3.txt",
+                      .contents_len = 14 },
+                    { "file4.txt", .contents = "/dir/file4.txt",
+                      .contents_len = 14 },
+                    { "file5.txt", .contents = "/dir/file5.txt",
+                      .contents_len = 14 },
+                    { "file6.txt", .contents = "/dir/file6.txt",
+                      .contents_len = 14 },
+                    { "a_renamed.txt", .contents = "/dir/file7.txt",
+                      .contents_len = 14 },
+                    { NULL },
+                },
+            }, {
+                .filename = "file8.txt",
+                .contents = "/dir/file8.txt",
+                .contents_len = 14,
+            }, {
+                .filename = NULL,
+            } },
+    } };
+
+    nffs_test_assert_system(expected_system, nffs_current_area_descs);
+}
@@ -0,0 +1,131 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "nffs_test_utils.h"
+
+static uint32_t
+nffs_test_gc_writable_space(void)
+{
+    uint32_t space;
+    int i;
+
+    space = 0;
+    for (i = 0; i < nffs_num_areas; i++) {
+        if (nffs_gc_area_is_writable(i)) {
+            space += nffs_area_free_space(nffs_areas + i);
+        }
+    }
+
+    return space;
+}
+
+TEST_CASE(nffs_test_gc_incremental)
+{
+    static char data[1000];
+    unsigned int gc_count;
+    int more;
+    int rc;
+    int i;
+
+    static const struct nffs_area_desc area_descs[] = {
+        { 0x00000000, 16 * 1024 },
+        { 0x00004000, 16 * 1024 },
+        { 0x00008000, 16 * 1024 },
+        { 0, 0 },
+    };
+
+    struct nffs_test_file_desc *expected_system =
+        (struct nffs_test_file_desc[]) { {
+            .filename = "",
+            .is_dir = 1,
+            .children = (struct nffs_test_file_desc[]) { {
+                .filename = "log.txt",
+                .contents = data,
+                .contents_len = sizeof data,
+            }, {
+                .filename = "new.txt",
+                .contents = "abc",
+                .contents_len = 3,
+            }, {
+                .filename = NULL,
+            } },
+    } };
+
+    rc = nffs_format(area_descs);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /*** Plenty of free space; no cycle is started. */
+    gc_count = nffs_gc_count;
+    rc = nffs_gc_step(0, &more);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(more == 0);
+    TEST_ASSERT(nffs_gc_count == gc_count);
+
+    /*** Fill the reserve with garbage without forcing a collection. */
+    i = 0;
+    while (nffs_test_gc_writable_space() >=
+           MYNEWT_VAL(NFFS_GC_INCREMENTAL_THRESH)) {
+
+        memset(data, '0' + i % 10, sizeof data);
+        nffs_test_util_create_file("/log.txt", data, sizeof data);
+        i++;
+    }
+    TEST_ASSERT(nffs_gc_count == gc_count);
+
+    /*** Run the cycle one bucket at a time with a write in between. */
+    rc = nffs_gc_step(0, &more);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT_FATAL(more == 1);
+    TEST_ASSERT(nffs_gc_in_progress());
+    TEST_ASSERT(nffs_gc_count == gc_count);
+
+    nffs_test_util_create_file("/new.txt", "abc", 3);
+    TEST_ASSERT(nffs_gc_count == gc_count);
+
+    while (more) {
+        rc = nffs_gc_step(0, &more);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    TEST_ASSERT(!nffs_gc_in_progress());
+    TEST_ASSERT(nffs_gc_count == gc_count + 1);
+
+    nffs_test_assert_system(expected_system, area_descs);
+
+    /*** A full collection completes a cycle that is under way. */
+    for (i = 0; i < 4; i++) {
+        nffs_test_util_create_file("/log.txt", data, sizeof data);
+    }
+    while (nffs_test_gc_writable_space() >=
+           MYNEWT_VAL(NFFS_GC_INCREMENTAL_THRESH)) {
+
+        nffs_test_util_create_file("/log.txt", data, sizeof data);
+    }
+
+    gc_count = nffs_gc_count;
+    rc = nffs_gc_step(0, &more);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT_FATAL(more == 1);
+
+    rc = nffs_gc(NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(!nffs_gc_in_progress());
+    TEST_ASSERT(nffs_gc_count == gc_count + 1);
+
+    nffs_test_assert_system(expected_system, area_descs);
+}
@@ -31,6 +31,12 @@ extern "C" {
 #define sec_bss_core    __attribute__((section(".bss.core")))
 #define sec_bss_nz_core __attribute__((section(".bss.core.nz")))
 
+/*
+ * Core sections above are in DTCM. Code in sec_text_itcm runs from ITCM,
+ * copied there at startup.
+ */
+#define sec_text_itcm   __attribute__((section(".itcm")))
+
 /* More convenient section placement macros. */
 #define bssnz_t         sec_bss_nz_core
 
@@ -63,6 +63,7 @@
   * @{
   */
 
+#include "syscfg/syscfg.h"
 #include "stm32f7xx.h"
 #include "bsp/cmsis_nvic.h"
 
@@ -177,6 +178,14 @@ void SystemInit(void)
 
   /* Relocate the vector table */
   NVIC_Relocate();
+
+  /* Enable caches; both are invalidated before being turned on */
+#if MYNEWT_VAL(STM32_ENABLE_ICACHE)
+  SCB_EnableICache();
+#endif
+#if MYNEWT_VAL(STM32_ENABLE_DCACHE)
+  SCB_EnableDCache();
+#endif
 }
 
 /**
@@ -122,6 +122,35 @@ LoopFillZeroCoreBss:
   cmp   r2, r3
   bcc   FillZeroCoreBss
 
+/*
+ * mynewt specific coredata (DTCM) and ITCM code copying.
+ */
+  ldr   r0, =__coredata_start__
+  ldr   r1, =__coredata_end__
+  ldr   r2, =__coredata_load__
+  b     LoopCopyCoreData
+
+CopyCoreData:
+  ldr   r3, [r2], #4
+  str   r3, [r0], #4
+
+LoopCopyCoreData:
+  cmp   r0, r1
+  bcc   CopyCoreData
+
+  ldr   r0, =__itcm_start__
+  ldr   r1, =__itcm_end__
+  ldr   r2, =__itcm_load__
+  b     LoopCopyItcm
+
+CopyItcm:
+  ldr   r3, [r2], #4
+  str   r3, [r0], #4
+
+LoopCopyItcm:
+  cmp   r0, r1
+  bcc   CopyItcm
+
 /* Call the clock system initialization function.*/
   bl  SystemInit
 /* Call the libc entry point.*/
@@ -0,0 +1,73 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __ADC_NRF52_H__
+#define __ADC_NRF52_H__
+
+#include <adc/adc.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of SAADC channels */
+#define NRF52_ADC_CHANNELS  8
+
+/**
+ * Channel configuration, passed to adc_chan_config().  Values are those of
+ * the SAADC CH[n].PSELP and CH[n].CONFIG register fields.
+ */
+struct nrf52_adc_chan_cfg {
+    /* SAADC_CH_PSELP_PSELP_AnalogInput0..7, or SAADC_CH_PSELP_PSELP_VDD */
+    uint8_t nac_pin;
+    /* SAADC_CH_CONFIG_GAIN_Gain1_6..Gain4 */
+    uint8_t nac_gain;
+    /* SAADC_CH_CONFIG_REFSEL_Internal or SAADC_CH_CONFIG_REFSEL_VDD1_4 */
+    uint8_t nac_refsel;
+    /* SAADC_CH_CONFIG_TACQ_3us..40us */
+    uint8_t nac_tacq;
+};
+
+struct nrf52_adc_dev_cfg {
+    /* SAADC_RESOLUTION_VAL_8bit..14bit */
+    uint8_t nadc_resolution;
+    /* Supply voltage in mV, used to scale channels with a VDD/4 reference */
+    uint16_t nadc_vddmv;
+    /* Compare value of the SAADC sample timer, 16MHz / sample rate, in the
+     * range 80-2047.  The sample timer can only be used with a single
+     * channel configured; with 0, samples are instead triggered by the
+     * SAADC SAMPLE task.
+     */
+    uint16_t nadc_sample_cc;
+    /* With nadc_sample_cc 0, an event register, e.g. a TIMER's
+     * EVENTS_COMPARE[n], connected to the SAMPLE task through PPI while
+     * sampling; NULL to trigger samples some other way.
+     */
+    volatile uint32_t *nadc_sample_event;
+    /* NRF52_ADC_CHANNELS channel structures */
+    struct adc_chan_config *nadc_chans;
+};
+
+int nrf52_adc_dev_init(struct os_dev *, void *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ADC_NRF52_H__ */
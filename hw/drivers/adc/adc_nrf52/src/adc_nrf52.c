@@ -0,0 +1,526 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <os/os.h>
+#include <bsp/cmsis_nvic.h>
+#include "nrf.h"
+#include "mcu/nrf52_hal.h"
+#include "adc_nrf52/adc_nrf52.h"
+
+/* Full scale of the SAADC is the reference divided by the gain */
+static const struct {
+    uint8_t num;
+    uint8_t den;
+} nrf52_adc_gains[] = {
+    [SAADC_CH_CONFIG_GAIN_Gain1_6] = { 6, 1 },
+    [SAADC_CH_CONFIG_GAIN_Gain1_5] = { 5, 1 },
+    [SAADC_CH_CONFIG_GAIN_Gain1_4] = { 4, 1 },
+    [SAADC_CH_CONFIG_GAIN_Gain1_3] = { 3, 1 },
+    [SAADC_CH_CONFIG_GAIN_Gain1_2] = { 2, 1 },
+    [SAADC_CH_CONFIG_GAIN_Gain1]   = { 1, 1 },
+    [SAADC_CH_CONFIG_GAIN_Gain2]   = { 1, 2 },
+    [SAADC_CH_CONFIG_GAIN_Gain4]   = { 1, 4 },
+};
+
+/* Internal reference voltage, in mV */
+#define NRF52_ADC_REF_INTERNAL_MV   600
+
+/*
+ * State of the single SAADC.  The SAADC latches its next result pointer
+ * once it has started filling the current buffer, so with two buffers set
+ * it alternates between them: as one fills, it is handed to the event
+ * handler, and the SAADC restarts on the other.  The restart is done by
+ * PPI from the END event when a channel is free, so that it doesn't wait
+ * for the interrupt handler.
+ */
+static struct {
+    struct adc_dev *dev;
+    int16_t *bufs[2];
+    uint16_t buf_samples;
+    /* Index of the buffer being filled */
+    uint8_t active;
+    uint8_t running;
+    uint8_t first;
+    /* PPI channels restarting the SAADC and triggering samples, -1 if none */
+    int8_t ppi_restart;
+    int8_t ppi_sample;
+} nrf52_adc;
+
+struct nrf52_adc_stats {
+    uint16_t adc_events;
+    uint16_t adc_error;
+};
+
+static struct nrf52_adc_stats nrf52_adc_stats;
+
+static void
+nrf52_adc_irq_handler(void)
+{
+    struct nrf52_adc_dev_cfg *cfg;
+    struct adc_dev *dev;
+    int16_t *buf;
+    int rc;
+
+    dev = nrf52_adc.dev;
+    cfg = (struct nrf52_adc_dev_cfg *)dev->ad_dev.od_init_arg;
+
+    if (NRF_SAADC->EVENTS_STARTED) {
+        NRF_SAADC->EVENTS_STARTED = 0;
+
+        if (nrf52_adc.bufs[1]) {
+            NRF_SAADC->RESULT.PTR =
+                (uint32_t)nrf52_adc.bufs[nrf52_adc.active ^ 1];
+        }
+        if (nrf52_adc.first && cfg->nadc_sample_cc) {
+            /* Starts the sample timer */
+            NRF_SAADC->TASKS_SAMPLE = 1;
+        }
+        nrf52_adc.first = 0;
+    }
+
+    if (NRF_SAADC->EVENTS_END) {
+        NRF_SAADC->EVENTS_END = 0;
+        ++nrf52_adc_stats.adc_events;
+
+        buf = nrf52_adc.bufs[nrf52_adc.active];
+        if (nrf52_adc.running && nrf52_adc.bufs[1]) {
+            nrf52_adc.active ^= 1;
+            if (nrf52_adc.ppi_restart < 0) {
+                NRF_SAADC->TASKS_START = 1;
+            }
+        } else {
+            nrf52_adc.running = 0;
+        }
+
+        if (dev->ad_event_handler_func) {
+            rc = dev->ad_event_handler_func(dev, dev->ad_event_handler_arg,
+                    ADC_EVENT_RESULT, buf,
+                    nrf52_adc.buf_samples * sizeof(int16_t));
+            if (rc) {
+                ++nrf52_adc_stats.adc_error;
+            }
+        }
+    }
+}
+
+/**
+ * Open the nRF52 SAADC device
+ *
+ * This function locks the device for access from other tasks.
+ *
+ * @param odev The OS device to open
+ * @param wait The time in MS to wait.  If 0 specified, returns immediately
+ *             if resource unavailable.  If OS_WAIT_FOREVER specified, blocks
+ *             until resource is available.
+ * @param arg  Argument provided by higher layer to open.
+ *
+ * @return 0 on success, non-zero on failure.
+ */
+static int
+nrf52_adc_open(struct os_dev *odev, uint32_t wait, void *arg)
+{
+    struct nrf52_adc_dev_cfg *cfg;
+    struct adc_dev *dev;
+    int rc;
+
+    assert(odev);
+    rc = OS_OK;
+    dev = (struct adc_dev *) odev;
+
+    if (os_started()) {
+        rc = os_mutex_pend(&dev->ad_lock, wait);
+        if (rc != OS_OK) {
+            goto err;
+        }
+    }
+
+    if (odev->od_flags & OS_DEV_F_STATUS_OPEN) {
+        os_mutex_release(&dev->ad_lock);
+        rc = OS_EBUSY;
+        goto err;
+    }
+
+    cfg = (struct nrf52_adc_dev_cfg *)dev->ad_dev.od_init_arg;
+
+    nrf52_adc.dev = dev;
+
+    NRF_SAADC->RESOLUTION = cfg->nadc_resolution;
+    NRF_SAADC->INTENCLR = 0xFFFFFFFF;
+    NRF_SAADC->ENABLE = SAADC_ENABLE_ENABLE_Enabled;
+
+    NVIC_SetVector(SAADC_IRQn, (uint32_t)nrf52_adc_irq_handler);
+    NVIC_ClearPendingIRQ(SAADC_IRQn);
+    NVIC_EnableIRQ(SAADC_IRQn);
+
+    return (OS_OK);
+err:
+    return (rc);
+}
+
+static int nrf52_adc_sample_stop(struct adc_dev *);
+
+/**
+ * Close the nRF52 SAADC device.
+ *
+ * This function unlocks the device.
+ *
+ * @param odev The device to close.
+ */
+static int
+nrf52_adc_close(struct os_dev *odev)
+{
+    struct adc_dev *dev;
+
+    dev = (struct adc_dev *) odev;
+
+    nrf52_adc_sample_stop(dev);
+
+    NVIC_DisableIRQ(SAADC_IRQn);
+    NRF_SAADC->ENABLE = SAADC_ENABLE_ENABLE_Disabled;
+
+    if (os_started()) {
+        os_mutex_release(&dev->ad_lock);
+    }
+
+    return (OS_OK);
+}
+
+/**
+ * Configure an ADC channel on the nRF52 SAADC.
+ *
+ * @param dev The ADC device to configure
+ * @param cnum The channel on the ADC device to configure
+ * @param cfgdata An opaque pointer to channel config, expected to be
+ *                a struct nrf52_adc_chan_cfg
+ *
+ * @return 0 on success, non-zero on failure.
+ */
+static int
+nrf52_adc_configure_channel(struct adc_dev *dev, uint8_t cnum,
+        void *cfgdata)
+{
+    struct nrf52_adc_chan_cfg *chan_cfg;
+    struct nrf52_adc_dev_cfg *cfg;
+    uint32_t refmv;
+
+    if (cnum >= NRF52_ADC_CHANNELS || cfgdata == NULL || nrf52_adc.running) {
+        return (OS_EINVAL);
+    }
+
+    cfg = (struct nrf52_adc_dev_cfg *)dev->ad_dev.od_init_arg;
+    chan_cfg = cfgdata;
+
+    if (chan_cfg->nac_gain > SAADC_CH_CONFIG_GAIN_Gain4) {
+        return (OS_EINVAL);
+    }
+
+    NRF_SAADC->CH[cnum].PSELN = SAADC_CH_PSELN_PSELN_NC;
+    NRF_SAADC->CH[cnum].CONFIG =
+        (chan_cfg->nac_gain << SAADC_CH_CONFIG_GAIN_Pos) |
+        (chan_cfg->nac_refsel << SAADC_CH_CONFIG_REFSEL_Pos) |
+        (chan_cfg->nac_tacq << SAADC_CH_CONFIG_TACQ_Pos) |
+        (SAADC_CH_CONFIG_MODE_SE << SAADC_CH_CONFIG_MODE_Pos);
+    NRF_SAADC->CH[cnum].PSELP = chan_cfg->nac_pin;
+
+    if (chan_cfg->nac_refsel == SAADC_CH_CONFIG_REFSEL_Internal) {
+        refmv = NRF52_ADC_REF_INTERNAL_MV;
+    } else {
+        refmv = cfg->nadc_vddmv / 4;
+    }
+    refmv = refmv * nrf52_adc_gains[chan_cfg->nac_gain].num /
+            nrf52_adc_gains[chan_cfg->nac_gain].den;
+
+    dev->ad_chans[cnum].c_res = 8 + 2 * cfg->nadc_resolution;
+    dev->ad_chans[cnum].c_refmv = refmv;
+    dev->ad_chans[cnum].c_configured = 1;
+    dev->ad_chans[cnum].c_cnum = cnum;
+
+    return (OS_OK);
+}
+
+/**
+ * Set buffer to read data into.  Implementation of setbuffer handler.
+ * Samples of all configured channels are stored in channel order, as
+ * signed 16-bit values.  With a secondary buffer, sampling alternates
+ * between the two buffers until stopped.
+ */
+static int
+nrf52_adc_set_buffer(struct adc_dev *dev, void *buf1, void *buf2,
+        int buflen)
+{
+    assert(dev != NULL && buf1 != NULL);
+
+    if (nrf52_adc.running) {
+        return (OS_EBUSY);
+    }
+
+    nrf52_adc.bufs[0] = buf1;
+    nrf52_adc.bufs[1] = buf2;
+    nrf52_adc.buf_samples = buflen / sizeof(int16_t);
+
+    return (OS_OK);
+}
+
+/**
+ * Buffers are used in turn, there is nothing to do until the released
+ * buffer comes round again.
+ */
+static int
+nrf52_adc_release_buffer(struct adc_dev *dev, void *buf, int buf_len)
+{
+    assert(dev);
+
+    return (OS_OK);
+}
+
+/**
+ * Start sampling into the buffers set by nrf52_adc_set_buffer().  Samples
+ * are paced by the SAADC sample timer if configured, by the configured
+ * sample event, or otherwise by triggers of the SAMPLE task.
+ *
+ * @param ADC device structure
+ * @return OS_OK on success, non OS_OK on failure
+ */
+static int
+nrf52_adc_sample(struct adc_dev *dev)
+{
+    struct nrf52_adc_dev_cfg *cfg;
+
+    assert(dev);
+    cfg = (struct nrf52_adc_dev_cfg *)dev->ad_dev.od_init_arg;
+
+    if (nrf52_adc.running) {
+        return (OS_EBUSY);
+    }
+    if (!nrf52_adc.bufs[0] || !nrf52_adc.buf_samples) {
+        return (OS_EINVAL);
+    }
+
+    if (cfg->nadc_sample_cc) {
+        NRF_SAADC->SAMPLERATE =
+            (cfg->nadc_sample_cc << SAADC_SAMPLERATE_CC_Pos) |
+            (SAADC_SAMPLERATE_MODE_Timers << SAADC_SAMPLERATE_MODE_Pos);
+    } else {
+        NRF_SAADC->SAMPLERATE =
+            SAADC_SAMPLERATE_MODE_Task << SAADC_SAMPLERATE_MODE_Pos;
+    }
+
+    if (cfg->nadc_sample_event) {
+        nrf52_adc.ppi_sample = nrf52_ppi_alloc();
+        if (nrf52_adc.ppi_sample < 0) {
+            return (OS_ENOMEM);
+        }
+        nrf52_ppi_connect(nrf52_adc.ppi_sample, cfg->nadc_sample_event,
+                          &NRF_SAADC->TASKS_SAMPLE);
+        nrf52_ppi_enable(nrf52_adc.ppi_sample);
+    }
+    if (nrf52_adc.bufs[1]) {
+        /* Without a free channel the interrupt handler restarts instead */
+        nrf52_adc.ppi_restart = nrf52_ppi_alloc();
+        if (nrf52_adc.ppi_restart >= 0) {
+            nrf52_ppi_connect(nrf52_adc.ppi_restart, &NRF_SAADC->EVENTS_END,
+                              &NRF_SAADC->TASKS_START);
+            nrf52_ppi_enable(nrf52_adc.ppi_restart);
+        }
+    }
+
+    nrf52_adc.active = 0;
+    nrf52_adc.first = 1;
+    nrf52_adc.running = 1;
+
+    NRF_SAADC->RESULT.PTR = (uint32_t)nrf52_adc.bufs[0];
+    NRF_SAADC->RESULT.MAXCNT = nrf52_adc.buf_samples;
+
+    NRF_SAADC->EVENTS_STARTED = 0;
+    NRF_SAADC->EVENTS_END = 0;
+    NRF_SAADC->INTENSET = SAADC_INTENSET_STARTED_Msk | SAADC_INTENSET_END_Msk;
+    NRF_SAADC->TASKS_START = 1;
+
+    return (OS_OK);
+}
+
+/**
+ * Stop sampling started by nrf52_adc_sample().
+ *
+ * @param ADC device structure
+ * @return OS_OK on success, non OS_OK on failure
+ */
+static int
+nrf52_adc_sample_stop(struct adc_dev *dev)
+{
+    NRF_SAADC->INTENCLR = SAADC_INTENCLR_STARTED_Msk | SAADC_INTENCLR_END_Msk;
+    nrf52_adc.running = 0;
+
+    if (nrf52_adc.ppi_restart >= 0) {
+        nrf52_ppi_free(nrf52_adc.ppi_restart);
+        nrf52_adc.ppi_restart = -1;
+    }
+    if (nrf52_adc.ppi_sample >= 0) {
+        nrf52_ppi_free(nrf52_adc.ppi_sample);
+        nrf52_adc.ppi_sample = -1;
+    }
+
+    NRF_SAADC->EVENTS_STOPPED = 0;
+    NRF_SAADC->TASKS_STOP = 1;
+    while (!NRF_SAADC->EVENTS_STOPPED) {
+    }
+    NRF_SAADC->EVENTS_STOPPED = 0;
+
+    NRF_SAADC->SAMPLERATE =
+        SAADC_SAMPLERATE_MODE_Task << SAADC_SAMPLERATE_MODE_Pos;
+    NRF_SAADC->EVENTS_STARTED = 0;
+    NRF_SAADC->EVENTS_END = 0;
+    NVIC_ClearPendingIRQ(SAADC_IRQn);
+
+    return (OS_OK);
+}
+
+/**
+ * Blocking read of an ADC channel, returns result as an integer.  Not
+ * available while sampling.
+ *
+ * @param1 ADC device structure
+ * @param2 channel number
+ * @param3 ADC result ptr
+ */
+static int
+nrf52_adc_read_channel(struct adc_dev *dev, uint8_t cnum, int *result)
+{
+    uint32_t pselp[NRF52_ADC_CHANNELS];
+    volatile int16_t val;
+    int i;
+
+    assert(dev != NULL && result != NULL);
+
+    if (nrf52_adc.running) {
+        return (OS_EBUSY);
+    }
+
+    /* Only sample the channel being read */
+    for (i = 0; i < NRF52_ADC_CHANNELS; i++) {
+        pselp[i] = NRF_SAADC->CH[i].PSELP;
+        if (i != cnum) {
+            NRF_SAADC->CH[i].PSELP = SAADC_CH_PSELP_PSELP_NC;
+        }
+    }
+
+    NRF_SAADC->SAMPLERATE =
+        SAADC_SAMPLERATE_MODE_Task << SAADC_SAMPLERATE_MODE_Pos;
+    NRF_SAADC->RESULT.PTR = (uint32_t)&val;
+    NRF_SAADC->RESULT.MAXCNT = 1;
+
+    NRF_SAADC->EVENTS_STARTED = 0;
+    NRF_SAADC->TASKS_START = 1;
+    while (!NRF_SAADC->EVENTS_STARTED) {
+    }
+    NRF_SAADC->EVENTS_STARTED = 0;
+
+    NRF_SAADC->EVENTS_END = 0;
+    NRF_SAADC->TASKS_SAMPLE = 1;
+    while (!NRF_SAADC->EVENTS_END) {
+    }
+    NRF_SAADC->EVENTS_END = 0;
+
+    NRF_SAADC->EVENTS_STOPPED = 0;
+    NRF_SAADC->TASKS_STOP = 1;
+    while (!NRF_SAADC->EVENTS_STOPPED) {
+    }
+    NRF_SAADC->EVENTS_STOPPED = 0;
+
+    for (i = 0; i < NRF52_ADC_CHANNELS; i++) {
+        NRF_SAADC->CH[i].PSELP = pselp[i];
+    }
+
+    /* Single ended readings can be slightly negative around 0V */
+    *result = val < 0 ? 0 : val;
+
+    return (OS_OK);
+}
+
+static int
+nrf52_adc_read_buffer(struct adc_dev *dev, void *buf, int buf_len, int off,
+                      int *result)
+{
+    assert(off < buf_len);
+
+    *result = *((int16_t *)buf + off);
+
+    return (OS_OK);
+}
+
+/**
+ * Callback to return size of buffer
+ *
+ * @param1 ADC device ptr
+ * @param2 Total number of channels
+ * @param3 Total number of samples
+ * @return Length of buffer in bytes
+ */
+static int
+nrf52_adc_size_buffer(struct adc_dev *dev, int chans, int samples)
+{
+    return (sizeof(int16_t) * chans * samples);
+}
+
+/**
+ * Callback to initialize an adc_dev structure from the os device
+ * initialization callback.  This sets up a nrf52_adc_device(), so
+ * that subsequent lookups to this device allow us to manipulate it.
+ *
+ * @param1 os device ptr
+ * @param2 nrf52 ADC device cfg ptr
+ * @return OS_OK on success
+ */
+int
+nrf52_adc_dev_init(struct os_dev *odev, void *arg)
+{
+    struct nrf52_adc_dev_cfg *cfg;
+    struct adc_dev *dev;
+    struct adc_driver_funcs *af;
+
+    cfg = (struct nrf52_adc_dev_cfg *) arg;
+
+    assert(cfg != NULL);
+
+    dev = (struct adc_dev *)odev;
+
+    os_mutex_init(&dev->ad_lock);
+
+    nrf52_adc.ppi_restart = -1;
+    nrf52_adc.ppi_sample = -1;
+
+    dev->ad_chans = cfg->nadc_chans;
+    dev->ad_chan_count = NRF52_ADC_CHANNELS;
+
+    OS_DEV_SETHANDLERS(odev, nrf52_adc_open, nrf52_adc_close);
+
+    af = &dev->ad_funcs;
+
+    af->af_configure_channel = nrf52_adc_configure_channel;
+    af->af_sample = nrf52_adc_sample;
+    af->af_read_channel = nrf52_adc_read_channel;
+    af->af_set_buffer = nrf52_adc_set_buffer;
+    af->af_release_buffer = nrf52_adc_release_buffer;
+    af->af_read_buffer = nrf52_adc_read_buffer;
+    af->af_size_buffer = nrf52_adc_size_buffer;
+    af->af_sample_stop = nrf52_adc_sample_stop;
+
+    return (OS_OK);
+}
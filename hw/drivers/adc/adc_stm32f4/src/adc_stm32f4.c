@@ -581,17 +581,15 @@ stm32f4_adc_set_buffer(struct adc_dev *dev, void *buf1, void *buf2,
     return rc;
 }
 
+/**
+ * Buffers are used in turn, there is nothing to do until the released
+ * buffer comes round again.  Sampling is stopped by
+ * stm32f4_adc_sample_stop().
+ */
 static int
 stm32f4_adc_release_buffer(struct adc_dev *dev, void *buf, int buf_len)
 {
-    ADC_HandleTypeDef *hadc;
-    struct stm32f4_adc_dev_cfg *cfg;
-
     assert(dev);
-    cfg  = (struct stm32f4_adc_dev_cfg *)dev->ad_dev.od_init_arg;
-    hadc = cfg->sac_adc_handle;
-
-    HAL_ADC_Stop_DMA(hadc);
 
     return (0);
 }
@@ -626,6 +624,29 @@ err:
     return rc;
 }
 
+/**
+ * Stop ADC sampling started by stm32f4_adc_sample().
+ *
+ * @param ADC device structure
+ * @return OS_OK on success, non OS_OK on failure
+ */
+static int
+stm32f4_adc_sample_stop(struct adc_dev *dev)
+{
+    ADC_HandleTypeDef *hadc;
+    struct stm32f4_adc_dev_cfg *cfg;
+
+    assert(dev);
+    cfg  = (struct stm32f4_adc_dev_cfg *)dev->ad_dev.od_init_arg;
+    hadc = cfg->sac_adc_handle;
+
+    if (HAL_ADC_Stop_DMA(hadc) != HAL_OK) {
+        return (OS_EINVAL);
+    }
+
+    return (OS_OK);
+}
+
 /**
  * Blocking read of an ADC channel, returns result as an integer.
  *
@@ -718,6 +739,7 @@ stm32f4_adc_dev_init(struct os_dev *odev, void *arg)
     af->af_release_buffer = stm32f4_adc_release_buffer;
     af->af_read_buffer = stm32f4_adc_read_buffer;
     af->af_size_buffer = stm32f4_adc_size_buffer;
+    af->af_sample_stop = stm32f4_adc_sample_stop;
 
     return (OS_OK);
 }
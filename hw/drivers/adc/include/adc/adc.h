@@ -20,6 +20,7 @@
 #ifndef __ADC_H__
 #define __ADC_H__
 
+#include <errno.h>
 #include <os/os_dev.h>
 
 #ifdef __cplusplus
@@ -73,6 +74,16 @@ typedef int (*adc_configure_channel_func_t)(struct adc_dev *dev, uint8_t,
  */
 typedef int (*adc_sample_func_t)(struct adc_dev *);
 
+/**
+ * Stop sampling started by adc_sample().  This is implemented by the HW
+ * specific drivers.
+ *
+ * @param The ADC device to stop
+ *
+ * @return 0 on success, non-zero error code on failure
+ */
+typedef int (*adc_sample_stop_func_t)(struct adc_dev *);
+
 /**
  * Blocking read of an ADC channel.  This is implemented by the HW specific
  * drivers.
@@ -144,6 +155,7 @@ struct adc_driver_funcs {
     adc_buf_release_func_t af_release_buffer;
     adc_buf_read_func_t af_read_buffer;
     adc_buf_size_func_t af_size_buffer;
+    adc_sample_stop_func_t af_sample_stop;
 };
 
 struct adc_chan_config {
@@ -172,6 +184,12 @@ int adc_event_handler_set(struct adc_dev *, adc_event_handler_func_t,
  * Sample the device specified by dev.  This is used in non-blocking mode
  * to generate samples into the event buffer.
  *
+ * If two buffers were set with adc_buf_set(), sampling continues until
+ * adc_sample_stop() is called: each time a buffer fills, the device goes on
+ * sampling into the other one and an ADC_EVENT_RESULT event is delivered
+ * for the full buffer.  The pace of sampling is set by the device
+ * configuration, typically a hardware timer.
+ *
  * @param dev The device to sample
  *
  * @return 0 on success, non-zero on failure
@@ -182,6 +200,22 @@ adc_sample(struct adc_dev *dev)
     return (dev->ad_funcs.af_sample(dev));
 }
 
+/**
+ * Stop sampling started with adc_sample().
+ *
+ * @param dev The device to stop sampling
+ *
+ * @return 0 on success, non-zero on failure
+ */
+static inline int
+adc_sample_stop(struct adc_dev *dev)
+{
+    if (!dev->ad_funcs.af_sample_stop) {
+        return (EINVAL);
+    }
+    return (dev->ad_funcs.af_sample_stop(dev));
+}
+
 /**
  * Set a result buffer to store data into.  Optionally, provide a
  * second buffer to continue writing data into as the first buffer
@@ -205,7 +239,9 @@ adc_buf_set(struct adc_dev *dev, void *buf1, void *buf2,
 
 /**
  * Release a result buffer on the ADC device, and allow for it to be
- * re-used for DMA'ing results.
+ * re-used for DMA'ing results.  When sampling continuously, a buffer must
+ * be processed before the other one fills, as the device then goes back
+ * to sampling into it.
  *
  * @param dev The device to release the buffer for
  * @param buf The buffer to release
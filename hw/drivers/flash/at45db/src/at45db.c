@@ -17,6 +17,7 @@
  * under the License.
  */
 
+#include "syscfg/syscfg.h"
 #include <os/os.h>
 
 #include <hal/hal_spi.h>
@@ -105,7 +106,24 @@ static struct hal_spi_settings at45db_default_settings = {
     .word_size  = HAL_SPI_WORD_SIZE_8BIT,
 };
 
-static uint8_t g_page_buffer[MAX_PAGE_SIZE];
+/* Internal SRAM buffer used for the last page write; 0 or 1. */
+static uint8_t g_write_buf;
+
+#if MYNEWT_VAL(AT45DB_READ_CACHE_PAGES) > 0
+/*
+ * Recently read pages, so that small reads of the same page (e.g. nffs
+ * and fcb headers) don't each need an SPI transaction.
+ */
+struct at45db_cache_page {
+    const struct at45db_dev *dev;   /* NULL if unused */
+    uint32_t addr;                  /* Start of page */
+    uint8_t data[MAX_PAGE_SIZE];
+};
+
+static struct at45db_cache_page
+  g_cache[MYNEWT_VAL(AT45DB_READ_CACHE_PAGES)];
+static uint8_t g_cache_next;
+#endif
 
 static uint8_t
 at45db_read_status(struct at45db_dev *dev)
@@ -222,6 +240,55 @@ at45db_read_page(struct at45db_dev *dev, uint32_t addr,
     return amount;
 }
 
+#if MYNEWT_VAL(AT45DB_READ_CACHE_PAGES) > 0
+static struct at45db_cache_page *
+at45db_cache_find(struct at45db_dev *dev, uint32_t page_addr)
+{
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(AT45DB_READ_CACHE_PAGES); i++) {
+        if (g_cache[i].dev == dev && g_cache[i].addr == page_addr) {
+            return &g_cache[i];
+        }
+    }
+    return NULL;
+}
+
+static void
+at45db_cache_invalidate(struct at45db_dev *dev, uint32_t page_addr)
+{
+    struct at45db_cache_page *cp;
+
+    cp = at45db_cache_find(dev, page_addr);
+    if (cp) {
+        cp->dev = NULL;
+    }
+}
+
+/*
+ * Returns cached copy of the page, reading it in if needed.
+ */
+static struct at45db_cache_page *
+at45db_cache_get(struct at45db_dev *dev, uint32_t page_addr)
+{
+    struct at45db_cache_page *cp;
+
+    cp = at45db_cache_find(dev, page_addr);
+    if (cp) {
+        return cp;
+    }
+    cp = &g_cache[g_cache_next];
+    if (++g_cache_next == MYNEWT_VAL(AT45DB_READ_CACHE_PAGES)) {
+        g_cache_next = 0;
+    }
+    at45db_wait_ready(dev);
+    at45db_read_page(dev, page_addr, dev->page_size, cp->data);
+    cp->dev = dev;
+    cp->addr = page_addr;
+    return cp;
+}
+#endif
+
 int
 at45db_read(const struct hal_flash *hal_flash_dev, uint32_t addr, void *buf,
         uint32_t len)
@@ -231,6 +298,10 @@ at45db_read(const struct hal_flash *hal_flash_dev, uint32_t addr, void *buf,
     uint16_t index;
     uint8_t *u8buf;
     struct at45db_dev *dev;
+#if MYNEWT_VAL(AT45DB_READ_CACHE_PAGES) > 0
+    struct at45db_cache_page *cp;
+    uint32_t start_addr;
+#endif
 
     dev = (struct at45db_dev *) hal_flash_dev;
 
@@ -239,9 +310,19 @@ at45db_read(const struct hal_flash *hal_flash_dev, uint32_t addr, void *buf,
     index = 0;
 
     while (page_count--) {
+#if MYNEWT_VAL(AT45DB_READ_CACHE_PAGES) > 0
+        start_addr = at45db_page_start_address(dev, addr);
+        cp = at45db_cache_get(dev, start_addr);
+        amount = dev->page_size - (addr - start_addr);
+        if (amount > len) {
+            amount = len;
+        }
+        memcpy(&u8buf[index], &cp->data[addr - start_addr], amount);
+#else
         at45db_wait_ready(dev);
 
         amount = at45db_read_page(dev, addr, len, &u8buf[index]);
+#endif
 
         addr = at45db_page_next_addr(dev, addr);
         index += amount;
@@ -251,6 +332,22 @@ at45db_read(const struct hal_flash *hal_flash_dev, uint32_t addr, void *buf,
     return 0;
 }
 
+/*
+ * Sends a command which takes a page address.
+ */
+static void
+at45db_page_cmd(struct at45db_dev *dev, uint8_t cmd, uint16_t pa)
+{
+    hal_gpio_write(dev->ss_pin, 0);
+
+    hal_spi_tx_val(dev->spi_num, cmd);
+    hal_spi_tx_val(dev->spi_num, (pa >> 6) & ~0x80);
+    hal_spi_tx_val(dev->spi_num, pa << 2);
+    hal_spi_tx_val(dev->spi_num, 0xff);
+
+    hal_gpio_write(dev->ss_pin, 1);
+}
+
 int
 at45db_write(const struct hal_flash *hal_flash_dev, uint32_t addr,
         const void *buf, uint32_t len)
@@ -258,7 +355,6 @@ at45db_write(const struct hal_flash *hal_flash_dev, uint32_t addr,
     uint16_t pa;
     uint16_t bfa;
     uint32_t n;
-    uint32_t start_addr;
     uint16_t index;
     uint16_t amount;
     int page_count;
@@ -274,87 +370,62 @@ at45db_write(const struct hal_flash *hal_flash_dev, uint32_t addr,
     index = 0;
 
     while (page_count--) {
-        at45db_wait_ready(dev);
-
         bfa = addr % page_size;
-        start_addr = at45db_page_start_address(dev, addr);
+        /* FIXME: check that pa doesn't overflow capacity */
+        pa = addr / page_size;
+
+        if (len + bfa <= page_size) {
+            amount = len;
+        } else {
+            amount = page_size - bfa;
+        }
+
+        /*
+         * Alternate between the two SRAM buffers, so that a buffer can be
+         * filled while the previous page is still being programmed from
+         * the other one.
+         */
+        g_write_buf ^= 1;
 
         /**
-         * If the page is not being written from the beginning,
-         * read first the current data to rewrite back.
-         *
-         * The whole page is read here for the case of some the
-         * real data ending before the end of the page, data must
-         * be written back again.
+         * If the page is not being written completely, load the current
+         * contents into the buffer inside the chip first, so that only
+         * the new data needs to go over SPI.
          */
-        if (bfa || len < page_size) {
-            at45db_read_page(dev, start_addr, page_size, g_page_buffer);
+        if (amount < page_size) {
+            at45db_wait_ready(dev);
+            at45db_page_cmd(dev, g_write_buf ? MEM_TO_BUF2_TRANSFER :
+                                               MEM_TO_BUF1_TRANSFER, pa);
             at45db_wait_ready(dev);
         }
 
         hal_gpio_write(dev->ss_pin, 0);
 
-        /* TODO: ping-pong between page 1 and 2? */
-        hal_spi_tx_val(dev->spi_num, BUF1_WRITE);
+        hal_spi_tx_val(dev->spi_num, g_write_buf ? BUF2_WRITE : BUF1_WRITE);
 
         hal_spi_tx_val(dev->spi_num, 0xff);
+        hal_spi_tx_val(dev->spi_num, (bfa >> 8) & 0x3);
+        hal_spi_tx_val(dev->spi_num, bfa);
 
-        /* Always write at offset 0 of internal buffer */
-        hal_spi_tx_val(dev->spi_num, 0);
-        hal_spi_tx_val(dev->spi_num, 0);
-
-        /**
-         * Write back extra stuff at the beginning of page.
-         */
-        if (bfa) {
-            amount = addr - start_addr;
-            for (n = 0; n < amount; n++) {
-                hal_spi_tx_val(dev->spi_num, g_page_buffer[n]);
-            }
-        }
-
-        if (len + bfa <= page_size) {
-            amount = len;
-        } else {
-            amount = page_size - bfa;
-        }
-
-        /**
-         * Write the stuff we're really want to write!
-         */
         for (n = 0; n < amount; n++) {
             hal_spi_tx_val(dev->spi_num, u8buf[index++]);
         }
 
-        /**
-         * Write back extra stuff at the ending of page.
-         */
-        if (bfa + len < page_size) {
-            for (n = len + bfa; n < page_size; n++) {
-                hal_spi_tx_val(dev->spi_num, g_page_buffer[n]);
-            }
-        }
-
         hal_gpio_write(dev->ss_pin, 1);
 
         at45db_wait_ready(dev);
 
-        hal_gpio_write(dev->ss_pin, 0);
-
         if (dev->disable_auto_erase) {
-            hal_spi_tx_val(dev->spi_num, BUF1_TO_MEM_NO_ERASE);
+            at45db_page_cmd(dev, g_write_buf ? BUF2_TO_MEM_NO_ERASE :
+                                               BUF1_TO_MEM_NO_ERASE, pa);
         } else {
-            hal_spi_tx_val(dev->spi_num, BUF1_TO_MEM_ERASE);
+            at45db_page_cmd(dev, g_write_buf ? BUF2_TO_MEM_ERASE :
+                                               BUF1_TO_MEM_ERASE, pa);
         }
 
-        /* FIXME: check that pa doesn't overflow capacity */
-        pa = addr / page_size;
-
-        hal_spi_tx_val(dev->spi_num, (pa >> 6) & ~0x80);
-        hal_spi_tx_val(dev->spi_num, pa << 2);
-        hal_spi_tx_val(dev->spi_num, 0xff);
-
-        hal_gpio_write(dev->ss_pin, 1);
+#if MYNEWT_VAL(AT45DB_READ_CACHE_PAGES) > 0
+        at45db_cache_invalidate(dev, at45db_page_start_address(dev, addr));
+#endif
 
         addr = at45db_page_next_addr(dev, addr);
         len -= amount;
@@ -375,14 +446,12 @@ at45db_erase_sector(const struct hal_flash *hal_flash_dev,
 
     at45db_wait_ready(dev);
 
-    hal_gpio_write(dev->ss_pin, 0);
-
-    hal_spi_tx_val(dev->spi_num, PAGE_ERASE);
-    hal_spi_tx_val(dev->spi_num, (pa >> 6) & ~0x80);
-    hal_spi_tx_val(dev->spi_num, pa << 2);
-    hal_spi_tx_val(dev->spi_num, 0xff);
+    at45db_page_cmd(dev, PAGE_ERASE, pa);
 
-    hal_gpio_write(dev->ss_pin, 1);
+#if MYNEWT_VAL(AT45DB_READ_CACHE_PAGES) > 0
+    at45db_cache_invalidate(dev,
+      at45db_page_start_address(dev, sector_address));
+#endif
 
     return 0;
 }
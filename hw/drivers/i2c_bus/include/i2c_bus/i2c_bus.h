@@ -0,0 +1,79 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __I2C_BUS_H__
+#define __I2C_BUS_H__
+
+#include <inttypes.h>
+#include "os/os.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Package init function.  Remove when we have post-kernel init stages.
+ */
+void i2c_bus_pkg_init(void);
+
+struct i2c_bus_xfer;
+
+/**
+ * Called from the bus event queue when a queued transaction completes.
+ *
+ * @param The transaction which completed
+ * @param 0 on success, the error returned by the I2C HAL on failure
+ */
+typedef void (*i2c_bus_xfer_func_t)(struct i2c_bus_xfer *, int);
+
+/**
+ * An I2C transaction.  "ibx_wlen" bytes are written from "ibx_wbuf" (e.g.
+ * a register address), then "ibx_rlen" bytes are read into "ibx_rbuf".
+ * Either part may be empty.
+ *
+ * The transaction, and its buffers, must remain valid until it completes.
+ */
+struct i2c_bus_xfer {
+    /* 7-bit device address */
+    uint8_t ibx_addr;
+
+    uint16_t ibx_wlen;
+    uint16_t ibx_rlen;
+    uint8_t *ibx_wbuf;
+    uint8_t *ibx_rbuf;
+
+    /* Timeout, in OS ticks, of each of the write and the read */
+    uint32_t ibx_timeout;
+
+    /* Completion callback and its argument */
+    i2c_bus_xfer_func_t ibx_func;
+    void *ibx_arg;
+
+    STAILQ_ENTRY(i2c_bus_xfer) ibx_next;
+};
+
+int i2c_bus_submit(uint8_t, struct i2c_bus_xfer *);
+int i2c_bus_xfer(uint8_t, struct i2c_bus_xfer *);
+int i2c_bus_evq_set(uint8_t, struct os_eventq *);
+struct os_eventq *i2c_bus_evq_get(uint8_t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __I2C_BUS_H__ */
@@ -0,0 +1,274 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include <assert.h>
+
+#include "defs/error.h"
+#include "os/os.h"
+#include "syscfg/syscfg.h"
+#include "hal/hal_i2c.h"
+#include "i2c_bus/i2c_bus.h"
+
+/*
+ * Transactions on a bus are queued and run one at a time from the bus's
+ * event queue, so drivers sharing a bus do not need to coordinate, and a
+ * driver can start a transaction without blocking on it.  Buses run on
+ * the default event queue unless given one of their own with
+ * i2c_bus_evq_set(), which lets transactions on different buses proceed
+ * in parallel.
+ */
+struct i2c_bus {
+    struct os_eventq *ib_evq;
+    struct os_event ib_ev;
+    STAILQ_HEAD(, i2c_bus_xfer) ib_queue;
+};
+
+static struct i2c_bus i2c_buses[MYNEWT_VAL(I2C_BUS_MAX)];
+
+/**
+ * Run a transaction on the bus, from the calling task.
+ */
+static int
+i2c_bus_run(uint8_t num, struct i2c_bus_xfer *xfer)
+{
+    struct hal_i2c_master_data data;
+    int rc;
+
+    data.address = xfer->ibx_addr;
+
+    rc = 0;
+    if (xfer->ibx_wlen) {
+        data.len = xfer->ibx_wlen;
+        data.buffer = xfer->ibx_wbuf;
+        rc = hal_i2c_master_write(num, &data, xfer->ibx_timeout,
+                xfer->ibx_rlen == 0);
+        if (rc != 0) {
+            goto done;
+        }
+    }
+
+    if (xfer->ibx_rlen) {
+        data.len = xfer->ibx_rlen;
+        data.buffer = xfer->ibx_rbuf;
+        rc = hal_i2c_master_read(num, &data, xfer->ibx_timeout, 1);
+    }
+
+done:
+    return (rc);
+}
+
+/**
+ * Bus event, runs the transaction at the head of the bus queue.  If more
+ * are queued, the event is posted again rather than looping here, so
+ * that other events on the queue are not held up behind a busy bus.
+ *
+ * @param OS event
+ */
+static void
+i2c_bus_event(struct os_event *ev)
+{
+    struct i2c_bus_xfer *xfer;
+    struct i2c_bus *bus;
+    os_sr_t sr;
+    int rc;
+
+    bus = ev->ev_arg;
+
+    OS_ENTER_CRITICAL(sr);
+    xfer = STAILQ_FIRST(&bus->ib_queue);
+    if (xfer) {
+        STAILQ_REMOVE_HEAD(&bus->ib_queue, ibx_next);
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    if (!xfer) {
+        return;
+    }
+
+    rc = i2c_bus_run(bus - i2c_buses, xfer);
+
+    OS_ENTER_CRITICAL(sr);
+    if (!STAILQ_EMPTY(&bus->ib_queue)) {
+        os_eventq_put(bus->ib_evq, &bus->ib_ev);
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    if (xfer->ibx_func) {
+        xfer->ibx_func(xfer, rc);
+    }
+}
+
+/**
+ * Queue a transaction on an I2C bus.  The transaction runs from the bus
+ * event queue, and its callback is called from there once it completes.
+ *
+ * @param The I2C bus number
+ * @param The transaction to queue
+ *
+ * @return 0 on success, SYS_EINVAL if the bus number is out of range.
+ */
+int
+i2c_bus_submit(uint8_t num, struct i2c_bus_xfer *xfer)
+{
+    struct i2c_bus *bus;
+    os_sr_t sr;
+
+    if (num >= MYNEWT_VAL(I2C_BUS_MAX)) {
+        return (SYS_EINVAL);
+    }
+    bus = &i2c_buses[num];
+
+    OS_ENTER_CRITICAL(sr);
+    STAILQ_INSERT_TAIL(&bus->ib_queue, xfer, ibx_next);
+    os_eventq_put(bus->ib_evq, &bus->ib_ev);
+    OS_EXIT_CRITICAL(sr);
+
+    return (0);
+}
+
+/* A task blocked in i2c_bus_xfer() */
+struct i2c_bus_waiter {
+    struct os_task *ibw_task;
+    int ibw_rc;
+    volatile uint8_t ibw_done;
+};
+
+static void
+i2c_bus_xfer_done(struct i2c_bus_xfer *xfer, int rc)
+{
+    struct i2c_bus_waiter *waiter;
+
+    waiter = xfer->ibx_arg;
+    waiter->ibw_rc = rc;
+    waiter->ibw_done = 1;
+    os_task_notify(waiter->ibw_task, OS_TASK_NOTIFY_IO);
+}
+
+/**
+ * Run a transaction on an I2C bus, blocking until it completes.  The
+ * transaction is queued behind any others on the bus; when called from
+ * the bus event queue itself, or before the OS has started, it is run
+ * directly.  "ibx_func" and "ibx_arg" are ignored.
+ *
+ * @param The I2C bus number
+ * @param The transaction to run
+ *
+ * @return 0 on success, SYS_EINVAL if the bus number is out of range,
+ *         other non-zero error code from the I2C HAL on failure.
+ */
+int
+i2c_bus_xfer(uint8_t num, struct i2c_bus_xfer *xfer)
+{
+    struct i2c_bus_waiter waiter;
+    struct os_task *owner;
+    int rc;
+
+    if (num >= MYNEWT_VAL(I2C_BUS_MAX)) {
+        return (SYS_EINVAL);
+    }
+
+    owner = i2c_buses[num].ib_evq->evq_owner;
+    if (!os_started() || !owner || owner == os_sched_get_current_task()) {
+        return (i2c_bus_run(num, xfer));
+    }
+
+    waiter.ibw_task = os_sched_get_current_task();
+    waiter.ibw_done = 0;
+    os_task_notify_clear(OS_TASK_NOTIFY_IO);
+    xfer->ibx_func = i2c_bus_xfer_done;
+    xfer->ibx_arg = &waiter;
+
+    rc = i2c_bus_submit(num, xfer);
+    if (rc != 0) {
+        return (rc);
+    }
+
+    while (!waiter.ibw_done) {
+        os_task_notify_wait(OS_TASK_NOTIFY_IO, OS_TIMEOUT_NEVER, NULL);
+    }
+
+    return (waiter.ibw_rc);
+}
+
+/**
+ * Run transactions on an I2C bus from "evq".  Must not be called while
+ * transactions are queued on the bus.
+ *
+ * @param The I2C bus number
+ * @param The event queue to run transactions from
+ *
+ * @return 0 on success, SYS_EINVAL on invalid arguments, SYS_EBUSY if
+ *         transactions are queued.
+ */
+int
+i2c_bus_evq_set(uint8_t num, struct os_eventq *evq)
+{
+    struct i2c_bus *bus;
+    os_sr_t sr;
+    int rc;
+
+    if (num >= MYNEWT_VAL(I2C_BUS_MAX) || !evq) {
+        return (SYS_EINVAL);
+    }
+    bus = &i2c_buses[num];
+
+    rc = 0;
+    OS_ENTER_CRITICAL(sr);
+    if (STAILQ_EMPTY(&bus->ib_queue)) {
+        bus->ib_evq = evq;
+    } else {
+        rc = SYS_EBUSY;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return (rc);
+}
+
+/**
+ * Get the event queue transactions on an I2C bus run from.
+ *
+ * @param The I2C bus number
+ *
+ * @return The event queue, NULL if the bus number is out of range.
+ */
+struct os_eventq *
+i2c_bus_evq_get(uint8_t num)
+{
+    if (num >= MYNEWT_VAL(I2C_BUS_MAX)) {
+        return (NULL);
+    }
+    return (i2c_buses[num].ib_evq);
+}
+
+void
+i2c_bus_pkg_init(void)
+{
+    struct i2c_bus *bus;
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(I2C_BUS_MAX); i++) {
+        bus = &i2c_buses[i];
+        memset(bus, 0, sizeof(*bus));
+        STAILQ_INIT(&bus->ib_queue);
+        bus->ib_ev.ev_cb = i2c_bus_event;
+        bus->ib_ev.ev_arg = bus;
+        bus->ib_evq = os_eventq_dflt_get();
+    }
+}
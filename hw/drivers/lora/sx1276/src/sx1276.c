@@ -1336,32 +1336,28 @@ uint8_t SX1276Read( uint8_t addr )
     return data;
 }
 
+/*
+ * Registers and the FIFO are accessed in bursts: the address byte, then
+ * the whole buffer in one SPI transfer, all under one chip select.
+ */
 void SX1276WriteBuffer( uint8_t addr, uint8_t *buffer, uint8_t size )
 {
-    uint8_t i;
-
     hal_gpio_write(RADIO_NSS, 0);
 
     hal_spi_tx_val(RADIO_SPI_IDX, addr | 0x80);
-    for( i = 0; i < size; i++ )
-    {
-        hal_spi_tx_val(RADIO_SPI_IDX, buffer[i]);
-    }
+    hal_spi_txrx(RADIO_SPI_IDX, buffer, NULL, size);
 
     hal_gpio_write(RADIO_NSS, 1);
 }
 
 void SX1276ReadBuffer( uint8_t addr, uint8_t *buffer, uint8_t size )
 {
-    uint8_t i;
-
     hal_gpio_write(RADIO_NSS, 0);
 
     hal_spi_tx_val(RADIO_SPI_IDX, addr & 0x7f);
-    for( i = 0; i < size; i++ )
-    {
-        buffer[i] = hal_spi_tx_val(RADIO_SPI_IDX, 0);
-    }
+    /* The radio ignores what is sent during a read */
+    memset(buffer, 0, size);
+    hal_spi_txrx(RADIO_SPI_IDX, buffer, buffer, size);
 
     hal_gpio_write(RADIO_NSS, 1);
 }
@@ -0,0 +1,65 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __BLE_IPSP_H__
+#define __BLE_IPSP_H__
+
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * IPv6 over BLE (RFC 7668). Each IPSP L2CAP channel is a link to one peer
+ * on a single lwIP network interface. IPv6 headers are compressed with
+ * 6LoWPAN IPHC; L2CAP does segmentation, so no 6LoWPAN fragmentation is
+ * used.
+ */
+#define BLE_IPSP_PSM            0x0023
+#define BLE_IPSP_MTU            1280
+
+struct netif;
+
+/*
+ * Router role: open an IPSP channel to the node on connection conn_handle.
+ *
+ * @param conn_handle Connection to open the channel on.
+ *
+ * @return int 0 on success, BLE host error code on failure.
+ */
+int ble_ipsp_connect(uint16_t conn_handle);
+
+/*
+ * Returns the lwIP network interface for IPSP. The link is up while at
+ * least one IPSP channel is connected.
+ */
+struct netif *ble_ipsp_netif(void);
+
+/*
+ * Registers the network interface with lwIP, and, in node role, starts
+ * accepting IPSP channels. Called by sysinit.
+ */
+void ble_ipsp_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BLE_IPSP_H__ */
@@ -0,0 +1,588 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include <syscfg/syscfg.h>
+#include <sysinit/sysinit.h>
+#include <os/os.h>
+
+#include <lwip/netif.h>
+#include <lwip/pbuf.h>
+#include <lwip/stats.h>
+#include <lwip/tcpip.h>
+
+#include <host/ble_hs.h>
+#include <host/ble_l2cap.h>
+
+#include "ble_ipsp/ble_ipsp.h"
+#include "ble_ipsp_priv.h"
+
+/*
+ * One IPSP channel, i.e. a link to one peer.
+ */
+struct ble_ipsp_conn {
+    struct ble_l2cap_chan *bic_chan;
+    uint8_t bic_peer_ll[BLE_IPSP_LL_LEN];
+    uint8_t bic_txq_len;
+    STAILQ_HEAD(, os_mbuf_pkthdr) bic_txq;  /* SDUs waiting for credits */
+    struct os_callout bic_rx_tmr;           /* retry for RX buffer */
+};
+
+static struct ble_ipsp_conn ble_ipsp_conns[MYNEWT_VAL(BLE_IPSP_MAX_CONN)];
+static int ble_ipsp_conn_cnt;
+static struct netif ble_ipsp_nif;
+
+/*
+ * Channel TX is done from the default event queue only; lwIP output just
+ * queues the SDU.
+ */
+static struct os_event ble_ipsp_tx_ev;
+
+static int ble_ipsp_l2cap_event(struct ble_l2cap_event *event, void *arg);
+
+static struct ble_ipsp_conn *
+ble_ipsp_conn_find(struct ble_l2cap_chan *chan)
+{
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(BLE_IPSP_MAX_CONN); i++) {
+        if (ble_ipsp_conns[i].bic_chan == chan) {
+            return &ble_ipsp_conns[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * BLE addresses are stored LSB first; link-layer addresses for IPv6 are
+ * MSB first.
+ */
+static void
+ble_ipsp_addr_to_ll(const ble_addr_t *addr, uint8_t *ll)
+{
+    int i;
+
+    for (i = 0; i < BLE_IPSP_LL_LEN; i++) {
+        ll[i] = addr->val[BLE_IPSP_LL_LEN - 1 - i];
+    }
+}
+
+static void
+ble_ipsp_txq_flush(struct ble_ipsp_conn *bic)
+{
+    struct os_mbuf_pkthdr *omp;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    while ((omp = STAILQ_FIRST(&bic->bic_txq))) {
+        STAILQ_REMOVE_HEAD(&bic->bic_txq, omp_next);
+        OS_EXIT_CRITICAL(sr);
+        os_mbuf_free_chain(OS_MBUF_PKTHDR_TO_MBUF(omp));
+        OS_ENTER_CRITICAL(sr);
+    }
+    bic->bic_txq_len = 0;
+    OS_EXIT_CRITICAL(sr);
+}
+
+/*
+ * Send queued SDUs until the channel runs out of credits. Continued when
+ * the stalled SDU completes.
+ */
+static void
+ble_ipsp_tx_event(struct os_event *ev)
+{
+    struct ble_ipsp_conn *bic;
+    struct os_mbuf_pkthdr *omp;
+    struct os_mbuf *om;
+    os_sr_t sr;
+    int rc;
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(BLE_IPSP_MAX_CONN); i++) {
+        bic = &ble_ipsp_conns[i];
+        if (!bic->bic_chan) {
+            continue;
+        }
+        while (1) {
+            OS_ENTER_CRITICAL(sr);
+            omp = STAILQ_FIRST(&bic->bic_txq);
+            if (omp) {
+                STAILQ_REMOVE_HEAD(&bic->bic_txq, omp_next);
+                bic->bic_txq_len--;
+            }
+            OS_EXIT_CRITICAL(sr);
+            if (!omp) {
+                break;
+            }
+            om = OS_MBUF_PKTHDR_TO_MBUF(omp);
+
+            rc = ble_l2cap_send(bic->bic_chan, om);
+            if (rc == BLE_HS_EBUSY) {
+                OS_ENTER_CRITICAL(sr);
+                STAILQ_INSERT_HEAD(&bic->bic_txq, omp, omp_next);
+                bic->bic_txq_len++;
+                OS_EXIT_CRITICAL(sr);
+                break;
+            }
+            if (rc) {
+                /* SDU was consumed by the host also on failure. */
+                LINK_STATS_INC(link.err);
+            } else {
+                LINK_STATS_INC(link.xmit);
+            }
+        }
+    }
+}
+
+static int
+ble_ipsp_txq_put(struct ble_ipsp_conn *bic, struct os_mbuf *om)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    if (!bic->bic_chan ||
+      bic->bic_txq_len >= MYNEWT_VAL(BLE_IPSP_TX_QUEUE_LEN)) {
+        OS_EXIT_CRITICAL(sr);
+        return -1;
+    }
+    STAILQ_INSERT_TAIL(&bic->bic_txq, OS_MBUF_PKTHDR(om), omp_next);
+    bic->bic_txq_len++;
+    OS_EXIT_CRITICAL(sr);
+    return 0;
+}
+
+/*
+ * Builds an SDU for peer out of IPv6 packet p: compressed header followed
+ * by the rest of the packet.
+ */
+static struct os_mbuf *
+ble_ipsp_sdu_build(struct pbuf *p, const uint8_t *peer_ll)
+{
+    uint8_t pkt[BLE_IPSP_HDR_MAX];
+    uint8_t hc[BLE_IPSP_IPHC_MAX];
+    struct os_mbuf *om;
+    struct pbuf *q;
+    int pkt_len;
+    int hc_len;
+    int off;
+    int rc;
+
+    pkt_len = pbuf_copy_partial(p, pkt, sizeof(pkt), 0);
+    hc_len = ble_ipsp_iphc_compress(pkt, pkt_len, ble_ipsp_nif.hwaddr,
+                                    peer_ll, hc, &off);
+    if (hc_len < 0) {
+        return NULL;
+    }
+
+    om = os_msys_get_pkthdr(hc_len + p->tot_len - off, 0);
+    if (!om) {
+        return NULL;
+    }
+    rc = os_mbuf_append(om, hc, hc_len);
+    for (q = p; q && !rc; q = q->next) {
+        if (off >= q->len) {
+            off -= q->len;
+            continue;
+        }
+        rc = os_mbuf_append(om, (uint8_t *)q->payload + off, q->len - off);
+        off = 0;
+    }
+    if (rc) {
+        os_mbuf_free_chain(om);
+        return NULL;
+    }
+    return om;
+}
+
+/*
+ * Picks the channel for a unicast destination: the peer whose link-layer
+ * address the IID is derived from, or the only peer there is.
+ */
+static struct ble_ipsp_conn *
+ble_ipsp_route(const ip6_addr_t *ip6addr)
+{
+    struct ble_ipsp_conn *bic;
+    const uint8_t *iid;
+    const uint8_t *ll;
+    int i;
+
+    iid = (const uint8_t *)&ip6addr->addr[2];
+    for (i = 0; i < MYNEWT_VAL(BLE_IPSP_MAX_CONN); i++) {
+        bic = &ble_ipsp_conns[i];
+        if (!bic->bic_chan) {
+            continue;
+        }
+        ll = bic->bic_peer_ll;
+        if (iid[0] == (ll[0] ^ 0x02) && iid[1] == ll[1] && iid[2] == ll[2] &&
+          iid[3] == 0xff && iid[4] == 0xfe &&
+          !memcmp(iid + 5, ll + 3, 3)) {
+            return bic;
+        }
+    }
+    if (ble_ipsp_conn_cnt == 1) {
+        for (i = 0; i < MYNEWT_VAL(BLE_IPSP_MAX_CONN); i++) {
+            if (ble_ipsp_conns[i].bic_chan) {
+                return &ble_ipsp_conns[i];
+            }
+        }
+    }
+    return NULL;
+}
+
+static err_t
+ble_ipsp_output_ip6(struct netif *nif, struct pbuf *p,
+                    const ip6_addr_t *ip6addr)
+{
+    struct ble_ipsp_conn *bic;
+    struct os_mbuf *om;
+    int sent;
+    int i;
+
+    sent = 0;
+    for (i = 0; i < MYNEWT_VAL(BLE_IPSP_MAX_CONN); i++) {
+        if (ip6_addr_ismulticast(ip6addr)) {
+            bic = &ble_ipsp_conns[i];
+            if (!bic->bic_chan) {
+                continue;
+            }
+        } else {
+            bic = ble_ipsp_route(ip6addr);
+            if (!bic) {
+                LINK_STATS_INC(link.rterr);
+                return ERR_RTE;
+            }
+            /* Only once. */
+            i = MYNEWT_VAL(BLE_IPSP_MAX_CONN);
+        }
+
+        om = ble_ipsp_sdu_build(p, bic->bic_peer_ll);
+        if (!om) {
+            LINK_STATS_INC(link.memerr);
+            continue;
+        }
+        if (ble_ipsp_txq_put(bic, om)) {
+            os_mbuf_free_chain(om);
+            LINK_STATS_INC(link.drop);
+            continue;
+        }
+        sent++;
+    }
+    if (sent) {
+        os_eventq_put(os_eventq_dflt_get(), &ble_ipsp_tx_ev);
+    }
+    return ERR_OK;
+}
+
+#if LWIP_IPV4
+static err_t
+ble_ipsp_output(struct netif *nif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+    /* IPSP carries IPv6 only. */
+    return ERR_IF;
+}
+#endif
+
+/*
+ * Converts received SDU to a pbuf, and hands it to lwIP.
+ */
+static void
+ble_ipsp_rx(struct ble_ipsp_conn *bic, struct os_mbuf *om)
+{
+    uint8_t in[BLE_IPSP_IPHC_MAX];
+    uint8_t hdr[BLE_IPSP_HDR_MAX];
+    struct pbuf *p;
+    struct os_mbuf *m;
+    int sdu_len;
+    int in_len;
+    int hdr_len;
+    int off;
+    int len;
+
+    LINK_STATS_INC(link.recv);
+    sdu_len = OS_MBUF_PKTLEN(om);
+    in_len = min(sdu_len, sizeof(in));
+    if (os_mbuf_copydata(om, 0, in_len, in)) {
+        goto drop;
+    }
+
+    if (in_len > 0 && in[0] == BLE_IPSP_DISPATCH_IPV6) {
+        hdr_len = 0;
+        off = 1;
+    } else {
+        off = ble_ipsp_iphc_decompress(in, in_len, sdu_len, bic->bic_peer_ll,
+                                       ble_ipsp_nif.hwaddr, hdr, &hdr_len);
+        if (off < 0) {
+            LINK_STATS_INC(link.proterr);
+            goto drop;
+        }
+    }
+
+    p = pbuf_alloc(PBUF_RAW, hdr_len + sdu_len - off, PBUF_POOL);
+    if (!p) {
+        LINK_STATS_INC(link.memerr);
+        goto drop;
+    }
+    if (hdr_len) {
+        pbuf_take(p, hdr, hdr_len);
+    }
+
+    /* Skip what was decompressed, and copy the rest. */
+    for (m = om; m; m = SLIST_NEXT(m, om_next)) {
+        if (off >= m->om_len) {
+            off -= m->om_len;
+            continue;
+        }
+        len = m->om_len - off;
+        pbuf_take_at(p, m->om_data + off, len, hdr_len);
+        hdr_len += len;
+        off = 0;
+    }
+    os_mbuf_free_chain(om);
+
+    if (ble_ipsp_nif.input(p, &ble_ipsp_nif) != ERR_OK) {
+        pbuf_free(p);
+    }
+    return;
+drop:
+    LINK_STATS_INC(link.drop);
+    os_mbuf_free_chain(om);
+}
+
+/*
+ * Gives the channel a buffer for the next SDU. If there's no mbuf now, try
+ * again a bit later.
+ */
+static void
+ble_ipsp_rx_ready(struct ble_ipsp_conn *bic, struct ble_l2cap_chan *chan)
+{
+    struct os_mbuf *om;
+
+    om = os_msys_get_pkthdr(0, 0);
+    if (!om) {
+        os_callout_reset(&bic->bic_rx_tmr, 1);
+        return;
+    }
+    ble_l2cap_recv_ready(chan, om);
+}
+
+static void
+ble_ipsp_rx_tmr(struct os_event *ev)
+{
+    struct ble_ipsp_conn *bic;
+
+    bic = ev->ev_arg;
+    if (bic->bic_chan) {
+        ble_ipsp_rx_ready(bic, bic->bic_chan);
+    }
+}
+
+/*
+ * lwIP netif changes are done in tcpip thread.
+ */
+static void
+ble_ipsp_link_cb(void *arg)
+{
+    if (arg) {
+        netif_create_ip6_linklocal_address(&ble_ipsp_nif, 1);
+        netif_set_link_up(&ble_ipsp_nif);
+    } else {
+        netif_set_link_down(&ble_ipsp_nif);
+    }
+}
+
+static void
+ble_ipsp_conn_up(uint16_t conn_handle, struct ble_l2cap_chan *chan)
+{
+    struct ble_gap_conn_desc desc;
+    struct ble_ipsp_conn *bic;
+    int rc;
+
+    rc = ble_gap_conn_find(conn_handle, &desc);
+    bic = ble_ipsp_conn_find(NULL);
+    if (rc || !bic) {
+        ble_l2cap_disconnect(chan);
+        return;
+    }
+
+    ble_ipsp_addr_to_ll(&desc.peer_ota_addr, bic->bic_peer_ll);
+    STAILQ_INIT(&bic->bic_txq);
+    bic->bic_txq_len = 0;
+    bic->bic_chan = chan;
+
+    if (ble_ipsp_conn_cnt++ == 0) {
+        /*
+         * Link-local address is derived from the address we use on air.
+         */
+        ble_ipsp_addr_to_ll(&desc.our_ota_addr, ble_ipsp_nif.hwaddr);
+        tcpip_callback(ble_ipsp_link_cb, &ble_ipsp_nif);
+    }
+}
+
+static void
+ble_ipsp_conn_down(struct ble_l2cap_chan *chan)
+{
+    struct ble_ipsp_conn *bic;
+
+    bic = ble_ipsp_conn_find(chan);
+    if (!bic) {
+        return;
+    }
+    os_callout_stop(&bic->bic_rx_tmr);
+    bic->bic_chan = NULL;
+    ble_ipsp_txq_flush(bic);
+
+    if (--ble_ipsp_conn_cnt == 0) {
+        tcpip_callback(ble_ipsp_link_cb, NULL);
+    }
+}
+
+static int
+ble_ipsp_l2cap_event(struct ble_l2cap_event *event, void *arg)
+{
+    struct ble_ipsp_conn *bic;
+    struct os_mbuf *sdu_rx;
+
+    switch (event->type) {
+    case BLE_L2CAP_EVENT_COC_ACCEPT:
+        if (ble_ipsp_conn_find(NULL) == NULL) {
+            return BLE_HS_ENOMEM;
+        }
+        if (event->accept.peer_sdu_size < BLE_IPSP_MTU) {
+            /* IPSP needs the IPv6 minimum MTU both ways. */
+            return BLE_HS_EINVAL;
+        }
+        sdu_rx = os_msys_get_pkthdr(0, 0);
+        if (!sdu_rx) {
+            return BLE_HS_ENOMEM;
+        }
+        ble_l2cap_recv_ready(event->accept.chan, sdu_rx);
+        return 0;
+
+    case BLE_L2CAP_EVENT_COC_CONNECTED:
+        if (event->connect.status == 0) {
+            ble_ipsp_conn_up(event->connect.conn_handle, event->connect.chan);
+        }
+        return 0;
+
+    case BLE_L2CAP_EVENT_COC_DISCONNECTED:
+        ble_ipsp_conn_down(event->disconnect.chan);
+        return 0;
+
+    case BLE_L2CAP_EVENT_COC_DATA_RECEIVED:
+        bic = ble_ipsp_conn_find(event->receive.chan);
+        if (!bic) {
+            os_mbuf_free_chain(event->receive.sdu_rx);
+            return 0;
+        }
+        ble_ipsp_rx(bic, event->receive.sdu_rx);
+        ble_ipsp_rx_ready(bic, event->receive.chan);
+        return 0;
+
+    case BLE_L2CAP_EVENT_COC_TX_UNSTALLED:
+        os_eventq_put(os_eventq_dflt_get(), &ble_ipsp_tx_ev);
+        return 0;
+
+    default:
+        return 0;
+    }
+}
+
+int
+ble_ipsp_connect(uint16_t conn_handle)
+{
+    struct os_mbuf *sdu_rx;
+    int rc;
+
+    sdu_rx = os_msys_get_pkthdr(0, 0);
+    if (!sdu_rx) {
+        return BLE_HS_ENOMEM;
+    }
+
+    rc = ble_l2cap_connect(conn_handle, BLE_IPSP_PSM, BLE_IPSP_MTU, sdu_rx,
+                           ble_ipsp_l2cap_event, NULL);
+    if (rc) {
+        os_mbuf_free_chain(sdu_rx);
+    }
+    return rc;
+}
+
+struct netif *
+ble_ipsp_netif(void)
+{
+    return &ble_ipsp_nif;
+}
+
+static err_t
+ble_ipsp_lwip_init(struct netif *nif)
+{
+    /*
+     * LwIP clears most of these field in netif_add() before calling
+     * this init routine. So we need to fill them in here.
+     */
+    memcpy(nif->name, "bt", 2);
+#if LWIP_IPV4
+    nif->output = ble_ipsp_output;
+#endif
+    nif->output_ip6 = ble_ipsp_output_ip6;
+    nif->mtu = BLE_IPSP_MTU;
+    nif->hwaddr_len = BLE_IPSP_LL_LEN;
+    nif->flags = 0;
+#if LWIP_IPV6_AUTOCONFIG
+    nif->ip6_autoconfig_enabled = 1;
+#endif
+
+    return ERR_OK;
+}
+
+void
+ble_ipsp_init(void)
+{
+    struct netif *nif;
+    int rc;
+    int i;
+
+    /* Ensure this function only gets called by sysinit. */
+    SYSINIT_ASSERT_ACTIVE();
+
+    ble_ipsp_tx_ev.ev_cb = ble_ipsp_tx_event;
+    for (i = 0; i < MYNEWT_VAL(BLE_IPSP_MAX_CONN); i++) {
+        STAILQ_INIT(&ble_ipsp_conns[i].bic_txq);
+        os_callout_init(&ble_ipsp_conns[i].bic_rx_tmr, os_eventq_dflt_get(),
+                        ble_ipsp_rx_tmr, &ble_ipsp_conns[i]);
+    }
+
+#if LWIP_IPV4
+    nif = netif_add(&ble_ipsp_nif, NULL, NULL, NULL, NULL, ble_ipsp_lwip_init,
+                    tcpip_input);
+#else
+    nif = netif_add(&ble_ipsp_nif, NULL, ble_ipsp_lwip_init, tcpip_input);
+#endif
+    SYSINIT_PANIC_ASSERT(nif != NULL);
+    netif_set_up(nif);
+
+#if MYNEWT_VAL(BLE_IPSP_NODE)
+    rc = ble_l2cap_create_server(BLE_IPSP_PSM, BLE_IPSP_MTU,
+                                 ble_ipsp_l2cap_event, NULL);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#else
+    (void)rc;
+#endif
+}
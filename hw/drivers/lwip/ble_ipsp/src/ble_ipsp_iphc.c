@@ -0,0 +1,501 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * 6LoWPAN IPHC (RFC 6282) as profiled for BLE by RFC 7668. Only stateless
+ * compression is done, i.e. no context based addresses. Link-local
+ * addresses whose IID is derived from the link-layer address are elided
+ * completely, and UDP headers are compressed with NHC leaving the checksum
+ * inline.
+ */
+#include <string.h>
+
+#include "ble_ipsp_priv.h"
+
+#define IPHC_TF_MASK            0x18
+#define IPHC_TF_ELIDED          0x18    /* TC and flow label elided */
+#define IPHC_TF_TC              0x10    /* TC inline, flow label elided */
+#define IPHC_TF_FL              0x08    /* ECN and flow label inline */
+#define IPHC_NH                 0x04
+#define IPHC_HLIM_MASK          0x03
+
+#define IPHC_CID                0x80
+#define IPHC_SAC                0x40
+#define IPHC_SAM_SHIFT          4
+#define IPHC_M                  0x08
+#define IPHC_DAC                0x04
+#define IPHC_AM_MASK            0x03
+
+/*
+ * Address modes, i.e. values of SAM/DAM, for unicast addresses.
+ */
+#define IPHC_AM_128             0       /* address inline */
+#define IPHC_AM_64              1       /* fe80::/64 + 64 bit IID inline */
+#define IPHC_AM_16              2       /* fe80::ff:fe00:XXXX */
+#define IPHC_AM_0               3       /* IID from link-layer address */
+
+#define NHC_UDP                 0xf0
+#define NHC_UDP_MASK            0xf8
+#define NHC_UDP_C               0x04
+#define NHC_UDP_PORTS_MASK      0x03
+
+#define IPHC_IP6_HLEN           40
+#define IPHC_UDP_HLEN           8
+#define IPHC_NEXTH_UDP          17
+
+#define IPHC_NEED(off, n, len)                                          \
+    do {                                                                \
+        if ((off) + (n) > (len)) {                                      \
+            return -1;                                                  \
+        }                                                               \
+    } while (0)
+
+static const uint8_t iphc_ll_prefix[8] = { 0xfe, 0x80 };
+static const uint8_t iphc_zero[16];
+
+/*
+ * IID derived from 48 bit link-layer address, the same way lwIP does it for
+ * the interface's own link-local address.
+ */
+static void
+iphc_ll_to_iid(const uint8_t *ll, uint8_t *iid)
+{
+    iid[0] = ll[0] ^ 0x02;
+    iid[1] = ll[1];
+    iid[2] = ll[2];
+    iid[3] = 0xff;
+    iid[4] = 0xfe;
+    iid[5] = ll[3];
+    iid[6] = ll[4];
+    iid[7] = ll[5];
+}
+
+static int
+iphc_addr_mode(const uint8_t *addr, const uint8_t *ll)
+{
+    static const uint8_t iid16[6] = { 0, 0, 0, 0xff, 0xfe, 0 };
+    uint8_t iid[8];
+
+    if (memcmp(addr, iphc_ll_prefix, 8)) {
+        return IPHC_AM_128;
+    }
+    iphc_ll_to_iid(ll, iid);
+    if (!memcmp(addr + 8, iid, 8)) {
+        return IPHC_AM_0;
+    }
+    if (!memcmp(addr + 8, iid16, sizeof(iid16))) {
+        return IPHC_AM_16;
+    }
+    return IPHC_AM_64;
+}
+
+static uint8_t *
+iphc_addr_put(uint8_t *out, const uint8_t *addr, int mode)
+{
+    switch (mode) {
+    case IPHC_AM_128:
+        memcpy(out, addr, 16);
+        return out + 16;
+    case IPHC_AM_64:
+        memcpy(out, addr + 8, 8);
+        return out + 8;
+    case IPHC_AM_16:
+        memcpy(out, addr + 14, 2);
+        return out + 2;
+    default:
+        return out;
+    }
+}
+
+static int
+iphc_addr_get(uint8_t *addr, const uint8_t *in, int in_len, int *off,
+              int mode, const uint8_t *ll)
+{
+    static const uint8_t len[] = { 16, 8, 2, 0 };
+
+    IPHC_NEED(*off, len[mode], in_len);
+    in += *off;
+    *off += len[mode];
+
+    if (mode == IPHC_AM_128) {
+        memcpy(addr, in, 16);
+        return 0;
+    }
+    memset(addr, 0, 16);
+    memcpy(addr, iphc_ll_prefix, sizeof(iphc_ll_prefix));
+    switch (mode) {
+    case IPHC_AM_64:
+        memcpy(addr + 8, in, 8);
+        break;
+    case IPHC_AM_16:
+        addr[11] = 0xff;
+        addr[12] = 0xfe;
+        memcpy(addr + 14, in, 2);
+        break;
+    default:
+        iphc_ll_to_iid(ll, addr + 8);
+        break;
+    }
+    return 0;
+}
+
+/*
+ * DAM for multicast destinations:
+ *   3: ff02::00XX
+ *   2: ffXX::00XX:XXXX
+ *   1: ffXX::00XX:XXXX:XXXX
+ *   0: inline
+ */
+static int
+iphc_mcast_mode(const uint8_t *addr)
+{
+    if (addr[1] == 0x02 && !memcmp(addr + 2, iphc_zero, 13)) {
+        return 3;
+    }
+    if (!memcmp(addr + 2, iphc_zero, 11)) {
+        return 2;
+    }
+    if (!memcmp(addr + 2, iphc_zero, 9)) {
+        return 1;
+    }
+    return 0;
+}
+
+static uint8_t *
+iphc_mcast_put(uint8_t *out, const uint8_t *addr, int mode)
+{
+    switch (mode) {
+    case 3:
+        *out++ = addr[15];
+        return out;
+    case 2:
+        *out++ = addr[1];
+        memcpy(out, addr + 13, 3);
+        return out + 3;
+    case 1:
+        *out++ = addr[1];
+        memcpy(out, addr + 11, 5);
+        return out + 5;
+    default:
+        memcpy(out, addr, 16);
+        return out + 16;
+    }
+}
+
+static int
+iphc_mcast_get(uint8_t *addr, const uint8_t *in, int in_len, int *off,
+               int mode)
+{
+    static const uint8_t len[] = { 16, 6, 4, 1 };
+
+    IPHC_NEED(*off, len[mode], in_len);
+    in += *off;
+    *off += len[mode];
+
+    memset(addr, 0, 16);
+    addr[0] = 0xff;
+    switch (mode) {
+    case 3:
+        addr[1] = 0x02;
+        addr[15] = in[0];
+        break;
+    case 2:
+        addr[1] = in[0];
+        memcpy(addr + 13, in + 1, 3);
+        break;
+    case 1:
+        addr[1] = in[0];
+        memcpy(addr + 11, in + 1, 5);
+        break;
+    default:
+        memcpy(addr, in, 16);
+        break;
+    }
+    return 0;
+}
+
+int
+ble_ipsp_iphc_compress(const uint8_t *pkt, int pkt_len,
+                       const uint8_t *src_ll, const uint8_t *dst_ll,
+                       uint8_t *out, int *consumed)
+{
+    const uint8_t *udp;
+    uint16_t sport;
+    uint16_t dport;
+    uint32_t fl;
+    uint8_t tc;
+    uint8_t *p;
+    int mode;
+
+    if (pkt_len < IPHC_IP6_HLEN || (pkt[0] >> 4) != 6) {
+        return -1;
+    }
+    tc = (pkt[0] << 4) | (pkt[1] >> 4);
+    fl = ((uint32_t)(pkt[1] & 0x0f) << 16) | (pkt[2] << 8) | pkt[3];
+
+    out[0] = BLE_IPSP_DISPATCH_IPHC;
+    out[1] = 0;
+    p = out + 2;
+
+    /*
+     * Traffic class goes on air as ECN + DSCP.
+     */
+    if (tc == 0 && fl == 0) {
+        out[0] |= IPHC_TF_ELIDED;
+    } else if (fl == 0) {
+        out[0] |= IPHC_TF_TC;
+        *p++ = (tc << 6) | (tc >> 2);
+    } else {
+        *p++ = (tc << 6) | (tc >> 2);
+        *p++ = fl >> 16;
+        *p++ = fl >> 8;
+        *p++ = fl;
+    }
+
+    udp = NULL;
+    if (pkt[6] == IPHC_NEXTH_UDP &&
+      pkt_len >= IPHC_IP6_HLEN + IPHC_UDP_HLEN) {
+        out[0] |= IPHC_NH;
+        udp = pkt + IPHC_IP6_HLEN;
+    } else {
+        *p++ = pkt[6];
+    }
+
+    switch (pkt[7]) {
+    case 1:
+        out[0] |= 1;
+        break;
+    case 64:
+        out[0] |= 2;
+        break;
+    case 255:
+        out[0] |= 3;
+        break;
+    default:
+        *p++ = pkt[7];
+        break;
+    }
+
+    mode = iphc_addr_mode(pkt + 8, src_ll);
+    out[1] |= mode << IPHC_SAM_SHIFT;
+    p = iphc_addr_put(p, pkt + 8, mode);
+
+    if (pkt[24] == 0xff) {
+        mode = iphc_mcast_mode(pkt + 24);
+        out[1] |= IPHC_M | mode;
+        p = iphc_mcast_put(p, pkt + 24, mode);
+    } else {
+        mode = iphc_addr_mode(pkt + 24, dst_ll);
+        out[1] |= mode;
+        p = iphc_addr_put(p, pkt + 24, mode);
+    }
+    *consumed = IPHC_IP6_HLEN;
+
+    if (udp) {
+        /*
+         * Length is elided, checksum is carried inline.
+         */
+        sport = (udp[0] << 8) | udp[1];
+        dport = (udp[2] << 8) | udp[3];
+        if ((sport & 0xfff0) == 0xf0b0 && (dport & 0xfff0) == 0xf0b0) {
+            *p++ = NHC_UDP | 3;
+            *p++ = ((sport & 0x0f) << 4) | (dport & 0x0f);
+        } else if ((dport & 0xff00) == 0xf000) {
+            *p++ = NHC_UDP | 1;
+            memcpy(p, udp, 2);
+            p[2] = udp[3];
+            p += 3;
+        } else if ((sport & 0xff00) == 0xf000) {
+            *p++ = NHC_UDP | 2;
+            p[0] = udp[1];
+            memcpy(p + 1, udp + 2, 2);
+            p += 3;
+        } else {
+            *p++ = NHC_UDP;
+            memcpy(p, udp, 4);
+            p += 4;
+        }
+        memcpy(p, udp + 6, 2);
+        p += 2;
+        *consumed += IPHC_UDP_HLEN;
+    }
+
+    return p - out;
+}
+
+int
+ble_ipsp_iphc_decompress(const uint8_t *in, int in_len, int sdu_len,
+                         const uint8_t *src_ll, const uint8_t *dst_ll,
+                         uint8_t *hdr, int *hdr_len)
+{
+    uint8_t *udp;
+    uint32_t fl;
+    uint16_t plen;
+    uint8_t tc;
+    uint8_t nh;
+    int mode;
+    int off;
+    int rc;
+
+    if (in_len < 2 ||
+      (in[0] & BLE_IPSP_DISPATCH_MASK) != BLE_IPSP_DISPATCH_IPHC) {
+        return -1;
+    }
+    if (in[1] & (IPHC_CID | IPHC_DAC)) {
+        /* No compression contexts are in use. */
+        return -1;
+    }
+    off = 2;
+
+    tc = 0;
+    fl = 0;
+    switch (in[0] & IPHC_TF_MASK) {
+    case 0:
+        IPHC_NEED(off, 4, in_len);
+        tc = (in[off] << 2) | (in[off] >> 6);
+        fl = ((uint32_t)(in[off + 1] & 0x0f) << 16) | (in[off + 2] << 8) |
+          in[off + 3];
+        off += 4;
+        break;
+    case IPHC_TF_FL:
+        IPHC_NEED(off, 3, in_len);
+        tc = in[off] >> 6;
+        fl = ((uint32_t)(in[off] & 0x0f) << 16) | (in[off + 1] << 8) |
+          in[off + 2];
+        off += 3;
+        break;
+    case IPHC_TF_TC:
+        IPHC_NEED(off, 1, in_len);
+        tc = (in[off] << 2) | (in[off] >> 6);
+        off++;
+        break;
+    default:
+        break;
+    }
+
+    if (in[0] & IPHC_NH) {
+        nh = IPHC_NEXTH_UDP;
+    } else {
+        IPHC_NEED(off, 1, in_len);
+        nh = in[off++];
+    }
+
+    switch (in[0] & IPHC_HLIM_MASK) {
+    case 1:
+        hdr[7] = 1;
+        break;
+    case 2:
+        hdr[7] = 64;
+        break;
+    case 3:
+        hdr[7] = 255;
+        break;
+    default:
+        IPHC_NEED(off, 1, in_len);
+        hdr[7] = in[off++];
+        break;
+    }
+
+    mode = (in[1] >> IPHC_SAM_SHIFT) & IPHC_AM_MASK;
+    if (in[1] & IPHC_SAC) {
+        /* SAC=1, SAM=00 is the unspecified address. */
+        if (mode != IPHC_AM_128) {
+            return -1;
+        }
+        memset(hdr + 8, 0, 16);
+    } else {
+        rc = iphc_addr_get(hdr + 8, in, in_len, &off, mode, src_ll);
+        if (rc) {
+            return -1;
+        }
+    }
+
+    mode = in[1] & IPHC_AM_MASK;
+    if (in[1] & IPHC_M) {
+        rc = iphc_mcast_get(hdr + 24, in, in_len, &off, mode);
+    } else {
+        rc = iphc_addr_get(hdr + 24, in, in_len, &off, mode, dst_ll);
+    }
+    if (rc) {
+        return -1;
+    }
+
+    *hdr_len = IPHC_IP6_HLEN;
+    udp = NULL;
+    if (in[0] & IPHC_NH) {
+        IPHC_NEED(off, 1, in_len);
+        if ((in[off] & NHC_UDP_MASK) != NHC_UDP || (in[off] & NHC_UDP_C)) {
+            /* Only UDP, with checksum, is supported. */
+            return -1;
+        }
+        udp = hdr + IPHC_IP6_HLEN;
+        switch (in[off++] & NHC_UDP_PORTS_MASK) {
+        case 0:
+            IPHC_NEED(off, 4, in_len);
+            memcpy(udp, in + off, 4);
+            off += 4;
+            break;
+        case 1:
+            IPHC_NEED(off, 3, in_len);
+            memcpy(udp, in + off, 2);
+            udp[2] = 0xf0;
+            udp[3] = in[off + 2];
+            off += 3;
+            break;
+        case 2:
+            IPHC_NEED(off, 3, in_len);
+            udp[0] = 0xf0;
+            udp[1] = in[off];
+            memcpy(udp + 2, in + off + 1, 2);
+            off += 3;
+            break;
+        default:
+            IPHC_NEED(off, 1, in_len);
+            udp[0] = 0xf0;
+            udp[1] = 0xb0 | (in[off] >> 4);
+            udp[2] = 0xf0;
+            udp[3] = 0xb0 | (in[off] & 0x0f);
+            off++;
+            break;
+        }
+        IPHC_NEED(off, 2, in_len);
+        memcpy(udp + 6, in + off, 2);
+        off += 2;
+        *hdr_len += IPHC_UDP_HLEN;
+    }
+
+    if (off > sdu_len) {
+        return -1;
+    }
+    plen = sdu_len - off + *hdr_len - IPHC_IP6_HLEN;
+
+    hdr[0] = 0x60 | (tc >> 4);
+    hdr[1] = (tc << 4) | ((fl >> 16) & 0x0f);
+    hdr[2] = fl >> 8;
+    hdr[3] = fl;
+    hdr[4] = plen >> 8;
+    hdr[5] = plen;
+    hdr[6] = nh;
+    if (udp) {
+        udp[4] = plen >> 8;
+        udp[5] = plen;
+    }
+
+    return off;
+}
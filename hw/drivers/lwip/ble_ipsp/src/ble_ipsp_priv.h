@@ -0,0 +1,84 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __BLE_IPSP_PRIV_H__
+#define __BLE_IPSP_PRIV_H__
+
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BLE_IPSP_LL_LEN         6       /* BD address, MSB first */
+
+/*
+ * Dispatch values of the first byte of an IPSP SDU.
+ */
+#define BLE_IPSP_DISPATCH_IPV6  0x41    /* uncompressed IPv6 header */
+#define BLE_IPSP_DISPATCH_IPHC  0x60    /* 011xxxxx */
+#define BLE_IPSP_DISPATCH_MASK  0xe0
+
+/*
+ * Longest IPHC encoded IPv6 + UDP header, and the longest header it expands
+ * to.
+ */
+#define BLE_IPSP_IPHC_MAX       48
+#define BLE_IPSP_HDR_MAX        (40 + 8)
+
+/*
+ * Compress IPv6 header, and UDP header if one follows, at the start of
+ * pkt.
+ *
+ * @param pkt Start of the IPv6 packet.
+ * @param pkt_len Bytes available at pkt; at most BLE_IPSP_HDR_MAX are used.
+ * @param src_ll Link-layer address of the sender.
+ * @param dst_ll Link-layer address of the receiver.
+ * @param out Where to write the IPHC header; BLE_IPSP_IPHC_MAX bytes.
+ * @param consumed Set to the number of bytes at pkt which were encoded.
+ *
+ * @return int Length of IPHC header, negative if pkt is not IPv6.
+ */
+int ble_ipsp_iphc_compress(const uint8_t *pkt, int pkt_len,
+                           const uint8_t *src_ll, const uint8_t *dst_ll,
+                           uint8_t *out, int *consumed);
+
+/*
+ * Expand IPHC header at the start of an SDU.
+ *
+ * @param in Start of the SDU.
+ * @param in_len Bytes available at in.
+ * @param sdu_len Length of the whole SDU.
+ * @param src_ll Link-layer address of the sender.
+ * @param dst_ll Link-layer address of the receiver.
+ * @param hdr Where to write IPv6 (and UDP) header; BLE_IPSP_HDR_MAX bytes.
+ * @param hdr_len Set to the length of header written to hdr.
+ *
+ * @return int Number of bytes of in which were decoded, negative if the
+ *             header is malformed or uses unsupported encodings.
+ */
+int ble_ipsp_iphc_decompress(const uint8_t *in, int in_len, int sdu_len,
+                             const uint8_t *src_ll, const uint8_t *dst_ll,
+                             uint8_t *hdr, int *hdr_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BLE_IPSP_PRIV_H__ */
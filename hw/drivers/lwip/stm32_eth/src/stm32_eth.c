@@ -30,8 +30,10 @@
 #include <mcu/stm32f4_bsp.h>
 #endif
 #if MYNEWT_VAL(MCU_STM32F7)
+#include <bsp/bsp.h>
 #include <bsp/stm32f7xx_hal_conf.h>
 #include <mcu/stm32f7_bsp.h>
+#include <mcu/stm32f7_cache.h>
 #endif
 
 #include <netif/etharp.h>
@@ -39,6 +41,9 @@
 #include <lwip/tcpip.h>
 #include <lwip/ethip6.h>
 #include <string.h>
+#if MYNEWT_VAL(LWIP_MBUF_PBUF)
+#include <ip/lwip_mbuf.h>
+#endif
 
 #include "stm32_eth/stm32_eth.h"
 #include "stm32_eth/stm32_eth_cfg.h"
@@ -61,8 +66,20 @@
 #define SMSC_8710_ISR_AUTO_DONE 0x40
 #define SMSC_8710_ISR_LINK_DOWN 0x10
 
-#define STM32_ETH_RX_DESC_SZ 3
-#define STM32_ETH_TX_DESC_SZ 4
+#define STM32_ETH_RX_DESC_SZ MYNEWT_VAL(STM32_ETH_RX_DESC_CNT)
+#define STM32_ETH_TX_DESC_SZ MYNEWT_VAL(STM32_ETH_TX_DESC_CNT)
+
+#if MYNEWT_VAL(STM32_ETH_RX_INTR_DELAY)
+#define STM32_ETH_RX_DIC ETH_DMARXDESC_DIC
+#else
+#define STM32_ETH_RX_DIC 0
+#endif
+
+#if MYNEWT_VAL(STM32_ETH_HW_CSUM)
+#define STM32_ETH_TX_CIC ETH_DMATXDESC_CIC_TCPUDPICMP_FULL
+#else
+#define STM32_ETH_TX_CIC 0
+#endif
 
 struct stm32_eth_desc {
     volatile ETH_DMADescTypeDef desc;
@@ -78,6 +95,7 @@ struct stm32_eth_state {
     uint8_t st_rx_tail;
     uint8_t st_tx_head;
     uint8_t st_tx_tail;
+    uint8_t st_tx_cnt;          /* descriptors not yet reclaimed */
     struct hal_timer st_phy_tmr;
     const struct stm32_eth_cfg *cfg;
 };
@@ -88,9 +106,19 @@ struct stm32_eth_stats {
     uint32_t oerr;
     uint32_t iframe;
     uint32_t imem;
+    uint32_t ierr;
 } stm32_eth_stats;
 
+#if MYNEWT_VAL(MCU_STM32F7)
+/*
+ * Descriptors are shared with the ethernet DMA. Keep them in DTCM, which
+ * is not cached, so that the D-cache can be enabled. Frame buffers get
+ * cache maintenance as they are handed over.
+ */
+static struct stm32_eth_state stm32_eth_state sec_bss_core;
+#else
 static struct stm32_eth_state stm32_eth_state;
+#endif
 
 static void
 stm32_eth_setup_descs(struct stm32_eth_desc *descs, int cnt)
@@ -116,14 +144,25 @@ stm32_eth_fill_rx(struct stm32_eth_state *ses)
         if (sed->p) {
             break;
         }
+#if MYNEWT_VAL(LWIP_MBUF_PBUF)
+        p = lwip_mbuf_pbuf_alloc(ETH_MAX_PACKET_SIZE);
+        if (!p) {
+            p = pbuf_alloc(PBUF_RAW, ETH_MAX_PACKET_SIZE, PBUF_POOL);
+        }
+#else
         p = pbuf_alloc(PBUF_RAW, ETH_MAX_PACKET_SIZE, PBUF_POOL);
+#endif
         if (!p) {
             ++stm32_eth_stats.imem;
             break;
         }
+#if MYNEWT_VAL(MCU_STM32F7)
+        stm32f7_dcache_invalidate(p->payload, ETH_MAX_PACKET_SIZE);
+#endif
         sed->p = p;
         sed->desc.Status = 0;
-        sed->desc.ControlBufferSize = ETH_DMARXDESC_RCH | ETH_MAX_PACKET_SIZE;
+        sed->desc.ControlBufferSize = STM32_ETH_RX_DIC | ETH_DMARXDESC_RCH |
+          ETH_MAX_PACKET_SIZE;
         sed->desc.Buffer1Addr = (uint32_t)p->payload;
         sed->desc.Status = ETH_DMARXDESC_OWN;
 
@@ -153,6 +192,10 @@ stm32_eth_input(struct stm32_eth_state *ses)
         }
         p = sed->p;
         sed->p = NULL;
+        ses->st_rx_head++;
+        if (ses->st_rx_head >= STM32_ETH_RX_DESC_SZ) {
+            ses->st_rx_head = 0;
+        }
         if (!(sed->desc.Status & ETH_DMARXDESC_LS)) {
             /*
              * Incoming data spans multiple pbufs. XXX support later
@@ -160,12 +203,21 @@ stm32_eth_input(struct stm32_eth_state *ses)
             pbuf_free(p);
             continue;
         }
+        if (sed->desc.Status & ETH_DMARXDESC_ES) {
+            ++stm32_eth_stats.ierr;
+            pbuf_free(p);
+            continue;
+        }
         p->len = p->tot_len = (sed->desc.Status & ETH_DMARXDESC_FL) >> 16;
+#if MYNEWT_VAL(MCU_STM32F7)
+        /*
+         * Lines may have been speculatively read while DMA owned the buffer.
+         */
+        stm32f7_dcache_invalidate(p->payload, p->len);
+#endif
         ++stm32_eth_stats.iframe;
-        nif->input(p, nif);
-        ses->st_rx_head++;
-        if (ses->st_rx_head >= STM32_ETH_RX_DESC_SZ) {
-            ses->st_rx_head = 0;
+        if (nif->input(p, nif) != ERR_OK) {
+            pbuf_free(p);
         }
     }
 
@@ -219,29 +271,37 @@ stm32_mld_mac_filter(struct netif *nif, const ip6_addr_t *group,
 }
 #endif
 
+/*
+ * Reclaim descriptors of frames which have been sent. Called from
+ * stm32_eth_output() only once at least half of the ring is in use, so
+ * that completions get processed in batches.
+ */
 static void
 stm32_eth_output_done(struct stm32_eth_state *ses)
 {
     struct stm32_eth_desc *sed;
 
-    while (1) {
+    while (ses->st_tx_cnt) {
         sed = &ses->st_tx_descs[ses->st_tx_tail];
-        if (!sed->p) {
-            break;
-        }
         if (sed->desc.Status & ETH_DMATXDESC_OWN) {
             /*
              * Belongs to board
              */
             break;
         }
-        if (sed->desc.Status & ETH_DMATXDESC_ES) {
-            ++stm32_eth_stats.oerr;
-        } else {
-            ++stm32_eth_stats.odone;
+        if (sed->p) {
+            /*
+             * Last descriptor of a frame.
+             */
+            if (sed->desc.Status & ETH_DMATXDESC_ES) {
+                ++stm32_eth_stats.oerr;
+            } else {
+                ++stm32_eth_stats.odone;
+            }
+            pbuf_free(sed->p);
+            sed->p = NULL;
         }
-        pbuf_free(sed->p);
-        sed->p = NULL;
+        ses->st_tx_cnt--;
         ses->st_tx_tail++;
         if (ses->st_tx_tail >= STM32_ETH_TX_DESC_SZ) {
             ses->st_tx_tail = 0;
@@ -256,24 +316,35 @@ stm32_eth_output(struct netif *nif, struct pbuf *p)
     struct stm32_eth_desc *sed;
     uint32_t reg;
     struct pbuf *q;
+    struct pbuf *last;
     err_t errval;
-
-    stm32_eth_output_done(ses);
+    int first;
+    int cnt;
+    int i;
 
     ++stm32_eth_stats.oframe;
-    sed = &ses->st_tx_descs[ses->st_tx_head];
+    cnt = 0;
+    last = NULL;
     for (q = p; q; q = q->next) {
-        if (!q->len) {
-            continue;
-        }
-        if (sed->desc.Status & ETH_DMATXDESC_OWN) {
-            /*
-             * Not enough space.
-             */
-            errval = ERR_MEM;
-            goto error;
+        if (q->len) {
+            cnt++;
+            last = q;
         }
-        sed = (struct stm32_eth_desc *)sed->desc.Buffer2NextDescAddr;
+    }
+    if (!cnt) {
+        return ERR_OK;
+    }
+    first = ses->st_tx_head;
+    if (ses->st_tx_cnt + cnt > STM32_ETH_TX_DESC_SZ ||
+      ses->st_tx_cnt >= STM32_ETH_TX_DESC_SZ / 2) {
+        stm32_eth_output_done(ses);
+    }
+    if (ses->st_tx_cnt + cnt > STM32_ETH_TX_DESC_SZ) {
+        /*
+         * Not enough space.
+         */
+        errval = ERR_MEM;
+        goto error;
     }
 
     for (q = p; q; q = q->next) {
@@ -282,25 +353,43 @@ stm32_eth_output(struct netif *nif, struct pbuf *p)
         }
         sed = &ses->st_tx_descs[ses->st_tx_head];
         if (q == p) {
-            reg = ETH_DMATXDESC_FS | ETH_DMATXDESC_TCH;
+            reg = ETH_DMATXDESC_FS | ETH_DMATXDESC_TCH | STM32_ETH_TX_CIC;
         } else {
             reg = ETH_DMATXDESC_TCH;
         }
-        if (q->next == NULL) {
+        if (q == last) {
+            /*
+             * Reference to frame is held by the last descriptor.
+             */
             reg |= ETH_DMATXDESC_LS;
+            sed->p = p;
+            pbuf_ref(p);
         }
         sed->desc.Status = reg;
-        sed->desc.ControlBufferSize = p->len;
-        sed->desc.Buffer1Addr = (uint32_t)p->payload;
-        sed->p = p;
-        pbuf_ref(p);
-        sed->desc.Status = reg | ETH_DMATXDESC_OWN;
+        sed->desc.ControlBufferSize = q->len;
+        sed->desc.Buffer1Addr = (uint32_t)q->payload;
+#if MYNEWT_VAL(MCU_STM32F7)
+        stm32f7_dcache_clean(q->payload, q->len);
+#endif
+        ses->st_tx_cnt++;
         ses->st_tx_head++;
         if (ses->st_tx_head >= STM32_ETH_TX_DESC_SZ) {
             ses->st_tx_head = 0;
         }
     }
 
+    /*
+     * Hand over descriptors to DMA, first one last.
+     */
+    i = ses->st_tx_head;
+    do {
+        if (i == 0) {
+            i = STM32_ETH_TX_DESC_SZ;
+        }
+        i--;
+        ses->st_tx_descs[i].desc.Status |= ETH_DMATXDESC_OWN;
+    } while (i != first);
+
     if (ses->st_eth.Instance->DMASR & ETH_DMASR_TBUS) {
         /*
          * Resume DMA transmission.
@@ -372,6 +461,9 @@ stm32_lwip_init(struct netif *nif)
     nif->mtu = 1500;
     nif->hwaddr_len = ETHARP_HWADDR_LEN;
     nif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP;
+#if MYNEWT_VAL(STM32_ETH_HW_CSUM)
+    NETIF_SET_CHECKSUM_CTRL(nif, NETIF_CHECKSUM_DISABLE_ALL);
+#endif
 
 #if LWIP_IGMP
     nif->flags |= NETIF_FLAG_IGMP;
@@ -418,6 +510,7 @@ stm32_lwip_init(struct netif *nif)
     ses->st_rx_tail = 0;
     ses->st_tx_head = 0;
     ses->st_tx_tail = 0;
+    ses->st_tx_cnt = 0;
 
     stm32_eth_setup_descs(ses->st_rx_descs, STM32_ETH_RX_DESC_SZ);
     stm32_eth_setup_descs(ses->st_tx_descs, STM32_ETH_TX_DESC_SZ);
@@ -433,6 +526,14 @@ stm32_lwip_init(struct netif *nif)
     ses->st_eth.Instance->MACFFR |= ETH_MULTICASTFRAMESFILTER_NONE;
     ses->st_eth.Instance->DMATDLAR = (uint32_t)ses->st_tx_descs;
     ses->st_eth.Instance->DMARDLAR = (uint32_t)ses->st_rx_descs;
+#if MYNEWT_VAL(STM32_ETH_RX_INTR_DELAY)
+    /*
+     * RX descriptors have interrupt on completion disabled; receive
+     * watchdog raises the interrupt instead.
+     */
+    __HAL_ETH_SET_RECEIVE_WATCHDOG_TIMER(&ses->st_eth,
+      MYNEWT_VAL(STM32_ETH_RX_INTR_DELAY));
+#endif
 
     /*
      * Generate an interrupt when link state changes
@@ -17,6 +17,9 @@
  * under the License.
  */
 
+#include <string.h>
+#include "syscfg/syscfg.h"
+#include <os/os.h>
 #include <hal/hal_spi.h>
 #include <hal/hal_gpio.h>
 #include <disk/disk.h>
@@ -37,6 +40,7 @@
 #define CMD25               (25)           /* WRITE_MULTIPLE_BLOCK */
 #define CMD55               (55)           /* APP_CMD */
 #define CMD58               (58)           /* READ_OCR */
+#define ACMD23              (0x80 + 23)    /* SET_WR_BLK_ERASE_COUNT (SDC) */
 #define ACMD41              (0x80 + 41)    /* SEND_OP_COND (SDC) */
 
 #define HCS                 ((uint32_t) 1 << 30)
@@ -63,14 +67,16 @@
 
 #define BLOCK_LEN           (512)
 
+/* MMC initialization accepts clocks in the range 100-400KHz */
+#define INIT_BAUDRATE       (100)
+
 static uint8_t g_block_buf[BLOCK_LEN];
 
 static struct hal_spi_settings mmc_settings = {
     .data_order = HAL_SPI_MSB_FIRST,
     .data_mode  = HAL_SPI_MODE0,
-    /* XXX: MMC initialization accepts clocks in the range 100-400KHz */
-    /* TODO: switch to high-speed aka 25MHz after initialization. */
-    .baudrate   = 100,
+    /* Switched to MMC_SPI_BAUDRATE once the card is initialized */
+    .baudrate   = INIT_BAUDRATE,
     .word_size  = HAL_SPI_WORD_SIZE_8BIT,
 };
 
@@ -80,6 +86,9 @@ static struct mmc_cfg {
     int                      ss_pin;
     void                     *spi_cfg;
     struct hal_spi_settings  *settings;
+#if MYNEWT_VAL(MMC_SPI_NOBLOCK)
+    struct os_task           *xfer_task;
+#endif
 } g_mmc_cfg;
 
 static int
@@ -166,6 +175,89 @@ send_mmc_cmd(struct mmc_cfg *mmc, uint8_t cmd, uint32_t payload)
     return status;
 }
 
+#if MYNEWT_VAL(MMC_SPI_NOBLOCK)
+static void
+mmc_txrx_cb(void *arg, int len)
+{
+    struct mmc_cfg *mmc;
+
+    mmc = arg;
+    os_task_notify(mmc->xfer_task, OS_TASK_NOTIFY_IO);
+}
+#endif
+
+/**
+ * Transfer a whole data block; with MMC_SPI_NOBLOCK the block is moved by
+ * the SPI driver (DMA where the MCU has it) while this task sleeps.
+ */
+static int
+mmc_txrx(struct mmc_cfg *mmc, void *txbuf, void *rxbuf, int len)
+{
+#if MYNEWT_VAL(MMC_SPI_NOBLOCK)
+    int rc;
+
+    /* Drop a completion left over from an earlier, aborted transfer. */
+    mmc->xfer_task = os_sched_get_current_task();
+    os_task_notify_clear(OS_TASK_NOTIFY_IO);
+
+    rc = hal_spi_txrx_noblock(mmc->spi_num, txbuf, rxbuf, len);
+    if (rc) {
+        return rc;
+    }
+
+    if (os_task_notify_wait(OS_TASK_NOTIFY_IO, OS_TICKS_PER_SEC / 10, NULL)) {
+        hal_spi_abort(mmc->spi_num);
+        return MMC_TIMEOUT;
+    }
+
+    return 0;
+#else
+    return hal_spi_txrx(mmc->spi_num, txbuf, rxbuf, len);
+#endif
+}
+
+/**
+ * 7.3.3 Control tokens
+ *   Wait up to 200ms for a control token.  Cards usually answer within a
+ *   few bytes, so poll at full speed for a while before sleeping between
+ *   polls; this runs once per block of a multi-block read.
+ */
+static uint8_t
+wait_token(struct mmc_cfg *mmc)
+{
+    os_time_t timeout;
+    uint8_t res;
+    int n;
+
+    timeout = os_time_get() + OS_TICKS_PER_SEC / 5;
+    n = 0;
+    do {
+        res = hal_spi_tx_val(mmc->spi_num, 0xff);
+        if (res != 0xff) break;
+        if (++n > BLOCK_LEN) {
+            os_time_delay(1);
+        }
+    } while (OS_TIME_TICK_LT(os_time_get(), timeout));
+
+    return res;
+}
+
+/**
+ * Switch the SPI clock; the SPI must be disabled while it is reconfigured.
+ */
+static int
+mmc_set_baudrate(struct mmc_cfg *mmc, uint32_t baudrate)
+{
+    int rc;
+
+    hal_spi_disable(mmc->spi_num);
+    mmc->settings->baudrate = baudrate;
+    rc = hal_spi_config(mmc->spi_num, mmc->settings);
+    hal_spi_enable(mmc->spi_num);
+
+    return rc;
+}
+
 /**
  * Initialize the MMC driver
  *
@@ -193,6 +285,7 @@ mmc_init(int spi_num, void *spi_cfg, int ss_pin)
     mmc->ss_pin = ss_pin;
     mmc->spi_cfg = spi_cfg;
     mmc->settings = &mmc_settings;
+    mmc->settings->baudrate = INIT_BAUDRATE;
 
     hal_gpio_init_out(mmc->ss_pin, 1);
 
@@ -206,7 +299,11 @@ mmc_init(int spi_num, void *spi_cfg, int ss_pin)
         return (rc);
     }
 
+#if MYNEWT_VAL(MMC_SPI_NOBLOCK)
+    hal_spi_set_txrx_cb(mmc->spi_num, mmc_txrx_cb, mmc);
+#else
     hal_spi_set_txrx_cb(mmc->spi_num, NULL, NULL);
+#endif
     hal_spi_enable(mmc->spi_num);
 
     /**
@@ -332,6 +429,16 @@ mmc_init(int spi_num, void *spi_cfg, int ss_pin)
 
 out:
     hal_gpio_write(mmc->ss_pin, 1);
+
+    /**
+     * Data transfers run at the full clock; if the HAL can't do the requested
+     * rate stay at the initialization rate.
+     */
+    if (rc == MMC_OK &&
+        mmc_set_baudrate(mmc, MYNEWT_VAL(MMC_SPI_BAUDRATE))) {
+        mmc_set_baudrate(mmc, INIT_BAUDRATE);
+    }
+
     return rc;
 }
 
@@ -356,6 +463,25 @@ wait_busy(struct mmc_cfg *mmc)
     return res;
 }
 
+/**
+ * Clock in one data block.  The destination is filled with 0xff and sent
+ * back out in place, so no separate dummy transmit buffer is needed.
+ */
+static int
+read_block(struct mmc_cfg *mmc, uint8_t *dst)
+{
+    int rc;
+
+    memset(dst, 0xff, BLOCK_LEN);
+    rc = mmc_txrx(mmc, dst, dst, BLOCK_LEN);
+
+    /* TODO: CRC-16 not used here but would be cool to have */
+    hal_spi_tx_val(mmc->spi_num, 0xff);
+    hal_spi_tx_val(mmc->spi_num, 0xff);
+
+    return rc;
+}
+
 /**
  * @return 0 on success, non-zero on failure
  */
@@ -365,14 +491,13 @@ mmc_read(uint8_t mmc_id, uint32_t addr, void *buf, uint32_t len)
     uint8_t cmd;
     uint8_t res;
     int rc;
-    uint32_t n;
     size_t block_len;
     size_t block_count;
-    os_time_t timeout;
     uint32_t block_addr;
     size_t offset;
     size_t index;
     size_t amount;
+    uint8_t *dst;
     struct mmc_cfg *mmc;
 
     mmc = mmc_cfg_dev(mmc_id);
@@ -396,38 +521,34 @@ mmc_read(uint8_t mmc_id, uint32_t addr, void *buf, uint32_t len)
         goto out;
     }
 
-    /**
-     * 7.3.3 Control tokens
-     *   Wait up to 200ms for control token.
-     */
-    timeout = os_time_get() + OS_TICKS_PER_SEC / 5;
-    do {
-        res = hal_spi_tx_val(mmc->spi_num, 0xff);
-        if (res != 0xFF) break;
-        os_time_delay(OS_TICKS_PER_SEC / 20);
-    } while (os_time_get() < timeout);
-
-    /**
-     * 7.3.3.2 Start Block Tokens and Stop Tran Token
-     */
-    if (res != START_BLOCK) {
-        rc = MMC_TIMEOUT;
-        goto out;
-    }
-
     index = 0;
     while (block_count--) {
-        for (n = 0; n < BLOCK_LEN; n++) {
-            g_block_buf[n] = hal_spi_tx_val(mmc->spi_num, 0xff);
+        /**
+         * 7.3.3.2 Start Block Tokens and Stop Tran Token
+         *   Every block of a multiple block read has its own start token.
+         */
+        res = wait_token(mmc);
+        if (res != START_BLOCK) {
+            rc = MMC_TIMEOUT;
+            break;
         }
 
-        /* TODO: CRC-16 not used here but would be cool to have */
-        hal_spi_tx_val(mmc->spi_num, 0xff);
-        hal_spi_tx_val(mmc->spi_num, 0xff);
-
+        /* Whole blocks go straight to the caller's buffer */
         amount = MIN(BLOCK_LEN - offset, len);
+        if (amount == BLOCK_LEN) {
+            dst = (uint8_t *)buf + index;
+        } else {
+            dst = g_block_buf;
+        }
+
+        if (read_block(mmc, dst)) {
+            rc = MMC_READ_ERROR;
+            break;
+        }
 
-        memcpy(((uint8_t *)buf + index), &g_block_buf[offset], amount);
+        if (dst == g_block_buf) {
+            memcpy(((uint8_t *)buf + index), &g_block_buf[offset], amount);
+        }
 
         offset = 0;
         len -= amount;
@@ -452,14 +573,13 @@ mmc_write(uint8_t mmc_id, uint32_t addr, const void *buf, uint32_t len)
 {
     uint8_t cmd;
     uint8_t res;
-    uint32_t n;
     size_t block_len;
     size_t block_count;
-    os_time_t timeout;
     uint32_t block_addr;
     size_t offset;
     size_t index;
     size_t amount;
+    const uint8_t *src;
     int rc;
     struct mmc_cfg *mmc;
 
@@ -490,28 +610,29 @@ mmc_write(uint8_t mmc_id, uint32_t addr, const void *buf, uint32_t len)
             goto out;
         }
 
-        timeout = os_time_get() + OS_TICKS_PER_SEC / 5;
-        do {
-            res = hal_spi_tx_val(mmc->spi_num, 0xff);
-            if (res != 0xff) break;
-            os_time_delay(OS_TICKS_PER_SEC / 20);
-        } while (os_time_get() < timeout);
-
+        res = wait_token(mmc);
         if (res != START_BLOCK) {
             rc = MMC_CARD_ERROR;
             goto out;
         }
 
-        for (n = 0; n < BLOCK_LEN; n++) {
-            g_block_buf[n] = hal_spi_tx_val(mmc->spi_num, 0xff);
+        if (read_block(mmc, g_block_buf)) {
+            rc = MMC_READ_ERROR;
+            goto out;
         }
-
-        hal_spi_tx_val(mmc->spi_num, 0xff);
-        hal_spi_tx_val(mmc->spi_num, 0xff);
     }
 
     /* now start write */
 
+    if (block_count > 1) {
+        /**
+         * Pre-erase the blocks about to be written, which speeds up
+         * multiple block writes.  This is only a hint and MMC cards don't
+         * know the command, so the response is ignored.
+         */
+        send_mmc_cmd(mmc, ACMD23, block_count);
+    }
+
     cmd = (block_count == 1) ? CMD24 : CMD25;
     res = send_mmc_cmd(mmc, cmd, block_addr);
     if (res) {
@@ -530,11 +651,18 @@ mmc_write(uint8_t mmc_id, uint32_t addr, const void *buf, uint32_t len)
             hal_spi_tx_val(mmc->spi_num, START_BLOCK_TOKEN);
         }
 
+        /* Whole blocks are sent straight from the caller's buffer */
         amount = MIN(BLOCK_LEN - offset, len);
-        memcpy(&g_block_buf[offset], ((uint8_t *)buf + index), amount);
+        if (amount == BLOCK_LEN) {
+            src = (const uint8_t *)buf + index;
+        } else {
+            memcpy(&g_block_buf[offset], ((uint8_t *)buf + index), amount);
+            src = g_block_buf;
+        }
 
-        for (n = 0; n < BLOCK_LEN; n++) {
-            hal_spi_tx_val(mmc->spi_num, g_block_buf[n]);
+        if (mmc_txrx(mmc, (void *)src, NULL, BLOCK_LEN)) {
+            res = 0;
+            break;
         }
 
         /* CRC */
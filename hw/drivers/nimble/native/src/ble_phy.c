@@ -593,6 +593,23 @@ ble_phy_max_data_pdu_pyld(void)
     return BLE_LL_DATA_PDU_MAX_PYLD;
 }
 
+/**
+ * Sets the PHY mode used for both transmit and receive. This PHY only
+ * supports the 1M PHY.
+ *
+ * @param phy_mode The PHY mode
+ *
+ * @return int 0: success; PHY error code otherwise
+ */
+int
+ble_phy_mode_set(uint8_t phy_mode)
+{
+    if (phy_mode != BLE_PHY_MODE_1M) {
+        return BLE_PHY_ERR_INV_PARAM;
+    }
+    return 0;
+}
+
 #if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PRIVACY) == 1)
 void
 ble_phy_resolv_list_enable(void)
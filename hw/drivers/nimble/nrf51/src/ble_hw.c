@@ -27,6 +27,7 @@
 #include "nimble/nimble_opt.h"
 #include "nrf51_bitfields.h"
 #include "controller/ble_hw.h"
+#include "hal/hal_aes.h"
 #include "bsp/cmsis_nvic.h"
 
 /* Total number of resolving list elements */
@@ -241,38 +242,11 @@ ble_hw_whitelist_match(void)
     return (int)NRF_RADIO->EVENTS_DEVMATCH;
 }
 
-/* Encrypt data */
+/* Encrypt data; shares the ECB arbitration of the MCU HAL */
 int
 ble_hw_encrypt_block(struct ble_encryption_block *ecb)
 {
-    int rc;
-    uint32_t end;
-    uint32_t err;
-
-    /* Stop ECB */
-    NRF_ECB->TASKS_STOPECB = 1;
-    /* XXX: does task stop clear these counters? Anyway to do this quicker? */
-    NRF_ECB->EVENTS_ENDECB = 0;
-    NRF_ECB->EVENTS_ERRORECB = 0;
-    NRF_ECB->ECBDATAPTR = (uint32_t)ecb;
-
-    /* Start ECB */
-    NRF_ECB->TASKS_STARTECB = 1;
-
-    /* Wait till error or done */
-    rc = 0;
-    while (1) {
-        end = NRF_ECB->EVENTS_ENDECB;
-        err = NRF_ECB->EVENTS_ERRORECB;
-        if (end || err) {
-            if (err) {
-                rc = -1;
-            }
-            break;
-        }
-    }
-
-    return rc;
+    return hal_aes128_encrypt(ecb->key, ecb->plain_text, ecb->cipher_text);
 }
 
 /**
@@ -82,6 +82,7 @@ struct ble_phy_obj
     uint8_t *rxdptr;
     uint32_t phy_aar_scratch;
     uint32_t phy_access_address;
+    uint32_t phy_data_access_addr;
     struct ble_mbuf_hdr rxhdr;
     void *txend_arg;
     ble_phy_tx_end_func txend_cb;
@@ -116,6 +117,8 @@ STATS_SECT_START(ble_phy_stats)
     STATS_SECT_ENTRY(radio_state_errs)
     STATS_SECT_ENTRY(rx_hw_err)
     STATS_SECT_ENTRY(tx_hw_err)
+    STATS_SECT_ENTRY(rx_tx_tifs_miss)
+    STATS_SECT_ENTRY(tx_rx_tifs_miss)
 STATS_SECT_END
 STATS_SECT_DECL(ble_phy_stats) ble_phy_stats;
 
@@ -133,6 +136,8 @@ STATS_NAME_START(ble_phy_stats)
     STATS_NAME(ble_phy_stats, radio_state_errs)
     STATS_NAME(ble_phy_stats, rx_hw_err)
     STATS_NAME(ble_phy_stats, tx_hw_err)
+    STATS_NAME(ble_phy_stats, rx_tx_tifs_miss)
+    STATS_NAME(ble_phy_stats, tx_rx_tifs_miss)
 STATS_NAME_END(ble_phy_stats)
 
 /*
@@ -412,7 +417,7 @@ ble_phy_wfr_enable(int txrx, uint32_t wfr_usecs)
 /**
  * Setup transceiver for receive.
  */
-static void
+static BLE_LL_RAMFUNC void
 ble_phy_rx_xcvr_setup(void)
 {
     uint8_t *dptr;
@@ -492,7 +497,7 @@ ble_phy_rx_xcvr_setup(void)
  * Called from interrupt context when the transmit ends
  *
  */
-static void
+static BLE_LL_RAMFUNC void
 ble_phy_tx_end_isr(void)
 {
     uint8_t was_encrypted;
@@ -554,6 +559,14 @@ ble_phy_tx_end_isr(void)
 
     transition = g_ble_phy_data.phy_transition;
     if (transition == BLE_PHY_TRANSITION_TX_RX) {
+        /*
+         * The radio latches the packet pointer when it starts receiving. If
+         * it already has, we were too slow getting here.
+         */
+        if (NRF_RADIO->STATE == RADIO_STATE_STATE_Rx) {
+            STATS_INC(ble_phy_stats, tx_rx_tifs_miss);
+        }
+
         /* Packet pointer needs to be reset. */
         ble_phy_rx_xcvr_setup();
 
@@ -591,7 +604,7 @@ ble_phy_tx_end_isr(void)
     }
 }
 
-static void
+static BLE_LL_RAMFUNC void
 ble_phy_rx_end_isr(void)
 {
     int rc;
@@ -669,7 +682,7 @@ ble_phy_rx_end_isr(void)
     }
 }
 
-static void
+static BLE_LL_RAMFUNC void
 ble_phy_rx_start_isr(void)
 {
     int rc;
@@ -761,11 +774,13 @@ ble_phy_rx_start_isr(void)
     STATS_INC(ble_phy_stats, rx_starts);
 }
 
-static void
+static BLE_LL_RAMFUNC void
 ble_phy_isr(void)
 {
     uint32_t irq_en;
 
+    os_trace_isr_enter(RADIO_IRQn);
+
     /* Read irq register to determine which interrupts are enabled */
     irq_en = NRF_RADIO->INTENCLR;
 
@@ -807,6 +822,8 @@ ble_phy_isr(void)
 
     /* Count # of interrupts */
     STATS_INC(ble_phy_stats, phy_isrs);
+
+    os_trace_isr_exit();
 }
 
 /**
@@ -862,6 +879,9 @@ ble_phy_init(void)
     NRF_RADIO->BASE0 = (BLE_ACCESS_ADDR_ADV << 8) & 0xFFFFFF00;
     NRF_RADIO->PREFIX0 = (BLE_ACCESS_ADDR_ADV >> 24) & 0xFF;
 
+    /* Logical address 1 is unconfigured (0 is not a valid access address) */
+    g_ble_phy_data.phy_data_access_addr = 0;
+
     /* Configure the CRC registers */
     NRF_RADIO->CRCCNF = RADIO_CRCCNF_SKIPADDR_Msk | RADIO_CRCCNF_LEN_Three;
 
@@ -1289,6 +1309,10 @@ ble_phy_tx(struct os_mbuf *txpdu, uint8_t end_trans)
     } else {
         ble_phy_disable();
         STATS_INC(ble_phy_stats, tx_late);
+        if (g_ble_phy_data.phy_state == BLE_PHY_STATE_RX) {
+            /* Turnaround transmit started before the pdu was ready */
+            STATS_INC(ble_phy_stats, rx_tx_tifs_miss);
+        }
         rc = BLE_PHY_ERR_RADIO_STATE;
     }
 
@@ -1384,12 +1408,19 @@ ble_phy_setchan(uint8_t chan, uint32_t access_addr, uint32_t crcinit)
         /* Set current access address */
         g_ble_phy_data.phy_access_address = access_addr;
 
-        /* Configure logical address 1 and crcinit */
-        prefix = NRF_RADIO->PREFIX0;
-        prefix &= 0xffff00ff;
-        prefix |= ((access_addr >> 24) & 0xFF) << 8;
-        NRF_RADIO->BASE1 = (access_addr << 8) & 0xFFFFFF00;
-        NRF_RADIO->PREFIX0 = prefix;
+        /*
+         * Configure logical address 1. Advertising only uses logical
+         * address 0, so this only needs doing when we move to a connection
+         * with a different access address.
+         */
+        if (access_addr != g_ble_phy_data.phy_data_access_addr) {
+            prefix = NRF_RADIO->PREFIX0;
+            prefix &= 0xffff00ff;
+            prefix |= ((access_addr >> 24) & 0xFF) << 8;
+            NRF_RADIO->BASE1 = (access_addr << 8) & 0xFFFFFF00;
+            NRF_RADIO->PREFIX0 = prefix;
+            g_ble_phy_data.phy_data_access_addr = access_addr;
+        }
         NRF_RADIO->TXADDRESS = 1;
         NRF_RADIO->RXADDRESSES = (1 << 1);
         NRF_RADIO->CRCINIT = crcinit;
@@ -1537,6 +1568,23 @@ ble_phy_max_data_pdu_pyld(void)
 #endif
 }
 
+/**
+ * Sets the PHY mode used for both transmit and receive. This PHY only
+ * supports the 1M PHY.
+ *
+ * @param phy_mode The PHY mode
+ *
+ * @return int 0: success; PHY error code otherwise
+ */
+int
+ble_phy_mode_set(uint8_t phy_mode)
+{
+    if (phy_mode != BLE_PHY_MODE_1M) {
+        return BLE_PHY_ERR_INV_PARAM;
+    }
+    return 0;
+}
+
 #if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PRIVACY) == 1)
 void
 ble_phy_resolv_list_enable(void)
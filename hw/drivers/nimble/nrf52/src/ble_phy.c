@@ -55,7 +55,21 @@ extern uint32_t g_nrf_irk_list[];
 /* Maximum length of frames */
 #define NRF_MAXLEN              (255)
 #define NRF_BALEN               (3)     /* For base address of 3 bytes */
-#define NRF_RX_START_OFFSET     (5)
+
+/*
+ * 2 Mbps radio mode. The nrf52832 supports this mode; it is not defined in
+ * its bitfield header.
+ */
+#ifndef RADIO_MODE_MODE_Ble_2Mbit
+#define RADIO_MODE_MODE_Ble_2Mbit   (4UL)
+#endif
+
+/*
+ * Time, in usecs, from the start of the preamble to the end of the access
+ * address. The 2M PHY has a 2 byte preamble.
+ */
+#define NRF_HDR_USECS_1M        (40)
+#define NRF_HDR_USECS_2M        (24)
 
 /* Maximum tx power */
 #define NRF_TX_PWR_MAX_DBM      (4)
@@ -73,9 +87,15 @@ struct ble_phy_obj
     uint8_t phy_encrypted;
     uint8_t phy_privacy;
     uint8_t phy_tx_pyld_len;
+    uint8_t phy_mode;
+    uint32_t phy_ccm_datarate;
     uint32_t phy_aar_scratch;
     uint32_t phy_access_address;
     struct ble_mbuf_hdr rxhdr;
+#if MYNEWT_VAL(BLE_PHY_RX_ZERO_COPY)
+    uint8_t *phy_rx_dptr;       /* Where the radio writes the current pdu */
+    struct os_mbuf *phy_rxpdu;  /* Mbuf the radio receives into */
+#endif
     void *txend_arg;
     ble_phy_tx_end_func txend_cb;
 #if MYNEWT_VAL(OS_CPUTIME_FREQ) == 32768
@@ -109,6 +129,7 @@ STATS_SECT_START(ble_phy_stats)
     STATS_SECT_ENTRY(radio_state_errs)
     STATS_SECT_ENTRY(rx_hw_err)
     STATS_SECT_ENTRY(tx_hw_err)
+    STATS_SECT_ENTRY(rx_no_mbuf)
 STATS_SECT_END
 STATS_SECT_DECL(ble_phy_stats) ble_phy_stats;
 
@@ -126,6 +147,7 @@ STATS_NAME_START(ble_phy_stats)
     STATS_NAME(ble_phy_stats, radio_state_errs)
     STATS_NAME(ble_phy_stats, rx_hw_err)
     STATS_NAME(ble_phy_stats, tx_hw_err)
+    STATS_NAME(ble_phy_stats, rx_no_mbuf)
 STATS_NAME_END(ble_phy_stats)
 
 /*
@@ -182,6 +204,21 @@ struct nrf_ccm_data
 struct nrf_ccm_data g_nrf_ccm_data;
 #endif
 
+/**
+ * Returns the time it takes to receive the preamble and access address on
+ * the current PHY mode.
+ *
+ * @return uint32_t Header time in usecs
+ */
+static uint32_t
+ble_phy_hdr_usecs(void)
+{
+    if (g_ble_phy_data.phy_mode == BLE_PHY_MODE_2M) {
+        return NRF_HDR_USECS_2M;
+    }
+    return NRF_HDR_USECS_1M;
+}
+
 /**
  * Copies the data from the phy receive buffer into a mbuf chain.
  *
@@ -204,10 +241,21 @@ ble_phy_rxpdu_copy(uint8_t *dptr, struct os_mbuf *rxpdu)
     struct ble_mbuf_hdr *ble_hdr;
     struct os_mbuf_pkthdr *pkthdr;
 
+    pkthdr = OS_MBUF_PKTHDR(rxpdu);
+
+#if MYNEWT_VAL(BLE_PHY_RX_ZERO_COPY)
+    /* Nothing to copy if the pdu was received directly into this mbuf */
+    if (dptr == rxpdu->om_data) {
+        rxpdu->om_len = pkthdr->omp_len;
+        ble_hdr = BLE_MBUF_HDR_PTR(rxpdu);
+        memcpy(ble_hdr, &g_ble_phy_data.rxhdr, sizeof(struct ble_mbuf_hdr));
+        return;
+    }
+#endif
+
     /* Better be aligned */
     assert(((uint32_t)dptr & 3) == 0);
 
-    pkthdr = OS_MBUF_PKTHDR(rxpdu);
     rem_bytes = pkthdr->omp_len;
 
     /* Fill in the mbuf pkthdr first. */
@@ -260,6 +308,72 @@ ble_phy_rxpdu_copy(uint8_t *dptr, struct os_mbuf *rxpdu)
     memcpy(ble_hdr, &g_ble_phy_data.rxhdr, sizeof(struct ble_mbuf_hdr));
 }
 
+#if MYNEWT_VAL(BLE_PHY_RX_ZERO_COPY)
+/**
+ * Hands the mbuf that the current pdu was received into to the caller. A
+ * new mbuf is allocated for the radio the next time receive is set up.
+ *
+ * @param len Total length of the received pdu (header plus payload)
+ *
+ * @return struct os_mbuf* The received pdu, or NULL if the pdu was received
+ * into the static receive buffer and must be copied.
+ */
+struct os_mbuf *
+ble_phy_rxpdu_take(uint16_t len)
+{
+    struct os_mbuf *m;
+
+    m = g_ble_phy_data.phy_rxpdu;
+    if ((m == NULL) || (g_ble_phy_data.phy_rx_dptr != (m->om_data - 1))) {
+        return NULL;
+    }
+
+    OS_MBUF_PKTHDR(m)->omp_len = len;
+    g_ble_phy_data.phy_rxpdu = NULL;
+    return m;
+}
+
+/**
+ * Returns the address the radio should receive the next pdu at. This is the
+ * data area of a preallocated msys mbuf when one is available; otherwise
+ * the static receive buffer is used.
+ *
+ * NOTE: the radio writes the S1 byte, which is removed after reception, so
+ * the pdu is placed one byte before om_data.
+ */
+static uint8_t *
+ble_phy_rx_dptr_get(void)
+{
+    struct os_mbuf *m;
+    uint8_t *dptr;
+
+    m = g_ble_phy_data.phy_rxpdu;
+    if (m == NULL) {
+        m = os_msys_get_pkthdr(BLE_PHY_MAX_PDU_LEN,
+                               sizeof(struct ble_mbuf_hdr));
+        if (m != NULL) {
+            m->om_data += 4;
+            if (OS_MBUF_TRAILINGSPACE(m) < BLE_PHY_MAX_PDU_LEN) {
+                os_mbuf_free_chain(m);
+                m = NULL;
+            }
+        }
+        g_ble_phy_data.phy_rxpdu = m;
+    }
+
+    if (m != NULL) {
+        dptr = m->om_data - 1;
+    } else {
+        STATS_INC(ble_phy_stats, rx_no_mbuf);
+        dptr = (uint8_t *)&g_ble_phy_rx_buf[0];
+        dptr += 3;
+    }
+    g_ble_phy_data.phy_rx_dptr = dptr;
+
+    return dptr;
+}
+#endif
+
 /**
  * Called when we want to wait if the radio is in either the rx or tx
  * disable states. We want to wait until that state is over before doing
@@ -387,15 +501,13 @@ ble_phy_wfr_enable(int txrx, uint32_t wfr_usecs)
          * from the transmit end. We add additional time to make sure the
          * address event comes before the compare. Note that transmit end
          * is captured in CC[2]
-         *
-         * XXX: this assumes 1Mbps as 40 usecs is header rx time for 1Mbps
          */
-        end_time = NRF_TIMER0->CC[2] + BLE_LL_IFS + 40 + 16;
+        end_time = NRF_TIMER0->CC[2] + BLE_LL_IFS + ble_phy_hdr_usecs() + 16;
     } else {
         /* CC[0] is set to when RXEN occurs. NOTE: the extra 16 usecs is
            jitter */
         end_time = NRF_TIMER0->CC[0] + XCVR_RX_START_DELAY_USECS + wfr_usecs +
-            40 + 16;
+            ble_phy_hdr_usecs() + 16;
     }
 
     /* wfr_secs is the time from rxen until timeout */
@@ -418,8 +530,12 @@ ble_phy_rx_xcvr_setup(void)
 {
     uint8_t *dptr;
 
+#if MYNEWT_VAL(BLE_PHY_RX_ZERO_COPY)
+    dptr = ble_phy_rx_dptr_get();
+#else
     dptr = (uint8_t *)&g_ble_phy_rx_buf[0];
     dptr += 3;
+#endif
 
 #if MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_ENCRYPTION)
     if (g_ble_phy_data.phy_encrypted) {
@@ -427,7 +543,8 @@ ble_phy_rx_xcvr_setup(void)
         NRF_CCM->INPTR = (uint32_t)&g_ble_phy_enc_buf[0];
         NRF_CCM->OUTPTR = (uint32_t)dptr;
         NRF_CCM->SCRATCHPTR = (uint32_t)&g_nrf_encrypt_scratchpad[0];
-        NRF_CCM->MODE = CCM_MODE_LENGTH_Msk | CCM_MODE_MODE_Decryption;
+        NRF_CCM->MODE = CCM_MODE_LENGTH_Msk | CCM_MODE_MODE_Decryption |
+                        g_ble_phy_data.phy_ccm_datarate;
         NRF_CCM->CNFPTR = (uint32_t)&g_nrf_ccm_data;
         NRF_CCM->SHORTS = 0;
         NRF_CCM->EVENTS_ERROR = 0;
@@ -559,8 +676,8 @@ ble_phy_tx_end_isr(void)
 #if (MYNEWT_VAL(OS_CPUTIME_FREQ) == 32768)
         ble_phy_wfr_enable(BLE_PHY_WFR_ENABLE_TXRX, 0);
 #else
-        wfr_time = BLE_LL_WFR_USECS - BLE_TX_LEN_USECS_M(NRF_RX_START_OFFSET);
-        wfr_time += BLE_TX_DUR_USECS_M(txlen);
+        wfr_time = BLE_LL_WFR_USECS - ble_phy_hdr_usecs();
+        wfr_time += BLE_TX_DUR_USECS_PHY(txlen, g_ble_phy_data.phy_mode);
         wfr_time = os_cputime_usecs_to_ticks(wfr_time);
         ble_ll_wfr_enable(txstart + wfr_time);
 #endif
@@ -602,8 +719,12 @@ ble_phy_rx_end_isr(void)
     assert(NRF_RADIO->EVENTS_RSSIEND != 0);
     ble_hdr->rxinfo.rssi = -1 * NRF_RADIO->RSSISAMPLE;
 
+#if MYNEWT_VAL(BLE_PHY_RX_ZERO_COPY)
+    dptr = g_ble_phy_data.phy_rx_dptr;
+#else
     dptr = (uint8_t *)&g_ble_phy_rx_buf[0];
     dptr += 3;
+#endif
 
     /* Count PHY crc errors and valid packets */
     crcok = (uint8_t)NRF_RADIO->CRCSTATUS;
@@ -686,12 +807,12 @@ ble_phy_rx_start_isr(void)
 
 #if (MYNEWT_VAL(OS_CPUTIME_FREQ) == 32768)
     /*
-     * Calculate receive start time. We assume that the header time is
-     * 40 usecs (only 1 mbps supported right now).
+     * Calculate receive start time. The address event occurs once the
+     * preamble and access address have been received.
      *
      * XXX: possibly use other routine with remainder!
      */
-    usecs = NRF_TIMER0->CC[1] - 40;
+    usecs = NRF_TIMER0->CC[1] - ble_phy_hdr_usecs();
     ticks = os_cputime_usecs_to_ticks(usecs);
     ble_hdr->rem_usecs = usecs - os_cputime_ticks_to_usecs(ticks);
     if (ble_hdr->rem_usecs == 31) {
@@ -701,7 +822,7 @@ ble_phy_rx_start_isr(void)
     ble_hdr->beg_cputime = g_ble_phy_data.phy_start_cputime + ticks;
 #else
     ble_hdr->beg_cputime = NRF_TIMER0->CC[1] -
-        os_cputime_usecs_to_ticks(BLE_TX_LEN_USECS_M(NRF_RX_START_OFFSET));
+        os_cputime_usecs_to_ticks(ble_phy_hdr_usecs());
 #endif
 
     /* XXX: I wonder if we always have the 1st byte. If we need to wait for
@@ -726,7 +847,11 @@ ble_phy_rx_start_isr(void)
     }
 
     /* Call Link Layer receive start function */
+#if MYNEWT_VAL(BLE_PHY_RX_ZERO_COPY)
+    rc = ble_ll_rx_start(g_ble_phy_data.phy_rx_dptr,
+#else
     rc = ble_ll_rx_start((uint8_t *)&g_ble_phy_rx_buf[0] + 3,
+#endif
                          g_ble_phy_data.phy_chan,
                          &g_ble_phy_data.rxhdr);
     if (rc >= 0) {
@@ -757,6 +882,8 @@ ble_phy_isr(void)
 {
     uint32_t irq_en;
 
+    os_trace_isr_enter(RADIO_IRQn);
+
     /* Read irq register to determine which interrupts are enabled */
     irq_en = NRF_RADIO->INTENCLR;
 
@@ -798,6 +925,8 @@ ble_phy_isr(void)
 
     /* Count # of interrupts */
     STATS_INC(ble_phy_stats, phy_isrs);
+
+    os_trace_isr_exit();
 }
 
 /**
@@ -840,6 +969,8 @@ ble_phy_init(void)
     NRF_RADIO->INTENCLR = NRF_RADIO_IRQ_MASK_ALL;
 
     /* Set configuration registers */
+    g_ble_phy_data.phy_mode = BLE_PHY_MODE_1M;
+    g_ble_phy_data.phy_ccm_datarate = 0;
     NRF_RADIO->MODE = RADIO_MODE_MODE_Ble_1Mbit;
     NRF_RADIO->PCNF0 = (NRF_LFLEN_BITS << RADIO_PCNF0_LFLEN_Pos)    |
                        RADIO_PCNF0_S1INCL_Msk                       |
@@ -1192,7 +1323,7 @@ ble_phy_tx(struct os_mbuf *txpdu, uint8_t end_trans)
      * all.
      */
     NRF_PPI->CHENCLR = PPI_CHEN_CH4_Msk | PPI_CHEN_CH5_Msk | PPI_CHEN_CH23_Msk |
-                       PPI_CHEN_CH25_Msk;
+                       PPI_CHEN_CH24_Msk | PPI_CHEN_CH25_Msk;
 
 #if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_ENCRYPTION) == 1)
     if (g_ble_phy_data.phy_encrypted) {
@@ -1204,9 +1335,10 @@ ble_phy_tx(struct os_mbuf *txpdu, uint8_t end_trans)
         NRF_CCM->OUTPTR = (uint32_t)pktptr;
         NRF_CCM->SCRATCHPTR = (uint32_t)&g_nrf_encrypt_scratchpad[0];
         NRF_CCM->EVENTS_ERROR = 0;
-        NRF_CCM->MODE = CCM_MODE_LENGTH_Msk;
+        NRF_CCM->MODE = CCM_MODE_LENGTH_Msk | g_ble_phy_data.phy_ccm_datarate;
         NRF_CCM->CNFPTR = (uint32_t)&g_nrf_ccm_data;
-        NRF_PPI->CHENSET = PPI_CHEN_CH24_Msk;
+        NRF_CCM->EVENTS_ENDKSGEN = 0;
+        NRF_CCM->EVENTS_ENDCRYPT = 0;
     } else {
 #if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PRIVACY) == 1)
         NRF_AAR->IRKPTR = (uint32_t)&g_nrf_irk_list[0];
@@ -1253,6 +1385,18 @@ ble_phy_tx(struct os_mbuf *txpdu, uint8_t end_trans)
         /* Copy data from mbuf into transmit buffer */
         os_mbuf_copydata(txpdu, ble_hdr->txinfo.offset, payload_len, dptr);
 
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_ENCRYPTION) == 1)
+        /*
+         * The pdu is ready to be encrypted so start keystream generation
+         * now (the CCM shortcut starts the encryption when done) rather than
+         * waiting for the radio READY event. This allows the pdu to be
+         * encrypted while the radio is ramping up.
+         */
+        if (g_ble_phy_data.phy_encrypted) {
+            NRF_CCM->TASKS_KSGEN = 1;
+        }
+#endif
+
         /* Set phy state to transmitting and count packet statistics */
         g_ble_phy_data.phy_state = BLE_PHY_STATE_TX;
         STATS_INC(ble_phy_stats, tx_good);
@@ -1505,6 +1649,46 @@ ble_phy_max_data_pdu_pyld(void)
     return BLE_LL_DATA_PDU_MAX_PYLD;
 }
 
+/**
+ * Sets the PHY mode used for both transmit and receive. This must only be
+ * called when the transceiver is disabled.
+ *
+ * @param phy_mode The PHY mode (BLE_PHY_MODE_1M or BLE_PHY_MODE_2M)
+ *
+ * @return int 0: success; PHY error code otherwise
+ */
+int
+ble_phy_mode_set(uint8_t phy_mode)
+{
+    uint32_t pcnf0;
+
+    if (phy_mode == g_ble_phy_data.phy_mode) {
+        return 0;
+    }
+
+    pcnf0 = NRF_RADIO->PCNF0 & ~RADIO_PCNF0_PLEN_Msk;
+    switch (phy_mode) {
+    case BLE_PHY_MODE_1M:
+        NRF_RADIO->MODE = RADIO_MODE_MODE_Ble_1Mbit;
+        NRF_RADIO->PCNF0 = pcnf0 |
+                           (RADIO_PCNF0_PLEN_8bit << RADIO_PCNF0_PLEN_Pos);
+        g_ble_phy_data.phy_ccm_datarate = 0;
+        break;
+    case BLE_PHY_MODE_2M:
+        NRF_RADIO->MODE = RADIO_MODE_MODE_Ble_2Mbit;
+        NRF_RADIO->PCNF0 = pcnf0 |
+                           (RADIO_PCNF0_PLEN_16bit << RADIO_PCNF0_PLEN_Pos);
+        g_ble_phy_data.phy_ccm_datarate =
+            CCM_MODE_DATARATE_2Mbit << CCM_MODE_DATARATE_Pos;
+        break;
+    default:
+        return BLE_PHY_ERR_INV_PARAM;
+    }
+
+    g_ble_phy_data.phy_mode = phy_mode;
+    return 0;
+}
+
 #if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PRIVACY) == 1)
 void
 ble_phy_resolv_list_enable(void)
@@ -42,14 +42,6 @@
 #include "stats/stats.h"
 #endif
 
-#ifndef MATHLIB_SUPPORT
-
-double NAN = 0.0/0.0;
-double POS_INF = 1.0 /0.0;
-double NEG_INF = -1.0/0.0;
-
-#endif
-
 static struct hal_spi_settings spi_bme280_settings = {
     .data_order = HAL_SPI_MSB_FIRST,
     .data_mode  = HAL_SPI_MODE0,
@@ -207,13 +199,13 @@ bme280_sensor_get_interface(struct sensor *sensor, sensor_type_t type)
 
 #if MYNEWT_VAL(BME280_SPEC_CALC)
 /**
- * Returns temperature in DegC, as double
+ * Returns temperature in DegC, computed in double precision
  * Output value of "51.23" equals 51.23 DegC.
  *
  * @param uncompensated raw temperature value
  * @return 0 on success, non-zero on failure
  */
-static double
+static sensor_val_t
 bme280_compensate_temperature(int32_t rawtemp, struct bme280_calib_data *bcd)
 {
     double var1, var2, comptemp;
@@ -223,7 +215,7 @@ bme280_compensate_temperature(int32_t rawtemp, struct bme280_calib_data *bcd)
 #if MYNEWT_VAL(BME280_STATS)
         STATS_INC(g_bme280stats, invalid_data_errors);
 #endif
-        return NAN;
+        return SENSOR_VAL_NAN;
     }
 
     var1 = (((double)rawtemp)/16384.0 - ((double)bcd->bcd_dig_T1)/1024.0) *
@@ -236,17 +228,17 @@ bme280_compensate_temperature(int32_t rawtemp, struct bme280_calib_data *bcd)
 
     comptemp = (var1 + var2) / 5120.0;
 
-    return comptemp;
+    return SENSOR_VAL_FROM_FLOAT(comptemp);
 }
 
 /**
- * Returns pressure in Pa as double.
+ * Returns pressure in Pa, computed in double precision.
  * Output value of "96386.2" equals 96386.2 Pa = 963.862 hPa
  *
  * @param uncompensated raw pressure value
  * @return 0 on success, non-zero on failure
  */
-static double
+static sensor_val_t
 bme280_compensate_pressure(int32_t rawpress, struct bme280_calib_data *bcd)
 {
     double var1, var2, p;
@@ -257,7 +249,7 @@ bme280_compensate_pressure(int32_t rawpress, struct bme280_calib_data *bcd)
 #if MYNEWT_VAL(BME280_STATS)
         STATS_INC(g_bme280stats, invalid_data_errors);
 #endif
-        return NAN;
+        return SENSOR_VAL_NAN;
     }
 
     if (!g_t_fine) {
@@ -287,17 +279,17 @@ bme280_compensate_pressure(int32_t rawpress, struct bme280_calib_data *bcd)
 
     p = p + (var1 + var2 + ((double)bcd->bcd_dig_P7)) / 16.0;
 
-    return p;
+    return SENSOR_VAL_FROM_FLOAT(p);
 }
 
 /**
- * Returns humidity in %rH as double.
+ * Returns humidity in %rH, computed in double precision.
  * Output value of "46.332" represents 46.332 %rH
  *
  * @param uncompensated raw humidity value
  * @return 0 on success, non-zero on failure
  */
-static double
+static sensor_val_t
 bme280_compensate_humidity(int32_t rawhumid, struct bme280_calib_data *bcd)
 {
     double h;
@@ -308,7 +300,7 @@ bme280_compensate_humidity(int32_t rawhumid, struct bme280_calib_data *bcd)
 #if MYNEWT_VAL(BME280_STATS)
         STATS_INC(g_bme280stats, invalid_data_errors);
 #endif
-        return NAN;
+        return SENSOR_VAL_NAN;
     }
 
     if (!g_t_fine) {
@@ -331,19 +323,19 @@ bme280_compensate_humidity(int32_t rawhumid, struct bme280_calib_data *bcd)
         h = 0.0;
     }
 
-    return h;
+    return SENSOR_VAL_FROM_FLOAT(h);
 }
 
 #else
 
 /**
- * Returns temperature in DegC, as float
+ * Returns temperature in DegC, computed in integer arithmetic
  * Output value of "51.23" equals 51.23 DegC.
  *
  * @param uncompensated raw temperature value
  * @return 0 on success, non-zero on failure
  */
-static float
+static sensor_val_t
 bme280_compensate_temperature(int32_t rawtemp, struct bme280_calib_data *bcd)
 {
     int32_t var1, var2, comptemp;
@@ -353,7 +345,7 @@ bme280_compensate_temperature(int32_t rawtemp, struct bme280_calib_data *bcd)
 #if MYNEWT_VAL(BME280_STATS)
         STATS_INC(g_bme280stats, invalid_data_errors);
 #endif
-        return NAN;
+        return SENSOR_VAL_NAN;
     }
 
     rawtemp >>= 4;
@@ -369,17 +361,17 @@ bme280_compensate_temperature(int32_t rawtemp, struct bme280_calib_data *bcd)
 
     comptemp = ((int32_t)(g_t_fine * 5 + 128)) >> 8;
 
-    return (float)comptemp/100;
+    return SENSOR_VAL_FROM_RATIO(comptemp, 100);
 }
 
 /**
- * Returns pressure in Pa as float.
+ * Returns pressure in Pa, computed in integer arithmetic.
  * Output value of "96386.2" equals 96386.2 Pa = 963.862 hPa
  *
  * @param uncompensated raw pressure value
  * @return 0 on success, non-zero on failure
  */
-static float
+static sensor_val_t
 bme280_compensate_pressure(int32_t rawpress, struct bme280_calib_data *bcd)
 {
     int64_t var1, var2, p;
@@ -390,7 +382,7 @@ bme280_compensate_pressure(int32_t rawpress, struct bme280_calib_data *bcd)
 #if MYNEWT_VAL(BME280_STATS)
         STATS_INC(g_bme280stats, invalid_data_errors);
 #endif
-        return NAN;
+        return SENSOR_VAL_NAN;
     }
 
     if (!g_t_fine) {
@@ -422,17 +414,17 @@ bme280_compensate_pressure(int32_t rawpress, struct bme280_calib_data *bcd)
 
     p = ((int64_t)(p + var1 + var2) >> 8) + (((int64_t)bcd->bcd_dig_P7) << 4);
 
-    return (float)p/256;
+    return SENSOR_VAL_FROM_RATIO(p, 256);
 }
 
 /**
- * Returns humidity in %rH as float.
+ * Returns humidity in %rH, computed in integer arithmetic.
  * Output value of "46.332" represents 46.332 %rH
  *
  * @param uncompensated raw humidity value
  * @return 0 on success, non-zero on failure
  */
-static float
+static sensor_val_t
 bme280_compensate_humidity(uint32_t rawhumid, struct bme280_calib_data *bcd)
 {
     int32_t h;
@@ -444,7 +436,7 @@ bme280_compensate_humidity(uint32_t rawhumid, struct bme280_calib_data *bcd)
 #if MYNEWT_VAL(BME280_STATS)
         STATS_INC(g_bme280stats, invalid_data_errors);
 #endif
-        return NAN;
+        return SENSOR_VAL_NAN;
     }
 
     if (!g_t_fine) {
@@ -470,7 +462,7 @@ bme280_compensate_humidity(uint32_t rawhumid, struct bme280_calib_data *bcd)
 
     h = (tmp32 >> 12);
 
-    return  h / 1024.0;
+    return SENSOR_VAL_FROM_RATIO(h, 1024);
 }
 
 #endif
@@ -519,7 +511,7 @@ bme280_sensor_read(struct sensor *sensor, sensor_type_t type,
 
         spd.spd_press = bme280_compensate_pressure(rawpress, &bcd);
 
-        if (spd.spd_press != NAN) {
+        if (!SENSOR_VAL_IS_NAN(spd.spd_press)) {
             spd.spd_press_is_valid = 1;
         }
 
@@ -539,7 +531,7 @@ bme280_sensor_read(struct sensor *sensor, sensor_type_t type,
 
         std.std_temp = bme280_compensate_temperature(rawtemp, &bcd);
 
-        if (std.std_temp != NAN) {
+        if (!SENSOR_VAL_IS_NAN(std.std_temp)) {
             std.std_temp_is_valid = 1;
         }
 
@@ -559,7 +551,7 @@ bme280_sensor_read(struct sensor *sensor, sensor_type_t type,
 
         shd.shd_humid = bme280_compensate_humidity(rawhumid, &bcd);
 
-        if (shd.shd_humid != NAN) {
+        if (!SENSOR_VAL_IS_NAN(shd.shd_humid)) {
             shd.shd_humid_is_valid = 1;
         }
 
@@ -24,7 +24,7 @@
 #include "defs/error.h"
 #include "os/os.h"
 #include "sysinit/sysinit.h"
-#include "hal/hal_i2c.h"
+#include "i2c_bus/i2c_bus.h"
 #include "sensor/sensor.h"
 #include "sensor/accel.h"
 #include "sensor/mag.h"
@@ -95,17 +95,17 @@ bno055_write8(uint8_t reg, uint8_t value)
     int rc;
     uint8_t payload[2] = { reg, value};
 
-    struct hal_i2c_master_data data_struct = {
-        .address = MYNEWT_VAL(BNO055_I2CADDR),
-        .len = 2,
-        .buffer = payload
+    struct i2c_bus_xfer xfer = {
+        .ibx_addr = MYNEWT_VAL(BNO055_I2CADDR),
+        .ibx_wlen = 2,
+        .ibx_wbuf = payload,
+        .ibx_timeout = OS_TICKS_PER_SEC
     };
 
-    rc = hal_i2c_master_write(MYNEWT_VAL(BNO055_I2CBUS), &data_struct,
-                              OS_TICKS_PER_SEC, 1);
+    rc = i2c_bus_xfer(MYNEWT_VAL(BNO055_I2CBUS), &xfer);
     if (rc) {
         BNO055_ERR("Failed to write to 0x%02X:0x%02X with value 0x%02X\n",
-                       data_struct.address, reg, value);
+                       xfer.ibx_addr, reg, value);
 #if MYNEWT_VAL(BNO055_STATS)
         STATS_INC(g_bno055stats, errors);
 #endif
@@ -130,32 +130,24 @@ bno055_writelen(uint8_t reg, uint8_t *buffer, uint8_t len)
                               0, 0, 0, 0, 0, 0, 0, 0,
                               0, 0, 0, 0, 0, 0, 0};
 
-    struct hal_i2c_master_data data_struct = {
-        .address = MYNEWT_VAL(BNO055_I2CADDR),
-        .len = 1,
-        .buffer = payload
+    struct i2c_bus_xfer xfer = {
+        .ibx_addr = MYNEWT_VAL(BNO055_I2CADDR),
+        .ibx_wlen = len + 1,
+        .ibx_wbuf = payload,
+        .ibx_timeout = OS_TICKS_PER_SEC / 10
     };
 
-    memcpy(&payload[1], buffer, len);
-
-    /* Register write */
-    rc = hal_i2c_master_write(MYNEWT_VAL(BNO055_I2CBUS), &data_struct,
-                              OS_TICKS_PER_SEC / 10, 1);
-    if (rc) {
-        BNO055_ERR("I2C access failed at address 0x%02X\n", data_struct.address);
-#if MYNEWT_VAL(BNO055_STATS)
-        STATS_INC(g_bno055stats, errors);
-#endif
+    if (len > sizeof(payload) - 1) {
+        rc = SYS_EINVAL;
         goto err;
     }
 
-    memset(payload, 0, sizeof(payload));
-    data_struct.len = len;
-    rc = hal_i2c_master_write(MYNEWT_VAL(BNO055_I2CBUS), &data_struct,
-                              OS_TICKS_PER_SEC / 10, len);
+    memcpy(&payload[1], buffer, len);
 
+    /* Register write, followed by the data */
+    rc = i2c_bus_xfer(MYNEWT_VAL(BNO055_I2CBUS), &xfer);
     if (rc) {
-        BNO055_ERR("Failed to read from 0x%02X:0x%02X\n", data_struct.address, reg);
+        BNO055_ERR("Failed to write to 0x%02X:0x%02X\n", xfer.ibx_addr, reg);
 #if MYNEWT_VAL(BNO055_STATS)
         STATS_INC(g_bno055stats, errors);
 #endif
@@ -179,45 +171,31 @@ int
 bno055_read8(uint8_t reg, uint8_t *value)
 {
     int rc;
-    uint8_t payload;
 
-    struct hal_i2c_master_data data_struct = {
-        .address = MYNEWT_VAL(BNO055_I2CADDR),
-        .len = 1,
-        .buffer = &payload
+    struct i2c_bus_xfer xfer = {
+        .ibx_addr = MYNEWT_VAL(BNO055_I2CADDR),
+        .ibx_wlen = 1,
+        .ibx_wbuf = &reg,
+        .ibx_rlen = 1,
+        .ibx_rbuf = value,
+        .ibx_timeout = OS_TICKS_PER_SEC / 10
     };
 
-    /* Register write */
-    payload = reg;
-    rc = hal_i2c_master_write(MYNEWT_VAL(BNO055_I2CBUS), &data_struct,
-                              OS_TICKS_PER_SEC / 10, 0);
+    /* Register write, then read one byte back */
+    *value = 0;
+    rc = i2c_bus_xfer(MYNEWT_VAL(BNO055_I2CBUS), &xfer);
     if (rc) {
-        BNO055_ERR("I2C register write failed at address 0x%02X:0x%02X\n",
-                   data_struct.address, reg);
-#if MYNEWT_VAL(BNO055_STATS)
-        STATS_INC(g_bno055stats, errors);
-#endif
-        goto err;
-    }
-
-    /* Read one byte back */
-    payload = 0;
-    rc = hal_i2c_master_read(MYNEWT_VAL(BNO055_I2CBUS), &data_struct,
-                             OS_TICKS_PER_SEC / 10, 1);
-    *value = payload;
-    if (rc) {
-        BNO055_ERR("Failed to read from 0x%02X:0x%02X\n", data_struct.address, reg);
+        BNO055_ERR("Failed to read from 0x%02X:0x%02X\n", xfer.ibx_addr, reg);
 #if MYNEWT_VAL(BNO055_STATS)
         STATS_INC(g_bno055stats, errors);
 #endif
     }
 
-err:
     return rc;
 }
 
 /**
- * Read data from the sensor of variable length (MAX: 8 bytes)
+ * Read data from the sensor of variable length
  *
  *
  * @param Register to read from
@@ -230,49 +208,29 @@ static int
 bno055_readlen(uint8_t reg, uint8_t *buffer, uint8_t len)
 {
     int rc;
-    uint8_t payload[23] = { reg, 0, 0, 0, 0, 0, 0, 0,
-                              0, 0, 0, 0, 0, 0, 0, 0,
-                              0, 0, 0, 0, 0, 0, 0};
 
-    struct hal_i2c_master_data data_struct = {
-        .address = MYNEWT_VAL(BNO055_I2CADDR),
-        .len = 1,
-        .buffer = payload
+    struct i2c_bus_xfer xfer = {
+        .ibx_addr = MYNEWT_VAL(BNO055_I2CADDR),
+        .ibx_wlen = 1,
+        .ibx_wbuf = &reg,
+        .ibx_rlen = len,
+        .ibx_rbuf = buffer,
+        .ibx_timeout = OS_TICKS_PER_SEC / 10
     };
 
     /* Clear the supplied buffer */
     memset(buffer, 0, len);
 
-    /* Register write */
-    rc = hal_i2c_master_write(MYNEWT_VAL(BNO055_I2CBUS), &data_struct,
-                              OS_TICKS_PER_SEC / 10, 1);
-    if (rc) {
-        BNO055_ERR("I2C access failed at address 0x%02X\n", data_struct.address);
-#if MYNEWT_VAL(BNO055_STATS)
-        STATS_INC(g_bno055stats, errors);
-#endif
-        goto err;
-    }
-
-    /* Read len bytes back */
-    memset(payload, 0, sizeof(payload));
-    data_struct.len = len;
-    rc = hal_i2c_master_read(MYNEWT_VAL(BNO055_I2CBUS), &data_struct,
-                             OS_TICKS_PER_SEC / 10, 1);
-
+    /* Register write, then read len bytes back */
+    rc = i2c_bus_xfer(MYNEWT_VAL(BNO055_I2CBUS), &xfer);
     if (rc) {
-        BNO055_ERR("Failed to read from 0x%02X:0x%02X\n", data_struct.address, reg);
+        BNO055_ERR("Failed to read from 0x%02X:0x%02X\n", xfer.ibx_addr, reg);
 #if MYNEWT_VAL(BNO055_STATS)
         STATS_INC(g_bno055stats, errors);
 #endif
-        goto err;
+        memset(buffer, 0, len);
     }
 
-    /* Copy the I2C results into the supplied buffer */
-    memcpy(buffer, payload, len);
-
-    return 0;
-err:
     return rc;
 }
 
@@ -827,15 +785,11 @@ int
 bno055_get_quat_data(void *datastruct)
 {
     uint8_t buffer[8];
-    double scale;
     int rc;
     struct sensor_quat_data *sqd;
 
     sqd = (struct sensor_quat_data *)datastruct;
 
-    /* As per Section 3.6.5.5 Orientation (Quaternion) */
-    scale = (1.0 / (1<<14));
-
     memset (buffer, 0, 8);
 
     /* Read quat data */
@@ -845,10 +799,15 @@ bno055_get_quat_data(void *datastruct)
         goto err;
     }
 
-    sqd->sqd_w = ((((uint16_t)buffer[1]) << 8) | ((uint16_t)buffer[0])) * scale;
-    sqd->sqd_x = ((((uint16_t)buffer[3]) << 8) | ((uint16_t)buffer[2])) * scale;
-    sqd->sqd_y = ((((uint16_t)buffer[5]) << 8) | ((uint16_t)buffer[4])) * scale;
-    sqd->sqd_z = ((((uint16_t)buffer[7]) << 8) | ((uint16_t)buffer[6])) * scale;
+    /* As per Section 3.6.5.5 Orientation (Quaternion), 1 = 2^14 LSB */
+    sqd->sqd_w = SENSOR_VAL_FROM_RATIO(((((uint16_t)buffer[1]) << 8) |
+                                        ((uint16_t)buffer[0])), 1 << 14);
+    sqd->sqd_x = SENSOR_VAL_FROM_RATIO(((((uint16_t)buffer[3]) << 8) |
+                                        ((uint16_t)buffer[2])), 1 << 14);
+    sqd->sqd_y = SENSOR_VAL_FROM_RATIO(((((uint16_t)buffer[5]) << 8) |
+                                        ((uint16_t)buffer[4])), 1 << 14);
+    sqd->sqd_z = SENSOR_VAL_FROM_RATIO(((((uint16_t)buffer[7]) << 8) |
+                                        ((uint16_t)buffer[6])), 1 << 14);
 
     sqd->sqd_w_is_valid = 1;
     sqd->sqd_x_is_valid = 1;
@@ -917,9 +876,9 @@ bno055_get_vector_data(void *datastruct, int type)
     struct sensor_euler_data *sed;
     uint8_t reg;
     uint8_t units;
-    float acc_div;
-    float gyro_div;
-    float euler_div;
+    int acc_div;
+    int gyro_div;
+    int euler_div;
 
     int rc;
 
@@ -946,9 +905,9 @@ bno055_get_vector_data(void *datastruct, int type)
         goto err;
     }
 
-    acc_div  = units & BNO055_ACC_UNIT_MG ? 1.0:100.0;
-    gyro_div = units & BNO055_ANGRATE_UNIT_RPS ? 900.0:16.0;
-    euler_div = units & BNO055_EULER_UNIT_RAD ? 16.0:900.0;
+    acc_div  = units & BNO055_ACC_UNIT_MG ? 1:100;
+    gyro_div = units & BNO055_ANGRATE_UNIT_RPS ? 900:16;
+    euler_div = units & BNO055_EULER_UNIT_RAD ? 16:900;
 
     /**
      * Convert the value to an appropriate range (section 3.6.4)
@@ -957,9 +916,9 @@ bno055_get_vector_data(void *datastruct, int type)
         case SENSOR_TYPE_MAGNETIC_FIELD:
             smd = datastruct;
             /* 1uT = 16 LSB */
-            smd->smd_x = ((double)x)/16.0;
-            smd->smd_y = ((double)y)/16.0;
-            smd->smd_z = ((double)z)/16.0;
+            smd->smd_x = SENSOR_VAL_FROM_RATIO(x, 16);
+            smd->smd_y = SENSOR_VAL_FROM_RATIO(y, 16);
+            smd->smd_z = SENSOR_VAL_FROM_RATIO(z, 16);
 
             smd->smd_x_is_valid = 1;
             smd->smd_y_is_valid = 1;
@@ -969,9 +928,9 @@ bno055_get_vector_data(void *datastruct, int type)
         case SENSOR_TYPE_GYROSCOPE:
             sad = datastruct;
             /* 1rps = 900 LSB */
-            sad->sad_x = ((double)x)/gyro_div;
-            sad->sad_y = ((double)y)/gyro_div;
-            sad->sad_z = ((double)z)/gyro_div;
+            sad->sad_x = SENSOR_VAL_FROM_RATIO(x, gyro_div);
+            sad->sad_y = SENSOR_VAL_FROM_RATIO(y, gyro_div);
+            sad->sad_z = SENSOR_VAL_FROM_RATIO(z, gyro_div);
 
             sad->sad_x_is_valid = 1;
             sad->sad_y_is_valid = 1;
@@ -980,9 +939,9 @@ bno055_get_vector_data(void *datastruct, int type)
         case SENSOR_TYPE_EULER:
             sed = datastruct;
             /* 1 degree = 16 LSB */
-            sed->sed_h = ((double)x)/euler_div;
-            sed->sed_r = ((double)y)/euler_div;
-            sed->sed_p = ((double)z)/euler_div;
+            sed->sed_h = SENSOR_VAL_FROM_RATIO(x, euler_div);
+            sed->sed_r = SENSOR_VAL_FROM_RATIO(y, euler_div);
+            sed->sed_p = SENSOR_VAL_FROM_RATIO(z, euler_div);
 
             sed->sed_h_is_valid = 1;
             sed->sed_r_is_valid = 1;
@@ -993,9 +952,9 @@ bno055_get_vector_data(void *datastruct, int type)
         case SENSOR_TYPE_GRAVITY:
             sad = datastruct;
             /* 1m/s^2 = 100 LSB */
-            sad->sad_x = ((double)x)/acc_div;
-            sad->sad_y = ((double)y)/acc_div;
-            sad->sad_z = ((double)z)/acc_div;
+            sad->sad_x = SENSOR_VAL_FROM_RATIO(x, acc_div);
+            sad->sad_y = SENSOR_VAL_FROM_RATIO(y, acc_div);
+            sad->sad_z = SENSOR_VAL_FROM_RATIO(z, acc_div);
 
             sad->sad_x_is_valid = 1;
             sad->sad_y_is_valid = 1;
@@ -1061,7 +1020,7 @@ bno055_get_temp_data(struct sensor_temp_data *std)
         goto err;
     }
 
-    std->std_temp = temp;
+    std->std_temp = SENSOR_VAL_FROM_RATIO(temp, 1);
     std->std_temp_is_valid = 1;
 
     return 0;
@@ -247,10 +247,18 @@ bno055_shell_cmd_read(int argc, char **argv)
             }
             sqd = databuf;
 
-            console_printf("x:%s ", sensor_ftostr(sqd->sqd_x, tmpstr, 13));
-            console_printf("y:%s ", sensor_ftostr(sqd->sqd_y, tmpstr, 13));
-            console_printf("z:%s ", sensor_ftostr(sqd->sqd_z, tmpstr, 13));
-            console_printf("w:%s\n", sensor_ftostr(sqd->sqd_w, tmpstr, 13));
+            console_printf("x:%s ",
+                           sensor_ftostr(SENSOR_VAL_TO_FLOAT(sqd->sqd_x),
+                                         tmpstr, 13));
+            console_printf("y:%s ",
+                           sensor_ftostr(SENSOR_VAL_TO_FLOAT(sqd->sqd_y),
+                                         tmpstr, 13));
+            console_printf("z:%s ",
+                           sensor_ftostr(SENSOR_VAL_TO_FLOAT(sqd->sqd_z),
+                                         tmpstr, 13));
+            console_printf("w:%s\n",
+                           sensor_ftostr(SENSOR_VAL_TO_FLOAT(sqd->sqd_w),
+                                         tmpstr, 13));
 
         } else if (type == SENSOR_TYPE_EULER) {
             rc = bno055_get_vector_data(databuf, type);
@@ -260,9 +268,15 @@ bno055_shell_cmd_read(int argc, char **argv)
             }
             sed = databuf;
 
-            console_printf("h:%s ", sensor_ftostr(sed->sed_h, tmpstr, 13));
-            console_printf("r:%s ", sensor_ftostr(sed->sed_r, tmpstr, 13));
-            console_printf("p:%s\n", sensor_ftostr(sed->sed_p, tmpstr, 13));
+            console_printf("h:%s ",
+                           sensor_ftostr(SENSOR_VAL_TO_FLOAT(sed->sed_h),
+                                         tmpstr, 13));
+            console_printf("r:%s ",
+                           sensor_ftostr(SENSOR_VAL_TO_FLOAT(sed->sed_r),
+                                         tmpstr, 13));
+            console_printf("p:%s\n",
+                           sensor_ftostr(SENSOR_VAL_TO_FLOAT(sed->sed_p),
+                                         tmpstr, 13));
 
         } else if (type == SENSOR_TYPE_TEMPERATURE) {
             rc = bno055_get_temp(databuf);
@@ -281,9 +295,15 @@ bno055_shell_cmd_read(int argc, char **argv)
             }
             sad = databuf;
 
-            console_printf("x:%s ", sensor_ftostr(sad->sad_x, tmpstr, 13));
-            console_printf("y:%s ", sensor_ftostr(sad->sad_y, tmpstr, 13));
-            console_printf("z:%s\n", sensor_ftostr(sad->sad_z, tmpstr, 13));
+            console_printf("x:%s ",
+                           sensor_ftostr(SENSOR_VAL_TO_FLOAT(sad->sad_x),
+                                         tmpstr, 13));
+            console_printf("y:%s ",
+                           sensor_ftostr(SENSOR_VAL_TO_FLOAT(sad->sad_y),
+                                         tmpstr, 13));
+            console_printf("z:%s\n",
+                           sensor_ftostr(SENSOR_VAL_TO_FLOAT(sad->sad_z),
+                                         tmpstr, 13));
         }
     }
 
@@ -24,7 +24,8 @@
 #include "defs/error.h"
 #include "os/os.h"
 #include "sysinit/sysinit.h"
-#include "hal/hal_i2c.h"
+#include "i2c_bus/i2c_bus.h"
+#include "hal/hal_gpio.h"
 #include "sensor/sensor.h"
 #include "sensor/accel.h"
 #include "sensor/mag.h"
@@ -93,11 +94,13 @@ static int lsm303dlhc_sensor_read(struct sensor *, sensor_type_t,
         sensor_data_func_t, void *, uint32_t);
 static int lsm303dlhc_sensor_get_config(struct sensor *, sensor_type_t,
         struct sensor_cfg *);
+static int lsm303dlhc_sensor_stream(struct sensor *, sensor_type_t, uint16_t);
 
 static const struct sensor_driver g_lsm303dlhc_sensor_driver = {
     lsm303dlhc_sensor_get_interface,
     lsm303dlhc_sensor_read,
-    lsm303dlhc_sensor_get_config
+    lsm303dlhc_sensor_get_config,
+    lsm303dlhc_sensor_stream
 };
 
 /**
@@ -115,14 +118,14 @@ lsm303dlhc_write8(uint8_t addr, uint8_t reg, uint32_t value)
     int rc;
     uint8_t payload[2] = { reg, value & 0xFF };
 
-    struct hal_i2c_master_data data_struct = {
-        .address = addr,
-        .len = 2,
-        .buffer = payload
+    struct i2c_bus_xfer xfer = {
+        .ibx_addr = addr,
+        .ibx_wlen = 2,
+        .ibx_wbuf = payload,
+        .ibx_timeout = OS_TICKS_PER_SEC / 10
     };
 
-    rc = hal_i2c_master_write(MYNEWT_VAL(LSM303DLHC_I2CBUS), &data_struct,
-                              OS_TICKS_PER_SEC / 10, 1);
+    rc = i2c_bus_xfer(MYNEWT_VAL(LSM303DLHC_I2CBUS), &xfer);
     if (rc) {
         LSM303DLHC_ERR("Failed to write to 0x%02X:0x%02X with value 0x%02X\n",
                        addr, reg, value);
@@ -146,90 +149,52 @@ lsm303dlhc_write8(uint8_t addr, uint8_t reg, uint32_t value)
 int
 lsm303dlhc_read8(uint8_t addr, uint8_t reg, uint8_t *value)
 {
-    int rc;
-    uint8_t payload;
-
-    struct hal_i2c_master_data data_struct = {
-        .address = addr,
-        .len = 1,
-        .buffer = &payload
-    };
-
-    /* Register write */
-    payload = reg;
-    rc = hal_i2c_master_write(MYNEWT_VAL(LSM303DLHC_I2CBUS), &data_struct,
-                              OS_TICKS_PER_SEC / 10, 1);
-    if (rc) {
-        LSM303DLHC_ERR("I2C access failed at address 0x%02X\n", addr);
-#if MYNEWT_VAL(LSM303DLHC_STATS)
-        STATS_INC(g_lsm303dlhcstats, errors);
-#endif
-        goto error;
-    }
-
-    /* Read one byte back */
-    payload = 0;
-    rc = hal_i2c_master_read(MYNEWT_VAL(LSM303DLHC_I2CBUS), &data_struct,
-                             OS_TICKS_PER_SEC / 10, 1);
-    *value = payload;
-    if (rc) {
-        LSM303DLHC_ERR("Failed to read from 0x%02X:0x%02X\n", addr, reg);
-#if MYNEWT_VAL(LSM303DLHC_STATS)
-        STATS_INC(g_lsm303dlhcstats, errors);
-#endif
-    }
-
-error:
-    return rc;
+    return lsm303dlhc_readlen(addr, reg, value, 1);
 }
 
 int
 lsm303dlhc_read48(uint8_t addr, uint8_t reg, uint8_t *buffer)
+{
+    return lsm303dlhc_readlen(addr, reg, buffer, 6);
+}
+
+/**
+ * Reads a number of consecutive bytes, starting from the specified register
+ *
+ * @param The I2C address to use
+ * @param The register address to start reading from
+ * @param Pointer to where the register values should be written
+ * @param Number of bytes to read
+ *
+ * @return 0 on success, non-zero error on failure.
+ */
+int
+lsm303dlhc_readlen(uint8_t addr, uint8_t reg, uint8_t *buffer, uint16_t len)
 {
     int rc;
-    uint8_t payload[7] = { reg, 0, 0, 0, 0, 0, 0 };
 
-    struct hal_i2c_master_data data_struct = {
-        .address = addr,
-        .len = 1,
-        .buffer = payload
+    struct i2c_bus_xfer xfer = {
+        .ibx_addr = addr,
+        .ibx_wlen = 1,
+        .ibx_wbuf = &reg,
+        .ibx_rlen = len,
+        .ibx_rbuf = buffer,
+        .ibx_timeout = OS_TICKS_PER_SEC / 10
     };
 
     /* Clear the supplied buffer */
-    memset(buffer, 0, 6);
-
-    /* Register write */
-    rc = hal_i2c_master_write(MYNEWT_VAL(LSM303DLHC_I2CBUS), &data_struct,
-                              OS_TICKS_PER_SEC / 10, 1);
-    if (rc) {
-        LSM303DLHC_ERR("I2C access failed at address 0x%02X\n", addr);
-#if MYNEWT_VAL(LSM303DLHC_STATS)
-        STATS_INC(g_lsm303dlhcstats, errors);
-#endif
-        goto error;
-    }
-
-    /* Read six bytes back */
-    memset(payload, 0, sizeof(payload));
-    data_struct.len = 6;
-    rc = hal_i2c_master_read(MYNEWT_VAL(LSM303DLHC_I2CBUS), &data_struct,
-                             OS_TICKS_PER_SEC / 10, 1);
+    memset(buffer, 0, len);
 
+    /* Register write, then read the bytes back */
+    rc = i2c_bus_xfer(MYNEWT_VAL(LSM303DLHC_I2CBUS), &xfer);
     if (rc) {
         LSM303DLHC_ERR("Failed to read from 0x%02X:0x%02X\n", addr, reg);
 #if MYNEWT_VAL(LSM303DLHC_STATS)
         STATS_INC(g_lsm303dlhcstats, errors);
 #endif
-        goto error;
+        memset(buffer, 0, len);
     }
 
-    /* Copy the I2C results into the supplied buffer */
-    memcpy(buffer, payload, 6);
-
-    /* ToDo: Log raw reads */
-    // console_printf("0x%04X\n", (uint16_t)payload[0] | ((uint16_t)payload[1] << 8));
-
-error:
     return rc;
 }
 
@@ -349,6 +314,146 @@ lsm303dlhc_sensor_get_interface(struct sensor *sensor, sensor_type_t type)
     return (NULL);
 }
 
+/**
+ * Converts a raw accelerometer sample to m/s^2
+ *
+ * @param The device the sample was read from
+ * @param The six bytes of the sample, as read from OUT_X_L_A onwards
+ * @param The accelerometer data to fill in
+ */
+static void
+lsm303dlhc_accel_convert(struct lsm303dlhc *lsm, uint8_t *payload,
+                         struct sensor_accel_data *sad)
+{
+    int16_t x, y, z;
+    int32_t ug_lsb;
+
+    /* Shift 12-bit left-aligned accel values into 16-bit int */
+    x = ((int16_t)(payload[0] | (payload[1] << 8))) >> 4;
+    y = ((int16_t)(payload[2] | (payload[3] << 8))) >> 4;
+    z = ((int16_t)(payload[4] | (payload[5] << 8))) >> 4;
+
+    /* Determine micro-g per lsb based on range */
+    switch(lsm->cfg.accel_range) {
+        case LSM303DLHC_ACCEL_RANGE_2:
+#if MYNEWT_VAL(LSM303DLHC_STATS)
+            STATS_INC(g_lsm303dlhcstats, samples_acc_2g);
+#endif
+            ug_lsb = 1000;
+            break;
+        case LSM303DLHC_ACCEL_RANGE_4:
+#if MYNEWT_VAL(LSM303DLHC_STATS)
+            STATS_INC(g_lsm303dlhcstats, samples_acc_4g);
+#endif
+            ug_lsb = 2000;
+            break;
+        case LSM303DLHC_ACCEL_RANGE_8:
+#if MYNEWT_VAL(LSM303DLHC_STATS)
+            STATS_INC(g_lsm303dlhcstats, samples_acc_8g);
+#endif
+            ug_lsb = 4000;
+            break;
+        case LSM303DLHC_ACCEL_RANGE_16:
+#if MYNEWT_VAL(LSM303DLHC_STATS)
+            STATS_INC(g_lsm303dlhcstats, samples_acc_16g);
+#endif
+            ug_lsb = 12000;
+            break;
+        default:
+            LSM303DLHC_ERR("Unknown accel range: 0x%02X. Assuming +/-2G.\n",
+                lsm->cfg.accel_range);
+            ug_lsb = 1000;
+            break;
+    }
+
+    /* Convert from micro-g to Earth gravity in m/s^2 (9.80665) */
+    sad->sad_x = SENSOR_VAL_FROM_RATIO((int64_t)x * ug_lsb * 980665,
+                                       100000000000LL);
+    sad->sad_y = SENSOR_VAL_FROM_RATIO((int64_t)y * ug_lsb * 980665,
+                                       100000000000LL);
+    sad->sad_z = SENSOR_VAL_FROM_RATIO((int64_t)z * ug_lsb * 980665,
+                                       100000000000LL);
+
+    sad->sad_x_is_valid = 1;
+    sad->sad_y_is_valid = 1;
+    sad->sad_z_is_valid = 1;
+}
+
+/**
+ * Reads all samples buffered in the accelerometer FIFO, and calls the data
+ * function for each of them in turn.
+ *
+ * @param The sensor to read from
+ * @param The data function to call
+ * @param The argument to pass to the data function
+ *
+ * @return 0 on success, non-zero error on failure.
+ */
+static int
+lsm303dlhc_accel_read_fifo(struct sensor *sensor, sensor_data_func_t data_func,
+                           void *data_arg)
+{
+    struct lsm303dlhc *lsm;
+    struct sensor_accel_data sad;
+#if MYNEWT_VAL(LSM303DLHC_FIFO_BURST)
+    uint8_t payload[6 * LSM303DLHC_ACCEL_FIFO_DEPTH];
+#else
+    uint8_t payload[6];
+#endif
+    uint8_t src;
+    int samples;
+    int i;
+    int rc;
+
+    lsm = (struct lsm303dlhc *) SENSOR_GET_DEVICE(sensor);
+
+    rc = lsm303dlhc_read8(LSM303DLHC_ADDR_ACCEL,
+                          LSM303DLHC_REGISTER_ACCEL_FIFO_SRC_REG_A, &src);
+    if (rc != 0) {
+        goto err;
+    }
+    if (src & LSM303DLHC_ACCEL_FIFO_SRC_OVRN) {
+        samples = LSM303DLHC_ACCEL_FIFO_DEPTH;
+    } else {
+        samples = src & LSM303DLHC_ACCEL_FIFO_SRC_FSS_MASK;
+    }
+
+#if MYNEWT_VAL(LSM303DLHC_FIFO_BURST)
+    /* Register address wraps back to OUT_X_L_A in FIFO mode, so the whole
+     * FIFO can be read out in one transfer.
+     */
+    rc = lsm303dlhc_readlen(LSM303DLHC_ADDR_ACCEL,
+                            LSM303DLHC_REGISTER_ACCEL_OUT_X_L_A | 0x80,
+                            payload, samples * 6);
+    if (rc != 0) {
+        goto err;
+    }
+#endif
+
+    for (i = 0; i < samples; i++) {
+#if MYNEWT_VAL(LSM303DLHC_FIFO_BURST)
+        lsm303dlhc_accel_convert(lsm, &payload[i * 6], &sad);
+#else
+        rc = lsm303dlhc_read48(LSM303DLHC_ADDR_ACCEL,
+                               LSM303DLHC_REGISTER_ACCEL_OUT_X_L_A | 0x80,
+                               payload);
+        if (rc != 0) {
+            goto err;
+        }
+        lsm303dlhc_accel_convert(lsm, payload, &sad);
+#endif
+
+        rc = data_func(sensor, data_arg, &sad);
+        if (rc != 0) {
+            goto err;
+        }
+    }
+
+    return (0);
+err:
+    return (rc);
+}
+
 static int
 lsm303dlhc_sensor_read(struct sensor *sensor, sensor_type_t type,
         sensor_data_func_t data_func, void *data_arg, uint32_t timeout)
@@ -358,7 +463,6 @@ lsm303dlhc_sensor_read(struct sensor *sensor, sensor_type_t type,
     struct sensor_mag_data smd;
     int rc;
     int16_t x, y, z;
-    float mg_lsb;
     int16_t gauss_lsb_xy;
     int16_t gauss_lsb_z;
     uint8_t payload[6];
@@ -372,9 +476,15 @@ lsm303dlhc_sensor_read(struct sensor *sensor, sensor_type_t type,
 
     lsm = (struct lsm303dlhc *) SENSOR_GET_DEVICE(sensor);
 
-    /* Get a new accelerometer sample */
-    if (type & SENSOR_TYPE_ACCELEROMETER) {
-        x = y = z = 0;
+    /* When streaming, return all samples buffered in the FIFO */
+    if ((type & SENSOR_TYPE_ACCELEROMETER) &&
+        (sensor->s_stream_types & SENSOR_TYPE_ACCELEROMETER)) {
+        rc = lsm303dlhc_accel_read_fifo(sensor, data_func, data_arg);
+        if (rc != 0) {
+            goto err;
+        }
+    } else if (type & SENSOR_TYPE_ACCELEROMETER) {
+        /* Get a new accelerometer sample */
         rc = lsm303dlhc_read48(LSM303DLHC_ADDR_ACCEL,
                               LSM303DLHC_REGISTER_ACCEL_OUT_X_L_A | 0x80,
                               payload);
@@ -382,52 +492,7 @@ lsm303dlhc_sensor_read(struct sensor *sensor, sensor_type_t type,
             goto err;
         }
 
-        /* Shift 12-bit left-aligned accel values into 16-bit int */
-        x = ((int16_t)(payload[0] | (payload[1] << 8))) >> 4;
-        y = ((int16_t)(payload[2] | (payload[3] << 8))) >> 4;
-        z = ((int16_t)(payload[4] | (payload[5] << 8))) >> 4;
-
-        /* Determine mg per lsb based on range */
-        switch(lsm->cfg.accel_range) {
-            case LSM303DLHC_ACCEL_RANGE_2:
-#if MYNEWT_VAL(LSM303DLHC_STATS)
-                STATS_INC(g_lsm303dlhcstats, samples_acc_2g);
-#endif
-                mg_lsb = 0.001F;
-                break;
-            case LSM303DLHC_ACCEL_RANGE_4:
-#if MYNEWT_VAL(LSM303DLHC_STATS)
-                STATS_INC(g_lsm303dlhcstats, samples_acc_4g);
-#endif
-                mg_lsb = 0.002F;
-                break;
-            case LSM303DLHC_ACCEL_RANGE_8:
-#if MYNEWT_VAL(LSM303DLHC_STATS)
-                STATS_INC(g_lsm303dlhcstats, samples_acc_8g);
-#endif
-                mg_lsb = 0.004F;
-                break;
-            case LSM303DLHC_ACCEL_RANGE_16:
-#if MYNEWT_VAL(LSM303DLHC_STATS)
-                STATS_INC(g_lsm303dlhcstats, samples_acc_16g);
-#endif
-                mg_lsb = 0.012F;
-                break;
-            default:
-                LSM303DLHC_ERR("Unknown accel range: 0x%02X. Assuming +/-2G.\n",
-                    lsm->cfg.accel_range);
-                mg_lsb = 0.001F;
-                break;
-        }
-
-        /* Convert from mg to Earth gravity in m/s^2 */
-        sad.sad_x = (float)x * mg_lsb * 9.80665F;
-        sad.sad_y = (float)y * mg_lsb * 9.80665F;
-        sad.sad_z = (float)z * mg_lsb * 9.80665F;
-
-        sad.sad_x_is_valid = 1;
-        sad.sad_y_is_valid = 1;
-        sad.sad_z_is_valid = 1;
+        lsm303dlhc_accel_convert(lsm, payload, &sad);
 
         /* Call data function */
         rc = data_func(sensor, data_arg, &sad);
@@ -511,9 +576,9 @@ lsm303dlhc_sensor_read(struct sensor *sensor, sensor_type_t type,
         }
 
         /* Convert from gauss to micro Tesla */
-        smd.smd_x = (float)x / gauss_lsb_xy * 100.0F;
-        smd.smd_y = (float)y / gauss_lsb_xy * 100.0F;
-        smd.smd_z = (float)z / gauss_lsb_z * 100.0F;
+        smd.smd_x = SENSOR_VAL_FROM_RATIO(x * 100, gauss_lsb_xy);
+        smd.smd_y = SENSOR_VAL_FROM_RATIO(y * 100, gauss_lsb_xy);
+        smd.smd_z = SENSOR_VAL_FROM_RATIO(z * 100, gauss_lsb_z);
 
         smd.smd_x_is_valid = 1;
         smd.smd_y_is_valid = 1;
@@ -549,3 +614,87 @@ lsm303dlhc_sensor_get_config(struct sensor *sensor, sensor_type_t type,
 err:
     return (rc);
 }
+
+static void
+lsm303dlhc_int1_irq(void *arg)
+{
+    sensor_mgr_stream_ready(arg);
+}
+
+static int
+lsm303dlhc_sensor_stream(struct sensor *sensor, sensor_type_t type,
+        uint16_t watermark)
+{
+    uint8_t fifo_ctrl;
+    int pin;
+    int rc;
+
+    pin = MYNEWT_VAL(LSM303DLHC_INT1_PIN);
+
+    /* Only the accelerometer has a FIFO */
+    if (pin < 0 || (type & ~SENSOR_TYPE_ACCELEROMETER) != 0 ||
+        watermark > LSM303DLHC_ACCEL_FIFO_DEPTH) {
+        rc = SYS_EINVAL;
+        goto err;
+    }
+
+    if (type == SENSOR_TYPE_NONE) {
+        hal_gpio_irq_release(pin);
+
+        rc = lsm303dlhc_write8(LSM303DLHC_ADDR_ACCEL,
+            LSM303DLHC_REGISTER_ACCEL_CTRL_REG3_A, 0);
+        if (rc != 0) {
+            goto err;
+        }
+        rc = lsm303dlhc_write8(LSM303DLHC_ADDR_ACCEL,
+            LSM303DLHC_REGISTER_ACCEL_FIFO_CTRL_REG_A,
+            LSM303DLHC_ACCEL_FIFO_MODE_BYPASS);
+        if (rc != 0) {
+            goto err;
+        }
+        rc = lsm303dlhc_write8(LSM303DLHC_ADDR_ACCEL,
+            LSM303DLHC_REGISTER_ACCEL_CTRL_REG5_A, 0);
+        goto err;
+    }
+
+    if (watermark == 0) {
+        watermark = 1;
+    }
+
+    rc = hal_gpio_irq_init(pin, lsm303dlhc_int1_irq, sensor,
+                           HAL_GPIO_TRIG_RISING, HAL_GPIO_PULL_NONE);
+    if (rc != 0) {
+        goto err;
+    }
+
+    /* Enable FIFO in stream mode, interrupt on INT1 at watermark */
+    rc = lsm303dlhc_write8(LSM303DLHC_ADDR_ACCEL,
+        LSM303DLHC_REGISTER_ACCEL_CTRL_REG5_A,
+        LSM303DLHC_ACCEL_CTRL_REG5_FIFO_EN);
+    if (rc != 0) {
+        goto err_irq;
+    }
+
+    fifo_ctrl = LSM303DLHC_ACCEL_FIFO_MODE_STREAM |
+        ((watermark - 1) & LSM303DLHC_ACCEL_FIFO_FTH_MASK);
+    rc = lsm303dlhc_write8(LSM303DLHC_ADDR_ACCEL,
+        LSM303DLHC_REGISTER_ACCEL_FIFO_CTRL_REG_A, fifo_ctrl);
+    if (rc != 0) {
+        goto err_irq;
+    }
+
+    rc = lsm303dlhc_write8(LSM303DLHC_ADDR_ACCEL,
+        LSM303DLHC_REGISTER_ACCEL_CTRL_REG3_A,
+        LSM303DLHC_ACCEL_CTRL_REG3_I1_WTM);
+    if (rc != 0) {
+        goto err_irq;
+    }
+
+    hal_gpio_irq_enable(pin);
+
+    return (0);
+err_irq:
+    hal_gpio_irq_release(pin);
+err:
+    return (rc);
+}
@@ -60,6 +60,24 @@ enum lsm303dlhc_registers_accel {                         /* DEFAULT    TYPE */
     LSM303DLHC_REGISTER_ACCEL_TIME_WINDOW_A       = 0x3D
 };
 
+/* CTRL_REG3_A */
+#define LSM303DLHC_ACCEL_CTRL_REG3_I1_WTM         (0x04)
+
+/* CTRL_REG5_A */
+#define LSM303DLHC_ACCEL_CTRL_REG5_FIFO_EN        (0x40)
+
+/* FIFO_CTRL_REG_A */
+#define LSM303DLHC_ACCEL_FIFO_MODE_BYPASS         (0x00 << 6)
+#define LSM303DLHC_ACCEL_FIFO_MODE_STREAM         (0x02 << 6)
+#define LSM303DLHC_ACCEL_FIFO_FTH_MASK            (0x1F)
+
+/* FIFO_SRC_REG_A */
+#define LSM303DLHC_ACCEL_FIFO_SRC_OVRN            (0x40)
+#define LSM303DLHC_ACCEL_FIFO_SRC_FSS_MASK        (0x1F)
+
+/* Depth of the accelerometer FIFO, in samples */
+#define LSM303DLHC_ACCEL_FIFO_DEPTH               (32)
+
 enum lsm303dlhc_registers_mag {
     LSM303DLHC_REGISTER_MAG_CRA_REG_M             = 0x00,
     LSM303DLHC_REGISTER_MAG_CRB_REG_M             = 0x01,
@@ -81,6 +99,8 @@ enum lsm303dlhc_registers_mag {
 int lsm303dlhc_write8(uint8_t addr, uint8_t reg, uint32_t value);
 int lsm303dlhc_read8(uint8_t addr, uint8_t reg, uint8_t *value);
 int lsm303dlhc_read48(uint8_t addr, uint8_t reg, uint8_t *buffer);
+int lsm303dlhc_readlen(uint8_t addr, uint8_t reg, uint8_t *buffer,
+                       uint16_t len);
 
 #ifdef __cplusplus
 }
@@ -814,7 +814,8 @@ tcs34725_calc_colortemp_lux(struct sensor_color_data *scd, struct tcs34725 *tcs3
     g_comp = scd->scd_g - scd->scd_ir;
     b_comp = scd->scd_b - scd->scd_ir;
 
-    scd->scd_cratio = (float)scd->scd_ir / (float)scd->scd_c;
+    scd->scd_cratio = scd->scd_c ?
+                      SENSOR_VAL_FROM_RATIO(scd->scd_ir, scd->scd_c) : 0;
 
     scd->scd_saturation = ((256 - atime) > 63) ? 65535 : 1024 * (256 - atime);
 
@@ -0,0 +1,90 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __SPI_BUS_H__
+#define __SPI_BUS_H__
+
+#include <inttypes.h>
+#include "os/os.h"
+#include "hal/hal_spi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Package init function.  Remove when we have post-kernel init stages.
+ */
+void spi_bus_pkg_init(void);
+
+struct spi_bus_xfer;
+
+/**
+ * Called when a queued transfer completes; from the bus event queue, or
+ * from interrupt context with SPI_BUS_F_ISR_CB.
+ *
+ * @param The transfer which completed
+ * @param 0 on success, the error returned by the SPI HAL on failure
+ */
+typedef void (*spi_bus_xfer_func_t)(struct spi_bus_xfer *, int);
+
+/* Leave chip select asserted after the transfer, for the next one */
+#define SPI_BUS_F_CS_HOLD       0x01
+/* Call the completion callback from interrupt context */
+#define SPI_BUS_F_ISR_CB        0x02
+
+/**
+ * A SPI master transfer.  "sbx_len" values are sent from "sbx_txbuf" while
+ * the ones received are stored in "sbx_rxbuf", if not NULL.  Chip select
+ * is driven low around the transfer.
+ *
+ * The transfer, its buffers and settings must remain valid until it
+ * completes.
+ */
+struct spi_bus_xfer {
+    /* Chip select pin, active low; -1 if the device has none */
+    int16_t sbx_cs_pin;
+    /* SPI_BUS_F_xxx */
+    uint8_t sbx_flags;
+    uint16_t sbx_len;
+    void *sbx_txbuf;
+    void *sbx_rxbuf;
+
+    /* Settings of the device, applied if they differ from the bus's
+     * current ones; NULL to keep them.
+     */
+    struct hal_spi_settings *sbx_settings;
+
+    /* Completion callback and its argument */
+    spi_bus_xfer_func_t sbx_func;
+    void *sbx_arg;
+
+    int sbx_rc;
+    STAILQ_ENTRY(spi_bus_xfer) sbx_next;
+};
+
+int spi_bus_init(uint8_t);
+int spi_bus_submit(uint8_t, struct spi_bus_xfer *);
+int spi_bus_xfer(uint8_t, struct spi_bus_xfer *);
+int spi_bus_evq_set(uint8_t, struct os_eventq *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SPI_BUS_H__ */
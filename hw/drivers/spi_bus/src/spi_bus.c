@@ -0,0 +1,384 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include <assert.h>
+
+#include "defs/error.h"
+#include "os/os.h"
+#include "syscfg/syscfg.h"
+#include "hal/hal_gpio.h"
+#include "hal/hal_spi.h"
+#include "spi_bus/spi_bus.h"
+
+/*
+ * Transfers on a SPI master are queued, and the next one is started from
+ * the completion interrupt of the previous, so transfers to the devices
+ * sharing the bus follow each other without waiting for a task to run.
+ * Completion callbacks are called from the bus event queue, the default
+ * one unless set with spi_bus_evq_set().
+ *
+ * While a transfer with SPI_BUS_F_CS_HOLD leaves its chip select asserted,
+ * only transfers with the same chip select are started, so that a device
+ * transaction made of several transfers isn't split by others.
+ */
+struct spi_bus {
+    uint8_t sb_init:1;
+    uint8_t sb_have_settings:1;
+    /* Chip select held asserted by SPI_BUS_F_CS_HOLD, -1 if none */
+    int16_t sb_cs_held;
+    /* Transfer in progress */
+    struct spi_bus_xfer *sb_cur;
+    STAILQ_HEAD(, spi_bus_xfer) sb_queue;
+    /* Completed transfers waiting for their callback */
+    STAILQ_HEAD(, spi_bus_xfer) sb_done;
+    /* Settings last applied, if sb_have_settings */
+    struct hal_spi_settings sb_settings;
+    struct os_eventq *sb_evq;
+    struct os_event sb_ev;
+};
+
+static struct spi_bus spi_buses[MYNEWT_VAL(SPI_BUS_MAX)];
+
+/**
+ * Finish a transfer: release chip select unless held, and hand the
+ * transfer to its callback.  Called with interrupts disabled.
+ */
+static void
+spi_bus_complete(struct spi_bus *bus, struct spi_bus_xfer *xfer, int rc)
+{
+    if (xfer->sbx_cs_pin >= 0) {
+        if (rc == 0 && (xfer->sbx_flags & SPI_BUS_F_CS_HOLD)) {
+            bus->sb_cs_held = xfer->sbx_cs_pin;
+        } else {
+            hal_gpio_write(xfer->sbx_cs_pin, 1);
+        }
+    }
+
+    xfer->sbx_rc = rc;
+    if (xfer->sbx_flags & SPI_BUS_F_ISR_CB) {
+        if (xfer->sbx_func) {
+            xfer->sbx_func(xfer, rc);
+        }
+    } else {
+        STAILQ_INSERT_TAIL(&bus->sb_done, xfer, sbx_next);
+        os_eventq_put(bus->sb_evq, &bus->sb_ev);
+    }
+}
+
+/**
+ * Apply the settings of a transfer, if they differ from the current ones.
+ */
+static int
+spi_bus_settings(struct spi_bus *bus, struct spi_bus_xfer *xfer)
+{
+    int num;
+    int rc;
+
+    if (!xfer->sbx_settings || (bus->sb_have_settings &&
+        !memcmp(&bus->sb_settings, xfer->sbx_settings,
+                sizeof(bus->sb_settings)))) {
+        return (0);
+    }
+
+    num = bus - spi_buses;
+    hal_spi_disable(num);
+    rc = hal_spi_config(num, xfer->sbx_settings);
+    hal_spi_enable(num);
+
+    if (rc == 0) {
+        bus->sb_settings = *xfer->sbx_settings;
+        bus->sb_have_settings = 1;
+    } else {
+        bus->sb_have_settings = 0;
+    }
+    return (rc);
+}
+
+/**
+ * Start the next transfer which may run, if the bus is idle.  Called
+ * with interrupts disabled.
+ */
+static void
+spi_bus_start(struct spi_bus *bus)
+{
+    struct spi_bus_xfer *xfer;
+    int rc;
+
+    while (!bus->sb_cur) {
+        if (bus->sb_cs_held < 0) {
+            xfer = STAILQ_FIRST(&bus->sb_queue);
+        } else {
+            STAILQ_FOREACH(xfer, &bus->sb_queue, sbx_next) {
+                if (xfer->sbx_cs_pin == bus->sb_cs_held) {
+                    break;
+                }
+            }
+        }
+        if (!xfer) {
+            break;
+        }
+        STAILQ_REMOVE(&bus->sb_queue, xfer, spi_bus_xfer, sbx_next);
+
+        rc = spi_bus_settings(bus, xfer);
+        if (rc == 0) {
+            bus->sb_cs_held = -1;
+            if (xfer->sbx_cs_pin >= 0) {
+                hal_gpio_write(xfer->sbx_cs_pin, 0);
+            }
+            bus->sb_cur = xfer;
+            rc = hal_spi_txrx_noblock(bus - spi_buses, xfer->sbx_txbuf,
+                                      xfer->sbx_rxbuf, xfer->sbx_len);
+            if (rc != 0) {
+                bus->sb_cur = NULL;
+            }
+        }
+        if (rc != 0) {
+            spi_bus_complete(bus, xfer, rc);
+        }
+    }
+}
+
+/**
+ * SPI HAL completion callback, from interrupt context.
+ */
+static void
+spi_bus_txrx_cb(void *arg, int len)
+{
+    struct spi_bus_xfer *xfer;
+    struct spi_bus *bus;
+    os_sr_t sr;
+
+    bus = arg;
+
+    OS_ENTER_CRITICAL(sr);
+    xfer = bus->sb_cur;
+    if (xfer) {
+        bus->sb_cur = NULL;
+        spi_bus_complete(bus, xfer, 0);
+        spi_bus_start(bus);
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+
+/**
+ * Bus event, calls the callback of the first completed transfer.  If more
+ * have completed, the event is posted again rather than looping here.
+ *
+ * @param OS event
+ */
+static void
+spi_bus_event(struct os_event *ev)
+{
+    struct spi_bus_xfer *xfer;
+    struct spi_bus *bus;
+    os_sr_t sr;
+
+    bus = ev->ev_arg;
+
+    OS_ENTER_CRITICAL(sr);
+    xfer = STAILQ_FIRST(&bus->sb_done);
+    if (xfer) {
+        STAILQ_REMOVE_HEAD(&bus->sb_done, sbx_next);
+        if (!STAILQ_EMPTY(&bus->sb_done)) {
+            os_eventq_put(bus->sb_evq, &bus->sb_ev);
+        }
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    if (xfer && xfer->sbx_func) {
+        xfer->sbx_func(xfer, xfer->sbx_rc);
+    }
+}
+
+/**
+ * Take over a SPI master for queued transfers.  The SPI must have been
+ * initialized as a master with hal_spi_init(); after this call it must
+ * only be used through this package.
+ *
+ * @param The SPI number
+ *
+ * @return 0 on success, SYS_EINVAL if the SPI number is out of range,
+ *         other non-zero error code from the SPI HAL on failure.
+ */
+int
+spi_bus_init(uint8_t num)
+{
+    struct spi_bus *bus;
+    int rc;
+
+    if (num >= MYNEWT_VAL(SPI_BUS_MAX)) {
+        return (SYS_EINVAL);
+    }
+    bus = &spi_buses[num];
+
+    hal_spi_disable(num);
+    rc = hal_spi_set_txrx_cb(num, spi_bus_txrx_cb, bus);
+    if (rc == 0) {
+        rc = hal_spi_enable(num);
+    }
+    if (rc == 0) {
+        bus->sb_init = 1;
+    }
+    return (rc);
+}
+
+/**
+ * Queue a transfer on a SPI master.  Its callback is called from the bus
+ * event queue once it completes, or from interrupt context with
+ * SPI_BUS_F_ISR_CB.
+ *
+ * @param The SPI number
+ * @param The transfer to queue
+ *
+ * @return 0 on success, SYS_EINVAL if the SPI number is out of range or
+ *         the bus is not initialized.
+ */
+int
+spi_bus_submit(uint8_t num, struct spi_bus_xfer *xfer)
+{
+    struct spi_bus *bus;
+    os_sr_t sr;
+
+    if (num >= MYNEWT_VAL(SPI_BUS_MAX) || !spi_buses[num].sb_init) {
+        return (SYS_EINVAL);
+    }
+    bus = &spi_buses[num];
+
+    OS_ENTER_CRITICAL(sr);
+    STAILQ_INSERT_TAIL(&bus->sb_queue, xfer, sbx_next);
+    spi_bus_start(bus);
+    OS_EXIT_CRITICAL(sr);
+
+    return (0);
+}
+
+/* A caller blocked in spi_bus_xfer() */
+struct spi_bus_waiter {
+    struct os_task *sbw_task;
+    volatile uint8_t sbw_done;
+};
+
+static void
+spi_bus_xfer_done(struct spi_bus_xfer *xfer, int rc)
+{
+    struct spi_bus_waiter *waiter;
+
+    waiter = xfer->sbx_arg;
+    waiter->sbw_done = 1;
+    if (waiter->sbw_task) {
+        os_task_notify(waiter->sbw_task, OS_TASK_NOTIFY_IO);
+    }
+}
+
+/**
+ * Run a transfer on a SPI master, blocking until it completes.  The
+ * transfer is queued behind any others on the bus.  Before the OS has
+ * started this spins until the transfer completes.  "sbx_func" and
+ * "sbx_arg" are overwritten.
+ *
+ * @param The SPI number
+ * @param The transfer to run
+ *
+ * @return 0 on success, SYS_EINVAL if the SPI number is out of range or
+ *         the bus is not initialized, other non-zero error code from the
+ *         SPI HAL on failure.
+ */
+int
+spi_bus_xfer(uint8_t num, struct spi_bus_xfer *xfer)
+{
+    struct spi_bus_waiter waiter;
+    int rc;
+
+    waiter.sbw_task = NULL;
+    if (os_started()) {
+        waiter.sbw_task = os_sched_get_current_task();
+        os_task_notify_clear(OS_TASK_NOTIFY_IO);
+    }
+    waiter.sbw_done = 0;
+    xfer->sbx_flags |= SPI_BUS_F_ISR_CB;
+    xfer->sbx_func = spi_bus_xfer_done;
+    xfer->sbx_arg = &waiter;
+
+    rc = spi_bus_submit(num, xfer);
+    if (rc != 0) {
+        return (rc);
+    }
+
+    while (!waiter.sbw_done) {
+        if (waiter.sbw_task) {
+            os_task_notify_wait(OS_TASK_NOTIFY_IO, OS_TIMEOUT_NEVER, NULL);
+        }
+    }
+
+    return (xfer->sbx_rc);
+}
+
+/**
+ * Call completion callbacks of transfers on a SPI master from "evq".  Must
+ * not be called while transfers are queued on the bus.
+ *
+ * @param The SPI number
+ * @param The event queue to call completion callbacks from
+ *
+ * @return 0 on success, SYS_EINVAL on invalid arguments, SYS_EBUSY if
+ *         transfers are queued.
+ */
+int
+spi_bus_evq_set(uint8_t num, struct os_eventq *evq)
+{
+    struct spi_bus *bus;
+    os_sr_t sr;
+    int rc;
+
+    if (num >= MYNEWT_VAL(SPI_BUS_MAX) || !evq) {
+        return (SYS_EINVAL);
+    }
+    bus = &spi_buses[num];
+
+    rc = 0;
+    OS_ENTER_CRITICAL(sr);
+    if (!bus->sb_cur && STAILQ_EMPTY(&bus->sb_queue) &&
+        STAILQ_EMPTY(&bus->sb_done)) {
+        bus->sb_evq = evq;
+    } else {
+        rc = SYS_EBUSY;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return (rc);
+}
+
+void
+spi_bus_pkg_init(void)
+{
+    struct spi_bus *bus;
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(SPI_BUS_MAX); i++) {
+        bus = &spi_buses[i];
+        memset(bus, 0, sizeof(*bus));
+        bus->sb_cs_held = -1;
+        STAILQ_INIT(&bus->sb_queue);
+        STAILQ_INIT(&bus->sb_done);
+        bus->sb_ev.ev_cb = spi_bus_event;
+        bus->sb_ev.ev_arg = bus;
+        bus->sb_evq = os_eventq_dflt_get();
+    }
+}
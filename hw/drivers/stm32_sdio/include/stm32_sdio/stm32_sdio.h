@@ -0,0 +1,97 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __STM32_SDIO_H__
+#define __STM32_SDIO_H__
+
+#include <disk/disk.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * SDIO driver errors.
+ */
+#define STM32_SDIO_OK           (0)
+#define STM32_SDIO_CARD_ERROR   (-1)  /* Is there a card installed? */
+#define STM32_SDIO_READ_ERROR   (-2)
+#define STM32_SDIO_WRITE_ERROR  (-3)
+#define STM32_SDIO_TIMEOUT      (-4)
+#define STM32_SDIO_PARAM_ERROR  (-5)
+
+extern struct disk_ops stm32_sdio_ops;
+
+/**
+ * Initialize the SDIO (STM32F4) or SDMMC1 (STM32F7) controller and the card
+ * in the slot.  The controller uses its fixed pins, PC8-PC12 and PD2, and
+ * DMA2 streams 3 (RX) and 6 (TX).
+ *
+ * @param cd_pin GPIO number of the card detect switch, pulled low when a
+ *               card is inserted, or -1 if the slot has none.
+ *
+ * @return 0 on success, non-zero on failure
+ */
+int
+stm32_sdio_init(int cd_pin);
+
+/**
+ * Read data from the SD card
+ *
+ * @param id Id of the SD device (currently must be 0)
+ * @param addr Disk address (in bytes) to be read from
+ * @param buf Buffer where data should be copied to
+ * @param len Amount of data to read/copy
+ *
+ * @return 0 on success, non-zero on failure
+ */
+int
+stm32_sdio_read(uint8_t id, uint32_t addr, void *buf, uint32_t len);
+
+/**
+ * Write data to the SD card
+ *
+ * @param id Id of the SD device (currently must be 0)
+ * @param addr Disk address (in bytes) to be written to
+ * @param buf Buffer where data should be copied from
+ * @param len Amount of data to copy/write
+ *
+ * @return 0 on success, non-zero on failure
+ */
+int
+stm32_sdio_write(uint8_t id, uint32_t addr, const void *buf, uint32_t len);
+
+/**
+ * Device control, the disk ioctl hook. No commands are supported yet;
+ * every command is accepted and ignored.
+ *
+ * @param id Id of the SD device (currently must be 0)
+ * @param cmd Command
+ * @param arg Command specific argument
+ *
+ * @return 0
+ */
+int
+stm32_sdio_ioctl(uint8_t id, uint32_t cmd, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STM32_SDIO_H__ */
@@ -0,0 +1,518 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include <syscfg/syscfg.h>
+#include <os/os.h>
+#include <hal/hal_gpio.h>
+#include <bsp/cmsis_nvic.h>
+
+#if MYNEWT_VAL(MCU_STM32F4)
+#include <bsp/stm32f4xx_hal_conf.h>
+#include <mcu/stm32f4_bsp.h>
+#endif
+#if MYNEWT_VAL(MCU_STM32F7)
+#include <bsp/stm32f7xx_hal_conf.h>
+#include <mcu/stm32f7_bsp.h>
+#include <mcu/stm32f7_cache.h>
+#endif
+#include <mcu/mcu.h>
+
+#include "stm32_sdio/stm32_sdio.h"
+
+#ifndef HAL_SD_MODULE_ENABLED
+#error "stm32_sdio needs HAL_SD_MODULE_ENABLED in the BSP's HAL configuration"
+#endif
+
+#define BLOCK_LEN               512
+
+/*
+ * Longest run of blocks moved by one DMA transfer; keeps the word count
+ * the HAL programs into the DMA stream within 16 bits.
+ */
+#define STM32_SDIO_MAX_BLOCKS   64
+
+#define STM32_SDIO_XFER_TICKS \
+    ((MYNEWT_VAL(STM32_SDIO_XFER_TIMEOUT) * OS_TICKS_PER_SEC + 999) / 1000)
+
+#if MYNEWT_VAL(MCU_STM32F4)
+#define STM32_SDIO_INST         SDIO
+#define STM32_SDIO_IRQ          SDIO_IRQn
+#define STM32_SDIO_AF           GPIO_AF12_SDIO
+#define STM32_SDIO_CLK_ENABLE() __HAL_RCC_SDIO_CLK_ENABLE()
+#define STM32_SDIO_BUS_WIDE_4B  SDIO_BUS_WIDE_4B
+/* DMA moves words */
+#define STM32_SDIO_DMA_ALIGN    4
+/*
+ * HAL_SD_Check{Read,Write}Operation() spin count.  Only used once the
+ * transfer has signalled completion, to let the DMA FIFO drain.
+ */
+#define STM32_SDIO_CHECK_SPINS  0x100000
+#else
+#define STM32_SDIO_INST         SDMMC1
+#define STM32_SDIO_IRQ          SDMMC1_IRQn
+#define STM32_SDIO_AF           GPIO_AF12_SDMMC1
+#define STM32_SDIO_CLK_ENABLE() __HAL_RCC_SDMMC1_CLK_ENABLE()
+#define STM32_SDIO_BUS_WIDE_4B  SDMMC_BUS_WIDE_4B
+/* Buffers given to DMA directly must not share cache lines. */
+#define STM32_SDIO_DMA_ALIGN    STM32F7_DCACHE_LINE
+#endif
+
+struct stm32_sdio_state {
+    SD_HandleTypeDef hsd;
+    DMA_HandleTypeDef dma_rx;
+    DMA_HandleTypeDef dma_tx;
+    struct os_task *xfer_task;
+    struct os_mutex lock;
+    volatile int xfer_err;
+    int cd_pin;
+};
+
+static struct stm32_sdio_state g_sdio;
+
+/* Bounce buffer for partial and misaligned blocks. */
+static uint8_t g_block_buf[BLOCK_LEN]
+    __attribute__((aligned(STM32_SDIO_DMA_ALIGN)));
+
+static void
+stm32_sdio_isr(void)
+{
+    HAL_SD_IRQHandler(&g_sdio.hsd);
+}
+
+static void
+stm32_sdio_dma_rx_isr(void)
+{
+    HAL_DMA_IRQHandler(&g_sdio.dma_rx);
+}
+
+static void
+stm32_sdio_dma_tx_isr(void)
+{
+    HAL_DMA_IRQHandler(&g_sdio.dma_tx);
+}
+
+/*
+ * Transfer completion callbacks, overriding the HAL's weak ones.  These run
+ * in interrupt context and wake up the task waiting in stm32_sdio_xfer().
+ */
+static void
+stm32_sdio_xfer_done(void)
+{
+    os_task_notify(g_sdio.xfer_task, OS_TASK_NOTIFY_IO);
+}
+
+#if MYNEWT_VAL(MCU_STM32F4)
+void
+HAL_SD_XferCpltCallback(SD_HandleTypeDef *hsd)
+{
+    stm32_sdio_xfer_done();
+}
+
+void
+HAL_SD_XferErrorCallback(SD_HandleTypeDef *hsd)
+{
+    g_sdio.xfer_err = 1;
+    stm32_sdio_xfer_done();
+}
+#else
+void
+HAL_SD_RxCpltCallback(SD_HandleTypeDef *hsd)
+{
+    stm32_sdio_xfer_done();
+}
+
+void
+HAL_SD_TxCpltCallback(SD_HandleTypeDef *hsd)
+{
+    stm32_sdio_xfer_done();
+}
+
+void
+HAL_SD_ErrorCallback(SD_HandleTypeDef *hsd)
+{
+    g_sdio.xfer_err = 1;
+    stm32_sdio_xfer_done();
+}
+#endif
+
+static void
+stm32_sdio_dma_init(DMA_HandleTypeDef *hdma, DMA_Stream_TypeDef *stream,
+                    uint32_t dir)
+{
+    hdma->Instance = stream;
+    hdma->Init.Channel = DMA_CHANNEL_4;
+    hdma->Init.Direction = dir;
+    hdma->Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma->Init.MemInc = DMA_MINC_ENABLE;
+    hdma->Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+    hdma->Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+    /* The SDIO controller decides when the transfer is done. */
+    hdma->Init.Mode = DMA_PFCTRL;
+    hdma->Init.Priority = DMA_PRIORITY_VERY_HIGH;
+    hdma->Init.FIFOMode = DMA_FIFOMODE_ENABLE;
+    hdma->Init.FIFOThreshold = DMA_FIFO_THRESHOLD_FULL;
+    hdma->Init.MemBurst = DMA_MBURST_INC4;
+    hdma->Init.PeriphBurst = DMA_PBURST_INC4;
+    HAL_DMA_Init(hdma);
+}
+
+static int
+stm32_sdio_card_present(void)
+{
+    /* Card detect switch closes to ground */
+    return g_sdio.cd_pin < 0 || hal_gpio_read(g_sdio.cd_pin) == 0;
+}
+
+/**
+ * Move cnt whole blocks, starting at block blk, between the card and buf
+ * using DMA.  The calling task sleeps until the transfer completes.
+ */
+static int
+stm32_sdio_xfer(int write, uint32_t blk, uint8_t *buf, uint32_t cnt)
+{
+    SD_HandleTypeDef *hsd;
+    int rc;
+#if MYNEWT_VAL(MCU_STM32F7)
+    os_time_t start;
+#endif
+
+    hsd = &g_sdio.hsd;
+
+    /* Drop a completion left over from an earlier, aborted transfer. */
+    g_sdio.xfer_task = os_sched_get_current_task();
+    os_task_notify_clear(OS_TASK_NOTIFY_IO);
+    g_sdio.xfer_err = 0;
+
+#if MYNEWT_VAL(MCU_STM32F4)
+    if (write) {
+        rc = HAL_SD_WriteBlocks_DMA(hsd, (uint32_t *)buf,
+                                    (uint64_t)blk * BLOCK_LEN, BLOCK_LEN, cnt);
+    } else {
+        rc = HAL_SD_ReadBlocks_DMA(hsd, (uint32_t *)buf,
+                                   (uint64_t)blk * BLOCK_LEN, BLOCK_LEN, cnt);
+    }
+    if (rc != SD_OK) {
+        goto err;
+    }
+
+    if (os_task_notify_wait(OS_TASK_NOTIFY_IO, STM32_SDIO_XFER_TICKS,
+                            NULL)) {
+        HAL_SD_StopTransfer(hsd);
+        HAL_DMA_Abort(write ? hsd->hdmatx : hsd->hdmarx);
+        return STM32_SDIO_TIMEOUT;
+    }
+
+    /* Waits for the DMA to drain, and stops a multi-block transfer. */
+    if (write) {
+        rc = HAL_SD_CheckWriteOperation(hsd, STM32_SDIO_CHECK_SPINS);
+    } else {
+        rc = HAL_SD_CheckReadOperation(hsd, STM32_SDIO_CHECK_SPINS);
+    }
+    if (rc != SD_OK || g_sdio.xfer_err) {
+        goto err;
+    }
+#else
+    if (write) {
+        stm32f7_dcache_clean(buf, cnt * BLOCK_LEN);
+        rc = HAL_SD_WriteBlocks_DMA(hsd, buf, blk, cnt);
+    } else {
+        stm32f7_dcache_invalidate(buf, cnt * BLOCK_LEN);
+        rc = HAL_SD_ReadBlocks_DMA(hsd, buf, blk, cnt);
+    }
+    if (rc != HAL_OK) {
+        goto err;
+    }
+
+    if (os_task_notify_wait(OS_TASK_NOTIFY_IO, STM32_SDIO_XFER_TICKS,
+                            NULL)) {
+        HAL_SD_Abort(hsd);
+        return STM32_SDIO_TIMEOUT;
+    }
+    if (g_sdio.xfer_err) {
+        goto err;
+    }
+
+    if (!write) {
+        stm32f7_dcache_invalidate(buf, cnt * BLOCK_LEN);
+    }
+
+    /* Wait for the card to finish programming, or to leave data state. */
+    start = os_time_get();
+    while (HAL_SD_GetCardState(hsd) != HAL_SD_CARD_TRANSFER) {
+        if (os_time_get() - start > STM32_SDIO_XFER_TICKS) {
+            return STM32_SDIO_TIMEOUT;
+        }
+        os_time_delay(1);
+    }
+#endif
+
+    return STM32_SDIO_OK;
+err:
+    return write ? STM32_SDIO_WRITE_ERROR : STM32_SDIO_READ_ERROR;
+}
+
+int
+stm32_sdio_read(uint8_t id, uint32_t addr, void *buf, uint32_t len)
+{
+    uint8_t *dst;
+    uint32_t blk;
+    uint32_t offset;
+    uint32_t cnt;
+    uint32_t amount;
+    int rc;
+
+    if (id != 0) {
+        return STM32_SDIO_PARAM_ERROR;
+    }
+
+    os_mutex_pend(&g_sdio.lock, OS_TIMEOUT_NEVER);
+
+    if (!stm32_sdio_card_present()) {
+        rc = STM32_SDIO_CARD_ERROR;
+        goto out;
+    }
+
+    dst = buf;
+    blk = addr / BLOCK_LEN;
+    offset = addr % BLOCK_LEN;
+    rc = STM32_SDIO_OK;
+
+    while (len > 0) {
+        if (offset == 0 && len >= BLOCK_LEN &&
+            ((uint32_t)dst & (STM32_SDIO_DMA_ALIGN - 1)) == 0) {
+            /* Whole blocks go straight into the caller's buffer. */
+            cnt = len / BLOCK_LEN;
+            if (cnt > STM32_SDIO_MAX_BLOCKS) {
+                cnt = STM32_SDIO_MAX_BLOCKS;
+            }
+            rc = stm32_sdio_xfer(0, blk, dst, cnt);
+            if (rc) {
+                goto out;
+            }
+            amount = cnt * BLOCK_LEN;
+        } else {
+            cnt = 1;
+            rc = stm32_sdio_xfer(0, blk, g_block_buf, 1);
+            if (rc) {
+                goto out;
+            }
+            amount = BLOCK_LEN - offset;
+            if (amount > len) {
+                amount = len;
+            }
+            memcpy(dst, &g_block_buf[offset], amount);
+        }
+
+        dst += amount;
+        len -= amount;
+        blk += cnt;
+        offset = 0;
+    }
+
+out:
+    os_mutex_release(&g_sdio.lock);
+    return rc;
+}
+
+int
+stm32_sdio_write(uint8_t id, uint32_t addr, const void *buf, uint32_t len)
+{
+    const uint8_t *src;
+    uint32_t blk;
+    uint32_t offset;
+    uint32_t cnt;
+    uint32_t amount;
+    int rc;
+
+    if (id != 0) {
+        return STM32_SDIO_PARAM_ERROR;
+    }
+
+    os_mutex_pend(&g_sdio.lock, OS_TIMEOUT_NEVER);
+
+    if (!stm32_sdio_card_present()) {
+        rc = STM32_SDIO_CARD_ERROR;
+        goto out;
+    }
+
+    src = buf;
+    blk = addr / BLOCK_LEN;
+    offset = addr % BLOCK_LEN;
+    rc = STM32_SDIO_OK;
+
+    while (len > 0) {
+        if (offset == 0 && len >= BLOCK_LEN &&
+            ((uint32_t)src & (STM32_SDIO_DMA_ALIGN - 1)) == 0) {
+            cnt = len / BLOCK_LEN;
+            if (cnt > STM32_SDIO_MAX_BLOCKS) {
+                cnt = STM32_SDIO_MAX_BLOCKS;
+            }
+            rc = stm32_sdio_xfer(1, blk, (uint8_t *)src, cnt);
+            if (rc) {
+                goto out;
+            }
+            amount = cnt * BLOCK_LEN;
+        } else {
+            cnt = 1;
+            amount = BLOCK_LEN - offset;
+            if (amount > len) {
+                amount = len;
+            }
+            /* Partial block: read-modify-write through the bounce buffer. */
+            if (amount < BLOCK_LEN) {
+                rc = stm32_sdio_xfer(0, blk, g_block_buf, 1);
+                if (rc) {
+                    goto out;
+                }
+            }
+            memcpy(&g_block_buf[offset], src, amount);
+            rc = stm32_sdio_xfer(1, blk, g_block_buf, 1);
+            if (rc) {
+                goto out;
+            }
+        }
+
+        src += amount;
+        len -= amount;
+        blk += cnt;
+        offset = 0;
+    }
+
+out:
+    os_mutex_release(&g_sdio.lock);
+    return rc;
+}
+
+/*
+ * No commands yet.
+ */
+int
+stm32_sdio_ioctl(uint8_t id, uint32_t cmd, void *arg)
+{
+    return 0;
+}
+
+int
+stm32_sdio_init(int cd_pin)
+{
+    static const int pins[] = {
+        MCU_GPIO_PORTC(8),      /* D0 */
+        MCU_GPIO_PORTC(12),     /* CK */
+        MCU_GPIO_PORTD(2),      /* CMD */
+#if MYNEWT_VAL(STM32_SDIO_BUS_WIDTH) == 4
+        MCU_GPIO_PORTC(9),      /* D1 */
+        MCU_GPIO_PORTC(10),     /* D2 */
+        MCU_GPIO_PORTC(11),     /* D3 */
+#endif
+    };
+    SD_HandleTypeDef *hsd;
+#if MYNEWT_VAL(MCU_STM32F4)
+    HAL_SD_CardInfoTypedef info;
+#endif
+    int rc;
+    int i;
+
+    memset(&g_sdio, 0, sizeof(g_sdio));
+    g_sdio.cd_pin = cd_pin;
+    os_mutex_init(&g_sdio.lock);
+
+    if (cd_pin >= 0) {
+        hal_gpio_init_in(cd_pin, HAL_GPIO_PULL_UP);
+    }
+    for (i = 0; i < sizeof(pins) / sizeof(pins[0]); i++) {
+        /* CK is driven by us; the card's lines are open drain. */
+        hal_gpio_init_af(pins[i], STM32_SDIO_AF,
+                         i == 1 ? GPIO_NOPULL : GPIO_PULLUP, 0);
+    }
+
+    STM32_SDIO_CLK_ENABLE();
+    __HAL_RCC_DMA2_CLK_ENABLE();
+
+    hsd = &g_sdio.hsd;
+    hsd->Instance = STM32_SDIO_INST;
+
+    stm32_sdio_dma_init(&g_sdio.dma_rx, DMA2_Stream3, DMA_PERIPH_TO_MEMORY);
+    __HAL_LINKDMA(hsd, hdmarx, g_sdio.dma_rx);
+    stm32_sdio_dma_init(&g_sdio.dma_tx, DMA2_Stream6, DMA_MEMORY_TO_PERIPH);
+    __HAL_LINKDMA(hsd, hdmatx, g_sdio.dma_tx);
+
+    NVIC_SetVector(STM32_SDIO_IRQ, (uint32_t)stm32_sdio_isr);
+    NVIC_SetVector(DMA2_Stream3_IRQn, (uint32_t)stm32_sdio_dma_rx_isr);
+    NVIC_SetVector(DMA2_Stream6_IRQn, (uint32_t)stm32_sdio_dma_tx_isr);
+    NVIC_EnableIRQ(STM32_SDIO_IRQ);
+    NVIC_EnableIRQ(DMA2_Stream3_IRQn);
+    NVIC_EnableIRQ(DMA2_Stream6_IRQn);
+
+    if (!stm32_sdio_card_present()) {
+        return STM32_SDIO_CARD_ERROR;
+    }
+
+    /*
+     * The HAL identifies the card at 400kHz on a 1-bit bus, then switches
+     * to these settings.
+     */
+#if MYNEWT_VAL(MCU_STM32F4)
+    hsd->Init.ClockEdge = SDIO_CLOCK_EDGE_RISING;
+    hsd->Init.ClockBypass = SDIO_CLOCK_BYPASS_DISABLE;
+    hsd->Init.ClockPowerSave = SDIO_CLOCK_POWER_SAVE_DISABLE;
+    hsd->Init.BusWide = SDIO_BUS_WIDE_1B;
+    hsd->Init.HardwareFlowControl = SDIO_HARDWARE_FLOW_CONTROL_DISABLE;
+    hsd->Init.ClockDiv = MYNEWT_VAL(STM32_SDIO_CLK_DIV);
+
+    if (HAL_SD_Init(hsd, &info) != SD_OK) {
+        return STM32_SDIO_CARD_ERROR;
+    }
+#if MYNEWT_VAL(STM32_SDIO_BUS_WIDTH) == 4
+    rc = HAL_SD_WideBusOperation_Config(hsd, STM32_SDIO_BUS_WIDE_4B);
+    if (rc != SD_OK) {
+        return STM32_SDIO_CARD_ERROR;
+    }
+#endif
+#else
+    hsd->Init.ClockEdge = SDMMC_CLOCK_EDGE_RISING;
+    hsd->Init.ClockBypass = SDMMC_CLOCK_BYPASS_DISABLE;
+    hsd->Init.ClockPowerSave = SDMMC_CLOCK_POWER_SAVE_DISABLE;
+    hsd->Init.BusWide = SDMMC_BUS_WIDE_1B;
+    hsd->Init.HardwareFlowControl = SDMMC_HARDWARE_FLOW_CONTROL_DISABLE;
+    hsd->Init.ClockDiv = MYNEWT_VAL(STM32_SDIO_CLK_DIV);
+
+    if (HAL_SD_Init(hsd) != HAL_OK) {
+        return STM32_SDIO_CARD_ERROR;
+    }
+#if MYNEWT_VAL(STM32_SDIO_BUS_WIDTH) == 4
+    rc = HAL_SD_ConfigWideBusOperation(hsd, STM32_SDIO_BUS_WIDE_4B);
+    if (rc != HAL_OK) {
+        return STM32_SDIO_CARD_ERROR;
+    }
+#endif
+#endif
+
+    return STM32_SDIO_OK;
+}
+
+/*
+ *
+ */
+struct disk_ops stm32_sdio_ops = {
+    .read  = &stm32_sdio_read,
+    .write = &stm32_sdio_write,
+    .ioctl = &stm32_sdio_ioctl,
+};
@@ -66,6 +66,37 @@ typedef void (*uart_tx_done)(void *arg);
  */
 typedef int (*uart_rx_char)(void *arg, uint8_t byte);
 
+/*
+ * Function prototype for UART driver to ask for a block of data to send.
+ * Optional; drivers which can't send blocks use uart_tx_char instead.
+ * Driver must call this with interrupts disabled.
+ *
+ * @param arg		This is uc_cb_arg passed in uart_conf in
+ *			os_dev_open().
+ * @param data		Set to point to data to send. Data must stay in
+ *			place until next call, and must be in RAM.
+ * @param max		Maximum number of bytes driver can take.
+ *
+ * @return		Number of bytes at *data, 0 if no more data to send.
+ */
+typedef int (*uart_tx_buf)(void *arg, uint8_t **data, int max);
+
+/*
+ * Function prototype for UART driver to report a block of incoming data.
+ * Optional; drivers which can't receive blocks use uart_rx_char instead.
+ * Driver must call this with interrupts disabled.
+ *
+ * @param arg		This is uc_cb_arg passed in uart_conf in
+ *			os_dev_open().
+ * @param data		Received data.
+ * @param len		Number of bytes at data.
+ *
+ * @return		Number of bytes taken. If less than len, receiving
+ *			stops until uart_start_rx(), which reports the rest
+ *			again.
+ */
+typedef int (*uart_rx_buf)(void *arg, uint8_t *data, int len);
+
 struct uart_driver_funcs {
     void (*uf_start_tx)(struct uart_dev *);
     void (*uf_start_rx)(struct uart_dev *);
@@ -102,6 +133,8 @@ struct uart_conf {
     uart_rx_char uc_rx_char;
     uart_tx_done uc_tx_done;
     void *uc_cb_arg;
+    uart_tx_buf uc_tx_buf;
+    uart_rx_buf uc_rx_buf;
 };
 
 /*
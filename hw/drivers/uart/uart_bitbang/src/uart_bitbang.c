@@ -25,6 +25,7 @@
 #include <hal/hal_uart.h>
 #include <hal/hal_timer.h>
 
+#include <syscfg/syscfg.h>
 #include <os/os.h>
 #include <os/os_dev.h>
 #include <os/os_cputime.h>
@@ -32,10 +33,17 @@
 
 #include "uart_bitbang/uart_bitbang.h"
 
+#if MYNEWT_VAL(UART_BITBANG_CAPTURE_CC) >= 0
+#include <mcu/nrf52_hal.h>
+#define UART_BITBANG_CAPTURE    1
+#endif
+
 /*
  * Async UART as a bitbanger.
  * Cannot run very fast, as it relies on cputimer to time sampling and
- * bit tx start times.
+ * bit tx start times.  On nRF52 the start of RX can be timestamped in
+ * hardware: PPI connects the GPIOTE event of the RX pin to a capture task of
+ * the cputime timer.
  */
 struct uart_bitbang {
     int ub_bittime;             /* number of cputimer ticks per bit */
@@ -46,6 +54,10 @@ struct uart_bitbang {
         uint8_t byte;           /* receiving this byte */
         uint8_t bits;           /* how many bits we've seen */
         int false_irq;
+#if UART_BITBANG_CAPTURE
+        int ppi;                /* GPIOTE event -> capture, -1 if none */
+        volatile uint32_t *capture; /* captured cputime of the last edge */
+#endif
     } ub_rx;
     struct {
         int pin;                /* TX pin */
@@ -155,7 +167,11 @@ uart_bitbang_isr(void *arg)
     struct uart_bitbang *ub = (struct uart_bitbang *)arg;
     uint32_t time;
 
+#if UART_BITBANG_CAPTURE
+    time = *ub->ub_rx.capture;
+#else
     time = os_cputime_get32();
+#endif
     if (ub->ub_rx.start - time < (9 * ub->ub_bittime)) {
         ++ub->ub_rx.false_irq;
         return;
@@ -240,6 +256,33 @@ uart_bitbang_start_rx(struct uart_dev *dev)
     }
 }
 
+#if UART_BITBANG_CAPTURE
+static int
+uart_bitbang_capture_init(struct uart_bitbang *ub)
+{
+    volatile uint32_t *event;
+    volatile uint32_t *task;
+
+    event = nrf52_gpio_irq_event(ub->ub_rx.pin);
+    if (!event) {
+        return -1;
+    }
+    if (nrf52_hal_timer_capture(MYNEWT_VAL(OS_CPUTIME_TIMER_NUM),
+        MYNEWT_VAL(UART_BITBANG_CAPTURE_CC), &task, &ub->ub_rx.capture)) {
+        return -1;
+    }
+    if (ub->ub_rx.ppi < 0) {
+        ub->ub_rx.ppi = nrf52_ppi_alloc();
+        if (ub->ub_rx.ppi < 0) {
+            return -1;
+        }
+    }
+    nrf52_ppi_connect(ub->ub_rx.ppi, event, task);
+    nrf52_ppi_enable(ub->ub_rx.ppi);
+    return 0;
+}
+#endif
+
 static int
 uart_bitbang_config(struct uart_bitbang *ub, int32_t baudrate, uint8_t databits,
   uint8_t stopbits, enum hal_uart_parity parity,
@@ -268,6 +311,12 @@ uart_bitbang_config(struct uart_bitbang *ub, int32_t baudrate, uint8_t databits,
         HAL_GPIO_TRIG_FALLING, HAL_GPIO_PULL_UP)) {
         return -1;
     }
+#if UART_BITBANG_CAPTURE
+    if (uart_bitbang_capture_init(ub)) {
+        hal_gpio_irq_release(ub->ub_rx.pin);
+        return -1;
+    }
+#endif
     hal_gpio_irq_enable(ub->ub_rx.pin);
 
     ub->ub_open = 1;
@@ -307,6 +356,12 @@ uart_bitbang_close(struct os_dev *odev)
     OS_ENTER_CRITICAL(sr);
     hal_gpio_irq_disable(ub->ub_rx.pin);
     hal_gpio_irq_release(ub->ub_rx.pin);
+#if UART_BITBANG_CAPTURE
+    if (ub->ub_rx.ppi >= 0) {
+        nrf52_ppi_free(ub->ub_rx.ppi);
+        ub->ub_rx.ppi = -1;
+    }
+#endif
     ub->ub_open = 0;
     ub->ub_txing = 0;
     ub->ub_rx_stall = 0;
@@ -333,6 +388,9 @@ uart_bitbang_init(struct os_dev *odev, void *arg)
     ub->ub_rx.pin = ubc->ubc_rxpin;
     ub->ub_tx.pin = ubc->ubc_txpin;
     ub->ub_cputimer_freq = ubc->ubc_cputimer_freq;
+#if UART_BITBANG_CAPTURE
+    ub->ub_rx.ppi = -1;
+#endif
 
     OS_DEV_SETHANDLERS(odev, uart_bitbang_open, uart_bitbang_close);
 
@@ -82,6 +82,14 @@ uart_hal_open(struct os_dev *odev, uint32_t wait, void *arg)
     }
     hal_uart_init_cbs(priv->unit, uc->uc_tx_char, uc->uc_tx_done,
       uc->uc_rx_char, uc->uc_cb_arg);
+    if (uc->uc_tx_buf) {
+        /* If not supported, tx_char is used. */
+        hal_uart_init_tx_buf(priv->unit, uc->uc_tx_buf);
+    }
+    if (uc->uc_rx_buf) {
+        /* If not supported, rx_char is used. */
+        hal_uart_init_rx_buf(priv->unit, uc->uc_rx_buf);
+    }
 
     rc = hal_uart_config(priv->unit, uc->uc_speed, uc->uc_databits,
       uc->uc_stopbits, (enum hal_uart_parity)uc->uc_parity, (enum hal_uart_flow_ctl)uc->uc_flow_ctl);
@@ -0,0 +1,53 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _HAL_AES_H_
+#define _HAL_AES_H_
+
+#include <stdint.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * AES-128 block encryption using a hardware AES engine (e.g. nrf5x ECB,
+ * STM32 CRYP).  Only MCUs with such an engine provide this; it is used by
+ * the LoRa MAC (LORA_NODE_CRYPTO_HAL), the BLE security manager
+ * (BLE_SM_ALG_HAL_AES), tinycrypt (TINYCRYPT_AES_HAL) and mbedtls
+ * (MBEDTLS_AES_HAL).  Callable from any context; the engine is held only
+ * for the duration of the call.
+ *
+ * All buffers are in the byte order of FIPS-197, i.e. most significant
+ * byte first.
+ *
+ * @param key			16 byte key
+ * @param in			16 byte plaintext block
+ * @param out			Filled with the 16 byte ciphertext block;
+ *				may be the same buffer as in
+ *
+ * @return			0 on success; nonzero if the engine is
+ *				unavailable
+ */
+int hal_aes128_encrypt(const uint8_t *key, const uint8_t *in, uint8_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HAL_AES_H_ */
@@ -0,0 +1,50 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _HAL_CRC_H_
+#define _HAL_CRC_H_
+
+#include <stdint.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Runs CRC-32 (IEEE 802.3, reflected) over buf using a hardware CRC
+ * unit, starting from the reset value 0xffffffff.  Only MCUs with such
+ * a unit provide this; it is used by util/crc when CRC32_HAL is set.
+ *
+ * The unit may process only part of the buffer (e.g. whole words); the
+ * caller finishes the rest in software.
+ *
+ * @param buf			Data to checksum
+ * @param len			Length of data
+ * @param crc			Filled with the CRC register value, without
+ *				the final inversion
+ *
+ * @return			number of bytes from the start of buf which
+ *				were processed; <= 0 if none
+ */
+int hal_crc32(const void *buf, int len, uint32_t *crc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HAL_CRC_H_ */
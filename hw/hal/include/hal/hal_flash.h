@@ -33,6 +33,23 @@ int hal_flash_write(uint8_t flash_id, uint32_t address, const void *src,
   uint32_t num_bytes);
 int hal_flash_erase_sector(uint8_t flash_id, uint32_t sector_address);
 int hal_flash_erase(uint8_t flash_id, uint32_t address, uint32_t num_bytes);
+
+/*
+ * Called when an operation started with hal_flash_erase_sector_async()
+ * has finished; rc is 0 on success.  Can be called from interrupt context,
+ * and must not start new flash operations.
+ */
+typedef void (*hal_flash_done_cb)(void *arg, int rc);
+
+/*
+ * Starts erasing a sector, and returns without waiting for it to finish.
+ * No other operation may be done on the flash device until cb has been
+ * called.  Returns nonzero if the erase could not be started; cb is not
+ * called then.  On flash devices which can't erase in the background, the
+ * sector is erased before this returns, and cb is called from it.
+ */
+int hal_flash_erase_sector_async(uint8_t flash_id, uint32_t sector_address,
+  hal_flash_done_cb cb, void *arg);
 uint8_t hal_flash_align(uint8_t flash_id);
 int hal_flash_init(void);
 
@@ -25,6 +25,7 @@ extern "C" {
 #endif
 
 #include <inttypes.h>
+#include "hal/hal_flash.h"
 
 /*
  * API that flash driver has to implement.
@@ -41,6 +42,9 @@ struct hal_flash_funcs {
     int (*hff_sector_info)(const struct hal_flash *dev, int idx,
             uint32_t *address, uint32_t *size);
     int (*hff_init)(const struct hal_flash *dev);
+    /* Optional; NULL if driver can only erase synchronously. */
+    int (*hff_erase_sector_async)(const struct hal_flash *dev,
+            uint32_t sector_address, hal_flash_done_cb cb, void *arg);
 };
 
 struct hal_flash {
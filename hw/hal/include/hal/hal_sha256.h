@@ -0,0 +1,60 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _HAL_SHA256_H_
+#define _HAL_SHA256_H_
+
+#include <stdint.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * SHA-256 using a hardware hash engine (e.g. STM32 HASH, CC310).  Only
+ * MCUs with such an engine provide these; bootutil uses them when
+ * BOOTUTIL_HASH_HAL is set, mbedtls when MBEDTLS_SHA256_HAL is set.  One
+ * hash can be in progress at a time; hal_sha256_start() fails while
+ * another is.
+ */
+
+/*
+ * Starts a new hash.
+ *
+ * @return			0 on success; nonzero if the engine is
+ *				unavailable
+ */
+int hal_sha256_start(void);
+
+/*
+ * Adds data to the hash in progress.
+ */
+int hal_sha256_update(const void *data, uint32_t len);
+
+/*
+ * Completes the hash in progress.
+ *
+ * @param digest		Filled with the 32 byte digest
+ */
+int hal_sha256_finish(uint8_t *digest);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HAL_SHA256_H_ */
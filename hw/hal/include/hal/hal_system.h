@@ -20,6 +20,8 @@
 #ifndef H_HAL_SYSTEM_
 #define H_HAL_SYSTEM_
 
+#include <inttypes.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -60,6 +62,18 @@ enum hal_reset_reason hal_reset_cause(void);
 /* Starts clocks needed by system */
 void hal_system_clock_start(void);
 
+/*
+ * Run the CPU at its full speed clock divided by 'div' (1 is full speed).
+ * Peripherals driven by the OS (os_time tick, hal_timer, UART baud rates)
+ * are retimed, so timing is kept. Returns 0 on success, -1 if the divider
+ * is not supported, or if a running timer could not keep its frequency.
+ * MCUs which cannot scale their clock only accept 1.
+ */
+int hal_system_clock_div_set(uint32_t div);
+
+/* Returns the current CPU clock divider. */
+uint32_t hal_system_clock_div_get(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -49,9 +49,41 @@ struct hal_timer
     hal_timer_cb        cb_func;    /* Callback function */
     void                *cb_arg;    /* Callback argument */
     uint32_t            expiry;     /* Tick at which timer should expire */
-    TAILQ_ENTRY(hal_timer) link;    /* Queue linked list structure */
+    /* Timer queue (pairing heap) links; see struct hal_timer_queue */
+    struct hal_timer    *child;     /* Leftmost child */
+    struct hal_timer    *sibling;   /* Right sibling */
+    struct hal_timer    *prev;      /* Parent or left sibling; NULL if idle */
 };
 
+/**
+ * Queue of started timers, ordered by expiry, for use by the MCU specific
+ * HAL timer implementations.  It is a pairing heap: insert and finding the
+ * first timer are O(1), removal O(log n) amortized, so starting a timer
+ * doesn't walk all others with interrupts disabled.  Expiries are compared
+ * as (int32_t)(a - b), like the rest of the timer code.  Callers must
+ * disable interrupts around the queue functions.
+ */
+struct hal_timer_queue {
+    struct hal_timer *htq_first;
+};
+
+void hal_timer_queue_insert(struct hal_timer_queue *q, struct hal_timer *tmr);
+void hal_timer_queue_remove(struct hal_timer_queue *q, struct hal_timer *tmr);
+
+/* The timer expiring first, NULL if the queue is empty */
+static inline struct hal_timer *
+hal_timer_queue_first(struct hal_timer_queue *q)
+{
+    return q->htq_first;
+}
+
+/* Whether a timer is started (on a queue) */
+static inline int
+hal_timer_queued(const struct hal_timer *tmr)
+{
+    return tmr->prev != NULL;
+}
+
 /* Initialize a HW timer. */
 int hal_timer_init(int timer_num, void *cfg);
 
@@ -49,6 +49,24 @@ typedef void (*hal_uart_tx_done)(void *arg);
  */
 typedef int (*hal_uart_rx_char)(void *arg, uint8_t byte);
 
+/*
+ * Function prototype for UART driver to ask for a block of data to send.
+ * Sets *data to point to at most max bytes, and returns their count; 0 if
+ * no more data.  Data must stay in place until the next call, which also
+ * tells that the previous block has been sent.  Data must be in RAM.
+ * Driver must call this with interrupts disabled.
+ */
+typedef int (*hal_uart_tx_buf)(void *arg, uint8_t **data, int max);
+
+/*
+ * Function prototype for UART driver to report a block of incoming data.
+ * Returns the number of bytes taken.  If less than len, the driver keeps
+ * the rest and stops receiving; the rest is reported again after
+ * hal_uart_start_rx().
+ * Driver must call this with interrupts disabled.
+ */
+typedef int (*hal_uart_rx_buf)(void *arg, uint8_t *data, int len);
+
 /**
  * hal uart init cbs
  *
@@ -69,6 +87,26 @@ enum hal_uart_flow_ctl {
     HAL_UART_FLOW_CTL_RTS_CTS = 1	/* RTS/CTS */
 };
 
+/**
+ * hal uart init tx buf
+ *
+ * Sets function for asking data to send in blocks, to use instead of
+ * tx_char.  Must be called before hal_uart_config().
+ *
+ * @return 0 on success; -1 if UART does not support block transmit.
+ */
+int hal_uart_init_tx_buf(int uart, hal_uart_tx_buf tx_buf);
+
+/**
+ * hal uart init rx buf
+ *
+ * Sets function for reporting received data in blocks, to use instead of
+ * rx_char.  Must be called before hal_uart_config().
+ *
+ * @return 0 on success; -1 if UART does not support block receive.
+ */
+int hal_uart_init_rx_buf(int uart, hal_uart_rx_buf rx_buf);
+
 /**
  * Initialize the HAL uart.
  *
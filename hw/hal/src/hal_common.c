@@ -26,3 +26,18 @@ _exit(int status)
 {
     hal_system_reset();
 }
+
+/*
+ * Defaults for MCUs which cannot scale their clock.
+ */
+int __attribute__((weak))
+hal_system_clock_div_set(uint32_t div)
+{
+    return div == 1 ? 0 : -1;
+}
+
+uint32_t __attribute__((weak))
+hal_system_clock_div_get(void)
+{
+    return 1;
+}
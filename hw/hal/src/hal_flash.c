@@ -124,6 +124,32 @@ hal_flash_erase_sector(uint8_t id, uint32_t sector_address)
     return hf->hf_itf->hff_erase_sector(hf, sector_address);
 }
 
+int
+hal_flash_erase_sector_async(uint8_t id, uint32_t sector_address,
+  hal_flash_done_cb cb, void *arg)
+{
+    const struct hal_flash *hf;
+    int rc;
+
+    hf = hal_bsp_flash_dev(id);
+    if (!hf) {
+        return -1;
+    }
+    if (hal_flash_check_addr(hf, sector_address)) {
+        return -1;
+    }
+    if (hf->hf_itf->hff_erase_sector_async) {
+        return hf->hf_itf->hff_erase_sector_async(hf, sector_address, cb,
+          arg);
+    }
+    rc = hf->hf_itf->hff_erase_sector(hf, sector_address);
+    if (rc) {
+        return rc;
+    }
+    cb(arg, 0);
+    return 0;
+}
+
 int
 hal_flash_erase(uint8_t id, uint32_t address, uint32_t num_bytes)
 {
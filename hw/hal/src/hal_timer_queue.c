@@ -0,0 +1,155 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stddef.h>
+#include "hal/hal_timer.h"
+
+/*
+ * Pairing heap.  The first timer is the root, and its "prev" points to
+ * itself so that hal_timer_queued() holds for it too.  Every other timer
+ * hangs off its parent's "child" list, linked through "sibling"; "prev"
+ * points to the parent for the leftmost child, and to the left sibling
+ * otherwise.
+ */
+
+static int
+hal_timer_before(const struct hal_timer *a, const struct hal_timer *b)
+{
+    return (int32_t)(a->expiry - b->expiry) < 0;
+}
+
+/*
+ * Links two heaps, neither of which has siblings.  Returns the new root.
+ */
+static struct hal_timer *
+hal_timer_meld(struct hal_timer *a, struct hal_timer *b)
+{
+    struct hal_timer *t;
+
+    if (a == NULL) {
+        return b;
+    }
+    if (b == NULL) {
+        return a;
+    }
+    if (hal_timer_before(b, a)) {
+        t = a;
+        a = b;
+        b = t;
+    }
+
+    b->sibling = a->child;
+    if (b->sibling) {
+        b->sibling->prev = b;
+    }
+    b->prev = a;
+    a->child = b;
+
+    return a;
+}
+
+/*
+ * Combines a list of siblings into one heap: meld pairs left to right, then
+ * meld the results right to left.
+ */
+static struct hal_timer *
+hal_timer_merge_pairs(struct hal_timer *first)
+{
+    struct hal_timer *pairs;
+    struct hal_timer *a;
+    struct hal_timer *b;
+    struct hal_timer *next;
+
+    pairs = NULL;
+    while (first) {
+        a = first;
+        b = a->sibling;
+        next = b ? b->sibling : NULL;
+        a->sibling = NULL;
+        if (b) {
+            b->sibling = NULL;
+        }
+        a = hal_timer_meld(a, b);
+
+        /* Stack of melded pairs, reusing the sibling link */
+        a->sibling = pairs;
+        pairs = a;
+        first = next;
+    }
+
+    first = NULL;
+    while (pairs) {
+        next = pairs->sibling;
+        pairs->sibling = NULL;
+        first = hal_timer_meld(pairs, first);
+        pairs = next;
+    }
+
+    return first;
+}
+
+static void
+hal_timer_queue_set_first(struct hal_timer_queue *q, struct hal_timer *tmr)
+{
+    q->htq_first = tmr;
+    if (tmr) {
+        tmr->prev = tmr;
+        tmr->sibling = NULL;
+    }
+}
+
+/**
+ * Add a timer to a queue.  The timer must not be queued.
+ */
+void
+hal_timer_queue_insert(struct hal_timer_queue *q, struct hal_timer *tmr)
+{
+    tmr->child = NULL;
+    tmr->sibling = NULL;
+    tmr->prev = NULL;
+    hal_timer_queue_set_first(q, hal_timer_meld(q->htq_first, tmr));
+}
+
+/**
+ * Remove a timer from the queue it is on.  The timer must be queued.
+ */
+void
+hal_timer_queue_remove(struct hal_timer_queue *q, struct hal_timer *tmr)
+{
+    struct hal_timer *sub;
+
+    sub = hal_timer_merge_pairs(tmr->child);
+    if (tmr == q->htq_first) {
+        hal_timer_queue_set_first(q, sub);
+    } else {
+        if (tmr->prev->child == tmr) {
+            tmr->prev->child = tmr->sibling;
+        } else {
+            tmr->prev->sibling = tmr->sibling;
+        }
+        if (tmr->sibling) {
+            tmr->sibling->prev = tmr->prev;
+        }
+        hal_timer_queue_set_first(q, hal_timer_meld(q->htq_first, sub));
+    }
+
+    tmr->child = NULL;
+    tmr->sibling = NULL;
+    tmr->prev = NULL;
+}
@@ -115,6 +115,20 @@ hal_uart_init_cbs(int port, hal_uart_tx_char tx_func, hal_uart_tx_done tx_done,
     return 0;
 }
 
+int
+hal_uart_init_tx_buf(int port, hal_uart_tx_buf tx_buf)
+{
+    /* Block transmit not supported; tx_char is used. */
+    return -1;
+}
+
+int
+hal_uart_init_rx_buf(int port, hal_uart_rx_buf rx_buf)
+{
+    /* Block receive not supported; rx_char is used. */
+    return -1;
+}
+
 static void
 uart_irq_handler(int port)
 {
@@ -23,9 +23,18 @@
 #include <string.h>
 #include <inttypes.h>
 #include <stdlib.h>
+#include "syscfg/syscfg.h"
+#include "os/os.h"
 #include "hal/hal_flash_int.h"
 #include "mcu/mcu_sim.h"
 
+#if MYNEWT_VAL(MCU_NATIVE_VIRTUAL_TIME)
+/* Flash operations stall the virtual CPU like they would a real one. */
+#define NATIVE_FLASH_CHARGE(cycles) os_arch_sim_cycles_add(cycles)
+#else
+#define NATIVE_FLASH_CHARGE(cycles)
+#endif
+
 char *native_flash_file;
 static int file;
 static void *file_loc;
@@ -164,6 +173,7 @@ native_flash_write(const struct hal_flash *dev, uint32_t address,
         const void *src, uint32_t length)
 {
     assert(address % native_flash_dev.hf_align == 0);
+    NATIVE_FLASH_CHARGE(length * MYNEWT_VAL(MCU_NATIVE_VT_FLASH_WRITE_CYCLES));
     return flash_native_write_internal(address, src, length, 0);
 }
 
@@ -180,6 +190,7 @@ native_flash_read(const struct hal_flash *dev, uint32_t address, void *dst,
 {
     flash_native_ensure_file_open();
     memcpy(dst, (char *)file_loc + address, length);
+    NATIVE_FLASH_CHARGE(length * MYNEWT_VAL(MCU_NATIVE_VT_FLASH_READ_CYCLES));
 
     return 0;
 }
@@ -225,6 +236,7 @@ native_flash_erase_sector(const struct hal_flash *dev, uint32_t sector_address)
     }
     len = flash_sector_len(area_id);
     flash_native_erase(sector_address, len);
+    NATIVE_FLASH_CHARGE(MYNEWT_VAL(MCU_NATIVE_VT_FLASH_ERASE_CYCLES));
     return 0;
 }
 
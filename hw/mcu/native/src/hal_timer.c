@@ -37,7 +37,7 @@ struct native_timer {
     uint32_t cnt;
     uint32_t last_ostime;
     int num;
-    TAILQ_HEAD(hal_timer_qhead, hal_timer) timers;
+    struct hal_timer_queue timers;
 } native_timers[1];
 
 /**
@@ -55,16 +55,15 @@ native_timer_cb(struct os_event *ev)
 
     OS_ENTER_CRITICAL(sr);
     cnt = hal_timer_read(nt->num);
-    while ((ht = TAILQ_FIRST(&nt->timers)) != NULL) {
+    while ((ht = hal_timer_queue_first(&nt->timers)) != NULL) {
         if (((int32_t)(cnt - ht->expiry)) >= 0) {
-            TAILQ_REMOVE(&nt->timers, ht, link);
-            ht->link.tqe_prev = NULL;
+            hal_timer_queue_remove(&nt->timers, ht);
             ht->cb_func(ht->cb_arg);
         } else {
             break;
         }
     }
-    ht = TAILQ_FIRST(&nt->timers);
+    ht = hal_timer_queue_first(&nt->timers);
     if (ht) {
         os_callout_reset(&nt->callout,
           (ht->expiry - hal_timer_read(nt->num)) / nt->ticks_per_ostick);
@@ -235,7 +234,7 @@ hal_timer_set_cb(int num, struct hal_timer *timer, hal_timer_cb cb_func,
     timer->cb_func = cb_func;
     timer->cb_arg = arg;
     timer->bsp_timer = nt;
-    timer->link.tqe_prev = NULL;
+    timer->prev = NULL;
 
     return 0;
 }
@@ -276,7 +275,6 @@ int
 hal_timer_start_at(struct hal_timer *timer, uint32_t tick)
 {
     struct native_timer *nt;
-    struct hal_timer *ht;
     uint32_t curtime;
     uint32_t osticks;
     os_sr_t sr;
@@ -287,19 +285,7 @@ hal_timer_start_at(struct hal_timer *timer, uint32_t tick)
 
     OS_ENTER_CRITICAL(sr);
 
-    if (TAILQ_EMPTY(&nt->timers)) {
-        TAILQ_INSERT_HEAD(&nt->timers, timer, link);
-    } else {
-        TAILQ_FOREACH(ht, &nt->timers, link) {
-            if ((int32_t)(timer->expiry - ht->expiry) < 0) {
-                TAILQ_INSERT_BEFORE(ht, timer, link);
-                break;
-            }
-        }
-        if (!ht) {
-            TAILQ_INSERT_TAIL(&nt->timers, timer, link);
-        }
-    }
+    hal_timer_queue_insert(&nt->timers, timer);
 
     curtime = hal_timer_read(nt->num);
     if ((int32_t)(tick - curtime) <= 0) {
@@ -308,7 +294,7 @@ hal_timer_start_at(struct hal_timer *timer, uint32_t tick)
          */
         os_callout_reset(&nt->callout, 0);
     } else {
-        if (timer == TAILQ_FIRST(&nt->timers)) {
+        if (timer == hal_timer_queue_first(&nt->timers)) {
             osticks = (tick - curtime) / nt->ticks_per_ostick;
             os_callout_reset(&nt->callout, osticks);
         }
@@ -338,16 +324,15 @@ hal_timer_stop(struct hal_timer *timer)
     OS_ENTER_CRITICAL(sr);
 
     nt = (struct native_timer *)timer->bsp_timer;
-    if (timer->link.tqe_prev != NULL) {
+    if (hal_timer_queued(timer)) {
         reset_ocmp = 0;
-        if (timer == TAILQ_FIRST(&nt->timers)) {
+        if (timer == hal_timer_queue_first(&nt->timers)) {
             /* If first on queue, we will need to reset OCMP */
-            ht = TAILQ_NEXT(timer, link);
             reset_ocmp = 1;
         }
-        TAILQ_REMOVE(&nt->timers, timer, link);
-        timer->link.tqe_prev = NULL;
+        hal_timer_queue_remove(&nt->timers, timer);
         if (reset_ocmp) {
+            ht = hal_timer_queue_first(&nt->timers);
             if (ht) {
                 os_callout_reset(&nt->callout,
                   (ht->expiry - hal_timer_read(nt->num) /
@@ -389,6 +389,20 @@ hal_uart_init_cbs(int port, hal_uart_tx_char tx_func, hal_uart_tx_done tx_done,
     return 0;
 }
 
+int
+hal_uart_init_tx_buf(int port, hal_uart_tx_buf tx_buf)
+{
+    /* Block transmit not supported; tx_char is used. */
+    return -1;
+}
+
+int
+hal_uart_init_rx_buf(int port, hal_uart_rx_buf rx_buf)
+{
+    /* Block receive not supported; rx_char is used. */
+    return -1;
+}
+
 int
 hal_uart_config(int port, int32_t baudrate, uint8_t databits, uint8_t stopbits,
   enum hal_uart_parity parity, enum hal_uart_flow_ctl flow_ctl)
@@ -20,6 +20,8 @@
 #ifndef H_NRF51_HAL_
 #define H_NRF51_HAL_
 
+#include <stdint.h>
+
 #ifdef __cplusplus
  extern "C" {
 #endif
@@ -63,6 +65,23 @@ struct nrf51_hal_spi_cfg {
 struct hal_flash;
 extern const struct hal_flash nrf51_flash_dev;
 
+/*
+ * Programmable peripheral interconnect (PPI).  Connects a peripheral event
+ * to a task, so that timing critical chains run in hardware rather than in
+ * interrupt handlers.  Channels handed out by nrf51_ppi_alloc() are those in
+ * syscfg NRF51_PPI_CHANNELS; the others are left to code programming fixed
+ * channels, like the BLE PHY.
+ */
+int nrf51_ppi_alloc(void);
+void nrf51_ppi_free(int ch);
+void nrf51_ppi_connect(int ch, volatile uint32_t *event,
+                       volatile uint32_t *task);
+void nrf51_ppi_enable(int ch);
+void nrf51_ppi_disable(int ch);
+
+/* GPIOTE event of a pin set up with hal_gpio_irq_init(), NULL if none */
+volatile uint32_t *nrf51_gpio_irq_event(int pin);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,68 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "nrf.h"
+#include "mcu/nrf51_hal.h"
+#include "hal/hal_aes.h"
+
+/*
+ * The ECB peripheral is shared with the BLE controller, and on this part
+ * the AES core is also used by CCM and AAR, which take priority: an ECB
+ * operation they preempt ends with ERRORECB and is retried.  Interrupts are
+ * disabled during each attempt, so another user of ECB can't stop it
+ * halfway; an attempt takes about 17 us.
+ */
+int
+hal_aes128_encrypt(const uint8_t *key, const uint8_t *in, uint8_t *out)
+{
+    struct {
+        uint8_t key[16];
+        uint8_t clear[16];
+        uint8_t cipher[16];
+    } ecb;
+    uint32_t ctx;
+    int done;
+
+    memcpy(ecb.key, key, sizeof ecb.key);
+    memcpy(ecb.clear, in, sizeof ecb.clear);
+
+    do {
+        __HAL_DISABLE_INTERRUPTS(ctx);
+
+        NRF_ECB->TASKS_STOPECB = 1;
+        NRF_ECB->EVENTS_ENDECB = 0;
+        NRF_ECB->EVENTS_ERRORECB = 0;
+        NRF_ECB->ECBDATAPTR = (uint32_t)&ecb;
+        NRF_ECB->TASKS_STARTECB = 1;
+
+        while (!NRF_ECB->EVENTS_ENDECB && !NRF_ECB->EVENTS_ERRORECB) {
+        }
+        done = NRF_ECB->EVENTS_ENDECB;
+        NRF_ECB->EVENTS_ENDECB = 0;
+        NRF_ECB->EVENTS_ERRORECB = 0;
+
+        __HAL_ENABLE_INTERRUPTS(ctx);
+    } while (!done);
+
+    memcpy(out, ecb.cipher, sizeof ecb.cipher);
+
+    return 0;
+}
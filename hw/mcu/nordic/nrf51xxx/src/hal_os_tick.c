@@ -116,6 +116,7 @@ rtc1_timer_handler(void)
     uint32_t counter;
 
     OS_ENTER_CRITICAL(sr);
+    os_trace_isr_enter(OS_TICK_IRQ);
 
     /*
      * Calculate elapsed ticks and advance OS time.
@@ -134,6 +135,7 @@ rtc1_timer_handler(void)
     /* Update the output compare to interrupt at the next tick */
     nrf51_os_tick_set_ocmp(lastocmp + timer_ticks_per_ostick);
 
+    os_trace_isr_exit();
     OS_EXIT_CRITICAL(sr);
 }
 
@@ -70,7 +70,7 @@ struct nrf51_hal_timer {
     uint32_t timer_isrs;
     uint32_t tmr_freq;
     void *tmr_reg;
-    TAILQ_HEAD(hal_timer_qhead, hal_timer) hal_timer_q;
+    struct hal_timer_queue hal_timer_q;
 };
 
 #if MYNEWT_VAL(TIMER_0)
@@ -317,7 +317,7 @@ hal_timer_chk_queue(struct nrf51_hal_timer *bsptimer)
 
     /* disable interrupts */
     __HAL_DISABLE_INTERRUPTS(ctx);
-    while ((timer = TAILQ_FIRST(&bsptimer->hal_timer_q)) != NULL) {
+    while ((timer = hal_timer_queue_first(&bsptimer->hal_timer_q)) != NULL) {
         if (bsptimer->tmr_16bit) {
             tcntr = hal_timer_read_bsptimer(bsptimer);
             delta = 0;
@@ -329,8 +329,7 @@ hal_timer_chk_queue(struct nrf51_hal_timer *bsptimer)
             delta = 0;
         }
         if ((int32_t)(tcntr - timer->expiry) >= delta) {
-            TAILQ_REMOVE(&bsptimer->hal_timer_q, timer, link);
-            timer->link.tqe_prev = NULL;
+            hal_timer_queue_remove(&bsptimer->hal_timer_q, timer);
             timer->cb_func(timer->cb_arg);
         } else {
             break;
@@ -338,7 +337,7 @@ hal_timer_chk_queue(struct nrf51_hal_timer *bsptimer)
     }
 
     /* Any timers left on queue? If so, we need to set OCMP */
-    timer = TAILQ_FIRST(&bsptimer->hal_timer_q);
+    timer = hal_timer_queue_first(&bsptimer->hal_timer_q);
     if (timer) {
         nrf_timer_set_ocmp(bsptimer, timer->expiry);
     } else {
@@ -839,7 +838,7 @@ hal_timer_set_cb(int timer_num, struct hal_timer *timer, hal_timer_cb cb_func,
 
     timer->cb_func = cb_func;
     timer->cb_arg = arg;
-    timer->link.tqe_prev = NULL;
+    timer->prev = NULL;
     timer->bsp_timer = bsptimer;
 
     rc = 0;
@@ -866,10 +865,9 @@ int
 hal_timer_start_at(struct hal_timer *timer, uint32_t tick)
 {
     uint32_t ctx;
-    struct hal_timer *entry;
     struct nrf51_hal_timer *bsptimer;
 
-    if ((timer == NULL) || (timer->link.tqe_prev != NULL) ||
+    if ((timer == NULL) || hal_timer_queued(timer) ||
         (timer->cb_func == NULL)) {
         return EINVAL;
     }
@@ -878,22 +876,10 @@ hal_timer_start_at(struct hal_timer *timer, uint32_t tick)
 
     __HAL_DISABLE_INTERRUPTS(ctx);
 
-    if (TAILQ_EMPTY(&bsptimer->hal_timer_q)) {
-        TAILQ_INSERT_HEAD(&bsptimer->hal_timer_q, timer, link);
-    } else {
-        TAILQ_FOREACH(entry, &bsptimer->hal_timer_q, link) {
-            if ((int32_t)(timer->expiry - entry->expiry) < 0) {
-                TAILQ_INSERT_BEFORE(entry, timer, link);
-                break;
-            }
-        }
-        if (!entry) {
-            TAILQ_INSERT_TAIL(&bsptimer->hal_timer_q, timer, link);
-        }
-    }
+    hal_timer_queue_insert(&bsptimer->hal_timer_q, timer);
 
     /* If this is the head, we need to set new OCMP */
-    if (timer == TAILQ_FIRST(&bsptimer->hal_timer_q)) {
+    if (timer == hal_timer_queue_first(&bsptimer->hal_timer_q)) {
         nrf_timer_set_ocmp(bsptimer, timer->expiry);
     }
 
@@ -927,16 +913,15 @@ hal_timer_stop(struct hal_timer *timer)
 
     __HAL_DISABLE_INTERRUPTS(ctx);
 
-    if (timer->link.tqe_prev != NULL) {
+    if (hal_timer_queued(timer)) {
         reset_ocmp = 0;
-        if (timer == TAILQ_FIRST(&bsptimer->hal_timer_q)) {
+        if (timer == hal_timer_queue_first(&bsptimer->hal_timer_q)) {
             /* If first on queue, we will need to reset OCMP */
-            entry = TAILQ_NEXT(timer, link);
             reset_ocmp = 1;
         }
-        TAILQ_REMOVE(&bsptimer->hal_timer_q, timer, link);
-        timer->link.tqe_prev = NULL;
+        hal_timer_queue_remove(&bsptimer->hal_timer_q, timer);
         if (reset_ocmp) {
+            entry = hal_timer_queue_first(&bsptimer->hal_timer_q);
             if (entry) {
                 nrf_timer_set_ocmp((struct nrf51_hal_timer *)entry->bsp_timer,
                                    entry->expiry);
@@ -0,0 +1,98 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdint.h>
+#include <assert.h>
+#include "syscfg/syscfg.h"
+#include "nrf51.h"
+#include "mcu/nrf51_hal.h"
+
+/* Programmable channels; the ones above are pre-programmed */
+#define NRF51_PPI_NUM_CH        16
+
+static uint32_t nrf51_ppi_used;
+
+/**
+ * Allocate a PPI channel.  The channel is disabled, with no event or
+ * task connected.
+ *
+ * @return The channel number, -1 if none are free.
+ */
+int
+nrf51_ppi_alloc(void)
+{
+    uint32_t ctx;
+    uint32_t avail;
+    int ch;
+
+    __HAL_DISABLE_INTERRUPTS(ctx);
+    avail = MYNEWT_VAL(NRF51_PPI_CHANNELS) & ~nrf51_ppi_used &
+      ((1UL << NRF51_PPI_NUM_CH) - 1);
+    if (avail) {
+        ch = __builtin_ctz(avail);
+        nrf51_ppi_used |= 1UL << ch;
+    } else {
+        ch = -1;
+    }
+    __HAL_ENABLE_INTERRUPTS(ctx);
+
+    if (ch >= 0) {
+        nrf51_ppi_connect(ch, NULL, NULL);
+    }
+    return ch;
+}
+
+/**
+ * Disable and release a channel returned by nrf51_ppi_alloc().
+ */
+void
+nrf51_ppi_free(int ch)
+{
+    uint32_t ctx;
+
+    assert(nrf51_ppi_used & (1UL << ch));
+    nrf51_ppi_disable(ch);
+
+    __HAL_DISABLE_INTERRUPTS(ctx);
+    nrf51_ppi_used &= ~(1UL << ch);
+    __HAL_ENABLE_INTERRUPTS(ctx);
+}
+
+/**
+ * Connect an event register to a task register.  Reconfigure a channel
+ * only while it is disabled.
+ */
+void
+nrf51_ppi_connect(int ch, volatile uint32_t *event, volatile uint32_t *task)
+{
+    NRF_PPI->CH[ch].EEP = (uint32_t)event;
+    NRF_PPI->CH[ch].TEP = (uint32_t)task;
+}
+
+void
+nrf51_ppi_enable(int ch)
+{
+    NRF_PPI->CHENSET = 1UL << ch;
+}
+
+void
+nrf51_ppi_disable(int ch)
+{
+    NRF_PPI->CHENCLR = 1UL << ch;
+}
@@ -20,6 +20,8 @@
 #ifndef H_NRF52_HAL_
 #define H_NRF52_HAL_
 
+#include <stdint.h>
+
 #ifdef __cplusplus
  extern "C" {
 #endif
@@ -62,6 +64,32 @@ struct nrf52_hal_spi_cfg {
     uint8_t ss_pin;
 };
 
+/*
+ * Programmable peripheral interconnect (PPI).  Connects a peripheral event
+ * to one or two tasks, so that timing critical chains run in hardware
+ * rather than in interrupt handlers.  Channels handed out by
+ * nrf52_ppi_alloc() are those in syscfg NRF52_PPI_CHANNELS; the others are
+ * left to code programming fixed channels, like the BLE PHY.
+ */
+int nrf52_ppi_alloc(void);
+void nrf52_ppi_free(int ch);
+void nrf52_ppi_connect(int ch, volatile uint32_t *event,
+                       volatile uint32_t *task);
+void nrf52_ppi_fork(int ch, volatile uint32_t *task);
+void nrf52_ppi_enable(int ch);
+void nrf52_ppi_disable(int ch);
+
+/* GPIOTE event of a pin set up with hal_gpio_irq_init(), NULL if none */
+volatile uint32_t *nrf52_gpio_irq_event(int pin);
+
+/*
+ * Capture task and capture register 'cc' (0 or 1) of a HAL timer, for
+ * timestamping events in hardware.  Captured values are in the timer's
+ * ticks, as read by hal_timer_read().  Not available on RTC timers.
+ */
+int nrf52_hal_timer_capture(int timer_num, int cc, volatile uint32_t **task,
+                            volatile uint32_t **val);
+
 #ifdef __cplusplus
 }
 #endif
@@ -21,6 +21,7 @@
 #include "bsp/cmsis_nvic.h"
 #include <stdlib.h>
 #include "nrf.h"
+#include "mcu/nrf52_hal.h"
 #include <assert.h>
 
 /* XXX:
@@ -340,6 +341,26 @@ hal_gpio_irq_release(int pin)
     hal_gpio_irqs[i].func = NULL;
 }
 
+/**
+ * Event register of the GPIOTE channel handling a pin's irq, for connecting
+ * it to tasks through PPI.
+ *
+ * @param pin
+ *
+ * @return The event register, NULL if the pin has no irq set up.
+ */
+volatile uint32_t *
+nrf52_gpio_irq_event(int pin)
+{
+    int i;
+
+    i = hal_gpio_find_pin(pin);
+    if (i < 0) {
+        return NULL;
+    }
+    return &NRF_GPIOTE->EVENTS_IN[i];
+}
+
 /**
  * gpio irq enable
  *
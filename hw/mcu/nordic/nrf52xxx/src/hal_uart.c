@@ -17,6 +17,7 @@
  * under the License.
  */
 
+#include "syscfg/syscfg.h"
 #include "hal/hal_uart.h"
 #include "bsp/cmsis_nvic.h"
 #include "bsp/bsp.h"
@@ -25,6 +26,7 @@
 #include "mcu/nrf52_hal.h"
 
 #include <assert.h>
+#include <stddef.h>
 
 #define UARTE_INT_ENDTX		UARTE_INTEN_ENDTX_Msk
 #define UARTE_INT_ENDRX		UARTE_INTEN_ENDRX_Msk
@@ -33,6 +35,35 @@
 #define UARTE_ENABLE		UARTE_ENABLE_ENABLE_Enabled
 #define UARTE_DISABLE           UARTE_ENABLE_ENABLE_Disabled
 
+#define UARTE_RX_BUF_SIZE       MYNEWT_VAL(NRF52_UART_RX_BUF_SIZE)
+
+#if UARTE_RX_BUF_SIZE
+#if UARTE_RX_BUF_SIZE > UARTE_RXD_MAXCNT_MAXCNT_Msk
+#error "NRF52_UART_RX_BUF_SIZE is larger than UARTE RXD.MAXCNT allows"
+#endif
+
+/*
+ * Idle line detection: every received byte restarts a timer through PPI,
+ * and when it expires the timer stops the receiver through PPI.  Stopping
+ * ends the current buffer early, so data sitting in a partly filled buffer
+ * gets reported.
+ */
+#if MYNEWT_VAL(NRF52_UART_RX_IDLE_TIMER) == 0
+#define UARTE_IDLE_TIMER        NRF_TIMER0
+#elif MYNEWT_VAL(NRF52_UART_RX_IDLE_TIMER) == 1
+#define UARTE_IDLE_TIMER        NRF_TIMER1
+#elif MYNEWT_VAL(NRF52_UART_RX_IDLE_TIMER) == 2
+#define UARTE_IDLE_TIMER        NRF_TIMER2
+#elif MYNEWT_VAL(NRF52_UART_RX_IDLE_TIMER) == 3
+#define UARTE_IDLE_TIMER        NRF_TIMER3
+#elif MYNEWT_VAL(NRF52_UART_RX_IDLE_TIMER) == 4
+#define UARTE_IDLE_TIMER        NRF_TIMER4
+#endif
+
+/* EVENTS_RXDRDY; missing from this SDK's UARTE register definition. */
+#define UARTE_EVENTS_RXDRDY     ((uint32_t)NRF_UARTE0 + 0x108)
+#endif
+
 /*
  * Only one UART on NRF 52832.
  */
@@ -45,7 +76,26 @@ struct hal_uart {
     hal_uart_rx_char u_rx_func;
     hal_uart_tx_char u_tx_func;
     hal_uart_tx_done u_tx_done;
+    hal_uart_tx_buf u_tx_buf_func;
     void *u_func_arg;
+#if UARTE_RX_BUF_SIZE
+    /*
+     * Block receive.  EasyDMA fills the two buffers in turn; the ENDRX_STARTRX
+     * shortcut moves it on to the next one without losing bytes.  Data not
+     * taken by the upper layer is kept in u_rx_pend until hal_uart_start_rx().
+     */
+    hal_uart_rx_buf u_rx_buf_func;
+    uint8_t u_rx_stopped:1;
+#ifdef UARTE_IDLE_TIMER
+    uint8_t u_rx_idle:1;        /* u_rx_idle_ppi allocated */
+    int8_t u_rx_idle_ppi[2];
+#endif
+    uint8_t u_rx_fill;
+    uint8_t u_rx_npend;
+    uint8_t u_rx_pend_len[2];
+    uint8_t *u_rx_pend[2];
+    uint8_t u_rx_bufs[2][UARTE_RX_BUF_SIZE];
+#endif
 };
 static struct hal_uart uart;
 
@@ -65,16 +115,194 @@ hal_uart_init_cbs(int port, hal_uart_tx_char tx_func, hal_uart_tx_done tx_done,
     u->u_rx_func = rx_func;
     u->u_tx_func = tx_func;
     u->u_tx_done = tx_done;
+    u->u_tx_buf_func = NULL;
+#if UARTE_RX_BUF_SIZE
+    u->u_rx_buf_func = NULL;
+#endif
     u->u_func_arg = arg;
     return 0;
 }
 
+int
+hal_uart_init_tx_buf(int port, hal_uart_tx_buf tx_buf)
+{
+    struct hal_uart *u;
+
+    if (port != 0) {
+        return -1;
+    }
+    u = &uart;
+    if (u->u_open) {
+        return -1;
+    }
+    u->u_tx_buf_func = tx_buf;
+    return 0;
+}
+
+int
+hal_uart_init_rx_buf(int port, hal_uart_rx_buf rx_buf)
+{
+#if UARTE_RX_BUF_SIZE
+    struct hal_uart *u;
+
+    if (port != 0) {
+        return -1;
+    }
+    u = &uart;
+    if (u->u_open) {
+        return -1;
+    }
+    u->u_rx_buf_func = rx_buf;
+    return 0;
+#else
+    /* Block receive not configured; rx_char is used. */
+    return -1;
+#endif
+}
+
+#if UARTE_RX_BUF_SIZE
+/*
+ * Hands received blocks to the upper layer.  Returns -1 if it stopped
+ * taking data.
+ */
 static int
-hal_uart_tx_fill_buf(struct hal_uart *u)
+hal_uart_rx_deliver(struct hal_uart *u)
+{
+    int len;
+    int rc;
+
+    while (u->u_rx_npend) {
+        len = u->u_rx_pend_len[0];
+        rc = u->u_rx_buf_func(u->u_func_arg, u->u_rx_pend[0], len);
+        if (rc < len) {
+            if (rc > 0) {
+                u->u_rx_pend[0] += rc;
+                u->u_rx_pend_len[0] -= rc;
+            }
+            return -1;
+        }
+        u->u_rx_pend[0] = u->u_rx_pend[1];
+        u->u_rx_pend_len[0] = u->u_rx_pend_len[1];
+        u->u_rx_npend--;
+    }
+    return 0;
+}
+
+static void
+hal_uart_rx_dma_start(struct hal_uart *u)
+{
+    u->u_rx_stopped = 0;
+    NRF_UARTE0->INTENCLR = UARTE_INTEN_RXTO_Msk;
+    NRF_UARTE0->RXD.PTR = (uint32_t)u->u_rx_bufs[u->u_rx_fill];
+    NRF_UARTE0->RXD.MAXCNT = UARTE_RX_BUF_SIZE;
+    NRF_UARTE0->SHORTS |= UARTE_SHORTS_ENDRX_STARTRX_Msk;
+    NRF_UARTE0->TASKS_STARTRX = 1;
+}
+
+/*
+ * Upper layer can't take more.  Let EasyDMA finish with the buffer it is
+ * filling, and then stay stopped; RTS holds off the sender if flow control
+ * is on.
+ */
+static void
+hal_uart_rx_dma_stall(struct hal_uart *u)
+{
+    u->u_rx_stall = 1;
+    NRF_UARTE0->SHORTS &= ~UARTE_SHORTS_ENDRX_STARTRX_Msk;
+    NRF_UARTE0->EVENTS_RXTO = 0;
+    NRF_UARTE0->INTENSET = UARTE_INTEN_RXTO_Msk;
+    NRF_UARTE0->TASKS_STOPRX = 1;
+}
+
+static void
+hal_uart_rx_dma_init(struct hal_uart *u)
+{
+    u->u_rx_fill = 0;
+    u->u_rx_npend = 0;
+
+#ifdef UARTE_IDLE_TIMER
+    UARTE_IDLE_TIMER->TASKS_STOP = 1;
+    UARTE_IDLE_TIMER->TASKS_CLEAR = 1;
+    UARTE_IDLE_TIMER->MODE = TIMER_MODE_MODE_Timer;
+    UARTE_IDLE_TIMER->BITMODE = TIMER_BITMODE_BITMODE_32Bit;
+    UARTE_IDLE_TIMER->PRESCALER = 4;    /* 1MHz */
+    UARTE_IDLE_TIMER->CC[0] = MYNEWT_VAL(NRF52_UART_RX_IDLE_US);
+    UARTE_IDLE_TIMER->SHORTS = TIMER_SHORTS_COMPARE0_STOP_Msk |
+                               TIMER_SHORTS_COMPARE0_CLEAR_Msk;
+
+    if (!u->u_rx_idle) {
+        u->u_rx_idle_ppi[0] = nrf52_ppi_alloc();
+        u->u_rx_idle_ppi[1] = nrf52_ppi_alloc();
+        assert(u->u_rx_idle_ppi[0] >= 0 && u->u_rx_idle_ppi[1] >= 0);
+        u->u_rx_idle = 1;
+    }
+    nrf52_ppi_connect(u->u_rx_idle_ppi[0],
+                      (volatile uint32_t *)UARTE_EVENTS_RXDRDY,
+                      &UARTE_IDLE_TIMER->TASKS_CLEAR);
+    nrf52_ppi_fork(u->u_rx_idle_ppi[0], &UARTE_IDLE_TIMER->TASKS_START);
+    nrf52_ppi_connect(u->u_rx_idle_ppi[1],
+                      &UARTE_IDLE_TIMER->EVENTS_COMPARE[0],
+                      &NRF_UARTE0->TASKS_STOPRX);
+    nrf52_ppi_enable(u->u_rx_idle_ppi[0]);
+    nrf52_ppi_enable(u->u_rx_idle_ppi[1]);
+#endif
+
+    NRF_UARTE0->EVENTS_RXSTARTED = 0;
+    NRF_UARTE0->INTENSET = UARTE_INT_ENDRX | UARTE_INTEN_RXSTARTED_Msk;
+    hal_uart_rx_dma_start(u);
+}
+
+static void
+hal_uart_rx_dma_irq(struct hal_uart *u)
+{
+    int amount;
+
+    if (NRF_UARTE0->EVENTS_ENDRX) {
+        NRF_UARTE0->EVENTS_ENDRX = 0;
+        amount = NRF_UARTE0->RXD.AMOUNT;
+        if (amount) {
+            u->u_rx_pend[u->u_rx_npend] = u->u_rx_bufs[u->u_rx_fill];
+            u->u_rx_pend_len[u->u_rx_npend] = amount;
+            u->u_rx_npend++;
+        }
+        u->u_rx_fill ^= 1;
+        if (!u->u_rx_stall && hal_uart_rx_deliver(u)) {
+            hal_uart_rx_dma_stall(u);
+        }
+    }
+    if (NRF_UARTE0->EVENTS_RXSTARTED) {
+        /* RXD.PTR is double buffered; queue up the next buffer. */
+        NRF_UARTE0->EVENTS_RXSTARTED = 0;
+        NRF_UARTE0->RXD.PTR = (uint32_t)u->u_rx_bufs[u->u_rx_fill ^ 1];
+    }
+    if ((NRF_UARTE0->INTEN & UARTE_INTEN_RXTO_Msk) &&
+        NRF_UARTE0->EVENTS_RXTO) {
+        NRF_UARTE0->EVENTS_RXTO = 0;
+        u->u_rx_stopped = 1;
+        if (!u->u_rx_stall) {
+            /* Upper layer caught up before receiver stopped. */
+            hal_uart_rx_dma_start(u);
+        }
+    }
+}
+#endif
+
+/*
+ * Gets next data to send.  With block transmit, EasyDMA reads directly from
+ * the caller's buffer; otherwise data is collected to u_tx_buf byte at a
+ * time.
+ */
+static int
+hal_uart_tx_fill_buf(struct hal_uart *u, uint8_t **ptr)
 {
     int data;
     int i;
 
+    if (u->u_tx_buf_func) {
+        return u->u_tx_buf_func(u->u_func_arg, ptr,
+                                UARTE_TXD_MAXCNT_MAXCNT_Msk);
+    }
+    *ptr = u->u_tx_buf;
     for (i = 0; i < sizeof(u->u_tx_buf); i++) {
         data = u->u_tx_func(u->u_func_arg);
         if (data < 0) {
@@ -89,6 +317,7 @@ void
 hal_uart_start_tx(int port)
 {
     struct hal_uart *u;
+    uint8_t *ptr;
     int sr;
     int rc;
 
@@ -98,10 +327,10 @@ hal_uart_start_tx(int port)
     u = &uart;
     __HAL_DISABLE_INTERRUPTS(sr);
     if (u->u_tx_started == 0) {
-        rc = hal_uart_tx_fill_buf(u);
+        rc = hal_uart_tx_fill_buf(u, &ptr);
         if (rc > 0) {
             NRF_UARTE0->INTENSET = UARTE_INT_ENDTX;
-            NRF_UARTE0->TXD.PTR = (uint32_t)&u->u_tx_buf;
+            NRF_UARTE0->TXD.PTR = (uint32_t)ptr;
             NRF_UARTE0->TXD.MAXCNT = rc;
             NRF_UARTE0->TASKS_STARTTX = 1;
             u->u_tx_started = 1;
@@ -121,6 +350,19 @@ hal_uart_start_rx(int port)
         return;
     }
     u = &uart;
+#if UARTE_RX_BUF_SIZE
+    if (u->u_rx_buf_func) {
+        __HAL_DISABLE_INTERRUPTS(sr);
+        if (u->u_rx_stall && hal_uart_rx_deliver(u) == 0) {
+            u->u_rx_stall = 0;
+            if (u->u_rx_stopped) {
+                hal_uart_rx_dma_start(u);
+            }
+        }
+        __HAL_ENABLE_INTERRUPTS(sr);
+        return;
+    }
+#endif
     if (u->u_rx_stall) {
         __HAL_DISABLE_INTERRUPTS(sr);
         rc = u->u_rx_func(u->u_func_arg, u->u_rx_buf);
@@ -171,14 +413,15 @@ static void
 uart_irq_handler(void)
 {
     struct hal_uart *u;
+    uint8_t *ptr;
     int rc;
 
     u = &uart;
     if (NRF_UARTE0->EVENTS_ENDTX) {
         NRF_UARTE0->EVENTS_ENDTX = 0;
-        rc = hal_uart_tx_fill_buf(u);
+        rc = hal_uart_tx_fill_buf(u, &ptr);
         if (rc > 0) {
-            NRF_UARTE0->TXD.PTR = (uint32_t)&u->u_tx_buf;
+            NRF_UARTE0->TXD.PTR = (uint32_t)ptr;
             NRF_UARTE0->TXD.MAXCNT = rc;
             NRF_UARTE0->TASKS_STARTTX = 1;
         } else {
@@ -190,6 +433,12 @@ uart_irq_handler(void)
             u->u_tx_started = 0;
         }
     }
+#if UARTE_RX_BUF_SIZE
+    if (u->u_rx_buf_func) {
+        hal_uart_rx_dma_irq(u);
+        return;
+    }
+#endif
     if (NRF_UARTE0->EVENTS_ENDRX) {
         NRF_UARTE0->EVENTS_ENDRX = 0;
         rc = u->u_rx_func(u->u_func_arg, u->u_rx_buf);
@@ -319,12 +568,20 @@ hal_uart_config(int port, int32_t baudrate, uint8_t databits, uint8_t stopbits,
 
     NRF_UARTE0->ENABLE = UARTE_ENABLE;
 
-    NRF_UARTE0->INTENSET = UARTE_INT_ENDRX;
-    NRF_UARTE0->RXD.PTR = (uint32_t)&u->u_rx_buf;
-    NRF_UARTE0->RXD.MAXCNT = sizeof(u->u_rx_buf);
-    NRF_UARTE0->TASKS_STARTRX = 1;
-
     u->u_rx_stall = 0;
+#if UARTE_RX_BUF_SIZE
+    if (u->u_rx_buf_func) {
+        hal_uart_rx_dma_init(u);
+    } else
+#endif
+    {
+        NRF_UARTE0->SHORTS = 0;
+        NRF_UARTE0->INTENSET = UARTE_INT_ENDRX;
+        NRF_UARTE0->RXD.PTR = (uint32_t)&u->u_rx_buf;
+        NRF_UARTE0->RXD.MAXCNT = sizeof(u->u_rx_buf);
+        NRF_UARTE0->TASKS_STARTRX = 1;
+    }
+
     u->u_tx_started = 0;
     u->u_open = 1;
 
@@ -342,6 +599,17 @@ hal_uart_close(int port)
         u->u_open = 0;
         NRF_UARTE0->ENABLE = 0;
         NRF_UARTE0->INTENCLR = 0xffffffff;
+        NRF_UARTE0->SHORTS = 0;
+#if UARTE_RX_BUF_SIZE
+#ifdef UARTE_IDLE_TIMER
+        if (u->u_rx_idle) {
+            nrf52_ppi_free(u->u_rx_idle_ppi[0]);
+            nrf52_ppi_free(u->u_rx_idle_ppi[1]);
+            u->u_rx_idle = 0;
+        }
+        UARTE_IDLE_TIMER->TASKS_STOP = 1;
+#endif
+#endif
         return 0;
     }
     return -1;
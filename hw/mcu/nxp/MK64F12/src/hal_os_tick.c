@@ -31,11 +31,13 @@ static void nxp_pit0_timer_handler(void)
     uint32_t sr;
 
     OS_ENTER_CRITICAL(sr);
+    os_trace_isr_enter(PIT0_IRQn);
 
     /* Clear interrupt flag.*/
     PIT_ClearStatusFlags(PIT, kPIT_Chnl_0, PIT_TFLG_TIF_MASK);
     os_time_advance(1);
 
+    os_trace_isr_exit();
     OS_EXIT_CRITICAL(sr);
 }
 
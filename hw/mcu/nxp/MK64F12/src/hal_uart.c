@@ -154,6 +154,20 @@ int hal_uart_init_cbs(int port, hal_uart_tx_char tx_func,
     return 0;
 }
 
+int
+hal_uart_init_tx_buf(int port, hal_uart_tx_buf tx_buf)
+{
+    /* Block transmit not supported; tx_char is used. */
+    return -1;
+}
+
+int
+hal_uart_init_rx_buf(int port, hal_uart_rx_buf rx_buf)
+{
+    /* Block receive not supported; rx_char is used. */
+    return -1;
+}
+
 void hal_uart_blocking_tx(int port, uint8_t byte)
 {
     struct hal_uart *u;
@@ -43,6 +43,7 @@ mkw41z_os_tick_handler(void)
     uint32_t sr;
 
     OS_ENTER_CRITICAL(sr);
+    os_trace_isr_enter(LPTMR0_IRQn);
 
     /* Must make sure flag is set when we get interrupt */
     csr = LPTMR0->CSR;
@@ -54,6 +55,7 @@ mkw41z_os_tick_handler(void)
         LPTMR0->CSR = csr;
     }
 
+    os_trace_isr_exit();
     OS_EXIT_CRITICAL(sr);
 }
 
@@ -67,6 +67,16 @@ struct stm32f4_hal_spi_cfg {
     int irq_prio;
 };
 
+/*
+ * Retiming for hal_system_clock_div_set(). The *_changed() functions are
+ * called with interrupts disabled, once SystemCoreClock has been updated.
+ */
+int stm32f4_hal_timer_clock_ok(uint32_t old_hclk, uint32_t new_hclk);
+void stm32f4_hal_timer_clock_changed(void);
+void stm32f4_os_tick_clock_changed(uint32_t old_hclk);
+void stm32f4_uart_tx_drain(void);
+void stm32f4_uart_clock_changed(void);
+
 #ifdef __cplusplus
 }
 #endif
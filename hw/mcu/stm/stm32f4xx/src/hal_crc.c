@@ -0,0 +1,60 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "hal/hal_crc.h"
+#include "stm32f4xx_hal.h"
+
+/*
+ * The CRC unit computes the MSB-first CRC-32 of 32-bit words, and always
+ * starts from 0xffffffff.  Bit reversing input words and the result gives
+ * the reflected CRC of the same bytes read as little-endian words.
+ */
+int
+hal_crc32(const void *buf, int len, uint32_t *crc)
+{
+    const uint8_t *ptr;
+    uint32_t primask;
+    uint32_t word;
+    int cnt;
+
+    cnt = len & ~3;
+    if (cnt == 0) {
+        return 0;
+    }
+    ptr = buf;
+
+    __HAL_RCC_CRC_CLK_ENABLE();
+
+    /* The unit holds the running value; keep other users out. */
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    CRC->CR = CRC_CR_RESET;
+    for (len = 0; len < cnt; len += 4) {
+        word = ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) |
+          ((uint32_t)ptr[3] << 24);
+        CRC->DR = __RBIT(word);
+        ptr += 4;
+    }
+    *crc = __RBIT(CRC->DR);
+
+    __set_PRIMASK(primask);
+
+    return cnt;
+}
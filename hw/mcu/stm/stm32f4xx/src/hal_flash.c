@@ -22,6 +22,8 @@
 #include "stm32f4xx_hal_flash.h"
 #include "stm32f4xx_hal_flash_ex.h"
 #include "hal/hal_flash_int.h"
+#include "bsp/cmsis_nvic.h"
+#include "stm32f4xx.h"
 
 static int stm32f4_flash_read(const struct hal_flash *dev, uint32_t address,
         void *dst, uint32_t num_bytes);
@@ -32,13 +34,16 @@ static int stm32f4_flash_erase_sector(const struct hal_flash *dev,
 static int stm32f4_flash_sector_info(const struct hal_flash *dev, int idx,
         uint32_t *address, uint32_t *sz);
 static int stm32f4_flash_init(const struct hal_flash *dev);
+static int stm32f4_flash_erase_sector_async(const struct hal_flash *dev,
+        uint32_t sector_address, hal_flash_done_cb cb, void *arg);
 
 static const struct hal_flash_funcs stm32f4_flash_funcs = {
     .hff_read = stm32f4_flash_read,
     .hff_write = stm32f4_flash_write,
     .hff_erase_sector = stm32f4_flash_erase_sector,
     .hff_sector_info = stm32f4_flash_sector_info,
-    .hff_init = stm32f4_flash_init
+    .hff_init = stm32f4_flash_init,
+    .hff_erase_sector_async = stm32f4_flash_erase_sector_async
 };
 
 static const uint32_t stm32f4_flash_sectors[] = {
@@ -133,6 +138,74 @@ stm32f4_flash_erase_sector(const struct hal_flash *dev, uint32_t sector_address)
     return -1;
 }
 
+/*
+ * Completion of the erase started by stm32f4_flash_erase_sector_async().
+ */
+static hal_flash_done_cb stm32f4_flash_cb;
+static void *stm32f4_flash_cb_arg;
+
+static void
+stm32f4_flash_done(int rc)
+{
+    hal_flash_done_cb cb;
+
+    /* HAL reports errors followed by end of operation; only tell once. */
+    cb = stm32f4_flash_cb;
+    stm32f4_flash_cb = NULL;
+    if (cb) {
+        cb(stm32f4_flash_cb_arg, rc);
+    }
+}
+
+void
+HAL_FLASH_EndOfOperationCallback(uint32_t ReturnValue)
+{
+    stm32f4_flash_done(0);
+}
+
+void
+HAL_FLASH_OperationErrorCallback(uint32_t ReturnValue)
+{
+    stm32f4_flash_done(-1);
+}
+
+static void
+stm32f4_flash_irq(void)
+{
+    HAL_FLASH_IRQHandler();
+}
+
+static int
+stm32f4_flash_erase_sector_async(const struct hal_flash *dev,
+        uint32_t sector_address, hal_flash_done_cb cb, void *arg)
+{
+    FLASH_EraseInitTypeDef eraseinit;
+    int i;
+
+    for (i = 0; i < STM32F4_FLASH_NUM_AREAS - 1; i++) {
+        if (stm32f4_flash_sectors[i] == sector_address) {
+            break;
+        }
+    }
+    if (i == STM32F4_FLASH_NUM_AREAS - 1 || stm32f4_flash_cb) {
+        return -1;
+    }
+
+    eraseinit.TypeErase = FLASH_TYPEERASE_SECTORS;
+    eraseinit.Banks = 0;
+    eraseinit.Sector = i;
+    eraseinit.NbSectors = 1;
+    eraseinit.VoltageRange = FLASH_VOLTAGE_RANGE_1;
+
+    stm32f4_flash_cb = cb;
+    stm32f4_flash_cb_arg = arg;
+    if (HAL_FLASHEx_Erase_IT(&eraseinit) != HAL_OK) {
+        stm32f4_flash_cb = NULL;
+        return -1;
+    }
+    return 0;
+}
+
 static int
 stm32f4_flash_sector_info(const struct hal_flash *dev, int idx,
         uint32_t *address, uint32_t *sz)
@@ -146,5 +219,7 @@ static int
 stm32f4_flash_init(const struct hal_flash *dev)
 {
     HAL_FLASH_Unlock();
+    NVIC_SetVector(FLASH_IRQn, (uint32_t)stm32f4_flash_irq);
+    NVIC_EnableIRQ(FLASH_IRQn);
     return 0;
 }
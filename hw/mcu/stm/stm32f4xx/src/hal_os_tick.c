@@ -21,15 +21,144 @@
 #include <os/os.h>
 #include <hal/hal_os_tick.h>
 
+struct hal_os_tick
+{
+    uint32_t cycles_per_ostick;
+    os_time_t max_idle_ticks;
+};
+
+static struct hal_os_tick g_hal_os_tick;
+
 /*
- * XXX implement tickless mode.
+ * Stretch the SysTick period to cover 'ticks' OS ticks (the current one
+ * included), sleep, and then account for the ticks that elapsed.
+ *
+ * SysTick is only 24 bits wide, so at high core clocks the idle period is
+ * limited to a few tens of milliseconds; longer idle durations just take
+ * several trips through here.
  */
+static void
+stm32f4_os_tick_idle_long(os_time_t ticks)
+{
+    uint32_t cycles;
+    uint32_t reload;
+    uint32_t elapsed;
+    uint32_t load;
+    os_time_t done;
+
+    if (ticks > g_hal_os_tick.max_idle_ticks) {
+        ticks = g_hal_os_tick.max_idle_ticks;
+    }
+    cycles = g_hal_os_tick.cycles_per_ostick;
+
+    /* Reading CTRL here also clears a stale COUNTFLAG. */
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+
+    /*
+     * A tick that expired while interrupts were disabled is still pending;
+     * let it be processed instead of sleeping past it.
+     */
+    if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) {
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+        return;
+    }
+
+    /* Remainder of the current tick plus the full ticks that follow. */
+    reload = SysTick->VAL + (ticks - 1) * cycles;
+    SysTick->LOAD = reload;
+    SysTick->VAL = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+
+    __DSB();
+    __WFI();
+
+    /* Stop the counter without reading (and so clearing) COUNTFLAG. */
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk;
+
+    if (SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) {
+        /*
+         * Woken up by the stretched tick itself. Its interrupt is pending
+         * and will account for the last tick once interrupts are enabled;
+         * the counter has already reloaded and is into the next tick.
+         */
+        done = ticks - 1;
+        elapsed = reload - SysTick->VAL;
+        if (elapsed >= cycles - 1) {
+            load = cycles - 1;
+        } else {
+            load = cycles - 1 - elapsed;
+        }
+    } else {
+        /*
+         * Woken up early by another interrupt. Count the cycles from the
+         * start of the tick that was current when going idle.
+         */
+        elapsed = ticks * cycles - SysTick->VAL;
+        done = elapsed / cycles;
+        load = (done + 1) * cycles - elapsed - 1;
+        if (load == 0) {
+            load = 1;
+        }
+    }
+
+    /* Finish the current tick, then resume regular ticking. */
+    SysTick->LOAD = load;
+    SysTick->VAL = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    SysTick->LOAD = cycles - 1;
+
+    if (done > 0) {
+        os_time_advance(done);
+    }
+}
+
 void
 os_tick_idle(os_time_t ticks)
 {
     OS_ASSERT_CRITICAL();
-    __DSB();
-    __WFI();
+
+    /*
+     * Only worth reprogramming SysTick if at least one whole tick can be
+     * skipped.
+     */
+    if (ticks > 1) {
+        stm32f4_os_tick_idle_long(ticks);
+    } else {
+        __DSB();
+        __WFI();
+    }
+}
+
+/*
+ * The core clock changed from 'old_hclk' to SystemCoreClock. Finish the
+ * current tick with its remaining cycles scaled to the new clock, then
+ * tick with the new period.
+ */
+void
+stm32f4_os_tick_clock_changed(uint32_t old_hclk)
+{
+    uint32_t cycles;
+    uint32_t left;
+
+    if (g_hal_os_tick.cycles_per_ostick == 0) {
+        /* Not ticking yet; os_tick_init() will use the new clock. */
+        return;
+    }
+    cycles = SystemCoreClock / OS_TICKS_PER_SEC;
+
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+    left = (uint64_t)SysTick->VAL * SystemCoreClock / old_hclk;
+    if (left == 0) {
+        left = 1;
+    }
+
+    g_hal_os_tick.cycles_per_ostick = cycles;
+    g_hal_os_tick.max_idle_ticks = SysTick_LOAD_RELOAD_Msk / cycles;
+
+    SysTick->LOAD = left;
+    SysTick->VAL = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    SysTick->LOAD = cycles - 1;
 }
 
 void
@@ -39,6 +168,10 @@ os_tick_init(uint32_t os_ticks_per_sec, int prio)
 
     reload_val = ((uint64_t)SystemCoreClock / os_ticks_per_sec) - 1;
 
+    g_hal_os_tick.cycles_per_ostick = reload_val + 1;
+    g_hal_os_tick.max_idle_ticks = SysTick_LOAD_RELOAD_Msk /
+                                   g_hal_os_tick.cycles_per_ostick;
+
     /* Set the system time ticker up */
     SysTick->LOAD = reload_val;
     SysTick->VAL = 0;
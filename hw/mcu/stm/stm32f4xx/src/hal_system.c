@@ -21,6 +21,32 @@
 #include <os/os.h>
 #include "hal/hal_system.h"
 #include "stm32f4xx_hal_def.h"
+#include "stm32f4xx_hal_dma.h"
+#include "stm32f4xx_hal_rcc.h"
+#include "mcu/stm32f4xx_mynewt_hal.h"
+
+/*
+ * CPU clock dividers, as AHB prescaler settings. SYSCLK (and so the PLL and
+ * flash wait states) stays as set up by the BSP; HCLK and the APB clocks
+ * derived from it scale together.
+ */
+static const struct {
+    uint16_t div;
+    uint16_t hpre;
+} stm32f4_clock_divs[] = {
+    { 1, RCC_SYSCLK_DIV1 },
+    { 2, RCC_SYSCLK_DIV2 },
+    { 4, RCC_SYSCLK_DIV4 },
+    { 8, RCC_SYSCLK_DIV8 },
+    { 16, RCC_SYSCLK_DIV16 },
+    { 64, RCC_SYSCLK_DIV64 },
+    { 128, RCC_SYSCLK_DIV128 },
+    { 256, RCC_SYSCLK_DIV256 },
+    { 512, RCC_SYSCLK_DIV512 },
+};
+
+#define STM32F4_CLOCK_DIV_CNT                                           \
+    (sizeof(stm32f4_clock_divs) / sizeof(stm32f4_clock_divs[0]))
 
 void
 hal_system_reset(void)
@@ -42,6 +68,70 @@ hal_debugger_connected(void)
     return CoreDebug->DHCSR & CoreDebug_DHCSR_C_DEBUGEN_Msk;
 }
 
+uint32_t
+hal_system_clock_div_get(void)
+{
+    uint32_t hpre;
+    int i;
+
+    hpre = RCC->CFGR & RCC_CFGR_HPRE;
+    for (i = 0; i < STM32F4_CLOCK_DIV_CNT; i++) {
+        if (stm32f4_clock_divs[i].hpre == hpre) {
+            return stm32f4_clock_divs[i].div;
+        }
+    }
+    return 1;
+}
+
+/*
+ * SPI and I2C are not retimed; SPI runs slower, and I2C needs to be
+ * reconfigured.
+ */
+int
+hal_system_clock_div_set(uint32_t div)
+{
+    uint32_t old_hclk;
+    uint32_t new_hclk;
+    uint32_t hpre;
+    int sr;
+    int i;
+
+    for (i = 0; i < STM32F4_CLOCK_DIV_CNT; i++) {
+        if (stm32f4_clock_divs[i].div == div) {
+            break;
+        }
+    }
+    if (i == STM32F4_CLOCK_DIV_CNT) {
+        return -1;
+    }
+    hpre = stm32f4_clock_divs[i].hpre;
+
+    __HAL_DISABLE_INTERRUPTS(sr);
+    if ((RCC->CFGR & RCC_CFGR_HPRE) == hpre) {
+        __HAL_ENABLE_INTERRUPTS(sr);
+        return 0;
+    }
+    old_hclk = SystemCoreClock;
+    new_hclk = (uint64_t)old_hclk * hal_system_clock_div_get() / div;
+    if (!stm32f4_hal_timer_clock_ok(old_hclk, new_hclk)) {
+        __HAL_ENABLE_INTERRUPTS(sr);
+        return -1;
+    }
+
+    /* Let characters being sent finish at the old baud rate. */
+    stm32f4_uart_tx_drain();
+
+    MODIFY_REG(RCC->CFGR, RCC_CFGR_HPRE, hpre);
+    SystemCoreClockUpdate();
+
+    stm32f4_os_tick_clock_changed(old_hclk);
+    stm32f4_hal_timer_clock_changed();
+    stm32f4_uart_clock_changed();
+    __HAL_ENABLE_INTERRUPTS(sr);
+
+    return 0;
+}
+
 uint32_t
 HAL_GetTick(void)
 {
@@ -39,7 +39,8 @@
 struct stm32f4_hal_tmr {
     TIM_TypeDef *sht_regs;	/* Pointer to timer registers */
     uint32_t sht_oflow;		/* 16 bits of overflow to make timer 32bits */
-    TAILQ_HEAD(hal_timer_qhead, hal_timer) sht_timers;
+    uint32_t sht_freq;		/* configured frequency, 0 if not running */
+    struct hal_timer_queue sht_timers;
 };
 
 #if MYNEWT_VAL(TIMER_0)
@@ -74,17 +75,16 @@ stm32f4_tmr_cbs(struct stm32f4_hal_tmr *tmr)
     uint32_t cnt;
     struct hal_timer *ht;
 
-    while ((ht = TAILQ_FIRST(&tmr->sht_timers)) != NULL) {
+    while ((ht = hal_timer_queue_first(&tmr->sht_timers)) != NULL) {
         cnt = hal_timer_cnt(tmr);
         if (((int32_t)(cnt - ht->expiry)) >= 0) {
-            TAILQ_REMOVE(&tmr->sht_timers, ht, link);
-            ht->link.tqe_prev = NULL;
+            hal_timer_queue_remove(&tmr->sht_timers, ht);
             ht->cb_func(ht->cb_arg);
         } else {
             break;
         }
     }
-    ht = TAILQ_FIRST(&tmr->sht_timers);
+    ht = hal_timer_queue_first(&tmr->sht_timers);
     if (ht) {
         tmr->sht_regs->CCR1 = ht->expiry;
     } else {
@@ -337,13 +337,14 @@ hal_timer_config(int num, uint32_t freq_hz)
     }
 
     prescaler = stm32f4_base_freq(tmr->sht_regs) / freq_hz;
-    if (prescaler > 0xffff) {
+    if (prescaler == 0 || prescaler > 0x10000) {
         return -1;
     }
+    tmr->sht_freq = freq_hz;
 
     memset(&init, 0, sizeof(init));
     init.Period = 0xffff;
-    init.Prescaler = prescaler;
+    init.Prescaler = prescaler - 1;
     init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
     init.CounterMode = TIM_COUNTERMODE_UP;
 
@@ -387,6 +388,7 @@ hal_timer_deinit(int num)
     tmr->sht_regs->CR1 &= ~TIM_CR1_CEN;
     tmr->sht_regs->DIER &= ~TIM_DIER_CC1IE;
     TIM_CCxChannelCmd(tmr->sht_regs, TIM_CHANNEL_1, TIM_CCx_DISABLE);
+    tmr->sht_freq = 0;
     __HAL_ENABLE_INTERRUPTS(sr);
     stm32f4_hw_setdown(tmr->sht_regs);
 
@@ -410,7 +412,58 @@ hal_timer_get_resolution(int num)
     if (num >= STM32F4_HAL_TIMER_MAX || !(tmr = stm32f4_tmr_devs[num])) {
         return -1;
     }
-    return (1000000000 / (SystemCoreClock / tmr->sht_regs->PSC));
+    return (1000000000 / (stm32f4_base_freq(tmr->sht_regs) /
+                          (tmr->sht_regs->PSC + 1)));
+}
+
+/*
+ * Timer clocks scale with HCLK. Running timers can follow a change only if
+ * their frequency still divides the new timer clock exactly.
+ */
+int
+stm32f4_hal_timer_clock_ok(uint32_t old_hclk, uint32_t new_hclk)
+{
+    struct stm32f4_hal_tmr *tmr;
+    uint32_t base;
+    int i;
+
+    for (i = 0; i < STM32F4_HAL_TIMER_MAX; i++) {
+        tmr = stm32f4_tmr_devs[i];
+        if (!tmr || !tmr->sht_freq) {
+            continue;
+        }
+        base = (uint64_t)stm32f4_base_freq(tmr->sht_regs) * new_hclk /
+               old_hclk;
+        if (base % tmr->sht_freq || base / tmr->sht_freq == 0 ||
+            base / tmr->sht_freq > 0x10000) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Load the prescaler for the new timer clock right away. The update event
+ * which loads it also clears the counter, so put the count back.
+ */
+void
+stm32f4_hal_timer_clock_changed(void)
+{
+    struct stm32f4_hal_tmr *tmr;
+    uint32_t cnt;
+    int i;
+
+    for (i = 0; i < STM32F4_HAL_TIMER_MAX; i++) {
+        tmr = stm32f4_tmr_devs[i];
+        if (!tmr || !tmr->sht_freq) {
+            continue;
+        }
+        cnt = tmr->sht_regs->CNT;
+        tmr->sht_regs->PSC =
+          stm32f4_base_freq(tmr->sht_regs) / tmr->sht_freq - 1;
+        tmr->sht_regs->EGR = TIM_EGR_UG;
+        tmr->sht_regs->CNT = cnt;
+    }
 }
 
 static uint32_t
@@ -500,7 +553,7 @@ hal_timer_set_cb(int num, struct hal_timer *timer, hal_timer_cb cb_func,
     timer->cb_func = cb_func;
     timer->cb_arg = arg;
     timer->bsp_timer = tmr;
-    timer->link.tqe_prev = NULL;
+    timer->prev = NULL;
 
     return 0;
 }
@@ -541,7 +594,6 @@ int
 hal_timer_start_at(struct hal_timer *timer, uint32_t tick)
 {
     struct stm32f4_hal_tmr *tmr;
-    struct hal_timer *ht;
     int sr;
 
     tmr = (struct stm32f4_hal_tmr *)timer->bsp_timer;
@@ -550,19 +602,7 @@ hal_timer_start_at(struct hal_timer *timer, uint32_t tick)
 
     __HAL_DISABLE_INTERRUPTS(sr);
 
-    if (TAILQ_EMPTY(&tmr->sht_timers)) {
-        TAILQ_INSERT_HEAD(&tmr->sht_timers, timer, link);
-    } else {
-        TAILQ_FOREACH(ht, &tmr->sht_timers, link) {
-            if ((int32_t)(timer->expiry - ht->expiry) < 0) {
-                TAILQ_INSERT_BEFORE(ht, timer, link);
-                break;
-            }
-        }
-        if (!ht) {
-            TAILQ_INSERT_TAIL(&tmr->sht_timers, timer, link);
-        }
-    }
+    hal_timer_queue_insert(&tmr->sht_timers, timer);
 
     if ((int32_t)(tick - hal_timer_cnt(tmr)) <= 0) {
         /*
@@ -571,7 +611,7 @@ hal_timer_start_at(struct hal_timer *timer, uint32_t tick)
         tmr->sht_regs->EGR |= TIM_EGR_CC1G;
         tmr->sht_regs->DIER |= TIM_DIER_CC1IE;
     } else {
-        if (timer == TAILQ_FIRST(&tmr->sht_timers)) {
+        if (timer == hal_timer_queue_first(&tmr->sht_timers)) {
             TIM_CCxChannelCmd(tmr->sht_regs, TIM_CHANNEL_1, TIM_CCx_ENABLE);
             tmr->sht_regs->CCR1 = timer->expiry;
             tmr->sht_regs->DIER |= TIM_DIER_CC1IE;
@@ -602,16 +642,15 @@ hal_timer_stop(struct hal_timer *timer)
     __HAL_DISABLE_INTERRUPTS(sr);
 
     tmr = (struct stm32f4_hal_tmr *)timer->bsp_timer;
-    if (timer->link.tqe_prev != NULL) {
+    if (hal_timer_queued(timer)) {
         reset_ocmp = 0;
-        if (timer == TAILQ_FIRST(&tmr->sht_timers)) {
+        if (timer == hal_timer_queue_first(&tmr->sht_timers)) {
             /* If first on queue, we will need to reset OCMP */
-            ht = TAILQ_NEXT(timer, link);
             reset_ocmp = 1;
         }
-        TAILQ_REMOVE(&tmr->sht_timers, timer, link);
-        timer->link.tqe_prev = NULL;
+        hal_timer_queue_remove(&tmr->sht_timers, timer);
         if (reset_ocmp) {
+            ht = hal_timer_queue_first(&tmr->sht_timers);
             if (ht) {
                 tmr->sht_regs->CCR1 = ht->expiry;
             } else {
@@ -39,6 +39,10 @@ struct hal_uart {
     hal_uart_rx_char u_rx_func;
     hal_uart_tx_char u_tx_func;
     hal_uart_tx_done u_tx_done;
+    hal_uart_tx_buf u_tx_buf_func;
+    uint8_t *u_tx_ptr;          /* Rest of block being sent */
+    int u_tx_len;
+    int32_t u_baudrate;
     void *u_func_arg;
     const struct stm32f4_uart_cfg *u_cfg;
 };
@@ -63,10 +67,53 @@ hal_uart_init_cbs(int port, hal_uart_tx_char tx_func, hal_uart_tx_done tx_done,
     u->u_rx_func = rx_func;
     u->u_tx_func = tx_func;
     u->u_tx_done = tx_done;
+    u->u_tx_buf_func = NULL;
     u->u_func_arg = arg;
     return 0;
 }
 
+int
+hal_uart_init_tx_buf(int port, hal_uart_tx_buf tx_buf)
+{
+    struct hal_uart *u;
+
+    u = &uarts[port];
+    if (port >= UART_CNT || u->u_open) {
+        return -1;
+    }
+    u->u_tx_buf_func = tx_buf;
+    u->u_tx_len = 0;
+    return 0;
+}
+
+int
+hal_uart_init_rx_buf(int port, hal_uart_rx_buf rx_buf)
+{
+    /* Block receive not supported; rx_char is used. */
+    return -1;
+}
+
+/*
+ * Next byte to send, -1 if none.  With block transmit, the upper layer is
+ * asked for more only when the previous block has been written out.
+ */
+static int
+hal_uart_tx_next(struct hal_uart *u)
+{
+    if (!u->u_tx_buf_func) {
+        return u->u_tx_func(u->u_func_arg);
+    }
+    if (u->u_tx_len == 0) {
+        u->u_tx_len = u->u_tx_buf_func(u->u_func_arg, &u->u_tx_ptr, INT16_MAX);
+        if (u->u_tx_len <= 0) {
+            u->u_tx_len = 0;
+            return -1;
+        }
+    }
+    u->u_tx_len--;
+    return *u->u_tx_ptr++;
+}
+
 static void
 uart_irq_handler(int num)
 {
@@ -96,7 +143,7 @@ uart_irq_handler(int num)
     if (isr & (USART_SR_TXE | USART_SR_TC)) {
         cr1 = regs->CR1;
         if (isr & USART_SR_TXE) {
-            data = u->u_tx_func(u->u_func_arg);
+            data = hal_uart_tx_next(u);
             if (data < 0) {
                 cr1 &= ~USART_CR1_TXEIE;
                 cr1 |= USART_CR1_TCIE;
@@ -260,6 +307,53 @@ hal_uart_set_nvic(IRQn_Type irqn, struct hal_uart *uart)
     }
 }
 
+static void
+hal_uart_set_brr(struct hal_uart *u)
+{
+    if (u->u_regs == USART1 || u->u_regs == USART6) {
+        u->u_regs->BRR = UART_BRR_SAMPLING16(HAL_RCC_GetPCLK2Freq(),
+                                             u->u_baudrate);
+    } else {
+        u->u_regs->BRR = UART_BRR_SAMPLING16(HAL_RCC_GetPCLK1Freq(),
+                                             u->u_baudrate);
+    }
+}
+
+/*
+ * Wait for characters being sent to leave the shift register. Called with
+ * interrupts disabled, so nothing new is queued meanwhile.
+ */
+void
+stm32f4_uart_tx_drain(void)
+{
+    struct hal_uart *u;
+    int i;
+
+    for (i = 0; i < UART_CNT; i++) {
+        u = &uarts[i];
+        if (!u->u_open) {
+            continue;
+        }
+        while ((u->u_regs->SR & USART_SR_TC) == 0) {
+        }
+    }
+}
+
+/*
+ * APB clocks changed; recompute baud rate divisors of open ports.
+ */
+void
+stm32f4_uart_clock_changed(void)
+{
+    int i;
+
+    for (i = 0; i < UART_CNT; i++) {
+        if (uarts[i].u_open) {
+            hal_uart_set_brr(&uarts[i]);
+        }
+    }
+}
+
 int
 hal_uart_config(int port, int32_t baudrate, uint8_t databits, uint8_t stopbits,
   enum hal_uart_parity parity, enum hal_uart_flow_ctl flow_ctl)
@@ -362,11 +456,8 @@ hal_uart_config(int port, int32_t baudrate, uint8_t databits, uint8_t stopbits,
     u->u_regs->CR3 = cr3;
     u->u_regs->CR2 = cr2;
     u->u_regs->CR1 = cr1;
-    if (cfg->suc_uart == USART1 || cfg->suc_uart == USART6) {
-        u->u_regs->BRR = UART_BRR_SAMPLING16(HAL_RCC_GetPCLK2Freq(), baudrate);
-    } else {
-        u->u_regs->BRR = UART_BRR_SAMPLING16(HAL_RCC_GetPCLK1Freq(), baudrate);
-    }
+    u->u_baudrate = baudrate;
+    hal_uart_set_brr(u);
 
     (void)u->u_regs->DR;
     (void)u->u_regs->SR;
@@ -0,0 +1,55 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __MCU_STM32F7_CACHE_H_
+#define __MCU_STM32F7_CACHE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Data cache maintenance for buffers shared with DMA. The cache line is
+ * 32 bytes; DMA buffers should be aligned to, and padded to, a multiple of
+ * that. DTCM is never cached, so buffers placed there (sec_bss_core) need
+ * no maintenance. These are no-ops while the D-cache is disabled.
+ */
+#define STM32F7_DCACHE_LINE     32
+
+/*
+ * Writes back cached data in [addr, addr + len) so that DMA reads what the
+ * CPU wrote. Call before handing a TX buffer to DMA.
+ */
+void stm32f7_dcache_clean(const void *addr, uint32_t len);
+
+/*
+ * Discards cached data in [addr, addr + len) so that the CPU reads what DMA
+ * wrote. Partial lines at either end are written back first, so data
+ * sharing those lines with the buffer is not lost. Call before handing an
+ * RX buffer to DMA, and again before reading it after DMA completes.
+ */
+void stm32f7_dcache_invalidate(void *addr, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MCU_STM32F7_CACHE_H_ */
@@ -0,0 +1,86 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "hal/hal_aes.h"
+#include "stm32f7xx_hal.h"
+
+#if defined(CRYP)
+
+static uint32_t
+hal_aes_be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+/*
+ * The CRYP unit (STM32F756/777/779) in AES-ECB mode.  With 8-bit data
+ * type it byte swaps the data words, so blocks go in and out as they are
+ * laid out in memory; the key registers take big-endian words.
+ */
+int
+hal_aes128_encrypt(const uint8_t *key, const uint8_t *in, uint8_t *out)
+{
+    uint32_t primask;
+    uint32_t word[4];
+    int i;
+
+    memcpy(word, in, sizeof word);
+
+    __HAL_RCC_CRYP_CLK_ENABLE();
+
+    /* Key and data are written to the unit's registers; keep others out. */
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    CRYP->CR = 0;
+    CRYP->CR = CRYP_CR_ALGOMODE_AES_ECB | CRYP_CR_DATATYPE_1;
+    CRYP->K2LR = hal_aes_be32(key);
+    CRYP->K2RR = hal_aes_be32(key + 4);
+    CRYP->K3LR = hal_aes_be32(key + 8);
+    CRYP->K3RR = hal_aes_be32(key + 12);
+    CRYP->CR |= CRYP_CR_FFLUSH;
+    CRYP->CR |= CRYP_CR_CRYPEN;
+
+    for (i = 0; i < 4; i++) {
+        CRYP->DR = word[i];
+    }
+    for (i = 0; i < 4; i++) {
+        while (!(CRYP->SR & CRYP_SR_OFNE)) {
+        }
+        word[i] = CRYP->DOUT;
+    }
+    CRYP->CR = 0;
+
+    __set_PRIMASK(primask);
+
+    memcpy(out, word, sizeof word);
+
+    return 0;
+}
+
+#else
+
+int
+hal_aes128_encrypt(const uint8_t *key, const uint8_t *in, uint8_t *out)
+{
+    return -1;
+}
+
+#endif
@@ -22,6 +22,7 @@
 #include "stm32f7xx_hal_flash.h"
 #include "stm32f7xx_hal_flash_ex.h"
 #include "hal/hal_flash_int.h"
+#include "mcu/stm32f7_cache.h"
 
 static int stm32f7_flash_read(const struct hal_flash *dev, uint32_t address,
         void *dst, uint32_t num_bytes);
@@ -86,21 +87,25 @@ stm32f7_flash_write(const struct hal_flash *dev, uint32_t address,
     int rc;
 
     sptr = src;
+    rc = 0;
     /*
      * Clear status of previous operation.
      */
     __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR | \
       FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_ERSERR);
     for (i = 0; i < num_bytes; i++) {
-        rc = HAL_FLASH_Program(FLASH_TYPEPROGRAM_BYTE, address, sptr[i]);
+        rc = HAL_FLASH_Program(FLASH_TYPEPROGRAM_BYTE, address + i, sptr[i]);
         if (rc != 0) {
-            return rc;
+            break;
         }
-
-        address++;
     }
 
-    return 0;
+    /*
+     * Flash is cached write-through; drop lines holding the old contents.
+     */
+    stm32f7_dcache_invalidate((void *)address, i);
+
+    return rc;
 }
 
 static void
@@ -117,6 +122,8 @@ stm32f7_flash_erase_sector(const struct hal_flash *dev, uint32_t sector_address)
     for (i = 0; i < STM32F7_FLASH_NUM_AREAS - 1; i++) {
         if (stm32f7_flash_sectors[i] == sector_address) {
             stm32f7_flash_erase_sector_id(i);
+            stm32f7_dcache_invalidate((void *)sector_address,
+              stm32f7_flash_sectors[i + 1] - sector_address);
             return 0;
         }
     }
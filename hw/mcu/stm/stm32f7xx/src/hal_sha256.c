@@ -0,0 +1,137 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include "hal/hal_sha256.h"
+#include "stm32f7xx_hal.h"
+
+#if defined(HASH)
+
+/*
+ * The HASH unit (STM32F756/777/779) in SHA-256 mode.  With 8-bit data type it byte
+ * swaps the data words, so the message goes in as laid out in memory; a
+ * trailing partial word is held back until the next update or the finish.
+ */
+static struct {
+    uint8_t busy;
+    uint8_t part_len;
+    uint8_t part[4];
+} hal_sha256_state;
+
+int
+hal_sha256_start(void)
+{
+    uint32_t primask;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (hal_sha256_state.busy) {
+        __set_PRIMASK(primask);
+        return -1;
+    }
+    hal_sha256_state.busy = 1;
+    __set_PRIMASK(primask);
+
+    __HAL_RCC_HASH_CLK_ENABLE();
+
+    hal_sha256_state.part_len = 0;
+    HASH->CR = HASH_CR_ALGO | HASH_CR_DATATYPE_1 | HASH_CR_INIT;
+
+    return 0;
+}
+
+int
+hal_sha256_update(const void *data, uint32_t len)
+{
+    const uint8_t *ptr;
+    uint32_t word;
+
+    ptr = data;
+    while (len > 0 && hal_sha256_state.part_len != 0) {
+        hal_sha256_state.part[hal_sha256_state.part_len++] = *ptr++;
+        len--;
+        if (hal_sha256_state.part_len == 4) {
+            memcpy(&word, hal_sha256_state.part, 4);
+            HASH->DIN = word;
+            hal_sha256_state.part_len = 0;
+        }
+    }
+    while (len >= 4) {
+        memcpy(&word, ptr, 4);
+        HASH->DIN = word;
+        ptr += 4;
+        len -= 4;
+    }
+    memcpy(hal_sha256_state.part + hal_sha256_state.part_len, ptr, len);
+    hal_sha256_state.part_len += len;
+
+    return 0;
+}
+
+int
+hal_sha256_finish(uint8_t *digest)
+{
+    uint32_t word;
+    int i;
+
+    if (hal_sha256_state.part_len != 0) {
+        word = 0;
+        memcpy(&word, hal_sha256_state.part, hal_sha256_state.part_len);
+        HASH->DIN = word;
+    }
+    /* Number of valid bits in the last word; 0 means all of them. */
+    HASH->STR = hal_sha256_state.part_len * 8;
+    HASH->STR |= HASH_STR_DCAL;
+    while (HASH->SR & HASH_SR_BUSY) {
+    }
+
+    for (i = 0; i < 8; i++) {
+        word = HASH_DIGEST->HR[i];
+        digest[i * 4] = word >> 24;
+        digest[i * 4 + 1] = word >> 16;
+        digest[i * 4 + 2] = word >> 8;
+        digest[i * 4 + 3] = word;
+    }
+
+    hal_sha256_state.busy = 0;
+
+    return 0;
+}
+
+#else
+
+int
+hal_sha256_start(void)
+{
+    return -1;
+}
+
+int
+hal_sha256_update(const void *data, uint32_t len)
+{
+    return -1;
+}
+
+int
+hal_sha256_finish(uint8_t *digest)
+{
+    return -1;
+}
+
+#endif
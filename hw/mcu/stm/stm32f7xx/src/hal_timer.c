@@ -39,7 +39,7 @@
 struct stm32f7_hal_tmr {
     TIM_TypeDef *sht_regs;	/* Pointer to timer registers */
     uint32_t sht_oflow;		/* 16 bits of overflow to make timer 32bits */
-    TAILQ_HEAD(hal_timer_qhead, hal_timer) sht_timers;
+    struct hal_timer_queue sht_timers;
 };
 
 #if MYNEWT_VAL(TIMER_0)
@@ -82,17 +82,16 @@ stm32f7_tmr_cbs(struct stm32f7_hal_tmr *tmr)
     uint32_t cnt;
     struct hal_timer *ht;
 
-    while ((ht = TAILQ_FIRST(&tmr->sht_timers)) != NULL) {
+    while ((ht = hal_timer_queue_first(&tmr->sht_timers)) != NULL) {
         cnt = hal_timer_cnt(tmr);
         if (((int32_t)(cnt - ht->expiry)) >= 0) {
-            TAILQ_REMOVE(&tmr->sht_timers, ht, link);
-            ht->link.tqe_prev = NULL;
+            hal_timer_queue_remove(&tmr->sht_timers, ht);
             ht->cb_func(ht->cb_arg);
         } else {
             break;
         }
     }
-    ht = TAILQ_FIRST(&tmr->sht_timers);
+    ht = hal_timer_queue_first(&tmr->sht_timers);
     if (ht) {
         tmr->sht_regs->CCR1 = ht->expiry;
     } else {
@@ -521,7 +520,7 @@ hal_timer_set_cb(int num, struct hal_timer *timer, hal_timer_cb cb_func,
     timer->cb_func = cb_func;
     timer->cb_arg = arg;
     timer->bsp_timer = tmr;
-    timer->link.tqe_prev = NULL;
+    timer->prev = NULL;
 
     return 0;
 }
@@ -562,7 +561,6 @@ int
 hal_timer_start_at(struct hal_timer *timer, uint32_t tick)
 {
     struct stm32f7_hal_tmr *tmr;
-    struct hal_timer *ht;
     int sr;
 
     tmr = (struct stm32f7_hal_tmr *)timer->bsp_timer;
@@ -571,19 +569,7 @@ hal_timer_start_at(struct hal_timer *timer, uint32_t tick)
 
     __HAL_DISABLE_INTERRUPTS(sr);
 
-    if (TAILQ_EMPTY(&tmr->sht_timers)) {
-        TAILQ_INSERT_HEAD(&tmr->sht_timers, timer, link);
-    } else {
-        TAILQ_FOREACH(ht, &tmr->sht_timers, link) {
-            if ((int32_t)(timer->expiry - ht->expiry) < 0) {
-                TAILQ_INSERT_BEFORE(ht, timer, link);
-                break;
-            }
-        }
-        if (!ht) {
-            TAILQ_INSERT_TAIL(&tmr->sht_timers, timer, link);
-        }
-    }
+    hal_timer_queue_insert(&tmr->sht_timers, timer);
 
     if ((int32_t)(tick - hal_timer_cnt(tmr)) <= 0) {
         /*
@@ -592,7 +578,7 @@ hal_timer_start_at(struct hal_timer *timer, uint32_t tick)
         tmr->sht_regs->EGR |= TIM_EGR_CC1G;
         tmr->sht_regs->DIER |= TIM_DIER_CC1IE;
     } else {
-        if (timer == TAILQ_FIRST(&tmr->sht_timers)) {
+        if (timer == hal_timer_queue_first(&tmr->sht_timers)) {
             TIM_CCxChannelCmd(tmr->sht_regs, TIM_CHANNEL_1, TIM_CCx_ENABLE);
             tmr->sht_regs->CCR1 = timer->expiry;
             tmr->sht_regs->DIER |= TIM_DIER_CC1IE;
@@ -623,16 +609,15 @@ hal_timer_stop(struct hal_timer *timer)
     __HAL_DISABLE_INTERRUPTS(sr);
 
     tmr = (struct stm32f7_hal_tmr *)timer->bsp_timer;
-    if (timer->link.tqe_prev != NULL) {
+    if (hal_timer_queued(timer)) {
         reset_ocmp = 0;
-        if (timer == TAILQ_FIRST(&tmr->sht_timers)) {
+        if (timer == hal_timer_queue_first(&tmr->sht_timers)) {
             /* If first on queue, we will need to reset OCMP */
-            ht = TAILQ_NEXT(timer, link);
             reset_ocmp = 1;
         }
-        TAILQ_REMOVE(&tmr->sht_timers, timer, link);
-        timer->link.tqe_prev = NULL;
+        hal_timer_queue_remove(&tmr->sht_timers, timer);
         if (reset_ocmp) {
+            ht = hal_timer_queue_first(&tmr->sht_timers);
             if (ht) {
                 tmr->sht_regs->CCR1 = ht->expiry;
             } else {
@@ -0,0 +1,70 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdint.h>
+
+#include "mcu/cortex_m7.h"
+#include "mcu/stm32f7_cache.h"
+
+#define DCACHE_ENABLED()        (SCB->CCR & SCB_CCR_DC_Msk)
+
+void
+stm32f7_dcache_clean(const void *addr, uint32_t len)
+{
+    uint32_t start;
+    uint32_t end;
+
+    if (!DCACHE_ENABLED() || !len) {
+        return;
+    }
+    start = (uint32_t)addr & ~(STM32F7_DCACHE_LINE - 1);
+    end = (uint32_t)addr + len;
+
+    SCB_CleanDCache_by_Addr((uint32_t *)start, end - start);
+}
+
+void
+stm32f7_dcache_invalidate(void *addr, uint32_t len)
+{
+    uint32_t start;
+    uint32_t end;
+
+    if (!DCACHE_ENABLED() || !len) {
+        return;
+    }
+    start = (uint32_t)addr;
+    end = start + len;
+
+    if (start & (STM32F7_DCACHE_LINE - 1)) {
+        start &= ~(STM32F7_DCACHE_LINE - 1);
+        SCB_CleanInvalidateDCache_by_Addr((uint32_t *)start,
+                                          STM32F7_DCACHE_LINE);
+        start += STM32F7_DCACHE_LINE;
+    }
+    if (end & (STM32F7_DCACHE_LINE - 1)) {
+        end &= ~(STM32F7_DCACHE_LINE - 1);
+        if (end >= start) {
+            SCB_CleanInvalidateDCache_by_Addr((uint32_t *)end,
+                                              STM32F7_DCACHE_LINE);
+        }
+    }
+    if (end > start) {
+        SCB_InvalidateDCache_by_Addr((uint32_t *)start, end - start);
+    }
+}
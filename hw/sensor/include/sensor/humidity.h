@@ -32,7 +32,7 @@ extern "C" {
  * All values are in %rH
  */
 struct sensor_humid_data {
-    float shd_humid;
+    sensor_val_t shd_humid;
 
     /* Validity */
     uint8_t shd_humid_is_valid:1;
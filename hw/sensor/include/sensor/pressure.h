@@ -32,7 +32,7 @@ extern "C" {
  * All values are in Pa
  */
 struct sensor_press_data {
-    float spd_press;
+    sensor_val_t spd_press;
 
     /* Validity */
     uint8_t spd_press_is_valid:1;
@@ -20,6 +20,7 @@
 #ifndef __SENSOR_H__
 #define __SENSOR_H__
 
+#include <math.h>
 #include "os/os.h"
 #include "os/os_dev.h"
 #include "syscfg/syscfg.h"
@@ -32,9 +33,44 @@ extern "C" {
  */
 void sensor_pkg_init(void);
 
+/**
+ * Type of the values in sensor data structures (struct sensor_accel_data
+ * etc.)  With SENSOR_FIXED_POINT, values are signed fixed point numbers
+ * with SENSOR_FIXED_POINT_FRAC_BITS fractional bits, so that parts with no
+ * FPU can read and process sensor data without floating point emulation.
+ * Otherwise they are floats.
+ *
+ * Drivers fill in values with SENSOR_VAL_FROM_RATIO(), which uses only
+ * integer arithmetic in fixed point mode.
+ */
+#if MYNEWT_VAL(SENSOR_FIXED_POINT)
+typedef int32_t sensor_val_t;
+
+#define SENSOR_VAL_ONE      (1L << MYNEWT_VAL(SENSOR_FIXED_POINT_FRAC_BITS))
+/* Marks a value which could not be computed */
+#define SENSOR_VAL_NAN      INT32_MIN
+
+#define SENSOR_VAL_FROM_RATIO(num, den) \
+    ((sensor_val_t)(((int64_t)(num) * SENSOR_VAL_ONE) / (den)))
+#define SENSOR_VAL_FROM_FLOAT(f)    ((sensor_val_t)((f) * SENSOR_VAL_ONE))
+#define SENSOR_VAL_TO_FLOAT(v)      ((float)(v) / SENSOR_VAL_ONE)
+#define SENSOR_VAL_IS_NAN(v)        ((v) == SENSOR_VAL_NAN)
+#else
+typedef float sensor_val_t;
+
+#define SENSOR_VAL_NAN      NAN
+
+#define SENSOR_VAL_FROM_RATIO(num, den) \
+    ((sensor_val_t)(num) / (sensor_val_t)(den))
+#define SENSOR_VAL_FROM_FLOAT(f)    ((sensor_val_t)(f))
+#define SENSOR_VAL_TO_FLOAT(v)      ((float)(v))
+#define SENSOR_VAL_IS_NAN(v)        isnan(v)
+#endif
+
 
 /* Forward declare sensor structure defined below. */
 struct sensor;
+struct sensor_worker;
 
 /**
  * @{ Sensor API
@@ -105,7 +141,8 @@ typedef enum {
  */
 #define SENSOR_VALUE_TYPE_INT32  (1)
 /**
- * 32-bit floating point
+ * 32-bit floating point, or fixed point with SENSOR_FIXED_POINT (see
+ * sensor_val_t)
  */
 #define SENSOR_VALUE_TYPE_FLOAT  (2)
 /**
@@ -113,7 +150,8 @@ typedef enum {
  */
 #define SENSOR_VALUE_TYPE_INT32_TRIPLET (3)
 /**
- * 32-bit floating point number triplet.
+ * 32-bit floating point number triplet, or fixed point with
+ * SENSOR_FIXED_POINT.
  */
 #define SENSOR_VALUE_TYPE_FLOAT_TRIPLET (4)
 
@@ -143,6 +181,49 @@ struct sensor_cfg {
  */
 typedef int (*sensor_data_func_t)(struct sensor *, void *, void *);
 
+struct sensor_timestamp {
+    struct os_timeval st_ostv;
+    struct os_timezone st_ostz;
+    uint32_t st_cputime;
+};
+
+/**
+ * A batch of samples of one sensor type, delivered to batch listeners.
+ */
+struct sensor_batch {
+    /* The type of sensor data in this batch */
+    sensor_type_t sb_type;
+    /* Number of samples in the batch */
+    uint16_t sb_count;
+    /* Size of each sample, e.g. sizeof(struct sensor_accel_data) */
+    uint16_t sb_sample_size;
+    /* Time of the read which produced the first sample */
+    struct sensor_timestamp sb_ts;
+    /* sb_count samples, sb_sample_size bytes apart */
+    void *sb_data;
+    /* Offset of each sample from sb_ts, in microseconds */
+    uint32_t *sb_delta_us;
+};
+
+/**
+ * Returns sample number "idx" in a sensor batch.
+ */
+#define SENSOR_BATCH_SAMPLE(__sb, __idx)                                \
+    ((void *)((uint8_t *)(__sb)->sb_data + (__idx) * (__sb)->sb_sample_size))
+
+/**
+ * Callback for handling a batch of sensor data, specified in a sensor
+ * listener.
+ *
+ * @param The sensor for which data is being returned
+ * @param The listener argument
+ * @param The batch of samples
+ *
+ * @return 0 on success, non-zero error code on failure.
+ */
+typedef int (*sensor_batch_func_t)(struct sensor *, void *,
+        struct sensor_batch *);
+
 /**
  *
  */
@@ -156,6 +237,12 @@ struct sensor_listener {
     /* Sensor data handler function, called when has data */
     sensor_data_func_t sl_func;
 
+    /* Optional handler for batches of data.  Samples read by the sensor
+     * manager are collected, up to SENSOR_BATCH_MAX at a time; other reads
+     * are delivered in batches of one.
+     */
+    sensor_batch_func_t sl_batch_func;
+
     /* Argument for the sensor listener */
     void *sl_arg;
 
@@ -165,6 +252,46 @@ struct sensor_listener {
     SLIST_ENTRY(sensor_listener) sl_next;
 };
 
+/**
+ * Reduces the samples of one sensor type delivered to the listeners of a
+ * sensor.  Each sample is averaged with the ones before it, over a window
+ * of "sr_window" samples; one in every "sr_decimate" averages is then
+ * delivered, and only if it differs from the last one delivered by at least
+ * "sr_threshold" in some axis.  Direct reads with sensor_read() still get
+ * every sample as read.
+ *
+ * Only types whose data is made of sensor_val_t (accelerometer, magnetic
+ * field, temperature, pressure, humidity, rotation vector, euler...) can
+ * be reduced.
+ */
+struct sensor_reduce {
+    /* The sensor type to reduce, a single type */
+    sensor_type_t sr_type;
+
+    /* Moving average window, up to SENSOR_REDUCE_WINDOW_MAX samples; 0 or
+     * 1 for no averaging.
+     */
+    uint8_t sr_window;
+
+    /* Deliver one in every sr_decimate samples, 0 or 1 for all */
+    uint16_t sr_decimate;
+
+    /* Minimum change in some axis for a sample to be delivered, 0 to
+     * deliver regardless.
+     */
+    sensor_val_t sr_threshold;
+
+    /* Private state, reset when registered */
+    uint16_t sr_count;
+    uint8_t sr_head;
+    uint8_t sr_fill;
+    uint8_t sr_has_last;
+    sensor_val_t sr_last[4];
+    sensor_val_t sr_hist[MYNEWT_VAL(SENSOR_REDUCE_WINDOW_MAX)][4];
+
+    SLIST_ENTRY(sensor_reduce) sr_next;
+};
+
 /**
  * Get a more specific interface on this sensor object (e.g. Gyro, Magnometer),
  * which has additional functions for managing the sensor.
@@ -206,16 +333,28 @@ typedef int (*sensor_read_func_t)(struct sensor *, sensor_type_t,
 typedef int (*sensor_get_config_func_t)(struct sensor *, sensor_type_t,
         struct sensor_cfg *);
 
+/**
+ * Start or stop streaming of sensor data.  When streaming, the driver lets
+ * samples accumulate in the on-chip FIFO and arranges for a data-ready or
+ * watermark interrupt, from which it calls sensor_mgr_stream_ready().  Reads
+ * through sd_read then return all samples buffered in the FIFO, calling the
+ * data function once for each.
+ *
+ * @param The sensor to configure
+ * @param The type(s) of sensor values to stream, SENSOR_TYPE_NONE to stop
+ *        streaming.
+ * @param Number of samples to buffer before interrupting.
+ *
+ * @return 0 on success, non-zero error code on failure.
+ */
+typedef int (*sensor_stream_func_t)(struct sensor *, sensor_type_t, uint16_t);
+
 struct sensor_driver {
     sensor_get_interface_func_t sd_get_interface;
     sensor_read_func_t sd_read;
     sensor_get_config_func_t sd_get_config;
-};
-
-struct sensor_timestamp {
-    struct os_timeval st_ostv;
-    struct os_timezone st_ostz;
-    uint32_t st_cputime;
+    /* Optional, NULL if the sensor can only be polled */
+    sensor_stream_func_t sd_stream;
 };
 
 /*
@@ -239,13 +378,27 @@ struct sensor {
      */
     sensor_type_t s_types;
     /**
-     * Poll rate in MS for this sensor.
+     * Poll rate in MS for this sensor, 0 for the default rate.
      */
     uint32_t s_poll_rate;
 
     /* The next time at which we want to poll data from this sensor */
     os_time_t s_next_run;
 
+    /* Fires when the sensor is next to be polled */
+    struct os_callout s_poll_callout;
+
+    /* Worker whose event queue the sensor is polled and streamed from */
+    struct sensor_worker *s_worker;
+
+    /* The types of sensor data being streamed, SENSOR_TYPE_NONE if the
+     * sensor is polled.
+     */
+    sensor_type_t s_stream_types;
+
+    /* Posted to the sensor's worker when streamed data is ready */
+    struct os_event s_stream_ev;
+
     /* Sensor driver specific functions, created by the device registering the
      * sensor.
      */
@@ -258,6 +411,11 @@ struct sensor {
      * sensor
      */
     SLIST_HEAD(, sensor_listener) s_listener_list;
+
+    /* Data reduction applied to samples before they are delivered to
+     * listeners, at most one per sensor type.
+     */
+    SLIST_HEAD(, sensor_reduce) s_reduce_list;
     /* The next sensor in the global sensor list. */
     TAILQ_ENTRY(sensor) s_next;
 };
@@ -267,9 +425,15 @@ int sensor_lock(struct sensor *);
 void sensor_unlock(struct sensor *);
 int sensor_register_listener(struct sensor *, struct sensor_listener *);
 int sensor_unregister_listener(struct sensor *, struct sensor_listener *);
+int sensor_register_reduce(struct sensor *, struct sensor_reduce *);
+int sensor_unregister_reduce(struct sensor *, struct sensor_reduce *);
 
 int sensor_read(struct sensor *, sensor_type_t, sensor_data_func_t, void *,
         uint32_t);
+int sensor_stream_start(struct sensor *, sensor_type_t, uint16_t);
+int sensor_stream_stop(struct sensor *);
+int sensor_set_poll_rate_ms(struct sensor *, uint32_t);
+int sensor_set_evq(struct sensor *, struct os_eventq *);
 
 /**
  * Set the driver functions for this sensor, along with the type of sensor
@@ -328,9 +492,8 @@ sensor_get_interface(struct sensor *sensor, sensor_type_t type)
  */
 
 
-/* Default number of ticks to wakeup the sensor task.  If sensor
- * polling has been configured more frequently than this, it will
- * be triggered instead.
+/* Default number of ticks between polls of a sensor, used for sensors
+ * that have no poll rate set.
  */
 #define SENSOR_MGR_WAKEUP_TICKS (MYNEWT_VAL(SENSOR_MGR_WAKEUP_RATE) * \
         (OS_TICKS_PER_SEC / 1000))
@@ -339,6 +502,7 @@ int sensor_mgr_lock(void);
 void sensor_mgr_unlock(void);
 int sensor_mgr_register(struct sensor *);
 struct os_eventq *sensor_mgr_evq_get(void);
+void sensor_mgr_stream_ready(struct sensor *);
 
 
 typedef int (*sensor_mgr_compare_func_t)(struct sensor *, void *);
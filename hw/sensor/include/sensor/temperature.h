@@ -32,7 +32,7 @@ extern "C" {
  * All values are in Deg C
  */
 struct sensor_temp_data {
-    float std_temp;
+    sensor_val_t std_temp;
 
     /* Validity */
     uint8_t std_temp_is_valid:1;
@@ -21,29 +21,76 @@
 #include <errno.h>
 #include <assert.h>
 
+#include "defs/error.h"
 #include "os/os.h"
 #include "sysinit/sysinit.h"
 
 #include "sensor/sensor.h"
+#include "sensor/accel.h"
+#include "sensor/color.h"
+#include "sensor/euler.h"
+#include "sensor/humidity.h"
+#include "sensor/light.h"
+#include "sensor/mag.h"
+#include "sensor/pressure.h"
+#include "sensor/quat.h"
+#include "sensor/temperature.h"
 
 #include "sensor_priv.h"
 #include "os/os_time.h"
 #include "os/os_cputime.h"
 
+/* Any one sample, used to size batch buffers */
+union sensor_sample {
+    struct sensor_accel_data ss_accel;
+    struct sensor_color_data ss_color;
+    struct sensor_euler_data ss_euler;
+    struct sensor_humid_data ss_humid;
+    struct sensor_light_data ss_light;
+    struct sensor_mag_data ss_mag;
+    struct sensor_press_data ss_press;
+    struct sensor_quat_data ss_quat;
+    struct sensor_temp_data ss_temp;
+};
+
+/*
+ * Sensors are polled and streamed from the event queue of a worker.  All
+ * sensors start out on the sensor manager's event queue; sensors on a slow
+ * bus can be moved onto a queue of their own with sensor_set_evq(), so
+ * that they are read in parallel with, and do not delay, other sensors.
+ */
+struct sensor_worker {
+    struct os_eventq *sw_evq;
+
+    /* Batch of samples being collected, only used from sw_evq */
+    struct sensor_batch sw_batch;
+    union sensor_sample sw_batch_data[MYNEWT_VAL(SENSOR_BATCH_MAX)];
+    uint32_t sw_batch_delta[MYNEWT_VAL(SENSOR_BATCH_MAX)];
+};
+
 struct {
     struct os_mutex mgr_lock;
 
-    struct os_callout mgr_wakeup_callout;
-    struct os_eventq *mgr_eventq;
-
     TAILQ_HEAD(, sensor) mgr_sensor_list;
+
+    /* Worker 0 runs on the sensor manager event queue */
+    struct sensor_worker mgr_workers[MYNEWT_VAL(SENSOR_MGR_WORKERS)];
 } sensor_mgr;
 
 struct sensor_read_ctx {
     sensor_data_func_t user_func;
     void *user_arg;
+    /* The sensor type being read */
+    sensor_type_t type;
+    /* Batch to collect samples into, NULL to deliver them one by one */
+    struct sensor_batch *batch;
 };
 
+static int sensor_read_batch(struct sensor *, sensor_type_t,
+        sensor_data_func_t, void *, uint32_t, struct sensor_batch *);
+static void sensor_poll_event(struct os_event *);
+static void sensor_poll_start(struct sensor *);
+
 struct sensor_timestamp sensor_base_ts;
 struct os_callout st_up_osco;
 
@@ -71,38 +118,10 @@ sensor_mgr_unlock(void)
     (void) os_mutex_release(&sensor_mgr.mgr_lock);
 }
 
-static void
-sensor_mgr_remove(struct sensor *sensor)
-{
-    TAILQ_REMOVE(&sensor_mgr.mgr_sensor_list, sensor, s_next);
-}
-
-static void
-sensor_mgr_insert(struct sensor *sensor)
-{
-    struct sensor *cursor;
-
-    cursor = NULL;
-    TAILQ_FOREACH(cursor, &sensor_mgr.mgr_sensor_list, s_next) {
-        if (cursor->s_next_run == OS_TIMEOUT_NEVER) {
-            break;
-        }
-
-        if (OS_TIME_TICK_LT(sensor->s_next_run, cursor->s_next_run)) {
-            break;
-        }
-    }
-
-    if (cursor) {
-        TAILQ_INSERT_BEFORE(cursor, sensor, s_next);
-    } else {
-        TAILQ_INSERT_TAIL(&sensor_mgr.mgr_sensor_list, sensor, s_next);
-    }
-}
-
 /**
  * Register the sensor with the global sensor list. This makes the sensor
- * searchable by other packages, who may want to look it up by type.
+ * searchable by other packages, who may want to look it up by type, and
+ * starts polling it from the sensor manager event queue.
  *
  * @param The sensor to register
  *
@@ -120,116 +139,247 @@ sensor_mgr_register(struct sensor *sensor)
 
     rc = sensor_lock(sensor);
     if (rc != 0) {
-        goto err;
+        goto err_mgr;
     }
 
-    sensor_mgr_insert(sensor);
+    TAILQ_INSERT_TAIL(&sensor_mgr.mgr_sensor_list, sensor, s_next);
 
-    sensor_unlock(sensor);
+    sensor->s_worker = &sensor_mgr.mgr_workers[0];
+    os_callout_init(&sensor->s_poll_callout, sensor->s_worker->sw_evq,
+            sensor_poll_event, sensor);
+    if (sensor->s_stream_types == SENSOR_TYPE_NONE) {
+        sensor_poll_start(sensor);
+    }
 
+    sensor_unlock(sensor);
+err_mgr:
     sensor_mgr_unlock();
-
-    return (0);
 err:
     return (rc);
 }
 
+/**
+ * Returns the worker running on "evq", allocating a free one if there is
+ * none yet.  Must be called with the sensor manager locked.
+ */
+static struct sensor_worker *
+sensor_mgr_worker_get(struct os_eventq *evq)
+{
+    struct sensor_worker *free;
+    int i;
+
+    free = NULL;
+    for (i = 0; i < MYNEWT_VAL(SENSOR_MGR_WORKERS); i++) {
+        if (sensor_mgr.mgr_workers[i].sw_evq == evq) {
+            return (&sensor_mgr.mgr_workers[i]);
+        }
+        if (!free && !sensor_mgr.mgr_workers[i].sw_evq) {
+            free = &sensor_mgr.mgr_workers[i];
+        }
+    }
+
+    if (free) {
+        free->sw_evq = evq;
+    }
+    return (free);
+}
+
+/**
+ * Poll the sensor now, and every poll interval thereafter.  Must be called
+ * with the sensor locked.
+ */
+static void
+sensor_poll_start(struct sensor *sensor)
+{
+    sensor->s_next_run = os_time_get();
+    os_callout_reset(&sensor->s_poll_callout, 0);
+}
+
+/**
+ * Schedule the next poll of the sensor one poll interval after the last
+ * one was due, rather than after it completed, so that time spent waiting
+ * on the event queue does not accumulate.  If the sensor has fallen more
+ * than a whole interval behind, its schedule is restarted from now.
+ */
+static void
+sensor_poll_schedule(struct sensor *sensor)
+{
+    uint32_t ticks;
+    os_time_t now;
+
+    if (sensor->s_poll_rate == 0 ||
+            os_time_ms_to_ticks(sensor->s_poll_rate, &ticks) != 0) {
+        ticks = SENSOR_MGR_WAKEUP_TICKS;
+    }
+    if (ticks == 0) {
+        ticks = 1;
+    }
+
+    now = os_time_get();
+    sensor->s_next_run += ticks;
+    if (OS_TIME_TICK_LT(sensor->s_next_run, now)) {
+        sensor->s_next_run = now + ticks;
+    }
+
+    os_callout_reset(&sensor->s_poll_callout, sensor->s_next_run - now);
+}
 
-static os_time_t
-sensor_mgr_poll_one(struct sensor *sensor, os_time_t now)
+/**
+ * Poll callout of a sensor, reads all of its types and passes the results
+ * to its listeners.
+ *
+ * @param OS event
+ */
+static void
+sensor_poll_event(struct os_event *ev)
 {
-    uint32_t sensor_ticks;
+    struct sensor *sensor;
     int rc;
 
+    sensor = ev->ev_arg;
+
     rc = sensor_lock(sensor);
     if (rc != 0) {
-        goto err;
+        /* Try again on the next tick */
+        os_callout_reset(&sensor->s_poll_callout, 1);
+        return;
     }
 
-    /* Sensor read results.  Every time a sensor is read, all of its
-     * listeners are called by default.  Specify NULL as a callback,
-     * because we just want to run all the listeners.
-     */
-    sensor_read(sensor, SENSOR_TYPE_ALL, NULL, NULL, OS_TIMEOUT_NEVER);
+    if (sensor->s_stream_types == SENSOR_TYPE_NONE) {
+        /* Sensor read results.  Every time a sensor is read, all of its
+         * listeners are called by default.  Specify NULL as a callback,
+         * because we just want to run all the listeners.
+         */
+        sensor_read_batch(sensor, SENSOR_TYPE_ALL, NULL, NULL,
+                OS_TIMEOUT_NEVER, &sensor->s_worker->sw_batch);
+        sensor_poll_schedule(sensor);
+    }
 
-    /* Remove the sensor from the sensor list for insert. */
-    sensor_mgr_remove(sensor);
+    sensor_unlock(sensor);
+}
 
-    /* Set next wakeup, and insert the sensor back into the
-     * list.
-     */
-    os_time_ms_to_ticks(sensor->s_poll_rate, &sensor_ticks);
-    sensor->s_next_run = now + sensor_ticks;
+/**
+ * Set the interval at which the sensor is polled, 0 to poll it at the
+ * default rate of SENSOR_MGR_WAKEUP_RATE.  The sensor is polled straight
+ * away, and then at the new interval.
+ *
+ * @param The sensor to set the poll rate of
+ * @param The poll interval, in milliseconds
+ *
+ * @return 0 on success, non-zero error code on failure.
+ */
+int
+sensor_set_poll_rate_ms(struct sensor *sensor, uint32_t poll_rate)
+{
+    int rc;
 
-    /* Re-insert the sensor manager, with the new wakeup time. */
-    sensor_mgr_insert(sensor);
+    rc = sensor_lock(sensor);
+    if (rc != 0) {
+        goto err;
+    }
 
-    /* Unlock the sensor to allow other access */
-    sensor_unlock(sensor);
+    sensor->s_poll_rate = poll_rate;
+    if (sensor->s_worker && sensor->s_stream_types == SENSOR_TYPE_NONE) {
+        sensor_poll_start(sensor);
+    }
 
-    return (sensor->s_next_run);
+    sensor_unlock(sensor);
 err:
-    /* Couldn't lock it.  Re-run task and spin until we get result. */
-    return (0);
+    return (rc);
 }
 
 /**
- * Event that wakes up the sensor manager, this goes through the sensor
- * list and polls any active sensors.
+ * Poll and stream the sensor from "evq" instead of the sensor manager event
+ * queue.  Sensors sharing a bus should share an event queue, so that reads
+ * on different buses can run in parallel.  Up to SENSOR_MGR_WORKERS event
+ * queues, including the sensor manager's, can be in use at once.
  *
- * @param OS event
+ * The sensor must have been registered with sensor_mgr_register().
+ *
+ * @param The sensor to move
+ * @param The event queue to read the sensor from
+ *
+ * @return 0 on success, SYS_ENOMEM if all workers are in use, other
+ *         non-zero error code on failure.
  */
-static void
-sensor_mgr_wakeup_event(struct os_event *ev)
+int
+sensor_set_evq(struct sensor *sensor, struct os_eventq *evq)
 {
-    struct sensor *cursor;
-    os_time_t now;
-    os_time_t task_next_wakeup;
-    os_time_t next_wakeup;
+    struct sensor_worker *worker;
     int rc;
 
-    now = os_time_get();
-    task_next_wakeup = now + SENSOR_MGR_WAKEUP_TICKS;
+    if (!sensor->s_worker || !evq) {
+        rc = SYS_EINVAL;
+        goto err;
+    }
 
     rc = sensor_mgr_lock();
     if (rc != 0) {
-        /* Schedule again in 1 tick, see if we can reacquire the lock */
-        task_next_wakeup = now + 1;
-        goto done;
+        goto err;
     }
 
-     TAILQ_FOREACH(cursor, &sensor_mgr.mgr_sensor_list, s_next) {
-        /* Sensors that are not periodic are inserted at the end of the sensor
-         * list.
-         */
-        if (cursor->s_next_run == OS_TIMEOUT_NEVER) {
-            break;
-        }
+    worker = sensor_mgr_worker_get(evq);
+    if (!worker) {
+        rc = SYS_ENOMEM;
+        goto err_mgr;
+    }
 
-        /* List is sorted by what runs first.  If we reached the first element that
-         * doesn't run, break out.
-         */
-        if (OS_TIME_TICK_LT(now, cursor->s_next_run)) {
-            break;
+    rc = sensor_lock(sensor);
+    if (rc != 0) {
+        goto err_mgr;
+    }
+
+    if (worker != sensor->s_worker) {
+        os_callout_stop(&sensor->s_poll_callout);
+        os_eventq_remove(sensor->s_worker->sw_evq, &sensor->s_stream_ev);
+
+        sensor->s_worker = worker;
+        os_callout_init(&sensor->s_poll_callout, worker->sw_evq,
+                sensor_poll_event, sensor);
+        if (sensor->s_stream_types == SENSOR_TYPE_NONE) {
+            sensor_poll_start(sensor);
+        } else {
+            /* Pick up any samples that were ready on the old queue */
+            os_eventq_put(worker->sw_evq, &sensor->s_stream_ev);
         }
+    }
 
-        /* Sensor poll one completes the poll, updates the sensor's "next run,"
-         * and re-inserts it into the list.  It returns the next wakeup time
-         * for this sensor.
-         */
-        next_wakeup = sensor_mgr_poll_one(cursor, now);
+    sensor_unlock(sensor);
+err_mgr:
+    sensor_mgr_unlock();
+err:
+    return (rc);
+}
 
-        /* If the next wakeup time for this sensor is before the task's next
-         * scheduled wakeup, move that forward, so we can collect data from that
-         * sensor
-         */
-        if (task_next_wakeup > next_wakeup) {
-            task_next_wakeup = next_wakeup;
-        }
+/**
+ * Event posted by sensor_mgr_stream_ready(), reads all samples buffered by
+ * a streaming sensor and passes them to its listeners.
+ *
+ * @param OS event
+ */
+static void
+sensor_mgr_stream_event(struct os_event *ev)
+{
+    struct sensor *sensor;
+
+    sensor = ev->ev_arg;
+
+    if (sensor->s_stream_types != SENSOR_TYPE_NONE) {
+        sensor_read_batch(sensor, sensor->s_stream_types, NULL, NULL, 0,
+                &sensor->s_worker->sw_batch);
     }
+}
 
-done:
-    os_callout_reset(&sensor_mgr.mgr_wakeup_callout, task_next_wakeup);
+/**
+ * Called by sensor drivers, typically from the data-ready or FIFO watermark
+ * interrupt handler, when a streaming sensor has data to be read.
+ *
+ * @param The sensor which has data ready
+ */
+void
+sensor_mgr_stream_ready(struct sensor *sensor)
+{
+    os_eventq_put(sensor->s_worker->sw_evq, &sensor->s_stream_ev);
 }
 
 /**
@@ -282,32 +432,33 @@ done:
 struct os_eventq *
 sensor_mgr_evq_get(void)
 {
-    return (sensor_mgr.mgr_eventq);
+    return (sensor_mgr.mgr_workers[0].sw_evq);
 }
 
 void
 sensor_mgr_evq_set(struct os_eventq *evq)
 {
-    os_eventq_designate(&sensor_mgr.mgr_eventq, evq, NULL);
+    os_eventq_designate(&sensor_mgr.mgr_workers[0].sw_evq, evq, NULL);
 }
 
 static void
 sensor_mgr_init(void)
 {
+    struct sensor_worker *worker;
     struct os_timeval ostv;
     struct os_timezone ostz;
+    int i;
 
     memset(&sensor_mgr, 0, sizeof(sensor_mgr));
     TAILQ_INIT(&sensor_mgr.mgr_sensor_list);
 
-    sensor_mgr_evq_set(os_eventq_dflt_get());
+    for (i = 0; i < MYNEWT_VAL(SENSOR_MGR_WORKERS); i++) {
+        worker = &sensor_mgr.mgr_workers[i];
+        worker->sw_batch.sb_data = worker->sw_batch_data;
+        worker->sw_batch.sb_delta_us = worker->sw_batch_delta;
+    }
 
-    /**
-     * Initialize sensor polling callout and set it to fire on boot.
-     */
-    os_callout_init(&sensor_mgr.mgr_wakeup_callout, sensor_mgr_evq_get(),
-            sensor_mgr_wakeup_event, NULL);
-    os_callout_reset(&sensor_mgr.mgr_wakeup_callout, 0);
+    sensor_mgr_evq_set(os_eventq_dflt_get());
 
     /* Initialize sensor cputime update callout and set it to fire after an
      * hour, CPU time gets wrapped in 4295 seconds,
@@ -422,17 +573,9 @@ sensor_mgr_find_next_bytype(sensor_type_t type, struct sensor *prev_cursor)
 }
 
 static int
-sensor_mgr_match_bydevname(struct sensor *sensor, void *arg)
+sensor_mgr_match_bydev(struct sensor *sensor, void *arg)
 {
-    char *devname;
-
-    devname = (char *) arg;
-
-    if (!strcmp(sensor->s_dev->od_name, devname)) {
-        return (1);
-    }
-
-    return (0);
+    return (sensor->s_dev == (struct os_dev *) arg);
 }
 
 
@@ -448,7 +591,15 @@ sensor_mgr_match_bydevname(struct sensor *sensor, void *arg)
 struct sensor *
 sensor_mgr_find_next_bydevname(char *devname, struct sensor *prev_cursor)
 {
-    return (sensor_mgr_find_next(sensor_mgr_match_bydevname, devname,
+    struct os_dev *dev;
+
+    /* Resolve the name once, then compare device pointers. */
+    dev = os_dev_lookup(devname);
+    if (dev == NULL) {
+        return (NULL);
+    }
+
+    return (sensor_mgr_find_next(sensor_mgr_match_bydev, dev,
             prev_cursor));
 }
 
@@ -519,6 +670,9 @@ sensor_init(struct sensor *sensor, struct os_dev *dev)
     }
     sensor->s_dev = dev;
 
+    sensor->s_stream_ev.ev_cb = sensor_mgr_stream_event;
+    sensor->s_stream_ev.ev_arg = sensor;
+
     return (0);
 err:
     return (rc);
@@ -589,19 +743,322 @@ err:
     return (rc);
 }
 
+/**
+ * Number of sensor_val_t at the start of a sample of the given type, which
+ * sensor data reduction is applied to.  0 if samples of that type can't
+ * be reduced.
+ */
+static int
+sensor_val_count(sensor_type_t type)
+{
+    switch (type) {
+    case SENSOR_TYPE_ACCELEROMETER:
+    case SENSOR_TYPE_LINEAR_ACCEL:
+    case SENSOR_TYPE_GRAVITY:
+    case SENSOR_TYPE_MAGNETIC_FIELD:
+    case SENSOR_TYPE_EULER:
+        return 3;
+    case SENSOR_TYPE_ROTATION_VECTOR:
+        return 4;
+    case SENSOR_TYPE_TEMPERATURE:
+    case SENSOR_TYPE_AMBIENT_TEMPERATURE:
+    case SENSOR_TYPE_PRESSURE:
+    case SENSOR_TYPE_RELATIVE_HUMIDITY:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Register data reduction for one type of data of a sensor.  Listeners of
+ * the sensor then only get the reduced samples of that type.
+ *
+ * @param The sensor to reduce data of
+ * @param The reduction to apply, see struct sensor_reduce
+ *
+ * @return 0 on success, SYS_EINVAL if the type can't be reduced, the
+ *         window is too large, or the type is already being reduced;
+ *         other non-zero error code on failure.
+ */
+int
+sensor_register_reduce(struct sensor *sensor, struct sensor_reduce *reduce)
+{
+    struct sensor_reduce *cursor;
+    int rc;
+
+    if (sensor_val_count(reduce->sr_type) == 0 ||
+            reduce->sr_window > MYNEWT_VAL(SENSOR_REDUCE_WINDOW_MAX)) {
+        rc = SYS_EINVAL;
+        goto err;
+    }
+
+    reduce->sr_count = 0;
+    reduce->sr_head = 0;
+    reduce->sr_fill = 0;
+    reduce->sr_has_last = 0;
+
+    rc = sensor_lock(sensor);
+    if (rc != 0) {
+        goto err;
+    }
+
+    SLIST_FOREACH(cursor, &sensor->s_reduce_list, sr_next) {
+        if (cursor->sr_type == reduce->sr_type) {
+            rc = SYS_EINVAL;
+            goto err_unlock;
+        }
+    }
+
+    SLIST_INSERT_HEAD(&sensor->s_reduce_list, reduce, sr_next);
+
+err_unlock:
+    sensor_unlock(sensor);
+err:
+    return (rc);
+}
+
+/**
+ * Stop reducing data of a sensor.
+ *
+ * @param The sensor to stop reducing data of
+ * @param The reduction registered with sensor_register_reduce()
+ *
+ * @return 0 on success, non-zero error code on failure.
+ */
+int
+sensor_unregister_reduce(struct sensor *sensor, struct sensor_reduce *reduce)
+{
+    int rc;
+
+    rc = sensor_lock(sensor);
+    if (rc != 0) {
+        goto err;
+    }
+
+    SLIST_REMOVE(&sensor->s_reduce_list, reduce, sensor_reduce, sr_next);
+
+    sensor_unlock(sensor);
+
+    return (0);
+err:
+    return (rc);
+}
+
+/**
+ * Size of a sample of sensor type "type", 0 if not known.
+ */
+static uint16_t
+sensor_sample_size(sensor_type_t type)
+{
+    switch (type) {
+    case SENSOR_TYPE_ACCELEROMETER:
+    case SENSOR_TYPE_LINEAR_ACCEL:
+    case SENSOR_TYPE_GRAVITY:
+        return sizeof(struct sensor_accel_data);
+    case SENSOR_TYPE_MAGNETIC_FIELD:
+        return sizeof(struct sensor_mag_data);
+    case SENSOR_TYPE_LIGHT:
+        return sizeof(struct sensor_light_data);
+    case SENSOR_TYPE_TEMPERATURE:
+    case SENSOR_TYPE_AMBIENT_TEMPERATURE:
+        return sizeof(struct sensor_temp_data);
+    case SENSOR_TYPE_PRESSURE:
+        return sizeof(struct sensor_press_data);
+    case SENSOR_TYPE_RELATIVE_HUMIDITY:
+        return sizeof(struct sensor_humid_data);
+    case SENSOR_TYPE_ROTATION_VECTOR:
+        return sizeof(struct sensor_quat_data);
+    case SENSOR_TYPE_EULER:
+        return sizeof(struct sensor_euler_data);
+    case SENSOR_TYPE_COLOR:
+        return sizeof(struct sensor_color_data);
+    default:
+        return 0;
+    }
+}
+
+static int
+sensor_has_batch_listener(struct sensor *sensor)
+{
+    struct sensor_listener *listener;
+
+    SLIST_FOREACH(listener, &sensor->s_listener_list, sl_next) {
+        if (listener->sl_batch_func != NULL) {
+            return (1);
+        }
+    }
+    return (0);
+}
+
+/**
+ * Hand a batch of samples to the batch listeners of the sensor, and empty
+ * the batch.
+ */
+static void
+sensor_batch_deliver(struct sensor *sensor, struct sensor_batch *batch)
+{
+    struct sensor_listener *listener;
+
+    if (batch->sb_count == 0) {
+        return;
+    }
+
+    SLIST_FOREACH(listener, &sensor->s_listener_list, sl_next) {
+        if (listener->sl_batch_func != NULL &&
+                (listener->sl_sensor_type & batch->sb_type) != 0) {
+            listener->sl_batch_func(sensor, listener->sl_arg, batch);
+        }
+    }
+    batch->sb_count = 0;
+}
+
+/**
+ * Add a sample to the batch being collected, delivering the batch first if
+ * it is full.
+ */
+static void
+sensor_batch_add(struct sensor *sensor, struct sensor_batch *batch,
+        void *data)
+{
+    if (batch->sb_count == MYNEWT_VAL(SENSOR_BATCH_MAX)) {
+        sensor_batch_deliver(sensor, batch);
+    }
+    if (batch->sb_count == 0) {
+        batch->sb_ts = sensor->s_sts;
+    }
+
+    memcpy(SENSOR_BATCH_SAMPLE(batch, batch->sb_count), data,
+           batch->sb_sample_size);
+    batch->sb_delta_us[batch->sb_count] = os_cputime_ticks_to_usecs(
+        os_cputime_get32() - batch->sb_ts.st_cputime);
+    batch->sb_count++;
+}
+
+/**
+ * Pass a sample through the data reduction registered for its type, if
+ * any.
+ *
+ * @return The sample to deliver to listeners, "data" itself or the reduced
+ *         sample in "out"; NULL if nothing is to be delivered.
+ */
+static void *
+sensor_reduce_sample(struct sensor *sensor, sensor_type_t type, void *data,
+        union sensor_sample *out)
+{
+    struct sensor_reduce *sr;
+    sensor_val_t avg[4];
+    sensor_val_t diff;
+#if MYNEWT_VAL(SENSOR_FIXED_POINT)
+    int64_t sum;
+#else
+    float sum;
+#endif
+    int window;
+    int deliver;
+    int n;
+    int i;
+    int j;
+
+    SLIST_FOREACH(sr, &sensor->s_reduce_list, sr_next) {
+        if (sr->sr_type == type) {
+            break;
+        }
+    }
+    if (!sr) {
+        return (data);
+    }
+
+    n = sensor_val_count(type);
+    window = sr->sr_window ? sr->sr_window : 1;
+
+    /* Samples are packed, copy rather than access the values in place */
+    memcpy(sr->sr_hist[sr->sr_head], data, n * sizeof(sensor_val_t));
+    sr->sr_head = (sr->sr_head + 1) % window;
+    if (sr->sr_fill < window) {
+        sr->sr_fill++;
+    }
+
+    for (i = 0; i < n; i++) {
+        sum = 0;
+        for (j = 0; j < sr->sr_fill; j++) {
+            sum += sr->sr_hist[j][i];
+        }
+        avg[i] = sum / sr->sr_fill;
+    }
+
+    if (++sr->sr_count < sr->sr_decimate) {
+        return (NULL);
+    }
+    sr->sr_count = 0;
+
+    if (sr->sr_threshold > 0 && sr->sr_has_last) {
+        deliver = 0;
+        for (i = 0; i < n; i++) {
+            diff = avg[i] - sr->sr_last[i];
+            if (diff >= sr->sr_threshold || -diff >= sr->sr_threshold) {
+                deliver = 1;
+                break;
+            }
+        }
+        if (!deliver) {
+            return (NULL);
+        }
+    }
+    memcpy(sr->sr_last, avg, sizeof(avg));
+    sr->sr_has_last = 1;
+
+    /* Keep the validity flags of the latest sample */
+    memcpy(out, data, sensor_sample_size(type));
+    memcpy(out, avg, n * sizeof(sensor_val_t));
+
+    return (out);
+}
+
 static int
 sensor_read_data_func(struct sensor *sensor, void *arg, void *data)
 {
     struct sensor_listener *listener;
     struct sensor_read_ctx *ctx;
+    struct sensor_batch one;
+    union sensor_sample reduced;
+    void *ldata;
+    uint32_t delta;
+
+    ctx = (struct sensor_read_ctx *) arg;
+
+    /* Listeners get the sample after data reduction, if it survives it */
+    ldata = data;
+    if (ctx->type != SENSOR_TYPE_NONE) {
+        ldata = sensor_reduce_sample(sensor, ctx->type, data, &reduced);
+        if (!ldata) {
+            goto user;
+        }
+    }
+
+    if (ctx->batch != NULL) {
+        sensor_batch_add(sensor, ctx->batch, ldata);
+    } else if (ctx->type != SENSOR_TYPE_NONE) {
+        /* Not batching, batch listeners get each sample on its own. */
+        delta = 0;
+        one.sb_type = ctx->type;
+        one.sb_count = 1;
+        one.sb_sample_size = sensor_sample_size(ctx->type);
+        one.sb_ts = sensor->s_sts;
+        one.sb_data = ldata;
+        one.sb_delta_us = &delta;
+        sensor_batch_deliver(sensor, &one);
+    }
 
     /* Notify all listeners first */
     SLIST_FOREACH(listener, &sensor->s_listener_list, sl_next) {
-        listener->sl_func(sensor, listener->sl_arg, data);
+        if (listener->sl_func != NULL) {
+            listener->sl_func(sensor, listener->sl_arg, ldata);
+        }
     }
 
+user:
     /* Call data function */
-    ctx = (struct sensor_read_ctx *) arg;
     if (ctx->user_func != NULL) {
         return (ctx->user_func(sensor, ctx->user_arg, data));
     } else {
@@ -614,6 +1071,10 @@ sensor_up_timestamp(struct sensor *sensor)
 {
     uint32_t curr_ts_ticks;
     uint32_t ts;
+    os_sr_t sr;
+
+    /* Sensors on different workers share the base timestamp */
+    OS_ENTER_CRITICAL(sr);
 
     curr_ts_ticks = os_cputime_get32();
 
@@ -633,6 +1094,73 @@ sensor_up_timestamp(struct sensor *sensor)
         (sensor_base_ts.st_ostv.tv_usec + ts)%1000000;
     sensor->s_sts.st_ostv.tv_usec = sensor_base_ts.st_ostv.tv_usec;
 
+    OS_EXIT_CRITICAL(sr);
+}
+
+/**
+ * Read sensor data, collecting samples into "batch" for batch listeners.
+ * If there are batch listeners or data reduction, each sensor type is read
+ * separately, so that every batch holds samples of one type only and each
+ * sample is reduced according to its type.
+ */
+static int
+sensor_read_batch(struct sensor *sensor, sensor_type_t type,
+        sensor_data_func_t data_func, void *arg, uint32_t timeout,
+        struct sensor_batch *batch)
+{
+    struct sensor_read_ctx src;
+    sensor_type_t types;
+    int rc;
+
+    rc = sensor_lock(sensor);
+    if (rc != 0) {
+        goto done;
+    }
+
+    src.user_func = data_func;
+    src.user_arg = arg;
+    src.batch = NULL;
+
+    sensor_up_timestamp(sensor);
+
+    if (!sensor_has_batch_listener(sensor) &&
+            SLIST_EMPTY(&sensor->s_reduce_list)) {
+        src.type = SENSOR_TYPE_NONE;
+        rc = sensor->s_funcs->sd_read(sensor, type, sensor_read_data_func,
+                &src, timeout);
+        goto unlock;
+    }
+
+    types = type & sensor->s_types;
+    while (types != 0) {
+        src.type = types & -types;
+        types &= ~src.type;
+
+        if (batch != NULL) {
+            batch->sb_type = src.type;
+            batch->sb_count = 0;
+            batch->sb_sample_size = sensor_sample_size(src.type);
+            if (batch->sb_sample_size != 0) {
+                src.batch = batch;
+            }
+        }
+
+        rc = sensor->s_funcs->sd_read(sensor, src.type, sensor_read_data_func,
+                &src, timeout);
+
+        if (src.batch != NULL) {
+            sensor_batch_deliver(sensor, src.batch);
+            src.batch = NULL;
+        }
+        if (rc != 0) {
+            break;
+        }
+    }
+
+unlock:
+    sensor_unlock(sensor);
+done:
+    return (rc);
 }
 
 /**
@@ -651,28 +1179,97 @@ int
 sensor_read(struct sensor *sensor, sensor_type_t type,
         sensor_data_func_t data_func, void *arg, uint32_t timeout)
 {
-    struct sensor_read_ctx src;
+    return (sensor_read_batch(sensor, type, data_func, arg, timeout, NULL));
+}
+
+/**
+ * Stop polling the sensor, and instead have the driver buffer samples in
+ * the sensor's FIFO and interrupt when "watermark" samples are available.
+ * Listeners are then called with each of the buffered samples in turn.
+ *
+ * @param The sensor to stream data from
+ * @param The type(s) of sensor data to stream
+ * @param Number of samples to buffer before listeners are called
+ *
+ * @return 0 on success, non-zero error code on failure.
+ */
+int
+sensor_stream_start(struct sensor *sensor, sensor_type_t type,
+        uint16_t watermark)
+{
     int rc;
 
-    rc = sensor_lock(sensor);
+    if (!sensor->s_funcs->sd_stream || type == SENSOR_TYPE_NONE ||
+            (type & ~sensor->s_types) != 0) {
+        rc = SYS_EINVAL;
+        goto err;
+    }
+
+    rc = sensor_mgr_lock();
     if (rc != 0) {
-        goto done;
+        goto err;
     }
 
-    src.user_func = data_func;
-    src.user_arg = arg;
+    rc = sensor_lock(sensor);
+    if (rc != 0) {
+        goto err_mgr;
+    }
 
-    sensor_up_timestamp(sensor);
+    rc = sensor->s_funcs->sd_stream(sensor, type, watermark);
+    if (rc == 0) {
+        sensor->s_stream_types = type;
 
-    rc = sensor->s_funcs->sd_read(sensor, type, sensor_read_data_func, &src,
-            timeout);
-    if (rc) {
-        goto done;
+        /* Streaming sensors are not polled. */
+        if (sensor->s_worker) {
+            os_callout_stop(&sensor->s_poll_callout);
+        }
     }
 
     sensor_unlock(sensor);
-
-done:
+err_mgr:
+    sensor_mgr_unlock();
+err:
     return (rc);
 }
 
+/**
+ * Stop streaming data from the sensor, and return to polling it.
+ *
+ * @param The sensor to stop streaming from
+ *
+ * @return 0 on success, non-zero error code on failure.
+ */
+int
+sensor_stream_stop(struct sensor *sensor)
+{
+    int rc;
+
+    if (sensor->s_stream_types == SENSOR_TYPE_NONE) {
+        return (0);
+    }
+
+    rc = sensor_mgr_lock();
+    if (rc != 0) {
+        goto err;
+    }
+
+    rc = sensor_lock(sensor);
+    if (rc != 0) {
+        goto err_mgr;
+    }
+
+    rc = sensor->s_funcs->sd_stream(sensor, SENSOR_TYPE_NONE, 0);
+    if (rc == 0) {
+        sensor->s_stream_types = SENSOR_TYPE_NONE;
+        if (sensor->s_worker) {
+            os_eventq_remove(sensor->s_worker->sw_evq, &sensor->s_stream_ev);
+            sensor_poll_start(sensor);
+        }
+    }
+
+    sensor_unlock(sensor);
+err_mgr:
+    sensor_mgr_unlock();
+err:
+    return (rc);
+}
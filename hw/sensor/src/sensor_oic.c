@@ -66,19 +66,19 @@ sensor_oic_encode(struct sensor* sensor, void *arg, void *databuf)
 
             if (((struct sensor_accel_data *)(databuf))->sad_x_is_valid) {
                 oc_rep_set_double(root, x,
-                    ((struct sensor_accel_data *)(databuf))->sad_x);
+                    SENSOR_VAL_TO_FLOAT(((struct sensor_accel_data *)(databuf))->sad_x));
             } else {
                 goto err;
             }
             if (((struct sensor_accel_data *)(databuf))->sad_y_is_valid) {
                 oc_rep_set_double(root, y,
-                    ((struct sensor_accel_data *)(databuf))->sad_y);
+                    SENSOR_VAL_TO_FLOAT(((struct sensor_accel_data *)(databuf))->sad_y));
             } else {
                 goto err;
             }
             if (((struct sensor_accel_data *)(databuf))->sad_z_is_valid) {
                 oc_rep_set_double(root, z,
-                    ((struct sensor_accel_data *)(databuf))->sad_z);
+                    SENSOR_VAL_TO_FLOAT(((struct sensor_accel_data *)(databuf))->sad_z));
             } else {
                 goto err;
             }
@@ -88,19 +88,19 @@ sensor_oic_encode(struct sensor* sensor, void *arg, void *databuf)
         case SENSOR_TYPE_MAGNETIC_FIELD:
             if (((struct sensor_mag_data *)(databuf))->smd_x_is_valid) {
                 oc_rep_set_double(root, x,
-                    ((struct sensor_mag_data *)(databuf))->smd_x);
+                    SENSOR_VAL_TO_FLOAT(((struct sensor_mag_data *)(databuf))->smd_x));
             } else {
                 goto err;
             }
             if (((struct sensor_mag_data *)(databuf))->smd_y_is_valid) {
                 oc_rep_set_double(root, y,
-                    ((struct sensor_mag_data *)(databuf))->smd_y);
+                    SENSOR_VAL_TO_FLOAT(((struct sensor_mag_data *)(databuf))->smd_y));
             } else {
                 goto err;
             }
             if (((struct sensor_mag_data *)(databuf))->smd_z_is_valid) {
                 oc_rep_set_double(root, z,
-                    ((struct sensor_mag_data *)(databuf))->smd_z);
+                    SENSOR_VAL_TO_FLOAT(((struct sensor_mag_data *)(databuf))->smd_z));
             } else {
                 goto err;
             }
@@ -131,7 +131,7 @@ sensor_oic_encode(struct sensor* sensor, void *arg, void *databuf)
         case SENSOR_TYPE_TEMPERATURE:
             if (((struct sensor_temp_data *)(databuf))->std_temp_is_valid) {
                 oc_rep_set_double(root, temp,
-                    ((struct sensor_temp_data *)(databuf))->std_temp);
+                    SENSOR_VAL_TO_FLOAT(((struct sensor_temp_data *)(databuf))->std_temp));
             }
             break;
 
@@ -139,7 +139,7 @@ sensor_oic_encode(struct sensor* sensor, void *arg, void *databuf)
         case SENSOR_TYPE_AMBIENT_TEMPERATURE:
             if (((struct sensor_temp_data *)(databuf))->std_temp_is_valid) {
                 oc_rep_set_double(root, temp,
-                    ((struct sensor_temp_data *)(databuf))->std_temp);
+                    SENSOR_VAL_TO_FLOAT(((struct sensor_temp_data *)(databuf))->std_temp));
             }
             break;
 
@@ -147,7 +147,7 @@ sensor_oic_encode(struct sensor* sensor, void *arg, void *databuf)
         case SENSOR_TYPE_PRESSURE:
             if (((struct sensor_press_data *)(databuf))->spd_press_is_valid) {
                 oc_rep_set_double(root, press,
-                    ((struct sensor_press_data *)(databuf))->spd_press);
+                    SENSOR_VAL_TO_FLOAT(((struct sensor_press_data *)(databuf))->spd_press));
             }
             break;
 #if 0
@@ -158,7 +158,7 @@ sensor_oic_encode(struct sensor* sensor, void *arg, void *databuf)
         case SENSOR_TYPE_RELATIVE_HUMIDITY:
             if (((struct sensor_humid_data *)(databuf))->shd_humid_is_valid) {
                 oc_rep_set_double(root, humid,
-                    ((struct sensor_humid_data *)(databuf))->shd_humid);
+                    SENSOR_VAL_TO_FLOAT(((struct sensor_humid_data *)(databuf))->shd_humid));
             }
             break;
 
@@ -166,25 +166,25 @@ sensor_oic_encode(struct sensor* sensor, void *arg, void *databuf)
         case SENSOR_TYPE_ROTATION_VECTOR:
             if (((struct sensor_quat_data *)(databuf))->sqd_x_is_valid) {
                 oc_rep_set_double(root, x,
-                    ((struct sensor_quat_data *)(databuf))->sqd_x);
+                    SENSOR_VAL_TO_FLOAT(((struct sensor_quat_data *)(databuf))->sqd_x));
             } else {
                 goto err;
             }
             if (((struct sensor_quat_data *)(databuf))->sqd_y_is_valid) {
                 oc_rep_set_double(root, y,
-                    ((struct sensor_quat_data *)(databuf))->sqd_y);
+                    SENSOR_VAL_TO_FLOAT(((struct sensor_quat_data *)(databuf))->sqd_y));
             } else {
                 goto err;
             }
             if (((struct sensor_quat_data *)(databuf))->sqd_z_is_valid) {
                 oc_rep_set_double(root, z,
-                    ((struct sensor_quat_data *)(databuf))->sqd_z);
+                    SENSOR_VAL_TO_FLOAT(((struct sensor_quat_data *)(databuf))->sqd_z));
             } else {
                 goto err;
             }
             if (((struct sensor_quat_data *)(databuf))->sqd_w_is_valid) {
                 oc_rep_set_double(root, w,
-                    ((struct sensor_quat_data *)(databuf))->sqd_w);
+                    SENSOR_VAL_TO_FLOAT(((struct sensor_quat_data *)(databuf))->sqd_w));
             } else {
                 goto err;
             }
@@ -200,19 +200,19 @@ sensor_oic_encode(struct sensor* sensor, void *arg, void *databuf)
         case SENSOR_TYPE_EULER:
             if (((struct sensor_euler_data *)(databuf))->sed_h_is_valid) {
                 oc_rep_set_double(root, h,
-                    ((struct sensor_euler_data *)(databuf))->sed_h);
+                    SENSOR_VAL_TO_FLOAT(((struct sensor_euler_data *)(databuf))->sed_h));
             } else {
                 goto err;
             }
             if (((struct sensor_euler_data *)(databuf))->sed_r_is_valid) {
                 oc_rep_set_double(root, r,
-                    ((struct sensor_euler_data *)(databuf))->sed_r);
+                    SENSOR_VAL_TO_FLOAT(((struct sensor_euler_data *)(databuf))->sed_r));
             } else {
                 goto err;
             }
             if (((struct sensor_euler_data *)(databuf))->sed_p_is_valid) {
                 oc_rep_set_double(root, p,
-                    ((struct sensor_euler_data *)(databuf))->sed_p);
+                    SENSOR_VAL_TO_FLOAT(((struct sensor_euler_data *)(databuf))->sed_p));
             } else {
                 goto err;
             }
@@ -270,7 +270,7 @@ sensor_oic_encode(struct sensor* sensor, void *arg, void *databuf)
             }
             if (((struct sensor_color_data *)(databuf))->scd_cratio_is_valid) {
                 oc_rep_set_double(root, cratio,
-                    ((struct sensor_color_data *)(databuf))->scd_cratio);
+                    SENSOR_VAL_TO_FLOAT(((struct sensor_color_data *)(databuf))->scd_cratio));
             } else {
                 goto err;
             }
@@ -468,9 +468,150 @@ err:
     return SYS_EINVAL;
 }
 
+#if MYNEWT_VAL(SENSOR_OIC_OBS_CNT) > 0
+/*
+ * Latest sample of one sensor type, kept by a listener which stays
+ * registered.  For polled sensors, GETs are served from it and observers
+ * are notified when a new sample arrives, so the bus is read at the poll
+ * rate rather than at the rate clients ask.
+ */
+union sensor_oic_data {
+    struct sensor_accel_data accel;
+    struct sensor_mag_data mag;
+    struct sensor_light_data light;
+    struct sensor_temp_data temp;
+    struct sensor_press_data press;
+    struct sensor_humid_data humid;
+    struct sensor_quat_data quat;
+    struct sensor_euler_data euler;
+    struct sensor_color_data color;
+};
+
+struct sensor_oic_obs {
+    oc_resource_t *soo_res;
+    struct sensor_listener soo_listener;
+    struct os_event soo_ev;
+    uint8_t soo_valid;
+    union sensor_oic_data soo_data;
+};
+
+static struct sensor_oic_obs sensor_oic_obs[MYNEWT_VAL(SENSOR_OIC_OBS_CNT)];
+static int sensor_oic_obs_cnt;
+
+static int
+sensor_oic_data_size(sensor_type_t type)
+{
+    switch (type) {
+    case SENSOR_TYPE_GYROSCOPE:
+    case SENSOR_TYPE_ACCELEROMETER:
+    case SENSOR_TYPE_LINEAR_ACCEL:
+    case SENSOR_TYPE_GRAVITY:
+        return sizeof(struct sensor_accel_data);
+    case SENSOR_TYPE_MAGNETIC_FIELD:
+        return sizeof(struct sensor_mag_data);
+    case SENSOR_TYPE_LIGHT:
+        return sizeof(struct sensor_light_data);
+    case SENSOR_TYPE_TEMPERATURE:
+    case SENSOR_TYPE_AMBIENT_TEMPERATURE:
+        return sizeof(struct sensor_temp_data);
+    case SENSOR_TYPE_PRESSURE:
+        return sizeof(struct sensor_press_data);
+    case SENSOR_TYPE_RELATIVE_HUMIDITY:
+        return sizeof(struct sensor_humid_data);
+    case SENSOR_TYPE_ROTATION_VECTOR:
+        return sizeof(struct sensor_quat_data);
+    case SENSOR_TYPE_EULER:
+        return sizeof(struct sensor_euler_data);
+    case SENSOR_TYPE_COLOR:
+        return sizeof(struct sensor_color_data);
+    default:
+        return 0;
+    }
+}
+
+static struct sensor_oic_obs *
+sensor_oic_obs_find(oc_resource_t *res)
+{
+    int i;
+
+    for (i = 0; i < sensor_oic_obs_cnt; i++) {
+        if (sensor_oic_obs[i].soo_res == res) {
+            return &sensor_oic_obs[i];
+        }
+    }
+    return NULL;
+}
+
+static void
+sensor_oic_obs_notify(struct os_event *ev)
+{
+    struct sensor_oic_obs *soo;
+
+    soo = ev->ev_arg;
+    oc_notify_observers(soo->soo_res);
+}
+
+/*
+ * Runs in the context of whoever read the sensor.  Notification is done
+ * from the OIC task; samples arriving before it has run are coalesced.
+ */
+static int
+sensor_oic_obs_data(struct sensor *sensor, void *arg, void *databuf)
+{
+    struct sensor_oic_obs *soo;
+    os_sr_t sr;
+    int size;
+
+    soo = arg;
+    size = sensor_oic_data_size(soo->soo_listener.sl_sensor_type);
+    if (!size) {
+        return SYS_EINVAL;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    memcpy(&soo->soo_data, databuf, size);
+    soo->soo_valid = 1;
+    OS_EXIT_CRITICAL(sr);
+
+    /* Unpolled sensors are read by the periodic observe GET itself. */
+    if (sensor->s_poll_rate) {
+        os_eventq_put(oc_evq_get(), &soo->soo_ev);
+    }
+    return 0;
+}
+
+static int
+sensor_oic_obs_add(struct sensor *sensor, oc_resource_t *res,
+                   sensor_type_t type)
+{
+    struct sensor_oic_obs *soo;
+
+    if (sensor_oic_obs_cnt >= MYNEWT_VAL(SENSOR_OIC_OBS_CNT)) {
+        return SYS_ENOMEM;
+    }
+    soo = &sensor_oic_obs[sensor_oic_obs_cnt];
+    soo->soo_res = res;
+    soo->soo_ev.ev_cb = sensor_oic_obs_notify;
+    soo->soo_ev.ev_arg = soo;
+    soo->soo_listener.sl_sensor_type = type;
+    soo->soo_listener.sl_func = sensor_oic_obs_data;
+    soo->soo_listener.sl_arg = soo;
+    if (sensor_register_listener(sensor, &soo->soo_listener)) {
+        return SYS_EINVAL;
+    }
+    sensor_oic_obs_cnt++;
+    return 0;
+}
+#endif
+
 static void
 sensor_oic_get_data(oc_request_t *request, oc_interface_mask_t interface)
 {
+#if MYNEWT_VAL(SENSOR_OIC_OBS_CNT) > 0
+    struct sensor_oic_obs *soo;
+    union sensor_oic_data data;
+    os_sr_t sr;
+#endif
     int rc;
     struct sensor *sensor;
     struct sensor_listener listener;
@@ -517,6 +658,22 @@ sensor_oic_get_data(oc_request_t *request, oc_interface_mask_t interface)
             goto err;
         }
 
+#if MYNEWT_VAL(SENSOR_OIC_OBS_CNT) > 0
+        /* Serve polled sensors from the last sample. */
+        soo = sensor_oic_obs_find(request->resource);
+        if (soo && soo->soo_valid && sensor->s_poll_rate) {
+            OS_ENTER_CRITICAL(sr);
+            memcpy(&data, &soo->soo_data, sizeof(data));
+            OS_EXIT_CRITICAL(sr);
+
+            rc = sensor_oic_encode(sensor, &type, &data);
+            oc_rep_end_root_object();
+            oc_send_response(request,
+                             rc ? OC_STATUS_NOT_FOUND : OC_STATUS_OK);
+            return;
+        }
+#endif
+
         listener.sl_sensor_type = type;
         listener.sl_func = sensor_oic_encode;
         listener.sl_arg = (void *)&listener.sl_sensor_type;
@@ -598,7 +755,21 @@ sensor_oic_init(void)
                 oc_resource_set_default_interface(res, OC_IF_R);
 
                 oc_resource_set_discoverable(res);
+#if MYNEWT_VAL(SENSOR_OIC_OBS_CNT) > 0
+                /*
+                 * Polled sensors push samples to observers; the others
+                 * are read when the periodic observe timer fires.
+                 */
+                if (sensor_oic_obs_add(sensor, res, 1 << i) == 0 &&
+                  sensor->s_poll_rate) {
+                    oc_resource_set_observable(res);
+                } else {
+                    oc_resource_set_periodic_observable(res,
+                      MYNEWT_VAL(SENSOR_OIC_OBS_RATE));
+                }
+#else
                 oc_resource_set_periodic_observable(res, MYNEWT_VAL(SENSOR_OIC_OBS_RATE));
+#endif
                 oc_resource_set_request_handler(res, OC_GET,
                                                 sensor_oic_get_data);
                 oc_add_resource(res);
@@ -253,13 +253,19 @@ sensor_shell_read_listener(struct sensor *sensor, void *arg, void *data)
 
         sad = (struct sensor_accel_data *) data;
         if (sad->sad_x_is_valid) {
-            console_printf("x = %s ", sensor_ftostr(sad->sad_x, tmpstr, 13));
+            console_printf("x = %s ",
+                           sensor_ftostr(SENSOR_VAL_TO_FLOAT(sad->sad_x),
+                                         tmpstr, 13));
         }
         if (sad->sad_y_is_valid) {
-            console_printf("y = %s ", sensor_ftostr(sad->sad_y, tmpstr, 13));
+            console_printf("y = %s ",
+                           sensor_ftostr(SENSOR_VAL_TO_FLOAT(sad->sad_y),
+                                         tmpstr, 13));
         }
         if (sad->sad_z_is_valid) {
-            console_printf("z = %s", sensor_ftostr(sad->sad_z, tmpstr, 13));
+            console_printf("z = %s",
+                           sensor_ftostr(SENSOR_VAL_TO_FLOAT(sad->sad_z),
+                                         tmpstr, 13));
         }
         console_printf("\n");
     }
@@ -267,13 +273,19 @@ sensor_shell_read_listener(struct sensor *sensor, void *arg, void *data)
     if (ctx->type == SENSOR_TYPE_MAGNETIC_FIELD) {
         smd = (struct sensor_mag_data *) data;
         if (smd->smd_x_is_valid) {
-            console_printf("x = %s ", sensor_ftostr(smd->smd_x, tmpstr, 13));
+            console_printf("x = %s ",
+                           sensor_ftostr(SENSOR_VAL_TO_FLOAT(smd->smd_x),
+                                         tmpstr, 13));
         }
         if (smd->smd_y_is_valid) {
-            console_printf("y = %s ", sensor_ftostr(smd->smd_y, tmpstr, 13));
+            console_printf("y = %s ",
+                           sensor_ftostr(SENSOR_VAL_TO_FLOAT(smd->smd_y),
+                                         tmpstr, 13));
         }
         if (smd->smd_z_is_valid) {
-            console_printf("z = %s ", sensor_ftostr(smd->smd_z, tmpstr, 13));
+            console_printf("z = %s ",
+                           sensor_ftostr(SENSOR_VAL_TO_FLOAT(smd->smd_z),
+                                         tmpstr, 13));
         }
         console_printf("\n");
     }
@@ -297,7 +309,9 @@ sensor_shell_read_listener(struct sensor *sensor, void *arg, void *data)
 
         std = (struct sensor_temp_data *) data;
         if (std->std_temp_is_valid) {
-            console_printf("temperature = %s Deg C", sensor_ftostr(std->std_temp, tmpstr, 13));
+            console_printf("temperature = %s Deg C",
+                           sensor_ftostr(SENSOR_VAL_TO_FLOAT(std->std_temp),
+                                         tmpstr, 13));
         }
         console_printf("\n");
     }
@@ -305,13 +319,19 @@ sensor_shell_read_listener(struct sensor *sensor, void *arg, void *data)
     if (ctx->type == SENSOR_TYPE_EULER) {
         sed = (struct sensor_euler_data *) data;
         if (sed->sed_h_is_valid) {
-            console_printf("h = %s", sensor_ftostr(sed->sed_h, tmpstr, 13));
+            console_printf("h = %s",
+                           sensor_ftostr(SENSOR_VAL_TO_FLOAT(sed->sed_h),
+                                         tmpstr, 13));
         }
         if (sed->sed_r_is_valid) {
-            console_printf("r = %s", sensor_ftostr(sed->sed_r, tmpstr, 13));
+            console_printf("r = %s",
+                           sensor_ftostr(SENSOR_VAL_TO_FLOAT(sed->sed_r),
+                                         tmpstr, 13));
         }
         if (sed->sed_p_is_valid) {
-            console_printf("p = %s", sensor_ftostr(sed->sed_p, tmpstr, 13));
+            console_printf("p = %s",
+                           sensor_ftostr(SENSOR_VAL_TO_FLOAT(sed->sed_p),
+                                         tmpstr, 13));
         }
         console_printf("\n");
     }
@@ -319,16 +339,24 @@ sensor_shell_read_listener(struct sensor *sensor, void *arg, void *data)
     if (ctx->type == SENSOR_TYPE_ROTATION_VECTOR) {
         sqd = (struct sensor_quat_data *) data;
         if (sqd->sqd_x_is_valid) {
-            console_printf("x = %s ", sensor_ftostr(sqd->sqd_x, tmpstr, 13));
+            console_printf("x = %s ",
+                           sensor_ftostr(SENSOR_VAL_TO_FLOAT(sqd->sqd_x),
+                                         tmpstr, 13));
         }
         if (sqd->sqd_y_is_valid) {
-            console_printf("y = %s ", sensor_ftostr(sqd->sqd_y, tmpstr, 13));
+            console_printf("y = %s ",
+                           sensor_ftostr(SENSOR_VAL_TO_FLOAT(sqd->sqd_y),
+                                         tmpstr, 13));
         }
         if (sqd->sqd_z_is_valid) {
-            console_printf("z = %s ", sensor_ftostr(sqd->sqd_z, tmpstr, 13));
+            console_printf("z = %s ",
+                           sensor_ftostr(SENSOR_VAL_TO_FLOAT(sqd->sqd_z),
+                                         tmpstr, 13));
         }
         if (sqd->sqd_w_is_valid) {
-            console_printf("w = %s ", sensor_ftostr(sqd->sqd_w, tmpstr, 13));
+            console_printf("w = %s ",
+                           sensor_ftostr(SENSOR_VAL_TO_FLOAT(sqd->sqd_w),
+                                         tmpstr, 13));
         }
         console_printf("\n");
     }
@@ -366,7 +394,9 @@ sensor_shell_read_listener(struct sensor *sensor, void *arg, void *data)
             console_printf(scd->scd_is_sat ? "is saturated, " : "not saturated, ");
         }
         if (scd->scd_cratio_is_valid) {
-            console_printf("cRatio = %s, ", sensor_ftostr(scd->scd_cratio, tmpstr, 13));
+            console_printf("cRatio = %s, ",
+                           sensor_ftostr(SENSOR_VAL_TO_FLOAT(scd->scd_cratio),
+                                         tmpstr, 13));
         }
         if (scd->scd_maxlux_is_valid) {
             console_printf("max lux = %u, ", scd->scd_maxlux);
@@ -379,7 +409,8 @@ sensor_shell_read_listener(struct sensor *sensor, void *arg, void *data)
         spd = (struct sensor_press_data *) data;
         if (spd->spd_press_is_valid) {
             console_printf("pressure = %s Pa",
-                           sensor_ftostr(spd->spd_press, tmpstr, 13));
+                           sensor_ftostr(SENSOR_VAL_TO_FLOAT(spd->spd_press),
+                                         tmpstr, 13));
         }
         console_printf("\n");
     }
@@ -388,7 +419,8 @@ sensor_shell_read_listener(struct sensor *sensor, void *arg, void *data)
         shd = (struct sensor_humid_data *) data;
         if (shd->shd_humid_is_valid) {
             console_printf("relative humidity = %s%%rh",
-                           sensor_ftostr(shd->shd_humid, tmpstr, 13));
+                           sensor_ftostr(SENSOR_VAL_TO_FLOAT(shd->shd_humid),
+                                         tmpstr, 13));
         }
         console_printf("\n");
     }
@@ -20,6 +20,7 @@
 #ifndef _OS_ARCH_SIM_H
 #define _OS_ARCH_SIM_H
 
+#include "syscfg/syscfg.h"
 #include <mcu/mcu_sim.h>
 
 #ifdef __cplusplus
@@ -75,6 +76,11 @@ os_error_t os_arch_os_init(void);
 void os_arch_os_stop(void);
 os_error_t os_arch_os_start(void);
 
+#if MYNEWT_VAL(MCU_NATIVE_VIRTUAL_TIME)
+void os_arch_sim_cycles_add(uint32_t cycles);
+uint64_t os_arch_sim_cycles(void);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -109,6 +109,7 @@ void os_init_idle_task(void);
 #include "os/os_sem.h"
 #include "os/os_task.h"
 #include "os/os_time.h"
+#include "os/os_trace.h"
 
 #ifdef __cplusplus
 }
@@ -49,10 +49,24 @@ extern "C" {
 #define OS_CPUTIME_FREQ_32768
 #endif
 
+/*
+ * Reciprocal of a 32-bit divisor, see os_cputime_recip_init().  Dividing by
+ * it costs a 32x32->64 multiply, an add and two shifts; on cores without a
+ * hardware divider (Cortex-M0) that is much cheaper than a division.
+ */
+struct os_cputime_recip
+{
+    uint32_t m;
+    uint8_t sh1;
+    uint8_t sh2;
+};
+
 /* CPUTIME data. */
 struct os_cputime_data
 {
     uint32_t ticks_per_usec;    /* number of ticks per usec */
+    struct os_cputime_recip ticks_per_usec_recip;
+    struct os_cputime_recip nsecs_per_usec_recip;
 };
 extern struct os_cputime_data g_cputime;
 
@@ -75,6 +89,32 @@ extern struct os_cputime_data g_cputime;
  */
 int os_cputime_init(uint32_t clock_freq);
 
+/**
+ * Computes the reciprocal of a divisor for os_cputime_recip_div().
+ *
+ * @param r The reciprocal to fill in
+ * @param d The divisor; must be non-zero
+ */
+void os_cputime_recip_init(struct os_cputime_recip *r, uint32_t d);
+
+/**
+ * Divides by multiplying with a reciprocal.  The result is exactly x / d
+ * (rounded down) for every 32-bit x, d being the divisor 'r' was made from.
+ *
+ * @param r The reciprocal of the divisor
+ * @param x The dividend
+ *
+ * @return uint32_t x / d
+ */
+static inline uint32_t
+os_cputime_recip_div(const struct os_cputime_recip *r, uint32_t x)
+{
+    uint32_t t;
+
+    t = (uint32_t)(((uint64_t)x * r->m) >> 32);
+    return (t + ((x - t) >> r->sh1)) >> r->sh2;
+}
+
 /**
  * os cputime get32
  *
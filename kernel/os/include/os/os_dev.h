@@ -38,6 +38,11 @@ struct os_dev;
 #define OS_DEV_INIT_PRIMARY   (1)
 #define OS_DEV_INIT_SECONDARY (2)
 #define OS_DEV_INIT_KERNEL    (3)
+/*
+ * Initialized after sysinit has finished, from the default event queue, so
+ * that slow devices do not hold up the start of the application.
+ */
+#define OS_DEV_INIT_DEFERRED  (4)
 
 #define OS_DEV_INIT_F_CRITICAL (1 << 0)
 
@@ -78,8 +83,14 @@ struct os_dev {
     uint8_t od_priority;
     uint8_t od_open_ref;
     uint8_t od_flags;
+#if MYNEWT_VAL(OS_DEV_INIT_PROFILE)
+    uint32_t od_init_usecs;     /* Time taken by od_init() */
+#endif
     char *od_name;
     STAILQ_ENTRY(os_dev) od_next;
+#if MYNEWT_VAL(OS_DEV_HASH_SIZE) > 0
+    SLIST_ENTRY(os_dev) od_hash_next;
+#endif
 };
 
 #define OS_DEV_SETHANDLERS(__dev, __open, __close)          \
@@ -109,10 +120,13 @@ os_dev_resume(struct os_dev *dev)
 int os_dev_create(struct os_dev *dev, char *name, uint8_t stage,
         uint8_t priority, os_dev_init_func_t od_init, void *arg);
 struct os_dev *os_dev_lookup(char *name);
+struct os_dev *os_dev_get_next(struct os_dev *prev);
 int os_dev_initialize_all(uint8_t stage);
 int os_dev_suspend_all(os_time_t, uint8_t);
 int os_dev_resume_all(void);
 struct os_dev *os_dev_open(char *devname, uint32_t timo, void *arg);
+struct os_dev *os_dev_open_cached(struct os_dev **handle, char *devname,
+        uint32_t timo, void *arg);
 int os_dev_close(struct os_dev *dev);
 void os_dev_reset(void);
 
@@ -21,6 +21,7 @@
 #define _OS_EVENTQ_H
 
 #include <inttypes.h>
+#include "syscfg/syscfg.h"
 #include "os/os_time.h"
 #include "os/queue.h"
 
@@ -36,27 +37,77 @@ struct os_event {
     os_event_fn *ev_cb;
     void *ev_arg;
     STAILQ_ENTRY(os_event) ev_next;
+#if MYNEWT_VAL(OS_EVENTQ_STATS)
+    os_time_t ev_put_time;      /* os_time at os_eventq_put() */
+#endif
 };
 
 #define OS_EVENT_QUEUED(__ev) ((__ev)->ev_queued)
 
+#if MYNEWT_VAL(OS_EVENTQ_STATS)
+struct os_eventq_stats {
+    uint32_t evqs_puts;         /* events queued */
+    uint32_t evqs_gets;         /* events pulled for dispatch */
+    uint16_t evqs_depth;        /* events currently queued */
+    uint16_t evqs_depth_max;    /* high water mark of evqs_depth */
+    os_time_t evqs_lat_max;     /* longest put to get, in ticks */
+    uint32_t evqs_lat_total;    /* sum of put to get over evqs_gets */
+};
+#endif
+
+struct os_eventq_set;
+
 struct os_eventq {
     struct os_task *evq_owner;  /* owner task */
     struct os_task *evq_task;   /* sleeper; must be either NULL, or the owner */
     STAILQ_HEAD(, os_event) evq_list;
+#if MYNEWT_VAL(OS_EVENTQ_STATS)
+    struct os_eventq_stats evq_stats;
+#endif
+#if MYNEWT_VAL(OS_EVENTQ_SET)
+    struct os_eventq_set *evq_set;  /* set the queue belongs to, or NULL */
+    uint8_t evq_prio;               /* priority in evq_set; 0 is highest */
+#endif
 };
 
+#if MYNEWT_VAL(OS_EVENTQ_SET)
+#if MYNEWT_VAL(OS_EVENTQ_SET_SIZE) < 1 || MYNEWT_VAL(OS_EVENTQ_SET_SIZE) > 32
+#error "OS_EVENTQ_SET_SIZE must be between 1 and 32"
+#endif
+
+/*
+ * A group of event queues served by one task.  Bit n of evs_ready is set
+ * while the queue of priority n holds events, so finding the next queue to
+ * serve, and waking the task, take constant time.
+ */
+struct os_eventq_set {
+    struct os_task *evs_task;   /* sleeper, or NULL */
+    uint32_t evs_ready;         /* non-empty member queues, by priority */
+    struct os_eventq *evs_evqs[MYNEWT_VAL(OS_EVENTQ_SET_SIZE)];
+};
+#endif
+
 void os_eventq_init(struct os_eventq *);
 int os_eventq_inited(const struct os_eventq *evq);
 void os_eventq_put(struct os_eventq *, struct os_event *);
 struct os_event *os_eventq_get_no_wait(struct os_eventq *evq);
 struct os_event *os_eventq_get(struct os_eventq *);
 void os_eventq_run(struct os_eventq *evq);
+int os_eventq_get_batch(struct os_eventq *evq, struct os_event **evs,
+                        int max);
+int os_eventq_run_batch(struct os_eventq *evq, int max);
 struct os_event *os_eventq_poll(struct os_eventq **, int, os_time_t);
 void os_eventq_remove(struct os_eventq *, struct os_event *);
 struct os_eventq *os_eventq_dflt_get(void);
 void os_eventq_designate(struct os_eventq **dst, struct os_eventq *val,
                          struct os_event *start_ev);
+#if MYNEWT_VAL(OS_EVENTQ_SET)
+void os_eventq_set_init(struct os_eventq_set *set);
+int os_eventq_set_add(struct os_eventq_set *set, struct os_eventq *evq,
+                      uint8_t prio);
+int os_eventq_set_del(struct os_eventq_set *set, struct os_eventq *evq);
+struct os_event *os_eventq_set_get(struct os_eventq_set *set, os_time_t timo);
+#endif
 #ifdef __cplusplus
 }
 #endif
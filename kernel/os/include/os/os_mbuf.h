@@ -105,6 +105,13 @@ struct os_mbuf {
      */
     SLIST_ENTRY(os_mbuf) om_next;
 
+#if MYNEWT_VAL(OS_MSYS_QUOTA)
+    /**
+     * The msys quota this mbuf is charged to, or NULL
+     */
+    struct os_msys_quota *om_quota;
+#endif
+
     /**
      * Pointer to the beginning of the data, after this buffer
      */
@@ -123,6 +130,36 @@ struct os_mqueue {
  */
 #define OS_MBUF_F_MASK(__n) (1 << (__n))
 
+/*
+ * The mbuf does not carry its own data; om_data points into an external
+ * buffer described by the struct os_mbuf_ext stored in om_databuf.
+ */
+#define OS_MBUF_F_EXT           OS_MBUF_F_MASK(0)
+
+/**
+ * Callback invoked when an mbuf referencing an external buffer is freed.
+ *
+ * @param buf                   The external buffer that was referenced.
+ * @param arg                   The argument given when attaching the buffer.
+ */
+typedef void os_mbuf_ext_free_fn(const void *buf, void *arg);
+
+/**
+ * Descriptor of the external buffer referenced by an OS_MBUF_F_EXT mbuf.
+ * Lives in the data area of the mbuf itself.
+ */
+struct os_mbuf_ext {
+    const void *ome_buf;
+    os_mbuf_ext_free_fn *ome_free_cb;
+    void *ome_arg;
+};
+
+/* Checks whether an mbuf references an external buffer */
+#define OS_MBUF_IS_EXT(__om) ((__om)->om_flags & OS_MBUF_F_EXT)
+
+/* Get the external buffer descriptor of an OS_MBUF_F_EXT mbuf */
+#define OS_MBUF_EXT(__om) ((struct os_mbuf_ext *)&(__om)->om_databuf[0])
+
 /* 
  * Checks whether a given mbuf is a packet header mbuf 
  *
@@ -180,6 +217,11 @@ _os_mbuf_leadingspace(struct os_mbuf *om)
     uint16_t startoff;
     uint16_t leadingspace;
 
+    /* External buffers are never written through the mbuf. */
+    if (OS_MBUF_IS_EXT(om)) {
+        return 0;
+    }
+
     startoff = 0;
     if (OS_MBUF_IS_PKTHDR(om)) {
         startoff = om->om_pkthdr_len;
@@ -209,6 +251,10 @@ _os_mbuf_trailingspace(struct os_mbuf *om)
 {
     struct os_mbuf_pool *omp;
 
+    if (OS_MBUF_IS_EXT(om)) {
+        return 0;
+    }
+
     omp = om->om_omp;
 
     return (&om->om_databuf[0] + omp->omp_databuf_len) -
@@ -252,6 +298,24 @@ struct os_mbuf *os_msys_get_pkthdr(uint16_t dsize, uint16_t user_hdr_len);
 int os_msys_count(void);
 int os_msys_num_free(void);
 
+#if MYNEWT_VAL(OS_MSYS_QUOTA)
+/* A share of msys for one subsystem; see os_msys_quota_init(). */
+struct os_msys_quota {
+    uint16_t omq_reserve;       /* mbufs kept back for this quota */
+    uint16_t omq_max;           /* Most mbufs charged at once; 0: no limit */
+    uint16_t omq_used;          /* mbufs currently charged */
+    uint16_t omq_denied;        /* Gets refused by the quota */
+};
+
+int os_msys_quota_init(struct os_msys_quota *q, uint16_t reserve,
+                       uint16_t max);
+struct os_mbuf *os_msys_get_quota(struct os_msys_quota *q, uint16_t dsize,
+                                  uint16_t leadingspace);
+struct os_mbuf *os_msys_get_pkthdr_quota(struct os_msys_quota *q,
+                                         uint16_t dsize,
+                                         uint16_t user_hdr_len);
+#endif
+
 /* Initialize a mbuf pool */
 int os_mbuf_pool_init(struct os_mbuf_pool *, struct os_mempool *mp, 
         uint16_t, uint16_t);
@@ -263,6 +327,15 @@ struct os_mbuf *os_mbuf_get(struct os_mbuf_pool *omp, uint16_t);
 struct os_mbuf *os_mbuf_get_pkthdr(struct os_mbuf_pool *omp, 
         uint8_t pkthdr_len);
 
+/* Allocate an mbuf referencing an external buffer */
+struct os_mbuf *os_mbuf_get_ext(struct os_mbuf_pool *omp, const void *buf,
+                                uint16_t len, os_mbuf_ext_free_fn *free_cb,
+                                void *arg);
+
+/* Append an external buffer to a mbuf chain without copying it */
+int os_mbuf_append_ext(struct os_mbuf *om, const void *buf, uint16_t len,
+                       os_mbuf_ext_free_fn *free_cb, void *arg);
+
 /* Duplicate a mbuf from the pool */
 struct os_mbuf *os_mbuf_dup(struct os_mbuf *m);
 
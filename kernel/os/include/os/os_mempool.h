@@ -48,6 +48,7 @@ struct os_mempool {
     int mp_num_blocks;          /* The number of memory blocks. */
     int mp_num_free;            /* The number of free blocks left */
     int mp_min_free;            /* The lowest number of free blocks seen */
+    int mp_num_exhausted;       /* Gets which found the pool empty */
     uint32_t mp_membuf_addr;    /* Address of memory buffer used by pool */
     STAILQ_ENTRY(os_mempool) mp_list;
     SLIST_HEAD(,os_memblock);   /* Pointer to list of free blocks */
@@ -61,12 +62,26 @@ struct os_mempool_info {
     int omi_num_blocks;
     int omi_num_free;
     int omi_min_free;
+    int omi_num_exhausted;
     char omi_name[OS_MEMPOOL_INFO_NAME_LEN];
 };
 
 struct os_mempool *os_mempool_info_get_next(struct os_mempool *,
         struct os_mempool_info *);
 
+#if MYNEWT_VAL(OS_MEMPOOL_OWNER)
+/* A block handed out by os_memblock_get(), and who took it. */
+struct os_memblock_owner {
+    struct os_mempool *omo_pool;
+    void *omo_block;
+    void *omo_ra;               /* Return address of the get */
+    uint8_t omo_taskid;         /* Running task, 0xff before the OS starts */
+};
+
+int os_memblock_owner_get_next(int *idx, struct os_memblock_owner *omo);
+uint32_t os_memblock_owner_untracked(void);
+#endif
+
 /*
  * To calculate size of the memory buffer needed for the pool. NOTE: This size
  * is NOT in bytes! The size is the number of os_membuf_t elements required for
@@ -20,6 +20,7 @@
 #ifndef _OS_MUTEX_H_
 #define _OS_MUTEX_H_
 
+#include "syscfg/syscfg.h"
 #include "os/os.h"
 #include "os/queue.h"
 
@@ -34,6 +35,11 @@ struct os_mutex
     uint8_t     mu_prio;            /* owner's default priority*/
     uint16_t    mu_level;           /* call nesting level */
     struct os_task *mu_owner;       /* owners task */
+#if MYNEWT_VAL(OS_MUTEX_STATS)
+    uint32_t    mu_contended;       /* pends that found it owned */
+    const char *mu_name;            /* set by os_mutex_register() */
+    STAILQ_ENTRY(os_mutex) mu_list;
+#endif
 };
 
 /* 
@@ -60,6 +66,24 @@ os_error_t os_mutex_release(struct os_mutex *mu);
 /* Pend (wait) for a mutex */
 os_error_t os_mutex_pend(struct os_mutex *mu, uint32_t timeout);
 
+#if MYNEWT_VAL(OS_MUTEX_STATS)
+#define OS_MUTEX_INFO_NAME_LEN (32)
+
+struct os_mutex_info {
+    uint32_t omi_contended;
+    uint16_t omi_level;
+    uint8_t omi_owner_id;           /* task id of owner; 0xff if free */
+    uint8_t omi_num_waiters;
+    char omi_name[OS_MUTEX_INFO_NAME_LEN];
+};
+
+/* Make a mutex visible to os_mutex_info_get_next() */
+void os_mutex_register(struct os_mutex *mu, const char *name);
+
+struct os_mutex *os_mutex_info_get_next(struct os_mutex *,
+        struct os_mutex_info *);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
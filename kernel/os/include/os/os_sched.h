@@ -20,6 +20,7 @@
 #ifndef _OS_SCHED_H
 #define _OS_SCHED_H
 
+#include "syscfg/syscfg.h"
 #include "os/os_task.h"
 
 #ifdef __cplusplus
@@ -39,6 +40,15 @@ int os_sched_remove(struct os_task *);
 void os_sched_resort(struct os_task *);
 os_time_t os_sched_wakeup_ticks(os_time_t now);
 
+#if MYNEWT_VAL(OS_TASK_PROFILE)
+uint32_t os_task_prof_time(void);
+void os_task_prof_isr_enter(void);
+void os_task_prof_isr_exit(void);
+#else
+#define os_task_prof_isr_enter()
+#define os_task_prof_isr_exit()
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -20,6 +20,7 @@
 #ifndef _OS_TASK_H
 #define _OS_TASK_H
 
+#include "syscfg/syscfg.h"
 #include "os/os.h"
 #include "os/os_sanity.h" 
 #include "os/queue.h"
@@ -55,6 +56,21 @@ typedef enum os_task_state {
 #define OS_TASK_FLAG_MUTEX_WAIT     (0x04U)
 #define OS_TASK_FLAG_EVQ_WAIT       (0x08U)
 #define OS_TASK_FLAG_LOCK_HELD      (0x10U)
+#define OS_TASK_FLAG_NOTIFY_WAIT    (0x20U)
+
+/*
+ * Task notification word layout. The low 16 bits are a counter driven by
+ * os_task_notify_give()/os_task_notify_take(); the high 16 bits are event
+ * bits set by os_task_notify() and collected by os_task_notify_wait().
+ */
+#define OS_TASK_NOTIFY_CNT_MASK     (0x0000ffffU)
+#define OS_TASK_NOTIFY_BITS_MASK    (0xffff0000U)
+
+/*
+ * Reserved for drivers which block the calling task until a transfer
+ * completes; a task is only ever inside one such call at a time.
+ */
+#define OS_TASK_NOTIFY_IO           (0x80000000U)
 
 typedef void (*os_task_func_t)(void *);
 
@@ -71,7 +87,12 @@ struct os_task {
     uint8_t t_state;
     uint8_t t_flags;
     uint8_t t_lockcnt;
+#if MYNEWT_VAL(OS_SCHED_PRIO_BITMAP)
+    /* Priority the task was queued with on the run list */
+    uint8_t t_run_prio;
+#else
     uint8_t t_pad;
+#endif
 
     const char *t_name;
     os_task_func_t t_func;
@@ -79,11 +100,25 @@ struct os_task {
 
     void *t_obj;
 
+    /* Notification word, and what the task is blocked on in it */
+    uint32_t t_notify;
+    uint32_t t_notify_wait;
+
     struct os_sanity_check t_sanity_check;
 
     os_time_t t_next_wakeup;
     os_time_t t_run_time;
     uint32_t t_ctx_sw_cnt;
+#if MYNEWT_VAL(OS_TASK_STACK_HWM)
+    /* Deepest stack pointer seen; see os_sched_ctx_sw_hook() */
+    os_stack_t *t_stack_hwm;
+#endif
+#if MYNEWT_VAL(OS_TASK_PROFILE)
+    /* Profiler clock: time run, time in ISRs, longest single run */
+    uint32_t t_prof_run;
+    uint32_t t_prof_isr;
+    uint32_t t_prof_max_run;
+#endif
 
     /* Global list of all tasks, irrespective of run or sleep lists */
     STAILQ_ENTRY(os_task) t_os_task_list;
@@ -102,6 +137,13 @@ int os_task_remove(struct os_task *t);
 
 uint8_t os_task_count(void);
 
+os_error_t os_task_notify(struct os_task *t, uint32_t bits);
+os_error_t os_task_notify_wait(uint32_t mask, uint32_t timeout,
+        uint32_t *bits);
+uint32_t os_task_notify_clear(uint32_t mask);
+os_error_t os_task_notify_give(struct os_task *t);
+os_error_t os_task_notify_take(uint32_t timeout);
+
 struct os_task_info {
     uint8_t oti_prio;
     uint8_t oti_taskid;
@@ -113,6 +155,11 @@ struct os_task_info {
     uint32_t oti_runtime;
     os_time_t oti_last_checkin;
     os_time_t oti_next_checkin;
+#if MYNEWT_VAL(OS_TASK_PROFILE)
+    uint32_t oti_prof_run;
+    uint32_t oti_prof_isr;
+    uint32_t oti_prof_max_run;
+#endif
 
     char oti_name[OS_TASK_MAX_NAME_LEN];
 };
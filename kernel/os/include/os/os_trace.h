@@ -0,0 +1,85 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#ifndef _OS_TRACE_H
+#define _OS_TRACE_H
+
+#include <inttypes.h>
+#include "syscfg/syscfg.h"
+#include "os/os_sched.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Trace event ids.  Ids from OS_TRACE_ID_USER up are for packages outside
+ * the kernel; see kernel/os/scripts/os_trace_decode.py for the ones in use.
+ */
+#define OS_TRACE_ID_CTX_SW          1   /* arg: id of the task switched to */
+#define OS_TRACE_ID_ISR_ENTER       2   /* arg: IRQ number */
+#define OS_TRACE_ID_ISR_EXIT        3
+#define OS_TRACE_ID_EVQ_PUT         4   /* arg: event */
+#define OS_TRACE_ID_EVQ_GET         5   /* arg: event */
+#define OS_TRACE_ID_MUTEX_WAIT      6   /* arg: mutex */
+#define OS_TRACE_ID_SEM_WAIT        7   /* arg: semaphore */
+#define OS_TRACE_ID_MEMPOOL_EMPTY   8   /* arg: pool */
+#define OS_TRACE_ID_USER            0x80
+
+/*
+ * One trace record, as kept in RAM and as sent to the host (in target
+ * byte order).
+ */
+struct os_trace_rec {
+    uint32_t otr_ts;        /* os_cputime */
+    uint32_t otr_arg;
+    uint8_t otr_id;
+    uint8_t otr_taskid;     /* Running task, 0xff before the OS starts */
+    uint16_t otr_rsvd;
+};
+
+#if MYNEWT_VAL(OS_TRACE)
+void os_trace_event(uint8_t id, uint32_t arg);
+int os_trace_read(struct os_trace_rec *recs, int max, uint32_t *lost);
+#else
+#define os_trace_event(id, arg)
+#endif
+
+/*
+ * Interrupt handlers bracket their work with these.  Besides the trace
+ * record, the time spent in between is charged to interrupts by the task
+ * profiler (OS_TASK_PROFILE) instead of to the interrupted task.
+ */
+#define os_trace_isr_enter(irq)                                         \
+    do {                                                                \
+        os_task_prof_isr_enter();                                       \
+        os_trace_event(OS_TRACE_ID_ISR_ENTER, (irq));                   \
+    } while (0)
+#define os_trace_isr_exit()                                             \
+    do {                                                                \
+        os_trace_event(OS_TRACE_ID_ISR_EXIT, 0);                        \
+        os_task_prof_isr_exit();                                        \
+    } while (0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _OS_TRACE_H */
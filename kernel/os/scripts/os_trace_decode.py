@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#  http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+#
+
+"""
+Decodes kernel trace records (OS_TRACE) captured from a device, either the
+raw RTT trace channel or the "d" fields of newtmgr trace reads, and prints
+them with times in microseconds, followed by interrupt durations and event
+queue put-to-get latencies.
+
+    os_trace_decode.py [--hex] [--freq HZ] [--big-endian] FILE
+
+With --hex, FILE holds the records as hex text; whitespace is ignored.
+"""
+
+import argparse
+import struct
+import sys
+
+EVENTS = {
+    1: 'ctx_sw',
+    2: 'isr_enter',
+    3: 'isr_exit',
+    4: 'evq_put',
+    5: 'evq_get',
+    6: 'mutex_wait',
+    7: 'sem_wait',
+    8: 'mempool_empty',
+    # net/nimble/controller: BLE_LL_TRACE_ID_*
+    0x80: 'ble_ll_rx_start',
+    0x81: 'ble_ll_rx_end',
+    # net/nimble/host: BLE_HS_TRACE_ID_*
+    0x88: 'ble_hs_hci_evt',
+    0x89: 'ble_hs_acl_rx',
+}
+
+REC_FMT = 'IIBBH'
+REC_SIZE = struct.calcsize('<' + REC_FMT)
+
+
+def read_records(data, endian):
+    fmt = endian + REC_FMT
+    for off in range(0, len(data) - REC_SIZE + 1, REC_SIZE):
+        ts, arg, ev_id, task, _ = struct.unpack_from(fmt, data, off)
+        yield ts, arg, ev_id, task
+
+
+def summary(title, samples):
+    if not samples:
+        return
+    samples.sort()
+    print('%s: n=%d min=%.1f avg=%.1f max=%.1f us' %
+          (title, len(samples), samples[0], sum(samples) / len(samples),
+           samples[-1]))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode an OS_TRACE capture')
+    parser.add_argument('file')
+    parser.add_argument('--hex', action='store_true',
+                        help='input is hex text rather than binary')
+    parser.add_argument('--freq', type=int, default=1000000,
+                        help='OS_CPUTIME_FREQ of the target (default 1MHz)')
+    parser.add_argument('--big-endian', action='store_true')
+    args = parser.parse_args()
+
+    if args.hex:
+        with open(args.file) as f:
+            data = bytes.fromhex(''.join(f.read().split()))
+    else:
+        with open(args.file, 'rb') as f:
+            data = f.read()
+
+    endian = '>' if args.big_endian else '<'
+    usecs = 1e6 / args.freq
+
+    start = None
+    prev = 0
+    isr_open = []
+    isr_lat = []
+    evq_open = {}
+    evq_lat = []
+
+    for ts, arg, ev_id, task in read_records(data, endian):
+        if start is None:
+            start = prev = ts
+        # Timestamps are 32 bit and wrap; keep a running 64 bit time.
+        prev_low = prev & 0xffffffff
+        prev += (ts - prev_low) & 0xffffffff
+        t = (prev - start) * usecs
+
+        name = EVENTS.get(ev_id, 'id_%d' % ev_id)
+        task_s = '-' if task == 0xff else str(task)
+        if ev_id == 2:
+            arg_s = str(arg - (1 << 32) if arg & 0x80000000 else arg)
+        else:
+            arg_s = '0x%x' % arg
+        print('%12.1f  task %-3s %-16s %s' % (t, task_s, name, arg_s))
+
+        if ev_id == 2:
+            isr_open.append(t)
+        elif ev_id == 3 and isr_open:
+            isr_lat.append(t - isr_open.pop())
+        elif ev_id == 4:
+            evq_open[arg] = t
+        elif ev_id == 5 and arg in evq_open:
+            evq_lat.append(t - evq_open.pop(arg))
+
+    print()
+    summary('isr', isr_lat)
+    summary('evq put->get', evq_lat)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
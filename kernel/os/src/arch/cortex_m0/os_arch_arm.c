@@ -104,7 +104,9 @@ uint32_t os_flags = OS_RUN_PRIV;
 void
 timer_handler(void)
 {
+    os_trace_isr_enter(SysTick_IRQn);
     os_time_advance(1);
+    os_trace_isr_exit();
 }
 
 void
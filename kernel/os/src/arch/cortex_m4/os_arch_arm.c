@@ -113,7 +113,9 @@ uint32_t os_flags = OS_RUN_PRIV;
 void
 timer_handler(void)
 {
+    os_trace_isr_enter(SysTick_IRQn);
     os_time_advance(1);
+    os_trace_isr_exit();
 }
 
 void
@@ -189,6 +191,16 @@ os_arch_init(void)
      * Trap on divide-by-zero.
      */
     SCB->CCR |= SCB_CCR_DIV_0_TRP_Msk;
+#if MYNEWT_VAL(HARDFLOAT)
+    /*
+     * Lazy FP stacking. An exception taken while CONTROL.FPCA is set (the
+     * task has executed an FP instruction) reserves room for S0-S15 and
+     * FPSCR, but only fills it if the handler itself uses the FPU. PendSV
+     * saves S16-S31 only for such extended frames, so tasks which never
+     * touch the FPU switch with the basic frame.
+     */
+    FPU->FPCCR |= FPU_FPCCR_ASPEN_Msk | FPU_FPCCR_LSPEN_Msk;
+#endif
     os_init_idle_task();
 }
 
@@ -156,6 +156,11 @@ PendSV_Handler:
 
         MRS     R12,PSP                 /* Read PSP */
 #if MYNEWT_VAL(HARDFLOAT)
+        /*
+         * Only tasks which have used the FPU have an extended frame. The
+         * VSTMDB also triggers the lazy save of S0-S15 and FPSCR into the
+         * space the hardware reserved for them on exception entry.
+         */
         TST     LR,#0x10                /* is it extended frame? */
         IT      EQ
         VSTMDBEQ R12!,{S16-S31}         /* yes; push the regs */
@@ -75,6 +75,9 @@ os_arch_sim_ctx_sw(void)
         }
     }
 
+#if MYNEWT_VAL(MCU_NATIVE_VIRTUAL_TIME)
+    os_arch_sim_cycles_add(MYNEWT_VAL(MCU_NATIVE_VT_CYCLES_CTX_SW));
+#endif
     os_sched_ctx_sw_hook(next_t);
 
     os_sched_set_current_task(next_t);
@@ -94,6 +97,8 @@ os_arch_sim_tick(void)
 
     OS_ASSERT_CRITICAL();
 
+    os_trace_isr_enter(SIGALRM);
+
     if (!time_inited) {
         gettimeofday(&time_last, NULL);
         time_inited = 1;
@@ -121,11 +126,14 @@ os_arch_sim_tick(void)
 
         os_time_advance(ticks);
     }
+
+    os_trace_isr_exit();
 }
 
 static void
 os_arch_sim_start_timer(void)
 {
+#if !MYNEWT_VAL(MCU_NATIVE_VIRTUAL_TIME)
     struct itimerval it;
     int rc;
 
@@ -137,11 +145,13 @@ os_arch_sim_start_timer(void)
 
     rc = setitimer(ITIMER_REAL, &it, NULL);
     assert(rc == 0);
+#endif
 }
 
 static void
 os_arch_sim_stop_timer(void)
 {
+#if !MYNEWT_VAL(MCU_NATIVE_VIRTUAL_TIME)
     struct itimerval it;
     int rc;
 
@@ -149,6 +159,7 @@ os_arch_sim_stop_timer(void)
 
     rc = setitimer(ITIMER_REAL, &it, NULL);
     assert(rc == 0);
+#endif
 }
 
 /*
@@ -237,8 +248,7 @@ os_arch_os_init(void)
     g_current_task = NULL;
 
     STAILQ_INIT(&g_os_task_list);
-    TAILQ_INIT(&g_os_run_list);
-    TAILQ_INIT(&g_os_sleep_list);
+    os_sched_init_lists();
 
     os_arch_sim_signals_init();
 
@@ -52,9 +52,6 @@
 #include <assert.h>
 #include "os_arch_sim_priv.h"
 
-static sigset_t nosigs;
-static sigset_t suspsigs;   /* signals delivered in sigsuspend() */
-
 static int ctx_sw_pending;
 static int interrupts_enabled = 1;
 
@@ -85,6 +82,9 @@ os_arch_save_sr(void)
     }
 
     interrupts_enabled = 0;
+#if MYNEWT_VAL(MCU_NATIVE_VIRTUAL_TIME)
+    os_arch_sim_cycles_add(MYNEWT_VAL(MCU_NATIVE_VT_CYCLES_CRIT));
+#endif
     return 0;
 }
 
@@ -99,6 +99,11 @@ os_arch_restore_sr(os_sr_t osr)
         return;
     }
 
+#if MYNEWT_VAL(MCU_NATIVE_VIRTUAL_TIME)
+    /* Take any tick interrupts that came due while interrupts were off. */
+    os_arch_sim_vt_tick();
+#endif
+
     if (ctx_sw_pending) {
         /* A context switch was requested while interrupts were disabled.
          * Perform it now that interrupts are enabled again.
@@ -115,6 +120,10 @@ os_arch_in_critical(void)
     return !interrupts_enabled;
 }
 
+#if !MYNEWT_VAL(MCU_NATIVE_VIRTUAL_TIME)
+static sigset_t nosigs;
+static sigset_t suspsigs;   /* signals delivered in sigsuspend() */
+
 /**
  * Unblocks the SIGALRM signal that is delivered by the OS tick timer.
  */
@@ -237,5 +246,6 @@ os_arch_sim_signals_cleanup(void)
     error = sigaction(SIGALRM, &sa, NULL);
     assert(error == 0);
 }
+#endif /* !MYNEWT_VAL(MCU_NATIVE_VIRTUAL_TIME) */
 
 #endif /* !MYNEWT_VAL(MCU_NATIVE_USE_SIGNALS) */
@@ -23,6 +23,9 @@ void os_arch_sim_ctx_sw(void);
 void os_arch_sim_tick(void);
 void os_arch_sim_signals_init(void);
 void os_arch_sim_signals_cleanup(void);
+#if MYNEWT_VAL(MCU_NATIVE_VIRTUAL_TIME)
+void os_arch_sim_vt_tick(void);
+#endif
 
 extern pid_t os_arch_sim_pid;
 
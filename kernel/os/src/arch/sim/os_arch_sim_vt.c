@@ -0,0 +1,144 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * This file implements virtual time for the "no-signals" version of sim.
+ * The host clock is never consulted: OS time advances as estimated CPU
+ * cycles accumulate, and the idle task skips straight to the next timeout.
+ * A given build therefore runs identically every time, whatever the host is
+ * doing, and the cycle count can be used to compare builds.
+ *
+ * Cycles are estimated with fixed charges for critical sections and context
+ * switches, plus a charge per function call when code is built with
+ * -finstrument-functions and MCU_NATIVE_VT_CYCLES_CALL is set.  Code can
+ * add its own estimates with os_arch_sim_cycles_add().
+ *
+ * To use virtual time, enable the MCU_NATIVE_VIRTUAL_TIME syscfg setting.
+ */
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(MCU_NATIVE_VIRTUAL_TIME)
+
+#include "os/os.h"
+#include "os_priv.h"
+
+#include <unistd.h>
+#include <assert.h>
+#include "os_arch_sim_priv.h"
+
+#define OS_ARCH_SIM_VT_CYCLES_PER_TICK \
+    (MYNEWT_VAL(MCU_NATIVE_VT_CPU_FREQ) / OS_TICKS_PER_SEC)
+
+/* Cycles of work done since startup. */
+static uint64_t vt_cycles;
+/* Cycles of work done since OS time last advanced. */
+static uint32_t vt_tick_cycles;
+
+/**
+ * Charges cycles of estimated work to the virtual CPU.  OS time catches up
+ * the next time interrupts are enabled.
+ *
+ * @param cycles The number of cycles to charge.
+ */
+void
+os_arch_sim_cycles_add(uint32_t cycles)
+{
+    vt_cycles += cycles;
+    vt_tick_cycles += cycles;
+}
+
+/**
+ * Returns the number of cycles of work done since startup.  Time spent idle
+ * is not included.
+ */
+uint64_t
+os_arch_sim_cycles(void)
+{
+    return vt_cycles;
+}
+
+/*
+ * Advances OS time by the whole ticks' worth of work done since it last
+ * advanced.  Called with interrupts disabled, where a real target would
+ * take the tick interrupt.
+ */
+void
+os_arch_sim_vt_tick(void)
+{
+    os_time_t ticks;
+
+    OS_ASSERT_CRITICAL();
+
+    if (vt_tick_cycles < OS_ARCH_SIM_VT_CYCLES_PER_TICK) {
+        return;
+    }
+
+    ticks = vt_tick_cycles / OS_ARCH_SIM_VT_CYCLES_PER_TICK;
+    vt_tick_cycles -= ticks * OS_ARCH_SIM_VT_CYCLES_PER_TICK;
+    os_time_advance(ticks);
+}
+
+void
+os_tick_idle(os_time_t ticks)
+{
+    OS_ASSERT_CRITICAL();
+
+    /*
+     * Nothing else can happen until the next timeout, so go straight to it.
+     * The partial tick of work done so far is absorbed by the first tick.
+     */
+    if (ticks == 0) {
+        ticks = 1;
+    }
+    vt_tick_cycles = 0;
+    os_time_advance(ticks);
+}
+
+/* No tick timer, so no signals to set up. */
+void
+os_arch_sim_signals_init(void)
+{
+}
+
+void
+os_arch_sim_signals_cleanup(void)
+{
+}
+
+#if MYNEWT_VAL(MCU_NATIVE_VT_CYCLES_CALL) > 0
+void __cyg_profile_func_enter(void *fn, void *site)
+    __attribute__((no_instrument_function));
+void __cyg_profile_func_exit(void *fn, void *site)
+    __attribute__((no_instrument_function));
+
+void
+__cyg_profile_func_enter(void *fn, void *site)
+{
+    vt_cycles += MYNEWT_VAL(MCU_NATIVE_VT_CYCLES_CALL);
+    vt_tick_cycles += MYNEWT_VAL(MCU_NATIVE_VT_CYCLES_CALL);
+}
+
+void
+__cyg_profile_func_exit(void *fn, void *site)
+{
+}
+#endif
+
+#endif /* MYNEWT_VAL(MCU_NATIVE_VIRTUAL_TIME) */
@@ -172,7 +172,7 @@ os_init(int (*main_fn)(int argc, char **arg))
 {
     os_error_t err;
 
-    TAILQ_INIT(&g_callout_list);
+    os_callout_init_lists();
     STAILQ_INIT(&g_os_task_list);
     os_eventq_init(os_eventq_dflt_get());
 
@@ -211,6 +211,10 @@ os_start(void)
     /* Enable the watchdog prior to starting the OS */
     hal_watchdog_enable();
 
+#if MYNEWT_VAL(OS_TASK_PROFILE)
+    os_sched_prof_start();
+#endif
+
     err = os_arch_os_start();
     assert(err == OS_OK);
 #else
@@ -230,6 +234,11 @@ os_pkg_init(void)
     assert(err == OS_OK);
 
     os_msys_init();
+    os_malloc_init();
+
+#if MYNEWT_VAL(OS_CALLOUT_STATS)
+    os_callout_stats_init();
+#endif
 }
 
 /**
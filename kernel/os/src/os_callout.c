@@ -20,17 +20,132 @@
 #include <assert.h>
 #include <string.h>
 
+#include "syscfg/syscfg.h"
 #include "os/os.h"
 #include "os_priv.h"
 
+#if MYNEWT_VAL(OS_CALLOUT_STATS)
+#include "stats/stats.h"
+#endif
+
 /**
  * @addtogroup OSKernel
  * @{
  *   @defgroup OSCallouts Event Timers (Callouts)
  *   @{
  */
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+#define OS_CALLOUT_WHEEL_SLOTS  MYNEWT_VAL(OS_CALLOUT_WHEEL_SLOTS)
+#define OS_CALLOUT_WHEEL_MASK   (OS_CALLOUT_WHEEL_SLOTS - 1)
+
+#if (OS_CALLOUT_WHEEL_SLOTS & OS_CALLOUT_WHEEL_MASK) != 0
+#error "OS_CALLOUT_WHEEL_SLOTS must be a power of two"
+#endif
+
+/*
+ * Hashed timing wheel. A callout expiring at tick 't' lives in slot
+ * (t & OS_CALLOUT_WHEEL_MASK), unsorted. Every tick only the slot for that
+ * tick needs to be examined; callouts due on a later revolution of the
+ * wheel are skipped.
+ */
+static struct os_callout_list os_callout_wheel[OS_CALLOUT_WHEEL_SLOTS];
+
+/* Last tick the wheel has been processed up to. */
+static os_time_t os_callout_wheel_tick;
+
+/*
+ * Earliest pending callout, kept up to date on insert so that the idle task
+ * does not have to search the wheel for its next deadline. Removing that
+ * callout only marks the cache stale; it is recomputed on the next query.
+ */
+static struct os_callout *os_callout_wheel_next;
+static uint8_t os_callout_wheel_next_stale;
+
+#define OS_CALLOUT_LIST(c) \
+    (&os_callout_wheel[(c)->c_ticks & OS_CALLOUT_WHEEL_MASK])
+#else
 struct os_callout_list g_callout_list;
 
+#define OS_CALLOUT_LIST(c) (&g_callout_list)
+#endif
+
+#if MYNEWT_VAL(OS_CALLOUT_STATS)
+STATS_SECT_START(os_callout_stats)
+    STATS_SECT_ENTRY(arm)
+    STATS_SECT_ENTRY(cancel)
+    STATS_SECT_ENTRY(expire)
+    STATS_SECT_ENTRY(walk)
+STATS_SECT_END
+
+STATS_SECT_DECL(os_callout_stats) g_os_callout_stats;
+
+STATS_NAME_START(os_callout_stats)
+    STATS_NAME(os_callout_stats, arm)
+    STATS_NAME(os_callout_stats, cancel)
+    STATS_NAME(os_callout_stats, expire)
+    STATS_NAME(os_callout_stats, walk)
+STATS_NAME_END(os_callout_stats)
+
+#define OS_CALLOUT_STATS_INC(__var) STATS_INC(g_os_callout_stats, __var)
+#else
+#define OS_CALLOUT_STATS_INC(__var)
+#endif
+
+/*
+ * Initialize the list(s) holding pending callouts.
+ */
+void
+os_callout_init_lists(void)
+{
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+    int i;
+
+    for (i = 0; i < OS_CALLOUT_WHEEL_SLOTS; i++) {
+        TAILQ_INIT(&os_callout_wheel[i]);
+    }
+    os_callout_wheel_tick = os_time_get();
+    os_callout_wheel_next = NULL;
+    os_callout_wheel_next_stale = 0;
+#else
+    TAILQ_INIT(&g_callout_list);
+#endif
+}
+
+#if MYNEWT_VAL(OS_CALLOUT_STATS)
+/*
+ * Register the "os_callout" statistics group.
+ */
+void
+os_callout_stats_init(void)
+{
+    /* Fails harmlessly if the group is already registered. */
+    (void)stats_init_and_reg(STATS_HDR(g_os_callout_stats),
+                             STATS_SIZE_INIT_PARMS(g_os_callout_stats,
+                                                   STATS_SIZE_32),
+                             STATS_NAME_INIT_PARMS(os_callout_stats),
+                             "os_callout");
+}
+#endif
+
+/*
+ * Unlink a pending callout from its list.
+ *
+ * NOTE: must be called with interrupts disabled!
+ */
+static void
+os_callout_remove(struct os_callout_list *head, struct os_callout *c)
+{
+    TAILQ_REMOVE(head, c, c_next);
+    c->c_next.tqe_prev = NULL;
+
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+    if (c == os_callout_wheel_next) {
+        os_callout_wheel_next = NULL;
+        os_callout_wheel_next_stale = 1;
+    }
+#endif
+}
+
 /**
  * Initialize a callout.
  *
@@ -70,8 +185,8 @@ os_callout_stop(struct os_callout *c)
     OS_ENTER_CRITICAL(sr);
 
     if (os_callout_queued(c)) {
-        TAILQ_REMOVE(&g_callout_list, c, c_next);
-        c->c_next.tqe_prev = NULL;
+        os_callout_remove(OS_CALLOUT_LIST(c), c);
+        OS_CALLOUT_STATS_INC(cancel);
     }
 
     if (c->c_evq) {
@@ -92,7 +207,9 @@ os_callout_stop(struct os_callout *c)
 int
 os_callout_reset(struct os_callout *c, int32_t ticks)
 {
+#if !MYNEWT_VAL(OS_CALLOUT_WHEEL)
     struct os_callout *entry;
+#endif
     os_sr_t sr;
     int rc;
 
@@ -111,8 +228,17 @@ os_callout_reset(struct os_callout *c, int32_t ticks)
 
     c->c_ticks = os_time_get() + ticks;
 
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+    TAILQ_INSERT_TAIL(OS_CALLOUT_LIST(c), c, c_next);
+    if (!os_callout_wheel_next_stale &&
+        (!os_callout_wheel_next ||
+         OS_TIME_TICK_LT(c->c_ticks, os_callout_wheel_next->c_ticks))) {
+        os_callout_wheel_next = c;
+    }
+#else
     entry = NULL;
     TAILQ_FOREACH(entry, &g_callout_list, c_next) {
+        OS_CALLOUT_STATS_INC(walk);
         if (OS_TIME_TICK_LT(c->c_ticks, entry->c_ticks)) {
             break;
         }
@@ -123,6 +249,8 @@ os_callout_reset(struct os_callout *c, int32_t ticks)
     } else {
         TAILQ_INSERT_TAIL(&g_callout_list, c, c_next);
     }
+#endif
+    OS_CALLOUT_STATS_INC(arm);
 
     OS_EXIT_CRITICAL(sr);
 
@@ -131,6 +259,71 @@ err:
     return (rc);
 }
 
+/*
+ * Post the event for an expired callout, or call its handler directly if
+ * there is no event queue.
+ */
+static void
+os_callout_fire(struct os_callout *c)
+{
+    OS_CALLOUT_STATS_INC(expire);
+
+    if (c->c_evq) {
+        os_eventq_put(c->c_evq, &c->c_ev);
+    } else {
+        c->c_ev.ev_cb(&c->c_ev);
+    }
+}
+
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+/**
+ * This function is called by the OS in the time tick.  It looks at the
+ * wheel slot of every tick elapsed since it last ran (at most one full
+ * revolution), and posts an event for each callout in those slots that's
+ * ready to run, to the event queue provided to os_callout_init().
+ */
+void
+os_callout_tick(void)
+{
+    struct os_callout_list *head;
+    struct os_callout *c;
+    os_time_t now;
+    os_time_t elapsed;
+    os_sr_t sr;
+
+    now = os_time_get();
+
+    elapsed = now - os_callout_wheel_tick;
+    if (elapsed > OS_CALLOUT_WHEEL_SLOTS) {
+        elapsed = OS_CALLOUT_WHEEL_SLOTS;
+    }
+
+    while (elapsed-- > 0) {
+        os_callout_wheel_tick++;
+        head = &os_callout_wheel[os_callout_wheel_tick &
+                                 OS_CALLOUT_WHEEL_MASK];
+
+        while (1) {
+            OS_ENTER_CRITICAL(sr);
+            TAILQ_FOREACH(c, head, c_next) {
+                OS_CALLOUT_STATS_INC(walk);
+                if (OS_TIME_TICK_GEQ(now, c->c_ticks)) {
+                    os_callout_remove(head, c);
+                    break;
+                }
+            }
+            OS_EXIT_CRITICAL(sr);
+
+            if (!c) {
+                break;
+            }
+            os_callout_fire(c);
+        }
+    }
+
+    os_callout_wheel_tick = now;
+}
+#else
 /**
  * This function is called by the OS in the time tick.  It searches the list
  * of callouts, and sees if any of them are ready to run.  If they are ready
@@ -151,8 +344,7 @@ os_callout_tick(void)
         c = TAILQ_FIRST(&g_callout_list);
         if (c) {
             if (OS_TIME_TICK_GEQ(now, c->c_ticks)) {
-                TAILQ_REMOVE(&g_callout_list, c, c_next);
-                c->c_next.tqe_prev = NULL;
+                os_callout_remove(&g_callout_list, c);
             } else {
                 c = NULL;
             }
@@ -160,16 +352,48 @@ os_callout_tick(void)
         OS_EXIT_CRITICAL(sr);
 
         if (c) {
-            if (c->c_evq) {
-                os_eventq_put(c->c_evq, &c->c_ev);
-            } else {
-                c->c_ev.ev_cb(&c->c_ev);
-            }
+            os_callout_fire(c);
         } else {
             break;
         }
     }
 }
+#endif
+
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+/*
+ * Returns the earliest pending callout on the wheel, or NULL if there is
+ * none. Slots are visited in expiry order starting from the current tick,
+ * so the first callout found that is due within one revolution is the
+ * earliest one. Only if every pending callout is further out than that is
+ * the whole wheel walked.
+ */
+static struct os_callout *
+os_callout_wheel_first(void)
+{
+    struct os_callout *first;
+    struct os_callout *c;
+    os_time_t tick;
+    int i;
+
+    first = NULL;
+    tick = os_callout_wheel_tick;
+    for (i = 0; i < OS_CALLOUT_WHEEL_SLOTS; i++) {
+        tick++;
+        TAILQ_FOREACH(c, &os_callout_wheel[tick & OS_CALLOUT_WHEEL_MASK],
+                      c_next) {
+            if (!OS_TIME_TICK_GT(c->c_ticks, tick)) {
+                return (c);
+            }
+            if (!first || OS_TIME_TICK_LT(c->c_ticks, first->c_ticks)) {
+                first = c;
+            }
+        }
+    }
+
+    return (first);
+}
+#endif
 
 /*
  * Returns the number of ticks to the first pending callout. If there are no
@@ -187,7 +411,15 @@ os_callout_wakeup_ticks(os_time_t now)
 
     OS_ASSERT_CRITICAL();
 
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+    if (os_callout_wheel_next_stale) {
+        os_callout_wheel_next = os_callout_wheel_first();
+        os_callout_wheel_next_stale = 0;
+    }
+    c = os_callout_wheel_next;
+#else
     c = TAILQ_FIRST(&g_callout_list);
+#endif
     if (c != NULL) {
         if (OS_TIME_TICK_GEQ(c->c_ticks, now)) {
             rt = c->c_ticks - now;
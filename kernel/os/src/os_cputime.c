@@ -34,6 +34,54 @@
 struct os_cputime_data g_os_cputime;
 #endif
 
+/**
+ * os cputime recip init
+ *
+ * Computes the reciprocal of 'd', following Granlund and Montgomery:
+ * with l = ceil(log2(d)), m = floor(2^32 * (2^l - d) / d) + 1, and
+ * x / d = (t + ((x - t) >> 1)) >> (l - 1) where t = (x * m) >> 32.  The
+ * 64-bit division is done once here instead of on every conversion.
+ *
+ * @param r The reciprocal to fill in
+ * @param d The divisor; must be non-zero
+ */
+void
+os_cputime_recip_init(struct os_cputime_recip *r, uint32_t d)
+{
+    uint8_t l;
+
+    assert(d != 0);
+
+    l = 0;
+    while (l < 32 && ((uint64_t)1 << l) < d) {
+        l++;
+    }
+
+    r->m = (uint32_t)(((((uint64_t)1 << l) - d) << 32) / d + 1);
+    if (l == 0) {
+        r->sh1 = 0;
+        r->sh2 = 0;
+    } else {
+        r->sh1 = 1;
+        r->sh2 = l - 1;
+    }
+}
+
+#if !defined(OS_CPUTIME_FREQ_32768) && !defined(OS_CPUTIME_FREQ_1MHZ)
+/* Divides by ticks_per_usec, rounding up. */
+static uint32_t
+os_cputime_div_tpu_ceil(uint32_t x)
+{
+    uint32_t q;
+
+    q = os_cputime_recip_div(&g_os_cputime.ticks_per_usec_recip, x);
+    if (q * g_os_cputime.ticks_per_usec != x) {
+        q++;
+    }
+    return q;
+}
+#endif
+
 /**
  * os cputime init
  *
@@ -53,6 +101,9 @@ os_cputime_init(uint32_t clock_freq)
     /* Set the ticks per microsecond. */
 #if !defined(OS_CPUTIME_FREQ_32768) && !defined(OS_CPUTIME_FREQ_1MHZ)
     g_os_cputime.ticks_per_usec = clock_freq / 1000000U;
+    os_cputime_recip_init(&g_os_cputime.ticks_per_usec_recip,
+                          g_os_cputime.ticks_per_usec);
+    os_cputime_recip_init(&g_os_cputime.nsecs_per_usec_recip, 1000);
 #endif
     rc = hal_timer_config(MYNEWT_VAL(OS_CPUTIME_TIMER_NUM), clock_freq);
     return rc;
@@ -76,7 +127,8 @@ os_cputime_nsecs_to_ticks(uint32_t nsecs)
 #if defined(OS_CPUTIME_FREQ_1MHZ)
     ticks = (nsecs + 999) / 1000;
 #else
-    ticks = ((nsecs * g_os_cputime.ticks_per_usec) + 999) / 1000;
+    ticks = os_cputime_recip_div(&g_os_cputime.nsecs_per_usec_recip,
+                                 (nsecs * g_os_cputime.ticks_per_usec) + 999);
 #endif
     return ticks;
 }
@@ -98,8 +150,7 @@ os_cputime_ticks_to_nsecs(uint32_t ticks)
 #if defined(OS_CPUTIME_FREQ_1MHZ)
     nsecs = ticks * 1000;
 #else
-    nsecs = ((ticks * 1000) + (g_os_cputime.ticks_per_usec - 1)) /
-            g_os_cputime.ticks_per_usec;
+    nsecs = os_cputime_div_tpu_ceil(ticks * 1000);
 #endif
 
     return nsecs;
@@ -189,8 +240,7 @@ os_cputime_ticks_to_usecs(uint32_t ticks)
 {
     uint32_t us;
 
-    us =  (ticks + (g_os_cputime.ticks_per_usec - 1)) /
-        g_os_cputime.ticks_per_usec;
+    us = os_cputime_div_tpu_ceil(ticks);
     return us;
 }
 #endif
@@ -32,6 +32,29 @@
 
 static STAILQ_HEAD(, os_dev) g_os_dev_list;
 
+#if MYNEWT_VAL(OS_DEV_HASH_SIZE) > 0
+/* Name index: devices hashed by name into OS_DEV_HASH_SIZE buckets. */
+static SLIST_HEAD(os_dev_hash_head, os_dev)
+    g_os_dev_hash[MYNEWT_VAL(OS_DEV_HASH_SIZE)];
+
+static struct os_dev_hash_head *
+os_dev_hash_bucket(const char *name)
+{
+    uint32_t h;
+
+    /* FNV-1a */
+    h = 2166136261u;
+    while (*name != '\0') {
+        h ^= (uint8_t)*name++;
+        h *= 16777619u;
+    }
+    return &g_os_dev_hash[h % MYNEWT_VAL(OS_DEV_HASH_SIZE)];
+}
+#endif
+
+/* Set once the OS_DEV_INIT_DEFERRED stage has been run. */
+static uint8_t os_dev_deferred_done;
+
 static int
 os_dev_init(struct os_dev *dev, char *name, uint8_t stage,
         uint8_t priority, os_dev_init_func_t od_init, void *arg)
@@ -42,6 +65,9 @@ os_dev_init(struct os_dev *dev, char *name, uint8_t stage,
     /* assume these are set after the fact. */
     dev->od_flags = 0;
     dev->od_open_ref = 0;
+#if MYNEWT_VAL(OS_DEV_INIT_PROFILE)
+    dev->od_init_usecs = 0;
+#endif
     dev->od_init = od_init;
     dev->od_init_arg = arg;
     memset(&dev->od_handlers, 0, sizeof(dev->od_handlers));
@@ -61,6 +87,10 @@ os_dev_add(struct os_dev *dev)
 {
     struct os_dev *cur_dev;
 
+#if MYNEWT_VAL(OS_DEV_HASH_SIZE) > 0
+    SLIST_INSERT_HEAD(os_dev_hash_bucket(dev->od_name), dev, od_hash_next);
+#endif
+
     /* If no devices present, insert into head */
     if (STAILQ_FIRST(&g_os_dev_list) == NULL) {
         STAILQ_INSERT_HEAD(&g_os_dev_list, dev, od_next);
@@ -102,9 +132,18 @@ os_dev_add(struct os_dev *dev)
 static int
 os_dev_initialize(struct os_dev *dev)
 {
+#if MYNEWT_VAL(OS_DEV_INIT_PROFILE)
+    uint32_t start;
+#endif
     int rc;
 
+#if MYNEWT_VAL(OS_DEV_INIT_PROFILE)
+    start = os_cputime_get32();
+#endif
     rc = dev->od_init(dev, dev->od_init_arg);
+#if MYNEWT_VAL(OS_DEV_INIT_PROFILE)
+    dev->od_init_usecs = os_cputime_ticks_to_usecs(os_cputime_get32() - start);
+#endif
     if (rc != 0) {
         if (dev->od_flags & OS_DEV_F_INIT_CRITICAL) {
             goto err;
@@ -148,7 +187,9 @@ os_dev_create(struct os_dev *dev, char *name, uint8_t stage,
         goto err;
     }
 
-    if (g_os_started) {
+    /* Deferred devices wait for their stage even once the OS is running. */
+    if (g_os_started &&
+        (stage != OS_DEV_INIT_DEFERRED || os_dev_deferred_done)) {
         rc = os_dev_initialize(dev);
     }
 err:
@@ -168,6 +209,10 @@ os_dev_initialize_all(uint8_t stage)
     struct os_dev *dev;
     int rc = 0;
 
+    if (stage == OS_DEV_INIT_DEFERRED) {
+        os_dev_deferred_done = 1;
+    }
+
     STAILQ_FOREACH(dev, &g_os_dev_list, od_next) {
         if (dev->od_stage == stage) {
             rc = os_dev_initialize(dev);
@@ -247,35 +292,48 @@ os_dev_lookup(char *name)
     struct os_dev *dev;
 
     dev = NULL;
+#if MYNEWT_VAL(OS_DEV_HASH_SIZE) > 0
+    SLIST_FOREACH(dev, os_dev_hash_bucket(name), od_hash_next) {
+        if (!strcmp(dev->od_name, name)) {
+            break;
+        }
+    }
+#else
     STAILQ_FOREACH(dev, &g_os_dev_list, od_next) {
         if (!strcmp(dev->od_name, name)) {
             break;
         }
     }
+#endif
     return (dev);
 }
 
 /**
- * Open a device.
+ * Walks the device list.
  *
- * @param dev The device to open
- * @param timo The timeout to open the device, if not specified.
- * @param arg The argument to the device open() call.
+ * @param prev The device returned by the previous call, or NULL to get the
+ *             first device.
  *
- * @return 0 on success, non-zero on failure.
+ * @return The next device, or NULL at the end of the list.
  */
 struct os_dev *
-os_dev_open(char *devname, uint32_t timo, void *arg)
+os_dev_get_next(struct os_dev *prev)
+{
+    if (prev == NULL) {
+        return STAILQ_FIRST(&g_os_dev_list);
+    }
+    return STAILQ_NEXT(prev, od_next);
+}
+
+/*
+ * Opens a device which has already been looked up.
+ */
+static struct os_dev *
+os_dev_open_dev(struct os_dev *dev, uint32_t timo, void *arg)
 {
-    struct os_dev *dev;
     os_sr_t sr;
     int rc;
 
-    dev = os_dev_lookup(devname);
-    if (dev == NULL) {
-        return (NULL);
-    }
-
     /* Device is not ready to be opened. */
     if ((dev->od_flags & OS_DEV_F_STATUS_READY) == 0) {
         return (NULL);
@@ -298,6 +356,54 @@ err:
     return (NULL);
 }
 
+/**
+ * Open a device.
+ *
+ * @param devname The name of the device to open
+ * @param timo The timeout to open the device, if not specified.
+ * @param arg The argument to the device open() call.
+ *
+ * @return The device on success, NULL on failure.
+ */
+struct os_dev *
+os_dev_open(char *devname, uint32_t timo, void *arg)
+{
+    struct os_dev *dev;
+
+    dev = os_dev_lookup(devname);
+    if (dev == NULL) {
+        return (NULL);
+    }
+
+    return os_dev_open_dev(dev, timo, arg);
+}
+
+/**
+ * Open a device, looking it up by name only the first time.  The device is
+ * remembered in *handle, which the caller keeps (NULL initially) and passes
+ * on later calls; devices are never removed, so the handle stays valid.
+ *
+ * @param handle Where the device found by a previous call is kept.
+ * @param devname The name of the device to open.
+ * @param timo The timeout to open the device, if not specified.
+ * @param arg The argument to the device open() call.
+ *
+ * @return The device on success, NULL on failure.
+ */
+struct os_dev *
+os_dev_open_cached(struct os_dev **handle, char *devname, uint32_t timo,
+        void *arg)
+{
+    if (*handle == NULL) {
+        *handle = os_dev_lookup(devname);
+        if (*handle == NULL) {
+            return (NULL);
+        }
+    }
+
+    return os_dev_open_dev(*handle, timo, arg);
+}
+
 /**
  * Close a device.
  *
@@ -338,6 +444,10 @@ void
 os_dev_reset(void)
 {
     STAILQ_INIT(&g_os_dev_list);
+#if MYNEWT_VAL(OS_DEV_HASH_SIZE) > 0
+    memset(g_os_dev_hash, 0, sizeof(g_os_dev_hash));
+#endif
+    os_dev_deferred_done = 0;
 }
 
 /**
@@ -31,6 +31,109 @@
 
 static struct os_eventq os_eventq_main;
 
+#if MYNEWT_VAL(OS_EVENTQ_STATS)
+static void
+os_eventq_stats_put(struct os_eventq *evq, struct os_event *ev)
+{
+    struct os_eventq_stats *st;
+
+    st = &evq->evq_stats;
+    ev->ev_put_time = os_time_get();
+    st->evqs_puts++;
+    st->evqs_depth++;
+    if (st->evqs_depth > st->evqs_depth_max) {
+        st->evqs_depth_max = st->evqs_depth;
+    }
+}
+
+static void
+os_eventq_stats_get(struct os_eventq *evq, struct os_event *ev)
+{
+    struct os_eventq_stats *st;
+    os_time_t lat;
+
+    st = &evq->evq_stats;
+    lat = os_time_get() - ev->ev_put_time;
+    st->evqs_gets++;
+    st->evqs_depth--;
+    st->evqs_lat_total += lat;
+    if (lat > st->evqs_lat_max) {
+        st->evqs_lat_max = lat;
+    }
+}
+
+static void
+os_eventq_stats_remove(struct os_eventq *evq)
+{
+    evq->evq_stats.evqs_depth--;
+}
+#else
+#define os_eventq_stats_put(evq, ev)
+#define os_eventq_stats_get(evq, ev)
+#define os_eventq_stats_remove(evq)
+#endif
+
+#if MYNEWT_VAL(OS_EVENTQ_SET)
+/**
+ * Marks a set member as non-empty, and wakes up the task waiting on the set.
+ * Must be called with interrupts disabled.
+ *
+ * @return 1 if a task was woken up, 0 otherwise
+ */
+static int
+os_eventq_set_ready(struct os_eventq *evq)
+{
+    struct os_eventq_set *set;
+    struct os_task *t;
+
+    set = evq->evq_set;
+    set->evs_ready |= 1UL << evq->evq_prio;
+
+    t = set->evs_task;
+    if (t == NULL) {
+        return 0;
+    }
+    set->evs_task = NULL;
+    if (t->t_state != OS_TASK_SLEEP) {
+        return 0;
+    }
+    os_sched_wakeup(t);
+    return 1;
+}
+
+/* Marks a set member as empty.  Must be called with interrupts disabled. */
+static void
+os_eventq_set_drained(struct os_eventq *evq)
+{
+    if (evq->evq_set && STAILQ_EMPTY(&evq->evq_list)) {
+        evq->evq_set->evs_ready &= ~(1UL << evq->evq_prio);
+    }
+}
+#else
+#define os_eventq_set_drained(evq)
+#endif
+
+/**
+ * Removes and returns the event at the head of a queue.  Must be called with
+ * interrupts disabled.
+ */
+static struct os_event *
+os_eventq_pull(struct os_eventq *evq)
+{
+    struct os_event *ev;
+
+    ev = STAILQ_FIRST(&evq->evq_list);
+    if (ev) {
+        STAILQ_REMOVE_HEAD(&evq->evq_list, ev_next);
+        ev->ev_queued = 0;
+        os_eventq_stats_get(evq, ev);
+        os_eventq_set_drained(evq);
+        os_trace_event(OS_TRACE_ID_EVQ_GET, (uintptr_t)ev);
+    }
+
+    return ev;
+}
+
 /**
  * Initialize the event queue
  *
@@ -72,6 +175,8 @@ os_eventq_put(struct os_eventq *evq, struct os_event *ev)
     /* Queue the event */
     ev->ev_queued = 1;
     STAILQ_INSERT_TAIL(&evq->evq_list, ev, ev_next);
+    os_eventq_stats_put(evq, ev);
+    os_trace_event(OS_TRACE_ID_EVQ_PUT, (uintptr_t)ev);
 
     resched = 0;
     if (evq->evq_task) {
@@ -89,6 +194,12 @@ os_eventq_put(struct os_eventq *evq, struct os_event *ev)
         evq->evq_task = NULL;
     }
 
+#if MYNEWT_VAL(OS_EVENTQ_SET)
+    if (evq->evq_set && os_eventq_set_ready(evq)) {
+        resched = 1;
+    }
+#endif
+
     OS_EXIT_CRITICAL(sr);
 
     if (resched) {
@@ -99,31 +210,30 @@ os_eventq_put(struct os_eventq *evq, struct os_event *ev)
 struct os_event *
 os_eventq_get_no_wait(struct os_eventq *evq)
 {
-    struct os_event *ev;
-
-    ev = STAILQ_FIRST(&evq->evq_list);
-    if (ev) {
-        STAILQ_REMOVE(&evq->evq_list, ev, os_event, ev_next);
-        ev->ev_queued = 0;
-    }
-
-    return ev;
+    return os_eventq_pull(evq);
 }
 
 /**
- * Pull a single item from an event queue.  This function blocks until there
- * is an item on the event queue to read.
+ * Pull up to 'max' items from an event queue in a single critical section.
+ * This function blocks until there is at least one item on the event queue
+ * to read.  As with os_eventq_get(), the returned events are no longer
+ * queued; removing one of them from the queue afterwards has no effect.
  *
- * @param evq The event queue to pull an event from
+ * @param evq The event queue to pull events from
+ * @param evs Array receiving the events, in queue order
+ * @param max The size of evs; must be at least 1
  *
- * @return The event from the queue
+ * @return The number of events written to evs
  */
-struct os_event *
-os_eventq_get(struct os_eventq *evq)
+int
+os_eventq_get_batch(struct os_eventq *evq, struct os_event **evs, int max)
 {
     struct os_event *ev;
     os_sr_t sr;
     struct os_task *t;
+    int n;
+
+    assert(max > 0);
 
     t = os_sched_get_current_task();
     if (evq->evq_owner != t) {
@@ -139,10 +249,15 @@ os_eventq_get(struct os_eventq *evq)
     }
     OS_ENTER_CRITICAL(sr);
 pull_one:
-    ev = STAILQ_FIRST(&evq->evq_list);
+    ev = os_eventq_pull(evq);
     if (ev) {
-        STAILQ_REMOVE(&evq->evq_list, ev, os_event, ev_next);
-        ev->ev_queued = 0;
+        evs[0] = ev;
+        for (n = 1; n < max; n++) {
+            evs[n] = os_eventq_pull(evq);
+            if (evs[n] == NULL) {
+                break;
+            }
+        }
         t->t_flags &= ~OS_TASK_FLAG_EVQ_WAIT;
     } else {
         evq->evq_task = t;
@@ -158,6 +273,24 @@ pull_one:
     }
     OS_EXIT_CRITICAL(sr);
 
+    return (n);
+}
+
+/**
+ * Pull a single item from an event queue.  This function blocks until there
+ * is an item on the event queue to read.
+ *
+ * @param evq The event queue to pull an event from
+ *
+ * @return The event from the queue
+ */
+struct os_event *
+os_eventq_get(struct os_eventq *evq)
+{
+    struct os_event *ev;
+
+    os_eventq_get_batch(evq, &ev, 1);
+
     return (ev);
 }
 
@@ -172,6 +305,42 @@ os_eventq_run(struct os_eventq *evq)
     ev->ev_cb(ev);
 }
 
+/**
+ * Pull up to 'max' events from an event queue in one critical section and
+ * dispatch them in order.  Blocks until at least one event is available.
+ *
+ * All events of the batch are dequeued before the first callback runs, so a
+ * callback that removes a later event of the same batch (for example by
+ * stopping its callout) does not prevent it from being dispatched.  Queues
+ * whose handlers cancel one another's events should use os_eventq_run().
+ *
+ * @param evq The event queue to process
+ * @param max The maximum number of events to dispatch; values above
+ *                OS_EVENTQ_BATCH_MAX, or less than 1, are treated as
+ *                OS_EVENTQ_BATCH_MAX.
+ *
+ * @return The number of events dispatched
+ */
+int
+os_eventq_run_batch(struct os_eventq *evq, int max)
+{
+    struct os_event *evs[MYNEWT_VAL(OS_EVENTQ_BATCH_MAX)];
+    int n;
+    int i;
+
+    if (max < 1 || max > MYNEWT_VAL(OS_EVENTQ_BATCH_MAX)) {
+        max = MYNEWT_VAL(OS_EVENTQ_BATCH_MAX);
+    }
+
+    n = os_eventq_get_batch(evq, evs, max);
+    for (i = 0; i < n; i++) {
+        assert(evs[i]->ev_cb != NULL);
+        evs[i]->ev_cb(evs[i]);
+    }
+
+    return (n);
+}
+
 static struct os_event *
 os_eventq_poll_0timo(struct os_eventq **evq, int nevqs)
 {
@@ -183,10 +352,8 @@ os_eventq_poll_0timo(struct os_eventq **evq, int nevqs)
 
     OS_ENTER_CRITICAL(sr);
     for (i = 0; i < nevqs; i++) {
-        ev = STAILQ_FIRST(&evq[i]->evq_list);
+        ev = os_eventq_pull(evq[i]);
         if (ev) {
-            STAILQ_REMOVE(&evq[i]->evq_list, ev, os_event, ev_next);
-            ev->ev_queued = 0;
             break;
         }
     }
@@ -228,10 +395,8 @@ os_eventq_poll(struct os_eventq **evq, int nevqs, os_time_t timo)
     cur_t = os_sched_get_current_task();
 
     for (i = 0; i < nevqs; i++) {
-        ev = STAILQ_FIRST(&evq[i]->evq_list);
+        ev = os_eventq_pull(evq[i]);
         if (ev) {
-            STAILQ_REMOVE(&evq[i]->evq_list, ev, os_event, ev_next);
-            ev->ev_queued = 0;
             /* Reset the items that already have an evq task set. */
             for (j = 0; j < i; j++) {
                 evq[j]->evq_task = NULL;
@@ -259,11 +424,7 @@ os_eventq_poll(struct os_eventq **evq, int nevqs, os_time_t timo)
          * we haven't found one.
          */
         if (!ev) {
-            ev = STAILQ_FIRST(&evq[i]->evq_list);
-            if (ev) {
-                STAILQ_REMOVE(&evq[i]->evq_list, ev, os_event, ev_next);
-                ev->ev_queued = 0;
-            }
+            ev = os_eventq_pull(evq[i]);
         }
         evq[i]->evq_task = NULL;
     }
@@ -273,6 +434,144 @@ has_event:
     return (ev);
 }
 
+#if MYNEWT_VAL(OS_EVENTQ_SET)
+/**
+ * Initialize an event queue set.  The set has no member queues.
+ *
+ * @param set The set to initialize
+ */
+void
+os_eventq_set_init(struct os_eventq_set *set)
+{
+    memset(set, 0, sizeof(*set));
+}
+
+/**
+ * Add an event queue to a set.  Each member has its own priority; events
+ * are taken from the highest priority non-empty queue first, and in queue
+ * order within it.  The queue may still be read directly, e.g. with
+ * os_eventq_get(), but only by the task serving the set.
+ *
+ * @param set  The set to add the queue to
+ * @param evq  The queue to add; must be initialized, and not in a set
+ * @param prio Priority of the queue in the set, 0 (highest) to
+ *                 OS_EVENTQ_SET_SIZE - 1; unique within the set.
+ *
+ * @return int
+ *      OS_INVALID_PARM     Priority out of range or already used
+ *      OS_EBUSY            Queue already belongs to a set
+ *      OS_OK               No error
+ */
+int
+os_eventq_set_add(struct os_eventq_set *set, struct os_eventq *evq,
+                  uint8_t prio)
+{
+    int rc;
+    os_sr_t sr;
+
+    if (prio >= MYNEWT_VAL(OS_EVENTQ_SET_SIZE)) {
+        return OS_INVALID_PARM;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    if (evq->evq_set) {
+        rc = OS_EBUSY;
+    } else if (set->evs_evqs[prio]) {
+        rc = OS_INVALID_PARM;
+    } else {
+        set->evs_evqs[prio] = evq;
+        evq->evq_set = set;
+        evq->evq_prio = prio;
+        if (!STAILQ_EMPTY(&evq->evq_list)) {
+            set->evs_ready |= 1UL << prio;
+        }
+        rc = OS_OK;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return rc;
+}
+
+/**
+ * Remove an event queue from a set.  Events on the queue stay queued.
+ *
+ * @param set The set to remove the queue from
+ * @param evq The queue to remove
+ *
+ * @return int
+ *      OS_INVALID_PARM     Queue is not in the set
+ *      OS_OK               No error
+ */
+int
+os_eventq_set_del(struct os_eventq_set *set, struct os_eventq *evq)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    if (evq->evq_set != set) {
+        OS_EXIT_CRITICAL(sr);
+        return OS_INVALID_PARM;
+    }
+    set->evs_evqs[evq->evq_prio] = NULL;
+    set->evs_ready &= ~(1UL << evq->evq_prio);
+    evq->evq_set = NULL;
+    OS_EXIT_CRITICAL(sr);
+
+    return OS_OK;
+}
+
+/**
+ * Pull the next event from a set: the head of the highest priority queue
+ * which has events.  Unlike os_eventq_poll(), the queues are not scanned;
+ * the wait and the wakeup cost the same whatever the number of queues.
+ *
+ * @param set  The set to pull an event from
+ * @param timo Timeout in ticks; 0 returns at once without involving the
+ *                 scheduler, OS_WAIT_FOREVER waits until an event arrives.
+ *
+ * @return An event, or NULL if none arrived before the timeout
+ */
+struct os_event *
+os_eventq_set_get(struct os_eventq_set *set, os_time_t timo)
+{
+    struct os_eventq *evq;
+    struct os_event *ev;
+    struct os_task *t;
+    os_sr_t sr;
+
+    t = os_sched_get_current_task();
+
+    OS_ENTER_CRITICAL(sr);
+    while (set->evs_ready == 0 && timo != 0) {
+        set->evs_task = t;
+        t->t_flags |= OS_TASK_FLAG_EVQ_WAIT;
+        os_sched_sleep(t, timo);
+        OS_EXIT_CRITICAL(sr);
+
+        os_sched(NULL);
+
+        OS_ENTER_CRITICAL(sr);
+        t->t_flags &= ~OS_TASK_FLAG_EVQ_WAIT;
+        set->evs_task = NULL;
+        if (timo != OS_WAIT_FOREVER) {
+            break;
+        }
+    }
+
+    ev = NULL;
+    if (set->evs_ready) {
+        evq = set->evs_evqs[__builtin_ctz(set->evs_ready)];
+        if (evq->evq_owner == NULL) {
+            evq->evq_owner = t;
+        }
+        ev = os_eventq_pull(evq);
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return ev;
+}
+#endif
+
 /**
  * Remove an event from the queue.
  *
@@ -287,6 +586,8 @@ os_eventq_remove(struct os_eventq *evq, struct os_event *ev)
     OS_ENTER_CRITICAL(sr);
     if (OS_EVENT_QUEUED(ev)) {
         STAILQ_REMOVE(&evq->evq_list, ev, os_event, ev_next);
+        os_eventq_stats_remove(evq);
+        os_eventq_set_drained(evq);
     }
     ev->ev_queued = 0;
     OS_EXIT_CRITICAL(sr);
@@ -19,8 +19,15 @@
 #include "syscfg/syscfg.h"
 
 #include <assert.h>
+#include <string.h>
 #include "os/os_mutex.h"
 #include "os/os_heap.h"
+#include "os/os_mempool.h"
+#include "os_priv.h"
+
+#if MYNEWT_VAL(OS_MALLOC_STATS)
+#include "stats/stats.h"
+#endif
 
 /**
  * @addtogroup OSKernel
@@ -33,6 +40,208 @@
 static struct os_mutex os_malloc_mutex;
 #endif
 
+#if MYNEWT_VAL(OS_MALLOC_STATS)
+STATS_SECT_START(os_malloc_stats)
+    STATS_SECT_ENTRY(slab_alloc)
+    STATS_SECT_ENTRY(slab_free)
+    STATS_SECT_ENTRY(slab_inuse_max)
+    STATS_SECT_ENTRY(heap_alloc)
+    STATS_SECT_ENTRY(heap_free)
+    STATS_SECT_ENTRY(heap_fallback)
+    STATS_SECT_ENTRY(heap_inuse)
+    STATS_SECT_ENTRY(heap_inuse_max)
+STATS_SECT_END
+
+STATS_SECT_DECL(os_malloc_stats) g_os_malloc_stats;
+
+STATS_NAME_START(os_malloc_stats)
+    STATS_NAME(os_malloc_stats, slab_alloc)
+    STATS_NAME(os_malloc_stats, slab_free)
+    STATS_NAME(os_malloc_stats, slab_inuse_max)
+    STATS_NAME(os_malloc_stats, heap_alloc)
+    STATS_NAME(os_malloc_stats, heap_free)
+    STATS_NAME(os_malloc_stats, heap_fallback)
+    STATS_NAME(os_malloc_stats, heap_inuse)
+    STATS_NAME(os_malloc_stats, heap_inuse_max)
+STATS_NAME_END(os_malloc_stats)
+
+#define OS_MALLOC_STATS_INC(__var) STATS_INC(g_os_malloc_stats, __var)
+#else
+#define OS_MALLOC_STATS_INC(__var)
+#endif
+
+/*
+ * Size classes for small allocations. Each class is a memory pool of
+ * fixed-size blocks, so frequently allocated small objects never fragment
+ * the heap. Classes must be configured in increasing order of size.
+ */
+#define OS_MALLOC_SLAB_DECL(__n)                                            \
+    static os_membuf_t os_malloc_slab_ ## __n ## _data[                     \
+        OS_MEMPOOL_SIZE(MYNEWT_VAL(OS_MALLOC_SLAB_ ## __n ## _COUNT),       \
+                        MYNEWT_VAL(OS_MALLOC_SLAB_ ## __n ## _SIZE))];      \
+    static struct os_mempool os_malloc_slab_ ## __n ## _pool
+
+#define OS_MALLOC_SLAB_ENTRY(__n)                                           \
+    {                                                                       \
+        .oms_pool = &os_malloc_slab_ ## __n ## _pool,                       \
+        .oms_data = os_malloc_slab_ ## __n ## _data,                        \
+        .oms_count = MYNEWT_VAL(OS_MALLOC_SLAB_ ## __n ## _COUNT),          \
+        .oms_size = MYNEWT_VAL(OS_MALLOC_SLAB_ ## __n ## _SIZE),            \
+        .oms_name = "os_malloc_" #__n,                                      \
+    },
+
+#if MYNEWT_VAL(OS_MALLOC_SLAB_1_COUNT) > 0
+OS_MALLOC_SLAB_DECL(1);
+#endif
+#if MYNEWT_VAL(OS_MALLOC_SLAB_2_COUNT) > 0
+OS_MALLOC_SLAB_DECL(2);
+#endif
+#if MYNEWT_VAL(OS_MALLOC_SLAB_3_COUNT) > 0
+OS_MALLOC_SLAB_DECL(3);
+#endif
+#if MYNEWT_VAL(OS_MALLOC_SLAB_4_COUNT) > 0
+OS_MALLOC_SLAB_DECL(4);
+#endif
+
+struct os_malloc_slab {
+    struct os_mempool *oms_pool;
+    os_membuf_t *oms_data;
+    int oms_count;
+    int oms_size;
+    char *oms_name;
+};
+
+static const struct os_malloc_slab os_malloc_slabs[] = {
+#if MYNEWT_VAL(OS_MALLOC_SLAB_1_COUNT) > 0
+    OS_MALLOC_SLAB_ENTRY(1)
+#endif
+#if MYNEWT_VAL(OS_MALLOC_SLAB_2_COUNT) > 0
+    OS_MALLOC_SLAB_ENTRY(2)
+#endif
+#if MYNEWT_VAL(OS_MALLOC_SLAB_3_COUNT) > 0
+    OS_MALLOC_SLAB_ENTRY(3)
+#endif
+#if MYNEWT_VAL(OS_MALLOC_SLAB_4_COUNT) > 0
+    OS_MALLOC_SLAB_ENTRY(4)
+#endif
+    { 0 }
+};
+
+#define OS_MALLOC_SLAB_CNT \
+    (sizeof(os_malloc_slabs) / sizeof(os_malloc_slabs[0]) - 1)
+
+/*
+ * Initialize the size class pools. Until this is called every allocation
+ * is served from the heap.
+ */
+void
+os_malloc_init(void)
+{
+    const struct os_malloc_slab *oms;
+    int rc;
+    int i;
+
+    for (i = 0; i < OS_MALLOC_SLAB_CNT; i++) {
+        oms = &os_malloc_slabs[i];
+        rc = os_mempool_init(oms->oms_pool, oms->oms_count, oms->oms_size,
+                             oms->oms_data, oms->oms_name);
+        assert(rc == 0);
+    }
+
+#if MYNEWT_VAL(OS_MALLOC_STATS)
+    /* Fails harmlessly if the group is already registered. */
+    (void)stats_init_and_reg(STATS_HDR(g_os_malloc_stats),
+                             STATS_SIZE_INIT_PARMS(g_os_malloc_stats,
+                                                   STATS_SIZE_32),
+                             STATS_NAME_INIT_PARMS(os_malloc_stats),
+                             "os_malloc");
+#endif
+
+#if MYNEWT_VAL(OS_SCHEDULING) && MYNEWT_VAL(OS_MUTEX_STATS)
+    os_mutex_register(&os_malloc_mutex, "os_malloc");
+#endif
+}
+
+/*
+ * Returns the size class the block at 'ptr' was allocated from, or NULL if
+ * it came from the heap.
+ */
+static const struct os_malloc_slab *
+os_malloc_slab_find(void *ptr)
+{
+    int i;
+
+    for (i = 0; i < OS_MALLOC_SLAB_CNT; i++) {
+        if (os_memblock_from(os_malloc_slabs[i].oms_pool, ptr)) {
+            return (&os_malloc_slabs[i]);
+        }
+    }
+
+    return (NULL);
+}
+
+/*
+ * Get a block from the smallest size class that fits 'size' and has a free
+ * block. Memory pools do their own locking, so the malloc mutex is not
+ * needed here.
+ */
+static void *
+os_malloc_slab_get(size_t size)
+{
+#if MYNEWT_VAL(OS_MALLOC_STATS)
+    int inuse;
+    int j;
+#endif
+    struct os_mempool *mp;
+    void *ptr;
+    int i;
+
+    for (i = 0; i < OS_MALLOC_SLAB_CNT; i++) {
+        if (size > os_malloc_slabs[i].oms_size) {
+            continue;
+        }
+        mp = os_malloc_slabs[i].oms_pool;
+        ptr = os_memblock_get(mp);
+        if (ptr) {
+            OS_MALLOC_STATS_INC(slab_alloc);
+#if MYNEWT_VAL(OS_MALLOC_STATS)
+            inuse = 0;
+            for (j = 0; j < OS_MALLOC_SLAB_CNT; j++) {
+                mp = os_malloc_slabs[j].oms_pool;
+                inuse += mp->mp_num_blocks - mp->mp_num_free;
+            }
+            if (inuse > g_os_malloc_stats.sslab_inuse_max) {
+                g_os_malloc_stats.sslab_inuse_max = inuse;
+            }
+#endif
+            return (ptr);
+        }
+    }
+
+    return (NULL);
+}
+
+static void
+os_malloc_heap_alloced(void)
+{
+    OS_MALLOC_STATS_INC(heap_alloc);
+#if MYNEWT_VAL(OS_MALLOC_STATS)
+    g_os_malloc_stats.sheap_inuse++;
+    if (g_os_malloc_stats.sheap_inuse > g_os_malloc_stats.sheap_inuse_max) {
+        g_os_malloc_stats.sheap_inuse_max = g_os_malloc_stats.sheap_inuse;
+    }
+#endif
+}
+
+static void
+os_malloc_heap_freed(void)
+{
+    OS_MALLOC_STATS_INC(heap_free);
+#if MYNEWT_VAL(OS_MALLOC_STATS)
+    g_os_malloc_stats.sheap_inuse--;
+#endif
+}
+
 static void
 os_malloc_lock(void)
 {
@@ -74,8 +283,20 @@ os_malloc(size_t size)
 {
     void *ptr;
 
+    ptr = os_malloc_slab_get(size);
+    if (ptr) {
+        return ptr;
+    }
+    if (OS_MALLOC_SLAB_CNT > 0 &&
+        size <= os_malloc_slabs[OS_MALLOC_SLAB_CNT - 1].oms_size) {
+        OS_MALLOC_STATS_INC(heap_fallback);
+    }
+
     os_malloc_lock();
     ptr = malloc(size);
+    if (ptr) {
+        os_malloc_heap_alloced();
+    }
     os_malloc_unlock();
 
     return ptr;
@@ -91,8 +312,22 @@ os_malloc(size_t size)
 void
 os_free(void *mem)
 {
+    const struct os_malloc_slab *oms;
+
+    if (!mem) {
+        return;
+    }
+
+    oms = os_malloc_slab_find(mem);
+    if (oms) {
+        os_memblock_put(oms->oms_pool, mem);
+        OS_MALLOC_STATS_INC(slab_free);
+        return;
+    }
+
     os_malloc_lock();
     free(mem);
+    os_malloc_heap_freed();
     os_malloc_unlock();
 }
 
@@ -104,15 +339,40 @@ os_free(void *mem)
  * @param ptr A pointer to the memory to allocate
  * @param size The number of contiguouos bytes to allocate at that location
  *
- * @return A pointer to memory of size, or NULL on failure to allocate
+ * @return A pointer to memory of size, or NULL on failure to allocate.
+ *         A size of 0 frees ptr and returns NULL.
  */
 void *
 os_realloc(void *ptr, size_t size)
 {
+    const struct os_malloc_slab *oms;
     void *new_ptr;
 
+    if (size == 0) {
+        os_free(ptr);
+        return NULL;
+    }
+
+    oms = ptr ? os_malloc_slab_find(ptr) : NULL;
+    if (oms) {
+        /* Still fits in the block. */
+        if (size <= oms->oms_size) {
+            return ptr;
+        }
+
+        new_ptr = os_malloc(size);
+        if (new_ptr) {
+            memcpy(new_ptr, ptr, oms->oms_size);
+            os_free(ptr);
+        }
+        return new_ptr;
+    }
+
     os_malloc_lock();
     new_ptr = realloc(ptr, size);
+    if (!ptr && new_ptr) {
+        os_malloc_heap_alloced();
+    }
     os_malloc_unlock();
 
     return new_ptr;
@@ -34,6 +34,7 @@
  */
 
 #include "os/os.h"
+#include "os_priv.h"
 
 #include <assert.h>
 #include <string.h>
@@ -49,6 +50,17 @@
 STAILQ_HEAD(, os_mbuf_pool) g_msys_pool_list =
     STAILQ_HEAD_INITIALIZER(g_msys_pool_list);
 
+#if MYNEWT_VAL(OS_MSYS_QUOTA)
+/* msys mbufs reserved by quotas and not yet taken by them. */
+static int os_msys_resv_out;
+#endif
+
+static struct os_mbuf *os_mbuf_get_owned(struct os_mbuf_pool *omp,
+                                         uint16_t leadingspace, void *ra);
+static struct os_mbuf *os_mbuf_get_pkthdr_owned(struct os_mbuf_pool *omp,
+                                                uint8_t user_pkthdr_len,
+                                                void *ra);
+
 /**
  * Initializes an mqueue.  An mqueue is a queue of mbufs that ties to a
  * particular task's event queue.  Mqueues form a helper API around a common
@@ -169,19 +181,22 @@ err:
 int
 os_msys_register(struct os_mbuf_pool *new_pool)
 {
+    struct os_mbuf_pool *prev;
     struct os_mbuf_pool *pool;
 
-    pool = NULL;
+    /* Keep the list sorted by buffer size, smallest first. */
+    prev = NULL;
     STAILQ_FOREACH(pool, &g_msys_pool_list, omp_next) {
-        if (new_pool->omp_databuf_len > pool->omp_databuf_len) {
+        if (new_pool->omp_databuf_len < pool->omp_databuf_len) {
             break;
         }
+        prev = pool;
     }
 
-    if (pool) {
-        STAILQ_INSERT_AFTER(&g_msys_pool_list, pool, new_pool, omp_next);
+    if (prev) {
+        STAILQ_INSERT_AFTER(&g_msys_pool_list, prev, new_pool, omp_next);
     } else {
-        STAILQ_INSERT_TAIL(&g_msys_pool_list, new_pool, omp_next);
+        STAILQ_INSERT_HEAD(&g_msys_pool_list, new_pool, omp_next);
     }
 
     return (0);
@@ -194,30 +209,240 @@ void
 os_msys_reset(void)
 {
     STAILQ_INIT(&g_msys_pool_list);
+#if MYNEWT_VAL(OS_MSYS_QUOTA)
+    os_msys_resv_out = 0;
+#endif
+}
+
+static struct os_mbuf *
+os_msys_get_from(struct os_mbuf_pool *pool, uint16_t len, int pkthdr,
+                 void *ra)
+{
+    if (pkthdr) {
+        return os_mbuf_get_pkthdr_owned(pool, len, ra);
+    } else {
+        return os_mbuf_get_owned(pool, len, ra);
+    }
 }
 
-static struct os_mbuf_pool *
-_os_msys_find_pool(uint16_t dsize)
+/*
+ * Gets an mbuf from the smallest msys pool whose buffers hold dsize bytes.
+ * If that pool is empty the larger ones are tried in turn, and then the
+ * smaller ones, largest first; the caller then gets a shorter mbuf and
+ * chains more as it appends.
+ */
+static struct os_mbuf *
+os_msys_get_fit(uint16_t dsize, uint16_t len, int pkthdr, void *ra)
 {
+    struct os_mbuf_pool *limit;
     struct os_mbuf_pool *pool;
+    struct os_mbuf_pool *prev;
+    struct os_mbuf *om;
 
-    pool = NULL;
+    limit = NULL;
     STAILQ_FOREACH(pool, &g_msys_pool_list, omp_next) {
-        if (dsize <= pool->omp_databuf_len) {
+        if (limit == NULL) {
+            if (dsize > pool->omp_databuf_len) {
+                continue;
+            }
+            limit = pool;
+        }
+        om = os_msys_get_from(pool, len, pkthdr, ra);
+        if (om != NULL) {
+            return (om);
+        }
+    }
+
+    /* Pools smaller than the fit; there are only a few, so rescan. */
+    while (limit != STAILQ_FIRST(&g_msys_pool_list)) {
+        prev = NULL;
+        STAILQ_FOREACH(pool, &g_msys_pool_list, omp_next) {
+            if (STAILQ_NEXT(pool, omp_next) == limit) {
+                prev = pool;
+                break;
+            }
+        }
+        if (prev == NULL) {
             break;
         }
+        om = os_msys_get_from(prev, len, pkthdr, ra);
+        if (om != NULL) {
+            return (om);
+        }
+        limit = prev;
+    }
+
+    return (NULL);
+}
+
+#if MYNEWT_VAL(OS_MSYS_QUOTA)
+/*
+ * Charges an mbuf to quota q, or checks that an mbuf for nobody in
+ * particular (q NULL) leaves the unused reservations free.  Must be called
+ * with interrupts disabled.
+ */
+static int
+os_msys_quota_admit(struct os_msys_quota *q)
+{
+    int own;
+
+    own = q != NULL && q->omq_used < q->omq_reserve;
+    if (!own && os_msys_num_free() <= os_msys_resv_out) {
+        goto denied;
+    }
+    if (q != NULL) {
+        if (q->omq_max != 0 && q->omq_used >= q->omq_max) {
+            goto denied;
+        }
+        q->omq_used++;
+        if (own) {
+            os_msys_resv_out--;
+        }
+    }
+    return (1);
+
+denied:
+    if (q != NULL) {
+        q->omq_denied++;
+    }
+    return (0);
+}
+
+/* Undoes os_msys_quota_admit(); called with interrupts disabled. */
+static void
+os_msys_quota_release(struct os_msys_quota *q)
+{
+    q->omq_used--;
+    if (q->omq_used < q->omq_reserve) {
+        os_msys_resv_out++;
+    }
+}
+
+static struct os_mbuf *
+os_msys_get_quota_fit(struct os_msys_quota *q, uint16_t dsize, uint16_t len,
+                      int pkthdr, void *ra)
+{
+    struct os_mbuf *om;
+    os_sr_t sr;
+
+    om = NULL;
+    OS_ENTER_CRITICAL(sr);
+    if (os_msys_quota_admit(q)) {
+        om = os_msys_get_fit(dsize, len, pkthdr, ra);
+        if (om == NULL) {
+            if (q != NULL) {
+                os_msys_quota_release(q);
+            }
+        } else {
+            om->om_quota = q;
+        }
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return (om);
+}
+
+/* Gets an mbuf to append to a chain charged to q, charging it as well. */
+static struct os_mbuf *
+os_mbuf_get_charged(struct os_mbuf_pool *omp, struct os_msys_quota *q)
+{
+    struct os_mbuf *om;
+    os_sr_t sr;
+
+    if (q == NULL) {
+        return os_mbuf_get(omp, 0);
+    }
+
+    om = NULL;
+    OS_ENTER_CRITICAL(sr);
+    if (os_msys_quota_admit(q)) {
+        om = os_mbuf_get(omp, 0);
+        if (om == NULL) {
+            os_msys_quota_release(q);
+        } else {
+            om->om_quota = q;
+        }
     }
+    OS_EXIT_CRITICAL(sr);
+
+    return (om);
+}
+
+/**
+ * Sets up a share of msys for one subsystem.  Mbufs got through the quota
+ * (os_msys_get_quota(), os_msys_get_pkthdr_quota(), and mbufs appended to
+ * them) are charged to it until freed.  The first 'reserve' of them are
+ * kept back from everybody else, and no more than 'max' are handed out.
+ *
+ * @param q The quota to initialize.
+ * @param reserve Number of mbufs kept back for this quota.
+ * @param max Most mbufs charged to the quota at once; 0 for no limit.
+ *
+ * @return 0 on success, OS_EINVAL if max is less than reserve.
+ */
+int
+os_msys_quota_init(struct os_msys_quota *q, uint16_t reserve, uint16_t max)
+{
+    os_sr_t sr;
 
-    if (!pool) {
-        pool = STAILQ_LAST(&g_msys_pool_list, os_mbuf_pool, omp_next);
+    if (max != 0 && max < reserve) {
+        return (OS_EINVAL);
     }
 
-    return (pool);
+    q->omq_reserve = reserve;
+    q->omq_max = max;
+    q->omq_used = 0;
+    q->omq_denied = 0;
+
+    OS_ENTER_CRITICAL(sr);
+    os_msys_resv_out += reserve;
+    OS_EXIT_CRITICAL(sr);
+
+    return (0);
 }
 
+/**
+ * os_msys_get(), charging the mbuf to a quota.
+ *
+ * @param q The quota to charge.
+ * @param dsize The estimated size of the data being stored in the mbuf
+ * @param leadingspace The amount of leadingspace to allocate in the mbuf
+ *
+ * @return A freshly allocated mbuf on success, NULL on failure or when the
+ *         quota does not allow it.
+ */
+struct os_mbuf *
+os_msys_get_quota(struct os_msys_quota *q, uint16_t dsize,
+                  uint16_t leadingspace)
+{
+    return os_msys_get_quota_fit(q, dsize, leadingspace, 0,
+                                 OS_MEMPOOL_CALLER());
+}
+
+/**
+ * os_msys_get_pkthdr(), charging the mbuf to a quota.
+ *
+ * @param q The quota to charge.
+ * @param dsize The estimated size of the data being stored in the mbuf
+ * @param user_hdr_len The length to allocate for the packet header structure
+ *
+ * @return A freshly allocated mbuf on success, NULL on failure or when the
+ *         quota does not allow it.
+ */
+struct os_mbuf *
+os_msys_get_pkthdr_quota(struct os_msys_quota *q, uint16_t dsize,
+                         uint16_t user_hdr_len)
+{
+    return os_msys_get_quota_fit(q,
+            dsize + user_hdr_len + sizeof(struct os_mbuf_pkthdr),
+            user_hdr_len, 1, OS_MEMPOOL_CALLER());
+}
+#endif
+
 /**
  * Allocate a mbuf from msys.  Based upon the data size requested,
- * os_msys_get() will choose the mbuf pool that has the best fit.
+ * os_msys_get() will choose the mbuf pool that has the best fit, falling
+ * back to other pools when that one is empty.
  *
  * @param dsize The estimated size of the data being stored in the mbuf
  * @param leadingspace The amount of leadingspace to allocate in the mbuf
@@ -228,18 +453,12 @@ _os_msys_find_pool(uint16_t dsize)
 struct os_mbuf *
 os_msys_get(uint16_t dsize, uint16_t leadingspace)
 {
-    struct os_mbuf *m;
-    struct os_mbuf_pool *pool;
-
-    pool = _os_msys_find_pool(dsize);
-    if (!pool) {
-        goto err;
-    }
-
-    m = os_mbuf_get(pool, leadingspace);
-    return (m);
-err:
-    return (NULL);
+#if MYNEWT_VAL(OS_MSYS_QUOTA)
+    return os_msys_get_quota_fit(NULL, dsize, leadingspace, 0,
+                                 OS_MEMPOOL_CALLER());
+#else
+    return os_msys_get_fit(dsize, leadingspace, 0, OS_MEMPOOL_CALLER());
+#endif
 }
 
 /**
@@ -255,19 +474,15 @@ struct os_mbuf *
 os_msys_get_pkthdr(uint16_t dsize, uint16_t user_hdr_len)
 {
     uint16_t total_pkthdr_len;
-    struct os_mbuf *m;
-    struct os_mbuf_pool *pool;
 
     total_pkthdr_len =  user_hdr_len + sizeof(struct os_mbuf_pkthdr);
-    pool = _os_msys_find_pool(dsize + total_pkthdr_len);
-    if (!pool) {
-        goto err;
-    }
-
-    m = os_mbuf_get_pkthdr(pool, user_hdr_len);
-    return (m);
-err:
-    return (NULL);
+#if MYNEWT_VAL(OS_MSYS_QUOTA)
+    return os_msys_get_quota_fit(NULL, dsize + total_pkthdr_len,
+                                 user_hdr_len, 1, OS_MEMPOOL_CALLER());
+#else
+    return os_msys_get_fit(dsize + total_pkthdr_len, user_hdr_len, 1,
+                           OS_MEMPOOL_CALLER());
+#endif
 }
 
 int
@@ -319,18 +534,12 @@ os_mbuf_pool_init(struct os_mbuf_pool *omp, struct os_mempool *mp,
     return (0);
 }
 
-/**
- * Get an mbuf from the mbuf pool.  The mbuf is allocated, and initialized
- * prior to being returned.
- *
- * @param omp The mbuf pool to return the packet from
- * @param leadingspace The amount of leadingspace to put before the data
- *     section by default.
- *
- * @return An initialized mbuf on success, and NULL on failure.
+/*
+ * os_mbuf_get(), with 'ra' recorded as the owner of the block under
+ * OS_MEMPOOL_OWNER.
  */
-struct os_mbuf *
-os_mbuf_get(struct os_mbuf_pool *omp, uint16_t leadingspace)
+static struct os_mbuf *
+os_mbuf_get_owned(struct os_mbuf_pool *omp, uint16_t leadingspace, void *ra)
 {
     struct os_mbuf *om;
 
@@ -338,7 +547,7 @@ os_mbuf_get(struct os_mbuf_pool *omp, uint16_t leadingspace)
         goto err;
     }
 
-    om = os_memblock_get(omp->omp_pool);
+    om = os_memblock_get_owned(omp->omp_pool, ra);
     if (!om) {
         goto err;
     }
@@ -349,6 +558,9 @@ os_mbuf_get(struct os_mbuf_pool *omp, uint16_t leadingspace)
     om->om_len = 0;
     om->om_data = (&om->om_databuf[0] + leadingspace);
     om->om_omp = omp;
+#if MYNEWT_VAL(OS_MSYS_QUOTA)
+    om->om_quota = NULL;
+#endif
 
     return (om);
 err:
@@ -356,15 +568,69 @@ err:
 }
 
 /**
- * Allocate a new packet header mbuf out of the os_mbuf_pool.
+ * Get an mbuf from the mbuf pool.  The mbuf is allocated, and initialized
+ * prior to being returned.
  *
- * @param omp The mbuf pool to allocate out of
- * @param user_pkthdr_len The packet header length to reserve for the caller.
+ * @param omp The mbuf pool to return the packet from
+ * @param leadingspace The amount of leadingspace to put before the data
+ *     section by default.
  *
- * @return A freshly allocated mbuf on success, NULL on failure.
+ * @return An initialized mbuf on success, and NULL on failure.
  */
 struct os_mbuf *
-os_mbuf_get_pkthdr(struct os_mbuf_pool *omp, uint8_t user_pkthdr_len)
+os_mbuf_get(struct os_mbuf_pool *omp, uint16_t leadingspace)
+{
+    return os_mbuf_get_owned(omp, leadingspace, OS_MEMPOOL_CALLER());
+}
+
+/**
+ * Get an mbuf that references an external buffer instead of carrying its own
+ * data.  No data is copied; the mbuf's data pointer refers to 'buf' directly.
+ * The buffer must stay valid, and must not change, until the mbuf is freed,
+ * at which point 'free_cb' is called.  Data in an external buffer is treated
+ * as read-only: the mbuf has no leading or trailing space, so prepending or
+ * appending to it allocates a new mbuf.
+ *
+ * @param omp The mbuf pool to allocate the mbuf header from
+ * @param buf The external buffer
+ * @param len The length of the external buffer
+ * @param free_cb Called when the mbuf is freed; can be NULL
+ * @param arg The argument to pass to free_cb
+ *
+ * @return An initialized mbuf on success, and NULL on failure.
+ */
+struct os_mbuf *
+os_mbuf_get_ext(struct os_mbuf_pool *omp, const void *buf, uint16_t len,
+                os_mbuf_ext_free_fn *free_cb, void *arg)
+{
+    struct os_mbuf_ext *ext;
+    struct os_mbuf *om;
+
+    /* The descriptor is kept in the data area of the mbuf. */
+    if (omp->omp_databuf_len < sizeof(struct os_mbuf_ext)) {
+        return NULL;
+    }
+
+    om = os_mbuf_get(omp, 0);
+    if (om == NULL) {
+        return NULL;
+    }
+
+    ext = OS_MBUF_EXT(om);
+    ext->ome_buf = buf;
+    ext->ome_free_cb = free_cb;
+    ext->ome_arg = arg;
+
+    om->om_flags |= OS_MBUF_F_EXT;
+    om->om_data = (uint8_t *)buf;
+    om->om_len = len;
+
+    return om;
+}
+
+static struct os_mbuf *
+os_mbuf_get_pkthdr_owned(struct os_mbuf_pool *omp, uint8_t user_pkthdr_len,
+                         void *ra)
 {
     uint16_t pkthdr_len;
     struct os_mbuf_pkthdr *pkthdr;
@@ -376,7 +642,7 @@ os_mbuf_get_pkthdr(struct os_mbuf_pool *omp, uint8_t user_pkthdr_len)
         return NULL;
     }
 
-    om = os_mbuf_get(omp, 0);
+    om = os_mbuf_get_owned(omp, 0, ra);
     if (om) {
         om->om_pkthdr_len = pkthdr_len;
         om->om_data += pkthdr_len;
@@ -390,6 +656,21 @@ os_mbuf_get_pkthdr(struct os_mbuf_pool *omp, uint8_t user_pkthdr_len)
     return om;
 }
 
+/**
+ * Allocate a new packet header mbuf out of the os_mbuf_pool.
+ *
+ * @param omp The mbuf pool to allocate out of
+ * @param user_pkthdr_len The packet header length to reserve for the caller.
+ *
+ * @return A freshly allocated mbuf on success, NULL on failure.
+ */
+struct os_mbuf *
+os_mbuf_get_pkthdr(struct os_mbuf_pool *omp, uint8_t user_pkthdr_len)
+{
+    return os_mbuf_get_pkthdr_owned(omp, user_pkthdr_len,
+                                    OS_MEMPOOL_CALLER());
+}
+
 /**
  * Release a mbuf back to the pool
  *
@@ -401,8 +682,28 @@ os_mbuf_get_pkthdr(struct os_mbuf_pool *omp, uint8_t user_pkthdr_len)
 int
 os_mbuf_free(struct os_mbuf *om)
 {
+    struct os_mbuf_ext *ext;
+#if MYNEWT_VAL(OS_MSYS_QUOTA)
+    os_sr_t sr;
+#endif
     int rc;
 
+    if (OS_MBUF_IS_EXT(om)) {
+        ext = OS_MBUF_EXT(om);
+        if (ext->ome_free_cb != NULL) {
+            ext->ome_free_cb(ext->ome_buf, ext->ome_arg);
+        }
+        om->om_flags &= ~OS_MBUF_F_EXT;
+    }
+
+#if MYNEWT_VAL(OS_MSYS_QUOTA)
+    if (om->om_quota != NULL) {
+        OS_ENTER_CRITICAL(sr);
+        os_msys_quota_release(om->om_quota);
+        OS_EXIT_CRITICAL(sr);
+    }
+#endif
+
     if (om->om_omp != NULL) {
         rc = os_memblock_put(om->om_omp->omp_pool, om);
         if (rc != 0) {
@@ -517,7 +818,11 @@ os_mbuf_append(struct os_mbuf *om, const void *data,  uint16_t len)
      * data into it, until data is exhausted.
      */
     while (remainder > 0) {
+#if MYNEWT_VAL(OS_MSYS_QUOTA)
+        new = os_mbuf_get_charged(omp, om->om_quota);
+#else
         new = os_mbuf_get(omp, 0);
+#endif
         if (!new) {
             break;
         }
@@ -546,6 +851,49 @@ err:
     return (rc);
 }
 
+/**
+ * Append an external buffer onto a mbuf chain without copying it.  A new mbuf
+ * referencing the buffer is allocated from the pool of 'om' and linked at the
+ * end of the chain; see os_mbuf_get_ext() for the rules that apply to the
+ * buffer.  On failure free_cb is not called.
+ *
+ * @param om      The mbuf chain to append the buffer onto
+ * @param buf     The external buffer
+ * @param len     The length of the external buffer
+ * @param free_cb Called when the referencing mbuf is freed; can be NULL
+ * @param arg     The argument to pass to free_cb
+ *
+ * @return 0 on success, and an error code on failure
+ */
+int
+os_mbuf_append_ext(struct os_mbuf *om, const void *buf, uint16_t len,
+                   os_mbuf_ext_free_fn *free_cb, void *arg)
+{
+    struct os_mbuf *last;
+    struct os_mbuf *ext;
+
+    if (om == NULL) {
+        return OS_EINVAL;
+    }
+
+    ext = os_mbuf_get_ext(om->om_omp, buf, len, free_cb, arg);
+    if (ext == NULL) {
+        return OS_ENOMEM;
+    }
+
+    last = om;
+    while (SLIST_NEXT(last, om_next) != NULL) {
+        last = SLIST_NEXT(last, om_next);
+    }
+    SLIST_NEXT(last, om_next) = ext;
+
+    if (OS_MBUF_IS_PKTHDR(om)) {
+        OS_MBUF_PKTHDR(om)->omp_len += len;
+    }
+
+    return 0;
+}
+
 /**
  * Reads data from one mbuf and appends it to another.  On error, the specified
  * data range may be partially appended.  Neither mbuf is required to contain
@@ -631,6 +979,20 @@ os_mbuf_dup(struct os_mbuf *om)
             }
             copy = head;
         }
+        if (OS_MBUF_IS_EXT(om)) {
+            /*
+             * The copy owns its data; an external buffer may not fit in a
+             * single mbuf, so spread it over as many as needed.
+             */
+            if (os_mbuf_append(copy, om->om_data, om->om_len) != 0) {
+                os_mbuf_free_chain(head);
+                goto err;
+            }
+            while (SLIST_NEXT(copy, om_next) != NULL) {
+                copy = SLIST_NEXT(copy, om_next);
+            }
+            continue;
+        }
         copy->om_flags = om->om_flags;
         copy->om_len = om->om_len;
         memcpy(OS_MBUF_DATA(copy, uint8_t *), OS_MBUF_DATA(om, uint8_t *),
@@ -1037,7 +1399,8 @@ os_mbuf_prepend_pullup(struct os_mbuf *om, uint16_t len)
  * Copies the contents of a flat buffer into an mbuf chain, starting at the
  * specified destination offset.  If the mbuf is too small for the source data,
  * it is extended as necessary.  If the destination mbuf contains a packet
- * header, the header length is updated.
+ * header, the header length is updated.  The destination range must not
+ * overlap data held in external buffers (see os_mbuf_get_ext()).
  *
  * @param omp                   The mbuf pool to allocate from.
  * @param om                    The mbuf chain to copy into.
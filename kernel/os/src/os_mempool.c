@@ -17,7 +17,9 @@
  * under the License.
  */
 
+#include "syscfg/syscfg.h"
 #include "os/os.h"
+#include "os_priv.h"
 
 #include <string.h>
 #include <assert.h>
@@ -34,9 +36,145 @@
 
 #define OS_MEMPOOL_TRUE_BLOCK_SIZE(bsize)   OS_ALIGN(bsize, OS_ALIGNMENT)
 
+/*
+ * The lock-free free list needs the exclusive access instructions, which are
+ * only present on ARMv7-M (Cortex-M3/M4/M7). Elsewhere fall back to the
+ * critical section implementation.
+ */
+#if MYNEWT_VAL(OS_MEMPOOL_LOCKFREE) && \
+    (defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__))
+#define OS_MEMPOOL_USE_LDREX    1
+#else
+#define OS_MEMPOOL_USE_LDREX    0
+#endif
+
 STAILQ_HEAD(, os_mempool) g_os_mempool_list =
     STAILQ_HEAD_INITIALIZER(g_os_mempool_list);
 
+#if MYNEWT_VAL(OS_MEMPOOL_OWNER)
+#define OS_MEMPOOL_OWNER_MAX    MYNEWT_VAL(OS_MEMPOOL_OWNER_MAX)
+
+/*
+ * Owners of the blocks currently handed out, hashed by block address with
+ * linear probing.  Blocks taken while the table is full are not tracked.
+ */
+static struct os_memblock_owner os_mempool_owners[OS_MEMPOOL_OWNER_MAX];
+static uint32_t os_mempool_owner_untracked;
+
+static int
+os_mempool_owner_home(const void *block)
+{
+    return (((uintptr_t)block / OS_ALIGNMENT) % OS_MEMPOOL_OWNER_MAX);
+}
+
+static void
+os_mempool_owner_add(struct os_mempool *mp, void *block, void *ra)
+{
+    struct os_memblock_owner *omo;
+    struct os_task *t;
+    os_sr_t sr;
+    int i;
+    int n;
+
+    t = os_sched_get_current_task();
+
+    OS_ENTER_CRITICAL(sr);
+    i = os_mempool_owner_home(block);
+    for (n = 0; n < OS_MEMPOOL_OWNER_MAX; n++) {
+        omo = &os_mempool_owners[i];
+        if (omo->omo_block == NULL) {
+            omo->omo_pool = mp;
+            omo->omo_block = block;
+            omo->omo_ra = ra;
+            omo->omo_taskid = t ? t->t_taskid : 0xff;
+            OS_EXIT_CRITICAL(sr);
+            return;
+        }
+        if (++i == OS_MEMPOOL_OWNER_MAX) {
+            i = 0;
+        }
+    }
+    os_mempool_owner_untracked++;
+    OS_EXIT_CRITICAL(sr);
+}
+
+static void
+os_mempool_owner_remove(void *block)
+{
+    struct os_memblock_owner *owners;
+    os_sr_t sr;
+    int hole;
+    int home;
+    int i;
+    int n;
+
+    owners = os_mempool_owners;
+
+    OS_ENTER_CRITICAL(sr);
+    i = os_mempool_owner_home(block);
+    for (n = 0; n < OS_MEMPOOL_OWNER_MAX; n++) {
+        if (owners[i].omo_block == block) {
+            break;
+        }
+        if (owners[i].omo_block == NULL) {
+            /* Not tracked. */
+            OS_EXIT_CRITICAL(sr);
+            return;
+        }
+        if (++i == OS_MEMPOOL_OWNER_MAX) {
+            i = 0;
+        }
+    }
+    if (n == OS_MEMPOOL_OWNER_MAX) {
+        OS_EXIT_CRITICAL(sr);
+        return;
+    }
+
+    /*
+     * Empty the slot, then move back any later entry of the same run whose
+     * home slot is not between the hole and itself, so that lookups never
+     * stop early at the hole.
+     */
+    hole = i;
+    owners[hole].omo_block = NULL;
+    while (1) {
+        if (++i == OS_MEMPOOL_OWNER_MAX) {
+            i = 0;
+        }
+        if (owners[i].omo_block == NULL) {
+            break;
+        }
+        home = os_mempool_owner_home(owners[i].omo_block);
+        if (hole <= i ? (hole < home && home <= i) :
+                        (hole < home || home <= i)) {
+            continue;
+        }
+        owners[hole] = owners[i];
+        owners[i].omo_block = NULL;
+        hole = i;
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+
+/* Forgets the blocks of a pool which is being initialized again. */
+static void
+os_mempool_owner_purge(struct os_mempool *mp)
+{
+    int i;
+
+    i = 0;
+    while (i < OS_MEMPOOL_OWNER_MAX) {
+        if (os_mempool_owners[i].omo_block != NULL &&
+            os_mempool_owners[i].omo_pool == mp) {
+            /* Removal can move another entry into this slot; look again. */
+            os_mempool_owner_remove(os_mempool_owners[i].omo_block);
+        } else {
+            i++;
+        }
+    }
+}
+#endif
+
 /**
  * os mempool init
  *
@@ -81,6 +219,7 @@ os_mempool_init(struct os_mempool *mp, int blocks, int block_size,
     mp->mp_block_size = block_size;
     mp->mp_num_free = blocks;
     mp->mp_min_free = blocks;
+    mp->mp_num_exhausted = 0;
     mp->mp_num_blocks = blocks;
     mp->mp_membuf_addr = (uint32_t)membuf;
     mp->name = name;
@@ -99,6 +238,10 @@ os_mempool_init(struct os_mempool *mp, int blocks, int block_size,
     /* Last one in the list should be NULL */
     SLIST_NEXT(block_ptr, mb_next) = NULL;
 
+#if MYNEWT_VAL(OS_MEMPOOL_OWNER)
+    os_mempool_owner_purge(mp);
+#endif
+
     STAILQ_INSERT_TAIL(&g_os_mempool_list, mp, mp_list);
 
     return OS_OK;
@@ -140,23 +283,98 @@ os_memblock_from(struct os_mempool *mp, void *block_addr)
     return 1;
 }
 
-/**
- * os memblock get
- *
- * Get a memory block from a memory pool
- *
- * @param mp Pointer to the memory pool
+#if OS_MEMPOOL_USE_LDREX
+/*
+ * The free list is a LIFO updated with LDREX/STREX. Any exception taken
+ * between the two clears the exclusive monitor, so if an interrupt handler
+ * gets or puts a block in the middle of an update the STREX fails and the
+ * update is retried. This also rules out the ABA problem a compare-and-swap
+ * based list would have, without having to tag the head pointer.
  *
- * @return void* Pointer to block if available; NULL otherwise
+ * The free counters are updated separately from the list, so they may lag
+ * the list by a block while an operation is in progress.
  */
-void *
-os_memblock_get(struct os_mempool *mp)
+static struct os_memblock *
+os_mempool_pop(struct os_mempool *mp)
+{
+    volatile uint32_t *head;
+    struct os_memblock *block;
+    struct os_memblock *next;
+
+    head = (volatile uint32_t *)&SLIST_FIRST(mp);
+    do {
+        block = (struct os_memblock *)__LDREXW(head);
+        if (block == NULL) {
+            __CLREX();
+            break;
+        }
+        next = SLIST_NEXT(block, mb_next);
+    } while (__STREXW((uint32_t)next, head));
+
+    return (block);
+}
+
+static void
+os_mempool_push(struct os_mempool *mp, struct os_memblock *block)
+{
+    volatile uint32_t *head;
+
+    head = (volatile uint32_t *)&SLIST_FIRST(mp);
+    do {
+        SLIST_NEXT(block, mb_next) = (struct os_memblock *)__LDREXW(head);
+    } while (__STREXW((uint32_t)block, head));
+}
+
+/*
+ * Atomically add 'delta' to a counter, returning the new value.
+ */
+static int
+os_mempool_count_add(int *cnt, int delta)
+{
+    int val;
+
+    do {
+        val = (int)__LDREXW((volatile uint32_t *)cnt) + delta;
+    } while (__STREXW((uint32_t)val, (volatile uint32_t *)cnt));
+
+    return (val);
+}
+
+static void
+os_mempool_min_update(struct os_mempool *mp, int num_free)
+{
+    volatile uint32_t *min;
+
+    min = (volatile uint32_t *)&mp->mp_min_free;
+    do {
+        if ((int)__LDREXW(min) <= num_free) {
+            __CLREX();
+            break;
+        }
+    } while (__STREXW((uint32_t)num_free, min));
+}
+#endif
+
+static inline void *
+os_memblock_take(struct os_mempool *mp)
 {
     os_sr_t sr;
     struct os_memblock *block;
 
     /* Check to make sure they passed in a memory pool (or something) */
     block = NULL;
+#if OS_MEMPOOL_USE_LDREX
+    (void)sr;
+    if (mp) {
+        block = os_mempool_pop(mp);
+        if (block) {
+            os_mempool_min_update(mp,
+                                  os_mempool_count_add(&mp->mp_num_free, -1));
+        } else {
+            os_mempool_count_add(&mp->mp_num_exhausted, 1);
+        }
+    }
+#else
     if (mp) {
         OS_ENTER_CRITICAL(sr);
         /* Check for any free */
@@ -172,13 +390,58 @@ os_memblock_get(struct os_mempool *mp)
             if (mp->mp_min_free > mp->mp_num_free) {
                 mp->mp_min_free = mp->mp_num_free;
             }
+        } else {
+            mp->mp_num_exhausted++;
         }
         OS_EXIT_CRITICAL(sr);
     }
+#endif
+
+    if (block == NULL) {
+        os_trace_event(OS_TRACE_ID_MEMPOOL_EMPTY, (uintptr_t)mp);
+    }
 
     return (void *)block;
 }
 
+/**
+ * os memblock get
+ *
+ * Get a memory block from a memory pool
+ *
+ * @param mp Pointer to the memory pool
+ *
+ * @return void* Pointer to block if available; NULL otherwise
+ */
+void *
+os_memblock_get(struct os_mempool *mp)
+{
+#if MYNEWT_VAL(OS_MEMPOOL_OWNER)
+    return os_memblock_get_owned(mp, __builtin_return_address(0));
+#else
+    return os_memblock_take(mp);
+#endif
+}
+
+#if MYNEWT_VAL(OS_MEMPOOL_OWNER)
+/*
+ * Gets a memory block, recording 'ra' as its owner; for wrappers such as
+ * os_mbuf_get() to pass their own caller.
+ */
+void *
+os_memblock_get_owned(struct os_mempool *mp, void *ra)
+{
+    void *block;
+
+    block = os_memblock_take(mp);
+    if (block != NULL) {
+        os_mempool_owner_add(mp, block, ra);
+    }
+
+    return (block);
+}
+#endif
+
 /**
  * os memblock put
  *
@@ -210,7 +473,16 @@ os_memblock_put(struct os_mempool *mp, void *block_addr)
         assert(block != (struct os_memblock *)block_addr);
     }
 #endif
+#if MYNEWT_VAL(OS_MEMPOOL_OWNER)
+    os_mempool_owner_remove(block_addr);
+#endif
+
     block = (struct os_memblock *)block_addr;
+#if OS_MEMPOOL_USE_LDREX
+    (void)sr;
+    os_mempool_push(mp, block);
+    os_mempool_count_add(&mp->mp_num_free, 1);
+#else
     OS_ENTER_CRITICAL(sr);
 
     /* Chain current free list pointer to this block; make this block head */
@@ -222,6 +494,7 @@ os_memblock_put(struct os_mempool *mp, void *block_addr)
     mp->mp_num_free++;
 
     OS_EXIT_CRITICAL(sr);
+#endif
 
     return OS_OK;
 }
@@ -246,11 +519,50 @@ os_mempool_info_get_next(struct os_mempool *mp, struct os_mempool_info *omi)
     omi->omi_num_blocks = cur->mp_num_blocks;
     omi->omi_num_free = cur->mp_num_free;
     omi->omi_min_free = cur->mp_min_free;
+    omi->omi_num_exhausted = cur->mp_num_exhausted;
     strncpy(omi->omi_name, cur->name, sizeof(omi->omi_name));
 
     return (cur);
 }
 
+#if MYNEWT_VAL(OS_MEMPOOL_OWNER)
+/**
+ * Walks the blocks currently taken from memory pools, and their owners.
+ *
+ * @param idx Walk position; set to 0 before the first call.
+ * @param omo Filled with the next block.
+ *
+ * @return 0 on success, OS_ENOENT when there are no more blocks.
+ */
+int
+os_memblock_owner_get_next(int *idx, struct os_memblock_owner *omo)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    while (*idx < OS_MEMPOOL_OWNER_MAX) {
+        if (os_mempool_owners[(*idx)++].omo_block != NULL) {
+            *omo = os_mempool_owners[*idx - 1];
+            OS_EXIT_CRITICAL(sr);
+            return (0);
+        }
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return (OS_ENOENT);
+}
+
+/**
+ * Returns the number of gets whose owner was not recorded because the owner
+ * table (OS_MEMPOOL_OWNER_MAX) was full.
+ */
+uint32_t
+os_memblock_owner_untracked(void)
+{
+    return (os_mempool_owner_untracked);
+}
+#endif
+
 
 /**
  *   @} OSMempool
@@ -17,8 +17,10 @@
  * under the License.
  */
 
+#include "syscfg/syscfg.h"
 #include "os/os.h"
 #include <assert.h>
+#include <string.h>
 
 /**
  * @addtogroup OSKernel
@@ -27,6 +29,83 @@
  *   @{
  */
 
+/*
+ * The fast path needs the exclusive access instructions, which are only
+ * present on ARMv7-M (Cortex-M3/M4/M7).
+ */
+#if MYNEWT_VAL(OS_MUTEX_FASTPATH) && \
+    (defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__))
+#define OS_MUTEX_USE_LDREX      1
+#else
+#define OS_MUTEX_USE_LDREX      0
+#endif
+
+#if MYNEWT_VAL(OS_MUTEX_STATS)
+static STAILQ_HEAD(, os_mutex) os_mutex_list =
+    STAILQ_HEAD_INITIALIZER(os_mutex_list);
+#endif
+
+#if OS_MUTEX_USE_LDREX
+/*
+ * Ownership is decided by mu_owner alone; the slow paths below test it
+ * rather than mu_level, which the fast path sets after claiming the mutex.
+ * A task switch between LDREX and STREX clears the exclusive monitor, so
+ * a competing task can only queue itself on the mutex, or boost the owner,
+ * in between if the STREX then fails.
+ *
+ * t_lockcnt and t_flags of the running task are only written by that task
+ * (os_mutex_release() touches them for the new owner while it sleeps), so
+ * they do not need protection here.
+ */
+static int
+os_mutex_fast_pend(struct os_mutex *mu, struct os_task *current)
+{
+    volatile uint32_t *owner;
+    uint8_t prio;
+
+    prio = current->t_prio;
+    owner = (volatile uint32_t *)&mu->mu_owner;
+    do {
+        if (__LDREXW(owner) != 0) {
+            __CLREX();
+            return (0);
+        }
+    } while (__STREXW((uint32_t)current, owner));
+
+    mu->mu_prio = prio;
+    mu->mu_level = 1;
+    current->t_lockcnt++;
+    current->t_flags |= OS_TASK_FLAG_LOCK_HELD;
+
+    return (1);
+}
+
+/*
+ * Releases a mutex whose nesting level already dropped to 0, provided no
+ * task waits for it and the owner was not boosted.
+ */
+static int
+os_mutex_fast_release(struct os_mutex *mu, struct os_task *current)
+{
+    volatile uint32_t *owner;
+
+    owner = (volatile uint32_t *)&mu->mu_owner;
+    do {
+        (void)__LDREXW(owner);
+        if (!SLIST_EMPTY(&mu->mu_head) || current->t_prio != mu->mu_prio) {
+            __CLREX();
+            return (0);
+        }
+    } while (__STREXW(0, owner));
+
+    if (--current->t_lockcnt == 0) {
+        current->t_flags &= ~OS_TASK_FLAG_LOCK_HELD;
+    }
+
+    return (1);
+}
+#endif
+
 
 /**
  * os mutex create
@@ -51,6 +130,9 @@ os_mutex_init(struct os_mutex *mu)
     mu->mu_level = 0;
     mu->mu_owner = NULL;
     SLIST_FIRST(&mu->mu_head) = NULL;
+#if MYNEWT_VAL(OS_MUTEX_STATS)
+    mu->mu_contended = 0;
+#endif
 
     return OS_OK;
 }
@@ -97,6 +179,12 @@ os_mutex_release(struct os_mutex *mu)
         return (OS_OK);
     }
 
+#if OS_MUTEX_USE_LDREX
+    if (os_mutex_fast_release(mu, current)) {
+        return (OS_OK);
+    }
+#endif
+
     OS_ENTER_CRITICAL(sr);
 
     /* Restore owner task's priority; resort list if different  */
@@ -178,11 +266,18 @@ os_mutex_pend(struct os_mutex *mu, uint32_t timeout)
         return OS_INVALID_PARM;
     }
 
+    current = os_sched_get_current_task();
+
+#if OS_MUTEX_USE_LDREX
+    if (os_mutex_fast_pend(mu, current)) {
+        return (OS_OK);
+    }
+#endif
+
     OS_ENTER_CRITICAL(sr);
 
     /* Is this owned? */
-    current = os_sched_get_current_task();
-    if (mu->mu_level == 0) {
+    if (mu->mu_owner == NULL) {
         mu->mu_owner = current;
         mu->mu_prio  = current->t_prio;
         current->t_lockcnt++;
@@ -199,6 +294,10 @@ os_mutex_pend(struct os_mutex *mu, uint32_t timeout)
         return OS_OK;
     }
 
+#if MYNEWT_VAL(OS_MUTEX_STATS)
+    mu->mu_contended++;
+#endif
+
     /* Mutex is not owned by us. If timeout is 0, return immediately */
     if (timeout == 0) {
         OS_EXIT_CRITICAL(sr);
@@ -232,6 +331,7 @@ os_mutex_pend(struct os_mutex *mu, uint32_t timeout)
     /* Set mutex pointer in task */
     current->t_obj = mu;
     current->t_flags |= OS_TASK_FLAG_MUTEX_WAIT;
+    os_trace_event(OS_TRACE_ID_MUTEX_WAIT, (uintptr_t)mu);
     os_sched_sleep(current, timeout);
     OS_EXIT_CRITICAL(sr);
 
@@ -250,7 +350,74 @@ os_mutex_pend(struct os_mutex *mu, uint32_t timeout)
 
     return rc;
 }
+#if MYNEWT_VAL(OS_MUTEX_STATS)
+/**
+ * Adds a mutex to the list reported by os_mutex_info_get_next().
+ * Registering a mutex again only updates its name.
+ *
+ * @param mu   The mutex to register; must stay valid from now on.
+ * @param name The name to report the mutex under.
+ */
+void
+os_mutex_register(struct os_mutex *mu, const char *name)
+{
+    struct os_mutex *cur;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    mu->mu_name = name;
+    STAILQ_FOREACH(cur, &os_mutex_list, mu_list) {
+        if (cur == mu) {
+            break;
+        }
+    }
+    if (cur == NULL) {
+        STAILQ_INSERT_TAIL(&os_mutex_list, mu, mu_list);
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+
+/**
+ * Get mutex statistics.  Iterates over the mutexes registered with
+ * os_mutex_register().
+ *
+ * @param mu  The previous mutex, or NULL to start from the first one.
+ * @param omi Filled in with information about the returned mutex.
+ *
+ * @return The next registered mutex, or NULL at the end of the list.
+ */
+struct os_mutex *
+os_mutex_info_get_next(struct os_mutex *mu, struct os_mutex_info *omi)
+{
+    struct os_mutex *cur;
+    struct os_task *t;
+    os_sr_t sr;
+
+    if (mu == NULL) {
+        cur = STAILQ_FIRST(&os_mutex_list);
+    } else {
+        cur = STAILQ_NEXT(mu, mu_list);
+    }
 
+    if (cur == NULL) {
+        return (NULL);
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    omi->omi_contended = cur->mu_contended;
+    omi->omi_level = cur->mu_level;
+    omi->omi_owner_id = cur->mu_owner ? cur->mu_owner->t_taskid : 0xff;
+    omi->omi_num_waiters = 0;
+    SLIST_FOREACH(t, &cur->mu_head, t_obj_list) {
+        omi->omi_num_waiters++;
+    }
+    OS_EXIT_CRITICAL(sr);
+    strncpy(omi->omi_name, cur->mu_name, sizeof(omi->omi_name) - 1);
+    omi->omi_name[sizeof(omi->omi_name) - 1] = '\0';
+
+    return (cur);
+}
+#endif
 
 /**
  *   @} OSMutex
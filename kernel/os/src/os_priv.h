@@ -38,6 +38,19 @@ extern struct os_task *g_current_task;
 extern struct os_callout_list g_callout_list;
 
 void os_msys_init(void);
+void os_sched_init_lists(void);
+void os_callout_init_lists(void);
+void os_callout_stats_init(void);
+void os_malloc_init(void);
+void os_sched_prof_start(void);
+
+#if MYNEWT_VAL(OS_MEMPOOL_OWNER)
+void *os_memblock_get_owned(struct os_mempool *mp, void *ra);
+#define OS_MEMPOOL_CALLER()         __builtin_return_address(0)
+#else
+#define os_memblock_get_owned(mp, ra)   os_memblock_get(mp)
+#define OS_MEMPOOL_CALLER()         NULL
+#endif
 
 #ifdef __cplusplus
 }
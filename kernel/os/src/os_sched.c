@@ -17,11 +17,13 @@
  * under the License.
  */
 
+#include "syscfg/syscfg.h"
 #include "os/os.h"
 #include "os/queue.h"
 #include "os_priv.h"
 
 #include <assert.h>
+#include <string.h>
 
 /**
  * @addtogroup OSKernel
@@ -38,6 +40,88 @@ struct os_task *g_current_task;
 extern os_time_t g_os_time;
 os_time_t g_os_last_ctx_sw_time;
 
+#if MYNEWT_VAL(OS_SCHED_PRIO_BITMAP)
+#define OS_SCHED_PRIO_CNT       (OS_TASK_PRI_LOWEST + 1)
+#define OS_SCHED_PRIO_WORDS     (OS_SCHED_PRIO_CNT / 32)
+
+/*
+ * The run list is kept sorted as usual, but instead of walking it to find
+ * the insertion point we remember the last task queued at each priority. A
+ * bit is set in the map for every priority that has at least one ready task,
+ * so the insertion point for a new priority is the tail of the closest
+ * occupied higher priority (lower number), found with CLZ.
+ */
+static uint32_t os_sched_prio_map[OS_SCHED_PRIO_WORDS];
+static struct os_task *os_sched_prio_tail[OS_SCHED_PRIO_CNT];
+
+/*
+ * Return the last ready task with a priority numerically lower than 'prio',
+ * or NULL if there is none.
+ */
+static struct os_task *
+os_sched_prio_prev_tail(uint8_t prio)
+{
+    uint32_t bits;
+    int word;
+
+    word = prio >> 5;
+    bits = os_sched_prio_map[word] & ((1UL << (prio & 31)) - 1);
+    while (bits == 0) {
+        if (word == 0) {
+            return (NULL);
+        }
+        word--;
+        bits = os_sched_prio_map[word];
+    }
+
+    return (os_sched_prio_tail[(word << 5) + 31 - __builtin_clz(bits)]);
+}
+#endif
+
+/*
+ * Initialize the run and sleep lists.
+ */
+void
+os_sched_init_lists(void)
+{
+    TAILQ_INIT(&g_os_run_list);
+    TAILQ_INIT(&g_os_sleep_list);
+#if MYNEWT_VAL(OS_SCHED_PRIO_BITMAP)
+    memset(os_sched_prio_map, 0, sizeof(os_sched_prio_map));
+    memset(os_sched_prio_tail, 0, sizeof(os_sched_prio_tail));
+#endif
+}
+
+/*
+ * Remove a task from the run list.
+ *
+ * NOTE: must be called with interrupts disabled!
+ */
+static void
+os_sched_run_list_remove(struct os_task *t)
+{
+#if MYNEWT_VAL(OS_SCHED_PRIO_BITMAP)
+    struct os_task *prev;
+    uint8_t prio;
+
+    /*
+     * Use the priority the task was queued with; t_prio may have already
+     * been changed by the caller (see os_sched_resort()).
+     */
+    prio = t->t_run_prio;
+    if (os_sched_prio_tail[prio] == t) {
+        prev = TAILQ_PREV(t, os_task_list, t_os_list);
+        if (prev && prev->t_run_prio == prio) {
+            os_sched_prio_tail[prio] = prev;
+        } else {
+            os_sched_prio_tail[prio] = NULL;
+            os_sched_prio_map[prio >> 5] &= ~(1UL << (prio & 31));
+        }
+    }
+#endif
+    TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+}
+
 /**
  * os sched insert
  *
@@ -63,6 +147,20 @@ os_sched_insert(struct os_task *t)
 
     entry = NULL;
     OS_ENTER_CRITICAL(sr);
+#if MYNEWT_VAL(OS_SCHED_PRIO_BITMAP)
+    entry = os_sched_prio_tail[t->t_prio];
+    if (!entry) {
+        entry = os_sched_prio_prev_tail(t->t_prio);
+        os_sched_prio_map[t->t_prio >> 5] |= 1UL << (t->t_prio & 31);
+    }
+    if (entry) {
+        TAILQ_INSERT_AFTER(&g_os_run_list, entry, t, t_os_list);
+    } else {
+        TAILQ_INSERT_HEAD(&g_os_run_list, t, t_os_list);
+    }
+    os_sched_prio_tail[t->t_prio] = t;
+    t->t_run_prio = t->t_prio;
+#else
     TAILQ_FOREACH(entry, &g_os_run_list, t_os_list) {
         if (t->t_prio < entry->t_prio) {
             break;
@@ -73,6 +171,7 @@ os_sched_insert(struct os_task *t)
     } else {
         TAILQ_INSERT_TAIL(&g_os_run_list, (struct os_task *) t, t_os_list);
     }
+#endif
     OS_EXIT_CRITICAL(sr);
 
     return (0);
@@ -80,12 +179,120 @@ err:
     return (rc);
 }
 
+#if MYNEWT_VAL(OS_TASK_PROFILE)
+#if MYNEWT_VAL(OS_TASK_PROFILE_CYCCNT) && \
+    (defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__))
+#define OS_TASK_PROF_USE_CYCCNT 1
+#else
+#define OS_TASK_PROF_USE_CYCCNT 0
+#include "os/os_cputime.h"
+#endif
+
+/* Profiler clock at the last context switch */
+static uint32_t os_task_prof_last;
+/* Time spent in instrumented ISRs since the last context switch */
+static uint32_t os_task_prof_isr_acc;
+static uint32_t os_task_prof_isr_start;
+static uint8_t os_task_prof_isr_nest;
+
+/**
+ * Returns the current value of the clock used by the task profiler: CPU
+ * cycles when OS_TASK_PROFILE_CYCCNT is in effect, os_cputime ticks
+ * otherwise.
+ */
+uint32_t
+os_task_prof_time(void)
+{
+#if OS_TASK_PROF_USE_CYCCNT
+    return (DWT->CYCCNT);
+#else
+    return (os_cputime_get32());
+#endif
+}
+
+/**
+ * Marks the start of an interrupt handler, so that its run time is not
+ * charged to the interrupted task.  Nested calls are counted; only the
+ * outermost pair is timed.
+ */
+void
+os_task_prof_isr_enter(void)
+{
+    if (os_task_prof_isr_nest++ == 0) {
+        os_task_prof_isr_start = os_task_prof_time();
+    }
+}
+
+/**
+ * Marks the end of an interrupt handler started with
+ * os_task_prof_isr_enter().
+ */
+void
+os_task_prof_isr_exit(void)
+{
+    if (--os_task_prof_isr_nest == 0) {
+        os_task_prof_isr_acc += os_task_prof_time() - os_task_prof_isr_start;
+    }
+}
+
+/*
+ * Called right before the first task runs; time before that is not
+ * charged to anybody.
+ */
+void
+os_sched_prof_start(void)
+{
+#if OS_TASK_PROF_USE_CYCCNT
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+    os_task_prof_last = os_task_prof_time();
+    os_task_prof_isr_acc = 0;
+}
+
+static void
+os_sched_prof_switch(struct os_task *prev_t)
+{
+    uint32_t now;
+    uint32_t elapsed;
+    uint32_t isr;
+
+    now = os_task_prof_time();
+    elapsed = now - os_task_prof_last;
+    os_task_prof_last = now;
+
+    isr = os_task_prof_isr_acc;
+    os_task_prof_isr_acc = 0;
+    if (isr > elapsed) {
+        isr = elapsed;
+    }
+
+    prev_t->t_prof_run += elapsed - isr;
+    prev_t->t_prof_isr += isr;
+    if (elapsed > prev_t->t_prof_max_run) {
+        prev_t->t_prof_max_run = elapsed;
+    }
+}
+#endif
+
 void
 os_sched_ctx_sw_hook(struct os_task *next_t)
 {
+    os_trace_event(OS_TRACE_ID_CTX_SW, next_t->t_taskid);
     next_t->t_ctx_sw_cnt++;
+#if MYNEWT_VAL(OS_TASK_STACK_HWM)
+    /* Saved stack pointer from when next_t was last switched out */
+    if (next_t->t_stackptr < next_t->t_stack_hwm &&
+        next_t->t_stackptr >= next_t->t_stacktop - next_t->t_stacksize) {
+        next_t->t_stack_hwm = next_t->t_stackptr;
+    }
+#endif
     g_current_task->t_run_time += g_os_time - g_os_last_ctx_sw_time;
     g_os_last_ctx_sw_time = g_os_time;
+#if MYNEWT_VAL(OS_TASK_PROFILE)
+    os_sched_prof_switch(g_current_task);
+#endif
 }
 
 /**
@@ -163,7 +370,7 @@ os_sched_sleep(struct os_task *t, os_time_t nticks)
 
     entry = NULL;
 
-    TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+    os_sched_run_list_remove(t);
     t->t_state = OS_TASK_SLEEP;
     t->t_next_wakeup = os_time_get() + nticks;
     if (nticks == OS_TIMEOUT_NEVER) {
@@ -206,7 +413,7 @@ os_sched_remove(struct os_task *t)
     if (t->t_state == OS_TASK_SLEEP) {
         TAILQ_REMOVE(&g_os_sleep_list, t, t_os_list);
     } else if (t->t_state == OS_TASK_READY) {
-        TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+        os_sched_run_list_remove(t);
     }
     t->t_next_wakeup = 0;
     t->t_flags |= OS_TASK_FLAG_NO_TIMEOUT;
@@ -353,7 +560,7 @@ void
 os_sched_resort(struct os_task *t)
 {
     if (t->t_state == OS_TASK_READY) {
-        TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+        os_sched_run_list_remove(t);
         os_sched_insert(t);
     }
 }
@@ -205,6 +205,7 @@ os_sem_pend(struct os_sem *sem, uint32_t timeout)
 
         /* We will put this task to sleep */
         sched = 1;
+        os_trace_event(OS_TRACE_ID_SEM_WAIT, (uintptr_t)sem);
         os_sched_sleep(current, timeout);
     }
 
@@ -132,6 +132,9 @@ os_task_init(struct os_task *t, const char *name, os_task_func_t func,
             stack_size);
     t->t_stacktop = &stack_bottom[stack_size];
     t->t_stacksize = stack_size;
+#if MYNEWT_VAL(OS_TASK_STACK_HWM)
+    t->t_stack_hwm = t->t_stackptr;
+#endif
 
     STAILQ_FOREACH(task, &g_os_task_list, t_os_task_list) {
         assert(t->t_prio != task->t_prio);
@@ -184,7 +187,7 @@ os_task_remove(struct os_task *t)
      * Disallow suspending tasks which are waiting on a lock
      */
     if (t->t_flags & (OS_TASK_FLAG_SEM_WAIT | OS_TASK_FLAG_MUTEX_WAIT |
-                                               OS_TASK_FLAG_EVQ_WAIT)) {
+                      OS_TASK_FLAG_EVQ_WAIT | OS_TASK_FLAG_NOTIFY_WAIT)) {
         return OS_EBUSY;
     }
 
@@ -207,6 +210,214 @@ os_task_remove(struct os_task *t)
     return rc;
 }
 
+/*
+ * Updates the notification word of a task, and wakes it up if it is
+ * blocked on a part of the word which is now non-zero.
+ */
+static os_error_t
+os_task_notify_update(struct os_task *t, uint32_t bits, int give)
+{
+    struct os_task *current;
+    int resched;
+    os_sr_t sr;
+
+    if (!g_os_started) {
+        return (OS_NOT_STARTED);
+    }
+
+    if (!t) {
+        return OS_INVALID_PARM;
+    }
+
+    resched = 0;
+    current = os_sched_get_current_task();
+
+    OS_ENTER_CRITICAL(sr);
+    if (give) {
+        if ((t->t_notify & OS_TASK_NOTIFY_CNT_MASK) !=
+            OS_TASK_NOTIFY_CNT_MASK) {
+            ++t->t_notify;
+        }
+    } else {
+        t->t_notify |= bits;
+    }
+
+    if ((t->t_flags & OS_TASK_FLAG_NOTIFY_WAIT) &&
+        (t->t_notify & t->t_notify_wait)) {
+        t->t_flags &= ~OS_TASK_FLAG_NOTIFY_WAIT;
+        os_sched_wakeup(t);
+        if (current->t_prio > t->t_prio) {
+            resched = 1;
+        }
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    if (resched) {
+        os_sched(NULL);
+    }
+
+    return OS_OK;
+}
+
+/*
+ * Blocks the current task until (t_notify & mask) is non-zero, or the
+ * timeout expires.  Returns the masked word, consumed according to 'take'.
+ */
+static os_error_t
+os_task_notify_pend(uint32_t mask, uint32_t timeout, int take,
+                    uint32_t *bits)
+{
+    struct os_task *current;
+    uint32_t got;
+    os_error_t rc;
+    os_sr_t sr;
+
+    if (!g_os_started) {
+        return (OS_NOT_STARTED);
+    }
+
+    current = os_sched_get_current_task();
+
+    OS_ENTER_CRITICAL(sr);
+    if ((current->t_notify & mask) == 0 && timeout != 0) {
+        current->t_notify_wait = mask;
+        current->t_flags |= OS_TASK_FLAG_NOTIFY_WAIT;
+        os_sched_sleep(current, (os_time_t)timeout);
+        OS_EXIT_CRITICAL(sr);
+
+        os_sched(NULL);
+
+        OS_ENTER_CRITICAL(sr);
+        current->t_flags &= ~OS_TASK_FLAG_NOTIFY_WAIT;
+    }
+
+    got = current->t_notify & mask;
+    if (got) {
+        if (take) {
+            --current->t_notify;
+        } else {
+            current->t_notify &= ~mask;
+        }
+        rc = OS_OK;
+    } else {
+        rc = OS_TIMEOUT;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    if (bits) {
+        *bits = got;
+    }
+
+    return rc;
+}
+
+/**
+ * Sets event bits in the notification word of a task.  If the task is
+ * waiting on any of them in os_task_notify_wait(), it is woken up.
+ *
+ * A notification is a cheaper alternative to a semaphore for signalling a
+ * single, known task; it needs no separate kernel object and may be sent
+ * from an interrupt.
+ *
+ * @param t    The task to notify
+ * @param bits Bits to set; only OS_TASK_NOTIFY_BITS_MASK bits should be used
+ *
+ * @return os_error_t
+ *      OS_NOT_STARTED      OS not started yet
+ *      OS_INVALID_PARM     Task passed in was NULL
+ *      OS_OK               No error
+ */
+os_error_t
+os_task_notify(struct os_task *t, uint32_t bits)
+{
+    return os_task_notify_update(t, bits & OS_TASK_NOTIFY_BITS_MASK, 0);
+}
+
+/**
+ * Waits for any of the given event bits to be set in the notification word
+ * of the current task.  The bits which were set are returned and cleared;
+ * other bits are left alone.
+ *
+ * @param mask    Event bits to wait for
+ * @param timeout Timeout, in OS ticks. 0 means do not wait if no bits are
+ *                set, OS_TIMEOUT_NEVER means wait forever.
+ * @param bits    Filled with the bits of 'mask' which were set; may be NULL
+ *
+ * @return os_error_t
+ *      OS_NOT_STARTED      OS not started yet
+ *      OS_TIMEOUT          None of the bits were set before the timeout
+ *      OS_OK               No error
+ */
+os_error_t
+os_task_notify_wait(uint32_t mask, uint32_t timeout, uint32_t *bits)
+{
+    return os_task_notify_pend(mask & OS_TASK_NOTIFY_BITS_MASK, timeout, 0,
+                               bits);
+}
+
+/**
+ * Clears event bits in the notification word of the current task, e.g. to
+ * discard a notification left over from a previous timed-out wait.
+ *
+ * @param mask Event bits to clear
+ *
+ * @return The value of those bits before they were cleared
+ */
+uint32_t
+os_task_notify_clear(uint32_t mask)
+{
+    struct os_task *current;
+    uint32_t prev;
+    os_sr_t sr;
+
+    mask &= OS_TASK_NOTIFY_BITS_MASK;
+    current = os_sched_get_current_task();
+
+    OS_ENTER_CRITICAL(sr);
+    prev = current->t_notify & mask;
+    current->t_notify &= ~mask;
+    OS_EXIT_CRITICAL(sr);
+
+    return prev;
+}
+
+/**
+ * Increments the notification counter of a task, waking it up if it is
+ * waiting in os_task_notify_take().  The counter saturates at
+ * OS_TASK_NOTIFY_CNT_MASK.
+ *
+ * @param t The task to notify
+ *
+ * @return os_error_t
+ *      OS_NOT_STARTED      OS not started yet
+ *      OS_INVALID_PARM     Task passed in was NULL
+ *      OS_OK               No error
+ */
+os_error_t
+os_task_notify_give(struct os_task *t)
+{
+    return os_task_notify_update(t, 0, 1);
+}
+
+/**
+ * Waits for the notification counter of the current task to be non-zero,
+ * then decrements it.  This behaves like pending on a counting semaphore
+ * owned by the task.
+ *
+ * @param timeout Timeout, in OS ticks. 0 means do not wait if the counter is
+ *                zero, OS_TIMEOUT_NEVER means wait forever.
+ *
+ * @return os_error_t
+ *      OS_NOT_STARTED      OS not started yet
+ *      OS_TIMEOUT          Counter still zero at the timeout
+ *      OS_OK               No error
+ */
+os_error_t
+os_task_notify_take(uint32_t timeout)
+{
+    return os_task_notify_pend(OS_TASK_NOTIFY_CNT_MASK, timeout, 1, NULL);
+}
+
 /**
  * Iterate through tasks, and return the following information about them:
  *
@@ -263,17 +474,37 @@ os_task_info_get_next(const struct os_task *prev, struct os_task_info *oti)
 
     top = next->t_stacktop;
     bottom = next->t_stacktop - next->t_stacksize;
+#if MYNEWT_VAL(OS_TASK_STACK_HWM)
+    /*
+     * Start from the deepest stack pointer sampled at context switches, and
+     * extend it through the used words directly below; deeper, unsampled
+     * use separated by untouched words is not seen.  Cost is proportional
+     * to the growth since the last call rather than to the stack size.
+     */
+    top = next->t_stack_hwm;
+    while (top > bottom && top[-1] != OS_STACK_PATTERN) {
+        --top;
+    }
+    next->t_stack_hwm = top;
+    bottom = top;
+#else
     while (bottom < top) {
         if (*bottom != OS_STACK_PATTERN) {
             break;
         }
         ++bottom;
     }
+#endif
 
     oti->oti_stkusage = (uint16_t) (next->t_stacktop - bottom);
     oti->oti_stksize = next->t_stacksize;
     oti->oti_cswcnt = next->t_ctx_sw_cnt;
     oti->oti_runtime = next->t_run_time;
+#if MYNEWT_VAL(OS_TASK_PROFILE)
+    oti->oti_prof_run = next->t_prof_run;
+    oti->oti_prof_isr = next->t_prof_isr;
+    oti->oti_prof_max_run = next->t_prof_max_run;
+#endif
     oti->oti_last_checkin = next->t_sanity_check.sc_checkin_last;
     oti->oti_next_checkin = next->t_sanity_check.sc_checkin_last +
         next->t_sanity_check.sc_checkin_itvl;
@@ -0,0 +1,162 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(OS_TRACE)
+
+#include <string.h>
+#include "os/os.h"
+#include "os/os_trace.h"
+#if MYNEWT_VAL(OS_TRACE_RTT)
+#include "rtt/SEGGER_RTT.h"
+#endif
+
+/**
+ * @addtogroup OSKernel
+ * @{
+ *   @defgroup OSTrace Event Trace
+ *   @{
+ */
+
+static uint32_t os_trace_lost;
+
+#if MYNEWT_VAL(OS_TRACE_RTT)
+/*
+ * Records are streamed to their own RTT up channel; they are fixed size, so
+ * the host needs no framing.  Records which don't fit are dropped whole.
+ */
+#define OS_TRACE_RTT_CHANNEL    MYNEWT_VAL(OS_TRACE_RTT_CHANNEL)
+
+static uint8_t os_trace_rtt_buf[MYNEWT_VAL(OS_TRACE_RTT_BUFFER_SIZE)];
+
+static void
+os_trace_put(const struct os_trace_rec *rec)
+{
+    /*
+     * Set the channel up on first use, and again if the RTT package has
+     * reset the control block since (events start before its sysinit).
+     */
+    if (_SEGGER_RTT.aUp[OS_TRACE_RTT_CHANNEL].pBuffer !=
+        (char *)os_trace_rtt_buf) {
+        SEGGER_RTT_ConfigUpBuffer(OS_TRACE_RTT_CHANNEL, "Trace",
+          os_trace_rtt_buf, sizeof(os_trace_rtt_buf),
+          SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+    }
+    if (SEGGER_RTT_WriteSkipNoLock(OS_TRACE_RTT_CHANNEL, rec,
+                                   sizeof(*rec)) == 0) {
+        os_trace_lost++;
+    }
+}
+#else
+/* Ring of the most recent records; the oldest are overwritten. */
+static struct os_trace_rec os_trace_ring[MYNEWT_VAL(OS_TRACE_ENTRIES)];
+static uint16_t os_trace_head;
+static uint16_t os_trace_cnt;
+
+static void
+os_trace_put(const struct os_trace_rec *rec)
+{
+    os_trace_ring[os_trace_head] = *rec;
+    if (++os_trace_head == MYNEWT_VAL(OS_TRACE_ENTRIES)) {
+        os_trace_head = 0;
+    }
+    if (os_trace_cnt < MYNEWT_VAL(OS_TRACE_ENTRIES)) {
+        os_trace_cnt++;
+    } else {
+        os_trace_lost++;
+    }
+}
+#endif
+
+/**
+ * Records a trace event, stamped with os_cputime and the running task.  Can
+ * be called from interrupt context.
+ *
+ * @param id The event id, OS_TRACE_ID_*.
+ * @param arg Event specific argument.
+ */
+void
+os_trace_event(uint8_t id, uint32_t arg)
+{
+    struct os_trace_rec rec;
+    struct os_task *t;
+    os_sr_t sr;
+
+    t = os_sched_get_current_task();
+    rec.otr_arg = arg;
+    rec.otr_id = id;
+    rec.otr_taskid = t ? t->t_taskid : 0xff;
+    rec.otr_rsvd = 0;
+
+    OS_ENTER_CRITICAL(sr);
+    rec.otr_ts = os_cputime_get32();
+    os_trace_put(&rec);
+    OS_EXIT_CRITICAL(sr);
+}
+
+/**
+ * Removes the oldest records from the trace ring.  With OS_TRACE_RTT the
+ * records go to the host as they happen, and none are kept to read here.
+ *
+ * @param recs Array receiving the records, oldest first.
+ * @param max The size of recs.
+ * @param lost Set to the number of records overwritten or dropped since the
+ *                 previous call.
+ *
+ * @return The number of records written to recs.
+ */
+int
+os_trace_read(struct os_trace_rec *recs, int max, uint32_t *lost)
+{
+    os_sr_t sr;
+    int n;
+#if !MYNEWT_VAL(OS_TRACE_RTT)
+    int idx;
+#endif
+
+    n = 0;
+    OS_ENTER_CRITICAL(sr);
+#if !MYNEWT_VAL(OS_TRACE_RTT)
+    idx = os_trace_head - os_trace_cnt;
+    if (idx < 0) {
+        idx += MYNEWT_VAL(OS_TRACE_ENTRIES);
+    }
+    while (n < max && os_trace_cnt > 0) {
+        recs[n++] = os_trace_ring[idx];
+        if (++idx == MYNEWT_VAL(OS_TRACE_ENTRIES)) {
+            idx = 0;
+        }
+        os_trace_cnt--;
+    }
+#endif
+    *lost = os_trace_lost;
+    os_trace_lost = 0;
+    OS_EXIT_CRITICAL(sr);
+
+    return (n);
+}
+
+/**
+ *   @} OSTrace
+ * @} OSKernel
+ */
+
+#endif
@@ -0,0 +1,41 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "testutil/testutil.h"
+#include "os/os.h"
+#include "os/os_cputime.h"
+#include "os_test_priv.h"
+
+void
+cputime_test_recip_check(uint32_t d, uint32_t x)
+{
+    struct os_cputime_recip r;
+    uint32_t q;
+
+    os_cputime_recip_init(&r, d);
+    q = os_cputime_recip_div(&r, x);
+    TEST_ASSERT_FATAL(q == x / d, "%lu / %lu: got %lu",
+                      (unsigned long)x, (unsigned long)d, (unsigned long)q);
+}
+
+TEST_CASE_DECL(os_cputime_test_recip)
+
+TEST_SUITE(os_cputime_test_suite)
+{
+    os_cputime_test_recip();
+}
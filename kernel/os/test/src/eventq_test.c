@@ -73,11 +73,24 @@ os_stack_t eventq_task_stack_poll_single_s[POLL_STACK_SIZE];
 struct os_task eventq_task_poll_single_r;
 os_stack_t eventq_task_stack_poll_single_r[POLL_STACK_SIZE];
 
+/* Setting the data for the batch get / run */
+struct os_task eventq_task_batch_s;
+os_stack_t eventq_task_stack_batch_s[MY_STACK_SIZE];
+
+struct os_task eventq_task_batch_r;
+os_stack_t eventq_task_stack_batch_r[MY_STACK_SIZE];
+
+static int eventq_batch_cb_cnt;
+
 TEST_CASE_DECL(event_test_sr)
 TEST_CASE_DECL(event_test_poll_sr)
 TEST_CASE_DECL(event_test_poll_timeout_sr)
 TEST_CASE_DECL(event_test_poll_single_sr)
 TEST_CASE_DECL(event_test_poll_0timo)
+TEST_CASE_DECL(event_test_batch_sr)
+#if MYNEWT_VAL(OS_EVENTQ_SET)
+TEST_CASE_DECL(event_test_set)
+#endif
 
 /* This is the task function  to send data */
 void
@@ -254,6 +267,61 @@ eventq_task_poll_single_receive(void *arg)
     os_test_restart();
 }
 
+/* Queues a burst of events while the receiver is blocked */
+void
+eventq_task_batch_send(void *arg)
+{
+    int i;
+
+    for (i = 0; i < SIZE_MULTI_EVENT; i++) {
+        os_eventq_put(&my_eventq, &m_event[i]);
+    }
+
+    /* This task sleeps until the receive task completes the test. */
+    os_time_delay(1000000);
+}
+
+static void
+eventq_batch_cb(struct os_event *ev)
+{
+    TEST_ASSERT((intptr_t)ev->ev_arg == eventq_batch_cb_cnt);
+    eventq_batch_cb_cnt++;
+}
+
+/* Pulls the burst in batches, then dispatches a second burst at once */
+void
+eventq_task_batch_receive(void *arg)
+{
+    struct os_event *evs[SIZE_MULTI_EVENT];
+    int n;
+    int i;
+
+    n = os_eventq_get_batch(&my_eventq, evs, SIZE_MULTI_EVENT - 1);
+    TEST_ASSERT_FATAL(n == SIZE_MULTI_EVENT - 1);
+    for (i = 0; i < n; i++) {
+        TEST_ASSERT(evs[i] == &m_event[i]);
+        TEST_ASSERT(!OS_EVENT_QUEUED(evs[i]));
+    }
+
+    n = os_eventq_get_batch(&my_eventq, evs, SIZE_MULTI_EVENT);
+    TEST_ASSERT_FATAL(n == 1);
+    TEST_ASSERT(evs[0] == &m_event[SIZE_MULTI_EVENT - 1]);
+
+    for (i = 0; i < SIZE_MULTI_EVENT; i++) {
+        m_event[i].ev_cb = eventq_batch_cb;
+        os_eventq_put(&my_eventq, &m_event[i]);
+    }
+
+    eventq_batch_cb_cnt = 0;
+    n = os_eventq_run_batch(&my_eventq, 0);
+    TEST_ASSERT(n == SIZE_MULTI_EVENT);
+    TEST_ASSERT(eventq_batch_cb_cnt == SIZE_MULTI_EVENT);
+    TEST_ASSERT(STAILQ_EMPTY(&my_eventq.evq_list));
+
+    /* Finishes the test when OS has been started */
+    os_test_restart();
+}
+
 TEST_SUITE(os_eventq_test_suite)
 {
     event_test_sr();
@@ -261,4 +329,8 @@ TEST_SUITE(os_eventq_test_suite)
     event_test_poll_timeout_sr();
     event_test_poll_single_sr();
     event_test_poll_0timo();
+    event_test_batch_sr();
+#if MYNEWT_VAL(OS_EVENTQ_SET)
+    event_test_set();
+#endif
 }
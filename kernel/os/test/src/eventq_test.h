@@ -96,6 +96,15 @@ extern os_stack_t eventq_task_stack_poll_single_s[POLL_STACK_SIZE];
 extern struct os_task eventq_task_poll_single_r;
 extern os_stack_t eventq_task_stack_poll_single_r[POLL_STACK_SIZE];
 
+/* Setting the data for the batch get / run */
+#define SEND_TASK_BATCH_PRIO            (INITIAL_EVENTQ_TASK_PRIO + 9)
+extern struct os_task eventq_task_batch_s;
+extern os_stack_t eventq_task_stack_batch_s[MY_STACK_SIZE];
+
+#define RECEIVE_TASK_BATCH_PRIO         (INITIAL_EVENTQ_TASK_PRIO + 10)
+extern struct os_task eventq_task_batch_r;
+extern os_stack_t eventq_task_stack_batch_r[MY_STACK_SIZE];
+
 void eventq_task_send(void *arg);
 void eventq_task_receive(void *arg);
 void eventq_task_poll_send(void *arg);
@@ -104,6 +113,8 @@ void eventq_task_poll_timeout_send(void *arg);
 void eventq_task_poll_timeout_receive(void *arg);
 void eventq_task_poll_single_send(void *arg);
 void eventq_task_poll_single_receive(void *arg);
+void eventq_task_batch_send(void *arg);
+void eventq_task_batch_receive(void *arg);
 
 #ifdef __cplusplus
 }
@@ -102,6 +102,10 @@ TEST_CASE_DECL(os_mbuf_test_pullup)
 TEST_CASE_DECL(os_mbuf_test_extend)
 TEST_CASE_DECL(os_mbuf_test_adj)
 TEST_CASE_DECL(os_mbuf_test_get_pkthdr)
+TEST_CASE_DECL(os_mbuf_test_ext)
+TEST_CASE_DECL(os_mbuf_test_copy)
+TEST_CASE_DECL(os_mbuf_test_msys)
+TEST_CASE_DECL(os_mbuf_test_bench)
 
 TEST_SUITE(os_mbuf_test_suite)
 {
@@ -112,4 +116,8 @@ TEST_SUITE(os_mbuf_test_suite)
     os_mbuf_test_extend();
     os_mbuf_test_adj();
     os_mbuf_test_get_pkthdr();
+    os_mbuf_test_ext();
+    os_mbuf_test_copy();
+    os_mbuf_test_msys();
+    os_mbuf_test_bench();
 }
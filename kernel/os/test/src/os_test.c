@@ -106,6 +106,8 @@ os_test_all(void)
 
     os_callout_test_suite();
 
+    os_cputime_test_suite();
+
     return tu_case_failed;
 }
 
@@ -26,6 +26,7 @@
 #include "os_test_priv.h"
 
 #include "callout_test.h"
+#include "cputime_test.h"
 
 #include "eventq_test.h"
 #include "mbuf_test.h"
@@ -72,6 +73,7 @@ int os_mutex_test_suite(void);
 int os_sem_test_suite(void);
 int os_eventq_test_suite(void);
 int os_callout_test_suite(void);
+int os_cputime_test_suite(void);
 
 #ifdef __cplusplus
 }
@@ -275,6 +275,78 @@ sem_test_4_task4_handler(void *arg)
     sem_test_pend_release_loop(0, 2000, 2000);
 }
 
+/*
+ * Task notifications: task1 waits on its counter and event bits while the
+ * lower priority task2 posts to them.
+ */
+void
+sem_test_notify_task1_handler(void *arg)
+{
+    os_error_t err;
+    uint32_t bits;
+
+    TEST_ASSERT(os_task_notify(NULL, 0x00010000) == OS_INVALID_PARM);
+    TEST_ASSERT(os_task_notify_give(NULL) == OS_INVALID_PARM);
+
+    /* Nothing posted yet */
+    err = os_task_notify_take(0);
+    TEST_ASSERT(err == OS_TIMEOUT);
+    err = os_task_notify_wait(0x00010000, 0, &bits);
+    TEST_ASSERT(err == OS_TIMEOUT && bits == 0);
+    err = os_task_notify_take(OS_TICKS_PER_SEC / 10);
+    TEST_ASSERT(err == OS_TIMEOUT);
+
+    /* task2 gives three times; the first one wakes us up */
+    err = os_task_notify_take(OS_TIMEOUT_NEVER);
+    TEST_ASSERT(err == OS_OK);
+
+    os_time_delay(OS_TICKS_PER_SEC / 10);
+    TEST_ASSERT(os_task_notify_take(0) == OS_OK);
+    TEST_ASSERT(os_task_notify_take(0) == OS_OK);
+    TEST_ASSERT(os_task_notify_take(0) == OS_TIMEOUT);
+
+    /* Only the waited-for bits are returned and cleared */
+    os_time_delay(OS_TICKS_PER_SEC / 5);
+    err = os_task_notify_wait(0x00050000, 0, &bits);
+    TEST_ASSERT(err == OS_OK && bits == 0x00050000,
+                "err=%d bits=0x%08lx", err, (unsigned long)bits);
+    TEST_ASSERT(os_task_notify_clear(0x00060000) == 0x00020000);
+    TEST_ASSERT(os_task_notify_clear(0x00060000) == 0);
+
+    /* Event bits never leak into the counter */
+    TEST_ASSERT(os_task_notify_take(0) == OS_TIMEOUT);
+
+    /* Block on a bit; task2 sets it later */
+    err = os_task_notify_wait(0x00080000, OS_TIMEOUT_NEVER, &bits);
+    TEST_ASSERT(err == OS_OK && bits == 0x00080000);
+
+#if MYNEWT_VAL(SELFTEST)
+    os_test_restart();
+#endif
+}
+
+void
+sem_test_notify_task2_handler(void *arg)
+{
+    os_time_delay(OS_TICKS_PER_SEC / 5);
+    TEST_ASSERT(os_task_notify_give(&task1) == OS_OK);
+    TEST_ASSERT(os_task_notify_give(&task1) == OS_OK);
+    TEST_ASSERT(os_task_notify_give(&task1) == OS_OK);
+
+    os_time_delay(OS_TICKS_PER_SEC / 5);
+    TEST_ASSERT(os_task_notify(&task1, 0x00010000) == OS_OK);
+    TEST_ASSERT(os_task_notify(&task1, 0x00020000) == OS_OK);
+    TEST_ASSERT(os_task_notify(&task1, 0x00040000) == OS_OK);
+    TEST_ASSERT(os_task_notify(&task1, 0x00000001) == OS_OK);
+
+    os_time_delay(OS_TICKS_PER_SEC / 5);
+    TEST_ASSERT(os_task_notify(&task1, 0x00080000) == OS_OK);
+
+    while (1) {
+        os_time_delay(OS_TICKS_PER_SEC);
+    }
+}
+
 void
 os_sem_tc_pretest(void* arg)
 {
@@ -322,6 +394,7 @@ TEST_CASE_DECL(os_sem_test_case_1)
 TEST_CASE_DECL(os_sem_test_case_2)
 TEST_CASE_DECL(os_sem_test_case_3)
 TEST_CASE_DECL(os_sem_test_case_4)
+TEST_CASE_DECL(os_sem_test_notify)
 
 TEST_SUITE(os_sem_test_suite)
 {
@@ -344,4 +417,8 @@ TEST_SUITE(os_sem_test_suite)
     tu_case_set_pre_cb(os_sem_tc_pretest, NULL);
     tu_case_set_post_cb(os_sem_tc_posttest, NULL);
     os_sem_test_case_4();
+
+    tu_case_set_pre_cb(os_sem_tc_pretest, NULL);
+    tu_case_set_post_cb(os_sem_tc_posttest, NULL);
+    os_sem_test_notify();
 }
@@ -48,6 +48,8 @@ void sem_test_3_task4_handler(void *arg);
 void sem_test_4_task2_handler(void *arg);
 void sem_test_4_task3_handler(void *arg);
 void sem_test_4_task4_handler(void *arg); 
+void sem_test_notify_task1_handler(void *arg);
+void sem_test_notify_task2_handler(void *arg);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,41 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+/* Test case for os_eventq_get_batch() and os_eventq_run_batch() */
+TEST_CASE(event_test_batch_sr)
+{
+    int i;
+
+    /* The sender runs first so the whole burst is queued at once */
+    os_task_init(&eventq_task_batch_s, "eventq_task_batch_s",
+        eventq_task_batch_send, NULL, SEND_TASK_BATCH_PRIO,
+        OS_WAIT_FOREVER, eventq_task_stack_batch_s, MY_STACK_SIZE);
+
+    os_task_init(&eventq_task_batch_r, "eventq_task_batch_r",
+        eventq_task_batch_receive, NULL, RECEIVE_TASK_BATCH_PRIO,
+        OS_WAIT_FOREVER, eventq_task_stack_batch_r, MY_STACK_SIZE);
+
+    os_eventq_init(&my_eventq);
+
+    for (i = 0; i < SIZE_MULTI_EVENT; i++) {
+        memset(&m_event[i], 0, sizeof m_event[i]);
+        m_event[i].ev_arg = (void *)(intptr_t)i;
+    }
+}
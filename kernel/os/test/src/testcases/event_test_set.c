@@ -0,0 +1,101 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+#if MYNEWT_VAL(OS_EVENTQ_SET)
+/**
+ * Tests event queue sets with a timeout of 0, which does not involve the
+ * scheduler.  Events must come out by queue priority, not by arrival.
+ */
+TEST_CASE(event_test_set)
+{
+    struct os_eventq_set set;
+    struct os_eventq other;
+    struct os_event *evp;
+    struct os_event ev[SIZE_MULTI_EVENT];
+    struct os_event ev2;
+    int i;
+
+    os_eventq_set_init(&set);
+    os_eventq_init(&other);
+    memset(ev, 0, sizeof ev);
+    memset(&ev2, 0, sizeof ev2);
+
+    /* multi_eventq[i] gets priority SIZE_MULTI_EVENT - 1 - i. */
+    for (i = 0; i < SIZE_MULTI_EVENT; i++) {
+        os_eventq_init(&multi_eventq[i]);
+        TEST_ASSERT(os_eventq_set_add(&set, &multi_eventq[i],
+                                      SIZE_MULTI_EVENT - 1 - i) == OS_OK);
+    }
+    TEST_ASSERT(os_eventq_set_add(&set, &other, 0) == OS_INVALID_PARM);
+    TEST_ASSERT(os_eventq_set_add(&set, &other,
+                                  MYNEWT_VAL(OS_EVENTQ_SET_SIZE)) ==
+                OS_INVALID_PARM);
+    TEST_ASSERT(os_eventq_set_add(&set, &multi_eventq[0],
+                                  SIZE_MULTI_EVENT) == OS_EBUSY);
+    TEST_ASSERT(os_eventq_set_del(&set, &other) == OS_INVALID_PARM);
+
+    TEST_ASSERT(os_eventq_set_get(&set, 0) == NULL);
+    TEST_ASSERT(set.evs_task == NULL);
+
+    /* Lowest priority queue first; two events on the highest one. */
+    for (i = 0; i < SIZE_MULTI_EVENT; i++) {
+        os_eventq_put(&multi_eventq[i], &ev[i]);
+    }
+    os_eventq_put(&multi_eventq[SIZE_MULTI_EVENT - 1], &ev2);
+
+    evp = os_eventq_set_get(&set, 0);
+    TEST_ASSERT(evp == &ev[SIZE_MULTI_EVENT - 1]);
+    evp = os_eventq_set_get(&set, 0);
+    TEST_ASSERT(evp == &ev2);
+    for (i = SIZE_MULTI_EVENT - 2; i >= 0; i--) {
+        evp = os_eventq_set_get(&set, 0);
+        TEST_ASSERT(evp == &ev[i]);
+    }
+    TEST_ASSERT(set.evs_ready == 0);
+    TEST_ASSERT(os_eventq_set_get(&set, 0) == NULL);
+
+    /* Removing the only queued event empties the member. */
+    os_eventq_put(&multi_eventq[1], &ev[1]);
+    TEST_ASSERT(set.evs_ready != 0);
+    os_eventq_remove(&multi_eventq[1], &ev[1]);
+    TEST_ASSERT(set.evs_ready == 0);
+
+    /* Reading a member directly keeps the set consistent. */
+    os_eventq_put(&multi_eventq[2], &ev[2]);
+    TEST_ASSERT(os_eventq_get_no_wait(&multi_eventq[2]) == &ev[2]);
+    TEST_ASSERT(os_eventq_set_get(&set, 0) == NULL);
+
+    /* A removed queue is no longer served; its events stay queued. */
+    os_eventq_put(&multi_eventq[0], &ev[0]);
+    TEST_ASSERT(os_eventq_set_del(&set, &multi_eventq[0]) == OS_OK);
+    TEST_ASSERT(os_eventq_set_get(&set, 0) == NULL);
+    TEST_ASSERT(os_eventq_get_no_wait(&multi_eventq[0]) == &ev[0]);
+
+    /* Adding a non-empty queue makes it ready at once. */
+    os_eventq_put(&other, &ev2);
+    TEST_ASSERT(os_eventq_set_add(&set, &other, SIZE_MULTI_EVENT) == OS_OK);
+    TEST_ASSERT(os_eventq_set_get(&set, 0) == &ev2);
+
+    /* The set lives on this stack; detach the shared queues from it. */
+    for (i = 1; i < SIZE_MULTI_EVENT; i++) {
+        TEST_ASSERT(os_eventq_set_del(&set, &multi_eventq[i]) == OS_OK);
+    }
+}
+#endif
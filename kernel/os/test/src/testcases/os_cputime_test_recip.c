@@ -0,0 +1,56 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+/*
+ * Division by reciprocal must match plain division, i.e. round down, for
+ * every dividend.  Check edge values and a pseudo-random sweep against a
+ * range of divisors, including cputime rates in MHz and the extremes.
+ */
+TEST_CASE(os_cputime_test_recip)
+{
+    static const uint32_t divisors[] = {
+        1, 2, 3, 5, 7, 10, 12, 16, 24, 48, 64, 96, 1000, 65537,
+        0x7fffffff, 0x80000000, 0x80000001, 0xffffffff,
+    };
+    uint32_t d;
+    uint32_t x;
+    int i;
+    int j;
+
+    for (i = 0; i < sizeof(divisors) / sizeof(divisors[0]); i++) {
+        d = divisors[i];
+
+        cputime_test_recip_check(d, 0);
+        cputime_test_recip_check(d, 1);
+        cputime_test_recip_check(d, d - 1);
+        cputime_test_recip_check(d, d);
+        cputime_test_recip_check(d, d + 1);
+        cputime_test_recip_check(d, 0xfffffffe);
+        cputime_test_recip_check(d, 0xffffffff);
+        cputime_test_recip_check(d, (0xffffffff / d) * d);
+        cputime_test_recip_check(d, (0xffffffff / d) * d - 1);
+
+        x = d;
+        for (j = 0; j < 10000; j++) {
+            x = x * 1664525 + 1013904223;
+            cputime_test_recip_check(d, x);
+        }
+    }
+}
@@ -0,0 +1,75 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+/* Not a functional test; reports the cost of common mbuf operations. */
+TEST_CASE(os_mbuf_test_bench)
+{
+    struct os_mbuf *om;
+    uint8_t buf[MBUF_TEST_DATA_LEN];
+    int rc;
+
+    os_mbuf_test_setup();
+
+    TEST_BENCH_BEGIN("get_free", 10000) {
+        om = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+        TEST_ASSERT_FATAL(om != NULL);
+        os_mbuf_free_chain(om);
+    } TEST_BENCH_END();
+
+    TEST_BENCH_BEGIN("append_copydata_1k", 1000) {
+        om = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+        TEST_ASSERT_FATAL(om != NULL);
+        rc = os_mbuf_append(om, os_mbuf_test_data, sizeof buf);
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = os_mbuf_copydata(om, 0, sizeof buf, buf);
+        TEST_ASSERT_FATAL(rc == 0);
+        os_mbuf_free_chain(om);
+    } TEST_BENCH_END();
+
+    TEST_BENCH_BEGIN("pullup_64", 1000) {
+        om = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+        TEST_ASSERT_FATAL(om != NULL);
+        rc = os_mbuf_append(om, os_mbuf_test_data, sizeof buf);
+        TEST_ASSERT_FATAL(rc == 0);
+        om = os_mbuf_pullup(om, 64);
+        TEST_ASSERT_FATAL(om != NULL);
+        os_mbuf_free_chain(om);
+    } TEST_BENCH_END();
+
+    /* Whole-chain copies to and from a flat buffer. */
+    om = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    rc = os_mbuf_append(om, os_mbuf_test_data, sizeof buf);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    TEST_BENCH_BEGIN("copydata_1k", 1000) {
+        os_mbuf_copydata(om, 0, sizeof buf, buf);
+    } TEST_BENCH_END();
+
+    TEST_BENCH_BEGIN("cmpf_1k", 1000) {
+        os_mbuf_cmpf(om, 0, buf, sizeof buf);
+    } TEST_BENCH_END();
+
+    TEST_BENCH_BEGIN("copyinto_1k", 1000) {
+        os_mbuf_copyinto(om, 0, buf, sizeof buf);
+    } TEST_BENCH_END();
+
+    os_mbuf_free_chain(om);
+}
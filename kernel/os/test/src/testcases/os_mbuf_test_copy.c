@@ -0,0 +1,81 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+#define OS_MBUF_TEST_COPY_LEN       (1000)
+
+static uint8_t os_mbuf_test_copy_buf[OS_MBUF_TEST_COPY_LEN + 8];
+
+TEST_CASE(os_mbuf_test_copy)
+{
+    static const int lens[] = { 1, 3, 4, 15, 16, 17, 64, 300, 900 };
+    struct os_mbuf *om;
+    uint8_t *dst;
+    int align;
+    int off;
+    int rc;
+    int i;
+
+    os_mbuf_test_setup();
+
+    om = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+
+    rc = os_mbuf_append(om, os_mbuf_test_data, OS_MBUF_TEST_COPY_LEN);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT_FATAL(OS_MBUF_PKTLEN(om) == OS_MBUF_TEST_COPY_LEN);
+
+    /*
+     * Exercise every source / destination alignment combination, across
+     * mbuf boundaries, against the flat reference data.
+     */
+    for (off = 0; off < 8; off++) {
+        for (align = 0; align < 4; align++) {
+            dst = os_mbuf_test_copy_buf + align;
+            for (i = 0; i < sizeof lens / sizeof lens[0]; i++) {
+                memset(os_mbuf_test_copy_buf, 0xff,
+                       sizeof os_mbuf_test_copy_buf);
+
+                rc = os_mbuf_copydata(om, off, lens[i], dst);
+                TEST_ASSERT_FATAL(rc == 0);
+                TEST_ASSERT(memcmp(dst, os_mbuf_test_data + off,
+                                   lens[i]) == 0);
+                TEST_ASSERT(dst[lens[i]] == 0xff);
+
+                rc = os_mbuf_cmpf(om, off, dst, lens[i]);
+                TEST_ASSERT(rc == 0);
+
+                dst[lens[i] - 1] ^= 0x01;
+                rc = os_mbuf_cmpf(om, off, dst, lens[i]);
+                TEST_ASSERT(rc != 0);
+                dst[lens[i] - 1] ^= 0x01;
+
+                /* Write back the same bytes; the chain must not change. */
+                rc = os_mbuf_copyinto(om, off, dst, lens[i]);
+                TEST_ASSERT_FATAL(rc == 0);
+                TEST_ASSERT(OS_MBUF_PKTLEN(om) == OS_MBUF_TEST_COPY_LEN);
+                TEST_ASSERT(os_mbuf_cmpf(om, 0, os_mbuf_test_data,
+                                         OS_MBUF_TEST_COPY_LEN) == 0);
+            }
+        }
+    }
+
+    rc = os_mbuf_free_chain(om);
+    TEST_ASSERT_FATAL(rc == 0);
+}
@@ -0,0 +1,100 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+static int os_mbuf_test_ext_freed;
+
+static void
+os_mbuf_test_ext_free_cb(const void *buf, void *arg)
+{
+    TEST_ASSERT(buf == os_mbuf_test_data);
+    TEST_ASSERT(arg == &os_mbuf_test_ext_freed);
+
+    os_mbuf_test_ext_freed++;
+}
+
+TEST_CASE(os_mbuf_test_ext)
+{
+    struct os_mbuf *om;
+    struct os_mbuf *dup;
+    struct os_mbuf *ext;
+    int rc;
+
+    os_mbuf_test_setup();
+    os_mbuf_test_ext_freed = 0;
+
+    /* An external buffer larger than a pool buffer is referenced as is. */
+    ext = os_mbuf_get_ext(&os_mbuf_pool, os_mbuf_test_data, 600,
+                          os_mbuf_test_ext_free_cb, &os_mbuf_test_ext_freed);
+    TEST_ASSERT_FATAL(ext != NULL);
+    TEST_ASSERT(OS_MBUF_IS_EXT(ext));
+    TEST_ASSERT(ext->om_data == os_mbuf_test_data);
+    TEST_ASSERT(ext->om_len == 600);
+    TEST_ASSERT(OS_MBUF_LEADINGSPACE(ext) == 0);
+    TEST_ASSERT(OS_MBUF_TRAILINGSPACE(ext) == 0);
+
+    rc = os_mbuf_free(ext);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(os_mbuf_test_ext_freed == 1);
+
+    /* Header in a regular mbuf, payload in an external buffer. */
+    om = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+
+    rc = os_mbuf_append(om, os_mbuf_test_data, 10);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = os_mbuf_append_ext(om, os_mbuf_test_data, 600,
+                            os_mbuf_test_ext_free_cb,
+                            &os_mbuf_test_ext_freed);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == 610);
+
+    ext = SLIST_NEXT(om, om_next);
+    TEST_ASSERT_FATAL(ext != NULL);
+    TEST_ASSERT(ext->om_data == os_mbuf_test_data);
+
+    /* Appending after the external buffer must not write into it. */
+    rc = os_mbuf_append(om, os_mbuf_test_data + 600, 20);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == 630);
+    TEST_ASSERT(ext->om_len == 600);
+    TEST_ASSERT(SLIST_NEXT(ext, om_next) != NULL);
+
+    /* A duplicate owns copies of the external data. */
+    dup = os_mbuf_dup(om);
+    TEST_ASSERT_FATAL(dup != NULL);
+    TEST_ASSERT(OS_MBUF_PKTLEN(dup) == 630);
+    for (ext = dup; ext != NULL; ext = SLIST_NEXT(ext, om_next)) {
+        TEST_ASSERT(!OS_MBUF_IS_EXT(ext));
+    }
+    TEST_ASSERT(os_mbuf_cmpf(dup, 0, os_mbuf_test_data, 10) == 0);
+    TEST_ASSERT(os_mbuf_cmpf(dup, 10, os_mbuf_test_data, 600) == 0);
+    TEST_ASSERT(os_mbuf_cmpf(dup, 610, os_mbuf_test_data + 600, 20) == 0);
+
+    rc = os_mbuf_free_chain(dup);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(os_mbuf_test_ext_freed == 1);
+
+    rc = os_mbuf_free_chain(om);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(os_mbuf_test_ext_freed == 2);
+
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == MBUF_TEST_POOL_BUF_COUNT);
+}
@@ -0,0 +1,87 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+#define MBUF_TEST_SMALL_BUF_SIZE    (64)
+#define MBUF_TEST_SMALL_BUF_COUNT   (2)
+
+static os_membuf_t os_mbuf_test_small_membuf[
+    OS_MEMPOOL_SIZE(MBUF_TEST_SMALL_BUF_COUNT, MBUF_TEST_SMALL_BUF_SIZE)];
+static struct os_mempool os_mbuf_test_small_mempool;
+static struct os_mbuf_pool os_mbuf_test_small_pool;
+
+TEST_CASE(os_mbuf_test_msys)
+{
+    struct os_mbuf *small[MBUF_TEST_SMALL_BUF_COUNT];
+    struct os_mbuf *big[MBUF_TEST_POOL_BUF_COUNT];
+    struct os_mbuf *m;
+    int rc;
+    int i;
+
+    os_mbuf_test_setup();
+
+    rc = os_mempool_init(&os_mbuf_test_small_mempool,
+                         MBUF_TEST_SMALL_BUF_COUNT, MBUF_TEST_SMALL_BUF_SIZE,
+                         os_mbuf_test_small_membuf, "mbuf_small");
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_mbuf_pool_init(&os_mbuf_test_small_pool,
+                           &os_mbuf_test_small_mempool,
+                           MBUF_TEST_SMALL_BUF_SIZE,
+                           MBUF_TEST_SMALL_BUF_COUNT);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Registered largest first; msys still picks the best fit. */
+    os_msys_reset();
+    os_msys_register(&os_mbuf_pool);
+    os_msys_register(&os_mbuf_test_small_pool);
+
+    for (i = 0; i < MBUF_TEST_SMALL_BUF_COUNT; i++) {
+        small[i] = os_msys_get(10, 0);
+        TEST_ASSERT_FATAL(small[i] != NULL);
+        TEST_ASSERT(small[i]->om_omp == &os_mbuf_test_small_pool);
+    }
+
+    /* Small pool empty: falls back to the larger one. */
+    m = os_msys_get(10, 0);
+    TEST_ASSERT_FATAL(m != NULL);
+    TEST_ASSERT(m->om_omp == &os_mbuf_pool);
+    os_mbuf_free(m);
+
+    /* Large requests come from the large pool... */
+    for (i = 0; i < MBUF_TEST_POOL_BUF_COUNT; i++) {
+        big[i] = os_msys_get(200, 0);
+        TEST_ASSERT_FATAL(big[i] != NULL);
+        TEST_ASSERT(big[i]->om_omp == &os_mbuf_pool);
+    }
+
+    /* ...and from a smaller pool once it is empty. */
+    TEST_ASSERT(os_msys_get(200, 0) == NULL);
+    os_mbuf_free(small[0]);
+    small[0] = os_msys_get(200, 0);
+    TEST_ASSERT_FATAL(small[0] != NULL);
+    TEST_ASSERT(small[0]->om_omp == &os_mbuf_test_small_pool);
+
+    for (i = 0; i < MBUF_TEST_SMALL_BUF_COUNT; i++) {
+        os_mbuf_free(small[i]);
+    }
+    for (i = 0; i < MBUF_TEST_POOL_BUF_COUNT; i++) {
+        os_mbuf_free(big[i]);
+    }
+    os_msys_reset();
+}
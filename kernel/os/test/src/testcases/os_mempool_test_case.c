@@ -135,6 +135,10 @@ mempool_test(int num_blocks, int block_size)
                 "Got all blocks but number free not zero! (%d)",
                 g_TstMempool.mp_num_free);
 
+    /* The get which found the pool empty is counted. */
+    TEST_ASSERT(g_TstMempool.mp_num_exhausted == 1,
+                "Exhausted count wrong (%d)", g_TstMempool.mp_num_exhausted);
+
     /* Now put them all back */
     for (cnt = 0; cnt < g_TstMempool.mp_num_blocks; ++cnt) {
         rc = os_memblock_put(&g_TstMempool, block_array[cnt]);
@@ -7,8 +7,11 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <assert.h>
+#include "syscfg/syscfg.h"
 #include "malloc.h"
 
+#if !MYNEWT_VAL(BASELIBC_MALLOC_TLSF)
+
 /* Both the arena list and the free memory list are double linked
    list with head node.  This the head node. Note that the arena list
    is sorted in order of address. */
@@ -272,3 +275,5 @@ void set_malloc_locking(malloc_lock_t lock, malloc_unlock_t unlock)
     else
         malloc_unlock = &malloc_unlock_nop;
 }
+
+#endif
@@ -0,0 +1,426 @@
+/*
+ * malloc_tlsf.c
+ *
+ * Two-level segregated fit malloc()/free()/realloc(), selected with
+ * BASELIBC_MALLOC_TLSF.  Free blocks are kept on lists by size class; a
+ * first level splits sizes by power of two, a second level splits each of
+ * those linearly, and two levels of bitmaps find a non-empty list that is
+ * large enough without searching.  Allocation and free are O(1), and the
+ * good fit keeps fragmentation down under mixed workloads.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(BASELIBC_MALLOC_TLSF)
+
+/*
+ * Every block starts with this header; prev_phys and size are kept for
+ * blocks in use too, the free list links only for free blocks, and the
+ * payload of a block in use starts where they would be.  The last block
+ * of each area is a zero sized sentinel which is never free, so the block
+ * after any other block always exists.
+ */
+struct tlsf_block {
+	struct tlsf_block *prev_phys;
+	size_t size;			/* Includes header; low bit: free */
+	struct tlsf_block *next_free;
+	struct tlsf_block *prev_free;
+};
+
+#define TLSF_FREE		1
+#define TLSF_HDR		offsetof(struct tlsf_block, next_free)
+#define TLSF_ALIGN		(2 * sizeof(void *))
+#define TLSF_MIN_BLOCK		sizeof(struct tlsf_block)
+
+/*
+ * Second level: 8 lists per power of two.  Sizes below TLSF_SMALL (where
+ * a power of two range would hold fewer than 8 aligned sizes) share the
+ * first list row, split linearly.  Allocations are limited to
+ * 2^TLSF_FL_MAX bytes; free blocks larger than the last list all go on it.
+ */
+#define TLSF_SL_LOG2		3
+#define TLSF_SL_COUNT		(1 << TLSF_SL_LOG2)
+#define TLSF_ALIGN_LOG2		(sizeof(void *) == 8 ? 4 : 3)
+#define TLSF_FL_SHIFT		(TLSF_SL_LOG2 + TLSF_ALIGN_LOG2)
+#define TLSF_SMALL		((size_t)1 << TLSF_FL_SHIFT)
+#define TLSF_FL_MAX		20
+#define TLSF_FL_COUNT		(TLSF_FL_MAX - TLSF_FL_SHIFT + 2)
+
+static struct {
+	uint32_t fl_bitmap;
+	uint8_t sl_bitmap[TLSF_FL_COUNT];
+	struct tlsf_block *lists[TLSF_FL_COUNT][TLSF_SL_COUNT];
+	struct tlsf_block *sentinel;	/* Of the most recently added area */
+	size_t free_bytes;
+} tlsf;
+
+static bool malloc_lock_nop() {return true;}
+static void malloc_unlock_nop() {}
+
+static malloc_lock_t malloc_lock = &malloc_lock_nop;
+static malloc_unlock_t malloc_unlock = &malloc_unlock_nop;
+
+static inline size_t block_size(const struct tlsf_block *b)
+{
+	return b->size & ~(size_t)TLSF_FREE;
+}
+
+static inline bool block_is_free(const struct tlsf_block *b)
+{
+	return b->size & TLSF_FREE;
+}
+
+static inline struct tlsf_block *block_next(struct tlsf_block *b)
+{
+	return (struct tlsf_block *)((char *)b + block_size(b));
+}
+
+static inline int fls_size(size_t size)
+{
+	return (int)(sizeof(unsigned long) * 8) - 1 -
+		__builtin_clzl((unsigned long)size);
+}
+
+static void mapping(size_t size, int *fl, int *sl)
+{
+	int f;
+
+	if (size < TLSF_SMALL) {
+		*fl = 0;
+		*sl = size / (TLSF_SMALL / TLSF_SL_COUNT);
+	} else {
+		f = fls_size(size);
+		*sl = (size >> (f - TLSF_SL_LOG2)) ^ TLSF_SL_COUNT;
+		*fl = f - TLSF_FL_SHIFT + 1;
+		if (*fl >= TLSF_FL_COUNT) {
+			*fl = TLSF_FL_COUNT - 1;
+			*sl = TLSF_SL_COUNT - 1;
+		}
+	}
+}
+
+static void insert_free(struct tlsf_block *b)
+{
+	struct tlsf_block *head;
+	int fl, sl;
+
+	mapping(block_size(b), &fl, &sl);
+	head = tlsf.lists[fl][sl];
+	b->next_free = head;
+	b->prev_free = NULL;
+	if (head)
+		head->prev_free = b;
+	tlsf.lists[fl][sl] = b;
+	tlsf.fl_bitmap |= 1UL << fl;
+	tlsf.sl_bitmap[fl] |= 1 << sl;
+
+	b->size |= TLSF_FREE;
+	tlsf.free_bytes += block_size(b);
+}
+
+static void remove_free(struct tlsf_block *b)
+{
+	int fl, sl;
+
+	mapping(block_size(b), &fl, &sl);
+	if (b->prev_free) {
+		b->prev_free->next_free = b->next_free;
+	} else {
+		tlsf.lists[fl][sl] = b->next_free;
+		if (!b->next_free) {
+			tlsf.sl_bitmap[fl] &= ~(1 << sl);
+			if (!tlsf.sl_bitmap[fl])
+				tlsf.fl_bitmap &= ~(1UL << fl);
+		}
+	}
+	if (b->next_free)
+		b->next_free->prev_free = b->prev_free;
+
+	b->size &= ~(size_t)TLSF_FREE;
+	tlsf.free_bytes -= block_size(b);
+}
+
+/* Rounds size up to the smallest size on the next list */
+static size_t round_up(size_t size)
+{
+	size_t step;
+
+	if (size < TLSF_SMALL)
+		return size;
+	step = (size_t)1 << (fls_size(size) - TLSF_SL_LOG2);
+	return (size + step - 1) & ~(step - 1);
+}
+
+/*
+ * Returns a free block of at least size bytes, from the first list whose
+ * blocks are all large enough.
+ */
+static struct tlsf_block *find_free(size_t size)
+{
+	uint32_t map;
+	int fl, sl;
+
+	mapping(round_up(size), &fl, &sl);
+
+	map = tlsf.sl_bitmap[fl] & (~0U << sl);
+	if (!map) {
+		map = tlsf.fl_bitmap & ~((2UL << fl) - 1);
+		if (!map)
+			return NULL;
+		fl = __builtin_ctz(map);
+		map = tlsf.sl_bitmap[fl];
+	}
+	sl = __builtin_ctz(map);
+	return tlsf.lists[fl][sl];
+}
+
+/* Splits the tail off block b, in use, if it is big enough for a block. */
+static void split(struct tlsf_block *b, size_t size)
+{
+	struct tlsf_block *rest, *next;
+	size_t rest_size;
+
+	rest_size = block_size(b) - size;
+	if (rest_size < TLSF_MIN_BLOCK)
+		return;
+
+	next = block_next(b);
+	rest = (struct tlsf_block *)((char *)b + size);
+	rest->prev_phys = b;
+	rest->size = rest_size;
+	b->size = size;
+
+	if (block_is_free(next)) {
+		remove_free(next);
+		rest->size += block_size(next);
+		next = block_next(next);
+	}
+	next->prev_phys = rest;
+	insert_free(rest);
+}
+
+/* Returns block b, in use, to the free lists, merging it with neighbours */
+static void release(struct tlsf_block *b)
+{
+	struct tlsf_block *prev, *next;
+
+	next = block_next(b);
+	if (block_is_free(next)) {
+		remove_free(next);
+		b->size += block_size(next);
+	}
+	prev = b->prev_phys;
+	if (prev && block_is_free(prev)) {
+		remove_free(prev);
+		prev->size += block_size(b);
+		b = prev;
+	}
+	block_next(b)->prev_phys = b;
+	insert_free(b);
+}
+
+static size_t adjust_size(size_t size)
+{
+	if (size > ((size_t)1 << TLSF_FL_MAX))
+		return 0;
+	size = (size + TLSF_HDR + TLSF_ALIGN - 1) & ~(TLSF_ALIGN - 1);
+	if (size < TLSF_MIN_BLOCK)
+		size = TLSF_MIN_BLOCK;
+	return size;
+}
+
+static void add_block(void *buf, size_t size)
+{
+	struct tlsf_block *b, *sentinel;
+	char *start, *end;
+
+	start = (char *)(((uintptr_t)buf + TLSF_ALIGN - 1) &
+			 ~(TLSF_ALIGN - 1));
+	end = (char *)(((uintptr_t)buf + size) & ~(TLSF_ALIGN - 1));
+	if (end < start + TLSF_MIN_BLOCK + TLSF_ALIGN)
+		return; // Too small.
+
+	/*
+	 * Memory from _sbrk() usually follows on from the previous area;
+	 * grow that, reusing its sentinel, rather than start a new one.
+	 */
+	if (tlsf.sentinel &&
+	    start == (char *)tlsf.sentinel + TLSF_ALIGN) {
+		b = tlsf.sentinel;
+	} else {
+		b = (struct tlsf_block *)start;
+		b->prev_phys = NULL;
+	}
+
+	sentinel = (struct tlsf_block *)(end - TLSF_ALIGN);
+	b->size = (char *)sentinel - (char *)b;
+	sentinel->prev_phys = b;
+	sentinel->size = 0;
+	tlsf.sentinel = sentinel;
+
+	release(b);
+}
+
+static void *alloc(size_t size)
+{
+	struct tlsf_block *b;
+	void *more_mem;
+	size_t more;
+	extern void *_sbrk(int incr);
+
+	b = find_free(size);
+	if (!b) {
+		/* Room for a block find_free() accepts, alignment and sentinel */
+		more = round_up(size) + 2 * TLSF_ALIGN;
+		more_mem = _sbrk(more);
+		if (more_mem == (void *)-1)
+			return NULL;
+		add_block(more_mem, more);
+		b = find_free(size);
+		if (!b)
+			return NULL;
+	}
+
+	remove_free(b);
+	split(b, size);
+
+	return (char *)b + TLSF_HDR;
+}
+
+void *malloc(size_t size)
+{
+	void *result;
+
+	if (size == 0)
+		return NULL;
+	size = adjust_size(size);
+	if (size == 0)
+		return NULL;
+
+	if (!malloc_lock())
+		return NULL;
+	result = alloc(size);
+	malloc_unlock();
+
+	return result;
+}
+
+/* Call this to give malloc some memory to allocate from */
+void add_malloc_block(void *buf, size_t size)
+{
+	if (!malloc_lock())
+		return;
+	add_block(buf, size);
+	malloc_unlock();
+}
+
+void free(void *ptr)
+{
+	struct tlsf_block *b;
+
+	if (!ptr)
+		return;
+
+	b = (struct tlsf_block *)((char *)ptr - TLSF_HDR);
+	assert(!block_is_free(b));
+
+	if (!malloc_lock())
+		return;
+	release(b);
+	malloc_unlock();
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	struct tlsf_block *b, *next;
+	void *newptr;
+	size_t want;
+
+	if (!ptr)
+		return malloc(size);
+
+	if (size == 0) {
+		free(ptr);
+		return NULL;
+	}
+
+	want = adjust_size(size);
+	if (want == 0)
+		return NULL;
+
+	b = (struct tlsf_block *)((char *)ptr - TLSF_HDR);
+
+	if (!malloc_lock())
+		return NULL;
+
+	/* Grow in place into a free block which follows */
+	next = block_next(b);
+	if (want > block_size(b) && block_is_free(next) &&
+	    block_size(b) + block_size(next) >= want) {
+		remove_free(next);
+		b->size += block_size(next);
+		block_next(b)->prev_phys = b;
+	}
+
+	if (want <= block_size(b)) {
+		split(b, want);
+		malloc_unlock();
+		return ptr;
+	}
+
+	newptr = alloc(want);
+	if (newptr) {
+		memcpy(newptr, ptr, block_size(b) - TLSF_HDR);
+		release(b);
+	}
+	malloc_unlock();
+
+	return newptr;
+}
+
+void get_malloc_memory_status(size_t *free_bytes, size_t *largest_block)
+{
+	struct tlsf_block *b;
+	int fl, sl;
+
+	*free_bytes = 0;
+	*largest_block = 0;
+
+	if (!malloc_lock())
+		return;
+
+	*free_bytes = tlsf.free_bytes;
+
+	/* The largest block is on the highest non-empty list */
+	if (tlsf.fl_bitmap) {
+		fl = 31 - __builtin_clz(tlsf.fl_bitmap);
+		sl = 31 - __builtin_clz(tlsf.sl_bitmap[fl]);
+		for (b = tlsf.lists[fl][sl]; b; b = b->next_free) {
+			if (block_size(b) > *largest_block)
+				*largest_block = block_size(b);
+		}
+	}
+
+	malloc_unlock();
+}
+
+void set_malloc_locking(malloc_lock_t lock, malloc_unlock_t unlock)
+{
+	if (lock)
+		malloc_lock = lock;
+	else
+		malloc_lock = &malloc_lock_nop;
+
+	if (unlock)
+		malloc_unlock = unlock;
+	else
+		malloc_unlock = &malloc_unlock_nop;
+}
+
+#endif
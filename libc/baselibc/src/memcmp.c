@@ -3,12 +3,37 @@
  */
 
 #include <string.h>
+#include <stdint.h>
 
 int memcmp(const void *s1, const void *s2, size_t n)
 {
 	const unsigned char *c1 = s1, *c2 = s2;
 	int d = 0;
 
+#if defined(__arm__)
+	typedef uint32_t __attribute__((__may_alias__)) word_t;
+
+	/*
+	 * Skip over equal words when both sides share word alignment; the
+	 * first differing word is resolved by the byte loop below so the
+	 * sign of the result is unchanged.
+	 */
+	if ((((uintptr_t)c1 ^ (uintptr_t)c2) & 3) == 0) {
+		while (((uintptr_t)c1 & 3) && n) {
+			d = (int)*c1++ - (int)*c2++;
+			if (d)
+				return d;
+			n--;
+		}
+		while (n >= 4 &&
+		       *(const word_t *)c1 == *(const word_t *)c2) {
+			c1 += 4;
+			c2 += 4;
+			n -= 4;
+		}
+	}
+#endif
+
 	while (n--) {
 		d = (int)*c1++ - (int)*c2++;
 		if (d)
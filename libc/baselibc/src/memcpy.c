@@ -19,6 +19,38 @@ void *memcpy(void *dst, const void *src, size_t n)
 	asm volatile ("cld ; rep ; movsq ; movl %3,%%ecx ; rep ; movsb":"+c"
 		      (nq), "+S"(p), "+D"(q)
 		      :"r"((uint32_t) (n & 7)));
+#elif defined(__arm__)
+	typedef uint32_t __attribute__((__may_alias__)) word_t;
+
+	/*
+	 * Cortex-M has no string instructions; when source and destination
+	 * share word alignment, move 16 bytes per LDM/STM pair and finish
+	 * with single words and bytes.  Only low registers are used so this
+	 * also assembles for Thumb-1 (ARMv6-M).
+	 */
+	if ((((uintptr_t)p ^ (uintptr_t)q) & 3) == 0) {
+		while (((uintptr_t)q & 3) && n) {
+			*q++ = *p++;
+			n--;
+		}
+		while (n >= 16) {
+			asm volatile ("ldmia %0!, {r3, r4, r5, r6}\n\t"
+				      "stmia %1!, {r3, r4, r5, r6}"
+				      : "+l" (p), "+l" (q)
+				      :
+				      : "r3", "r4", "r5", "r6", "memory");
+			n -= 16;
+		}
+		while (n >= 4) {
+			*(word_t *)q = *(const word_t *)p;
+			p += 4;
+			q += 4;
+			n -= 4;
+		}
+	}
+	while (n--) {
+		*q++ = *p++;
+	}
 #else
 	while (n--) {
 		*q++ = *p++;
@@ -3,6 +3,7 @@
  */
 
 #include <string.h>
+#include <stdint.h>
 
 void *memmove(void *dst, const void *src, size_t n)
 {
@@ -18,6 +19,35 @@ void *memmove(void *dst, const void *src, size_t n)
 		asm volatile("std; rep; movsb; cld"
 			     : "+c" (n), "+S"(p), "+D"(q));
 	}
+#elif defined(__arm__)
+	typedef uint32_t __attribute__((__may_alias__)) word_t;
+
+	/*
+	 * memcpy() copies upwards, loading each block before storing it, so
+	 * it also handles overlap with the destination below the source.
+	 */
+	if (q <= p || q >= p + n) {
+		return memcpy(dst, src, n);
+	}
+
+	/* Copy downwards, a word at a time when both ends share alignment. */
+	p += n;
+	q += n;
+	if ((((uintptr_t)p ^ (uintptr_t)q) & 3) == 0) {
+		while (((uintptr_t)q & 3) && n) {
+			*--q = *--p;
+			n--;
+		}
+		while (n >= 4) {
+			p -= 4;
+			q -= 4;
+			*(word_t *)q = *(const word_t *)p;
+			n -= 4;
+		}
+	}
+	while (n--) {
+		*--q = *--p;
+	}
 #else
 	if (q < p) {
 		while (n--) {
@@ -20,6 +20,37 @@ void *memset(void *dst, int c, size_t n)
 		      :"+c" (nq), "+D" (q)
 		      : "a" ((unsigned char)c * 0x0101010101010101U),
 			"r" ((uint32_t) n & 7));
+#elif defined(__arm__)
+	typedef uint32_t __attribute__((__may_alias__)) word_t;
+	uint32_t w;
+
+	/* Align the destination, then store 16 bytes per STM. */
+	while (((uintptr_t)q & 3) && n) {
+		*q++ = c;
+		n--;
+	}
+	if (n >= 4) {
+		w = (unsigned char)c * 0x01010101U;
+		while (n >= 16) {
+			asm volatile ("mov r3, %1\n\t"
+				      "mov r4, %1\n\t"
+				      "mov r5, %1\n\t"
+				      "mov r6, %1\n\t"
+				      "stmia %0!, {r3, r4, r5, r6}"
+				      : "+l" (q)
+				      : "l" (w)
+				      : "r3", "r4", "r5", "r6", "memory");
+			n -= 16;
+		}
+		while (n >= 4) {
+			*(word_t *)q = w;
+			q += 4;
+			n -= 4;
+		}
+	}
+	while (n--) {
+		*q++ = c;
+	}
 #else
 	while (n--) {
 		*q++ = c;
@@ -5,8 +5,11 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "syscfg/syscfg.h"
 #include "malloc.h"
 
+#if !MYNEWT_VAL(BASELIBC_MALLOC_TLSF)
+
 /* FIXME: This is cheesy, it should be fixed later */
 
 void *realloc(void *ptr, size_t size)
@@ -48,3 +51,5 @@ void *realloc(void *ptr, size_t size)
 		return newptr;
 	}
 }
+
+#endif
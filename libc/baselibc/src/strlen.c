@@ -3,10 +3,32 @@
  */
 
 #include <string.h>
+#include <stdint.h>
 
 size_t strlen(const char *s)
 {
 	const char *ss = s;
+
+#if defined(__arm__)
+	typedef uint32_t __attribute__((__may_alias__)) word_t;
+	const word_t *w;
+
+	/*
+	 * Once aligned, test a word at a time for a zero byte.  An aligned
+	 * word never straddles a memory region boundary, so reading past the
+	 * terminator within it is harmless.
+	 */
+	while ((uintptr_t)ss & 3) {
+		if (!*ss)
+			return ss - s;
+		ss++;
+	}
+	w = (const word_t *)ss;
+	while (!((*w - 0x01010101U) & ~*w & 0x80808080U))
+		w++;
+	ss = (const char *)w;
+#endif
+
 	while (*ss)
 		ss++;
 	return ss - s;
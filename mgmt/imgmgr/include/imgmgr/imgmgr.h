@@ -43,6 +43,40 @@ extern "C" {
 #define IMGMGR_STATE_F_ACTIVE           0x04
 #define IMGMGR_STATE_F_PERMANENT        0x08
 
+/*
+ * Delta image: uploaded in place of a full image, and turned into one by
+ * applying it against the running image.  Starts with struct imgmgr_delta_hdr,
+ * followed by a sequence of operations which produce the new image in order.
+ * Each operation is a one byte opcode and a 32-bit length; COPY and ADD
+ * then have a 32-bit offset into the base image; ADD and INSERT are then
+ * followed by length bytes of data.  All fields are little endian.
+ */
+#define IMGMGR_DELTA_MAGIC          0x96f3b8d1
+
+#define IMGMGR_DELTA_OP_COPY        0   /* Copy bytes from base image. */
+#define IMGMGR_DELTA_OP_ADD         1   /* Base image bytes + data bytes. */
+#define IMGMGR_DELTA_OP_INSERT      2   /* Data bytes. */
+
+struct imgmgr_delta_hdr {
+    uint32_t idh_magic;
+    uint32_t idh_size;          /* Size of the resulting image. */
+    uint8_t idh_base_hash[IMGMGR_HASH_LEN]; /* SHA256 TLV of base image. */
+};
+
+/*
+ * Compressed image: uploaded in place of a full image, and expanded into
+ * the upload slot as it arrives.  Starts with struct imgmgr_lz4_hdr,
+ * followed by the image as one LZ4 block (as produced by
+ * LZ4_compress_default()).  Matches can reach back up to 64KB into the
+ * image written so far.  All fields are little endian.
+ */
+#define IMGMGR_LZ4_MAGIC            0x96f3b8d2
+
+struct imgmgr_lz4_hdr {
+    uint32_t ilh_magic;
+    uint32_t ilh_size;          /* Size of the uncompressed image. */
+};
+
 extern int boot_current_slot;
 
 void imgmgr_module_init(void);
@@ -16,6 +16,7 @@
  * specific language governing permissions and limitations
  * under the License.
  */
+#include <os/os.h>
 #include <os/endian.h>
 
 #include <limits.h>
@@ -25,6 +26,8 @@
 #include "sysinit/sysinit.h"
 #include "sysflash/sysflash.h"
 #include "hal/hal_bsp.h"
+#include "hal/hal_flash.h"
+#include "hal/hal_flash_int.h"
 #include "flash_map/flash_map.h"
 #include "cborattr/cborattr.h"
 #include "bootutil/image.h"
@@ -293,6 +296,277 @@ imgr_erase(struct mgmt_cbuf *cb)
     return 0;
 }
 
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) > 0
+/*
+ * Upload chunks which arrived ahead of the current upload offset.
+ */
+struct imgr_chunk {
+    uint32_t ic_off;
+    uint16_t ic_len;            /* 0 if unused */
+    uint8_t ic_data[MYNEWT_VAL(IMGMGR_MAX_CHUNK_SIZE)];
+};
+
+static struct imgr_chunk imgr_window[MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW)];
+
+static void
+imgr_window_reset(void)
+{
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW); i++) {
+        imgr_window[i].ic_len = 0;
+    }
+}
+
+/*
+ * Hold on to chunk until the data before it has been written. Chunk is
+ * dropped if there is no room; peer will resend it.
+ */
+static void
+imgr_window_put(uint32_t off, const uint8_t *data, int len)
+{
+    struct imgr_chunk *ic;
+    struct imgr_chunk *free_ic;
+    int i;
+
+    if (len == 0 || off < imgr_state.upload.off ||
+      off + len > imgr_state.upload.size) {
+        return;
+    }
+    free_ic = NULL;
+    for (i = 0; i < MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW); i++) {
+        ic = &imgr_window[i];
+        if (ic->ic_len == 0) {
+            if (!free_ic) {
+                free_ic = ic;
+            }
+        } else if (ic->ic_off == off) {
+            /* Duplicate. */
+            return;
+        }
+    }
+    if (free_ic) {
+        free_ic->ic_off = off;
+        free_ic->ic_len = len;
+        memcpy(free_ic->ic_data, data, len);
+    }
+}
+
+/*
+ * Returns held chunk which starts at the current upload offset, if any.
+ * Chunks which are now behind the offset are released.
+ */
+static struct imgr_chunk *
+imgr_window_next(void)
+{
+    struct imgr_chunk *ic;
+    struct imgr_chunk *found;
+    int i;
+
+    found = NULL;
+    for (i = 0; i < MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW); i++) {
+        ic = &imgr_window[i];
+        if (ic->ic_len == 0) {
+            continue;
+        }
+        if (ic->ic_off == imgr_state.upload.off) {
+            found = ic;
+        } else if (ic->ic_off < imgr_state.upload.off) {
+            ic->ic_len = 0;
+        }
+    }
+    return found;
+}
+#endif
+
+#if MYNEWT_VAL(IMGMGR_LAZY_ERASE)
+/*
+ * The sector after the last write is erased in the background, while the
+ * next chunk is on its way.
+ */
+static struct os_sem imgr_erase_sem;
+static uint32_t imgr_erase_end;         /* 0 if no erase in progress */
+static int imgr_erase_rc;
+
+static void
+imgr_erase_done(void *arg, int rc)
+{
+    imgr_erase_rc = rc;
+    os_sem_release(&imgr_erase_sem);
+}
+
+static int
+imgr_erase_wait(void)
+{
+    if (!imgr_erase_end) {
+        return 0;
+    }
+    os_sem_pend(&imgr_erase_sem, OS_TIMEOUT_NEVER);
+    if (imgr_erase_rc == 0) {
+        imgr_state.upload.erased_off = imgr_erase_end;
+    }
+    imgr_erase_end = 0;
+    return imgr_erase_rc;
+}
+
+static void
+imgr_erase_next(void)
+{
+    const struct flash_area *fa;
+    const struct hal_flash *hf;
+    uint32_t start;
+    uint32_t size;
+    int i;
+
+    fa = imgr_state.upload.fa;
+    if (imgr_erase_end || imgr_state.upload.erased_off >= fa->fa_size) {
+        return;
+    }
+    hf = hal_bsp_flash_dev(fa->fa_device_id);
+    for (i = 0; i < hf->hf_sector_cnt; i++) {
+        hf->hf_itf->hff_sector_info(hf, i, &start, &size);
+        if (start == fa->fa_off + imgr_state.upload.erased_off) {
+            if (hal_flash_erase_sector_async(fa->fa_device_id, start,
+                imgr_erase_done, NULL) == 0) {
+                imgr_erase_end = imgr_state.upload.erased_off + size;
+            }
+            break;
+        }
+    }
+}
+
+/*
+ * Erase the sectors of upload slot which start below offset "end", and
+ * have not been erased yet.
+ */
+static int
+imgr_erase_ahead(uint32_t end)
+{
+    const struct flash_area *fa;
+    const struct hal_flash *hf;
+    uint32_t start;
+    uint32_t size;
+    int rc;
+    int i;
+
+    rc = imgr_erase_wait();
+    if (rc) {
+        return rc;
+    }
+    fa = imgr_state.upload.fa;
+    if (end > fa->fa_size) {
+        end = fa->fa_size;
+    }
+    if (imgr_state.upload.erased_off >= end) {
+        return 0;
+    }
+    hf = hal_bsp_flash_dev(fa->fa_device_id);
+    for (i = 0; i < hf->hf_sector_cnt; i++) {
+        hf->hf_itf->hff_sector_info(hf, i, &start, &size);
+        if (start < fa->fa_off + imgr_state.upload.erased_off) {
+            continue;
+        }
+        if (start >= fa->fa_off + end) {
+            break;
+        }
+        rc = flash_area_erase(fa, start - fa->fa_off, size);
+        if (rc) {
+            return rc;
+        }
+        imgr_state.upload.erased_off = start - fa->fa_off + size;
+    }
+    return 0;
+}
+#endif
+
+/*
+ * Write chunk of upload at offset "off", which must be the current upload
+ * offset.
+ */
+static int
+imgr_upload_write(uint32_t off, const uint8_t *data, int len)
+{
+    int rc;
+
+#if MYNEWT_VAL(IMGMGR_DELTA)
+    if (imgr_state.upload.is_delta) {
+        /* The upload offset counts bytes of the delta. */
+        if (off == 0) {
+            rc = imgr_delta_write(&imgr_state.upload.delta,
+              imgr_state.upload.fa, data + sizeof(struct imgmgr_delta_hdr),
+              len - sizeof(struct imgmgr_delta_hdr));
+        } else {
+            rc = imgr_delta_write(&imgr_state.upload.delta,
+              imgr_state.upload.fa, data, len);
+        }
+    } else
+#endif
+#if MYNEWT_VAL(IMGMGR_LZ4)
+    if (imgr_state.upload.is_lz4) {
+        /* The upload offset counts bytes of the compressed image. */
+        if (off == 0) {
+            rc = imgr_lz4_write(&imgr_state.upload.lz4,
+              imgr_state.upload.fa, data + sizeof(struct imgmgr_lz4_hdr),
+              len - sizeof(struct imgmgr_lz4_hdr));
+        } else {
+            rc = imgr_lz4_write(&imgr_state.upload.lz4,
+              imgr_state.upload.fa, data, len);
+        }
+    } else
+#endif
+    {
+#if MYNEWT_VAL(IMGMGR_LAZY_ERASE)
+        rc = imgr_erase_ahead(off + len);
+        if (rc) {
+            return MGMT_ERR_EINVAL;
+        }
+#endif
+        rc = flash_area_write(imgr_state.upload.fa, off, data, len);
+#if MYNEWT_VAL(IMGMGR_LAZY_ERASE)
+        if (rc == 0) {
+            imgr_erase_next();
+        }
+#endif
+    }
+    if (rc) {
+        return MGMT_ERR_EINVAL;
+    }
+    imgr_state.upload.off += len;
+    return 0;
+}
+
+/*
+ * Tells from the first bytes of an upload whether it is a plain image, a
+ * delta or a compressed image.
+ */
+int
+imgr_upload_set_type(const struct image_header *hdr)
+{
+#if MYNEWT_VAL(IMGMGR_DELTA)
+    imgr_state.upload.is_delta = 0;
+#endif
+#if MYNEWT_VAL(IMGMGR_LZ4)
+    imgr_state.upload.is_lz4 = 0;
+#endif
+
+#if MYNEWT_VAL(IMGMGR_DELTA)
+    if (hdr->ih_magic == IMGMGR_DELTA_MAGIC) {
+        imgr_state.upload.is_delta = 1;
+        return 0;
+    }
+#endif
+#if MYNEWT_VAL(IMGMGR_LZ4)
+    if (hdr->ih_magic == IMGMGR_LZ4_MAGIC) {
+        imgr_state.upload.is_lz4 = 1;
+        return 0;
+    }
+#endif
+    if (hdr->ih_magic != IMAGE_MAGIC) {
+        return MGMT_ERR_EINVAL;
+    }
+    return 0;
+}
+
 static int
 imgr_upload(struct mgmt_cbuf *cb)
 {
@@ -329,6 +603,9 @@ imgr_upload(struct mgmt_cbuf *cb)
     int rc;
     int i;
     bool empty = false;
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) > 0
+    struct imgr_chunk *ic;
+#endif
     CborError g_err = CborNoError;
 
     rc = cbor_read_object(&cb->it, off_attr);
@@ -344,8 +621,9 @@ imgr_upload(struct mgmt_cbuf *cb)
             return MGMT_ERR_EINVAL;
         }
         hdr = (struct image_header *)img_data;
-        if (hdr->ih_magic != IMAGE_MAGIC) {
-            return MGMT_ERR_EINVAL;
+        rc = imgr_upload_set_type(hdr);
+        if (rc) {
+            return rc;
         }
 
         /*
@@ -379,6 +657,9 @@ imgr_upload(struct mgmt_cbuf *cb)
         }
         if (best >= 0) {
             area_id = flash_area_id_from_image_slot(best);
+#if MYNEWT_VAL(IMGMGR_LAZY_ERASE)
+            imgr_erase_wait();
+#endif
             if (imgr_state.upload.fa) {
                 flash_area_close(imgr_state.upload.fa);
                 imgr_state.upload.fa = NULL;
@@ -387,6 +668,30 @@ imgr_upload(struct mgmt_cbuf *cb)
             if (rc) {
                 return MGMT_ERR_EINVAL;
             }
+#if MYNEWT_VAL(IMGMGR_DELTA)
+            if (imgr_state.upload.is_delta) {
+                if (best == boot_current_slot) {
+                    return MGMT_ERR_EINVAL;
+                }
+                if (imgr_state.upload.delta.id_base) {
+                    imgr_delta_finish(&imgr_state.upload.delta);
+                }
+                rc = imgr_delta_start(&imgr_state.upload.delta, img_data,
+                                      data_len, imgr_state.upload.fa);
+                if (rc) {
+                    return rc;
+                }
+            } else
+#endif
+#if MYNEWT_VAL(IMGMGR_LZ4)
+            if (imgr_state.upload.is_lz4) {
+                rc = imgr_lz4_start(&imgr_state.upload.lz4, img_data,
+                                    data_len, imgr_state.upload.fa);
+                if (rc) {
+                    return rc;
+                }
+            } else
+#endif
             if (IMAGE_SIZE(hdr) > imgr_state.upload.fa->fa_size) {
                 return MGMT_ERR_EINVAL;
             }
@@ -396,6 +701,30 @@ imgr_upload(struct mgmt_cbuf *cb)
                 return MGMT_ERR_EINVAL;
             }
 
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) > 0
+            imgr_window_reset();
+#endif
+#if MYNEWT_VAL(IMGMGR_LAZY_ERASE)
+            imgr_state.upload.erased_off = imgr_state.upload.fa->fa_size;
+            if (!empty
+#if MYNEWT_VAL(IMGMGR_DELTA)
+              && !imgr_state.upload.is_delta
+#endif
+#if MYNEWT_VAL(IMGMGR_LZ4)
+              && !imgr_state.upload.is_lz4
+#endif
+              ) {
+                /*
+                 * Rest of the slot gets erased as data arrives. Erase the
+                 * last sector now, so that the trailer of the previous image
+                 * does not get paired with a partial upload.
+                 */
+                rc = flash_area_erase(imgr_state.upload.fa,
+                  imgr_state.upload.fa->fa_size - 1, 1);
+                imgr_state.upload.erased_off = 0;
+                empty = true;
+            }
+#endif
             if(!empty) {
                 rc = flash_area_erase(imgr_state.upload.fa, 0,
                   imgr_state.upload.fa->fa_size);
@@ -411,6 +740,11 @@ imgr_upload(struct mgmt_cbuf *cb)
          * Invalid offset. Drop the data, and respond with the offset we're
          * expecting data for.
          */
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) > 0
+        if (imgr_state.upload.fa) {
+            imgr_window_put(off, img_data, data_len);
+        }
+#endif
         goto out;
     }
 
@@ -418,15 +752,42 @@ imgr_upload(struct mgmt_cbuf *cb)
         return MGMT_ERR_EINVAL;
     }
     if (data_len) {
-        rc = flash_area_write(imgr_state.upload.fa, imgr_state.upload.off,
-          img_data, data_len);
+        rc = imgr_upload_write(off, img_data, data_len);
         if (rc) {
-            rc = MGMT_ERR_EINVAL;
             goto err_close;
         }
-        imgr_state.upload.off += data_len;
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) > 0
+        while ((ic = imgr_window_next()) != NULL) {
+            rc = imgr_upload_write(ic->ic_off, ic->ic_data, ic->ic_len);
+            ic->ic_len = 0;
+            if (rc) {
+                goto err_close;
+            }
+        }
+#endif
         if (imgr_state.upload.size == imgr_state.upload.off) {
             /* Done */
+#if MYNEWT_VAL(IMGMGR_DELTA)
+            if (imgr_state.upload.is_delta &&
+                imgr_delta_finish(&imgr_state.upload.delta)) {
+                rc = MGMT_ERR_EINVAL;
+                goto err_close;
+            }
+#endif
+#if MYNEWT_VAL(IMGMGR_LZ4)
+            if (imgr_state.upload.is_lz4 &&
+                imgr_lz4_finish(&imgr_state.upload.lz4,
+                                imgr_state.upload.fa)) {
+                rc = MGMT_ERR_EINVAL;
+                goto err_close;
+            }
+#endif
+#if MYNEWT_VAL(IMGMGR_LAZY_ERASE)
+            if (imgr_erase_ahead(imgr_state.upload.fa->fa_size)) {
+                rc = MGMT_ERR_EINVAL;
+                goto err_close;
+            }
+#endif
             flash_area_close(imgr_state.upload.fa);
             imgr_state.upload.fa = NULL;
         }
@@ -443,6 +804,17 @@ out:
     }
     return 0;
 err_close:
+#if MYNEWT_VAL(IMGMGR_LAZY_ERASE)
+    imgr_erase_wait();
+#endif
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) > 0
+    imgr_window_reset();
+#endif
+#if MYNEWT_VAL(IMGMGR_DELTA)
+    if (imgr_state.upload.is_delta && imgr_state.upload.delta.id_base) {
+        imgr_delta_finish(&imgr_state.upload.delta);
+    }
+#endif
     flash_area_close(imgr_state.upload.fa);
     imgr_state.upload.fa = NULL;
     return rc;
@@ -459,6 +831,11 @@ imgmgr_module_init(void)
     rc = mgmt_group_register(&imgr_nmgr_group);
     SYSINIT_PANIC_ASSERT(rc == 0);
 
+#if MYNEWT_VAL(IMGMGR_LAZY_ERASE)
+    rc = os_sem_init(&imgr_erase_sem, 0);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+
 #if MYNEWT_VAL(IMGMGR_CLI)
     rc = imgr_cli_register();
     SYSINIT_PANIC_ASSERT(rc == 0);
@@ -0,0 +1,227 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(IMGMGR_DELTA)
+
+#include <string.h>
+
+#include "os/endian.h"
+#include "flash_map/flash_map.h"
+#include "mgmt/mgmt.h"
+
+#include "imgmgr/imgmgr.h"
+#include "imgmgr_priv.h"
+
+#define IMGR_DELTA_BUF_SZ       64
+
+/*
+ * Checks the delta header at the start of an upload, and prepares for the
+ * rest of it.  The delta must be against the running image.
+ */
+int
+imgr_delta_start(struct imgr_delta *id, const uint8_t *data, int len,
+                 const struct flash_area *dst)
+{
+    struct imgmgr_delta_hdr hdr;
+    uint8_t hash[IMGMGR_HASH_LEN];
+    int rc;
+
+    if (len < sizeof(hdr)) {
+        return MGMT_ERR_EINVAL;
+    }
+    memcpy(&hdr, data, sizeof(hdr));
+    if (le32toh(hdr.idh_magic) != IMGMGR_DELTA_MAGIC ||
+        le32toh(hdr.idh_size) > dst->fa_size) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    rc = imgr_read_info(boot_current_slot, NULL, hash, NULL);
+    if (rc != 0 || memcmp(hash, hdr.idh_base_hash, sizeof(hash))) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    memset(id, 0, sizeof(*id));
+    rc = flash_area_open(flash_area_id_from_image_slot(boot_current_slot),
+                         &id->id_base);
+    if (rc) {
+        return MGMT_ERR_EINVAL;
+    }
+    id->id_size = le32toh(hdr.idh_size);
+
+    return 0;
+}
+
+/*
+ * Produces 'len' bytes of image from the current operation.  For INSERT
+ * and ADD, 'data' holds the bytes from the delta.
+ */
+static int
+imgr_delta_out(struct imgr_delta *id, const struct flash_area *dst,
+               const uint8_t *data, uint32_t len)
+{
+    uint8_t buf[IMGR_DELTA_BUF_SZ];
+    const uint8_t *out;
+    uint32_t chunk;
+    int i;
+
+    while (len > 0) {
+        chunk = len;
+        if (chunk > sizeof(buf)) {
+            chunk = sizeof(buf);
+        }
+        if (id->id_op == IMGMGR_DELTA_OP_INSERT) {
+            out = data;
+        } else {
+            if (flash_area_read(id->id_base, id->id_base_off, buf, chunk)) {
+                return MGMT_ERR_EINVAL;
+            }
+            if (id->id_op == IMGMGR_DELTA_OP_ADD) {
+                for (i = 0; i < chunk; i++) {
+                    buf[i] += data[i];
+                }
+            }
+            id->id_base_off += chunk;
+            out = buf;
+        }
+        if (flash_area_write(dst, id->id_out_off, out, chunk)) {
+            return MGMT_ERR_EINVAL;
+        }
+        id->id_out_off += chunk;
+        if (data) {
+            data += chunk;
+        }
+        len -= chunk;
+    }
+    return 0;
+}
+
+/*
+ * Parses an operation header once all of it has been collected.
+ */
+static int
+imgr_delta_op(struct imgr_delta *id, const struct flash_area *dst)
+{
+    uint32_t len;
+    uint32_t u32;
+    int rc;
+
+    memcpy(&u32, &id->id_hdr[1], sizeof(u32));
+    len = le32toh(u32);
+    if (len > id->id_size - id->id_out_off) {
+        return MGMT_ERR_EINVAL;
+    }
+    if (id->id_op != IMGMGR_DELTA_OP_INSERT) {
+        memcpy(&u32, &id->id_hdr[5], sizeof(u32));
+        id->id_base_off = le32toh(u32);
+        if (id->id_base_off > id->id_base->fa_size ||
+            len > id->id_base->fa_size - id->id_base_off) {
+            return MGMT_ERR_EINVAL;
+        }
+    }
+    id->id_hdr_len = 0;
+
+    if (id->id_op == IMGMGR_DELTA_OP_COPY) {
+        /* Needs no data from the delta; do it now. */
+        rc = imgr_delta_out(id, dst, NULL, len);
+        if (rc) {
+            return rc;
+        }
+    } else {
+        id->id_len = len;
+    }
+    return 0;
+}
+
+/*
+ * Applies the next piece of the delta, following the header.
+ */
+int
+imgr_delta_write(struct imgr_delta *id, const struct flash_area *dst,
+                 const uint8_t *data, int len)
+{
+    uint32_t chunk;
+    int need;
+    int rc;
+
+    while (len > 0) {
+        if (id->id_len == 0) {
+            /* Collecting an operation header. */
+            if (id->id_hdr_len == 0) {
+                id->id_op = data[0];
+                if (id->id_op > IMGMGR_DELTA_OP_INSERT) {
+                    return MGMT_ERR_EINVAL;
+                }
+            }
+            need = (id->id_op == IMGMGR_DELTA_OP_INSERT ? 5 : 9) -
+                   id->id_hdr_len;
+            if (need > len) {
+                need = len;
+            }
+            memcpy(&id->id_hdr[id->id_hdr_len], data, need);
+            id->id_hdr_len += need;
+            data += need;
+            len -= need;
+
+            if (id->id_hdr_len ==
+                (id->id_op == IMGMGR_DELTA_OP_INSERT ? 5 : 9)) {
+                rc = imgr_delta_op(id, dst);
+                if (rc) {
+                    return rc;
+                }
+            }
+        } else {
+            chunk = id->id_len;
+            if (chunk > len) {
+                chunk = len;
+            }
+            rc = imgr_delta_out(id, dst, data, chunk);
+            if (rc) {
+                return rc;
+            }
+            id->id_len -= chunk;
+            data += chunk;
+            len -= chunk;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Called once all of the delta has been received.  The result is checked
+ * by the boot loader like any other image.
+ */
+int
+imgr_delta_finish(struct imgr_delta *id)
+{
+    int rc;
+
+    if (id->id_out_off == id->id_size && id->id_len == 0 &&
+        id->id_hdr_len == 0) {
+        rc = 0;
+    } else {
+        rc = MGMT_ERR_EINVAL;
+    }
+    flash_area_close(id->id_base);
+    id->id_base = NULL;
+    return rc;
+}
+
+#endif
@@ -0,0 +1,324 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(IMGMGR_LZ4)
+
+#include <string.h>
+
+#include "os/endian.h"
+#include "flash_map/flash_map.h"
+#include "mgmt/mgmt.h"
+
+#include "imgmgr/imgmgr.h"
+#include "imgmgr_priv.h"
+
+/*
+ * Where we are within an LZ4 sequence.
+ */
+#define IMGR_LZ4_TOKEN          0
+#define IMGR_LZ4_LIT_LEN        1       /* Extra literal length bytes. */
+#define IMGR_LZ4_LIT            2
+#define IMGR_LZ4_OFF_LO         3
+#define IMGR_LZ4_OFF_HI         4
+#define IMGR_LZ4_MATCH_LEN      5       /* Extra match length bytes. */
+#define IMGR_LZ4_DONE           6
+
+#define IMGR_LZ4_MIN_MATCH      4
+
+/*
+ * Checks the header at the start of an upload, and prepares for the rest
+ * of it.
+ */
+int
+imgr_lz4_start(struct imgr_lz4 *il, const uint8_t *data, int len,
+               const struct flash_area *dst)
+{
+    struct imgmgr_lz4_hdr hdr;
+
+    if (len < sizeof(hdr)) {
+        return MGMT_ERR_EINVAL;
+    }
+    memcpy(&hdr, data, sizeof(hdr));
+    if (le32toh(hdr.ilh_magic) != IMGMGR_LZ4_MAGIC ||
+        le32toh(hdr.ilh_size) > dst->fa_size) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    memset(il, 0, sizeof(*il));
+    il->il_size = le32toh(hdr.ilh_size);
+
+    return 0;
+}
+
+static int
+imgr_lz4_flush(struct imgr_lz4 *il, const struct flash_area *dst, int len)
+{
+    if (flash_area_write(dst, il->il_out_off - il->il_buf_len, il->il_buf,
+                         len)) {
+        return MGMT_ERR_EINVAL;
+    }
+    il->il_buf_len = 0;
+    return 0;
+}
+
+/*
+ * Adds produced bytes to the write buffer.  Flash is written in full
+ * buffers, so writes stay aligned.
+ */
+static int
+imgr_lz4_out(struct imgr_lz4 *il, const struct flash_area *dst,
+             const uint8_t *data, uint32_t len)
+{
+    uint32_t chunk;
+    int rc;
+
+    while (len > 0) {
+        chunk = sizeof(il->il_buf) - il->il_buf_len;
+        if (chunk > len) {
+            chunk = len;
+        }
+        memcpy(&il->il_buf[il->il_buf_len], data, chunk);
+        il->il_buf_len += chunk;
+        il->il_out_off += chunk;
+        data += chunk;
+        len -= chunk;
+        if (il->il_buf_len == sizeof(il->il_buf)) {
+            rc = imgr_lz4_flush(il, dst, sizeof(il->il_buf));
+            if (rc) {
+                return rc;
+            }
+        }
+    }
+    return 0;
+}
+
+/*
+ * Copies the current match from earlier in the image.  Source can overlap
+ * with the bytes being produced, so this goes in pieces which are already
+ * available.
+ */
+static int
+imgr_lz4_match(struct imgr_lz4 *il, const struct flash_area *dst)
+{
+    uint8_t tmp[IMGR_LZ4_BUF_SZ];
+    uint32_t flash_end;
+    uint32_t src;
+    uint32_t chunk;
+    int rc;
+
+    while (il->il_len > 0) {
+        src = il->il_out_off - il->il_match_off;
+        flash_end = il->il_out_off - il->il_buf_len;
+        chunk = il->il_len;
+        if (chunk > il->il_match_off) {
+            chunk = il->il_match_off;
+        }
+        if (chunk > sizeof(tmp)) {
+            chunk = sizeof(tmp);
+        }
+        if (src < flash_end) {
+            if (chunk > flash_end - src) {
+                chunk = flash_end - src;
+            }
+            if (flash_area_read(dst, src, tmp, chunk)) {
+                return MGMT_ERR_EINVAL;
+            }
+        } else {
+            memcpy(tmp, &il->il_buf[src - flash_end], chunk);
+        }
+        rc = imgr_lz4_out(il, dst, tmp, chunk);
+        if (rc) {
+            return rc;
+        }
+        il->il_len -= chunk;
+    }
+    return 0;
+}
+
+/*
+ * Called when the match offset has been read.  Match length might still
+ * need more bytes.
+ */
+static int
+imgr_lz4_match_start(struct imgr_lz4 *il)
+{
+    if (il->il_match_off == 0 || il->il_match_off > il->il_out_off) {
+        return MGMT_ERR_EINVAL;
+    }
+    return 0;
+}
+
+static int
+imgr_lz4_match_end(struct imgr_lz4 *il, const struct flash_area *dst)
+{
+    int rc;
+
+    if (il->il_len > il->il_size - il->il_out_off) {
+        return MGMT_ERR_EINVAL;
+    }
+    rc = imgr_lz4_match(il, dst);
+    if (rc) {
+        return rc;
+    }
+    il->il_state = IMGR_LZ4_TOKEN;
+    return 0;
+}
+
+/*
+ * Called once the literal length is known.
+ */
+static int
+imgr_lz4_lit_end(struct imgr_lz4 *il)
+{
+    uint32_t left;
+
+    left = il->il_size - il->il_out_off;
+    if (il->il_len > left) {
+        return MGMT_ERR_EINVAL;
+    }
+    if (il->il_len > 0) {
+        il->il_state = IMGR_LZ4_LIT;
+    } else if (left == 0) {
+        il->il_state = IMGR_LZ4_DONE;
+    } else {
+        il->il_state = IMGR_LZ4_OFF_LO;
+    }
+    return 0;
+}
+
+/*
+ * Expands the next piece of the compressed image, following the header.
+ */
+int
+imgr_lz4_write(struct imgr_lz4 *il, const struct flash_area *dst,
+               const uint8_t *data, int len)
+{
+    uint32_t chunk;
+    uint8_t b;
+    int rc = 0;
+
+    while (len > 0) {
+        if (il->il_state == IMGR_LZ4_LIT) {
+            chunk = il->il_len;
+            if (chunk > len) {
+                chunk = len;
+            }
+            rc = imgr_lz4_out(il, dst, data, chunk);
+            if (rc) {
+                return rc;
+            }
+            il->il_len -= chunk;
+            data += chunk;
+            len -= chunk;
+            if (il->il_len == 0) {
+                if (il->il_out_off == il->il_size) {
+                    /* Last sequence has no match. */
+                    il->il_state = IMGR_LZ4_DONE;
+                } else {
+                    il->il_state = IMGR_LZ4_OFF_LO;
+                }
+            }
+            continue;
+        }
+
+        b = *data++;
+        len--;
+        switch (il->il_state) {
+        case IMGR_LZ4_TOKEN:
+            /* Match length is kept in il_match_off until literals are done. */
+            il->il_len = b >> 4;
+            il->il_match_off = b & 0xf;
+            if (il->il_len == 0xf) {
+                il->il_state = IMGR_LZ4_LIT_LEN;
+            } else {
+                rc = imgr_lz4_lit_end(il);
+            }
+            break;
+        case IMGR_LZ4_LIT_LEN:
+            il->il_len += b;
+            if (b != 0xff) {
+                rc = imgr_lz4_lit_end(il);
+            }
+            break;
+        case IMGR_LZ4_OFF_LO:
+            il->il_len = il->il_match_off + IMGR_LZ4_MIN_MATCH;
+            il->il_match_off = b;
+            il->il_state = IMGR_LZ4_OFF_HI;
+            break;
+        case IMGR_LZ4_OFF_HI:
+            il->il_match_off |= b << 8;
+            rc = imgr_lz4_match_start(il);
+            if (rc) {
+                break;
+            }
+            if (il->il_len == 0xf + IMGR_LZ4_MIN_MATCH) {
+                il->il_state = IMGR_LZ4_MATCH_LEN;
+            } else {
+                rc = imgr_lz4_match_end(il, dst);
+            }
+            break;
+        case IMGR_LZ4_MATCH_LEN:
+            il->il_len += b;
+            if (b != 0xff) {
+                rc = imgr_lz4_match_end(il, dst);
+            }
+            break;
+        default:
+            /* Data past the end of the image. */
+            rc = MGMT_ERR_EINVAL;
+            break;
+        }
+        if (rc) {
+            return rc;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Called once all of the compressed image has been received.  Writes out
+ * what is left in the buffer, padded to flash alignment with erased bytes.
+ * The result is checked by the boot loader like any other image.
+ */
+int
+imgr_lz4_finish(struct imgr_lz4 *il, const struct flash_area *dst)
+{
+    int align;
+    int len;
+
+    if (il->il_state != IMGR_LZ4_DONE || il->il_out_off != il->il_size) {
+        return MGMT_ERR_EINVAL;
+    }
+    if (il->il_buf_len == 0) {
+        return 0;
+    }
+    align = flash_area_align(dst);
+    len = il->il_buf_len;
+    if (align > 1) {
+        len = (len + align - 1) & ~(align - 1);
+    }
+    if (len > sizeof(il->il_buf)) {
+        return MGMT_ERR_EINVAL;
+    }
+    memset(&il->il_buf[il->il_buf_len], 0xff, len - il->il_buf_len);
+    return imgr_lz4_flush(il, dst, len);
+}
+
+#endif
@@ -88,17 +88,62 @@ struct os_mbuf;
 struct fs_file;
 struct mgmt_cbuf;
 
+#if MYNEWT_VAL(IMGMGR_DELTA)
+/*
+ * State of applying a delta image as it is uploaded.
+ */
+struct imgr_delta {
+    const struct flash_area *id_base;
+    uint32_t id_size;           /* Size of image being built. */
+    uint32_t id_out_off;        /* Bytes of image written so far. */
+    uint32_t id_base_off;       /* Base offset for current op. */
+    uint32_t id_len;            /* Bytes left of current op. */
+    uint8_t id_op;
+    uint8_t id_hdr_len;         /* Bytes of op header collected. */
+    uint8_t id_hdr[9];
+};
+#endif
+
+#if MYNEWT_VAL(IMGMGR_LZ4)
+#define IMGR_LZ4_BUF_SZ         64
+
+/*
+ * State of expanding a compressed image as it is uploaded.
+ */
+struct imgr_lz4 {
+    uint32_t il_size;           /* Size of image being built. */
+    uint32_t il_out_off;        /* Bytes of image produced so far. */
+    uint32_t il_len;            /* Literal or match bytes of sequence. */
+    uint16_t il_match_off;
+    uint8_t il_state;
+    uint8_t il_buf_len;         /* Produced bytes not yet in flash. */
+    uint8_t il_buf[IMGR_LZ4_BUF_SZ];
+};
+#endif
+
 struct imgr_state {
     struct {
         uint32_t off;
         uint32_t size;
         const struct flash_area *fa;
+#if MYNEWT_VAL(IMGMGR_LAZY_ERASE)
+        uint32_t erased_off;    /* Slot is erased up to this offset. */
+#endif
+#if MYNEWT_VAL(IMGMGR_DELTA)
+        uint8_t is_delta;
+        struct imgr_delta delta;
+#endif
+#if MYNEWT_VAL(IMGMGR_LZ4)
+        uint8_t is_lz4;
+        struct imgr_lz4 lz4;
+#endif
     } upload;
 };
 
 extern struct imgr_state imgr_state;
 
 struct nmgr_jbuf;
+struct image_header;
 
 int imgr_core_list(struct mgmt_cbuf *);
 int imgr_core_load(struct mgmt_cbuf *);
@@ -108,6 +153,21 @@ int imgmgr_state_write(struct mgmt_cbuf *njb);
 int imgr_find_by_ver(struct image_version *find, uint8_t *hash);
 int imgr_find_by_hash(uint8_t *find, struct image_version *ver);
 int imgr_cli_register(void);
+int imgr_upload_set_type(const struct image_header *hdr);
+#if MYNEWT_VAL(IMGMGR_DELTA)
+int imgr_delta_start(struct imgr_delta *id, const uint8_t *data, int len,
+                     const struct flash_area *dst);
+int imgr_delta_write(struct imgr_delta *id, const struct flash_area *dst,
+                     const uint8_t *data, int len);
+int imgr_delta_finish(struct imgr_delta *id);
+#endif
+#if MYNEWT_VAL(IMGMGR_LZ4)
+int imgr_lz4_start(struct imgr_lz4 *il, const uint8_t *data, int len,
+                   const struct flash_area *dst);
+int imgr_lz4_write(struct imgr_lz4 *il, const struct flash_area *dst,
+                   const uint8_t *data, int len);
+int imgr_lz4_finish(struct imgr_lz4 *il, const struct flash_area *dst);
+#endif
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,54 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "imgmgr_test.h"
+
+/*
+ * Upload type is picked from the magic of the first header, with both
+ * delta and compressed uploads enabled. Flags left by the previous upload
+ * must not carry over.
+ */
+TEST_CASE(imgmgr_test_upload_type)
+{
+    struct image_header hdr;
+    int rc;
+
+    memset(&hdr, 0, sizeof(hdr));
+
+    hdr.ih_magic = IMGMGR_LZ4_MAGIC;
+    rc = imgr_upload_set_type(&hdr);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(imgr_state.upload.is_lz4 == 1);
+    TEST_ASSERT(imgr_state.upload.is_delta == 0);
+
+    hdr.ih_magic = IMGMGR_DELTA_MAGIC;
+    rc = imgr_upload_set_type(&hdr);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(imgr_state.upload.is_delta == 1);
+    TEST_ASSERT(imgr_state.upload.is_lz4 == 0);
+
+    hdr.ih_magic = IMAGE_MAGIC;
+    rc = imgr_upload_set_type(&hdr);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(imgr_state.upload.is_delta == 0);
+    TEST_ASSERT(imgr_state.upload.is_lz4 == 0);
+
+    hdr.ih_magic = 0x12345678;
+    rc = imgr_upload_set_type(&hdr);
+    TEST_ASSERT(rc == MGMT_ERR_EINVAL);
+}
@@ -69,6 +69,16 @@ extern "C" {
 
 #define NMGR_HDR_SIZE           (8)
 
+/*
+ * nh_flags.  A request with NMGR_F_STREAM lets the response be sent as a
+ * series of complete messages, each flagged NMGR_F_STREAM, and all but the
+ * last also NMGR_F_MORE; the payloads concatenate to the full response.
+ * A response without NMGR_F_STREAM ends the series and replaces the parts
+ * received so far (sent if handling fails part way).
+ */
+#define NMGR_F_STREAM           0x01
+#define NMGR_F_MORE             0x02
+
 struct nmgr_hdr {
 #if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
     uint8_t  nh_op:3;           /* NMGR_OP_XXX */
@@ -78,7 +88,7 @@ struct nmgr_hdr {
     uint8_t  _res1:5;
     uint8_t  nh_op:3;           /* NMGR_OP_XXX */
 #endif
-    uint8_t  nh_flags;          /* XXX reserved for future flags */
+    uint8_t  nh_flags;          /* NMGR_F_XXX */
     uint16_t nh_len;            /* length of the payload */
     uint16_t nh_group;          /* NMGR_GROUP_XXX */
     uint8_t  nh_seq;            /* sequence number */
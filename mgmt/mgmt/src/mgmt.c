@@ -18,6 +18,7 @@
  */
 #include <string.h>
 
+#include "syscfg/syscfg.h"
 #include <os/os.h>
 #include <tinycbor/cbor.h>
 #include "mgmt/mgmt.h"
@@ -26,6 +27,15 @@ static struct os_mutex mgmt_group_lock;
 static STAILQ_HEAD(, mgmt_group) mgmt_group_list =
     STAILQ_HEAD_INITIALIZER(mgmt_group_list);
 
+#if MYNEWT_VAL(MGMT_GROUP_TBL_SIZE) > 0
+/*
+ * Groups with small IDs, indexed by group ID.  Entries are only ever set,
+ * once the group is fully in the list; reading them needs no lock.
+ */
+static struct mgmt_group * volatile
+    mgmt_group_tbl[MYNEWT_VAL(MGMT_GROUP_TBL_SIZE)];
+#endif
+
 static int
 mgmt_group_list_lock(void)
 {
@@ -75,6 +85,12 @@ mgmt_group_register(struct mgmt_group *group)
     }
 
     STAILQ_INSERT_TAIL(&mgmt_group_list, group, mg_next);
+#if MYNEWT_VAL(MGMT_GROUP_TBL_SIZE) > 0
+    if (group->mg_group_id < MYNEWT_VAL(MGMT_GROUP_TBL_SIZE) &&
+        !mgmt_group_tbl[group->mg_group_id]) {
+        mgmt_group_tbl[group->mg_group_id] = group;
+    }
+#endif
 
     rc = mgmt_group_list_unlock();
     if (rc != 0) {
@@ -92,6 +108,12 @@ mgmt_find_group(uint16_t group_id)
     struct mgmt_group *group;
     int rc;
 
+#if MYNEWT_VAL(MGMT_GROUP_TBL_SIZE) > 0
+    if (group_id < MYNEWT_VAL(MGMT_GROUP_TBL_SIZE)) {
+        return mgmt_group_tbl[group_id];
+    }
+#endif
+
     group = NULL;
 
     rc = mgmt_group_list_lock();
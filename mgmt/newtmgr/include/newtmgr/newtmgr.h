@@ -21,6 +21,7 @@
 #define _NEWTMGR_H_
 
 #include <tinycbor/cbor.h>
+#include "syscfg/syscfg.h"
 #include <inttypes.h>
 #include <os/os.h>
 #include <os/endian.h>
@@ -48,6 +49,9 @@ typedef uint16_t (*nmgr_transport_get_mtu_func_t)(struct os_mbuf *m);
 
 struct nmgr_transport {
     struct os_mqueue nt_imq;
+#if MYNEWT_VAL(NEWTMGR_SLOW_WORKER)
+    struct os_mqueue nt_slow_imq;
+#endif
     nmgr_transport_out_func_t nt_output;
     nmgr_transport_get_mtu_func_t nt_get_mtu;
 };
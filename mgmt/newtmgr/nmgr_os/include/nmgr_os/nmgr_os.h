@@ -33,6 +33,10 @@ extern "C" {
 #define NMGR_ID_MPSTATS         3
 #define NMGR_ID_DATETIME_STR    4
 #define NMGR_ID_RESET           5
+#define NMGR_ID_HEAPSTATS       6
+#define NMGR_ID_BOOTSTATS       7
+#define NMGR_ID_TRACE           8
+#define NMGR_ID_MPOWNERS        9
 
 int nmgr_os_groups_register(void);
 
@@ -22,6 +22,7 @@
 #include <os/endian.h>
 
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <hal/hal_system.h>
@@ -31,11 +32,16 @@
 
 #include <console/console.h>
 #include <datetime/datetime.h>
+#include <sysinit/sysinit.h>
 
 #if MYNEWT_VAL(LOG_SOFT_RESET)
 #include <reboot/log_reboot.h>
 #endif
 
+#if MYNEWT_VAL(CONFIG_SAVE_DEFER) > 0
+#include <config/config.h>
+#endif
+
 #include "nmgr_os/nmgr_os.h"
 
 #include <tinycbor/cbor.h>
@@ -50,6 +56,18 @@ static int nmgr_def_mpstat_read(struct mgmt_cbuf *njb);
 static int nmgr_datetime_get(struct mgmt_cbuf *njb);
 static int nmgr_datetime_set(struct mgmt_cbuf *njb);
 static int nmgr_reset(struct mgmt_cbuf *njb);
+#if MYNEWT_VAL(BASELIBC_PRESENT)
+static int nmgr_def_heapstat_read(struct mgmt_cbuf *njb);
+#endif
+#if MYNEWT_VAL(SYSINIT_PROFILE) || MYNEWT_VAL(OS_DEV_INIT_PROFILE)
+static int nmgr_def_bootstat_read(struct mgmt_cbuf *njb);
+#endif
+#if MYNEWT_VAL(OS_TRACE)
+static int nmgr_def_trace_read(struct mgmt_cbuf *njb);
+#endif
+#if MYNEWT_VAL(OS_MEMPOOL_OWNER)
+static int nmgr_def_mpowner_read(struct mgmt_cbuf *njb);
+#endif
 
 static const struct mgmt_handler nmgr_def_group_handlers[] = {
     [NMGR_ID_ECHO] = {
@@ -70,6 +88,26 @@ static const struct mgmt_handler nmgr_def_group_handlers[] = {
     [NMGR_ID_RESET] = {
         NULL, nmgr_reset
     },
+#if MYNEWT_VAL(BASELIBC_PRESENT)
+    [NMGR_ID_HEAPSTATS] = {
+        nmgr_def_heapstat_read, NULL
+    },
+#endif
+#if MYNEWT_VAL(SYSINIT_PROFILE) || MYNEWT_VAL(OS_DEV_INIT_PROFILE)
+    [NMGR_ID_BOOTSTATS] = {
+        nmgr_def_bootstat_read, NULL
+    },
+#endif
+#if MYNEWT_VAL(OS_TRACE)
+    [NMGR_ID_TRACE] = {
+        nmgr_def_trace_read, NULL
+    },
+#endif
+#if MYNEWT_VAL(OS_MEMPOOL_OWNER)
+    [NMGR_ID_MPOWNERS] = {
+        nmgr_def_mpowner_read, NULL
+    },
+#endif
 };
 
 #define NMGR_DEF_GROUP_SZ                                               \
@@ -180,6 +218,14 @@ nmgr_def_taskstat_read(struct mgmt_cbuf *cb)
         g_err |= cbor_encode_uint(&task, oti.oti_last_checkin);
         g_err |= cbor_encode_text_stringz(&task, "next_checkin");
         g_err |= cbor_encode_uint(&task, oti.oti_next_checkin);
+#if MYNEWT_VAL(OS_TASK_PROFILE)
+        g_err |= cbor_encode_text_stringz(&task, "prof_run");
+        g_err |= cbor_encode_uint(&task, oti.oti_prof_run);
+        g_err |= cbor_encode_text_stringz(&task, "prof_isr");
+        g_err |= cbor_encode_uint(&task, oti.oti_prof_isr);
+        g_err |= cbor_encode_text_stringz(&task, "prof_maxrun");
+        g_err |= cbor_encode_uint(&task, oti.oti_prof_max_run);
+#endif
         g_err |= cbor_encoder_close_container(&tasks, &task);
     }
     g_err |= cbor_encoder_close_container(&cb->encoder, &tasks);
@@ -222,6 +268,8 @@ nmgr_def_mpstat_read(struct mgmt_cbuf *cb)
         g_err |= cbor_encode_uint(&pool, omi.omi_num_free);
         g_err |= cbor_encode_text_stringz(&pool, "min");
         g_err |= cbor_encode_uint(&pool, omi.omi_min_free);
+        g_err |= cbor_encode_text_stringz(&pool, "exhaust");
+        g_err |= cbor_encode_uint(&pool, omi.omi_num_exhausted);
         g_err |= cbor_encoder_close_container(&pools, &pool);
     }
 
@@ -233,6 +281,175 @@ nmgr_def_mpstat_read(struct mgmt_cbuf *cb)
     return (0);
 }
 
+#if MYNEWT_VAL(OS_MEMPOOL_OWNER)
+/*
+ * Blocks currently taken from memory pools: "owners" lists the pool, the
+ * caller's return address and the task id of each; "untracked" counts gets
+ * made while the owner table was full.
+ */
+static int
+nmgr_def_mpowner_read(struct mgmt_cbuf *cb)
+{
+    struct os_memblock_owner omo;
+    CborError g_err = CborNoError;
+    CborEncoder owners;
+    CborEncoder owner;
+    int idx;
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "rc");
+    g_err |= cbor_encode_int(&cb->encoder, MGMT_ERR_EOK);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "owners");
+    g_err |= cbor_encoder_create_array(&cb->encoder, &owners,
+                                       CborIndefiniteLength);
+
+    idx = 0;
+    while (os_memblock_owner_get_next(&idx, &omo) == 0) {
+        g_err |= cbor_encoder_create_map(&owners, &owner,
+                                         CborIndefiniteLength);
+        g_err |= cbor_encode_text_stringz(&owner, "pool");
+        g_err |= cbor_encode_text_stringz(&owner, omo.omo_pool->name);
+        g_err |= cbor_encode_text_stringz(&owner, "ra");
+        g_err |= cbor_encode_uint(&owner, (uintptr_t)omo.omo_ra);
+        g_err |= cbor_encode_text_stringz(&owner, "task");
+        g_err |= cbor_encode_uint(&owner, omo.omo_taskid);
+        g_err |= cbor_encoder_close_container(&owners, &owner);
+    }
+
+    g_err |= cbor_encoder_close_container(&cb->encoder, &owners);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "untracked");
+    g_err |= cbor_encode_uint(&cb->encoder, os_memblock_owner_untracked());
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return (0);
+}
+#endif
+
+#if MYNEWT_VAL(BASELIBC_PRESENT)
+/*
+ * Heap free bytes, the largest free block, and fragmentation as the
+ * percentage of free bytes outside the largest block.
+ */
+static int
+nmgr_def_heapstat_read(struct mgmt_cbuf *cb)
+{
+    CborError g_err = CborNoError;
+    size_t free_bytes;
+    size_t largest;
+    unsigned frag;
+
+    get_malloc_memory_status(&free_bytes, &largest);
+    if (free_bytes) {
+        frag = 100 - (uint64_t)largest * 100 / free_bytes;
+    } else {
+        frag = 0;
+    }
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "rc");
+    g_err |= cbor_encode_int(&cb->encoder, MGMT_ERR_EOK);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "free");
+    g_err |= cbor_encode_uint(&cb->encoder, free_bytes);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "largest");
+    g_err |= cbor_encode_uint(&cb->encoder, largest);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "frag");
+    g_err |= cbor_encode_uint(&cb->encoder, frag);
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return (0);
+}
+#endif
+
+#if MYNEWT_VAL(SYSINIT_PROFILE) || MYNEWT_VAL(OS_DEV_INIT_PROFILE)
+/*
+ * Boot timing in microseconds: "steps" holds the sysinit profile records in
+ * order, "devs" the time each device's init function took.
+ */
+static int
+nmgr_def_bootstat_read(struct mgmt_cbuf *cb)
+{
+    CborError g_err = CborNoError;
+#if MYNEWT_VAL(SYSINIT_PROFILE)
+    CborEncoder steps;
+    CborEncoder step;
+    const char *name;
+    uint32_t usecs;
+    int i;
+#endif
+#if MYNEWT_VAL(OS_DEV_INIT_PROFILE)
+    CborEncoder devs;
+    struct os_dev *dev;
+#endif
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "rc");
+    g_err |= cbor_encode_int(&cb->encoder, MGMT_ERR_EOK);
+
+#if MYNEWT_VAL(SYSINIT_PROFILE)
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "steps");
+    g_err |= cbor_encoder_create_array(&cb->encoder, &steps,
+                                       CborIndefiniteLength);
+    for (i = 0; sysinit_profile_get(i, &name, &usecs) == 0; i++) {
+        g_err |= cbor_encoder_create_map(&steps, &step, CborIndefiniteLength);
+        g_err |= cbor_encode_text_stringz(&step, "name");
+        g_err |= cbor_encode_text_stringz(&step, name);
+        g_err |= cbor_encode_text_stringz(&step, "usecs");
+        g_err |= cbor_encode_uint(&step, usecs);
+        g_err |= cbor_encoder_close_container(&steps, &step);
+    }
+    g_err |= cbor_encoder_close_container(&cb->encoder, &steps);
+#endif
+
+#if MYNEWT_VAL(OS_DEV_INIT_PROFILE)
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "devs");
+    g_err |= cbor_encoder_create_map(&cb->encoder, &devs,
+                                     CborIndefiniteLength);
+    dev = NULL;
+    while ((dev = os_dev_get_next(dev)) != NULL) {
+        g_err |= cbor_encode_text_stringz(&devs, dev->od_name);
+        g_err |= cbor_encode_uint(&devs, dev->od_init_usecs);
+    }
+    g_err |= cbor_encoder_close_container(&cb->encoder, &devs);
+#endif
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return (0);
+}
+#endif
+
+#if MYNEWT_VAL(OS_TRACE)
+/*
+ * Drains the oldest kernel trace records: "d" holds them as raw struct
+ * os_trace_rec, "lost" the number overwritten since the previous read.
+ */
+static int
+nmgr_def_trace_read(struct mgmt_cbuf *cb)
+{
+    struct os_trace_rec recs[MYNEWT_VAL(NMGR_TRACE_READ_MAX)];
+    CborError g_err = CborNoError;
+    uint32_t lost;
+    int n;
+
+    n = os_trace_read(recs, MYNEWT_VAL(NMGR_TRACE_READ_MAX), &lost);
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "rc");
+    g_err |= cbor_encode_int(&cb->encoder, MGMT_ERR_EOK);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "lost");
+    g_err |= cbor_encode_uint(&cb->encoder, lost);
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "d");
+    g_err |= cbor_encode_byte_string(&cb->encoder, (uint8_t *)recs,
+                                     n * sizeof(recs[0]));
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return (0);
+}
+#endif
+
 static int
 nmgr_datetime_get(struct mgmt_cbuf *cb)
 {
@@ -327,6 +544,9 @@ nmgr_reset(struct mgmt_cbuf *cb)
 
 #if MYNEWT_VAL(LOG_SOFT_RESET)
     log_reboot(HAL_RESET_REQUESTED);
+#endif
+#if MYNEWT_VAL(CONFIG_SAVE_DEFER) > 0
+    conf_save_flush();
 #endif
     os_callout_reset(&nmgr_reset_callout, OS_TICKS_PER_SEC / 4);
 
@@ -39,15 +39,52 @@
 /* Shared queue that newtmgr uses for work items. */
 struct os_eventq *nmgr_evq;
 
+#if MYNEWT_VAL(NEWTMGR_STREAM_RSP)
 /*
- * cbor buffer for newtmgr
+ * cbor writer for streamed responses.  Encoded data is collected into an
+ * mbuf holding one response part; the part is sent when it reaches the
+ * MTU.  At most one part is buffered at a time.
  */
-static struct nmgr_cbuf {
+struct nmgr_stream_writer {
+    struct cbor_encoder_writer enc;
+    struct nmgr_transport *nt;
+    struct os_mbuf *req;            /* Source of user header for parts. */
+    struct os_mbuf *m;              /* Part being filled; NULL if none. */
+    struct nmgr_hdr hdr;
+    uint16_t mtu;
+};
+#endif
+
+/*
+ * cbor buffer for newtmgr; one for each context handling requests.
+ */
+struct nmgr_cbuf {
     struct mgmt_cbuf n_b;
     struct cbor_mbuf_writer writer;
     struct cbor_mbuf_reader reader;
     struct os_mbuf *n_out_m;
-} nmgr_task_cbuf;
+#if MYNEWT_VAL(NEWTMGR_STREAM_RSP)
+    struct nmgr_stream_writer stream;
+#endif
+};
+
+static struct nmgr_cbuf nmgr_task_cbuf;
+
+#if MYNEWT_VAL(NEWTMGR_SLOW_WORKER)
+/*
+ * Requests for groups which can take long (image, fs) are handled by a
+ * task of their own, so that they don't hold up the other groups.
+ * Responses can then go out in different order than requests came in;
+ * peer matches them using nh_seq.
+ */
+static struct nmgr_cbuf nmgr_slow_cbuf;
+static struct os_eventq nmgr_slow_evq;
+static struct os_task nmgr_slow_task;
+static os_stack_t nmgr_slow_stack[MYNEWT_VAL(NEWTMGR_SLOW_STACK_SIZE)];
+
+/* Transport output is serialized between the two tasks. */
+static struct os_mutex nmgr_out_mtx;
+#endif
 
 struct os_eventq *
 mgmt_evq_get(void)
@@ -69,7 +106,7 @@ nmgr_cbuf_init(struct nmgr_cbuf *njb)
 }
 
 static struct nmgr_hdr *
-nmgr_init_rsp(struct os_mbuf *m, struct nmgr_hdr *src)
+nmgr_init_rsp(struct nmgr_cbuf *cb, struct os_mbuf *m, struct nmgr_hdr *src)
 {
     struct nmgr_hdr *hdr;
 
@@ -87,45 +124,63 @@ nmgr_init_rsp(struct os_mbuf *m, struct nmgr_hdr *src)
     hdr->nh_id = src->nh_id;
 
     /* setup state for cbor encoding */
-    cbor_mbuf_writer_init(&nmgr_task_cbuf.writer, m);
-    cbor_encoder_init(&nmgr_task_cbuf.n_b.encoder, &nmgr_task_cbuf.writer.enc, 0);
-    nmgr_task_cbuf.n_out_m = m;
+    cbor_mbuf_writer_init(&cb->writer, m);
+    cbor_encoder_init(&cb->n_b.encoder, &cb->writer.enc, 0);
+    cb->n_out_m = m;
     return hdr;
 }
 
+/*
+ * Transport output; serialized if requests are handled in more than one
+ * task.
+ */
+static int
+nmgr_output(struct nmgr_transport *nt, struct os_mbuf *m)
+{
+    int rc;
+
+#if MYNEWT_VAL(NEWTMGR_SLOW_WORKER)
+    os_mutex_pend(&nmgr_out_mtx, OS_TIMEOUT_NEVER);
+#endif
+    rc = nt->nt_output(nt, m);
+#if MYNEWT_VAL(NEWTMGR_SLOW_WORKER)
+    os_mutex_release(&nmgr_out_mtx);
+#endif
+    return rc;
+}
+
 static void
-nmgr_send_err_rsp(struct nmgr_transport *nt, struct os_mbuf *m,
-                  struct nmgr_hdr *hdr, int status)
+nmgr_send_err_rsp(struct nmgr_cbuf *cb, struct nmgr_transport *nt,
+                  struct os_mbuf *m, struct nmgr_hdr *hdr, int status)
 {
     struct CborEncoder map;
     int rc;
 
-    hdr = nmgr_init_rsp(m, hdr);
+    hdr = nmgr_init_rsp(cb, m, hdr);
     if (!hdr) {
         os_mbuf_free_chain(m);
         return;
     }
 
-    rc = cbor_encoder_create_map(&nmgr_task_cbuf.n_b.encoder, &map,
+    rc = cbor_encoder_create_map(&cb->n_b.encoder, &map,
                                  CborIndefiniteLength);
     if (rc != 0) {
         return;
     }
 
-    rc = mgmt_cbuf_setoerr(&nmgr_task_cbuf.n_b, status);
+    rc = mgmt_cbuf_setoerr(&cb->n_b, status);
     if (rc != 0) {
         return;
     }
 
-    rc = cbor_encoder_close_container(&nmgr_task_cbuf.n_b.encoder, &map);
+    rc = cbor_encoder_close_container(&cb->n_b.encoder, &map);
     if (rc != 0) {
         return;
     }
 
-    hdr->nh_len =
-        htons(cbor_encode_bytes_written(&nmgr_task_cbuf.n_b.encoder));
+    hdr->nh_len = htons(cbor_encode_bytes_written(&cb->n_b.encoder));
 
-    nt->nt_output(nt, nmgr_task_cbuf.n_out_m);
+    nmgr_output(nt, cb->n_out_m);
 }
 
 /**
@@ -173,7 +228,7 @@ nmgr_rsp_tx(struct nmgr_transport *nt, struct os_mbuf **rsp, uint16_t mtu)
             return MGMT_ERR_ENOMEM;
         }
 
-        rc = nt->nt_output(nt, frag);
+        rc = nmgr_output(nt, frag);
         if (rc != 0) {
             /* Output function already freed mbuf. */
             return MGMT_ERR_EUNKNOWN;
@@ -183,8 +238,137 @@ nmgr_rsp_tx(struct nmgr_transport *nt, struct os_mbuf **rsp, uint16_t mtu)
     return MGMT_ERR_EOK;
 }
 
+#if MYNEWT_VAL(NEWTMGR_STREAM_RSP)
+static int
+nmgr_stream_part_new(struct nmgr_stream_writer *sw)
+{
+    os_time_t start;
+
+    start = os_time_get();
+    while (1) {
+        sw->m = nmgr_rsp_frag_alloc(sw->mtu, sw->req);
+        if (sw->m) {
+            break;
+        }
+        if (os_time_get() - start >= MYNEWT_VAL(NEWTMGR_STREAM_WAIT)) {
+            return MGMT_ERR_ENOMEM;
+        }
+        /* Give the transport time to drain the parts already sent. */
+        os_time_delay(1);
+    }
+    if (os_mbuf_append(sw->m, &sw->hdr, sizeof(sw->hdr))) {
+        os_mbuf_free_chain(sw->m);
+        sw->m = NULL;
+        return MGMT_ERR_ENOMEM;
+    }
+    return 0;
+}
+
+static int
+nmgr_stream_part_tx(struct nmgr_stream_writer *sw, uint8_t flags)
+{
+    struct nmgr_hdr hdr;
+    struct os_mbuf *m;
+
+    m = sw->m;
+    sw->m = NULL;
+
+    hdr = sw->hdr;
+    hdr.nh_len = htons(OS_MBUF_PKTLEN(m) - sizeof(hdr));
+    hdr.nh_flags = NMGR_F_STREAM | flags;
+    os_mbuf_copyinto(m, 0, &hdr, sizeof(hdr));
+
+    if (nmgr_output(sw->nt, m)) {
+        /* Output function already freed mbuf. */
+        return MGMT_ERR_EUNKNOWN;
+    }
+    return 0;
+}
+
+static int
+nmgr_stream_write(struct cbor_encoder_writer *arg, const char *data, int len)
+{
+    struct nmgr_stream_writer *sw;
+    int chunk;
+
+    sw = (struct nmgr_stream_writer *)arg;
+    while (len > 0) {
+        if (!sw->m && nmgr_stream_part_new(sw)) {
+            return CborErrorOutOfMemory;
+        }
+        chunk = sw->mtu - OS_MBUF_PKTLEN(sw->m);
+        if (chunk > len) {
+            chunk = len;
+        }
+        if (os_mbuf_append(sw->m, data, chunk)) {
+            return CborErrorOutOfMemory;
+        }
+        sw->enc.bytes_written += chunk;
+        data += chunk;
+        len -= chunk;
+
+        if (OS_MBUF_PKTLEN(sw->m) >= sw->mtu &&
+            nmgr_stream_part_tx(sw, NMGR_F_MORE)) {
+            return CborErrorIO;
+        }
+    }
+    return CborNoError;
+}
+
+static int
+nmgr_stream_start(struct nmgr_cbuf *cb, struct nmgr_transport *nt,
+                  struct os_mbuf *req, struct nmgr_hdr *src, uint16_t mtu)
+{
+    struct nmgr_stream_writer *sw;
+
+    sw = &cb->stream;
+    if (mtu <= sizeof(sw->hdr)) {
+        return MGMT_ERR_EINVAL;
+    }
+    sw->enc.write = nmgr_stream_write;
+    sw->enc.bytes_written = 0;
+    sw->nt = nt;
+    sw->req = req;
+    sw->m = NULL;
+    sw->mtu = mtu;
+    sw->hdr = *src;
+    sw->hdr.nh_op = (src->nh_op == NMGR_OP_READ) ? NMGR_OP_READ_RSP :
+      NMGR_OP_WRITE_RSP;
+
+    cbor_encoder_init(&cb->n_b.encoder, &sw->enc, 0);
+    return 0;
+}
+
+/*
+ * Sends the last part of the response.
+ */
+static int
+nmgr_stream_finish(struct nmgr_stream_writer *sw)
+{
+    int rc;
+
+    if (!sw->m) {
+        rc = nmgr_stream_part_new(sw);
+        if (rc) {
+            return rc;
+        }
+    }
+    return nmgr_stream_part_tx(sw, 0);
+}
+
 static void
-nmgr_handle_req(struct nmgr_transport *nt, struct os_mbuf *req)
+nmgr_stream_abort(struct nmgr_stream_writer *sw)
+{
+    if (sw->m) {
+        os_mbuf_free_chain(sw->m);
+        sw->m = NULL;
+    }
+}
+#endif
+
+static void
+nmgr_handle_req(struct nmgr_cbuf *cb, struct nmgr_transport *nt,
+                struct os_mbuf *req)
 {
     struct os_mbuf *rsp;
     const struct mgmt_handler *handler;
@@ -195,6 +379,9 @@ nmgr_handle_req(struct nmgr_transport *nt, struct os_mbuf *req)
     uint16_t len;
     uint16_t mtu;
     int rc;
+#if MYNEWT_VAL(NEWTMGR_STREAM_RSP)
+    int stream;
+#endif
 
     rsp_hdr = NULL;
 
@@ -232,23 +419,36 @@ nmgr_handle_req(struct nmgr_transport *nt, struct os_mbuf *req)
             goto err;
         }
 
-        /* Build response header apriori.  Then pass to the handlers
-         * to fill out the response data, and adjust length & flags.
+#if MYNEWT_VAL(NEWTMGR_STREAM_RSP)
+        /* Streamed response goes out in parts of its own; rsp is kept for
+         * a possible error response.
          */
-        rsp_hdr = nmgr_init_rsp(rsp, &hdr);
-        if (!rsp_hdr) {
-            rc = MGMT_ERR_ENOMEM;
-            goto err_norsp;
+        stream = hdr.nh_flags & NMGR_F_STREAM;
+        if (stream) {
+            rc = nmgr_stream_start(cb, nt, req, &hdr, mtu);
+            if (rc) {
+                goto err;
+            }
+        } else
+#endif
+        {
+            /* Build response header apriori.  Then pass to the handlers
+             * to fill out the response data, and adjust length & flags.
+             */
+            rsp_hdr = nmgr_init_rsp(cb, rsp, &hdr);
+            if (!rsp_hdr) {
+                rc = MGMT_ERR_ENOMEM;
+                goto err_norsp;
+            }
         }
 
-        cbor_mbuf_reader_init(&nmgr_task_cbuf.reader, req, sizeof(hdr));
-        cbor_parser_init(&nmgr_task_cbuf.reader.r, 0,
-                         &nmgr_task_cbuf.n_b.parser, &nmgr_task_cbuf.n_b.it);
+        cbor_mbuf_reader_init(&cb->reader, req, sizeof(hdr));
+        cbor_parser_init(&cb->reader.r, 0, &cb->n_b.parser, &cb->n_b.it);
 
         /* Begin response payload.  Response fields are inserted into the root
          * map as key value pairs.
          */
-        rc = cbor_encoder_create_map(&nmgr_task_cbuf.n_b.encoder, &payload_enc,
+        rc = cbor_encoder_create_map(&cb->n_b.encoder, &payload_enc,
                                      CborIndefiniteLength);
         if (rc != 0) {
             rc = MGMT_ERR_ENOMEM;
@@ -257,13 +457,13 @@ nmgr_handle_req(struct nmgr_transport *nt, struct os_mbuf *req)
 
         if (hdr.nh_op == NMGR_OP_READ) {
             if (handler->mh_read) {
-                rc = handler->mh_read(&nmgr_task_cbuf.n_b);
+                rc = handler->mh_read(&cb->n_b);
             } else {
                 rc = MGMT_ERR_ENOENT;
             }
         } else if (hdr.nh_op == NMGR_OP_WRITE) {
             if (handler->mh_write) {
-                rc = handler->mh_write(&nmgr_task_cbuf.n_b);
+                rc = handler->mh_write(&cb->n_b);
             } else {
                 rc = MGMT_ERR_ENOENT;
             }
@@ -275,15 +475,24 @@ nmgr_handle_req(struct nmgr_transport *nt, struct os_mbuf *req)
         }
 
         /* End response payload. */
-        rc = cbor_encoder_close_container(&nmgr_task_cbuf.n_b.encoder,
-                                          &payload_enc);
+        rc = cbor_encoder_close_container(&cb->n_b.encoder, &payload_enc);
         if (rc != 0) {
             rc = MGMT_ERR_ENOMEM;
             goto err;
         }
 
-        rsp_hdr->nh_len +=
-            cbor_encode_bytes_written(&nmgr_task_cbuf.n_b.encoder);
+#if MYNEWT_VAL(NEWTMGR_STREAM_RSP)
+        if (stream) {
+            rc = nmgr_stream_finish(&cb->stream);
+            if (rc) {
+                goto err;
+            }
+            off += sizeof(hdr) + OS_ALIGN(hdr.nh_len, 4);
+            continue;
+        }
+#endif
+
+        rsp_hdr->nh_len += cbor_encode_bytes_written(&cb->n_b.encoder);
         rsp_hdr->nh_len = htons(rsp_hdr->nh_len);
 
         rc = nmgr_rsp_tx(nt, &rsp, mtu);
@@ -306,10 +515,13 @@ nmgr_handle_req(struct nmgr_transport *nt, struct os_mbuf *req)
     return;
 
 err:
+#if MYNEWT_VAL(NEWTMGR_STREAM_RSP)
+    nmgr_stream_abort(&cb->stream);
+#endif
     /* Clear partially written response. */
     os_mbuf_adj(rsp, OS_MBUF_PKTLEN(rsp));
 
-    nmgr_send_err_rsp(nt, rsp, &hdr, rc);
+    nmgr_send_err_rsp(cb, nt, rsp, &hdr, rc);
     os_mbuf_free_chain(req);
     return;
 
@@ -320,6 +532,45 @@ err_norsp:
 }
 
 
+#if MYNEWT_VAL(NEWTMGR_SLOW_WORKER)
+/*
+ * Whether request should be handled by the slow worker.  Decided by the
+ * group of the first request in the mbuf.
+ */
+static int
+nmgr_req_is_slow(struct os_mbuf *req)
+{
+    struct nmgr_hdr hdr;
+    uint16_t group;
+
+    if (os_mbuf_copydata(req, 0, sizeof(hdr), &hdr)) {
+        return 0;
+    }
+    group = ntohs(hdr.nh_group);
+    return group == MGMT_GROUP_ID_IMAGE || group == MGMT_GROUP_ID_FS;
+}
+
+static void
+nmgr_slow_data_in(struct os_event *ev)
+{
+    struct nmgr_transport *nt;
+    struct os_mbuf *m;
+
+    nt = ev->ev_arg;
+    while ((m = os_mqueue_get(&nt->nt_slow_imq)) != NULL) {
+        nmgr_handle_req(&nmgr_slow_cbuf, nt, m);
+    }
+}
+
+static void
+nmgr_slow_task_handler(void *arg)
+{
+    while (1) {
+        os_eventq_run(&nmgr_slow_evq);
+    }
+}
+#endif
+
 static void
 nmgr_process(struct nmgr_transport *nt)
 {
@@ -331,7 +582,15 @@ nmgr_process(struct nmgr_transport *nt)
             break;
         }
 
-        nmgr_handle_req(nt, m);
+#if MYNEWT_VAL(NEWTMGR_SLOW_WORKER)
+        if (nmgr_req_is_slow(m)) {
+            if (os_mqueue_put(&nt->nt_slow_imq, &nmgr_slow_evq, m)) {
+                os_mbuf_free_chain(m);
+            }
+            continue;
+        }
+#endif
+        nmgr_handle_req(&nmgr_task_cbuf, nt, m);
     }
 }
 
@@ -355,6 +614,12 @@ nmgr_transport_init(struct nmgr_transport *nt,
     if (rc != 0) {
         goto err;
     }
+#if MYNEWT_VAL(NEWTMGR_SLOW_WORKER)
+    rc = os_mqueue_init(&nt->nt_slow_imq, nmgr_slow_data_in, nt);
+    if (rc != 0) {
+        goto err;
+    }
+#endif
 
     return (0);
 err:
@@ -398,5 +663,15 @@ nmgr_pkg_init(void)
 
     nmgr_cbuf_init(&nmgr_task_cbuf);
 
+#if MYNEWT_VAL(NEWTMGR_SLOW_WORKER)
+    nmgr_cbuf_init(&nmgr_slow_cbuf);
+    os_mutex_init(&nmgr_out_mtx);
+    os_eventq_init(&nmgr_slow_evq);
+    rc = os_task_init(&nmgr_slow_task, "nmgr_slow", nmgr_slow_task_handler,
+                      NULL, MYNEWT_VAL(NEWTMGR_SLOW_TASK_PRIO), OS_WAIT_FOREVER,
+                      nmgr_slow_stack, MYNEWT_VAL(NEWTMGR_SLOW_STACK_SIZE));
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+
     mgmt_evq_set(os_eventq_dflt_get());
 }
@@ -35,6 +35,15 @@
 #define SHELL_NLIP_DATA         0x0414
 #define SHELL_NLIP_MAX_FRAME    128
 
+/*
+ * Binary framing: SLIP (RFC 1055), with the CRC-16 of the newtmgr packet
+ * appended to it inside the frame.
+ */
+#define NMGR_UART_SLIP_END      0xc0
+#define NMGR_UART_SLIP_ESC      0xdb
+#define NMGR_UART_SLIP_ESC_END  0xdc
+#define NMGR_UART_SLIP_ESC_ESC  0xdd
+
 #define NUS_EV_TO_STATE(ptr)                                            \
     (struct nmgr_uart_state *)((uint8_t *)ptr -                         \
       (int)&(((struct nmgr_uart_state *)0)->nus_cb_ev))
@@ -48,6 +57,12 @@ struct nmgr_uart_state {
     struct os_mbuf_pkthdr *nus_rx_pkt;
     struct os_mbuf_pkthdr *nus_rx_q;
     struct os_mbuf_pkthdr *nus_rx;
+#if MYNEWT_VAL(NMGR_UART_SLIP)
+    uint8_t nus_slip:1;         /* Respond in SLIP frames */
+    uint8_t nus_rx_slip:1;      /* nus_rx is a SLIP frame */
+    uint8_t nus_rx_esc:1;       /* Last SLIP char was an escape */
+    uint8_t nus_rx_q_slip:1;    /* nus_rx_q is a SLIP frame */
+#endif
 };
 
 /*
@@ -66,6 +81,67 @@ nmgr_uart_mtu(struct os_mbuf *m)
     return MGMT_MAX_MTU;
 }
 
+#if MYNEWT_VAL(NMGR_UART_SLIP)
+/*
+ * Encodes packet, CRC included, into a SLIP frame.
+ */
+static struct os_mbuf *
+nmgr_uart_slip_enc(struct os_mbuf *m)
+{
+    struct os_mbuf *n;
+    struct os_mbuf *om;
+    uint8_t buf[32];
+    int blen;
+    int i;
+
+    n = os_msys_get(SHELL_NLIP_MAX_FRAME, 0);
+    if (!n) {
+        return NULL;
+    }
+
+    /* Leading END flushes any line noise the host has received. */
+    buf[0] = NMGR_UART_SLIP_END;
+    blen = 1;
+    for (om = m; om; om = SLIST_NEXT(om, om_next)) {
+        for (i = 0; i < om->om_len; i++) {
+            if (blen >= sizeof(buf) - 1) {
+                if (os_mbuf_append(n, buf, blen)) {
+                    goto err;
+                }
+                blen = 0;
+            }
+            switch (om->om_data[i]) {
+            case NMGR_UART_SLIP_END:
+                buf[blen++] = NMGR_UART_SLIP_ESC;
+                buf[blen++] = NMGR_UART_SLIP_ESC_END;
+                break;
+            case NMGR_UART_SLIP_ESC:
+                buf[blen++] = NMGR_UART_SLIP_ESC;
+                buf[blen++] = NMGR_UART_SLIP_ESC_ESC;
+                break;
+            default:
+                buf[blen++] = om->om_data[i];
+                break;
+            }
+        }
+    }
+    if (blen >= sizeof(buf)) {
+        if (os_mbuf_append(n, buf, blen)) {
+            goto err;
+        }
+        blen = 0;
+    }
+    buf[blen++] = NMGR_UART_SLIP_END;
+    if (os_mbuf_append(n, buf, blen)) {
+        goto err;
+    }
+    return n;
+err:
+    os_mbuf_free_chain(n);
+    return NULL;
+}
+#endif
+
 /*
  * Called by mgmt to queue packet out to UART.
  */
@@ -103,6 +179,19 @@ nmgr_uart_out(struct nmgr_transport *nt, struct os_mbuf *m)
     }
     memcpy(dst, tmp_buf, sizeof(uint16_t));
 
+#if MYNEWT_VAL(NMGR_UART_SLIP)
+    /*
+     * Respond in the framing the host used for its last request.
+     */
+    if (nus->nus_slip) {
+        n = nmgr_uart_slip_enc(m);
+        if (!n) {
+            goto err;
+        }
+        goto tx;
+    }
+#endif
+
     /*
      * Create another mbuf chain with base64 encoded data.
      */
@@ -163,6 +252,9 @@ nmgr_uart_out(struct nmgr_transport *nt, struct os_mbuf *m)
         }
     }
 
+#if MYNEWT_VAL(NMGR_UART_SLIP)
+tx:
+#endif
     os_mbuf_free_chain(m);
     OS_ENTER_CRITICAL(sr);
     if (!nus->nus_tx) {
@@ -282,6 +374,9 @@ nmgr_uart_rx_pkt(struct nmgr_uart_state *nus, struct os_mbuf_pkthdr *rxm)
     if (nus->nus_rx_pkt->omp_len - sizeof(*nsh) == ntohs(nsh->nsh_len)) {
         os_mbuf_adj(m, 4);
         os_mbuf_adj(m, -2);
+#if MYNEWT_VAL(NMGR_UART_SLIP)
+        nus->nus_slip = 0;
+#endif
         nmgr_rx_req(&nus->nus_transport, m);
         nus->nus_rx_pkt = NULL;
     }
@@ -290,6 +385,46 @@ err:
     os_mbuf_free_chain(m);
 }
 
+#if MYNEWT_VAL(NMGR_UART_SLIP)
+/*
+ * Check CRC of a SLIP frame, and pass the packet in it to newtmgr.
+ */
+static void
+nmgr_uart_rx_slip(struct nmgr_uart_state *nus, struct os_mbuf_pkthdr *rxm)
+{
+    struct os_mbuf *m;
+    struct os_mbuf *n;
+    uint16_t crc;
+
+    m = OS_MBUF_PKTHDR_TO_MBUF(rxm);
+
+    if (rxm->omp_len <= sizeof(crc)) {
+        goto err;
+    }
+
+    /*
+     * CRC computed over data followed by its big-endian CRC is zero.
+     */
+    crc = CRC16_INITIAL_CRC;
+    for (n = m; n; n = SLIST_NEXT(n, om_next)) {
+        crc = crc16_ccitt(crc, n->om_data, n->om_len);
+    }
+    if (crc != 0) {
+        goto err;
+    }
+    os_mbuf_adj(m, -(int)sizeof(crc));
+
+    /*
+     * Host speaks SLIP; responses go out the same way from now on.
+     */
+    nus->nus_slip = 1;
+    nmgr_rx_req(&nus->nus_transport, m);
+    return;
+err:
+    os_mbuf_free_chain(m);
+}
+#endif
+
 /*
  * Callback from mgmt task context.
  */
@@ -298,17 +433,45 @@ nmgr_uart_rx_frame(struct os_event *ev)
 {
     struct nmgr_uart_state *nus = NUS_EV_TO_STATE(ev);
     struct os_mbuf_pkthdr *m;
+#if MYNEWT_VAL(NMGR_UART_SLIP)
+    int slip;
+#endif
     int sr;
 
     OS_ENTER_CRITICAL(sr);
     m = nus->nus_rx_q;
     nus->nus_rx_q = NULL;
+#if MYNEWT_VAL(NMGR_UART_SLIP)
+    slip = nus->nus_rx_q_slip;
+#endif
     OS_EXIT_CRITICAL(sr);
     if (m) {
+#if MYNEWT_VAL(NMGR_UART_SLIP)
+        if (slip) {
+            nmgr_uart_rx_slip(nus, m);
+            return;
+        }
+#endif
         nmgr_uart_rx_pkt(nus, m);
     }
 }
 
+/*
+ * Hand a complete line/frame over to be processed outside interrupt
+ * context.
+ */
+static void
+nmgr_uart_rx_queue(struct nmgr_uart_state *nus, int slip)
+{
+    assert(!nus->nus_rx_q);
+    nus->nus_rx_q = nus->nus_rx;
+    nus->nus_rx = NULL;
+#if MYNEWT_VAL(NMGR_UART_SLIP)
+    nus->nus_rx_q_slip = slip;
+#endif
+    os_eventq_put(mgmt_evq_get(), &nus->nus_cb_ev);
+}
+
 /*
  * Receive a character from UART.
  */
@@ -336,20 +499,51 @@ nmgr_uart_rx_char(void *arg, uint8_t data)
     }
 
     m = OS_MBUF_PKTHDR_TO_MBUF(nus->nus_rx);
+#if MYNEWT_VAL(NMGR_UART_SLIP)
+    if (nus->nus_rx_slip) {
+        switch (data) {
+        case NMGR_UART_SLIP_END:
+            if (nus->nus_rx->omp_len == 0) {
+                /* Empty frame; host flushing the line. */
+                return 0;
+            }
+            nus->nus_rx_slip = 0;
+            nmgr_uart_rx_queue(nus, 1);
+            return 0;
+        case NMGR_UART_SLIP_ESC:
+            nus->nus_rx_esc = 1;
+            return 0;
+        default:
+            if (nus->nus_rx_esc) {
+                nus->nus_rx_esc = 0;
+                if (data == NMGR_UART_SLIP_ESC_END) {
+                    data = NMGR_UART_SLIP_END;
+                } else if (data == NMGR_UART_SLIP_ESC_ESC) {
+                    data = NMGR_UART_SLIP_ESC;
+                }
+            }
+            break;
+        }
+    } else if (data == NMGR_UART_SLIP_END && nus->nus_rx->omp_len == 0) {
+        /*
+         * END outside a base64 line starts a SLIP frame.
+         */
+        nus->nus_rx_slip = 1;
+        nus->nus_rx_esc = 0;
+        return 0;
+    } else
+#endif
     if (data == '\n') {
         /*
          * Full line of input. Process it outside interrupt context.
          */
-        assert(!nus->nus_rx_q);
-        nus->nus_rx_q = nus->nus_rx;
-        nus->nus_rx = NULL;
-        os_eventq_put(mgmt_evq_get(), &nus->nus_cb_ev);
+        nmgr_uart_rx_queue(nus, 0);
+        return 0;
+    }
+
+    rc = os_mbuf_append(m, &data, 1);
+    if (rc == 0) {
         return 0;
-    } else {
-        rc = os_mbuf_append(m, &data, 1);
-        if (rc == 0) {
-            return 0;
-        }
     }
     /* failed */
     nus->nus_rx->omp_len = 0;
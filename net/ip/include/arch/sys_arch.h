@@ -101,13 +101,11 @@ sys_mutex_unlock(sys_mutex_t *mutex)
 static inline uint32_t
 sys_now(void)
 {
-    uint32_t t;
-
     /*
-     * XXX not right when g_os_time rolls over
+     * lwIP timers compute differences of this, so wrapping at 32 bits is
+     * fine.
      */
-    t = os_time_get() * OS_TICKS_PER_SEC / 1000;
-    return t;
+    return os_get_uptime_usec() / 1000;
 }
 
 static inline err_t
@@ -0,0 +1,45 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef __IP_LWIP_MBUF_H__
+#define __IP_LWIP_MBUF_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <inttypes.h>
+
+struct pbuf;
+
+/*
+ * Allocates a pbuf with payload inside a single msys mbuf. Network
+ * drivers can use this instead of pbuf_alloc(PBUF_RAW, len, PBUF_POOL)
+ * for received frames; when the data ends up at a mn_socket, the mbuf is
+ * handed to the socket user without copying.
+ *
+ * Returns NULL if there's no msys mbuf with len bytes of contiguous space
+ * available.
+ */
+struct pbuf *lwip_mbuf_pbuf_alloc(uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IP_LWIP_MBUF_H__ */
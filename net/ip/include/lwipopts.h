@@ -23,6 +23,8 @@
 extern "C" {
 #endif
 
+#include "syscfg/syscfg.h"
+
 #define MEM_LIBC_MALLOC			1	/* use platform malloc */
 #define LWIP_NETIF_TX_SINGLE_PBUF 	1
 #define LWIP_NETIF_LOOPBACK		1	/* yes loopback interface */
@@ -98,14 +100,25 @@ extern "C" {
 /* MEMP_NUM_NETCONN: the number of struct netconns. */
 #define MEMP_NUM_NETCONN                0
 
+#if MYNEWT_VAL(LWIP_OS_MEMPOOL)
+/* memp pools are os_mempools, and show up in mpstat */
+#define MEMP_USE_OS_MEMPOOL             1
+#endif
+
 /* ---------- Pbuf options ---------- */
+#if MYNEWT_VAL(LWIP_PBUF_POOL_MSYS)
+/* PBUF_POOL pbufs are msys mbufs, see lwip_mem.c */
+#define MEMP_PBUF_POOL_MSYS             1
+#define PBUF_POOL_SIZE                  0
+#endif
+
 /* PBUF_POOL_SIZE: the number of buffers in the pbuf pool. */
 #ifndef PBUF_POOL_SIZE
 #define PBUF_POOL_SIZE                  6
 #endif
 
 /* PBUF_POOL_BUFSIZE: the size of each pbuf in the pbuf pool. */
-#define PBUF_POOL_BUFSIZE               1580
+#define PBUF_POOL_BUFSIZE               MYNEWT_VAL(LWIP_PBUF_POOL_BUFSIZE)
 
 /*
  * Disable this; causes excessive stack use in device drivers calling
@@ -117,6 +130,16 @@ extern "C" {
    link level header. */
 #define PBUF_LINK_HLEN                  16
 
+#if MYNEWT_VAL(LWIP_CHECKSUM_CTRL_PER_NETIF)
+/* Drivers with checksum offload use NETIF_SET_CHECKSUM_CTRL() */
+#define LWIP_CHECKSUM_CTRL_PER_NETIF    1
+#endif
+
+#if MYNEWT_VAL(LWIP_MBUF_PBUF)
+/* Needed for pbufs backed by msys mbufs, ip/lwip_mbuf.h */
+#define LWIP_SUPPORT_CUSTOM_PBUF        1
+#endif
+
 /* ---------- TCP options ---------- */
 #define LWIP_TCP                        1
 #define TCP_TTL                         255
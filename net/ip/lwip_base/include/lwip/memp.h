@@ -74,6 +74,27 @@ extern const struct memp_desc* const memp_pools[MEMP_MAX];
     LWIP_MEM_ALIGN_SIZE(size) \
   };
 
+#elif MEMP_USE_OS_MEMPOOL
+
+/* Elements come from an os_mempool named "lwip_<name>"; see memp_init_pool(). */
+#define LWIP_MEMPOOL_DECLARE(name,num,size,desc) \
+  static os_membuf_t memp_memory_ ## name ## _base[ \
+    OS_MEMPOOL_SIZE((num), LWIP_MEM_ALIGN_SIZE(size))]; \
+    \
+  LWIP_MEMPOOL_DECLARE_STATS_INSTANCE(memp_stats_ ## name) \
+    \
+  static struct os_mempool memp_os_ ## name; \
+    \
+  const struct memp_desc memp_ ## name = { \
+    DECLARE_LWIP_MEMPOOL_DESC(desc) \
+    LWIP_MEMPOOL_DECLARE_STATS_REFERENCE(memp_stats_ ## name) \
+    LWIP_MEM_ALIGN_SIZE(size), \
+    (num), \
+    (u8_t *)memp_memory_ ## name ## _base, \
+    &memp_os_ ## name, \
+    "lwip_" #name \
+  };
+
 #else /* MEMP_MEM_MALLOC */
 
 /**
@@ -239,6 +239,25 @@
 #define MEMP_MEM_MALLOC                 0
 #endif
 
+/**
+ * MEMP_USE_OS_MEMPOOL==1: Back each memp pool with a Mynewt os_mempool, so
+ * that the pools are listed with the other system pools (os_mempool_info_get_next()).
+ * Cannot be combined with MEMP_MEM_MALLOC, MEMP_OVERFLOW_CHECK, MEMP_SANITY_CHECK
+ * or LWIP_HOOK_MEMP_AVAILABLE.
+ */
+#if !defined MEMP_USE_OS_MEMPOOL || defined __DOXYGEN__
+#define MEMP_USE_OS_MEMPOOL             0
+#endif
+
+/**
+ * MEMP_PBUF_POOL_MSYS==1: Take PBUF_POOL elements from msys mbufs instead of
+ * a pool of their own; PBUF_POOL_SIZE is then unused. Requires MEMP_USE_OS_MEMPOOL,
+ * and the port to provide memp_msys_get() and memp_msys_put().
+ */
+#if !defined MEMP_PBUF_POOL_MSYS || defined __DOXYGEN__
+#define MEMP_PBUF_POOL_MSYS             0
+#endif
+
 /**
  * MEM_ALIGNMENT: should be set to the alignment of the CPU
  *    4 byte alignment -> \#define MEM_ALIGNMENT 4
@@ -40,6 +40,10 @@
 
 #include "lwip/opt.h"
 
+#if MEMP_USE_OS_MEMPOOL
+#include "os/os_mempool.h"
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -147,8 +151,16 @@ struct memp_desc {
   /** Base address */
   u8_t *base;
 
+#if MEMP_USE_OS_MEMPOOL
+  /** The os_mempool handing out the elements */
+  struct os_mempool *mp;
+
+  /** Name of the os_mempool */
+  const char *name;
+#else
   /** First free element of each pool. Elements form a linked list. */
   struct memp **tab;
+#endif /* MEMP_USE_OS_MEMPOOL */
 #endif /* MEMP_MEM_MALLOC */
 };
 
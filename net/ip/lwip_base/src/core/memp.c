@@ -93,6 +93,28 @@ const struct memp_desc* const memp_pools[MEMP_MAX] = {
 #define MEMP_OVERFLOW_CHECK 1
 #endif
 
+#if MEMP_USE_OS_MEMPOOL
+#if MEMP_MEM_MALLOC || MEMP_OVERFLOW_CHECK || MEMP_SANITY_CHECK || defined(LWIP_HOOK_MEMP_AVAILABLE)
+#error "MEMP_USE_OS_MEMPOOL cannot be combined with MEMP_MEM_MALLOC, MEMP_OVERFLOW_CHECK, MEMP_SANITY_CHECK or LWIP_HOOK_MEMP_AVAILABLE"
+#endif
+#if MEMP_PBUF_POOL_MSYS
+/* Provided by the port; an element of size bytes backed by an msys mbuf */
+void *memp_msys_get(u16_t size);
+void memp_msys_put(void *mem);
+#define MEMP_IS_MSYS(desc) ((desc) == memp_pools[MEMP_PBUF_POOL])
+#define MEMP_OS_GET(desc) \
+  (MEMP_IS_MSYS(desc) ? memp_msys_get((desc)->size) : os_memblock_get((desc)->mp))
+#define MEMP_OS_PUT(desc, mem) \
+  (MEMP_IS_MSYS(desc) ? memp_msys_put(mem) : (void)os_memblock_put((desc)->mp, (mem)))
+#else
+#define MEMP_IS_MSYS(desc) 0
+#define MEMP_OS_GET(desc) os_memblock_get((desc)->mp)
+#define MEMP_OS_PUT(desc, mem) os_memblock_put((desc)->mp, (mem))
+#endif
+#elif MEMP_PBUF_POOL_MSYS
+#error "MEMP_PBUF_POOL_MSYS requires MEMP_USE_OS_MEMPOOL"
+#endif /* MEMP_USE_OS_MEMPOOL */
+
 #if MEMP_SANITY_CHECK && !MEMP_MEM_MALLOC
 /**
  * Check that memp-lists don't form a circle, using "Floyd's cycle-finding algorithm".
@@ -231,6 +253,15 @@ memp_init_pool(const struct memp_desc *desc)
 {
 #if MEMP_MEM_MALLOC
   LWIP_UNUSED_ARG(desc);
+#elif MEMP_USE_OS_MEMPOOL
+  /* Pools without elements, or taken from msys, stay out of the os_mempool list */
+  if (desc->num > 0 && !MEMP_IS_MSYS(desc)) {
+    os_mempool_init(desc->mp, desc->num, desc->size, desc->base,
+                    (char *)desc->name);
+  }
+#if MEMP_STATS
+  desc->stats->avail = desc->num;
+#endif /* MEMP_STATS */
 #else
   int i;
   struct memp *memp;
@@ -300,6 +331,9 @@ do_memp_malloc_pool_fn(const struct memp_desc *desc, const char* file, const int
 #if MEMP_MEM_MALLOC
   memp = (struct memp *)mem_malloc(MEMP_SIZE + MEMP_ALIGN_SIZE(desc->size));
   SYS_ARCH_PROTECT(old_level);
+#elif MEMP_USE_OS_MEMPOOL
+  memp = (struct memp *)MEMP_OS_GET(desc);
+  SYS_ARCH_PROTECT(old_level);
 #else /* MEMP_MEM_MALLOC */
   SYS_ARCH_PROTECT(old_level);
 
@@ -307,7 +341,7 @@ do_memp_malloc_pool_fn(const struct memp_desc *desc, const char* file, const int
 #endif /* MEMP_MEM_MALLOC */
 
   if (memp != NULL) {
-#if !MEMP_MEM_MALLOC
+#if !MEMP_MEM_MALLOC && !MEMP_USE_OS_MEMPOOL
 #if MEMP_OVERFLOW_CHECK == 1
     memp_overflow_check_element_overflow(memp, desc);
     memp_overflow_check_element_underflow(memp, desc);
@@ -430,6 +464,9 @@ do_memp_free_pool(const struct memp_desc* desc, void *mem)
   LWIP_UNUSED_ARG(desc);
   SYS_ARCH_UNPROTECT(old_level);
   mem_free(memp);
+#elif MEMP_USE_OS_MEMPOOL
+  SYS_ARCH_UNPROTECT(old_level);
+  MEMP_OS_PUT(desc, memp);
 #else /* MEMP_MEM_MALLOC */
   memp->next = *desc->tab;
   *desc->tab = memp;
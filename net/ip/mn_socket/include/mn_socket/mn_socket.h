@@ -140,6 +140,21 @@ struct mn_mreq {
 #define MN_MCAST_JOIN_GROUP             1
 #define MN_MCAST_LEAVE_GROUP            2
 #define MN_MCAST_IF                     3
+/*
+ * Value is int. If non-zero, (*readable) callback is only called when
+ * data arrives to an empty receive queue; socket owner must read until
+ * MN_EAGAIN, e.g. with mn_recvmsgs().
+ */
+#define MN_SO_RXBATCH                   4
+
+/*
+ * Datagram and peer address, for mn_recvmsgs() and mn_sendmsgs().
+ * mm_addr is big enough for either address family.
+ */
+struct mn_msg {
+    struct os_mbuf *mm_m;
+    struct mn_sockaddr_in6 mm_addr;
+};
 
 /*
  * Socket calls.
@@ -157,6 +172,11 @@ struct mn_mreq {
  *
  * If remote end closes the socket, socket callback (*readable) will be
  * called.
+ *
+ * mn_recvmsgs() and mn_sendmsgs() handle up to *cnt datagrams per call.
+ * On return *cnt holds the number of datagrams received or sent. On send
+ * error the failed datagram, and the ones after it, are still owned by
+ * the caller.
  */
 int mn_socket(struct mn_socket **, uint8_t domain, uint8_t type, uint8_t proto);
 int mn_bind(struct mn_socket *, struct mn_sockaddr *);
@@ -166,6 +186,8 @@ int mn_listen(struct mn_socket *, uint8_t qlen);
 int mn_recvfrom(struct mn_socket *, struct os_mbuf **,
   struct mn_sockaddr *from);
 int mn_sendto(struct mn_socket *, struct os_mbuf *, struct mn_sockaddr *to);
+int mn_recvmsgs(struct mn_socket *, struct mn_msg *msgs, int *cnt);
+int mn_sendmsgs(struct mn_socket *, struct mn_msg *msgs, int *cnt);
 
 int mn_getsockopt(struct mn_socket *, uint8_t level, uint8_t optname,
   void *optval);
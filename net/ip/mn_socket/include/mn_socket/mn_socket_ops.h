@@ -31,6 +31,8 @@ extern "C" {
  *   the socket provider.
  * - mso_close() closes the socket, memory should be freed. User should not
  *   be using the socket pointer once it has been closed.
+ * - mso_recvmsgs() and mso_sendmsgs() are optional. If not set, mn_socket
+ *   calls mso_recvfrom()/mso_sendto() for each datagram.
  */
 struct mn_socket_ops {
     int (*mso_create)(struct mn_socket **, uint8_t domain, uint8_t type,
@@ -56,6 +58,9 @@ struct mn_socket_ops {
 
     int (*mso_itf_getnext)(struct mn_itf *);
     int (*mso_itf_addr_getnext)(struct mn_itf *, struct mn_itf_addr *);
+
+    int (*mso_recvmsgs)(struct mn_socket *, struct mn_msg *, int *cnt);
+    int (*mso_sendmsgs)(struct mn_socket *, struct mn_msg *, int *cnt);
 };
 
 int mn_socket_ops_reg(const struct mn_socket_ops *ops);
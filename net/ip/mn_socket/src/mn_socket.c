@@ -96,6 +96,51 @@ mn_sendto(struct mn_socket *s, struct os_mbuf *m, struct mn_sockaddr *to)
     return s->ms_ops->mso_sendto(s, m, to);
 }
 
+int
+mn_recvmsgs(struct mn_socket *s, struct mn_msg *msgs, int *cnt)
+{
+    int rc;
+    int i;
+
+    if (s->ms_ops->mso_recvmsgs) {
+        return s->ms_ops->mso_recvmsgs(s, msgs, cnt);
+    }
+    rc = 0;
+    for (i = 0; i < *cnt; i++) {
+        rc = s->ms_ops->mso_recvfrom(s, &msgs[i].mm_m,
+          (struct mn_sockaddr *)&msgs[i].mm_addr);
+        if (rc) {
+            break;
+        }
+    }
+    *cnt = i;
+    if (i && rc == MN_EAGAIN) {
+        rc = 0;
+    }
+    return rc;
+}
+
+int
+mn_sendmsgs(struct mn_socket *s, struct mn_msg *msgs, int *cnt)
+{
+    int rc;
+    int i;
+
+    if (s->ms_ops->mso_sendmsgs) {
+        return s->ms_ops->mso_sendmsgs(s, msgs, cnt);
+    }
+    rc = 0;
+    for (i = 0; i < *cnt; i++) {
+        rc = s->ms_ops->mso_sendto(s, msgs[i].mm_m,
+          (struct mn_sockaddr *)&msgs[i].mm_addr);
+        if (rc) {
+            break;
+        }
+    }
+    *cnt = i;
+    return rc;
+}
+
 int
 mn_getsockopt(struct mn_socket *s, uint8_t level, uint8_t name, void *val)
 {
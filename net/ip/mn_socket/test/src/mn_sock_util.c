@@ -265,6 +265,91 @@ sock_udp_data(void)
     mn_close(sock2);
 }
 
+void
+sock_udp_msgs(void)
+{
+    struct mn_socket *sock1;
+    struct mn_socket *sock2;
+    struct mn_sockaddr_in msin;
+    struct mn_sockaddr_in msin2;
+    struct mn_msg msgs[4];
+    int rc;
+    int cnt;
+    int got;
+    int i;
+    union mn_socket_cb sock_cbs = {
+        .socket.readable = sud_readable
+    };
+    char data[] = "1234567890";
+
+    rc = mn_socket(&sock1, MN_PF_INET, MN_SOCK_DGRAM, 0);
+    TEST_ASSERT(rc == 0);
+    mn_socket_set_cbs(sock1, NULL, &sock_cbs);
+
+    rc = mn_socket(&sock2, MN_PF_INET, MN_SOCK_DGRAM, 0);
+    TEST_ASSERT(rc == 0);
+
+    msin.msin_family = MN_PF_INET;
+    msin.msin_len = sizeof(msin);
+    msin.msin_port = htons(12446);
+    mn_inet_pton(MN_PF_INET, "127.0.0.1", &msin.msin_addr);
+
+    rc = mn_bind(sock1, (struct mn_sockaddr *)&msin);
+    TEST_ASSERT(rc == 0);
+
+    msin2.msin_family = MN_PF_INET;
+    msin2.msin_len = sizeof(msin2);
+    msin2.msin_port = 0;
+    msin2.msin_addr.s_addr = 0;
+    rc = mn_bind(sock2, (struct mn_sockaddr *)&msin2);
+    TEST_ASSERT(rc == 0);
+
+    for (i = 0; i < 3; i++) {
+        msgs[i].mm_m = os_msys_get_pkthdr(sizeof(data), 0);
+        TEST_ASSERT(msgs[i].mm_m);
+        data[0] = '1' + i;
+        rc = os_mbuf_copyinto(msgs[i].mm_m, 0, data, sizeof(data));
+        TEST_ASSERT(rc == 0);
+        memcpy(&msgs[i].mm_addr, &msin, sizeof(msin));
+    }
+    cnt = 3;
+    rc = mn_sendmsgs(sock2, msgs, &cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(cnt == 3);
+
+    got = 0;
+    while (got < 3) {
+        rc = os_sem_pend(&test_sem, OS_TICKS_PER_SEC);
+        TEST_ASSERT_FATAL(rc == 0);
+
+        cnt = sizeof(msgs) / sizeof(msgs[0]);
+        rc = mn_recvmsgs(sock1, msgs, &cnt);
+        if (rc == MN_EAGAIN) {
+            continue;
+        }
+        TEST_ASSERT(rc == 0);
+        for (i = 0; i < cnt; i++) {
+            TEST_ASSERT(msgs[i].mm_addr.msin6_family == MN_AF_INET);
+            TEST_ASSERT(OS_MBUF_PKTLEN(msgs[i].mm_m) == sizeof(data));
+            TEST_ASSERT(msgs[i].mm_m->om_data[0] == '1' + got);
+            os_mbuf_free_chain(msgs[i].mm_m);
+            got++;
+        }
+    }
+    /*
+     * Provider might call (*readable) once per datagram.
+     */
+    while (os_sem_pend(&test_sem, OS_TICKS_PER_SEC / 10) == 0) {
+    }
+    cnt = 1;
+    rc = mn_recvmsgs(sock1, msgs, &cnt);
+    TEST_ASSERT(rc == MN_EAGAIN);
+    TEST_ASSERT(cnt == 0);
+
+    mn_close(sock1);
+    mn_close(sock2);
+}
+
 void
 std_writable(void *cb_arg, int err)
 {
@@ -766,6 +851,7 @@ mn_socket_test_handler(void *arg)
     sock_listen();
     sock_tcp_connect();
     sock_udp_data();
+    sock_udp_msgs();
     sock_tcp_data();
     sock_itf_list();
     sock_udp_ll();
@@ -24,6 +24,9 @@
 
 int ip_init(void)
 {
+    if (lwip_mem_init()) {
+        return -1;
+    }
     if (lwip_socket_init()) {
         return -1;
     }
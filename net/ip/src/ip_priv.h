@@ -24,6 +24,9 @@
 extern "C" {
 #endif
 
+#include <inttypes.h>
+#include "syscfg/syscfg.h"
+
 struct mn_itf;
 struct mn_itf_addr;
 int lwip_itf_getnext(struct mn_itf *mi);
@@ -34,6 +37,17 @@ void lwip_cli_init(void);
 
 int lwip_err_to_mn_err(int rc);
 
+struct os_mbuf;
+int lwip_mem_init(void);
+struct os_mbuf *lwip_msys_get(uint16_t dsize, uint16_t leadingspace);
+struct os_mbuf *lwip_msys_get_pkthdr(uint16_t dsize, uint16_t user_hdr_len);
+
+#if MYNEWT_VAL(LWIP_MBUF_PBUF)
+struct pbuf;
+struct os_mbuf *lwip_mbuf_pbuf_take(struct pbuf *p);
+struct pbuf *lwip_mbuf_to_pbuf(struct os_mbuf *m);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,137 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(LWIP_MBUF_PBUF)
+
+#include <os/os.h>
+#include <os/os_mbuf.h>
+
+#include <mn_socket/mn_socket.h>
+
+#include <lwip/pbuf.h>
+#include "ip/lwip_mbuf.h"
+#include "ip_priv.h"
+
+/*
+ * Lives in the mbuf data area, immediately before the payload.
+ */
+struct lwip_mbuf_pbuf {
+    struct pbuf_custom lmp_pc;
+    struct os_mbuf *lmp_m;              /* NULL once taken by socket */
+};
+
+static void
+lwip_mbuf_pbuf_free(struct pbuf *p)
+{
+    struct lwip_mbuf_pbuf *lmp = (struct lwip_mbuf_pbuf *)p;
+
+    if (lmp->lmp_m) {
+        os_mbuf_free_chain(lmp->lmp_m);
+    }
+}
+
+struct pbuf *
+lwip_mbuf_pbuf_alloc(uint16_t len)
+{
+    struct lwip_mbuf_pbuf *lmp;
+    struct os_mbuf *m;
+    uint16_t need;
+
+    /*
+     * Reserve user header space for the source address, so UDP sockets
+     * can queue the mbuf as is.
+     */
+    need = OS_ALIGN(sizeof(*lmp), OS_ALIGNMENT) + len;
+    m = lwip_msys_get_pkthdr(need, sizeof(struct mn_sockaddr_in6));
+    if (!m) {
+        return NULL;
+    }
+    m->om_data = (uint8_t *)OS_ALIGN((uintptr_t)m->om_data, OS_ALIGNMENT);
+    if (OS_MBUF_TRAILINGSPACE(m) < need) {
+        os_mbuf_free_chain(m);
+        return NULL;
+    }
+    lmp = (struct lwip_mbuf_pbuf *)m->om_data;
+    lmp->lmp_pc.custom_free_function = lwip_mbuf_pbuf_free;
+    lmp->lmp_m = m;
+    return pbuf_alloced_custom(PBUF_RAW, len, PBUF_REF, &lmp->lmp_pc,
+      m->om_data + OS_ALIGN(sizeof(*lmp), OS_ALIGNMENT), len);
+}
+
+/*
+ * If the pbuf was allocated with lwip_mbuf_pbuf_alloc(), and nobody else
+ * holds a reference to it, take the mbuf underneath. The mbuf is adjusted
+ * to contain just the payload of this pbuf. The pbuf must still be freed
+ * by the caller.
+ */
+struct os_mbuf *
+lwip_mbuf_pbuf_take(struct pbuf *p)
+{
+    struct lwip_mbuf_pbuf *lmp = (struct lwip_mbuf_pbuf *)p;
+    struct os_mbuf *m;
+
+    if (!(p->flags & PBUF_FLAG_IS_CUSTOM) || p->ref != 1 ||
+      lmp->lmp_pc.custom_free_function != lwip_mbuf_pbuf_free ||
+      !lmp->lmp_m) {
+        return NULL;
+    }
+    m = lmp->lmp_m;
+    lmp->lmp_m = NULL;
+    m->om_data = p->payload;
+    m->om_len = p->len;
+    OS_MBUF_PKTHDR(m)->omp_len = p->len;
+    return m;
+}
+
+/*
+ * Builds a chain of PBUF_REF pbufs pointing to data within mbuf chain m.
+ * lwIP copies PBUF_REF data if it needs to hold on to it after the output
+ * call returns, so the mbuf can be freed after that.
+ */
+struct pbuf *
+lwip_mbuf_to_pbuf(struct os_mbuf *m)
+{
+    struct pbuf *head;
+    struct pbuf *p;
+
+    head = NULL;
+    for (; m; m = SLIST_NEXT(m, om_next)) {
+        if (m->om_len == 0) {
+            continue;
+        }
+        p = pbuf_alloc(PBUF_RAW, m->om_len, PBUF_REF);
+        if (!p) {
+            if (head) {
+                pbuf_free(head);
+            }
+            return NULL;
+        }
+        p->payload = m->om_data;
+        if (head) {
+            pbuf_cat(head, p);
+        } else {
+            head = p;
+        }
+    }
+    return head;
+}
+
+#endif
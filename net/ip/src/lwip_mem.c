@@ -0,0 +1,98 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "syscfg/syscfg.h"
+
+#include <os/os.h>
+#include <os/os_mbuf.h>
+
+#include <lwip/opt.h>
+
+#include "ip_priv.h"
+
+#if MYNEWT_VAL(LWIP_MSYS_QUOTA)
+/* All msys mbufs lwIP holds are charged here. */
+static struct os_msys_quota lwip_msys_quota;
+#endif
+
+struct os_mbuf *
+lwip_msys_get(uint16_t dsize, uint16_t leadingspace)
+{
+#if MYNEWT_VAL(LWIP_MSYS_QUOTA)
+    return os_msys_get_quota(&lwip_msys_quota, dsize, leadingspace);
+#else
+    return os_msys_get(dsize, leadingspace);
+#endif
+}
+
+struct os_mbuf *
+lwip_msys_get_pkthdr(uint16_t dsize, uint16_t user_hdr_len)
+{
+#if MYNEWT_VAL(LWIP_MSYS_QUOTA)
+    return os_msys_get_pkthdr_quota(&lwip_msys_quota, dsize, user_hdr_len);
+#else
+    return os_msys_get_pkthdr(dsize, user_hdr_len);
+#endif
+}
+
+#if MYNEWT_VAL(LWIP_PBUF_POOL_MSYS)
+/*
+ * PBUF_POOL elements for memp.c. The element lives in the data area of a
+ * single msys mbuf, right after a pointer back to the mbuf.
+ */
+#define LWIP_MSYS_HDR_SZ    LWIP_MEM_ALIGN_SIZE(sizeof(struct os_mbuf *))
+
+void *
+memp_msys_get(uint16_t size)
+{
+    struct os_mbuf *m;
+    uint16_t need;
+
+    need = LWIP_MSYS_HDR_SZ + size;
+    m = lwip_msys_get(need, 0);
+    if (!m) {
+        return NULL;
+    }
+    m->om_data = (uint8_t *)LWIP_MEM_ALIGN(m->om_data);
+    if (OS_MBUF_TRAILINGSPACE(m) < need) {
+        /* Only smaller mbufs were left */
+        os_mbuf_free(m);
+        return NULL;
+    }
+    *(struct os_mbuf **)m->om_data = m;
+    return m->om_data + LWIP_MSYS_HDR_SZ;
+}
+
+void
+memp_msys_put(void *mem)
+{
+    os_mbuf_free(*(struct os_mbuf **)((uint8_t *)mem - LWIP_MSYS_HDR_SZ));
+}
+#endif
+
+int
+lwip_mem_init(void)
+{
+#if MYNEWT_VAL(LWIP_MSYS_QUOTA)
+    return os_msys_quota_init(&lwip_msys_quota, MYNEWT_VAL(LWIP_MSYS_RESERVE),
+                              MYNEWT_VAL(LWIP_MSYS_MAX));
+#else
+    return 0;
+#endif
+}
@@ -20,45 +20,56 @@
 #include <lwip/sys.h>
 #include <ip/os_queue.h>
 
-u32_t
-sys_arch_sem_wait(sys_sem_t *sem, u32_t timo)
+/*
+ * Convert lwIP timeout to OS ticks. Rounds up, so that the thread does
+ * not wake up before the next lwIP timeout is due, only to find out that
+ * there's nothing to do yet.
+ */
+static uint32_t
+lwip_timo_to_ticks(u32_t timo)
 {
-    u32_t now;
+    uint64_t ticks;
 
     if (timo == 0) {
-        timo = OS_WAIT_FOREVER;
-    } else {
-        if (os_time_ms_to_ticks(timo, &timo)) {
-            timo = OS_WAIT_FOREVER - 1;
-        }
+        return OS_WAIT_FOREVER;
+    }
+    ticks = ((uint64_t)timo * OS_TICKS_PER_SEC + 999) / 1000;
+    if (ticks >= OS_WAIT_FOREVER) {
+        ticks = OS_WAIT_FOREVER - 1;
     }
+    return ticks;
+}
+
+static u32_t
+lwip_elapsed_ms(os_time_t start)
+{
+    return (uint64_t)(os_time_get() - start) * 1000 / OS_TICKS_PER_SEC;
+}
+
+u32_t
+sys_arch_sem_wait(sys_sem_t *sem, u32_t timo)
+{
+    os_time_t now;
+
     now = os_time_get();
-    if (os_sem_pend(sem, timo) == OS_TIMEOUT) {
+    if (os_sem_pend(sem, lwip_timo_to_ticks(timo)) == OS_TIMEOUT) {
         return SYS_ARCH_TIMEOUT;
     }
-    return (now - os_time_get()) * 1000 / OS_TICKS_PER_SEC;
+    return lwip_elapsed_ms(now);
 }
 
 u32_t
 sys_arch_mbox_fetch(sys_mbox_t *mbox, void **msg, uint32_t timo)
 {
-    u32_t now;
+    os_time_t now;
     void *val;
 
-    if (timo == 0) {
-        timo = OS_WAIT_FOREVER;
-    } else {
-        if (os_time_ms_to_ticks(timo, &timo)) {
-            timo = OS_WAIT_FOREVER - 1;
-        }
-    }
     now = os_time_get();
-    if (os_queue_get(mbox, &val, timo)) {
+    if (os_queue_get(mbox, &val, lwip_timo_to_ticks(timo))) {
         return SYS_ARCH_TIMEOUT;
     }
     if (msg != NULL) {
         *msg = val;
     }
-    return (now - os_time_get()) * 1000 / OS_TICKS_PER_SEC;
+    return lwip_elapsed_ms(now);
 }
-
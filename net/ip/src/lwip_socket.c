@@ -41,6 +41,8 @@ static int lwip_sendto(struct mn_socket *, struct os_mbuf *,
   struct mn_sockaddr *);
 static int lwip_recvfrom(struct mn_socket *, struct os_mbuf **,
   struct mn_sockaddr *);
+static int lwip_sendmsgs(struct mn_socket *, struct mn_msg *, int *cnt);
+static int lwip_recvmsgs(struct mn_socket *, struct mn_msg *, int *cnt);
 static int lwip_getsockopt(struct mn_socket *, uint8_t level,
   uint8_t name, void *val);
 static int lwip_setsockopt(struct mn_socket *, uint8_t level,
@@ -67,6 +69,9 @@ static const struct mn_socket_ops lwip_sock_ops = {
 
     .mso_itf_getnext = lwip_itf_getnext,
     .mso_itf_addr_getnext = lwip_itf_addr_getnext,
+
+    .mso_recvmsgs = lwip_recvmsgs,
+    .mso_sendmsgs = lwip_sendmsgs,
 };
 
 struct lwip_sock {
@@ -79,6 +84,7 @@ struct lwip_sock {
     } ls_pcb;
     STAILQ_HEAD(, os_mbuf_pkthdr) ls_rx;
     struct os_mbuf *ls_tx;
+    uint8_t ls_rx_batch;        /* MN_SO_RXBATCH */
 };
 
 static struct os_mempool lwip_sockets;
@@ -178,6 +184,56 @@ lwip_err_to_mn_err(int rc)
     }
 }
 
+#if LWIP_UDP || LWIP_TCP
+static void
+lwip_sock_rx_queue(struct lwip_sock *s, struct os_mbuf *m)
+{
+    int notify;
+
+    notify = !s->ls_rx_batch || STAILQ_EMPTY(&s->ls_rx);
+    STAILQ_INSERT_TAIL(&s->ls_rx, OS_MBUF_PKTHDR(m), omp_next);
+    if (notify) {
+        mn_socket_readable(&s->ls_sock, 0);
+    }
+}
+
+/*
+ * Returns packet p as a mbuf chain. The pbuf is not freed.
+ */
+static struct os_mbuf *
+lwip_pbuf_to_mbuf(struct pbuf *p, int usrhdr_len)
+{
+    struct os_mbuf *m;
+    struct pbuf *q;
+    int off;
+
+#if MYNEWT_VAL(LWIP_MBUF_PBUF)
+    if (!p->next) {
+        /*
+         * These have space for mn_sockaddr_in6 in the user header.
+         */
+        m = lwip_mbuf_pbuf_take(p);
+        if (m) {
+            return m;
+        }
+    }
+#endif
+    m = os_msys_get_pkthdr(p->tot_len, usrhdr_len);
+    if (!m) {
+        return NULL;
+    }
+    off = 0;
+    for (q = p; q; q = q->next) {
+        if (os_mbuf_copyinto(m, off, q->payload, q->len)) {
+            os_mbuf_free_chain(m);
+            return NULL;
+        }
+        off += q->len;
+    }
+    return m;
+}
+#endif
+
 #if LWIP_UDP
 static void
 lwip_sock_udp_rx(void *arg, struct udp_pcb *pcb, struct pbuf *p,
@@ -185,23 +241,15 @@ lwip_sock_udp_rx(void *arg, struct udp_pcb *pcb, struct pbuf *p,
 {
     struct lwip_sock *s = (struct lwip_sock *)arg;
     struct os_mbuf *m;
-    struct pbuf *q;
-    int off;
 
-    m = os_msys_get_pkthdr(p->tot_len, sizeof(struct mn_sockaddr_in6));
+    m = lwip_pbuf_to_mbuf(p, sizeof(struct mn_sockaddr_in6));
+    pbuf_free(p);
     if (!m) {
-        pbuf_free(p);
         return;
     }
     lwip_addr_to_mn_addr((struct mn_sockaddr *)OS_MBUF_USRHDR(m),
       addr, port);
-    off = 0;
-    for (q = p; q; q = q->next) {
-        os_mbuf_copyinto(m, off, q->payload, p->len);
-    }
-    pbuf_free(p);
-    STAILQ_INSERT_TAIL(&s->ls_rx, OS_MBUF_PKTHDR(m), omp_next);
-    mn_socket_readable(&s->ls_sock, 0);
+    lwip_sock_rx_queue(s, m);
 }
 #endif
 
@@ -211,8 +259,6 @@ lwip_sock_tcp_rx(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
 {
     struct lwip_sock *s = (struct lwip_sock *)arg;
     struct os_mbuf *m;
-    struct pbuf *q;
-    int off;
 
     if (!p) {
         /*
@@ -221,16 +267,15 @@ lwip_sock_tcp_rx(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
         mn_socket_readable(&s->ls_sock, MN_ECONNABORTED);
         return ERR_OK;
     }
-    m = os_msys_get_pkthdr(p->tot_len, 0);
-    assert(m);
-    /* XXX fix this */
-    off = 0;
-    for (q = p; q; q = q->next) {
-        os_mbuf_copyinto(m, off, q->payload, p->len);
+    m = lwip_pbuf_to_mbuf(p, 0);
+    if (!m) {
+        /*
+         * lwIP holds on to the data, and retries later.
+         */
+        return ERR_MEM;
     }
     pbuf_free(p);
-    STAILQ_INSERT_TAIL(&s->ls_rx, OS_MBUF_PKTHDR(m), omp_next);
-    mn_socket_readable(&s->ls_sock, 0);
+    lwip_sock_rx_queue(s, m);
 
     return ERR_OK;
 }
@@ -283,6 +328,7 @@ lwip_sock_accept(void *arg, struct tcp_pcb *new, err_t err)
     tcp_err(new, lwip_sock_tcp_err);
     STAILQ_INIT(&new_s->ls_rx);
     new_s->ls_tx = NULL;
+    new_s->ls_rx_batch = 0;
     if (mn_socket_newconn(&s->ls_sock, &new_s->ls_sock)) {
         /* XXX close connection */
     }
@@ -304,6 +350,7 @@ lwip_sock_create(struct mn_socket **sp, uint8_t domain, uint8_t type,
     s->ls_pcb.ip = NULL;
     STAILQ_INIT(&s->ls_rx);
     s->ls_tx = NULL;
+    s->ls_rx_batch = 0;
 
     LOCK_TCPIP_CORE();
     switch (type) {
@@ -471,7 +518,8 @@ lwip_stream_tx(struct lwip_sock *s, int notify)
     while (s->ls_tx && rc == 0) {
         m = s->ls_tx;
         n = SLIST_NEXT(m, om_next);
-        rc = tcp_write(s->ls_pcb.tcp, m->om_data, m->om_len, 0);
+        rc = tcp_write(s->ls_pcb.tcp, m->om_data, m->om_len,
+          TCP_WRITE_FLAG_COPY);
         if (rc == 0) {
             s->ls_tx = n;
             os_mbuf_free(m);
@@ -494,11 +542,14 @@ lwip_stream_tx(struct lwip_sock *s, int notify)
     return rc;
 }
 
+#if LWIP_UDP
+/*
+ * Called with TCPIP core locked.
+ */
 static int
-lwip_sendto(struct mn_socket *ms, struct os_mbuf *m,
+lwip_udp_send(struct lwip_sock *s, struct os_mbuf *m,
   struct mn_sockaddr *addr)
 {
-    struct lwip_sock *s = (struct lwip_sock *)ms;
     struct pbuf *p;
     struct os_mbuf *n;
     ip_addr_t ip_addr;
@@ -506,16 +557,19 @@ lwip_sendto(struct mn_socket *ms, struct os_mbuf *m,
     int off;
     int rc;
 
-    switch (s->ls_type) {
-#if LWIP_UDP
-    case MN_SOCK_DGRAM:
-        if (!addr) {
-            return MN_EDESTADDRREQ;
-        }
-        rc = lwip_mn_addr_to_addr(addr, &ip_addr, &port);
-        if (rc) {
-            return rc;
-        }
+    if (!addr) {
+        return MN_EDESTADDRREQ;
+    }
+    rc = lwip_mn_addr_to_addr(addr, &ip_addr, &port);
+    if (rc) {
+        return rc;
+    }
+#if MYNEWT_VAL(LWIP_MBUF_PBUF)
+    p = lwip_mbuf_to_pbuf(m);
+#else
+    p = NULL;
+#endif
+    if (!p) {
         off = 0;
         for (n = m; n; n = SLIST_NEXT(n, om_next)) {
             off += n->om_len;
@@ -524,22 +578,36 @@ lwip_sendto(struct mn_socket *ms, struct os_mbuf *m,
         if (!p) {
             return MN_ENOBUFS;
         }
-
         off = 0;
         for (n = m; n; n = SLIST_NEXT(n, om_next)) {
             pbuf_take_at(p, n->om_data, n->om_len, off);
             off += n->om_len;
         }
+    }
+    rc = udp_sendto(s->ls_pcb.udp, p, &ip_addr, port);
+    pbuf_free(p);
+    if (rc) {
+        return lwip_err_to_mn_err(rc);
+    }
+    os_mbuf_free_chain(m);
+    return 0;
+}
+#endif
+
+static int
+lwip_sendto(struct mn_socket *ms, struct os_mbuf *m,
+  struct mn_sockaddr *addr)
+{
+    struct lwip_sock *s = (struct lwip_sock *)ms;
+    int rc;
+
+    switch (s->ls_type) {
+#if LWIP_UDP
+    case MN_SOCK_DGRAM:
         LOCK_TCPIP_CORE();
-        rc = udp_sendto(s->ls_pcb.udp, p, &ip_addr, port);
+        rc = lwip_udp_send(s, m, addr);
         UNLOCK_TCPIP_CORE();
-        if (rc) {
-            rc = lwip_err_to_mn_err(rc);
-            pbuf_free(p);
-            return rc;
-        }
-        os_mbuf_free_chain(m);
-        return 0;
+        return rc;
 #endif
 #if LWIP_TCP
     case MN_SOCK_STREAM:
@@ -561,45 +629,111 @@ lwip_sendto(struct mn_socket *ms, struct os_mbuf *m,
 }
 
 static int
-lwip_recvfrom(struct mn_socket *ms, struct os_mbuf **mp,
-  struct mn_sockaddr *addr)
+lwip_sendmsgs(struct mn_socket *ms, struct mn_msg *msgs, int *cnt)
 {
     struct lwip_sock *s = (struct lwip_sock *)ms;
+    int rc;
+    int i;
+
+    if (s->ls_type != MN_SOCK_DGRAM) {
+        for (i = 0; i < *cnt; i++) {
+            rc = lwip_sendto(ms, msgs[i].mm_m, NULL);
+            if (rc) {
+                break;
+            }
+        }
+        *cnt = i;
+        return rc;
+    }
+    rc = 0;
+#if LWIP_UDP
+    LOCK_TCPIP_CORE();
+    for (i = 0; i < *cnt; i++) {
+        rc = lwip_udp_send(s, msgs[i].mm_m,
+          (struct mn_sockaddr *)&msgs[i].mm_addr);
+        if (rc) {
+            break;
+        }
+    }
+    UNLOCK_TCPIP_CORE();
+    *cnt = i;
+#endif
+    return rc;
+}
+
+/*
+ * Called with TCPIP core locked.
+ */
+static int
+lwip_rx_dequeue(struct lwip_sock *s, struct os_mbuf **mp,
+  struct mn_sockaddr *addr)
+{
     struct mn_sockaddr *ms_a;
     struct os_mbuf_pkthdr *m;
     int slen;
 
-    LOCK_TCPIP_CORE();
     m = STAILQ_FIRST(&s->ls_rx);
-    if (m) {
-        STAILQ_REMOVE_HEAD(&s->ls_rx, omp_next);
-        STAILQ_NEXT(m, omp_next) = NULL;
+    if (!m) {
+        *mp = NULL;
+        return MN_EAGAIN;
     }
-    if (m) {
-        *mp = OS_MBUF_PKTHDR_TO_MBUF(m);
-        if (addr) {
-            if (s->ls_type == MN_SOCK_DGRAM) {
-                ms_a = (struct mn_sockaddr *)(m + 1);
-                if (ms_a->msa_family == MN_AF_INET6) {
-                    slen = sizeof(struct mn_sockaddr_in6);
-                } else {
-                    slen = sizeof(struct mn_sockaddr_in);
-                }
-                memcpy(addr, ms_a, slen);
+    STAILQ_REMOVE_HEAD(&s->ls_rx, omp_next);
+    STAILQ_NEXT(m, omp_next) = NULL;
+    *mp = OS_MBUF_PKTHDR_TO_MBUF(m);
+    if (addr) {
+        if (s->ls_type == MN_SOCK_DGRAM) {
+            ms_a = (struct mn_sockaddr *)(m + 1);
+            if (ms_a->msa_family == MN_AF_INET6) {
+                slen = sizeof(struct mn_sockaddr_in6);
             } else {
+                slen = sizeof(struct mn_sockaddr_in);
+            }
+            memcpy(addr, ms_a, slen);
+        } else {
 #if LWIP_TCP
-                lwip_addr_to_mn_addr(addr, &s->ls_pcb.ip->local_ip,
-                                     s->ls_pcb.tcp->local_port);
+            lwip_addr_to_mn_addr(addr, &s->ls_pcb.ip->local_ip,
+                                 s->ls_pcb.tcp->local_port);
 #endif
-            }
         }
-        UNLOCK_TCPIP_CORE();
-        return 0;
-    } else {
-        UNLOCK_TCPIP_CORE();
-        *mp = NULL;
-        return MN_EAGAIN;
     }
+    return 0;
+}
+
+static int
+lwip_recvfrom(struct mn_socket *ms, struct os_mbuf **mp,
+  struct mn_sockaddr *addr)
+{
+    struct lwip_sock *s = (struct lwip_sock *)ms;
+    int rc;
+
+    LOCK_TCPIP_CORE();
+    rc = lwip_rx_dequeue(s, mp, addr);
+    UNLOCK_TCPIP_CORE();
+    return rc;
+}
+
+static int
+lwip_recvmsgs(struct mn_socket *ms, struct mn_msg *msgs, int *cnt)
+{
+    struct lwip_sock *s = (struct lwip_sock *)ms;
+    int rc;
+    int i;
+
+    rc = 0;
+    LOCK_TCPIP_CORE();
+    for (i = 0; i < *cnt; i++) {
+        rc = lwip_rx_dequeue(s, &msgs[i].mm_m,
+          (struct mn_sockaddr *)&msgs[i].mm_addr);
+        if (rc) {
+            break;
+        }
+    }
+    UNLOCK_TCPIP_CORE();
+    *cnt = i;
+    if (i && rc == MN_EAGAIN) {
+        rc = 0;
+    }
+    return rc;
 }
 
 static int
@@ -625,6 +759,7 @@ lwip_nif_from_idx(int idx)
 static int
 lwip_setsockopt(struct mn_socket *ms, uint8_t level, uint8_t name, void *val)
 {
+    struct lwip_sock *s = (struct lwip_sock *)ms;
     struct netif *nif;
     struct mn_mreq *mreq;
     int rc = MN_EPROTONOSUPPORT;
@@ -660,6 +795,9 @@ lwip_setsockopt(struct mn_socket *ms, uint8_t level, uint8_t name, void *val)
             }
             UNLOCK_TCPIP_CORE();
             return lwip_err_to_mn_err(rc);
+        case MN_SO_RXBATCH:
+            s->ls_rx_batch = (*(int *)val != 0);
+            return 0;
         case MN_MCAST_IF:
         default:
             break;
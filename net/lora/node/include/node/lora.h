@@ -20,7 +20,9 @@
 #ifndef H_LORA_
 #define H_LORA_
 
+#include <inttypes.h>
 #include "stats/stats.h"
+#include "node/mac/LoRaMac.h"
 
 STATS_SECT_START(lora_stats)
     STATS_SECT_ENTRY(rx_error)
@@ -28,7 +30,57 @@ STATS_SECT_START(lora_stats)
     STATS_SECT_ENTRY(rx_timeout)
     STATS_SECT_ENTRY(tx_success)
     STATS_SECT_ENTRY(tx_timeout)
+    STATS_SECT_ENTRY(txq_frames)
+    STATS_SECT_ENTRY(txq_drop)
 STATS_SECT_END
 extern STATS_SECT_DECL(lora_stats) lora_stats;
 
+/*
+ * Receive window timing, in microseconds: how late the window timers ran,
+ * and how long setting up the radio for receive took after that.
+ */
+STATS_SECT_START(lora_rxwin_stats)
+    STATS_SECT_GAUGE(late_usecs)
+    STATS_SECT_GAUGE(setup_usecs)
+STATS_SECT_END
+extern STATS_SECT_DECL(lora_rxwin_stats) lora_rxwin_stats;
+
+/*
+ * Transmit queue: payloads waiting, sampled whenever it changes, and how long
+ * the oldest payload of each frame sent had waited, in milliseconds.
+ */
+STATS_SECT_START(lora_txq_stats)
+    STATS_SECT_GAUGE(depth)
+    STATS_SECT_GAUGE(latency_ms)
+STATS_SECT_END
+extern STATS_SECT_DECL(lora_txq_stats) lora_txq_stats;
+
+/**
+ * Queue an application payload for transmission on the given port.
+ *
+ * Consecutive payloads for the same port are sent back to back in one frame,
+ * as many as fit in the largest payload of the current data rate; the
+ * application's payload format has to allow for them being split apart on
+ * the other end.  Frames are held back while the duty cycle restrictions
+ * don't allow a transmission, so payloads queued meanwhile join the frame.
+ *
+ * @param port                  LoRaWAN port, 1 to 223.
+ * @param data                  Payload to copy into the queue.
+ * @param len                   Length of payload, at most
+ *                                  LORA_NODE_TXQ_ENTRY_MAX.
+ *
+ * @return                      0 on success;
+ *                              OS_EINVAL if port or len are invalid;
+ *                              OS_ENOMEM if the queue is full.
+ */
+int lora_txq_put(uint8_t port, const void *data, uint8_t len);
+
+/**
+ * Tells the transmit queue that the LoRaMAC layer has finished with the last
+ * frame.  Has to be called from the application's McpsConfirm primitive.
+ *
+ * @param confirm               The confirm passed to the primitive.
+ */
+void lora_txq_mcps_confirm(McpsConfirm_t *confirm);
+
 #endif
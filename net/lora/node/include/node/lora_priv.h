@@ -40,5 +40,6 @@
 #endif
 
 void lora_cli_init(void);
+void lora_txq_init(void);
 
 #endif
@@ -29,8 +29,16 @@ STATS_NAME_START(lora_stats)
     STATS_NAME(lora_stats, rx_timeout)
     STATS_NAME(lora_stats, tx_success)
     STATS_NAME(lora_stats, tx_timeout)
+    STATS_NAME(lora_stats, txq_frames)
+    STATS_NAME(lora_stats, txq_drop)
 STATS_NAME_END(lora_stats)
 
+STATS_SECT_DECL(lora_rxwin_stats) lora_rxwin_stats;
+STATS_NAME_START(lora_rxwin_stats)
+    STATS_NAME(lora_rxwin_stats, late_usecs)
+    STATS_NAME(lora_rxwin_stats, setup_usecs)
+STATS_NAME_END(lora_rxwin_stats)
+
 void
 lora_node_init(void)
 {
@@ -42,7 +50,14 @@ lora_node_init(void)
         STATS_NAME_INIT_PARMS(lora_stats), "lora");
     SYSINIT_PANIC_ASSERT(rc == 0);
 
+    rc = stats_init_and_reg(
+        STATS_HDR(lora_rxwin_stats),
+        STATS_SIZE_INIT_PARMS(lora_rxwin_stats, STATS_SIZE_GAUGE),
+        STATS_NAME_INIT_PARMS(lora_rxwin_stats), "lora_rxwin");
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
 #if MYNEWT_VAL(LORA_NODE_CLI)
+    lora_txq_init();
     lora_cli_init();
 #endif
 }
@@ -0,0 +1,254 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "os/os.h"
+#include "sysinit/sysinit.h"
+#include "syscfg/syscfg.h"
+#include "node/lora.h"
+#include "node/lora_priv.h"
+
+#define LORA_TXQ_SIZE           MYNEWT_VAL(LORA_NODE_TXQ_SIZE)
+#define LORA_TXQ_ENTRY_MAX      MYNEWT_VAL(LORA_NODE_TXQ_ENTRY_MAX)
+#define LORA_TXQ_FRAME_MAX      242
+
+struct lora_txq_entry {
+    os_time_t lte_queued;
+    uint8_t lte_port;
+    uint8_t lte_len;
+    uint8_t lte_data[LORA_TXQ_ENTRY_MAX];
+};
+
+static struct {
+    struct lora_txq_entry entries[LORA_TXQ_SIZE];
+    uint8_t head;
+    uint8_t count;
+    uint8_t busy;           /* Frame handed to the MAC, not yet confirmed. */
+    struct os_callout co;
+    uint8_t frame[LORA_TXQ_FRAME_MAX];
+} lora_txq;
+
+STATS_SECT_DECL(lora_txq_stats) lora_txq_stats;
+STATS_NAME_START(lora_txq_stats)
+    STATS_NAME(lora_txq_stats, depth)
+    STATS_NAME(lora_txq_stats, latency_ms)
+STATS_NAME_END(lora_txq_stats)
+
+static struct lora_txq_entry *
+lora_txq_entry(int idx)
+{
+    return &lora_txq.entries[(lora_txq.head + idx) % LORA_TXQ_SIZE];
+}
+
+static void
+lora_txq_retry(uint32_t ms)
+{
+    uint32_t ticks;
+
+    if (os_time_ms_to_ticks(ms, &ticks) != 0 || ticks > INT32_MAX) {
+        ticks = INT32_MAX;
+    }
+    os_callout_reset(&lora_txq.co, ticks);
+}
+
+/*
+ * Removes cnt entries from the head of the queue.  Returns how long ago the
+ * first of them was queued, in ms.
+ */
+static uint32_t
+lora_txq_pop(int cnt)
+{
+    os_time_t queued;
+    int sr;
+
+    OS_ENTER_CRITICAL(sr);
+    queued = lora_txq_entry(0)->lte_queued;
+    lora_txq.head = (lora_txq.head + cnt) % LORA_TXQ_SIZE;
+    lora_txq.count -= cnt;
+    STATS_GAUGE_ADD(lora_txq_stats, depth, lora_txq.count);
+    OS_EXIT_CRITICAL(sr);
+
+    return (uint64_t)(os_time_get() - queued) * 1000 / OS_TICKS_PER_SEC;
+}
+
+static void
+lora_txq_ev_cb(struct os_event *ev)
+{
+    struct lora_txq_entry *lte;
+    MibRequestConfirm_t mib;
+    LoRaMacTxInfo_t info;
+    LoRaMacStatus_t status;
+    McpsReq_t req;
+    uint32_t delay;
+    uint32_t latency;
+    uint8_t port;
+    int max;
+    int len;
+    int cnt;
+
+    if (lora_txq.busy || lora_txq.count == 0) {
+        return;
+    }
+
+    /*
+     * Hold the frame back until the duty cycle allows sending it, rather
+     * than have the MAC do it; payloads queued meanwhile can still join it.
+     */
+    delay = LoRaMacQueryTxDelay();
+    if (delay != 0) {
+        lora_txq_retry(delay);
+        return;
+    }
+
+    status = LoRaMacQueryTxPossible(0, &info);
+    if (status == LORAMAC_STATUS_OK) {
+        max = info.MaxPossiblePayload;
+    } else {
+        max = 0;
+    }
+    if (max > LORA_TXQ_FRAME_MAX) {
+        max = LORA_TXQ_FRAME_MAX;
+    }
+
+    lte = lora_txq_entry(0);
+    if (lte->lte_len > info.CurrentPayloadSize) {
+        /* Too big for this data rate even without MAC commands. */
+        lora_txq_pop(1);
+        STATS_INC(lora_stats, txq_drop);
+        os_callout_reset(&lora_txq.co, 0);
+        return;
+    }
+
+    port = lte->lte_port;
+    len = 0;
+    for (cnt = 0; cnt < lora_txq.count; cnt++) {
+        lte = lora_txq_entry(cnt);
+        if (lte->lte_port != port || len + lte->lte_len > max) {
+            break;
+        }
+        memcpy(lora_txq.frame + len, lte->lte_data, lte->lte_len);
+        len += lte->lte_len;
+    }
+
+    mib.Type = MIB_CHANNELS_DATARATE;
+    LoRaMacMibGetRequestConfirm(&mib);
+
+    /*
+     * If pending MAC commands leave no room for the first payload, send an
+     * empty frame to flush them.
+     */
+    if (MYNEWT_VAL(LORA_NODE_TXQ_CONFIRMED) && cnt != 0) {
+        req.Type = MCPS_CONFIRMED;
+        req.Req.Confirmed.fPort = port;
+        req.Req.Confirmed.fBuffer = lora_txq.frame;
+        req.Req.Confirmed.fBufferSize = len;
+        req.Req.Confirmed.Datarate = mib.Param.ChannelsDatarate;
+        req.Req.Confirmed.NbTrials = MYNEWT_VAL(LORA_NODE_TXQ_CONFIRMED);
+    } else {
+        req.Type = MCPS_UNCONFIRMED;
+        req.Req.Unconfirmed.fPort = port;
+        req.Req.Unconfirmed.fBuffer = cnt != 0 ? lora_txq.frame : NULL;
+        req.Req.Unconfirmed.fBufferSize = len;
+        req.Req.Unconfirmed.Datarate = mib.Param.ChannelsDatarate;
+    }
+
+    status = LoRaMacMcpsRequest(&req);
+    switch (status) {
+    case LORAMAC_STATUS_OK:
+        lora_txq.busy = 1;
+        if (cnt != 0) {
+            /* The MAC has copied the payload into its own buffer. */
+            latency = lora_txq_pop(cnt);
+            STATS_GAUGE_ADD(lora_txq_stats, latency_ms, latency);
+            STATS_INC(lora_stats, txq_frames);
+        }
+        break;
+    case LORAMAC_STATUS_BUSY:
+    case LORAMAC_STATUS_NO_NETWORK_JOINED:
+        lora_txq_retry(MYNEWT_VAL(LORA_NODE_TXQ_RETRY_MS));
+        break;
+    default:
+        if (cnt != 0) {
+            lora_txq_pop(cnt);
+            STATS_INCN(lora_stats, txq_drop, cnt);
+            os_callout_reset(&lora_txq.co, 0);
+        } else {
+            lora_txq_retry(MYNEWT_VAL(LORA_NODE_TXQ_RETRY_MS));
+        }
+        break;
+    }
+}
+
+int
+lora_txq_put(uint8_t port, const void *data, uint8_t len)
+{
+    struct lora_txq_entry *lte;
+    int sr;
+
+    if (port == 0 || port > 223 || len == 0 || len > LORA_TXQ_ENTRY_MAX) {
+        return OS_EINVAL;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    if (lora_txq.count == LORA_TXQ_SIZE) {
+        OS_EXIT_CRITICAL(sr);
+        STATS_INC(lora_stats, txq_drop);
+        return OS_ENOMEM;
+    }
+    lte = lora_txq_entry(lora_txq.count);
+    lte->lte_queued = os_time_get();
+    lte->lte_port = port;
+    lte->lte_len = len;
+    memcpy(lte->lte_data, data, len);
+    lora_txq.count++;
+    STATS_GAUGE_ADD(lora_txq_stats, depth, lora_txq.count);
+    OS_EXIT_CRITICAL(sr);
+
+    if (!lora_txq.busy && !os_callout_queued(&lora_txq.co)) {
+        os_callout_reset(&lora_txq.co, 0);
+    }
+    return 0;
+}
+
+void
+lora_txq_mcps_confirm(McpsConfirm_t *confirm)
+{
+    if (!lora_txq.busy) {
+        return;
+    }
+    lora_txq.busy = 0;
+    if (lora_txq.count != 0) {
+        os_callout_reset(&lora_txq.co, 0);
+    }
+}
+
+void
+lora_txq_init(void)
+{
+    int rc;
+
+    os_callout_init(&lora_txq.co, os_eventq_dflt_get(), lora_txq_ev_cb, NULL);
+
+    rc = stats_init_and_reg(
+        STATS_HDR(lora_txq_stats),
+        STATS_SIZE_INIT_PARMS(lora_txq_stats, STATS_SIZE_GAUGE),
+        STATS_NAME_INIT_PARMS(lora_txq_stats), "lora_txq");
+    SYSINIT_PANIC_ASSERT(rc == 0);
+}
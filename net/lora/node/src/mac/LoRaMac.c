@@ -32,6 +32,7 @@ Maintainer: Miguel Luis ( Semtech ), Gregory Cristian ( Semtech ) and Daniel Jä
 #include "hal/hal_timer.h"
 
 #include "node/lora_priv.h"
+#include "node/lora.h"
 
 /*!
  * Maximum PHY layer payload size
@@ -572,6 +573,13 @@ static struct hal_timer RxWindowTimer2;
 static uint32_t RxWindow1Delay;
 static uint32_t RxWindow2Delay;
 
+/*!
+ * Time, in cputime ticks, it takes to set up the radio for receive once a
+ * reception window timer fires.  Windows are started this much earlier.
+ * Follows increases right away and decreases slowly.
+ */
+static uint32_t RxWindowSetupTicks;
+
 /*!
  * Acknowledge timeout timer. Used for packet retransmissions.
  */
@@ -954,6 +962,49 @@ LoRaMacStatus_t SetTxContinuousWave( uint16_t timeout );
  */
 static void ResetMacParameters( void );
 
+/*!
+ * \brief Starts a reception window or ack timeout timer
+ *
+ * \remark The timer is started relative to the time the transmission ended
+ *         rather than to now, so time spent handling the TX done event is
+ *         not added to the delay.
+ *
+ * \param [IN] timer      Timer to start
+ * \param [IN] txDoneTime cputime at which the transmission ended
+ * \param [IN] delay      Delay from the end of the transmission, in ms
+ */
+static void RxWindowTimerStart( struct hal_timer *timer, uint32_t txDoneTime, uint32_t delay )
+{
+    os_cputime_timer_start( timer, txDoneTime +
+                            os_cputime_usecs_to_ticks( delay * 1000 ) -
+                            RxWindowSetupTicks );
+}
+
+/*!
+ * \brief Records the timing of a reception window once the radio is set up
+ *
+ * \param [IN] timer      Timer of the window
+ * \param [IN] fired      cputime at which the timer callback ran
+ */
+static void RxWindowOpened( struct hal_timer *timer, uint32_t fired )
+{
+    uint32_t setup = os_cputime_get32( ) - fired;
+
+    STATS_GAUGE_ADD( lora_rxwin_stats, late_usecs,
+                     os_cputime_ticks_to_usecs( fired - timer->expiry ) );
+    STATS_GAUGE_ADD( lora_rxwin_stats, setup_usecs,
+                     os_cputime_ticks_to_usecs( setup ) );
+
+    if( setup > RxWindowSetupTicks )
+    {
+        RxWindowSetupTicks = setup;
+    }
+    else
+    {
+        RxWindowSetupTicks -= ( RxWindowSetupTicks - setup ) / 8;
+    }
+}
+
 static void OnRadioTxDone(void)
 {
     uint32_t curTime = os_cputime_get32();
@@ -970,17 +1021,16 @@ static void OnRadioTxDone(void)
     // Setup timers
     if( IsRxWindowsEnabled == true )
     {
-        os_cputime_timer_relative(&RxWindowTimer1, RxWindow1Delay);
+        RxWindowTimerStart( &RxWindowTimer1, curTime, RxWindow1Delay );
         if( LoRaMacDeviceClass != CLASS_C )
         {
-            os_cputime_timer_relative(&RxWindowTimer2, RxWindow2Delay);
+            RxWindowTimerStart( &RxWindowTimer2, curTime, RxWindow2Delay );
         }
         if( ( LoRaMacDeviceClass == CLASS_C ) || ( NodeAckRequested == true ) )
         {
-            os_cputime_timer_relative(
-                &AckTimeoutTimer,
-                RxWindow2Delay + ACK_TIMEOUT +
-                    randr(-ACK_TIMEOUT_RND, ACK_TIMEOUT_RND));
+            os_cputime_timer_start( &AckTimeoutTimer, curTime +
+                os_cputime_usecs_to_ticks( ( RxWindow2Delay + ACK_TIMEOUT +
+                    randr( -ACK_TIMEOUT_RND, ACK_TIMEOUT_RND ) ) * 1000 ) );
         }
     }
     else
@@ -1705,8 +1755,9 @@ static void OnTxDelayedTimerEvent(void *unused)
     ScheduleTx( );
 }
 
-static void OnRxWindow1TimerEvent(void *unused)
+static void OnRxWindow1TimerEvent(void *arg)
 {
+    uint32_t fired = os_cputime_get32( );
     uint16_t symbTimeout = 5; // DR_2, DR_1, DR_0
     int8_t datarate = 0;
     uint32_t bandwidth = 0; // LoRa 125 kHz
@@ -1803,10 +1854,16 @@ static void OnRxWindow1TimerEvent(void *unused)
 #else
     #error "Please define a frequency band in the compiler options."
 #endif
+    RxWindowOpened( &RxWindowTimer1, fired );
 }
 
-static void OnRxWindow2TimerEvent(void *unused)
+/*
+ * Also called directly, with a NULL argument, to open a continuous window
+ * in class C.  The timer passes itself as the argument.
+ */
+static void OnRxWindow2TimerEvent(void *arg)
 {
+    uint32_t fired = os_cputime_get32( );
     uint16_t symbTimeout = 5; // DR_2, DR_1, DR_0
     uint32_t bandwidth = 0; // LoRa 125 kHz
     bool rxContinuousMode = false;
@@ -1885,6 +1942,10 @@ static void OnRxWindow2TimerEvent(void *unused)
     {
         RxSlot = 1;
     }
+    if( arg != NULL )
+    {
+        RxWindowOpened( &RxWindowTimer2, fired );
+    }
 }
 
 static void OnAckTimeoutTimerEvent(void *unused)
@@ -2924,7 +2985,7 @@ static LoRaMacStatus_t ScheduleTx( )
     {
         // Send later - prepare timer
         LoRaMacState |= LORAMAC_TX_DELAYED;
-        os_cputime_timer_relative(&TxDelayedTimer, dutyCycleTimeOff);
+        os_cputime_timer_relative(&TxDelayedTimer, dutyCycleTimeOff * 1000);
 
         return LORAMAC_STATUS_OK;
     }
@@ -3468,8 +3529,10 @@ LoRaMacStatus_t LoRaMacInitialization( LoRaMacPrimitives_t *primitives, LoRaMacC
                           NULL);
 
     os_cputime_timer_init(&TxDelayedTimer, OnTxDelayedTimerEvent, NULL);
-    os_cputime_timer_init(&RxWindowTimer1, OnRxWindow1TimerEvent, NULL);
-    os_cputime_timer_init(&RxWindowTimer2, OnRxWindow2TimerEvent, NULL);
+    os_cputime_timer_init(&RxWindowTimer1, OnRxWindow1TimerEvent,
+                          &RxWindowTimer1);
+    os_cputime_timer_init(&RxWindowTimer2, OnRxWindow2TimerEvent,
+                          &RxWindowTimer2);
     os_cputime_timer_init(&AckTimeoutTimer, OnAckTimeoutTimerEvent, NULL);
 
     // Initialize Radio driver
@@ -3533,6 +3596,54 @@ LoRaMacStatus_t LoRaMacQueryTxPossible( uint8_t size, LoRaMacTxInfo_t* txInfo )
     return LORAMAC_STATUS_OK;
 }
 
+uint32_t LoRaMacQueryTxDelay( void )
+{
+    uint32_t elapsed;
+    uint32_t remaining;
+    uint32_t delay = UINT32_MAX;
+
+    elapsed = TimerGetElapsedTime( AggregatedLastTxDoneTime );
+    if( AggregatedTimeOff > elapsed )
+    {
+        return AggregatedTimeOff - elapsed;
+    }
+
+    if( ( IsLoRaMacNetworkJoined == true ) && ( DutyCycleOn == false ) )
+    {
+        return 0;
+    }
+
+    // The soonest any enabled channel's band comes out of its time off
+    for( uint8_t i = 0, k = 0; i < LORA_MAX_NB_CHANNELS; i += 16, k++ )
+    {
+        for( uint8_t j = 0; j < 16; j++ )
+        {
+            if( ( LoRaMacParams.ChannelsMask[k] & ( 1 << j ) ) == 0 )
+            {
+                continue;
+            }
+            if( Channels[i + j].Frequency == 0 )
+            {
+                continue;
+            }
+            elapsed = TimerGetElapsedTime( Bands[Channels[i + j].Band].LastTxDoneTime );
+            if( Bands[Channels[i + j].Band].TimeOff <= elapsed )
+            {
+                return 0;
+            }
+            remaining = Bands[Channels[i + j].Band].TimeOff - elapsed;
+            delay = MIN( delay, remaining );
+        }
+    }
+
+    if( delay == UINT32_MAX )
+    {
+        // No channel enabled; let the request report the error
+        delay = 0;
+    }
+    return delay;
+}
+
 LoRaMacStatus_t LoRaMacMibGetRequestConfirm( MibRequestConfirm_t *mibGet )
 {
     LoRaMacStatus_t status = LORAMAC_STATUS_OK;
@@ -20,35 +20,25 @@ Maintainer: Miguel Luis ( Semtech ), Gregory Cristian ( Semtech ) and Daniel Jä
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include "syscfg/syscfg.h"
 #include "node/utilities.h"
 
-#include "aes.h"
-#include "cmac.h"
+#if MYNEWT_VAL(LORA_NODE_CRYPTO_HAL)
+#include "hal/hal_aes.h"
+#else
+#include "tinycrypt/aes.h"
+#endif
 
 #include "node/mac/LoRaMacCrypto.h"
 
-/*!
- * CMAC/AES Message Integrity Code (MIC) Block B0 size
- */
 #define LORAMAC_MIC_BLOCK_B0_SIZE                   16
 
-/*!
- * MIC field computation initial data
- */
 static uint8_t MicBlockB0[] = { 0x49, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
                                 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
                               };
 
-/*!
- * Contains the computed MIC field.
- *
- * \remark Only the 4 first bytes are used
- */
 static uint8_t Mic[16];
 
-/*!
- * Encryption aBlock and sBlock
- */
 static uint8_t aBlock[] = { 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
                             0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
                           };
@@ -56,27 +46,110 @@ static uint8_t sBlock[] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
                             0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
                           };
 
+#if MYNEWT_VAL(LORA_NODE_CRYPTO_HAL)
+static uint8_t AesKey[16];
+#else
+static struct tc_aes_key_sched_struct AesKeySched;
+#endif
+
 /*!
- * AES computation context variable
+ * Sets the key used by LoRaMacAesEncrypt
  */
-static aes_context AesContext;
+static void LoRaMacAesSetKey( const uint8_t *key )
+{
+#if MYNEWT_VAL(LORA_NODE_CRYPTO_HAL)
+    memcpy( AesKey, key, sizeof( AesKey ) );
+#else
+    tc_aes128_set_encrypt_key( &AesKeySched, key );
+#endif
+}
 
 /*!
- * CMAC computation context variable
+ * Encrypts one block, with the MCU's AES engine if LORA_NODE_CRYPTO_HAL is
+ * set and in software otherwise. in and out may be the same buffer.
  */
-//static AES_CMAC_CTX AesCmacCtx[1];
+static void LoRaMacAesEncrypt( const uint8_t *in, uint8_t *out )
+{
+#if MYNEWT_VAL(LORA_NODE_CRYPTO_HAL)
+    hal_aes128_encrypt( AesKey, in, out );
+#else
+    tc_aes_encrypt( out, in, &AesKeySched );
+#endif
+}
 
 /*!
- * \brief Computes the LoRaMAC frame MIC field  
- *
- * \param [IN]  buffer          Data buffer
- * \param [IN]  size            Data buffer size
- * \param [IN]  key             AES key to be used
- * \param [IN]  address         Frame address
- * \param [IN]  dir             Frame direction [0: uplink, 1: downlink]
- * \param [IN]  sequenceCounter Frame sequence counter
- * \param [OUT] mic Computed MIC field
+ * Derives the next AES-CMAC subkey from the previous one (RFC 4493, 2.3)
  */
+static void LoRaMacCmacSubkey( uint8_t *k )
+{
+    uint8_t msb = k[0] & 0x80;
+
+    for( uint8_t i = 0; i < 15; i++ )
+    {
+        k[i] = ( k[i] << 1 ) | ( k[i + 1] >> 7 );
+    }
+    k[15] <<= 1;
+    if( msb != 0 )
+    {
+        k[15] ^= 0x87;
+    }
+}
+
+/*!
+ * Computes the AES-CMAC (RFC 4493) of the optional block0 followed by
+ * buffer, with the key set by LoRaMacAesSetKey, into Mic
+ */
+static void LoRaMacAesCmac( const uint8_t *block0, const uint8_t *buffer, uint16_t size )
+{
+    uint8_t subkey[16];
+    uint16_t headLen = ( block0 != NULL ) ? 16 : 0;
+    uint16_t total = headLen + size;
+    uint16_t nbBlocks = ( total + 15 ) / 16;
+    uint16_t idx;
+    uint8_t byte;
+
+    // K1 = L << 1, K2 = K1 << 1, where L = AES( K, 0 )
+    memset( subkey, 0, sizeof( subkey ) );
+    LoRaMacAesEncrypt( subkey, subkey );
+    LoRaMacCmacSubkey( subkey );
+    if( ( total == 0 ) || ( ( total % 16 ) != 0 ) )
+    {
+        // Last block is padded
+        LoRaMacCmacSubkey( subkey );
+    }
+    if( nbBlocks == 0 )
+    {
+        nbBlocks = 1;
+    }
+
+    memset( Mic, 0, sizeof( Mic ) );
+    for( uint16_t b = 0; b < nbBlocks; b++ )
+    {
+        for( uint8_t i = 0; i < 16; i++ )
+        {
+            idx = b * 16 + i;
+            if( idx < headLen )
+            {
+                byte = block0[idx];
+            }
+            else if( idx < total )
+            {
+                byte = buffer[idx - headLen];
+            }
+            else
+            {
+                byte = ( idx == total ) ? 0x80 : 0x00;
+            }
+            if( b == nbBlocks - 1 )
+            {
+                byte ^= subkey[i];
+            }
+            Mic[i] ^= byte;
+        }
+        LoRaMacAesEncrypt( Mic, Mic );
+    }
+}
+
 void LoRaMacComputeMic( const uint8_t *buffer, uint16_t size, const uint8_t *key, uint32_t address, uint8_t dir, uint32_t sequenceCounter, uint32_t *mic )
 {
     MicBlockB0[5] = dir;
@@ -93,27 +166,18 @@ void LoRaMacComputeMic( const uint8_t *buffer, uint16_t size, const uint8_t *key
 
     MicBlockB0[15] = size & 0xFF;
 
-    //AES_CMAC_Init( AesCmacCtx );
-
-    //AES_CMAC_SetKey( AesCmacCtx, key );
-
-    //AES_CMAC_Update( AesCmacCtx, MicBlockB0, LORAMAC_MIC_BLOCK_B0_SIZE );
-    
-    //AES_CMAC_Update( AesCmacCtx, buffer, size & 0xFF );
-    
-    //AES_CMAC_Final( Mic, AesCmacCtx );
+    LoRaMacAesSetKey( key );
+    LoRaMacAesCmac( MicBlockB0, buffer, size & 0xFF );
     
     *mic = ( uint32_t )( ( uint32_t )Mic[3] << 24 | ( uint32_t )Mic[2] << 16 | ( uint32_t )Mic[1] << 8 | ( uint32_t )Mic[0] );
 }
-
 void LoRaMacPayloadEncrypt( const uint8_t *buffer, uint16_t size, const uint8_t *key, uint32_t address, uint8_t dir, uint32_t sequenceCounter, uint8_t *encBuffer )
 {
     uint16_t i;
     uint8_t bufferIndex = 0;
     uint16_t ctr = 1;
 
-    memset( AesContext.ksch, '\0', 240 );
-    //aes_set_key( key, 16, &AesContext );
+    LoRaMacAesSetKey( key );
 
     aBlock[5] = dir;
 
@@ -131,7 +195,7 @@ void LoRaMacPayloadEncrypt( const uint8_t *buffer, uint16_t size, const uint8_t
     {
         aBlock[15] = ( ( ctr ) & 0xFF );
         ctr++;
-        //aes_encrypt( aBlock, sBlock, &AesContext );
+        LoRaMacAesEncrypt( aBlock, sBlock );
         for( i = 0; i < 16; i++ )
         {
             encBuffer[bufferIndex + i] = buffer[bufferIndex + i] ^ sBlock[i];
@@ -143,7 +207,7 @@ void LoRaMacPayloadEncrypt( const uint8_t *buffer, uint16_t size, const uint8_t
     if( size > 0 )
     {
         aBlock[15] = ( ( ctr ) & 0xFF );
-        //aes_encrypt( aBlock, sBlock, &AesContext );
+        LoRaMacAesEncrypt( aBlock, sBlock );
         for( i = 0; i < size; i++ )
         {
             encBuffer[bufferIndex + i] = buffer[bufferIndex + i] ^ sBlock[i];
@@ -158,26 +222,20 @@ void LoRaMacPayloadDecrypt( const uint8_t *buffer, uint16_t size, const uint8_t
 
 void LoRaMacJoinComputeMic( const uint8_t *buffer, uint16_t size, const uint8_t *key, uint32_t *mic )
 {
-    //AES_CMAC_Init( AesCmacCtx );
-
-    //AES_CMAC_SetKey( AesCmacCtx, key );
-
-    //AES_CMAC_Update( AesCmacCtx, buffer, size & 0xFF );
-
-    //AES_CMAC_Final( Mic, AesCmacCtx );
+    LoRaMacAesSetKey( key );
+    LoRaMacAesCmac( NULL, buffer, size & 0xFF );
 
     *mic = ( uint32_t )( ( uint32_t )Mic[3] << 24 | ( uint32_t )Mic[2] << 16 | ( uint32_t )Mic[1] << 8 | ( uint32_t )Mic[0] );
 }
 
 void LoRaMacJoinDecrypt( const uint8_t *buffer, uint16_t size, const uint8_t *key, uint8_t *decBuffer )
 {
-    memset( AesContext.ksch, '\0', 240 );
-    //aes_set_key( key, 16, &AesContext );
-    //aes_encrypt( buffer, decBuffer, &AesContext );
+    LoRaMacAesSetKey( key );
+    LoRaMacAesEncrypt( buffer, decBuffer );
     // Check if optional CFList is included
     if( size >= 16 )
     {
-        //aes_encrypt( buffer + 16, decBuffer + 16, &AesContext );
+        LoRaMacAesEncrypt( buffer + 16, decBuffer + 16 );
     }
 }
 
@@ -186,18 +244,17 @@ void LoRaMacJoinComputeSKeys( const uint8_t *key, const uint8_t *appNonce, uint1
     uint8_t nonce[16];
     uint8_t *pDevNonce = ( uint8_t * )&devNonce;
     
-    memset( AesContext.ksch, '\0', 240 );
-    //aes_set_key( key, 16, &AesContext );
+    LoRaMacAesSetKey( key );
 
     memset( nonce, 0, sizeof( nonce ) );
     nonce[0] = 0x01;
     memcpy( nonce + 1, appNonce, 6 );
     memcpy( nonce + 7, pDevNonce, 2 );
-    //aes_encrypt( nonce, nwkSKey, &AesContext );
+    LoRaMacAesEncrypt( nonce, nwkSKey );
 
     memset( nonce, 0, sizeof( nonce ) );
     nonce[0] = 0x02;
     memcpy( nonce + 1, appNonce, 6 );
     memcpy( nonce + 7, pDevNonce, 2 );
-    //aes_encrypt( nonce, appSKey, &AesContext );
+    LoRaMacAesEncrypt( nonce, appSKey );
 }
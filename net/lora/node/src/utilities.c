@@ -57,7 +57,8 @@ round(double d)
 uint32_t
 TimerGetElapsedTime(uint32_t savedTime)
 {
-    return savedTime - os_cputime_get32();
+    /* savedTime is in cputime ticks; the MAC's time offs are in ms. */
+    return os_cputime_ticks_to_usecs(os_cputime_get32() - savedTime) / 1000;
 }
 
 uint32_t
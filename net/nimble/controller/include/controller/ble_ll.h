@@ -24,6 +24,7 @@
 #include "os/os_eventq.h"
 #include "os/os_callout.h"
 #include "os/os_cputime.h"
+#include "os/os_trace.h"
 #include "nimble/nimble_opt.h"
 #include "controller/ble_phy.h"
 
@@ -44,6 +45,17 @@ extern "C" {
  * would exceed 31 usecs.
  */
 
+/*
+ * Marks a function on the radio interrupt hot path. With
+ * BLE_LL_HOT_PATH_IN_RAM the function is placed in the .ramfunc section,
+ * which is copied to RAM at startup; long_call lets code in flash reach it.
+ */
+#if MYNEWT_VAL(BLE_LL_HOT_PATH_IN_RAM)
+#define BLE_LL_RAMFUNC  __attribute__((section(".ramfunc"), long_call))
+#else
+#define BLE_LL_RAMFUNC
+#endif
+
 /* Determines if we need to turn on/off rf clock */
 #undef BLE_XCVR_RFCLK
 
@@ -85,7 +97,7 @@ struct ble_ll_obj
     uint8_t ll_state;
 
     /* Supported features */
-    uint8_t ll_supp_features;
+    uint32_t ll_supp_features;
 
     /* Number of ACL data packets supported */
     uint8_t ll_num_acl_pkts;
@@ -159,6 +171,7 @@ STATS_SECT_START(ble_ll_stats)
     STATS_SECT_ENTRY(adv_late_starts)
     STATS_SECT_ENTRY(sched_state_conn_errs)
     STATS_SECT_ENTRY(sched_state_adv_errs)
+    STATS_SECT_ENTRY(sched_adv_packed)
     STATS_SECT_ENTRY(scan_starts)
     STATS_SECT_ENTRY(scan_stops)
     STATS_SECT_ENTRY(scan_req_txf)
@@ -183,6 +196,8 @@ extern STATS_SECT_DECL(ble_ll_stats) ble_ll_stats;
 #define BLE_LL_FEAT_DATA_LEN_EXT    (0x20)
 #define BLE_LL_FEAT_LL_PRIVACY      (0x40)
 #define BLE_LL_FEAT_EXT_SCAN_FILT   (0x80)
+#define BLE_LL_FEAT_LE_2M_PHY       (0x100)
+#define BLE_LL_FEAT_CSA2            (0x4000)
 
 /* LL timing */
 #define BLE_LL_IFS                  (150)       /* usecs */
@@ -237,6 +252,17 @@ struct ble_dev_addr
  */
 #define BLE_TX_DUR_USECS_M(len)     (((len) + BLE_LL_PDU_OVERHEAD) << 3)
 
+/*
+ * Same as above for the LE 2M PHY. Each byte takes 4 usecs and the preamble
+ * is 2 bytes long instead of 1.
+ */
+#define BLE_TX_DUR_USECS_2M(len)    (((len) + BLE_LL_PDU_OVERHEAD + 1) << 2)
+
+/* Transmit duration of a PDU on the given PHY (BLE_PHY_MODE_xxx) */
+#define BLE_TX_DUR_USECS_PHY(len, phy)                      \
+    (((phy) == BLE_PHY_MODE_2M) ? BLE_TX_DUR_USECS_2M(len) : \
+                                  BLE_TX_DUR_USECS_M(len))
+
 /* Calculates the time it takes to transmit 'len' bytes */
 #define BLE_TX_LEN_USECS_M(len)     ((len) << 3)
 
@@ -252,6 +278,7 @@ struct ble_dev_addr
  * -> Payload (max 37 bytes)
  */
 #define BLE_ADV_PDU_HDR_TYPE_MASK           (0x0F)
+#define BLE_ADV_PDU_HDR_CHSEL_MASK          (0x20)
 #define BLE_ADV_PDU_HDR_TXADD_MASK          (0x40)
 #define BLE_ADV_PDU_HDR_RXADD_MASK          (0x80)
 #define BLE_ADV_PDU_HDR_LEN_MASK            (0x3F)
@@ -375,10 +402,11 @@ void ble_ll_hw_error(void);
 struct ble_mbuf_hdr;
 
 /* Called by the PHY when a packet has started */
-int ble_ll_rx_start(uint8_t *rxbuf, uint8_t chan, struct ble_mbuf_hdr *hdr);
+BLE_LL_RAMFUNC int ble_ll_rx_start(uint8_t *rxbuf, uint8_t chan,
+                                   struct ble_mbuf_hdr *hdr);
 
 /* Called by the PHY when a packet reception ends */
-int ble_ll_rx_end(uint8_t *rxbuf, struct ble_mbuf_hdr *rxhdr);
+BLE_LL_RAMFUNC int ble_ll_rx_end(uint8_t *rxbuf, struct ble_mbuf_hdr *rxhdr);
 
 /*--- Controller API ---*/
 void ble_ll_mbuf_init(struct os_mbuf *m, uint8_t pdulen, uint8_t hdr);
@@ -408,7 +436,7 @@ void ble_ll_wfr_disable(void);
 void ble_ll_wfr_timer_exp(void *arg);
 
 /* Read set of features supported by the Link Layer */
-uint8_t ble_ll_read_supp_features(void);
+uint32_t ble_ll_read_supp_features(void);
 
 /* Read set of states supported by the Link Layer */
 uint64_t ble_ll_read_supp_states(void);
@@ -421,6 +449,9 @@ int ble_ll_chk_txrx_time(uint16_t time);
 int ble_ll_rand_init(void);
 void ble_ll_rand_sample(uint8_t rnum);
 int ble_ll_rand_data_get(uint8_t *buf, uint8_t len);
+int ble_ll_rand_data_try_get(uint8_t *buf, uint8_t len);
+uint32_t ble_ll_rand(void);
+void ble_ll_rand_seed(uint32_t seed);
 void ble_ll_rand_prand_get(uint8_t *prand);
 int ble_ll_rand_start(void);
 
@@ -456,6 +487,10 @@ int ble_ll_rand_start(void);
 #define BLE_LL_LOG_ID_RFCLK_SCHED_DIS   (96)
 #define BLE_LL_LOG_ID_RFCLK_SCAN_DIS    (97)
 
+/* Event ids for the kernel trace (OS_TRACE) */
+#define BLE_LL_TRACE_ID_RX_START        (OS_TRACE_ID_USER + 0)  /* chan */
+#define BLE_LL_TRACE_ID_RX_END          (OS_TRACE_ID_USER + 1)  /* hdr, len */
+
 #ifdef BLE_LL_LOG
 void ble_ll_log(uint8_t id, uint8_t arg8, uint16_t arg16, uint32_t arg32);
 #else
@@ -93,6 +93,21 @@ struct ble_ll_conn_enc_data
 };
 #endif
 
+/*
+ * PHY information for a connection. The PHY values are BLE_PHY_MODE_xxx and
+ * the preferences are bitmasks of BLE_HCI_LE_PHY_xxx_PREF_MASK.
+ */
+struct ble_ll_conn_phy_data
+{
+    uint8_t cur_tx_phy;
+    uint8_t cur_rx_phy;
+    uint8_t new_tx_phy;
+    uint8_t new_rx_phy;
+    uint8_t host_pref_tx_phys;
+    uint8_t host_pref_rx_phys;
+    uint16_t phy_instant;
+};
+
 /* Connection state machine flags. */
 union ble_ll_conn_sm_flags {
     struct {
@@ -115,6 +130,10 @@ union ble_ll_conn_sm_flags {
         uint32_t encrypted:1;
         uint32_t encrypt_chg_sent:1;
         uint32_t le_ping_supp:1;
+        uint32_t phy_update_sched:1;
+        uint32_t host_phy_update:1;
+        uint32_t phy_update_event:1;
+        uint32_t csa2:1;
     } cfbit;
     uint32_t conn_flags;
 } __attribute__((packed));
@@ -144,6 +163,9 @@ struct ble_ll_conn_sm
     uint16_t eff_max_tx_time;
     uint16_t eff_max_rx_time;
 
+    /* PHY used by the connection and PHY update procedure data */
+    struct ble_ll_conn_phy_data phy_data;
+
     /* Used to calculate data channel index for connection */
     uint8_t chanmap[BLE_LL_CONN_CHMAP_LEN];
     uint8_t req_chanmap[BLE_LL_CONN_CHMAP_LEN];
@@ -153,6 +175,7 @@ struct ble_ll_conn_sm
     uint8_t unmapped_chan;
     uint8_t last_unmapped_chan;
     uint8_t num_used_chans;
+    uint16_t channel_id;        /* Channel selection algorithm #2 */
 
     /* RSSI */
     int8_t conn_rssi;
@@ -165,6 +188,10 @@ struct ble_ll_conn_sm
     uint8_t last_rxd_hdr_byte;  /* note: possibly can make 1 bit since we
                                    only use the MD bit now */
 
+    /* Per connection event statistics */
+    uint8_t ce_txd_pdus;        /* Non-empty PDUs sent in this event */
+    uint8_t ce_extended;        /* Event ran past its scheduled end time */
+
     /* For privacy */
     int8_t rpa_index;
 
@@ -176,7 +203,7 @@ struct ble_ll_conn_sm
     uint8_t cur_ctrl_proc;
     uint8_t disconnect_reason;
     uint8_t rxd_disconnect_reason;
-    uint8_t common_features;        /* Just a uint8 for now */
+    uint32_t common_features;
     uint8_t vers_nr;
     uint16_t pending_ctrl_procs;
     uint16_t event_cntr;
@@ -271,6 +298,10 @@ struct ble_ll_conn_sm
 #define CONN_F_ENC_CHANGE_SENT(csm) ((csm)->csmflags.cfbit.encrypt_chg_sent)
 #define CONN_F_LE_PING_SUPP(csm)    ((csm)->csmflags.cfbit.le_ping_supp)
 #define CONN_F_TERMINATE_STARTED(csm) ((csm)->csmflags.cfbit.terminate_started)
+#define CONN_F_PHY_UPDATE_SCHED(csm) ((csm)->csmflags.cfbit.phy_update_sched)
+#define CONN_F_HOST_PHY_UPDATE(csm) ((csm)->csmflags.cfbit.host_phy_update)
+#define CONN_F_PHY_UPDATE_EVENT(csm) ((csm)->csmflags.cfbit.phy_update_event)
+#define CONN_F_CSA2_SUPP(csm)       ((csm)->csmflags.cfbit.csa2)
 
 /* Role */
 #define CONN_IS_MASTER(csm)         (csm->conn_role == BLE_LL_CONN_ROLE_MASTER)
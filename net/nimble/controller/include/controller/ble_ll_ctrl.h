@@ -38,7 +38,8 @@ extern "C" {
 #define BLE_LL_CTRL_PROC_CONN_PARAM_REQ (6)
 #define BLE_LL_CTRL_PROC_LE_PING        (7)
 #define BLE_LL_CTRL_PROC_DATA_LEN_UPD   (8)
-#define BLE_LL_CTRL_PROC_NUM            (9)
+#define BLE_LL_CTRL_PROC_PHY_UPDATE     (9)
+#define BLE_LL_CTRL_PROC_NUM            (10)
 #define BLE_LL_CTRL_PROC_IDLE           (255)
 
 /* Checks if a particular control procedure is running */
@@ -75,9 +76,12 @@ extern "C" {
 #define BLE_LL_CTRL_PING_RSP            (19)
 #define BLE_LL_CTRL_LENGTH_REQ          (20)
 #define BLE_LL_CTRL_LENGTH_RSP          (21)
+#define BLE_LL_CTRL_PHY_REQ             (22)
+#define BLE_LL_CTRL_PHY_RSP             (23)
+#define BLE_LL_CTRL_PHY_UPDATE_IND      (24)
 
 /* Maximum opcode value */
-#define BLE_LL_CTRL_OPCODES             (BLE_LL_CTRL_LENGTH_RSP + 1)
+#define BLE_LL_CTRL_OPCODES             (BLE_LL_CTRL_PHY_UPDATE_IND + 1)
 
 extern const uint8_t g_ble_ll_ctrl_pkt_lengths[BLE_LL_CTRL_OPCODES];
 
@@ -221,6 +225,21 @@ struct ble_ll_len_req
 
 #define BLE_LL_CTRL_LENGTH_REQ_LEN      (8)
 
+/*
+ * LL control PHY req and PHY rsp
+ *  -> tx_phys (1 byte): bitmask of preferred transmit PHYs.
+ *  -> rx_phys (1 byte): bitmask of preferred receive PHYs.
+ */
+#define BLE_LL_CTRL_PHY_REQ_LEN         (2)
+
+/*
+ * LL control PHY update ind
+ *  -> m_to_s_phy (1 byte): PHY used from master to slave (0 if unchanged).
+ *  -> s_to_m_phy (1 byte): PHY used from slave to master (0 if unchanged).
+ *  -> instant (2 bytes)
+ */
+#define BLE_LL_CTRL_PHY_UPDATE_IND_LEN  (4)
+
 /* API */
 struct ble_ll_conn_sm;
 void ble_ll_ctrl_proc_start(struct ble_ll_conn_sm *connsm, int ctrl_proc);
@@ -240,6 +259,7 @@ int ble_ll_ctrl_tx_done(struct os_mbuf *txpdu, struct ble_ll_conn_sm *connsm);
 int ble_ll_ctrl_is_start_enc_rsp(struct os_mbuf *txpdu);
 
 void ble_ll_hci_ev_datalen_chg(struct ble_ll_conn_sm *connsm);
+void ble_ll_hci_ev_phy_update(struct ble_ll_conn_sm *connsm, uint8_t status);
 void ble_ll_hci_ev_rem_conn_parm_req(struct ble_ll_conn_sm *connsm,
                                      struct ble_ll_conn_params *cp);
 void ble_ll_hci_ev_conn_update(struct ble_ll_conn_sm *connsm, uint8_t status);
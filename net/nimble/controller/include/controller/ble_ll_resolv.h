@@ -91,6 +91,12 @@ uint32_t ble_ll_resolv_get_rpa_tmo(void);
 /* Resolve a resolvable private address */
 int ble_ll_resolv_rpa(uint8_t *rpa, uint8_t *irk);
 
+/*
+ * Get resolving list index of a received peer RPA; uses the hardware result
+ * or the cache of recently resolved RPAs. Returns -1 if not resolved.
+ */
+int ble_ll_resolv_peer_rpa_match(uint8_t *rpa);
+
 /* Initialize resolv*/
 void ble_ll_resolv_init(void);
 
@@ -99,6 +99,10 @@ int ble_ll_scan_set_scan_params(uint8_t *cmd);
 /* Turn scanning on/off */
 int ble_ll_scan_set_enable(uint8_t *cmd);
 
+/* Vendor specific advertising report filter command */
+int ble_ll_scan_rpt_filt_cmd(uint8_t *cmdbuf, uint8_t cmdlen, uint8_t *rspbuf,
+                             uint8_t *rsplen);
+
 /*--- Controller Internal API ---*/
 /* Initialize the scanner */
 void ble_ll_scan_init(void);
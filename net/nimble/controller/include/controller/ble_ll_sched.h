@@ -73,6 +73,10 @@ extern uint8_t g_ble_ll_sched_offset_ticks;
 #define BLE_LL_SCHED_TYPE_SCAN      (2)
 #define BLE_LL_SCHED_TYPE_CONN      (3)
 
+/* Policies for placing new master connections (BLE_LL_SCHED_MASTER_POLICY) */
+#define BLE_LL_SCHED_POLICY_FIRST_FIT   (0)
+#define BLE_LL_SCHED_POLICY_PACKED      (1)
+
 /* Return values for schedule callback. */
 #define BLE_LL_SCHED_STATE_RUNNING  (0)
 #define BLE_LL_SCHED_STATE_DONE     (1)
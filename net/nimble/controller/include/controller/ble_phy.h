@@ -50,6 +50,10 @@ struct os_mbuf;
 /* Data rate */
 #define BLE_PHY_BIT_RATE_BPS        (1000000)
 
+/* PHY modes. NOTE: these match the PHY values used by HCI */
+#define BLE_PHY_MODE_1M             (1)
+#define BLE_PHY_MODE_2M             (2)
+
 /* Macros */
 #define BLE_IS_ADV_CHAN(chan)       (chan >= BLE_PHY_ADV_CHAN_START)
 #define BLE_IS_DATA_CHAN(chan)      (chan < BLE_PHY_ADV_CHAN_START)
@@ -110,6 +114,9 @@ int ble_phy_rx(void);
 /* Copies the received PHY buffer into the allocated pdu */
 void ble_phy_rxpdu_copy(uint8_t *dptr, struct os_mbuf *rxpdu);
 
+/* Takes the mbuf the current pdu was received into (NULL if none) */
+struct os_mbuf *ble_phy_rxpdu_take(uint16_t len);
+
 /* Get an RSSI reading */
 int ble_phy_rssi_get(void);
 
@@ -179,6 +186,9 @@ void ble_phy_resolv_list_enable(void);
 /* Disable phy resolving list */
 void ble_phy_resolv_list_disable(void);
 
+/* Set the PHY mode (BLE_PHY_MODE_xxx) used for transmit and receive */
+int ble_phy_mode_set(uint8_t phy_mode);
+
 #ifdef __cplusplus
 }
 #endif
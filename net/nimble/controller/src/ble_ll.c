@@ -175,6 +175,7 @@ STATS_NAME_START(ble_ll_stats)
     STATS_NAME(ble_ll_stats, adv_late_starts)
     STATS_NAME(ble_ll_stats, sched_state_conn_errs)
     STATS_NAME(ble_ll_stats, sched_state_adv_errs)
+    STATS_NAME(ble_ll_stats, sched_adv_packed)
     STATS_NAME(ble_ll_stats, scan_starts)
     STATS_NAME(ble_ll_stats, scan_stops)
     STATS_NAME(ble_ll_stats, scan_req_txf)
@@ -289,6 +290,14 @@ ble_ll_rxpdu_alloc(uint16_t len)
     struct os_mbuf *p;
     struct os_mbuf_pkthdr *pkthdr;
 
+#if MYNEWT_VAL(BLE_PHY_RX_ZERO_COPY)
+    /* Use the mbuf the phy received into; the pdu copy is then skipped */
+    p = ble_phy_rxpdu_take(len);
+    if (p) {
+        goto rxpdu_alloc_exit;
+    }
+#endif
+
     p = os_msys_get_pkthdr(len, sizeof(struct ble_mbuf_hdr));
     if (!p) {
         goto rxpdu_alloc_exit;
@@ -785,7 +794,7 @@ ble_ll_hw_err_timer_cb(struct os_event *ev)
  *   = 0: Continue to receive frame. Dont go from rx to tx
  *   > 0: Continue to receive frame and go from rx to tx when done
  */
-int
+BLE_LL_RAMFUNC int
 ble_ll_rx_start(uint8_t *rxbuf, uint8_t chan, struct ble_mbuf_hdr *rxhdr)
 {
     int rc;
@@ -797,6 +806,7 @@ ble_ll_rx_start(uint8_t *rxbuf, uint8_t chan, struct ble_mbuf_hdr *rxhdr)
 #else
     ble_ll_log(BLE_LL_LOG_ID_RX_START, chan, 0, rxhdr->beg_cputime);
 #endif
+    os_trace_event(BLE_LL_TRACE_ID_RX_START, chan);
 
     /* Check channel type */
     if (chan < BLE_PHY_NUM_DATA_CHANS) {
@@ -859,7 +869,7 @@ ble_ll_rx_start(uint8_t *rxbuf, uint8_t chan, struct ble_mbuf_hdr *rxhdr)
  *      == 0: Success. Do not disable the PHY.
  *       > 0: Do not disable PHY as that has already been done.
  */
-int
+BLE_LL_RAMFUNC int
 ble_ll_rx_end(uint8_t *rxbuf, struct ble_mbuf_hdr *rxhdr)
 {
     int rc;
@@ -877,6 +887,7 @@ ble_ll_rx_end(uint8_t *rxbuf, struct ble_mbuf_hdr *rxhdr)
     ble_ll_log(BLE_LL_LOG_ID_RX_END, rxbuf[0],
                ((uint16_t)rxhdr->rxinfo.flags << 8) | rxbuf[1],
                rxhdr->beg_cputime);
+    os_trace_event(BLE_LL_TRACE_ID_RX_END, (rxbuf[0] << 8) | rxbuf[1]);
 
     /* Check channel type */
     if (chan < BLE_PHY_NUM_DATA_CHANS) {
@@ -1071,9 +1082,9 @@ ble_ll_read_supp_states(void)
 /**
  * Returns the features supported by the link layer
  *
- * @return uint8_t bitmask of supported features.
+ * @return uint32_t bitmask of supported features.
  */
-uint8_t
+uint32_t
 ble_ll_read_supp_features(void)
 {
     return g_ble_ll_data.ll_supp_features;
@@ -1220,6 +1231,7 @@ ble_ll_seed_prng(void)
         seed <<= 8;
     }
     srand(seed);
+    ble_ll_rand_seed(seed);
 }
 
 /**
@@ -1231,7 +1243,7 @@ void
 ble_ll_init(void)
 {
     int rc;
-    uint8_t features;
+    uint32_t features;
 #ifdef BLE_XCVR_RFCLK
     uint32_t xtal_ticks;
 #endif
@@ -1339,6 +1351,14 @@ ble_ll_init(void)
     features |= BLE_LL_FEAT_LE_PING;
 #endif
 
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_2M_PHY) == 1)
+    features |= BLE_LL_FEAT_LE_2M_PHY;
+#endif
+
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_CSA2) == 1)
+    features |= BLE_LL_FEAT_CSA2;
+#endif
+
     /* Initialize random number generation */
     ble_ll_rand_init();
 
@@ -282,6 +282,14 @@ ble_ll_adv_pdu_make(struct ble_ll_adv_sm *advsm, struct os_mbuf *m)
         pdu_type |= BLE_ADV_PDU_HDR_TXADD_RAND;
     }
 
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_CSA2) == 1)
+    /* Indicate channel selection algorithm #2 on connectable PDUs */
+    if ((advsm->adv_type == BLE_HCI_ADV_TYPE_ADV_IND) ||
+        advsm->adv_directed) {
+        pdu_type |= BLE_ADV_PDU_HDR_CHSEL_MASK;
+    }
+#endif
+
     /* Get the advertising PDU and initialize it*/
     ble_ll_mbuf_init(m, pdulen, pdu_type);
 
@@ -429,6 +437,11 @@ ble_ll_adv_tx_start_cb(struct ble_ll_sched_item *sch)
     rc = ble_phy_setchan(advsm->adv_chan, 0, 0);
     assert(rc == 0);
 
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_2M_PHY) == 1)
+    /* Advertising always uses the 1M PHY */
+    ble_phy_mode_set(BLE_PHY_MODE_1M);
+#endif
+
     /* Set transmit start time. */
 #if MYNEWT_VAL(OS_CPUTIME_FREQ) == 32768
     txstart = sch->start_time + g_ble_ll_sched_offset_ticks;
@@ -1176,7 +1189,7 @@ ble_ll_adv_rx_req(uint8_t pdu_type, struct os_mbuf *rxpdu)
 
 #if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PRIVACY) == 1)
     if (ble_ll_is_rpa(peer, txadd) && ble_ll_resolv_enabled()) {
-        advsm->adv_rpa_index = ble_hw_resolv_list_match();
+        advsm->adv_rpa_index = ble_ll_resolv_peer_rpa_match(peer);
         if (advsm->adv_rpa_index >= 0) {
             ble_hdr->rxinfo.flags |= BLE_MBUF_HDR_F_RESOLVED;
             if (chk_wl) {
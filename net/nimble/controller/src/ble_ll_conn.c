@@ -195,6 +195,11 @@ STATS_SECT_START(ble_ll_conn_stats)
     STATS_SECT_ENTRY(tx_l2cap_bytes)
     STATS_SECT_ENTRY(tx_empty_pdus)
     STATS_SECT_ENTRY(mic_failures)
+    STATS_SECT_ENTRY(conn_events)
+    STATS_SECT_ENTRY(conn_ev_pdus)
+    STATS_SECT_ENTRY(conn_ev_multi_pdu)
+    STATS_SECT_ENTRY(conn_ev_extended)
+    STATS_SECT_ENTRY(chan_assess_upds)
 STATS_SECT_END
 STATS_SECT_DECL(ble_ll_conn_stats) ble_ll_conn_stats;
 
@@ -225,6 +230,11 @@ STATS_NAME_START(ble_ll_conn_stats)
     STATS_NAME(ble_ll_conn_stats, tx_l2cap_bytes)
     STATS_NAME(ble_ll_conn_stats, tx_empty_pdus)
     STATS_NAME(ble_ll_conn_stats, mic_failures)
+    STATS_NAME(ble_ll_conn_stats, conn_events)
+    STATS_NAME(ble_ll_conn_stats, conn_ev_pdus)
+    STATS_NAME(ble_ll_conn_stats, conn_ev_multi_pdu)
+    STATS_NAME(ble_ll_conn_stats, conn_ev_extended)
+    STATS_NAME(ble_ll_conn_stats, chan_assess_upds)
 STATS_NAME_END(ble_ll_conn_stats)
 
 static void ble_ll_conn_event_end(struct os_event *ev);
@@ -475,6 +485,184 @@ ble_ll_conn_calc_used_chans(uint8_t *chmap)
     return used_channels;
 }
 
+#if MYNEWT_VAL(BLE_LL_CONN_CHAN_ASSESS)
+/*
+ * Data channel assessment. Received PDUs and CRC errors are counted per data
+ * channel across all connections; once every assessment period channels with
+ * a high error rate are held out of the master channel map for a number of
+ * periods. The counters are halved every period so old samples age out.
+ */
+struct ble_ll_conn_chan_assess
+{
+    uint16_t rx_pdus[BLE_PHY_NUM_DATA_CHANS];
+    uint16_t crc_errs[BLE_PHY_NUM_DATA_CHANS];
+    uint8_t hold[BLE_PHY_NUM_DATA_CHANS];
+    uint8_t num_used_chans;
+    uint8_t chanmap[BLE_LL_CONN_CHMAP_LEN];
+    os_time_t last_eval;
+};
+
+static struct ble_ll_conn_chan_assess g_ble_ll_conn_chan_assess;
+
+/**
+ * Resets channel assessment; the effective channel map becomes the host
+ * channel map.
+ */
+static void
+ble_ll_conn_chan_assess_reset(void)
+{
+    struct ble_ll_conn_chan_assess *ca;
+    os_sr_t sr;
+
+    ca = &g_ble_ll_conn_chan_assess;
+
+    OS_ENTER_CRITICAL(sr);
+    memset(ca, 0, sizeof(*ca));
+    OS_EXIT_CRITICAL(sr);
+
+    ca->num_used_chans = g_ble_ll_conn_params.num_used_chans;
+    memcpy(ca->chanmap, g_ble_ll_conn_params.master_chan_map,
+           BLE_LL_CONN_CHMAP_LEN);
+    ca->last_eval = os_time_get();
+}
+
+/**
+ * Count a received data channel PDU.
+ *
+ * Context: Interrupt
+ *
+ * @param chan  Data channel index
+ * @param crcok Whether the PDU passed the CRC check
+ */
+static void
+ble_ll_conn_chan_assess_sample(uint8_t chan, int crcok)
+{
+    struct ble_ll_conn_chan_assess *ca;
+
+    ca = &g_ble_ll_conn_chan_assess;
+    if (ca->rx_pdus[chan] != UINT16_MAX) {
+        ++ca->rx_pdus[chan];
+        if (!crcok) {
+            ++ca->crc_errs[chan];
+        }
+    }
+}
+
+/**
+ * Evaluates the channel statistics if an assessment period has elapsed. If
+ * the resulting channel map differs from the one in use, a channel map
+ * update is started on all connections in which we are master.
+ *
+ * Context: Link Layer task
+ */
+static void
+ble_ll_conn_chan_assess_chk(void)
+{
+    int i;
+    int min_i;
+    uint8_t chanmap[BLE_LL_CONN_CHMAP_LEN];
+    uint8_t num_used_chans;
+    uint8_t *host_map;
+    uint32_t period;
+    struct ble_ll_conn_sm *connsm;
+    struct ble_ll_conn_chan_assess *ca;
+    os_sr_t sr;
+
+    ca = &g_ble_ll_conn_chan_assess;
+    period = MYNEWT_VAL(BLE_LL_CONN_CHAN_ASSESS_PERIOD_MS) * OS_TICKS_PER_SEC /
+             1000;
+    if ((int32_t)(os_time_get() - (ca->last_eval + period)) < 0) {
+        return;
+    }
+    ca->last_eval = os_time_get();
+
+    /* Age out held channels and mark channels with high error rates bad */
+    OS_ENTER_CRITICAL(sr);
+    for (i = 0; i < BLE_PHY_NUM_DATA_CHANS; ++i) {
+        if (ca->hold[i]) {
+            --ca->hold[i];
+        }
+        if ((ca->rx_pdus[i] >= MYNEWT_VAL(BLE_LL_CONN_CHAN_ASSESS_MIN_PDUS)) &&
+            ((uint32_t)ca->crc_errs[i] * 100 >=
+             (uint32_t)ca->rx_pdus[i] *
+             MYNEWT_VAL(BLE_LL_CONN_CHAN_ASSESS_ERR_PCT))) {
+            ca->hold[i] = MYNEWT_VAL(BLE_LL_CONN_CHAN_ASSESS_HOLD);
+            ca->rx_pdus[i] = 0;
+            ca->crc_errs[i] = 0;
+        } else {
+            ca->rx_pdus[i] >>= 1;
+            ca->crc_errs[i] >>= 1;
+        }
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    /* Effective map is the host map minus held channels */
+    host_map = g_ble_ll_conn_params.master_chan_map;
+    memcpy(chanmap, host_map, BLE_LL_CONN_CHMAP_LEN);
+    for (i = 0; i < BLE_PHY_NUM_DATA_CHANS; ++i) {
+        if (ca->hold[i]) {
+            chanmap[i >> 3] &= ~(1 << (i & 0x07));
+        }
+    }
+    num_used_chans = ble_ll_conn_calc_used_chans(chanmap);
+
+    /* Re-admit the channels closest to the end of their hold if needed */
+    while (num_used_chans < MYNEWT_VAL(BLE_LL_CONN_CHAN_ASSESS_MIN_CHANS)) {
+        min_i = -1;
+        for (i = 0; i < BLE_PHY_NUM_DATA_CHANS; ++i) {
+            if (ca->hold[i] && (host_map[i >> 3] & (1 << (i & 0x07))) &&
+                ((min_i < 0) || (ca->hold[i] < ca->hold[min_i]))) {
+                min_i = i;
+            }
+        }
+        if (min_i < 0) {
+            break;
+        }
+        ca->hold[min_i] = 0;
+        chanmap[min_i >> 3] |= 1 << (min_i & 0x07);
+        ++num_used_chans;
+    }
+
+    if (!memcmp(ca->chanmap, chanmap, BLE_LL_CONN_CHMAP_LEN)) {
+        return;
+    }
+    memcpy(ca->chanmap, chanmap, BLE_LL_CONN_CHMAP_LEN);
+    ca->num_used_chans = num_used_chans;
+    STATS_INC(ble_ll_conn_stats, chan_assess_upds);
+
+    SLIST_FOREACH(connsm, &g_ble_ll_conn_active_list, act_sle) {
+        if (connsm->conn_role == BLE_LL_CONN_ROLE_MASTER) {
+            ble_ll_ctrl_proc_start(connsm, BLE_LL_CTRL_PROC_CHAN_MAP_UPD);
+        }
+    }
+}
+#endif
+
+/**
+ * Returns the channel map to use, as master, for new connections and
+ * channel map updates. This is the host channel map, less any channels
+ * removed by channel assessment.
+ *
+ * @param num_used_chans Filled with the number of used channels (may be NULL)
+ *
+ * @return uint8_t* Pointer to channel map
+ */
+uint8_t *
+ble_ll_conn_get_master_chanmap(uint8_t *num_used_chans)
+{
+#if MYNEWT_VAL(BLE_LL_CONN_CHAN_ASSESS)
+    if (num_used_chans) {
+        *num_used_chans = g_ble_ll_conn_chan_assess.num_used_chans;
+    }
+    return g_ble_ll_conn_chan_assess.chanmap;
+#else
+    if (num_used_chans) {
+        *num_used_chans = g_ble_ll_conn_params.num_used_chans;
+    }
+    return g_ble_ll_conn_params.master_chan_map;
+#endif
+}
+
 static uint32_t
 ble_ll_conn_calc_access_addr(void)
 {
@@ -492,8 +680,8 @@ ble_ll_conn_calc_access_addr(void)
     aa = 0;
     while (1) {
         /* Get two, 16-bit random numbers */
-        aa_low = rand() & 0xFFFF;
-        aa_high = rand() & 0xFFFF;
+        aa_low = ble_ll_rand() & 0xFFFF;
+        aa_high = ble_ll_rand() & 0xFFFF;
 
         /* All four bytes cannot be equal */
         if (aa_low == aa_high) {
@@ -563,6 +751,115 @@ ble_ll_conn_calc_access_addr(void)
     return aa;
 }
 
+/**
+ * Returns the used channel at position 'remap_index' in the channel map (i.e.
+ * the remap_index'th channel, counting from 0, whose bit is set).
+ *
+ * @param remap_index
+ * @param chanmap
+ *
+ * @return uint8_t
+ */
+static uint8_t
+ble_ll_conn_remapped_channel(uint8_t remap_index, const uint8_t *chanmap)
+{
+    int     i;
+    int     j;
+    uint8_t chan;
+    uint8_t cntr;
+    uint8_t mask;
+    uint8_t usable_chans;
+
+    /* NOTE: possible to build a map but this would use memory. For now,
+       we just calculate */
+    /* Iterate through channel map to find this channel */
+    chan = 0;
+    cntr = 0;
+    for (i = 0; i < BLE_LL_CONN_CHMAP_LEN; i++) {
+        usable_chans = chanmap[i];
+        if (usable_chans != 0) {
+            mask = 0x01;
+            for (j = 0; j < 8; j++) {
+                if (usable_chans & mask) {
+                    if (cntr == remap_index) {
+                        return (chan + j);
+                    }
+                    ++cntr;
+                }
+                mask <<= 1;
+            }
+        }
+        chan += 8;
+    }
+
+    /* Not reached with a valid channel map */
+    return 0;
+}
+
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_CSA2) == 1)
+/*
+ * Channel selection algorithm #2 permutation: reverses the bit order within
+ * each byte of a 16-bit value (Core v5.0 Vol 6, Part B, 4.5.8.3.2).
+ */
+static uint16_t
+ble_ll_conn_csa2_perm(uint16_t in)
+{
+    uint16_t out;
+    int i;
+
+    out = 0;
+    for (i = 0; i < 8; i++) {
+        out |= ((in >> i) & 0x0101) << (7 - i);
+    }
+
+    return out;
+}
+
+/* Unmapped event channel pseudo-random number, prn_e */
+static uint16_t
+ble_ll_conn_csa2_prn_e(uint16_t counter, uint16_t chan_id)
+{
+    uint16_t prn;
+    int i;
+
+    prn = counter ^ chan_id;
+    for (i = 0; i < 3; i++) {
+        prn = ble_ll_conn_csa2_perm(prn);
+        prn = (17 * prn) + chan_id;
+    }
+
+    return prn ^ chan_id;
+}
+
+/**
+ * Determine data channel index to be used for the upcoming/current
+ * connection event using channel selection algorithm #2. The event counter
+ * must already be set to the counter of that event.
+ *
+ * @param conn
+ *
+ * @return uint8_t
+ */
+static uint8_t
+ble_ll_conn_calc_dci_csa2(struct ble_ll_conn_sm *conn)
+{
+    uint16_t prn_e;
+    uint8_t curchan;
+    uint8_t remap_index;
+
+    prn_e = ble_ll_conn_csa2_prn_e(conn->event_cntr, conn->channel_id);
+    curchan = prn_e % BLE_PHY_NUM_DATA_CHANS;
+    conn->unmapped_chan = curchan;
+
+    if ((conn->chanmap[curchan >> 3] & (1 << (curchan & 0x07))) == 0) {
+        remap_index = ((uint32_t)conn->num_used_chans * prn_e) >> 16;
+        curchan = ble_ll_conn_remapped_channel(remap_index, conn->chanmap);
+    }
+
+    return curchan;
+}
+#endif
+
 /**
  * Determine data channel index to be used for the upcoming/current
  * connection event
@@ -574,15 +871,9 @@ ble_ll_conn_calc_access_addr(void)
 uint8_t
 ble_ll_conn_calc_dci(struct ble_ll_conn_sm *conn)
 {
-    int     i;
-    int     j;
-    uint8_t chan;
     uint8_t curchan;
     uint8_t remap_index;
     uint8_t bitpos;
-    uint8_t cntr;
-    uint8_t mask;
-    uint8_t usable_chans;
 
     /* Get next unmapped channel */
     curchan = conn->last_unmapped_chan + conn->hop_inc;
@@ -599,28 +890,7 @@ ble_ll_conn_calc_dci(struct ble_ll_conn_sm *conn)
 
         /* Calculate remap index */
         remap_index = curchan % conn->num_used_chans;
-
-        /* NOTE: possible to build a map but this would use memory. For now,
-           we just calculate */
-        /* Iterate through channel map to find this channel */
-        chan = 0;
-        cntr = 0;
-        for (i = 0; i < BLE_LL_CONN_CHMAP_LEN; i++) {
-            usable_chans = conn->chanmap[i];
-            if (usable_chans != 0) {
-                mask = 0x01;
-                for (j = 0; j < 8; j++) {
-                    if (usable_chans & mask) {
-                        if (cntr == remap_index) {
-                            return (chan + j);
-                        }
-                        ++cntr;
-                    }
-                    mask <<= 1;
-                }
-            }
-            chan += 8;
-        }
+        curchan = ble_ll_conn_remapped_channel(remap_index, conn->chanmap);
     }
 
     return curchan;
@@ -807,6 +1077,15 @@ ble_ll_conn_chk_csm_flags(struct ble_ll_conn_sm *connsm)
         ble_ll_hci_ev_conn_update(connsm, update_status);
         connsm->csmflags.cfbit.host_expects_upd_event = 0;
     }
+
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_2M_PHY) == 1)
+    /* The PHY changed or the host asked for the PHY update procedure */
+    if (CONN_F_PHY_UPDATE_EVENT(connsm)) {
+        ble_ll_hci_ev_phy_update(connsm, BLE_ERR_SUCCESS);
+        CONN_F_PHY_UPDATE_EVENT(connsm) = 0;
+        CONN_F_HOST_PHY_UPDATE(connsm) = 0;
+    }
+#endif
 }
 
 /**
@@ -978,8 +1257,8 @@ ble_ll_conn_tx_data_pdu(struct ble_ll_conn_sm *connsm)
          * received a frame and we are replying to it.
          */
         ticks = (BLE_LL_IFS * 3) + connsm->eff_max_rx_time +
-                BLE_TX_DUR_USECS_M(next_txlen) +
-                BLE_TX_DUR_USECS_M(cur_txlen);
+                BLE_TX_DUR_USECS_PHY(next_txlen, connsm->phy_data.cur_tx_phy) +
+                BLE_TX_DUR_USECS_PHY(cur_txlen, connsm->phy_data.cur_tx_phy);
 
         if (connsm->conn_role == BLE_LL_CONN_ROLE_MASTER) {
             ticks += (BLE_LL_IFS + connsm->eff_max_rx_time);
@@ -1151,6 +1430,18 @@ conn_tx_pdu:
             STATS_INC(ble_ll_conn_stats, tx_l2cap_pdus);
             STATS_INCN(ble_ll_conn_stats, tx_l2cap_bytes, cur_txlen);
         }
+
+        /*
+         * Count the PDUs sent in this connection event and note if the
+         * event has been extended past the slots reserved for it; this
+         * happens when the scheduler has nothing else to run.
+         */
+        if (!CONN_F_EMPTY_PDU_TXD(connsm) && (connsm->ce_txd_pdus != 0xFF)) {
+            ++connsm->ce_txd_pdus;
+        }
+        if (CPUTIME_GT(os_cputime_get32(), connsm->ce_end_time)) {
+            connsm->ce_extended = 1;
+        }
     }
     return rc;
 }
@@ -1196,6 +1487,11 @@ ble_ll_conn_event_start_cb(struct ble_ll_sched_item *sch)
     ble_phy_setchan(connsm->data_chan_index, connsm->access_addr,
                     connsm->crcinit);
 
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_2M_PHY) == 1)
+    /* Set the PHY used by the connection (same in both directions) */
+    ble_phy_mode_set(connsm->phy_data.cur_tx_phy);
+#endif
+
 #if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PRIVACY)
     ble_phy_resolv_list_disable();
 #endif
@@ -1360,10 +1656,11 @@ ble_ll_conn_can_send_next_pdu(struct ble_ll_conn_sm *connsm, uint32_t begtime,
             if (rem_bytes > connsm->eff_max_tx_octets) {
                 rem_bytes = connsm->eff_max_tx_octets;
             }
-            usecs = BLE_TX_DUR_USECS_M(rem_bytes);
+            usecs = BLE_TX_DUR_USECS_PHY(rem_bytes,
+                                         connsm->phy_data.cur_tx_phy);
         } else {
             /* We will send empty pdu (just a LL header) */
-            usecs = BLE_TX_DUR_USECS_M(0);
+            usecs = BLE_TX_DUR_USECS_PHY(0, connsm->phy_data.cur_tx_phy);
         }
         usecs += (BLE_LL_IFS * 2) + connsm->eff_max_rx_time;
 
@@ -1452,7 +1749,7 @@ ble_ll_conn_master_init(struct ble_ll_conn_sm *connsm,
     connsm->master_sca = MYNEWT_VAL(BLE_LL_MASTER_SCA);
 
     /* Hop increment is a random value between 5 and 16. */
-    connsm->hop_inc = (rand() % 12) + 5;
+    connsm->hop_inc = (ble_ll_rand() % 12) + 5;
 
     /* Set slave latency and supervision timeout */
     connsm->slave_latency = hcc->conn_latency;
@@ -1481,14 +1778,14 @@ ble_ll_conn_master_init(struct ble_ll_conn_sm *connsm,
         connsm->max_ce_len = hcc->max_ce_len;
     }
 
-    /* Set channel map to map requested by host */
-    connsm->num_used_chans = g_ble_ll_conn_params.num_used_chans;
-    memcpy(connsm->chanmap, g_ble_ll_conn_params.master_chan_map,
+    /* Set channel map to map requested by host (less assessed bad ones) */
+    memcpy(connsm->chanmap,
+           ble_ll_conn_get_master_chanmap(&connsm->num_used_chans),
            BLE_LL_CONN_CHMAP_LEN);
 
     /*  Calculate random access address and crc initialization value */
     connsm->access_addr = ble_ll_conn_calc_access_addr();
-    connsm->crcinit = rand() & 0xffffff;
+    connsm->crcinit = ble_ll_rand() & 0xffffff;
 
     /* Set initial schedule callback */
     connsm->conn_sch.sched_cb = ble_ll_conn_event_start_cb;
@@ -1548,6 +1845,8 @@ ble_ll_conn_sm_new(struct ble_ll_conn_sm *connsm)
     connsm->next_exp_seqnum = 0;
     connsm->cons_rxd_bad_crc = 0;
     connsm->last_rxd_sn = 1;
+    connsm->ce_txd_pdus = 0;
+    connsm->ce_extended = 0;
     connsm->completed_pkts = 0;
 
     /* initialize data length mgmt */
@@ -1565,6 +1864,14 @@ ble_ll_conn_sm_new(struct ble_ll_conn_sm *connsm)
     connsm->eff_max_tx_octets = BLE_LL_CONN_SUPP_BYTES_MIN;
     connsm->eff_max_rx_octets = BLE_LL_CONN_SUPP_BYTES_MIN;
 
+    /* All connections start on the 1M PHY */
+    connsm->phy_data.cur_tx_phy = BLE_PHY_MODE_1M;
+    connsm->phy_data.cur_rx_phy = BLE_PHY_MODE_1M;
+    connsm->phy_data.new_tx_phy = BLE_PHY_MODE_1M;
+    connsm->phy_data.new_rx_phy = BLE_PHY_MODE_1M;
+    connsm->phy_data.host_pref_tx_phys = conn_params->def_tx_phys;
+    connsm->phy_data.host_pref_rx_phys = conn_params->def_rx_phys;
+
     /* Reset encryption data */
 #if MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_ENCRYPTION)
     memset(&connsm->enc_data, 0, sizeof(struct ble_ll_conn_enc_data));
@@ -1751,6 +2058,7 @@ ble_ll_conn_next_event(struct ble_ll_conn_sm *connsm)
     latency = 1;
     if (connsm->csmflags.cfbit.allow_slave_latency      &&
         !connsm->csmflags.cfbit.conn_update_sched       &&
+        !connsm->csmflags.cfbit.phy_update_sched        &&
         !connsm->csmflags.cfbit.chanmap_update_scheduled) {
         if (connsm->csmflags.cfbit.pkt_rxd) {
             latency += connsm->slave_latency;
@@ -1859,7 +2167,29 @@ ble_ll_conn_next_event(struct ble_ll_conn_sm *connsm)
            check to make sure we dont have to restart! */
     }
 
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_2M_PHY) == 1)
+    /*
+     * If a PHY update is scheduled and we have reached the instant, switch
+     * to the new PHY. As with the channel map, the instant may already have
+     * been passed by the time we get here.
+     */
+    if (CONN_F_PHY_UPDATE_SCHED(connsm) &&
+        ((int16_t)(connsm->phy_data.phy_instant - connsm->event_cntr) <= 0)) {
+        connsm->phy_data.cur_tx_phy = connsm->phy_data.new_tx_phy;
+        connsm->phy_data.cur_rx_phy = connsm->phy_data.new_rx_phy;
+        CONN_F_PHY_UPDATE_SCHED(connsm) = 0;
+        CONN_F_PHY_UPDATE_EVENT(connsm) = 1;
+        ble_ll_ctrl_proc_stop(connsm, BLE_LL_CTRL_PROC_PHY_UPDATE);
+    }
+#endif
+
     /* Calculate data channel index of next connection event */
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_CSA2) == 1)
+    if (CONN_F_CSA2_SUPP(connsm)) {
+        connsm->data_chan_index = ble_ll_conn_calc_dci_csa2(connsm);
+        latency = 0;
+    }
+#endif
     while (latency > 0) {
         connsm->last_unmapped_chan = connsm->unmapped_chan;
         connsm->data_chan_index = ble_ll_conn_calc_dci(connsm);
@@ -1952,6 +2282,18 @@ ble_ll_conn_created(struct ble_ll_conn_sm *connsm, struct ble_mbuf_hdr *rxhdr)
      */
     connsm->last_rxd_pdu_cputime = connsm->last_scheduled;
 
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_CSA2) == 1)
+    /*
+     * Both sides agreed on channel selection algorithm #2; the channel for
+     * the first connection event was calculated with #1 so redo it.
+     */
+    if (CONN_F_CSA2_SUPP(connsm)) {
+        connsm->channel_id = (connsm->access_addr >> 16) ^
+                             (connsm->access_addr & 0xffff);
+        connsm->data_chan_index = ble_ll_conn_calc_dci_csa2(connsm);
+    }
+#endif
+
     /*
      * Set first connection event time. If slave the endtime is the receive end
      * time of the connect request. The actual connection starts 1.25 msecs plus
@@ -2083,6 +2425,16 @@ ble_ll_conn_event_end(struct os_event *ev)
     /* Remove any connection end events that might be enqueued */
     os_eventq_remove(&g_ble_ll_data.ll_evq, &connsm->conn_ev_end);
 
+    /* Update packets per connection event statistics */
+    STATS_INC(ble_ll_conn_stats, conn_events);
+    STATS_INCN(ble_ll_conn_stats, conn_ev_pdus, connsm->ce_txd_pdus);
+    if (connsm->ce_txd_pdus > 1) {
+        STATS_INC(ble_ll_conn_stats, conn_ev_multi_pdu);
+    }
+    if (connsm->ce_extended) {
+        STATS_INC(ble_ll_conn_stats, conn_ev_extended);
+    }
+
     /*
      * If we have received a packet, we can set the current transmit window
      * usecs to 0 since we dont need to listen in the transmit window.
@@ -2115,6 +2467,13 @@ ble_ll_conn_event_end(struct os_event *ev)
     /* Reset "per connection event" variables */
     connsm->cons_rxd_bad_crc = 0;
     connsm->csmflags.cfbit.pkt_rxd = 0;
+    connsm->ce_txd_pdus = 0;
+    connsm->ce_extended = 0;
+
+#if MYNEWT_VAL(BLE_LL_CONN_CHAN_ASSESS)
+    /* Periodically re-assess the data channels */
+    ble_ll_conn_chan_assess_chk();
+#endif
 
     /* See if we need to start any control procedures */
     ble_ll_ctrl_chk_proc_start(connsm);
@@ -2193,9 +2552,10 @@ ble_ll_conn_req_pdu_update(struct os_mbuf *m, uint8_t *adva, uint8_t addr_type,
 
     assert(m != NULL);
 
-    /* Retain pdu type but clear txadd/rxadd bits */
+    /* Retain pdu type and chsel but clear txadd/rxadd bits */
     ble_hdr = BLE_MBUF_HDR_PTR(m);
-    hdr = ble_hdr->txinfo.hdr_byte & BLE_ADV_PDU_HDR_TYPE_MASK;
+    hdr = ble_hdr->txinfo.hdr_byte &
+          (BLE_ADV_PDU_HDR_TYPE_MASK | BLE_ADV_PDU_HDR_CHSEL_MASK);
     if (addr_type) {
         /* Set random address */
         hdr |= BLE_ADV_PDU_HDR_RXADD_MASK;
@@ -2519,7 +2879,7 @@ ble_ll_init_rx_isr_end(uint8_t *rxbuf, uint8_t crcok,
 
 #if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PRIVACY)
         if (ble_ll_is_rpa(adv_addr, addr_type) && ble_ll_resolv_enabled()) {
-            index = ble_hw_resolv_list_match();
+            index = ble_ll_resolv_peer_rpa_match(adv_addr);
             if (index >= 0) {
                 ble_hdr->rxinfo.flags |= BLE_MBUF_HDR_F_RESOLVED;
                 connsm->rpa_index = index;
@@ -2559,6 +2919,11 @@ ble_ll_init_rx_isr_end(uint8_t *rxbuf, uint8_t crcok,
             }
         }
 
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_CSA2) == 1)
+        /* Use channel selection algorithm #2 if the advertiser supports it */
+        CONN_F_CSA2_SUPP(connsm) = !!(rxbuf[0] & BLE_ADV_PDU_HDR_CHSEL_MASK);
+#endif
+
         /* Attempt to schedule new connection. Possible that this might fail */
         if (!ble_ll_sched_master_new(connsm, ble_hdr, pyld_len)) {
             /* Setup to transmit the connect request */
@@ -2649,7 +3014,7 @@ ble_ll_conn_timeout(struct ble_ll_conn_sm *connsm, uint8_t ble_err)
  *
  * @param rxhdr
  */
-int
+BLE_LL_RAMFUNC int
 ble_ll_conn_rx_isr_start(struct ble_mbuf_hdr *rxhdr, uint32_t aa)
 {
     struct ble_ll_conn_sm *connsm;
@@ -2835,7 +3200,7 @@ conn_rx_data_pdu_end:
  *      == 0: Success. Do not disable the PHY.
  *       > 0: Do not disable PHY as that has already been done.
  */
-int
+BLE_LL_RAMFUNC int
 ble_ll_conn_rx_isr_end(uint8_t *rxbuf, struct ble_mbuf_hdr *rxhdr)
 {
     int rc;
@@ -2880,13 +3245,20 @@ ble_ll_conn_rx_isr_end(uint8_t *rxbuf, struct ble_mbuf_hdr *rxhdr)
         goto conn_exit;
     }
 
+#if MYNEWT_VAL(BLE_LL_CONN_CHAN_ASSESS)
+    ble_ll_conn_chan_assess_sample(connsm->data_chan_index,
+                                   BLE_MBUF_HDR_CRC_OK(rxhdr));
+#endif
+
     /* Calculate the end time of the received PDU */
 #if MYNEWT_VAL(OS_CPUTIME_FREQ) == 32768
     endtime = rxhdr->beg_cputime;
-    add_usecs = rxhdr->rem_usecs + BLE_TX_DUR_USECS_M(rx_pyld_len);
+    add_usecs = rxhdr->rem_usecs +
+        BLE_TX_DUR_USECS_PHY(rx_pyld_len, connsm->phy_data.cur_rx_phy);
 #else
     endtime = rxhdr->beg_cputime +
-        os_cputime_usecs_to_ticks(BLE_TX_DUR_USECS_M(rx_pyld_len));
+        os_cputime_usecs_to_ticks(BLE_TX_DUR_USECS_PHY(rx_pyld_len,
+                                            connsm->phy_data.cur_rx_phy));
     add_usecs = 0;
 #endif
 
@@ -3228,6 +3600,9 @@ ble_ll_conn_set_global_chanmap(uint8_t num_used_chans, uint8_t *chanmap)
     /* Change channel map and cause channel map update procedure to start */
     conn_params->num_used_chans = num_used_chans;
     memcpy(conn_params->master_chan_map, chanmap, BLE_LL_CONN_CHMAP_LEN);
+#if MYNEWT_VAL(BLE_LL_CONN_CHAN_ASSESS)
+    ble_ll_conn_chan_assess_reset();
+#endif
 
     /* Perform channel map update */
     SLIST_FOREACH(connsm, &g_ble_ll_conn_active_list, act_sle) {
@@ -3342,6 +3717,11 @@ ble_ll_conn_slave_start(uint8_t *rxbuf, uint8_t pat, struct ble_mbuf_hdr *rxhdr)
     connsm->conn_role = BLE_LL_CONN_ROLE_SLAVE;
     ble_ll_conn_sm_new(connsm);
 
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_CSA2) == 1)
+    /* Our connectable advertising PDUs always set chsel */
+    CONN_F_CSA2_SUPP(connsm) = !!(rxbuf[0] & BLE_ADV_PDU_HDR_CHSEL_MASK);
+#endif
+
     /* Set initial schedule callback */
     connsm->conn_sch.sched_cb = ble_ll_conn_event_start_cb;
     rc = ble_ll_conn_created(connsm, rxhdr);
@@ -3421,10 +3801,17 @@ ble_ll_conn_module_reset(void)
     conn_params->sugg_tx_octets = BLE_LL_CONN_SUPP_BYTES_MIN;
     conn_params->sugg_tx_time = BLE_LL_CONN_SUPP_TIME_MIN;
 
+    /* No PHY preference by default */
+    conn_params->def_tx_phys = BLE_HCI_LE_PHY_PREF_MASK_ALL;
+    conn_params->def_rx_phys = BLE_HCI_LE_PHY_PREF_MASK_ALL;
+
     /* Mask in all channels by default */
     conn_params->num_used_chans = BLE_PHY_NUM_DATA_CHANS;
     memset(conn_params->master_chan_map, 0xff, BLE_LL_CONN_CHMAP_LEN - 1);
     conn_params->master_chan_map[4] = 0x1f;
+#if MYNEWT_VAL(BLE_LL_CONN_CHAN_ASSESS)
+    ble_ll_conn_chan_assess_reset();
+#endif
 
     /* Reset statistics */
     STATS_RESET(ble_ll_conn_stats);
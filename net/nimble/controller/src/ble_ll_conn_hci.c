@@ -125,6 +125,9 @@ ble_ll_conn_req_pdu_make(struct ble_ll_conn_sm *connsm)
 
     /* Construct first PDU header byte */
     pdu_type = BLE_ADV_PDU_TYPE_CONNECT_REQ;
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_CSA2) == 1)
+    pdu_type |= BLE_ADV_PDU_HDR_CHSEL_MASK;
+#endif
 
     /* Set BLE transmit header */
     ble_ll_mbuf_init(m, BLE_CONNECT_REQ_LEN, pdu_type);
@@ -1018,6 +1021,146 @@ ble_ll_conn_hci_set_data_len(uint8_t *cmdbuf, uint8_t *rspbuf, uint8_t *rsplen)
 }
 #endif
 
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_2M_PHY) == 1)
+/**
+ * Checks the PHY preferences of a LE set default PHY or LE set PHY command.
+ * If the host has no preference for a direction, all PHYs are allowed.
+ *
+ * @param cmdbuf Pointer to the all_phys, tx_phys and rx_phys fields.
+ * @param tx_phys Transmit PHY preferences are written here.
+ * @param rx_phys Receive PHY preferences are written here.
+ *
+ * @return int BLE error code
+ */
+static int
+ble_ll_conn_hci_chk_phys(uint8_t *cmdbuf, uint8_t *tx_phys, uint8_t *rx_phys)
+{
+    uint8_t all_phys;
+    uint8_t supp_phys;
+
+    all_phys = cmdbuf[0];
+    *tx_phys = cmdbuf[1];
+    *rx_phys = cmdbuf[2];
+    supp_phys = BLE_HCI_LE_PHY_1M_PREF_MASK | BLE_HCI_LE_PHY_2M_PREF_MASK;
+
+    if (all_phys & BLE_HCI_LE_PHY_NO_TX_PREF_MASK) {
+        *tx_phys = supp_phys;
+    } else if (*tx_phys == 0) {
+        return BLE_ERR_INV_HCI_CMD_PARMS;
+    }
+
+    if (all_phys & BLE_HCI_LE_PHY_NO_RX_PREF_MASK) {
+        *rx_phys = supp_phys;
+    } else if (*rx_phys == 0) {
+        return BLE_ERR_INV_HCI_CMD_PARMS;
+    }
+
+    if ((*tx_phys & ~supp_phys) || (*rx_phys & ~supp_phys)) {
+        return BLE_ERR_UNSUPPORTED;
+    }
+
+    return BLE_ERR_SUCCESS;
+}
+
+/**
+ * LE read PHY command. Returns the PHYs currently used by a connection.
+ *
+ * @param cmdbuf
+ * @param rspbuf
+ * @param rsplen
+ *
+ * @return int BLE error code
+ */
+int
+ble_ll_conn_hci_le_rd_phy(uint8_t *cmdbuf, uint8_t *rspbuf, uint8_t *rsplen)
+{
+    int rc;
+    uint16_t handle;
+    struct ble_ll_conn_sm *connsm;
+
+    handle = get_le16(cmdbuf);
+    connsm = ble_ll_conn_find_active_conn(handle);
+    if (!connsm) {
+        rc = BLE_ERR_UNK_CONN_ID;
+        rspbuf[2] = 0;
+        rspbuf[3] = 0;
+    } else {
+        rc = BLE_ERR_SUCCESS;
+        rspbuf[2] = connsm->phy_data.cur_tx_phy;
+        rspbuf[3] = connsm->phy_data.cur_rx_phy;
+    }
+
+    put_le16(rspbuf, handle);
+    *rsplen = BLE_HCI_LE_RD_PHY_RSPLEN;
+    return rc;
+}
+
+/**
+ * LE set default PHY command. Sets the PHY preferences used for new
+ * connections.
+ *
+ * @param cmdbuf
+ *
+ * @return int BLE error code
+ */
+int
+ble_ll_conn_hci_le_set_default_phy(uint8_t *cmdbuf)
+{
+    int rc;
+    uint8_t tx_phys;
+    uint8_t rx_phys;
+
+    rc = ble_ll_conn_hci_chk_phys(cmdbuf, &tx_phys, &rx_phys);
+    if (!rc) {
+        g_ble_ll_conn_params.def_tx_phys = tx_phys;
+        g_ble_ll_conn_params.def_rx_phys = rx_phys;
+    }
+    return rc;
+}
+
+/**
+ * LE set PHY command. Sets the PHY preferences of a connection and starts
+ * the PHY update procedure. The PHY options are ignored as the coded PHY is
+ * not supported.
+ *
+ * @param cmdbuf
+ *
+ * @return int BLE error code
+ */
+int
+ble_ll_conn_hci_le_set_phy(uint8_t *cmdbuf)
+{
+    int rc;
+    uint8_t tx_phys;
+    uint8_t rx_phys;
+    uint16_t handle;
+    struct ble_ll_conn_sm *connsm;
+
+    handle = get_le16(cmdbuf);
+    connsm = ble_ll_conn_find_active_conn(handle);
+    if (!connsm) {
+        return BLE_ERR_UNK_CONN_ID;
+    }
+
+    rc = ble_ll_conn_hci_chk_phys(cmdbuf + 2, &tx_phys, &rx_phys);
+    if (rc) {
+        return rc;
+    }
+
+    /* Only one host initiated PHY update at a time */
+    if (CONN_F_HOST_PHY_UPDATE(connsm)) {
+        return BLE_ERR_CMD_DISALLOWED;
+    }
+
+    connsm->phy_data.host_pref_tx_phys = tx_phys;
+    connsm->phy_data.host_pref_rx_phys = rx_phys;
+    CONN_F_HOST_PHY_UPDATE(connsm) = 1;
+    ble_ll_ctrl_proc_start(connsm, BLE_LL_CTRL_PROC_PHY_UPDATE);
+
+    return BLE_ERR_SUCCESS;
+}
+#endif
+
 #if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_ENCRYPTION) == 1)
 /**
  * LE start encrypt command
@@ -74,6 +74,8 @@ struct ble_ll_conn_global_params
     uint16_t conn_init_max_tx_time;
     uint16_t supp_max_tx_time;
     uint16_t supp_max_rx_time;
+    uint8_t def_tx_phys;
+    uint8_t def_rx_phys;
 };
 extern struct ble_ll_conn_global_params g_ble_ll_conn_params;
 
@@ -112,8 +114,10 @@ void ble_ll_conn_module_init(void);
 void ble_ll_conn_set_global_chanmap(uint8_t num_used_chans, uint8_t *chanmap);
 void ble_ll_conn_module_reset(void);
 void ble_ll_conn_tx_pkt_in(struct os_mbuf *om, uint16_t handle, uint16_t len);
-int ble_ll_conn_rx_isr_start(struct ble_mbuf_hdr *rxhdr, uint32_t aa);
-int ble_ll_conn_rx_isr_end(uint8_t *rxbuf, struct ble_mbuf_hdr *rxhdr);
+BLE_LL_RAMFUNC int ble_ll_conn_rx_isr_start(struct ble_mbuf_hdr *rxhdr,
+                                            uint32_t aa);
+BLE_LL_RAMFUNC int ble_ll_conn_rx_isr_end(uint8_t *rxbuf,
+                                          struct ble_mbuf_hdr *rxhdr);
 void ble_ll_conn_rx_data_pdu(struct os_mbuf *rxpdu, struct ble_mbuf_hdr *hdr);
 void ble_ll_init_rx_pkt_in(uint8_t *rxbuf, struct ble_mbuf_hdr *ble_hdr);
 int ble_ll_init_rx_isr_end(uint8_t *rxbuf, uint8_t crcok,
@@ -123,6 +127,7 @@ int ble_ll_conn_is_lru(struct ble_ll_conn_sm *s1, struct ble_ll_conn_sm *s2);
 uint32_t ble_ll_conn_get_ce_end_time(void);
 void ble_ll_conn_event_halt(void);
 uint8_t ble_ll_conn_calc_used_chans(uint8_t *chmap);
+uint8_t *ble_ll_conn_get_master_chanmap(uint8_t *num_used_chans);
 
 /* HCI */
 void ble_ll_disconn_comp_event_send(struct ble_ll_conn_sm *connsm,
@@ -147,6 +152,10 @@ int ble_ll_conn_hci_rd_chan_map(uint8_t *cmdbuf, uint8_t *rspbuf,
                                 uint8_t *rsplen);
 int ble_ll_conn_hci_set_data_len(uint8_t *cmdbuf, uint8_t *rspbuf,
                                  uint8_t *rsplen);
+int ble_ll_conn_hci_le_rd_phy(uint8_t *cmdbuf, uint8_t *rspbuf,
+                              uint8_t *rsplen);
+int ble_ll_conn_hci_le_set_default_phy(uint8_t *cmdbuf);
+int ble_ll_conn_hci_le_set_phy(uint8_t *cmdbuf);
 int ble_ll_conn_hci_le_start_encrypt(uint8_t *cmdbuf);
 int ble_ll_conn_hci_le_ltk_reply(uint8_t *cmdbuf, uint8_t *rspbuf, uint8_t ocf);
 int ble_ll_conn_hci_wr_auth_pyld_tmo(uint8_t *cmdbuf, uint8_t *rsp,
@@ -27,6 +27,7 @@
 #include "controller/ble_ll_hci.h"
 #include "controller/ble_ll_ctrl.h"
 #include "controller/ble_hw.h"
+#include "controller/ble_phy.h"
 #include "ble_ll_conn_priv.h"
 
 /* To use spec sample data for testing */
@@ -79,7 +80,8 @@
  */
 const uint8_t g_ble_ll_ctrl_pkt_lengths[BLE_LL_CTRL_OPCODES] =
 {
-    11, 7, 1, 22, 12, 0, 0, 1, 8, 8, 0, 0, 5, 1, 8, 23, 23, 2, 0, 0, 8, 8
+    11, 7, 1, 22, 12, 0, 0, 1, 8, 8, 0, 0, 5, 1, 8, 23, 23, 2, 0, 0, 8, 8,
+    2, 2, 4
 };
 
 static int
@@ -312,6 +314,9 @@ ble_ll_ctrl_proc_unk_rsp(struct ble_ll_conn_sm *connsm, uint8_t *dptr)
 #endif
         ctrl_proc = BLE_LL_CTRL_PROC_LE_PING;
         break;
+    case BLE_LL_CTRL_PHY_REQ:
+        ctrl_proc = BLE_LL_CTRL_PROC_PHY_UPDATE;
+        break;
     default:
         ctrl_proc = BLE_LL_CTRL_PROC_NUM;
         break;
@@ -325,6 +330,13 @@ ble_ll_ctrl_proc_unk_rsp(struct ble_ll_conn_sm *connsm, uint8_t *dptr)
             ble_ll_hci_ev_conn_update(connsm, BLE_ERR_UNSUPP_REM_FEATURE);
         } else if (ctrl_proc == BLE_LL_CTRL_PROC_FEATURE_XCHG) {
             ble_ll_hci_ev_rd_rem_used_feat(connsm, BLE_ERR_UNSUPP_REM_FEATURE);
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_2M_PHY) == 1)
+        } else if (ctrl_proc == BLE_LL_CTRL_PROC_PHY_UPDATE) {
+            if (CONN_F_HOST_PHY_UPDATE(connsm)) {
+                ble_ll_hci_ev_phy_update(connsm, BLE_ERR_UNSUPP_REM_FEATURE);
+                CONN_F_HOST_PHY_UPDATE(connsm) = 0;
+            }
+#endif
         }
     }
 }
@@ -791,8 +803,8 @@ ble_ll_ctrl_version_ind_make(struct ble_ll_conn_sm *connsm, uint8_t *pyld)
 static void
 ble_ll_ctrl_chanmap_req_make(struct ble_ll_conn_sm *connsm, uint8_t *pyld)
 {
-    /* Copy channel map that host desires into request */
-    memcpy(pyld, g_ble_ll_conn_params.master_chan_map, BLE_LL_CONN_CHMAP_LEN);
+    /* Copy channel map that host desires (less assessed bad ones) */
+    memcpy(pyld, ble_ll_conn_get_master_chanmap(NULL), BLE_LL_CONN_CHMAP_LEN);
     memcpy(connsm->req_chanmap, pyld, BLE_LL_CONN_CHMAP_LEN);
 
     /* Place instant into request */
@@ -953,6 +965,22 @@ ble_ll_ctrl_rx_reject_ind(struct ble_ll_conn_sm *connsm, uint8_t *dptr,
         ble_ll_hci_ev_encrypt_chg(connsm, ble_error);
         connsm->enc_data.enc_state = CONN_ENC_S_UNENCRYPTED;
         break;
+#endif
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_2M_PHY) == 1)
+    case BLE_LL_CTRL_PROC_PHY_UPDATE:
+        /*
+         * On a collision the master's procedure takes precedence and will
+         * complete ours when we receive its PHY update indication.
+         */
+        if ((opcode == BLE_LL_CTRL_REJECT_IND_EXT) &&
+            (ble_error != BLE_ERR_LMP_COLLISION)) {
+            ble_ll_ctrl_proc_stop(connsm, BLE_LL_CTRL_PROC_PHY_UPDATE);
+            if (CONN_F_HOST_PHY_UPDATE(connsm)) {
+                ble_ll_hci_ev_phy_update(connsm, ble_error);
+                CONN_F_HOST_PHY_UPDATE(connsm) = 0;
+            }
+        }
+        break;
 #endif
     default:
         break;
@@ -1040,9 +1068,9 @@ ble_ll_ctrl_rx_feature_req(struct ble_ll_conn_sm *connsm, uint8_t *dptr,
 
     /* Set common features and reply */
     rsp_opcode = BLE_LL_CTRL_FEATURE_RSP;
-    connsm->common_features = dptr[0] & ble_ll_read_supp_features();
+    connsm->common_features = get_le32(dptr) & ble_ll_read_supp_features();
     memset(rspbuf + 1, 0, 8);
-    rspbuf[1] = connsm->common_features;
+    put_le32(rspbuf + 1, connsm->common_features);
 
     return rsp_opcode;
 }
@@ -1222,6 +1250,247 @@ ble_ll_ctrl_rx_chanmap_req(struct ble_ll_conn_sm *connsm, uint8_t *dptr)
     }
 }
 
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_2M_PHY) == 1)
+/**
+ * Returns the bitmask of PHYs supported by the controller.
+ *
+ * @return uint8_t Bitmask of BLE_HCI_LE_PHY_xxx_PREF_MASK
+ */
+static uint8_t
+ble_ll_ctrl_phy_supp_mask(void)
+{
+    uint8_t mask;
+
+    mask = BLE_HCI_LE_PHY_1M_PREF_MASK;
+    if (ble_ll_read_supp_features() & BLE_LL_FEAT_LE_2M_PHY) {
+        mask |= BLE_HCI_LE_PHY_2M_PREF_MASK;
+    }
+    return mask;
+}
+
+/**
+ * Picks the PHY to use given a bitmask of acceptable PHYs. The fastest PHY
+ * is chosen; the 1M PHY is always supported so it is used if no other PHY
+ * is acceptable.
+ *
+ * @param phy_mask Bitmask of BLE_HCI_LE_PHY_xxx_PREF_MASK
+ *
+ * @return uint8_t The PHY to use (BLE_PHY_MODE_xxx)
+ */
+static uint8_t
+ble_ll_ctrl_phy_from_mask(uint8_t phy_mask)
+{
+    if (phy_mask & BLE_HCI_LE_PHY_2M_PREF_MASK) {
+        return BLE_PHY_MODE_2M;
+    }
+    return BLE_PHY_MODE_1M;
+}
+
+/**
+ * Create a LL_PHY_REQ or LL_PHY_RSP pdu. Our radio uses the same PHY in
+ * both directions, so the same preferences are sent for transmit and
+ * receive.
+ *
+ * @param connsm Pointer to connection state machine
+ * @param ctrdata Pointer to where CtrData field starts
+ */
+static void
+ble_ll_ctrl_phy_req_rsp_make(struct ble_ll_conn_sm *connsm, uint8_t *ctrdata)
+{
+    uint8_t phys;
+
+    phys = connsm->phy_data.host_pref_tx_phys &
+           connsm->phy_data.host_pref_rx_phys &
+           ble_ll_ctrl_phy_supp_mask();
+    if (phys == 0) {
+        phys = BLE_HCI_LE_PHY_1M_PREF_MASK;
+    }
+    ctrdata[0] = phys;
+    ctrdata[1] = phys;
+}
+
+/**
+ * Called by the master to create a LL_PHY_UPDATE_IND pdu once it knows the
+ * PHY preferences of the slave. If the PHY does not change, the PHY fields
+ * are set to zero and the procedure is complete; otherwise the update is
+ * scheduled for the instant placed in the pdu.
+ *
+ * @param connsm Pointer to connection state machine
+ * @param dptr Pointer to the received PHY_REQ or PHY_RSP CtrData
+ * @param ctrdata Pointer to where CtrData of the update ind starts
+ */
+static void
+ble_ll_ctrl_phy_update_ind_make(struct ble_ll_conn_sm *connsm, uint8_t *dptr,
+                                uint8_t *ctrdata)
+{
+    uint8_t tx_phy;
+    uint8_t rx_phy;
+    uint8_t local[2];
+
+    /* Master tx needs the slave rx PHY and vice versa */
+    ble_ll_ctrl_phy_req_rsp_make(connsm, local);
+    tx_phy = ble_ll_ctrl_phy_from_mask(local[0] & dptr[1]);
+    rx_phy = ble_ll_ctrl_phy_from_mask(local[1] & dptr[0]);
+
+    /* Our radio does not support different PHYs for tx and rx */
+    if (tx_phy != rx_phy) {
+        tx_phy = BLE_PHY_MODE_1M;
+        rx_phy = BLE_PHY_MODE_1M;
+    }
+
+    if ((tx_phy == connsm->phy_data.cur_tx_phy) &&
+        (rx_phy == connsm->phy_data.cur_rx_phy)) {
+        ctrdata[0] = 0;
+        ctrdata[1] = 0;
+        put_le16(ctrdata + 2, 0);
+        if (CONN_F_HOST_PHY_UPDATE(connsm)) {
+            CONN_F_PHY_UPDATE_EVENT(connsm) = 1;
+        }
+        ble_ll_ctrl_proc_stop(connsm, BLE_LL_CTRL_PROC_PHY_UPDATE);
+    } else {
+        connsm->phy_data.new_tx_phy = tx_phy;
+        connsm->phy_data.new_rx_phy = rx_phy;
+        connsm->phy_data.phy_instant = connsm->event_cntr +
+                                       connsm->slave_latency + 6 + 1;
+        ctrdata[0] = tx_phy;
+        ctrdata[1] = rx_phy;
+        put_le16(ctrdata + 2, connsm->phy_data.phy_instant);
+        CONN_F_PHY_UPDATE_SCHED(connsm) = 1;
+    }
+}
+
+/**
+ * Called when we receive a LL_PHY_REQ pdu.
+ *
+ * Context: Link Layer task
+ *
+ * @param connsm Pointer to connection state machine
+ * @param dptr Pointer to CtrData of received pdu
+ * @param rspbuf Pointer to response buffer
+ *
+ * @return uint8_t Opcode of the response pdu
+ */
+static uint8_t
+ble_ll_ctrl_rx_phy_req(struct ble_ll_conn_sm *connsm, uint8_t *dptr,
+                       uint8_t *rspbuf)
+{
+    uint8_t rsp_opcode;
+
+    if (connsm->conn_role == BLE_LL_CONN_ROLE_MASTER) {
+        /*
+         * Our own PHY update takes precedence over the one the slave
+         * started. Reject it if another procedure with an instant is
+         * already scheduled.
+         */
+        if (connsm->cur_ctrl_proc == BLE_LL_CTRL_PROC_PHY_UPDATE) {
+            rsp_opcode = BLE_LL_CTRL_REJECT_IND_EXT;
+            rspbuf[1] = BLE_LL_CTRL_PHY_REQ;
+            rspbuf[2] = BLE_ERR_LMP_COLLISION;
+        } else if (CONN_F_UPDATE_SCHED(connsm) ||
+                   connsm->csmflags.cfbit.chanmap_update_scheduled ||
+                   CONN_F_PHY_UPDATE_SCHED(connsm)) {
+            rsp_opcode = BLE_LL_CTRL_REJECT_IND_EXT;
+            rspbuf[1] = BLE_LL_CTRL_PHY_REQ;
+            rspbuf[2] = BLE_ERR_DIFF_TRANS_COLL;
+        } else {
+            /* A pending request from our host is satisfied by this one */
+            CLR_PENDING_CTRL_PROC(connsm, BLE_LL_CTRL_PROC_PHY_UPDATE);
+            rsp_opcode = BLE_LL_CTRL_PHY_UPDATE_IND;
+            ble_ll_ctrl_phy_update_ind_make(connsm, dptr, rspbuf + 1);
+        }
+    } else {
+        rsp_opcode = BLE_LL_CTRL_PHY_RSP;
+        ble_ll_ctrl_phy_req_rsp_make(connsm, rspbuf + 1);
+    }
+
+    return rsp_opcode;
+}
+
+/**
+ * Called when we receive a LL_PHY_RSP pdu. Only the master expects this
+ * pdu and replies with a LL_PHY_UPDATE_IND.
+ *
+ * Context: Link Layer task
+ *
+ * @param connsm Pointer to connection state machine
+ * @param dptr Pointer to CtrData of received pdu
+ * @param rspbuf Pointer to response buffer
+ *
+ * @return uint8_t Opcode of the response pdu
+ */
+static uint8_t
+ble_ll_ctrl_rx_phy_rsp(struct ble_ll_conn_sm *connsm, uint8_t *dptr,
+                       uint8_t *rspbuf)
+{
+    uint8_t rsp_opcode;
+
+    rsp_opcode = BLE_ERR_MAX;
+    if (connsm->conn_role == BLE_LL_CONN_ROLE_MASTER) {
+        if (connsm->cur_ctrl_proc == BLE_LL_CTRL_PROC_PHY_UPDATE) {
+            rsp_opcode = BLE_LL_CTRL_PHY_UPDATE_IND;
+            ble_ll_ctrl_phy_update_ind_make(connsm, dptr, rspbuf + 1);
+        }
+    } else {
+        rsp_opcode = BLE_LL_CTRL_UNKNOWN_RSP;
+    }
+
+    return rsp_opcode;
+}
+
+/**
+ * Called when a slave receives a LL_PHY_UPDATE_IND pdu.
+ *
+ * Context: Link Layer task
+ *
+ * @param connsm Pointer to connection state machine
+ * @param dptr Pointer to CtrData of received pdu
+ */
+static void
+ble_ll_ctrl_rx_phy_update_ind(struct ble_ll_conn_sm *connsm, uint8_t *dptr)
+{
+    uint8_t tx_phy;
+    uint8_t rx_phy;
+    uint16_t instant;
+    uint16_t conn_events;
+
+    if (connsm->conn_role != BLE_LL_CONN_ROLE_SLAVE) {
+        return;
+    }
+
+    /* No change; the procedure is complete */
+    if ((dptr[0] == 0) && (dptr[1] == 0)) {
+        if (CONN_F_HOST_PHY_UPDATE(connsm)) {
+            CONN_F_PHY_UPDATE_EVENT(connsm) = 1;
+        }
+        ble_ll_ctrl_proc_stop(connsm, BLE_LL_CTRL_PROC_PHY_UPDATE);
+        return;
+    }
+
+    /* Slave rx PHY is the master to slave PHY. Zero means no change */
+    rx_phy = dptr[0] ? dptr[0] : connsm->phy_data.cur_rx_phy;
+    tx_phy = dptr[1] ? dptr[1] : connsm->phy_data.cur_tx_phy;
+
+    /* We only support the same, supported, PHY in both directions */
+    if ((tx_phy != rx_phy) || (tx_phy > BLE_PHY_MODE_2M) ||
+        ((ble_ll_ctrl_phy_supp_mask() & (1 << (tx_phy - 1))) == 0)) {
+        ble_ll_conn_timeout(connsm, BLE_ERR_UNSUPP_LMP_LL_PARM);
+        return;
+    }
+
+    /* If instant is in the past, we have to end the connection */
+    instant = get_le16(dptr + 2);
+    conn_events = (instant - connsm->event_cntr) & 0xFFFF;
+    if (conn_events >= 32767) {
+        ble_ll_conn_timeout(connsm, BLE_ERR_INSTANT_PASSED);
+    } else {
+        connsm->phy_data.new_tx_phy = tx_phy;
+        connsm->phy_data.new_rx_phy = rx_phy;
+        connsm->phy_data.phy_instant = instant;
+        CONN_F_PHY_UPDATE_SCHED(connsm) = 1;
+    }
+}
+#endif
+
 /**
  * Callback when LL control procedure times out (for a given connection). If
  * this is called, it means that we need to end the connection because it
@@ -1284,7 +1553,7 @@ ble_ll_ctrl_proc_init(struct ble_ll_conn_sm *connsm, int ctrl_proc)
                 opcode = BLE_LL_CTRL_SLAVE_FEATURE_REQ;
             }
             memset(ctrdata, 0, BLE_LL_CTRL_FEATURE_LEN);
-            ctrdata[0] = ble_ll_read_supp_features();
+            put_le32(ctrdata, ble_ll_read_supp_features());
             break;
         case BLE_LL_CTRL_PROC_VERSION_XCHG:
             opcode = BLE_LL_CTRL_VERSION_IND;
@@ -1305,6 +1574,12 @@ ble_ll_ctrl_proc_init(struct ble_ll_conn_sm *connsm, int ctrl_proc)
             opcode = BLE_LL_CTRL_LENGTH_REQ;
             ble_ll_ctrl_datalen_upd_make(connsm, dptr);
             break;
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_2M_PHY) == 1)
+        case BLE_LL_CTRL_PROC_PHY_UPDATE:
+            opcode = BLE_LL_CTRL_PHY_REQ;
+            ble_ll_ctrl_phy_req_rsp_make(connsm, ctrdata);
+            break;
+#endif
 #if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_ENCRYPTION) == 1)
         /* XXX: deal with already encrypted connection.*/
         case BLE_LL_CTRL_PROC_ENCRYPT:
@@ -1517,8 +1792,8 @@ ble_ll_ctrl_chk_proc_start(struct ble_ll_conn_sm *connsm)
 int
 ble_ll_ctrl_rx_pdu(struct ble_ll_conn_sm *connsm, struct os_mbuf *om)
 {
-    uint8_t features;
-    uint8_t feature;
+    uint32_t features;
+    uint32_t feature;
     uint8_t len;
     uint8_t opcode;
     uint8_t rsp_opcode;
@@ -1599,6 +1874,11 @@ ble_ll_ctrl_rx_pdu(struct ble_ll_conn_sm *connsm, struct os_mbuf *om)
     case BLE_LL_CTRL_PING_REQ:
         feature = BLE_LL_FEAT_LE_PING;
         break;
+    case BLE_LL_CTRL_PHY_REQ:
+    case BLE_LL_CTRL_PHY_RSP:
+    case BLE_LL_CTRL_PHY_UPDATE_IND:
+        feature = BLE_LL_FEAT_LE_2M_PHY;
+        break;
     default:
         feature = 0;
         break;
@@ -1678,7 +1958,7 @@ ble_ll_ctrl_rx_pdu(struct ble_ll_conn_sm *connsm, struct os_mbuf *om)
     /* XXX: check to see if ctrl procedure was running? Do we care? */
     case BLE_LL_CTRL_FEATURE_RSP:
         /* Stop the control procedure */
-        connsm->common_features = dptr[0];
+        connsm->common_features = get_le32(dptr);
         if (IS_PENDING_CTRL_PROC(connsm, BLE_LL_CTRL_PROC_FEATURE_XCHG)) {
             ble_ll_hci_ev_rd_rem_used_feat(connsm, BLE_ERR_SUCCESS);
             ble_ll_ctrl_proc_stop(connsm, BLE_LL_CTRL_PROC_FEATURE_XCHG);
@@ -1725,6 +2005,17 @@ ble_ll_ctrl_rx_pdu(struct ble_ll_conn_sm *connsm, struct os_mbuf *om)
     case BLE_LL_CTRL_CONN_PARM_RSP:
         rsp_opcode = ble_ll_ctrl_rx_conn_param_rsp(connsm, dptr, rspbuf);
         break;
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_2M_PHY) == 1)
+    case BLE_LL_CTRL_PHY_REQ:
+        rsp_opcode = ble_ll_ctrl_rx_phy_req(connsm, dptr, rspbuf);
+        break;
+    case BLE_LL_CTRL_PHY_RSP:
+        rsp_opcode = ble_ll_ctrl_rx_phy_rsp(connsm, dptr, rspbuf);
+        break;
+    case BLE_LL_CTRL_PHY_UPDATE_IND:
+        ble_ll_ctrl_rx_phy_update_ind(connsm, dptr);
+        break;
+#endif
     /* Fall-through intentional... */
     case BLE_LL_CTRL_REJECT_IND:
     case BLE_LL_CTRL_REJECT_IND_EXT:
@@ -390,7 +390,7 @@ ble_ll_hci_le_read_local_features(uint8_t *rspbuf, uint8_t *rsplen)
 {
     /* Add list of supported features. */
     memset(rspbuf, 0, BLE_HCI_RD_LOC_SUPP_FEAT_RSPLEN);
-    rspbuf[0] = ble_ll_read_supp_features();
+    put_le32(rspbuf, ble_ll_read_supp_features());
     *rsplen = BLE_HCI_RD_LOC_SUPP_FEAT_RSPLEN;
     return BLE_ERR_SUCCESS;
 }
@@ -499,6 +499,7 @@ ble_ll_hci_le_cmd_send_cmd_status(uint16_t ocf)
     case BLE_HCI_OCF_LE_START_ENCRYPT:
     case BLE_HCI_OCF_LE_RD_P256_PUBKEY:
     case BLE_HCI_OCF_LE_GEN_DHKEY:
+    case BLE_HCI_OCF_LE_SET_PHY:
         rc = 1;
         break;
     default:
@@ -579,6 +580,13 @@ ble_ll_hci_vendor_cmd_proc(uint8_t *cmdbuf, uint16_t ocf, uint8_t *rsplen)
             rc = ble_ll_adv_multi_adv_cmd(cmdbuf, cmdlen, rspbuf, rsplen);
         }
         break;
+#endif
+#if MYNEWT_VAL(BLE_LL_SCAN_RPT_FILT_SIZE) > 0
+    case BLE_HCI_OCF_ADV_RPT_FILT:
+        if (cmdlen > 0) {
+            rc = ble_ll_scan_rpt_filt_cmd(cmdbuf, cmdlen, rspbuf, rsplen);
+        }
+        break;
 #endif
     default:
         rc = BLE_ERR_UNKNOWN_HCI_CMD;
@@ -618,6 +626,10 @@ ble_ll_hci_le_cmd_proc(uint8_t *cmdbuf, uint16_t ocf, uint8_t *rsplen)
     len = cmdbuf[sizeof(uint16_t)];
 
     /* Check the length to make sure it is valid */
+    if (ocf >= BLE_HCI_NUM_LE_CMDS) {
+        rc = BLE_ERR_UNKNOWN_HCI_CMD;
+        goto ll_hci_le_cmd_exit;
+    }
     cmdlen = g_ble_hci_le_cmd_len[ocf];
     if (len != cmdlen) {
         goto ll_hci_le_cmd_exit;
@@ -764,6 +776,17 @@ ble_ll_hci_le_cmd_proc(uint8_t *cmdbuf, uint16_t ocf, uint8_t *rsplen)
     case BLE_HCI_OCF_LE_RD_MAX_DATA_LEN:
         rc = ble_ll_hci_le_rd_max_data_len(rspbuf, rsplen);
         break;
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_2M_PHY) == 1)
+    case BLE_HCI_OCF_LE_RD_PHY:
+        rc = ble_ll_conn_hci_le_rd_phy(cmdbuf, rspbuf, rsplen);
+        break;
+    case BLE_HCI_OCF_LE_SET_DEFAULT_PHY:
+        rc = ble_ll_conn_hci_le_set_default_phy(cmdbuf);
+        break;
+    case BLE_HCI_OCF_LE_SET_PHY:
+        rc = ble_ll_conn_hci_le_set_phy(cmdbuf);
+        break;
+#endif
     default:
         rc = BLE_ERR_UNKNOWN_HCI_CMD;
         break;
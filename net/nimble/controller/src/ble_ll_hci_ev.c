@@ -58,6 +58,34 @@ ble_ll_hci_ev_datalen_chg(struct ble_ll_conn_sm *connsm)
     }
 }
 
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_2M_PHY) == 1)
+/**
+ * Send a PHY update complete event for a connection to the host.
+ *
+ * @param connsm Pointer to connection state machine
+ * @param status The status of the PHY update procedure
+ */
+void
+ble_ll_hci_ev_phy_update(struct ble_ll_conn_sm *connsm, uint8_t status)
+{
+    uint8_t *evbuf;
+
+    if (ble_ll_hci_is_le_event_enabled(BLE_HCI_LE_SUBEV_PHY_UPDATE_COMPLETE)) {
+        evbuf = ble_hci_trans_buf_alloc(BLE_HCI_TRANS_BUF_EVT_HI);
+        if (evbuf) {
+            evbuf[0] = BLE_HCI_EVCODE_LE_META;
+            evbuf[1] = BLE_HCI_LE_PHY_UPD_LEN;
+            evbuf[2] = BLE_HCI_LE_SUBEV_PHY_UPDATE_COMPLETE;
+            evbuf[3] = status;
+            put_le16(evbuf + 4, connsm->conn_handle);
+            evbuf[6] = connsm->phy_data.cur_tx_phy;
+            evbuf[7] = connsm->phy_data.cur_rx_phy;
+            ble_ll_hci_event_send(evbuf);
+        }
+    }
+}
+#endif
+
 /**
  * Send a connection parameter request event for a connection to the host.
  *
@@ -198,7 +226,7 @@ ble_ll_hci_ev_rd_rem_used_feat(struct ble_ll_conn_sm *connsm, uint8_t status)
             evbuf[3] = status;
             put_le16(evbuf + 4, connsm->conn_handle);
             memset(evbuf + 6, 0, BLE_HCI_RD_LOC_SUPP_FEAT_RSPLEN);
-            evbuf[6] = connsm->common_features;
+            put_le32(evbuf + 6, connsm->common_features);
             ble_ll_hci_event_send(evbuf);
         }
     }
@@ -32,7 +32,7 @@ struct ble_ll_rnum_data
 {
     uint8_t *rnd_in;
     uint8_t *rnd_out;
-    volatile uint8_t rnd_size;
+    volatile uint16_t rnd_size;
 };
 
 struct ble_ll_rnum_data g_ble_ll_rnum_data;
@@ -41,6 +41,21 @@ uint8_t g_ble_ll_rnum_buf[MYNEWT_VAL(BLE_LL_RNG_BUFSIZE)];
 #define IS_RNUM_BUF_END(x)  \
     (x == &g_ble_ll_rnum_buf[MYNEWT_VAL(BLE_LL_RNG_BUFSIZE) - 1])
 
+/*
+ * Non-cryptographic PRNG (xorshift128) used by ble_ll_rand(). It is stirred
+ * with bytes from the entropy pool every BLE_LL_RAND_RESEED_ITVL outputs,
+ * but never waits for the pool to fill.
+ */
+struct ble_ll_rand_prng
+{
+    uint32_t s[4];
+    uint16_t outputs;
+};
+
+static struct ble_ll_rand_prng g_ble_ll_rand_prng = {
+    .s = { 0x075bcd15, 0x159a55e5, 0x1f123bb5, 0x5491333d },
+};
+
 void
 ble_ll_rand_sample(uint8_t rnum)
 {
@@ -62,35 +77,57 @@ ble_ll_rand_sample(uint8_t rnum)
     OS_EXIT_CRITICAL(sr);
 }
 
-/* Get 'len' bytes of random data */
+/**
+ * Takes up to 'len' bytes out of the entropy pool without waiting and
+ * restarts the rng so the pool gets refilled.
+ *
+ * @param buf
+ * @param len
+ *
+ * @return int The number of bytes copied into 'buf'.
+ */
 int
-ble_ll_rand_data_get(uint8_t *buf, uint8_t len)
+ble_ll_rand_data_try_get(uint8_t *buf, uint8_t len)
 {
     uint8_t rnums;
+    uint8_t copied;
     os_sr_t sr;
 
-    while (len != 0) {
-        OS_ENTER_CRITICAL(sr);
+    OS_ENTER_CRITICAL(sr);
+    rnums = len;
+    if (g_ble_ll_rnum_data.rnd_size < rnums) {
         rnums = g_ble_ll_rnum_data.rnd_size;
-        if (rnums > len) {
-            rnums = len;
-        }
-        len -= rnums;
-        g_ble_ll_rnum_data.rnd_size -= rnums;
-        while (rnums) {
-            buf[0] = g_ble_ll_rnum_data.rnd_out[0];
-            if (IS_RNUM_BUF_END(g_ble_ll_rnum_data.rnd_out)) {
-                g_ble_ll_rnum_data.rnd_out = g_ble_ll_rnum_buf;
-            } else {
-                ++g_ble_ll_rnum_data.rnd_out;
-            }
-            ++buf;
-            --rnums;
+    }
+    g_ble_ll_rnum_data.rnd_size -= rnums;
+    copied = rnums;
+    while (rnums) {
+        buf[0] = g_ble_ll_rnum_data.rnd_out[0];
+        if (IS_RNUM_BUF_END(g_ble_ll_rnum_data.rnd_out)) {
+            g_ble_ll_rnum_data.rnd_out = g_ble_ll_rnum_buf;
+        } else {
+            ++g_ble_ll_rnum_data.rnd_out;
         }
-        OS_EXIT_CRITICAL(sr);
+        ++buf;
+        --rnums;
+    }
+    OS_EXIT_CRITICAL(sr);
 
-        /* Make sure rng is started! */
-        ble_hw_rng_start();
+    /* Make sure rng is started! */
+    ble_hw_rng_start();
+
+    return copied;
+}
+
+/* Get 'len' bytes of random data */
+int
+ble_ll_rand_data_get(uint8_t *buf, uint8_t len)
+{
+    uint8_t rnums;
+
+    while (len != 0) {
+        rnums = ble_ll_rand_data_try_get(buf, len);
+        buf += rnums;
+        len -= rnums;
 
         /* Wait till bytes are in buffer. */
         if (len) {
@@ -104,6 +141,79 @@ ble_ll_rand_data_get(uint8_t *buf, uint8_t len)
     return BLE_ERR_SUCCESS;
 }
 
+/**
+ * Mixes whatever the entropy pool currently holds (up to 16 bytes) into the
+ * PRNG state. Called with interrupts disabled.
+ */
+static void
+ble_ll_rand_prng_stir(void)
+{
+    uint8_t seed[16];
+    int num;
+    int i;
+
+    num = ble_ll_rand_data_try_get(seed, sizeof seed);
+    for (i = 0; i < num; ++i) {
+        g_ble_ll_rand_prng.s[i >> 2] ^= (uint32_t)seed[i] << ((i & 3) * 8);
+    }
+
+    /* xorshift128 must never have an all-zero state */
+    if ((g_ble_ll_rand_prng.s[0] | g_ble_ll_rand_prng.s[1] |
+         g_ble_ll_rand_prng.s[2] | g_ble_ll_rand_prng.s[3]) == 0) {
+        g_ble_ll_rand_prng.s[0] = 0x075bcd15;
+    }
+}
+
+/**
+ * Returns a 32-bit pseudo-random number. This never waits for the hardware
+ * rng, and can be called from interrupt context, but it is NOT suitable for
+ * keys or any other security material; use ble_ll_rand_data_get() for
+ * those.
+ *
+ * @return uint32_t
+ */
+uint32_t
+ble_ll_rand(void)
+{
+    uint32_t t;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    if (g_ble_ll_rand_prng.outputs == 0) {
+        ble_ll_rand_prng_stir();
+        g_ble_ll_rand_prng.outputs = MYNEWT_VAL(BLE_LL_RAND_RESEED_ITVL);
+    }
+    --g_ble_ll_rand_prng.outputs;
+
+    t = g_ble_ll_rand_prng.s[3];
+    t ^= t << 11;
+    t ^= t >> 8;
+    g_ble_ll_rand_prng.s[3] = g_ble_ll_rand_prng.s[2];
+    g_ble_ll_rand_prng.s[2] = g_ble_ll_rand_prng.s[1];
+    g_ble_ll_rand_prng.s[1] = g_ble_ll_rand_prng.s[0];
+    t ^= g_ble_ll_rand_prng.s[0] ^ (g_ble_ll_rand_prng.s[0] >> 19);
+    g_ble_ll_rand_prng.s[0] = t;
+    OS_EXIT_CRITICAL(sr);
+
+    return t;
+}
+
+/**
+ * Mixes a seed into the ble_ll_rand() PRNG state.
+ *
+ * @param seed
+ */
+void
+ble_ll_rand_seed(uint32_t seed)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    g_ble_ll_rand_prng.s[3] ^= seed;
+    ble_ll_rand_prng_stir();
+    OS_EXIT_CRITICAL(sr);
+}
+
 /**
  * Called to obtain a "prand" as defined in core V4.2 Vol 6 Part B 1.3.2.2
  *
@@ -44,6 +44,48 @@ struct ble_ll_resolv_data g_ble_ll_resolv_data;
 
 struct ble_ll_resolv_entry g_ble_ll_resolv_list[MYNEWT_VAL(BLE_LL_RESOLV_LIST_SIZE)];
 
+#if MYNEWT_VAL(BLE_LL_RESOLV_RPA_CACHE_SIZE) > 0
+/*
+ * Cache of recently resolved peer RPAs. It is direct mapped on the prand
+ * part of the address so that a lookup from an ISR is a single compare.
+ * rc_index is the resolving list index plus 1; 0 marks an unused entry.
+ */
+struct ble_ll_resolv_rpa_cache_entry
+{
+    uint8_t rc_rpa[BLE_DEV_ADDR_LEN];
+    uint8_t rc_index;
+};
+
+static struct ble_ll_resolv_rpa_cache_entry
+g_ble_ll_resolv_rpa_cache[MYNEWT_VAL(BLE_LL_RESOLV_RPA_CACHE_SIZE)];
+
+static struct ble_ll_resolv_rpa_cache_entry *
+ble_ll_resolv_rpa_cache_slot(uint8_t *rpa)
+{
+    uint32_t prand;
+
+    prand = rpa[3] | ((uint32_t)rpa[4] << 8) | ((uint32_t)rpa[5] << 16);
+    return &g_ble_ll_resolv_rpa_cache[prand %
+                                      MYNEWT_VAL(BLE_LL_RESOLV_RPA_CACHE_SIZE)];
+}
+
+/**
+ * Empties the cache of resolved peer RPAs. Needs to be called whenever
+ * resolving list indices change.
+ */
+static void
+ble_ll_resolv_rpa_cache_clr(void)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    memset(g_ble_ll_resolv_rpa_cache, 0, sizeof(g_ble_ll_resolv_rpa_cache));
+    OS_EXIT_CRITICAL(sr);
+}
+#else
+#define ble_ll_resolv_rpa_cache_clr()
+#endif
+
 /**
  * Called to determine if a change is allowed to the resolving list at this
  * time. We are not allowed to modify the resolving list if address translation
@@ -78,6 +120,9 @@ ble_ll_resolv_rpa_timer_cb(struct os_event *ev)
     os_sr_t sr;
     struct ble_ll_resolv_entry *rl;
 
+    /* Peers are likely to have moved on to new RPAs as well */
+    ble_ll_resolv_rpa_cache_clr();
+
     rl = &g_ble_ll_resolv_list[0];
     for (i = 0; i < g_ble_ll_resolv_data.rl_cnt; ++i) {
         OS_ENTER_CRITICAL(sr);
@@ -132,6 +177,7 @@ ble_ll_resolv_list_clr(void)
     /* Sets total on list to 0. Clears HW resolve list */
     g_ble_ll_resolv_data.rl_cnt = 0;
     ble_hw_resolv_list_clear();
+    ble_ll_resolv_rpa_cache_clr();
 
     return BLE_ERR_SUCCESS;
 }
@@ -280,14 +326,18 @@ ble_ll_resolv_list_rmv(uint8_t *cmdbuf)
 
     /* Remove from IRK records */
     position = ble_ll_is_on_resolv_list(ident_addr, addr_type);
-    if (position && (position < g_ble_ll_resolv_data.rl_cnt)) {
+    if (position) {
         memmove(&g_ble_ll_resolv_list[position - 1],
                 &g_ble_ll_resolv_list[position],
-                g_ble_ll_resolv_data.rl_cnt - position);
+                (g_ble_ll_resolv_data.rl_cnt - position) *
+                sizeof(struct ble_ll_resolv_entry));
         --g_ble_ll_resolv_data.rl_cnt;
 
         /* Remove from HW list */
         ble_hw_resolv_list_rmv(position - 1);
+
+        /* Entries after the removed one have moved */
+        ble_ll_resolv_rpa_cache_clr();
     }
 
     return BLE_ERR_SUCCESS;
@@ -522,6 +572,42 @@ ble_ll_resolv_rpa(uint8_t *rpa, uint8_t *irk)
     return rc;
 }
 
+/**
+ * Returns the resolving list index of a peer RPA that was just received.
+ * The result of the hardware resolver is used if it has one; such results
+ * are remembered so that the next PDU from the same RPA resolves even when
+ * the hardware has not finished (or there is no hardware resolver).
+ *
+ * Context: Interrupt
+ *
+ * @param rpa Pointer to received RPA
+ *
+ * @return int Index in resolving list; -1 if not resolved.
+ */
+int
+ble_ll_resolv_peer_rpa_match(uint8_t *rpa)
+{
+    int index;
+#if MYNEWT_VAL(BLE_LL_RESOLV_RPA_CACHE_SIZE) > 0
+    struct ble_ll_resolv_rpa_cache_entry *entry;
+#endif
+
+    index = ble_hw_resolv_list_match();
+
+#if MYNEWT_VAL(BLE_LL_RESOLV_RPA_CACHE_SIZE) > 0
+    entry = ble_ll_resolv_rpa_cache_slot(rpa);
+    if (index >= 0) {
+        memcpy(entry->rc_rpa, rpa, BLE_DEV_ADDR_LEN);
+        entry->rc_index = index + 1;
+    } else if ((entry->rc_index != 0) &&
+               !memcmp(entry->rc_rpa, rpa, BLE_DEV_ADDR_LEN)) {
+        index = entry->rc_index - 1;
+    }
+#endif
+
+    return index;
+}
+
 /**
  * Returns whether or not address resolution is enabled.
  *
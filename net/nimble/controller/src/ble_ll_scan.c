@@ -27,6 +27,7 @@
 #include "nimble/ble.h"
 #include "nimble/nimble_opt.h"
 #include "nimble/hci_common.h"
+#include "nimble/hci_vendor.h"
 #include "nimble/ble_hci_trans.h"
 #include "controller/ble_phy.h"
 #include "controller/ble_hw.h"
@@ -51,7 +52,10 @@
  * receive a scan response from? Implement this.
  */
 
-/* Dont allow more than 255 of these entries */
+/*
+ * Dont allow more than 255 of these entries. Entry indices are stored in
+ * uint8_t fields and 0xFF marks an empty link, so indices stay below 255.
+ */
 #if MYNEWT_VAL(BLE_LL_NUM_SCAN_DUP_ADVS) > 255
     #error "Cannot have more than 255 duplicate entries!"
 #endif
@@ -59,7 +63,6 @@
     #error "Cannot have more than 255 scan response entries!"
 #endif
 
-
 /* The scanning parameters set by host */
 struct ble_ll_scan_params g_ble_ll_scan_params;
 
@@ -74,6 +77,9 @@ struct ble_ll_scan_sm g_ble_ll_scan_sm;
 struct ble_ll_scan_advertisers
 {
     uint16_t            sc_adv_flags;
+    uint16_t            sc_adv_hash;
+    uint8_t             sc_lru_prev;
+    uint8_t             sc_lru_next;
     struct ble_dev_addr adv_addr;
 };
 
@@ -82,15 +88,55 @@ struct ble_ll_scan_advertisers
 #define BLE_LL_SC_ADV_F_DIRECT_RPT_SENT (0x04)
 #define BLE_LL_SC_ADV_F_ADV_RPT_SENT    (0x08)
 
+/* Marks an empty LRU link */
+#define BLE_LL_SC_ADV_NONE              (0xFF)
+
+/*
+ * A list of advertisers, indexed by an open-addressed hash table so that
+ * lookups from the receive ISR take constant time regardless of list size.
+ * Each hash slot holds the index of an entry plus one; 0 means empty. When
+ * the list is full the least recently used advertiser is replaced.
+ */
+struct ble_ll_scan_adv_tbl
+{
+    uint8_t num_advs;
+    uint8_t max_advs;
+    uint8_t lru_head;
+    uint8_t lru_tail;
+    uint16_t hash_size;
+    uint8_t *hash;
+    struct ble_ll_scan_advertisers *advs;
+};
+
+/* Twice as many hash slots as entries keeps probe sequences short */
+#define BLE_LL_SCAN_RSP_HASH_SZ (2 * MYNEWT_VAL(BLE_LL_NUM_SCAN_RSP_ADVS))
+#define BLE_LL_SCAN_DUP_HASH_SZ (2 * MYNEWT_VAL(BLE_LL_NUM_SCAN_DUP_ADVS))
+
 /* Contains list of advertisers that we have heard scan responses from */
-static uint8_t g_ble_ll_scan_num_rsp_advs;
 struct ble_ll_scan_advertisers
 g_ble_ll_scan_rsp_advs[MYNEWT_VAL(BLE_LL_NUM_SCAN_RSP_ADVS)];
+static uint8_t g_ble_ll_scan_rsp_hash[BLE_LL_SCAN_RSP_HASH_SZ];
+static struct ble_ll_scan_adv_tbl g_ble_ll_scan_rsp_tbl = {
+    .max_advs = MYNEWT_VAL(BLE_LL_NUM_SCAN_RSP_ADVS),
+    .lru_head = BLE_LL_SC_ADV_NONE,
+    .lru_tail = BLE_LL_SC_ADV_NONE,
+    .hash_size = BLE_LL_SCAN_RSP_HASH_SZ,
+    .hash = g_ble_ll_scan_rsp_hash,
+    .advs = g_ble_ll_scan_rsp_advs,
+};
 
 /* Used to filter duplicate advertising events to host */
-static uint8_t g_ble_ll_scan_num_dup_advs;
 struct ble_ll_scan_advertisers
 g_ble_ll_scan_dup_advs[MYNEWT_VAL(BLE_LL_NUM_SCAN_DUP_ADVS)];
+static uint8_t g_ble_ll_scan_dup_hash[BLE_LL_SCAN_DUP_HASH_SZ];
+static struct ble_ll_scan_adv_tbl g_ble_ll_scan_dup_tbl = {
+    .max_advs = MYNEWT_VAL(BLE_LL_NUM_SCAN_DUP_ADVS),
+    .lru_head = BLE_LL_SC_ADV_NONE,
+    .lru_tail = BLE_LL_SC_ADV_NONE,
+    .hash_size = BLE_LL_SCAN_DUP_HASH_SZ,
+    .hash = g_ble_ll_scan_dup_hash,
+    .advs = g_ble_ll_scan_dup_advs,
+};
 
 /* See Vol 6 Part B Section 4.4.3.2. Active scanning backoff */
 static void
@@ -119,7 +165,7 @@ ble_ll_scan_req_backoff(struct ble_ll_scan_sm *scansm, int success)
         STATS_INC(ble_ll_stats, scan_req_txf);
     }
 
-    scansm->backoff_count = rand() & (scansm->upper_limit - 1);
+    scansm->backoff_count = ble_ll_rand() & (scansm->upper_limit - 1);
     ++scansm->backoff_count;
     assert(scansm->backoff_count <= 256);
 }
@@ -196,46 +242,204 @@ ble_ll_scan_req_pdu_make(struct ble_ll_scan_sm *scansm, uint8_t *adv_addr,
 }
 
 /**
- * Checks to see if an advertiser is on the duplicate address list.
+ * Empties an advertiser list.
  *
- * @param addr Pointer to address
+ * @param tbl Pointer to advertiser list
+ */
+static void
+ble_ll_scan_adv_tbl_reset(struct ble_ll_scan_adv_tbl *tbl)
+{
+    tbl->num_advs = 0;
+    tbl->lru_head = BLE_LL_SC_ADV_NONE;
+    tbl->lru_tail = BLE_LL_SC_ADV_NONE;
+    memset(tbl->hash, 0, tbl->hash_size);
+}
+
+/**
+ * Calculates the home hash slot of an advertiser.
+ */
+static uint16_t
+ble_ll_scan_adv_hash(struct ble_ll_scan_adv_tbl *tbl, uint8_t *addr,
+                     uint8_t txadd)
+{
+    int i;
+    uint32_t h;
+
+    h = txadd ? 1 : 0;
+    for (i = 0; i < BLE_DEV_ADDR_LEN; ++i) {
+        h = (h * 31) + addr[i];
+    }
+
+    return h % tbl->hash_size;
+}
+
+static void
+ble_ll_scan_adv_lru_unlink(struct ble_ll_scan_adv_tbl *tbl, uint8_t idx)
+{
+    struct ble_ll_scan_advertisers *adv;
+
+    adv = &tbl->advs[idx];
+    if (adv->sc_lru_prev == BLE_LL_SC_ADV_NONE) {
+        tbl->lru_head = adv->sc_lru_next;
+    } else {
+        tbl->advs[adv->sc_lru_prev].sc_lru_next = adv->sc_lru_next;
+    }
+    if (adv->sc_lru_next == BLE_LL_SC_ADV_NONE) {
+        tbl->lru_tail = adv->sc_lru_prev;
+    } else {
+        tbl->advs[adv->sc_lru_next].sc_lru_prev = adv->sc_lru_prev;
+    }
+}
+
+static void
+ble_ll_scan_adv_lru_push(struct ble_ll_scan_adv_tbl *tbl, uint8_t idx)
+{
+    struct ble_ll_scan_advertisers *adv;
+
+    adv = &tbl->advs[idx];
+    adv->sc_lru_prev = BLE_LL_SC_ADV_NONE;
+    adv->sc_lru_next = tbl->lru_head;
+    if (tbl->lru_head == BLE_LL_SC_ADV_NONE) {
+        tbl->lru_tail = idx;
+    } else {
+        tbl->advs[tbl->lru_head].sc_lru_prev = idx;
+    }
+    tbl->lru_head = idx;
+}
+
+/**
+ * Finds an advertiser on a list. A found advertiser becomes the most
+ * recently used one.
+ *
+ * @param tbl   Pointer to advertiser list
+ * @param addr  Pointer to address
  * @param txadd TxAdd bit. 0: public; random otherwise
  *
- * @return uint8_t 0: not on list; any other value is
+ * @return struct ble_ll_scan_advertisers* NULL if not on list
  */
 static struct ble_ll_scan_advertisers *
-ble_ll_scan_find_dup_adv(uint8_t *addr, uint8_t txadd)
+ble_ll_scan_adv_tbl_find(struct ble_ll_scan_adv_tbl *tbl, uint8_t *addr,
+                         uint8_t txadd)
 {
-    uint8_t num_advs;
+    uint8_t idx;
+    uint16_t slot;
+    uint16_t probes;
     struct ble_ll_scan_advertisers *adv;
 
-    /* Do we have an address match? Must match address type */
-    adv = &g_ble_ll_scan_dup_advs[0];
-    num_advs = g_ble_ll_scan_num_dup_advs;
-    while (num_advs) {
-        if (!memcmp(&adv->adv_addr, addr, BLE_DEV_ADDR_LEN)) {
-            /* Address type must match */
-            if (txadd) {
-                if ((adv->sc_adv_flags & BLE_LL_SC_ADV_F_RANDOM_ADDR) == 0) {
-                    goto next_dup_adv;
-                }
-            } else {
-                if (adv->sc_adv_flags & BLE_LL_SC_ADV_F_RANDOM_ADDR) {
-                    goto next_dup_adv;
-                }
-            }
+    slot = ble_ll_scan_adv_hash(tbl, addr, txadd);
+    for (probes = 0; probes < tbl->hash_size; ++probes) {
+        if (tbl->hash[slot] == 0) {
+            break;
+        }
+
+        idx = tbl->hash[slot] - 1;
+        adv = &tbl->advs[idx];
 
+        /* Address and address type must match */
+        if (!memcmp(&adv->adv_addr, addr, BLE_DEV_ADDR_LEN) &&
+            (!(adv->sc_adv_flags & BLE_LL_SC_ADV_F_RANDOM_ADDR) == !txadd)) {
+            if (tbl->lru_head != idx) {
+                ble_ll_scan_adv_lru_unlink(tbl, idx);
+                ble_ll_scan_adv_lru_push(tbl, idx);
+            }
             return adv;
         }
 
-next_dup_adv:
-        ++adv;
-        --num_advs;
+        if (++slot == tbl->hash_size) {
+            slot = 0;
+        }
     }
 
     return NULL;
 }
 
+/**
+ * Removes an entry from the hash table of an advertiser list. Entries
+ * following it in the same probe sequence are moved back so that lookups
+ * never stop early at the emptied slot.
+ */
+static void
+ble_ll_scan_adv_hash_remove(struct ble_ll_scan_adv_tbl *tbl, uint8_t idx)
+{
+    uint16_t i;
+    uint16_t j;
+    uint16_t home;
+
+    i = tbl->advs[idx].sc_adv_hash;
+    while (tbl->hash[i] != idx + 1) {
+        if (++i == tbl->hash_size) {
+            i = 0;
+        }
+    }
+    tbl->hash[i] = 0;
+
+    j = i;
+    while (1) {
+        if (++j == tbl->hash_size) {
+            j = 0;
+        }
+        if (tbl->hash[j] == 0) {
+            break;
+        }
+
+        /* Move entry at j into the hole unless its home lies in (i, j] */
+        home = tbl->advs[tbl->hash[j] - 1].sc_adv_hash;
+        if ((i <= j) ? ((i < home) && (home <= j)) :
+                       ((i < home) || (home <= j))) {
+            continue;
+        }
+        tbl->hash[i] = tbl->hash[j];
+        tbl->hash[j] = 0;
+        i = j;
+    }
+}
+
+/**
+ * Adds an advertiser to a list; the caller has checked that it is not on it
+ * already. If the list is full, the least recently used advertiser is
+ * dropped to make room.
+ *
+ * @return struct ble_ll_scan_advertisers* The new entry
+ */
+static struct ble_ll_scan_advertisers *
+ble_ll_scan_adv_tbl_add(struct ble_ll_scan_adv_tbl *tbl, uint8_t *addr,
+                        uint8_t txadd)
+{
+    uint8_t idx;
+    uint16_t slot;
+    struct ble_ll_scan_advertisers *adv;
+
+    if (tbl->num_advs < tbl->max_advs) {
+        idx = tbl->num_advs;
+        ++tbl->num_advs;
+    } else {
+        idx = tbl->lru_tail;
+        ble_ll_scan_adv_lru_unlink(tbl, idx);
+        ble_ll_scan_adv_hash_remove(tbl, idx);
+    }
+
+    adv = &tbl->advs[idx];
+    memcpy(&adv->adv_addr, addr, BLE_DEV_ADDR_LEN);
+    adv->sc_adv_flags = 0;
+    if (txadd) {
+        adv->sc_adv_flags |= BLE_LL_SC_ADV_F_RANDOM_ADDR;
+    }
+
+    /* Table has twice as many slots as entries so a free slot exists */
+    slot = ble_ll_scan_adv_hash(tbl, addr, txadd);
+    adv->sc_adv_hash = slot;
+    while (tbl->hash[slot] != 0) {
+        if (++slot == tbl->hash_size) {
+            slot = 0;
+        }
+    }
+    tbl->hash[slot] = idx + 1;
+
+    ble_ll_scan_adv_lru_push(tbl, idx);
+
+    return adv;
+}
+
 /**
  * Check if a packet is a duplicate advertising packet.
  *
@@ -249,7 +453,7 @@ ble_ll_scan_is_dup_adv(uint8_t pdu_type, uint8_t txadd, uint8_t *addr)
 {
     struct ble_ll_scan_advertisers *adv;
 
-    adv = ble_ll_scan_find_dup_adv(addr, txadd);
+    adv = ble_ll_scan_adv_tbl_find(&g_ble_ll_scan_dup_tbl, addr, txadd);
     if (adv) {
         /* Check appropriate flag (based on type of PDU) */
         if (pdu_type == BLE_ADV_PDU_TYPE_ADV_DIRECT_IND) {
@@ -278,27 +482,12 @@ ble_ll_scan_is_dup_adv(uint8_t pdu_type, uint8_t txadd, uint8_t *addr)
 void
 ble_ll_scan_add_dup_adv(uint8_t *addr, uint8_t txadd, uint8_t subev)
 {
-    uint8_t num_advs;
     struct ble_ll_scan_advertisers *adv;
 
     /* Check to see if on list. */
-    adv = ble_ll_scan_find_dup_adv(addr, txadd);
+    adv = ble_ll_scan_adv_tbl_find(&g_ble_ll_scan_dup_tbl, addr, txadd);
     if (!adv) {
-        /* XXX: for now, if we dont have room, just leave */
-        num_advs = g_ble_ll_scan_num_dup_advs;
-        if (num_advs == MYNEWT_VAL(BLE_LL_NUM_SCAN_DUP_ADVS)) {
-            return;
-        }
-
-        /* Add the advertiser to the array */
-        adv = &g_ble_ll_scan_dup_advs[num_advs];
-        memcpy(&adv->adv_addr, addr, BLE_DEV_ADDR_LEN);
-        ++g_ble_ll_scan_num_dup_advs;
-
-        adv->sc_adv_flags = 0;
-        if (txadd) {
-            adv->sc_adv_flags |= BLE_LL_SC_ADV_F_RANDOM_ADDR;
-        }
+        adv = ble_ll_scan_adv_tbl_add(&g_ble_ll_scan_dup_tbl, addr, txadd);
     }
 
     if (subev == BLE_HCI_LE_SUBEV_DIRECT_ADV_RPT) {
@@ -319,66 +508,400 @@ ble_ll_scan_add_dup_adv(uint8_t *addr, uint8_t txadd, uint8_t subev)
 static int
 ble_ll_scan_have_rxd_scan_rsp(uint8_t *addr, uint8_t txadd)
 {
-    uint8_t num_advs;
+    return ble_ll_scan_adv_tbl_find(&g_ble_ll_scan_rsp_tbl, addr,
+                                    txadd) != NULL;
+}
+
+static void
+ble_ll_scan_add_scan_rsp_adv(uint8_t *addr, uint8_t txadd)
+{
     struct ble_ll_scan_advertisers *adv;
 
-    /* Do we have an address match? Must match address type */
-    adv = &g_ble_ll_scan_rsp_advs[0];
-    num_advs = g_ble_ll_scan_num_rsp_advs;
-    while (num_advs) {
-        if (!memcmp(&adv->adv_addr, addr, BLE_DEV_ADDR_LEN)) {
-            /* Address type must match */
-            if (txadd) {
-                if (adv->sc_adv_flags & BLE_LL_SC_ADV_F_RANDOM_ADDR) {
-                    return 1;
-                }
-            } else {
-                if ((adv->sc_adv_flags & BLE_LL_SC_ADV_F_RANDOM_ADDR) == 0) {
-                    return 1;
-                }
+    /* Check if address is already on the list */
+    if (ble_ll_scan_have_rxd_scan_rsp(addr, txadd)) {
+        return;
+    }
+
+    /* Add the advertiser to the list */
+    adv = ble_ll_scan_adv_tbl_add(&g_ble_ll_scan_rsp_tbl, addr, txadd);
+    adv->sc_adv_flags |= BLE_LL_SC_ADV_F_SCAN_RSP_RXD;
+}
+
+#if MYNEWT_VAL(BLE_LL_SCAN_RPT_FILT_SIZE) > 0
+/* AD types examined by the advertising report filter */
+#define BLE_LL_ADV_AD_UUIDS16_INCOMP        (0x02)
+#define BLE_LL_ADV_AD_UUIDS16_COMP          (0x03)
+#define BLE_LL_ADV_AD_UUIDS32_INCOMP        (0x04)
+#define BLE_LL_ADV_AD_UUIDS32_COMP          (0x05)
+#define BLE_LL_ADV_AD_UUIDS128_INCOMP       (0x06)
+#define BLE_LL_ADV_AD_UUIDS128_COMP         (0x07)
+#define BLE_LL_ADV_AD_SVC_DATA_UUID16       (0x16)
+#define BLE_LL_ADV_AD_SVC_DATA_UUID32       (0x20)
+#define BLE_LL_ADV_AD_SVC_DATA_UUID128      (0x21)
+#define BLE_LL_ADV_AD_MFG_DATA              (0xff)
+
+struct ble_ll_scan_rpt_filt
+{
+    uint8_t type;
+    uint8_t len;
+    uint8_t val[16];
+};
+
+static struct ble_ll_scan_rpt_filt
+    g_ble_ll_scan_rpt_filts[MYNEWT_VAL(BLE_LL_SCAN_RPT_FILT_SIZE)];
+static uint8_t g_ble_ll_scan_rpt_filt_cnt;
+static uint8_t g_ble_ll_scan_rpt_filt_enabled;
+
+/**
+ * Checks whether a single AD field matches an advertising report filter.
+ *
+ * @param filt  The filter
+ * @param ad_type The AD type of the field
+ * @param field Pointer to the field data (after the AD type)
+ * @param len   Length of the field data
+ *
+ * @return int 1: match; 0 otherwise.
+ */
+static int
+ble_ll_scan_rpt_filt_field_match(struct ble_ll_scan_rpt_filt *filt,
+                                 uint8_t ad_type, uint8_t *field, uint8_t len)
+{
+    uint8_t off;
+    uint8_t list_type1;
+    uint8_t list_type2;
+    uint8_t svc_data_type;
+
+    switch (filt->type) {
+    case BLE_HCI_ADV_RPT_FILT_TYPE_MFG_ID:
+        return (ad_type == BLE_LL_ADV_AD_MFG_DATA) && (len >= filt->len) &&
+               !memcmp(field, filt->val, filt->len);
+    case BLE_HCI_ADV_RPT_FILT_TYPE_UUID16:
+        list_type1 = BLE_LL_ADV_AD_UUIDS16_INCOMP;
+        list_type2 = BLE_LL_ADV_AD_UUIDS16_COMP;
+        svc_data_type = BLE_LL_ADV_AD_SVC_DATA_UUID16;
+        break;
+    case BLE_HCI_ADV_RPT_FILT_TYPE_UUID32:
+        list_type1 = BLE_LL_ADV_AD_UUIDS32_INCOMP;
+        list_type2 = BLE_LL_ADV_AD_UUIDS32_COMP;
+        svc_data_type = BLE_LL_ADV_AD_SVC_DATA_UUID32;
+        break;
+    default:
+        list_type1 = BLE_LL_ADV_AD_UUIDS128_INCOMP;
+        list_type2 = BLE_LL_ADV_AD_UUIDS128_COMP;
+        svc_data_type = BLE_LL_ADV_AD_SVC_DATA_UUID128;
+        break;
+    }
+
+    /* Service data starts with the UUID */
+    if (ad_type == svc_data_type) {
+        return (len >= filt->len) && !memcmp(field, filt->val, filt->len);
+    }
+
+    /* Otherwise, look for the UUID in a service UUID list */
+    if ((ad_type == list_type1) || (ad_type == list_type2)) {
+        for (off = 0; off + filt->len <= len; off += filt->len) {
+            if (!memcmp(field + off, filt->val, filt->len)) {
+                return 1;
             }
         }
-        ++adv;
-        --num_advs;
     }
 
     return 0;
 }
 
+/**
+ * Checks the advertising data of a received PDU against the advertising
+ * report filters installed by the host.
+ *
+ * @param data  Pointer to advertising data
+ * @param len   Length of advertising data
+ *
+ * @return int 1: report should be sent to the host; 0: discard it.
+ */
+static int
+ble_ll_scan_rpt_filt_match(uint8_t *data, uint8_t len)
+{
+    int i;
+    uint8_t off;
+    uint8_t field_len;
+
+    if (!g_ble_ll_scan_rpt_filt_enabled) {
+        return 1;
+    }
+
+    off = 0;
+    while (off < len) {
+        field_len = data[off];
+        if ((field_len == 0) || (off + 1 + field_len > len)) {
+            break;
+        }
+
+        for (i = 0; i < g_ble_ll_scan_rpt_filt_cnt; ++i) {
+            if (ble_ll_scan_rpt_filt_field_match(&g_ble_ll_scan_rpt_filts[i],
+                                                 data[off + 1],
+                                                 data + off + 2,
+                                                 field_len - 1)) {
+                return 1;
+            }
+        }
+
+        off += field_len + 1;
+    }
+
+    return 0;
+}
+
+static int
+ble_ll_scan_rpt_filt_add(uint8_t *cmdbuf, uint8_t cmdlen)
+{
+    uint8_t type;
+    uint8_t len;
+    struct ble_ll_scan_rpt_filt *filt;
+
+    type = cmdbuf[0];
+    len = cmdbuf[1];
+    if (cmdlen != BLE_HCI_ADV_RPT_FILT_ADD_MIN_LEN - 2 + len) {
+        return BLE_ERR_INV_HCI_CMD_PARMS;
+    }
+
+    switch (type) {
+    case BLE_HCI_ADV_RPT_FILT_TYPE_MFG_ID:
+    case BLE_HCI_ADV_RPT_FILT_TYPE_UUID16:
+        if (len != 2) {
+            return BLE_ERR_INV_HCI_CMD_PARMS;
+        }
+        break;
+    case BLE_HCI_ADV_RPT_FILT_TYPE_UUID32:
+        if (len != 4) {
+            return BLE_ERR_INV_HCI_CMD_PARMS;
+        }
+        break;
+    case BLE_HCI_ADV_RPT_FILT_TYPE_UUID128:
+        if (len != 16) {
+            return BLE_ERR_INV_HCI_CMD_PARMS;
+        }
+        break;
+    default:
+        return BLE_ERR_INV_HCI_CMD_PARMS;
+    }
+
+    if (g_ble_ll_scan_rpt_filt_cnt == MYNEWT_VAL(BLE_LL_SCAN_RPT_FILT_SIZE)) {
+        return BLE_ERR_MEM_CAPACITY;
+    }
+
+    filt = &g_ble_ll_scan_rpt_filts[g_ble_ll_scan_rpt_filt_cnt];
+    filt->type = type;
+    filt->len = len;
+    memcpy(filt->val, cmdbuf + 2, len);
+    ++g_ble_ll_scan_rpt_filt_cnt;
+
+    return BLE_ERR_SUCCESS;
+}
+
+/**
+ * Process the vendor specific advertising report filter command.
+ *
+ * @param cmdbuf Pointer to command parameters (sub-command first)
+ * @param cmdlen Length of command parameters
+ * @param rspbuf Pointer to response buffer
+ * @param rsplen Pointer to response length
+ *
+ * @return int BLE error code
+ */
+int
+ble_ll_scan_rpt_filt_cmd(uint8_t *cmdbuf, uint8_t cmdlen, uint8_t *rspbuf,
+                         uint8_t *rsplen)
+{
+    int rc;
+    uint8_t subcmd;
+
+    /* NOTE: the command length includes the sub command byte */
+    rc = BLE_ERR_INV_HCI_CMD_PARMS;
+    subcmd = cmdbuf[0];
+    switch (subcmd) {
+    case BLE_HCI_ADV_RPT_FILT_CLEAR:
+        if (cmdlen == BLE_HCI_ADV_RPT_FILT_CLEAR_LEN) {
+            g_ble_ll_scan_rpt_filt_cnt = 0;
+            rc = BLE_ERR_SUCCESS;
+        }
+        break;
+    case BLE_HCI_ADV_RPT_FILT_ADD:
+        if (cmdlen >= BLE_HCI_ADV_RPT_FILT_ADD_MIN_LEN) {
+            rc = ble_ll_scan_rpt_filt_add(cmdbuf + 1, cmdlen - 1);
+        }
+        break;
+    case BLE_HCI_ADV_RPT_FILT_ENABLE:
+        if ((cmdlen == BLE_HCI_ADV_RPT_FILT_ENABLE_LEN) && (cmdbuf[1] <= 1)) {
+            g_ble_ll_scan_rpt_filt_enabled = cmdbuf[1];
+            rc = BLE_ERR_SUCCESS;
+        }
+        break;
+    default:
+        rc = BLE_ERR_UNKNOWN_HCI_CMD;
+        break;
+    }
+
+    rspbuf[0] = subcmd;
+    *rsplen = 1;
+
+    return rc;
+}
+#endif
+
+#if MYNEWT_VAL(BLE_LL_SCAN_RPT_BATCH_MAX) > 1
+/*
+ * Advertising reports waiting to be sent to the host in a single LE
+ * Advertising Report event. The HCI event lays out each report field as an
+ * array across all reports, so the reports are staged here and the event is
+ * built when the batch is flushed.
+ */
+struct ble_ll_scan_rpt
+{
+    uint8_t evtype;
+    uint8_t addr_type;
+    uint8_t addr[BLE_DEV_ADDR_LEN];
+    uint8_t data_len;
+    int8_t rssi;
+    uint8_t data[BLE_ADV_DATA_MAX_LEN];
+};
+
+/* Event parameter length of a single report, excluding its data. */
+#define BLE_LL_SCAN_RPT_LEN     (BLE_HCI_LE_ADV_RPT_MIN_LEN - 2)
+
+/* Largest event parameter length that fits in an event buffer */
+#if (MYNEWT_VAL(BLE_HCI_EVT_BUF_SIZE) - BLE_HCI_EVENT_HDR_LEN) > 255
+#define BLE_LL_SCAN_RPT_MAX_EVT_LEN     (255)
+#else
+#define BLE_LL_SCAN_RPT_MAX_EVT_LEN     \
+    (MYNEWT_VAL(BLE_HCI_EVT_BUF_SIZE) - BLE_HCI_EVENT_HDR_LEN)
+#endif
+
+static struct ble_ll_scan_rpt
+    g_ble_ll_scan_rpts[MYNEWT_VAL(BLE_LL_SCAN_RPT_BATCH_MAX)];
+static uint8_t g_ble_ll_scan_num_rpts;
+static uint8_t g_ble_ll_scan_rpt_evlen;
+static struct os_callout g_ble_ll_scan_rpt_timer;
+
+/**
+ * Sends all staged advertising reports to the host in one event.
+ *
+ * Context: Link Layer task.
+ */
 static void
-ble_ll_scan_add_scan_rsp_adv(uint8_t *addr, uint8_t txadd)
+ble_ll_scan_rpt_flush(void)
 {
-    uint8_t num_advs;
-    struct ble_ll_scan_advertisers *adv;
+    int i;
+    uint8_t num;
+    uint8_t *evbuf;
+    uint8_t *dptr;
+    struct ble_ll_scan_rpt *rpt;
 
-    /* XXX: for now, if we dont have room, just leave */
-    num_advs = g_ble_ll_scan_num_rsp_advs;
-    if (num_advs == MYNEWT_VAL(BLE_LL_NUM_SCAN_RSP_ADVS)) {
+    num = g_ble_ll_scan_num_rpts;
+    if (num == 0) {
         return;
     }
 
-    /* Check if address is already on the list */
-    if (ble_ll_scan_have_rxd_scan_rsp(addr, txadd)) {
+    os_callout_stop(&g_ble_ll_scan_rpt_timer);
+    g_ble_ll_scan_num_rpts = 0;
+
+    evbuf = ble_hci_trans_buf_alloc(BLE_HCI_TRANS_BUF_EVT_LO);
+    if (!evbuf) {
         return;
     }
 
-    /* Add the advertiser to the array */
-    adv = &g_ble_ll_scan_rsp_advs[num_advs];
-    memcpy(&adv->adv_addr, addr, BLE_DEV_ADDR_LEN);
-    adv->sc_adv_flags = BLE_LL_SC_ADV_F_SCAN_RSP_RXD;
-    if (txadd) {
-        adv->sc_adv_flags |= BLE_LL_SC_ADV_F_RANDOM_ADDR;
+    evbuf[0] = BLE_HCI_EVCODE_LE_META;
+    evbuf[1] = g_ble_ll_scan_rpt_evlen;
+    evbuf[2] = BLE_HCI_LE_SUBEV_ADV_RPT;
+    evbuf[3] = num;
+    dptr = evbuf + 4;
+
+    for (i = 0; i < num; ++i) {
+        dptr[i] = g_ble_ll_scan_rpts[i].evtype;
     }
-    ++g_ble_ll_scan_num_rsp_advs;
+    dptr += num;
 
-    return;
+    for (i = 0; i < num; ++i) {
+        dptr[i] = g_ble_ll_scan_rpts[i].addr_type;
+    }
+    dptr += num;
+
+    for (i = 0; i < num; ++i) {
+        memcpy(dptr, g_ble_ll_scan_rpts[i].addr, BLE_DEV_ADDR_LEN);
+        dptr += BLE_DEV_ADDR_LEN;
+    }
+
+    for (i = 0; i < num; ++i) {
+        dptr[i] = g_ble_ll_scan_rpts[i].data_len;
+    }
+    dptr += num;
+
+    for (i = 0; i < num; ++i) {
+        rpt = &g_ble_ll_scan_rpts[i];
+        memcpy(dptr, rpt->data, rpt->data_len);
+        dptr += rpt->data_len;
+    }
+
+    for (i = 0; i < num; ++i) {
+        dptr[i] = g_ble_ll_scan_rpts[i].rssi;
+    }
+
+    ble_ll_hci_event_send(evbuf);
+}
+
+static void
+ble_ll_scan_rpt_timer_cb(struct os_event *ev)
+{
+    ble_ll_scan_rpt_flush();
+}
+
+/**
+ * Adds an advertising report to the current batch, sending the batch first
+ * if the report would not fit in the same event.
+ */
+static void
+ble_ll_scan_rpt_add(uint8_t evtype, uint8_t addr_type, uint8_t *addr,
+                    uint8_t *data, uint8_t data_len, int8_t rssi)
+{
+    uint32_t ticks;
+    struct ble_ll_scan_rpt *rpt;
+
+    if (g_ble_ll_scan_num_rpts &&
+        (g_ble_ll_scan_rpt_evlen + BLE_LL_SCAN_RPT_LEN + data_len >
+         BLE_LL_SCAN_RPT_MAX_EVT_LEN)) {
+        ble_ll_scan_rpt_flush();
+    }
+
+    if (g_ble_ll_scan_num_rpts == 0) {
+        /* Subevent code and number of reports */
+        g_ble_ll_scan_rpt_evlen = 2;
+    }
+
+    rpt = &g_ble_ll_scan_rpts[g_ble_ll_scan_num_rpts];
+    rpt->evtype = evtype;
+    rpt->addr_type = addr_type;
+    memcpy(rpt->addr, addr, BLE_DEV_ADDR_LEN);
+    rpt->data_len = data_len;
+    rpt->rssi = rssi;
+    memcpy(rpt->data, data, data_len);
+
+    ++g_ble_ll_scan_num_rpts;
+    g_ble_ll_scan_rpt_evlen += BLE_LL_SCAN_RPT_LEN + data_len;
+
+    if (g_ble_ll_scan_num_rpts == MYNEWT_VAL(BLE_LL_SCAN_RPT_BATCH_MAX)) {
+        ble_ll_scan_rpt_flush();
+    } else if (g_ble_ll_scan_num_rpts == 1) {
+        os_time_ms_to_ticks(MYNEWT_VAL(BLE_LL_SCAN_RPT_BATCH_MS), &ticks);
+        os_callout_reset(&g_ble_ll_scan_rpt_timer, ticks);
+    }
 }
+#endif
 
 /**
  * Send an advertising report to the host.
  *
- * NOTE: while we are allowed to send multiple devices in one report, we
- * will just send for one for now.
+ * NOTE: undirected reports may be held back and batched with other reports
+ * (see BLE_LL_SCAN_RPT_BATCH_MAX); direct advertising reports are always
+ * sent immediately.
  *
  * @param pdu_type
  * @param txadd
@@ -434,65 +957,91 @@ ble_ll_hci_send_adv_report(uint8_t pdu_type, uint8_t txadd, uint8_t *rxbuf,
         event_len = BLE_HCI_LE_ADV_RPT_MIN_LEN + adv_data_len;
     }
 
-    if (ble_ll_hci_is_le_event_enabled(subev)) {
-        evbuf = ble_hci_trans_buf_alloc(BLE_HCI_TRANS_BUF_EVT_LO);
-        if (evbuf) {
-            evbuf[0] = BLE_HCI_EVCODE_LE_META;
-            evbuf[1] = event_len;
-            evbuf[2] = subev;
-            evbuf[3] = 1;       /* number of reports */
-            evbuf[4] = evtype;
+    if (!ble_ll_hci_is_le_event_enabled(subev)) {
+        return;
+    }
 
-            if (txadd) {
-                addr_type = BLE_HCI_ADV_OWN_ADDR_RANDOM;
-            } else {
-                addr_type = BLE_HCI_ADV_OWN_ADDR_PUBLIC;
-            }
+    if (txadd) {
+        addr_type = BLE_HCI_ADV_OWN_ADDR_RANDOM;
+    } else {
+        addr_type = BLE_HCI_ADV_OWN_ADDR_PUBLIC;
+    }
 
-            rxbuf += BLE_LL_PDU_HDR_LEN;
+    rxbuf += BLE_LL_PDU_HDR_LEN;
 #if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PRIVACY)
-            if (BLE_MBUF_HDR_RESOLVED(hdr)) {
-                index = scansm->scan_rpa_index;
-                adv_addr = g_ble_ll_resolv_list[index].rl_identity_addr;
-                /*
-                 * NOTE: this looks a bit odd, but the resolved address types
-                 * are 2 greater than the unresolved ones in the spec, so
-                 * we just add 2 here.
-                 */
-                addr_type = g_ble_ll_resolv_list[index].rl_addr_type + 2;
-            } else {
-                adv_addr = rxbuf;
-            }
+    if (BLE_MBUF_HDR_RESOLVED(hdr)) {
+        index = scansm->scan_rpa_index;
+        adv_addr = g_ble_ll_resolv_list[index].rl_identity_addr;
+        /*
+         * NOTE: this looks a bit odd, but the resolved address types
+         * are 2 greater than the unresolved ones in the spec, so
+         * we just add 2 here.
+         */
+        addr_type = g_ble_ll_resolv_list[index].rl_addr_type + 2;
+    } else {
+        adv_addr = rxbuf;
+    }
 #else
-            adv_addr = rxbuf;
+    adv_addr = rxbuf;
 #endif
 
-            orig_evbuf = evbuf;
-            evbuf += 5;
+#if MYNEWT_VAL(BLE_LL_SCAN_RPT_FILT_SIZE) > 0
+    if (!inita &&
+        !ble_ll_scan_rpt_filt_match(rxbuf + BLE_DEV_ADDR_LEN, adv_data_len)) {
+        return;
+    }
+#endif
 
-            /* The advertisers address type and address are always in event */
-            evbuf[0] = addr_type;
-            memcpy(evbuf + 1, adv_addr, BLE_DEV_ADDR_LEN);
-            evbuf += BLE_DEV_ADDR_LEN + 1;
+#if MYNEWT_VAL(BLE_LL_SCAN_RPT_BATCH_MAX) > 1
+    if (!inita) {
+        ble_ll_scan_rpt_add(evtype, addr_type, adv_addr,
+                            rxbuf + BLE_DEV_ADDR_LEN, adv_data_len,
+                            hdr->rxinfo.rssi);
 
-            if (inita) {
-                evbuf[0] = BLE_HCI_ADV_OWN_ADDR_RANDOM;
-                memcpy(evbuf + 1, inita, BLE_DEV_ADDR_LEN);
-                evbuf += BLE_DEV_ADDR_LEN + 1;
-            } else {
-                evbuf[0] = adv_data_len;
-                memcpy(evbuf + 1, rxbuf + BLE_DEV_ADDR_LEN, adv_data_len);
-                evbuf += adv_data_len + 1;
-            }
+        /*
+         * The report is now owned by the batch; it counts as sent for
+         * duplicate filtering.
+         */
+        if (scansm->scan_filt_dups) {
+            ble_ll_scan_add_dup_adv(adv_addr, txadd, subev);
+        }
+        return;
+    }
+#endif
 
-            evbuf[0] = hdr->rxinfo.rssi;
+    evbuf = ble_hci_trans_buf_alloc(BLE_HCI_TRANS_BUF_EVT_LO);
+    if (evbuf) {
+        evbuf[0] = BLE_HCI_EVCODE_LE_META;
+        evbuf[1] = event_len;
+        evbuf[2] = subev;
+        evbuf[3] = 1;       /* number of reports */
+        evbuf[4] = evtype;
+
+        orig_evbuf = evbuf;
+        evbuf += 5;
+
+        /* The advertisers address type and address are always in event */
+        evbuf[0] = addr_type;
+        memcpy(evbuf + 1, adv_addr, BLE_DEV_ADDR_LEN);
+        evbuf += BLE_DEV_ADDR_LEN + 1;
+
+        if (inita) {
+            evbuf[0] = BLE_HCI_ADV_OWN_ADDR_RANDOM;
+            memcpy(evbuf + 1, inita, BLE_DEV_ADDR_LEN);
+            evbuf += BLE_DEV_ADDR_LEN + 1;
+        } else {
+            evbuf[0] = adv_data_len;
+            memcpy(evbuf + 1, rxbuf + BLE_DEV_ADDR_LEN, adv_data_len);
+            evbuf += adv_data_len + 1;
+        }
 
-            rc = ble_ll_hci_event_send(orig_evbuf);
-            if (!rc) {
-                /* If filtering, add it to list of duplicate addresses */
-                if (scansm->scan_filt_dups) {
-                    ble_ll_scan_add_dup_adv(adv_addr, txadd, subev);
-                }
+        evbuf[0] = hdr->rxinfo.rssi;
+
+        rc = ble_ll_hci_event_send(orig_evbuf);
+        if (!rc) {
+            /* If filtering, add it to list of duplicate addresses */
+            if (scansm->scan_filt_dups) {
+                ble_ll_scan_add_dup_adv(adv_addr, txadd, subev);
             }
         }
     }
@@ -581,6 +1130,11 @@ ble_ll_scan_start(struct ble_ll_scan_sm *scansm, uint8_t chan)
     rc = ble_phy_setchan(chan, 0, 0);
     assert(rc == 0);
 
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_2M_PHY) == 1)
+    /* Scanning always uses the 1M PHY */
+    ble_phy_mode_set(BLE_PHY_MODE_1M);
+#endif
+
     /*
      * Set transmit end callback to NULL in case we transmit a scan request.
      * There is a callback for the connect request.
@@ -784,8 +1338,8 @@ ble_ll_scan_sm_start(struct ble_ll_scan_sm *scansm)
     scansm->scan_rsp_pending = 0;
 
     /* Forget filtered advertisers from previous scan. */
-    g_ble_ll_scan_num_rsp_advs = 0;
-    g_ble_ll_scan_num_dup_advs = 0;
+    ble_ll_scan_adv_tbl_reset(&g_ble_ll_scan_rsp_tbl);
+    ble_ll_scan_adv_tbl_reset(&g_ble_ll_scan_dup_tbl);
 
     /* XXX: align to current or next slot???. */
     /* Schedule start time now */
@@ -1109,7 +1663,7 @@ ble_ll_scan_rx_isr_end(struct os_mbuf *rxpdu, uint8_t crcok)
     index = -1;
 #if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PRIVACY) == 1)
     if (ble_ll_is_rpa(peer, peer_addr_type) && ble_ll_resolv_enabled()) {
-        index = ble_hw_resolv_list_match();
+        index = ble_ll_resolv_peer_rpa_match(peer);
         if (index >= 0) {
             ble_hdr->rxinfo.flags |= BLE_MBUF_HDR_F_RESOLVED;
             peer = g_ble_ll_resolv_list[index].rl_identity_addr;
@@ -1443,6 +1997,10 @@ ble_ll_scan_set_enable(uint8_t *cmd)
         if (scansm->scan_enabled) {
             ble_ll_scan_sm_stop(1);
         }
+#if MYNEWT_VAL(BLE_LL_SCAN_RPT_BATCH_MAX) > 1
+        /* Deliver any reports still waiting for a batch to fill */
+        ble_ll_scan_rpt_flush();
+#endif
     }
 
     return rc;
@@ -1585,12 +2143,24 @@ ble_ll_scan_reset(void)
     os_mbuf_free_chain(scansm->scan_req_pdu);
 
     /* Reset duplicate advertisers and those from which we rxd a response */
-    g_ble_ll_scan_num_rsp_advs = 0;
+    ble_ll_scan_adv_tbl_reset(&g_ble_ll_scan_rsp_tbl);
     memset(&g_ble_ll_scan_rsp_advs[0], 0, sizeof(g_ble_ll_scan_rsp_advs));
 
-    g_ble_ll_scan_num_dup_advs = 0;
+    ble_ll_scan_adv_tbl_reset(&g_ble_ll_scan_dup_tbl);
     memset(&g_ble_ll_scan_dup_advs[0], 0, sizeof(g_ble_ll_scan_dup_advs));
 
+#if MYNEWT_VAL(BLE_LL_SCAN_RPT_BATCH_MAX) > 1
+    /* Drop any batched reports */
+    os_callout_stop(&g_ble_ll_scan_rpt_timer);
+    g_ble_ll_scan_num_rpts = 0;
+#endif
+
+#if MYNEWT_VAL(BLE_LL_SCAN_RPT_FILT_SIZE) > 0
+    /* Remove advertising report filters */
+    g_ble_ll_scan_rpt_filt_cnt = 0;
+    g_ble_ll_scan_rpt_filt_enabled = 0;
+#endif
+
     /* Call the init function again */
     ble_ll_scan_init();
 }
@@ -1626,6 +2196,12 @@ ble_ll_scan_init(void)
     /* Initialize scanning timer */
     os_cputime_timer_init(&scansm->scan_timer, ble_ll_scan_timer_cb, scansm);
 
+#if MYNEWT_VAL(BLE_LL_SCAN_RPT_BATCH_MAX) > 1
+    /* Initialize the advertising report batch timer */
+    os_callout_init(&g_ble_ll_scan_rpt_timer, &g_ble_ll_data.ll_evq,
+                    ble_ll_scan_rpt_timer_cb, NULL);
+#endif
+
     /* Get a scan request mbuf (packet header) and attach to state machine */
     scansm->scan_req_pdu = os_msys_get_pkthdr(BLE_SCAN_MAX_PKT_LEN,
                                               sizeof(struct ble_mbuf_hdr));
@@ -278,6 +278,66 @@ ble_ll_sched_conn_reschedule(struct ble_ll_conn_sm *connsm)
     return rc;
 }
 
+#if MYNEWT_VAL(BLE_LL_SCHED_MASTER_POLICY) == BLE_LL_SCHED_POLICY_PACKED
+/**
+ * Looks for a place to start a new master connection directly after the end
+ * of an already scheduled connection event. The new event must fit before
+ * the next item in the schedule and start within one connection interval of
+ * the earliest possible start time.
+ *
+ * Context: Interrupt, with interrupts disabled.
+ *
+ * @param connsm        The new connection.
+ * @param initial_start Earliest possible start time of the new connection.
+ * @param dur           Duration of the new connection event, in ticks.
+ * @param itvl_t        Connection interval of the new connection, in ticks.
+ * @param match_itvl    Only pack after connections with the same interval.
+ * @param out_start     On success, the start time is written here.
+ *
+ * @return struct ble_ll_sched_item* Item to insert after; NULL if none.
+ */
+static struct ble_ll_sched_item *
+ble_ll_sched_master_pack(struct ble_ll_conn_sm *connsm, uint32_t initial_start,
+                         uint32_t dur, uint32_t itvl_t, int match_itvl,
+                         uint32_t *out_start)
+{
+    uint32_t start;
+    struct ble_ll_conn_sm *entry_connsm;
+    struct ble_ll_sched_item *entry;
+    struct ble_ll_sched_item *next;
+
+    TAILQ_FOREACH(entry, &g_ble_ll_sched_q, link) {
+        if (entry->sched_type != BLE_LL_SCHED_TYPE_CONN) {
+            continue;
+        }
+
+        start = entry->end_time;
+        if ((int32_t)(start - initial_start) < 0) {
+            continue;
+        }
+        if ((start - initial_start) > itvl_t) {
+            break;
+        }
+
+        entry_connsm = (struct ble_ll_conn_sm *)entry->cb_arg;
+        if (match_itvl && (entry_connsm->conn_itvl != connsm->conn_itvl)) {
+            continue;
+        }
+
+        /* Items do not overlap, so only the next one can be in the way */
+        next = TAILQ_NEXT(entry, link);
+        if (next && ((int32_t)(start + dur - next->start_time) > 0)) {
+            continue;
+        }
+
+        *out_start = start;
+        return entry;
+    }
+
+    return NULL;
+}
+#endif
+
 /**
  * Called to schedule a connection when the current role is master.
  *
@@ -389,33 +449,50 @@ ble_ll_sched_master_new(struct ble_ll_conn_sm *connsm,
         connsm->tx_win_off = MYNEWT_VAL(BLE_LL_CONN_INIT_MIN_WIN_OFFSET);
     } else {
         os_cputime_timer_stop(&g_ble_ll_sched_timer);
-        TAILQ_FOREACH(entry, &g_ble_ll_sched_q, link) {
-            /* Set these because overlap function needs them to be set */
-            sch->start_time = earliest_start;
-            sch->end_time = earliest_end;
 
-            /* We can insert if before entry in list */
-            if ((int32_t)(sch->end_time - entry->start_time) <= 0) {
-                if ((earliest_start - initial_start) <= itvl_t) {
-                    rc = 0;
-                    TAILQ_INSERT_BEFORE(entry, sch, link);
+#if MYNEWT_VAL(BLE_LL_SCHED_MASTER_POLICY) == BLE_LL_SCHED_POLICY_PACKED
+        entry = ble_ll_sched_master_pack(connsm, initial_start, dur, itvl_t, 1,
+                                         &earliest_start);
+        if (!entry) {
+            entry = ble_ll_sched_master_pack(connsm, initial_start, dur,
+                                             itvl_t, 0, &earliest_start);
+        }
+        if (entry) {
+            rc = 0;
+            earliest_end = earliest_start + dur;
+            TAILQ_INSERT_AFTER(&g_ble_ll_sched_q, entry, sch, link);
+        }
+#endif
+
+        if (rc) {
+            TAILQ_FOREACH(entry, &g_ble_ll_sched_q, link) {
+                /* Set these because overlap function needs them to be set */
+                sch->start_time = earliest_start;
+                sch->end_time = earliest_end;
+
+                /* We can insert if before entry in list */
+                if ((int32_t)(sch->end_time - entry->start_time) <= 0) {
+                    if ((earliest_start - initial_start) <= itvl_t) {
+                        rc = 0;
+                        TAILQ_INSERT_BEFORE(entry, sch, link);
+                    }
+                    break;
                 }
-                break;
-            }
 
-            /* Check for overlapping events */
-            if (ble_ll_sched_is_overlap(sch, entry)) {
-                /* Earliest start is end of this event since we overlap */
-                earliest_start = entry->end_time;
-                earliest_end = earliest_start + dur;
+                /* Check for overlapping events */
+                if (ble_ll_sched_is_overlap(sch, entry)) {
+                    /* Earliest start is end of this event since we overlap */
+                    earliest_start = entry->end_time;
+                    earliest_end = earliest_start + dur;
+                }
             }
-        }
 
-        /* Must be able to schedule within one connection interval */
-        if (!entry) {
-            if ((earliest_start - initial_start) <= itvl_t) {
-                rc = 0;
-                TAILQ_INSERT_TAIL(&g_ble_ll_sched_q, sch, link);
+            /* Must be able to schedule within one connection interval */
+            if (!entry) {
+                if ((earliest_start - initial_start) <= itvl_t) {
+                    rc = 0;
+                    TAILQ_INSERT_TAIL(&g_ble_ll_sched_q, sch, link);
+                }
             }
         }
 
@@ -583,6 +660,51 @@ ble_ll_sched_slave_new(struct ble_ll_conn_sm *connsm)
     return rc;
 }
 
+#if MYNEWT_VAL(BLE_LL_ADV_SCHED_PACK)
+/**
+ * Looks for a place to start an advertising event directly after the end of
+ * another, already scheduled, advertising event (e.g. another advertising
+ * instance). The event must start no later than 'window' ticks after the
+ * requested start time and fit before the next item in the schedule.
+ *
+ * Context: Interrupt, with interrupts disabled.
+ *
+ * @param start         Requested start time of the advertising event.
+ * @param window        Maximum delay allowed past 'start', in ticks.
+ * @param dur           Duration of the advertising event, in ticks.
+ *
+ * @return struct ble_ll_sched_item* Item to insert after; NULL if none.
+ */
+static struct ble_ll_sched_item *
+ble_ll_sched_adv_pack(uint32_t start, uint32_t window, uint32_t dur)
+{
+    struct ble_ll_sched_item *entry;
+    struct ble_ll_sched_item *next;
+
+    TAILQ_FOREACH(entry, &g_ble_ll_sched_q, link) {
+        if ((int32_t)(entry->end_time - start) < 0) {
+            continue;
+        }
+        if ((entry->end_time - start) > window) {
+            break;
+        }
+        if (entry->sched_type != BLE_LL_SCHED_TYPE_ADV) {
+            continue;
+        }
+
+        /* Items do not overlap, so only the next one can be in the way */
+        next = TAILQ_NEXT(entry, link);
+        if (next && ((int32_t)(entry->end_time + dur - next->start_time) > 0)) {
+            continue;
+        }
+
+        return entry;
+    }
+
+    return NULL;
+}
+#endif
+
 int
 ble_ll_sched_adv_new(struct ble_ll_sched_item *sch)
 {
@@ -605,6 +727,20 @@ ble_ll_sched_adv_new(struct ble_ll_sched_item *sch)
     } else {
         /* XXX: no need to stop timer if not first on list. Modify code? */
         os_cputime_timer_stop(&g_ble_ll_sched_timer);
+
+#if MYNEWT_VAL(BLE_LL_ADV_SCHED_PACK)
+        /* Start back-to-back with another advertising instance if we can */
+        entry = ble_ll_sched_adv_pack(sch->start_time,
+                    os_cputime_usecs_to_ticks(BLE_LL_ADV_DELAY_MS_MAX * 1000),
+                    duration);
+        if (entry) {
+            rc = 0;
+            sch->start_time = entry->end_time;
+            sch->end_time = sch->start_time + duration;
+            TAILQ_INSERT_AFTER(&g_ble_ll_sched_q, entry, sch, link);
+            STATS_INC(ble_ll_stats, sched_adv_packed);
+        } else
+#endif
         TAILQ_FOREACH(entry, &g_ble_ll_sched_q, link) {
             /* We can insert if before entry in list */
             if ((int32_t)(sch->end_time - entry->start_time) <= 0) {
@@ -679,6 +815,27 @@ ble_ll_sched_adv_reschedule(struct ble_ll_sched_item *sch, uint32_t *start,
     OS_ENTER_CRITICAL(sr);
 
     entry = ble_ll_sched_insert_if_empty(sch);
+#if MYNEWT_VAL(BLE_LL_ADV_SCHED_PACK)
+    /*
+     * Rather than a random advDelay, start right after another advertising
+     * event that ends within the allowed delay. Events of all advertising
+     * instances then run back-to-back and the radio wakes up less often.
+     */
+    if (entry && max_delay_ticks) {
+        entry = ble_ll_sched_adv_pack(sch->start_time, max_delay_ticks,
+                                      duration);
+        if (entry) {
+            os_cputime_timer_stop(&g_ble_ll_sched_timer);
+            sch->start_time = entry->end_time;
+            TAILQ_INSERT_AFTER(&g_ble_ll_sched_q, entry, sch, link);
+            STATS_INC(ble_ll_stats, sched_adv_packed);
+            rand_ticks = 0;
+            entry = NULL;
+        } else {
+            entry = TAILQ_FIRST(&g_ble_ll_sched_q);
+        }
+    }
+#endif
     if (entry) {
         os_cputime_timer_stop(&g_ble_ll_sched_timer);
         while (1) {
@@ -757,7 +914,7 @@ ble_ll_sched_adv_reschedule(struct ble_ll_sched_item *sch, uint32_t *start,
     if (!rc) {
         sch->enqueued = 1;
         if (rand_ticks) {
-            sch->start_time += rand() % rand_ticks;
+            sch->start_time += ble_ll_rand() % rand_ticks;
         }
         sch->end_time = sch->start_time + duration;
         *start = sch->start_time;
@@ -856,7 +1013,7 @@ ble_ll_sched_rmv_elem(struct ble_ll_sched_item *sch)
  *
  * @return int 0: schedule item is not over; otherwise schedule item is done.
  */
-static int
+static BLE_LL_RAMFUNC int
 ble_ll_sched_execute_item(struct ble_ll_sched_item *sch)
 {
     int rc;
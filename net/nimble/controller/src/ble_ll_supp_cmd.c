@@ -165,7 +165,23 @@
 
 /* Octet 35 */
 #define BLE_SUPP_CMD_LE_RD_MAX_DATALEN      (1 << 3)
-#define BLE_LL_SUPP_CMD_OCTET_35            (BLE_SUPP_CMD_LE_RD_MAX_DATALEN)
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_2M_PHY) == 1)
+#define BLE_SUPP_CMD_LE_READ_PHY            (1 << 4)
+#define BLE_SUPP_CMD_LE_SET_DEFAULT_PHY     (1 << 5)
+#define BLE_SUPP_CMD_LE_SET_PHY             (1 << 6)
+#else
+#define BLE_SUPP_CMD_LE_READ_PHY            (0 << 4)
+#define BLE_SUPP_CMD_LE_SET_DEFAULT_PHY     (0 << 5)
+#define BLE_SUPP_CMD_LE_SET_PHY             (0 << 6)
+#endif
+
+#define BLE_LL_SUPP_CMD_OCTET_35            \
+(                                           \
+    BLE_SUPP_CMD_LE_RD_MAX_DATALEN      |   \
+    BLE_SUPP_CMD_LE_READ_PHY            |   \
+    BLE_SUPP_CMD_LE_SET_DEFAULT_PHY     |   \
+    BLE_SUPP_CMD_LE_SET_PHY                 \
+)
 
 /* Defines the array of supported commands */
 const uint8_t g_ble_ll_supp_cmds[BLE_LL_SUPP_CMD_LEN] =
@@ -30,20 +30,41 @@
 #include "controller/ble_ll_scan.h"
 #include "controller/ble_hw.h"
 
-#if (MYNEWT_VAL(BLE_LL_WHITELIST_SIZE) < BLE_HW_WHITE_LIST_SIZE)
-#define BLE_LL_WHITELIST_SIZE       MYNEWT_VAL(BLE_LL_WHITELIST_SIZE)
+/*
+ * The hardware whitelist is not used if the whitelist is configured to live
+ * in software only; this allows the whitelist to be larger than the hardware
+ * one.
+ */
+#if (BLE_USES_HW_WHITELIST == 1) && (MYNEWT_VAL(BLE_LL_WHITELIST_SW) == 0)
+#define BLE_LL_USES_HW_WHITELIST    (1)
 #else
+#define BLE_LL_USES_HW_WHITELIST    (0)
+#endif
+
+#if (BLE_LL_USES_HW_WHITELIST == 1) && \
+    (MYNEWT_VAL(BLE_LL_WHITELIST_SIZE) > BLE_HW_WHITE_LIST_SIZE)
 #define BLE_LL_WHITELIST_SIZE       BLE_HW_WHITE_LIST_SIZE
+#else
+#define BLE_LL_WHITELIST_SIZE       MYNEWT_VAL(BLE_LL_WHITELIST_SIZE)
+#endif
+
+/* The size is reported to the host in a single byte */
+#if (BLE_LL_WHITELIST_SIZE > 255)
+    #error "Cannot have more than 255 whitelist entries!"
 #endif
 
 struct ble_ll_whitelist_entry
 {
-    uint8_t wl_valid;
     uint8_t wl_addr_type;
     uint8_t wl_dev_addr[BLE_DEV_ADDR_LEN];
 };
 
+/*
+ * The whitelist is kept sorted by address type and address so that it can
+ * be searched with a binary search from the receive ISRs.
+ */
 struct ble_ll_whitelist_entry g_ble_ll_whitelist[BLE_LL_WHITELIST_SIZE];
+static uint8_t g_ble_ll_whitelist_cnt;
 
 static int
 ble_ll_whitelist_chg_allowed(void)
@@ -72,22 +93,15 @@ ble_ll_whitelist_chg_allowed(void)
 int
 ble_ll_whitelist_clear(void)
 {
-    int i;
-    struct ble_ll_whitelist_entry *wl;
-
     /* Check proper state */
     if (!ble_ll_whitelist_chg_allowed()) {
         return BLE_ERR_CMD_DISALLOWED;
     }
 
     /* Set the number of entries to 0 */
-    wl = &g_ble_ll_whitelist[0];
-    for (i = 0; i < BLE_LL_WHITELIST_SIZE; ++i) {
-        wl->wl_valid = 0;
-        ++wl;
-    }
+    g_ble_ll_whitelist_cnt = 0;
 
-#if (BLE_USES_HW_WHITELIST == 1)
+#if (BLE_LL_USES_HW_WHITELIST == 1)
     ble_hw_whitelist_clear();
 #endif
 
@@ -110,6 +124,62 @@ ble_ll_whitelist_read_size(uint8_t *rspbuf, uint8_t *rsplen)
     return BLE_ERR_SUCCESS;
 }
 
+/**
+ * Compares an address against a whitelist entry, using the order in which
+ * the whitelist is sorted.
+ *
+ * @return int <0, 0 or >0 if the address sorts before, equal or after wl.
+ */
+static int
+ble_ll_whitelist_cmp(struct ble_ll_whitelist_entry *wl, uint8_t *addr,
+                     uint8_t addr_type)
+{
+    if (addr_type != wl->wl_addr_type) {
+        return (int)addr_type - (int)wl->wl_addr_type;
+    }
+
+    return memcmp(addr, &wl->wl_dev_addr[0], BLE_DEV_ADDR_LEN);
+}
+
+/**
+ * Finds the whitelist position of an address.
+ *
+ * @param addr      Device or identity address to look for.
+ * @param addr_type Public address (0) or random address (1)
+ * @param out_index The index of the matching entry, or where the address
+ *                  would have to be inserted, is written here.
+ *
+ * @return int 1: address found; 0 otherwise.
+ */
+static int
+ble_ll_whitelist_bsearch(uint8_t *addr, uint8_t addr_type, int *out_index)
+{
+    int lo;
+    int hi;
+    int mid;
+    int cmp;
+
+    lo = 0;
+    hi = g_ble_ll_whitelist_cnt;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        cmp = ble_ll_whitelist_cmp(&g_ble_ll_whitelist[mid], addr, addr_type);
+        if (cmp == 0) {
+            *out_index = mid;
+            return 1;
+        }
+
+        if (cmp < 0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+
+    *out_index = lo;
+    return 0;
+}
+
 /**
  * Searches the whitelist to determine if the address is present in the
  * whitelist. This is an internal API that only searches the link layer
@@ -125,16 +195,10 @@ ble_ll_whitelist_read_size(uint8_t *rspbuf, uint8_t *rsplen)
 static int
 ble_ll_whitelist_search(uint8_t *addr, uint8_t addr_type)
 {
-    int i;
-    struct ble_ll_whitelist_entry *wl;
+    int index;
 
-    wl = &g_ble_ll_whitelist[0];
-    for (i = 0; i < BLE_LL_WHITELIST_SIZE; ++i) {
-        if ((wl->wl_valid) && (wl->wl_addr_type == addr_type) &&
-            (!memcmp(&wl->wl_dev_addr[0], addr, BLE_DEV_ADDR_LEN))) {
-            return i + 1;
-        }
-        ++wl;
+    if (ble_ll_whitelist_bsearch(addr, addr_type, &index)) {
+        return index + 1;
     }
 
     return 0;
@@ -157,7 +221,7 @@ int
 ble_ll_whitelist_match(uint8_t *addr, uint8_t addr_type, int is_ident)
 {
     int rc;
-#if (BLE_USES_HW_WHITELIST == 1)
+#if (BLE_LL_USES_HW_WHITELIST == 1)
     /*
      * XXX: This should be changed. This is HW specific: some HW may be able
      * to both resolve a private address and perform a whitelist check. The
@@ -182,8 +246,8 @@ ble_ll_whitelist_match(uint8_t *addr, uint8_t addr_type, int is_ident)
 int
 ble_ll_whitelist_add(uint8_t *addr, uint8_t addr_type)
 {
-    int i;
     int rc;
+    int index;
     struct ble_ll_whitelist_entry *wl;
 
     /* Must be in proper state */
@@ -193,25 +257,22 @@ ble_ll_whitelist_add(uint8_t *addr, uint8_t addr_type)
 
     /* Check if we have any open entries */
     rc = BLE_ERR_SUCCESS;
-    if (!ble_ll_whitelist_search(addr, addr_type)) {
-        wl = &g_ble_ll_whitelist[0];
-        for (i = 0; i < BLE_LL_WHITELIST_SIZE; ++i) {
-            if (wl->wl_valid == 0) {
-                memcpy(&wl->wl_dev_addr[0], addr, BLE_DEV_ADDR_LEN);
-                wl->wl_addr_type = addr_type;
-                wl->wl_valid = 1;
-                break;
-            }
-            ++wl;
+    if (!ble_ll_whitelist_bsearch(addr, addr_type, &index)) {
+        if (g_ble_ll_whitelist_cnt == BLE_LL_WHITELIST_SIZE) {
+            return BLE_ERR_MEM_CAPACITY;
         }
 
-        if (i == BLE_LL_WHITELIST_SIZE) {
-            rc = BLE_ERR_MEM_CAPACITY;
-        } else {
-#if (BLE_USES_HW_WHITELIST == 1)
-            rc = ble_hw_whitelist_add(addr, addr_type);
+        /* Make room for the new entry, keeping the list sorted */
+        wl = &g_ble_ll_whitelist[index];
+        memmove(wl + 1, wl,
+                (g_ble_ll_whitelist_cnt - index) * sizeof(*wl));
+        memcpy(&wl->wl_dev_addr[0], addr, BLE_DEV_ADDR_LEN);
+        wl->wl_addr_type = addr_type;
+        ++g_ble_ll_whitelist_cnt;
+
+#if (BLE_LL_USES_HW_WHITELIST == 1)
+        rc = ble_hw_whitelist_add(addr, addr_type);
 #endif
-        }
     }
 
     return rc;
@@ -227,19 +288,21 @@ ble_ll_whitelist_add(uint8_t *addr, uint8_t addr_type)
 int
 ble_ll_whitelist_rmv(uint8_t *addr, uint8_t addr_type)
 {
-    int position;
+    int index;
+    struct ble_ll_whitelist_entry *wl;
 
     /* Must be in proper state */
     if (!ble_ll_whitelist_chg_allowed()) {
         return BLE_ERR_CMD_DISALLOWED;
     }
 
-    position = ble_ll_whitelist_search(addr, addr_type);
-    if (position) {
-        g_ble_ll_whitelist[position - 1].wl_valid = 0;
+    if (ble_ll_whitelist_bsearch(addr, addr_type, &index)) {
+        wl = &g_ble_ll_whitelist[index];
+        --g_ble_ll_whitelist_cnt;
+        memmove(wl, wl + 1, (g_ble_ll_whitelist_cnt - index) * sizeof(*wl));
     }
 
-#if (BLE_USES_HW_WHITELIST == 1)
+#if (BLE_LL_USES_HW_WHITELIST == 1)
     ble_hw_whitelist_rmv(addr, addr_type);
 #endif
 
@@ -254,7 +317,7 @@ ble_ll_whitelist_rmv(uint8_t *addr, uint8_t addr_type)
 void
 ble_ll_whitelist_enable(void)
 {
-#if (BLE_USES_HW_WHITELIST == 1)
+#if (BLE_LL_USES_HW_WHITELIST == 1)
     ble_hw_whitelist_enable();
 #endif
 }
@@ -267,7 +330,7 @@ ble_ll_whitelist_enable(void)
 void
 ble_ll_whitelist_disable(void)
 {
-#if (BLE_USES_HW_WHITELIST == 1)
+#if (BLE_LL_USES_HW_WHITELIST == 1)
     ble_hw_whitelist_disable();
 #endif
 }
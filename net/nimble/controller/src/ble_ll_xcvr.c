@@ -141,7 +141,7 @@ ble_ll_xcvr_rfclk_timer_start(uint32_t cputime)
      * 'cputime'. If the expiry is before, no need to do anything. If it
      * is after, we need to stop the timer and start at new time.
      */
-    if (g_ble_ll_data.ll_rfclk_timer.link.tqe_prev != NULL) {
+    if (hal_timer_queued(&g_ble_ll_data.ll_rfclk_timer)) {
         if ((int32_t)(cputime - g_ble_ll_data.ll_rfclk_timer.expiry) >= 0) {
             return;
         }
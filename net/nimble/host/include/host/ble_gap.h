@@ -111,6 +111,9 @@ struct hci_conn_update;
 #define BLE_GAP_EVENT_SUBSCRIBE             14
 #define BLE_GAP_EVENT_MTU                   15
 #define BLE_GAP_EVENT_IDENTITY_RESOLVED     16
+#define BLE_GAP_EVENT_NOTIFY_QUEUE          17
+#define BLE_GAP_EVENT_DATA_LEN              18
+#define BLE_GAP_EVENT_PHY_UPDATE_COMPLETE   19
 
 /*** Reason codes for the subscribe GAP event. */
 
@@ -172,10 +175,23 @@ struct ble_gap_conn_desc {
     uint16_t conn_itvl;
     uint16_t conn_latency;
     uint16_t supervision_timeout;
+    uint16_t max_tx_octets;
     uint8_t role;
     uint8_t master_clock_accuracy;
 };
 
+/** Outgoing ACL data state of a connection. */
+struct ble_gap_conn_tx_stats {
+    /** Fragments sent to the controller and not yet completed. */
+    uint16_t outstanding;
+
+    /** Fragments queued in the host awaiting a controller buffer. */
+    uint16_t queued;
+
+    /** The most fragments that have been queued at once. */
+    uint16_t queued_max;
+};
+
 struct ble_gap_conn_params {
     uint16_t scan_itvl;
     uint16_t scan_window;
@@ -205,6 +221,24 @@ struct ble_gap_upd_params {
     uint16_t max_ce_len;
 };
 
+/** Connection parameter policy; see ble_gap_conn_policy_set(). */
+struct ble_gap_conn_policy {
+    /** Parameters to request while the connection is busy. */
+    struct ble_gap_upd_params bulk;
+
+    /** Parameters to request once the connection has gone quiet. */
+    struct ble_gap_upd_params idle;
+
+    /**
+     * L2CAP bytes (tx + rx) per sample period at which the connection is
+     * considered busy.  Must be nonzero.
+     */
+    uint32_t bulk_thresh;
+
+    /** How long the connection must stay below the threshold to be idle. */
+    uint32_t idle_timeout_ms;
+};
+
 struct ble_gap_passkey_params {
     uint8_t action;
     uint32_t numcmp;
@@ -223,6 +257,18 @@ struct ble_gap_disc_desc {
      * direct address fields are not present.
      */
     ble_addr_t direct_addr;
+
+    /***
+     * Host duplicate cache summary (BLE_GAP_DISC_DEDUP_ENTRIES).  The number
+     * of identical reports received since the last one delivered for this
+     * advertiser and data, this one included, and their RSSI.  For a report
+     * delivered without aggregation, num_reports is 1 and the RSSI fields
+     * equal rssi.
+     */
+    uint16_t num_reports;
+    int8_t rssi_min;
+    int8_t rssi_max;
+    int8_t rssi_avg;
 };
 
 /**
@@ -517,11 +563,86 @@ struct ble_gap_event {
             /** The handle of the relevant connection. */
             uint16_t conn_handle;
         } identity_resolved;
+
+        /**
+         * Represents a change in the state of a connection's notification
+         * queue (see ble_gattc_notify_queue()).  This event is reported once
+         * when the queue rejects a notification because it is full, and once
+         * more when the queue has room again.
+         *
+         * Valid for the following event types:
+         *     o BLE_GAP_EVENT_NOTIFY_QUEUE
+         */
+        struct {
+            /** The handle of the relevant connection. */
+            uint16_t conn_handle;
+
+            /** The number of notifications currently queued. */
+            uint8_t count;
+
+            /**
+             * The state of the queue;
+             *     o 0: Queue has room for more notifications;
+             *     o 1: Queue is full; notification was dropped.
+             */
+            uint8_t full:1;
+        } notify_queue;
+
+        /**
+         * Represents a change in a connection's LL data length, as reported
+         * by the controller's Data Length Change event.  Outgoing ACL data is
+         * fragmented to max_tx_octets from now on.
+         *
+         * Valid for the following event types:
+         *     o BLE_GAP_EVENT_DATA_LEN
+         */
+        struct {
+            /** The handle of the relevant connection. */
+            uint16_t conn_handle;
+
+            /** Maximum LL payload the controller will send, in bytes. */
+            uint16_t max_tx_octets;
+
+            /** Maximum LL payload the controller will receive, in bytes. */
+            uint16_t max_rx_octets;
+        } data_len;
+
+        /**
+         * Represents a completed PHY update procedure.
+         *
+         * Valid for the following event types:
+         *     o BLE_GAP_EVENT_PHY_UPDATE_COMPLETE
+         */
+        struct {
+            /**
+             * The result of the procedure;
+             *     o 0: the PHYs listed below are now in use;
+             *     o BLE host HCI error code: the update failed.
+             */
+            int status;
+
+            /** The handle of the relevant connection. */
+            uint16_t conn_handle;
+
+            /** Transmit PHY; one of the BLE_GAP_LE_PHY_[...] values. */
+            uint8_t tx_phy;
+
+            /** Receive PHY; one of the BLE_GAP_LE_PHY_[...] values. */
+            uint8_t rx_phy;
+        } phy_updated;
     };
 };
 
 typedef int ble_gap_event_fn(struct ble_gap_event *event, void *arg);
 
+#define BLE_GAP_LE_PHY_1M                   1
+#define BLE_GAP_LE_PHY_2M                   2
+#define BLE_GAP_LE_PHY_CODED                3
+
+#define BLE_GAP_LE_PHY_1M_MASK              0x01
+#define BLE_GAP_LE_PHY_2M_MASK              0x02
+#define BLE_GAP_LE_PHY_CODED_MASK           0x04
+
 #define BLE_GAP_CONN_MODE_NON               0
 #define BLE_GAP_CONN_MODE_DIR               1
 #define BLE_GAP_CONN_MODE_UND               2
@@ -549,6 +670,10 @@ int ble_gap_disc(uint8_t own_addr_type, int32_t duration_ms,
                  ble_gap_event_fn *cb, void *cb_arg);
 int ble_gap_disc_cancel(void);
 int ble_gap_disc_active(void);
+int ble_gap_disc_filter_clear(void);
+int ble_gap_disc_filter_add_mfg_id(uint16_t company_id);
+int ble_gap_disc_filter_add_uuid(const ble_uuid_t *uuid);
+int ble_gap_disc_filter_enable(int enable);
 int ble_gap_connect(uint8_t own_addr_type, const ble_addr_t *peer_addr,
                     int32_t duration_ms,
                     const struct ble_gap_conn_params *params,
@@ -560,11 +685,19 @@ int ble_gap_wl_set(const ble_addr_t *addrs, uint8_t white_list_count);
 int ble_gap_update_params(uint16_t conn_handle,
                           const struct ble_gap_upd_params *params);
 int ble_gap_dbg_update_active(uint16_t conn_handle);
+int ble_gap_conn_policy_set(uint16_t conn_handle,
+                            const struct ble_gap_conn_policy *policy);
 int ble_gap_security_initiate(uint16_t conn_handle);
 int ble_gap_pair_initiate(uint16_t conn_handle);
 int ble_gap_encryption_initiate(uint16_t conn_handle, const uint8_t *ltk,
                                 uint16_t ediv, uint64_t rand_val, int auth);
 int ble_gap_conn_rssi(uint16_t conn_handle, int8_t *out_rssi);
+int ble_gap_conn_tx_stats(uint16_t conn_handle,
+                          struct ble_gap_conn_tx_stats *out_stats);
+int ble_gap_set_data_len(uint16_t conn_handle, uint16_t tx_octets,
+                         uint16_t tx_time);
+int ble_gap_set_phy(uint16_t conn_handle, uint8_t tx_phys_mask,
+                    uint8_t rx_phys_mask);
 
 #ifdef __cplusplus
 }
@@ -168,6 +168,12 @@ int ble_gattc_read_long(uint16_t conn_handle, uint16_t handle, uint16_t offset,
 int ble_gattc_read_mult(uint16_t conn_handle, const uint16_t *handles,
                         uint8_t num_handles, ble_gatt_attr_fn *cb,
                         void *cb_arg);
+int ble_gattc_read_mult_var(uint16_t conn_handle, const uint16_t *handles,
+                            uint8_t num_handles, ble_gatt_attr_fn *cb,
+                            void *cb_arg);
+int ble_gattc_read_mult_list(uint16_t conn_handle, const uint16_t *handles,
+                             uint8_t num_handles, ble_gatt_attr_fn *cb,
+                             void *cb_arg);
 int ble_gattc_write_no_rsp(uint16_t conn_handle, uint16_t attr_handle,
                            struct os_mbuf *om);
 int ble_gattc_write_no_rsp_flat(uint16_t conn_handle, uint16_t attr_handle,
@@ -188,6 +194,11 @@ int ble_gattc_write_reliable(uint16_t conn_handle,
 int ble_gattc_notify_custom(uint16_t conn_handle, uint16_t att_handle,
                             struct os_mbuf *om);
 int ble_gattc_notify(uint16_t conn_handle, uint16_t chr_val_handle);
+int ble_gattc_notify_multi(uint16_t conn_handle,
+                           const uint16_t *chr_val_handles,
+                           uint8_t num_handles);
+int ble_gattc_notify_queue(uint16_t conn_handle, uint16_t chr_val_handle,
+                           struct os_mbuf *txom);
 int ble_gattc_indicate(uint16_t conn_handle, uint16_t chr_val_handle);
 
 int ble_gattc_init(void);
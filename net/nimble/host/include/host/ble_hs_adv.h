@@ -41,6 +41,16 @@ struct ble_hs_adv_field {
 typedef int (* ble_hs_adv_parse_func_t) (const struct ble_hs_adv_field *,
                                          void *);
 
+/**
+ * Walks the fields of raw advertising data in place.  Fields are returned as
+ * pointers into the data being walked; nothing is copied.  A field's length
+ * includes its type byte.
+ */
+struct ble_hs_adv_iter {
+    const uint8_t *data;
+    uint8_t length;
+};
+
 struct ble_hs_adv_fields {
     /*** 0x01 - Flags. */
     uint8_t flags;
@@ -164,6 +174,13 @@ int ble_hs_adv_parse_fields(struct ble_hs_adv_fields *adv_fields, uint8_t *src,
 int ble_hs_adv_parse(const uint8_t *data, uint8_t length,
                      ble_hs_adv_parse_func_t func, void *user_data);
 
+void ble_hs_adv_iter_init(struct ble_hs_adv_iter *iter, const uint8_t *data,
+                          uint8_t length);
+int ble_hs_adv_iter_next(struct ble_hs_adv_iter *iter,
+                         const struct ble_hs_adv_field **out_field);
+int ble_hs_adv_find_field(uint8_t type, const uint8_t *data, uint8_t length,
+                          const struct ble_hs_adv_field **out);
+
 #ifdef __cplusplus
 }
 #endif
@@ -75,6 +75,7 @@ struct ble_hs_conn;
 #define BLE_L2CAP_EVENT_COC_DISCONNECTED              1
 #define BLE_L2CAP_EVENT_COC_ACCEPT                    2
 #define BLE_L2CAP_EVENT_COC_DATA_RECEIVED             3
+#define BLE_L2CAP_EVENT_COC_TX_UNSTALLED              4
 
 typedef void ble_l2cap_sig_update_fn(uint16_t conn_handle, int status,
                                      void *arg);
@@ -173,11 +174,64 @@ struct ble_l2cap_event {
             /** The mbuf with received SDU. */
             struct os_mbuf *sdu_rx;
         } receive;
+
+        /**
+         * Represents the end of an SDU transmission which had to wait for
+         * credits from the peer; the channel accepts a new SDU again. Valid
+         * for the following event types:
+         *     o BLE_L2CAP_EVENT_COC_TX_UNSTALLED
+         */
+        struct {
+            /** Connection handle of the relevant connection */
+            uint16_t conn_handle;
+
+            /** The L2CAP channel of the relevant L2CAP connection. */
+            struct ble_l2cap_chan *chan;
+
+            /**
+             * 0 if the SDU was sent completely; otherwise the BLE host error
+             * code which caused it to be dropped.
+             */
+            int status;
+        } tx_unstalled;
     };
 };
 
 typedef int ble_l2cap_event_fn(struct ble_l2cap_event *event, void *arg);
 
+/** Throughput counters for an LE Connection Oriented Channel. */
+struct ble_l2cap_chan_stats {
+    /** SDU payload bytes received. */
+    uint32_t rx_bytes;
+
+    /** Complete SDUs received. */
+    uint32_t rx_sdus;
+
+    /** LE frames received. */
+    uint32_t rx_frames;
+
+    /** SDU payload bytes sent. */
+    uint32_t tx_bytes;
+
+    /** Complete SDUs sent. */
+    uint32_t tx_sdus;
+
+    /** LE frames sent. */
+    uint32_t tx_frames;
+
+    /** Number of times transmission stopped because the peer ran out of
+     * credits for us.
+     */
+    uint32_t tx_credit_stalls;
+
+    /** Number of times the peer ran out of credits before completing an SDU.
+     */
+    uint32_t rx_credit_stalls;
+
+    /** Credits granted to the peer after the channel was established. */
+    uint32_t credits_granted;
+};
+
 uint16_t ble_l2cap_get_conn_handle(struct ble_l2cap_chan *chan);
 int ble_l2cap_create_server(uint16_t psm, uint16_t mtu,
                             ble_l2cap_event_fn *cb, void *cb_arg);
@@ -188,6 +242,8 @@ int ble_l2cap_connect(uint16_t conn_handle, uint16_t psm, uint16_t mtu,
 int ble_l2cap_disconnect(struct ble_l2cap_chan *chan);
 int ble_l2cap_send(struct ble_l2cap_chan *chan, struct os_mbuf *sdu_tx);
 void ble_l2cap_recv_ready(struct ble_l2cap_chan *chan, struct os_mbuf *sdu_rx);
+int ble_l2cap_get_chan_stats(struct ble_l2cap_chan *chan,
+                             struct ble_l2cap_chan_stats *out_stats);
 
 #ifdef __cplusplus
 }
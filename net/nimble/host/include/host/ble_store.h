@@ -22,6 +22,7 @@
 
 #include <inttypes.h>
 #include "nimble/ble.h"
+#include "host/ble_uuid.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -30,6 +31,15 @@ extern "C" {
 #define BLE_STORE_OBJ_TYPE_OUR_SEC      1
 #define BLE_STORE_OBJ_TYPE_PEER_SEC     2
 #define BLE_STORE_OBJ_TYPE_CCCD         3
+#define BLE_STORE_OBJ_TYPE_GATT         4
+
+/** Kinds of cached GATT attribute records (ble_store_value_gatt::attr_type). */
+#define BLE_STORE_GATT_ATTR_SVC         1
+#define BLE_STORE_GATT_ATTR_CHR         2
+#define BLE_STORE_GATT_ATTR_DSC         3
+
+/** Marker indicating the peer's full service list has been cached. */
+#define BLE_STORE_GATT_ATTR_DB          4
 
 /**
  * Used as a key for lookups of security material.  This struct corresponds to
@@ -113,6 +123,67 @@ struct ble_store_value_cccd {
     unsigned value_changed:1;
 };
 
+/**
+ * Used as a key for lookups of cached GATT attributes of a peer's database.
+ * This struct corresponds to the BLE_STORE_OBJ_TYPE_GATT store object type.
+ */
+struct ble_store_key_gatt {
+    /**
+     * Key by peer identity address;
+     * peer_addr=BLE_ADDR_ANY means don't key off peer.
+     */
+    ble_addr_t peer_addr;
+
+    /**
+     * Key by record kind (BLE_STORE_GATT_ATTR_[...]);
+     * attr_type=0 means don't key off record kind.
+     */
+    uint8_t attr_type;
+
+    /** Key by attribute handle; handle=0 means don't key off handle. */
+    uint16_t handle;
+
+    /** Number of results to skip; 0 means retrieve the first match. */
+    uint8_t idx;
+};
+
+/**
+ * Represents a cached attribute of a peer's GATT database.  This struct
+ * corresponds to the BLE_STORE_OBJ_TYPE_GATT store object type.
+ */
+struct ble_store_value_gatt {
+    ble_addr_t peer_addr;
+
+    /** One of the BLE_STORE_GATT_ATTR_[...] codes. */
+    uint8_t attr_type;
+
+    /**
+     * Service: start handle; characteristic: definition handle; descriptor:
+     * descriptor handle.
+     */
+    uint16_t handle;
+
+    /**
+     * Service: end group handle; characteristic: last handle covered by the
+     * cached descriptor list (valid if complete is set).
+     */
+    uint16_t end_handle;
+
+    /** Characteristic value handle (characteristics only). */
+    uint16_t val_handle;
+
+    /** Characteristic properties (characteristics only). */
+    uint8_t properties;
+
+    ble_uuid_any_t uuid;
+
+    /**
+     * Service: all of its characteristics are cached; characteristic: all of
+     * its descriptors up to end_handle are cached.
+     */
+    unsigned complete:1;
+};
+
 /**
  * Used as a key for store lookups.  This union must be accompanied by an
  * object type code to indicate which field is valid.
@@ -120,6 +191,7 @@ struct ble_store_value_cccd {
 union ble_store_key {
     struct ble_store_key_sec sec;
     struct ble_store_key_cccd cccd;
+    struct ble_store_key_gatt gatt;
 };
 
 /**
@@ -129,6 +201,7 @@ union ble_store_key {
 union ble_store_value {
     struct ble_store_value_sec sec;
     struct ble_store_value_cccd cccd;
+    struct ble_store_value_gatt gatt;
 };
 
 /**
@@ -200,10 +273,17 @@ int ble_store_read_cccd(const struct ble_store_key_cccd *key,
 int ble_store_write_cccd(const struct ble_store_value_cccd *value);
 int ble_store_delete_cccd(const struct ble_store_key_cccd *key);
 
+int ble_store_read_gatt(const struct ble_store_key_gatt *key,
+                        struct ble_store_value_gatt *out_value);
+int ble_store_write_gatt(const struct ble_store_value_gatt *value);
+int ble_store_delete_gatt(const struct ble_store_key_gatt *key);
+
 void ble_store_key_from_value_sec(struct ble_store_key_sec *out_key,
                                   const struct ble_store_value_sec *value);
 void ble_store_key_from_value_cccd(struct ble_store_key_cccd *out_key,
                                    const struct ble_store_value_cccd *value);
+void ble_store_key_from_value_gatt(struct ble_store_key_gatt *out_key,
+                                   const struct ble_store_value_gatt *value);
 
 void ble_store_key_from_value(int obj_type,
                               union ble_store_key *out_key,
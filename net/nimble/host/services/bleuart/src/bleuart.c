@@ -22,6 +22,7 @@
 #include <string.h>
 
 #include "sysinit/sysinit.h"
+#include "stats/stats.h"
 #include "host/ble_hs.h"
 #include "host/ble_uuid.h"
 #include "bleuart/bleuart.h"
@@ -38,6 +39,54 @@ uint16_t g_bleuart_attr_write_handle;
 char *console_buf;
 
 uint16_t g_console_conn_handle;
+
+#if MYNEWT_VAL(BLEUART_RX_CREDITS) > 0
+/* ble uart attr credits handle */
+uint16_t g_bleuart_attr_credits_handle;
+
+/*
+ * Total number of writes the peer has been allowed since it connected.
+ * Starts at BLEUART_RX_CREDITS; one more is granted each time a queued
+ * write has been passed to the console.
+ */
+static uint16_t bleuart_rx_credits;
+static uint16_t bleuart_rx_credits_sent;
+#endif
+
+/*
+ * Console input waiting to be notified to the peer.  Notifications are
+ * filled up to the ATT MTU; if the host is out of buffers, sending is
+ * retried from a callout instead of dropping the data.
+ */
+static uint8_t bleuart_tx_buf[MYNEWT_VAL(BLEUART_TX_BUF_SIZE)];
+static uint16_t bleuart_tx_head;
+static uint16_t bleuart_tx_len;
+static struct os_callout bleuart_tx_timer;
+
+/* Peer writes, passed to the console from the default event queue. */
+static struct os_mqueue bleuart_rxq;
+
+STATS_SECT_START(bleuart_stats)
+    STATS_SECT_ENTRY(tx_bytes)
+    STATS_SECT_ENTRY(tx_notify)
+    STATS_SECT_ENTRY(tx_retry)
+    STATS_SECT_ENTRY(tx_drop)
+    STATS_SECT_ENTRY(rx_bytes)
+    STATS_SECT_ENTRY(rx_write)
+    STATS_SECT_ENTRY(rx_drop)
+STATS_SECT_END
+static STATS_SECT_DECL(bleuart_stats) bleuart_stats;
+
+STATS_NAME_START(bleuart_stats)
+    STATS_NAME(bleuart_stats, tx_bytes)
+    STATS_NAME(bleuart_stats, tx_notify)
+    STATS_NAME(bleuart_stats, tx_retry)
+    STATS_NAME(bleuart_stats, tx_drop)
+    STATS_NAME(bleuart_stats, rx_bytes)
+    STATS_NAME(bleuart_stats, rx_write)
+    STATS_NAME(bleuart_stats, rx_drop)
+STATS_NAME_END(bleuart_stats)
+
 /**
  * The vendor specific "bleuart" service consists of one write no-rsp characteristic
  * and one notification only read charateristic
@@ -45,6 +94,9 @@ uint16_t g_console_conn_handle;
  *       over a non-encrypted connection
  *     o "read": a single-byte characteristic that can always be read only via
  *       notifications
+ *     o "credits": optional, readable and notified; little-endian 16-bit
+ *       count of writes the peer may have sent in total since connecting.
+ *       Peers which don't use it can keep writing as before.
  */
 
 /* {6E400001-B5A3-F393-E0A9-E50E24DCCA9E} */
@@ -63,6 +115,13 @@ const ble_uuid128_t gatt_svr_chr_uart_read_uuid =
     BLE_UUID128_INIT(0x9e, 0xca, 0xdc, 0x24, 0x0e, 0xe5, 0xa9, 0xe0,
                      0x93, 0xf3, 0xa3, 0xb5, 0x03, 0x00, 0x40, 0x6e);
 
+#if MYNEWT_VAL(BLEUART_RX_CREDITS) > 0
+/* {6E400004-B5A3-F393-E0A9-E50E24DCCA9E} */
+const ble_uuid128_t gatt_svr_chr_uart_credits_uuid =
+    BLE_UUID128_INIT(0x9e, 0xca, 0xdc, 0x24, 0x0e, 0xe5, 0xa9, 0xe0,
+                     0x93, 0xf3, 0xa3, 0xb5, 0x04, 0x00, 0x40, 0x6e);
+#endif
+
 static int
 gatt_svr_chr_access_uart_write(uint16_t conn_handle, uint16_t attr_handle,
                               struct ble_gatt_access_ctxt *ctxt, void *arg);
@@ -84,6 +143,14 @@ static const struct ble_gatt_svc_def gatt_svr_svcs[] = {
             .flags = BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_WRITE_NO_RSP,
             .val_handle = &g_bleuart_attr_write_handle,
         }, {
+#if MYNEWT_VAL(BLEUART_RX_CREDITS) > 0
+            /* Characteristic: RX credits */
+            .uuid = &gatt_svr_chr_uart_credits_uuid.u,
+            .access_cb = gatt_svr_chr_access_uart_write,
+            .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_NOTIFY,
+            .val_handle = &g_bleuart_attr_credits_handle,
+        }, {
+#endif
             0, /* No more characteristics in this service */
         } },
     },
@@ -97,15 +164,31 @@ static int
 gatt_svr_chr_access_uart_write(uint16_t conn_handle, uint16_t attr_handle,
                                struct ble_gatt_access_ctxt *ctxt, void *arg)
 {
-    struct os_mbuf *om = ctxt->om;
+    struct os_mbuf *om;
+#if MYNEWT_VAL(BLEUART_RX_CREDITS) > 0
+    uint8_t buf[2];
+#endif
+
     switch (ctxt->op) {
         case BLE_GATT_ACCESS_OP_WRITE_CHR:
-              while(om) {
-                  console_write((char *)om->om_data, om->om_len);
-                  om = SLIST_NEXT(om, om_next);
+              STATS_INC(bleuart_stats, rx_write);
+              STATS_INCN(bleuart_stats, rx_bytes, OS_MBUF_PKTLEN(ctxt->om));
+              om = os_mbuf_dup(ctxt->om);
+              if (!om ||
+                os_mqueue_put(&bleuart_rxq, os_eventq_dflt_get(), om)) {
+                  STATS_INC(bleuart_stats, rx_drop);
+                  os_mbuf_free_chain(om);
               }
-              console_write("\n", 1);
               return 0;
+#if MYNEWT_VAL(BLEUART_RX_CREDITS) > 0
+        case BLE_GATT_ACCESS_OP_READ_CHR:
+              put_le16(buf, bleuart_rx_credits);
+              bleuart_rx_credits_sent = bleuart_rx_credits;
+              if (os_mbuf_append(ctxt->om, buf, sizeof(buf))) {
+                  return BLE_ATT_ERR_INSUFFICIENT_RES;
+              }
+              return 0;
+#endif
         default:
             assert(0);
             return BLE_ATT_ERR_UNLIKELY;
@@ -137,6 +220,119 @@ err:
     return rc;
 }
 
+/**
+ * Passes queued peer writes to the console, and returns their credits.
+ */
+static void
+bleuart_rx_process(struct os_event *ev)
+{
+    struct os_mbuf *om;
+    struct os_mbuf *m;
+
+    while ((om = os_mqueue_get(&bleuart_rxq)) != NULL) {
+        for (m = om; m; m = SLIST_NEXT(m, om_next)) {
+            console_write((char *)m->om_data, m->om_len);
+        }
+        console_write("\n", 1);
+        os_mbuf_free_chain(om);
+#if MYNEWT_VAL(BLEUART_RX_CREDITS) > 0
+        bleuart_rx_credits++;
+#endif
+    }
+
+#if MYNEWT_VAL(BLEUART_RX_CREDITS) > 0
+    /* Tell the peer once half of the window has been freed. */
+    if ((uint16_t)(bleuart_rx_credits - bleuart_rx_credits_sent) >=
+      (MYNEWT_VAL(BLEUART_RX_CREDITS) + 1) / 2) {
+        ble_gatts_chr_updated(g_bleuart_attr_credits_handle);
+    }
+#endif
+}
+
+/**
+ * Sends as much buffered console data as the host takes, one MTU-sized
+ * notification at a time.
+ */
+static void
+bleuart_tx_drain(void)
+{
+    struct os_mbuf *om;
+    uint16_t mtu;
+    uint16_t first;
+    uint16_t len;
+    os_sr_t sr;
+    int rc;
+
+    mtu = ble_att_mtu(g_console_conn_handle);
+    if (mtu <= 3) {
+        /* Not connected; keep the data until someone is. */
+        return;
+    }
+
+    while (bleuart_tx_len) {
+        len = min(bleuart_tx_len, mtu - 3);
+        first = min(len, sizeof(bleuart_tx_buf) - bleuart_tx_head);
+
+        om = ble_hs_mbuf_att_pkt();
+        if (!om) {
+            goto retry;
+        }
+        if (os_mbuf_append(om, &bleuart_tx_buf[bleuart_tx_head], first) ||
+          os_mbuf_append(om, bleuart_tx_buf, len - first)) {
+            os_mbuf_free_chain(om);
+            goto retry;
+        }
+        rc = ble_gattc_notify_custom(g_console_conn_handle,
+                                     g_bleuart_attr_read_handle, om);
+        if (rc == BLE_HS_ENOMEM) {
+            goto retry;
+        } else if (rc) {
+            return;
+        }
+        STATS_INC(bleuart_stats, tx_notify);
+        STATS_INCN(bleuart_stats, tx_bytes, len);
+
+        OS_ENTER_CRITICAL(sr);
+        bleuart_tx_head = (bleuart_tx_head + len) % sizeof(bleuart_tx_buf);
+        bleuart_tx_len -= len;
+        OS_EXIT_CRITICAL(sr);
+    }
+    return;
+retry:
+    STATS_INC(bleuart_stats, tx_retry);
+    os_callout_reset(&bleuart_tx_timer, OS_TICKS_PER_SEC / 100 + 1);
+}
+
+static void
+bleuart_tx_timer_cb(struct os_event *ev)
+{
+    bleuart_tx_drain();
+}
+
+/*
+ * Appends data to the TX ring; whatever doesn't fit is dropped.
+ */
+static void
+bleuart_tx_queue(const char *data, int len)
+{
+    uint16_t off;
+    uint16_t cnt;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    if (len > sizeof(bleuart_tx_buf) - bleuart_tx_len) {
+        STATS_INCN(bleuart_stats, tx_drop,
+                   len - (sizeof(bleuart_tx_buf) - bleuart_tx_len));
+        len = sizeof(bleuart_tx_buf) - bleuart_tx_len;
+    }
+    off = (bleuart_tx_head + bleuart_tx_len) % sizeof(bleuart_tx_buf);
+    cnt = min(len, sizeof(bleuart_tx_buf) - off);
+    memcpy(&bleuart_tx_buf[off], data, cnt);
+    memcpy(bleuart_tx_buf, data + cnt, len - cnt);
+    bleuart_tx_len += len;
+    OS_EXIT_CRITICAL(sr);
+}
+
 /**
  * Reads console and sends data over BLE
  */
@@ -146,7 +342,6 @@ bleuart_uart_read(void)
     int rc;
     int off;
     int full_line;
-    struct os_mbuf *om;
 
     off = 0;
     while (1) {
@@ -160,12 +355,8 @@ bleuart_uart_read(void)
             continue;
         }
 
-        om = ble_hs_mbuf_from_flat(console_buf, off);
-        if (!om) {
-            return;
-        }
-        ble_gattc_notify_custom(g_console_conn_handle,
-                                g_bleuart_attr_read_handle, om);
+        bleuart_tx_queue(console_buf, off);
+        bleuart_tx_drain();
         off = 0;
         break;
     }
@@ -179,6 +370,11 @@ bleuart_uart_read(void)
 void
 bleuart_set_conn_handle(uint16_t conn_handle) {
     g_console_conn_handle = conn_handle;
+#if MYNEWT_VAL(BLEUART_RX_CREDITS) > 0
+    bleuart_rx_credits = MYNEWT_VAL(BLEUART_RX_CREDITS);
+    bleuart_rx_credits_sent = bleuart_rx_credits;
+#endif
+    bleuart_tx_drain();
 }
 
 /**
@@ -199,4 +395,14 @@ bleuart_init(void)
 
     console_buf = malloc(MYNEWT_VAL(BLEUART_MAX_INPUT));
     SYSINIT_PANIC_ASSERT(console_buf != NULL);
+
+    os_callout_init(&bleuart_tx_timer, os_eventq_dflt_get(),
+                    bleuart_tx_timer_cb, NULL);
+    rc = os_mqueue_init(&bleuart_rxq, bleuart_rx_process, NULL);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
+    rc = stats_init_and_reg(
+        STATS_HDR(bleuart_stats), STATS_SIZE_INIT_PARMS(bleuart_stats,
+        STATS_SIZE_32), STATS_NAME_INIT_PARMS(bleuart_stats), "ble_uart");
+    SYSINIT_PANIC_ASSERT(rc == 0);
 }
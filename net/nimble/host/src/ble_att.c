@@ -59,6 +59,9 @@ static const struct ble_att_rx_dispatch_entry ble_att_rx_dispatch[] = {
     { BLE_ATT_OP_NOTIFY_REQ,           ble_att_svr_rx_notify },
     { BLE_ATT_OP_INDICATE_REQ,         ble_att_svr_rx_indicate },
     { BLE_ATT_OP_INDICATE_RSP,         ble_att_clt_rx_indicate },
+    { BLE_ATT_OP_READ_MULT_VAR_REQ,    ble_att_svr_rx_read_mult_var },
+    { BLE_ATT_OP_READ_MULT_VAR_RSP,    ble_att_clt_rx_read_mult_var },
+    { BLE_ATT_OP_NOTIFY_MULTI_REQ,     ble_att_svr_rx_notify_multi },
     { BLE_ATT_OP_WRITE_CMD,            ble_att_svr_rx_write_no_rsp },
 };
 
@@ -97,6 +100,10 @@ STATS_NAME_START(ble_att_stats)
     STATS_NAME(ble_att_stats, read_mult_req_tx)
     STATS_NAME(ble_att_stats, read_mult_rsp_rx)
     STATS_NAME(ble_att_stats, read_mult_rsp_tx)
+    STATS_NAME(ble_att_stats, read_mult_var_req_rx)
+    STATS_NAME(ble_att_stats, read_mult_var_req_tx)
+    STATS_NAME(ble_att_stats, read_mult_var_rsp_rx)
+    STATS_NAME(ble_att_stats, read_mult_var_rsp_tx)
     STATS_NAME(ble_att_stats, read_group_type_req_rx)
     STATS_NAME(ble_att_stats, read_group_type_req_tx)
     STATS_NAME(ble_att_stats, read_group_type_rsp_rx)
@@ -115,6 +122,8 @@ STATS_NAME_START(ble_att_stats)
     STATS_NAME(ble_att_stats, exec_write_rsp_tx)
     STATS_NAME(ble_att_stats, notify_req_rx)
     STATS_NAME(ble_att_stats, notify_req_tx)
+    STATS_NAME(ble_att_stats, notify_multi_req_rx)
+    STATS_NAME(ble_att_stats, notify_multi_req_tx)
     STATS_NAME(ble_att_stats, indicate_req_rx)
     STATS_NAME(ble_att_stats, indicate_req_tx)
     STATS_NAME(ble_att_stats, indicate_rsp_rx)
@@ -215,6 +224,14 @@ ble_att_inc_tx_stat(uint8_t att_op)
         STATS_INC(ble_att_stats, read_mult_rsp_tx);
         break;
 
+    case BLE_ATT_OP_READ_MULT_VAR_REQ:
+        STATS_INC(ble_att_stats, read_mult_var_req_tx);
+        break;
+
+    case BLE_ATT_OP_READ_MULT_VAR_RSP:
+        STATS_INC(ble_att_stats, read_mult_var_rsp_tx);
+        break;
+
     case BLE_ATT_OP_READ_GROUP_TYPE_REQ:
         STATS_INC(ble_att_stats, read_group_type_req_tx);
         break;
@@ -251,6 +268,10 @@ ble_att_inc_tx_stat(uint8_t att_op)
         STATS_INC(ble_att_stats, notify_req_tx);
         break;
 
+    case BLE_ATT_OP_NOTIFY_MULTI_REQ:
+        STATS_INC(ble_att_stats, notify_multi_req_tx);
+        break;
+
     case BLE_ATT_OP_INDICATE_REQ:
         STATS_INC(ble_att_stats, indicate_req_tx);
         break;
@@ -332,6 +353,14 @@ ble_att_inc_rx_stat(uint8_t att_op)
         STATS_INC(ble_att_stats, read_mult_rsp_rx);
         break;
 
+    case BLE_ATT_OP_READ_MULT_VAR_REQ:
+        STATS_INC(ble_att_stats, read_mult_var_req_rx);
+        break;
+
+    case BLE_ATT_OP_READ_MULT_VAR_RSP:
+        STATS_INC(ble_att_stats, read_mult_var_rsp_rx);
+        break;
+
     case BLE_ATT_OP_READ_GROUP_TYPE_REQ:
         STATS_INC(ble_att_stats, read_group_type_req_rx);
         break;
@@ -368,6 +397,10 @@ ble_att_inc_rx_stat(uint8_t att_op)
         STATS_INC(ble_att_stats, notify_req_rx);
         break;
 
+    case BLE_ATT_OP_NOTIFY_MULTI_REQ:
+        STATS_INC(ble_att_stats, notify_multi_req_rx);
+        break;
+
     case BLE_ATT_OP_INDICATE_REQ:
         STATS_INC(ble_att_stats, indicate_req_rx);
         break;
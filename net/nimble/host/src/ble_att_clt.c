@@ -33,16 +33,14 @@
 int
 ble_att_clt_rx_error(uint16_t conn_handle, struct os_mbuf **rxom)
 {
-    struct ble_att_error_rsp *rsp;
-    int rc;
+    const struct ble_att_error_rsp *rsp;
+    struct ble_att_error_rsp rsp_buf;
 
-    rc = ble_hs_mbuf_pullup_base(rxom, sizeof(*rsp));
-    if (rc != 0) {
-        return rc;
+    rsp = ble_hs_mbuf_peek(*rxom, 0, sizeof *rsp, &rsp_buf);
+    if (rsp == NULL) {
+        return BLE_HS_EBADDATA;
     }
 
-    rsp = (struct ble_att_error_rsp *)(*rxom)->om_data;
-
     BLE_ATT_LOG_CMD(0, "error rsp", conn_handle, ble_att_error_rsp_log, rsp);
 
     ble_gattc_rx_err(conn_handle, le16toh(rsp->baep_handle),
@@ -113,16 +111,17 @@ ble_att_clt_tx_mtu(uint16_t conn_handle, uint16_t mtu)
 int
 ble_att_clt_rx_mtu(uint16_t conn_handle, struct os_mbuf **rxom)
 {
-    struct ble_att_mtu_cmd *cmd;
+    const struct ble_att_mtu_cmd *cmd;
+    struct ble_att_mtu_cmd cmd_buf;
     struct ble_l2cap_chan *chan;
     uint16_t mtu;
     int rc;
 
     mtu = 0;
 
-    rc = ble_hs_mbuf_pullup_base(rxom, sizeof(*cmd));
+    cmd = ble_hs_mbuf_peek(*rxom, 0, sizeof *cmd, &cmd_buf);
+    rc = cmd != NULL ? 0 : BLE_HS_EBADDATA;
     if (rc == 0) {
-        cmd = (struct ble_att_mtu_cmd *)(*rxom)->om_data;
 
         BLE_ATT_LOG_CMD(0, "mtu rsp", conn_handle, ble_att_mtu_cmd_log, cmd);
 
@@ -607,6 +606,58 @@ ble_att_clt_rx_read_mult(uint16_t conn_handle, struct os_mbuf **rxom)
     return 0;
 }
 
+/*****************************************************************************
+ * $read multiple variable length                                            *
+ *****************************************************************************/
+
+int
+ble_att_clt_tx_read_mult_var(uint16_t conn_handle, const uint16_t *handles,
+                             int num_handles)
+{
+#if !NIMBLE_BLE_ATT_CLT_READ_MULT_VAR
+    return BLE_HS_ENOTSUP;
+#endif
+
+    struct ble_att_read_mult_req *req;
+    struct os_mbuf *txom;
+    int i;
+
+    BLE_ATT_LOG_EMPTY_CMD(1, "read mult var req", conn_handle);
+
+    /* The request must name at least two attributes. */
+    if (num_handles < 2) {
+        return BLE_HS_EINVAL;
+    }
+
+    /* The request has the same layout as a read multiple request. */
+    req = ble_att_cmd_get(BLE_ATT_OP_READ_MULT_VAR_REQ,
+                          sizeof(req->handles[0]) * num_handles,
+                          &txom);
+    if (req == NULL) {
+        return BLE_HS_ENOMEM;
+    }
+
+    for (i = 0; i < num_handles; i++) {
+        req->handles[i] = htole16(handles[i]);
+    }
+
+    return ble_att_tx(conn_handle, txom);
+}
+
+int
+ble_att_clt_rx_read_mult_var(uint16_t conn_handle, struct os_mbuf **rxom)
+{
+#if !NIMBLE_BLE_ATT_CLT_READ_MULT_VAR
+    return BLE_HS_ENOTSUP;
+#endif
+
+    BLE_ATT_LOG_EMPTY_CMD(0, "read mult var rsp", conn_handle);
+
+    /* Pass the Length Value Tuple List to GATT. */
+    ble_gattc_rx_read_mult_var_rsp(conn_handle, 0, rxom);
+    return 0;
+}
+
 /*****************************************************************************
  * $read by group type                                                       *
  *****************************************************************************/
@@ -852,7 +903,8 @@ ble_att_clt_rx_prep_write(uint16_t conn_handle, struct os_mbuf **rxom)
     return BLE_HS_ENOTSUP;
 #endif
 
-    struct ble_att_prep_write_cmd *rsp;
+    const struct ble_att_prep_write_cmd *rsp;
+    struct ble_att_prep_write_cmd rsp_buf;
     uint16_t handle, offset;
     int rc;
 
@@ -860,12 +912,11 @@ ble_att_clt_rx_prep_write(uint16_t conn_handle, struct os_mbuf **rxom)
     handle = 0;
     offset = 0;
 
-    rc = ble_hs_mbuf_pullup_base(rxom, sizeof(*rsp));
-    if (rc != 0) {
+    rsp = ble_hs_mbuf_peek(*rxom, 0, sizeof *rsp, &rsp_buf);
+    if (rsp == NULL) {
+        rc = BLE_HS_EBADDATA;
         goto done;
     }
-
-    rsp = (struct ble_att_prep_write_cmd *)(*rxom)->om_data;
     BLE_ATT_LOG_CMD(0, "prep write rsp", conn_handle,
                     ble_att_prep_write_cmd_log, rsp);
 
@@ -966,6 +1017,58 @@ err:
     return rc;
 }
 
+/**
+ * Sends a Multiple Handle Value Notification.  This function consumes the
+ * supplied mbuf regardless of the outcome.
+ *
+ * @param conn_handle           The connection to send the notification on.
+ * @param txom                  The Handle Length Value Tuple List; the
+ *                                  opcode gets prepended to it.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_EMSGSIZE if the tuples don't fit in
+ *                                  the ATT MTU;
+ *                              Other nonzero on failure.
+ */
+int
+ble_att_clt_tx_notify_multi(uint16_t conn_handle, struct os_mbuf *txom)
+{
+#if !NIMBLE_BLE_ATT_CLT_NOTIFY_MULTI
+    return BLE_HS_ENOTSUP;
+#endif
+
+    uint16_t mtu;
+    int rc;
+
+    mtu = ble_att_mtu(conn_handle);
+    if (mtu == 0) {
+        rc = BLE_HS_ENOTCONN;
+        goto err;
+    }
+
+    /* Unlike other commands, a truncated notification of multiple values is
+     * not allowed.
+     */
+    if (BLE_ATT_NOTIFY_MULTI_REQ_BASE_SZ + OS_MBUF_PKTLEN(txom) > mtu) {
+        rc = BLE_HS_EMSGSIZE;
+        goto err;
+    }
+
+    txom = os_mbuf_prepend(txom, BLE_ATT_NOTIFY_MULTI_REQ_BASE_SZ);
+    if (txom == NULL) {
+        return BLE_HS_ENOMEM;
+    }
+    ble_att_notify_multi_req_write(txom->om_data, txom->om_len);
+
+    BLE_ATT_LOG_EMPTY_CMD(1, "notify multi req", conn_handle);
+
+    return ble_att_tx(conn_handle, txom);
+
+err:
+    os_mbuf_free_chain(txom);
+    return rc;
+}
+
 /*****************************************************************************
  * $handle value indication                                                  *
  *****************************************************************************/
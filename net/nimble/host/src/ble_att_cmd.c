@@ -449,6 +449,34 @@ ble_att_read_mult_rsp_write(void *payload, int len)
                        BLE_ATT_READ_MULT_RSP_BASE_SZ, len);
 }
 
+void
+ble_att_read_mult_var_req_parse(const void *payload, int len)
+{
+    ble_att_init_parse(BLE_ATT_OP_READ_MULT_VAR_REQ, payload,
+                       BLE_ATT_READ_MULT_VAR_REQ_BASE_SZ, len);
+}
+
+void
+ble_att_read_mult_var_req_write(void *payload, int len)
+{
+    ble_att_init_write(BLE_ATT_OP_READ_MULT_VAR_REQ, payload,
+                       BLE_ATT_READ_MULT_VAR_REQ_BASE_SZ, len);
+}
+
+void
+ble_att_read_mult_var_rsp_parse(const void *payload, int len)
+{
+    ble_att_init_parse(BLE_ATT_OP_READ_MULT_VAR_RSP, payload,
+                       BLE_ATT_READ_MULT_VAR_RSP_BASE_SZ, len);
+}
+
+void
+ble_att_read_mult_var_rsp_write(void *payload, int len)
+{
+    ble_att_init_write(BLE_ATT_OP_READ_MULT_VAR_RSP, payload,
+                       BLE_ATT_READ_MULT_VAR_RSP_BASE_SZ, len);
+}
+
 void
 ble_att_read_group_type_req_parse(const void *payload, int len,
                                   struct ble_att_read_group_type_req *dst)
@@ -702,6 +730,20 @@ ble_att_notify_req_log(const struct ble_att_notify_req *cmd)
     BLE_HS_LOG(DEBUG, "handle=0x%04x", cmd->banq_handle);
 }
 
+void
+ble_att_notify_multi_req_parse(const void *payload, int len)
+{
+    ble_att_init_parse(BLE_ATT_OP_NOTIFY_MULTI_REQ, payload,
+                       BLE_ATT_NOTIFY_MULTI_REQ_BASE_SZ, len);
+}
+
+void
+ble_att_notify_multi_req_write(void *payload, int len)
+{
+    ble_att_init_write(BLE_ATT_OP_NOTIFY_MULTI_REQ, payload,
+                       BLE_ATT_NOTIFY_MULTI_REQ_BASE_SZ, len);
+}
+
 void
 ble_att_indicate_req_parse(const void *payload, int len,
                            struct ble_att_indicate_req *dst)
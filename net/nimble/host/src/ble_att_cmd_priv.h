@@ -225,6 +225,26 @@ struct ble_att_read_mult_req {
  */
 #define BLE_ATT_READ_MULT_RSP_BASE_SZ   1
 
+/**
+ * | Parameter                          | Size (octets)     |
+ * +------------------------------------+-------------------+
+ * | Attribute Opcode                   | 1                 |
+ * | Set Of Handles                     | 4 to (ATT_MTU-1)  |
+ */
+#define BLE_ATT_READ_MULT_VAR_REQ_BASE_SZ   1
+
+/**
+ * | Parameter                          | Size (octets)     |
+ * +------------------------------------+-------------------+
+ * | Attribute Opcode                   | 1                 |
+ * | Length Value Tuple List            | 2 to (ATT_MTU-1)  |
+ *
+ * Each tuple is a 2-octet value length followed by the value.  The last
+ * value may be truncated to fit the MTU.
+ */
+#define BLE_ATT_READ_MULT_VAR_RSP_BASE_SZ   1
+#define BLE_ATT_READ_MULT_VAR_TUPLE_SZ      2
+
 /**
  * | Parameter                          | Size (octets)     |
  * +------------------------------------+-------------------+
@@ -321,6 +341,18 @@ struct ble_att_notify_req {
     uint16_t banq_handle;
 } __attribute__((packed));
 
+/**
+ * | Parameter                          | Size (octets)     |
+ * +------------------------------------+-------------------+
+ * | Attribute Opcode                   | 1                 |
+ * | Handle Length Value Tuple List     | 8 to (ATT_MTU-1)  |
+ *
+ * Each tuple is a 2-octet attribute handle, a 2-octet value length, and the
+ * value.
+ */
+#define BLE_ATT_NOTIFY_MULTI_REQ_BASE_SZ    1
+#define BLE_ATT_NOTIFY_MULTI_TUPLE_SZ       4
+
 /**
  * | Parameter                          | Size (octets)     |
  * +------------------------------------+-------------------+
@@ -407,6 +439,10 @@ void ble_att_read_mult_req_parse(const void *payload, int len);
 void ble_att_read_mult_req_write(void *payload, int len);
 void ble_att_read_mult_rsp_parse(const void *payload, int len);
 void ble_att_read_mult_rsp_write(void *payload, int len);
+void ble_att_read_mult_var_req_parse(const void *payload, int len);
+void ble_att_read_mult_var_req_write(void *payload, int len);
+void ble_att_read_mult_var_rsp_parse(const void *payload, int len);
+void ble_att_read_mult_var_rsp_write(void *payload, int len);
 void ble_att_read_group_type_req_parse(
     const void *payload, int len, struct ble_att_read_group_type_req *req);
 void ble_att_read_group_type_req_write(
@@ -450,6 +486,8 @@ void ble_att_notify_req_parse(const void *payload, int len,
 void ble_att_notify_req_write(void *payload, int len,
                               const struct ble_att_notify_req *req);
 void ble_att_notify_req_log(const struct ble_att_notify_req *cmd);
+void ble_att_notify_multi_req_parse(const void *payload, int len);
+void ble_att_notify_multi_req_write(void *payload, int len);
 void ble_att_indicate_req_parse(const void *payload, int len,
                                 struct ble_att_indicate_req *req);
 void ble_att_indicate_req_write(void *payload, int len,
@@ -78,6 +78,10 @@ STATS_SECT_START(ble_att_stats)
     STATS_SECT_ENTRY(read_mult_req_tx)
     STATS_SECT_ENTRY(read_mult_rsp_rx)
     STATS_SECT_ENTRY(read_mult_rsp_tx)
+    STATS_SECT_ENTRY(read_mult_var_req_rx)
+    STATS_SECT_ENTRY(read_mult_var_req_tx)
+    STATS_SECT_ENTRY(read_mult_var_rsp_rx)
+    STATS_SECT_ENTRY(read_mult_var_rsp_tx)
     STATS_SECT_ENTRY(read_group_type_req_rx)
     STATS_SECT_ENTRY(read_group_type_req_tx)
     STATS_SECT_ENTRY(read_group_type_rsp_rx)
@@ -96,6 +100,8 @@ STATS_SECT_START(ble_att_stats)
     STATS_SECT_ENTRY(exec_write_rsp_tx)
     STATS_SECT_ENTRY(notify_req_rx)
     STATS_SECT_ENTRY(notify_req_tx)
+    STATS_SECT_ENTRY(notify_multi_req_rx)
+    STATS_SECT_ENTRY(notify_multi_req_tx)
     STATS_SECT_ENTRY(indicate_req_rx)
     STATS_SECT_ENTRY(indicate_req_tx)
     STATS_SECT_ENTRY(indicate_rsp_rx)
@@ -122,6 +128,11 @@ struct ble_att_svr_conn {
     /** This list is sorted by attribute handle ID. */
     struct ble_att_prep_entry_list basc_prep_list;
     os_time_t basc_prep_timeout_at;
+#if MYNEWT_VAL(BLE_ATT_SVR_READ_CACHE)
+    /** Full value of the attribute being read with Read Blob requests. */
+    struct os_mbuf *basc_read_cache;
+    uint16_t basc_read_cache_handle;
+#endif
 };
 
 /**
@@ -145,7 +156,9 @@ int ble_att_svr_register(const ble_uuid_t *uuid, uint8_t flags,
                          ble_att_svr_access_fn *cb, void *cb_arg);
 
 struct ble_att_svr_entry {
+#if !MYNEWT_VAL(BLE_ATT_SVR_FLAT)
     STAILQ_ENTRY(ble_att_svr_entry) ha_next;
+#endif
 
     const ble_uuid_t *ha_uuid;
     uint8_t ha_flags;
@@ -153,6 +166,10 @@ struct ble_att_svr_entry {
     uint16_t ha_handle_id;
     ble_att_svr_access_fn *ha_cb;
     void *ha_cb_arg;
+#if MYNEWT_VAL(BLE_ATT_SVR_INDEX)
+    /* Next entry, by handle, in the same UUID hash bucket. */
+    struct ble_att_svr_entry *ha_uuid_next;
+#endif
 };
 
 SLIST_HEAD(ble_att_clt_entry_list, ble_att_clt_entry);
@@ -186,6 +203,7 @@ ble_att_svr_find_by_uuid(struct ble_att_svr_entry *start_at,
 uint16_t ble_att_svr_prev_handle(void);
 int ble_att_svr_rx_mtu(uint16_t conn_handle, struct os_mbuf **rxom);
 struct ble_att_svr_entry *ble_att_svr_find_by_handle(uint16_t handle_id);
+struct ble_att_svr_entry *ble_att_svr_next(struct ble_att_svr_entry *entry);
 int32_t ble_att_svr_ticks_until_tmo(const struct ble_att_svr_conn *svr,
                                     os_time_t now);
 int ble_att_svr_rx_find_info(uint16_t conn_handle, struct os_mbuf **rxom);
@@ -201,6 +219,8 @@ int ble_att_svr_rx_read_blob(uint16_t conn_handle,
                              struct os_mbuf **rxom);
 int ble_att_svr_rx_read_mult(uint16_t conn_handle,
                              struct os_mbuf **rxom);
+int ble_att_svr_rx_read_mult_var(uint16_t conn_handle,
+                                 struct os_mbuf **rxom);
 int ble_att_svr_rx_write(uint16_t conn_handle,
                          struct os_mbuf **rxom);
 int ble_att_svr_rx_write_no_rsp(uint16_t conn_handle, struct os_mbuf **rxom);
@@ -210,9 +230,15 @@ int ble_att_svr_rx_exec_write(uint16_t conn_handle,
                               struct os_mbuf **rxom);
 int ble_att_svr_rx_notify(uint16_t conn_handle,
                           struct os_mbuf **rxom);
+int ble_att_svr_rx_notify_multi(uint16_t conn_handle,
+                                struct os_mbuf **rxom);
 int ble_att_svr_rx_indicate(uint16_t conn_handle,
                             struct os_mbuf **rxom);
 void ble_att_svr_prep_clear(struct ble_att_prep_entry_list *prep_list);
+#if MYNEWT_VAL(BLE_ATT_SVR_READ_CACHE)
+void ble_att_svr_read_cache_clear(struct ble_att_svr_conn *basc);
+void ble_att_svr_read_cache_invalidate(uint16_t attr_handle);
+#endif
 int ble_att_svr_read_handle(uint16_t conn_handle, uint16_t attr_handle,
                             uint16_t offset, struct os_mbuf *om,
                             uint8_t *out_att_err);
@@ -260,6 +286,9 @@ int ble_att_clt_rx_read_blob(uint16_t conn_handle, struct os_mbuf **rxom);
 int ble_att_clt_tx_read_mult(uint16_t conn_handle,
                              const uint16_t *handles, int num_handles);
 int ble_att_clt_rx_read_mult(uint16_t conn_handle, struct os_mbuf **rxom);
+int ble_att_clt_tx_read_mult_var(uint16_t conn_handle,
+                                 const uint16_t *handles, int num_handles);
+int ble_att_clt_rx_read_mult_var(uint16_t conn_handle, struct os_mbuf **rxom);
 int ble_att_clt_tx_read_type(uint16_t conn_handle, uint16_t start_handle,
                              uint16_t end_handle, const ble_uuid_t *uuid);
 int ble_att_clt_rx_read_type(uint16_t conn_handle, struct os_mbuf **rxom);
@@ -288,6 +317,7 @@ int ble_att_clt_rx_exec_write(uint16_t conn_handle, struct os_mbuf **rxom);
 int ble_att_clt_rx_write(uint16_t conn_handle, struct os_mbuf **rxom);
 int ble_att_clt_tx_notify(uint16_t conn_handle, uint16_t handle,
                           struct os_mbuf *txom);
+int ble_att_clt_tx_notify_multi(uint16_t conn_handle, struct os_mbuf *txom);
 int ble_att_clt_tx_indicate(uint16_t conn_handle, uint16_t handle,
                             struct os_mbuf *txom);
 int ble_att_clt_rx_indicate(uint16_t conn_handle, struct os_mbuf **rxom);
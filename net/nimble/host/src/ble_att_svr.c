@@ -44,13 +44,92 @@
  * application may choose to retain the mbuf during the callback, so the stack
  */
 
+static uint16_t ble_att_svr_id;
+
+#if MYNEWT_VAL(BLE_ATT_SVR_FLAT)
+/**
+ * All attributes live in a single array in handle order, so entry 'h' lives
+ * at index h - 1.  Sized for ble_hs_max_attrs at startup.
+ */
+static struct ble_att_svr_entry *ble_att_svr_entries;
+#else
 STAILQ_HEAD(ble_att_svr_entry_list, ble_att_svr_entry);
 static struct ble_att_svr_entry_list ble_att_svr_list;
 
-static uint16_t ble_att_svr_id;
-
 static void *ble_att_svr_entry_mem;
 static struct os_mempool ble_att_svr_entry_pool;
+#endif
+
+#if MYNEWT_VAL(BLE_ATT_SVR_INDEX)
+#define BLE_ATT_SVR_UUID_BUCKETS MYNEWT_VAL(BLE_ATT_SVR_UUID_BUCKETS)
+
+#if (BLE_ATT_SVR_UUID_BUCKETS & (BLE_ATT_SVR_UUID_BUCKETS - 1)) != 0
+#error "BLE_ATT_SVR_UUID_BUCKETS must be a power of two"
+#endif
+
+/**
+ * Handles are assigned contiguously starting at 1, so entry 'h' lives at
+ * index h - 1.  Sized for ble_hs_max_attrs at startup.
+ */
+static struct ble_att_svr_entry **ble_att_svr_handle_idx;
+
+/** Per bucket, the first and last entry in handle order. */
+static struct ble_att_svr_entry *
+    ble_att_svr_uuid_head[BLE_ATT_SVR_UUID_BUCKETS];
+static struct ble_att_svr_entry *
+    ble_att_svr_uuid_tail[BLE_ATT_SVR_UUID_BUCKETS];
+
+static int
+ble_att_svr_uuid_bucket(const ble_uuid_t *uuid)
+{
+    uint32_t val;
+
+    switch (uuid->type) {
+    case BLE_UUID_TYPE_16:
+        val = BLE_UUID16(uuid)->value;
+        break;
+    case BLE_UUID_TYPE_32:
+        val = BLE_UUID32(uuid)->value;
+        break;
+    default:
+        /* Bytes 12 and 13 hold the 16-bit alias of a Bluetooth UUID; for
+         * vendor UUIDs they are as random as any other pair.
+         */
+        val = get_le16(&BLE_UUID128(uuid)->value[12]);
+        break;
+    }
+
+    val ^= val >> 16;
+    val ^= val >> 8;
+    val ^= val >> 4;
+    return val & (BLE_ATT_SVR_UUID_BUCKETS - 1);
+}
+
+static void
+ble_att_svr_index_add(struct ble_att_svr_entry *entry)
+{
+    int bucket;
+
+    if (ble_att_svr_handle_idx != NULL) {
+        ble_att_svr_handle_idx[entry->ha_handle_id - 1] = entry;
+    }
+
+    bucket = ble_att_svr_uuid_bucket(entry->ha_uuid);
+    if (ble_att_svr_uuid_tail[bucket] == NULL) {
+        ble_att_svr_uuid_head[bucket] = entry;
+    } else {
+        ble_att_svr_uuid_tail[bucket]->ha_uuid_next = entry;
+    }
+    ble_att_svr_uuid_tail[bucket] = entry;
+}
+
+static void
+ble_att_svr_index_reset(void)
+{
+    memset(ble_att_svr_uuid_head, 0, sizeof ble_att_svr_uuid_head);
+    memset(ble_att_svr_uuid_tail, 0, sizeof ble_att_svr_uuid_tail);
+}
+#endif
 
 static os_membuf_t ble_att_svr_prep_entry_mem[
     OS_MEMPOOL_SIZE(MYNEWT_VAL(BLE_ATT_SVR_MAX_PREP_ENTRIES),
@@ -64,7 +143,14 @@ ble_att_svr_entry_alloc(void)
 {
     struct ble_att_svr_entry *entry;
 
+#if MYNEWT_VAL(BLE_ATT_SVR_FLAT)
+    if (ble_att_svr_entries == NULL || ble_att_svr_id >= ble_hs_max_attrs) {
+        return NULL;
+    }
+    entry = ble_att_svr_entries + ble_att_svr_id;
+#else
     entry = os_memblock_get(&ble_att_svr_entry_pool);
+#endif
     if (entry != NULL) {
         memset(entry, 0, sizeof *entry);
     }
@@ -115,7 +201,12 @@ ble_att_svr_register(const ble_uuid_t *uuid, uint8_t flags,
     entry->ha_cb = cb;
     entry->ha_cb_arg = cb_arg;
 
+#if !MYNEWT_VAL(BLE_ATT_SVR_FLAT)
     STAILQ_INSERT_TAIL(&ble_att_svr_list, entry, ha_next);
+#endif
+#if MYNEWT_VAL(BLE_ATT_SVR_INDEX)
+    ble_att_svr_index_add(entry);
+#endif
 
     if (handle_id != NULL) {
         *handle_id = entry->ha_handle_id;
@@ -130,6 +221,39 @@ ble_att_svr_prev_handle(void)
     return ble_att_svr_id;
 }
 
+/**
+ * Retrieves the attribute following the specified one, in handle order.
+ *
+ * @param entry                 The attribute to start after; null means
+ *                                  retrieve the first attribute.
+ *
+ * @return                      The next attribute, or NULL if the end of the
+ *                                  attribute list was reached.
+ */
+struct ble_att_svr_entry *
+ble_att_svr_next(struct ble_att_svr_entry *entry)
+{
+#if MYNEWT_VAL(BLE_ATT_SVR_FLAT)
+    uint16_t handle_id;
+
+    if (entry == NULL) {
+        handle_id = 1;
+    } else {
+        handle_id = entry->ha_handle_id + 1;
+    }
+
+    if (handle_id > ble_att_svr_id) {
+        return NULL;
+    }
+    return ble_att_svr_entries + handle_id - 1;
+#else
+    if (entry == NULL) {
+        return STAILQ_FIRST(&ble_att_svr_list);
+    }
+    return STAILQ_NEXT(entry, ha_next);
+#endif
+}
+
 /**
  * Find a host attribute by handle id.
  *
@@ -149,9 +273,25 @@ ble_att_svr_find_by_handle(uint16_t handle_id)
 {
     struct ble_att_svr_entry *entry;
 
-    for (entry = STAILQ_FIRST(&ble_att_svr_list);
+#if MYNEWT_VAL(BLE_ATT_SVR_FLAT)
+    if (handle_id == 0 || handle_id > ble_att_svr_id) {
+        return NULL;
+    }
+    return ble_att_svr_entries + handle_id - 1;
+#endif
+
+#if MYNEWT_VAL(BLE_ATT_SVR_INDEX)
+    if (ble_att_svr_handle_idx != NULL) {
+        if (handle_id == 0 || handle_id > ble_att_svr_id) {
+            return NULL;
+        }
+        return ble_att_svr_handle_idx[handle_id - 1];
+    }
+#endif
+
+    for (entry = ble_att_svr_next(NULL);
          entry != NULL;
-         entry = STAILQ_NEXT(entry, ha_next)) {
+         entry = ble_att_svr_next(entry)) {
 
         if (entry->ha_handle_id == handle_id) {
             return entry;
@@ -180,16 +320,36 @@ ble_att_svr_find_by_uuid(struct ble_att_svr_entry *prev, const ble_uuid_t *uuid,
                          uint16_t end_handle)
 {
     struct ble_att_svr_entry *entry;
+#if MYNEWT_VAL(BLE_ATT_SVR_INDEX)
+    int bucket;
 
-    if (prev == NULL) {
-        entry = STAILQ_FIRST(&ble_att_svr_list);
-    } else {
-        entry = STAILQ_NEXT(prev, ha_next);
+    /* Walk the UUID's hash chain, unless the caller resumes from an entry
+     * in a different chain.
+     */
+    bucket = ble_att_svr_uuid_bucket(uuid);
+    if (prev == NULL || ble_att_svr_uuid_bucket(prev->ha_uuid) == bucket) {
+        if (prev == NULL) {
+            entry = ble_att_svr_uuid_head[bucket];
+        } else {
+            entry = prev->ha_uuid_next;
+        }
+
+        for (;
+             entry != NULL && entry->ha_handle_id <= end_handle;
+             entry = entry->ha_uuid_next) {
+
+            if (ble_uuid_cmp(entry->ha_uuid, uuid) == 0) {
+                return entry;
+            }
+        }
+
+        return NULL;
     }
+#endif
 
-    for (;
+    for (entry = ble_att_svr_next(prev);
          entry != NULL && entry->ha_handle_id <= end_handle;
-         entry = STAILQ_NEXT(entry, ha_next)) {
+         entry = ble_att_svr_next(entry)) {
 
         if (ble_uuid_cmp(entry->ha_uuid, uuid) == 0) {
             return entry;
@@ -530,6 +690,9 @@ ble_att_svr_write(uint16_t conn_handle, struct ble_att_svr_entry *entry,
     BLE_HS_DBG_ASSERT(entry->ha_cb != NULL);
     rc = entry->ha_cb(conn_handle, entry->ha_handle_id,
                       BLE_ATT_ACCESS_OP_WRITE, offset, om, entry->ha_cb_arg);
+#if MYNEWT_VAL(BLE_ATT_SVR_READ_CACHE)
+    ble_att_svr_read_cache_invalidate(entry->ha_handle_id);
+#endif
     if (rc != 0) {
         att_err = rc;
         rc = BLE_HS_EAPP;
@@ -725,7 +888,8 @@ done:
 int
 ble_att_svr_rx_mtu(uint16_t conn_handle, struct os_mbuf **rxom)
 {
-    struct ble_att_mtu_cmd *cmd;
+    const struct ble_att_mtu_cmd *cmd;
+    struct ble_att_mtu_cmd cmd_buf;
     struct ble_l2cap_chan *chan;
     struct ble_hs_conn *conn;
     struct os_mbuf *txom;
@@ -736,12 +900,13 @@ ble_att_svr_rx_mtu(uint16_t conn_handle, struct os_mbuf **rxom)
     txom = NULL;
     mtu = 0;
 
-    rc = ble_att_svr_pullup_req_base(rxom, sizeof(*cmd), &att_err);
-    if (rc != 0) {
+    cmd = ble_hs_mbuf_peek(*rxom, 0, sizeof *cmd, &cmd_buf);
+    if (cmd == NULL) {
+        att_err = 0;
+        rc = BLE_HS_EBADDATA;
         goto done;
     }
 
-    cmd = (struct ble_att_mtu_cmd *)(*rxom)->om_data;
     BLE_ATT_LOG_CMD(0, "mtu req", conn_handle, ble_att_mtu_cmd_log, cmd);
 
     mtu = le16toh(cmd->bamc_mtu);
@@ -805,7 +970,7 @@ ble_att_svr_fill_info(uint16_t start_handle, uint16_t end_handle,
     num_entries = 0;
     rc = 0;
 
-    STAILQ_FOREACH(ha, &ble_att_svr_list, ha_next) {
+    for (ha = ble_att_svr_next(NULL); ha != NULL; ha = ble_att_svr_next(ha)) {
         if (ha->ha_handle_id > end_handle) {
             rc = 0;
             goto done;
@@ -913,7 +1078,8 @@ ble_att_svr_rx_find_info(uint16_t conn_handle, struct os_mbuf **rxom)
     return BLE_HS_ENOTSUP;
 #endif
 
-    struct ble_att_find_info_req *req;
+    const struct ble_att_find_info_req *req;
+    struct ble_att_find_info_req req_buf;
     struct os_mbuf *txom;
     uint16_t err_handle, start_handle, end_handle;
     uint8_t att_err;
@@ -924,13 +1090,12 @@ ble_att_svr_rx_find_info(uint16_t conn_handle, struct os_mbuf **rxom)
     att_err = 0;
     err_handle = 0;
 
-    rc = ble_att_svr_pullup_req_base(rxom, sizeof(*req), &att_err);
-    if (rc != 0) {
-        err_handle = 0;
+    req = ble_hs_mbuf_peek(*rxom, 0, sizeof *req, &req_buf);
+    if (req == NULL) {
+        rc = BLE_HS_EBADDATA;
         goto done;
     }
 
-    req = (struct ble_att_find_info_req *)(*rxom)->om_data;
     start_handle = le16toh(req->bafq_start_handle);
     end_handle = le16toh(req->bafq_end_handle);
 
@@ -1096,7 +1261,7 @@ ble_att_svr_fill_type_value(uint16_t conn_handle,
      * matching group.  For each attribute entry, determine if data needs to be
      * written to the response.
      */
-    STAILQ_FOREACH(ha, &ble_att_svr_list, ha_next) {
+    for (ha = ble_att_svr_next(NULL); ha != NULL; ha = ble_att_svr_next(ha)) {
         if (ha->ha_handle_id < start_handle) {
             continue;
         }
@@ -1225,7 +1390,8 @@ ble_att_svr_rx_find_type_value(uint16_t conn_handle, struct os_mbuf **rxom)
     return BLE_HS_ENOTSUP;
 #endif
 
-    struct ble_att_find_type_value_req *req;
+    const struct ble_att_find_type_value_req *req;
+    struct ble_att_find_type_value_req req_buf;
     uint16_t start_handle, end_handle;
     ble_uuid16_t attr_type;
     struct os_mbuf *txom;
@@ -1238,12 +1404,12 @@ ble_att_svr_rx_find_type_value(uint16_t conn_handle, struct os_mbuf **rxom)
     att_err = 0;
     err_handle = 0;
 
-    rc = ble_att_svr_pullup_req_base(rxom, sizeof(*req), &att_err);
-    if (rc != 0) {
+    req = ble_hs_mbuf_peek(*rxom, 0, sizeof *req, &req_buf);
+    if (req == NULL) {
+        rc = BLE_HS_EBADDATA;
         goto done;
     }
 
-    req = (struct ble_att_find_type_value_req *)(*rxom)->om_data;
     start_handle = le16toh(req->bavq_start_handle);
     end_handle = le16toh(req->bavq_end_handle);
     attr_type = (ble_uuid16_t) BLE_UUID16_INIT(le16toh(req->bavq_attr_type));
@@ -1465,6 +1631,169 @@ done:
     return rc;
 }
 
+#if MYNEWT_VAL(BLE_ATT_SVR_READ_CACHE)
+void
+ble_att_svr_read_cache_clear(struct ble_att_svr_conn *basc)
+{
+    os_mbuf_free_chain(basc->basc_read_cache);
+    basc->basc_read_cache = NULL;
+    basc->basc_read_cache_handle = 0;
+}
+
+/**
+ * Drops every connection's cached copy of the specified attribute.
+ */
+void
+ble_att_svr_read_cache_invalidate(uint16_t attr_handle)
+{
+    struct ble_hs_conn *conn;
+    int i;
+
+    ble_hs_lock();
+    for (i = 0; ; i++) {
+        conn = ble_hs_conn_find_by_idx(i);
+        if (conn == NULL) {
+            break;
+        }
+
+        if (conn->bhc_att_svr.basc_read_cache != NULL &&
+            conn->bhc_att_svr.basc_read_cache_handle == attr_handle) {
+
+            ble_att_svr_read_cache_clear(&conn->bhc_att_svr);
+        }
+    }
+    ble_hs_unlock();
+}
+
+/**
+ * Replaces the connection's cached value; consumes 'value' in all cases.
+ */
+static void
+ble_att_svr_read_cache_set(uint16_t conn_handle, uint16_t attr_handle,
+                           struct os_mbuf *value)
+{
+    struct ble_hs_conn *conn;
+
+    ble_hs_lock();
+    conn = ble_hs_conn_find(conn_handle);
+    if (conn != NULL) {
+        ble_att_svr_read_cache_clear(&conn->bhc_att_svr);
+        conn->bhc_att_svr.basc_read_cache = value;
+        conn->bhc_att_svr.basc_read_cache_handle = attr_handle;
+        value = NULL;
+    }
+    ble_hs_unlock();
+
+    os_mbuf_free_chain(value);
+}
+
+/**
+ * Appends the portion of 'value' starting at 'offset' that fits in one
+ * response onto 'txom'.  Sets *out_more if the peer is expected to request
+ * further portions.
+ */
+static int
+ble_att_svr_read_slice(struct os_mbuf *value, uint16_t offset,
+                       uint16_t max_len, struct os_mbuf *txom,
+                       int *out_more, uint8_t *out_att_err)
+{
+    uint16_t len;
+    int rc;
+
+    if (offset > OS_MBUF_PKTLEN(value)) {
+        *out_att_err = BLE_ATT_ERR_INVALID_OFFSET;
+        return BLE_HS_EAPP;
+    }
+
+    len = min(OS_MBUF_PKTLEN(value) - offset, max_len);
+    rc = os_mbuf_appendfrom(txom, value, offset, len);
+    if (rc != 0) {
+        *out_att_err = BLE_ATT_ERR_INSUFFICIENT_RES;
+        return BLE_HS_ENOMEM;
+    }
+
+    /* A full-sized response tells the peer to keep reading. */
+    *out_more = len == max_len;
+
+    return 0;
+}
+
+/**
+ * Serves a Read Blob request, from the connection's cached value when it
+ * holds the requested attribute.  Otherwise the full value is read, and kept
+ * if it does not fit in this response.
+ */
+static int
+ble_att_svr_read_blob_cached(uint16_t conn_handle, uint16_t attr_handle,
+                             uint16_t offset, struct os_mbuf *txom,
+                             uint8_t *out_att_err)
+{
+    struct ble_att_svr_entry *entry;
+    struct ble_hs_conn *conn;
+    struct os_mbuf *value;
+    uint16_t max_len;
+    int more;
+    int hit;
+    int rc;
+
+    entry = ble_att_svr_find_by_handle(attr_handle);
+    if (entry == NULL) {
+        *out_att_err = BLE_ATT_ERR_INVALID_HANDLE;
+        return BLE_HS_ENOENT;
+    }
+
+    /* The response already contains the one-byte opcode. */
+    max_len = ble_att_mtu(conn_handle) - 1;
+
+    rc = ble_att_svr_check_perms(conn_handle, 1, entry, out_att_err);
+    if (rc != 0) {
+        return rc;
+    }
+
+    hit = 0;
+    more = 0;
+    ble_hs_lock();
+    conn = ble_hs_conn_find(conn_handle);
+    if (conn != NULL &&
+        conn->bhc_att_svr.basc_read_cache != NULL &&
+        conn->bhc_att_svr.basc_read_cache_handle == attr_handle) {
+
+        hit = 1;
+        rc = ble_att_svr_read_slice(conn->bhc_att_svr.basc_read_cache,
+                                    offset, max_len, txom, &more,
+                                    out_att_err);
+        if (rc != 0 || !more) {
+            ble_att_svr_read_cache_clear(&conn->bhc_att_svr);
+        }
+    }
+    ble_hs_unlock();
+
+    if (hit) {
+        return rc;
+    }
+
+    value = os_msys_get_pkthdr(0, 0);
+    if (value == NULL) {
+        *out_att_err = BLE_ATT_ERR_INSUFFICIENT_RES;
+        return BLE_HS_ENOMEM;
+    }
+
+    rc = ble_att_svr_read(conn_handle, entry, 0, value, out_att_err);
+    if (rc == 0) {
+        rc = ble_att_svr_read_slice(value, offset, max_len, txom, &more,
+                                    out_att_err);
+    }
+
+    if (rc == 0 && more) {
+        ble_att_svr_read_cache_set(conn_handle, attr_handle, value);
+    } else {
+        os_mbuf_free_chain(value);
+    }
+
+    return rc;
+}
+#endif
+
 int
 ble_att_svr_rx_read(uint16_t conn_handle, struct os_mbuf **rxom)
 {
@@ -1472,7 +1801,8 @@ ble_att_svr_rx_read(uint16_t conn_handle, struct os_mbuf **rxom)
     return BLE_HS_ENOTSUP;
 #endif
 
-    struct ble_att_read_req *req;
+    const struct ble_att_read_req *req;
+    struct ble_att_read_req req_buf;
     struct os_mbuf *txom;
     uint16_t err_handle;
     uint8_t att_err;
@@ -1483,12 +1813,12 @@ ble_att_svr_rx_read(uint16_t conn_handle, struct os_mbuf **rxom)
     att_err = 0;
     err_handle = 0;
 
-    rc = ble_att_svr_pullup_req_base(rxom, sizeof(*req), &att_err);
-    if (rc != 0) {
+    req = ble_hs_mbuf_peek(*rxom, 0, sizeof *req, &req_buf);
+    if (req == NULL) {
+        rc = BLE_HS_EBADDATA;
         goto done;
     }
 
-    req = (struct ble_att_read_req *)(*rxom)->om_data;
     BLE_ATT_LOG_CMD(0, "read req", conn_handle, ble_att_read_req_log, req);
 
     err_handle = le16toh(req->barq_handle);
@@ -1509,6 +1839,25 @@ ble_att_svr_rx_read(uint16_t conn_handle, struct os_mbuf **rxom)
         goto done;
     }
 
+#if MYNEWT_VAL(BLE_ATT_SVR_READ_CACHE)
+    /* If the value gets truncated, the peer will likely follow up with Read
+     * Blob requests; keep the full value around for them.
+     */
+    if (OS_MBUF_PKTLEN(txom) > ble_att_mtu(conn_handle)) {
+        struct os_mbuf *value;
+
+        value = os_msys_get_pkthdr(0, 0);
+        if (value != NULL) {
+            if (os_mbuf_appendfrom(value, txom, 1,
+                                   OS_MBUF_PKTLEN(txom) - 1) == 0) {
+                ble_att_svr_read_cache_set(conn_handle, err_handle, value);
+            } else {
+                os_mbuf_free_chain(value);
+            }
+        }
+    }
+#endif
+
 done:
     rc = ble_att_svr_tx_rsp(conn_handle, rc, txom, BLE_ATT_OP_READ_REQ,
                             att_err, err_handle);
@@ -1522,7 +1871,8 @@ ble_att_svr_rx_read_blob(uint16_t conn_handle, struct os_mbuf **rxom)
     return BLE_HS_ENOTSUP;
 #endif
 
-    struct ble_att_read_blob_req *req;
+    const struct ble_att_read_blob_req *req;
+    struct ble_att_read_blob_req req_buf;
     struct os_mbuf *txom;
     uint16_t err_handle, offset;
     uint8_t att_err;
@@ -1533,12 +1883,12 @@ ble_att_svr_rx_read_blob(uint16_t conn_handle, struct os_mbuf **rxom)
     att_err = 0;
     err_handle = 0;
 
-    rc = ble_att_svr_pullup_req_base(rxom, sizeof(*req), &att_err);
-    if (rc != 0) {
+    req = ble_hs_mbuf_peek(*rxom, 0, sizeof *req, &req_buf);
+    if (req == NULL) {
+        rc = BLE_HS_EBADDATA;
         goto done;
     }
 
-    req = (struct ble_att_read_blob_req *)(*rxom)->om_data;
     BLE_ATT_LOG_CMD(0, "read blob req", conn_handle, ble_att_read_blob_req_log,
                     req);
 
@@ -1556,8 +1906,13 @@ ble_att_svr_rx_read_blob(uint16_t conn_handle, struct os_mbuf **rxom)
         goto done;
     }
 
+#if MYNEWT_VAL(BLE_ATT_SVR_READ_CACHE)
+    rc = ble_att_svr_read_blob_cached(conn_handle, err_handle, offset,
+                                      txom, &att_err);
+#else
     rc = ble_att_svr_read_handle(conn_handle, err_handle, offset,
                                  txom, &att_err);
+#endif
     if (rc != 0) {
         goto done;
     }
@@ -1582,6 +1937,7 @@ ble_att_svr_build_read_mult_rsp(uint16_t conn_handle,
     struct os_mbuf *txom;
     uint16_t handle;
     uint16_t mtu;
+    uint8_t buf[2];
     int rc;
 
     mtu = ble_att_mtu(conn_handle);
@@ -1604,19 +1960,10 @@ ble_att_svr_build_read_mult_rsp(uint16_t conn_handle,
      * response is full.
      */
     while (OS_MBUF_PKTLEN(*rxom) >= 2 && OS_MBUF_PKTLEN(txom) < mtu) {
-        /* Ensure the full 16-bit handle is contiguous at the start of the
-         * mbuf.
-         */
-        rc = ble_att_svr_pullup_req_base(rxom, 2, att_err);
-        if (rc != 0) {
-            *err_handle = 0;
-            goto done;
-        }
-
         /* Extract the 16-bit handle and strip it from the front of the
          * mbuf.
          */
-        handle = get_le16((*rxom)->om_data);
+        handle = get_le16(ble_hs_mbuf_peek(*rxom, 0, 2, buf));
         os_mbuf_adj(*rxom, 2);
 
         rc = ble_att_svr_read_handle(conn_handle, handle, 0, txom, att_err);
@@ -1660,6 +2007,109 @@ ble_att_svr_rx_read_mult(uint16_t conn_handle, struct os_mbuf **rxom)
                               att_err, err_handle);
 }
 
+static int
+ble_att_svr_build_read_mult_var_rsp(uint16_t conn_handle,
+                                    struct os_mbuf **rxom,
+                                    struct os_mbuf **out_txom,
+                                    uint8_t *att_err,
+                                    uint16_t *err_handle)
+{
+    struct os_mbuf *txom;
+    uint16_t value_len;
+    uint16_t handle;
+    uint16_t mtu;
+    uint8_t buf[BLE_ATT_READ_MULT_VAR_TUPLE_SZ];
+    int off;
+    int rc;
+
+    mtu = ble_att_mtu(conn_handle);
+
+    rc = ble_att_svr_pkt(rxom, &txom, att_err);
+    if (rc != 0) {
+        *err_handle = 0;
+        goto done;
+    }
+
+    if (ble_att_cmd_prepare(BLE_ATT_OP_READ_MULT_VAR_RSP, 0, txom) == NULL) {
+        *att_err = BLE_ATT_ERR_INSUFFICIENT_RES;
+        *err_handle = 0;
+        rc = BLE_HS_ENOMEM;
+        goto done;
+    }
+
+    /* Each value is preceded by its length.  As with read multiple, stop when
+     * the response is full; the final value gets truncated to the MTU when
+     * the response is sent.
+     */
+    while (OS_MBUF_PKTLEN(*rxom) >= 2 && OS_MBUF_PKTLEN(txom) < mtu) {
+        handle = get_le16(ble_hs_mbuf_peek(*rxom, 0, 2, buf));
+        os_mbuf_adj(*rxom, 2);
+
+        /* Reserve space for the length; fill it in once the value has been
+         * read.
+         */
+        off = OS_MBUF_PKTLEN(txom);
+        put_le16(buf, 0);
+        rc = os_mbuf_append(txom, buf, sizeof buf);
+        if (rc != 0) {
+            *att_err = BLE_ATT_ERR_INSUFFICIENT_RES;
+            *err_handle = handle;
+            rc = BLE_HS_ENOMEM;
+            goto done;
+        }
+
+        rc = ble_att_svr_read_handle(conn_handle, handle, 0, txom, att_err);
+        if (rc != 0) {
+            *err_handle = handle;
+            goto done;
+        }
+
+        value_len = OS_MBUF_PKTLEN(txom) - off - sizeof buf;
+        put_le16(buf, value_len);
+        rc = os_mbuf_copyinto(txom, off, buf, sizeof buf);
+        if (rc != 0) {
+            *att_err = BLE_ATT_ERR_INSUFFICIENT_RES;
+            *err_handle = handle;
+            rc = BLE_HS_ENOMEM;
+            goto done;
+        }
+    }
+
+    BLE_ATT_LOG_EMPTY_CMD(1, "read mult var rsp", conn_handle);
+    rc = 0;
+
+done:
+    *out_txom = txom;
+    return rc;
+}
+
+int
+ble_att_svr_rx_read_mult_var(uint16_t conn_handle, struct os_mbuf **rxom)
+{
+#if !MYNEWT_VAL(BLE_ATT_SVR_READ_MULT_VAR)
+    return BLE_HS_ENOTSUP;
+#endif
+
+    struct os_mbuf *txom;
+    uint16_t err_handle;
+    uint8_t att_err;
+    int rc;
+
+    BLE_ATT_LOG_EMPTY_CMD(0, "read mult var req", conn_handle);
+
+    /* Initialize some values in case of early error. */
+    txom = NULL;
+    err_handle = 0;
+    att_err = 0;
+
+    rc = ble_att_svr_build_read_mult_var_rsp(conn_handle, rxom, &txom,
+                                             &att_err, &err_handle);
+
+    return ble_att_svr_tx_rsp(conn_handle, rc, txom,
+                              BLE_ATT_OP_READ_MULT_VAR_REQ,
+                              att_err, err_handle);
+}
+
 static int
 ble_att_svr_is_valid_read_group_type(const ble_uuid_t *uuid)
 {
@@ -1766,7 +2216,10 @@ ble_att_svr_build_read_group_type_rsp(uint16_t conn_handle,
 
     start_group_handle = 0;
     rsp->bagp_length = 0;
-    STAILQ_FOREACH(entry, &ble_att_svr_list, ha_next) {
+    for (entry = ble_att_svr_next(NULL);
+         entry != NULL;
+         entry = ble_att_svr_next(entry)) {
+
         if (entry->ha_handle_id < start_handle) {
             continue;
         }
@@ -2008,7 +2461,8 @@ ble_att_svr_rx_write(uint16_t conn_handle, struct os_mbuf **rxom)
     return BLE_HS_ENOTSUP;
 #endif
 
-    struct ble_att_write_req *req;
+    const struct ble_att_write_req *req;
+    struct ble_att_write_req req_buf;
     struct os_mbuf *txom;
     uint16_t handle;
     uint8_t att_err;
@@ -2019,13 +2473,12 @@ ble_att_svr_rx_write(uint16_t conn_handle, struct os_mbuf **rxom)
     att_err = 0;
     handle = 0;
 
-    rc = ble_att_svr_pullup_req_base(rxom, sizeof(*req), &att_err);
-    if (rc != 0) {
+    req = ble_hs_mbuf_peek(*rxom, 0, sizeof *req, &req_buf);
+    if (req == NULL) {
+        rc = BLE_HS_EBADDATA;
         goto done;
     }
 
-    req = (struct ble_att_write_req *)(*rxom)->om_data;
-
     BLE_ATT_LOG_CMD(0, "write req", conn_handle,
                     ble_att_write_req_log, req);
 
@@ -2064,17 +2517,18 @@ ble_att_svr_rx_write_no_rsp(uint16_t conn_handle, struct os_mbuf **rxom)
     return BLE_HS_ENOTSUP;
 #endif
 
-    struct ble_att_write_req *req;
+    const struct ble_att_write_req *req;
+    struct ble_att_write_req req_buf;
     uint8_t att_err;
     uint16_t handle;
     int rc;
 
-    rc = ble_att_svr_pullup_req_base(rxom, sizeof(*req), &att_err);
-    if (rc != 0) {
+    req = ble_hs_mbuf_peek(*rxom, 0, sizeof *req, &req_buf);
+    if (req == NULL) {
+        rc = BLE_HS_EBADDATA;
         return rc;
     }
 
-    req = (struct ble_att_write_req *)(*rxom)->om_data;
     BLE_ATT_LOG_CMD(0, "write cmd", conn_handle,
                     ble_att_write_req_log, req);
 
@@ -2456,7 +2910,8 @@ ble_att_svr_rx_exec_write(uint16_t conn_handle, struct os_mbuf **rxom)
 #endif
 
     struct ble_att_prep_entry_list prep_list;
-    struct ble_att_exec_write_req *req;
+    const struct ble_att_exec_write_req *req;
+    struct ble_att_exec_write_req req_buf;
     struct ble_hs_conn *conn;
     struct os_mbuf *txom;
     uint16_t err_handle;
@@ -2468,12 +2923,13 @@ ble_att_svr_rx_exec_write(uint16_t conn_handle, struct os_mbuf **rxom)
     txom = NULL;
     err_handle = 0;
 
-    rc = ble_att_svr_pullup_req_base(rxom, sizeof(*req), &att_err);
-    if (rc != 0) {
+    req = ble_hs_mbuf_peek(*rxom, 0, sizeof *req, &req_buf);
+    if (req == NULL) {
+        att_err = 0;
+        rc = BLE_HS_EBADDATA;
         goto done;
     }
 
-    req = (struct ble_att_exec_write_req *)(*rxom)->om_data;
     BLE_ATT_LOG_CMD(0, "exec write req", conn_handle,
                     ble_att_exec_write_req_log, req);
 
@@ -2531,17 +2987,15 @@ ble_att_svr_rx_notify(uint16_t conn_handle, struct os_mbuf **rxom)
     return BLE_HS_ENOTSUP;
 #endif
 
-    struct ble_att_notify_req *req;
+    const struct ble_att_notify_req *req;
+    struct ble_att_notify_req req_buf;
     uint16_t handle;
-    int rc;
 
-    rc = ble_att_svr_pullup_req_base(rxom, sizeof(*req), NULL);
-    if (rc != 0) {
-        return BLE_HS_ENOMEM;
+    req = ble_hs_mbuf_peek(*rxom, 0, sizeof *req, &req_buf);
+    if (req == NULL) {
+        return BLE_HS_EBADDATA;
     }
 
-    req = (struct ble_att_notify_req *)(*rxom)->om_data;
-
     BLE_ATT_LOG_CMD(0, "notify req", conn_handle,
                     ble_att_notify_req_log, req);
 
@@ -2560,6 +3014,68 @@ ble_att_svr_rx_notify(uint16_t conn_handle, struct os_mbuf **rxom)
     return 0;
 }
 
+int
+ble_att_svr_rx_notify_multi(uint16_t conn_handle, struct os_mbuf **rxom)
+{
+#if !MYNEWT_VAL(BLE_ATT_SVR_NOTIFY_MULTI)
+    return BLE_HS_ENOTSUP;
+#endif
+
+    struct os_mbuf *om;
+    const uint8_t *tuple;
+    uint8_t buf[BLE_ATT_NOTIFY_MULTI_TUPLE_SZ];
+    uint16_t handle;
+    uint16_t len;
+    int rc;
+
+    BLE_ATT_LOG_EMPTY_CMD(0, "notify multi req", conn_handle);
+
+    /* Report each value to the application as a separate notification. */
+    while (OS_MBUF_PKTLEN(*rxom) > 0) {
+        tuple = ble_hs_mbuf_peek(*rxom, 0, sizeof buf, buf);
+        if (tuple == NULL) {
+            return BLE_HS_EBADDATA;
+        }
+
+        handle = get_le16(tuple);
+        len = get_le16(tuple + 2);
+        if (handle == 0) {
+            return BLE_HS_EBADDATA;
+        }
+
+        os_mbuf_adj(*rxom, BLE_ATT_NOTIFY_MULTI_TUPLE_SZ);
+        if (len > OS_MBUF_PKTLEN(*rxom)) {
+            return BLE_HS_EBADDATA;
+        }
+
+        if (len == OS_MBUF_PKTLEN(*rxom)) {
+            /* Last value; hand over the request buffer itself. */
+            om = *rxom;
+            *rxom = NULL;
+        } else {
+            om = ble_hs_mbuf_att_pkt();
+            if (om == NULL) {
+                return BLE_HS_ENOMEM;
+            }
+
+            rc = os_mbuf_appendfrom(om, *rxom, 0, len);
+            if (rc != 0) {
+                os_mbuf_free_chain(om);
+                return BLE_HS_ENOMEM;
+            }
+            os_mbuf_adj(*rxom, len);
+        }
+
+        ble_gap_notify_rx_event(conn_handle, handle, om, 0);
+
+        if (*rxom == NULL) {
+            break;
+        }
+    }
+
+    return 0;
+}
+
 /**
  * @return                      0 on success; nonzero on failure.
  */
@@ -2599,7 +3115,8 @@ ble_att_svr_rx_indicate(uint16_t conn_handle, struct os_mbuf **rxom)
     return BLE_HS_ENOTSUP;
 #endif
 
-    struct ble_att_indicate_req *req;
+    const struct ble_att_indicate_req *req;
+    struct ble_att_indicate_req req_buf;
     struct os_mbuf *txom;
     uint16_t handle;
     uint8_t att_err;
@@ -2610,12 +3127,12 @@ ble_att_svr_rx_indicate(uint16_t conn_handle, struct os_mbuf **rxom)
     att_err = 0;
     handle = 0;
 
-    rc = ble_att_svr_pullup_req_base(rxom, sizeof(*req), NULL);
-    if (rc != 0) {
+    req = ble_hs_mbuf_peek(*rxom, 0, sizeof *req, &req_buf);
+    if (req == NULL) {
+        rc = BLE_HS_EBADDATA;
         goto done;
     }
 
-    req = (struct ble_att_indicate_req *)(*rxom)->om_data;
     BLE_ATT_LOG_CMD(0, "indicate req", conn_handle,
                     ble_att_indicate_req_log, req);
 
@@ -2637,6 +3154,10 @@ ble_att_svr_rx_indicate(uint16_t conn_handle, struct os_mbuf **rxom)
     /* Strip the request base from the front of the mbuf. */
     os_mbuf_adj(*rxom, sizeof(*req));
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    ble_gattc_cache_rx_indicate(conn_handle, handle);
+#endif
+
     ble_gap_notify_rx_event(conn_handle, handle, *rxom, 1);
     *rxom = NULL;
 
@@ -2653,8 +3174,18 @@ done:
 static void
 ble_att_svr_free_start_mem(void)
 {
+#if MYNEWT_VAL(BLE_ATT_SVR_FLAT)
+    free(ble_att_svr_entries);
+    ble_att_svr_entries = NULL;
+#else
     free(ble_att_svr_entry_mem);
     ble_att_svr_entry_mem = NULL;
+#endif
+
+#if MYNEWT_VAL(BLE_ATT_SVR_INDEX)
+    free(ble_att_svr_handle_idx);
+    ble_att_svr_handle_idx = NULL;
+#endif
 }
 
 int
@@ -2665,6 +3196,14 @@ ble_att_svr_start(void)
     ble_att_svr_free_start_mem();
 
     if (ble_hs_max_attrs > 0) {
+#if MYNEWT_VAL(BLE_ATT_SVR_FLAT)
+        ble_att_svr_entries = malloc(ble_hs_max_attrs *
+                                     sizeof *ble_att_svr_entries);
+        if (ble_att_svr_entries == NULL) {
+            rc = BLE_HS_ENOMEM;
+            goto err;
+        }
+#else
         ble_att_svr_entry_mem = malloc(
             OS_MEMPOOL_BYTES(ble_hs_max_attrs,
                              sizeof (struct ble_att_svr_entry)));
@@ -2680,6 +3219,17 @@ ble_att_svr_start(void)
             rc = BLE_HS_EOS;
             goto err;
         }
+#endif
+
+#if MYNEWT_VAL(BLE_ATT_SVR_INDEX) && !MYNEWT_VAL(BLE_ATT_SVR_FLAT)
+        /* The flat table is already indexed by handle. */
+        ble_att_svr_handle_idx = malloc(ble_hs_max_attrs *
+                                        sizeof *ble_att_svr_handle_idx);
+        if (ble_att_svr_handle_idx == NULL) {
+            rc = BLE_HS_ENOMEM;
+            goto err;
+        }
+#endif
     }
 
     return 0;
@@ -2705,7 +3255,12 @@ ble_att_svr_init(void)
         }
     }
 
+#if !MYNEWT_VAL(BLE_ATT_SVR_FLAT)
     STAILQ_INIT(&ble_att_svr_list);
+#endif
+#if MYNEWT_VAL(BLE_ATT_SVR_INDEX)
+    ble_att_svr_index_reset();
+#endif
 
     ble_att_svr_id = 0;
 
@@ -24,6 +24,8 @@
 #include "os/os.h"
 #include "mem/mem.h"
 #include "nimble/nimble_opt.h"
+#include "nimble/ble.h"
+#include "nimble/hci_vendor.h"
 #include "host/ble_hs_adv.h"
 #include "ble_hs_priv.h"
 
@@ -109,6 +111,7 @@ struct ble_gap_master_state {
 
         struct {
             uint8_t limited:1;
+            uint8_t dedup:1;
         } disc;
     };
 };
@@ -322,6 +325,7 @@ ble_gap_fill_conn_desc(struct ble_hs_conn *conn,
     desc->conn_itvl = conn->bhc_itvl;
     desc->conn_latency = conn->bhc_latency;
     desc->supervision_timeout = conn->bhc_supervision_timeout;
+    desc->max_tx_octets = conn->bhc_max_tx_octets;
     desc->master_clock_accuracy = conn->bhc_master_clock_accuracy;
     desc->sec_state = conn->bhc_sec_state;
 
@@ -579,12 +583,149 @@ ble_gap_master_connect_cancelled(void)
     }
 }
 
+#if MYNEWT_VAL(BLE_GAP_DISC_DEDUP_ENTRIES) > 0
+
+#define BLE_GAP_DISC_DEDUP_PERIOD_TICKS \
+    (MYNEWT_VAL(BLE_GAP_DISC_DEDUP_PERIOD_MS) * OS_TICKS_PER_SEC / 1000)
+
+/** Reports seen from one advertiser with one payload. */
+struct ble_gap_disc_dedup_entry {
+    ble_addr_t addr;
+    uint32_t hash;          /* Of the event type and data. */
+    os_time_t last_tx;      /* When a report was last delivered. */
+    int32_t rssi_sum;       /* The rest covers reports held back since. */
+    uint16_t num_reports;
+    int8_t rssi_min;
+    int8_t rssi_max;
+    uint8_t in_use:1;
+};
+
+static struct ble_gap_disc_dedup_entry
+    ble_gap_disc_dedup[MYNEWT_VAL(BLE_GAP_DISC_DEDUP_ENTRIES)];
+
+static uint32_t
+ble_gap_disc_dedup_hash(const struct ble_gap_disc_desc *desc)
+{
+    uint32_t h;
+    int i;
+
+    /* FNV-1a */
+    h = (2166136261u ^ desc->event_type) * 16777619u;
+    for (i = 0; i < desc->length_data; i++) {
+        h ^= desc->data[i];
+        h *= 16777619u;
+    }
+
+    return h;
+}
+
+static void
+ble_gap_disc_dedup_clear(void)
+{
+    memset(ble_gap_disc_dedup, 0, sizeof ble_gap_disc_dedup);
+}
+
+/**
+ * Runs a report through the duplicate cache.
+ *
+ * @return                      1 if the report should be delivered, with
+ *                                  its summary fields filled in;
+ *                              0 if it was absorbed into a summary.
+ */
+static int
+ble_gap_disc_dedup_rx(struct ble_gap_disc_desc *desc)
+{
+    struct ble_gap_disc_dedup_entry *oldest;
+    struct ble_gap_disc_dedup_entry *entry;
+    os_time_t now;
+    uint32_t hash;
+    int i;
+
+    now = os_time_get();
+    hash = ble_gap_disc_dedup_hash(desc);
+
+    entry = NULL;
+    oldest = NULL;
+    for (i = 0; i < MYNEWT_VAL(BLE_GAP_DISC_DEDUP_ENTRIES); i++) {
+        if (!ble_gap_disc_dedup[i].in_use) {
+            if (oldest == NULL || oldest->in_use) {
+                oldest = ble_gap_disc_dedup + i;
+            }
+            continue;
+        }
+
+        if (ble_gap_disc_dedup[i].hash == hash &&
+            ble_addr_cmp(&ble_gap_disc_dedup[i].addr, &desc->addr) == 0) {
+
+            entry = ble_gap_disc_dedup + i;
+            break;
+        }
+
+        if (oldest == NULL ||
+            (oldest->in_use &&
+             OS_TIME_TICK_LT(ble_gap_disc_dedup[i].last_tx,
+                             oldest->last_tx))) {
+
+            oldest = ble_gap_disc_dedup + i;
+        }
+    }
+
+    if (entry == NULL) {
+        /* First sighting; deliver it now and start a period. */
+        entry = oldest;
+        memset(entry, 0, sizeof *entry);
+        entry->in_use = 1;
+        entry->addr = desc->addr;
+        entry->hash = hash;
+    }
+
+    if (entry->num_reports == 0 || desc->rssi < entry->rssi_min) {
+        entry->rssi_min = desc->rssi;
+    }
+    if (entry->num_reports == 0 || desc->rssi > entry->rssi_max) {
+        entry->rssi_max = desc->rssi;
+    }
+    entry->rssi_sum += desc->rssi;
+    entry->num_reports++;
+
+    if (entry->num_reports > 1 &&
+        OS_TIME_TICK_LT(now, entry->last_tx +
+                             BLE_GAP_DISC_DEDUP_PERIOD_TICKS)) {
+
+        return 0;
+    }
+
+    desc->num_reports = entry->num_reports;
+    desc->rssi_min = entry->rssi_min;
+    desc->rssi_max = entry->rssi_max;
+    desc->rssi_avg = entry->rssi_sum / entry->num_reports;
+
+    entry->last_tx = now;
+    entry->rssi_sum = 0;
+    entry->num_reports = 0;
+
+    return 1;
+}
+
+#endif
+
 static void
 ble_gap_disc_report(struct ble_gap_disc_desc *desc)
 {
     struct ble_gap_master_state state;
     struct ble_gap_event event;
 
+    desc->num_reports = 1;
+    desc->rssi_min = desc->rssi;
+    desc->rssi_max = desc->rssi;
+    desc->rssi_avg = desc->rssi;
+
+#if MYNEWT_VAL(BLE_GAP_DISC_DEDUP_ENTRIES) > 0
+    if (ble_gap_master.disc.dedup && !ble_gap_disc_dedup_rx(desc)) {
+        return;
+    }
+#endif
+
     ble_gap_master_extract_state(&state, 0);
 
     if (state.cb != NULL) {
@@ -624,6 +765,12 @@ ble_gap_update_notify(uint16_t conn_handle, int status)
 
     ble_gap_call_conn_event_cb(&event, conn_handle);
 
+#if MYNEWT_VAL(BLE_GAP_CONN_POLICY)
+    if (status != 0) {
+        ble_gap_policy_update_failed(conn_handle);
+    }
+#endif
+
     /* Terminate the connection on procedure timeout. */
     if (status == BLE_HS_ETIMEOUT) {
         ble_gap_terminate(conn_handle, BLE_ERR_REM_USER_CONN_TERM);
@@ -2215,6 +2362,10 @@ ble_gap_disc(uint8_t own_addr_type, int32_t duration_ms,
     }
 
     ble_gap_master.disc.limited = params.limited;
+#if MYNEWT_VAL(BLE_GAP_DISC_DEDUP_ENTRIES) > 0
+    ble_gap_master.disc.dedup = params.filter_duplicates;
+    ble_gap_disc_dedup_clear();
+#endif
     ble_gap_master.cb = cb;
     ble_gap_master.cb_arg = cb_arg;
 
@@ -2263,6 +2414,164 @@ ble_gap_disc_active(void)
     return ble_gap_master.op == BLE_GAP_OP_M_DISC;
 }
 
+static int
+ble_gap_disc_filter_tx(uint8_t *buf)
+{
+    uint8_t rsp;
+    uint8_t rsplen;
+    int rc;
+
+    rc = ble_hs_hci_cmd_tx(buf, &rsp, sizeof rsp, &rsplen);
+    if (rc != 0) {
+        return rc;
+    }
+
+    if (rsplen != sizeof rsp) {
+        return BLE_HS_ECONTROLLER;
+    }
+
+    return 0;
+}
+
+/**
+ * Removes all advertising report filters from the controller.  Requires a
+ * controller that supports the NimBLE vendor specific advertising report
+ * filter command.
+ *
+ * @return                      0 on success;
+ *                              A BLE host HCI return code if the controller
+ *                                  rejected the request.
+ */
+int
+ble_gap_disc_filter_clear(void)
+{
+#if !MYNEWT_VAL(BLE_ROLE_OBSERVER)
+    return BLE_HS_ENOTSUP;
+#endif
+
+    uint8_t buf[BLE_HCI_CMD_HDR_LEN + BLE_HCI_ADV_RPT_FILT_CLEAR_LEN];
+
+    ble_hs_hci_cmd_build_adv_rpt_filt_clear(buf, sizeof buf);
+    return ble_gap_disc_filter_tx(buf);
+}
+
+/**
+ * Adds a controller advertising report filter that matches devices
+ * advertising manufacturer specific data with the specified company
+ * identifier.  Filters only take effect once enabled with
+ * ble_gap_disc_filter_enable().
+ *
+ * @param company_id            The company identifier to match.
+ *
+ * @return                      0 on success;
+ *                              A BLE host HCI return code if the controller
+ *                                  rejected the request (e.g., the filter
+ *                                  table is full).
+ */
+int
+ble_gap_disc_filter_add_mfg_id(uint16_t company_id)
+{
+#if !MYNEWT_VAL(BLE_ROLE_OBSERVER)
+    return BLE_HS_ENOTSUP;
+#endif
+
+    uint8_t buf[BLE_HCI_CMD_HDR_LEN + BLE_HCI_ADV_RPT_FILT_ADD_MAX_LEN];
+    uint8_t val[2];
+    int rc;
+
+    put_le16(val, company_id);
+    rc = ble_hs_hci_cmd_build_adv_rpt_filt_add(
+        BLE_HCI_ADV_RPT_FILT_TYPE_MFG_ID, val, sizeof val, buf, sizeof buf);
+    if (rc != 0) {
+        return rc;
+    }
+
+    return ble_gap_disc_filter_tx(buf);
+}
+
+/**
+ * Adds a controller advertising report filter that matches devices
+ * advertising the specified service UUID, either in a service UUID list or
+ * in a service data field.  Filters only take effect once enabled with
+ * ble_gap_disc_filter_enable().
+ *
+ * @param uuid                  The service UUID to match.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_EINVAL if the UUID is invalid;
+ *                              A BLE host HCI return code if the controller
+ *                                  rejected the request (e.g., the filter
+ *                                  table is full).
+ */
+int
+ble_gap_disc_filter_add_uuid(const ble_uuid_t *uuid)
+{
+#if !MYNEWT_VAL(BLE_ROLE_OBSERVER)
+    return BLE_HS_ENOTSUP;
+#endif
+
+    uint8_t buf[BLE_HCI_CMD_HDR_LEN + BLE_HCI_ADV_RPT_FILT_ADD_MAX_LEN];
+    uint8_t val[16];
+    uint8_t val_len;
+    uint8_t type;
+    int rc;
+
+    switch (uuid->type) {
+    case BLE_UUID_TYPE_16:
+        type = BLE_HCI_ADV_RPT_FILT_TYPE_UUID16;
+        put_le16(val, BLE_UUID16(uuid)->value);
+        val_len = 2;
+        break;
+
+    case BLE_UUID_TYPE_32:
+        type = BLE_HCI_ADV_RPT_FILT_TYPE_UUID32;
+        put_le32(val, BLE_UUID32(uuid)->value);
+        val_len = 4;
+        break;
+
+    case BLE_UUID_TYPE_128:
+        type = BLE_HCI_ADV_RPT_FILT_TYPE_UUID128;
+        memcpy(val, BLE_UUID128(uuid)->value, 16);
+        val_len = 16;
+        break;
+
+    default:
+        return BLE_HS_EINVAL;
+    }
+
+    rc = ble_hs_hci_cmd_build_adv_rpt_filt_add(type, val, val_len,
+                                               buf, sizeof buf);
+    if (rc != 0) {
+        return rc;
+    }
+
+    return ble_gap_disc_filter_tx(buf);
+}
+
+/**
+ * Enables or disables controller filtering of advertising reports.  While
+ * enabled, undirected advertising reports are only delivered to the host if
+ * the advertisement matches one of the installed filters.
+ *
+ * @param enable                1 to enable filtering; 0 to disable.
+ *
+ * @return                      0 on success;
+ *                              A BLE host HCI return code if the controller
+ *                                  rejected the request.
+ */
+int
+ble_gap_disc_filter_enable(int enable)
+{
+#if !MYNEWT_VAL(BLE_ROLE_OBSERVER)
+    return BLE_HS_ENOTSUP;
+#endif
+
+    uint8_t buf[BLE_HCI_CMD_HDR_LEN + BLE_HCI_ADV_RPT_FILT_ENABLE_LEN];
+
+    ble_hs_hci_cmd_build_adv_rpt_filt_enable(enable, buf, sizeof buf);
+    return ble_gap_disc_filter_tx(buf);
+}
+
 /*****************************************************************************
  * $connection establishment procedures                                      *
  *****************************************************************************/
@@ -2779,6 +3088,55 @@ ble_gap_rx_param_req(struct hci_le_conn_param_req *evt)
     }
 }
 
+void
+ble_gap_rx_data_len_chg(struct hci_le_data_len_chg *evt)
+{
+#if !NIMBLE_BLE_CONNECT
+    return;
+#endif
+
+    struct ble_gap_event event;
+    struct ble_hs_conn *conn;
+
+    ble_hs_lock();
+
+    conn = ble_hs_conn_find(evt->connection_handle);
+    if (conn != NULL) {
+        conn->bhc_max_tx_octets = evt->max_tx_octets;
+    }
+
+    ble_hs_unlock();
+
+    if (conn == NULL) {
+        return;
+    }
+
+    memset(&event, 0, sizeof event);
+    event.type = BLE_GAP_EVENT_DATA_LEN;
+    event.data_len.conn_handle = evt->connection_handle;
+    event.data_len.max_tx_octets = evt->max_tx_octets;
+    event.data_len.max_rx_octets = evt->max_rx_octets;
+    ble_gap_call_conn_event_cb(&event, evt->connection_handle);
+}
+
+void
+ble_gap_rx_phy_update_complete(struct hci_le_phy_upd_complete *evt)
+{
+#if !NIMBLE_BLE_CONNECT
+    return;
+#endif
+
+    struct ble_gap_event event;
+
+    memset(&event, 0, sizeof event);
+    event.type = BLE_GAP_EVENT_PHY_UPDATE_COMPLETE;
+    event.phy_updated.status = BLE_HS_HCI_ERR(evt->status);
+    event.phy_updated.conn_handle = evt->connection_handle;
+    event.phy_updated.tx_phy = evt->tx_phy;
+    event.phy_updated.rx_phy = evt->rx_phy;
+    ble_gap_call_conn_event_cb(&event, evt->connection_handle);
+}
+
 static int
 ble_gap_update_tx(uint16_t conn_handle,
                   const struct ble_gap_upd_params *params)
@@ -3152,6 +3510,144 @@ ble_gap_conn_rssi(uint16_t conn_handle, int8_t *out_rssi)
     return rc;
 }
 
+/**
+ * Retrieves the outgoing ACL data state of a connection.  Fragments are only
+ * queued in the host when BLE_HS_ACL_TX_SCHED is enabled; otherwise the
+ * queue figures are always 0.
+ *
+ * @param conn_handle           Specifies the connection to query.
+ * @param out_stats             On success, the connection's state is written
+ *                                  here.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_ENOTCONN if there is no such
+ *                                  connection.
+ */
+int
+ble_gap_conn_tx_stats(uint16_t conn_handle,
+                      struct ble_gap_conn_tx_stats *out_stats)
+{
+    struct ble_hs_conn *conn;
+
+    ble_hs_lock();
+
+    conn = ble_hs_conn_find(conn_handle);
+    if (conn != NULL) {
+        memset(out_stats, 0, sizeof *out_stats);
+        out_stats->outstanding = conn->bhc_outstanding_pkts;
+#if MYNEWT_VAL(BLE_HS_ACL_TX_SCHED)
+        out_stats->queued = conn->bhc_tx_q_len;
+        out_stats->queued_max = conn->bhc_tx_q_max;
+#endif
+    }
+
+    ble_hs_unlock();
+
+    if (conn == NULL) {
+        return BLE_HS_ENOTCONN;
+    }
+
+    return 0;
+}
+
+/**
+ * Asks the controller to use the specified LL data length on a connection.
+ * The new length takes effect once the controller reports a data length
+ * change; the application is notified via a BLE_GAP_EVENT_DATA_LEN event and
+ * the host fragments outgoing ACL data accordingly.
+ *
+ * @param conn_handle           The connection to update.
+ * @param tx_octets             The preferred maximum LL payload to transmit;
+ *                                  27 to 251.
+ * @param tx_time               The preferred maximum transmit time, in
+ *                                  microseconds; 328 to 2120.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_ENOTCONN if there is no such
+ *                                  connection;
+ *                              BLE_HS_EINVAL if a parameter is out of range;
+ *                              A BLE host HCI return code if the controller
+ *                                  rejected the request.
+ */
+int
+ble_gap_set_data_len(uint16_t conn_handle, uint16_t tx_octets,
+                     uint16_t tx_time)
+{
+#if !NIMBLE_BLE_CONNECT
+    return BLE_HS_ENOTSUP;
+#endif
+
+    struct ble_hs_conn *conn;
+    int rc;
+
+    ble_hs_lock();
+    conn = ble_hs_conn_find(conn_handle);
+    ble_hs_unlock();
+
+    if (conn == NULL) {
+        return BLE_HS_ENOTCONN;
+    }
+
+    if (tx_octets < BLE_HCI_SET_DATALEN_TX_OCTETS_MIN ||
+        tx_octets > BLE_HCI_SET_DATALEN_TX_OCTETS_MAX ||
+        tx_time < BLE_HCI_SET_DATALEN_TX_TIME_MIN ||
+        tx_time > BLE_HCI_SET_DATALEN_TX_TIME_MAX) {
+
+        return BLE_HS_EINVAL;
+    }
+
+    rc = ble_hs_hci_util_set_data_len(conn_handle, tx_octets, tx_time);
+    return rc;
+}
+
+/**
+ * Asks the controller to move a connection to the specified PHYs.  The
+ * outcome is reported via a BLE_GAP_EVENT_PHY_UPDATE_COMPLETE event.
+ *
+ * @param conn_handle           The connection to update.
+ * @param tx_phys_mask          Preferred transmit PHYs; a combination of the
+ *                                  BLE_GAP_LE_PHY_[...]_MASK flags, or 0 for
+ *                                  no preference.
+ * @param rx_phys_mask          Preferred receive PHYs; same encoding as
+ *                                  tx_phys_mask.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_ENOTCONN if there is no such
+ *                                  connection;
+ *                              BLE_HS_EINVAL if a mask is invalid;
+ *                              A BLE host HCI return code if the controller
+ *                                  rejected the request.
+ */
+int
+ble_gap_set_phy(uint16_t conn_handle, uint8_t tx_phys_mask,
+                uint8_t rx_phys_mask)
+{
+#if !NIMBLE_BLE_CONNECT
+    return BLE_HS_ENOTSUP;
+#endif
+
+    uint8_t buf[BLE_HCI_CMD_HDR_LEN + BLE_HCI_LE_SET_PHY_LEN];
+    struct ble_hs_conn *conn;
+    int rc;
+
+    ble_hs_lock();
+    conn = ble_hs_conn_find(conn_handle);
+    ble_hs_unlock();
+
+    if (conn == NULL) {
+        return BLE_HS_ENOTCONN;
+    }
+
+    rc = ble_hs_hci_cmd_build_le_set_phy(conn_handle, tx_phys_mask,
+                                         rx_phys_mask, buf, sizeof buf);
+    if (rc != 0) {
+        return rc;
+    }
+
+    rc = ble_hs_hci_cmd_tx_empty_ack(buf);
+    return rc;
+}
+
 /*****************************************************************************
  * $notify                                                                   *
  *****************************************************************************/
@@ -3196,6 +3692,23 @@ ble_gap_notify_tx_event(int status, uint16_t conn_handle, uint16_t attr_handle,
     ble_gap_call_conn_event_cb(&event, conn_handle);
 }
 
+void
+ble_gap_notify_queue_event(uint16_t conn_handle, uint8_t count, int full)
+{
+#if !MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE)
+    return;
+#endif
+
+    struct ble_gap_event event;
+
+    memset(&event, 0, sizeof event);
+    event.type = BLE_GAP_EVENT_NOTIFY_QUEUE;
+    event.notify_queue.conn_handle = conn_handle;
+    event.notify_queue.count = count;
+    event.notify_queue.full = full;
+    ble_gap_call_conn_event_cb(&event, conn_handle);
+}
+
 /*****************************************************************************
  * $subscribe                                                                *
  *****************************************************************************/
@@ -0,0 +1,291 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * GAP connection parameter policy.
+ *
+ * A connection with a policy attached alternates between two parameter sets:
+ * "bulk" while the link is busy and "idle" once it goes quiet.  The host
+ * counts the L2CAP bytes sent and received on the connection during each
+ * sample period (BLE_GAP_CONN_POLICY_SAMPLE_MS):
+ *     o As soon as a period's count reaches the policy's bulk threshold, the
+ *       bulk parameters are requested.
+ *     o Once no period has reached the threshold for the policy's idle
+ *       timeout, the idle parameters are requested.
+ *
+ * A request that cannot be started (e.g., another update is in progress) or
+ * that fails is retried at the next sample.
+ */
+
+#include <string.h>
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(BLE_GAP_CONN_POLICY)
+
+#include "ble_hs_priv.h"
+
+#define BLE_GAP_POLICY_MODE_NONE        0
+#define BLE_GAP_POLICY_MODE_BULK        1
+#define BLE_GAP_POLICY_MODE_IDLE        2
+
+#define BLE_GAP_POLICY_SAMPLE_TICKS                                 \
+    (MYNEWT_VAL(BLE_GAP_CONN_POLICY_SAMPLE_MS) * OS_TICKS_PER_SEC / 1000)
+
+struct ble_gap_policy_req {
+    uint16_t conn_handle;
+    uint8_t mode;
+    uint8_t prev_mode;
+};
+
+static os_time_t ble_gap_policy_next_sample;
+
+static const struct ble_gap_upd_params *
+ble_gap_policy_params(const struct ble_gap_conn_policy *policy, uint8_t mode)
+{
+    if (mode == BLE_GAP_POLICY_MODE_BULK) {
+        return &policy->bulk;
+    } else {
+        return &policy->idle;
+    }
+}
+
+/**
+ * Records L2CAP traffic on a connection.  If this is the first traffic in
+ * the current sample period to reach the bulk threshold, the policy timer is
+ * expedited so that the bulk parameters get requested right away.
+ *
+ * Lock restrictions: Caller must lock ble_hs_mutex.
+ */
+void
+ble_gap_policy_traffic(struct ble_hs_conn *conn, uint16_t len)
+{
+    struct ble_gap_policy_conn *pc;
+
+    BLE_HS_DBG_ASSERT(ble_hs_locked_by_cur_task());
+
+    pc = &conn->bhc_policy;
+    if (pc->policy == NULL) {
+        return;
+    }
+
+    if (pc->bytes < pc->policy->bulk_thresh &&
+        pc->bytes + len >= pc->policy->bulk_thresh &&
+        pc->mode != BLE_GAP_POLICY_MODE_BULK) {
+
+        pc->bulk_pending = 1;
+        ble_hs_timer_resched();
+    }
+
+    pc->bytes += len;
+}
+
+/**
+ * Called when a connection update procedure fails.  Forget the current mode
+ * so that the appropriate one is requested again at the next sample.
+ *
+ * Lock restrictions: Caller must unlock ble_hs_mutex.
+ */
+void
+ble_gap_policy_update_failed(uint16_t conn_handle)
+{
+    struct ble_hs_conn *conn;
+
+    ble_hs_lock();
+
+    conn = ble_hs_conn_find(conn_handle);
+    if (conn != NULL) {
+        conn->bhc_policy.mode = BLE_GAP_POLICY_MODE_NONE;
+    }
+
+    ble_hs_unlock();
+}
+
+/**
+ * Evaluates the policy of each connection and requests parameter updates
+ * where the mode has changed.
+ *
+ * Lock restrictions: Caller must unlock ble_hs_mutex.
+ *
+ * @return                      The number of ticks until this function
+ *                                  should be called again.
+ */
+int32_t
+ble_gap_policy_timer(void)
+{
+    struct ble_gap_policy_req reqs[MYNEWT_VAL(BLE_MAX_CONNECTIONS)];
+    const struct ble_gap_conn_policy *policy;
+    struct ble_gap_policy_conn *pc;
+    struct ble_hs_conn *conn;
+    uint32_t idle_ticks;
+    os_time_t now;
+    int32_t ticks_until_next;
+    int num_reqs;
+    int any_policy;
+    int sample;
+    int rc;
+    int i;
+
+    now = os_time_get();
+    sample = OS_TIME_TICK_GEQ(now, ble_gap_policy_next_sample);
+    num_reqs = 0;
+    any_policy = 0;
+
+    ble_hs_lock();
+
+    for (i = 0; ; i++) {
+        conn = ble_hs_conn_find_by_idx(i);
+        if (conn == NULL) {
+            break;
+        }
+
+        pc = &conn->bhc_policy;
+        policy = pc->policy;
+        if (policy == NULL) {
+            continue;
+        }
+        any_policy = 1;
+
+        if (!sample && !pc->bulk_pending) {
+            continue;
+        }
+
+        BLE_HS_DBG_ASSERT(num_reqs < MYNEWT_VAL(BLE_MAX_CONNECTIONS));
+        reqs[num_reqs].conn_handle = conn->bhc_handle;
+        reqs[num_reqs].prev_mode = pc->mode;
+
+        if (pc->bytes >= policy->bulk_thresh) {
+            pc->last_busy = now;
+            if (pc->mode != BLE_GAP_POLICY_MODE_BULK) {
+                pc->mode = BLE_GAP_POLICY_MODE_BULK;
+                reqs[num_reqs].mode = pc->mode;
+                num_reqs++;
+            }
+        } else if (sample && pc->mode != BLE_GAP_POLICY_MODE_IDLE) {
+            rc = os_time_ms_to_ticks(policy->idle_timeout_ms, &idle_ticks);
+            if (rc != 0 || (uint32_t)(now - pc->last_busy) >= idle_ticks) {
+                pc->mode = BLE_GAP_POLICY_MODE_IDLE;
+                reqs[num_reqs].mode = pc->mode;
+                num_reqs++;
+            }
+        }
+
+        pc->bulk_pending = 0;
+        if (sample) {
+            pc->bytes = 0;
+        }
+    }
+
+    ble_hs_unlock();
+
+    if (sample) {
+        ble_gap_policy_next_sample = now + BLE_GAP_POLICY_SAMPLE_TICKS;
+    }
+
+    /* Start the parameter updates without the host lock held. */
+    for (i = 0; i < num_reqs; i++) {
+        ble_hs_lock();
+        conn = ble_hs_conn_find(reqs[i].conn_handle);
+        policy = conn != NULL ? conn->bhc_policy.policy : NULL;
+        ble_hs_unlock();
+
+        if (policy == NULL) {
+            continue;
+        }
+
+        rc = ble_gap_update_params(reqs[i].conn_handle,
+                                   ble_gap_policy_params(policy,
+                                                         reqs[i].mode));
+        if (rc != 0) {
+            /* Revert the mode so the request gets retried. */
+            ble_hs_lock();
+            conn = ble_hs_conn_find(reqs[i].conn_handle);
+            if (conn != NULL) {
+                conn->bhc_policy.mode = reqs[i].prev_mode;
+            }
+            ble_hs_unlock();
+        }
+    }
+
+    if (!any_policy) {
+        return BLE_HS_FOREVER;
+    }
+
+    ticks_until_next = ble_gap_policy_next_sample - os_time_get();
+    if (ticks_until_next < 0) {
+        ticks_until_next = 0;
+    }
+    return ticks_until_next;
+}
+
+/**
+ * Attaches a connection parameter policy to a connection, or detaches the
+ * current one.  While attached, the host requests the policy's bulk
+ * parameters when the connection is busy and its idle parameters when it
+ * has been quiet for the policy's idle timeout.  The policy is detached
+ * automatically when the connection terminates.
+ *
+ * @param conn_handle           The connection to apply the policy to.
+ * @param policy                The policy to apply, or NULL to stop
+ *                                  managing the connection's parameters.
+ *                                  The policy is not copied; it must remain
+ *                                  valid until it is detached.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_ENOTCONN if there is no such
+ *                                  connection;
+ *                              BLE_HS_EINVAL if the policy is invalid.
+ */
+int
+ble_gap_conn_policy_set(uint16_t conn_handle,
+                        const struct ble_gap_conn_policy *policy)
+{
+    struct ble_gap_policy_conn *pc;
+    struct ble_hs_conn *conn;
+
+    if (policy != NULL && policy->bulk_thresh == 0) {
+        return BLE_HS_EINVAL;
+    }
+
+    ble_hs_lock();
+
+    conn = ble_hs_conn_find(conn_handle);
+    if (conn == NULL) {
+        ble_hs_unlock();
+        return BLE_HS_ENOTCONN;
+    }
+
+    pc = &conn->bhc_policy;
+    memset(pc, 0, sizeof *pc);
+    pc->policy = policy;
+    pc->mode = BLE_GAP_POLICY_MODE_NONE;
+    pc->last_busy = os_time_get();
+
+    ble_hs_unlock();
+
+    if (policy != NULL) {
+        /* Start sampling now. */
+        ble_gap_policy_next_sample = os_time_get() + BLE_GAP_POLICY_SAMPLE_TICKS;
+        ble_hs_timer_resched();
+    }
+
+    return 0;
+}
+
+#endif
@@ -21,6 +21,8 @@
 #define H_BLE_GAP_CONN_
 
 #include <inttypes.h>
+#include "syscfg/syscfg.h"
+#include "os/os_time.h"
 #include "stats/stats.h"
 #include "host/ble_gap.h"
 #ifdef __cplusplus
@@ -29,11 +31,23 @@ extern "C" {
 
 struct hci_le_conn_upd_complete;
 struct hci_le_conn_param_req;
+struct hci_le_data_len_chg;
+struct hci_le_phy_upd_complete;
 struct hci_le_conn_complete;
 struct hci_disconn_complete;
 struct hci_encrypt_change;
 struct ble_hs_hci_ack;
 struct ble_hs_adv;
+struct ble_hs_conn;
+
+/** Per-connection state of the connection parameter policy. */
+struct ble_gap_policy_conn {
+    const struct ble_gap_conn_policy *policy;
+    uint32_t bytes;         /* L2CAP bytes in the current sample period. */
+    os_time_t last_busy;
+    uint8_t mode;
+    uint8_t bulk_pending:1;
+};
 
 STATS_SECT_START(ble_gap_stats)
     STATS_SECT_ENTRY(wl_set)
@@ -79,6 +93,8 @@ int ble_gap_rx_conn_complete(struct hci_le_conn_complete *evt);
 void ble_gap_rx_disconn_complete(struct hci_disconn_complete *evt);
 void ble_gap_rx_update_complete(struct hci_le_conn_upd_complete *evt);
 void ble_gap_rx_param_req(struct hci_le_conn_param_req *evt);
+void ble_gap_rx_data_len_chg(struct hci_le_data_len_chg *evt);
+void ble_gap_rx_phy_update_complete(struct hci_le_phy_upd_complete *evt);
 int ble_gap_rx_l2cap_update_req(uint16_t conn_handle,
                                 struct ble_gap_upd_params *params);
 void ble_gap_enc_event(uint16_t conn_handle, int status,
@@ -95,11 +111,19 @@ void ble_gap_subscribe_event(uint16_t conn_handle, uint16_t attr_handle,
                              uint8_t prev_indicate, uint8_t cur_indicate);
 void ble_gap_mtu_event(uint16_t conn_handle, uint16_t cid, uint16_t mtu);
 void ble_gap_identity_event(uint16_t conn_handle);
+void ble_gap_notify_queue_event(uint16_t conn_handle, uint8_t count,
+                                int full);
 int ble_gap_master_in_progress(void);
 
 void ble_gap_conn_broken(uint16_t conn_handle, int reason);
 int32_t ble_gap_timer(void);
 
+#if MYNEWT_VAL(BLE_GAP_CONN_POLICY)
+void ble_gap_policy_traffic(struct ble_hs_conn *conn, uint16_t len);
+void ble_gap_policy_update_failed(uint16_t conn_handle);
+int32_t ble_gap_policy_timer(void);
+#endif
+
 int ble_gap_init(void);
 
 #ifdef __cplusplus
@@ -56,6 +56,8 @@ STATS_SECT_START(ble_gattc_stats)
     STATS_SECT_ENTRY(read_long_fail)
     STATS_SECT_ENTRY(read_mult)
     STATS_SECT_ENTRY(read_mult_fail)
+    STATS_SECT_ENTRY(read_mult_var)
+    STATS_SECT_ENTRY(read_mult_var_fail)
     STATS_SECT_ENTRY(write_no_rsp)
     STATS_SECT_ENTRY(write_no_rsp_fail)
     STATS_SECT_ENTRY(write)
@@ -66,6 +68,10 @@ STATS_SECT_START(ble_gattc_stats)
     STATS_SECT_ENTRY(write_reliable_fail)
     STATS_SECT_ENTRY(notify)
     STATS_SECT_ENTRY(notify_fail)
+    STATS_SECT_ENTRY(notify_coalesce)
+    STATS_SECT_ENTRY(notify_queue_full)
+    STATS_SECT_ENTRY(notify_multi)
+    STATS_SECT_ENTRY(notify_multi_fail)
     STATS_SECT_ENTRY(indicate)
     STATS_SECT_ENTRY(indicate_fail)
     STATS_SECT_ENTRY(proc_timeout)
@@ -100,6 +106,22 @@ struct ble_gatts_conn {
 
 /*** @client. */
 
+#if MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE)
+struct ble_gattc_notify_entry;
+STAILQ_HEAD(ble_gattc_notify_list, ble_gattc_notify_entry);
+
+/** Per-connection queue of pending notifications. */
+struct ble_gattc_notify_q {
+    struct ble_gattc_notify_list gnq_entries;
+    uint8_t gnq_count;
+
+    /* Set when a notification was rejected; cleared when the application has
+     * been told the queue has room again.
+     */
+    uint8_t gnq_full:1;
+};
+#endif
+
 /** Convert the resume rate from milliseconds to OS ticks. */
 #define BLE_GATT_RESUME_RATE_TICKS                \
     (MYNEWT_VAL(BLE_GATT_RESUME_RATE) * OS_TICKS_PER_SEC / 1000)
@@ -118,6 +140,8 @@ void ble_gattc_rx_read_blob_rsp(uint16_t conn_handle, int status,
                                 struct os_mbuf **rxom);
 void ble_gattc_rx_read_mult_rsp(uint16_t conn_handle, int status,
                                 struct os_mbuf **rxom);
+void ble_gattc_rx_read_mult_var_rsp(uint16_t conn_handle, int status,
+                                    struct os_mbuf **rxom);
 void ble_gattc_rx_read_group_type_adata(
     uint16_t conn_handle, struct ble_att_read_group_type_adata *adata);
 void ble_gattc_rx_read_group_type_complete(uint16_t conn_handle, int rc);
@@ -135,8 +159,40 @@ void ble_gattc_rx_find_info_idata(uint16_t conn_handle,
 void ble_gattc_rx_find_info_complete(uint16_t conn_handle, int status);
 void ble_gattc_connection_txable(uint16_t conn_handle);
 void ble_gattc_connection_broken(uint16_t conn_handle);
+#if MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE)
+void ble_gattc_notify_q_sched(void);
+void ble_gattc_notify_q_clear(struct ble_gattc_notify_q *q);
+#endif
 int32_t ble_gattc_timer(void);
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+int ble_gattc_cache_peer(uint16_t conn_handle, ble_addr_t *out_peer_addr);
+int ble_gattc_cache_add_svc(const ble_addr_t *peer_addr,
+                            const struct ble_gatt_svc *svc);
+int ble_gattc_cache_add_chr(const ble_addr_t *peer_addr,
+                            const struct ble_gatt_chr *chr);
+int ble_gattc_cache_add_dsc(const ble_addr_t *peer_addr,
+                            const struct ble_gatt_dsc *dsc);
+int ble_gattc_cache_svcs_done(const ble_addr_t *peer_addr);
+int ble_gattc_cache_chrs_done(const ble_addr_t *peer_addr,
+                              uint16_t start_handle, uint16_t end_handle);
+int ble_gattc_cache_dscs_done(const ble_addr_t *peer_addr,
+                              uint16_t chr_val_handle, uint16_t end_handle);
+int ble_gattc_cache_has_svcs(const ble_addr_t *peer_addr);
+int ble_gattc_cache_has_chrs(const ble_addr_t *peer_addr,
+                             uint16_t start_handle, uint16_t end_handle);
+int ble_gattc_cache_has_dscs(const ble_addr_t *peer_addr,
+                             uint16_t chr_val_handle, uint16_t end_handle);
+int ble_gattc_cache_next_svc(const ble_addr_t *peer_addr, uint16_t prev_handle,
+                             struct ble_gatt_svc *out_svc);
+int ble_gattc_cache_next_chr(const ble_addr_t *peer_addr, uint16_t prev_handle,
+                             uint16_t end_handle, struct ble_gatt_chr *out_chr);
+int ble_gattc_cache_next_dsc(const ble_addr_t *peer_addr, uint16_t prev_handle,
+                             uint16_t end_handle, struct ble_gatt_dsc *out_dsc);
+int ble_gattc_cache_clear(const ble_addr_t *peer_addr);
+void ble_gattc_cache_rx_indicate(uint16_t conn_handle, uint16_t attr_handle);
+#endif
+
 int ble_gattc_any_jobs(void);
 int ble_gattc_init(void);
 
@@ -86,11 +86,18 @@
 #define BLE_GATT_OP_WRITE_LONG                  12
 #define BLE_GATT_OP_WRITE_RELIABLE              13
 #define BLE_GATT_OP_INDICATE                    14
-#define BLE_GATT_OP_CNT                         15
+#define BLE_GATT_OP_READ_MULT_VAR               15
+#define BLE_GATT_OP_CNT                         16
 
 /** Procedure stalled due to resource exhaustion. */
 #define BLE_GATTC_PROC_F_STALLED                0x01
 
+/** Procedure results are being written to the discovery cache. */
+#define BLE_GATTC_PROC_F_CACHE                  0x02
+
+/** Procedure is waiting for an earlier procedure on its connection. */
+#define BLE_GATTC_PROC_F_QUEUED                 0x04
+
 /** Represents an in-progress GATT procedure. */
 struct ble_gattc_proc {
     STAILQ_ENTRY(ble_gattc_proc) next;
@@ -100,6 +107,14 @@ struct ble_gattc_proc {
     uint8_t op;
     uint8_t flags;
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    /* Identity of the peer whose database is being cached or replayed. */
+    ble_addr_t cache_peer;
+
+    /* Start of the range searched by a discover-all-characteristics proc. */
+    uint16_t cache_start_handle;
+#endif
+
     union {
         struct {
             ble_gatt_mtu_fn *cb;
@@ -177,12 +192,23 @@ struct ble_gattc_proc {
         struct {
             uint16_t handles[MYNEWT_VAL(BLE_GATT_READ_MAX_ATTRS)];
             uint8_t num_handles;
+
+            /* Index of the first handle in the outstanding request. */
+            uint8_t cur_handle;
+
+            /* Split the handle list across as many requests as needed. */
+            uint8_t split;
+
             ble_gatt_attr_fn *cb;
             void *cb_arg;
         } read_mult;
 
         struct {
             uint16_t att_handle;
+
+            /* Value to write; only held while the proc is queued. */
+            struct os_mbuf *om;
+
             ble_gatt_attr_fn *cb;
             void *cb_arg;
         } write;
@@ -232,6 +258,7 @@ static ble_gattc_err_fn ble_gattc_write_err;
 static ble_gattc_err_fn ble_gattc_write_long_err;
 static ble_gattc_err_fn ble_gattc_write_reliable_err;
 static ble_gattc_err_fn ble_gattc_indicate_err;
+static ble_gattc_err_fn ble_gattc_read_mult_var_err;
 
 static ble_gattc_err_fn * const ble_gattc_err_dispatch[BLE_GATT_OP_CNT] = {
     [BLE_GATT_OP_MTU]               = ble_gattc_mtu_err,
@@ -249,41 +276,50 @@ static ble_gattc_err_fn * const ble_gattc_err_dispatch[BLE_GATT_OP_CNT] = {
     [BLE_GATT_OP_WRITE_LONG]        = ble_gattc_write_long_err,
     [BLE_GATT_OP_WRITE_RELIABLE]    = ble_gattc_write_reliable_err,
     [BLE_GATT_OP_INDICATE]          = ble_gattc_indicate_err,
+    [BLE_GATT_OP_READ_MULT_VAR]     = ble_gattc_read_mult_var_err,
 };
 
 /**
  * Resume functions - these handle periodic retries of procedures that have
- * stalled due to memory exhaustion.
+ * stalled due to memory exhaustion, and start procedures that were queued
+ * behind another procedure on the same connection.
  */
 typedef int ble_gattc_resume_fn(struct ble_gattc_proc *proc);
 
+static ble_gattc_resume_fn ble_gattc_mtu_resume;
 static ble_gattc_resume_fn ble_gattc_disc_all_svcs_resume;
 static ble_gattc_resume_fn ble_gattc_disc_svc_uuid_resume;
 static ble_gattc_resume_fn ble_gattc_find_inc_svcs_resume;
 static ble_gattc_resume_fn ble_gattc_disc_all_chrs_resume;
 static ble_gattc_resume_fn ble_gattc_disc_chr_uuid_resume;
 static ble_gattc_resume_fn ble_gattc_disc_all_dscs_resume;
+static ble_gattc_resume_fn ble_gattc_read_resume;
+static ble_gattc_resume_fn ble_gattc_read_uuid_resume;
 static ble_gattc_resume_fn ble_gattc_read_long_resume;
+static ble_gattc_resume_fn ble_gattc_read_mult_resume;
+static ble_gattc_resume_fn ble_gattc_write_resume;
 static ble_gattc_resume_fn ble_gattc_write_long_resume;
 static ble_gattc_resume_fn ble_gattc_write_reliable_resume;
+static ble_gattc_resume_fn ble_gattc_read_mult_var_resume;
 
 static ble_gattc_resume_fn * const
 ble_gattc_resume_dispatch[BLE_GATT_OP_CNT] = {
-    [BLE_GATT_OP_MTU]               = NULL,
+    [BLE_GATT_OP_MTU]               = ble_gattc_mtu_resume,
     [BLE_GATT_OP_DISC_ALL_SVCS]     = ble_gattc_disc_all_svcs_resume,
     [BLE_GATT_OP_DISC_SVC_UUID]     = ble_gattc_disc_svc_uuid_resume,
     [BLE_GATT_OP_FIND_INC_SVCS]     = ble_gattc_find_inc_svcs_resume,
     [BLE_GATT_OP_DISC_ALL_CHRS]     = ble_gattc_disc_all_chrs_resume,
     [BLE_GATT_OP_DISC_CHR_UUID]     = ble_gattc_disc_chr_uuid_resume,
     [BLE_GATT_OP_DISC_ALL_DSCS]     = ble_gattc_disc_all_dscs_resume,
-    [BLE_GATT_OP_READ]              = NULL,
-    [BLE_GATT_OP_READ_UUID]         = NULL,
+    [BLE_GATT_OP_READ]              = ble_gattc_read_resume,
+    [BLE_GATT_OP_READ_UUID]         = ble_gattc_read_uuid_resume,
     [BLE_GATT_OP_READ_LONG]         = ble_gattc_read_long_resume,
-    [BLE_GATT_OP_READ_MULT]         = NULL,
-    [BLE_GATT_OP_WRITE]             = NULL,
+    [BLE_GATT_OP_READ_MULT]         = ble_gattc_read_mult_resume,
+    [BLE_GATT_OP_WRITE]             = ble_gattc_write_resume,
     [BLE_GATT_OP_WRITE_LONG]        = ble_gattc_write_long_resume,
     [BLE_GATT_OP_WRITE_RELIABLE]    = ble_gattc_write_reliable_resume,
     [BLE_GATT_OP_INDICATE]          = NULL,
+    [BLE_GATT_OP_READ_MULT_VAR]     = ble_gattc_read_mult_var_resume,
 };
 
 /**
@@ -307,6 +343,7 @@ static ble_gattc_tmo_fn ble_gattc_write_tmo;
 static ble_gattc_tmo_fn ble_gattc_write_long_tmo;
 static ble_gattc_tmo_fn ble_gattc_write_reliable_tmo;
 static ble_gattc_tmo_fn ble_gattc_indicate_tmo;
+static ble_gattc_tmo_fn ble_gattc_read_mult_var_tmo;
 
 static ble_gattc_tmo_fn * const
 ble_gattc_tmo_dispatch[BLE_GATT_OP_CNT] = {
@@ -325,6 +362,7 @@ ble_gattc_tmo_dispatch[BLE_GATT_OP_CNT] = {
     [BLE_GATT_OP_WRITE_LONG]        = ble_gattc_write_long_tmo,
     [BLE_GATT_OP_WRITE_RELIABLE]    = ble_gattc_write_reliable_tmo,
     [BLE_GATT_OP_INDICATE]          = ble_gattc_indicate_tmo,
+    [BLE_GATT_OP_READ_MULT_VAR]     = ble_gattc_read_mult_var_tmo,
 };
 
 /**
@@ -353,6 +391,7 @@ static ble_gattc_rx_adata_fn ble_gattc_disc_chr_uuid_rx_adata;
 static ble_gattc_rx_complete_fn ble_gattc_disc_chr_uuid_rx_complete;
 static ble_gattc_rx_attr_fn ble_gattc_read_rx_read_rsp;
 static ble_gattc_rx_attr_fn ble_gattc_read_long_rx_read_rsp;
+static ble_gattc_rx_attr_fn ble_gattc_read_mult_var_rx_read_rsp;
 static ble_gattc_rx_adata_fn ble_gattc_read_uuid_rx_adata;
 static ble_gattc_rx_complete_fn ble_gattc_read_uuid_rx_complete;
 static ble_gattc_rx_prep_fn ble_gattc_write_long_rx_prep;
@@ -387,6 +426,7 @@ static const struct ble_gattc_rx_attr_entry {
     { BLE_GATT_OP_READ,             ble_gattc_read_rx_read_rsp },
     { BLE_GATT_OP_READ_LONG,        ble_gattc_read_long_rx_read_rsp },
     { BLE_GATT_OP_FIND_INC_SVCS,    ble_gattc_find_inc_svcs_rx_read_rsp },
+    { BLE_GATT_OP_READ_MULT_VAR,    ble_gattc_read_mult_var_rx_read_rsp },
 };
 
 static const struct ble_gattc_rx_prep_entry {
@@ -412,6 +452,27 @@ static os_membuf_t ble_gattc_proc_mem[
 
 static struct os_mempool ble_gattc_proc_pool;
 
+#if MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE)
+struct ble_gattc_notify_entry {
+    STAILQ_ENTRY(ble_gattc_notify_entry) next;
+
+    /* NULL: read the attribute value when the notification is sent. */
+    struct os_mbuf *om;
+    uint16_t chr_val_handle;
+};
+
+static os_membuf_t ble_gattc_notify_entry_mem[
+    OS_MEMPOOL_SIZE(MYNEWT_VAL(BLE_MAX_CONNECTIONS) *
+                        MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE_LEN),
+                    sizeof (struct ble_gattc_notify_entry))
+];
+
+static struct os_mempool ble_gattc_notify_entry_pool;
+
+/* Drains the notification queues in the host parent task. */
+static struct os_event ble_gattc_notify_ev;
+#endif
+
 /* The list of active GATT client procedures. */
 static struct ble_gattc_proc_list ble_gattc_procs;
 
@@ -420,6 +481,13 @@ static struct ble_gattc_proc_list ble_gattc_procs;
  */
 static os_time_t ble_gattc_resume_at;
 
+#if MYNEWT_VAL(BLE_GATT_PROC_QUEUE)
+/* The proc whose response is currently being processed.  It is not in the
+ * proc list while its callback executes, but its connection is still busy.
+ */
+static struct ble_gattc_proc *ble_gattc_rx_proc;
+#endif
+
 /* Statistics. */
 STATS_SECT_DECL(ble_gattc_stats) ble_gattc_stats;
 STATS_NAME_START(ble_gattc_stats)
@@ -445,6 +513,8 @@ STATS_NAME_START(ble_gattc_stats)
     STATS_NAME(ble_gattc_stats, read_long_fail)
     STATS_NAME(ble_gattc_stats, read_mult)
     STATS_NAME(ble_gattc_stats, read_mult_fail)
+    STATS_NAME(ble_gattc_stats, read_mult_var)
+    STATS_NAME(ble_gattc_stats, read_mult_var_fail)
     STATS_NAME(ble_gattc_stats, write_no_rsp)
     STATS_NAME(ble_gattc_stats, write_no_rsp_fail)
     STATS_NAME(ble_gattc_stats, write)
@@ -455,6 +525,10 @@ STATS_NAME_START(ble_gattc_stats)
     STATS_NAME(ble_gattc_stats, write_reliable_fail)
     STATS_NAME(ble_gattc_stats, notify)
     STATS_NAME(ble_gattc_stats, notify_fail)
+    STATS_NAME(ble_gattc_stats, notify_coalesce)
+    STATS_NAME(ble_gattc_stats, notify_queue_full)
+    STATS_NAME(ble_gattc_stats, notify_multi)
+    STATS_NAME(ble_gattc_stats, notify_multi_fail)
     STATS_NAME(ble_gattc_stats, indicate)
     STATS_NAME(ble_gattc_stats, indicate_fail)
     STATS_NAME(ble_gattc_stats, proc_timeout)
@@ -572,11 +646,10 @@ ble_gattc_log_read_long(struct ble_gattc_proc *proc)
 }
 
 static void
-ble_gattc_log_read_mult(const uint16_t *handles, uint8_t num_handles)
+ble_gattc_log_handles(const uint16_t *handles, uint8_t num_handles)
 {
     int i;
 
-    ble_gattc_log_proc_init("read multiple; ");
     BLE_HS_LOG(INFO, "att_handles=");
     for (i = 0; i < num_handles; i++) {
         BLE_HS_LOG(INFO, "%s%d", i != 0 ? "," : "", handles[i]);
@@ -584,6 +657,27 @@ ble_gattc_log_read_mult(const uint16_t *handles, uint8_t num_handles)
     BLE_HS_LOG(INFO, "\n");
 }
 
+static void
+ble_gattc_log_read_mult(const uint16_t *handles, uint8_t num_handles)
+{
+    ble_gattc_log_proc_init("read multiple; ");
+    ble_gattc_log_handles(handles, num_handles);
+}
+
+static void
+ble_gattc_log_read_mult_var(const uint16_t *handles, uint8_t num_handles)
+{
+    ble_gattc_log_proc_init("read multiple variable; ");
+    ble_gattc_log_handles(handles, num_handles);
+}
+
+static void
+ble_gattc_log_notify_multi(const uint16_t *handles, uint8_t num_handles)
+{
+    ble_gattc_log_proc_init("notify multiple; ");
+    ble_gattc_log_handles(handles, num_handles);
+}
+
 static void
 ble_gattc_log_write(uint16_t att_handle, uint16_t len, int expecting_rsp)
 {
@@ -665,6 +759,10 @@ ble_gattc_rx_entry_find(uint8_t op, const void *rx_entries, int num_entries)
  * $proc                                                                    *
  *****************************************************************************/
 
+#if MYNEWT_VAL(BLE_GATT_PROC_QUEUE)
+static void ble_gattc_proc_kick(uint16_t conn_handle);
+#endif
+
 /**
  * Allocates a proc entry.
  *
@@ -696,6 +794,10 @@ ble_gattc_proc_free(struct ble_gattc_proc *proc)
         ble_gattc_dbg_assert_proc_not_inserted(proc);
 
         switch (proc->op) {
+        case BLE_GATT_OP_WRITE:
+            os_mbuf_free_chain(proc->write.om);
+            break;
+
         case BLE_GATT_OP_WRITE_LONG:
             os_mbuf_free_chain(proc->write_long.attr.om);
             break;
@@ -755,9 +857,18 @@ ble_gattc_proc_set_resume_timer(struct ble_gattc_proc *proc)
 static void
 ble_gattc_process_status(struct ble_gattc_proc *proc, int status)
 {
+#if MYNEWT_VAL(BLE_GATT_PROC_QUEUE)
+    uint16_t conn_handle;
+
+    if (proc == ble_gattc_rx_proc) {
+        ble_gattc_rx_proc = NULL;
+    }
+#endif
+
     switch (status) {
     case 0:
-        if (!(proc->flags & BLE_GATTC_PROC_F_STALLED)) {
+        if (!(proc->flags & (BLE_GATTC_PROC_F_STALLED |
+                             BLE_GATTC_PROC_F_QUEUED))) {
             ble_gattc_proc_set_exp_timer(proc);
         }
 
@@ -766,7 +877,15 @@ ble_gattc_process_status(struct ble_gattc_proc *proc, int status)
         break;
 
     default:
+#if MYNEWT_VAL(BLE_GATT_PROC_QUEUE)
+        conn_handle = proc->conn_handle;
+        ble_gattc_proc_free(proc);
+
+        /* Issue the next procedure waiting on this connection. */
+        ble_gattc_proc_kick(conn_handle);
+#else
         ble_gattc_proc_free(proc);
+#endif
         break;
     }
 }
@@ -829,6 +948,7 @@ typedef int ble_gattc_match_fn(struct ble_gattc_proc *proc, void *arg);
 struct ble_gattc_criteria_conn_op {
     uint16_t conn_handle;
     uint8_t op;
+    uint8_t active_only;
 };
 
 /**
@@ -838,6 +958,8 @@ struct ble_gattc_criteria_conn_op {
  * @param conn_handle           The connection handle to match against.
  * @param op                    The op code to match against, or
  *                                  BLE_GATT_OP_NONE to ignore this criterion.
+ * @param active_only           Whether to skip procedures that are queued
+ *                                  behind another procedure.
  *
  * @return                      1 if the proc matches; 0 otherwise.
  */
@@ -852,6 +974,10 @@ ble_gattc_proc_matches_conn_op(struct ble_gattc_proc *proc, void *arg)
         return 0;
     }
 
+    if (criteria->active_only && proc->flags & BLE_GATTC_PROC_F_QUEUED) {
+        return 0;
+    }
+
     if (criteria->op != proc->op && criteria->op != BLE_GATT_OP_NONE) {
         return 0;
     }
@@ -872,6 +998,11 @@ ble_gattc_proc_matches_expired(struct ble_gattc_proc *proc, void *arg)
 
     criteria = arg;
 
+    /* Queued procedures haven't been sent yet; they can't time out. */
+    if (proc->flags & BLE_GATTC_PROC_F_QUEUED) {
+        return 0;
+    }
+
     time_diff = proc->exp_os_ticks - criteria->now;
 
     if (time_diff <= 0) {
@@ -906,6 +1037,10 @@ ble_gattc_proc_matches_conn_rx_entry(struct ble_gattc_proc *proc, void *arg)
         return 0;
     }
 
+    if (proc->flags & BLE_GATTC_PROC_F_QUEUED) {
+        return 0;
+    }
+
     /* Entry matches; indicate corresponding rx entry. */
     criteria->matching_rx_entry = ble_gattc_rx_entry_find(
         proc->op, criteria->rx_entries, criteria->num_rx_entries);
@@ -976,6 +1111,7 @@ ble_gattc_extract_by_conn_op(uint16_t conn_handle, uint8_t op,
 
     criteria.conn_handle = conn_handle;
     criteria.op = op;
+    criteria.active_only = 0;
 
     ble_gattc_extract(ble_gattc_proc_matches_conn_op, &criteria, 0, dst_list);
 }
@@ -983,10 +1119,20 @@ ble_gattc_extract_by_conn_op(uint16_t conn_handle, uint8_t op,
 static struct ble_gattc_proc *
 ble_gattc_extract_first_by_conn_op(uint16_t conn_handle, uint8_t op)
 {
-    struct ble_gattc_proc_list dst_list;
+    struct ble_gattc_criteria_conn_op criteria;
+    struct ble_gattc_proc *proc;
 
-    ble_gattc_extract_by_conn_op(conn_handle, op, &dst_list);
-    return STAILQ_FIRST(&dst_list);
+    criteria.conn_handle = conn_handle;
+    criteria.op = op;
+    criteria.active_only = 1;
+
+    proc = ble_gattc_extract_one(ble_gattc_proc_matches_conn_op, &criteria);
+
+#if MYNEWT_VAL(BLE_GATT_PROC_QUEUE)
+    ble_gattc_rx_proc = proc;
+#endif
+
+    return proc;
 }
 
 static int
@@ -1036,6 +1182,10 @@ ble_gattc_extract_with_rx_entry(uint16_t conn_handle,
                                  &criteria);
     *out_rx_entry = criteria.matching_rx_entry;
 
+#if MYNEWT_VAL(BLE_GATT_PROC_QUEUE)
+    ble_gattc_rx_proc = proc;
+#endif
+
     return proc;
 }
 
@@ -1088,6 +1238,156 @@ ble_gattc_fail_procs(uint16_t conn_handle, uint8_t op, int status)
     }
 }
 
+#if MYNEWT_VAL(BLE_GATT_PROC_QUEUE)
+
+/**
+ * Indicates whether a client procedure is outstanding on the specified
+ * connection.  Queued procedures count; a new procedure must line up behind
+ * them to preserve the order the application requested.  Indications are
+ * server-side transactions and don't hold up client procedures.
+ */
+static int
+ble_gattc_conn_busy(uint16_t conn_handle)
+{
+    struct ble_gattc_proc *proc;
+    int busy;
+
+    if (ble_gattc_rx_proc != NULL &&
+        ble_gattc_rx_proc->conn_handle == conn_handle &&
+        ble_gattc_rx_proc->op != BLE_GATT_OP_INDICATE) {
+
+        return 1;
+    }
+
+    busy = 0;
+
+    ble_hs_lock();
+    STAILQ_FOREACH(proc, &ble_gattc_procs, next) {
+        if (proc->conn_handle == conn_handle &&
+            proc->op != BLE_GATT_OP_INDICATE) {
+
+            busy = 1;
+            break;
+        }
+    }
+    ble_hs_unlock();
+
+    return busy;
+}
+
+/**
+ * Removes the first queued procedure for the specified connection from the
+ * proc list, provided no other procedure is outstanding on the connection.
+ *
+ * @return                      The procedure to issue next; null if there is
+ *                                  none or the connection is still busy.
+ */
+static struct ble_gattc_proc *
+ble_gattc_extract_queued(uint16_t conn_handle)
+{
+    struct ble_gattc_proc *proc;
+    struct ble_gattc_proc *first;
+
+    /* Only the parent task is allowed to remove entries from the list. */
+    BLE_HS_DBG_ASSERT(ble_hs_is_parent_task());
+
+    if (ble_gattc_rx_proc != NULL &&
+        ble_gattc_rx_proc->conn_handle == conn_handle &&
+        ble_gattc_rx_proc->op != BLE_GATT_OP_INDICATE) {
+
+        return NULL;
+    }
+
+    first = NULL;
+
+    ble_hs_lock();
+
+    STAILQ_FOREACH(proc, &ble_gattc_procs, next) {
+        if (proc->conn_handle != conn_handle ||
+            proc->op == BLE_GATT_OP_INDICATE) {
+
+            continue;
+        }
+
+        if (!(proc->flags & BLE_GATTC_PROC_F_QUEUED)) {
+            /* Another procedure is still in progress. */
+            first = NULL;
+            break;
+        }
+
+        if (first == NULL) {
+            first = proc;
+        }
+    }
+
+    if (first != NULL) {
+        STAILQ_REMOVE(&ble_gattc_procs, first, ble_gattc_proc, next);
+        first->flags &= ~BLE_GATTC_PROC_F_QUEUED;
+    }
+
+    ble_hs_unlock();
+
+    return first;
+}
+
+/**
+ * Marks a newly created procedure as queued if another procedure is
+ * outstanding on its connection.  A queued procedure is inserted into the
+ * proc list without transmitting anything; it gets issued by
+ * ble_gattc_proc_kick() when the connection becomes idle.
+ *
+ * @return                      1 if the procedure was queued;
+ *                              0 if it should be transmitted immediately.
+ */
+static int
+ble_gattc_proc_defer(struct ble_gattc_proc *proc)
+{
+    if (!ble_gattc_conn_busy(proc->conn_handle)) {
+        return 0;
+    }
+
+    proc->flags |= BLE_GATTC_PROC_F_QUEUED;
+    return 1;
+}
+
+/**
+ * Issues the next queued procedure on the specified connection, if the
+ * connection is idle.  Called whenever a procedure completes, so the next
+ * request goes out in the same host event as the previous response.
+ * Procedures whose transmit fails are reported and discarded, and the next
+ * one is tried.
+ */
+static void
+ble_gattc_proc_kick(uint16_t conn_handle)
+{
+    struct ble_gattc_proc *proc;
+    ble_gattc_resume_fn *resume_cb;
+    int rc;
+
+    while ((proc = ble_gattc_extract_queued(conn_handle)) != NULL) {
+        resume_cb = ble_gattc_resume_dispatch_get(proc->op);
+        BLE_HS_DBG_ASSERT(resume_cb != NULL);
+
+        rc = resume_cb(proc);
+        if (rc == 0) {
+            ble_gattc_process_status(proc, 0);
+            break;
+        }
+
+        ble_gattc_proc_free(proc);
+    }
+}
+
+#else
+
+static int
+ble_gattc_proc_defer(struct ble_gattc_proc *proc)
+{
+    return 0;
+}
+
+#endif
+
 static void
 ble_gattc_resume_procs(void)
 {
@@ -1286,6 +1586,22 @@ ble_gattc_mtu_tx(struct ble_gattc_proc *proc)
     return rc;
 }
 
+static int
+ble_gattc_mtu_resume(struct ble_gattc_proc *proc)
+{
+    int status;
+    int rc;
+
+    status = ble_gattc_mtu_tx(proc);
+    rc = ble_gattc_process_resume_status(proc, status);
+    if (rc != 0) {
+        ble_gattc_mtu_cb(proc, rc, 0, 0);
+        return rc;
+    }
+
+    return 0;
+}
+
 /**
  * Initiates GATT procedure: Exchange MTU.
  *
@@ -1319,6 +1635,11 @@ ble_gattc_exchange_mtu(uint16_t conn_handle, ble_gatt_mtu_fn *cb, void *cb_arg)
 
     ble_gattc_log_proc_init("exchange mtu\n");
 
+    if (ble_gattc_proc_defer(proc)) {
+        rc = 0;
+        goto done;
+    }
+
     rc = ble_gattc_mtu_tx(proc);
     if (rc != 0) {
         goto done;
@@ -1334,86 +1655,443 @@ done:
 }
 
 /*****************************************************************************
- * $discover all services                                                    *
+ * $cache                                                                    *
  *****************************************************************************/
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+
+/* Discovery procedures being answered from the cache. */
+static struct ble_gattc_proc_list ble_gattc_cache_procs;
+
+/* Replays cached procedures in the host parent task. */
+static struct os_event ble_gattc_cache_ev;
+
+static int ble_gattc_disc_all_svcs_cb(struct ble_gattc_proc *proc,
+                                      uint16_t status, uint16_t att_handle,
+                                      struct ble_gatt_svc *service);
+static int ble_gattc_disc_svc_uuid_cb(struct ble_gattc_proc *proc, int status,
+                                      uint16_t att_handle,
+                                      struct ble_gatt_svc *service);
+static int ble_gattc_disc_all_chrs_cb(struct ble_gattc_proc *proc, int status,
+                                      uint16_t att_handle,
+                                      struct ble_gatt_chr *chr);
+static int ble_gattc_disc_chr_uuid_cb(struct ble_gattc_proc *proc, int status,
+                                      uint16_t att_handle,
+                                      struct ble_gatt_chr *chr);
+static int ble_gattc_disc_all_dscs_cb(struct ble_gattc_proc *proc, int status,
+                                      uint16_t att_handle,
+                                      struct ble_gatt_dsc *dsc);
+
 /**
- * Calls a discover-all-services proc's callback with the specified parameters.
- * If the proc has no callback, this function is a no-op.
+ * Determines whether the specified discovery proc can be answered from the
+ * cache.  If it can, the proc is queued for replay.  Otherwise, the proc is
+ * flagged so that its results get cached (provided the peer is bonded).
  *
- * @return                      The return code of the callback (or 0 if there
- *                                  is no callback).
+ * @return                      1 if the proc was queued for replay;
+ *                              0 if the proc must be executed over the air.
  */
 static int
-ble_gattc_disc_all_svcs_cb(struct ble_gattc_proc *proc,
-                           uint16_t status, uint16_t att_handle,
-                           struct ble_gatt_svc *service)
+ble_gattc_cache_proc_start(struct ble_gattc_proc *proc)
 {
+    ble_addr_t *peer;
+    int cached;
     int rc;
 
-    BLE_HS_DBG_ASSERT(!ble_hs_locked_by_cur_task());
-    BLE_HS_DBG_ASSERT(service != NULL || status != 0);
-    ble_gattc_dbg_assert_proc_not_inserted(proc);
-
-    if (status != 0 && status != BLE_HS_EDONE) {
-        STATS_INC(ble_gattc_stats, disc_all_svcs_fail);
+    peer = &proc->cache_peer;
+    rc = ble_gattc_cache_peer(proc->conn_handle, peer);
+    if (rc != 0) {
+        return 0;
     }
 
-    if (proc->disc_all_svcs.cb == NULL) {
-        rc = 0;
-    } else {
-        rc = proc->disc_all_svcs.cb(proc->conn_handle,
-                                    ble_gattc_error(status, att_handle),
-                                    service, proc->disc_all_svcs.cb_arg);
+    switch (proc->op) {
+    case BLE_GATT_OP_DISC_ALL_SVCS:
+        cached = ble_gattc_cache_has_svcs(peer);
+        if (!cached) {
+            proc->flags |= BLE_GATTC_PROC_F_CACHE;
+        }
+        break;
+
+    case BLE_GATT_OP_DISC_SVC_UUID:
+        cached = ble_gattc_cache_has_svcs(peer);
+        break;
+
+    case BLE_GATT_OP_DISC_ALL_CHRS:
+        proc->cache_start_handle = proc->disc_all_chrs.prev_handle + 1;
+        cached = ble_gattc_cache_has_chrs(peer, proc->cache_start_handle,
+                                          proc->disc_all_chrs.end_handle);
+        if (!cached) {
+            proc->flags |= BLE_GATTC_PROC_F_CACHE;
+        }
+        break;
+
+    case BLE_GATT_OP_DISC_CHR_UUID:
+        cached = ble_gattc_cache_has_chrs(peer,
+                                          proc->disc_chr_uuid.prev_handle + 1,
+                                          proc->disc_chr_uuid.end_handle);
+        break;
+
+    case BLE_GATT_OP_DISC_ALL_DSCS:
+        cached = ble_gattc_cache_has_dscs(peer,
+                                          proc->disc_all_dscs.chr_val_handle,
+                                          proc->disc_all_dscs.end_handle);
+        if (!cached) {
+            proc->flags |= BLE_GATTC_PROC_F_CACHE;
+        }
+        break;
+
+    default:
+        cached = 0;
+        break;
     }
 
-    return rc;
-}
+    if (!cached) {
+        return 0;
+    }
 
-static void
-ble_gattc_disc_all_svcs_tmo(struct ble_gattc_proc *proc)
-{
-    BLE_HS_DBG_ASSERT(!ble_hs_locked_by_cur_task());
-    ble_gattc_dbg_assert_proc_not_inserted(proc);
+    ble_hs_lock();
+    STAILQ_INSERT_TAIL(&ble_gattc_cache_procs, proc, next);
+    ble_hs_unlock();
 
-    ble_gattc_disc_all_svcs_cb(proc, BLE_HS_ETIMEOUT, 0, 0);
+    os_eventq_put(ble_hs_evq_get(), &ble_gattc_cache_ev);
+    return 1;
 }
 
 /**
- * Triggers a pending transmit for the specified discover-all-services proc.
+ * Stops caching the results of the specified proc if a cache write failed.
+ * The entries written so far remain in the store, but they are never replayed
+ * because the range is not marked complete.
  */
-static int
-ble_gattc_disc_all_svcs_tx(struct ble_gattc_proc *proc)
+static void
+ble_gattc_cache_proc_write_status(struct ble_gattc_proc *proc, int rc)
 {
-    ble_uuid16_t uuid = BLE_UUID16_INIT(BLE_ATT_UUID_PRIMARY_SERVICE);
-    int rc;
-
-    ble_gattc_dbg_assert_proc_not_inserted(proc);
-
-    rc = ble_att_clt_tx_read_group_type(proc->conn_handle,
-                                        proc->disc_all_svcs.prev_handle + 1,
-                                        0xffff, &uuid.u);
     if (rc != 0) {
-        return rc;
+        BLE_HS_LOG(DEBUG, "GATT cache write failed; rc=%d\n", rc);
+        proc->flags &= ~BLE_GATTC_PROC_F_CACHE;
     }
-
-    return 0;
 }
 
-static int
-ble_gattc_disc_all_svcs_resume(struct ble_gattc_proc *proc)
+static void
+ble_gattc_cache_proc_add_svc(struct ble_gattc_proc *proc,
+                             const struct ble_gatt_svc *svc)
 {
-    int status;
     int rc;
 
-    status = ble_gattc_disc_all_svcs_tx(proc);
-    rc = ble_gattc_process_resume_status(proc, status);
-    if (rc != 0) {
-        ble_gattc_disc_all_svcs_cb(proc, rc, 0, NULL);
-        return rc;
+    if (proc->flags & BLE_GATTC_PROC_F_CACHE) {
+        rc = ble_gattc_cache_add_svc(&proc->cache_peer, svc);
+        ble_gattc_cache_proc_write_status(proc, rc);
     }
-
-    return 0;
+}
+
+static void
+ble_gattc_cache_proc_add_chr(struct ble_gattc_proc *proc,
+                             const struct ble_gatt_chr *chr)
+{
+    int rc;
+
+    if (proc->flags & BLE_GATTC_PROC_F_CACHE) {
+        rc = ble_gattc_cache_add_chr(&proc->cache_peer, chr);
+        ble_gattc_cache_proc_write_status(proc, rc);
+    }
+}
+
+static void
+ble_gattc_cache_proc_add_dsc(struct ble_gattc_proc *proc,
+                             const struct ble_gatt_dsc *dsc)
+{
+    int rc;
+
+    if (proc->flags & BLE_GATTC_PROC_F_CACHE) {
+        rc = ble_gattc_cache_add_dsc(&proc->cache_peer, dsc);
+        ble_gattc_cache_proc_write_status(proc, rc);
+    }
+}
+
+/**
+ * Marks the range searched by the specified proc as complete in the cache.
+ * Called when a discovery proc finishes successfully.
+ */
+static void
+ble_gattc_cache_proc_done(struct ble_gattc_proc *proc)
+{
+    int rc;
+
+    if (!(proc->flags & BLE_GATTC_PROC_F_CACHE)) {
+        return;
+    }
+    proc->flags &= ~BLE_GATTC_PROC_F_CACHE;
+
+    switch (proc->op) {
+    case BLE_GATT_OP_DISC_ALL_SVCS:
+        rc = ble_gattc_cache_svcs_done(&proc->cache_peer);
+        break;
+
+    case BLE_GATT_OP_DISC_ALL_CHRS:
+        rc = ble_gattc_cache_chrs_done(&proc->cache_peer,
+                                       proc->cache_start_handle,
+                                       proc->disc_all_chrs.end_handle);
+        break;
+
+    case BLE_GATT_OP_DISC_ALL_DSCS:
+        rc = ble_gattc_cache_dscs_done(&proc->cache_peer,
+                                       proc->disc_all_dscs.chr_val_handle,
+                                       proc->disc_all_dscs.end_handle);
+        break;
+
+    default:
+        rc = 0;
+        break;
+    }
+
+    ble_gattc_cache_proc_write_status(proc, rc);
+}
+
+/**
+ * Converts the result of a cache iteration to a procedure status.
+ */
+static int
+ble_gattc_cache_replay_status(int rc)
+{
+    if (rc == BLE_HS_ENOENT) {
+        return BLE_HS_EDONE;
+    }
+
+    return rc;
+}
+
+/**
+ * Reports the cached results of the specified proc to the application, in the
+ * same order the peer would have reported them.
+ */
+static void
+ble_gattc_cache_replay(struct ble_gattc_proc *proc)
+{
+    struct ble_gatt_svc svc;
+    struct ble_gatt_chr chr;
+    struct ble_gatt_dsc dsc;
+    const ble_addr_t *peer;
+    uint16_t prev_handle;
+    int rc;
+
+    peer = &proc->cache_peer;
+
+    ble_hs_lock();
+    if (ble_hs_conn_find(proc->conn_handle) == NULL) {
+        rc = BLE_HS_ENOTCONN;
+    } else {
+        rc = 0;
+    }
+    ble_hs_unlock();
+
+    switch (proc->op) {
+    case BLE_GATT_OP_DISC_ALL_SVCS:
+        prev_handle = 0;
+        while (rc == 0) {
+            rc = ble_gattc_cache_next_svc(peer, prev_handle, &svc);
+            if (rc == 0) {
+                prev_handle = svc.start_handle;
+                if (ble_gattc_disc_all_svcs_cb(proc, 0, 0, &svc) != 0) {
+                    return;
+                }
+            }
+        }
+        ble_gattc_disc_all_svcs_cb(proc, ble_gattc_cache_replay_status(rc),
+                                   0, NULL);
+        break;
+
+    case BLE_GATT_OP_DISC_SVC_UUID:
+        prev_handle = 0;
+        while (rc == 0) {
+            rc = ble_gattc_cache_next_svc(peer, prev_handle, &svc);
+            if (rc == 0) {
+                prev_handle = svc.start_handle;
+                if (ble_uuid_cmp(&svc.uuid.u,
+                                 &proc->disc_svc_uuid.service_uuid.u) == 0 &&
+                    ble_gattc_disc_svc_uuid_cb(proc, 0, 0, &svc) != 0) {
+
+                    return;
+                }
+            }
+        }
+        ble_gattc_disc_svc_uuid_cb(proc, ble_gattc_cache_replay_status(rc),
+                                   0, NULL);
+        break;
+
+    case BLE_GATT_OP_DISC_ALL_CHRS:
+        prev_handle = proc->disc_all_chrs.prev_handle;
+        while (rc == 0) {
+            rc = ble_gattc_cache_next_chr(peer, prev_handle,
+                                          proc->disc_all_chrs.end_handle,
+                                          &chr);
+            if (rc == 0) {
+                prev_handle = chr.def_handle;
+                if (ble_gattc_disc_all_chrs_cb(proc, 0, 0, &chr) != 0) {
+                    return;
+                }
+            }
+        }
+        ble_gattc_disc_all_chrs_cb(proc, ble_gattc_cache_replay_status(rc),
+                                   0, NULL);
+        break;
+
+    case BLE_GATT_OP_DISC_CHR_UUID:
+        prev_handle = proc->disc_chr_uuid.prev_handle;
+        while (rc == 0) {
+            rc = ble_gattc_cache_next_chr(peer, prev_handle,
+                                          proc->disc_chr_uuid.end_handle,
+                                          &chr);
+            if (rc == 0) {
+                prev_handle = chr.def_handle;
+                if (ble_uuid_cmp(&chr.uuid.u,
+                                 &proc->disc_chr_uuid.chr_uuid.u) == 0 &&
+                    ble_gattc_disc_chr_uuid_cb(proc, 0, 0, &chr) != 0) {
+
+                    return;
+                }
+            }
+        }
+        ble_gattc_disc_chr_uuid_cb(proc, ble_gattc_cache_replay_status(rc),
+                                   0, NULL);
+        break;
+
+    case BLE_GATT_OP_DISC_ALL_DSCS:
+        prev_handle = proc->disc_all_dscs.prev_handle;
+        while (rc == 0) {
+            rc = ble_gattc_cache_next_dsc(peer, prev_handle,
+                                          proc->disc_all_dscs.end_handle,
+                                          &dsc);
+            if (rc == 0) {
+                prev_handle = dsc.handle;
+                if (ble_gattc_disc_all_dscs_cb(proc, 0, 0, &dsc) != 0) {
+                    return;
+                }
+            }
+        }
+        ble_gattc_disc_all_dscs_cb(proc, ble_gattc_cache_replay_status(rc),
+                                   0, NULL);
+        break;
+
+    default:
+        BLE_HS_DBG_ASSERT(0);
+        break;
+    }
+}
+
+/**
+ * Replays all queued cached procedures.  Procedures are replayed from the
+ * event queue rather than from the initiating call, so that an application
+ * chaining discovery procedures from its callbacks does not recurse.
+ */
+static void
+ble_gattc_cache_event(struct os_event *ev)
+{
+    struct ble_gattc_proc *proc;
+
+    while (1) {
+        ble_hs_lock();
+        proc = STAILQ_FIRST(&ble_gattc_cache_procs);
+        if (proc != NULL) {
+            STAILQ_REMOVE_HEAD(&ble_gattc_cache_procs, next);
+        }
+        ble_hs_unlock();
+
+        if (proc == NULL) {
+            return;
+        }
+
+        ble_gattc_cache_replay(proc);
+        ble_gattc_proc_free(proc);
+    }
+}
+
+#endif
+
+/*****************************************************************************
+ * $discover all services                                                    *
+ *****************************************************************************/
+
+/**
+ * Calls a discover-all-services proc's callback with the specified parameters.
+ * If the proc has no callback, this function is a no-op.
+ *
+ * @return                      The return code of the callback (or 0 if there
+ *                                  is no callback).
+ */
+static int
+ble_gattc_disc_all_svcs_cb(struct ble_gattc_proc *proc,
+                           uint16_t status, uint16_t att_handle,
+                           struct ble_gatt_svc *service)
+{
+    int rc;
+
+    BLE_HS_DBG_ASSERT(!ble_hs_locked_by_cur_task());
+    BLE_HS_DBG_ASSERT(service != NULL || status != 0);
+    ble_gattc_dbg_assert_proc_not_inserted(proc);
+
+    if (status != 0 && status != BLE_HS_EDONE) {
+        STATS_INC(ble_gattc_stats, disc_all_svcs_fail);
+    }
+
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    if (status == BLE_HS_EDONE) {
+        ble_gattc_cache_proc_done(proc);
+    }
+#endif
+
+    if (proc->disc_all_svcs.cb == NULL) {
+        rc = 0;
+    } else {
+        rc = proc->disc_all_svcs.cb(proc->conn_handle,
+                                    ble_gattc_error(status, att_handle),
+                                    service, proc->disc_all_svcs.cb_arg);
+    }
+
+    return rc;
+}
+
+static void
+ble_gattc_disc_all_svcs_tmo(struct ble_gattc_proc *proc)
+{
+    BLE_HS_DBG_ASSERT(!ble_hs_locked_by_cur_task());
+    ble_gattc_dbg_assert_proc_not_inserted(proc);
+
+    ble_gattc_disc_all_svcs_cb(proc, BLE_HS_ETIMEOUT, 0, 0);
+}
+
+/**
+ * Triggers a pending transmit for the specified discover-all-services proc.
+ */
+static int
+ble_gattc_disc_all_svcs_tx(struct ble_gattc_proc *proc)
+{
+    ble_uuid16_t uuid = BLE_UUID16_INIT(BLE_ATT_UUID_PRIMARY_SERVICE);
+    int rc;
+
+    ble_gattc_dbg_assert_proc_not_inserted(proc);
+
+    rc = ble_att_clt_tx_read_group_type(proc->conn_handle,
+                                        proc->disc_all_svcs.prev_handle + 1,
+                                        0xffff, &uuid.u);
+    if (rc != 0) {
+        return rc;
+    }
+
+    return 0;
+}
+
+static int
+ble_gattc_disc_all_svcs_resume(struct ble_gattc_proc *proc)
+{
+    int status;
+    int rc;
+
+    status = ble_gattc_disc_all_svcs_tx(proc);
+    rc = ble_gattc_process_resume_status(proc, status);
+    if (rc != 0) {
+        ble_gattc_disc_all_svcs_cb(proc, rc, 0, NULL);
+        return rc;
+    }
+
+    return 0;
 }
 
 /**
@@ -1474,6 +2152,10 @@ ble_gattc_disc_all_svcs_rx_adata(struct ble_gattc_proc *proc,
     service.start_handle = adata->att_handle;
     service.end_handle = adata->end_group_handle;
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    ble_gattc_cache_proc_add_svc(proc, &service);
+#endif
+
     rc = 0;
 
 done:
@@ -1553,6 +2235,17 @@ ble_gattc_disc_all_svcs(uint16_t conn_handle, ble_gatt_disc_svc_fn *cb,
 
     ble_gattc_log_proc_init("discover all services\n");
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    if (ble_gattc_cache_proc_start(proc)) {
+        return 0;
+    }
+#endif
+
+    if (ble_gattc_proc_defer(proc)) {
+        rc = 0;
+        goto done;
+    }
+
     rc = ble_gattc_disc_all_svcs_tx(proc);
     if (rc != 0) {
         goto done;
@@ -1780,6 +2473,17 @@ ble_gattc_disc_svc_by_uuid(uint16_t conn_handle, const ble_uuid_t *uuid,
 
     ble_gattc_log_disc_svc_uuid(proc);
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    if (ble_gattc_cache_proc_start(proc)) {
+        return 0;
+    }
+#endif
+
+    if (ble_gattc_proc_defer(proc)) {
+        rc = 0;
+        goto done;
+    }
+
     rc = ble_gattc_disc_svc_uuid_tx(proc);
     if (rc != 0) {
         goto done;
@@ -2109,6 +2813,11 @@ ble_gattc_find_inc_svcs(uint16_t conn_handle, uint16_t start_handle,
 
     ble_gattc_log_find_inc_svcs(proc);
 
+    if (ble_gattc_proc_defer(proc)) {
+        rc = 0;
+        goto done;
+    }
+
     rc = ble_gattc_find_inc_svcs_tx(proc);
     if (rc != 0) {
         goto done;
@@ -2148,6 +2857,12 @@ ble_gattc_disc_all_chrs_cb(struct ble_gattc_proc *proc, int status,
         STATS_INC(ble_gattc_stats, disc_all_chrs_fail);
     }
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    if (status == BLE_HS_EDONE) {
+        ble_gattc_cache_proc_done(proc);
+    }
+#endif
+
     if (proc->disc_all_chrs.cb == NULL) {
         rc = 0;
     } else {
@@ -2267,6 +2982,10 @@ ble_gattc_disc_all_chrs_rx_adata(struct ble_gattc_proc *proc,
     }
     proc->disc_all_chrs.prev_handle = adata->att_handle;
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    ble_gattc_cache_proc_add_chr(proc, &chr);
+#endif
+
     rc = 0;
 
 done:
@@ -2353,6 +3072,17 @@ ble_gattc_disc_all_chrs(uint16_t conn_handle, uint16_t start_handle,
 
     ble_gattc_log_disc_all_chrs(proc);
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    if (ble_gattc_cache_proc_start(proc)) {
+        return 0;
+    }
+#endif
+
+    if (ble_gattc_proc_defer(proc)) {
+        rc = 0;
+        goto done;
+    }
+
     rc = ble_gattc_disc_all_chrs_tx(proc);
     if (rc != 0) {
         goto done;
@@ -2611,6 +3341,17 @@ ble_gattc_disc_chrs_by_uuid(uint16_t conn_handle, uint16_t start_handle,
 
     ble_gattc_log_disc_chr_uuid(proc);
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    if (ble_gattc_cache_proc_start(proc)) {
+        return 0;
+    }
+#endif
+
+    if (ble_gattc_proc_defer(proc)) {
+        rc = 0;
+        goto done;
+    }
+
     rc = ble_gattc_disc_chr_uuid_tx(proc);
     if (rc != 0) {
         goto done;
@@ -2650,6 +3391,12 @@ ble_gattc_disc_all_dscs_cb(struct ble_gattc_proc *proc, int status,
         STATS_INC(ble_gattc_stats, disc_all_dscs_fail);
     }
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    if (status == BLE_HS_EDONE) {
+        ble_gattc_cache_proc_done(proc);
+    }
+#endif
+
     if (proc->disc_all_dscs.cb == NULL) {
         rc = 0;
     } else {
@@ -2752,6 +3499,12 @@ done:
     dsc.handle = idata->attr_handle;
     dsc.uuid = idata->uuid;
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    if (rc == 0) {
+        ble_gattc_cache_proc_add_dsc(proc, &dsc);
+    }
+#endif
+
     cbrc = ble_gattc_disc_all_dscs_cb(proc, rc, 0, &dsc);
     if (rc != 0 || cbrc != 0) {
         return BLE_HS_EDONE;
@@ -2837,6 +3590,17 @@ ble_gattc_disc_all_dscs(uint16_t conn_handle, uint16_t start_handle,
 
     ble_gattc_log_disc_all_dscs(proc);
 
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    if (ble_gattc_cache_proc_start(proc)) {
+        return 0;
+    }
+#endif
+
+    if (ble_gattc_proc_defer(proc)) {
+        rc = 0;
+        goto done;
+    }
+
     rc = ble_gattc_disc_all_dscs_tx(proc);
     if (rc != 0) {
         goto done;
@@ -2946,8 +3710,24 @@ ble_gattc_read_tx(struct ble_gattc_proc *proc)
     return 0;
 }
 
-/**
- * Initiates GATT procedure: Read Characteristic Value.
+static int
+ble_gattc_read_resume(struct ble_gattc_proc *proc)
+{
+    int status;
+    int rc;
+
+    status = ble_gattc_read_tx(proc);
+    rc = ble_gattc_process_resume_status(proc, status);
+    if (rc != 0) {
+        ble_gattc_read_cb(proc, rc, 0, NULL);
+        return rc;
+    }
+
+    return 0;
+}
+
+/**
+ * Initiates GATT procedure: Read Characteristic Value.
  *
  * @param conn_handle           The connection over which to execute the
  *                                  procedure.
@@ -2985,6 +3765,12 @@ ble_gattc_read(uint16_t conn_handle, uint16_t attr_handle,
     proc->read.cb_arg = cb_arg;
 
     ble_gattc_log_read(attr_handle);
+
+    if (ble_gattc_proc_defer(proc)) {
+        rc = 0;
+        goto done;
+    }
+
     rc = ble_gattc_read_tx(proc);
     if (rc != 0) {
         goto done;
@@ -3120,6 +3906,22 @@ ble_gattc_read_uuid_tx(struct ble_gattc_proc *proc)
                                     &proc->read_uuid.chr_uuid.u);
 }
 
+static int
+ble_gattc_read_uuid_resume(struct ble_gattc_proc *proc)
+{
+    int status;
+    int rc;
+
+    status = ble_gattc_read_uuid_tx(proc);
+    rc = ble_gattc_process_resume_status(proc, status);
+    if (rc != 0) {
+        ble_gattc_read_uuid_cb(proc, rc, 0, NULL);
+        return rc;
+    }
+
+    return 0;
+}
+
 /**
  * Initiates GATT procedure: Read Using Characteristic UUID.
  *
@@ -3165,6 +3967,12 @@ ble_gattc_read_by_uuid(uint16_t conn_handle, uint16_t start_handle,
     proc->read_uuid.cb_arg = cb_arg;
 
     ble_gattc_log_read_uuid(start_handle, end_handle, uuid);
+
+    if (ble_gattc_proc_defer(proc)) {
+        rc = 0;
+        goto done;
+    }
+
     rc = ble_gattc_read_uuid_tx(proc);
     if (rc != 0) {
         goto done;
@@ -3374,6 +4182,11 @@ ble_gattc_read_long(uint16_t conn_handle, uint16_t handle, uint16_t offset,
 
     ble_gattc_log_read_long(proc);
 
+    if (ble_gattc_proc_defer(proc)) {
+        rc = 0;
+        goto done;
+    }
+
     rc = ble_gattc_read_long_tx(proc);
     if (rc != 0) {
         goto done;
@@ -3473,6 +4286,22 @@ ble_gattc_read_mult_tx(struct ble_gattc_proc *proc)
     return 0;
 }
 
+static int
+ble_gattc_read_mult_resume(struct ble_gattc_proc *proc)
+{
+    int status;
+    int rc;
+
+    status = ble_gattc_read_mult_tx(proc);
+    rc = ble_gattc_process_resume_status(proc, status);
+    if (rc != 0) {
+        ble_gattc_read_mult_cb(proc, rc, 0, NULL);
+        return rc;
+    }
+
+    return 0;
+}
+
 /**
  * Initiates GATT procedure: Read Multiple Characteristic Values.
  *
@@ -3521,15 +4350,397 @@ ble_gattc_read_mult(uint16_t conn_handle, const uint16_t *handles,
     proc->read_mult.cb = cb;
     proc->read_mult.cb_arg = cb_arg;
 
-    ble_gattc_log_read_mult(handles, num_handles);
-    rc = ble_gattc_read_mult_tx(proc);
+    ble_gattc_log_read_mult(handles, num_handles);
+
+    if (ble_gattc_proc_defer(proc)) {
+        rc = 0;
+        goto done;
+    }
+
+    rc = ble_gattc_read_mult_tx(proc);
+    if (rc != 0) {
+        goto done;
+    }
+
+done:
+    if (rc != 0) {
+        STATS_INC(ble_gattc_stats, read_mult_fail);
+    }
+
+    ble_gattc_process_status(proc, rc);
+    return rc;
+}
+
+/*****************************************************************************
+ * $read multiple variable length                                            *
+ *****************************************************************************/
+
+/**
+ * Calls a read-multiple-variable-length proc's callback with the specified
+ * parameters.  If the proc has no callback, this function is a no-op.
+ *
+ * @return                      The return code of the callback (or 0 if there
+ *                                  is no callback).
+ */
+static int
+ble_gattc_read_mult_var_cb(struct ble_gattc_proc *proc, int status,
+                           uint16_t att_handle, struct ble_gatt_attr *attr)
+{
+    int rc;
+
+    BLE_HS_DBG_ASSERT(!ble_hs_locked_by_cur_task());
+    BLE_HS_DBG_ASSERT(attr != NULL || status != 0);
+    ble_gattc_dbg_assert_proc_not_inserted(proc);
+
+    if (status != 0 && status != BLE_HS_EDONE) {
+        STATS_INC(ble_gattc_stats, read_mult_var_fail);
+    }
+
+    if (proc->read_mult.cb == NULL) {
+        rc = 0;
+    } else {
+        rc = proc->read_mult.cb(proc->conn_handle,
+                                ble_gattc_error(status, att_handle), attr,
+                                proc->read_mult.cb_arg);
+    }
+
+    return rc;
+}
+
+static void
+ble_gattc_read_mult_var_tmo(struct ble_gattc_proc *proc)
+{
+    BLE_HS_DBG_ASSERT(!ble_hs_locked_by_cur_task());
+    ble_gattc_dbg_assert_proc_not_inserted(proc);
+
+    ble_gattc_read_mult_var_cb(proc, BLE_HS_ETIMEOUT, 0, NULL);
+}
+
+/**
+ * Handles an incoming ATT error response for the specified
+ * read-multiple-variable-length proc.
+ */
+static void
+ble_gattc_read_mult_var_err(struct ble_gattc_proc *proc, int status,
+                            uint16_t att_handle)
+{
+    ble_gattc_dbg_assert_proc_not_inserted(proc);
+    ble_gattc_read_mult_var_cb(proc, status, att_handle, NULL);
+}
+
+/**
+ * Handles an incoming read-multiple-variable-length response.  Each value in
+ * the response is reported to the application separately, in request order.
+ */
+static int
+ble_gattc_read_mult_var_rx(struct ble_gattc_proc *proc, struct os_mbuf **om)
+{
+    struct ble_gatt_attr attr;
+    const uint8_t *tuple;
+    uint8_t buf[BLE_ATT_READ_MULT_VAR_TUPLE_SZ];
+    uint16_t value_len;
+    uint8_t first;
+    int rc;
+    int i;
+
+    ble_gattc_dbg_assert_proc_not_inserted(proc);
+
+    first = proc->read_mult.cur_handle;
+    for (i = first; i < proc->read_mult.num_handles; i++) {
+        tuple = ble_hs_mbuf_peek(*om, 0, sizeof buf, buf);
+        if (tuple == NULL) {
+            /* The rest of the values didn't fit in the response. */
+            break;
+        }
+
+        value_len = get_le16(tuple);
+
+        /* The last value may have been truncated to fit the MTU.  A split
+         * read requests it again in the next PDU unless it is the only value
+         * in the response.
+         */
+        if (value_len > OS_MBUF_PKTLEN(*om) - BLE_ATT_READ_MULT_VAR_TUPLE_SZ) {
+            if (proc->read_mult.split && i > first) {
+                break;
+            }
+            value_len = OS_MBUF_PKTLEN(*om) - BLE_ATT_READ_MULT_VAR_TUPLE_SZ;
+        }
+        os_mbuf_adj(*om, BLE_ATT_READ_MULT_VAR_TUPLE_SZ);
+
+        attr.handle = proc->read_mult.handles[i];
+        attr.offset = 0;
+        attr.om = ble_hs_mbuf_att_pkt();
+        if (attr.om == NULL ||
+            os_mbuf_appendfrom(attr.om, *om, 0, value_len) != 0) {
+
+            os_mbuf_free_chain(attr.om);
+            ble_gattc_read_mult_var_cb(proc, BLE_HS_ENOMEM, 0, NULL);
+            return BLE_HS_EDONE;
+        }
+        os_mbuf_adj(*om, value_len);
+
+        rc = ble_gattc_read_mult_var_cb(proc, 0, 0, &attr);
+
+        /* Free the attribute mbuf if the application has not consumed it. */
+        os_mbuf_free_chain(attr.om);
+
+        if (rc != 0) {
+            return BLE_HS_EDONE;
+        }
+    }
+
+    proc->read_mult.cur_handle = i;
+
+    /* Request the remaining values, provided the peer made progress. */
+    if (proc->read_mult.split && i > first &&
+        i < proc->read_mult.num_handles) {
+
+        rc = ble_gattc_read_mult_var_resume(proc);
+        if (rc != 0) {
+            return BLE_HS_EDONE;
+        }
+        return 0;
+    }
+
+    ble_gattc_read_mult_var_cb(proc, BLE_HS_EDONE, 0, NULL);
+    return BLE_HS_EDONE;
+}
+
+/**
+ * Handles an incoming read-response for a split read-multiple proc.  A plain
+ * read request is used when only a single handle remains.
+ */
+static int
+ble_gattc_read_mult_var_rx_read_rsp(struct ble_gattc_proc *proc, int status,
+                                    struct os_mbuf **om)
+{
+    struct ble_gatt_attr attr;
+
+    ble_gattc_dbg_assert_proc_not_inserted(proc);
+
+    if (status != 0) {
+        ble_gattc_read_mult_var_cb(proc, status, 0, NULL);
+        return BLE_HS_EDONE;
+    }
+
+    attr.handle = proc->read_mult.handles[proc->read_mult.cur_handle];
+    attr.offset = 0;
+    attr.om = *om;
+
+    if (ble_gattc_read_mult_var_cb(proc, 0, 0, &attr) == 0) {
+        ble_gattc_read_mult_var_cb(proc, BLE_HS_EDONE, 0, NULL);
+    }
+
+    /* Indicate to the caller whether the application consumed the mbuf. */
+    *om = attr.om;
+
+    return BLE_HS_EDONE;
+}
+
+static int
+ble_gattc_read_mult_var_tx(struct ble_gattc_proc *proc)
+{
+    const uint16_t *handles;
+    uint16_t mtu;
+    int num_handles;
+    int max_handles;
+    int rc;
+
+    handles = proc->read_mult.handles + proc->read_mult.cur_handle;
+    num_handles = proc->read_mult.num_handles - proc->read_mult.cur_handle;
+
+    if (proc->read_mult.split) {
+        if (num_handles == 1) {
+            return ble_att_clt_tx_read(proc->conn_handle, handles[0]);
+        }
+
+        mtu = ble_att_mtu(proc->conn_handle);
+        if (mtu == 0) {
+            return BLE_HS_ENOTCONN;
+        }
+
+        max_handles = (mtu - BLE_ATT_READ_MULT_VAR_REQ_BASE_SZ) /
+                      sizeof *handles;
+        if (num_handles > max_handles) {
+            num_handles = max_handles;
+        }
+    }
+
+    rc = ble_att_clt_tx_read_mult_var(proc->conn_handle, handles,
+                                      num_handles);
+    if (rc != 0) {
+        return rc;
+    }
+
+    return 0;
+}
+
+static int
+ble_gattc_read_mult_var_resume(struct ble_gattc_proc *proc)
+{
+    int status;
+    int rc;
+
+    status = ble_gattc_read_mult_var_tx(proc);
+    rc = ble_gattc_process_resume_status(proc, status);
+    if (rc != 0) {
+        ble_gattc_read_mult_var_cb(proc, rc, 0, NULL);
+        return rc;
+    }
+
+    return 0;
+}
+
+/**
+ * Initiates GATT procedure: Read Multiple Variable Length Characteristic
+ * Values.  Unlike ble_gattc_read_mult(), the response carries the length of
+ * each value, so the values are reported to the callback one at a time, each
+ * with its attribute handle.  A final callback with a status of BLE_HS_EDONE
+ * indicates the procedure is complete.  Values that did not fit in the ATT
+ * MTU are truncated or omitted; use ble_gattc_read_long() to retrieve them.
+ *
+ * @param conn_handle           The connection over which to execute the
+ *                                  procedure.
+ * @param handles               An array of 16-bit attribute handles to read.
+ * @param num_handles           The number of entries in the "handles" array;
+ *                                  at least two.
+ * @param cb                    The function to call to report procedure status
+ *                                  updates; null for no callback.
+ * @param cb_arg                The optional argument to pass to the callback
+ *                                  function.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int
+ble_gattc_read_mult_var(uint16_t conn_handle, const uint16_t *handles,
+                        uint8_t num_handles, ble_gatt_attr_fn *cb,
+                        void *cb_arg)
+{
+#if !MYNEWT_VAL(BLE_GATT_READ_MULT_VAR)
+    return BLE_HS_ENOTSUP;
+#endif
+
+    struct ble_gattc_proc *proc;
+    int rc;
+
+    proc = NULL;
+
+    STATS_INC(ble_gattc_stats, read_mult_var);
+
+    if (num_handles < 2 ||
+        num_handles > MYNEWT_VAL(BLE_GATT_READ_MAX_ATTRS)) {
+
+        rc = BLE_HS_EINVAL;
+        goto done;
+    }
+
+    proc = ble_gattc_proc_alloc();
+    if (proc == NULL) {
+        rc = BLE_HS_ENOMEM;
+        goto done;
+    }
+
+    proc->op = BLE_GATT_OP_READ_MULT_VAR;
+    proc->conn_handle = conn_handle;
+    memcpy(proc->read_mult.handles, handles, num_handles * sizeof *handles);
+    proc->read_mult.num_handles = num_handles;
+    proc->read_mult.cb = cb;
+    proc->read_mult.cb_arg = cb_arg;
+
+    ble_gattc_log_read_mult_var(handles, num_handles);
+
+    if (ble_gattc_proc_defer(proc)) {
+        rc = 0;
+        goto done;
+    }
+
+    rc = ble_gattc_read_mult_var_tx(proc);
+    if (rc != 0) {
+        goto done;
+    }
+
+done:
+    if (rc != 0) {
+        STATS_INC(ble_gattc_stats, read_mult_var_fail);
+    }
+
+    ble_gattc_process_status(proc, rc);
+    return rc;
+}
+
+/**
+ * Reads an arbitrary list of attribute values.  The list is split across as
+ * many Read Multiple Variable Length requests as the ATT MTU requires; values
+ * the peer omits or truncates from a response are requested again in the
+ * next one, and a plain read request is used when a single handle remains.
+ * The values are reported to the callback one at a time, in list order, each
+ * with its attribute handle.  A final callback with a status of BLE_HS_EDONE
+ * indicates the procedure is complete.  A value too long to fit in a
+ * response by itself is truncated; use ble_gattc_read_long() to retrieve it.
+ *
+ * @param conn_handle           The connection over which to execute the
+ *                                  procedure.
+ * @param handles               An array of 16-bit attribute handles to read.
+ * @param num_handles           The number of entries in the "handles" array.
+ * @param cb                    The function to call to report procedure status
+ *                                  updates; null for no callback.
+ * @param cb_arg                The optional argument to pass to the callback
+ *                                  function.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int
+ble_gattc_read_mult_list(uint16_t conn_handle, const uint16_t *handles,
+                         uint8_t num_handles, ble_gatt_attr_fn *cb,
+                         void *cb_arg)
+{
+#if !MYNEWT_VAL(BLE_GATT_READ_MULT_VAR)
+    return BLE_HS_ENOTSUP;
+#endif
+
+    struct ble_gattc_proc *proc;
+    int rc;
+
+    proc = NULL;
+
+    STATS_INC(ble_gattc_stats, read_mult_var);
+
+    if (num_handles < 1 ||
+        num_handles > MYNEWT_VAL(BLE_GATT_READ_MAX_ATTRS)) {
+
+        rc = BLE_HS_EINVAL;
+        goto done;
+    }
+
+    proc = ble_gattc_proc_alloc();
+    if (proc == NULL) {
+        rc = BLE_HS_ENOMEM;
+        goto done;
+    }
+
+    proc->op = BLE_GATT_OP_READ_MULT_VAR;
+    proc->conn_handle = conn_handle;
+    memcpy(proc->read_mult.handles, handles, num_handles * sizeof *handles);
+    proc->read_mult.num_handles = num_handles;
+    proc->read_mult.split = 1;
+    proc->read_mult.cb = cb;
+    proc->read_mult.cb_arg = cb_arg;
+
+    ble_gattc_log_read_mult_var(handles, num_handles);
+
+    if (ble_gattc_proc_defer(proc)) {
+        rc = 0;
+        goto done;
+    }
+
+    rc = ble_gattc_read_mult_var_tx(proc);
     if (rc != 0) {
         goto done;
     }
 
 done:
     if (rc != 0) {
-        STATS_INC(ble_gattc_stats, read_mult_fail);
+        STATS_INC(ble_gattc_stats, read_mult_var_fail);
     }
 
     ble_gattc_process_status(proc, rc);
@@ -3666,6 +4877,30 @@ ble_gattc_write_err(struct ble_gattc_proc *proc, int status,
     ble_gattc_write_cb(proc, status, att_handle);
 }
 
+/**
+ * Issues a write that was queued behind another procedure.  The ATT layer
+ * consumes the value even when the send fails, so a write cannot be stalled
+ * and retried; any error is reported immediately.
+ */
+static int
+ble_gattc_write_resume(struct ble_gattc_proc *proc)
+{
+    struct os_mbuf *om;
+    int rc;
+
+    om = proc->write.om;
+    proc->write.om = NULL;
+
+    rc = ble_att_clt_tx_write_req(proc->conn_handle, proc->write.att_handle,
+                                  om);
+    if (rc != 0) {
+        ble_gattc_write_cb(proc, rc, 0);
+        return rc;
+    }
+
+    return 0;
+}
+
 /**
  * Initiates GATT procedure: Write Characteristic Value.  This function
  * consumes the supplied mbuf regardless of the outcome.
@@ -3709,6 +4944,14 @@ ble_gattc_write(uint16_t conn_handle, uint16_t attr_handle,
 
     ble_gattc_log_write(attr_handle, OS_MBUF_PKTLEN(txom), 1);
 
+    if (ble_gattc_proc_defer(proc)) {
+        /* Hold on to the value until the procedure is issued. */
+        proc->write.om = txom;
+        txom = NULL;
+        rc = 0;
+        goto done;
+    }
+
     rc = ble_att_clt_tx_write_req(conn_handle, attr_handle, txom);
     txom = NULL;
     if (rc != 0) {
@@ -4056,6 +5299,11 @@ ble_gattc_write_long(uint16_t conn_handle, uint16_t attr_handle,
 
     ble_gattc_log_write_long(proc);
 
+    if (ble_gattc_proc_defer(proc)) {
+        rc = 0;
+        goto done;
+    }
+
     rc = ble_gattc_write_long_tx(proc);
     if (rc != 0) {
         goto done;
@@ -4362,6 +5610,12 @@ ble_gattc_write_reliable(uint16_t conn_handle,
     }
 
     ble_gattc_log_write_reliable(proc);
+
+    if (ble_gattc_proc_defer(proc)) {
+        rc = 0;
+        goto done;
+    }
+
     rc = ble_gattc_write_reliable_tx(proc);
     if (rc != 0) {
         goto done;
@@ -4477,6 +5731,372 @@ ble_gattc_notify(uint16_t conn_handle, uint16_t chr_val_handle)
     return rc;
 }
 
+/**
+ * Sends the current values of several characteristics in a single Multiple
+ * Handle Value Notification.  The values are read from the local attributes.
+ * The peer must support this command; the host does not check.  Each
+ * characteristic results in a BLE_GAP_EVENT_NOTIFY_TX event.
+ *
+ * @param conn_handle           The connection over which to execute the
+ *                                  procedure.
+ * @param chr_val_handles       The value attribute handles of the
+ *                                  characteristics to include in the
+ *                                  notification.
+ * @param num_handles           The number of entries in the
+ *                                  "chr_val_handles" array; at least two.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_EMSGSIZE if the values don't fit in the
+ *                                  ATT MTU;
+ *                              Other nonzero on failure.
+ */
+int
+ble_gattc_notify_multi(uint16_t conn_handle, const uint16_t *chr_val_handles,
+                       uint8_t num_handles)
+{
+#if !MYNEWT_VAL(BLE_GATT_NOTIFY_MULTI)
+    return BLE_HS_ENOTSUP;
+#endif
+
+    struct os_mbuf *txom;
+    uint16_t value_len;
+    uint8_t buf[BLE_ATT_NOTIFY_MULTI_TUPLE_SZ];
+    int off;
+    int rc;
+    int i;
+
+    txom = NULL;
+
+    STATS_INC(ble_gattc_stats, notify_multi);
+
+    ble_gattc_log_notify_multi(chr_val_handles, num_handles);
+
+    if (num_handles < 2) {
+        rc = BLE_HS_EINVAL;
+        goto done;
+    }
+
+    txom = ble_hs_mbuf_att_pkt();
+    if (txom == NULL) {
+        rc = BLE_HS_ENOMEM;
+        goto done;
+    }
+
+    for (i = 0; i < num_handles; i++) {
+        if (chr_val_handles[i] == 0) {
+            rc = BLE_HS_EINVAL;
+            goto done;
+        }
+
+        /* Write the handle and a placeholder length; the length is filled in
+         * once the value has been read.
+         */
+        off = OS_MBUF_PKTLEN(txom);
+        put_le16(buf, chr_val_handles[i]);
+        put_le16(buf + 2, 0);
+        rc = os_mbuf_append(txom, buf, sizeof buf);
+        if (rc != 0) {
+            rc = BLE_HS_ENOMEM;
+            goto done;
+        }
+
+        rc = ble_att_svr_read_handle(BLE_HS_CONN_HANDLE_NONE,
+                                     chr_val_handles[i], 0, txom, NULL);
+        if (rc != 0) {
+            /* Fatal error; application disallowed attribute read. */
+            rc = BLE_HS_EAPP;
+            goto done;
+        }
+
+        value_len = OS_MBUF_PKTLEN(txom) - off - sizeof buf;
+        put_le16(buf + 2, value_len);
+        rc = os_mbuf_copyinto(txom, off + 2, buf + 2, 2);
+        if (rc != 0) {
+            rc = BLE_HS_ENOMEM;
+            goto done;
+        }
+    }
+
+    rc = ble_att_clt_tx_notify_multi(conn_handle, txom);
+    txom = NULL;
+
+done:
+    os_mbuf_free_chain(txom);
+
+    if (rc != 0) {
+        STATS_INC(ble_gattc_stats, notify_multi_fail);
+    }
+
+    /* Tell the application that a notification transmission was attempted. */
+    for (i = 0; i < num_handles; i++) {
+        ble_gap_notify_tx_event(rc, conn_handle, chr_val_handles[i], 0);
+    }
+
+    return rc;
+}
+
+#if MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE)
+
+/*****************************************************************************
+ * $notify queue                                                             *
+ *****************************************************************************/
+
+/**
+ * Indicates whether the controller can accept another notification for the
+ * specified connection.  Lock restrictions: caller must lock ble_hs_mutex.
+ */
+static int
+ble_gattc_notify_q_txable(const struct ble_hs_conn *conn)
+{
+    BLE_HS_DBG_ASSERT(ble_hs_locked_by_cur_task());
+
+    if (MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE_MAX_PKTS) == 0) {
+        return 1;
+    }
+
+    return conn->bhc_outstanding_pkts <
+           MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE_MAX_PKTS);
+}
+
+static struct ble_gattc_notify_entry *
+ble_gattc_notify_q_find(struct ble_gattc_notify_q *q, uint16_t chr_val_handle)
+{
+    struct ble_gattc_notify_entry *entry;
+
+    STAILQ_FOREACH(entry, &q->gnq_entries, next) {
+        if (entry->chr_val_handle == chr_val_handle) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Frees all notifications pending in the specified queue without sending
+ * them.  Lock restrictions: caller must either lock ble_hs_mutex or own the
+ * connection exclusively.
+ */
+void
+ble_gattc_notify_q_clear(struct ble_gattc_notify_q *q)
+{
+    struct ble_gattc_notify_entry *entry;
+
+    while ((entry = STAILQ_FIRST(&q->gnq_entries)) != NULL) {
+        STAILQ_REMOVE_HEAD(&q->gnq_entries, next);
+        os_mbuf_free_chain(entry->om);
+        os_memblock_put(&ble_gattc_notify_entry_pool, entry);
+    }
+
+    q->gnq_count = 0;
+    q->gnq_full = 0;
+}
+
+/**
+ * Schedules the notification queues to be drained in the host parent task.
+ */
+void
+ble_gattc_notify_q_sched(void)
+{
+    os_eventq_put(ble_hs_evq_get(), &ble_gattc_notify_ev);
+}
+
+/**
+ * Sends as many queued notifications for the specified connection as the
+ * controller currently accepts.
+ *
+ * @param idx                   The index of the connection to service.
+ *
+ * @return                      0 if the connection was serviced;
+ *                              BLE_HS_ENOTCONN if there is no connection at
+ *                                  the specified index.
+ */
+static int
+ble_gattc_notify_q_tx_conn(int idx)
+{
+    struct ble_gattc_notify_entry *entry;
+    struct ble_gattc_notify_q *q;
+    struct ble_hs_conn *conn;
+    uint16_t chr_val_handle;
+    uint16_t conn_handle;
+    uint8_t count;
+    int avail;
+    int rc;
+
+    while (1) {
+        avail = 0;
+        entry = NULL;
+        count = 0;
+
+        ble_hs_lock();
+
+        conn = ble_hs_conn_find_by_idx(idx);
+        if (conn != NULL) {
+            conn_handle = conn->bhc_handle;
+            q = &conn->bhc_notify_q;
+            if (ble_gattc_notify_q_txable(conn)) {
+                entry = STAILQ_FIRST(&q->gnq_entries);
+                if (entry != NULL) {
+                    STAILQ_REMOVE_HEAD(&q->gnq_entries, next);
+                    q->gnq_count--;
+                }
+            }
+
+            if (entry == NULL && q->gnq_full &&
+                q->gnq_count < MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE_LEN)) {
+
+                q->gnq_full = 0;
+                count = q->gnq_count;
+                avail = 1;
+            }
+        } else {
+            /* Silence some spurious gcc warnings. */
+            conn_handle = BLE_HS_CONN_HANDLE_NONE;
+        }
+
+        ble_hs_unlock();
+
+        if (conn == NULL) {
+            return BLE_HS_ENOTCONN;
+        }
+
+        if (entry == NULL) {
+            break;
+        }
+
+        chr_val_handle = entry->chr_val_handle;
+        rc = ble_gattc_notify_custom(conn_handle, chr_val_handle, entry->om);
+        os_memblock_put(&ble_gattc_notify_entry_pool, entry);
+
+        ble_gap_notify_tx_event(rc, conn_handle, chr_val_handle, 0);
+    }
+
+    if (avail) {
+        ble_gap_notify_queue_event(conn_handle, count, 0);
+    }
+
+    return 0;
+}
+
+static void
+ble_gattc_notify_q_event(struct os_event *ev)
+{
+    int i;
+
+    for (i = 0; ; i++) {
+        if (ble_gattc_notify_q_tx_conn(i) != 0) {
+            break;
+        }
+    }
+}
+
+/**
+ * Queues a characteristic notification for transmission from the host parent
+ * task.  If a notification for the same characteristic is already queued on
+ * the connection, its content is replaced and it keeps its place in the
+ * queue; only the most recent value is sent.  The queue is drained as fast
+ * as the controller accepts ACL data, so bursts of updates go out
+ * back-to-back rather than one per application wakeup.
+ *
+ * This function consumes the supplied mbuf regardless of the outcome.  Each
+ * queued notification results in a BLE_GAP_EVENT_NOTIFY_TX event when it is
+ * actually sent.
+ *
+ * @param conn_handle           The connection over which to send the
+ *                                  notification.
+ * @param chr_val_handle        The attribute handle to indicate in the
+ *                                  outgoing notification.
+ * @param txom                  The notification payload; NULL to read the
+ *                                  characteristic value when the notification
+ *                                  is sent.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_ENOTCONN if there is no such
+ *                                  connection;
+ *                              BLE_HS_EBUSY if the connection's queue is
+ *                                  full.  The application is notified with a
+ *                                  BLE_GAP_EVENT_NOTIFY_QUEUE event, and again
+ *                                  when the queue has room;
+ *                              Other nonzero on failure.
+ */
+int
+ble_gattc_notify_queue(uint16_t conn_handle, uint16_t chr_val_handle,
+                       struct os_mbuf *txom)
+{
+    struct ble_gattc_notify_entry *entry;
+    struct ble_gattc_notify_q *q;
+    struct ble_hs_conn *conn;
+    struct os_mbuf *old_om;
+    uint8_t count;
+    int full;
+    int rc;
+
+    old_om = NULL;
+    full = 0;
+    count = 0;
+
+    ble_hs_lock();
+
+    conn = ble_hs_conn_find(conn_handle);
+    if (conn == NULL) {
+        rc = BLE_HS_ENOTCONN;
+        goto done;
+    }
+    q = &conn->bhc_notify_q;
+
+    entry = ble_gattc_notify_q_find(q, chr_val_handle);
+    if (entry != NULL) {
+        /* Coalesce with the notification that is already queued. */
+        STATS_INC(ble_gattc_stats, notify_coalesce);
+        old_om = entry->om;
+        entry->om = txom;
+        txom = NULL;
+        rc = 0;
+        goto done;
+    }
+
+    if (q->gnq_count >= MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE_LEN)) {
+        entry = NULL;
+    } else {
+        entry = os_memblock_get(&ble_gattc_notify_entry_pool);
+    }
+    if (entry == NULL) {
+        STATS_INC(ble_gattc_stats, notify_queue_full);
+        if (!q->gnq_full) {
+            q->gnq_full = 1;
+            count = q->gnq_count;
+            full = 1;
+        }
+        rc = BLE_HS_EBUSY;
+        goto done;
+    }
+
+    entry->chr_val_handle = chr_val_handle;
+    entry->om = txom;
+    txom = NULL;
+    STAILQ_INSERT_TAIL(&q->gnq_entries, entry, next);
+    q->gnq_count++;
+    rc = 0;
+
+done:
+    ble_hs_unlock();
+
+    os_mbuf_free_chain(old_om);
+    os_mbuf_free_chain(txom);
+
+    if (full) {
+        ble_gap_notify_queue_event(conn_handle, count, 1);
+    }
+
+    if (rc == 0) {
+        ble_gattc_notify_q_sched();
+    }
+
+    return rc;
+}
+
+#endif
+
 /*****************************************************************************
  * $indicate                                                                 *
  *****************************************************************************/
@@ -4659,7 +6279,7 @@ ble_gattc_rx_err(uint16_t conn_handle, uint16_t handle, uint16_t status)
         if (err_cb != NULL) {
             err_cb(proc, BLE_HS_ERR_ATT_BASE + status, handle);
         }
-        ble_gattc_proc_free(proc);
+        ble_gattc_process_status(proc, BLE_HS_EDONE);
     }
 }
 
@@ -4932,6 +6552,34 @@ ble_gattc_rx_read_mult_rsp(uint16_t conn_handle, int status,
     }
 }
 
+/**
+ * Dispatches an incoming ATT read-multiple-variable-length response to the
+ * appropriate active GATT procedure.
+ */
+void
+ble_gattc_rx_read_mult_var_rsp(uint16_t conn_handle, int status,
+                               struct os_mbuf **om)
+{
+#if !NIMBLE_BLE_ATT_CLT_READ_MULT_VAR
+    return;
+#endif
+
+    struct ble_gattc_proc *proc;
+    int rc;
+
+    proc = ble_gattc_extract_first_by_conn_op(conn_handle,
+                                              BLE_GATT_OP_READ_MULT_VAR);
+    if (proc != NULL) {
+        if (status != 0) {
+            ble_gattc_read_mult_var_cb(proc, status, 0, NULL);
+            rc = BLE_HS_EDONE;
+        } else {
+            rc = ble_gattc_read_mult_var_rx(proc, om);
+        }
+        ble_gattc_process_status(proc, rc);
+    }
+}
+
 /**
  * Dispatches an incoming ATT write-response to the appropriate active GATT
  * procedure.
@@ -5068,6 +6716,28 @@ ble_gattc_init(void)
         }
     }
 
+#if MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE)
+    rc = os_mempool_init(&ble_gattc_notify_entry_pool,
+                         MYNEWT_VAL(BLE_MAX_CONNECTIONS) *
+                             MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE_LEN),
+                         sizeof (struct ble_gattc_notify_entry),
+                         ble_gattc_notify_entry_mem,
+                         "ble_gattc_notify_entry_pool");
+    if (rc != 0) {
+        return rc;
+    }
+
+    memset(&ble_gattc_notify_ev, 0, sizeof ble_gattc_notify_ev);
+    ble_gattc_notify_ev.ev_cb = ble_gattc_notify_q_event;
+#endif
+
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    STAILQ_INIT(&ble_gattc_cache_procs);
+
+    memset(&ble_gattc_cache_ev, 0, sizeof ble_gattc_cache_ev);
+    ble_gattc_cache_ev.ev_cb = ble_gattc_cache_event;
+#endif
+
     rc = stats_init_and_reg(
         STATS_HDR(ble_gattc_stats), STATS_SIZE_INIT_PARMS(ble_gattc_stats,
         STATS_SIZE_32), STATS_NAME_INIT_PARMS(ble_gattc_stats), "ble_gattc");
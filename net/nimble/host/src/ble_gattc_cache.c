@@ -0,0 +1,462 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * GATT client discovery cache.
+ *
+ * The results of discovery procedures against a bonded peer are persisted as
+ * BLE_STORE_OBJ_TYPE_GATT records, keyed by the peer's identity address.  A
+ * record is written for each discovered service, characteristic, and
+ * descriptor.  Completion is tracked separately, so that a cached range is
+ * only reported if the full range was discovered:
+ *     o A BLE_STORE_GATT_ATTR_DB record indicates the service list is
+ *       complete.
+ *     o A service's complete flag indicates its characteristics are cached.
+ *     o A characteristic's complete flag indicates its descriptors up to
+ *       end_handle are cached.
+ *
+ * The whole cache for a peer is discarded when the peer indicates its Service
+ * Changed characteristic, or when its bond is deleted.
+ */
+
+#include <string.h>
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+
+#include "host/ble_store.h"
+#include "ble_hs_priv.h"
+
+#define BLE_GATTC_CACHE_SVC_CHANGED_UUID16      0x2a05
+
+/**
+ * Retrieves the cached record of the specified kind with the lowest handle in
+ * the range (prev_handle, end_handle].
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_ENOENT if there is no such record;
+ *                              Other nonzero on store error.
+ */
+static int
+ble_gattc_cache_find_next(const ble_addr_t *peer_addr, uint8_t attr_type,
+                          uint16_t prev_handle, uint16_t end_handle,
+                          struct ble_store_value_gatt *out_value)
+{
+    struct ble_store_value_gatt cur;
+    struct ble_store_key_gatt key;
+    int found;
+    int rc;
+
+    memset(&key, 0, sizeof key);
+    key.peer_addr = *peer_addr;
+    key.attr_type = attr_type;
+
+    found = 0;
+    while (1) {
+        rc = ble_store_read_gatt(&key, &cur);
+        if (rc == BLE_HS_ENOENT) {
+            break;
+        }
+        if (rc != 0) {
+            return rc;
+        }
+        key.idx++;
+
+        if (cur.handle > prev_handle && cur.handle <= end_handle) {
+            if (!found || cur.handle < out_value->handle) {
+                *out_value = cur;
+                found = 1;
+            }
+        }
+    }
+
+    if (!found) {
+        return BLE_HS_ENOENT;
+    }
+
+    return 0;
+}
+
+/**
+ * Retrieves the cached characteristic with the specified value handle.
+ */
+static int
+ble_gattc_cache_find_chr_val(const ble_addr_t *peer_addr, uint16_t val_handle,
+                             struct ble_store_value_gatt *out_value)
+{
+    struct ble_store_key_gatt key;
+    int rc;
+
+    memset(&key, 0, sizeof key);
+    key.peer_addr = *peer_addr;
+    key.attr_type = BLE_STORE_GATT_ATTR_CHR;
+
+    while (1) {
+        rc = ble_store_read_gatt(&key, out_value);
+        if (rc != 0) {
+            return rc;
+        }
+        if (out_value->val_handle == val_handle) {
+            return 0;
+        }
+        key.idx++;
+    }
+}
+
+static int
+ble_gattc_cache_write(const ble_addr_t *peer_addr, uint8_t attr_type,
+                      struct ble_store_value_gatt *value)
+{
+    value->peer_addr = *peer_addr;
+    value->attr_type = attr_type;
+
+    return ble_store_write_gatt(value);
+}
+
+/**
+ * Determines whether discovery results for the specified connection can be
+ * cached.  Only bonded peers are cached, as the identity address is the only
+ * stable key for a peer's database.
+ *
+ * @param conn_handle           The connection to query.
+ * @param out_peer_addr         On success, the peer's identity address gets
+ *                                  written here.
+ *
+ * @return                      0 if the peer is cacheable;
+ *                              BLE_HS_ENOTCONN if there is no such
+ *                                  connection;
+ *                              BLE_HS_ENOENT if the peer is not bonded.
+ */
+int
+ble_gattc_cache_peer(uint16_t conn_handle, ble_addr_t *out_peer_addr)
+{
+    struct ble_store_value_sec value_sec;
+    struct ble_store_key_sec key_sec;
+    struct ble_gap_conn_desc desc;
+    int rc;
+
+    rc = ble_gap_conn_find(conn_handle, &desc);
+    if (rc != 0) {
+        return rc;
+    }
+
+    memset(&key_sec, 0, sizeof key_sec);
+    key_sec.peer_addr = desc.peer_id_addr;
+
+    rc = ble_store_read_peer_sec(&key_sec, &value_sec);
+    if (rc != 0) {
+        return rc;
+    }
+
+    *out_peer_addr = desc.peer_id_addr;
+    return 0;
+}
+
+int
+ble_gattc_cache_add_svc(const ble_addr_t *peer_addr,
+                        const struct ble_gatt_svc *svc)
+{
+    struct ble_store_value_gatt value;
+
+    memset(&value, 0, sizeof value);
+    value.handle = svc->start_handle;
+    value.end_handle = svc->end_handle;
+    value.uuid = svc->uuid;
+
+    return ble_gattc_cache_write(peer_addr, BLE_STORE_GATT_ATTR_SVC, &value);
+}
+
+int
+ble_gattc_cache_add_chr(const ble_addr_t *peer_addr,
+                        const struct ble_gatt_chr *chr)
+{
+    struct ble_store_value_gatt value;
+
+    memset(&value, 0, sizeof value);
+    value.handle = chr->def_handle;
+    value.val_handle = chr->val_handle;
+    value.properties = chr->properties;
+    value.uuid = chr->uuid;
+
+    return ble_gattc_cache_write(peer_addr, BLE_STORE_GATT_ATTR_CHR, &value);
+}
+
+int
+ble_gattc_cache_add_dsc(const ble_addr_t *peer_addr,
+                        const struct ble_gatt_dsc *dsc)
+{
+    struct ble_store_value_gatt value;
+
+    memset(&value, 0, sizeof value);
+    value.handle = dsc->handle;
+    value.uuid = dsc->uuid;
+
+    return ble_gattc_cache_write(peer_addr, BLE_STORE_GATT_ATTR_DSC, &value);
+}
+
+/**
+ * Records that the peer's complete service list has been cached.
+ */
+int
+ble_gattc_cache_svcs_done(const ble_addr_t *peer_addr)
+{
+    struct ble_store_value_gatt value;
+
+    memset(&value, 0, sizeof value);
+    value.handle = 0xffff;
+    value.complete = 1;
+
+    return ble_gattc_cache_write(peer_addr, BLE_STORE_GATT_ATTR_DB, &value);
+}
+
+/**
+ * Records that characteristic discovery over the specified range completed.
+ * Every cached service lying entirely within the range is marked complete.
+ */
+int
+ble_gattc_cache_chrs_done(const ble_addr_t *peer_addr, uint16_t start_handle,
+                          uint16_t end_handle)
+{
+    struct ble_store_value_gatt value;
+    uint16_t prev_handle;
+    int rc;
+
+    prev_handle = start_handle - 1;
+    while (1) {
+        rc = ble_gattc_cache_find_next(peer_addr, BLE_STORE_GATT_ATTR_SVC,
+                                       prev_handle, end_handle, &value);
+        if (rc == BLE_HS_ENOENT) {
+            return 0;
+        }
+        if (rc != 0) {
+            return rc;
+        }
+        prev_handle = value.handle;
+
+        if (value.end_handle <= end_handle && !value.complete) {
+            value.complete = 1;
+            rc = ble_store_write_gatt(&value);
+            if (rc != 0) {
+                return rc;
+            }
+        }
+    }
+}
+
+/**
+ * Records that descriptor discovery for the specified characteristic
+ * completed, covering handles up to end_handle.
+ */
+int
+ble_gattc_cache_dscs_done(const ble_addr_t *peer_addr,
+                          uint16_t chr_val_handle, uint16_t end_handle)
+{
+    struct ble_store_value_gatt value;
+    int rc;
+
+    rc = ble_gattc_cache_find_chr_val(peer_addr, chr_val_handle, &value);
+    if (rc != 0) {
+        return rc;
+    }
+
+    value.end_handle = end_handle;
+    value.complete = 1;
+    return ble_store_write_gatt(&value);
+}
+
+/**
+ * Indicates whether the peer's complete service list is cached.
+ */
+int
+ble_gattc_cache_has_svcs(const ble_addr_t *peer_addr)
+{
+    struct ble_store_value_gatt value;
+    struct ble_store_key_gatt key;
+    int rc;
+
+    memset(&key, 0, sizeof key);
+    key.peer_addr = *peer_addr;
+    key.attr_type = BLE_STORE_GATT_ATTR_DB;
+
+    rc = ble_store_read_gatt(&key, &value);
+    return rc == 0 && value.complete;
+}
+
+/**
+ * Indicates whether all characteristics in the specified range are cached.
+ * This is only the case if the range lies within a single service whose
+ * characteristics have been fully discovered.
+ */
+int
+ble_gattc_cache_has_chrs(const ble_addr_t *peer_addr, uint16_t start_handle,
+                         uint16_t end_handle)
+{
+    struct ble_store_value_gatt value;
+    uint16_t prev_handle;
+    int rc;
+
+    prev_handle = 0;
+    while (1) {
+        rc = ble_gattc_cache_find_next(peer_addr, BLE_STORE_GATT_ATTR_SVC,
+                                       prev_handle, start_handle, &value);
+        if (rc != 0) {
+            return 0;
+        }
+        prev_handle = value.handle;
+
+        if (value.complete && end_handle <= value.end_handle) {
+            return 1;
+        }
+    }
+}
+
+/**
+ * Indicates whether all descriptors of the specified characteristic, up to
+ * end_handle, are cached.
+ */
+int
+ble_gattc_cache_has_dscs(const ble_addr_t *peer_addr, uint16_t chr_val_handle,
+                         uint16_t end_handle)
+{
+    struct ble_store_value_gatt value;
+    int rc;
+
+    rc = ble_gattc_cache_find_chr_val(peer_addr, chr_val_handle, &value);
+    return rc == 0 && value.complete && end_handle <= value.end_handle;
+}
+
+/**
+ * Retrieves the cached service with the lowest start handle greater than
+ * prev_handle.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_ENOENT if there are no more services;
+ *                              Other nonzero on store error.
+ */
+int
+ble_gattc_cache_next_svc(const ble_addr_t *peer_addr, uint16_t prev_handle,
+                         struct ble_gatt_svc *out_svc)
+{
+    struct ble_store_value_gatt value;
+    int rc;
+
+    rc = ble_gattc_cache_find_next(peer_addr, BLE_STORE_GATT_ATTR_SVC,
+                                   prev_handle, 0xffff, &value);
+    if (rc != 0) {
+        return rc;
+    }
+
+    out_svc->start_handle = value.handle;
+    out_svc->end_handle = value.end_handle;
+    out_svc->uuid = value.uuid;
+    return 0;
+}
+
+/**
+ * Retrieves the cached characteristic with the lowest definition handle in the
+ * range (prev_handle, end_handle].
+ */
+int
+ble_gattc_cache_next_chr(const ble_addr_t *peer_addr, uint16_t prev_handle,
+                         uint16_t end_handle, struct ble_gatt_chr *out_chr)
+{
+    struct ble_store_value_gatt value;
+    int rc;
+
+    rc = ble_gattc_cache_find_next(peer_addr, BLE_STORE_GATT_ATTR_CHR,
+                                   prev_handle, end_handle, &value);
+    if (rc != 0) {
+        return rc;
+    }
+
+    out_chr->def_handle = value.handle;
+    out_chr->val_handle = value.val_handle;
+    out_chr->properties = value.properties;
+    out_chr->uuid = value.uuid;
+    return 0;
+}
+
+/**
+ * Retrieves the cached descriptor with the lowest handle in the range
+ * (prev_handle, end_handle].
+ */
+int
+ble_gattc_cache_next_dsc(const ble_addr_t *peer_addr, uint16_t prev_handle,
+                         uint16_t end_handle, struct ble_gatt_dsc *out_dsc)
+{
+    struct ble_store_value_gatt value;
+    int rc;
+
+    rc = ble_gattc_cache_find_next(peer_addr, BLE_STORE_GATT_ATTR_DSC,
+                                   prev_handle, end_handle, &value);
+    if (rc != 0) {
+        return rc;
+    }
+
+    out_dsc->handle = value.handle;
+    out_dsc->uuid = value.uuid;
+    return 0;
+}
+
+/**
+ * Discards all cached attributes of the specified peer.
+ */
+int
+ble_gattc_cache_clear(const ble_addr_t *peer_addr)
+{
+    union ble_store_key key;
+
+    memset(&key, 0, sizeof key);
+    key.gatt.peer_addr = *peer_addr;
+
+    return ble_store_util_delete_all(BLE_STORE_OBJ_TYPE_GATT, &key);
+}
+
+/**
+ * Called when an indication is received.  If the indicated attribute is the
+ * peer's Service Changed characteristic, the peer's cache is discarded.
+ */
+void
+ble_gattc_cache_rx_indicate(uint16_t conn_handle, uint16_t attr_handle)
+{
+    struct ble_store_value_gatt value;
+    ble_addr_t peer_addr;
+    int rc;
+
+    rc = ble_gattc_cache_peer(conn_handle, &peer_addr);
+    if (rc != 0) {
+        return;
+    }
+
+    rc = ble_gattc_cache_find_chr_val(&peer_addr, attr_handle, &value);
+    if (rc != 0) {
+        return;
+    }
+
+    if (ble_uuid_cmp(&value.uuid.u,
+                     BLE_UUID16_DECLARE(BLE_GATTC_CACHE_SVC_CHANGED_UUID16))) {
+        return;
+    }
+
+    BLE_HS_LOG(INFO, "GATT cache: peer database changed; invalidating\n");
+    ble_gattc_cache_clear(&peer_addr);
+}
+
+#endif
@@ -1447,6 +1447,11 @@ ble_gatts_chr_updated(uint16_t chr_val_handle)
     int rc;
     int i;
 
+#if MYNEWT_VAL(BLE_ATT_SVR_READ_CACHE)
+    /* A long read in progress must not return a mix of old and new data. */
+    ble_att_svr_read_cache_invalidate(chr_val_handle);
+#endif
+
     /* Determine if notifications or indications are allowed for this
      * characteristic.  If not, return immediately.
      */
@@ -1748,13 +1753,13 @@ ble_gatts_find_svc_chr_attr(const ble_uuid_t *svc_uuid, const ble_uuid_t *chr_uu
         return BLE_HS_EUNKNOWN;
     }
 
-    cur = STAILQ_NEXT(att_svc, ha_next);
+    cur = ble_att_svr_next(att_svc);
     while (1) {
         if (cur == NULL) {
             /* Reached end of attribute list without a match. */
             return BLE_HS_ENOENT;
         }
-        next = STAILQ_NEXT(cur, ha_next);
+        next = ble_att_svr_next(cur);
 
         if (cur->ha_handle_id == svc_entry->end_group_handle) {
             /* Reached end of service without a match. */
@@ -1875,7 +1880,7 @@ ble_gatts_find_dsc(const ble_uuid_t *svc_uuid, const ble_uuid_t *chr_uuid,
         return rc;
     }
 
-    cur = STAILQ_NEXT(att_chr, ha_next);
+    cur = ble_att_svr_next(att_chr);
     while (1) {
         if (cur == NULL) {
             /* Reached end of attribute list without a match. */
@@ -1899,7 +1904,7 @@ ble_gatts_find_dsc(const ble_uuid_t *svc_uuid, const ble_uuid_t *chr_uuid,
                 return 0;
             }
         }
-        cur = STAILQ_NEXT(cur, ha_next);
+        cur = ble_att_svr_next(cur);
     }
 }
 
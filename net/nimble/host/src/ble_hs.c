@@ -102,9 +102,10 @@ STATS_NAME_START(ble_hs_stats)
     STATS_NAME(ble_hs_stats, hci_timeout)
     STATS_NAME(ble_hs_stats, reset)
     STATS_NAME(ble_hs_stats, sync)
+    STATS_NAME(ble_hs_stats, acl_tx_queued)
 STATS_NAME_END(ble_hs_stats)
 
-static struct os_eventq *
+struct os_eventq *
 ble_hs_evq_get(void)
 {
     return ble_hs_evq;
@@ -264,6 +265,9 @@ ble_hs_reset(void)
         return rc;
     }
 
+    /* Commands queued before the reset will never be acknowledged. */
+    ble_hs_hci_async_flush();
+
     ble_hs_clear_data_queue(&ble_hs_tx_q);
     ble_hs_clear_data_queue(&ble_hs_rx_q);
 
@@ -313,6 +317,11 @@ ble_hs_timer_exp(struct os_event *ev)
 
     ticks_until_next = ble_hs_conn_timer();
     ble_hs_timer_sched(ticks_until_next);
+
+#if MYNEWT_VAL(BLE_GAP_CONN_POLICY)
+    ticks_until_next = ble_gap_policy_timer();
+    ble_hs_timer_sched(ticks_until_next);
+#endif
 }
 
 static void
@@ -494,6 +503,17 @@ ble_hs_rx_data(struct os_mbuf *om, void *arg)
 {
     int rc;
 
+#if MYNEWT_VAL(BLE_HS_DIRECT_ACL)
+    /* Already in the host task; process the packet now rather than posting
+     * an event to ourselves.  Anything still queued goes first to preserve
+     * ordering.
+     */
+    if (os_started() && ble_hs_is_parent_task()) {
+        ble_hs_process_rx_data_queue();
+        return ble_hs_hci_evt_acl_process(om);
+    }
+#endif
+
     rc = os_mqueue_put(&ble_hs_rx_q, ble_hs_evq_get(), om);
     if (rc != 0) {
         os_mbuf_free_chain(om);
@@ -517,11 +537,21 @@ ble_hs_tx_data(struct os_mbuf *om)
 {
     int rc;
 
+#if MYNEWT_VAL(BLE_HS_DIRECT_ACL)
+    /* The transport transmit is a direct enqueue onto the controller's
+     * packet queue; no need to bounce through the host task.
+     */
+    rc = ble_hci_trans_hs_acl_tx(om);
+    if (rc != 0) {
+        return BLE_HS_EOS;
+    }
+#else
     rc = os_mqueue_put(&ble_hs_tx_q, ble_hs_evq_get(), om);
     if (rc != 0) {
         os_mbuf_free_chain(om);
         return BLE_HS_EOS;
     }
+#endif
 
     return 0;
 }
@@ -549,6 +579,9 @@ ble_hs_init(void)
                          "ble_hs_hci_ev_pool");
     SYSINIT_PANIC_ASSERT(rc == 0);
 
+    rc = ble_hs_mbuf_init();
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
     /* These get initialized here to allow unit tests to run without a zeroed
      * bss.
      */
@@ -595,6 +628,9 @@ ble_hs_init(void)
 
     rc = os_mutex_init(&ble_hs_mutex);
     SYSINIT_PANIC_ASSERT(rc == 0);
+#if MYNEWT_VAL(OS_MUTEX_STATS)
+    os_mutex_register(&ble_hs_mutex, "ble_hs");
+#endif
 
 #if MYNEWT_VAL(BLE_HS_DEBUG)
     ble_hs_dbg_mutex_locked = 0;
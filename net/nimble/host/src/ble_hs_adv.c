@@ -23,11 +23,6 @@
 #include "host/ble_hs_adv.h"
 #include "ble_hs_priv.h"
 
-struct find_field_data {
-    uint8_t type;
-    const struct ble_hs_adv_field *field;
-};
-
 static ble_uuid16_t ble_hs_adv_uuids16[BLE_HS_ADV_MAX_FIELD_SZ / 2];
 static ble_uuid32_t ble_hs_adv_uuids32[BLE_HS_ADV_MAX_FIELD_SZ / 4];
 static ble_uuid128_t ble_hs_adv_uuids128[BLE_HS_ADV_MAX_FIELD_SZ / 16];
@@ -642,64 +637,117 @@ ble_hs_adv_parse_fields(struct ble_hs_adv_fields *adv_fields, uint8_t *src,
     return 0;
 }
 
+/**
+ * Prepares an iterator over raw advertising data.
+ *
+ * @param iter                  The iterator to initialize.
+ * @param data                  The advertising data; it must remain valid
+ *                                  while the iterator and the fields it
+ *                                  returns are in use.
+ * @param length                The length of the advertising data.
+ */
+void
+ble_hs_adv_iter_init(struct ble_hs_adv_iter *iter, const uint8_t *data,
+                     uint8_t length)
+{
+    iter->data = data;
+    iter->length = length;
+}
+
+/**
+ * Retrieves the next field of the advertising data.  A zero length field
+ * marks the end of the significant part of the data, as does the end of the
+ * data itself.
+ *
+ * @param iter                  The iterator.
+ * @param out_field             On success, points to the field.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_ENOENT if there are no more fields;
+ *                              BLE_HS_EMSGSIZE if the next field runs past
+ *                                  the end of the data.
+ */
 int
-ble_hs_adv_parse(const uint8_t *data, uint8_t length,
-                 ble_hs_adv_parse_func_t func, void *user_data)
+ble_hs_adv_iter_next(struct ble_hs_adv_iter *iter,
+                     const struct ble_hs_adv_field **out_field)
 {
     const struct ble_hs_adv_field *field;
 
-    while (length > 1) {
-        field = (const void *) data;
-
-        if (field->length >= length) {
-            return BLE_HS_EBADDATA;
-        }
-
-        if (func(field, user_data) == 0) {
-            return 0;
-        }
+    if (iter->length < 1 || iter->data[0] == 0) {
+        return BLE_HS_ENOENT;
+    }
 
-        length -= 1 + field->length;
-        length += 1 + field->length;
+    field = (const void *)iter->data;
+    if (field->length >= iter->length) {
+        return BLE_HS_EMSGSIZE;
     }
 
+    iter->data += 1 + field->length;
+    iter->length -= 1 + field->length;
+
+    *out_field = field;
     return 0;
 }
 
-static int
-find_field_func(const struct ble_hs_adv_field *field, void *user_data)
+int
+ble_hs_adv_parse(const uint8_t *data, uint8_t length,
+                 ble_hs_adv_parse_func_t func, void *user_data)
 {
-    struct find_field_data *ffd = user_data;
-
-    if (field->type != ffd->type) {
-        return BLE_HS_EAGAIN;
-    }
+    const struct ble_hs_adv_field *field;
+    struct ble_hs_adv_iter iter;
+    int rc;
 
-    ffd->field = field;
+    ble_hs_adv_iter_init(&iter, data, length);
+    while (1) {
+        rc = ble_hs_adv_iter_next(&iter, &field);
+        switch (rc) {
+        case 0:
+            break;
+        case BLE_HS_ENOENT:
+            return 0;
+        default:
+            return BLE_HS_EBADDATA;
+        }
 
-    return 0;
+        if (func(field, user_data) == 0) {
+            return 0;
+        }
+    }
 }
 
+/**
+ * Finds the first field of the specified type in raw advertising data.
+ *
+ * @param type                  The field type to find; one of the
+ *                                  BLE_HS_ADV_TYPE_[...] values.
+ * @param data                  The advertising data.
+ * @param length                The length of the advertising data.
+ * @param out                   On success, points to the field within the
+ *                                  advertising data.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_ENOENT if there is no such field;
+ *                              BLE_HS_EMSGSIZE if the data is malformed
+ *                                  before the field is found.
+ */
 int
 ble_hs_adv_find_field(uint8_t type, const uint8_t *data, uint8_t length,
                       const struct ble_hs_adv_field **out)
 {
+    const struct ble_hs_adv_field *field;
+    struct ble_hs_adv_iter iter;
     int rc;
-    struct find_field_data ffd = {
-            .type = type,
-            .field = NULL,
-    };
 
-    rc = ble_hs_adv_parse(data, length, find_field_func, &ffd);
-    if (rc != 0) {
-        return rc;
-    }
+    ble_hs_adv_iter_init(&iter, data, length);
+    while (1) {
+        rc = ble_hs_adv_iter_next(&iter, &field);
+        if (rc != 0) {
+            return rc;
+        }
 
-    if (!ffd.field) {
-        return BLE_HS_ENOENT;
+        if (field->type == type) {
+            *out = field;
+            return 0;
+        }
     }
-
-    *out = ffd.field;
-
-    return 0;
 }
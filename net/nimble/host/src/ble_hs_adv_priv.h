@@ -26,8 +26,6 @@ extern "C" {
 
 int ble_hs_adv_set_flat(uint8_t type, int data_len, const void *data,
                         uint8_t *dst, uint8_t *dst_len, uint8_t max_len);
-int ble_hs_adv_find_field(uint8_t type, const uint8_t *data, uint8_t length,
-                          const struct ble_hs_adv_field **out);
 
 #ifdef __cplusplus
 }
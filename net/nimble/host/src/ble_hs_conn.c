@@ -27,7 +27,22 @@
 /** At least three channels required per connection (sig, att, sm). */
 #define BLE_HS_CONN_MIN_CHANS       3
 
+/** Number of slots in each connection lookup table. */
+#define BLE_HS_CONN_TBL_SZ          MYNEWT_VAL(BLE_MAX_CONNECTIONS)
+
 static SLIST_HEAD(, ble_hs_conn) ble_hs_conns;
+
+/**
+ * Open-addressed lookup tables, keyed by connection handle and by peer
+ * address.  Each table has one slot per connection, so a free slot always
+ * exists on insert.  Collisions are resolved with linear probing.
+ * Controllers typically assign handles sequentially, so lookups by handle
+ * almost always hit the first slot probed.
+ */
+static struct ble_hs_conn *ble_hs_conn_handle_tbl[BLE_HS_CONN_TBL_SZ];
+static struct ble_hs_conn *ble_hs_conn_addr_tbl[BLE_HS_CONN_TBL_SZ];
+
+typedef int ble_hs_conn_hash_fn(const struct ble_hs_conn *conn);
 static struct os_mempool ble_hs_conn_pool;
 
 static os_membuf_t ble_hs_conn_elem_mem[
@@ -37,6 +52,99 @@ static os_membuf_t ble_hs_conn_elem_mem[
 
 static const uint8_t ble_hs_conn_null_addr[6];
 
+static int
+ble_hs_conn_handle_hash(uint16_t conn_handle)
+{
+    return conn_handle % BLE_HS_CONN_TBL_SZ;
+}
+
+static int
+ble_hs_conn_addr_hash(const ble_addr_t *addr)
+{
+    uint32_t hash;
+    int i;
+
+    /* The address type is excluded; it changes when the peer's identity is
+     * resolved.
+     */
+    hash = 0;
+    for (i = 0; i < sizeof addr->val; i++) {
+        hash = hash * 31 + addr->val[i];
+    }
+
+    return hash % BLE_HS_CONN_TBL_SZ;
+}
+
+static int
+ble_hs_conn_hash_by_handle(const struct ble_hs_conn *conn)
+{
+    return ble_hs_conn_handle_hash(conn->bhc_handle);
+}
+
+static int
+ble_hs_conn_hash_by_addr(const struct ble_hs_conn *conn)
+{
+    return ble_hs_conn_addr_hash(&conn->bhc_peer_addr);
+}
+
+static void
+ble_hs_conn_tbl_insert(struct ble_hs_conn **tbl, ble_hs_conn_hash_fn *hash_fn,
+                       struct ble_hs_conn *conn)
+{
+    int idx;
+    int i;
+
+    idx = hash_fn(conn);
+    for (i = 0; i < BLE_HS_CONN_TBL_SZ; i++) {
+        if (tbl[idx] == NULL) {
+            tbl[idx] = conn;
+            return;
+        }
+
+        idx = (idx + 1) % BLE_HS_CONN_TBL_SZ;
+    }
+
+    /* There are as many slots as there are connections. */
+    BLE_HS_DBG_ASSERT(0);
+}
+
+static void
+ble_hs_conn_tbl_remove(struct ble_hs_conn **tbl, ble_hs_conn_hash_fn *hash_fn,
+                       struct ble_hs_conn *conn)
+{
+    struct ble_hs_conn *moved;
+    int idx;
+    int i;
+
+    idx = hash_fn(conn);
+    for (i = 0; i < BLE_HS_CONN_TBL_SZ; i++) {
+        if (tbl[idx] == conn) {
+            break;
+        }
+
+        idx = (idx + 1) % BLE_HS_CONN_TBL_SZ;
+    }
+    if (i >= BLE_HS_CONN_TBL_SZ) {
+        return;
+    }
+
+    tbl[idx] = NULL;
+
+    /* Reinsert the rest of the probe sequence so that no lookup stops early
+     * at the slot just emptied.
+     */
+    for (i = 1; i < BLE_HS_CONN_TBL_SZ; i++) {
+        idx = (idx + 1) % BLE_HS_CONN_TBL_SZ;
+        moved = tbl[idx];
+        if (moved == NULL) {
+            break;
+        }
+
+        tbl[idx] = NULL;
+        ble_hs_conn_tbl_insert(tbl, hash_fn, moved);
+    }
+}
+
 int
 ble_hs_conn_can_alloc(void)
 {
@@ -140,7 +248,18 @@ ble_hs_conn_alloc(uint16_t conn_handle)
     memset(conn, 0, sizeof *conn);
     conn->bhc_handle = conn_handle;
 
+    /* Until the controller reports a data length change, assume the
+     * default LL payload size.
+     */
+    conn->bhc_max_tx_octets = BLE_HCI_SET_DATALEN_TX_OCTETS_MIN;
+
     SLIST_INIT(&conn->bhc_channels);
+#if MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE)
+    STAILQ_INIT(&conn->bhc_notify_q.gnq_entries);
+#endif
+#if MYNEWT_VAL(BLE_HS_ACL_TX_SCHED)
+    STAILQ_INIT(&conn->bhc_tx_q);
+#endif
 
     chan = ble_att_create_chan(conn_handle);
     if (chan == NULL) {
@@ -212,6 +331,15 @@ ble_hs_conn_free(struct ble_hs_conn *conn)
     }
 
     ble_att_svr_prep_clear(&conn->bhc_att_svr.basc_prep_list);
+#if MYNEWT_VAL(BLE_ATT_SVR_READ_CACHE)
+    ble_att_svr_read_cache_clear(&conn->bhc_att_svr);
+#endif
+#if MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE)
+    ble_gattc_notify_q_clear(&conn->bhc_notify_q);
+#endif
+#if MYNEWT_VAL(BLE_HS_ACL_TX_SCHED)
+    ble_hs_hci_acl_tx_conn_free(conn);
+#endif
 
     while ((chan = SLIST_FIRST(&conn->bhc_channels)) != NULL) {
         ble_hs_conn_delete_chan(conn, chan);
@@ -237,6 +365,11 @@ ble_hs_conn_insert(struct ble_hs_conn *conn)
 
     BLE_HS_DBG_ASSERT_EVAL(ble_hs_conn_find(conn->bhc_handle) == NULL);
     SLIST_INSERT_HEAD(&ble_hs_conns, conn, bhc_next);
+
+    ble_hs_conn_tbl_insert(ble_hs_conn_handle_tbl, ble_hs_conn_hash_by_handle,
+                           conn);
+    ble_hs_conn_tbl_insert(ble_hs_conn_addr_tbl, ble_hs_conn_hash_by_addr,
+                           conn);
 }
 
 void
@@ -249,6 +382,40 @@ ble_hs_conn_remove(struct ble_hs_conn *conn)
     BLE_HS_DBG_ASSERT(ble_hs_locked_by_cur_task());
 
     SLIST_REMOVE(&ble_hs_conns, conn, ble_hs_conn, bhc_next);
+
+    ble_hs_conn_tbl_remove(ble_hs_conn_handle_tbl, ble_hs_conn_hash_by_handle,
+                           conn);
+    ble_hs_conn_tbl_remove(ble_hs_conn_addr_tbl, ble_hs_conn_hash_by_addr,
+                           conn);
+}
+
+/**
+ * Changes the peer address of a connection, keeping the address lookup table
+ * consistent.  The connection need not be inserted yet.
+ */
+void
+ble_hs_conn_set_peer_addr(struct ble_hs_conn *conn, const ble_addr_t *addr)
+{
+#if !NIMBLE_BLE_CONNECT
+    return;
+#endif
+
+    int inserted;
+
+    BLE_HS_DBG_ASSERT(ble_hs_locked_by_cur_task());
+
+    inserted = ble_hs_conn_find(conn->bhc_handle) == conn;
+    if (inserted) {
+        ble_hs_conn_tbl_remove(ble_hs_conn_addr_tbl, ble_hs_conn_hash_by_addr,
+                               conn);
+    }
+
+    conn->bhc_peer_addr = *addr;
+
+    if (inserted) {
+        ble_hs_conn_tbl_insert(ble_hs_conn_addr_tbl, ble_hs_conn_hash_by_addr,
+                               conn);
+    }
 }
 
 struct ble_hs_conn *
@@ -259,13 +426,22 @@ ble_hs_conn_find(uint16_t conn_handle)
 #endif
 
     struct ble_hs_conn *conn;
+    int idx;
+    int i;
 
     BLE_HS_DBG_ASSERT(ble_hs_locked_by_cur_task());
 
-    SLIST_FOREACH(conn, &ble_hs_conns, bhc_next) {
+    idx = ble_hs_conn_handle_hash(conn_handle);
+    for (i = 0; i < BLE_HS_CONN_TBL_SZ; i++) {
+        conn = ble_hs_conn_handle_tbl[idx];
+        if (conn == NULL) {
+            break;
+        }
         if (conn->bhc_handle == conn_handle) {
             return conn;
         }
+
+        idx = (idx + 1) % BLE_HS_CONN_TBL_SZ;
     }
 
     return NULL;
@@ -290,6 +466,8 @@ ble_hs_conn_find_by_addr(const ble_addr_t *addr)
 #endif
 
     struct ble_hs_conn *conn;
+    int idx;
+    int i;
 
     BLE_HS_DBG_ASSERT(ble_hs_locked_by_cur_task());
 
@@ -297,10 +475,17 @@ ble_hs_conn_find_by_addr(const ble_addr_t *addr)
         return NULL;
     }
 
-    SLIST_FOREACH(conn, &ble_hs_conns, bhc_next) {
+    idx = ble_hs_conn_addr_hash(addr);
+    for (i = 0; i < BLE_HS_CONN_TBL_SZ; i++) {
+        conn = ble_hs_conn_addr_tbl[idx];
+        if (conn == NULL) {
+            break;
+        }
         if (ble_addr_cmp(&conn->bhc_peer_addr, addr) == 0) {
             return conn;
         }
+
+        idx = (idx + 1) % BLE_HS_CONN_TBL_SZ;
     }
 
     return NULL;
@@ -504,6 +689,8 @@ ble_hs_conn_init(void)
     }
 
     SLIST_INIT(&ble_hs_conns);
+    memset(ble_hs_conn_handle_tbl, 0, sizeof ble_hs_conn_handle_tbl);
+    memset(ble_hs_conn_addr_tbl, 0, sizeof ble_hs_conn_addr_tbl);
 
     return 0;
 }
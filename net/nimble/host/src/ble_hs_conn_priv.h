@@ -56,11 +56,25 @@ struct ble_hs_conn {
     struct ble_l2cap_chan *bhc_rx_chan; /* Channel rxing current packet. */
     uint32_t bhc_rx_timeout;
     uint16_t bhc_outstanding_pkts;
+    uint16_t bhc_max_tx_octets; /* Negotiated LL data length (DLE). */
+#if MYNEWT_VAL(BLE_HS_ACL_TX_SCHED)
+    /* ACL fragments waiting for a controller buffer. */
+    STAILQ_HEAD(, os_mbuf_pkthdr) bhc_tx_q;
+    uint16_t bhc_tx_q_len;
+    uint16_t bhc_tx_q_max;
+    uint8_t bhc_tx_deficit;     /* Fragments left in this round robin turn. */
+#endif
 
     struct ble_att_svr_conn bhc_att_svr;
     struct ble_gatts_conn bhc_gatt_svr;
+#if MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE)
+    struct ble_gattc_notify_q bhc_notify_q;
+#endif
 
     struct ble_gap_sec_state bhc_sec_state;
+#if MYNEWT_VAL(BLE_GAP_CONN_POLICY)
+    struct ble_gap_policy_conn bhc_policy;
+#endif
 
     ble_gap_event_fn *bhc_cb;
     void *bhc_cb_arg;
@@ -78,6 +92,8 @@ struct ble_hs_conn *ble_hs_conn_alloc(uint16_t conn_handle);
 void ble_hs_conn_free(struct ble_hs_conn *conn);
 void ble_hs_conn_insert(struct ble_hs_conn *conn);
 void ble_hs_conn_remove(struct ble_hs_conn *conn);
+void ble_hs_conn_set_peer_addr(struct ble_hs_conn *conn,
+                               const ble_addr_t *addr);
 struct ble_hs_conn *ble_hs_conn_find(uint16_t conn_handle);
 struct ble_hs_conn *ble_hs_conn_find_assert(uint16_t conn_handle);
 struct ble_hs_conn *ble_hs_conn_find_by_addr(const ble_addr_t *addr);
@@ -28,6 +28,9 @@
 
 #define BLE_HCI_CMD_TIMEOUT     (OS_TICKS_PER_SEC)
 
+/* Longest command that can be queued with ble_hs_hci_cmd_tx_async(). */
+#define BLE_HS_HCI_ASYNC_CMD_MAX_LEN    (BLE_HCI_CMD_HDR_LEN + 32)
+
 static struct os_mutex ble_hs_hci_mutex;
 static struct os_sem ble_hs_hci_sem;
 
@@ -35,6 +38,60 @@ static uint8_t *ble_hs_hci_ack;
 static uint16_t ble_hs_hci_buf_sz;
 static uint8_t ble_hs_hci_max_pkts;
 
+#if MYNEWT_VAL(BLE_HS_ACL_TX_SCHED)
+/* Controller ACL buffers not holding one of our fragments. */
+static uint8_t ble_hs_hci_avail_pkts;
+/* Connection whose turn it was last; the next turn goes to the one after. */
+static uint16_t ble_hs_hci_tx_last_handle = BLE_HS_CONN_HANDLE_NONE;
+#endif
+
+/* Commands the controller will currently accept (Num_HCI_Command_Packets). */
+static uint8_t ble_hs_hci_cmd_credits = 1;
+
+struct ble_hs_hci_async_cmd {
+    STAILQ_ENTRY(ble_hs_hci_async_cmd) bhac_next;
+    ble_hs_hci_cmd_cb_fn *bhac_cb;
+    void *bhac_arg;
+    uint8_t *bhac_ack;      /* Ack event; NULL if completed without one. */
+    int bhac_status;        /* Error if completed without an ack. */
+    uint8_t bhac_cmd[BLE_HS_HCI_ASYNC_CMD_MAX_LEN];
+};
+
+STAILQ_HEAD(ble_hs_hci_async_list, ble_hs_hci_async_cmd);
+
+static os_membuf_t ble_hs_hci_async_mem[
+    OS_MEMPOOL_SIZE(MYNEWT_VAL(BLE_HS_HCI_CMD_QUEUE_LEN),
+                    sizeof (struct ble_hs_hci_async_cmd))];
+static struct os_mempool ble_hs_hci_async_pool;
+
+/* Queued async commands move from pending (not sent) to inflight (sent,
+ * awaiting their ack) to done (callback not yet called).
+ */
+static struct ble_hs_hci_async_list ble_hs_hci_async_pending;
+static struct ble_hs_hci_async_list ble_hs_hci_async_inflight;
+static struct ble_hs_hci_async_list ble_hs_hci_async_done;
+
+/* Set while a task is sending pending commands; keeps them in order. */
+static uint8_t ble_hs_hci_async_sending;
+/* Set while a blocking command owns the link; async sends hold off. */
+static uint8_t ble_hs_hci_sync_busy;
+/* Tasks blocked in ble_hs_hci_cmd_wait_async(). */
+static uint8_t ble_hs_hci_async_waiters;
+
+/* Released as async commands complete, for ble_hs_hci_cmd_wait_async(). */
+static struct os_sem ble_hs_hci_async_sem;
+/* Released when the last in-flight async command is acked while a blocking
+ * command is waiting to be sent.
+ */
+static struct os_sem ble_hs_hci_idle_sem;
+
+static void ble_hs_hci_async_event(struct os_event *ev);
+
+/* Runs async completions and sends pending commands in the host task. */
+static struct os_event ble_hs_hci_async_ev = {
+    .ev_cb = ble_hs_hci_async_event,
+};
+
 #if MYNEWT_VAL(BLE_HS_PHONY_HCI_ACKS)
 static ble_hs_hci_phony_ack_fn *ble_hs_hci_phony_ack_cb;
 #endif
@@ -74,6 +131,9 @@ ble_hs_hci_set_buf_sz(uint16_t pktlen, uint8_t max_pkts)
 
     ble_hs_hci_buf_sz = pktlen;
     ble_hs_hci_max_pkts = max_pkts;
+#if MYNEWT_VAL(BLE_HS_ACL_TX_SCHED)
+    ble_hs_hci_avail_pkts = max_pkts;
+#endif
 
     return 0;
 }
@@ -148,26 +208,26 @@ ble_hs_hci_rx_cmd_status(uint8_t event_code, uint8_t *data, int len,
     return 0;
 }
 
+/**
+ * Parses a Command Complete or Command Status event.  On success, the
+ * parameters in out_ack point into the event buffer.
+ */
 static int
-ble_hs_hci_process_ack(uint16_t expected_opcode,
-                       uint8_t *params_buf, uint8_t params_buf_len,
-                       struct ble_hs_hci_ack *out_ack)
+ble_hs_hci_parse_ack(uint8_t *ack_ev, struct ble_hs_hci_ack *out_ack)
 {
     uint8_t event_code;
     uint8_t param_len;
     uint8_t event_len;
     int rc;
 
-    BLE_HS_DBG_ASSERT(ble_hs_hci_ack != NULL);
-
     /* Count events received */
     STATS_INC(ble_hs_stats, hci_event);
 
     /* Display to console */
-    ble_hs_dbg_event_disp(ble_hs_hci_ack);
+    ble_hs_dbg_event_disp(ack_ev);
 
-    event_code = ble_hs_hci_ack[0];
-    param_len = ble_hs_hci_ack[1];
+    event_code = ack_ev[0];
+    param_len = ack_ev[1];
     event_len = param_len + 2;
 
     /* Clear ack fields up front to silence spurious gcc warnings. */
@@ -175,12 +235,12 @@ ble_hs_hci_process_ack(uint16_t expected_opcode,
 
     switch (event_code) {
     case BLE_HCI_EVCODE_COMMAND_COMPLETE:
-        rc = ble_hs_hci_rx_cmd_complete(event_code, ble_hs_hci_ack,
+        rc = ble_hs_hci_rx_cmd_complete(event_code, ack_ev,
                                          event_len, out_ack);
         break;
 
     case BLE_HCI_EVCODE_COMMAND_STATUS:
-        rc = ble_hs_hci_rx_cmd_status(event_code, ble_hs_hci_ack,
+        rc = ble_hs_hci_rx_cmd_status(event_code, ack_ev,
                                        event_len, out_ack);
         break;
 
@@ -190,6 +250,19 @@ ble_hs_hci_process_ack(uint16_t expected_opcode,
         break;
     }
 
+    return rc;
+}
+
+static int
+ble_hs_hci_process_ack(uint16_t expected_opcode,
+                       uint8_t *params_buf, uint8_t params_buf_len,
+                       struct ble_hs_hci_ack *out_ack)
+{
+    int rc;
+
+    BLE_HS_DBG_ASSERT(ble_hs_hci_ack != NULL);
+
+    rc = ble_hs_hci_parse_ack(ble_hs_hci_ack, out_ack);
     if (rc == 0) {
         if (params_buf == NULL) {
             out_ack->bha_params_len = 0;
@@ -247,6 +320,414 @@ ble_hs_hci_wait_for_ack(void)
     return rc;
 }
 
+/**
+ * Reads the opcode and Num_HCI_Command_Packets fields of a Command Complete
+ * or Command Status event.
+ *
+ * @return                      0 on success; BLE_HS_ECONTROLLER if the
+ *                                  event is too short.
+ */
+static int
+ble_hs_hci_ack_hdr(const uint8_t *ack_ev, uint16_t *out_opcode,
+                   uint8_t *out_num_pkts)
+{
+    if (ack_ev[0] == BLE_HCI_EVCODE_COMMAND_COMPLETE) {
+        if (ack_ev[1] < 3) {
+            return BLE_HS_ECONTROLLER;
+        }
+        *out_num_pkts = ack_ev[2];
+        *out_opcode = get_le16(ack_ev + 3);
+    } else {
+        if (ack_ev[1] < 4) {
+            return BLE_HS_ECONTROLLER;
+        }
+        *out_num_pkts = ack_ev[3];
+        *out_opcode = get_le16(ack_ev + 4);
+    }
+
+    return 0;
+}
+
+/**
+ * Wakes anything waiting for async completions, and has the host task call
+ * the completion callbacks.
+ */
+static void
+ble_hs_hci_async_notify(void)
+{
+    if (ble_hs_hci_async_waiters > 0) {
+        os_sem_release(&ble_hs_hci_async_sem);
+    }
+    os_eventq_put(ble_hs_evq_get(), &ble_hs_hci_async_ev);
+}
+
+/**
+ * Moves a command onto the done list.  Must be called with interrupts
+ * disabled.
+ */
+static void
+ble_hs_hci_async_complete(struct ble_hs_hci_async_cmd *cmd, uint8_t *ack_ev,
+                          int status)
+{
+    cmd->bhac_ack = ack_ev;
+    cmd->bhac_status = status;
+    STAILQ_INSERT_TAIL(&ble_hs_hci_async_done, cmd, bhac_next);
+
+    if (ble_hs_hci_sync_busy && STAILQ_EMPTY(&ble_hs_hci_async_inflight)) {
+        os_sem_release(&ble_hs_hci_idle_sem);
+    }
+}
+
+/**
+ * Hands an ack to the oldest in-flight async command if it is the command
+ * being acknowledged.
+ *
+ * @return                      1 if the ack was consumed; 0 otherwise.
+ */
+static int
+ble_hs_hci_async_rx_ack(uint8_t *ack_ev)
+{
+    struct ble_hs_hci_async_cmd *cmd;
+    uint16_t opcode;
+    uint8_t num_pkts;
+    os_sr_t sr;
+
+    if (ble_hs_hci_ack_hdr(ack_ev, &opcode, &num_pkts) != 0) {
+        return 0;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    cmd = STAILQ_FIRST(&ble_hs_hci_async_inflight);
+    if (cmd == NULL || get_le16(cmd->bhac_cmd) != opcode) {
+        OS_EXIT_CRITICAL(sr);
+        return 0;
+    }
+    STAILQ_REMOVE_HEAD(&ble_hs_hci_async_inflight, bhac_next);
+    ble_hs_hci_async_complete(cmd, ack_ev, 0);
+    OS_EXIT_CRITICAL(sr);
+
+    ble_hs_hci_async_notify();
+    return 1;
+}
+
+static int
+ble_hs_hci_async_send(struct ble_hs_hci_async_cmd *cmd)
+{
+    int rc;
+
+    rc = ble_hs_hci_cmd_send_buf(cmd->bhac_cmd);
+
+#if MYNEWT_VAL(BLE_HS_PHONY_HCI_ACKS)
+    if (rc == 0) {
+        uint8_t *ack_ev;
+
+        if (ble_hs_hci_phony_ack_cb == NULL) {
+            rc = BLE_HS_ETIMEOUT_HCI;
+        } else {
+            ack_ev = ble_hci_trans_buf_alloc(BLE_HCI_TRANS_BUF_CMD);
+            BLE_HS_DBG_ASSERT(ack_ev != NULL);
+            rc = ble_hs_hci_phony_ack_cb(ack_ev, 260);
+            if (rc == 0) {
+                ble_hs_hci_cmd_credits = 1;
+                ble_hs_hci_rx_ack(ack_ev);
+            } else {
+                ble_hci_trans_buf_free(ack_ev);
+            }
+        }
+    }
+#endif
+
+    return rc;
+}
+
+/**
+ * Sends pending async commands for as long as the controller has command
+ * credits and no blocking command owns the link.
+ */
+static void
+ble_hs_hci_async_kick(void)
+{
+    struct ble_hs_hci_async_cmd *cmd;
+    int failed;
+    os_sr_t sr;
+    int rc;
+
+    failed = 0;
+
+    OS_ENTER_CRITICAL(sr);
+    if (ble_hs_hci_async_sending) {
+        /* Another task is sending; it will pick up what is pending. */
+        OS_EXIT_CRITICAL(sr);
+        return;
+    }
+    ble_hs_hci_async_sending = 1;
+
+    while (1) {
+        cmd = STAILQ_FIRST(&ble_hs_hci_async_pending);
+        if (cmd == NULL || ble_hs_hci_sync_busy ||
+            ble_hs_hci_cmd_credits == 0) {
+
+            break;
+        }
+
+        /* In flight before it is sent; the ack can beat the return. */
+        STAILQ_REMOVE_HEAD(&ble_hs_hci_async_pending, bhac_next);
+        STAILQ_INSERT_TAIL(&ble_hs_hci_async_inflight, cmd, bhac_next);
+        ble_hs_hci_cmd_credits--;
+        OS_EXIT_CRITICAL(sr);
+
+        rc = ble_hs_hci_async_send(cmd);
+
+        OS_ENTER_CRITICAL(sr);
+        if (rc != 0) {
+            STAILQ_REMOVE(&ble_hs_hci_async_inflight, cmd,
+                          ble_hs_hci_async_cmd, bhac_next);
+            ble_hs_hci_async_complete(cmd, NULL, rc);
+            failed = 1;
+        }
+    }
+
+    ble_hs_hci_async_sending = 0;
+    OS_EXIT_CRITICAL(sr);
+
+    if (failed) {
+        ble_hs_hci_async_notify();
+    }
+}
+
+/**
+ * Calls the callbacks of completed async commands, then sends whatever the
+ * freed credits allow.
+ */
+static void
+ble_hs_hci_async_process(void)
+{
+    struct ble_hs_hci_async_cmd *cmd;
+    struct ble_hs_hci_ack ack;
+    os_sr_t sr;
+    int rc;
+
+    while (1) {
+        OS_ENTER_CRITICAL(sr);
+        cmd = STAILQ_FIRST(&ble_hs_hci_async_done);
+        if (cmd != NULL) {
+            STAILQ_REMOVE_HEAD(&ble_hs_hci_async_done, bhac_next);
+        }
+        OS_EXIT_CRITICAL(sr);
+
+        if (cmd == NULL) {
+            break;
+        }
+
+        memset(&ack, 0, sizeof ack);
+        if (cmd->bhac_ack == NULL) {
+            rc = cmd->bhac_status;
+        } else {
+            rc = ble_hs_hci_parse_ack(cmd->bhac_ack, &ack);
+            if (rc == 0) {
+                rc = ack.bha_status;
+            } else {
+                STATS_INC(ble_hs_stats, hci_invalid_ack);
+            }
+        }
+
+        if (cmd->bhac_cb != NULL) {
+            cmd->bhac_cb(rc, ack.bha_params, ack.bha_params_len,
+                         cmd->bhac_arg);
+        }
+
+        if (cmd->bhac_ack != NULL) {
+            ble_hci_trans_buf_free(cmd->bhac_ack);
+        }
+        os_memblock_put(&ble_hs_hci_async_pool, cmd);
+    }
+
+    ble_hs_hci_async_kick();
+}
+
+static void
+ble_hs_hci_async_event(struct os_event *ev)
+{
+    ble_hs_hci_async_process();
+}
+
+/**
+ * Queues an HCI command to be sent without blocking.  The command is sent
+ * once the controller has a command credit for it; commands are sent in the
+ * order they are queued.  The callback is called from the host task (or from
+ * a task in ble_hs_hci_cmd_wait_async()) with the command's status and the
+ * return parameters of its Command Complete event, excluding the status
+ * byte.  The parameters are only valid for the duration of the callback.
+ *
+ * @param cmd                   The command, header included.  It is copied.
+ * @param cb                    Called when the command completes; may be
+ *                                  NULL.
+ * @param arg                   Passed to the callback.
+ *
+ * @return                      0 if the command was queued;
+ *                              BLE_HS_EINVAL if the command is too long;
+ *                              BLE_HS_ENOMEM if the queue is full.
+ */
+int
+ble_hs_hci_cmd_tx_async(const void *cmd, ble_hs_hci_cmd_cb_fn *cb, void *arg)
+{
+    struct ble_hs_hci_async_cmd *entry;
+    os_sr_t sr;
+    int len;
+
+    len = BLE_HCI_CMD_HDR_LEN + ((const uint8_t *)cmd)[2];
+    if (len > BLE_HS_HCI_ASYNC_CMD_MAX_LEN) {
+        return BLE_HS_EINVAL;
+    }
+
+    entry = os_memblock_get(&ble_hs_hci_async_pool);
+    if (entry == NULL) {
+        return BLE_HS_ENOMEM;
+    }
+
+    memcpy(entry->bhac_cmd, cmd, len);
+    entry->bhac_cb = cb;
+    entry->bhac_arg = arg;
+    entry->bhac_ack = NULL;
+    entry->bhac_status = 0;
+
+    OS_ENTER_CRITICAL(sr);
+    STAILQ_INSERT_TAIL(&ble_hs_hci_async_pending, entry, bhac_next);
+    OS_EXIT_CRITICAL(sr);
+
+    ble_hs_hci_async_kick();
+
+    return 0;
+}
+
+/**
+ * Blocks until every queued async command has completed and its callback
+ * has been called.  Callbacks that are due are called from this task.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_ETIMEOUT_HCI if the controller stops
+ *                                  acknowledging commands.
+ */
+int
+ble_hs_hci_cmd_wait_async(void)
+{
+    int wait;
+    os_sr_t sr;
+    int rc;
+
+    while (1) {
+        ble_hs_hci_async_process();
+
+        OS_ENTER_CRITICAL(sr);
+        wait = STAILQ_EMPTY(&ble_hs_hci_async_done);
+        if (wait) {
+            if (STAILQ_EMPTY(&ble_hs_hci_async_pending) &&
+                STAILQ_EMPTY(&ble_hs_hci_async_inflight)) {
+
+                OS_EXIT_CRITICAL(sr);
+                return 0;
+            }
+            ble_hs_hci_async_waiters++;
+        }
+        OS_EXIT_CRITICAL(sr);
+
+        if (!wait) {
+            continue;
+        }
+
+#if MYNEWT_VAL(BLE_HS_PHONY_HCI_ACKS)
+        /* Phony acks arrive as commands are sent; nothing else will. */
+        rc = OS_TIMEOUT;
+#else
+        rc = os_sem_pend(&ble_hs_hci_async_sem, BLE_HCI_CMD_TIMEOUT);
+#endif
+
+        OS_ENTER_CRITICAL(sr);
+        ble_hs_hci_async_waiters--;
+        OS_EXIT_CRITICAL(sr);
+
+        switch (rc) {
+        case 0:
+            break;
+        case OS_TIMEOUT:
+            STATS_INC(ble_hs_stats, hci_timeout);
+            return BLE_HS_ETIMEOUT_HCI;
+        default:
+            return BLE_HS_EOS;
+        }
+    }
+}
+
+/**
+ * Completes every queued and in-flight async command with
+ * BLE_HS_ENOTSYNCED.  Called when the host resets.
+ */
+void
+ble_hs_hci_async_flush(void)
+{
+    struct ble_hs_hci_async_cmd *cmd;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    while ((cmd = STAILQ_FIRST(&ble_hs_hci_async_inflight)) != NULL) {
+        STAILQ_REMOVE_HEAD(&ble_hs_hci_async_inflight, bhac_next);
+        ble_hs_hci_async_complete(cmd, NULL, BLE_HS_ENOTSYNCED);
+    }
+    while ((cmd = STAILQ_FIRST(&ble_hs_hci_async_pending)) != NULL) {
+        STAILQ_REMOVE_HEAD(&ble_hs_hci_async_pending, bhac_next);
+        ble_hs_hci_async_complete(cmd, NULL, BLE_HS_ENOTSYNCED);
+    }
+    ble_hs_hci_cmd_credits = 1;
+    OS_EXIT_CRITICAL(sr);
+
+    ble_hs_hci_async_process();
+}
+
+/**
+ * Takes the link for a blocking command: stops async sends and waits for
+ * the acks of any async commands already in flight, so that the next ack
+ * belongs to the blocking command.
+ */
+static int
+ble_hs_hci_sync_begin(void)
+{
+    int idle;
+    os_sr_t sr;
+    int rc;
+
+    OS_ENTER_CRITICAL(sr);
+    ble_hs_hci_sync_busy = 1;
+    idle = STAILQ_EMPTY(&ble_hs_hci_async_inflight);
+    OS_EXIT_CRITICAL(sr);
+
+    if (idle) {
+        return 0;
+    }
+
+    rc = os_sem_pend(&ble_hs_hci_idle_sem, BLE_HCI_CMD_TIMEOUT);
+    switch (rc) {
+    case 0:
+        return 0;
+    case OS_TIMEOUT:
+        STATS_INC(ble_hs_stats, hci_timeout);
+        return BLE_HS_ETIMEOUT_HCI;
+    default:
+        return BLE_HS_EOS;
+    }
+}
+
+static void
+ble_hs_hci_sync_end(void)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    ble_hs_hci_sync_busy = 0;
+    OS_EXIT_CRITICAL(sr);
+
+    ble_hs_hci_async_kick();
+}
+
 int
 ble_hs_hci_cmd_tx(void *cmd, void *evt_buf, uint8_t evt_buf_len,
                   uint8_t *out_evt_buf_len)
@@ -260,6 +741,12 @@ ble_hs_hci_cmd_tx(void *cmd, void *evt_buf, uint8_t evt_buf_len,
     BLE_HS_DBG_ASSERT(ble_hs_hci_ack == NULL);
     ble_hs_hci_lock();
 
+    rc = ble_hs_hci_sync_begin();
+    if (rc != 0) {
+        ble_hs_sched_reset(rc);
+        goto done;
+    }
+
     rc = ble_hs_hci_cmd_send_buf(cmd);
     if (rc != 0) {
         goto done;
@@ -289,6 +776,7 @@ done:
         ble_hs_hci_ack = NULL;
     }
 
+    ble_hs_hci_sync_end();
     ble_hs_hci_unlock();
     return rc;
 }
@@ -309,6 +797,10 @@ ble_hs_hci_cmd_tx_empty_ack(void *cmd)
 void
 ble_hs_hci_rx_ack(uint8_t *ack_ev)
 {
+    if (ble_hs_hci_async_rx_ack(ack_ev)) {
+        return;
+    }
+
     if (ble_hs_hci_sem.sem_tokens != 0) {
         /* This ack is unexpected; ignore it. */
         ble_hci_trans_buf_free(ack_ev);
@@ -326,6 +818,8 @@ ble_hs_hci_rx_ack(uint8_t *ack_ev)
 int
 ble_hs_hci_rx_evt(uint8_t *hci_ev, void *arg)
 {
+    uint16_t opcode;
+    uint8_t num_pkts;
     int enqueue;
 
     BLE_HS_DBG_ASSERT(hci_ev != NULL);
@@ -333,7 +827,17 @@ ble_hs_hci_rx_evt(uint8_t *hci_ev, void *arg)
     switch (hci_ev[0]) {
     case BLE_HCI_EVCODE_COMMAND_COMPLETE:
     case BLE_HCI_EVCODE_COMMAND_STATUS:
-        if (hci_ev[3] == 0 && hci_ev[4] == 0) {
+        if (ble_hs_hci_ack_hdr(hci_ev, &opcode, &num_pkts) != 0) {
+            enqueue = 1;
+            break;
+        }
+
+        ble_hs_hci_cmd_credits = num_pkts;
+        if (opcode == BLE_HCI_OPCODE_NOP) {
+            /* Credits only; let queued commands go. */
+            if (num_pkts > 0 && !STAILQ_EMPTY(&ble_hs_hci_async_pending)) {
+                os_eventq_put(ble_hs_evq_get(), &ble_hs_hci_async_ev);
+            }
             enqueue = 1;
         } else {
             ble_hs_hci_rx_ack(hci_ev);
@@ -363,6 +867,24 @@ ble_hs_hci_max_acl_payload_sz(void)
     return ble_hs_hci_buf_sz - BLE_HCI_DATA_HDR_SZ;
 }
 
+/**
+ * Calculates the ACL fragment size to use for the specified connection.  This
+ * is the controller's ACL payload size capped to the connection's negotiated
+ * LL data length, so that each fragment maps to exactly one LL data PDU.
+ */
+static uint16_t
+ble_hs_hci_acl_frag_sz(const struct ble_hs_conn *conn)
+{
+    uint16_t frag_sz;
+
+    frag_sz = ble_hs_hci_max_acl_payload_sz();
+    if (conn->bhc_max_tx_octets != 0 && conn->bhc_max_tx_octets < frag_sz) {
+        frag_sz = conn->bhc_max_tx_octets;
+    }
+
+    return frag_sz;
+}
+
 /**
  * Allocates an mbuf to contain an outgoing ACL data fragment.
  */
@@ -402,20 +924,178 @@ ble_hs_hci_acl_hdr_prepend(struct os_mbuf *om, uint16_t handle,
     return om;
 }
 
+#if MYNEWT_VAL(BLE_HS_ACL_TX_SCHED)
+
+static struct ble_hs_conn *
+ble_hs_hci_acl_tx_next_conn(struct ble_hs_conn *conn)
+{
+    conn = SLIST_NEXT(conn, bhc_next);
+    if (conn == NULL) {
+        conn = ble_hs_conn_first();
+    }
+    return conn;
+}
+
+/**
+ * Sends a connection's queued fragments until its turn ends.
+ *
+ * @return                      The number of fragments sent.
+ */
+static int
+ble_hs_hci_acl_tx_conn_turn(struct ble_hs_conn *conn)
+{
+    struct os_mbuf_pkthdr *omp;
+    struct os_mbuf *frag;
+    int sent;
+    int rc;
+
+    if (STAILQ_EMPTY(&conn->bhc_tx_q)) {
+        conn->bhc_tx_deficit = 0;
+        return 0;
+    }
+
+    if (conn->bhc_tx_deficit == 0) {
+        conn->bhc_tx_deficit = MYNEWT_VAL(BLE_HS_ACL_TX_QUANTUM);
+    }
+
+    sent = 0;
+    while (conn->bhc_tx_deficit > 0 && ble_hs_hci_avail_pkts > 0) {
+        omp = STAILQ_FIRST(&conn->bhc_tx_q);
+        if (omp == NULL) {
+            break;
+        }
+        STAILQ_REMOVE_HEAD(&conn->bhc_tx_q, omp_next);
+        conn->bhc_tx_q_len--;
+        conn->bhc_tx_deficit--;
+
+        frag = OS_MBUF_PKTHDR_TO_MBUF(omp);
+
+        BLE_HS_LOG(DEBUG, "ble_hs_hci_acl_tx(): ");
+        ble_hs_log_mbuf(frag);
+        BLE_HS_LOG(DEBUG, "\n");
+
+        rc = ble_hs_tx_data(frag);
+        if (rc == 0) {
+            ble_hs_hci_avail_pkts--;
+            conn->bhc_outstanding_pkts++;
+            sent++;
+        }
+    }
+
+    if (STAILQ_EMPTY(&conn->bhc_tx_q)) {
+        conn->bhc_tx_deficit = 0;
+    }
+    ble_hs_hci_tx_last_handle = conn->bhc_handle;
+
+    return sent;
+}
+
+/**
+ * Hands queued ACL fragments to the controller while it has free buffers.
+ * Connections with queued data take turns, each sending up to
+ * BLE_HS_ACL_TX_QUANTUM fragments per turn.  A turn cut short by the
+ * controller running out of buffers resumes first when buffers free up.
+ */
+void
+ble_hs_hci_acl_tx_sched(void)
+{
+    struct ble_hs_conn *start;
+    struct ble_hs_conn *conn;
+    int sent;
+
+    ble_hs_lock();
+
+    while (ble_hs_hci_avail_pkts > 0) {
+        conn = ble_hs_conn_find(ble_hs_hci_tx_last_handle);
+        if (conn == NULL) {
+            conn = ble_hs_conn_first();
+        } else if (conn->bhc_tx_deficit == 0) {
+            conn = ble_hs_hci_acl_tx_next_conn(conn);
+        }
+        if (conn == NULL) {
+            break;
+        }
+
+        /* One pass over every connection. */
+        sent = 0;
+        start = conn;
+        do {
+            sent += ble_hs_hci_acl_tx_conn_turn(conn);
+            if (ble_hs_hci_avail_pkts == 0) {
+                break;
+            }
+            conn = ble_hs_hci_acl_tx_next_conn(conn);
+        } while (conn != start);
+
+        if (sent == 0) {
+            break;
+        }
+    }
+
+    ble_hs_unlock();
+}
+
+/**
+ * Returns controller buffers reported free by a Number of Completed Packets
+ * event.
+ */
+void
+ble_hs_hci_acl_tx_done(uint16_t num_pkts)
+{
+    if (num_pkts > ble_hs_hci_max_pkts - ble_hs_hci_avail_pkts) {
+        ble_hs_hci_avail_pkts = ble_hs_hci_max_pkts;
+    } else {
+        ble_hs_hci_avail_pkts += num_pkts;
+    }
+}
+
+/**
+ * Drops a connection's queued fragments.  The controller frees the buffers
+ * of a connection when it terminates, so its outstanding fragments are
+ * counted as free and the other connections are given a chance to use them.
+ */
+void
+ble_hs_hci_acl_tx_conn_free(struct ble_hs_conn *conn)
+{
+    struct os_mbuf_pkthdr *omp;
+
+    while ((omp = STAILQ_FIRST(&conn->bhc_tx_q)) != NULL) {
+        STAILQ_REMOVE_HEAD(&conn->bhc_tx_q, omp_next);
+        os_mbuf_free_chain(OS_MBUF_PKTHDR_TO_MBUF(omp));
+    }
+    conn->bhc_tx_q_len = 0;
+
+    if (conn->bhc_outstanding_pkts > 0) {
+        ble_hs_hci_acl_tx_done(conn->bhc_outstanding_pkts);
+        conn->bhc_outstanding_pkts = 0;
+        ble_hs_hci_acl_tx_sched();
+    }
+}
+
+#endif
+
 /**
  * Transmits an HCI ACL data packet.  This function consumes the supplied mbuf,
  * regardless of the outcome.
  *
- * XXX: Ensure the controller has sufficient buffer capacity for the outgoing
- * fragments.
+ * With BLE_HS_ACL_TX_SCHED, the fragments are queued on the connection and
+ * sent as controller buffers become free.  Otherwise they are sent
+ * immediately; the controller is assumed to have room for them.
  */
 int
 ble_hs_hci_acl_tx(struct ble_hs_conn *connection, struct os_mbuf *txom)
 {
     struct os_mbuf *frag;
+    uint16_t frag_sz;
     uint8_t pb;
     int rc;
 
+#if MYNEWT_VAL(BLE_GAP_CONN_POLICY)
+    ble_gap_policy_traffic(connection, OS_MBUF_PKTLEN(txom));
+#endif
+
+    frag_sz = ble_hs_hci_acl_frag_sz(connection);
+
     /* The first fragment uses the first-non-flush packet boundary value.
      * After sending the first fragment, pb gets set appropriately for all
      * subsequent fragments in this packet.
@@ -424,8 +1104,7 @@ ble_hs_hci_acl_tx(struct ble_hs_conn *connection, struct os_mbuf *txom)
 
     /* Send fragments until the entire packet has been sent. */
     while (txom != NULL) {
-        frag = mem_split_frag(&txom, ble_hs_hci_max_acl_payload_sz(),
-                              ble_hs_hci_frag_alloc, NULL);
+        frag = mem_split_frag(&txom, frag_sz, ble_hs_hci_frag_alloc, NULL);
 
         frag = ble_hs_hci_acl_hdr_prepend(frag, connection->bhc_handle, pb);
         if (frag == NULL) {
@@ -434,6 +1113,15 @@ ble_hs_hci_acl_tx(struct ble_hs_conn *connection, struct os_mbuf *txom)
         }
         pb = BLE_HCI_PB_MIDDLE;
 
+#if MYNEWT_VAL(BLE_HS_ACL_TX_SCHED)
+        STAILQ_INSERT_TAIL(&connection->bhc_tx_q, OS_MBUF_PKTHDR(frag),
+                           omp_next);
+        connection->bhc_tx_q_len++;
+        if (connection->bhc_tx_q_len > connection->bhc_tx_q_max) {
+            connection->bhc_tx_q_max = connection->bhc_tx_q_len;
+        }
+        STATS_INC(ble_hs_stats, acl_tx_queued);
+#else
         BLE_HS_LOG(DEBUG, "ble_hs_hci_acl_tx(): ");
         ble_hs_log_mbuf(frag);
         BLE_HS_LOG(DEBUG, "\n");
@@ -444,8 +1132,13 @@ ble_hs_hci_acl_tx(struct ble_hs_conn *connection, struct os_mbuf *txom)
         }
 
         connection->bhc_outstanding_pkts++;
+#endif
     }
 
+#if MYNEWT_VAL(BLE_HS_ACL_TX_SCHED)
+    ble_hs_hci_acl_tx_sched();
+#endif
+
     return 0;
 
 err:
@@ -465,4 +1158,24 @@ ble_hs_hci_init(void)
 
     rc = os_mutex_init(&ble_hs_hci_mutex);
     BLE_HS_DBG_ASSERT_EVAL(rc == 0);
+
+    rc = os_sem_init(&ble_hs_hci_async_sem, 0);
+    BLE_HS_DBG_ASSERT_EVAL(rc == 0);
+
+    rc = os_sem_init(&ble_hs_hci_idle_sem, 0);
+    BLE_HS_DBG_ASSERT_EVAL(rc == 0);
+
+    rc = os_mempool_init(&ble_hs_hci_async_pool,
+                         MYNEWT_VAL(BLE_HS_HCI_CMD_QUEUE_LEN),
+                         sizeof (struct ble_hs_hci_async_cmd),
+                         ble_hs_hci_async_mem, "ble_hs_hci_async_pool");
+    BLE_HS_DBG_ASSERT_EVAL(rc == 0);
+
+    STAILQ_INIT(&ble_hs_hci_async_pending);
+    STAILQ_INIT(&ble_hs_hci_async_inflight);
+    STAILQ_INIT(&ble_hs_hci_async_done);
+    ble_hs_hci_async_sending = 0;
+    ble_hs_hci_sync_busy = 0;
+    ble_hs_hci_async_waiters = 0;
+    ble_hs_hci_cmd_credits = 1;
 }
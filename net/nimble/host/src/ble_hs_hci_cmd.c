@@ -24,6 +24,7 @@
 #include "os/os.h"
 #include "console/console.h"
 #include "nimble/hci_common.h"
+#include "nimble/hci_vendor.h"
 #include "nimble/ble_hci_trans.h"
 #include "ble_hs_dbg_priv.h"
 #include "ble_hs_priv.h"
@@ -979,6 +980,27 @@ ble_hs_hci_cmd_build_le_rand(uint8_t *dst, int dst_len)
     ble_hs_hci_cmd_write_hdr(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_RAND, 0, dst);
 }
 
+/**
+ * Encrypt a block with the controller's AES engine.  The key and plaintext
+ * are little-endian, as specified for the HCI command.
+ *
+ * OGF = 0x08 (LE)
+ * OCF = 0x0017
+ */
+void
+ble_hs_hci_cmd_build_le_encrypt(const uint8_t *key, const uint8_t *plaintext,
+                                uint8_t *dst, int dst_len)
+{
+    BLE_HS_DBG_ASSERT(dst_len >= BLE_HCI_CMD_HDR_LEN + BLE_HCI_LE_ENCRYPT_LEN);
+
+    ble_hs_hci_cmd_write_hdr(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_ENCRYPT,
+                             BLE_HCI_LE_ENCRYPT_LEN, dst);
+    dst += BLE_HCI_CMD_HDR_LEN;
+
+    memcpy(dst, key, 16);
+    memcpy(dst + 16, plaintext, 16);
+}
+
 static void
 ble_hs_hci_cmd_body_le_start_encrypt(const struct hci_start_encrypt *cmd,
                                      uint8_t *dst)
@@ -1085,6 +1107,116 @@ ble_hs_hci_cmd_build_set_data_len(uint16_t connection_handle,
     return 0;
 }
 
+/*
+ * OGF=0x08 OCF=0x0032
+ */
+int
+ble_hs_hci_cmd_build_le_set_phy(uint16_t conn_handle, uint8_t tx_phys,
+                                uint8_t rx_phys, uint8_t *dst, int dst_len)
+{
+    BLE_HS_DBG_ASSERT(dst_len >= BLE_HCI_CMD_HDR_LEN + BLE_HCI_LE_SET_PHY_LEN);
+
+    if ((tx_phys & ~BLE_HCI_LE_PHY_PREF_MASK_ALL) != 0 ||
+        (rx_phys & ~BLE_HCI_LE_PHY_PREF_MASK_ALL) != 0) {
+
+        return BLE_HS_EINVAL;
+    }
+
+    ble_hs_hci_cmd_write_hdr(BLE_HCI_OGF_LE, BLE_HCI_OCF_LE_SET_PHY,
+                             BLE_HCI_LE_SET_PHY_LEN, dst);
+    dst += BLE_HCI_CMD_HDR_LEN;
+
+    put_le16(dst + 0, conn_handle);
+
+    /* An empty mask means "no preference" for that direction. */
+    dst[2] = 0;
+    if (tx_phys == 0) {
+        dst[2] |= BLE_HCI_LE_PHY_NO_TX_PREF_MASK;
+    }
+    if (rx_phys == 0) {
+        dst[2] |= BLE_HCI_LE_PHY_NO_RX_PREF_MASK;
+    }
+    dst[3] = tx_phys;
+    dst[4] = rx_phys;
+
+    /* No coded PHY preference. */
+    put_le16(dst + 5, 0);
+
+    return 0;
+}
+
+/**
+ * Vendor specific advertising report filter command; clears all filters.
+ *
+ * OGF=0x3f OCF=0x0155
+ */
+void
+ble_hs_hci_cmd_build_adv_rpt_filt_clear(uint8_t *dst, int dst_len)
+{
+    BLE_HS_DBG_ASSERT(dst_len >= BLE_HCI_CMD_HDR_LEN +
+                                 BLE_HCI_ADV_RPT_FILT_CLEAR_LEN);
+
+    ble_hs_hci_cmd_write_hdr(BLE_HCI_OGF_VENDOR, BLE_HCI_OCF_ADV_RPT_FILT,
+                             BLE_HCI_ADV_RPT_FILT_CLEAR_LEN, dst);
+    dst += BLE_HCI_CMD_HDR_LEN;
+
+    dst[0] = BLE_HCI_ADV_RPT_FILT_CLEAR;
+}
+
+/**
+ * Vendor specific advertising report filter command; adds a filter.  The
+ * value is little endian.
+ *
+ * OGF=0x3f OCF=0x0155
+ */
+int
+ble_hs_hci_cmd_build_adv_rpt_filt_add(uint8_t type, const uint8_t *val,
+                                      uint8_t val_len, uint8_t *dst,
+                                      int dst_len)
+{
+    uint8_t len;
+
+    if (val_len > BLE_HCI_ADV_RPT_FILT_ADD_MAX_LEN -
+                  (BLE_HCI_ADV_RPT_FILT_ADD_MIN_LEN - 2)) {
+        return BLE_HS_EINVAL;
+    }
+
+    len = BLE_HCI_ADV_RPT_FILT_ADD_MIN_LEN - 2 + val_len;
+    BLE_HS_DBG_ASSERT(dst_len >= BLE_HCI_CMD_HDR_LEN + len);
+
+    ble_hs_hci_cmd_write_hdr(BLE_HCI_OGF_VENDOR, BLE_HCI_OCF_ADV_RPT_FILT,
+                             len, dst);
+    dst += BLE_HCI_CMD_HDR_LEN;
+
+    dst[0] = BLE_HCI_ADV_RPT_FILT_ADD;
+    dst[1] = type;
+    dst[2] = val_len;
+    memcpy(dst + 3, val, val_len);
+
+    return 0;
+}
+
+/**
+ * Vendor specific advertising report filter command; enables or disables
+ * filtering.
+ *
+ * OGF=0x3f OCF=0x0155
+ */
+void
+ble_hs_hci_cmd_build_adv_rpt_filt_enable(uint8_t enable, uint8_t *dst,
+                                         int dst_len)
+{
+    BLE_HS_DBG_ASSERT(dst_len >= BLE_HCI_CMD_HDR_LEN +
+                                 BLE_HCI_ADV_RPT_FILT_ENABLE_LEN);
+
+    ble_hs_hci_cmd_write_hdr(BLE_HCI_OGF_VENDOR, BLE_HCI_OCF_ADV_RPT_FILT,
+                             BLE_HCI_ADV_RPT_FILT_ENABLE_LEN, dst);
+    dst += BLE_HCI_CMD_HDR_LEN;
+
+    dst[0] = BLE_HCI_ADV_RPT_FILT_ENABLE;
+    dst[1] = !!enable;
+}
+
 /**
  * IRKs are in little endian.
  */
@@ -45,7 +45,9 @@ static ble_hs_hci_evt_le_fn ble_hs_hci_evt_le_adv_rpt;
 static ble_hs_hci_evt_le_fn ble_hs_hci_evt_le_conn_upd_complete;
 static ble_hs_hci_evt_le_fn ble_hs_hci_evt_le_lt_key_req;
 static ble_hs_hci_evt_le_fn ble_hs_hci_evt_le_conn_parm_req;
+static ble_hs_hci_evt_le_fn ble_hs_hci_evt_le_data_len_chg;
 static ble_hs_hci_evt_le_fn ble_hs_hci_evt_le_dir_adv_rpt;
+static ble_hs_hci_evt_le_fn ble_hs_hci_evt_le_phy_update_complete;
 
 /* Statistics */
 struct host_hci_stats
@@ -90,8 +92,11 @@ static const struct ble_hs_hci_evt_le_dispatch_entry
           ble_hs_hci_evt_le_conn_upd_complete },
     { BLE_HCI_LE_SUBEV_LT_KEY_REQ, ble_hs_hci_evt_le_lt_key_req },
     { BLE_HCI_LE_SUBEV_REM_CONN_PARM_REQ, ble_hs_hci_evt_le_conn_parm_req },
+    { BLE_HCI_LE_SUBEV_DATA_LEN_CHG, ble_hs_hci_evt_le_data_len_chg },
     { BLE_HCI_LE_SUBEV_ENH_CONN_COMPLETE, ble_hs_hci_evt_le_conn_complete },
     { BLE_HCI_LE_SUBEV_DIRECT_ADV_RPT, ble_hs_hci_evt_le_dir_adv_rpt },
+    { BLE_HCI_LE_SUBEV_PHY_UPDATE_COMPLETE,
+          ble_hs_hci_evt_le_phy_update_complete },
 };
 
 #define BLE_HS_HCI_EVT_LE_DISPATCH_SZ \
@@ -200,9 +205,12 @@ ble_hs_hci_evt_enc_key_refresh(uint8_t event_code, uint8_t *data, int len)
 static int
 ble_hs_hci_evt_num_completed_pkts(uint8_t event_code, uint8_t *data, int len)
 {
+    struct ble_hs_conn *conn;
     uint16_t num_pkts;
     uint16_t handle;
     uint8_t num_handles;
+    int tx_sched;
+    int sched;
     int off;
     int i;
 
@@ -218,16 +226,58 @@ ble_hs_hci_evt_num_completed_pkts(uint8_t event_code, uint8_t *data, int len)
     }
     off++;
 
+    tx_sched = 0;
+    sched = 0;
+
     for (i = 0; i < num_handles; i++) {
         handle = get_le16(data + off);
         num_pkts = get_le16(data + off + 2);
         off += (2 * sizeof(uint16_t));
 
-        /* XXX: Do something with these values. */
-        (void)handle;
-        (void)num_pkts;
+        ble_hs_lock();
+
+        conn = ble_hs_conn_find(handle);
+        if (conn != NULL) {
+            if (conn->bhc_outstanding_pkts < num_pkts) {
+                num_pkts = conn->bhc_outstanding_pkts;
+            }
+            conn->bhc_outstanding_pkts -= num_pkts;
+
+#if MYNEWT_VAL(BLE_HS_ACL_TX_SCHED)
+            ble_hs_hci_acl_tx_done(num_pkts);
+            if (num_pkts > 0) {
+                tx_sched = 1;
+            }
+#endif
+
+#if MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE)
+            if (!STAILQ_EMPTY(&conn->bhc_notify_q.gnq_entries)) {
+                sched = 1;
+            }
+#endif
+        }
+
+        ble_hs_unlock();
     }
 
+#if MYNEWT_VAL(BLE_HS_ACL_TX_SCHED)
+    /* Controller buffers were freed; send queued ACL fragments. */
+    if (tx_sched) {
+        ble_hs_hci_acl_tx_sched();
+    }
+#else
+    (void)tx_sched;
+#endif
+
+#if MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE)
+    /* Controller buffers were freed; resume queued notifications. */
+    if (sched) {
+        ble_gattc_notify_q_sched();
+    }
+#else
+    (void)sched;
+#endif
+
     return 0;
 }
 
@@ -564,6 +614,54 @@ ble_hs_hci_evt_le_conn_parm_req(uint8_t subevent, uint8_t *data, int len)
     return 0;
 }
 
+static int
+ble_hs_hci_evt_le_data_len_chg(uint8_t subevent, uint8_t *data, int len)
+{
+    struct hci_le_data_len_chg evt;
+
+    if (len < BLE_HCI_LE_DATA_LEN_CHG_LEN) {
+        return BLE_HS_ECONTROLLER;
+    }
+
+    evt.subevent_code = data[0];
+    evt.connection_handle = get_le16(data + 1);
+    evt.max_tx_octets = get_le16(data + 3);
+    evt.max_tx_time = get_le16(data + 5);
+    evt.max_rx_octets = get_le16(data + 7);
+    evt.max_rx_time = get_le16(data + 9);
+
+    if (evt.max_tx_octets < BLE_HCI_SET_DATALEN_TX_OCTETS_MIN ||
+        evt.max_tx_octets > BLE_HCI_SET_DATALEN_TX_OCTETS_MAX) {
+
+        return BLE_HS_EBADDATA;
+    }
+
+    ble_gap_rx_data_len_chg(&evt);
+
+    return 0;
+}
+
+static int
+ble_hs_hci_evt_le_phy_update_complete(uint8_t subevent, uint8_t *data,
+                                      int len)
+{
+    struct hci_le_phy_upd_complete evt;
+
+    if (len < BLE_HCI_LE_PHY_UPD_LEN) {
+        return BLE_HS_ECONTROLLER;
+    }
+
+    evt.subevent_code = data[0];
+    evt.status = data[1];
+    evt.connection_handle = get_le16(data + 2);
+    evt.tx_phy = data[4];
+    evt.rx_phy = data[5];
+
+    ble_gap_rx_phy_update_complete(&evt);
+
+    return 0;
+}
+
 int
 ble_hs_hci_evt_process(uint8_t *data)
 {
@@ -582,6 +680,7 @@ ble_hs_hci_evt_process(uint8_t *data)
     /* Process the event */
     event_code = data[0];
     param_len = data[1];
+    os_trace_event(BLE_HS_TRACE_ID_HCI_EVT, event_code);
 
     event_len = param_len + 2;
 
@@ -621,6 +720,7 @@ ble_hs_hci_evt_acl_process(struct os_mbuf *om)
     if (rc != 0) {
         goto err;
     }
+    os_trace_event(BLE_HS_TRACE_ID_ACL_RX, hci_hdr.hdh_len);
 
 #if (BLETEST_THROUGHPUT_TEST == 0)
     BLE_HS_LOG(DEBUG, "ble_hs_hci_evt_acl_process(): conn_handle=%u pb=%x "
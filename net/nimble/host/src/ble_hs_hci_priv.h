@@ -36,9 +36,27 @@ struct ble_hs_hci_ack {
     uint8_t bha_hci_handle;
 };
 
+/**
+ * Called when a command queued with ble_hs_hci_cmd_tx_async() completes.
+ *
+ * @param status                0 on success; a BLE_HS_E<...> error,
+ *                                  including BLE_HS_HCI_ERR() codes,
+ *                                  otherwise.
+ * @param params                The return parameters, excluding the status
+ *                                  byte.
+ * @param params_len            The length of the return parameters.
+ * @param arg                   The argument the command was queued with.
+ */
+typedef void ble_hs_hci_cmd_cb_fn(int status, const uint8_t *params,
+                                  int params_len, void *arg);
+
 int ble_hs_hci_cmd_tx(void *cmd, void *evt_buf, uint8_t evt_buf_len,
                       uint8_t *out_evt_buf_len);
 int ble_hs_hci_cmd_tx_empty_ack(void *cmd);
+int ble_hs_hci_cmd_tx_async(const void *cmd, ble_hs_hci_cmd_cb_fn *cb,
+                            void *arg);
+int ble_hs_hci_cmd_wait_async(void);
+void ble_hs_hci_async_flush(void);
 void ble_hs_hci_rx_ack(uint8_t *ack_ev);
 void ble_hs_hci_init(void);
 
@@ -49,6 +67,8 @@ void ble_hs_hci_set_phony_ack_cb(ble_hs_hci_phony_ack_fn *cb);
 
 int ble_hs_hci_util_read_adv_tx_pwr(int8_t *out_pwr);
 int ble_hs_hci_util_rand(void *dst, int len);
+int ble_hs_hci_util_encrypt(const uint8_t *key, const uint8_t *plaintext,
+                            uint8_t *out);
 int ble_hs_hci_util_read_rssi(uint16_t conn_handle, int8_t *out_rssi);
 int ble_hs_hci_util_set_random_addr(const uint8_t *addr);
 int ble_hs_hci_util_set_data_len(uint16_t conn_handle, uint16_t tx_octets,
@@ -126,6 +146,9 @@ void ble_hs_hci_cmd_build_le_conn_param_neg_reply(
 int ble_hs_hci_cmd_le_conn_param_neg_reply(
     const struct hci_conn_param_neg_reply *hcn);
 void ble_hs_hci_cmd_build_le_rand(uint8_t *dst, int dst_len);
+void ble_hs_hci_cmd_build_le_encrypt(const uint8_t *key,
+                                     const uint8_t *plaintext,
+                                     uint8_t *dst, int dst_len);
 void ble_hs_hci_cmd_build_le_start_encrypt(const struct hci_start_encrypt *cmd,
                                            uint8_t *dst, int dst_len);
 int ble_hs_hci_set_buf_sz(uint16_t pktlen, uint8_t max_pkts);
@@ -134,10 +157,24 @@ uint16_t ble_hs_hci_util_handle_pb_bc_join(uint16_t handle, uint8_t pb,
                                            uint8_t bc);
 
 int ble_hs_hci_acl_tx(struct ble_hs_conn *connection, struct os_mbuf *txom);
+#if MYNEWT_VAL(BLE_HS_ACL_TX_SCHED)
+void ble_hs_hci_acl_tx_sched(void);
+void ble_hs_hci_acl_tx_done(uint16_t num_pkts);
+void ble_hs_hci_acl_tx_conn_free(struct ble_hs_conn *conn);
+#endif
 
 int ble_hs_hci_cmd_build_set_data_len(uint16_t connection_handle,
                                       uint16_t tx_octets, uint16_t tx_time,
                                       uint8_t *dst, int dst_len);
+int ble_hs_hci_cmd_build_le_set_phy(uint16_t conn_handle, uint8_t tx_phys,
+                                    uint8_t rx_phys, uint8_t *dst,
+                                    int dst_len);
+void ble_hs_hci_cmd_build_adv_rpt_filt_clear(uint8_t *dst, int dst_len);
+int ble_hs_hci_cmd_build_adv_rpt_filt_add(uint8_t type, const uint8_t *val,
+                                          uint8_t val_len, uint8_t *dst,
+                                          int dst_len);
+void ble_hs_hci_cmd_build_adv_rpt_filt_enable(uint8_t enable, uint8_t *dst,
+                                              int dst_len);
 int ble_hs_hci_cmd_build_add_to_resolv_list(
     const struct hci_add_dev_to_resolving_list *padd,
     uint8_t *dst, int dst_len);
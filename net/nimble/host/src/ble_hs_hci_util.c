@@ -93,6 +93,34 @@ ble_hs_hci_util_rand(void *dst, int len)
     return 0;
 }
 
+/**
+ * Encrypts a single 128-bit block with the controller's AES engine.  All
+ * buffers are little-endian.
+ */
+int
+ble_hs_hci_util_encrypt(const uint8_t *key, const uint8_t *plaintext,
+                        uint8_t *out)
+{
+    uint8_t buf[BLE_HCI_CMD_HDR_LEN + BLE_HCI_LE_ENCRYPT_LEN];
+    uint8_t rsp_buf[16];
+    uint8_t params_len;
+    int rc;
+
+    ble_hs_hci_cmd_build_le_encrypt(key, plaintext, buf, sizeof buf);
+
+    rc = ble_hs_hci_cmd_tx(buf, rsp_buf, sizeof rsp_buf, &params_len);
+    if (rc != 0) {
+        return rc;
+    }
+    if (params_len != sizeof rsp_buf) {
+        return BLE_HS_ECONTROLLER;
+    }
+
+    memcpy(out, rsp_buf, sizeof rsp_buf);
+
+    return 0;
+}
+
 int
 ble_hs_hci_util_read_rssi(uint16_t conn_handle, int8_t *out_rssi)
 {
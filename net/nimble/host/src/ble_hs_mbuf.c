@@ -20,6 +20,10 @@
 #include "host/ble_hs.h"
 #include "ble_hs_priv.h"
 
+#if MYNEWT_VAL(BLE_HS_MSYS_QUOTA)
+static struct os_msys_quota ble_hs_mbuf_quota;
+#endif
+
 /**
  * Allocates an mbuf for use by the nimble host.
  */
@@ -29,7 +33,11 @@ ble_hs_mbuf_gen_pkt(uint16_t leading_space)
     struct os_mbuf *om;
     int rc;
 
+#if MYNEWT_VAL(BLE_HS_MSYS_QUOTA)
+    om = os_msys_get_pkthdr_quota(&ble_hs_mbuf_quota, 0, 0);
+#else
     om = os_msys_get_pkthdr(0, 0);
+#endif
     if (om == NULL) {
         return NULL;
     }
@@ -182,6 +190,50 @@ ble_hs_mbuf_to_flat(const struct os_mbuf *om, void *flat, uint16_t max_len,
     return rc;
 }
 
+/**
+ * Locates a run of bytes in an mbuf chain without modifying the chain.  This
+ * lets protocol parsers read headers in place rather than pulling them up
+ * into the first buffer.
+ *
+ * @param om                    The mbuf chain to read from.
+ * @param off                   The offset of the first byte to read.
+ * @param len                   The number of bytes to read.
+ * @param buf                   Scratch space of at least "len" bytes; only
+ *                                  used if the requested bytes span more
+ *                                  than one buffer.
+ *
+ * @return                      A pointer to the requested bytes, either
+ *                                  within the mbuf chain or in "buf";
+ *                              NULL if the chain is too short.
+ */
+const void *
+ble_hs_mbuf_peek(const struct os_mbuf *om, int off, int len, void *buf)
+{
+    const struct os_mbuf *cur;
+    uint16_t cur_off;
+    int rc;
+
+    if (off < 0 || len < 0 || OS_MBUF_PKTLEN(om) - off < len) {
+        return NULL;
+    }
+
+    cur = os_mbuf_off(om, off, &cur_off);
+    if (cur == NULL) {
+        return NULL;
+    }
+
+    if (cur->om_len - cur_off >= len) {
+        return cur->om_data + cur_off;
+    }
+
+    rc = os_mbuf_copydata(om, off, len, buf);
+    if (rc != 0) {
+        return NULL;
+    }
+
+    return buf;
+}
+
 int
 ble_hs_mbuf_pullup_base(struct os_mbuf **om, int base_len)
 {
@@ -196,3 +248,15 @@ ble_hs_mbuf_pullup_base(struct os_mbuf **om, int base_len)
 
     return 0;
 }
+
+int
+ble_hs_mbuf_init(void)
+{
+#if MYNEWT_VAL(BLE_HS_MSYS_QUOTA)
+    return os_msys_quota_init(&ble_hs_mbuf_quota,
+                              MYNEWT_VAL(BLE_HS_MSYS_RESERVE),
+                              MYNEWT_VAL(BLE_HS_MSYS_MAX));
+#else
+    return 0;
+#endif
+}
@@ -29,7 +29,10 @@ struct os_mbuf;
 struct os_mbuf *ble_hs_mbuf_bare_pkt(void);
 struct os_mbuf *ble_hs_mbuf_acm_pkt(void);
 struct os_mbuf *ble_hs_mbuf_l2cap_pkt(void);
+const void *ble_hs_mbuf_peek(const struct os_mbuf *om, int off, int len,
+                             void *buf);
 int ble_hs_mbuf_pullup_base(struct os_mbuf **om, int base_len);
+int ble_hs_mbuf_init(void);
 
 #ifdef __cplusplus
 }
@@ -23,6 +23,7 @@
 #include <assert.h>
 #include <inttypes.h>
 #include "os/os_time.h"
+#include "os/os_trace.h"
 #include "ble_att_cmd_priv.h"
 #include "ble_att_priv.h"
 #include "ble_gap_priv.h"
@@ -59,6 +60,10 @@ struct os_event;
 #define BLE_HS_SYNC_STATE_BRINGUP       1
 #define BLE_HS_SYNC_STATE_GOOD          2
 
+/* Event ids for the kernel trace (OS_TRACE) */
+#define BLE_HS_TRACE_ID_HCI_EVT         (OS_TRACE_ID_USER + 8)  /* code */
+#define BLE_HS_TRACE_ID_ACL_RX          (OS_TRACE_ID_USER + 9)  /* len */
+
 #if NIMBLE_BLE_CONNECT
 #define BLE_HS_MAX_CONNECTIONS MYNEWT_VAL(BLE_MAX_CONNECTIONS)
 #else
@@ -82,6 +87,7 @@ STATS_SECT_START(ble_hs_stats)
     STATS_SECT_ENTRY(hci_timeout)
     STATS_SECT_ENTRY(reset)
     STATS_SECT_ENTRY(sync)
+    STATS_SECT_ENTRY(acl_tx_queued)
 STATS_SECT_END
 extern STATS_SECT_DECL(ble_hs_stats) ble_hs_stats;
 
@@ -119,6 +125,7 @@ void ble_hs_sched_reset(int reason);
 void ble_hs_hw_error(uint8_t hw_code);
 void ble_hs_timer_resched(void);
 void ble_hs_notifications_sched(void);
+struct os_eventq *ble_hs_evq_get(void);
 
 #if MYNEWT_VAL(LOG_LEVEL) <= LOG_LEVEL_DEBUG
 
@@ -22,90 +22,131 @@
 #include "host/ble_hs.h"
 #include "ble_hs_priv.h"
 
+/* First error reported by a queued startup command. */
+static int ble_hs_startup_rc;
+
+static void
+ble_hs_startup_fail(int rc)
+{
+    if (ble_hs_startup_rc == 0) {
+        ble_hs_startup_rc = rc;
+    }
+}
+
 static int
-ble_hs_startup_le_read_sup_f_tx(void)
+ble_hs_startup_tx(const void *cmd, ble_hs_hci_cmd_cb_fn *cb)
 {
-    uint8_t ack_params[BLE_HCI_RD_LOC_SUPP_FEAT_RSPLEN];
-    uint8_t buf[BLE_HCI_CMD_HDR_LEN];
-    uint8_t ack_params_len;
     int rc;
 
-    ble_hs_hci_cmd_build_le_read_loc_supp_feat(buf, sizeof buf);
-    rc = ble_hs_hci_cmd_tx(buf, ack_params, sizeof ack_params,
-                           &ack_params_len);
+    rc = ble_hs_hci_cmd_tx_async(cmd, cb, NULL);
     if (rc != 0) {
-        return rc;
+        ble_hs_startup_fail(rc);
+    }
+
+    return rc;
+}
+
+static void
+ble_hs_startup_empty_ack_cb(int status, const uint8_t *params,
+                            int params_len, void *arg)
+{
+    if (status != 0) {
+        ble_hs_startup_fail(status);
     }
+}
 
-    if (ack_params_len != BLE_HCI_RD_LOC_SUPP_FEAT_RSPLEN) {
-        return BLE_HS_ECONTROLLER;
+static void
+ble_hs_startup_le_read_sup_f_cb(int status, const uint8_t *params,
+                                int params_len, void *arg)
+{
+    if (status != 0) {
+        ble_hs_startup_fail(status);
+        return;
     }
 
-    /* XXX: Do something with the supported features bit map. */
+    if (params_len != BLE_HCI_RD_LOC_SUPP_FEAT_RSPLEN) {
+        ble_hs_startup_fail(BLE_HS_ECONTROLLER);
+        return;
+    }
 
-    return 0;
+    /* XXX: Do something with the supported features bit map. */
 }
 
 static int
-ble_hs_startup_le_read_buf_sz_tx(void)
+ble_hs_startup_le_read_sup_f_tx(void)
 {
-    uint16_t pktlen;
-    uint8_t ack_params[BLE_HCI_RD_BUF_SIZE_RSPLEN];
     uint8_t buf[BLE_HCI_CMD_HDR_LEN];
-    uint8_t ack_params_len;
+
+    ble_hs_hci_cmd_build_le_read_loc_supp_feat(buf, sizeof buf);
+    return ble_hs_startup_tx(buf, ble_hs_startup_le_read_sup_f_cb);
+}
+
+static void
+ble_hs_startup_le_read_buf_sz_cb(int status, const uint8_t *params,
+                                 int params_len, void *arg)
+{
+    uint16_t pktlen;
     uint8_t max_pkts;
     int rc;
 
-    ble_hs_hci_cmd_build_le_read_buffer_size(buf, sizeof buf);
-    rc = ble_hs_hci_cmd_tx(buf, ack_params, sizeof ack_params,
-                           &ack_params_len);
-    if (rc != 0) {
-        return rc;
+    if (status != 0) {
+        ble_hs_startup_fail(status);
+        return;
     }
 
-    if (ack_params_len != BLE_HCI_RD_BUF_SIZE_RSPLEN) {
-        return BLE_HS_ECONTROLLER;
+    if (params_len != BLE_HCI_RD_BUF_SIZE_RSPLEN) {
+        ble_hs_startup_fail(BLE_HS_ECONTROLLER);
+        return;
     }
 
-    pktlen = get_le16(ack_params + 0);
-    max_pkts = ack_params[2];
+    pktlen = get_le16(params + 0);
+    max_pkts = params[2];
 
     rc = ble_hs_hci_set_buf_sz(pktlen, max_pkts);
     if (rc != 0) {
-        return rc;
+        ble_hs_startup_fail(rc);
     }
-
-    return 0;
 }
 
 static int
-ble_hs_startup_read_bd_addr(void)
+ble_hs_startup_le_read_buf_sz_tx(void)
 {
-    uint8_t ack_params[BLE_HCI_IP_RD_BD_ADDR_ACK_PARAM_LEN];
     uint8_t buf[BLE_HCI_CMD_HDR_LEN];
-    uint8_t ack_params_len;
-    int rc;
 
-    ble_hs_hci_cmd_build_read_bd_addr(buf, sizeof buf);
-    rc = ble_hs_hci_cmd_tx(buf, ack_params, sizeof ack_params,
-                           &ack_params_len);
-    if (rc != 0) {
-        return rc;
+    ble_hs_hci_cmd_build_le_read_buffer_size(buf, sizeof buf);
+    return ble_hs_startup_tx(buf, ble_hs_startup_le_read_buf_sz_cb);
+}
+
+static void
+ble_hs_startup_read_bd_addr_cb(int status, const uint8_t *params,
+                               int params_len, void *arg)
+{
+    if (status != 0) {
+        ble_hs_startup_fail(status);
+        return;
     }
 
-    if (ack_params_len != sizeof ack_params) {
-        return BLE_HS_ECONTROLLER;
+    if (params_len != BLE_HCI_IP_RD_BD_ADDR_ACK_PARAM_LEN) {
+        ble_hs_startup_fail(BLE_HS_ECONTROLLER);
+        return;
     }
 
-    ble_hs_id_set_pub(ack_params);
-    return 0;
+    ble_hs_id_set_pub(params);
+}
+
+static int
+ble_hs_startup_read_bd_addr(void)
+{
+    uint8_t buf[BLE_HCI_CMD_HDR_LEN];
+
+    ble_hs_hci_cmd_build_read_bd_addr(buf, sizeof buf);
+    return ble_hs_startup_tx(buf, ble_hs_startup_read_bd_addr_cb);
 }
 
 static int
 ble_hs_startup_le_set_evmask_tx(void)
 {
     uint8_t buf[BLE_HCI_CMD_HDR_LEN + BLE_HCI_SET_LE_EVENT_MASK_LEN];
-    int rc;
 
     /**
      * Enable the following LE events:
@@ -117,15 +158,21 @@ ble_hs_startup_le_set_evmask_tx(void)
      *     0x0000000000000020 LE Remote Connection Parameter Request Event
      *     0x0000000000000040 LE Data Length Change Event
      *     0x0000000000000200 LE Enhanced Connection Complete Event
+     *     0x0000000000000800 LE PHY Update Complete Event
      */
-    ble_hs_hci_cmd_build_le_set_event_mask(0x000000000000027f,
+    ble_hs_hci_cmd_build_le_set_event_mask(0x0000000000000a7f,
                                            buf, sizeof buf);
-    rc = ble_hs_hci_cmd_tx_empty_ack(buf);
-    if (rc != 0) {
-        return rc;
-    }
+    return ble_hs_startup_tx(buf, ble_hs_startup_empty_ack_cb);
+}
 
-    return 0;
+static void
+ble_hs_startup_evmask2_cb(int status, const uint8_t *params, int params_len,
+                          void *arg)
+{
+    /* Older controllers lack page 2; carry on without it. */
+    if (status != 0) {
+        BLE_HS_LOG(WARN, "ble_hs_startup_set_evmask_tx() failed\n");
+    }
 }
 
 static int
@@ -177,7 +224,7 @@ ble_hs_startup_set_evmask_tx(void)
      *     0x2000000000000000 LE Meta-Event
      */
     ble_hs_hci_cmd_build_set_event_mask(0x20009807ffffffff, buf, sizeof buf);
-    rc = ble_hs_hci_cmd_tx_empty_ack(buf);
+    rc = ble_hs_startup_tx(buf, ble_hs_startup_empty_ack_cb);
     if (rc != 0) {
         return rc;
     }
@@ -187,12 +234,7 @@ ble_hs_startup_set_evmask_tx(void)
      *     0x0000000000800000 Authenticated Payload Timeout Event
      */
     ble_hs_hci_cmd_build_set_event_mask2(0x0000000000800000, buf, sizeof buf);
-    rc = ble_hs_hci_cmd_tx_empty_ack(buf);
-    if (rc != 0) {
-        BLE_HS_LOG(WARN, "ble_hs_startup_set_evmask_tx() failed\n");
-    }
-
-    return 0;
+    return ble_hs_startup_tx(buf, ble_hs_startup_evmask2_cb);
 }
 
 static int
@@ -210,6 +252,12 @@ ble_hs_startup_reset_tx(void)
     return 0;
 }
 
+/**
+ * Brings the controller up.  The reset is sent on its own; the rest of the
+ * sequence is queued at once so the host does not wait out a round trip per
+ * command where the controller accepts several.  Commands go out in the
+ * order they are queued.
+ */
 int
 ble_hs_startup_go(void)
 {
@@ -220,35 +268,38 @@ ble_hs_startup_go(void)
         return rc;
     }
 
+    ble_hs_startup_rc = 0;
+
     /* XXX: Read local supported commands. */
     /* XXX: Read local supported features. */
 
+    /* Stop queueing at the first failure; anything already queued still
+     * has to drain before returning.
+     */
     rc = ble_hs_startup_set_evmask_tx();
-    if (rc != 0) {
-        return rc;
+    if (rc == 0) {
+        rc = ble_hs_startup_le_set_evmask_tx();
     }
-
-    rc = ble_hs_startup_le_set_evmask_tx();
-    if (rc != 0) {
-        return rc;
-    }
-
-    rc = ble_hs_startup_le_read_buf_sz_tx();
-    if (rc != 0) {
-        return rc;
+    if (rc == 0) {
+        rc = ble_hs_startup_le_read_buf_sz_tx();
     }
 
     /* XXX: Read buffer size. */
 
-    rc = ble_hs_startup_le_read_sup_f_tx();
-    if (rc != 0) {
-        return rc;
+    if (rc == 0) {
+        rc = ble_hs_startup_le_read_sup_f_tx();
+    }
+    if (rc == 0) {
+        rc = ble_hs_startup_read_bd_addr();
     }
 
-    rc = ble_hs_startup_read_bd_addr();
+    rc = ble_hs_hci_cmd_wait_async();
     if (rc != 0) {
         return rc;
     }
+    if (ble_hs_startup_rc != 0) {
+        return ble_hs_startup_rc;
+    }
 
     ble_hs_pvcy_set_our_irk(NULL);
 
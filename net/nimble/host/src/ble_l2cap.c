@@ -172,6 +172,13 @@ ble_l2cap_recv_ready(struct ble_l2cap_chan *chan, struct os_mbuf *sdu_rx)
     ble_l2cap_coc_recv_ready(chan, sdu_rx);
 }
 
+int
+ble_l2cap_get_chan_stats(struct ble_l2cap_chan *chan,
+                         struct ble_l2cap_chan_stats *out_stats)
+{
+    return ble_l2cap_coc_get_stats(chan, out_stats);
+}
+
 void
 ble_l2cap_remove_rx(struct ble_hs_conn *conn, struct ble_l2cap_chan *chan)
 {
@@ -304,6 +311,10 @@ ble_l2cap_rx(struct ble_hs_conn *conn,
 
     *out_reject_cid = -1;
 
+#if MYNEWT_VAL(BLE_GAP_CONN_POLICY)
+    ble_gap_policy_traffic(conn, OS_MBUF_PKTLEN(om));
+#endif
+
     pb = BLE_HCI_DATA_PB(hci_hdr->hdh_handle_pb_bc);
     switch (pb) {
     case BLE_HCI_PB_FIRST_FLUSH:
@@ -118,6 +118,75 @@ ble_l2cap_coc_srv_find(uint16_t psm)
     return srv;
 }
 
+#if MYNEWT_VAL(BLE_L2CAP_COC_AUTO_CREDITS)
+/**
+ * Estimates how many more incoming LE frames the host can buffer.  Each frame
+ * is assumed to occupy one msys block while it waits to be processed.
+ */
+static uint16_t
+ble_l2cap_coc_msys_frames(void)
+{
+    int avail;
+
+    avail = os_msys_num_free() - MYNEWT_VAL(BLE_L2CAP_COC_MSYS_RESERVE);
+    if (avail <= 0) {
+        return 0;
+    }
+
+    return avail;
+}
+
+/**
+ * Tops up the peer's credits to the channel's current target.  The target
+ * doubles whenever the peer runs out of credits, shrinks when it holds on to
+ * them, and is capped by the msys blocks available for incoming frames.
+ *
+ * Only updates the channel's accounting; the caller sends the returned
+ * grant, if nonzero, with ble_l2cap_sig_le_credits() once it no longer holds
+ * the host lock.
+ *
+ * @return                      The number of credits to grant the peer.
+ */
+static uint16_t
+ble_l2cap_coc_auto_credits(struct ble_l2cap_chan *chan)
+{
+    struct ble_l2cap_coc_endpoint *rx;
+    uint16_t limit;
+    uint16_t grant;
+
+    rx = &chan->coc_rx;
+
+    /* Nowhere to put received data until the application provides a
+     * buffer.
+     */
+    if (rx->sdu == NULL) {
+        return 0;
+    }
+
+    /* Back off when buffers run low, but always allow a full SDU. */
+    limit = ble_l2cap_coc_msys_frames();
+    if (chan->target_credits > limit) {
+        chan->target_credits = max(limit, chan->initial_credits);
+    }
+
+    /* Wait until the peer has used half of its credits; this keeps the number
+     * of credit packets down.
+     */
+    if (rx->credits > chan->target_credits / 2) {
+        return 0;
+    }
+
+    grant = chan->target_credits - rx->credits;
+    rx->credits += grant;
+    chan->stats.credits_granted += grant;
+
+    BLE_HS_LOG(DEBUG, "Granting %d credits, target=%d\n",
+               grant, chan->target_credits);
+
+    return grant;
+}
+#endif
+
 static void
 ble_l2cap_event_coc_received_data(struct ble_l2cap_chan *chan,
                                   struct os_mbuf *om)
@@ -131,6 +200,19 @@ ble_l2cap_event_coc_received_data(struct ble_l2cap_chan *chan,
     chan->cb(&event, chan->cb_arg);
 }
 
+static void
+ble_l2cap_event_coc_unstalled(struct ble_l2cap_chan *chan, int status)
+{
+    struct ble_l2cap_event event;
+
+    event.type = BLE_L2CAP_EVENT_COC_TX_UNSTALLED;
+    event.tx_unstalled.conn_handle = chan->conn_handle;
+    event.tx_unstalled.chan = chan;
+    event.tx_unstalled.status = status;
+
+    chan->cb(&event, chan->cb_arg);
+}
+
 static int
 ble_l2cap_coc_rx_fn(struct ble_l2cap_chan *chan)
 {
@@ -138,6 +220,9 @@ ble_l2cap_coc_rx_fn(struct ble_l2cap_chan *chan)
     struct os_mbuf **om;
     struct ble_l2cap_coc_endpoint *rx;
     uint16_t om_total;
+#if MYNEWT_VAL(BLE_L2CAP_COC_AUTO_CREDITS)
+    uint16_t grant;
+#endif
 
     /* Create a shortcut to rx_buf */
     om = &chan->rx_buf;
@@ -146,6 +231,12 @@ ble_l2cap_coc_rx_fn(struct ble_l2cap_chan *chan)
     /* Create a shortcut to rx endpoint */
     rx = &chan->coc_rx;
 
+    if (rx->sdu == NULL) {
+        /* The application has not provided a buffer for the next SDU. */
+        BLE_HS_LOG(INFO, "error: no SDU buffer; dropping LE frame\n");
+        return BLE_HS_ENOMEM;
+    }
+
     om_total = OS_MBUF_PKTLEN(*om);
     rc = ble_hs_mbuf_pullup_base(om, om_total);
     if (rc != 0) {
@@ -180,6 +271,7 @@ ble_l2cap_coc_rx_fn(struct ble_l2cap_chan *chan)
 
         /* In RX case data_offset keeps incoming SDU len */
         rx->data_offset = sdu_len;
+        chan->stats.rx_bytes += om_total - BLE_L2CAP_SDU_SIZE;
 
     } else {
         BLE_HS_LOG(DEBUG, "Continuation...received %d\n", (*om)->om_len);
@@ -190,9 +282,22 @@ ble_l2cap_coc_rx_fn(struct ble_l2cap_chan *chan)
             BLE_HS_LOG(DEBUG, "Could not append data rc=%d\n", rc);
             assert(0);
         }
+        chan->stats.rx_bytes += om_total;
     }
 
     rx->credits--;
+    chan->stats.rx_frames++;
+
+#if MYNEWT_VAL(BLE_L2CAP_COC_AUTO_CREDITS)
+    /* The peer used up its credits before we gave it more; let it have more
+     * in flight.
+     */
+    if (rx->credits == 0) {
+        chan->target_credits = min(chan->target_credits * 2,
+                                   max(MYNEWT_VAL(BLE_L2CAP_COC_MAX_CREDITS),
+                                       chan->initial_credits));
+    }
+#endif
 
     if (OS_MBUF_PKTLEN(rx->sdu) == rx->data_offset) {
         struct os_mbuf *sdu_rx = rx->sdu;
@@ -206,12 +311,24 @@ ble_l2cap_coc_rx_fn(struct ble_l2cap_chan *chan)
          */
         rx->sdu = NULL;
         rx->data_offset = 0;
+        chan->stats.rx_sdus++;
 
         ble_l2cap_event_coc_received_data(chan, sdu_rx);
 
         return 0;
     }
 
+    if (rx->credits == 0) {
+        chan->stats.rx_credit_stalls++;
+    }
+
+#if MYNEWT_VAL(BLE_L2CAP_COC_AUTO_CREDITS)
+    grant = ble_l2cap_coc_auto_credits(chan);
+    if (grant != 0) {
+        ble_l2cap_sig_le_credits(chan->conn_handle, chan->scid, grant);
+    }
+#else
+
     /* If we did not received full SDU and credits are 0 it means
      * that remote was sending us not fully filled up LE frames.
      * However, we still have buffer to for next LE Frame so lets give one more
@@ -222,8 +339,10 @@ ble_l2cap_coc_rx_fn(struct ble_l2cap_chan *chan)
          * so since we have still buffer to handle it
          */
         rx->credits = 1;
+        chan->stats.credits_granted++;
         ble_l2cap_sig_le_credits(chan->conn_handle, chan->scid, rx->credits);
     }
+#endif
 
     BLE_HS_LOG(DEBUG, "Received partial sdu_len=%d, credits left=%d\n",
                OS_MBUF_PKTLEN(rx->sdu), rx->credits);
@@ -258,6 +377,9 @@ ble_l2cap_coc_chan_alloc(uint16_t conn_handle, uint16_t psm, uint16_t mtu,
     chan->coc_rx.credits = (mtu + (chan->my_mtu - 1) / 2) / chan->my_mtu;
 
     chan->initial_credits = chan->coc_rx.credits;
+#if MYNEWT_VAL(BLE_L2CAP_COC_AUTO_CREDITS)
+    chan->target_credits = chan->initial_credits;
+#endif
     return chan;
 }
 
@@ -391,6 +513,8 @@ ble_l2cap_coc_continue_tx(struct ble_l2cap_chan *chan)
         } else {
             tx->credits --;
             tx->data_offset += len - sdu_size_offset;
+            chan->stats.tx_frames++;
+            chan->stats.tx_bytes += len - sdu_size_offset;
         }
 
         BLE_HS_LOG(DEBUG, "Sent %d bytes, credits=%d, to send %d bytes \n",
@@ -401,10 +525,16 @@ ble_l2cap_coc_continue_tx(struct ble_l2cap_chan *chan)
                 os_mbuf_free_chain(tx->sdu);
                 tx->sdu = 0;
                 tx->data_offset = 0;
+                chan->stats.tx_sdus++;
                 break;
         }
     }
 
+    if (tx->sdu != NULL) {
+        /* Out of credits; the rest is sent when the peer grants more. */
+        chan->stats.tx_credit_stalls++;
+    }
+
     return 0;
 
 failed:
@@ -421,6 +551,8 @@ ble_l2cap_coc_le_credits_update(uint16_t conn_handle, uint16_t dcid,
 {
     struct ble_hs_conn *conn;
     struct ble_l2cap_chan *chan;
+    int stalled;
+    int rc;
 
     /* remote updated its credits */
     ble_hs_lock();
@@ -444,8 +576,13 @@ ble_l2cap_coc_le_credits_update(uint16_t conn_handle, uint16_t dcid,
     }
 
     chan->coc_tx.credits += credits;
+    stalled = chan->coc_tx.sdu != NULL;
     ble_hs_unlock();
-    ble_l2cap_coc_continue_tx(chan);
+    rc = ble_l2cap_coc_continue_tx(chan);
+
+    if (stalled && chan->coc_tx.sdu == NULL) {
+        ble_l2cap_event_coc_unstalled(chan, rc);
+    }
 }
 
 void
@@ -453,6 +590,9 @@ ble_l2cap_coc_recv_ready(struct ble_l2cap_chan *chan, struct os_mbuf *sdu_rx)
 {
     struct ble_hs_conn *conn;
     struct ble_l2cap_chan *c;
+#if MYNEWT_VAL(BLE_L2CAP_COC_AUTO_CREDITS)
+    uint16_t grant;
+#endif
 
     chan->coc_rx.sdu = sdu_rx;
 
@@ -464,6 +604,23 @@ ble_l2cap_coc_recv_ready(struct ble_l2cap_chan *chan, struct os_mbuf *sdu_rx)
         return;
     }
 
+#if MYNEWT_VAL(BLE_L2CAP_COC_AUTO_CREDITS)
+    /* The peer did not use any credits since the last grant; it does not
+     * need as many.
+     */
+    if (chan->coc_rx.credits >= chan->target_credits &&
+        chan->target_credits > chan->initial_credits) {
+
+        chan->target_credits--;
+    }
+
+    grant = ble_l2cap_coc_auto_credits(chan);
+    ble_hs_unlock();
+
+    if (grant != 0) {
+        ble_l2cap_sig_le_credits(chan->conn_handle, chan->scid, grant);
+    }
+#else
     /* We want to back only that much credits which remote side is missing
      * to be able to send complete SDU.
      */
@@ -472,10 +629,13 @@ ble_l2cap_coc_recv_ready(struct ble_l2cap_chan *chan, struct os_mbuf *sdu_rx)
         ble_l2cap_sig_le_credits(chan->conn_handle, chan->scid,
                                  c->initial_credits - chan->coc_rx.credits);
         ble_hs_lock();
+        chan->stats.credits_granted +=
+            c->initial_credits - chan->coc_rx.credits;
         chan->coc_rx.credits = c->initial_credits;
     }
 
     ble_hs_unlock();
+#endif
 }
 
 int
@@ -498,6 +658,22 @@ ble_l2cap_coc_send(struct ble_l2cap_chan *chan, struct os_mbuf *sdu_tx)
     return ble_l2cap_coc_continue_tx(chan);
 }
 
+int
+ble_l2cap_coc_get_stats(struct ble_l2cap_chan *chan,
+                        struct ble_l2cap_chan_stats *out_stats)
+{
+    /* PSM 0 is used for fixed channels. */
+    if (chan == NULL || chan->psm == 0) {
+        return BLE_HS_EINVAL;
+    }
+
+    ble_hs_lock();
+    *out_stats = chan->stats;
+    ble_hs_unlock();
+
+    return 0;
+}
+
 int
 ble_l2cap_coc_init(void)
 {
@@ -79,6 +79,10 @@ struct ble_l2cap_chan {
     struct ble_l2cap_coc_endpoint coc_rx;
     struct ble_l2cap_coc_endpoint coc_tx;
     uint16_t initial_credits;
+#if MYNEWT_VAL(BLE_L2CAP_COC_AUTO_CREDITS)
+    uint16_t target_credits;
+#endif
+    struct ble_l2cap_chan_stats stats;
     ble_l2cap_event_fn *cb;
     void *cb_arg;
 #endif
@@ -1101,6 +1101,8 @@ ble_l2cap_sig_rx(struct ble_l2cap_chan *chan)
 {
     struct ble_l2cap_sig_hdr hdr;
     ble_l2cap_sig_rx_fn *rx_cb;
+    const void *hdr_data;
+    uint8_t hdr_buf[BLE_L2CAP_SIG_HDR_SZ];
     uint16_t conn_handle;
     struct os_mbuf **om;
     int rc;
@@ -1113,12 +1115,12 @@ ble_l2cap_sig_rx(struct ble_l2cap_chan *chan)
     ble_hs_log_mbuf(*om);
     BLE_HS_LOG(DEBUG, "\n");
 
-    rc = ble_hs_mbuf_pullup_base(om, BLE_L2CAP_SIG_HDR_SZ);
-    if (rc != 0) {
-        return rc;
+    hdr_data = ble_hs_mbuf_peek(*om, 0, sizeof hdr_buf, hdr_buf);
+    if (hdr_data == NULL) {
+        return BLE_HS_EBADDATA;
     }
 
-    ble_l2cap_sig_hdr_parse((*om)->om_data, (*om)->om_len, &hdr);
+    ble_l2cap_sig_hdr_parse(hdr_data, sizeof hdr_buf, &hdr);
 
     /* Strip L2CAP sig header from the front of the mbuf. */
     os_mbuf_adj(*om, BLE_L2CAP_SIG_HDR_SZ);
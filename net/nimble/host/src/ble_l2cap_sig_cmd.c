@@ -37,10 +37,10 @@ ble_l2cap_sig_tx(uint16_t conn_handle, struct os_mbuf *txom)
 }
 
 void
-ble_l2cap_sig_hdr_parse(void *payload, uint16_t len,
+ble_l2cap_sig_hdr_parse(const void *payload, uint16_t len,
                         struct ble_l2cap_sig_hdr *dst)
 {
-    struct ble_l2cap_sig_hdr *src = payload;
+    const struct ble_l2cap_sig_hdr *src = payload;
 
     BLE_HS_DBG_ASSERT(len >= BLE_L2CAP_SIG_HDR_SZ);
 
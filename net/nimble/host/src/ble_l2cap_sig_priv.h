@@ -89,7 +89,7 @@ struct ble_l2cap_sig_le_credits {
     uint16_t credits;
 } __attribute__((packed));
 
-void ble_l2cap_sig_hdr_parse(void *payload, uint16_t len,
+void ble_l2cap_sig_hdr_parse(const void *payload, uint16_t len,
                              struct ble_l2cap_sig_hdr *hdr);
 int ble_l2cap_sig_reject_tx(uint16_t conn_handle,
                             uint8_t id, uint16_t reason,
@@ -393,6 +393,7 @@ ble_sm_proc_free(struct ble_sm_proc *proc)
 
     if (proc != NULL) {
         ble_sm_dbg_assert_not_inserted(proc);
+        ble_sm_sc_proc_free(proc);
 #if MYNEWT_VAL(BLE_HS_DEBUG)
         memset(proc, 0xff, sizeof *proc);
 #endif
@@ -519,7 +520,7 @@ ble_sm_persist_keys(struct ble_sm_proc *proc)
         peer_addr.type = proc->peer_keys.addr_type;
         memcpy(peer_addr.val, proc->peer_keys.addr, sizeof peer_addr.val);
 
-        conn->bhc_peer_addr = peer_addr;
+        ble_hs_conn_set_peer_addr(conn, &peer_addr);
         /* Update identity address in conn.
          * If peer's address was an RPA, we store it as RPA since peer's address
          * will not be an identity address. The peer's address type has to be
@@ -2506,7 +2507,10 @@ ble_sm_init(void)
         return rc;
     }
 
-    ble_sm_sc_init();
+    rc = ble_sm_sc_init();
+    if (rc != 0) {
+        return rc;
+    }
 
     return 0;
 }
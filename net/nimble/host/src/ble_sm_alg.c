@@ -31,9 +31,14 @@
 #include "tinycrypt/aes.h"
 #include "tinycrypt/constants.h"
 #include "tinycrypt/utils.h"
+#if MYNEWT_VAL(BLE_SM_ALG_HAL_AES)
+#include "hal/hal_aes.h"
+#endif
 
 #if MYNEWT_VAL(BLE_SM_SC)
+#if !MYNEWT_VAL(BLE_SM_ALG_HCI_AES) && !MYNEWT_VAL(BLE_SM_ALG_HAL_AES)
 #include "tinycrypt/cmac_mode.h"
+#endif
 #include "tinycrypt/ecc_dh.h"
 #endif
 
@@ -47,6 +52,53 @@ ble_sm_alg_xor_128(uint8_t *p, uint8_t *q, uint8_t *r)
     }
 }
 
+#if MYNEWT_VAL(BLE_SM_ALG_HCI_AES)
+
+/**
+ * Encrypts a block with the controller's AES engine (HCI LE Encrypt).  On
+ * the nrf5x controllers this runs on the radio's ECB peripheral.  All
+ * buffers are little-endian.
+ */
+static int
+ble_sm_alg_encrypt(uint8_t *key, uint8_t *plaintext, uint8_t *enc_data)
+{
+    int rc;
+
+    rc = ble_hs_hci_util_encrypt(key, plaintext, enc_data);
+    if (rc != 0) {
+        return BLE_HS_EUNKNOWN;
+    }
+
+    return 0;
+}
+
+#elif MYNEWT_VAL(BLE_SM_ALG_HAL_AES)
+
+/**
+ * Encrypts a block with the MCU's AES engine (hal_aes128_encrypt()), as
+ * the LoRa MAC does with LORA_NODE_CRYPTO_HAL.  All buffers are
+ * little-endian.
+ */
+static int
+ble_sm_alg_encrypt(uint8_t *key, uint8_t *plaintext, uint8_t *enc_data)
+{
+    uint8_t key_be[16];
+    uint8_t in_be[16];
+
+    swap_buf(key_be, key, 16);
+    swap_buf(in_be, plaintext, 16);
+
+    if (hal_aes128_encrypt(key_be, in_be, enc_data) != 0) {
+        return BLE_HS_EUNKNOWN;
+    }
+
+    swap_in_place(enc_data, 16);
+
+    return 0;
+}
+
+#else
+
 static int
 ble_sm_alg_encrypt(uint8_t *key, uint8_t *plaintext, uint8_t *enc_data)
 {
@@ -72,6 +124,8 @@ ble_sm_alg_encrypt(uint8_t *key, uint8_t *plaintext, uint8_t *enc_data)
     return 0;
 }
 
+#endif
+
 int
 ble_sm_alg_s1(uint8_t *k, uint8_t *r1, uint8_t *r2, uint8_t *out)
 {
@@ -195,6 +249,115 @@ ble_sm_alg_log_buf(const char *name, const uint8_t *buf, int len)
  * @param len                   Length of the message in octets.
  * @param out                   Output; message authentication code.
  */
+#if MYNEWT_VAL(BLE_SM_ALG_HCI_AES) || MYNEWT_VAL(BLE_SM_ALG_HAL_AES)
+
+/**
+ * AES-128 with big-endian buffers, as used by the CMAC based functions.
+ */
+static int
+ble_sm_alg_encrypt_be(const uint8_t *key, const uint8_t *in, uint8_t *out)
+{
+#if MYNEWT_VAL(BLE_SM_ALG_HAL_AES)
+    if (hal_aes128_encrypt(key, in, out) != 0) {
+        return BLE_HS_EUNKNOWN;
+    }
+
+    return 0;
+#else
+    uint8_t key_le[16];
+    uint8_t in_le[16];
+    int rc;
+
+    swap_buf(key_le, key, 16);
+    swap_buf(in_le, in, 16);
+
+    rc = ble_sm_alg_encrypt(key_le, in_le, out);
+    if (rc != 0) {
+        return rc;
+    }
+
+    swap_in_place(out, 16);
+
+    return 0;
+#endif
+}
+
+/**
+ * Derives the next CMAC subkey from the previous one (RFC 4493, 2.3).
+ */
+static void
+ble_sm_alg_cmac_subkey(uint8_t *k)
+{
+    uint8_t msb;
+    int i;
+
+    msb = k[0] & 0x80;
+    for (i = 0; i < 15; i++) {
+        k[i] = (k[i] << 1) | (k[i + 1] >> 7);
+    }
+    k[15] <<= 1;
+
+    if (msb) {
+        k[15] ^= 0x87;
+    }
+}
+
+static int
+ble_sm_alg_aes_cmac(const uint8_t *key, const uint8_t *in, size_t len,
+                    uint8_t *out)
+{
+    uint8_t subkey[16];
+    uint8_t block[16];
+    uint8_t mac[16];
+    size_t num_blocks;
+    size_t off;
+    size_t i;
+    int rc;
+
+    /* L = AES-128(K, 0); K1 = L << 1 (with reduction). */
+    memset(subkey, 0, sizeof subkey);
+    rc = ble_sm_alg_encrypt_be(key, subkey, subkey);
+    if (rc != 0) {
+        return rc;
+    }
+    ble_sm_alg_cmac_subkey(subkey);
+
+    num_blocks = (len + 15) / 16;
+    if (num_blocks == 0) {
+        num_blocks = 1;
+    }
+
+    memset(mac, 0, sizeof mac);
+    for (i = 0, off = 0; i < num_blocks; i++, off += 16) {
+        if (i < num_blocks - 1) {
+            memcpy(block, in + off, 16);
+        } else if (len - off == 16) {
+            memcpy(block, in + off, 16);
+            ble_sm_alg_xor_128(block, subkey, block);
+        } else {
+            /* Incomplete last block: pad and use K2. */
+            memset(block, 0, sizeof block);
+            memcpy(block, in + off, len - off);
+            block[len - off] = 0x80;
+
+            ble_sm_alg_cmac_subkey(subkey);
+            ble_sm_alg_xor_128(block, subkey, block);
+        }
+
+        ble_sm_alg_xor_128(mac, block, mac);
+        rc = ble_sm_alg_encrypt_be(key, mac, mac);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    memcpy(out, mac, sizeof mac);
+
+    return 0;
+}
+
+#else
+
 static int
 ble_sm_alg_aes_cmac(const uint8_t *key, const uint8_t *in, size_t len,
                     uint8_t *out)
@@ -217,6 +380,8 @@ ble_sm_alg_aes_cmac(const uint8_t *key, const uint8_t *in, size_t len,
     return 0;
 }
 
+#endif
+
 int
 ble_sm_alg_f4(uint8_t *u, uint8_t *v, uint8_t *x, uint8_t z,
               uint8_t *out_enc_data)
@@ -20,6 +20,7 @@
 #include <string.h>
 
 #include "nimble/nimble_opt.h"
+#include "stats/stats.h"
 #include "host/ble_sm.h"
 #include "ble_hs_priv.h"
 #include "ble_sm_priv.h"
@@ -29,6 +30,22 @@
 #define BLE_SM_SC_PASSKEY_BYTES     4
 #define BLE_SM_SC_PASSKEY_BITS      20
 
+/* Statistics. */
+STATS_SECT_START(ble_sm_sc_stats)
+    STATS_SECT_ENTRY(key_gen)
+    STATS_SECT_ENTRY(key_gen_ms)
+    STATS_SECT_ENTRY(key_cache_hit)
+    STATS_SECT_ENTRY(key_cache_miss)
+STATS_SECT_END
+
+STATS_SECT_DECL(ble_sm_sc_stats) ble_sm_sc_stats;
+STATS_NAME_START(ble_sm_sc_stats)
+    STATS_NAME(ble_sm_sc_stats, key_gen)
+    STATS_NAME(ble_sm_sc_stats, key_gen_ms)
+    STATS_NAME(ble_sm_sc_stats, key_cache_hit)
+    STATS_NAME(ble_sm_sc_stats, key_cache_miss)
+STATS_NAME_END(ble_sm_sc_stats)
+
 /**
  * The public and private keys are stored in unions.  Some crypto functions
  * accept pointers to uint32_t; others accept pointers to uint8_t.  The use of
@@ -49,6 +66,33 @@ static union {
  */
 static uint8_t ble_sm_sc_keys_generated;
 
+#if MYNEWT_VAL(BLE_SM_SC_KEY_TASK)
+
+/**
+ * The next key pair, precomputed by the key task.  The key task only writes
+ * these while ble_sm_sc_next_keys_ready is clear; the host only reads them
+ * while it is set.
+ */
+static union {
+    uint32_t u32[16];
+    uint8_t u8[64];
+} ble_sm_sc_next_pub_key;
+static union {
+    uint32_t u32[8];
+    uint8_t u8[32];
+} ble_sm_sc_next_priv_key;
+static volatile uint8_t ble_sm_sc_next_keys_ready;
+
+/** Number of pairing procedures using the current key pair. */
+static uint8_t ble_sm_sc_key_users;
+
+static struct os_task ble_sm_sc_key_task;
+static struct os_sem ble_sm_sc_key_sem;
+static os_stack_t ble_sm_sc_key_stack[
+    OS_STACK_ALIGN(MYNEWT_VAL(BLE_SM_SC_KEY_TASK_STACK_SIZE))];
+
+#endif
+
 /**
  * Create some shortened names for the passkey actions so that the table is
  * easier to read.
@@ -160,6 +204,84 @@ ble_sm_sc_io_action(struct ble_sm_proc *proc, uint8_t *action)
     return 0;
 }
 
+/**
+ * Generates a key pair in the calling task and records how long it took.
+ */
+static int
+ble_sm_sc_gen_key_pair_timed(void *pub, uint32_t *priv)
+{
+    os_time_t start;
+    int rc;
+
+    start = os_time_get();
+
+    rc = ble_sm_alg_gen_key_pair(pub, priv);
+    if (rc != 0) {
+        return rc;
+    }
+
+    STATS_INC(ble_sm_sc_stats, key_gen);
+    STATS_INCN(ble_sm_sc_stats, key_gen_ms,
+               (uint32_t)(os_time_get() - start) * 1000 / OS_TICKS_PER_SEC);
+
+    return 0;
+}
+
+#if MYNEWT_VAL(BLE_SM_SC_KEY_TASK)
+
+/**
+ * Takes the precomputed key pair, if there is one, and wakes the key task to
+ * compute the next.
+ *
+ * @return                      1 if a precomputed pair was taken; else 0.
+ */
+static int
+ble_sm_sc_next_keys_take(void *pub, uint32_t *priv)
+{
+    int taken;
+
+    taken = ble_sm_sc_next_keys_ready;
+    if (taken) {
+        memcpy(pub, ble_sm_sc_next_pub_key.u8, 64);
+        memcpy(priv, ble_sm_sc_next_priv_key.u8, 32);
+        ble_sm_sc_next_keys_ready = 0;
+    }
+
+    os_sem_release(&ble_sm_sc_key_sem);
+
+    return taken;
+}
+
+/**
+ * Computes a key pair ahead of the next pairing procedure.  This task runs
+ * at low priority, so the expensive ECC math comes out of idle time rather
+ * than out of the host task while a peer is waiting.
+ */
+static void
+ble_sm_sc_key_task_handler(void *arg)
+{
+    int rc;
+
+    while (1) {
+        os_sem_pend(&ble_sm_sc_key_sem, OS_TIMEOUT_NEVER);
+
+        /* Key generation uses the controller's random number generator. */
+        while (!ble_hs_synced()) {
+            os_time_delay(OS_TICKS_PER_SEC);
+        }
+
+        if (!ble_sm_sc_next_keys_ready) {
+            rc = ble_sm_sc_gen_key_pair_timed(ble_sm_sc_next_pub_key.u32,
+                                              ble_sm_sc_next_priv_key.u32);
+            if (rc == 0) {
+                ble_sm_sc_next_keys_ready = 1;
+            }
+        }
+    }
+}
+
+#endif
+
 static int
 ble_sm_gen_pub_priv(void *pub, uint32_t *priv)
 {
@@ -174,7 +296,15 @@ ble_sm_gen_pub_priv(void *pub, uint32_t *priv)
     }
 #endif
 
-    rc = ble_sm_alg_gen_key_pair(pub, priv);
+#if MYNEWT_VAL(BLE_SM_SC_KEY_TASK)
+    if (ble_sm_sc_next_keys_take(pub, priv)) {
+        STATS_INC(ble_sm_sc_stats, key_cache_hit);
+        return 0;
+    }
+    STATS_INC(ble_sm_sc_stats, key_cache_miss);
+#endif
+
+    rc = ble_sm_sc_gen_key_pair_timed(pub, priv);
     if (rc != 0) {
         return rc;
     }
@@ -207,6 +337,22 @@ ble_sm_sc_ensure_keys_generated(void)
     return 0;
 }
 
+/**
+ * Notes that the specified procedure is using our current key pair.  With
+ * the key task enabled, the pair is retired once every procedure using it
+ * has completed.
+ */
+static void
+ble_sm_sc_key_use(struct ble_sm_proc *proc)
+{
+#if MYNEWT_VAL(BLE_SM_SC_KEY_TASK)
+    if (!(proc->flags & BLE_SM_PROC_F_SC_KEY)) {
+        proc->flags |= BLE_SM_PROC_F_SC_KEY;
+        ble_sm_sc_key_users++;
+    }
+#endif
+}
+
 /* Initiator does not send a confirm when pairing algorithm is any of:
  *     o just works
  *     o numeric comparison
@@ -516,6 +662,7 @@ ble_sm_sc_public_key_exec(struct ble_sm_proc *proc, struct ble_sm_result *res,
         res->sm_err = BLE_SM_ERR_UNSPECIFIED;
         return;
     }
+    ble_sm_sc_key_use(proc);
 
     cmd = ble_sm_cmd_get(BLE_SM_OP_PAIR_PUBLIC_KEY, sizeof(*cmd), &txom);
     if (!cmd) {
@@ -588,6 +735,8 @@ ble_sm_sc_public_key_rx(uint16_t conn_handle, struct os_mbuf **om,
         res->app_status = BLE_HS_ENOENT;
         res->sm_err = BLE_SM_ERR_UNSPECIFIED;
     } else {
+        ble_sm_sc_key_use(proc);
+
         memcpy(&proc->pub_key_peer, cmd, sizeof(*cmd));
         rc = ble_sm_alg_gen_dhkey(proc->pub_key_peer.x,
                                   proc->pub_key_peer.y,
@@ -793,10 +942,63 @@ ble_sm_sc_dhkey_check_rx(uint16_t conn_handle, struct os_mbuf **om,
     ble_hs_unlock();
 }
 
+/**
+ * Called when an SM procedure is freed.  Once no procedure is using the
+ * current key pair, it is retired; the next pairing uses a freshly computed
+ * one.
+ */
 void
+ble_sm_sc_proc_free(struct ble_sm_proc *proc)
+{
+#if MYNEWT_VAL(BLE_SM_SC_KEY_TASK)
+    if (proc->flags & BLE_SM_PROC_F_SC_KEY) {
+        BLE_HS_DBG_ASSERT(ble_sm_sc_key_users > 0);
+
+        ble_sm_sc_key_users--;
+        if (ble_sm_sc_key_users == 0) {
+            ble_sm_sc_keys_generated = 0;
+        }
+    }
+#endif
+}
+
+int
 ble_sm_sc_init(void)
 {
+    int rc;
+
     ble_sm_sc_keys_generated = 0;
+
+#if MYNEWT_VAL(BLE_SM_SC_KEY_TASK)
+    ble_sm_sc_key_users = 0;
+
+    /* The key task survives host resets; only start it once. */
+    if (ble_sm_sc_key_task.t_func == NULL) {
+        rc = os_sem_init(&ble_sm_sc_key_sem, 1);
+        if (rc != 0) {
+            return BLE_HS_EOS;
+        }
+
+        rc = os_task_init(&ble_sm_sc_key_task, "ble_sm_key",
+                          ble_sm_sc_key_task_handler, NULL,
+                          MYNEWT_VAL(BLE_SM_SC_KEY_TASK_PRIO),
+                          OS_WAIT_FOREVER, ble_sm_sc_key_stack,
+                          OS_STACK_ALIGN(
+                              MYNEWT_VAL(BLE_SM_SC_KEY_TASK_STACK_SIZE)));
+        if (rc != 0) {
+            return BLE_HS_EOS;
+        }
+    }
+#endif
+
+    rc = stats_init_and_reg(
+        STATS_HDR(ble_sm_sc_stats), STATS_SIZE_INIT_PARMS(ble_sm_sc_stats,
+        STATS_SIZE_32), STATS_NAME_INIT_PARMS(ble_sm_sc_stats), "ble_sm_sc");
+    if (rc != 0) {
+        return BLE_HS_EOS;
+    }
+
+    return 0;
 }
 
 #endif  /* MYNEWT_VAL(BLE_SM_SC) */
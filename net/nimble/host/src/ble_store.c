@@ -225,6 +225,52 @@ ble_store_key_from_value_cccd(struct ble_store_key_cccd *out_key,
     out_key->idx = 0;
 }
 
+int
+ble_store_read_gatt(const struct ble_store_key_gatt *key,
+                    struct ble_store_value_gatt *out_value)
+{
+    union ble_store_value *store_value;
+    union ble_store_key *store_key;
+    int rc;
+
+    store_key = (void *)key;
+    store_value = (void *)out_value;
+    rc = ble_store_read(BLE_STORE_OBJ_TYPE_GATT, store_key, store_value);
+    return rc;
+}
+
+int
+ble_store_write_gatt(const struct ble_store_value_gatt *value)
+{
+    union ble_store_value *store_value;
+    int rc;
+
+    store_value = (void *)value;
+    rc = ble_store_write(BLE_STORE_OBJ_TYPE_GATT, store_value);
+    return rc;
+}
+
+int
+ble_store_delete_gatt(const struct ble_store_key_gatt *key)
+{
+    union ble_store_key *store_key;
+    int rc;
+
+    store_key = (void *)key;
+    rc = ble_store_delete(BLE_STORE_OBJ_TYPE_GATT, store_key);
+    return rc;
+}
+
+void
+ble_store_key_from_value_gatt(struct ble_store_key_gatt *out_key,
+                              const struct ble_store_value_gatt *value)
+{
+    out_key->peer_addr = value->peer_addr;
+    out_key->attr_type = value->attr_type;
+    out_key->handle = value->handle;
+    out_key->idx = 0;
+}
+
 void
 ble_store_key_from_value_sec(struct ble_store_key_sec *out_key,
                              const struct ble_store_value_sec *value)
@@ -252,6 +298,10 @@ ble_store_key_from_value(int obj_type,
         ble_store_key_from_value_cccd(&out_key->cccd, &value->cccd);
         break;
 
+    case BLE_STORE_OBJ_TYPE_GATT:
+        ble_store_key_from_value_gatt(&out_key->gatt, &value->gatt);
+        break;
+
     default:
         BLE_HS_DBG_ASSERT(0);
         break;
@@ -281,6 +331,10 @@ ble_store_iterate(int obj_type,
             key.cccd.peer_addr = *BLE_ADDR_ANY;
             pidx = &key.cccd.idx;
             break;
+        case BLE_STORE_OBJ_TYPE_GATT:
+            key.gatt.peer_addr = *BLE_ADDR_ANY;
+            pidx = &key.gatt.idx;
+            break;
         default:
             BLE_HS_DBG_ASSERT(0);
             return BLE_HS_EINVAL;
@@ -0,0 +1,1167 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * This file implements a persistent key database for BLE host security
+ * material, CCCDs, and cached GATT attributes.  Records are kept in RAM and
+ * persisted through sys/config, one config value per record
+ * ("ble_store/<table>/<slot>"), so changing a single bond only rewrites that
+ * bond.
+ *
+ * Security records are indexed twice: by peer address and by EDIV/rand.  Both
+ * indices are sorted arrays of slot numbers, giving logarithmic lookups on
+ * the two keys the host actually uses (reconnection by identity address and
+ * LTK requests by EDIV/rand).
+ *
+ * Modified records are only marked dirty; they are written out together
+ * BLE_STORE_CONFIG_FLUSH_DELAY_MS after the first change, or whenever
+ * ble_store_config_flush() is called.
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sysinit/sysinit.h"
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "config/config.h"
+#include "host/ble_hs.h"
+#include "store/config/ble_store_config.h"
+
+#define BLE_STORE_CONFIG_MAP_SZ(n)      (((n) + 7) / 8)
+
+#define BLE_STORE_CONFIG_VAL_STR_LEN                                        \
+    CONF_STR_FROM_BYTES_LEN(sizeof (union ble_store_value))
+
+/** A fixed-slot array of records of a single object type. */
+struct ble_store_config_tbl {
+    /** Second component of each record's config name. */
+    const char *name;
+
+    void *values;
+    uint16_t value_size;
+    uint16_t max;
+    uint16_t num;
+
+    /** Bitmap of occupied slots. */
+    uint8_t *used;
+
+    /** Bitmap of slots whose contents differ from flash. */
+    uint8_t *dirty;
+};
+
+/** Security table with its two sorted indices. */
+struct ble_store_config_sec_tbl {
+    struct ble_store_config_tbl tbl;
+
+    /** Occupied slots, sorted by (peer_addr, ediv, rand_num). */
+    uint16_t *by_addr;
+
+    /** Occupied slots, sorted by (ediv, rand_num, peer_addr). */
+    uint16_t *by_ediv;
+};
+
+static struct ble_store_value_sec
+    ble_store_config_our_sec_vals[MYNEWT_VAL(BLE_STORE_MAX_BONDS)];
+static uint16_t
+    ble_store_config_our_sec_by_addr[MYNEWT_VAL(BLE_STORE_MAX_BONDS)];
+static uint16_t
+    ble_store_config_our_sec_by_ediv[MYNEWT_VAL(BLE_STORE_MAX_BONDS)];
+static uint8_t ble_store_config_our_sec_used[
+    BLE_STORE_CONFIG_MAP_SZ(MYNEWT_VAL(BLE_STORE_MAX_BONDS))];
+static uint8_t ble_store_config_our_sec_dirty[
+    BLE_STORE_CONFIG_MAP_SZ(MYNEWT_VAL(BLE_STORE_MAX_BONDS))];
+
+static struct ble_store_value_sec
+    ble_store_config_peer_sec_vals[MYNEWT_VAL(BLE_STORE_MAX_BONDS)];
+static uint16_t
+    ble_store_config_peer_sec_by_addr[MYNEWT_VAL(BLE_STORE_MAX_BONDS)];
+static uint16_t
+    ble_store_config_peer_sec_by_ediv[MYNEWT_VAL(BLE_STORE_MAX_BONDS)];
+static uint8_t ble_store_config_peer_sec_used[
+    BLE_STORE_CONFIG_MAP_SZ(MYNEWT_VAL(BLE_STORE_MAX_BONDS))];
+static uint8_t ble_store_config_peer_sec_dirty[
+    BLE_STORE_CONFIG_MAP_SZ(MYNEWT_VAL(BLE_STORE_MAX_BONDS))];
+
+static struct ble_store_value_cccd
+    ble_store_config_cccd_vals[MYNEWT_VAL(BLE_STORE_MAX_CCCDS)];
+static uint8_t ble_store_config_cccd_used[
+    BLE_STORE_CONFIG_MAP_SZ(MYNEWT_VAL(BLE_STORE_MAX_CCCDS))];
+static uint8_t ble_store_config_cccd_dirty[
+    BLE_STORE_CONFIG_MAP_SZ(MYNEWT_VAL(BLE_STORE_MAX_CCCDS))];
+
+static struct ble_store_value_gatt
+    ble_store_config_gatt_vals[MYNEWT_VAL(BLE_STORE_MAX_GATT_ATTRS)];
+static uint8_t ble_store_config_gatt_used[
+    BLE_STORE_CONFIG_MAP_SZ(MYNEWT_VAL(BLE_STORE_MAX_GATT_ATTRS))];
+static uint8_t ble_store_config_gatt_dirty[
+    BLE_STORE_CONFIG_MAP_SZ(MYNEWT_VAL(BLE_STORE_MAX_GATT_ATTRS))];
+
+static struct ble_store_config_sec_tbl ble_store_config_our_secs = {
+    .tbl = {
+        .name = "our_sec",
+        .values = ble_store_config_our_sec_vals,
+        .value_size = sizeof (struct ble_store_value_sec),
+        .max = MYNEWT_VAL(BLE_STORE_MAX_BONDS),
+        .used = ble_store_config_our_sec_used,
+        .dirty = ble_store_config_our_sec_dirty,
+    },
+    .by_addr = ble_store_config_our_sec_by_addr,
+    .by_ediv = ble_store_config_our_sec_by_ediv,
+};
+
+static struct ble_store_config_sec_tbl ble_store_config_peer_secs = {
+    .tbl = {
+        .name = "peer_sec",
+        .values = ble_store_config_peer_sec_vals,
+        .value_size = sizeof (struct ble_store_value_sec),
+        .max = MYNEWT_VAL(BLE_STORE_MAX_BONDS),
+        .used = ble_store_config_peer_sec_used,
+        .dirty = ble_store_config_peer_sec_dirty,
+    },
+    .by_addr = ble_store_config_peer_sec_by_addr,
+    .by_ediv = ble_store_config_peer_sec_by_ediv,
+};
+
+static struct ble_store_config_tbl ble_store_config_cccds = {
+    .name = "cccd",
+    .values = ble_store_config_cccd_vals,
+    .value_size = sizeof (struct ble_store_value_cccd),
+    .max = MYNEWT_VAL(BLE_STORE_MAX_CCCDS),
+    .used = ble_store_config_cccd_used,
+    .dirty = ble_store_config_cccd_dirty,
+};
+
+static struct ble_store_config_tbl ble_store_config_gatts = {
+    .name = "gatt",
+    .values = ble_store_config_gatt_vals,
+    .value_size = sizeof (struct ble_store_value_gatt),
+    .max = MYNEWT_VAL(BLE_STORE_MAX_GATT_ATTRS),
+    .used = ble_store_config_gatt_used,
+    .dirty = ble_store_config_gatt_dirty,
+};
+
+static struct ble_store_config_tbl * const ble_store_config_tbls[] = {
+    &ble_store_config_our_secs.tbl,
+    &ble_store_config_peer_secs.tbl,
+    &ble_store_config_cccds,
+    &ble_store_config_gatts,
+};
+
+#define BLE_STORE_CONFIG_NUM_TBLS                                           \
+    (sizeof ble_store_config_tbls / sizeof ble_store_config_tbls[0])
+
+static struct os_callout ble_store_config_flush_timer;
+
+static char *ble_store_config_conf_get(int argc, char **argv, char *buf,
+                                       int max_len);
+static int ble_store_config_conf_set(int argc, char **argv, char *val);
+static int ble_store_config_conf_export(
+    void (*export_func)(char *name, char *val), enum conf_export_tgt tgt);
+
+static struct conf_handler ble_store_config_conf_handler = {
+    .ch_name = "ble_store",
+    .ch_get = ble_store_config_conf_get,
+    .ch_set = ble_store_config_conf_set,
+    .ch_commit = NULL,
+    .ch_export = ble_store_config_conf_export,
+};
+
+/*****************************************************************************
+ * $table                                                                    *
+ *****************************************************************************/
+
+static int
+ble_store_config_bit_test(const uint8_t *map, int bit)
+{
+    return (map[bit / 8] >> (bit % 8)) & 1;
+}
+
+static void
+ble_store_config_bit_set(uint8_t *map, int bit)
+{
+    map[bit / 8] |= 1 << (bit % 8);
+}
+
+static void
+ble_store_config_bit_clear(uint8_t *map, int bit)
+{
+    map[bit / 8] &= ~(1 << (bit % 8));
+}
+
+static void *
+ble_store_config_tbl_value(const struct ble_store_config_tbl *tbl, int slot)
+{
+    return (uint8_t *)tbl->values + slot * tbl->value_size;
+}
+
+static int
+ble_store_config_tbl_alloc(const struct ble_store_config_tbl *tbl)
+{
+    int slot;
+
+    if (tbl->num >= tbl->max) {
+        return -1;
+    }
+
+    for (slot = 0; slot < tbl->max; slot++) {
+        if (!ble_store_config_bit_test(tbl->used, slot)) {
+            return slot;
+        }
+    }
+
+    return -1;
+}
+
+static void
+ble_store_config_schedule_flush(void)
+{
+#if MYNEWT_VAL(BLE_STORE_CONFIG_FLUSH_DELAY_MS) == 0
+    ble_store_config_flush();
+#else
+    uint32_t ticks;
+    int rc;
+
+    if (os_callout_queued(&ble_store_config_flush_timer)) {
+        /* A flush is already pending; this change will be part of it. */
+        return;
+    }
+
+    rc = os_time_ms_to_ticks(MYNEWT_VAL(BLE_STORE_CONFIG_FLUSH_DELAY_MS),
+                             &ticks);
+    if (rc != 0) {
+        ticks = OS_TICKS_PER_SEC;
+    }
+    os_callout_reset(&ble_store_config_flush_timer, ticks);
+#endif
+}
+
+static void
+ble_store_config_tbl_mark_dirty(struct ble_store_config_tbl *tbl, int slot)
+{
+    ble_store_config_bit_set(tbl->dirty, slot);
+    ble_store_config_schedule_flush();
+}
+
+static void
+ble_store_config_tbl_fill(struct ble_store_config_tbl *tbl, int slot,
+                          const void *value)
+{
+    if (!ble_store_config_bit_test(tbl->used, slot)) {
+        ble_store_config_bit_set(tbl->used, slot);
+        tbl->num++;
+    }
+    memcpy(ble_store_config_tbl_value(tbl, slot), value, tbl->value_size);
+}
+
+static void
+ble_store_config_tbl_clear(struct ble_store_config_tbl *tbl, int slot)
+{
+    if (ble_store_config_bit_test(tbl->used, slot)) {
+        ble_store_config_bit_clear(tbl->used, slot);
+        tbl->num--;
+    }
+}
+
+static void
+ble_store_config_tbl_reset(struct ble_store_config_tbl *tbl)
+{
+    memset(tbl->used, 0, BLE_STORE_CONFIG_MAP_SZ(tbl->max));
+    memset(tbl->dirty, 0, BLE_STORE_CONFIG_MAP_SZ(tbl->max));
+    tbl->num = 0;
+}
+
+static int
+ble_store_config_tbl_persist(struct ble_store_config_tbl *tbl, int slot)
+{
+    char name[CONF_MAX_NAME_LEN];
+    char buf[BLE_STORE_CONFIG_VAL_STR_LEN];
+    char *val;
+    int rc;
+
+    snprintf(name, sizeof name, "%s/%s/%d",
+             ble_store_config_conf_handler.ch_name, tbl->name, slot);
+
+    if (ble_store_config_bit_test(tbl->used, slot)) {
+        val = conf_str_from_bytes(ble_store_config_tbl_value(tbl, slot),
+                                  tbl->value_size, buf, sizeof buf);
+        if (val == NULL) {
+            return BLE_HS_EINVAL;
+        }
+    } else {
+        /* An empty value erases the record. */
+        val = NULL;
+    }
+
+    rc = conf_save_one(name, val);
+    if (rc != 0) {
+        return BLE_HS_EOS;
+    }
+
+    return 0;
+}
+
+/*****************************************************************************
+ * $sec                                                                      *
+ *****************************************************************************/
+
+static struct ble_store_value_sec *
+ble_store_config_sec_value(const struct ble_store_config_sec_tbl *sec_tbl,
+                           int slot)
+{
+    return ble_store_config_tbl_value(&sec_tbl->tbl, slot);
+}
+
+static int
+ble_store_config_cmp_ediv_rand(uint16_t ediv_a, uint64_t rand_a,
+                               uint16_t ediv_b, uint64_t rand_b)
+{
+    if (ediv_a != ediv_b) {
+        return ediv_a < ediv_b ? -1 : 1;
+    }
+    if (rand_a != rand_b) {
+        return rand_a < rand_b ? -1 : 1;
+    }
+    return 0;
+}
+
+static int
+ble_store_config_cmp_addr_order(const struct ble_store_value_sec *a,
+                                const struct ble_store_value_sec *b)
+{
+    int rc;
+
+    rc = ble_addr_cmp(&a->peer_addr, &b->peer_addr);
+    if (rc != 0) {
+        return rc;
+    }
+    return ble_store_config_cmp_ediv_rand(a->ediv, a->rand_num,
+                                          b->ediv, b->rand_num);
+}
+
+static int
+ble_store_config_cmp_ediv_order(const struct ble_store_value_sec *a,
+                                const struct ble_store_value_sec *b)
+{
+    int rc;
+
+    rc = ble_store_config_cmp_ediv_rand(a->ediv, a->rand_num,
+                                        b->ediv, b->rand_num);
+    if (rc != 0) {
+        return rc;
+    }
+    return ble_addr_cmp(&a->peer_addr, &b->peer_addr);
+}
+
+/**
+ * Returns the position of the first by_addr entry whose peer address is not
+ * less than the specified one.
+ */
+static int
+ble_store_config_lower_bound_addr(const struct ble_store_config_sec_tbl *st,
+                                  const ble_addr_t *addr)
+{
+    const struct ble_store_value_sec *cur;
+    int lo;
+    int hi;
+    int mid;
+
+    lo = 0;
+    hi = st->tbl.num;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        cur = ble_store_config_sec_value(st, st->by_addr[mid]);
+        if (ble_addr_cmp(&cur->peer_addr, addr) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+/**
+ * Returns the position of the first by_ediv entry whose EDIV/rand pair is not
+ * less than the specified one.
+ */
+static int
+ble_store_config_lower_bound_ediv(const struct ble_store_config_sec_tbl *st,
+                                  uint16_t ediv, uint64_t rand_num)
+{
+    const struct ble_store_value_sec *cur;
+    int lo;
+    int hi;
+    int mid;
+
+    lo = 0;
+    hi = st->tbl.num;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        cur = ble_store_config_sec_value(st, st->by_ediv[mid]);
+        if (ble_store_config_cmp_ediv_rand(cur->ediv, cur->rand_num,
+                                           ediv, rand_num) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+typedef int ble_store_config_sec_cmp_fn(const struct ble_store_value_sec *a,
+                                        const struct ble_store_value_sec *b);
+
+/**
+ * Inserts a slot into a sorted index.  The index must currently hold
+ * num entries (the slot being inserted not included).
+ */
+static void
+ble_store_config_index_insert(const struct ble_store_config_sec_tbl *st,
+                              uint16_t *index, int num,
+                              ble_store_config_sec_cmp_fn *cmp, int slot)
+{
+    const struct ble_store_value_sec *val;
+    int lo;
+    int hi;
+    int mid;
+
+    val = ble_store_config_sec_value(st, slot);
+
+    lo = 0;
+    hi = num;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (cmp(ble_store_config_sec_value(st, index[mid]), val) <= 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    memmove(index + lo + 1, index + lo, (num - lo) * sizeof *index);
+    index[lo] = slot;
+}
+
+/**
+ * Removes a slot from a sorted index.  The index must currently hold
+ * num entries (the slot being removed included).
+ */
+static void
+ble_store_config_index_remove(const struct ble_store_config_sec_tbl *st,
+                              uint16_t *index, int num,
+                              ble_store_config_sec_cmp_fn *cmp, int slot)
+{
+    const struct ble_store_value_sec *val;
+    int lo;
+    int hi;
+    int mid;
+
+    val = ble_store_config_sec_value(st, slot);
+
+    lo = 0;
+    hi = num;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (cmp(ble_store_config_sec_value(st, index[mid]), val) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    /* Entries with identical keys are adjacent; find this slot among them. */
+    while (lo < num && index[lo] != slot) {
+        lo++;
+    }
+    if (lo >= num) {
+        return;
+    }
+
+    memmove(index + lo, index + lo + 1, (num - lo - 1) * sizeof *index);
+}
+
+/**
+ * Adds an occupied slot to both indices.  Must be called after the slot has
+ * been counted in tbl.num.
+ */
+static void
+ble_store_config_sec_index_add(struct ble_store_config_sec_tbl *st, int slot)
+{
+    ble_store_config_index_insert(st, st->by_addr, st->tbl.num - 1,
+                                  ble_store_config_cmp_addr_order, slot);
+    ble_store_config_index_insert(st, st->by_ediv, st->tbl.num - 1,
+                                  ble_store_config_cmp_ediv_order, slot);
+}
+
+/**
+ * Removes an occupied slot from both indices.  Must be called before the slot
+ * is released.
+ */
+static void
+ble_store_config_sec_index_del(struct ble_store_config_sec_tbl *st, int slot)
+{
+    ble_store_config_index_remove(st, st->by_addr, st->tbl.num,
+                                  ble_store_config_cmp_addr_order, slot);
+    ble_store_config_index_remove(st, st->by_ediv, st->tbl.num,
+                                  ble_store_config_cmp_ediv_order, slot);
+}
+
+static int
+ble_store_config_find_sec(const struct ble_store_config_sec_tbl *st,
+                          const struct ble_store_key_sec *key_sec)
+{
+    const struct ble_store_value_sec *cur;
+    int skipped;
+    int slot;
+    int i;
+
+    skipped = 0;
+
+    if (ble_addr_cmp(&key_sec->peer_addr, BLE_ADDR_ANY)) {
+        i = ble_store_config_lower_bound_addr(st, &key_sec->peer_addr);
+        for (; i < st->tbl.num; i++) {
+            slot = st->by_addr[i];
+            cur = ble_store_config_sec_value(st, slot);
+
+            if (ble_addr_cmp(&cur->peer_addr, &key_sec->peer_addr)) {
+                break;
+            }
+
+            if (key_sec->ediv_rand_present) {
+                if (cur->ediv != key_sec->ediv ||
+                    cur->rand_num != key_sec->rand_num) {
+
+                    continue;
+                }
+            }
+
+            if (key_sec->idx > skipped) {
+                skipped++;
+                continue;
+            }
+
+            return slot;
+        }
+
+        return -1;
+    }
+
+    if (key_sec->ediv_rand_present) {
+        i = ble_store_config_lower_bound_ediv(st, key_sec->ediv,
+                                              key_sec->rand_num);
+        for (; i < st->tbl.num; i++) {
+            slot = st->by_ediv[i];
+            cur = ble_store_config_sec_value(st, slot);
+
+            if (cur->ediv != key_sec->ediv ||
+                cur->rand_num != key_sec->rand_num) {
+
+                break;
+            }
+
+            if (key_sec->idx > skipped) {
+                skipped++;
+                continue;
+            }
+
+            return slot;
+        }
+
+        return -1;
+    }
+
+    if (key_sec->idx < st->tbl.num) {
+        return st->by_addr[key_sec->idx];
+    }
+
+    return -1;
+}
+
+static int
+ble_store_config_read_sec(const struct ble_store_config_sec_tbl *st,
+                          const struct ble_store_key_sec *key_sec,
+                          struct ble_store_value_sec *value_sec)
+{
+    int slot;
+
+    slot = ble_store_config_find_sec(st, key_sec);
+    if (slot == -1) {
+        return BLE_HS_ENOENT;
+    }
+
+    *value_sec = *ble_store_config_sec_value(st, slot);
+    return 0;
+}
+
+static int
+ble_store_config_write_sec(struct ble_store_config_sec_tbl *st,
+                           const struct ble_store_value_sec *value_sec)
+{
+    const struct ble_store_value_sec *cur;
+    struct ble_store_key_sec key_sec;
+    int slot;
+
+    ble_store_key_from_value_sec(&key_sec, value_sec);
+    slot = ble_store_config_find_sec(st, &key_sec);
+    if (slot != -1) {
+        cur = ble_store_config_sec_value(st, slot);
+        if (ble_store_config_cmp_addr_order(cur, value_sec) == 0) {
+            /* Same key; the indices remain valid. */
+            ble_store_config_tbl_fill(&st->tbl, slot, value_sec);
+        } else {
+            /* Matched through a wildcard address; re-sort the record. */
+            ble_store_config_sec_index_del(st, slot);
+            ble_store_config_tbl_fill(&st->tbl, slot, value_sec);
+            ble_store_config_sec_index_add(st, slot);
+        }
+    } else {
+        slot = ble_store_config_tbl_alloc(&st->tbl);
+        if (slot == -1) {
+            BLE_HS_LOG(DEBUG, "error persisting %s; too many entries (%d)\n",
+                       st->tbl.name, st->tbl.num);
+            return BLE_HS_ENOMEM;
+        }
+
+        ble_store_config_tbl_fill(&st->tbl, slot, value_sec);
+        ble_store_config_sec_index_add(st, slot);
+    }
+
+    ble_store_config_tbl_mark_dirty(&st->tbl, slot);
+    return 0;
+}
+
+static int
+ble_store_config_delete_sec(struct ble_store_config_sec_tbl *st,
+                            const struct ble_store_key_sec *key_sec)
+{
+    int slot;
+
+    slot = ble_store_config_find_sec(st, key_sec);
+    if (slot == -1) {
+        return BLE_HS_ENOENT;
+    }
+
+    ble_store_config_sec_index_del(st, slot);
+    ble_store_config_tbl_clear(&st->tbl, slot);
+    ble_store_config_tbl_mark_dirty(&st->tbl, slot);
+    return 0;
+}
+
+/*****************************************************************************
+ * $cccd                                                                     *
+ *****************************************************************************/
+
+static int
+ble_store_config_find_cccd(const struct ble_store_key_cccd *key)
+{
+    struct ble_store_value_cccd *cccd;
+    int skipped;
+    int i;
+
+    skipped = 0;
+    for (i = 0; i < ble_store_config_cccds.max; i++) {
+        if (!ble_store_config_bit_test(ble_store_config_cccds.used, i)) {
+            continue;
+        }
+        cccd = ble_store_config_cccd_vals + i;
+
+        if (ble_addr_cmp(&key->peer_addr, BLE_ADDR_ANY)) {
+            if (ble_addr_cmp(&cccd->peer_addr, &key->peer_addr)) {
+                continue;
+            }
+        }
+
+        if (key->chr_val_handle != 0) {
+            if (cccd->chr_val_handle != key->chr_val_handle) {
+                continue;
+            }
+        }
+
+        if (key->idx > skipped) {
+            skipped++;
+            continue;
+        }
+
+        return i;
+    }
+
+    return -1;
+}
+
+static int
+ble_store_config_delete_cccd(const struct ble_store_key_cccd *key_cccd)
+{
+    int idx;
+
+    idx = ble_store_config_find_cccd(key_cccd);
+    if (idx == -1) {
+        return BLE_HS_ENOENT;
+    }
+
+    ble_store_config_tbl_clear(&ble_store_config_cccds, idx);
+    ble_store_config_tbl_mark_dirty(&ble_store_config_cccds, idx);
+    return 0;
+}
+
+static int
+ble_store_config_read_cccd(const struct ble_store_key_cccd *key_cccd,
+                           struct ble_store_value_cccd *value_cccd)
+{
+    int idx;
+
+    idx = ble_store_config_find_cccd(key_cccd);
+    if (idx == -1) {
+        return BLE_HS_ENOENT;
+    }
+
+    *value_cccd = ble_store_config_cccd_vals[idx];
+    return 0;
+}
+
+static int
+ble_store_config_write_cccd(const struct ble_store_value_cccd *value_cccd)
+{
+    struct ble_store_key_cccd key_cccd;
+    int idx;
+
+    ble_store_key_from_value_cccd(&key_cccd, value_cccd);
+    idx = ble_store_config_find_cccd(&key_cccd);
+    if (idx == -1) {
+        idx = ble_store_config_tbl_alloc(&ble_store_config_cccds);
+        if (idx == -1) {
+            BLE_HS_LOG(DEBUG, "error persisting cccd; too many entries (%d)\n",
+                       ble_store_config_cccds.num);
+            return BLE_HS_ENOMEM;
+        }
+    }
+
+    ble_store_config_tbl_fill(&ble_store_config_cccds, idx, value_cccd);
+    ble_store_config_tbl_mark_dirty(&ble_store_config_cccds, idx);
+    return 0;
+}
+
+/*****************************************************************************
+ * $gatt                                                                     *
+ *****************************************************************************/
+
+static int
+ble_store_config_find_gatt(const struct ble_store_key_gatt *key)
+{
+    struct ble_store_value_gatt *gatt;
+    int skipped;
+    int i;
+
+    skipped = 0;
+    for (i = 0; i < ble_store_config_gatts.max; i++) {
+        if (!ble_store_config_bit_test(ble_store_config_gatts.used, i)) {
+            continue;
+        }
+        gatt = ble_store_config_gatt_vals + i;
+
+        if (ble_addr_cmp(&key->peer_addr, BLE_ADDR_ANY)) {
+            if (ble_addr_cmp(&gatt->peer_addr, &key->peer_addr)) {
+                continue;
+            }
+        }
+
+        if (key->attr_type != 0) {
+            if (gatt->attr_type != key->attr_type) {
+                continue;
+            }
+        }
+
+        if (key->handle != 0) {
+            if (gatt->handle != key->handle) {
+                continue;
+            }
+        }
+
+        if (key->idx > skipped) {
+            skipped++;
+            continue;
+        }
+
+        return i;
+    }
+
+    return -1;
+}
+
+static int
+ble_store_config_delete_gatt(const struct ble_store_key_gatt *key_gatt)
+{
+    int idx;
+
+    idx = ble_store_config_find_gatt(key_gatt);
+    if (idx == -1) {
+        return BLE_HS_ENOENT;
+    }
+
+    ble_store_config_tbl_clear(&ble_store_config_gatts, idx);
+    ble_store_config_tbl_mark_dirty(&ble_store_config_gatts, idx);
+    return 0;
+}
+
+static int
+ble_store_config_read_gatt(const struct ble_store_key_gatt *key_gatt,
+                           struct ble_store_value_gatt *value_gatt)
+{
+    int idx;
+
+    idx = ble_store_config_find_gatt(key_gatt);
+    if (idx == -1) {
+        return BLE_HS_ENOENT;
+    }
+
+    *value_gatt = ble_store_config_gatt_vals[idx];
+    return 0;
+}
+
+static int
+ble_store_config_write_gatt(const struct ble_store_value_gatt *value_gatt)
+{
+    struct ble_store_key_gatt key_gatt;
+    int idx;
+
+    ble_store_key_from_value_gatt(&key_gatt, value_gatt);
+    idx = ble_store_config_find_gatt(&key_gatt);
+    if (idx == -1) {
+        idx = ble_store_config_tbl_alloc(&ble_store_config_gatts);
+        if (idx == -1) {
+            BLE_HS_LOG(DEBUG, "error persisting gatt attr; too many entries "
+                              "(%d)\n", ble_store_config_gatts.num);
+            return BLE_HS_ENOMEM;
+        }
+    }
+
+    ble_store_config_tbl_fill(&ble_store_config_gatts, idx, value_gatt);
+    ble_store_config_tbl_mark_dirty(&ble_store_config_gatts, idx);
+    return 0;
+}
+
+/*****************************************************************************
+ * $conf                                                                     *
+ *****************************************************************************/
+
+static struct ble_store_config_tbl *
+ble_store_config_tbl_find(const char *name)
+{
+    int i;
+
+    for (i = 0; i < BLE_STORE_CONFIG_NUM_TBLS; i++) {
+        if (strcmp(ble_store_config_tbls[i]->name, name) == 0) {
+            return ble_store_config_tbls[i];
+        }
+    }
+
+    return NULL;
+}
+
+static struct ble_store_config_sec_tbl *
+ble_store_config_sec_tbl_from_tbl(struct ble_store_config_tbl *tbl)
+{
+    if (tbl == &ble_store_config_our_secs.tbl) {
+        return &ble_store_config_our_secs;
+    }
+    if (tbl == &ble_store_config_peer_secs.tbl) {
+        return &ble_store_config_peer_secs;
+    }
+    return NULL;
+}
+
+static char *
+ble_store_config_conf_get(int argc, char **argv, char *buf, int max_len)
+{
+    /* Key material is not exposed through the config get interface. */
+    return NULL;
+}
+
+static int
+ble_store_config_conf_set(int argc, char **argv, char *val)
+{
+    union ble_store_value value;
+    struct ble_store_config_sec_tbl *st;
+    struct ble_store_config_tbl *tbl;
+    char *endptr;
+    long slot;
+    int len;
+    int rc;
+
+    if (argc != 2) {
+        return OS_ENOENT;
+    }
+
+    tbl = ble_store_config_tbl_find(argv[0]);
+    if (tbl == NULL) {
+        return OS_ENOENT;
+    }
+
+    slot = strtol(argv[1], &endptr, 10);
+    if (*argv[1] == '\0' || *endptr != '\0' || slot < 0 || slot >= tbl->max) {
+        return OS_ENOENT;
+    }
+
+    if (val != NULL && val[0] != '\0') {
+        len = sizeof value;
+        rc = conf_bytes_from_str(val, &value, &len);
+        if (rc != 0 || len != tbl->value_size) {
+            return OS_EINVAL;
+        }
+    }
+
+    /* Records loaded from flash are never dirty. */
+    ble_store_config_bit_clear(tbl->dirty, slot);
+
+    st = ble_store_config_sec_tbl_from_tbl(tbl);
+    if (st != NULL && ble_store_config_bit_test(tbl->used, slot)) {
+        ble_store_config_sec_index_del(st, slot);
+    }
+
+    if (val == NULL || val[0] == '\0') {
+        ble_store_config_tbl_clear(tbl, slot);
+        return 0;
+    }
+
+    ble_store_config_tbl_clear(tbl, slot);
+    ble_store_config_tbl_fill(tbl, slot, &value);
+    if (st != NULL) {
+        ble_store_config_sec_index_add(st, slot);
+    }
+
+    return 0;
+}
+
+static int
+ble_store_config_conf_export(void (*export_func)(char *name, char *val),
+                             enum conf_export_tgt tgt)
+{
+    struct ble_store_config_tbl *tbl;
+    char name[CONF_MAX_NAME_LEN];
+    char buf[BLE_STORE_CONFIG_VAL_STR_LEN];
+    char *val;
+    int slot;
+    int i;
+
+    if (tgt != CONF_EXPORT_PERSIST) {
+        /* Don't display key material. */
+        return 0;
+    }
+
+    for (i = 0; i < BLE_STORE_CONFIG_NUM_TBLS; i++) {
+        tbl = ble_store_config_tbls[i];
+        for (slot = 0; slot < tbl->max; slot++) {
+            if (!ble_store_config_bit_test(tbl->used, slot)) {
+                continue;
+            }
+
+            val = conf_str_from_bytes(ble_store_config_tbl_value(tbl, slot),
+                                      tbl->value_size, buf, sizeof buf);
+            if (val == NULL) {
+                continue;
+            }
+
+            snprintf(name, sizeof name, "%s/%s/%d",
+                     ble_store_config_conf_handler.ch_name, tbl->name, slot);
+            export_func(name, val);
+            ble_store_config_bit_clear(tbl->dirty, slot);
+        }
+    }
+
+    return 0;
+}
+
+static void
+ble_store_config_flush_timer_exp(struct os_event *ev)
+{
+    ble_store_config_flush();
+}
+
+/*****************************************************************************
+ * $api                                                                      *
+ *****************************************************************************/
+
+/**
+ * Writes all modified records to flash.  Called automatically after
+ * BLE_STORE_CONFIG_FLUSH_DELAY_MS; an application may call it directly to
+ * persist pending changes immediately (e.g., before a reset).
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_EOS if a record could not be saved.
+ *                                  Unsaved records stay dirty and are retried
+ *                                  on the next flush.
+ */
+int
+ble_store_config_flush(void)
+{
+    struct ble_store_config_tbl *tbl;
+    int slot;
+    int rc;
+    int i;
+
+    os_callout_stop(&ble_store_config_flush_timer);
+
+    rc = 0;
+    for (i = 0; i < BLE_STORE_CONFIG_NUM_TBLS; i++) {
+        tbl = ble_store_config_tbls[i];
+        for (slot = 0; slot < tbl->max; slot++) {
+            if (!ble_store_config_bit_test(tbl->dirty, slot)) {
+                continue;
+            }
+
+            if (ble_store_config_tbl_persist(tbl, slot) != 0) {
+                rc = BLE_HS_EOS;
+                continue;
+            }
+
+            ble_store_config_bit_clear(tbl->dirty, slot);
+        }
+    }
+
+    return rc;
+}
+
+/**
+ * Searches the database for an object matching the specified criteria.
+ *
+ * @return                      0 if a key was found; else BLE_HS_ENOENT.
+ */
+int
+ble_store_config_read(int obj_type, const union ble_store_key *key,
+                      union ble_store_value *value)
+{
+    int rc;
+
+    switch (obj_type) {
+    case BLE_STORE_OBJ_TYPE_PEER_SEC:
+        rc = ble_store_config_read_sec(&ble_store_config_peer_secs,
+                                       &key->sec, &value->sec);
+        return rc;
+
+    case BLE_STORE_OBJ_TYPE_OUR_SEC:
+        rc = ble_store_config_read_sec(&ble_store_config_our_secs,
+                                       &key->sec, &value->sec);
+        return rc;
+
+    case BLE_STORE_OBJ_TYPE_CCCD:
+        rc = ble_store_config_read_cccd(&key->cccd, &value->cccd);
+        return rc;
+
+    case BLE_STORE_OBJ_TYPE_GATT:
+        rc = ble_store_config_read_gatt(&key->gatt, &value->gatt);
+        return rc;
+
+    default:
+        return BLE_HS_ENOTSUP;
+    }
+}
+
+/**
+ * Adds the specified object to the database.  The change is persisted on the
+ * next flush.
+ *
+ * @return                      0 on success; BLE_HS_ENOMEM if the database is
+ *                                  full.
+ */
+int
+ble_store_config_write(int obj_type, const union ble_store_value *val)
+{
+    int rc;
+
+    switch (obj_type) {
+    case BLE_STORE_OBJ_TYPE_PEER_SEC:
+        rc = ble_store_config_write_sec(&ble_store_config_peer_secs,
+                                        &val->sec);
+        return rc;
+
+    case BLE_STORE_OBJ_TYPE_OUR_SEC:
+        rc = ble_store_config_write_sec(&ble_store_config_our_secs,
+                                        &val->sec);
+        return rc;
+
+    case BLE_STORE_OBJ_TYPE_CCCD:
+        rc = ble_store_config_write_cccd(&val->cccd);
+        return rc;
+
+    case BLE_STORE_OBJ_TYPE_GATT:
+        rc = ble_store_config_write_gatt(&val->gatt);
+        return rc;
+
+    default:
+        return BLE_HS_ENOTSUP;
+    }
+}
+
+int
+ble_store_config_delete(int obj_type, const union ble_store_key *key)
+{
+    int rc;
+
+    switch (obj_type) {
+    case BLE_STORE_OBJ_TYPE_PEER_SEC:
+        rc = ble_store_config_delete_sec(&ble_store_config_peer_secs,
+                                         &key->sec);
+        return rc;
+
+    case BLE_STORE_OBJ_TYPE_OUR_SEC:
+        rc = ble_store_config_delete_sec(&ble_store_config_our_secs,
+                                         &key->sec);
+        return rc;
+
+    case BLE_STORE_OBJ_TYPE_CCCD:
+        rc = ble_store_config_delete_cccd(&key->cccd);
+        return rc;
+
+    case BLE_STORE_OBJ_TYPE_GATT:
+        rc = ble_store_config_delete_gatt(&key->gatt);
+        return rc;
+
+    default:
+        return BLE_HS_ENOTSUP;
+    }
+}
+
+void
+ble_store_config_init(void)
+{
+    int rc;
+    int i;
+
+    /* Ensure this function only gets called by sysinit. */
+    SYSINIT_ASSERT_ACTIVE();
+
+    ble_hs_cfg.store_read_cb = ble_store_config_read;
+    ble_hs_cfg.store_write_cb = ble_store_config_write;
+    ble_hs_cfg.store_delete_cb = ble_store_config_delete;
+
+    /* Re-initialize BSS values in case of unit tests. */
+    for (i = 0; i < BLE_STORE_CONFIG_NUM_TBLS; i++) {
+        ble_store_config_tbl_reset(ble_store_config_tbls[i]);
+    }
+
+    os_callout_init(&ble_store_config_flush_timer, os_eventq_dflt_get(),
+                    ble_store_config_flush_timer_exp, NULL);
+
+    /* Records are populated when the application calls conf_load(). */
+    rc = conf_register(&ble_store_config_conf_handler);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+}
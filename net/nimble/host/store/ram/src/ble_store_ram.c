@@ -19,7 +19,7 @@
 
 /**
  * This file implements a simple in-RAM key database for BLE host security
- * material and CCCDs.  As this database is only ble_store_ramd in RAM, its
+ * material, CCCDs, and cached GATT attributes.  As this database is only ble_store_ramd in RAM, its
  * contents are lost when the application terminates.
  */
 
@@ -43,6 +43,10 @@ static struct ble_store_value_cccd
     ble_store_ram_cccds[MYNEWT_VAL(BLE_STORE_MAX_CCCDS)];
 static int ble_store_ram_num_cccds;
 
+static struct ble_store_value_gatt
+    ble_store_ram_gatts[MYNEWT_VAL(BLE_STORE_MAX_GATT_ATTRS)];
+static int ble_store_ram_num_gatts;
+
 /*****************************************************************************
  * $sec                                                                      *
  *****************************************************************************/
@@ -184,7 +188,7 @@ ble_store_ram_delete_obj(void *values, int value_size, int idx,
         src = dst + value_size;
 
         move_count = *num_values - idx;
-        memmove(dst, src, move_count);
+        memmove(dst, src, move_count * value_size);
     }
 
     return 0;
@@ -381,6 +385,110 @@ ble_store_ram_write_cccd(const struct ble_store_value_cccd *value_cccd)
     return 0;
 }
 
+/*****************************************************************************
+ * $gatt                                                                     *
+ *****************************************************************************/
+
+static int
+ble_store_ram_find_gatt(const struct ble_store_key_gatt *key)
+{
+    struct ble_store_value_gatt *gatt;
+    int skipped;
+    int i;
+
+    skipped = 0;
+    for (i = 0; i < ble_store_ram_num_gatts; i++) {
+        gatt = ble_store_ram_gatts + i;
+
+        if (ble_addr_cmp(&key->peer_addr, BLE_ADDR_ANY)) {
+            if (ble_addr_cmp(&gatt->peer_addr, &key->peer_addr)) {
+                continue;
+            }
+        }
+
+        if (key->attr_type != 0) {
+            if (gatt->attr_type != key->attr_type) {
+                continue;
+            }
+        }
+
+        if (key->handle != 0) {
+            if (gatt->handle != key->handle) {
+                continue;
+            }
+        }
+
+        if (key->idx > skipped) {
+            skipped++;
+            continue;
+        }
+
+        return i;
+    }
+
+    return -1;
+}
+
+static int
+ble_store_ram_delete_gatt(const struct ble_store_key_gatt *key_gatt)
+{
+    int idx;
+    int rc;
+
+    idx = ble_store_ram_find_gatt(key_gatt);
+    if (idx == -1) {
+        return BLE_HS_ENOENT;
+    }
+
+    rc = ble_store_ram_delete_obj(ble_store_ram_gatts,
+                                  sizeof *ble_store_ram_gatts,
+                                  idx,
+                                  &ble_store_ram_num_gatts);
+    if (rc != 0) {
+        return rc;
+    }
+
+    return 0;
+}
+
+static int
+ble_store_ram_read_gatt(const struct ble_store_key_gatt *key_gatt,
+                        struct ble_store_value_gatt *value_gatt)
+{
+    int idx;
+
+    idx = ble_store_ram_find_gatt(key_gatt);
+    if (idx == -1) {
+        return BLE_HS_ENOENT;
+    }
+
+    *value_gatt = ble_store_ram_gatts[idx];
+    return 0;
+}
+
+static int
+ble_store_ram_write_gatt(const struct ble_store_value_gatt *value_gatt)
+{
+    struct ble_store_key_gatt key_gatt;
+    int idx;
+
+    ble_store_key_from_value_gatt(&key_gatt, value_gatt);
+    idx = ble_store_ram_find_gatt(&key_gatt);
+    if (idx == -1) {
+        if (ble_store_ram_num_gatts >= MYNEWT_VAL(BLE_STORE_MAX_GATT_ATTRS)) {
+            BLE_HS_LOG(DEBUG, "error persisting gatt attr; too many entries "
+                              "(%d)\n", ble_store_ram_num_gatts);
+            return BLE_HS_ENOMEM;
+        }
+
+        idx = ble_store_ram_num_gatts;
+        ble_store_ram_num_gatts++;
+    }
+
+    ble_store_ram_gatts[idx] = *value_gatt;
+    return 0;
+}
+
 /*****************************************************************************
  * $api                                                                      *
  *****************************************************************************/
@@ -423,6 +531,10 @@ ble_store_ram_read(int obj_type, const union ble_store_key *key,
         rc = ble_store_ram_read_cccd(&key->cccd, &value->cccd);
         return rc;
 
+    case BLE_STORE_OBJ_TYPE_GATT:
+        rc = ble_store_ram_read_gatt(&key->gatt, &value->gatt);
+        return rc;
+
     default:
         return BLE_HS_ENOTSUP;
     }
@@ -452,6 +564,10 @@ ble_store_ram_write(int obj_type, const union ble_store_value *val)
         rc = ble_store_ram_write_cccd(&val->cccd);
         return rc;
 
+    case BLE_STORE_OBJ_TYPE_GATT:
+        rc = ble_store_ram_write_gatt(&val->gatt);
+        return rc;
+
     default:
         return BLE_HS_ENOTSUP;
     }
@@ -475,6 +591,10 @@ ble_store_ram_delete(int obj_type, const union ble_store_key *key)
         rc = ble_store_ram_delete_cccd(&key->cccd);
         return rc;
 
+    case BLE_STORE_OBJ_TYPE_GATT:
+        rc = ble_store_ram_delete_gatt(&key->gatt);
+        return rc;
+
     default:
         return BLE_HS_ENOTSUP;
     }
@@ -494,4 +614,5 @@ ble_store_ram_init(void)
     ble_store_ram_num_our_secs = 0;
     ble_store_ram_num_peer_secs = 0;
     ble_store_ram_num_cccds = 0;
+    ble_store_ram_num_gatts = 0;
 }
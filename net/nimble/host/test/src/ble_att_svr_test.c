@@ -40,6 +40,7 @@ static uint16_t ble_att_svr_test_n_conn_handle;
 static uint16_t ble_att_svr_test_n_attr_handle;
 static uint8_t ble_att_svr_test_attr_n[1024];
 static uint16_t ble_att_svr_test_attr_n_len;
+static int ble_att_svr_test_n_count;
 
 static int
 ble_att_svr_test_misc_gap_cb(struct ble_gap_event *event, void *arg)
@@ -53,6 +54,7 @@ ble_att_svr_test_misc_gap_cb(struct ble_gap_event *event, void *arg)
         ble_att_svr_test_attr_n_len = OS_MBUF_PKTLEN(event->notify_rx.om);
         os_mbuf_copydata(event->notify_rx.om, 0, ble_att_svr_test_attr_n_len,
                          ble_att_svr_test_attr_n);
+        ble_att_svr_test_n_count++;
         break;
 
     default:
@@ -443,6 +445,85 @@ ble_att_svr_test_misc_verify_all_read_mult(
                                                   attrs, num_attrs);
 }
 
+static void
+ble_att_svr_test_misc_rx_read_mult_var_req(uint16_t conn_handle,
+                                           uint16_t *handles, int num_handles,
+                                           int success)
+{
+    uint8_t buf[256];
+    int off;
+    int rc;
+    int i;
+
+    ble_att_read_mult_var_req_write(buf, sizeof buf);
+
+    off = BLE_ATT_READ_MULT_VAR_REQ_BASE_SZ;
+    for (i = 0; i < num_handles; i++) {
+        put_le16(buf + off, handles[i]);
+        off += 2;
+    }
+
+    rc = ble_hs_test_util_l2cap_rx_payload_flat(conn_handle, BLE_L2CAP_CID_ATT,
+                                                buf, off);
+    if (success) {
+        TEST_ASSERT(rc == 0);
+    } else {
+        TEST_ASSERT(rc != 0);
+    }
+}
+
+static void
+ble_att_svr_test_misc_verify_all_read_mult_var(
+    uint16_t conn_handle, struct ble_hs_test_util_flat_attr *attrs,
+    int num_attrs)
+{
+    struct ble_l2cap_chan *chan;
+    struct os_mbuf *om;
+    uint16_t handles[256];
+    uint8_t exp[1024];
+    uint16_t mtu;
+    int off;
+    int rc;
+    int i;
+
+    TEST_ASSERT_FATAL(num_attrs <= sizeof handles / sizeof handles[0]);
+
+    for (i = 0; i < num_attrs; i++) {
+        handles[i] = attrs[i].handle;
+    }
+
+    ble_att_svr_test_misc_rx_read_mult_var_req(conn_handle, handles,
+                                               num_attrs, 1);
+
+    ble_hs_lock();
+    rc = ble_hs_misc_conn_chan_find(conn_handle, BLE_L2CAP_CID_ATT,
+                                    NULL, &chan);
+    TEST_ASSERT_FATAL(rc == 0);
+    mtu = ble_att_chan_mtu(chan);
+    ble_hs_unlock();
+
+    /* Build the expected response: length-value tuples until the MTU is
+     * reached, truncated to the MTU.
+     */
+    exp[0] = BLE_ATT_OP_READ_MULT_VAR_RSP;
+    off = 1;
+    for (i = 0; i < num_attrs && off < mtu; i++) {
+        put_le16(exp + off, attrs[i].value_len);
+        off += 2;
+        memcpy(exp + off, attrs[i].value, attrs[i].value_len);
+        off += attrs[i].value_len;
+    }
+    off = min(off, mtu);
+
+    ble_hs_test_util_tx_all();
+    om = ble_hs_test_util_prev_tx_dequeue();
+    TEST_ASSERT_FATAL(om != NULL);
+
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == off);
+    rc = os_mbuf_cmpf(om, 0, exp, off);
+    TEST_ASSERT(rc == 0);
+}
+
 static void
 ble_att_svr_test_misc_verify_tx_mtu_rsp(uint16_t conn_handle)
 {
@@ -712,6 +793,29 @@ ble_att_svr_test_misc_verify_notify(uint16_t conn_handle, uint16_t attr_handle,
     }
 }
 
+static void
+ble_att_svr_test_misc_rx_notify_multi(uint16_t conn_handle,
+                                      const void *tuples, int tuples_len,
+                                      int good)
+{
+    uint8_t buf[1024];
+    int rc;
+
+    ble_att_notify_multi_req_write(buf, sizeof buf);
+    memcpy(buf + BLE_ATT_NOTIFY_MULTI_REQ_BASE_SZ, tuples, tuples_len);
+
+    ble_att_svr_test_n_count = 0;
+
+    rc = ble_hs_test_util_l2cap_rx_payload_flat(
+        conn_handle, BLE_L2CAP_CID_ATT, buf,
+        BLE_ATT_NOTIFY_MULTI_REQ_BASE_SZ + tuples_len);
+    if (good) {
+        TEST_ASSERT(rc == 0);
+    } else {
+        TEST_ASSERT(rc == BLE_HS_EBADDATA);
+    }
+}
+
 static void
 ble_att_svr_test_misc_verify_tx_indicate_rsp(void)
 {
@@ -920,6 +1024,87 @@ TEST_CASE(ble_att_svr_test_read_blob)
                                                   0);
 }
 
+static int ble_att_svr_test_read_cache_calls;
+
+static int
+ble_att_svr_test_misc_attr_fn_r_cnt(uint16_t conn_handle,
+                                    uint16_t attr_handle, uint8_t op,
+                                    uint16_t offset, struct os_mbuf **om,
+                                    void *arg)
+{
+    ble_att_svr_test_read_cache_calls++;
+    return ble_att_svr_test_misc_attr_fn_r_1(conn_handle, attr_handle, op,
+                                             offset, om, arg);
+}
+
+TEST_CASE(ble_att_svr_test_read_blob_cache)
+{
+#if MYNEWT_VAL(BLE_ATT_SVR_READ_CACHE)
+    static uint8_t val[60];
+    uint16_t attr_handle;
+    uint16_t conn_handle;
+    uint16_t off;
+    int rc;
+    int i;
+
+    conn_handle = ble_att_svr_test_misc_init(0);
+
+    for (i = 0; i < sizeof val; i++) {
+        val[i] = i;
+    }
+    ble_att_svr_test_attr_r_1 = val;
+    ble_att_svr_test_attr_r_1_len = sizeof val;
+    ble_att_svr_test_read_cache_calls = 0;
+
+    rc = ble_att_svr_register(BLE_UUID16_DECLARE(0x1234), HA_FLAG_PERM_RW, 0,
+                              &attr_handle,
+                              ble_att_svr_test_misc_attr_fn_r_cnt, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /*** A long read only calls the access callback once. */
+    rc = ble_hs_test_util_rx_att_read_req(conn_handle, attr_handle);
+    TEST_ASSERT(rc == 0);
+    ble_hs_test_util_verify_tx_read_rsp(val, BLE_ATT_MTU_DFLT - 1);
+
+    for (off = BLE_ATT_MTU_DFLT - 1;
+         off < sizeof val;
+         off += BLE_ATT_MTU_DFLT - 1) {
+
+        rc = ble_hs_test_util_rx_att_read_blob_req(conn_handle, attr_handle,
+                                                   off);
+        TEST_ASSERT(rc == 0);
+        ble_hs_test_util_verify_tx_read_blob_rsp(
+            val + off, min(sizeof val - off, BLE_ATT_MTU_DFLT - 1));
+    }
+    TEST_ASSERT(ble_att_svr_test_read_cache_calls == 1);
+
+    /*** Changing the value invalidates the cached copy. */
+    rc = ble_hs_test_util_rx_att_read_blob_req(conn_handle, attr_handle, 0);
+    TEST_ASSERT(rc == 0);
+    ble_hs_test_util_verify_tx_read_blob_rsp(val, BLE_ATT_MTU_DFLT - 1);
+    TEST_ASSERT(ble_att_svr_test_read_cache_calls == 2);
+
+    val[BLE_ATT_MTU_DFLT - 1] = 0xaa;
+    ble_gatts_chr_updated(attr_handle);
+
+    rc = ble_hs_test_util_rx_att_read_blob_req(conn_handle, attr_handle,
+                                               BLE_ATT_MTU_DFLT - 1);
+    TEST_ASSERT(rc == 0);
+    ble_hs_test_util_verify_tx_read_blob_rsp(val + BLE_ATT_MTU_DFLT - 1,
+                                             BLE_ATT_MTU_DFLT - 1);
+    TEST_ASSERT(ble_att_svr_test_read_cache_calls == 3);
+
+    /*** Finish the read so that no value stays cached. */
+    rc = ble_hs_test_util_rx_att_read_blob_req(conn_handle, attr_handle,
+                                               2 * (BLE_ATT_MTU_DFLT - 1));
+    TEST_ASSERT(rc == 0);
+    ble_hs_test_util_verify_tx_read_blob_rsp(
+        val + 2 * (BLE_ATT_MTU_DFLT - 1),
+        sizeof val - 2 * (BLE_ATT_MTU_DFLT - 1));
+    TEST_ASSERT(ble_att_svr_test_read_cache_calls == 3);
+#endif
+}
+
 TEST_CASE(ble_att_svr_test_read_mult)
 {
     uint16_t conn_handle;
@@ -997,9 +1182,74 @@ TEST_CASE(ble_att_svr_test_read_mult)
 
 }
 
+TEST_CASE(ble_att_svr_test_read_mult_var)
+{
+    uint16_t conn_handle;
+    int rc;
+
+    conn_handle = ble_att_svr_test_misc_init(0);
+
+    struct ble_hs_test_util_flat_attr attrs[2] = {
+        {
+            .handle = 0,
+            .offset = 0,
+            .value = { 1, 2, 3, 4 },
+            .value_len = 4,
+        },
+        {
+            .handle = 0,
+            .offset = 0,
+            .value = { 2, 3, 4, 5, 6 },
+            .value_len = 5,
+        },
+    };
+
+    ble_att_svr_test_attr_r_1 = attrs[0].value;
+    ble_att_svr_test_attr_r_1_len = attrs[0].value_len;
+    ble_att_svr_test_attr_r_2 = attrs[1].value;
+    ble_att_svr_test_attr_r_2_len = attrs[1].value_len;
+
+    rc = ble_att_svr_register(BLE_UUID16_DECLARE(0x1111), HA_FLAG_PERM_RW, 0,
+                              &attrs[0].handle,
+                              ble_att_svr_test_misc_attr_fn_r_1, NULL);
+    TEST_ASSERT(rc == 0);
+
+    rc = ble_att_svr_register(BLE_UUID16_DECLARE(0x2222), HA_FLAG_PERM_RW, 0,
+                              &attrs[1].handle,
+                              ble_att_svr_test_misc_attr_fn_r_2, NULL);
+    TEST_ASSERT(rc == 0);
+
+    /*** Two attributes. */
+    ble_att_svr_test_misc_verify_all_read_mult_var(conn_handle, attrs, 2);
+
+    /*** Empty attribute. */
+    ble_att_svr_test_attr_r_1_len = 0;
+    attrs[0].value_len = 0;
+    ble_att_svr_test_misc_verify_all_read_mult_var(conn_handle, attrs, 2);
+
+    /*** Second attribute nonexistent; verify only error txed. */
+    ble_att_svr_test_misc_rx_read_mult_var_req(
+        conn_handle, ((uint16_t[]){ attrs[0].handle, 100 }), 2, 0);
+    ble_hs_test_util_verify_tx_err_rsp(BLE_ATT_OP_READ_MULT_VAR_REQ,
+                                       100, BLE_ATT_ERR_INVALID_HANDLE);
+
+    /*** Response too long; verify only MTU bytes sent. */
+    attrs[0].value_len = 20;
+    memcpy(attrs[0].value,
+           ((uint8_t[]){0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19}),
+           attrs[0].value_len);
+    ble_att_svr_test_attr_r_1_len = attrs[0].value_len;
+
+    ble_att_svr_test_misc_verify_all_read_mult_var(conn_handle, attrs, 2);
+}
+
 TEST_CASE(ble_att_svr_test_write)
 {
+    struct hci_data_hdr hci_hdr;
     struct ble_hs_conn *conn;
+    struct os_mbuf *om2;
+    struct os_mbuf *om;
+    uint8_t buf[16];
     uint16_t conn_handle;
     uint16_t attr_handle;
     const ble_uuid_t *uuid_sec = BLE_UUID128_DECLARE( \
@@ -1086,6 +1336,35 @@ TEST_CASE(ble_att_svr_test_write)
                                            attr_val, sizeof attr_val);
     TEST_ASSERT(rc == 0);
     ble_hs_test_util_verify_tx_write_rsp();
+
+    /*** Request header split across two buffers. */
+    ble_att_svr_test_attr_w_1_len = 0;
+
+    om = ble_hs_mbuf_l2cap_pkt();
+    TEST_ASSERT_FATAL(om != NULL);
+    buf[0] = BLE_ATT_OP_WRITE_REQ;
+    buf[1] = attr_handle & 0xff;
+    rc = os_mbuf_append(om, buf, 2);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    om2 = ble_hs_mbuf_bare_pkt();
+    TEST_ASSERT_FATAL(om2 != NULL);
+    buf[0] = attr_handle >> 8;
+    memcpy(buf + 1, attr_val, sizeof attr_val);
+    rc = os_mbuf_append(om2, buf, 1 + sizeof attr_val);
+    TEST_ASSERT_FATAL(rc == 0);
+    os_mbuf_concat(om, om2);
+
+    hci_hdr = BLE_HS_TEST_UTIL_L2CAP_HCI_HDR(conn_handle,
+                                             BLE_HCI_PB_FIRST_FLUSH,
+                                             OS_MBUF_PKTLEN(om));
+    rc = ble_hs_test_util_l2cap_rx_first_frag(conn_handle, BLE_L2CAP_CID_ATT,
+                                              &hci_hdr, om);
+    TEST_ASSERT(rc == 0);
+    ble_hs_test_util_verify_tx_write_rsp();
+    TEST_ASSERT(ble_att_svr_test_attr_w_1_len == sizeof attr_val);
+    TEST_ASSERT(memcmp(ble_att_svr_test_attr_w_1, attr_val,
+                       sizeof attr_val) == 0);
 }
 
 TEST_CASE(ble_att_svr_test_find_info)
@@ -1780,6 +2059,46 @@ TEST_CASE(ble_att_svr_test_notify)
 
 }
 
+TEST_CASE(ble_att_svr_test_notify_multi)
+{
+    uint16_t conn_handle;
+
+    conn_handle = ble_att_svr_test_misc_init(0);
+
+    /*** Two values; each reported as a separate notification. */
+    ble_att_svr_test_misc_rx_notify_multi(conn_handle,
+        (uint8_t[]) { 10, 0, 3, 0, 1, 2, 3, 11, 0, 2, 0, 4, 5 }, 13, 1);
+    TEST_ASSERT(ble_att_svr_test_n_count == 2);
+    TEST_ASSERT(ble_att_svr_test_n_conn_handle == conn_handle);
+    TEST_ASSERT(ble_att_svr_test_n_attr_handle == 11);
+    TEST_ASSERT(ble_att_svr_test_attr_n_len == 2);
+    TEST_ASSERT(memcmp(ble_att_svr_test_attr_n, (uint8_t[]) { 4, 5 },
+                       2) == 0);
+
+    /*** Empty last value. */
+    ble_att_svr_test_misc_rx_notify_multi(conn_handle,
+        (uint8_t[]) { 10, 0, 1, 0, 9, 12, 0, 0, 0 }, 9, 1);
+    TEST_ASSERT(ble_att_svr_test_n_count == 2);
+    TEST_ASSERT(ble_att_svr_test_n_attr_handle == 12);
+    TEST_ASSERT(ble_att_svr_test_attr_n_len == 0);
+
+    /*** Bad notifies; verify callback is not executed. */
+    /* Attribute handle of 0. */
+    ble_att_svr_test_misc_rx_notify_multi(conn_handle,
+        (uint8_t[]) { 0, 0, 1, 0, 9 }, 5, 0);
+    TEST_ASSERT(ble_att_svr_test_n_count == 0);
+
+    /* Length exceeds remaining data. */
+    ble_att_svr_test_misc_rx_notify_multi(conn_handle,
+        (uint8_t[]) { 10, 0, 5, 0, 9 }, 5, 0);
+    TEST_ASSERT(ble_att_svr_test_n_count == 0);
+
+    /* Incomplete tuple header. */
+    ble_att_svr_test_misc_rx_notify_multi(conn_handle,
+        (uint8_t[]) { 10, 0, 5 }, 3, 0);
+    TEST_ASSERT(ble_att_svr_test_n_count == 0);
+}
+
 TEST_CASE(ble_att_svr_test_prep_write_tmo)
 {
     int32_t ticks_from_now;
@@ -2052,6 +2371,52 @@ TEST_CASE(ble_att_svr_test_oom)
     os_mbuf_free_chain(oms);
 }
 
+/*
+ * Not a functional test; reports the cost of receiving, parsing and
+ * answering common requests with a few dozen attributes registered.
+ */
+TEST_CASE(ble_att_svr_test_bench)
+{
+    ble_uuid16_t uuids[32];
+    uint16_t conn_handle;
+    uint16_t attr_handle;
+    int rc;
+    int i;
+
+    conn_handle = ble_att_svr_test_misc_init(0);
+
+    ble_att_svr_test_attr_r_1 = (uint8_t[]){0,1,2,3,4,5,6,7};
+    ble_att_svr_test_attr_r_1_len = 8;
+    for (i = 0; i < sizeof uuids / sizeof uuids[0]; i++) {
+        uuids[i].u.type = BLE_UUID_TYPE_16;
+        uuids[i].value = 0x8000 + i;
+        rc = ble_att_svr_register(&uuids[i].u, HA_FLAG_PERM_RW, 0,
+                                  &attr_handle,
+                                  ble_att_svr_test_misc_attr_fn_r_1, NULL);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    /* attr_handle is the last, i.e. worst case, attribute. */
+    TEST_BENCH_BEGIN("read_req", 1000) {
+        rc = ble_hs_test_util_rx_att_read_req(conn_handle, attr_handle);
+        TEST_ASSERT_FATAL(rc == 0);
+        ble_hs_test_util_prev_tx_queue_clear();
+    } TEST_BENCH_END();
+
+    TEST_BENCH_BEGIN("read_type_req", 1000) {
+        rc = ble_hs_test_util_rx_att_read_type_req16(conn_handle, 1, 0xffff,
+                                                     uuids[i - 1].value);
+        TEST_ASSERT_FATAL(rc == 0);
+        ble_hs_test_util_prev_tx_queue_clear();
+    } TEST_BENCH_END();
+
+    TEST_BENCH_BEGIN("find_info_req", 1000) {
+        rc = ble_hs_test_util_rx_att_find_info_req(conn_handle, 1, 0xffff);
+        TEST_ASSERT_FATAL(rc == 0);
+        ble_hs_test_util_prev_tx_queue_clear();
+    } TEST_BENCH_END();
+}
+
 TEST_SUITE(ble_att_svr_suite)
 {
     /* When checking for mbuf leaks, ensure no stale prep entries. */
@@ -2066,7 +2431,9 @@ TEST_SUITE(ble_att_svr_suite)
     ble_att_svr_test_mtu();
     ble_att_svr_test_read();
     ble_att_svr_test_read_blob();
+    ble_att_svr_test_read_blob_cache();
     ble_att_svr_test_read_mult();
+    ble_att_svr_test_read_mult_var();
     ble_att_svr_test_write();
     ble_att_svr_test_find_info();
     ble_att_svr_test_find_type_value();
@@ -2075,8 +2442,10 @@ TEST_SUITE(ble_att_svr_suite)
     ble_att_svr_test_prep_write();
     ble_att_svr_test_prep_write_tmo();
     ble_att_svr_test_notify();
+    ble_att_svr_test_notify_multi();
     ble_att_svr_test_indicate();
     ble_att_svr_test_oom();
+    ble_att_svr_test_bench();
 }
 
 int
@@ -22,6 +22,7 @@
 #include "testutil/testutil.h"
 #include "nimble/ble.h"
 #include "nimble/hci_common.h"
+#include "nimble/hci_vendor.h"
 #include "host/ble_hs_adv.h"
 #include "host/ble_hs_test.h"
 #include "ble_hs_test_util.h"
@@ -782,6 +783,76 @@ TEST_CASE(ble_gap_test_case_disc_busy)
     TEST_ASSERT(rc == BLE_HS_EBUSY);
 }
 
+TEST_CASE(ble_gap_test_case_disc_filter)
+{
+    uint8_t rsp;
+    uint8_t *param;
+    uint8_t param_len;
+    int rc;
+
+    ble_gap_test_util_init();
+
+    rsp = BLE_HCI_ADV_RPT_FILT_ADD;
+    ble_hs_test_util_set_ack_params(
+        ble_hs_hci_util_opcode_join(BLE_HCI_OGF_VENDOR,
+                                    BLE_HCI_OCF_ADV_RPT_FILT),
+        0, &rsp, sizeof rsp);
+
+    /* Manufacturer ID filter. */
+    rc = ble_gap_disc_filter_add_mfg_id(0x1234);
+    TEST_ASSERT(rc == 0);
+
+    param = ble_hs_test_util_verify_tx_hci(BLE_HCI_OGF_VENDOR,
+                                           BLE_HCI_OCF_ADV_RPT_FILT,
+                                           &param_len);
+    TEST_ASSERT(param_len == 5);
+    TEST_ASSERT(param[0] == BLE_HCI_ADV_RPT_FILT_ADD);
+    TEST_ASSERT(param[1] == BLE_HCI_ADV_RPT_FILT_TYPE_MFG_ID);
+    TEST_ASSERT(param[2] == 2);
+    TEST_ASSERT(get_le16(param + 3) == 0x1234);
+
+    /* 16-bit UUID filter. */
+    ble_hs_test_util_set_ack_params(
+        ble_hs_hci_util_opcode_join(BLE_HCI_OGF_VENDOR,
+                                    BLE_HCI_OCF_ADV_RPT_FILT),
+        0, &rsp, sizeof rsp);
+
+    rc = ble_gap_disc_filter_add_uuid(BLE_UUID16_DECLARE(0x180d));
+    TEST_ASSERT(rc == 0);
+
+    param = ble_hs_test_util_verify_tx_hci(BLE_HCI_OGF_VENDOR,
+                                           BLE_HCI_OCF_ADV_RPT_FILT,
+                                           &param_len);
+    TEST_ASSERT(param_len == 5);
+    TEST_ASSERT(param[1] == BLE_HCI_ADV_RPT_FILT_TYPE_UUID16);
+    TEST_ASSERT(get_le16(param + 3) == 0x180d);
+
+    /* Controller rejects the filter (table full). */
+    ble_hs_test_util_set_ack(
+        ble_hs_hci_util_opcode_join(BLE_HCI_OGF_VENDOR,
+                                    BLE_HCI_OCF_ADV_RPT_FILT),
+        BLE_ERR_MEM_CAPACITY);
+    rc = ble_gap_disc_filter_add_uuid(BLE_UUID16_DECLARE(0x180f));
+    TEST_ASSERT(rc == BLE_HS_HCI_ERR(BLE_ERR_MEM_CAPACITY));
+
+    /* Enable filtering. */
+    rsp = BLE_HCI_ADV_RPT_FILT_ENABLE;
+    ble_hs_test_util_set_ack_params(
+        ble_hs_hci_util_opcode_join(BLE_HCI_OGF_VENDOR,
+                                    BLE_HCI_OCF_ADV_RPT_FILT),
+        0, &rsp, sizeof rsp);
+
+    rc = ble_gap_disc_filter_enable(1);
+    TEST_ASSERT(rc == 0);
+
+    param = ble_hs_test_util_verify_tx_hci(BLE_HCI_OGF_VENDOR,
+                                           BLE_HCI_OCF_ADV_RPT_FILT,
+                                           &param_len);
+    TEST_ASSERT(param_len == 2);
+    TEST_ASSERT(param[0] == BLE_HCI_ADV_RPT_FILT_ENABLE);
+    TEST_ASSERT(param[1] == 1);
+}
+
 TEST_SUITE(ble_gap_test_suite_disc)
 {
     tu_suite_set_post_test_cb(ble_hs_test_util_post_test, NULL);
@@ -793,6 +864,7 @@ TEST_SUITE(ble_gap_test_suite_disc)
     ble_gap_test_case_disc_dflts();
     ble_gap_test_case_disc_already();
     ble_gap_test_case_disc_busy();
+    ble_gap_test_case_disc_filter();
 }
 
 /*****************************************************************************
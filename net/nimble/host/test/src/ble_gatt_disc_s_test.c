@@ -620,6 +620,60 @@ TEST_CASE(ble_gatt_disc_s_test_oom_timeout)
     os_mbuf_free_chain(oms);
 }
 
+TEST_CASE(ble_gatt_disc_s_test_cache)
+{
+#if MYNEWT_VAL(BLE_GATT_CACHE)
+    struct ble_gatt_disc_s_test_svc services[] = {
+        { 1, 5,     BLE_UUID16_DECLARE(0x1234) },
+        { 6, 20,    BLE_UUID128_DECLARE(1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 ), },
+        { 0 }
+    };
+    struct ble_store_value_sec value_sec = {
+        .peer_addr = { BLE_ADDR_PUBLIC, { 2, 3, 4, 5, 6, 7 } },
+        .ltk_present = 1,
+    };
+    int rc;
+
+    ble_gatt_disc_s_test_init();
+
+    /* Results are only cached for bonded peers. */
+    rc = ble_store_write_peer_sec(&value_sec);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    ble_hs_test_util_create_conn(2, ((uint8_t[]){2,3,4,5,6,7,8,9}),
+                                 NULL, NULL);
+
+    /*** First discovery goes over the air and populates the cache. */
+    rc = ble_gattc_disc_all_svcs(2, ble_gatt_disc_s_test_misc_disc_cb, NULL);
+    TEST_ASSERT(rc == 0);
+
+    ble_gatt_disc_s_test_misc_rx_all_rsp(2, services);
+    ble_gatt_disc_s_test_misc_verify_services(services);
+
+    /*** Second discovery is answered from the cache. */
+    ble_gatt_disc_s_test_num_svcs = 0;
+    ble_gatt_disc_s_test_rx_complete = 0;
+
+    rc = ble_gattc_disc_all_svcs(2, ble_gatt_disc_s_test_misc_disc_cb, NULL);
+    TEST_ASSERT(rc == 0);
+
+    ble_hs_test_util_tx_all();
+    TEST_ASSERT(ble_hs_test_util_prev_tx_queue_sz() == 0);
+    TEST_ASSERT(!ble_gatt_disc_s_test_rx_complete);
+
+    ble_hs_test_util_evq_run_all();
+    ble_gatt_disc_s_test_misc_verify_services(services);
+    TEST_ASSERT(!ble_gattc_any_jobs());
+
+    /*** Deleting the bond discards the cache. */
+    rc = ble_store_util_delete_peer(&value_sec.peer_addr);
+    TEST_ASSERT(rc == 0);
+
+    rc = ble_gattc_cache_has_svcs(&value_sec.peer_addr);
+    TEST_ASSERT(!rc);
+#endif
+}
+
 TEST_SUITE(ble_gatt_disc_s_test_suite)
 {
     tu_suite_set_post_test_cb(ble_hs_test_util_post_test, NULL);
@@ -629,6 +683,7 @@ TEST_SUITE(ble_gatt_disc_s_test_suite)
     ble_gatt_disc_s_test_oom_all();
     ble_gatt_disc_s_test_oom_uuid();
     ble_gatt_disc_s_test_oom_timeout();
+    ble_gatt_disc_s_test_cache();
 }
 
 int
@@ -497,6 +497,67 @@ ble_gatt_read_test_misc_mult_verify_bad(
     TEST_ASSERT(!ble_gattc_any_jobs());
 }
 
+static void
+ble_gatt_read_test_misc_mult_var_verify_good(
+    struct ble_hs_test_util_flat_attr *attrs)
+{
+    uint8_t rsp[BLE_ATT_MTU_DFLT];
+    uint16_t handles[256];
+    int num_attrs;
+    int num_read;
+    int chunk_sz;
+    int off;
+    int rc;
+    int i;
+
+    ble_gatt_read_test_misc_init();
+    ble_hs_test_util_create_conn(2, ((uint8_t[]){2,3,4,5,6,7,8,9}),
+                                 NULL, NULL);
+
+    num_attrs = ble_gatt_read_test_misc_extract_handles(attrs, handles);
+
+    /* Build a response holding as many length-value tuples as fit in the
+     * default MTU; the last value may be truncated.
+     */
+    off = 0;
+    for (num_read = 0; num_read < num_attrs; num_read++) {
+        if (off + 2 > BLE_ATT_MTU_DFLT - 1) {
+            break;
+        }
+        put_le16(rsp + off, attrs[num_read].value_len);
+        off += 2;
+
+        chunk_sz = min(attrs[num_read].value_len, BLE_ATT_MTU_DFLT - 1 - off);
+        memcpy(rsp + off, attrs[num_read].value, chunk_sz);
+        off += chunk_sz;
+    }
+
+    rc = ble_gattc_read_mult_var(2, handles, num_attrs,
+                                 ble_gatt_read_test_cb, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    ble_gatt_read_test_misc_rx_rsp_good_raw(2, BLE_ATT_OP_READ_MULT_VAR_RSP,
+                                            rsp, off);
+
+    TEST_ASSERT(ble_gatt_read_test_complete);
+    TEST_ASSERT(ble_gatt_read_test_bad_status == BLE_HS_EDONE);
+    TEST_ASSERT(!ble_gattc_any_jobs());
+    TEST_ASSERT(ble_gatt_read_test_num_attrs == num_read);
+
+    off = 1;
+    for (i = 0; i < num_read; i++) {
+        off += 2;
+        chunk_sz = min(attrs[i].value_len, BLE_ATT_MTU_DFLT - off);
+        off += chunk_sz;
+
+        TEST_ASSERT(ble_gatt_read_test_attrs[i].conn_handle == 2);
+        TEST_ASSERT(ble_gatt_read_test_attrs[i].handle == attrs[i].handle);
+        TEST_ASSERT(ble_gatt_read_test_attrs[i].value_len == chunk_sz);
+        TEST_ASSERT(memcmp(ble_gatt_read_test_attrs[i].value, attrs[i].value,
+                           chunk_sz) == 0);
+    }
+}
+
 TEST_CASE(ble_gatt_read_test_by_handle)
 {
     /* Read a seven-byte attribute. */
@@ -751,6 +812,142 @@ TEST_CASE(ble_gatt_read_test_mult)
         } });
 }
 
+TEST_CASE(ble_gatt_read_test_mult_var)
+{
+    uint16_t handles[2];
+    int rc;
+
+    /* Read two attributes. */
+    ble_gatt_read_test_misc_mult_var_verify_good(
+        (struct ble_hs_test_util_flat_attr[]) { {
+        .handle = 43,
+        .value = { 0, 1, 2, 3, 4, 5, 6, 7 },
+        .value_len = 7,
+    }, {
+        .handle = 44,
+        .value = { 8, 9, 10, 11 },
+        .value_len = 4,
+    }, {
+        0
+    } });
+
+    /* Read an empty attribute. */
+    ble_gatt_read_test_misc_mult_var_verify_good(
+        (struct ble_hs_test_util_flat_attr[]) { {
+        .handle = 44,
+        .value_len = 0,
+    }, {
+        .handle = 43,
+        .value = { 0, 1, 2 },
+        .value_len = 3,
+    }, {
+        0
+    } });
+
+    /* Second value truncated; third doesn't fit at all. */
+    ble_gatt_read_test_misc_mult_var_verify_good(
+        (struct ble_hs_test_util_flat_attr[]) { {
+        .handle = 43,
+        .value = { 0, 1, 2, 3, 4, 5, 6 },
+        .value_len = 7,
+    }, {
+        .handle = 44,
+        .value = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+        .value_len = 16,
+    }, {
+        .handle = 45,
+        .value = { 1 },
+        .value_len = 1,
+    }, {
+        0
+    } });
+
+    /* A single handle is rejected. */
+    ble_gatt_read_test_misc_init();
+    ble_hs_test_util_create_conn(2, ((uint8_t[]){2,3,4,5,6,7,8,9}),
+                                 NULL, NULL);
+    handles[0] = 43;
+    rc = ble_gattc_read_mult_var(2, handles, 1, ble_gatt_read_test_cb, NULL);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+    TEST_ASSERT(!ble_gattc_any_jobs());
+
+    /* Fail due to attribute not found. */
+    handles[1] = 719;
+    rc = ble_gattc_read_mult_var(2, handles, 2, ble_gatt_read_test_cb, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    ble_hs_test_util_tx_all();
+    ble_hs_test_util_rx_att_err_rsp(2, BLE_ATT_OP_READ_MULT_VAR_REQ,
+                                    BLE_ATT_ERR_ATTR_NOT_FOUND, 719);
+
+    TEST_ASSERT(ble_gatt_read_test_num_attrs == 0);
+    TEST_ASSERT(ble_gatt_read_test_bad_conn_handle == 2);
+    TEST_ASSERT(ble_gatt_read_test_bad_status ==
+                BLE_HS_ERR_ATT_BASE + BLE_ATT_ERR_ATTR_NOT_FOUND);
+    TEST_ASSERT(!ble_gattc_any_jobs());
+}
+
+TEST_CASE(ble_gatt_read_test_mult_list)
+{
+    static const uint8_t value[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+    uint16_t handles[3] = { 43, 44, 45 };
+    uint8_t rsp[BLE_ATT_MTU_DFLT - 1];
+    struct os_mbuf *om;
+    int off;
+    int rc;
+    int i;
+
+    ble_gatt_read_test_misc_init();
+    ble_hs_test_util_create_conn(2, ((uint8_t[]){2,3,4,5,6,7,8,9}),
+                                 NULL, NULL);
+
+    rc = ble_gattc_read_mult_list(2, handles, 3, ble_gatt_read_test_cb, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* The first two values fit; only the length of the third does. */
+    off = 0;
+    for (i = 0; i < 3; i++) {
+        put_le16(rsp + off, sizeof value);
+        off += 2;
+        if (i < 2) {
+            memcpy(rsp + off, value, sizeof value);
+            off += sizeof value;
+        }
+    }
+    TEST_ASSERT_FATAL(off == sizeof rsp);
+
+    ble_gatt_read_test_misc_rx_rsp_good_raw(2, BLE_ATT_OP_READ_MULT_VAR_RSP,
+                                            rsp, off);
+    TEST_ASSERT(ble_gatt_read_test_num_attrs == 2);
+    TEST_ASSERT(ble_gatt_read_test_bad_status == 0);
+    TEST_ASSERT(ble_gattc_any_jobs());
+
+    /* The omitted value is requested again with a plain read. */
+    ble_hs_test_util_tx_all();
+    om = ble_hs_test_util_prev_tx_dequeue_pullup();
+    TEST_ASSERT_FATAL(om != NULL);
+    TEST_ASSERT(om->om_data[0] == BLE_ATT_OP_READ_MULT_VAR_REQ);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == 1 + 3 * 2);
+
+    om = ble_hs_test_util_prev_tx_dequeue_pullup();
+    TEST_ASSERT_FATAL(om != NULL);
+    TEST_ASSERT(om->om_data[0] == BLE_ATT_OP_READ_REQ);
+    TEST_ASSERT(get_le16(om->om_data + 1) == 45);
+
+    ble_gatt_read_test_misc_rx_rsp_good_raw(2, BLE_ATT_OP_READ_RSP,
+                                            value, sizeof value);
+    TEST_ASSERT(ble_gatt_read_test_bad_status == BLE_HS_EDONE);
+    TEST_ASSERT(!ble_gattc_any_jobs());
+    TEST_ASSERT_FATAL(ble_gatt_read_test_num_attrs == 3);
+
+    for (i = 0; i < 3; i++) {
+        TEST_ASSERT(ble_gatt_read_test_attrs[i].handle == handles[i]);
+        TEST_ASSERT(ble_gatt_read_test_attrs[i].value_len == sizeof value);
+        TEST_ASSERT(memcmp(ble_gatt_read_test_attrs[i].value, value,
+                           sizeof value) == 0);
+    }
+}
+
 TEST_CASE(ble_gatt_read_test_concurrent)
 {
     int rc;
@@ -911,6 +1108,8 @@ TEST_SUITE(ble_gatt_read_test_suite)
     ble_gatt_read_test_by_uuid();
     ble_gatt_read_test_long();
     ble_gatt_read_test_mult();
+    ble_gatt_read_test_mult_var();
+    ble_gatt_read_test_mult_list();
     ble_gatt_read_test_concurrent();
     ble_gatt_read_test_long_oom();
 }
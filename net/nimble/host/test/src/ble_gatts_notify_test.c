@@ -84,6 +84,7 @@ ble_gatts_notify_test_util_gap_event(struct ble_gap_event *event, void *arg)
     switch (event->type) {
     case BLE_GAP_EVENT_NOTIFY_TX:
     case BLE_GAP_EVENT_SUBSCRIBE:
+    case BLE_GAP_EVENT_NOTIFY_QUEUE:
         TEST_ASSERT_FATAL(ble_gatts_notify_test_num_events <
                           BLE_GATTS_NOTIFY_TEST_MAX_EVENTS);
 
@@ -222,6 +223,20 @@ ble_gatts_notify_test_util_verify_ack_event(uint16_t conn_handle,
                                                BLE_HS_EDONE, 1);
 }
 
+static void
+ble_gatts_notify_test_util_verify_queue_event(uint16_t conn_handle,
+                                              uint8_t count, int full)
+{
+    struct ble_gap_event event;
+
+    ble_gatts_notify_test_util_next_event(&event);
+
+    TEST_ASSERT(event.type == BLE_GAP_EVENT_NOTIFY_QUEUE);
+    TEST_ASSERT(event.notify_queue.conn_handle == conn_handle);
+    TEST_ASSERT(event.notify_queue.count == count);
+    TEST_ASSERT(event.notify_queue.full == full);
+}
+
 static void
 ble_gatts_notify_test_misc_init(uint16_t *out_conn_handle, int bonding,
                                 uint16_t chr1_flags, uint16_t chr2_flags)
@@ -1041,6 +1056,132 @@ TEST_CASE(ble_gatts_notify_test_disallowed)
         2, chr3_val_handle - 1, BLE_GATTS_CLT_CFG_F_INDICATE, 0);
 }
 
+TEST_CASE(ble_gatts_notify_test_queue)
+{
+    struct ble_hs_test_util_num_completed_pkts_entry ncpe[2];
+    uint16_t chr1_val_handle;
+    uint16_t chr2_val_handle;
+    uint16_t conn_handle;
+    struct os_mbuf *om;
+    uint8_t val;
+    int rc;
+
+    ble_gatts_notify_test_misc_init(&conn_handle, 0, 0, 0);
+    chr1_val_handle = ble_gatts_notify_test_chr_1_def_handle + 1;
+    chr2_val_handle = ble_gatts_notify_test_chr_2_def_handle + 1;
+
+    /* Release any controller buffers consumed during setup. */
+    ncpe[0].handle_id = conn_handle;
+    ncpe[0].num_pkts = 100;
+    ncpe[1].handle_id = 0;
+    ble_hs_test_util_rx_num_completed_pkts_event(ncpe);
+
+    /* Queue three values for characteristic 1; they get coalesced. */
+    for (val = 1; val <= 3; val++) {
+        om = ble_hs_test_util_om_from_flat(&val, 1);
+        rc = ble_gattc_notify_queue(conn_handle, chr1_val_handle, om);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    /* Queue a notification for characteristic 2; value read on transmit. */
+    rc = ble_gattc_notify_queue(conn_handle, chr2_val_handle, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+    ble_gatts_notify_test_chr_2_val[0] = 0x55;
+    ble_gatts_notify_test_chr_2_len = 1;
+
+    /* Queue is full; a third characteristic is rejected. */
+    val = 4;
+    om = ble_hs_test_util_om_from_flat(&val, 1);
+    rc = ble_gattc_notify_queue(conn_handle, chr2_val_handle + 10, om);
+    TEST_ASSERT(rc == BLE_HS_EBUSY);
+    ble_gatts_notify_test_util_verify_queue_event(conn_handle, 2, 1);
+
+    /* Nothing is sent until the host task runs. */
+    ble_hs_test_util_tx_all();
+    TEST_ASSERT(ble_hs_test_util_prev_tx_dequeue() == NULL);
+
+    /* Only one ACL packet may be outstanding; only the latest value of
+     * characteristic 1 gets sent.
+     */
+    ble_hs_test_util_evq_run_all();
+    val = 3;
+    ble_gatts_notify_test_misc_verify_tx_n(conn_handle, chr1_val_handle,
+                                           &val, 1);
+    TEST_ASSERT(ble_hs_test_util_prev_tx_dequeue() == NULL);
+    ble_gatts_notify_test_util_verify_queue_event(conn_handle, 1, 0);
+    TEST_ASSERT(ble_gatts_notify_test_num_events == 0);
+
+    /* Controller frees the buffer; remaining notification goes out. */
+    ncpe[0].num_pkts = 1;
+    ble_hs_test_util_rx_num_completed_pkts_event(ncpe);
+    ble_hs_test_util_evq_run_all();
+    ble_gatts_notify_test_misc_verify_tx_n(conn_handle, chr2_val_handle,
+                                           ble_gatts_notify_test_chr_2_val,
+                                           1);
+    TEST_ASSERT(ble_hs_test_util_prev_tx_dequeue() == NULL);
+    TEST_ASSERT(ble_gatts_notify_test_num_events == 0);
+}
+
+TEST_CASE(ble_gatts_notify_test_notify_multi)
+{
+    uint16_t handles[2];
+    uint16_t conn_handle;
+    struct os_mbuf *om;
+    uint8_t exp[32];
+    int rc;
+
+    ble_gatts_notify_test_misc_init(&conn_handle, 0, 0, 0);
+    handles[0] = ble_gatts_notify_test_chr_1_def_handle + 1;
+    handles[1] = ble_gatts_notify_test_chr_2_def_handle + 1;
+
+    ble_gatts_notify_test_chr_1_val[0] = 0xab;
+    ble_gatts_notify_test_chr_1_val[1] = 0xcd;
+    ble_gatts_notify_test_chr_1_len = 2;
+    ble_gatts_notify_test_chr_2_val[0] = 0x12;
+    ble_gatts_notify_test_chr_2_len = 1;
+
+    /*** Both values sent in a single PDU. */
+    rc = ble_gattc_notify_multi(conn_handle, handles, 2);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    exp[0] = BLE_ATT_OP_NOTIFY_MULTI_REQ;
+    put_le16(exp + 1, handles[0]);
+    put_le16(exp + 3, 2);
+    exp[5] = 0xab;
+    exp[6] = 0xcd;
+    put_le16(exp + 7, handles[1]);
+    put_le16(exp + 9, 1);
+    exp[11] = 0x12;
+
+    ble_hs_test_util_tx_all();
+    om = ble_hs_test_util_prev_tx_dequeue();
+    TEST_ASSERT_FATAL(om != NULL);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == 12);
+    TEST_ASSERT(os_mbuf_cmpf(om, 0, exp, 12) == 0);
+
+    ble_gatts_notify_test_util_verify_tx_event(conn_handle, handles[0], 0, 0);
+    ble_gatts_notify_test_util_verify_tx_event(conn_handle, handles[1], 0, 0);
+
+    /*** A single handle is rejected. */
+    rc = ble_gattc_notify_multi(conn_handle, handles, 1);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+    ble_gatts_notify_test_util_verify_tx_event(conn_handle, handles[0],
+                                               BLE_HS_EINVAL, 0);
+
+    /*** Values larger than the MTU are rejected. */
+    ble_gatts_notify_test_chr_1_len = 20;
+    rc = ble_gattc_notify_multi(conn_handle, handles, 2);
+    TEST_ASSERT(rc == BLE_HS_EMSGSIZE);
+    ble_gatts_notify_test_util_verify_tx_event(conn_handle, handles[0],
+                                               BLE_HS_EMSGSIZE, 0);
+    ble_gatts_notify_test_util_verify_tx_event(conn_handle, handles[1],
+                                               BLE_HS_EMSGSIZE, 0);
+
+    ble_hs_test_util_tx_all();
+    TEST_ASSERT(ble_hs_test_util_prev_tx_dequeue() == NULL);
+    TEST_ASSERT(ble_gatts_notify_test_num_events == 0);
+}
+
 TEST_SUITE(ble_gatts_notify_suite)
 {
     tu_suite_set_post_test_cb(ble_hs_test_util_post_test, NULL);
@@ -1055,6 +1196,10 @@ TEST_SUITE(ble_gatts_notify_suite)
 
     ble_gatts_notify_test_disallowed();
 
+    ble_gatts_notify_test_queue();
+
+    ble_gatts_notify_test_notify_multi();
+
     /* XXX: Test corner cases:
      *     o Bonding after CCCD configuration.
      *     o Disconnect prior to rx of indicate ack.
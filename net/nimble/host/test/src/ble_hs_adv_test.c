@@ -1263,6 +1263,57 @@ TEST_CASE(ble_hs_adv_test_case_user_full_payload)
     TEST_ASSERT(rc == BLE_HS_EMSGSIZE);
 }
 
+TEST_CASE(ble_hs_adv_test_case_iter)
+{
+    const struct ble_hs_adv_field *field;
+    struct ble_hs_adv_iter iter;
+    int rc;
+
+    static const uint8_t data[] = {
+        0x02, BLE_HS_ADV_TYPE_FLAGS, 0x06,
+        0x05, BLE_HS_ADV_TYPE_COMP_UUIDS16, 0x0f, 0x18, 0x11, 0x18,
+        0x04, BLE_HS_ADV_TYPE_COMP_NAME, 'a', 'b', 'c',
+        0x00, 0x00,
+    };
+
+    /*** Fields are returned in order, in place. */
+    ble_hs_adv_iter_init(&iter, data, sizeof data);
+
+    rc = ble_hs_adv_iter_next(&iter, &field);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT((const uint8_t *)field == data + 0);
+    TEST_ASSERT(field->length == 2);
+    TEST_ASSERT(field->type == BLE_HS_ADV_TYPE_FLAGS);
+
+    rc = ble_hs_adv_iter_next(&iter, &field);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT((const uint8_t *)field == data + 3);
+    TEST_ASSERT(field->type == BLE_HS_ADV_TYPE_COMP_UUIDS16);
+
+    rc = ble_hs_adv_iter_next(&iter, &field);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(field->type == BLE_HS_ADV_TYPE_COMP_NAME);
+    TEST_ASSERT(memcmp(field->value, "abc", 3) == 0);
+
+    /* Zero padding ends the data. */
+    rc = ble_hs_adv_iter_next(&iter, &field);
+    TEST_ASSERT(rc == BLE_HS_ENOENT);
+
+    /*** Lookup finds fields past the first. */
+    rc = ble_hs_adv_find_field(BLE_HS_ADV_TYPE_COMP_NAME, data, sizeof data,
+                               &field);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT((const uint8_t *)field == data + 9);
+
+    rc = ble_hs_adv_find_field(BLE_HS_ADV_TYPE_MFG_DATA, data, sizeof data,
+                               &field);
+    TEST_ASSERT(rc == BLE_HS_ENOENT);
+
+    /*** Truncated field. */
+    rc = ble_hs_adv_find_field(BLE_HS_ADV_TYPE_COMP_NAME, data, 12, &field);
+    TEST_ASSERT(rc == BLE_HS_EMSGSIZE);
+}
+
 TEST_SUITE(ble_hs_adv_test_suite)
 {
     tu_suite_set_post_test_cb(ble_hs_test_util_post_test, NULL);
@@ -1270,6 +1321,7 @@ TEST_SUITE(ble_hs_adv_test_suite)
     ble_hs_adv_test_case_user();
     ble_hs_adv_test_case_user_rsp();
     ble_hs_adv_test_case_user_full_payload();
+    ble_hs_adv_test_case_iter();
 }
 
 int
@@ -200,6 +200,75 @@ TEST_CASE(ble_hs_conn_test_undirect_connectable_success)
     ble_hs_unlock();
 }
 
+static void
+ble_hs_conn_test_util_verify_find(uint16_t conn_handle, uint8_t addr_id,
+                                  int exists)
+{
+    struct ble_hs_conn *conn;
+    ble_addr_t addr = { BLE_ADDR_PUBLIC, { addr_id, 2, 3, 4, 5, 6 }};
+
+    ble_hs_lock();
+
+    conn = ble_hs_conn_find(conn_handle);
+    if (exists) {
+        TEST_ASSERT_FATAL(conn != NULL);
+        TEST_ASSERT(conn->bhc_handle == conn_handle);
+        TEST_ASSERT(ble_hs_conn_find_by_addr(&addr) == conn);
+    } else {
+        TEST_ASSERT(conn == NULL);
+        TEST_ASSERT(ble_hs_conn_find_by_addr(&addr) == NULL);
+    }
+
+    ble_hs_unlock();
+}
+
+TEST_CASE(ble_hs_conn_test_find)
+{
+    /* Handles that map to the same lookup table slot. */
+    static const uint16_t handles[] = {
+        1,
+        1 + MYNEWT_VAL(BLE_MAX_CONNECTIONS),
+        1 + 2 * MYNEWT_VAL(BLE_MAX_CONNECTIONS),
+        2,
+    };
+    int num_handles;
+    int i;
+
+    ble_hs_test_util_init();
+
+    num_handles = sizeof handles / sizeof handles[0];
+    for (i = 0; i < num_handles; i++) {
+        ble_hs_test_util_create_conn(handles[i],
+                                     ((uint8_t[]){ i + 1, 2, 3, 4, 5, 6 }),
+                                     NULL, NULL);
+    }
+
+    for (i = 0; i < num_handles; i++) {
+        ble_hs_conn_test_util_verify_find(handles[i], i + 1, 1);
+    }
+    ble_hs_conn_test_util_verify_find(3, num_handles + 1, 0);
+
+    /*** Remove the head of a probe sequence; the rest remain reachable. */
+    ble_hs_test_util_conn_disconnect(handles[0]);
+    ble_hs_conn_test_util_verify_find(handles[0], 1, 0);
+    for (i = 1; i < num_handles; i++) {
+        ble_hs_conn_test_util_verify_find(handles[i], i + 1, 1);
+    }
+
+    /*** Reuse the freed handle. */
+    ble_hs_test_util_create_conn(handles[0],
+                                 ((uint8_t[]){ 1, 2, 3, 4, 5, 6 }),
+                                 NULL, NULL);
+    for (i = 0; i < num_handles; i++) {
+        ble_hs_conn_test_util_verify_find(handles[i], i + 1, 1);
+    }
+
+    for (i = 0; i < num_handles; i++) {
+        ble_hs_test_util_conn_disconnect(handles[i]);
+    }
+    TEST_ASSERT(!ble_hs_conn_test_util_any());
+}
+
 TEST_SUITE(conn_suite)
 {
     tu_suite_set_post_test_cb(ble_hs_test_util_post_test, NULL);
@@ -207,6 +276,7 @@ TEST_SUITE(conn_suite)
     ble_hs_conn_test_direct_connect_success();
     ble_hs_conn_test_direct_connectable_success();
     ble_hs_conn_test_undirect_connectable_success();
+    ble_hs_conn_test_find();
 }
 
 int
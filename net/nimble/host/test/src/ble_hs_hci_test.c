@@ -83,12 +83,131 @@ TEST_CASE(ble_hs_hci_test_rssi)
     TEST_ASSERT(rc == BLE_HS_ECONTROLLER);
 }
 
+static int ble_hs_hci_test_data_len_event_cnt;
+static uint16_t ble_hs_hci_test_data_len_tx_octets;
+
+static int
+ble_hs_hci_test_data_len_gap_cb(struct ble_gap_event *event, void *arg)
+{
+    if (event->type == BLE_GAP_EVENT_DATA_LEN) {
+        ble_hs_hci_test_data_len_event_cnt++;
+        ble_hs_hci_test_data_len_tx_octets = event->data_len.max_tx_octets;
+    }
+
+    return 0;
+}
+
+static void
+ble_hs_hci_test_rx_data_len_chg(uint16_t conn_handle, uint16_t max_tx_octets)
+{
+    uint8_t *buf;
+    int rc;
+
+    buf = ble_hci_trans_buf_alloc(BLE_HCI_TRANS_BUF_EVT_HI);
+    TEST_ASSERT_FATAL(buf != NULL);
+
+    buf[0] = BLE_HCI_EVCODE_LE_META;
+    buf[1] = BLE_HCI_LE_DATA_LEN_CHG_LEN;
+    buf[2] = BLE_HCI_LE_SUBEV_DATA_LEN_CHG;
+    put_le16(buf + 3, conn_handle);
+    put_le16(buf + 5, max_tx_octets);
+    put_le16(buf + 7, BLE_HCI_SET_DATALEN_TX_TIME_MAX);
+    put_le16(buf + 9, BLE_HCI_SET_DATALEN_TX_OCTETS_MAX);
+    put_le16(buf + 11, BLE_HCI_SET_DATALEN_TX_TIME_MAX);
+
+    rc = ble_hs_hci_evt_process(buf);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+/**
+ * Transmits an ACL data packet of the specified size and returns the number
+ * of HCI fragments it was split into.
+ */
+static int
+ble_hs_hci_test_acl_tx_frag_cnt(uint16_t conn_handle, int len)
+{
+    static const uint8_t zeros[BLE_HCI_SET_DATALEN_TX_OCTETS_MAX];
+    struct ble_hs_conn *conn;
+    struct os_mbuf *om;
+    int rc;
+
+    TEST_ASSERT_FATAL(len <= sizeof zeros);
+
+    om = ble_hs_mbuf_acm_pkt();
+    TEST_ASSERT_FATAL(om != NULL);
+    rc = os_mbuf_append(om, zeros, len);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    ble_hs_test_util_prev_tx_queue_clear();
+
+    ble_hs_lock();
+    conn = ble_hs_conn_find_assert(conn_handle);
+    rc = ble_hs_hci_acl_tx(conn, om);
+    ble_hs_unlock();
+    TEST_ASSERT_FATAL(rc == 0);
+
+    ble_hs_test_util_tx_all();
+    return ble_hs_test_util_prev_tx_queue_sz();
+}
+
+TEST_CASE(ble_hs_hci_test_data_len)
+{
+    struct ble_gap_conn_desc desc;
+    int rc;
+
+    ble_hs_test_util_init();
+
+    /* Let the controller accept full-size LL payloads. */
+    rc = ble_hs_hci_set_buf_sz(BLE_HCI_SET_DATALEN_TX_OCTETS_MAX +
+                               BLE_HCI_DATA_HDR_SZ, 10);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    ble_hs_hci_test_data_len_event_cnt = 0;
+    ble_hs_test_util_create_conn(2, ((uint8_t[]){1,2,3,4,5,6}),
+                                 ble_hs_hci_test_data_len_gap_cb, NULL);
+
+    rc = ble_gap_conn_find(2, &desc);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(desc.max_tx_octets == BLE_HCI_SET_DATALEN_TX_OCTETS_MIN);
+
+    /*** Default data length; fragment to 27-byte PDUs. */
+    TEST_ASSERT(ble_hs_hci_test_acl_tx_frag_cnt(2, 100) == 4);
+
+    /*** Extended data length; whole packet fits in one PDU. */
+    ble_hs_hci_test_rx_data_len_chg(2, BLE_HCI_SET_DATALEN_TX_OCTETS_MAX);
+    TEST_ASSERT(ble_hs_hci_test_data_len_event_cnt == 1);
+    TEST_ASSERT(ble_hs_hci_test_data_len_tx_octets ==
+                BLE_HCI_SET_DATALEN_TX_OCTETS_MAX);
+
+    rc = ble_gap_conn_find(2, &desc);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(desc.max_tx_octets == BLE_HCI_SET_DATALEN_TX_OCTETS_MAX);
+
+    TEST_ASSERT(ble_hs_hci_test_acl_tx_frag_cnt(2, 100) == 1);
+    TEST_ASSERT(ble_hs_hci_test_acl_tx_frag_cnt(2, 251) == 1);
+
+    /*** Controller buffer smaller than data length still limits fragments. */
+    rc = ble_hs_hci_set_buf_sz(64 + BLE_HCI_DATA_HDR_SZ, 10);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(ble_hs_hci_test_acl_tx_frag_cnt(2, 100) == 2);
+
+    /*** Data length update requests are validated before going out. */
+    rc = ble_gap_set_data_len(2, BLE_HCI_SET_DATALEN_TX_OCTETS_MAX + 1,
+                              BLE_HCI_SET_DATALEN_TX_TIME_MAX);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+
+    rc = ble_gap_set_data_len(3, BLE_HCI_SET_DATALEN_TX_OCTETS_MAX,
+                              BLE_HCI_SET_DATALEN_TX_TIME_MAX);
+    TEST_ASSERT(rc == BLE_HS_ENOTCONN);
+}
+
 TEST_SUITE(ble_hs_hci_suite)
 {
     tu_suite_set_post_test_cb(ble_hs_test_util_post_test, NULL);
 
     ble_hs_hci_test_event_bad();
     ble_hs_hci_test_rssi();
+    ble_hs_hci_test_data_len();
 }
 
 int
@@ -1487,6 +1487,22 @@ ble_hs_test_util_tx_all(void)
     ble_hs_process_tx_data_queue();
 }
 
+/**
+ * Executes every event queued to the host.  The OS is not running during most
+ * tests, so events are pulled off the queue directly rather than via
+ * os_eventq_run().
+ */
+void
+ble_hs_test_util_evq_run_all(void)
+{
+    struct os_event *ev;
+
+    while ((ev = STAILQ_FIRST(&ble_hs_test_util_evq.evq_list)) != NULL) {
+        os_eventq_remove(&ble_hs_test_util_evq, ev);
+        ev->ev_cb(ev);
+    }
+}
+
 void
 ble_hs_test_util_verify_tx_prep_write(uint16_t attr_handle, uint16_t offset,
                                       const void *data, int data_len)
@@ -2203,6 +2219,13 @@ ble_hs_test_util_mbuf_count(const struct ble_hs_test_util_mbuf_params *params)
                 count += ble_hs_test_util_mbuf_chain_len(prep->bape_value);
             }
         }
+
+#if MYNEWT_VAL(BLE_ATT_SVR_READ_CACHE)
+        if (params->prep_list) {
+            count += ble_hs_test_util_mbuf_chain_len(
+                conn->bhc_att_svr.basc_read_cache);
+        }
+#endif
     }
     ble_hs_unlock();
 
@@ -929,6 +929,7 @@ ble_l2cap_test_coc_send_data(struct test_data *t)
     struct os_mbuf *sdu;
     struct os_mbuf *sdu_copy;
     struct event *ev = &t->event[t->event_iter++];
+    struct ble_l2cap_chan_stats stats;
     int rc;
 
     /* Send data event is created only for testing.
@@ -965,6 +966,11 @@ ble_l2cap_test_coc_send_data(struct test_data *t)
 
     ble_hs_test_util_verify_tx_l2cap(sdu);
 
+    rc = ble_l2cap_get_chan_stats(t->chan, &stats);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(stats.tx_sdus == 1);
+    TEST_ASSERT(stats.tx_bytes == ev->data_len);
+
     os_mbuf_free_chain(sdu_copy);
 }
 
@@ -972,6 +978,7 @@ static void
 ble_l2cap_test_coc_recv_data(struct test_data *t)
 {
     struct os_mbuf *sdu;
+    struct ble_l2cap_chan_stats stats;
     int rc;
     struct event *ev = &t->event[t->event_iter++];
 
@@ -989,6 +996,11 @@ ble_l2cap_test_coc_recv_data(struct test_data *t)
     put_le16(sdu->om_data, ev->data_len);
 
     ble_hs_test_util_inject_rx_l2cap(2, t->chan->scid, sdu);
+
+    rc = ble_l2cap_get_chan_stats(t->chan, &stats);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(stats.rx_sdus == 1);
+    TEST_ASSERT(stats.rx_bytes == ev->data_len);
 }
 
 static void
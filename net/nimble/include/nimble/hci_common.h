@@ -57,7 +57,7 @@ extern "C" {
  * Number of LE commands. NOTE: this is really just used to size the array
  * containing the lengths of the LE commands.
  */
-#define BLE_HCI_NUM_LE_CMDS                 (48)
+#define BLE_HCI_NUM_LE_CMDS                 (51)
 
 /* List of OCF for Link Control commands (OGF=0x01) */
 #define BLE_HCI_OCF_DISCONNECT_CMD          (0x0006)
@@ -128,6 +128,9 @@ extern "C" {
 #define BLE_HCI_OCF_LE_SET_ADDR_RES_EN      (0x002D)
 #define BLE_HCI_OCF_LE_SET_RPA_TMO          (0x002E)
 #define BLE_HCI_OCF_LE_RD_MAX_DATA_LEN      (0x002F)
+#define BLE_HCI_OCF_LE_RD_PHY               (0x0030)
+#define BLE_HCI_OCF_LE_SET_DEFAULT_PHY      (0x0031)
+#define BLE_HCI_OCF_LE_SET_PHY              (0x0032)
 
 /* Command Specific Definitions */
 /* --- Disconnect command (OGF 0x01, OCF 0x0006) --- */
@@ -383,6 +386,27 @@ extern "C" {
 /* --- LE read maximum data length (OCF 0x002F) */
 #define BLE_HCI_RD_MAX_DATALEN_RSPLEN       (8)
 
+/* --- LE read PHY (OCF 0x0030) */
+#define BLE_HCI_LE_RD_PHY_LEN               (2)
+#define BLE_HCI_LE_RD_PHY_RSPLEN            (4)
+#define BLE_HCI_LE_PHY_1M                   (1)
+#define BLE_HCI_LE_PHY_2M                   (2)
+#define BLE_HCI_LE_PHY_CODED                (3)
+
+/* --- LE set default PHY (OCF 0x0031) */
+#define BLE_HCI_LE_SET_DEFAULT_PHY_LEN      (3)
+#define BLE_HCI_LE_PHY_NO_TX_PREF_MASK      (0x01)
+#define BLE_HCI_LE_PHY_NO_RX_PREF_MASK      (0x02)
+#define BLE_HCI_LE_PHY_1M_PREF_MASK         (0x01)
+#define BLE_HCI_LE_PHY_2M_PREF_MASK         (0x02)
+#define BLE_HCI_LE_PHY_CODED_PREF_MASK      (0x04)
+#define BLE_HCI_LE_PHY_PREF_MASK_ALL        \
+    (BLE_HCI_LE_PHY_1M_PREF_MASK | BLE_HCI_LE_PHY_2M_PREF_MASK |  \
+     BLE_HCI_LE_PHY_CODED_PREF_MASK)
+
+/* --- LE set PHY (OCF 0x0032) */
+#define BLE_HCI_LE_SET_PHY_LEN              (7)
+
 /* Event Codes */
 #define BLE_HCI_EVCODE_INQUIRY_CMP          (0x01)
 #define BLE_HCI_EVCODE_INQUIRY_RESULT       (0x02)
@@ -474,6 +498,7 @@ extern "C" {
 #define BLE_HCI_LE_SUBEV_GEN_DHKEY_COMPLETE (0x09)
 #define BLE_HCI_LE_SUBEV_ENH_CONN_COMPLETE  (0x0A)
 #define BLE_HCI_LE_SUBEV_DIRECT_ADV_RPT     (0x0B)
+#define BLE_HCI_LE_SUBEV_PHY_UPDATE_COMPLETE (0x0C)
 
 /* Generic event header */
 #define BLE_HCI_EVENT_HDR_LEN               (2)
@@ -548,6 +573,9 @@ extern "C" {
 /* LE data length change event (sub event 0x07) */
 #define BLE_HCI_LE_DATA_LEN_CHG_LEN         (11)
 
+/* LE PHY update complete event (sub event 0x0C) */
+#define BLE_HCI_LE_PHY_UPD_LEN              (6)
+
 /* Bluetooth Assigned numbers for version information.*/
 #define BLE_HCI_VER_BCS_1_0b                (0)
 #define BLE_HCI_VER_BCS_1_1                 (1)
@@ -710,6 +738,27 @@ struct hci_le_conn_upd_complete
     uint16_t supervision_timeout;
 };
 
+/* Data length change LE meta subevent */
+struct hci_le_data_len_chg
+{
+    uint8_t subevent_code;
+    uint16_t connection_handle;
+    uint16_t max_tx_octets;
+    uint16_t max_tx_time;
+    uint16_t max_rx_octets;
+    uint16_t max_rx_time;
+};
+
+/* PHY update complete LE meta subevent */
+struct hci_le_phy_upd_complete
+{
+    uint8_t subevent_code;
+    uint8_t status;
+    uint16_t connection_handle;
+    uint8_t tx_phy;
+    uint8_t rx_phy;
+};
+
 /* Remote connection parameter request LE meta subevent */
 struct hci_le_conn_param_req
 {
@@ -27,6 +27,7 @@ extern "C" {
 /* Here is a list of the vendor specific OCFs */
 #define BLE_HCI_OCF_VENDOR_CAPS         (0x153)
 #define BLE_HCI_OCF_MULTI_ADV           (0x154)
+#define BLE_HCI_OCF_ADV_RPT_FILT        (0x155)
 
 /* Multi-advertiser sub-commands */
 #define BLE_HCI_MULTI_ADV_PARAMS        (0x01)
@@ -42,6 +43,23 @@ extern "C" {
 #define BLE_HCI_MULTI_ADV_SET_RAND_ADDR_LEN (8)
 #define BLE_HCI_MULTI_ADV_ENABLE_LEN        (3)
 
+/* Advertising report filter sub-commands */
+#define BLE_HCI_ADV_RPT_FILT_CLEAR          (0x01)
+#define BLE_HCI_ADV_RPT_FILT_ADD            (0x02)
+#define BLE_HCI_ADV_RPT_FILT_ENABLE         (0x03)
+
+/* Advertising report filter types */
+#define BLE_HCI_ADV_RPT_FILT_TYPE_MFG_ID    (0x01)
+#define BLE_HCI_ADV_RPT_FILT_TYPE_UUID16    (0x02)
+#define BLE_HCI_ADV_RPT_FILT_TYPE_UUID32    (0x03)
+#define BLE_HCI_ADV_RPT_FILT_TYPE_UUID128   (0x04)
+
+/* Command lengths. Includes sub-command opcode */
+#define BLE_HCI_ADV_RPT_FILT_CLEAR_LEN      (1)
+#define BLE_HCI_ADV_RPT_FILT_ADD_MIN_LEN    (4)
+#define BLE_HCI_ADV_RPT_FILT_ADD_MAX_LEN    (18)
+#define BLE_HCI_ADV_RPT_FILT_ENABLE_LEN     (2)
+
 /* Vendor specific events (LE meta events) */
 #define BLE_HCI_LE_SUBEV_ADV_STATE_CHG      (0x55)
 
@@ -104,6 +122,31 @@ struct hci_multi_adv_params
  *  - Multi-adv opcode (1)
  */
 
+/*
+ * Advertising report filter commands (OCF BLE_HCI_OCF_ADV_RPT_FILT):
+ *
+ * Clear:
+ *  - Sub-command (1)
+ *
+ * Add:
+ *  - Sub-command (1)
+ *  - Filter type (1)
+ *  - Value length (1): 2 for a manufacturer ID, 2/4/16 for a UUID
+ *  - Value (2 to 16), little endian
+ *
+ * Enable:
+ *  - Sub-command (1)
+ *  - Enable (1)
+ *
+ * A manufacturer ID filter matches a manufacturer specific data field that
+ * begins with the company identifier. A UUID filter matches the UUID in a
+ * complete or incomplete service UUID list or in a service data field.
+ *
+ * All of these commands generate a Command Complete with this format:
+ *  - Status (1)
+ *  - Sub-command (1)
+ */
+
 
 #ifdef __cplusplus
 }
@@ -75,4 +75,7 @@ const uint8_t g_ble_hci_le_cmd_len[BLE_HCI_NUM_LE_CMDS] =
     sizeof(uint8_t),                    /* 0x002D: set addr resolution enable */
     sizeof(uint16_t),                   /* 0x002E: Set resolv priv addr tmo */
     0,                                  /* 0x002F: Read max data length */
+    BLE_HCI_LE_RD_PHY_LEN,              /* 0x0030: Read PHY */
+    BLE_HCI_LE_SET_DEFAULT_PHY_LEN,     /* 0x0031: Set default PHY */
+    BLE_HCI_LE_SET_PHY_LEN,             /* 0x0032: Set PHY */
 };
@@ -35,6 +35,10 @@
  */
 #include "syscfg/syscfg.h"
 
+#if MYNEWT_VAL(BLE_SOCK_USE_LINUX_BLUE)
+#define _GNU_SOURCE     /* sendmmsg() */
+#endif
+
 #include <assert.h>
 #include <string.h>
 #include <stdio.h>
@@ -156,14 +160,34 @@ static void *ble_hci_sock_rx_cmd_arg;
 static ble_hci_trans_rx_acl_fn *ble_hci_sock_rx_acl_cb;
 static void *ble_hci_sock_rx_acl_arg;
 
+#if MYNEWT_VAL(BLE_SOCK_RX_BUF_SIZE) < MYNEWT_VAL(BLE_ACL_BUF_SIZE) + \
+    BLE_HCI_DATA_HDR_SZ + 1
+#error "BLE_SOCK_RX_BUF_SIZE must hold at least one ACL packet"
+#endif
+
+/*
+ * Outgoing ACL packets are queued, and sent from the event queue in
+ * batches of up to BLE_HCI_SOCK_TX_BATCH packets per system call; a
+ * single sendmsg() over TCP, sendmmsg() for Linux Bluetooth sockets
+ * (which take one packet per message).
+ */
+#define BLE_HCI_SOCK_TX_BATCH       16
+#define BLE_HCI_SOCK_TX_IOV         64
+
+/* Maximum number of reads per RX event before yielding. */
+#define BLE_HCI_SOCK_RX_READS       16
+
 static struct ble_hci_sock_state {
     int sock;
     struct os_eventq *evq;
     struct os_event ev;
+    struct os_event tx_ev;
     struct os_callout timer;
 
-    uint8_t rx_off;
-    uint8_t rx_data[512];
+    STAILQ_HEAD(, os_mbuf_pkthdr) tx_q;
+
+    uint16_t rx_off;
+    uint8_t rx_data[MYNEWT_VAL(BLE_SOCK_RX_BUF_SIZE)];
 } ble_hci_sock_state;
 
 /**
@@ -186,45 +210,128 @@ ble_hci_trans_acl_buf_alloc(void)
     return m;
 }
 
-static int
-ble_hci_sock_acl_tx(struct os_mbuf *om)
+/*
+ * Sends all queued ACL packets.
+ */
+static void
+ble_hci_sock_acl_flush(void)
 {
+    static uint8_t ch = BLE_HCI_UART_H4_ACL;
+    struct ble_hci_sock_state *bhss;
+    STAILQ_HEAD(, os_mbuf_pkthdr) txq;
+    struct os_mbuf_pkthdr *omp;
+    struct iovec iov[BLE_HCI_SOCK_TX_IOV];
+#if MYNEWT_VAL(BLE_SOCK_USE_LINUX_BLUE)
+    struct mmsghdr msgs[BLE_HCI_SOCK_TX_BATCH];
+#else
     struct msghdr msg;
-    struct iovec iov[8];
-    int i;
+#endif
     struct os_mbuf *m;
-    uint8_t ch;
+    int first;
+    int total;
+    int niov;
+    int cnt;
+    int rc;
+    int sr;
 
-    memset(&msg, 0, sizeof(msg));
-    memset(iov, 0, sizeof(iov));
+    bhss = &ble_hci_sock_state;
 
-    msg.msg_iov = iov;
+    /* Take the whole queue; more may be added while we send. */
+    STAILQ_INIT(&txq);
+    OS_ENTER_CRITICAL(sr);
+    txq.stqh_first = STAILQ_FIRST(&bhss->tx_q);
+    STAILQ_INIT(&bhss->tx_q);
+    OS_EXIT_CRITICAL(sr);
+
+    while (STAILQ_FIRST(&txq)) {
+        cnt = 0;
+        niov = 0;
+        total = 0;
+        for (omp = STAILQ_FIRST(&txq); omp; omp = STAILQ_NEXT(omp, omp_next)) {
+            if (cnt == BLE_HCI_SOCK_TX_BATCH) {
+                break;
+            }
+            first = niov;
+            if (niov == BLE_HCI_SOCK_TX_IOV) {
+                break;
+            }
+            iov[niov].iov_base = &ch;
+            iov[niov].iov_len = 1;
+            niov++;
+            for (m = OS_MBUF_PKTHDR_TO_MBUF(omp); m; m = SLIST_NEXT(m, om_next)) {
+                if (niov == BLE_HCI_SOCK_TX_IOV) {
+                    break;
+                }
+                iov[niov].iov_base = m->om_data;
+                iov[niov].iov_len = m->om_len;
+                niov++;
+            }
+            if (m) {
+                /* Doesn't fit; goes into the next batch. */
+                niov = first;
+                break;
+            }
+#if MYNEWT_VAL(BLE_SOCK_USE_LINUX_BLUE)
+            memset(&msgs[cnt], 0, sizeof(msgs[cnt]));
+            msgs[cnt].msg_hdr.msg_iov = &iov[first];
+            msgs[cnt].msg_hdr.msg_iovlen = niov - first;
+#endif
+            total += omp->omp_len + 1;
+            cnt++;
+        }
+        assert(cnt > 0);
 
-    ch = BLE_HCI_UART_H4_ACL;
-    iov[0].iov_len = 1;
-    iov[0].iov_base = &ch;
-    i = 1;
-    for (m = om; m; m = SLIST_NEXT(m, om_next)) {
-        iov[i].iov_base = m->om_data;
-        iov[i].iov_len = m->om_len;
-        i++;
-    }
-    msg.msg_iovlen = i;
+        STATS_INCN(hci_sock_stats, omsg, cnt);
+        STATS_INCN(hci_sock_stats, oacl, cnt);
+        STATS_INCN(hci_sock_stats, obytes, total);
+#if MYNEWT_VAL(BLE_SOCK_USE_LINUX_BLUE)
+        rc = sendmmsg(bhss->sock, msgs, cnt, 0);
+        if (rc != cnt) {
+            dprintf(1, "sendmmsg() sent %d of %d\n", rc, cnt);
+            STATS_INC(hci_sock_stats, oerr);
+        }
+#else
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = niov;
+        rc = sendmsg(bhss->sock, &msg, 0);
+        if (rc != total) {
+            if (rc < 0) {
+                dprintf(1, "sendmsg() failed : %d\n", errno);
+            } else {
+                dprintf(1, "sendmsg() partial write: %d\n", rc);
+            }
+            STATS_INC(hci_sock_stats, oerr);
+        }
+#endif
 
-    STATS_INC(hci_sock_stats, omsg);
-    STATS_INC(hci_sock_stats, oacl);
-    STATS_INCN(hci_sock_stats, obytes, OS_MBUF_PKTLEN(om) + 1);
-    i = sendmsg(ble_hci_sock_state.sock, &msg, 0);
-    os_mbuf_free_chain(om);
-    if (i != OS_MBUF_PKTLEN(om) + 1) {
-        if (i < 0) {
-            dprintf(1, "sendmsg() failed : %d\n", errno);
-        } else {
-            dprintf(1, "sendmsg() partial write: %d\n", i);
+        while (cnt--) {
+            omp = STAILQ_FIRST(&txq);
+            STAILQ_REMOVE_HEAD(&txq, omp_next);
+            os_mbuf_free_chain(OS_MBUF_PKTHDR_TO_MBUF(omp));
         }
-        STATS_INC(hci_sock_stats, oerr);
-        return BLE_ERR_MEM_CAPACITY;
     }
+}
+
+static void
+ble_hci_sock_tx_ev(struct os_event *ev)
+{
+    ble_hci_sock_acl_flush();
+}
+
+static int
+ble_hci_sock_acl_tx(struct os_mbuf *om)
+{
+    struct ble_hci_sock_state *bhss;
+    int sr;
+
+    bhss = &ble_hci_sock_state;
+
+    OS_ENTER_CRITICAL(sr);
+    STAILQ_INSERT_TAIL(&bhss->tx_q, OS_MBUF_PKTHDR(om), omp_next);
+    OS_EXIT_CRITICAL(sr);
+    os_eventq_put(bhss->evq, &bhss->tx_ev);
+
     return 0;
 }
 
@@ -237,6 +344,9 @@ ble_hci_sock_cmdevt_tx(uint8_t *hci_ev, uint8_t h4_type)
     int i;
     uint8_t ch;
 
+    /* Keep ordering with ACL data queued before this. */
+    ble_hci_sock_acl_flush();
+
     memset(&msg, 0, sizeof(msg));
     memset(iov, 0, sizeof(iov));
 
@@ -276,41 +386,37 @@ ble_hci_sock_cmdevt_tx(uint8_t *hci_ev, uint8_t h4_type)
     return 0;
 }
 
-static int
-ble_hci_sock_rx_msg(void)
+/*
+ * Delivers all complete packets at the start of the RX buffer, and moves
+ * what is left of it to the front.
+ */
+static void
+ble_hci_sock_rx_parse(void)
 {
     struct ble_hci_sock_state *bhss;
-    int len;
     struct os_mbuf *m;
     uint8_t *data;
+    uint8_t *pkt;
+    int left;
+    int off;
+    int len;
     int sr;
     int rc;
 
     bhss = &ble_hci_sock_state;
-    if (bhss->sock < 0) {
-        return -1;
-    }
-    len = read(bhss->sock, bhss->rx_data + bhss->rx_off,
-               sizeof(bhss->rx_data) - bhss->rx_off);
-    if (len < 0) {
-        return -2;
-    }
-    if (len == 0) {
-        return -1;
-    }
-    bhss->rx_off += len;
-    STATS_INCN(hci_sock_stats, ibytes, len);
-
-    while (bhss->rx_off > 0) {
-        switch (bhss->rx_data[0]) {
+    off = 0;
+    while (off < bhss->rx_off) {
+        pkt = &bhss->rx_data[off];
+        left = bhss->rx_off - off;
+        switch (pkt[0]) {
 #if MYNEWT_VAL(BLE_DEVICE)
         case BLE_HCI_UART_H4_CMD:
-            if (bhss->rx_off < BLE_HCI_CMD_HDR_LEN) {
-                return -1;
+            if (left < 1 + BLE_HCI_CMD_HDR_LEN) {
+                goto out;
             }
-            len = 1 + BLE_HCI_CMD_HDR_LEN + bhss->rx_data[3];
-            if (bhss->rx_off < len) {
-                return -1;
+            len = 1 + BLE_HCI_CMD_HDR_LEN + pkt[3];
+            if (left < len) {
+                goto out;
             }
             STATS_INC(hci_sock_stats, imsg);
             STATS_INC(hci_sock_stats, icmd);
@@ -319,7 +425,7 @@ ble_hci_sock_rx_msg(void)
                 STATS_INC(hci_sock_stats, ierr);
                 break;
             }
-            memcpy(data, &bhss->rx_data[1], len - 1);
+            memcpy(data, &pkt[1], len - 1);
             OS_ENTER_CRITICAL(sr);
             rc = ble_hci_sock_rx_cmd_cb(data, ble_hci_sock_rx_cmd_arg);
             OS_EXIT_CRITICAL(sr);
@@ -332,12 +438,12 @@ ble_hci_sock_rx_msg(void)
 #endif
 #if MYNEWT_VAL(BLE_HOST)
         case BLE_HCI_UART_H4_EVT:
-            if (bhss->rx_off < BLE_HCI_EVENT_HDR_LEN) {
-                return -1;
+            if (left < 1 + BLE_HCI_EVENT_HDR_LEN) {
+                goto out;
             }
-            len = 1 + BLE_HCI_EVENT_HDR_LEN + bhss->rx_data[2];
-            if (bhss->rx_off < len) {
-                return -1;
+            len = 1 + BLE_HCI_EVENT_HDR_LEN + pkt[2];
+            if (left < len) {
+                goto out;
             }
             STATS_INC(hci_sock_stats, imsg);
             STATS_INC(hci_sock_stats, ievt);
@@ -346,25 +452,25 @@ ble_hci_sock_rx_msg(void)
                 STATS_INC(hci_sock_stats, ierr);
                 break;
             }
-            memcpy(data, &bhss->rx_data[1], len - 1);
+            memcpy(data, &pkt[1], len - 1);
             OS_ENTER_CRITICAL(sr);
             rc = ble_hci_sock_rx_cmd_cb(data, ble_hci_sock_rx_cmd_arg);
             OS_EXIT_CRITICAL(sr);
             if (rc) {
+                /* Keep the event; try it again on next RX event. */
                 ble_hci_trans_buf_free(data);
                 STATS_INC(hci_sock_stats, ierr);
-                return 0;
+                goto out;
             }
             break;
 #endif
         case BLE_HCI_UART_H4_ACL:
-            if (bhss->rx_off < BLE_HCI_DATA_HDR_SZ) {
-                return -1;
+            if (left < 1 + BLE_HCI_DATA_HDR_SZ) {
+                goto out;
             }
-            len = 1 + BLE_HCI_DATA_HDR_SZ + (bhss->rx_data[4] << 8) +
-              bhss->rx_data[3];
-            if (bhss->rx_off < len) {
-                return -1;
+            len = 1 + BLE_HCI_DATA_HDR_SZ + (pkt[4] << 8) + pkt[3];
+            if (left < len) {
+                goto out;
             }
             STATS_INC(hci_sock_stats, imsg);
             STATS_INC(hci_sock_stats, iacl);
@@ -373,7 +479,7 @@ ble_hci_sock_rx_msg(void)
                 STATS_INC(hci_sock_stats, imem);
                 break;
             }
-            if (os_mbuf_append(m, &bhss->rx_data[1], len - 1)) {
+            if (os_mbuf_append(m, &pkt[1], len - 1)) {
                 STATS_INC(hci_sock_stats, imem);
                 os_mbuf_free_chain(m);
                 break;
@@ -383,11 +489,55 @@ ble_hci_sock_rx_msg(void)
             OS_EXIT_CRITICAL(sr);
             break;
         default:
+            /* Lost sync; drop everything we have. */
             STATS_INC(hci_sock_stats, ierr);
+            len = left;
             break;
         }
-        memmove(bhss->rx_data, &bhss->rx_data[len], bhss->rx_off - len);
-        bhss->rx_off -= len;
+        off += len;
+    }
+out:
+    if (off) {
+        memmove(bhss->rx_data, &bhss->rx_data[off], bhss->rx_off - off);
+        bhss->rx_off -= off;
+    }
+}
+
+/*
+ * Reads what the socket has, up to BLE_HCI_SOCK_RX_READS times, parsing
+ * as many packets as each read brought in.
+ *
+ * @return                      0 if more data may be waiting;
+ *                              -1 if the socket had nothing to read.
+ */
+static int
+ble_hci_sock_rx_msg(void)
+{
+    struct ble_hci_sock_state *bhss;
+    int reads;
+    int len;
+
+    bhss = &ble_hci_sock_state;
+    if (bhss->sock < 0) {
+        return -1;
+    }
+    /* Retry anything left undelivered last time. */
+    ble_hci_sock_rx_parse();
+
+    for (reads = 0; reads < BLE_HCI_SOCK_RX_READS; reads++) {
+        len = read(bhss->sock, bhss->rx_data + bhss->rx_off,
+                   sizeof(bhss->rx_data) - bhss->rx_off);
+        if (len <= 0) {
+            return reads ? 0 : -1;
+        }
+        bhss->rx_off += len;
+        STATS_INCN(hci_sock_stats, ibytes, len);
+
+        ble_hci_sock_rx_parse();
+        if (bhss->rx_off == sizeof(bhss->rx_data)) {
+            /* Stuck on a packet we can't deliver yet. */
+            return -1;
+        }
     }
     return 0;
 }
@@ -698,10 +848,18 @@ ble_hci_trans_buf_free(uint8_t *buf)
 int
 ble_hci_trans_reset(void)
 {
+    struct os_mbuf_pkthdr *omp;
     int rc;
 
     os_callout_stop(&ble_hci_sock_state.timer);
 
+    /* Drop ACL data not yet sent. */
+    os_eventq_remove(ble_hci_sock_state.evq, &ble_hci_sock_state.tx_ev);
+    while ((omp = STAILQ_FIRST(&ble_hci_sock_state.tx_q)) != NULL) {
+        STAILQ_REMOVE_HEAD(&ble_hci_sock_state.tx_q, omp_next);
+        os_mbuf_free_chain(OS_MBUF_PKTHDR_TO_MBUF(omp));
+    }
+
     /* Reopen the UART. */
     rc = ble_hci_sock_config();
     if (rc != 0) {
@@ -742,6 +900,8 @@ ble_hci_sock_init(void)
 
     ble_hci_sock_set_evq(os_eventq_dflt_get());
     ble_hci_sock_state.ev.ev_cb = ble_hci_sock_rx_ev;
+    ble_hci_sock_state.tx_ev.ev_cb = ble_hci_sock_tx_ev;
+    STAILQ_INIT(&ble_hci_sock_state.tx_q);
 
     /*
      * The MBUF payload size must accommodate the HCI data header size plus the
@@ -155,6 +155,21 @@ static struct {
 
 static uint16_t ble_hci_uart_max_acl_datalen;
 
+#if MYNEWT_VAL(BLE_HCI_UART_RX_RING_SIZE) > 0
+/**
+ * Receive ring. The UART interrupt only stores bytes here; packets are
+ * parsed, a block at a time, from an event on the transport event queue.
+ */
+static struct {
+    uint8_t buf[MYNEWT_VAL(BLE_HCI_UART_RX_RING_SIZE)];
+    volatile uint16_t head;     /* Written by the UART interrupt */
+    volatile uint16_t tail;     /* Written by the event handler */
+    volatile uint8_t stalled;   /* Receiver stopped as ring was full */
+    struct os_eventq *evq;
+    struct os_event ev;
+} ble_hci_uart_rx_ring;
+#endif
+
 /**
  * Allocates a buffer (mbuf) for ACL operation.
  *
@@ -703,6 +718,233 @@ ble_hci_uart_rx_char(void *arg, uint8_t data)
     }
 }
 
+#if MYNEWT_VAL(BLE_HCI_UART_RX_RING_SIZE) > 0
+/**
+ * Consumes as many bytes of a command or event as are available in a block
+ * of received data.
+ *
+ * @param data      Pointer to received data
+ * @param len       Number of bytes available
+ * @param hdr_len   Length of the command/event header
+ * @param len_off   Offset of the parameter length byte in the header
+ *
+ * @return int Number of bytes consumed.
+ */
+static int
+ble_hci_uart_rx_cmdevt_block(const uint8_t *data, int len, int hdr_len,
+                             int len_off)
+{
+    struct ble_hci_uart_cmd *rxcmd;
+    int copylen;
+    int rc;
+
+    rxcmd = &ble_hci_uart_state.rx_cmd;
+    if (rxcmd->cur < hdr_len) {
+        copylen = hdr_len - rxcmd->cur;
+    } else {
+        copylen = rxcmd->len - rxcmd->cur;
+    }
+    if (copylen > len) {
+        copylen = len;
+    }
+
+    memcpy(rxcmd->data + rxcmd->cur, data, copylen);
+    rxcmd->cur += copylen;
+
+    if (rxcmd->cur < hdr_len) {
+        return copylen;
+    }
+
+    if ((rxcmd->cur == hdr_len) && (rxcmd->len == 0)) {
+        rxcmd->len = rxcmd->data[len_off] + hdr_len;
+    }
+
+    if (rxcmd->cur == rxcmd->len) {
+        assert(ble_hci_uart_rx_cmd_cb != NULL);
+        rc = ble_hci_uart_rx_cmd_cb(rxcmd->data, ble_hci_uart_rx_cmd_arg);
+        if (rc != 0) {
+            ble_hci_trans_buf_free(rxcmd->data);
+        }
+        ble_hci_uart_state.rx_type = BLE_HCI_UART_H4_NONE;
+    }
+
+    return copylen;
+}
+
+/**
+ * Consumes as many bytes of an ACL data packet as are available in a block
+ * of received data.
+ *
+ * @param data  Pointer to received data
+ * @param len   Number of bytes available
+ *
+ * @return int Number of bytes consumed.
+ */
+static int
+ble_hci_uart_rx_acl_block(const uint8_t *data, int len)
+{
+    struct ble_hci_uart_acl *rxacl;
+    uint16_t pktlen;
+    int copylen;
+
+    rxacl = &ble_hci_uart_state.rx_acl;
+    if (rxacl->rxd_bytes < BLE_HCI_DATA_HDR_SZ) {
+        copylen = BLE_HCI_DATA_HDR_SZ - rxacl->rxd_bytes;
+    } else {
+        copylen = rxacl->len - rxacl->rxd_bytes;
+    }
+    if (copylen > len) {
+        copylen = len;
+    }
+
+    memcpy(rxacl->dptr + rxacl->rxd_bytes, data, copylen);
+    rxacl->rxd_bytes += copylen;
+
+    if (rxacl->rxd_bytes < BLE_HCI_DATA_HDR_SZ) {
+        return copylen;
+    }
+
+    if ((rxacl->rxd_bytes == BLE_HCI_DATA_HDR_SZ) && (rxacl->len == 0)) {
+        pktlen = get_le16(rxacl->dptr + 2);
+        rxacl->len = pktlen + BLE_HCI_DATA_HDR_SZ;
+
+        /*
+         * Data portion cannot exceed data length of acl buffer. If it does
+         * this is considered to be a loss of sync.
+         */
+        if (pktlen > ble_hci_uart_max_acl_datalen) {
+            os_mbuf_free_chain(rxacl->buf);
+#if MYNEWT_VAL(BLE_DEVICE)
+            ble_hci_uart_sync_lost();
+#else
+            ble_hci_uart_state.rx_type = BLE_HCI_UART_H4_NONE;
+#endif
+            return copylen;
+        }
+    }
+
+    if (rxacl->rxd_bytes == rxacl->len) {
+        assert(ble_hci_uart_rx_acl_cb != NULL);
+        OS_MBUF_PKTLEN(rxacl->buf) = rxacl->rxd_bytes;
+        rxacl->buf->om_len = rxacl->rxd_bytes;
+        ble_hci_uart_rx_acl_cb(rxacl->buf, ble_hci_uart_rx_acl_arg);
+        ble_hci_uart_state.rx_type = BLE_HCI_UART_H4_NONE;
+    }
+
+    return copylen;
+}
+
+/**
+ * Block oriented version of ble_hci_uart_rx_char(). Packet bodies are copied
+ * in as large a chunk as is available; the packet type byte and the rarely
+ * used skip/sync loss states still go through the byte parser.
+ *
+ * @param data  Pointer to received data
+ * @param len   Number of bytes available (must be > 0)
+ *
+ * @return int Number of bytes consumed.
+ */
+static int
+ble_hci_uart_rx_block(const uint8_t *data, int len)
+{
+    switch (ble_hci_uart_state.rx_type) {
+#if MYNEWT_VAL(BLE_DEVICE)
+    case BLE_HCI_UART_H4_CMD:
+        return ble_hci_uart_rx_cmdevt_block(data, len, BLE_HCI_CMD_HDR_LEN, 2);
+#endif
+#if MYNEWT_VAL(BLE_HOST)
+    case BLE_HCI_UART_H4_EVT:
+        return ble_hci_uart_rx_cmdevt_block(data, len, BLE_HCI_EVENT_HDR_LEN,
+                                            1);
+#endif
+    case BLE_HCI_UART_H4_ACL:
+        return ble_hci_uart_rx_acl_block(data, len);
+    default:
+        ble_hci_uart_rx_char(NULL, data[0]);
+        return 1;
+    }
+}
+
+/**
+ * UART receive interrupt callback when the receive ring is in use. Simply
+ * stores the byte and lets the event handler parse it. If the ring is full
+ * the byte is refused, which stalls the UART receiver (and so asserts RTS
+ * when flow control is used) until the task side drains the ring.
+ */
+static int
+ble_hci_uart_rx_ring_put(void *arg, uint8_t data)
+{
+    uint16_t head;
+    uint16_t next;
+
+    head = ble_hci_uart_rx_ring.head;
+    next = head + 1;
+    if (next == MYNEWT_VAL(BLE_HCI_UART_RX_RING_SIZE)) {
+        next = 0;
+    }
+
+    if (next == ble_hci_uart_rx_ring.tail) {
+        ble_hci_uart_rx_ring.stalled = 1;
+        return -1;
+    }
+
+    ble_hci_uart_rx_ring.buf[head] = data;
+    ble_hci_uart_rx_ring.head = next;
+
+    os_eventq_put(ble_hci_uart_rx_ring.evq, &ble_hci_uart_rx_ring.ev);
+    return 0;
+}
+
+/**
+ * Event handler which drains the receive ring, parsing contiguous blocks
+ * of received data at a time.
+ */
+static void
+ble_hci_uart_rx_ring_ev(struct os_event *ev)
+{
+    os_sr_t sr;
+    uint16_t head;
+    uint16_t tail;
+    int stalled;
+    int len;
+    int rc;
+
+    while (1) {
+        head = ble_hci_uart_rx_ring.head;
+        tail = ble_hci_uart_rx_ring.tail;
+        if (head == tail) {
+            break;
+        }
+
+        if (head > tail) {
+            len = head - tail;
+        } else {
+            len = MYNEWT_VAL(BLE_HCI_UART_RX_RING_SIZE) - tail;
+        }
+
+        while (len > 0) {
+            rc = ble_hci_uart_rx_block(ble_hci_uart_rx_ring.buf + tail, len);
+            tail += rc;
+            len -= rc;
+        }
+
+        if (tail == MYNEWT_VAL(BLE_HCI_UART_RX_RING_SIZE)) {
+            tail = 0;
+        }
+        ble_hci_uart_rx_ring.tail = tail;
+
+        OS_ENTER_CRITICAL(sr);
+        stalled = ble_hci_uart_rx_ring.stalled;
+        ble_hci_uart_rx_ring.stalled = 0;
+        OS_EXIT_CRITICAL(sr);
+
+        if (stalled) {
+            hal_uart_start_rx(MYNEWT_VAL(BLE_HCI_UART_PORT));
+        }
+    }
+}
+#endif
+
 static void
 ble_hci_uart_set_rx_cbs(ble_hci_trans_rx_cmd_fn *cmd_cb,
                         void *cmd_arg,
@@ -744,7 +986,12 @@ ble_hci_uart_config(void)
 
     rc = hal_uart_init_cbs(MYNEWT_VAL(BLE_HCI_UART_PORT),
                            ble_hci_uart_tx_char, NULL,
-                           ble_hci_uart_rx_char, NULL);
+#if MYNEWT_VAL(BLE_HCI_UART_RX_RING_SIZE) > 0
+                           ble_hci_uart_rx_ring_put,
+#else
+                           ble_hci_uart_rx_char,
+#endif
+                           NULL);
     if (rc != 0) {
         return BLE_ERR_UNSPECIFIED;
     }
@@ -968,6 +1215,14 @@ ble_hci_trans_reset(void)
         return BLE_ERR_HW_FAIL;
     }
 
+#if MYNEWT_VAL(BLE_HCI_UART_RX_RING_SIZE) > 0
+    /* Discard any received data which has not been parsed yet. */
+    os_eventq_remove(ble_hci_uart_rx_ring.evq, &ble_hci_uart_rx_ring.ev);
+    ble_hci_uart_rx_ring.head = 0;
+    ble_hci_uart_rx_ring.tail = 0;
+    ble_hci_uart_rx_ring.stalled = 0;
+#endif
+
     ble_hci_uart_free_pkt(ble_hci_uart_state.rx_type,
                           ble_hci_uart_state.rx_cmd.data,
                           ble_hci_uart_state.rx_acl.buf);
@@ -1072,6 +1327,11 @@ ble_hci_uart_init(void)
                             &ble_hci_uart_pkt_buf);
     SYSINIT_PANIC_ASSERT(rc == 0);
 
+#if MYNEWT_VAL(BLE_HCI_UART_RX_RING_SIZE) > 0
+    ble_hci_uart_rx_ring.evq = os_eventq_dflt_get();
+    ble_hci_uart_rx_ring.ev.ev_cb = ble_hci_uart_rx_ring_ev;
+#endif
+
     rc = ble_hci_uart_config();
     SYSINIT_PANIC_ASSERT_MSG(rc == 0, "Failure configuring UART HCI");
 
@@ -239,6 +239,10 @@ STATS_SECT_START(coap_stats)
     STATS_SECT_ENTRY(imem)
     STATS_SECT_ENTRY(oframe)
     STATS_SECT_ENTRY(oerr)
+    STATS_SECT_ENTRY(retrans)
+    STATS_SECT_ENTRY(timeout)
+    STATS_SECT_ENTRY(rtt_samples)
+    STATS_SECT_ENTRY(rtt_ms)
 STATS_SECT_END
 
 extern STATS_SECT_DECL(coap_stats) coap_stats;
@@ -48,6 +48,9 @@ extern "C" {
 
 typedef struct coap_observer {
   SLIST_ENTRY(coap_observer) next;
+  SLIST_ENTRY(coap_observer) tok_next;  /* hashed by token */
+  SLIST_ENTRY(coap_observer) uri_next;  /* hashed by url */
+  SLIST_ENTRY(coap_observer) mid_next;  /* hashed by last_mid */
 
   oc_resource_t *resource;
 
@@ -61,6 +61,7 @@ typedef struct coap_transaction {
     uint8_t retrans_counter;
     coap_message_type_t type;
     uint32_t retrans_tmo;
+    os_time_t sent_at;
     struct os_callout retrans_timer;
     struct os_mbuf *m;
 } coap_transaction_t;
@@ -72,6 +73,7 @@ coap_transaction_t *coap_new_transaction(uint16_t mid, oc_endpoint_t *endpoint);
 void coap_send_transaction(coap_transaction_t *t);
 void coap_clear_transaction(coap_transaction_t *t);
 coap_transaction_t *coap_get_transaction_by_mid(uint16_t mid);
+void coap_transaction_rtt_sample(coap_transaction_t *t);
 
 void coap_check_transactions(void);
 
@@ -92,6 +92,13 @@ bool _oc_string_array_add_item(oc_string_array_t *ocstringarray,
 #define oc_string_array_get_allocated_size(ocstringarray)               \
     (ocstringarray.oa_sz / STRING_ARRAY_ITEM_MAX_LEN)
 
+/*
+ * Hash for lookup tables. Pass OC_HASH_INIT as initial hash; to hash
+ * data in pieces, pass in the value returned for previous piece.
+ */
+#define OC_HASH_INIT 2166136261UL
+uint32_t oc_hash(const void *data, int len, uint32_t hash);
+
 #ifdef __cplusplus
 }
 #endif
@@ -21,6 +21,7 @@
 #include <stdint.h>
 
 #include <tinycbor/cbor.h>
+#include <tinycbor/cbor_mbuf_reader.h>
 #include "oic/oc_constants.h"
 #include "oic/oc_helpers.h"
 #include "oic/port/mynewt/config.h"
@@ -192,6 +193,33 @@ int oc_rep_finalize(void);
     g_err |= cbor_encoder_close_container(&object##_map, &key##_value_array);  \
   } while (0)
 
+/*
+ * Cursor over the CBOR payload of a received message.  Handlers pull fields
+ * straight out of the mbuf, with cborattr descriptors or tinycbor calls on
+ * orc_value, instead of having oc_parse_rep() build an oc_rep_t tree.
+ */
+struct coap_packet_rx;
+struct cbor_attr_t;
+
+struct oc_rep_cursor {
+    struct cbor_mbuf_reader orc_reader;
+    CborParser orc_parser;
+    CborValue orc_value;        /* Root value of the payload */
+};
+
+/*
+ * Positions cursor at the root value of the payload in pkt.  Returns 0 on
+ * success, -1 if the packet has no payload or it is not valid CBOR.
+ */
+int oc_rep_cursor_init(struct oc_rep_cursor *cur, struct coap_packet_rx *pkt);
+
+/*
+ * Reads the fields described by attrs from the root map of the payload in
+ * pkt.  Returns 0 on success, non-zero on failure.
+ */
+int oc_rep_read_attrs(struct coap_packet_rx *pkt,
+                      const struct cbor_attr_t *attrs);
+
 #ifdef OC_CLIENT
 typedef enum {
   NIL = 0,
@@ -106,6 +106,7 @@ typedef void (*oc_request_handler_t)(oc_request_t *, oc_interface_mask_t);
 
 typedef struct oc_resource {
   SLIST_ENTRY(oc_resource) next;
+  SLIST_ENTRY(oc_resource) uri_next;  /* hashed by uri */
   int device;
   oc_string_t uri;
   oc_string_array_t types;
@@ -23,6 +23,7 @@
 #include "oic/messaging/coap/oc_coap.h"
 #include "oic/oc_rep.h"
 #include "oic/oc_ri.h"
+#include "api/oc_priv.h"
 
 #ifdef OC_SECURITY
 #include "security/oc_pstat.h"
@@ -275,6 +276,7 @@ oc_core_populate_resource(int type, const char *uri, const char *rt,
     r->put_handler = put;
     r->post_handler = post;
     r->delete_handler = delete;
+    oc_discovery_cache_invalidate();
 }
 
 oc_uuid_t *
@@ -17,6 +17,7 @@
 #include <syscfg/syscfg.h>
 
 #include "oic/port/mynewt/config.h"
+#include <cborattr/cborattr.h>
 #ifdef OC_CLIENT
 #include "oic/oc_client_state.h"
 #endif /* OC_CLIENT */
@@ -24,6 +25,90 @@
 #include "oic/messaging/coap/oc_coap.h"
 #include "oic/oc_api.h"
 #include "oic/oc_core_res.h"
+#include "api/oc_priv.h"
+
+#if MYNEWT_VAL(OC_DISC_CACHE_CNT) > 0
+/*
+ * Encoded /oic/res responses, keyed by interface and "rt" query value.
+ * Flushed whenever the set of resources changes, or the device ID does.
+ */
+#define OC_DISC_CACHE_RT_MAX    32
+
+struct oc_disc_cache_entry {
+    uint8_t odc_valid;
+    uint8_t odc_if;
+    uint8_t odc_rt_len;
+    uint16_t odc_len;                   /* 0 if nothing matched */
+    char odc_rt[OC_DISC_CACHE_RT_MAX];
+    uint8_t odc_data[MYNEWT_VAL(OC_DISC_CACHE_SIZE)];
+};
+
+static struct oc_disc_cache_entry oc_disc_cache[MYNEWT_VAL(OC_DISC_CACHE_CNT)];
+static uint8_t oc_disc_cache_next;
+static oc_uuid_t oc_disc_cache_uuid;
+#endif
+
+void
+oc_discovery_cache_invalidate(void)
+{
+#if MYNEWT_VAL(OC_DISC_CACHE_CNT) > 0
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(OC_DISC_CACHE_CNT); i++) {
+        oc_disc_cache[i].odc_valid = 0;
+    }
+#endif
+}
+
+#if MYNEWT_VAL(OC_DISC_CACHE_CNT) > 0
+static struct oc_disc_cache_entry *
+oc_disc_cache_find(oc_interface_mask_t interface, const char *rt, int rt_len)
+{
+    struct oc_disc_cache_entry *ent;
+    int i;
+
+    if (memcmp(&oc_disc_cache_uuid, oc_core_get_device_id(0),
+               sizeof(oc_disc_cache_uuid))) {
+        oc_discovery_cache_invalidate();
+        memcpy(&oc_disc_cache_uuid, oc_core_get_device_id(0),
+               sizeof(oc_disc_cache_uuid));
+        return NULL;
+    }
+    for (i = 0; i < MYNEWT_VAL(OC_DISC_CACHE_CNT); i++) {
+        ent = &oc_disc_cache[i];
+        if (ent->odc_valid && ent->odc_if == interface &&
+          ent->odc_rt_len == rt_len &&
+          (!rt_len || !memcmp(ent->odc_rt, rt, rt_len))) {
+            return ent;
+        }
+    }
+    return NULL;
+}
+
+static void
+oc_disc_cache_add(oc_interface_mask_t interface, const char *rt, int rt_len,
+                  struct os_mbuf *m, int len)
+{
+    struct oc_disc_cache_entry *ent;
+
+    if (rt_len > OC_DISC_CACHE_RT_MAX || len > sizeof(ent->odc_data)) {
+        return;
+    }
+    ent = &oc_disc_cache[oc_disc_cache_next];
+    if (len && os_mbuf_copydata(m, 0, len, ent->odc_data)) {
+        return;
+    }
+    ent->odc_if = interface;
+    ent->odc_rt_len = rt_len;
+    if (rt_len) {
+        memcpy(ent->odc_rt, rt, rt_len);
+    }
+    ent->odc_len = len;
+    ent->odc_valid = 1;
+    oc_disc_cache_next = (oc_disc_cache_next + 1) %
+      MYNEWT_VAL(OC_DISC_CACHE_CNT);
+}
+#endif
 
 static bool
 filter_resource(oc_resource_t *resource, const char *rt, int rt_len,
@@ -135,8 +220,31 @@ oc_core_discovery_handler(oc_request_t *req, oc_interface_mask_t interface)
     char *rt = NULL;
     int rt_len = 0, matches = 0;
     char uuid[37];
+#if MYNEWT_VAL(OC_DISC_CACHE_CNT) > 0
+    struct oc_disc_cache_entry *ent;
+#endif
 
     rt_len = oc_ri_get_query_value(req->query, req->query_len, "rt", &rt);
+    if (rt_len < 0) {
+        rt_len = 0;
+    }
+
+#if MYNEWT_VAL(OC_DISC_CACHE_CNT) > 0
+    ent = oc_disc_cache_find(interface, rt, rt_len);
+    if (ent) {
+        oc_rep_reset();
+        if (ent->odc_len &&
+          !os_mbuf_append(req->response->response_buffer->buffer,
+                          ent->odc_data, ent->odc_len)) {
+            req->response->response_buffer->response_length = ent->odc_len;
+            req->response->response_buffer->code =
+              oc_status_code(OC_STATUS_OK);
+        } else {
+            req->response->response_buffer->code = OC_IGNORE;
+        }
+        return;
+    }
+#endif
 
     oc_uuid_to_str(oc_core_get_device_id(0), uuid, sizeof(uuid));
 
@@ -167,6 +275,13 @@ oc_core_discovery_handler(oc_request_t *req, oc_interface_mask_t interface)
         /* There were rt/if selections and there were no matches, so ignore */
         req->response->response_buffer->code = OC_IGNORE;
     }
+#if MYNEWT_VAL(OC_DISC_CACHE_CNT) > 0
+    if (response_length >= 0) {
+        oc_disc_cache_add(interface, rt, rt_len,
+                          req->response->response_buffer->buffer,
+                          matches ? response_length : 0);
+    }
+#endif
 }
 
 void
@@ -178,135 +293,136 @@ oc_create_discovery_resource(void)
 }
 
 #ifdef OC_CLIENT
+#define OC_DISC_HREF_MAX        64
+#define OC_DISC_STR_CNT         8   /* rt/if values read per link */
+
+/*
+ * Reads one link object of a discovery response, and passes it to handler.
+ * Advances link past the object.
+ */
+static oc_discovery_flags_t
+oc_ri_process_discovery_link(CborValue *link, const char *di,
+                             oc_discovery_cb_t *handler,
+                             oc_server_handle_t *handle, uint16_t default_port)
+{
+  char href[OC_DISC_HREF_MAX];
+  char *rt_ptrs[OC_DISC_STR_CNT];
+  char rt_store[OC_DISC_STR_CNT * STRING_ARRAY_ITEM_MAX_LEN];
+  char *if_ptrs[OC_DISC_STR_CNT];
+  char if_store[OC_DISC_STR_CNT * 8];
+  int rt_cnt = 0;
+  int if_cnt = 0;
+  bool secure = false;
+  long long unsigned int dtls_port = 0;
+  oc_string_array_t types = {};
+  oc_interface_mask_t interfaces = 0;
+  oc_discovery_flags_t ret;
+  int i;
+  struct cbor_attr_t policy_attrs[] = {
+    { .attribute = "sec", .type = CborAttrBooleanType,
+      .addr.boolean = &secure },
+    { .attribute = "port", .type = CborAttrUnsignedIntegerType,
+      .addr.uinteger = &dtls_port },
+    { .attribute = NULL }
+  };
+  const struct cbor_attr_t link_attrs[] = {
+    { .attribute = "href", .type = CborAttrTextStringType,
+      .addr.string = href, .len = sizeof(href) },
+    { .attribute = "rt", .type = CborAttrArrayType,
+      .addr.array.element_type = CborAttrTextStringType,
+      .addr.array.arr.strings.ptrs = rt_ptrs,
+      .addr.array.arr.strings.store = rt_store,
+      .addr.array.arr.strings.storelen = sizeof(rt_store),
+      .addr.array.count = &rt_cnt,
+      .addr.array.maxlen = OC_DISC_STR_CNT },
+    { .attribute = "if", .type = CborAttrArrayType,
+      .addr.array.element_type = CborAttrTextStringType,
+      .addr.array.arr.strings.ptrs = if_ptrs,
+      .addr.array.arr.strings.store = if_store,
+      .addr.array.arr.strings.storelen = sizeof(if_store),
+      .addr.array.count = &if_cnt,
+      .addr.array.maxlen = OC_DISC_STR_CNT },
+    { .attribute = "p", .type = CborAttrObjectType,
+      .addr.obj = policy_attrs },
+    { .attribute = NULL }
+  };
+
+  href[0] = '\0';
+  if (cbor_read_object(link, link_attrs)) {
+    return OC_CONTINUE_DISCOVERY;
+  }
+
+  if (rt_cnt > 0) {
+    oc_new_string_array(&types, rt_cnt);
+    for (i = 0; i < rt_cnt; i++) {
+      oc_string_array_add_item(types, rt_ptrs[i]);
+    }
+  }
+  for (i = 0; i < if_cnt; i++) {
+    interfaces |= oc_ri_get_interface_mask(if_ptrs[i], strlen(if_ptrs[i]));
+  }
+
+  if (secure) {
+    handle->endpoint.oe_ip.v6.port = dtls_port;
+    handle->endpoint.oe_ip.flags |= SECURED;
+  } else {
+    handle->endpoint.oe_ip.v6.port = default_port;
+    handle->endpoint.oe_ip.flags &= ~SECURED;
+  }
+
+  ret = handler(di, href, types, interfaces, handle);
+  if (rt_cnt > 0) {
+    oc_free_string_array(&types);
+  }
+  return ret;
+}
+
+/*
+ * Discovery responses are read straight from the mbuf, one link at a time,
+ * instead of being parsed into an oc_rep_t tree first.
+ */
 oc_discovery_flags_t
 oc_ri_process_discovery_payload(struct coap_packet_rx *rsp,
                                 oc_discovery_cb_t *handler,
                                 oc_endpoint_t *endpoint)
 {
-  oc_discovery_flags_t ret = OC_CONTINUE_DISCOVERY;
-  oc_string_t uri = {
-      .os_sz = 0,
-      .os_str = NULL
-  };
-  oc_string_t di = {
-      .os_sz = 0,
-      .os_str = NULL
-  };
-  bool secure = false;
-  uint16_t dtls_port = 0, default_port = endpoint->oe_ip.v6.port;
-  oc_string_array_t types = {};
-  oc_interface_mask_t interfaces = 0;
+  struct oc_rep_cursor cur;
+  CborValue device, val, link;
+  char di[37];
+  uint16_t default_port = endpoint->oe_ip.v6.port;
   oc_server_handle_t handle;
-  uint16_t data_off;
-  struct os_mbuf *m;
-  int len;
+  size_t len;
 
   memcpy(&handle.endpoint, endpoint, sizeof(oc_endpoint_t));
 
-  oc_rep_t *array = 0, *rep;
-
-  len = coap_get_payload(rsp, &m, &data_off);
-  int s = oc_parse_rep(m, data_off, len, &rep);
-  if (s == 0)
-    array = rep;
-  while (array != NULL) {
-    oc_rep_t *device_map = array->value_object;
-    while (device_map != NULL) {
-      switch (device_map->type) {
-      case STRING:
-        if (oc_string_len(device_map->name) == 2 &&
-            strncmp(oc_string(device_map->name), "di", 2) == 0)
-          di = device_map->value_string;
-        break;
-      default:
-        break;
+  if (oc_rep_cursor_init(&cur, rsp) ||
+      !cbor_value_is_array(&cur.orc_value) ||
+      cbor_value_enter_container(&cur.orc_value, &device)) {
+    return OC_CONTINUE_DISCOVERY;
+  }
+  while (cbor_value_is_map(&device)) {
+    di[0] = '\0';
+    if (cbor_value_map_find_value(&device, "di", &val) == CborNoError &&
+        cbor_value_is_text_string(&val)) {
+      len = sizeof(di);
+      if (cbor_value_copy_text_string(&val, di, &len, NULL)) {
+        di[0] = '\0';
       }
-      device_map = device_map->next;
     }
-    device_map = array->value_object;
-    while (device_map != NULL) {
-      switch (device_map->type) {
-      case OBJECT_ARRAY: {
-        oc_rep_t *links = device_map->value_object_array;
-        while (links != NULL) {
-          switch (links->type) {
-          case OBJECT: {
-            oc_rep_t *resource_info = links->value_object;
-            while (resource_info != NULL) {
-              switch (resource_info->type) {
-              case STRING:
-                uri = resource_info->value_string;
-                break;
-              case STRING_ARRAY:
-                if (oc_string_len(resource_info->name) == 2 &&
-                    strncmp(oc_string(resource_info->name), "rt", 2) == 0)
-                  types = resource_info->value_array;
-                else {
-                  interfaces = 0;
-                  int i;
-                  for (i = 0; i < oc_string_array_get_allocated_size(
-                                    resource_info->value_array);
-                       i++) {
-                    interfaces |= oc_ri_get_interface_mask(
-                      oc_string_array_get_item(resource_info->value_array, i),
-                      oc_string_array_get_item_size(resource_info->value_array,
-                                                    i));
-                  }
-                }
-                break;
-              case OBJECT: {
-                oc_rep_t *policy_info = resource_info->value_object;
-                while (policy_info != NULL) {
-                  if (policy_info->type == INT &&
-                      oc_string_len(policy_info->name) == 4 &&
-                      strncmp(oc_string(policy_info->name), "port", 4) == 0) {
-                    dtls_port = policy_info->value_int;
-                  }
-                  if (policy_info->type == BOOL &&
-                      oc_string_len(policy_info->name) == 3 &&
-                      strncmp(oc_string(policy_info->name), "sec", 3) == 0 &&
-                      policy_info->value_boolean == true) {
-                    secure = true;
-                  }
-                  policy_info = policy_info->next;
-                }
-              } break;
-              default:
-                break;
-              }
-              resource_info = resource_info->next;
-            }
-            if (secure) {
-              handle.endpoint.oe_ip.v6.port = dtls_port;
-              handle.endpoint.oe_ip.flags |= SECURED;
-            } else {
-              handle.endpoint.oe_ip.v6.port = default_port;
-              handle.endpoint.oe_ip.flags &= ~SECURED;
-            }
-
-            if (handler(oc_string(di), oc_string(uri), types, interfaces,
-                        &handle) == OC_STOP_DISCOVERY) {
-              ret = OC_STOP_DISCOVERY;
-              goto done;
-            }
-            dtls_port = 0;
-            secure = false;
-          } break;
-          default:
-            break;
-          }
-          links = links->next;
+    if (cbor_value_map_find_value(&device, "links", &val) == CborNoError &&
+        cbor_value_is_array(&val) &&
+        cbor_value_enter_container(&val, &link) == CborNoError) {
+      while (cbor_value_is_map(&link)) {
+        if (oc_ri_process_discovery_link(&link, di, handler, &handle,
+                                         default_port) == OC_STOP_DISCOVERY) {
+          return OC_STOP_DISCOVERY;
         }
-      } break;
-      default:
-        break;
       }
-      device_map = device_map->next;
     }
-    array = array->next;
+    if (cbor_value_advance(&device)) {
+      break;
+    }
   }
-done:
-  oc_free_rep(rep);
-  return ret;
+  return OC_CONTINUE_DISCOVERY;
 }
 #endif /* OC_CLIENT */
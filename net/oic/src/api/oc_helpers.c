@@ -128,3 +128,14 @@ _oc_string_array_add_item(oc_string_array_t *osa, const char str[])
     }
     return false;
 }
+
+uint32_t
+oc_hash(const void *data, int len, uint32_t hash)
+{
+    const uint8_t *p = data;
+
+    while (len--) {
+        hash = (hash ^ *p++) * 16777619UL;
+    }
+    return hash;
+}
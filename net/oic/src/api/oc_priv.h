@@ -21,5 +21,6 @@
 
 void oc_rep_init(void);
 void oc_buffer_init(void);
+void oc_discovery_cache_invalidate(void);
 
 #endif /* __OC_OC_PRIV_H__ */
@@ -22,10 +22,12 @@
 
 #include <tinycbor/cbor_mbuf_writer.h>
 #include <tinycbor/cbor_mbuf_reader.h>
+#include <cborattr/cborattr.h>
 
 #include "oic/port/mynewt/config.h"
 #include "oic/oc_rep.h"
 #include "oic/oc_log.h"
+#include "oic/messaging/coap/coap.h"
 #include "oic/port/mynewt/config.h"
 #include "port/oc_assert.h"
 #include "api/oc_priv.h"
@@ -67,6 +69,36 @@ oc_rep_reset(void)
     memset(&g_encoder, 0, sizeof(g_encoder));
 }
 
+int
+oc_rep_cursor_init(struct oc_rep_cursor *cur, struct coap_packet_rx *pkt)
+{
+    struct os_mbuf *m;
+    uint16_t off;
+    int len;
+
+    len = coap_get_payload(pkt, &m, &off);
+    if (len <= 0) {
+        return -1;
+    }
+    cbor_mbuf_reader_init(&cur->orc_reader, m, off);
+    if (cbor_parser_init(&cur->orc_reader.r, 0, &cur->orc_parser,
+                         &cur->orc_value) != CborNoError) {
+        return -1;
+    }
+    return 0;
+}
+
+int
+oc_rep_read_attrs(struct coap_packet_rx *pkt, const struct cbor_attr_t *attrs)
+{
+    struct oc_rep_cursor cur;
+
+    if (oc_rep_cursor_init(&cur, pkt)) {
+        return -1;
+    }
+    return cbor_read_object(&cur.orc_value, attrs);
+}
+
 #ifdef OC_CLIENT
 static oc_rep_t *
 _alloc_rep(void)
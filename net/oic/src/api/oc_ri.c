@@ -38,6 +38,7 @@
 #include "oic/oc_core_res.h"
 #include "oic/oc_discovery.h"
 #include "oic/oc_ri.h"
+#include "oic/oc_helpers.h"
 #include "oic/oc_uuid.h"
 #include "api/oc_priv.h"
 
@@ -48,6 +49,23 @@
 
 #ifdef OC_SERVER
 static SLIST_HEAD(, oc_resource) oc_app_resources;
+
+/*
+ * Application resources hashed by uri, for request dispatch. Key is the
+ * uri without its leading '/', as that is what arrives in Uri-Path.
+ */
+SLIST_HEAD(oc_resource_list, oc_resource);
+static struct oc_resource_list
+    oc_app_resources_uri[MYNEWT_VAL(OC_LOOKUP_BUCKETS)];
+
+#define OC_RESOURCE_URI_LIST(path, path_len)                            \
+    (&oc_app_resources_uri[oc_hash((path), (path_len), OC_HASH_INIT) %  \
+                           MYNEWT_VAL(OC_LOOKUP_BUCKETS)])
+#define OC_RESOURCE_LIST(res)                                           \
+    (oc_string_len((res)->uri) ?                                        \
+     OC_RESOURCE_URI_LIST(oc_string((res)->uri) + 1,                    \
+                          oc_string_len((res)->uri) - 1) :              \
+     OC_RESOURCE_URI_LIST("", 0))
 static struct os_mempool oc_resource_pool;
 static uint8_t oc_resource_area[OS_MEMPOOL_BYTES(MAX_APP_RESOURCES,
       sizeof(oc_resource_t))];
@@ -57,7 +75,26 @@ static void periodic_observe_handler(struct os_event *ev);
 
 #ifdef OC_CLIENT
 #include "oc_client_state.h"
-static SLIST_HEAD(, oc_client_cb) oc_client_cbs;
+
+/*
+ * Outstanding client callbacks, indexed by token, URI and MID.
+ */
+SLIST_HEAD(oc_client_cb_list, oc_client_cb);
+static struct oc_client_cb_list oc_client_cbs_tok[MYNEWT_VAL(OC_LOOKUP_BUCKETS)];
+static struct oc_client_cb_list oc_client_cbs_uri[MYNEWT_VAL(OC_LOOKUP_BUCKETS)];
+static struct oc_client_cb_list oc_client_cbs_mid[MYNEWT_VAL(OC_LOOKUP_BUCKETS)];
+
+#define OC_CLIENT_CB_LIST(idx, hash)                                    \
+    (&(idx)[(hash) % MYNEWT_VAL(OC_LOOKUP_BUCKETS)])
+#define OC_CLIENT_CB_TOK_LIST(token, token_len)                         \
+    OC_CLIENT_CB_LIST(oc_client_cbs_tok,                                \
+                      oc_hash((token), (token_len), OC_HASH_INIT))
+#define OC_CLIENT_CB_URI_LIST(uri, uri_len)                             \
+    OC_CLIENT_CB_LIST(oc_client_cbs_uri,                                \
+                      oc_hash((uri), (uri_len), OC_HASH_INIT))
+#define OC_CLIENT_CB_MID_LIST(mid)                                      \
+    OC_CLIENT_CB_LIST(oc_client_cbs_mid, (mid))
+
 static struct os_mempool oc_client_cb_pool;
 static uint8_t oc_client_cb_area[OS_MEMPOOL_BYTES(MAX_NUM_CONCURRENT_REQUESTS,
       sizeof(oc_client_cb_t))];
@@ -193,19 +230,40 @@ stop_processes(void)
 }
 
 #ifdef OC_SERVER
-oc_resource_t *
-oc_ri_get_app_resource_by_uri(const char *uri)
+/*
+ * Find application resource by uri, without the leading '/'.
+ */
+static oc_resource_t *
+oc_ri_find_app_resource(const char *path, int path_len)
 {
     oc_resource_t *res;
 
-    SLIST_FOREACH(res, &oc_app_resources, next) {
-        if (oc_string_len(res->uri) == strlen(uri) &&
-          strncmp(uri, oc_string(res->uri), strlen(uri)) == 0)
+    SLIST_FOREACH(res, OC_RESOURCE_URI_LIST(path, path_len), uri_next) {
+        if (oc_string_len(res->uri) == path_len + 1 &&
+          strncmp(oc_string(res->uri) + 1, path, path_len) == 0) {
             return res;
+        }
     }
 
     return NULL;
 }
+
+oc_resource_t *
+oc_ri_get_app_resource_by_uri(const char *uri)
+{
+    oc_resource_t *res;
+    int uri_len;
+
+    uri_len = strlen(uri);
+    if (!uri_len) {
+        return NULL;
+    }
+    res = oc_ri_find_app_resource(uri + 1, uri_len - 1);
+    if (res && oc_string(res->uri)[0] != uri[0]) {
+        return NULL;
+    }
+    return res;
+}
 #endif
 
 void
@@ -220,7 +278,6 @@ oc_ri_init(void)
 #endif
 
 #ifdef OC_CLIENT
-  SLIST_INIT(&oc_client_cbs);
   os_mempool_init(&oc_client_cb_pool, MAX_NUM_CONCURRENT_REQUESTS,
     sizeof(oc_client_cb_t), oc_client_cb_area, "oc_cl_cbs");
   oc_rep_init();
@@ -260,10 +317,12 @@ oc_ri_delete_resource(oc_resource_t *resource)
     SLIST_FOREACH(tmp, &oc_app_resources, next) {
         if (tmp == resource) {
             SLIST_REMOVE(&oc_app_resources, tmp, oc_resource, next);
+            SLIST_REMOVE(OC_RESOURCE_LIST(tmp), tmp, oc_resource, uri_next);
             break;
         }
     }
     os_memblock_put(&oc_resource_pool, resource);
+    oc_discovery_cache_invalidate();
 }
 
 bool
@@ -281,6 +340,8 @@ oc_ri_add_resource(oc_resource_t *resource)
     }
     if (valid) {
         SLIST_INSERT_HEAD(&oc_app_resources, resource, next);
+        SLIST_INSERT_HEAD(OC_RESOURCE_LIST(resource), resource, uri_next);
+        oc_discovery_cache_invalidate();
     }
 
     return valid;
@@ -446,14 +507,8 @@ oc_ri_invoke_coap_entity_handler(struct coap_packet_rx *request,
   /* Check against list of declared application resources.
    */
   if (!cur_resource && !bad_request) {
-      SLIST_FOREACH(resource, &oc_app_resources, next) {
-          if (oc_string_len(resource->uri) == (uri_path_len + 1) &&
-            strncmp((const char *)oc_string(resource->uri) + 1, uri_path,
-              uri_path_len) == 0) {
-              request_obj.resource = cur_resource = resource;
-              break;
-          }
-      }
+      cur_resource = oc_ri_find_app_resource(uri_path, uri_path_len);
+      request_obj.resource = cur_resource;
   }
 #endif
 
@@ -665,8 +720,13 @@ static void
 free_client_cb(oc_client_cb_t *cb)
 {
     os_callout_stop(&cb->callout);
+    SLIST_REMOVE(OC_CLIENT_CB_TOK_LIST(cb->token, cb->token_len), cb,
+                 oc_client_cb, next);
+    SLIST_REMOVE(OC_CLIENT_CB_URI_LIST(oc_string(cb->uri),
+                                       oc_string_len(cb->uri)), cb,
+                 oc_client_cb, uri_next);
+    SLIST_REMOVE(OC_CLIENT_CB_MID_LIST(cb->mid), cb, oc_client_cb, mid_next);
     oc_free_string(&cb->uri);
-    SLIST_REMOVE(&oc_client_cbs, cb, oc_client_cb, next);
     os_memblock_put(&oc_client_cb_pool, cb);
 }
 
@@ -675,7 +735,7 @@ oc_ri_remove_client_cb_by_mid(uint16_t mid)
 {
     oc_client_cb_t *cb;
 
-    SLIST_FOREACH(cb, &oc_client_cbs, next) {
+    SLIST_FOREACH(cb, OC_CLIENT_CB_MID_LIST(mid), mid_next) {
         if (cb->mid == mid) {
             break;
         }
@@ -727,7 +787,7 @@ oc_ri_invoke_client_cb(struct coap_packet_rx *rsp, oc_endpoint_t *endpoint)
     */
     coap_get_header_content_format(rsp, &content_format);
 
-    cb = SLIST_FIRST(&oc_client_cbs);
+    cb = SLIST_FIRST(OC_CLIENT_CB_TOK_LIST(rsp->token, rsp->token_len));
     while (cb != NULL) {
         tmp = SLIST_NEXT(cb, next);
         if (cb->token_len != rsp->token_len ||
@@ -808,10 +868,12 @@ oc_ri_get_client_cb(const char *uri, oc_server_handle_t *server,
                     oc_method_t method)
 {
     oc_client_cb_t *cb;
+    int uri_len;
 
-    SLIST_FOREACH(cb, &oc_client_cbs, next) {
-        if (oc_string_len(cb->uri) == strlen(uri) &&
-          strncmp(oc_string(cb->uri), uri, strlen(uri)) == 0 &&
+    uri_len = strlen(uri);
+    SLIST_FOREACH(cb, OC_CLIENT_CB_URI_LIST(uri, uri_len), uri_next) {
+        if (oc_string_len(cb->uri) == uri_len &&
+          strncmp(oc_string(cb->uri), uri, uri_len) == 0 &&
           memcmp(&cb->server.endpoint, &server->endpoint,
                  oc_endpoint_size(&cb->server.endpoint)) == 0 &&
           cb->method == method) {
@@ -862,7 +924,12 @@ oc_ri_alloc_client_cb(const char *uri, oc_server_handle_t *server,
 
     os_callout_init(&cb->callout, oc_evq_get(), oc_ri_remove_cb, cb);
 
-    SLIST_INSERT_HEAD(&oc_client_cbs, cb, next);
+    SLIST_INSERT_HEAD(OC_CLIENT_CB_TOK_LIST(cb->token, cb->token_len), cb,
+                      next);
+    SLIST_INSERT_HEAD(OC_CLIENT_CB_URI_LIST(oc_string(cb->uri),
+                                            oc_string_len(cb->uri)), cb,
+                      uri_next);
+    SLIST_INSERT_HEAD(OC_CLIENT_CB_MID_LIST(cb->mid), cb, mid_next);
     return cb;
 }
 #endif /* OC_CLIENT */
@@ -55,6 +55,10 @@ STATS_NAME_START(coap_stats)
     STATS_NAME(coap_stats, imem)
     STATS_NAME(coap_stats, oframe)
     STATS_NAME(coap_stats, oerr)
+    STATS_NAME(coap_stats, retrans)
+    STATS_NAME(coap_stats, timeout)
+    STATS_NAME(coap_stats, rtt_samples)
+    STATS_NAME(coap_stats, rtt_ms)
 STATS_NAME_END(coap_stats)
 
 /*---------------------------------------------------------------------------*/
@@ -41,12 +41,191 @@
 /* OIC Stack headers */
 #include "api/oc_buffer.h"
 #include "oic/oc_ri.h"
+#include "oic/oc_helpers.h"
 #include "messaging/coap/engine.h"
 
 #ifdef OC_CLIENT
 #include "oic/oc_client_state.h"
 #endif
 
+#if MYNEWT_VAL(OC_BLOCK1_SESSIONS) > 0
+/*
+ * Reassembly state for Block1 requests. Payload of the blocks is collected
+ * here, and the resource handler gets invoked only after the last block.
+ */
+struct coap_block1_state {
+    oc_endpoint_t cbs_ep;
+    uint32_t cbs_uri_hash;
+    struct os_mbuf *cbs_m;      /* payload so far, NULL if slot is free */
+    os_time_t cbs_time;         /* when the latest block came in */
+};
+
+static struct coap_block1_state
+    coap_block1_states[MYNEWT_VAL(OC_BLOCK1_SESSIONS)];
+
+static uint32_t
+coap_block1_uri_hash(struct coap_packet_rx *pkt)
+{
+    uint8_t buf[16];
+    uint32_t hash;
+    int off;
+    int len;
+
+    hash = OC_HASH_INIT;
+    for (off = 0; off < pkt->uri_path_len; off += len) {
+        len = MIN(sizeof(buf), pkt->uri_path_len - off);
+        os_mbuf_copydata(pkt->m, pkt->uri_path_off + off, len, buf);
+        hash = oc_hash(buf, len, hash);
+    }
+    return hash;
+}
+
+static void
+coap_block1_free(struct coap_block1_state *cbs)
+{
+    os_mbuf_free_chain(cbs->cbs_m);
+    cbs->cbs_m = NULL;
+}
+
+/*
+ * Returns reassembly state for a request. If this is the 1st block, state
+ * is (re)started, taking over free or the least recently used slot.
+ */
+static struct coap_block1_state *
+coap_block1_get(oc_endpoint_t *ep, uint32_t hash, int first)
+{
+    struct coap_block1_state *cbs;
+    struct coap_block1_state *lru;
+    int i;
+
+    lru = NULL;
+    for (i = 0; i < MYNEWT_VAL(OC_BLOCK1_SESSIONS); i++) {
+        cbs = &coap_block1_states[i];
+        if (!cbs->cbs_m) {
+            if (!lru || lru->cbs_m) {
+                lru = cbs;
+            }
+            continue;
+        }
+        if (cbs->cbs_uri_hash == hash &&
+          !memcmp(&cbs->cbs_ep, ep, oc_endpoint_size(ep))) {
+            if (!first) {
+                return cbs;
+            }
+            lru = cbs;
+            break;
+        }
+        if (!lru ||
+          (lru->cbs_m && OS_TIME_TICK_LT(cbs->cbs_time, lru->cbs_time))) {
+            lru = cbs;
+        }
+    }
+    if (!first) {
+        return NULL;
+    }
+    if (lru->cbs_m) {
+        coap_block1_free(lru);
+    }
+    lru->cbs_m = os_msys_get_pkthdr(0, 0);
+    if (!lru->cbs_m) {
+        return NULL;
+    }
+    memcpy(&lru->cbs_ep, ep, oc_endpoint_size(ep));
+    lru->cbs_uri_hash = hash;
+    return lru;
+}
+
+/*
+ * Processes a request with Block1 option. Returns 0 when the complete
+ * payload is now in the request, and resource handler should be called.
+ * Otherwise response has been filled in.
+ */
+static int
+coap_block1_rx(struct coap_packet_rx *req, coap_packet_t *rsp,
+               oc_endpoint_t *ep)
+{
+    struct coap_block1_state *cbs;
+    struct os_mbuf *m;
+    uint32_t num;
+    uint8_t more;
+    uint16_t size;
+    uint32_t offset;
+    uint16_t hdr_len;
+    uint16_t len;
+
+    coap_get_header_block1(req, &num, &more, &size, &offset);
+    OC_LOG_DEBUG(" Blockwise: block1 %u%s (%u) @ %u bytes\n",
+                 (unsigned int)num, more ? "+" : "", size,
+                 (unsigned int)offset);
+
+    /*
+     * Use smaller blocks than peer if needed; peer continues from
+     * where we tell it to.
+     */
+    len = req->payload_len;
+    if (size > COAP_MAX_BLOCK_SIZE) {
+        size = COAP_MAX_BLOCK_SIZE;
+        num = offset / size;
+        offset = num * size;
+    }
+    if (len > size) {
+        len = size;
+        more = 1;
+    }
+
+    cbs = coap_block1_get(ep, coap_block1_uri_hash(req), offset == 0);
+    if (!cbs) {
+        if (offset == 0) {
+            rsp->code = SERVICE_UNAVAILABLE_5_03;
+        } else {
+            rsp->code = REQUEST_ENTITY_INCOMPLETE_4_08;
+        }
+        return -1;
+    }
+    if (offset != OS_MBUF_PKTLEN(cbs->cbs_m)) {
+        rsp->code = REQUEST_ENTITY_INCOMPLETE_4_08;
+        goto err;
+    }
+    if (offset + len > MYNEWT_VAL(OC_BLOCK1_MAX_SIZE)) {
+        rsp->code = REQUEST_ENTITY_TOO_LARGE_4_13;
+        goto err;
+    }
+    if (len && os_mbuf_appendfrom(cbs->cbs_m, req->m, req->payload_off, len)) {
+        rsp->code = SERVICE_UNAVAILABLE_5_03;
+        goto err;
+    }
+    cbs->cbs_time = os_time_get();
+
+    if (more) {
+        rsp->code = CONTINUE_2_31;
+        coap_set_header_block1(rsp, num, 1, size);
+        return 1;
+    }
+
+    /*
+     * Last block. Replace the payload of this request with the reassembled
+     * one.
+     */
+    m = req->m;
+    if (req->payload_len) {
+        hdr_len = req->payload_off;
+    } else {
+        hdr_len = OS_MBUF_PKTLEN(m);
+    }
+    os_mbuf_adj(m, hdr_len - OS_MBUF_PKTLEN(m));
+    req->payload_off = hdr_len;
+    req->payload_len = OS_MBUF_PKTLEN(cbs->cbs_m);
+    os_mbuf_concat(m, cbs->cbs_m);
+    cbs->cbs_m = NULL;
+
+    coap_set_header_block1(rsp, num, 0, size);
+    return 0;
+err:
+    coap_block1_free(cbs);
+    return -1;
+}
+#endif
+
 /*---------------------------------------------------------------------------*/
 /*- Internal API ------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
@@ -146,10 +325,21 @@ coap_receive(struct os_mbuf **mp)
             OC_LOG_DEBUG(" Blockwise: block request %u (%u/%u) @ %u bytes\n",
                          (unsigned int) block_num, block_size,
                          COAP_MAX_BLOCK_SIZE, (unsigned int) block_offset);
-            block_size = MIN(block_size, COAP_MAX_BLOCK_SIZE);
+            if (block_size > COAP_MAX_BLOCK_SIZE) {
+                block_size = COAP_MAX_BLOCK_SIZE;
+                block_num = block_offset / block_size;
+                block_offset = block_num * block_size;
+            }
             new_offset = block_offset;
         }
 
+#if MYNEWT_VAL(OC_BLOCK1_SESSIONS) > 0
+        if (IS_OPTION(message, COAP_OPTION_BLOCK1) &&
+          coap_block1_rx(message, response, &endpoint)) {
+            /* waiting for more blocks, or block was rejected */
+            OC_LOG_DEBUG(" Blockwise: block1 rsp %u\n", response->code);
+        } else
+#endif
         if (oc_ri_invoke_coap_entity_handler(message, response, &new_offset,
                                              OC_MBUF_ENDPOINT(m))) {
             if (erbium_status_code == NO_ERROR) {
@@ -179,6 +369,11 @@ coap_receive(struct os_mbuf **mp)
                                      response->payload_len, block_size);
                         if (block_offset >= response->payload_len) {
                             response->code = BAD_OPTION_4_02;
+                            if (response->payload_m) {
+                                os_mbuf_free_chain(response->payload_m);
+                                response->payload_m = NULL;
+                                response->payload_len = 0;
+                            }
                             rsp = os_msys_get_pkthdr(0, 0);
                             if (rsp) {
                                 os_mbuf_copyinto(rsp, 0, "BlockOutOfScope", 15);
@@ -188,11 +383,16 @@ coap_receive(struct os_mbuf **mp)
                             /* a const char str[] and sizeof(str)
                                produces larger code size */
                         } else {
+                            /*
+                             * Representation is regenerated for every
+                             * block; send only the requested slice.
+                             */
+                            os_mbuf_adj(response->payload_m, block_offset);
+                            response->payload_len -= block_offset;
                             coap_set_header_block2(response, block_num,
-                                         response->payload_len - block_offset >
-                                           block_size, block_size);
-                            response->payload_len = MIN(response->payload_len -
-                                                        block_offset,
+                                         response->payload_len > block_size,
+                                         block_size);
+                            response->payload_len = MIN(response->payload_len,
                                                         block_size);
                         } /* if(valid offset) */
 
@@ -219,6 +419,14 @@ coap_receive(struct os_mbuf **mp)
                                            COAP_MAX_BLOCK_SIZE);
                     response->payload_len = MIN(response->payload_len,
                                                 COAP_MAX_BLOCK_SIZE);
+
+                    /* Response does not fit, start Block2 transfer */
+                } else if (response->payload_len > MAX_PAYLOAD_SIZE) {
+                    OC_LOG_DEBUG(" block: rsp %u bytes, using block sz %u\n",
+                                 response->payload_len, COAP_MAX_BLOCK_SIZE);
+
+                    coap_set_header_block2(response, 0, 1, COAP_MAX_BLOCK_SIZE);
+                    response->payload_len = COAP_MAX_BLOCK_SIZE;
                 } /* blockwise transfer handling */
             }   /* no errors/hooks */
             /* successful service callback */
@@ -245,6 +453,9 @@ coap_receive(struct os_mbuf **mp)
 
         /* Open transaction now cleared for ACK since mid matches */
         if ((transaction = coap_get_transaction_by_mid(message->mid))) {
+            if (message->type == COAP_TYPE_ACK) {
+                coap_transaction_rtt_sample(transaction);
+            }
             coap_clear_transaction(transaction);
         }
         /* if(ACKed transaction) */
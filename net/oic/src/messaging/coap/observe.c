@@ -36,7 +36,9 @@
 
 #include <syscfg/syscfg.h>
 
+#include <os/os.h>
 #include <os/os_mempool.h>
+#include <os/os_mbuf.h>
 #include <os/queue.h>
 
 #include "oic/port/mynewt/config.h"
@@ -47,12 +49,32 @@
 #include "oic/messaging/coap/oc_coap.h"
 #include "oic/oc_rep.h"
 #include "oic/oc_ri.h"
+#include "oic/oc_helpers.h"
 
 /*-------------------*/
 uint64_t observe_counter = 3;
 /*---------------------------------------------------------------------------*/
 static SLIST_HEAD(, coap_observer) oc_observers;
 
+/*
+ * Indices for finding observers from incoming requests/RSTs.
+ */
+SLIST_HEAD(coap_observer_list, coap_observer);
+static struct coap_observer_list oc_observers_tok[MYNEWT_VAL(OC_LOOKUP_BUCKETS)];
+static struct coap_observer_list oc_observers_uri[MYNEWT_VAL(OC_LOOKUP_BUCKETS)];
+static struct coap_observer_list oc_observers_mid[MYNEWT_VAL(OC_LOOKUP_BUCKETS)];
+
+#define COAP_OBSERVER_LIST(idx, hash)                                   \
+    (&(idx)[(hash) % MYNEWT_VAL(OC_LOOKUP_BUCKETS)])
+#define COAP_OBSERVER_TOK_LIST(token, token_len)                        \
+    COAP_OBSERVER_LIST(oc_observers_tok,                                \
+                       oc_hash((token), (token_len), OC_HASH_INIT))
+#define COAP_OBSERVER_URI_LIST(url)                                     \
+    COAP_OBSERVER_LIST(oc_observers_uri,                                \
+                       oc_hash((url), strlen(url), OC_HASH_INIT))
+#define COAP_OBSERVER_MID_LIST(mid)                                     \
+    COAP_OBSERVER_LIST(oc_observers_mid, (mid))
+
 static struct os_mempool coap_observer_pool;
 static uint8_t coap_observer_area[OS_MEMPOOL_BYTES(COAP_MAX_OBSERVERS,
       sizeof(coap_observer_t))];
@@ -65,18 +87,22 @@ add_observer(oc_resource_t *resource, oc_endpoint_t *endpoint,
              const uint8_t *token, size_t token_len, const char *uri,
              int uri_len)
 {
+    char url[COAP_OBSERVER_URL_LEN];
+    int dup;
+
+    if (uri_len > sizeof(url) - 1) {
+        uri_len = sizeof(url) - 1;
+    }
+    memcpy(url, uri, uri_len);
+    url[uri_len] = 0;
+
     /* Remove existing observe relationship, if any. */
-    int dup = coap_remove_observer_by_uri(endpoint, uri);
+    dup = coap_remove_observer_by_uri(endpoint, url);
 
     coap_observer_t *o = os_memblock_get(&coap_observer_pool);
 
     if (o) {
-        int max = sizeof(o->url) - 1;
-        if (max > uri_len) {
-            max = uri_len;
-        }
-        memcpy(o->url, uri, max);
-        o->url[max] = 0;
+        strcpy(o->url, url);
         memcpy(&o->endpoint, endpoint, sizeof(oc_endpoint_t));
         o->token_len = token_len;
         memcpy(o->token, token, token_len);
@@ -88,10 +114,23 @@ add_observer(oc_resource_t *resource, oc_endpoint_t *endpoint,
           coap_observer_pool.mp_num_blocks - coap_observer_pool.mp_num_free,
           coap_observer_pool.mp_num_blocks, o->url, o->token[0], o->token[1]);
         SLIST_INSERT_HEAD(&oc_observers, o, next);
+        SLIST_INSERT_HEAD(COAP_OBSERVER_TOK_LIST(o->token, o->token_len), o,
+                          tok_next);
+        SLIST_INSERT_HEAD(COAP_OBSERVER_URI_LIST(o->url), o, uri_next);
+        SLIST_INSERT_HEAD(COAP_OBSERVER_MID_LIST(o->last_mid), o, mid_next);
         return dup;
     }
     return -1;
 }
+
+static void
+coap_observer_set_mid(coap_observer_t *o, uint16_t mid)
+{
+    SLIST_REMOVE(COAP_OBSERVER_MID_LIST(o->last_mid), o, coap_observer,
+                 mid_next);
+    o->last_mid = mid;
+    SLIST_INSERT_HEAD(COAP_OBSERVER_MID_LIST(o->last_mid), o, mid_next);
+}
 /*---------------------------------------------------------------------------*/
 /*- Removal -----------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
@@ -101,6 +140,11 @@ coap_remove_observer(coap_observer_t *o)
     OC_LOG_DEBUG("Removing observer for /%s [0x%02X%02X]\n",
                  o->url, o->token[0], o->token[1]);
     SLIST_REMOVE(&oc_observers, o, coap_observer, next);
+    SLIST_REMOVE(COAP_OBSERVER_TOK_LIST(o->token, o->token_len), o,
+                 coap_observer, tok_next);
+    SLIST_REMOVE(COAP_OBSERVER_URI_LIST(o->url), o, coap_observer, uri_next);
+    SLIST_REMOVE(COAP_OBSERVER_MID_LIST(o->last_mid), o, coap_observer,
+                 mid_next);
     os_memblock_put(&coap_observer_pool, o);
 }
 /*---------------------------------------------------------------------------*/
@@ -127,37 +171,35 @@ int
 coap_remove_observer_by_token(oc_endpoint_t *endpoint, uint8_t *token,
                               size_t token_len)
 {
-    int removed = 0;
-    coap_observer_t *obs, *next;
+    coap_observer_t *obs;
 
-    obs = SLIST_FIRST(&oc_observers);
-    while (obs) {
-        next = SLIST_NEXT(obs, next);
+    SLIST_FOREACH(obs, COAP_OBSERVER_TOK_LIST(token, token_len), tok_next) {
         if (memcmp(&obs->endpoint, endpoint, oc_endpoint_size(endpoint)) == 0 &&
           obs->token_len == token_len &&
           memcmp(obs->token, token, token_len) == 0) {
             obs->resource->num_observers--;
             coap_remove_observer(obs);
-            removed++;
-            break;
+            return 1;
         }
-        obs = next;
     }
-    return removed;
+    return 0;
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * uri must be truncated to fit in coap_observer->url.
+ */
 int
 coap_remove_observer_by_uri(oc_endpoint_t *endpoint, const char *uri)
 {
     int removed = 0;
     coap_observer_t *obs, *next;
 
-    obs = SLIST_FIRST(&oc_observers);
+    obs = SLIST_FIRST(COAP_OBSERVER_URI_LIST(uri));
     while (obs) {
-        next = SLIST_NEXT(obs, next);
+        next = SLIST_NEXT(obs, uri_next);
         if (((memcmp(&obs->endpoint, endpoint,
                      oc_endpoint_size(endpoint)) == 0)) &&
-          (obs->url == uri || memcmp(obs->url, uri, strlen(obs->url)) == 0)) {
+          (obs->url == uri || strcmp(obs->url, uri) == 0)) {
             obs->resource->num_observers--;
             coap_remove_observer(obs);
             removed++;
@@ -170,26 +212,70 @@ coap_remove_observer_by_uri(oc_endpoint_t *endpoint, const char *uri)
 int
 coap_remove_observer_by_mid(oc_endpoint_t *endpoint, uint16_t mid)
 {
-    int removed = 0;
-    coap_observer_t *obs, *next;
+    coap_observer_t *obs;
 
-    obs = SLIST_FIRST(&oc_observers);
-    while (obs) {
-        next = SLIST_NEXT(obs, next);
+    SLIST_FOREACH(obs, COAP_OBSERVER_MID_LIST(mid), mid_next) {
         if (memcmp(&obs->endpoint, endpoint, oc_endpoint_size(endpoint)) == 0 &&
           obs->last_mid == mid) {
             obs->resource->num_observers--;
             coap_remove_observer(obs);
-            removed++;
-            break;
+            return 1;
         }
-        obs = next;
     }
-    return removed;
+    return 0;
 }
 /*---------------------------------------------------------------------------*/
 /*- Notification ------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
+/*
+ * Representation is encoded once per notification, and the payload mbuf
+ * is shared with all observers via mbufs referencing its data. Number of
+ * references is kept in the user header of the payload mbuf.
+ */
+#define COAP_NOTIFY_REFCNT(m)   (*(uint16_t *)OS_MBUF_USRHDR(m))
+
+static void
+coap_notify_payload_free(const void *buf, void *arg)
+{
+    struct os_mbuf *m = arg;
+    int refcnt;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    refcnt = --COAP_NOTIFY_REFCNT(m);
+    OS_EXIT_CRITICAL(sr);
+    if (!refcnt) {
+        os_mbuf_free_chain(m);
+    }
+}
+
+static struct os_mbuf *
+coap_notify_payload_ref(struct os_mbuf *m)
+{
+    struct os_mbuf *ref;
+    struct os_mbuf *om;
+    os_sr_t sr;
+
+    ref = os_msys_get_pkthdr(0, 0);
+    if (!ref) {
+        return NULL;
+    }
+    for (om = m; om; om = SLIST_NEXT(om, om_next)) {
+        if (!om->om_len) {
+            continue;
+        }
+        if (os_mbuf_append_ext(ref, om->om_data, om->om_len,
+                               coap_notify_payload_free, m)) {
+            os_mbuf_free_chain(ref);
+            return NULL;
+        }
+        OS_ENTER_CRITICAL(sr);
+        COAP_NOTIFY_REFCNT(m)++;
+        OS_EXIT_CRITICAL(sr);
+    }
+    return ref;
+}
+
 int
 coap_notify_observers(oc_resource_t *resource,
                       oc_response_buffer_t *response_buf,
@@ -212,11 +298,12 @@ coap_notify_observers(oc_resource_t *resource,
     if (!response_buf && resource) {
         OC_LOG_DEBUG("coap_notify_observers: Issue GET request to resource\n");
         /* performing GET on the resource */
-        m = os_msys_get_pkthdr(0, 0);
+        m = os_msys_get_pkthdr(0, sizeof(uint16_t));
         if (!m) {
             /* XXX count */
             return num_observers;
         }
+        COAP_NOTIFY_REFCNT(m) = 1;
         response_buffer.buffer = m;
         response_buffer.block_offset = NULL;
         response.response_buffer = &response_buffer;
@@ -271,7 +358,7 @@ coap_notify_observers(oc_resource_t *resource,
                   coap_get_mid(), &obs->endpoint))) {
 
                 /* update last MID for RST matching */
-                obs->last_mid = transaction->mid;
+                coap_observer_set_mid(obs, transaction->mid);
 
                 /* prepare response */
                 /* build notification */
@@ -286,8 +373,15 @@ coap_notify_observers(oc_resource_t *resource,
                                  "notification to check for client liveness\n");
                     notification->type = COAP_TYPE_CON;
                 }
-                coap_set_payload(notification, response_buf->buffer,
-                                 OS_MBUF_PKTLEN(response_buf->buffer));
+                if (m) {
+                    notification->payload_m = coap_notify_payload_ref(m);
+                }
+                if (notification->payload_m) {
+                    notification->payload_len = OS_MBUF_PKTLEN(m);
+                } else {
+                    coap_set_payload(notification, response_buf->buffer,
+                                     OS_MBUF_PKTLEN(response_buf->buffer));
+                }
                 coap_set_status_code(notification, response_buf->code);
                 if (notification->code < BAD_REQUEST_4_00 &&
                   obs->resource->num_observers) {
@@ -310,7 +404,7 @@ coap_notify_observers(oc_resource_t *resource,
 #endif
     }
     if (m) {
-        os_mbuf_free_chain(m);
+        coap_notify_payload_free(NULL, m);
     }
     return num_observers;
 }
@@ -56,10 +56,110 @@
 static struct os_mempool oc_transaction_memb;
 static uint8_t oc_transaction_area[OS_MEMPOOL_BYTES(COAP_MAX_OPEN_TRANSACTIONS,
       sizeof(coap_transaction_t))];
-static SLIST_HEAD(, coap_transaction) oc_transaction_list;
+
+/*
+ * Open transactions, hashed by MID.
+ */
+static SLIST_HEAD(, coap_transaction)
+    oc_transaction_list[MYNEWT_VAL(OC_LOOKUP_BUCKETS)];
+#define COAP_TRANSACTION_LIST(mid)                                      \
+    (&oc_transaction_list[(mid) % MYNEWT_VAL(OC_LOOKUP_BUCKETS)])
 
 static void coap_transaction_retrans(struct os_event *ev);
 
+#if MYNEWT_VAL(OC_COAP_RTT_ENDPOINTS) > 0
+/*
+ * Per-peer retransmission timeout, estimated from ACK round trip times
+ * (CoCoA, draft-ietf-core-cocoa).  Only samples from transactions which
+ * were not retransmitted are used.  SRTT and RTTVAR are kept as in TCP
+ * (RFC 6298), scaled by 8 and 4 respectively.  The RTO used is the
+ * average of the previous RTO and the one derived from the new sample.
+ */
+#define COAP_RTO_MAX_TICKS  (OS_TICKS_PER_SEC * 32)
+
+struct coap_rtt {
+    oc_endpoint_t cr_ep;
+    int32_t cr_srtt;
+    int32_t cr_rttvar;
+    uint32_t cr_rto;            /* 0 if entry is unused */
+    os_time_t cr_used;
+};
+
+static struct coap_rtt coap_rtt[MYNEWT_VAL(OC_COAP_RTT_ENDPOINTS)];
+
+static struct coap_rtt *
+coap_rtt_find(oc_endpoint_t *ep, int alloc)
+{
+    struct coap_rtt *cr;
+    struct coap_rtt *lru;
+    int i;
+
+    lru = NULL;
+    for (i = 0; i < MYNEWT_VAL(OC_COAP_RTT_ENDPOINTS); i++) {
+        cr = &coap_rtt[i];
+        if (cr->cr_rto &&
+          !memcmp(&cr->cr_ep, ep, oc_endpoint_size(ep))) {
+            return cr;
+        }
+        if (!lru || !cr->cr_rto ||
+          (lru->cr_rto && OS_TIME_TICK_LT(cr->cr_used, lru->cr_used))) {
+            lru = cr;
+        }
+    }
+    if (!alloc) {
+        return NULL;
+    }
+    memset(lru, 0, sizeof(*lru));
+    memcpy(&lru->cr_ep, ep, oc_endpoint_size(ep));
+    lru->cr_rto = COAP_RESPONSE_TIMEOUT_TICKS;
+    return lru;
+}
+
+static void
+coap_rtt_update(oc_endpoint_t *ep, int32_t rtt)
+{
+    struct coap_rtt *cr;
+    uint32_t min_rto;
+    uint32_t rto;
+    int32_t delta;
+
+    cr = coap_rtt_find(ep, 1);
+    cr->cr_used = os_time_get();
+    if (cr->cr_srtt == 0) {
+        cr->cr_srtt = rtt << 3;
+        cr->cr_rttvar = rtt << 1;
+    } else {
+        delta = rtt - (cr->cr_srtt >> 3);
+        cr->cr_srtt += delta;
+        if (delta < 0) {
+            delta = -delta;
+        }
+        cr->cr_rttvar += delta - (cr->cr_rttvar >> 2);
+    }
+    rto = (cr->cr_rto + (cr->cr_srtt >> 3) + cr->cr_rttvar) / 2;
+
+    min_rto = MYNEWT_VAL(OC_COAP_RTO_MIN_MS) * OS_TICKS_PER_SEC / 1000;
+    if (rto < min_rto) {
+        rto = min_rto;
+    } else if (rto > COAP_RTO_MAX_TICKS) {
+        rto = COAP_RTO_MAX_TICKS;
+    }
+    cr->cr_rto = rto;
+}
+
+static uint32_t
+coap_rtt_rto(oc_endpoint_t *ep)
+{
+    struct coap_rtt *cr;
+
+    cr = coap_rtt_find(ep, 0);
+    if (cr) {
+        return cr->cr_rto;
+    }
+    return COAP_RESPONSE_TIMEOUT_TICKS;
+}
+#endif
+
 void
 coap_transaction_init(void)
 {
@@ -84,7 +184,7 @@ coap_new_transaction(uint16_t mid, oc_endpoint_t *endpoint)
             os_callout_init(&t->retrans_timer, oc_evq_get(),
               coap_transaction_retrans, t);
             /* list itself makes sure same element is not added twice */
-            SLIST_INSERT_HEAD(&oc_transaction_list, t, next);
+            SLIST_INSERT_HEAD(COAP_TRANSACTION_LIST(mid), t, next);
         } else {
             os_memblock_put(&oc_transaction_memb, t);
             t = NULL;
@@ -108,15 +208,35 @@ coap_send_transaction(coap_transaction_t *t)
         if (t->retrans_counter < COAP_MAX_RETRANSMIT) {
             /* not timed out yet */
             if (t->retrans_counter == 0) {
+#if MYNEWT_VAL(OC_COAP_RTT_ENDPOINTS) > 0
+                t->retrans_tmo = coap_rtt_rto(OC_MBUF_ENDPOINT(t->m));
+                t->retrans_tmo += oc_random_rand() % (t->retrans_tmo / 2 + 1);
+#else
                 t->retrans_tmo =
                   COAP_RESPONSE_TIMEOUT_TICKS +
                   (oc_random_rand() %
                     (oc_clock_time_t)COAP_RESPONSE_TIMEOUT_BACKOFF_MASK);
+#endif
+                t->sent_at = os_time_get();
                 OC_LOG_DEBUG("Initial interval " OC_CLK_FMT "\n",
                              t->retrans_tmo);
             } else {
+#if MYNEWT_VAL(OC_COAP_RTT_ENDPOINTS) > 0
+                /*
+                 * Variable backoff: short timeouts grow faster, long
+                 * ones slower.
+                 */
+                if (t->retrans_tmo < OS_TICKS_PER_SEC) {
+                    t->retrans_tmo *= 3;
+                } else if (t->retrans_tmo > 3 * OS_TICKS_PER_SEC) {
+                    t->retrans_tmo += t->retrans_tmo / 2;
+                } else {
+                    t->retrans_tmo <<= 1;
+                }
+#else
                 t->retrans_tmo <<= 1; /* double */
-                OC_LOG_DEBUG("Doubled " OC_CLK_FMT "\n", t->retrans_tmo);
+#endif
+                OC_LOG_DEBUG("Backoff " OC_CLK_FMT "\n", t->retrans_tmo);
             }
 
             os_callout_reset(&t->retrans_timer, t->retrans_tmo);
@@ -127,6 +247,7 @@ coap_send_transaction(coap_transaction_t *t)
         } else {
             /* timed out */
             OC_LOG_DEBUG("Timeout\n");
+            STATS_INC(coap_stats, timeout);
 
 #ifdef OC_SERVER
             /* handle observers */
@@ -165,9 +286,10 @@ coap_clear_transaction(coap_transaction_t *t)
         /*
          * Transaction might not be in the list yet.
          */
-        SLIST_FOREACH(tmp, &oc_transaction_list, next) {
+        SLIST_FOREACH(tmp, COAP_TRANSACTION_LIST(t->mid), next) {
             if (t == tmp) {
-                SLIST_REMOVE(&oc_transaction_list, t, coap_transaction, next);
+                SLIST_REMOVE(COAP_TRANSACTION_LIST(t->mid), t,
+                             coap_transaction, next);
                 break;
             }
         }
@@ -180,7 +302,7 @@ coap_get_transaction_by_mid(uint16_t mid)
 {
     coap_transaction_t *t;
 
-    SLIST_FOREACH(t, &oc_transaction_list, next) {
+    SLIST_FOREACH(t, COAP_TRANSACTION_LIST(mid), next) {
         if (t->mid == mid) {
             return t;
         }
@@ -188,11 +310,35 @@ coap_get_transaction_by_mid(uint16_t mid)
     return NULL;
 }
 
+/*
+ * Called when transaction is ACKed, before it is cleared.
+ */
+void
+coap_transaction_rtt_sample(coap_transaction_t *t)
+{
+    int32_t rtt;
+
+    if (t->type != COAP_TYPE_CON || t->retrans_counter != 0) {
+        /* Can't tell which transmission was ACKed. */
+        return;
+    }
+    rtt = os_time_get() - t->sent_at;
+    if (rtt <= 0) {
+        rtt = 1;
+    }
+    STATS_INC(coap_stats, rtt_samples);
+    STATS_INCN(coap_stats, rtt_ms, (uint32_t)rtt * 1000 / OS_TICKS_PER_SEC);
+#if MYNEWT_VAL(OC_COAP_RTT_ENDPOINTS) > 0
+    coap_rtt_update(OC_MBUF_ENDPOINT(t->m), rtt);
+#endif
+}
+
 static void
 coap_transaction_retrans(struct os_event *ev)
 {
     coap_transaction_t *t = ev->ev_arg;
     ++(t->retrans_counter);
+    STATS_INC(coap_stats, retrans);
     OC_LOG_DEBUG("Retransmitting %u (%u)\n", t->mid, t->retrans_counter);
     coap_send_transaction(t);
 }
@@ -298,47 +298,96 @@ oc_connectivity_shutdown_gatt(void)
     /* there is not unregister for BLE */
 }
 
-static int
+/*
+ * Outgoing frames larger than MTU are sent as slices which reference the
+ * data in the original mbuf chain. The chain is freed once all slices have
+ * been freed. Connection handle has been read from the endpoint in user
+ * header by then, so that space is reused for the reference count.
+ */
+#define OC_BLE_FRAG_REFCNT(m)   (*(uint16_t *)OS_MBUF_USRHDR(m))
+
+static void
+oc_ble_frag_free(const void *buf, void *arg)
+{
+    struct os_mbuf *m = arg;
+    int refcnt;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    refcnt = --OC_BLE_FRAG_REFCNT(m);
+    OS_EXIT_CRITICAL(sr);
+    if (!refcnt) {
+        os_mbuf_free_chain(m);
+    }
+}
+
+static struct os_mbuf *
 oc_ble_frag(struct os_mbuf *m, uint16_t mtu)
 {
     struct os_mbuf_pkthdr *pkt;
+    struct os_mbuf_pkthdr *last;
+    struct os_mbuf *first;
+    struct os_mbuf *om;
     struct os_mbuf *n;
-    uint16_t off, blk;
+    uint16_t off, blk, left;
+    os_sr_t sr;
 
     pkt = OS_MBUF_PKTHDR(m);
     if (pkt->omp_len <= mtu) {
         STAILQ_NEXT(pkt, omp_next) = NULL;
-        return 0;
+        return m;
     }
 
-    off = pkt->omp_len - (pkt->omp_len % mtu);
-    while (off >= mtu) {
-        n = os_msys_get_pkthdr(mtu, 0);
+    OC_BLE_FRAG_REFCNT(m) = 1;
+    first = NULL;
+    last = NULL;
+    om = m;
+    off = 0;
+    while (om) {
+        /*
+         * Leave room for ATT/L2CAP headers to be prepended in place.
+         */
+        n = ble_hs_mbuf_att_pkt();
         if (!n) {
             goto err;
         }
-        STAILQ_NEXT(OS_MBUF_PKTHDR(n), omp_next) = STAILQ_NEXT(pkt, omp_next);
-        STAILQ_NEXT(pkt, omp_next) = OS_MBUF_PKTHDR(n);
-
-        blk = pkt->omp_len - off;
-        if (os_mbuf_appendfrom(n, m, off, blk)) {
-            goto err;
+        STAILQ_NEXT(OS_MBUF_PKTHDR(n), omp_next) = NULL;
+        if (last) {
+            STAILQ_NEXT(last, omp_next) = OS_MBUF_PKTHDR(n);
+        } else {
+            first = n;
+        }
+        last = OS_MBUF_PKTHDR(n);
+
+        for (left = mtu; left && om; ) {
+            blk = min(om->om_len - off, left);
+            if (blk) {
+                if (os_mbuf_append_ext(n, om->om_data + off, blk,
+                                       oc_ble_frag_free, m)) {
+                    goto err;
+                }
+                OS_ENTER_CRITICAL(sr);
+                OC_BLE_FRAG_REFCNT(m)++;
+                OS_EXIT_CRITICAL(sr);
+            }
+            off += blk;
+            left -= blk;
+            if (off == om->om_len) {
+                om = SLIST_NEXT(om, om_next);
+                off = 0;
+            }
         }
-        off -= mtu;
-        os_mbuf_adj(m, -blk);
     }
-    return 0;
+    oc_ble_frag_free(NULL, m);
+    return first;
 err:
-    pkt = OS_MBUF_PKTHDR(m);
-    while (1) {
-        pkt = STAILQ_NEXT(pkt, omp_next);
-        os_mbuf_free_chain(m);
-        if (!pkt) {
-            break;
-        }
-        m = OS_MBUF_PKTHDR_TO_MBUF(pkt);
-    };
-    return -1;
+    while (first) {
+        pkt = STAILQ_NEXT(OS_MBUF_PKTHDR(first), omp_next);
+        os_mbuf_free_chain(first);
+        first = pkt ? OS_MBUF_PKTHDR_TO_MBUF(pkt) : NULL;
+    }
+    oc_ble_frag_free(NULL, m);
+    return NULL;
 }
 
 void
@@ -370,7 +419,8 @@ oc_send_buffer_gatt(struct os_mbuf *m)
     }
     mtu -= 3; /* # of bytes for ATT notification base */
 
-    if (oc_ble_frag(m, mtu)) {
+    m = oc_ble_frag(m, mtu);
+    if (!m) {
         STATS_INC(oc_ble_stats, oerr);
         return;
     }
@@ -46,6 +46,9 @@ static struct os_event oc_sock4_read_event = {
 
 #define COAP_PORT_UNSECURED (5683)
 
+/* Max number of datagrams read from socket at a time */
+#define OC_IP_RX_BATCH      4
+
 /* 224.0.1.187 */
 static const struct mn_in_addr coap_all_nodes_v4 = {
     .s_addr = htonl(0xe00001bb)
@@ -181,18 +184,11 @@ oc_send_buffer_ip4_mcast(struct os_mbuf *m)
 }
 
 static struct os_mbuf *
-oc_attempt_rx_ip4_sock(struct mn_socket *rxsock)
+oc_ip4_rx_wrap(struct os_mbuf *n, struct mn_sockaddr_in *from)
 {
-    int rc;
     struct os_mbuf *m;
-    struct os_mbuf *n;
     struct oc_endpoint *oe;
-    struct mn_sockaddr_in from;
 
-    rc = mn_recvfrom(rxsock, &n, (struct mn_sockaddr *) &from);
-    if (rc != 0) {
-        return NULL;
-    }
     assert(OS_MBUF_IS_PKTHDR(n));
 
     STATS_INC(oc_ip4_stats, iframe);
@@ -208,9 +204,9 @@ oc_attempt_rx_ip4_sock(struct mn_socket *rxsock)
     oe = OC_MBUF_ENDPOINT(m);
 
     oe->oe_ip.flags = IP4;
-    memcpy(&oe->oe_ip.v4.address, &from.msin_addr,
+    memcpy(&oe->oe_ip.v4.address, &from->msin_addr,
            sizeof(oe->oe_ip.v4.address));
-    oe->oe_ip.v4.port = ntohs(from.msin_port);
+    oe->oe_ip.v4.port = ntohs(from->msin_port);
 
     return m;
 
@@ -221,18 +217,30 @@ rx_attempt_err:
     return NULL;
 }
 
-static struct os_mbuf *
-oc_attempt_rx_ip4(void)
+/*
+ * Receives and processes up to OC_IP_RX_BATCH datagrams from socket.
+ * Returns the number of datagrams received.
+ */
+static int
+oc_attempt_rx_ip4_sock(struct mn_socket *rxsock)
 {
+    struct mn_msg msgs[OC_IP_RX_BATCH];
     struct os_mbuf *m;
+    int cnt;
+    int i;
 
-    m = oc_attempt_rx_ip4_sock(oc_ucast4);
-#if (MYNEWT_VAL(OC_SERVER) == 1)
-    if (m == NULL) {
-        m = oc_attempt_rx_ip4_sock(oc_mcast4);
+    cnt = OC_IP_RX_BATCH;
+    if (mn_recvmsgs(rxsock, msgs, &cnt)) {
+        return 0;
     }
-#endif
-    return m;
+    for (i = 0; i < cnt; i++) {
+        m = oc_ip4_rx_wrap(msgs[i].mm_m,
+          (struct mn_sockaddr_in *)&msgs[i].mm_addr);
+        if (m) {
+            oc_recv_message(m);
+        }
+    }
+    return cnt;
 }
 
 static void oc_socks4_readable(void *cb_arg, int err);
@@ -265,17 +273,21 @@ oc_connectivity_shutdown_ip4(void)
 static void
 oc_event_ip4(struct os_event *ev)
 {
-    struct os_mbuf *m;
+    int cnt;
 
-    while ((m = oc_attempt_rx_ip4()) != NULL) {
-        oc_recv_message(m);
-    }
+    do {
+        cnt = oc_attempt_rx_ip4_sock(oc_ucast4);
+#if (MYNEWT_VAL(OC_SERVER) == 1)
+        cnt += oc_attempt_rx_ip4_sock(oc_mcast4);
+#endif
+    } while (cnt);
 }
 
 int
 oc_connectivity_init_ip4(void)
 {
     int rc;
+    int rx_batch = 1;
     struct mn_sockaddr_in sin;
     struct mn_itf itf;
 
@@ -287,6 +299,7 @@ oc_connectivity_init_ip4(void)
         return rc;
     }
     mn_socket_set_cbs(oc_ucast4, oc_ucast4, &oc_sock4_cbs);
+    mn_setsockopt(oc_ucast4, MN_SO_LEVEL, MN_SO_RXBATCH, &rx_batch);
 
 #if (MYNEWT_VAL(OC_SERVER) == 1)
     rc = mn_socket(&oc_mcast4, MN_PF_INET, MN_SOCK_DGRAM, 0);
@@ -296,6 +309,7 @@ oc_connectivity_init_ip4(void)
         return rc;
     }
     mn_socket_set_cbs(oc_mcast4, oc_mcast4, &oc_sock4_cbs);
+    mn_setsockopt(oc_mcast4, MN_SO_LEVEL, MN_SO_RXBATCH, &rx_batch);
 #endif
 
     sin.msin_len = sizeof(sin);
@@ -47,6 +47,9 @@ static struct os_event oc_sock6_read_event = {
 
 #define COAP_PORT_UNSECURED (5683)
 
+/* Max number of datagrams read from socket at a time */
+#define OC_IP_RX_BATCH      4
+
 /* link-local scoped address ff02::fd */
 static const struct mn_in6_addr coap_all_nodes_v6 = {
     .s_addr = {
@@ -178,18 +181,11 @@ oc_send_buffer_ip6_mcast(struct os_mbuf *m)
 }
 
 static struct os_mbuf *
-oc_attempt_rx_ip6_sock(struct mn_socket *rxsock)
+oc_ip6_rx_wrap(struct os_mbuf *n, struct mn_sockaddr_in6 *from)
 {
-    int rc;
     struct os_mbuf *m;
-    struct os_mbuf *n;
     struct oc_endpoint *oe;
-    struct mn_sockaddr_in6 from;
 
-    rc = mn_recvfrom(rxsock, &n, (struct mn_sockaddr *) &from);
-    if (rc != 0) {
-        return NULL;
-    }
     assert(OS_MBUF_IS_PKTHDR(n));
 
     STATS_INC(oc_ip_stats, iframe);
@@ -205,10 +201,10 @@ oc_attempt_rx_ip6_sock(struct mn_socket *rxsock)
     oe = OC_MBUF_ENDPOINT(m);
 
     oe->oe_ip.flags = IP;
-    memcpy(&oe->oe_ip.v6.address, &from.msin6_addr,
+    memcpy(&oe->oe_ip.v6.address, &from->msin6_addr,
            sizeof(oe->oe_ip.v6.address));
-    oe->oe_ip.v6.scope = from.msin6_scope_id;
-    oe->oe_ip.v6.port = ntohs(from.msin6_port);
+    oe->oe_ip.v6.scope = from->msin6_scope_id;
+    oe->oe_ip.v6.port = ntohs(from->msin6_port);
 
     return m;
 
@@ -219,18 +215,30 @@ rx_attempt_err:
     return NULL;
 }
 
-static struct os_mbuf *
-oc_attempt_rx_ip6(void)
+/*
+ * Receives and processes up to OC_IP_RX_BATCH datagrams from socket.
+ * Returns the number of datagrams received.
+ */
+static int
+oc_attempt_rx_ip6_sock(struct mn_socket *rxsock)
 {
+    struct mn_msg msgs[OC_IP_RX_BATCH];
     struct os_mbuf *m;
+    int cnt;
+    int i;
 
-    m = oc_attempt_rx_ip6_sock(oc_ucast6);
-#if (MYNEWT_VAL(OC_SERVER) == 1)
-    if (m == NULL) {
-        m = oc_attempt_rx_ip6_sock(oc_mcast6);
+    cnt = OC_IP_RX_BATCH;
+    if (mn_recvmsgs(rxsock, msgs, &cnt)) {
+        return 0;
     }
-#endif
-    return m;
+    for (i = 0; i < cnt; i++) {
+        m = oc_ip6_rx_wrap(msgs[i].mm_m,
+          (struct mn_sockaddr_in6 *)&msgs[i].mm_addr);
+        if (m) {
+            oc_recv_message(m);
+        }
+    }
+    return cnt;
 }
 
 static void oc_socks6_readable(void *cb_arg, int err);
@@ -264,17 +272,21 @@ oc_connectivity_shutdown_ip6(void)
 static void
 oc_event_ip6(struct os_event *ev)
 {
-    struct os_mbuf *m;
+    int cnt;
 
-    while ((m = oc_attempt_rx_ip6()) != NULL) {
-        oc_recv_message(m);
-    }
+    do {
+        cnt = oc_attempt_rx_ip6_sock(oc_ucast6);
+#if (MYNEWT_VAL(OC_SERVER) == 1)
+        cnt += oc_attempt_rx_ip6_sock(oc_mcast6);
+#endif
+    } while (cnt);
 }
 
 int
 oc_connectivity_init_ip6(void)
 {
     int rc;
+    int rx_batch = 1;
     struct mn_sockaddr_in6 sin;
     struct mn_itf itf;
 
@@ -286,6 +298,7 @@ oc_connectivity_init_ip6(void)
         return rc;
     }
     mn_socket_set_cbs(oc_ucast6, oc_ucast6, &oc_sock6_cbs);
+    mn_setsockopt(oc_ucast6, MN_SO_LEVEL, MN_SO_RXBATCH, &rx_batch);
 
 #if (MYNEWT_VAL(OC_SERVER) == 1)
     rc = mn_socket(&oc_mcast6, MN_PF_INET6, MN_SOCK_DGRAM, 0);
@@ -295,6 +308,7 @@ oc_connectivity_init_ip6(void)
         return rc;
     }
     mn_socket_set_cbs(oc_mcast6, oc_mcast6, &oc_sock6_cbs);
+    mn_setsockopt(oc_mcast6, MN_SO_LEVEL, MN_SO_RXBATCH, &rx_batch);
 #endif
 
     sin.msin6_len = sizeof(sin);
@@ -43,6 +43,20 @@ struct wifi_ap {
     int8_t wa_rssi;
     uint8_t wa_key_type;
     uint8_t wa_channel;
+    os_time_t wa_seen;          /* when last reported; set by wifi_mgmt */
+};
+
+/*
+ * Connection setup metrics.
+ */
+struct wifi_conn_stats {
+    uint32_t wcs_connects;      /* connect attempts started */
+    uint32_t wcs_cached;        /* attempts made from cache, without scan */
+    uint32_t wcs_scans;         /* scans started */
+    uint32_t wcs_fails;         /* attempts which failed */
+    uint32_t wcs_last_ms;       /* wifi_connect() to IP address, last */
+    uint32_t wcs_min_ms;
+    uint32_t wcs_max_ms;
 };
 
 struct wifi_if_ops;
@@ -65,7 +79,14 @@ struct wifi_if {
     const struct wifi_if_ops *wi_ops;
 
     uint8_t wi_scan_cnt;
-    struct wifi_ap wi_scan[WIFI_SCAN_CNT_MAX];
+    uint8_t wi_conn_cached:1;   /* current attempt did not scan */
+    uint8_t wi_conn_retry:1;    /* rescan and retry after failure */
+    uint8_t wi_conn_timing:1;   /* wi_conn_start is valid */
+    os_time_t wi_scan_time;     /* when the latest scan was started */
+    os_time_t wi_conn_start;
+    struct wifi_ap wi_conn_ap;  /* AP of the current attempt */
+    struct wifi_ap wi_scan[WIFI_SCAN_CNT_MAX];  /* scan result cache */
+    struct wifi_conn_stats wi_stats;
     char wi_ssid[WIFI_SSID_MAX + 1];
     char wi_key[WIFI_KEY_MAX + 1];
     uint8_t wi_myip[4];
@@ -80,6 +101,7 @@ int wifi_if_register(struct wifi_if *, const struct wifi_if_ops *);
 
 int wifi_start(struct wifi_if *);
 int wifi_connect(struct wifi_if *);
+int wifi_connect_ap(struct wifi_if *, const struct wifi_ap *ap);
 int wifi_stop(struct wifi_if *w);
 int wifi_scan_start(struct wifi_if *w);
 
@@ -30,6 +30,12 @@
 #include "wifi_mgmt/wifi_mgmt_if.h"
 #include "wifi_priv.h"
 
+/*
+ * Scan results are kept for this long, and connect attempts made within
+ * that time go straight to the cached AP instead of scanning first.
+ */
+#define WIFI_SCAN_TTL   (MYNEWT_VAL(WIFI_SCAN_CACHE_TTL) * OS_TICKS_PER_SEC)
+
 static struct os_task wifi_os_task;
 struct os_eventq wifi_evq;
 
@@ -81,6 +87,90 @@ wifi_tgt_state(struct wifi_if *wi, int state)
     os_eventq_put(&wifi_evq, &wi->wi_event);
 }
 
+/*
+ * Scan result cache. Entries are usable if they're younger than
+ * WIFI_SCAN_TTL, or if they were reported during the latest scan.
+ */
+static int
+wifi_ap_usable(struct wifi_if *wi, struct wifi_ap *ap, os_time_t now)
+{
+    return (os_time_t)(now - ap->wa_seen) < WIFI_SCAN_TTL ||
+      OS_TIME_TICK_GEQ(ap->wa_seen, wi->wi_scan_time);
+}
+
+static int
+wifi_ap_same(const struct wifi_ap *a, const struct wifi_ap *b)
+{
+    static const char no_bssid[WIFI_BSSID_LEN];
+
+    if (!memcmp(a->wa_bssid, no_bssid, WIFI_BSSID_LEN) ||
+      !memcmp(b->wa_bssid, no_bssid, WIFI_BSSID_LEN)) {
+        /* Driver does not report BSSIDs. */
+        return !strcmp(a->wa_ssid, b->wa_ssid) &&
+          a->wa_channel == b->wa_channel;
+    }
+    return !memcmp(a->wa_bssid, b->wa_bssid, WIFI_BSSID_LEN);
+}
+
+static void
+wifi_cache_del(struct wifi_if *wi, int idx)
+{
+    wi->wi_scan[idx] = wi->wi_scan[--wi->wi_scan_cnt];
+    memset(&wi->wi_scan[wi->wi_scan_cnt], 0, sizeof(wi->wi_scan[0]));
+}
+
+/*
+ * Adds AP to cache, or refreshes the existing entry for it. When full,
+ * the entry which has been around the longest is replaced.
+ */
+static void
+wifi_cache_add(struct wifi_if *wi, const struct wifi_ap *ap)
+{
+    os_time_t now;
+    int oldest;
+    int i;
+
+    now = os_time_get();
+    oldest = 0;
+    for (i = 0; i < wi->wi_scan_cnt; i++) {
+        if (wifi_ap_same(&wi->wi_scan[i], ap)) {
+            break;
+        }
+        if (OS_TIME_TICK_LT(wi->wi_scan[i].wa_seen,
+            wi->wi_scan[oldest].wa_seen)) {
+            oldest = i;
+        }
+    }
+    if (i == wi->wi_scan_cnt) {
+        if (wi->wi_scan_cnt < WIFI_SCAN_CNT_MAX) {
+            wi->wi_scan_cnt++;
+        } else {
+            i = oldest;
+        }
+    }
+    wi->wi_scan[i] = *ap;
+    wi->wi_scan[i].wa_seen = now;
+}
+
+/*
+ * Drops entries which have aged out.
+ */
+static void
+wifi_cache_age(struct wifi_if *wi)
+{
+    os_time_t now;
+    int i;
+
+    now = os_time_get();
+    for (i = 0; i < wi->wi_scan_cnt; ) {
+        if ((os_time_t)(now - wi->wi_scan[i].wa_seen) >= WIFI_SCAN_TTL) {
+            wifi_cache_del(wi, i);
+        } else {
+            i++;
+        }
+    }
+}
+
 /*
  * Wi-fi driver reports a response to wifi scan request.
  * Driver reports networks one at a time.
@@ -88,10 +178,7 @@ wifi_tgt_state(struct wifi_if *wi, int state)
 void
 wifi_scan_result(struct wifi_if *wi, struct wifi_ap *ap)
 {
-    if (wi->wi_scan_cnt == WIFI_SCAN_CNT_MAX) {
-        return;
-    }
-    wi->wi_scan[wi->wi_scan_cnt++] = *ap;
+    wifi_cache_add(wi, ap);
 }
 
 /*
@@ -128,8 +215,26 @@ wifi_scan_done(struct wifi_if *wi, int status)
 void
 wifi_connect_done(struct wifi_if *wi, int status)
 {
+    int i;
+
     console_printf("connect_done : %d\n", status);
     if (status) {
+        wi->wi_stats.wcs_fails++;
+        if (wi->wi_conn_cached) {
+            /*
+             * Cached AP did not work out; forget it, and retry with a scan.
+             */
+            for (i = 0; i < wi->wi_scan_cnt; i++) {
+                if (wifi_ap_same(&wi->wi_scan[i], &wi->wi_conn_ap)) {
+                    wifi_cache_del(wi, i);
+                    break;
+                }
+            }
+            wi->wi_conn_cached = 0;
+            wi->wi_conn_retry = 1;
+        } else {
+            wi->wi_conn_timing = 0;
+        }
         wifi_tgt_state(wi, INIT);
         return;
     }
@@ -143,7 +248,23 @@ wifi_connect_done(struct wifi_if *wi, int status)
 void
 wifi_dhcp_done(struct wifi_if *wi, uint8_t *ip)
 {
+    struct wifi_conn_stats *ws;
+    uint32_t ms;
+
     console_printf("dhcp done %d.%d.%d.%d\n", ip[0], ip[1], ip[2], ip[3]);
+    if (wi->wi_conn_timing) {
+        wi->wi_conn_timing = 0;
+        ws = &wi->wi_stats;
+        ms = (uint32_t)(os_time_get() - wi->wi_conn_start) * 1000 /
+          OS_TICKS_PER_SEC;
+        ws->wcs_last_ms = ms;
+        if (ws->wcs_min_ms == 0 || ms < ws->wcs_min_ms) {
+            ws->wcs_min_ms = ms;
+        }
+        if (ms > ws->wcs_max_ms) {
+            ws->wcs_max_ms = ms;
+        }
+    }
     wifi_tgt_state(wi, CONNECTED);
 }
 
@@ -157,17 +278,29 @@ wifi_disconnected(struct wifi_if *wi, int status)
     wifi_tgt_state(wi, INIT);
 }
 
+/*
+ * Returns the strongest usable AP in cache with matching SSID.
+ */
 static struct wifi_ap *
 wifi_find_ap(struct wifi_if *wi, char *ssid)
 {
+    struct wifi_ap *ap;
+    struct wifi_ap *best;
+    os_time_t now;
     int i;
 
+    now = os_time_get();
+    best = NULL;
     for (i = 0; i < wi->wi_scan_cnt; i++) {
-        if (!strcmp(wi->wi_scan[i].wa_ssid, ssid)) {
-            return &wi->wi_scan[i];
+        ap = &wi->wi_scan[i];
+        if (strcmp(ap->wa_ssid, ssid) || !wifi_ap_usable(wi, ap, now)) {
+            continue;
+        }
+        if (!best || ap->wa_rssi > best->wa_rssi) {
+            best = ap;
         }
     }
-    return NULL;
+    return best;
 }
 
 static void
@@ -215,6 +348,9 @@ wifi_connect(struct wifi_if *wi)
         if (WIFI_SSID_EMPTY(wi->wi_ssid)) {
             return -1;
         }
+        wi->wi_stats.wcs_connects++;
+        wi->wi_conn_start = os_time_get();
+        wi->wi_conn_timing = 1;
         wifi_tgt_state(wi, CONNECTING);
         return 0;
     default:
@@ -223,6 +359,22 @@ wifi_connect(struct wifi_if *wi)
     return 0;
 }
 
+/*
+ * Called by user to connect to a known AP, e.g. one remembered from an
+ * earlier session, without scanning first. SSID, BSSID and channel of ap
+ * must be filled in. If the connection fails, falls back to scanning.
+ */
+int
+wifi_connect_ap(struct wifi_if *wi, const struct wifi_ap *ap)
+{
+    if (wi->wi_state != INIT || WIFI_SSID_EMPTY(ap->wa_ssid)) {
+        return -1;
+    }
+    wifi_cache_add(wi, ap);
+    strcpy(wi->wi_ssid, ap->wa_ssid);
+    return wifi_connect(wi);
+}
+
 /*
  * From user to initiate Wi-Fi scan.
  */
@@ -266,11 +418,17 @@ wifi_step(struct wifi_if *wi)
             wi->wi_state = wi->wi_tgt;
         } else if (wi->wi_state == CONNECTING) {
             wi->wi_state = wi->wi_tgt;
+            if (wi->wi_conn_retry) {
+                wi->wi_conn_retry = 0;
+                wi->wi_tgt = CONNECTING;
+            }
         }
         break;
     case SCANNING:
         if (wi->wi_state == INIT) {
-            memset(wi->wi_scan, 0, sizeof(wi->wi_scan));
+            wifi_cache_age(wi);
+            wi->wi_scan_time = os_time_get();
+            wi->wi_stats.wcs_scans++;
             rc = wi->wi_ops->wio_scan_start(wi);
             console_printf("wifi_request_scan : %d\n", rc);
             if (rc != 0) {
@@ -288,6 +446,11 @@ wifi_step(struct wifi_if *wi)
                 wifi_tgt_state(wi, SCANNING);
                 break;
             }
+            wi->wi_conn_cached = (wi->wi_state == INIT);
+            if (wi->wi_conn_cached) {
+                wi->wi_stats.wcs_cached++;
+            }
+            wi->wi_conn_ap = *ap;
             rc = wi->wi_ops->wio_connect(wi, ap);
             console_printf("wifi_connect : %d\n", rc);
             if (rc == 0) {
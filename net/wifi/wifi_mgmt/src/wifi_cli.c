@@ -53,13 +53,25 @@ wifi_cli(int argc, char **argv)
         int i;
         struct wifi_ap *ap;
 
-        console_printf("   %32s %4s %4s %s\n", "SSID", "RSSI", "chan", "sec");
+        console_printf("   %32s %4s %4s %3s %s\n", "SSID", "RSSI", "chan",
+          "sec", "age");
         for (i = 0; i < wi->wi_scan_cnt; i++) {
             ap = (struct wifi_ap *)&wi->wi_scan[i];
-            console_printf("%2d:%32s %4d %4d %s\n",
+            console_printf("%2d:%32s %4d %4d %3s %lu\n",
               i, ap->wa_ssid, ap->wa_rssi, ap->wa_channel,
-              ap->wa_key_type ? "X" : "");
+              ap->wa_key_type ? "X" : "",
+              (unsigned long)((os_time_get() - ap->wa_seen) /
+                OS_TICKS_PER_SEC));
         }
+    } else if (!strcmp(argv[1], "stats")) {
+        struct wifi_conn_stats *ws = &wi->wi_stats;
+
+        console_printf("connects %lu cached %lu scans %lu fails %lu\n",
+          (unsigned long)ws->wcs_connects, (unsigned long)ws->wcs_cached,
+          (unsigned long)ws->wcs_scans, (unsigned long)ws->wcs_fails);
+        console_printf("connect ms last %lu min %lu max %lu\n",
+          (unsigned long)ws->wcs_last_ms, (unsigned long)ws->wcs_min_ms,
+          (unsigned long)ws->wcs_max_ms);
     } else if (!strcmp(argv[1], "connect")) {
         if (argc < 2) {
             goto conn_usage;
@@ -83,7 +95,7 @@ conn_usage:
         }
     } else {
 usage:
-        console_printf("start|stop|scan|aps|connect <ssid> [<key>]\n");
+        console_printf("start|stop|scan|aps|stats|connect <ssid> [<key>]\n");
     }
     return 0;
 }
@@ -52,6 +52,12 @@ enum conf_export_tgt {
     CONF_EXPORT_SHOW            /* Value is to be displayed. */
 };
 
+/*
+ * Handler flags.
+ */
+#define CONF_HANDLER_F_LAZY     0x01    /* Load on first use, not at boot */
+#define CONF_HANDLER_F_LOADED   0x02    /* Internal */
+
 struct conf_handler {
     SLIST_ENTRY(conf_handler) ch_list;
     char *ch_name;
@@ -60,14 +66,19 @@ struct conf_handler {
     int (*ch_commit)(void);
     int (*ch_export)(void (*export_func)(char *name, char *val),
       enum conf_export_tgt tgt);
+    uint8_t ch_flags;
+    uint32_t ch_hash;
+    SLIST_ENTRY(conf_handler) ch_hash_next;
 };
 
 void conf_init(void);
 int conf_register(struct conf_handler *);
 int conf_load(void);
+int conf_load_subtree(char *name);
 
 int conf_save(void);
 int conf_save_one(const char *name, char *var);
+int conf_save_flush(void);
 
 void conf_store_init(void);
 
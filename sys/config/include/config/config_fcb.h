@@ -33,6 +33,13 @@ struct conf_fcb {
 extern int conf_fcb_src(struct conf_fcb *cf);
 extern int conf_fcb_dst(struct conf_fcb *cf);
 
+/*
+ * Same FCB layout, but values are stored in binary form keyed by the hash
+ * of their name.  Reads text records written by conf_fcb_src/dst.
+ */
+extern int conf_fcb_bin_src(struct conf_fcb *cf);
+extern int conf_fcb_bin_dst(struct conf_fcb *cf);
+
 #ifdef __cplusplus
 }
 #endif
@@ -30,6 +30,11 @@
 
 struct conf_handler_head conf_handlers;
 
+#if MYNEWT_VAL(CONFIG_HANDLER_HASH_SIZE) > 0
+static struct conf_handler_head
+  conf_handler_hash[MYNEWT_VAL(CONFIG_HANDLER_HASH_SIZE)];
+#endif
+
 static uint8_t conf_cmd_inited;
 
 void
@@ -38,6 +43,9 @@ conf_init(void)
     int rc;
 
     SLIST_INIT(&conf_handlers);
+#if MYNEWT_VAL(CONFIG_HANDLER_HASH_SIZE) > 0
+    memset(conf_handler_hash, 0, sizeof(conf_handler_hash));
+#endif
     conf_store_init();
 
     if (conf_cmd_inited) {
@@ -58,10 +66,33 @@ conf_init(void)
     conf_cmd_inited = 1;
 }
 
+uint32_t
+conf_name_hash(const char *name)
+{
+    uint32_t hash;
+
+    /* FNV-1a */
+    hash = 2166136261u;
+    while (*name) {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619u;
+    }
+    if (hash == 0) {
+        hash = 1;
+    }
+    return hash;
+}
+
 int
 conf_register(struct conf_handler *handler)
 {
     SLIST_INSERT_HEAD(&conf_handlers, handler, ch_list);
+    handler->ch_hash = conf_name_hash(handler->ch_name);
+    handler->ch_flags &= ~CONF_HANDLER_F_LOADED;
+#if MYNEWT_VAL(CONFIG_HANDLER_HASH_SIZE) > 0
+    SLIST_INSERT_HEAD(&conf_handler_hash[handler->ch_hash %
+        MYNEWT_VAL(CONFIG_HANDLER_HASH_SIZE)], handler, ch_hash_next);
+#endif
     return 0;
 }
 
@@ -72,15 +103,40 @@ struct conf_handler *
 conf_handler_lookup(char *name)
 {
     struct conf_handler *ch;
+    uint32_t hash;
 
+    hash = conf_name_hash(name);
+#if MYNEWT_VAL(CONFIG_HANDLER_HASH_SIZE) > 0
+    SLIST_FOREACH(ch, &conf_handler_hash[hash %
+        MYNEWT_VAL(CONFIG_HANDLER_HASH_SIZE)], ch_hash_next) {
+#else
     SLIST_FOREACH(ch, &conf_handlers, ch_list) {
-        if (!strcmp(name, ch->ch_name)) {
+#endif
+        if (ch->ch_hash == hash && !strcmp(name, ch->ch_name)) {
             return ch;
         }
     }
     return NULL;
 }
 
+/*
+ * Handler for the first element of name, without modifying name.
+ */
+struct conf_handler *
+conf_handler_of(const char *name)
+{
+    char buf[CONF_MAX_NAME_LEN + 1];
+    int len;
+
+    len = strcspn(name, CONF_NAME_SEPARATOR);
+    if (len >= sizeof(buf)) {
+        return NULL;
+    }
+    memcpy(buf, name, len);
+    buf[len] = '\0';
+    return conf_handler_lookup(buf);
+}
+
 /*
  * Separate string into argv array.
  */
@@ -259,6 +315,7 @@ conf_get_value(char *name, char *buf, int buf_len)
     if (!ch) {
         return NULL;
     }
+    conf_load_lazy(ch);
 
     return ch->ch_get(name_argc - 1, &name_argv[1], buf, buf_len);
 }
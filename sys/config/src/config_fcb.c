@@ -23,6 +23,7 @@
 
 #include <os/os.h>
 #include <fcb/fcb.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "config/config.h"
@@ -46,7 +47,7 @@ static struct conf_store_itf conf_fcb_itf = {
 };
 
 int
-conf_fcb_src(struct conf_fcb *cf)
+conf_fcb_init(struct conf_fcb *cf)
 {
     int rc;
 
@@ -70,7 +71,18 @@ conf_fcb_src(struct conf_fcb *cf)
             break;
         }
     }
+    return OS_OK;
+}
+
+int
+conf_fcb_src(struct conf_fcb *cf)
+{
+    int rc;
 
+    rc = conf_fcb_init(cf);
+    if (rc) {
+        return rc;
+    }
     cf->cf_store.cs_itf = &conf_fcb_itf;
     conf_src_register(&cf->cf_store);
 
@@ -147,6 +159,120 @@ conf_fcb_var_read(struct fcb_entry *loc, char *buf, char **name, char **val)
     return rc;
 }
 
+#if MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX) > 0
+/*
+ * Location of the latest entry for names with a given hash.  Built once
+ * per compression, so that checking whether an entry has been superseded
+ * does not need a scan of the rest of the FCB.
+ */
+struct conf_fcb_idx {
+    uint32_t cfi_hash;		/* 0 if slot is unused */
+    struct fcb_entry cfi_loc;
+};
+
+static struct conf_fcb_idx *
+conf_fcb_idx_slot(struct conf_fcb_idx *idx, uint32_t hash)
+{
+    struct conf_fcb_idx *cfi;
+    int i;
+    int j;
+
+    j = hash % MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX);
+    for (i = 0; i < MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX); i++) {
+        cfi = &idx[j];
+        if (cfi->cfi_hash == 0 || cfi->cfi_hash == hash) {
+            return cfi;
+        }
+        if (++j == MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX)) {
+            j = 0;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Returns NULL if there are more distinct names than fit in the index.
+ */
+static struct conf_fcb_idx *
+conf_fcb_idx_build(struct conf_fcb *cf, char *buf)
+{
+    struct conf_fcb_idx *idx;
+    struct conf_fcb_idx *cfi;
+    struct fcb_entry loc;
+    char *name, *val;
+    uint32_t hash;
+
+    idx = calloc(MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX), sizeof(*idx));
+    if (!idx) {
+        return NULL;
+    }
+    loc.fe_area = NULL;
+    loc.fe_elem_off = 0;
+    while (fcb_getnext(&cf->cf_fcb, &loc) == 0) {
+        if (conf_fcb_var_read(&loc, buf, &name, &val)) {
+            continue;
+        }
+        hash = conf_name_hash(name);
+        cfi = conf_fcb_idx_slot(idx, hash);
+        if (!cfi) {
+            free(idx);
+            return NULL;
+        }
+        cfi->cfi_hash = hash;
+        cfi->cfi_loc = loc;
+    }
+    return idx;
+}
+#endif
+
+/*
+ * Whether there's a later entry in FCB for the same name as loc1.
+ */
+static int
+conf_fcb_superseded(struct conf_fcb *cf, void *idx, struct fcb_entry *loc1,
+  char *name1, char *buf2)
+{
+    struct fcb_entry loc2;
+    char *name2, *val2;
+    int rc;
+#if MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX) > 0
+    struct conf_fcb_idx *cfi;
+    uint32_t hash;
+
+    if (idx) {
+        hash = conf_name_hash(name1);
+        cfi = conf_fcb_idx_slot(idx, hash);
+    } else {
+        cfi = NULL;
+    }
+    if (cfi && cfi->cfi_hash == hash) {
+        if (cfi->cfi_loc.fe_area == loc1->fe_area &&
+          cfi->cfi_loc.fe_elem_off == loc1->fe_elem_off) {
+            return 0;
+        }
+        rc = conf_fcb_var_read(&cfi->cfi_loc, buf2, &name2, &val2);
+        if (rc == 0 && !strcmp(name1, name2)) {
+            return 1;
+        }
+        /*
+         * Hash collision with a different name; search.
+         */
+    }
+#endif
+
+    loc2 = *loc1;
+    while (fcb_getnext(&cf->cf_fcb, &loc2) == 0) {
+        rc = conf_fcb_var_read(&loc2, buf2, &name2, &val2);
+        if (rc) {
+            continue;
+        }
+        if (!strcmp(name1, name2)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
 static void
 conf_fcb_compress(struct conf_fcb *cf)
 {
@@ -156,11 +282,17 @@ conf_fcb_compress(struct conf_fcb *cf)
     struct fcb_entry loc1;
     struct fcb_entry loc2;
     char *name1, *val1;
-    char *name2, *val2;
-    int copy;
+    void *idx;
+
+#if MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX) > 0
+    idx = conf_fcb_idx_build(cf, buf2);
+#else
+    idx = NULL;
+#endif
 
     rc = fcb_append_to_scratch(&cf->cf_fcb);
     if (rc) {
+        free(idx);
         return; /* XXX */
     }
 
@@ -174,19 +306,7 @@ conf_fcb_compress(struct conf_fcb *cf)
         if (rc) {
             continue;
         }
-        loc2 = loc1;
-        copy = 1;
-        while (fcb_getnext(&cf->cf_fcb, &loc2) == 0) {
-            rc = conf_fcb_var_read(&loc2, buf2, &name2, &val2);
-            if (rc) {
-                continue;
-            }
-            if (!strcmp(name1, name2)) {
-                copy = 0;
-                break;
-            }
-        }
-        if (!copy) {
+        if (conf_fcb_superseded(cf, idx, &loc1, name1, buf2)) {
             continue;
         }
 
@@ -209,6 +329,7 @@ conf_fcb_compress(struct conf_fcb *cf)
         }
         fcb_append_finish(&cf->cf_fcb, &loc2);
     }
+    free(idx);
     rc = fcb_rotate(&cf->cf_fcb);
     if (rc) {
         /* XXXX */
@@ -0,0 +1,635 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(CONFIG_FCB) && MYNEWT_VAL(CONFIG_FCB_BINARY)
+
+#include <os/os.h>
+#include <os/endian.h>
+#include <fcb/fcb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config/config.h"
+#include "config/config_fcb.h"
+#include "config_priv.h"
+
+/*
+ * Binary records.  Name is replaced by a 32 bit id, the hash of the name,
+ * and value is stored in native form:
+ *
+ *   CONF_FCB_BIN_NAME, id, name
+ *   CONF_FCB_BIN_VAL | type, id, value
+ *
+ * Name record for an id is written only once, so updating a setting costs
+ * the header plus the value.  Value is 1, 2 or 4 byte integer, raw bytes,
+ * or string without terminator; CONF_NONE has no value.  The encoding is
+ * picked so that value reads back as the exact string that was saved.
+ *
+ * Text records ("name=value") from conf_fcb are still read; their first
+ * byte is always below CONF_FCB_BIN_VAL.  They're converted to binary
+ * records when their sector is compressed.
+ */
+#define CONF_FCB_BIN_VAL	0x80	/* low bits hold enum conf_type */
+#define CONF_FCB_BIN_NAME	0xc0
+#define CONF_FCB_BIN_TEXT	0	/* cbr_tag of a text record */
+#define CONF_FCB_BIN_TYPE_MASK	0x3f
+
+#define CONF_FCB_BIN_HDR	5
+#define CONF_FCB_BIN_BUF	(CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32)
+
+struct conf_fcb_bin_rec {
+    uint8_t cbr_tag;
+    uint32_t cbr_id;
+    char *cbr_name;		/* name and text records */
+    char *cbr_val;		/* value and text records */
+    int cbr_val_len;
+};
+
+static int conf_fcb_bin_load(struct conf_store *, load_cb cb, void *cb_arg);
+static int conf_fcb_bin_save(struct conf_store *, const char *name,
+  const char *value);
+
+static struct conf_store_itf conf_fcb_bin_itf = {
+    .csi_load = conf_fcb_bin_load,
+    .csi_save = conf_fcb_bin_save,
+};
+
+int
+conf_fcb_bin_src(struct conf_fcb *cf)
+{
+    int rc;
+
+    rc = conf_fcb_init(cf);
+    if (rc) {
+        return rc;
+    }
+    cf->cf_store.cs_itf = &conf_fcb_bin_itf;
+    conf_src_register(&cf->cf_store);
+
+    return OS_OK;
+}
+
+int
+conf_fcb_bin_dst(struct conf_fcb *cf)
+{
+    cf->cf_store.cs_itf = &conf_fcb_bin_itf;
+    conf_dst_register(&cf->cf_store);
+
+    return OS_OK;
+}
+
+/*
+ * Read and parse record at loc.  Strings in rec point into buf, which
+ * must be CONF_FCB_BIN_BUF bytes.
+ */
+static int
+conf_fcb_bin_read(struct fcb_entry *loc, char *buf,
+  struct conf_fcb_bin_rec *rec)
+{
+    int len;
+    int rc;
+
+    len = loc->fe_data_len;
+    if (len >= CONF_FCB_BIN_BUF) {
+        return -1;
+    }
+    rc = flash_area_read(loc->fe_area, loc->fe_data_off, buf, len);
+    if (rc) {
+        return rc;
+    }
+    buf[len] = '\0';
+
+    rec->cbr_tag = buf[0];
+    if (!(rec->cbr_tag & CONF_FCB_BIN_VAL)) {
+        rc = conf_line_parse(buf, &rec->cbr_name, &rec->cbr_val);
+        if (rc) {
+            return rc;
+        }
+        rec->cbr_tag = CONF_FCB_BIN_TEXT;
+        rec->cbr_id = conf_name_hash(rec->cbr_name);
+        rec->cbr_val_len = rec->cbr_val ? strlen(rec->cbr_val) : 0;
+        return 0;
+    }
+    if (len < CONF_FCB_BIN_HDR) {
+        return -1;
+    }
+    rec->cbr_id = get_le32(&buf[1]);
+    if (rec->cbr_tag == CONF_FCB_BIN_NAME) {
+        rec->cbr_name = &buf[CONF_FCB_BIN_HDR];
+        rec->cbr_val = NULL;
+        rec->cbr_val_len = 0;
+    } else {
+        rec->cbr_name = NULL;
+        rec->cbr_val = &buf[CONF_FCB_BIN_HDR];
+        rec->cbr_val_len = len - CONF_FCB_BIN_HDR;
+    }
+    return 0;
+}
+
+static int
+conf_fcb_bin_has_name(struct conf_fcb_bin_rec *rec)
+{
+    return rec->cbr_tag == CONF_FCB_BIN_NAME ||
+      rec->cbr_tag == CONF_FCB_BIN_TEXT;
+}
+
+static int
+conf_fcb_bin_has_val(struct conf_fcb_bin_rec *rec)
+{
+    return rec->cbr_tag != CONF_FCB_BIN_NAME;
+}
+
+/*
+ * Value of record in string form.  *valp is set to NULL for an empty
+ * value; str is used for values which need to be formatted.
+ */
+static int
+conf_fcb_bin_val_str(struct conf_fcb_bin_rec *rec, char *str, int str_len,
+  char **valp)
+{
+    uint8_t *val;
+    long ival;
+
+    val = (uint8_t *)rec->cbr_val;
+    if (rec->cbr_tag == CONF_FCB_BIN_TEXT) {
+        *valp = rec->cbr_val;
+        return 0;
+    }
+    switch (rec->cbr_tag & CONF_FCB_BIN_TYPE_MASK) {
+    case CONF_NONE:
+        *valp = NULL;
+        return 0;
+    case CONF_INT8:
+        if (rec->cbr_val_len != 1) {
+            return -1;
+        }
+        ival = (int8_t)val[0];
+        break;
+    case CONF_INT16:
+        if (rec->cbr_val_len != 2) {
+            return -1;
+        }
+        ival = (int16_t)get_le16(val);
+        break;
+    case CONF_INT32:
+        if (rec->cbr_val_len != 4) {
+            return -1;
+        }
+        ival = (int32_t)get_le32(val);
+        break;
+    case CONF_STRING:
+        /* conf_fcb_bin_read() zero terminated it */
+        *valp = rec->cbr_val;
+        return 0;
+    case CONF_BYTES:
+        *valp = conf_str_from_bytes(val, rec->cbr_val_len, str, str_len);
+        return *valp ? 0 : -1;
+    default:
+        return -1;
+    }
+    snprintf(str, str_len, "%ld", ival);
+    *valp = str;
+    return 0;
+}
+
+/*
+ * Encode value record.  Returns length, or -1 if value does not fit.
+ */
+static int
+conf_fcb_bin_val_make(uint8_t *buf, int buf_len, uint32_t id,
+  const char *value)
+{
+    char str[CONF_MAX_VAL_LEN + 1];
+    uint8_t *val;
+    char *eptr;
+    long ival;
+    int len;
+
+    val = &buf[CONF_FCB_BIN_HDR];
+    put_le32(&buf[1], id);
+
+    if (!value || !value[0]) {
+        buf[0] = CONF_FCB_BIN_VAL | CONF_NONE;
+        return CONF_FCB_BIN_HDR;
+    }
+
+    len = strlen(value);
+    if (len > CONF_MAX_VAL_LEN || CONF_FCB_BIN_HDR + len > buf_len) {
+        return -1;
+    }
+
+    ival = strtol(value, &eptr, 10);
+    if (*eptr == '\0' && ival >= INT32_MIN && ival <= INT32_MAX) {
+        snprintf(str, sizeof(str), "%ld", ival);
+        if (!strcmp(str, value)) {
+            if (ival >= INT8_MIN && ival <= INT8_MAX) {
+                buf[0] = CONF_FCB_BIN_VAL | CONF_INT8;
+                val[0] = ival;
+                return CONF_FCB_BIN_HDR + 1;
+            } else if (ival >= INT16_MIN && ival <= INT16_MAX) {
+                buf[0] = CONF_FCB_BIN_VAL | CONF_INT16;
+                put_le16(val, ival);
+                return CONF_FCB_BIN_HDR + 2;
+            }
+            buf[0] = CONF_FCB_BIN_VAL | CONF_INT32;
+            put_le32(val, ival);
+            return CONF_FCB_BIN_HDR + 4;
+        }
+    }
+
+    /*
+     * Base64 encoded bytes stored as such, if they encode back to the
+     * same string.
+     */
+    strcpy(str, value);
+    len = buf_len - CONF_FCB_BIN_HDR;
+    if (conf_bytes_from_str(str, val, &len) == 0 &&
+      conf_str_from_bytes(val, len, str, sizeof(str)) &&
+      !strcmp(str, value)) {
+        buf[0] = CONF_FCB_BIN_VAL | CONF_BYTES;
+        return CONF_FCB_BIN_HDR + len;
+    }
+
+    len = strlen(value);
+    buf[0] = CONF_FCB_BIN_VAL | CONF_STRING;
+    memcpy(val, value, len);
+    return CONF_FCB_BIN_HDR + len;
+}
+
+static int
+conf_fcb_bin_name_make(uint8_t *buf, int buf_len, uint32_t id,
+  const char *name)
+{
+    int len;
+
+    len = strlen(name);
+    if (len > CONF_MAX_NAME_LEN || CONF_FCB_BIN_HDR + len > buf_len) {
+        return -1;
+    }
+    buf[0] = CONF_FCB_BIN_NAME;
+    put_le32(&buf[1], id);
+    memcpy(&buf[CONF_FCB_BIN_HDR], name, len);
+    return CONF_FCB_BIN_HDR + len;
+}
+
+/*
+ * Search for the next record after loc carrying the name (want_name) or
+ * the value for id.  loc must have fe_area NULL to search from the start.
+ */
+static int
+conf_fcb_bin_find(struct conf_fcb *cf, struct fcb_entry *loc, uint32_t id,
+  int want_name, char *buf)
+{
+    struct conf_fcb_bin_rec rec;
+
+    while (fcb_getnext(&cf->cf_fcb, loc) == 0) {
+        if (conf_fcb_bin_read(loc, buf, &rec) || rec.cbr_id != id) {
+            continue;
+        }
+        if (want_name ? conf_fcb_bin_has_name(&rec) :
+          conf_fcb_bin_has_val(&rec)) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+#if MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX) > 0
+/*
+ * Locations of the latest name and value records for each id.  Built on
+ * the heap for load and compression.
+ */
+struct conf_fcb_bin_idx {
+    uint32_t cbi_id;		/* 0 if slot is unused */
+    struct fcb_entry cbi_name;
+    struct fcb_entry cbi_val;	/* fe_area NULL if there's no value */
+};
+
+static struct conf_fcb_bin_idx *
+conf_fcb_bin_idx_slot(struct conf_fcb_bin_idx *idx, uint32_t id)
+{
+    struct conf_fcb_bin_idx *cbi;
+    int i;
+    int j;
+
+    j = id % MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX);
+    for (i = 0; i < MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX); i++) {
+        cbi = &idx[j];
+        if (cbi->cbi_id == 0 || cbi->cbi_id == id) {
+            return cbi;
+        }
+        if (++j == MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX)) {
+            j = 0;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Returns NULL if there are more distinct ids than fit in the index.
+ */
+static struct conf_fcb_bin_idx *
+conf_fcb_bin_idx_build(struct conf_fcb *cf, char *buf)
+{
+    struct conf_fcb_bin_idx *idx;
+    struct conf_fcb_bin_idx *cbi;
+    struct conf_fcb_bin_rec rec;
+    struct fcb_entry loc;
+
+    idx = calloc(MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX), sizeof(*idx));
+    if (!idx) {
+        return NULL;
+    }
+    loc.fe_area = NULL;
+    loc.fe_elem_off = 0;
+    while (fcb_getnext(&cf->cf_fcb, &loc) == 0) {
+        if (conf_fcb_bin_read(&loc, buf, &rec)) {
+            continue;
+        }
+        cbi = conf_fcb_bin_idx_slot(idx, rec.cbr_id);
+        if (!cbi) {
+            free(idx);
+            return NULL;
+        }
+        cbi->cbi_id = rec.cbr_id;
+        if (conf_fcb_bin_has_name(&rec)) {
+            cbi->cbi_name = loc;
+        }
+        if (conf_fcb_bin_has_val(&rec)) {
+            cbi->cbi_val = loc;
+        }
+    }
+    return idx;
+}
+#endif
+
+/*
+ * Deliver the setting whose name is in record name_loc and value in
+ * record val_loc.
+ */
+static void
+conf_fcb_bin_deliver(struct fcb_entry *name_loc, struct fcb_entry *val_loc,
+  char *buf, load_cb cb, void *cb_arg)
+{
+    char name[CONF_MAX_NAME_LEN + 1];
+    char str[CONF_MAX_VAL_LEN + 1];
+    struct conf_fcb_bin_rec rec;
+    char *val;
+
+    if (conf_fcb_bin_read(name_loc, buf, &rec) ||
+      strlen(rec.cbr_name) > CONF_MAX_NAME_LEN) {
+        return;
+    }
+    strcpy(name, rec.cbr_name);
+    if (conf_fcb_bin_read(val_loc, buf, &rec) ||
+      conf_fcb_bin_val_str(&rec, str, sizeof(str), &val)) {
+        return;
+    }
+    cb(name, val, cb_arg);
+}
+
+static int
+conf_fcb_bin_load(struct conf_store *cs, load_cb cb, void *cb_arg)
+{
+    struct conf_fcb *cf = (struct conf_fcb *)cs;
+    char buf[CONF_FCB_BIN_BUF];
+    struct conf_fcb_bin_rec rec;
+    struct fcb_entry name_loc;
+    struct fcb_entry loc;
+#if MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX) > 0
+    struct conf_fcb_bin_idx *idx;
+    struct conf_fcb_bin_idx *cbi;
+    int i;
+
+    /*
+     * Only the latest value of each setting is read.
+     */
+    idx = conf_fcb_bin_idx_build(cf, buf);
+    if (idx) {
+        for (i = 0; i < MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX); i++) {
+            cbi = &idx[i];
+            if (cbi->cbi_id == 0 || !cbi->cbi_val.fe_area ||
+              !cbi->cbi_name.fe_area) {
+                continue;
+            }
+            conf_fcb_bin_deliver(&cbi->cbi_name, &cbi->cbi_val, buf,
+              cb, cb_arg);
+        }
+        free(idx);
+        return OS_OK;
+    }
+#endif
+
+    /*
+     * Every value in FCB order, later ones overriding the earlier.
+     */
+    loc.fe_area = NULL;
+    loc.fe_elem_off = 0;
+    while (fcb_getnext(&cf->cf_fcb, &loc) == 0) {
+        if (conf_fcb_bin_read(&loc, buf, &rec)) {
+            continue;
+        }
+        if (rec.cbr_tag == CONF_FCB_BIN_TEXT) {
+            conf_fcb_bin_deliver(&loc, &loc, buf, cb, cb_arg);
+        } else if (rec.cbr_tag != CONF_FCB_BIN_NAME) {
+            name_loc.fe_area = NULL;
+            name_loc.fe_elem_off = 0;
+            if (conf_fcb_bin_find(cf, &name_loc, rec.cbr_id, 1, buf) == 0) {
+                conf_fcb_bin_deliver(&name_loc, &loc, buf, cb, cb_arg);
+            }
+        }
+    }
+    return OS_OK;
+}
+
+static int
+conf_fcb_bin_write(struct conf_fcb *cf, uint8_t *buf, int len)
+{
+    struct fcb_entry loc;
+    int rc;
+
+    rc = fcb_append(&cf->cf_fcb, len, &loc);
+    if (rc) {
+        return rc;
+    }
+    rc = flash_area_write(loc.fe_area, loc.fe_data_off, buf, len);
+    if (rc) {
+        return rc;
+    }
+    return fcb_append_finish(&cf->cf_fcb, &loc);
+}
+
+static int
+conf_fcb_bin_is_latest(struct conf_fcb *cf, void *idx, struct fcb_entry *loc,
+  uint32_t id, int want_name, char *buf)
+{
+    struct fcb_entry loc2;
+#if MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX) > 0
+    struct conf_fcb_bin_idx *cbi;
+
+    if (idx) {
+        cbi = conf_fcb_bin_idx_slot(idx, id);
+        if (cbi && cbi->cbi_id == id) {
+            loc2 = want_name ? cbi->cbi_name : cbi->cbi_val;
+            return loc2.fe_area == loc->fe_area &&
+              loc2.fe_elem_off == loc->fe_elem_off;
+        }
+    }
+#endif
+    loc2 = *loc;
+    return conf_fcb_bin_find(cf, &loc2, id, want_name, buf) != 0;
+}
+
+/*
+ * Copy the latest name and value records from the oldest sector, and
+ * rotate it out.  Text records are written back as binary.
+ */
+static void
+conf_fcb_bin_compress(struct conf_fcb *cf)
+{
+    char buf1[CONF_FCB_BIN_BUF];
+    char buf2[CONF_FCB_BIN_BUF];
+    uint8_t out[CONF_FCB_BIN_BUF];
+    struct conf_fcb_bin_rec rec;
+    struct fcb_entry loc;
+    void *idx;
+    int len;
+    int rc;
+
+#if MYNEWT_VAL(CONFIG_FCB_COMPRESS_INDEX) > 0
+    idx = conf_fcb_bin_idx_build(cf, buf2);
+#else
+    idx = NULL;
+#endif
+
+    rc = fcb_append_to_scratch(&cf->cf_fcb);
+    if (rc) {
+        free(idx);
+        return; /* XXX */
+    }
+
+    loc.fe_area = NULL;
+    loc.fe_elem_off = 0;
+    while (fcb_getnext(&cf->cf_fcb, &loc) == 0) {
+        if (loc.fe_area != cf->cf_fcb.f_oldest) {
+            break;
+        }
+        if (conf_fcb_bin_read(&loc, buf1, &rec)) {
+            continue;
+        }
+        if (conf_fcb_bin_has_name(&rec) &&
+          conf_fcb_bin_is_latest(cf, idx, &loc, rec.cbr_id, 1, buf2)) {
+            len = conf_fcb_bin_name_make(out, sizeof(out), rec.cbr_id,
+              rec.cbr_name);
+            if (len > 0) {
+                conf_fcb_bin_write(cf, out, len);
+            }
+        }
+        if (conf_fcb_bin_has_val(&rec) &&
+          conf_fcb_bin_is_latest(cf, idx, &loc, rec.cbr_id, 0, buf2)) {
+            if (rec.cbr_tag == CONF_FCB_BIN_TEXT) {
+                len = conf_fcb_bin_val_make(out, sizeof(out), rec.cbr_id,
+                  rec.cbr_val);
+            } else {
+                len = loc.fe_data_len;
+                memcpy(out, buf1, len);
+            }
+            if (len > 0) {
+                conf_fcb_bin_write(cf, out, len);
+            }
+        }
+    }
+    free(idx);
+    rc = fcb_rotate(&cf->cf_fcb);
+    if (rc) {
+        /* XXXX */
+        ;
+    }
+}
+
+static int
+conf_fcb_bin_append(struct conf_fcb *cf, uint8_t *buf, int len)
+{
+    int rc;
+    int i;
+
+    for (i = 0; i < 10; i++) {
+        rc = conf_fcb_bin_write(cf, buf, len);
+        if (rc != FCB_ERR_NOSPACE) {
+            break;
+        }
+        conf_fcb_bin_compress(cf);
+    }
+    if (rc) {
+        return OS_EINVAL;
+    }
+    return OS_OK;
+}
+
+static int
+conf_fcb_bin_save(struct conf_store *cs, const char *name, const char *value)
+{
+    struct conf_fcb *cf = (struct conf_fcb *)cs;
+    uint8_t buf[CONF_FCB_BIN_BUF];
+    struct conf_fcb_bin_rec rec;
+    struct fcb_entry loc;
+    uint32_t id;
+    int len;
+    int rc;
+
+    if (!name) {
+        return OS_INVALID_PARM;
+    }
+    id = conf_name_hash(name);
+
+    /*
+     * Name goes in once per id.  Compression keeps the latest name record
+     * for every id, so it stays around for the value written next.
+     */
+    loc.fe_area = NULL;
+    loc.fe_elem_off = 0;
+    rc = conf_fcb_bin_find(cf, &loc, id, 1, (char *)buf);
+    if (rc == 0) {
+        conf_fcb_bin_read(&loc, (char *)buf, &rec);
+        if (strcmp(rec.cbr_name, name)) {
+            /* Different name, same id. */
+            return OS_EINVAL;
+        }
+    } else {
+        len = conf_fcb_bin_name_make(buf, sizeof(buf), id, name);
+        if (len < 0) {
+            return OS_INVALID_PARM;
+        }
+        rc = conf_fcb_bin_append(cf, buf, len);
+        if (rc) {
+            return rc;
+        }
+    }
+
+    len = conf_fcb_bin_val_make(buf, sizeof(buf), id, value);
+    if (len < 0) {
+        return OS_INVALID_PARM;
+    }
+    return conf_fcb_bin_append(cf, buf, len);
+}
+
+#endif
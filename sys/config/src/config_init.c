@@ -51,6 +51,14 @@ config_init_fs(void)
 #include "fcb/fcb.h"
 #include "config/config_fcb.h"
 
+#if MYNEWT_VAL(CONFIG_FCB_BINARY)
+#define CONFIG_INIT_FCB_SRC conf_fcb_bin_src
+#define CONFIG_INIT_FCB_DST conf_fcb_bin_dst
+#else
+#define CONFIG_INIT_FCB_SRC conf_fcb_src
+#define CONFIG_INIT_FCB_DST conf_fcb_dst
+#endif
+
 static struct flash_area conf_fcb_area[NFFS_AREA_MAX + 1];
 
 static struct conf_fcb config_init_conf_fcb = {
@@ -73,7 +81,7 @@ config_init_fcb(void)
 
     config_init_conf_fcb.cf_fcb.f_sector_cnt = cnt;
 
-    rc = conf_fcb_src(&config_init_conf_fcb);
+    rc = CONFIG_INIT_FCB_SRC(&config_init_conf_fcb);
     if (rc) {
         for (cnt = 0;
              cnt < config_init_conf_fcb.cf_fcb.f_sector_cnt;
@@ -82,10 +90,10 @@ config_init_fcb(void)
             flash_area_erase(&conf_fcb_area[cnt], 0,
                              conf_fcb_area[cnt].fa_size);
         }
-        rc = conf_fcb_src(&config_init_conf_fcb);
+        rc = CONFIG_INIT_FCB_SRC(&config_init_conf_fcb);
     }
     SYSINIT_PANIC_ASSERT(rc == 0);
-    rc = conf_fcb_dst(&config_init_conf_fcb);
+    rc = CONFIG_INIT_FCB_DST(&config_init_conf_fcb);
     SYSINIT_PANIC_ASSERT(rc == 0);
 }
 
@@ -46,6 +46,14 @@ struct conf_store_itf {
     int (*csi_save_end)(struct conf_store *cs);
 };
 
+uint32_t conf_name_hash(const char *name);
+struct conf_handler *conf_handler_lookup(char *name);
+struct conf_handler *conf_handler_of(const char *name);
+void conf_load_lazy(struct conf_handler *ch);
+
+struct conf_fcb;
+int conf_fcb_init(struct conf_fcb *cf);
+
 void conf_src_register(struct conf_store *cs);
 void conf_dst_register(struct conf_store *cs);
 
@@ -19,8 +19,10 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include <os/os.h>
+#include <syscfg/syscfg.h>
 
 #include "config/config.h"
 #include "config_priv.h"
@@ -34,6 +36,26 @@ struct conf_dup_check_arg {
 struct conf_store_head conf_load_srcs;
 struct conf_store *conf_save_dst;
 
+#if MYNEWT_VAL(CONFIG_SAVE_DEFER) > 0
+/*
+ * Write-behind cache.  Holds the stored value of settings, so that
+ * conf_save_one() can detect duplicates without reading the store, and
+ * changes which have not been written out yet.  Filled from conf_save_dst
+ * on first save.  Names which don't fit go straight to the store.
+ */
+struct conf_save_ent {
+    uint32_t cse_hash;          /* 0 if slot is unused */
+    uint8_t cse_dirty;
+    char *cse_name;             /* name and value in one allocation */
+    char *cse_val;              /* NULL for empty value */
+};
+
+static struct conf_save_ent conf_save_cache[MYNEWT_VAL(CONFIG_SAVE_DEFER)];
+static uint8_t conf_save_cache_filled;
+static uint8_t conf_save_cache_full;
+static struct os_callout conf_save_callout;
+#endif
+
 void
 conf_src_register(struct conf_store *cs)
 {
@@ -50,15 +72,231 @@ conf_src_register(struct conf_store *cs)
     }
 }
 
+#if MYNEWT_VAL(CONFIG_SAVE_DEFER) > 0
+static void
+conf_save_cache_clear(void)
+{
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(CONFIG_SAVE_DEFER); i++) {
+        free(conf_save_cache[i].cse_name);
+    }
+    memset(conf_save_cache, 0, sizeof(conf_save_cache));
+    conf_save_cache_filled = 0;
+    conf_save_cache_full = 0;
+}
+
+/*
+ * Slot for name; unused slot if alloc is set and name is not there.
+ */
+static struct conf_save_ent *
+conf_save_cache_find(const char *name, uint32_t hash, int alloc)
+{
+    struct conf_save_ent *cse;
+    struct conf_save_ent *unused;
+    int i;
+
+    unused = NULL;
+    for (i = 0; i < MYNEWT_VAL(CONFIG_SAVE_DEFER); i++) {
+        cse = &conf_save_cache[i];
+        if (cse->cse_hash == hash && !strcmp(cse->cse_name, name)) {
+            return cse;
+        }
+        if (cse->cse_hash == 0 && !unused) {
+            unused = cse;
+        }
+    }
+    return alloc ? unused : NULL;
+}
+
+static int
+conf_save_cache_set(struct conf_save_ent *cse, uint32_t hash,
+  const char *name, const char *val)
+{
+    int nlen;
+    int vlen;
+    char *p;
+
+    nlen = strlen(name) + 1;
+    vlen = (val && val[0]) ? strlen(val) + 1 : 0;
+    p = malloc(nlen + vlen);
+    if (!p) {
+        return OS_ENOMEM;
+    }
+    memcpy(p, name, nlen);
+    if (vlen) {
+        memcpy(p + nlen, val, vlen);
+    }
+    free(cse->cse_name);
+    cse->cse_hash = hash;
+    cse->cse_name = p;
+    cse->cse_val = vlen ? p + nlen : NULL;
+    return 0;
+}
+
+static int
+conf_save_cache_same(struct conf_save_ent *cse, const char *val)
+{
+    if (!val || val[0] == '\0') {
+        return cse->cse_val == NULL;
+    }
+    return cse->cse_val && !strcmp(cse->cse_val, val);
+}
+
+static void
+conf_save_cache_fill_cb(char *name, char *val, void *cb_arg)
+{
+    struct conf_save_ent *cse;
+    uint32_t hash;
+
+    hash = conf_name_hash(name);
+    cse = conf_save_cache_find(name, hash, 1);
+    if (!cse || conf_save_cache_set(cse, hash, name, val)) {
+        if (cse && cse->cse_hash) {
+            /* Stale now. */
+            free(cse->cse_name);
+            memset(cse, 0, sizeof(*cse));
+        }
+        conf_save_cache_full = 1;
+    }
+}
+
+static void
+conf_save_tmo(struct os_event *ev)
+{
+    conf_save_flush();
+}
+
+/*
+ * Returns OS_ENOENT if the setting has to be written directly.
+ */
+static int
+conf_save_defer(struct conf_store *cs, const char *name, char *value)
+{
+    struct conf_save_ent *cse;
+    uint32_t hash;
+    uint32_t ticks;
+
+    if (!conf_save_cache_filled) {
+        conf_save_cache_filled = 1;
+        cs->cs_itf->csi_load(cs, conf_save_cache_fill_cb, NULL);
+    }
+
+    hash = conf_name_hash(name);
+    cse = conf_save_cache_find(name, hash, !conf_save_cache_full);
+    if (!cse) {
+        return OS_ENOENT;
+    }
+    if (cse->cse_hash && conf_save_cache_same(cse, value)) {
+        return 0;
+    }
+    if (conf_save_cache_set(cse, hash, name, value)) {
+        if (cse->cse_hash) {
+            /*
+             * Value going to the store directly; forget the old one.
+             */
+            free(cse->cse_name);
+            memset(cse, 0, sizeof(*cse));
+            conf_save_cache_full = 1;
+        }
+        return OS_ENOENT;
+    }
+    cse->cse_dirty = 1;
+
+    if (!os_callout_queued(&conf_save_callout)) {
+        os_time_ms_to_ticks(MYNEWT_VAL(CONFIG_SAVE_DEFER_MS), &ticks);
+        os_callout_reset(&conf_save_callout, ticks);
+    }
+    return 0;
+}
+#endif
+
+/*
+ * Write out changes held back by CONFIG_SAVE_DEFER.  Called periodically,
+ * from conf_save(), and should be called before a planned reset.
+ */
+int
+conf_save_flush(void)
+{
+#if MYNEWT_VAL(CONFIG_SAVE_DEFER) > 0
+    struct conf_store *cs;
+    struct conf_save_ent *cse;
+    int started;
+    int rc;
+    int rc2;
+    int i;
+
+    cs = conf_save_dst;
+    if (!cs) {
+        return OS_ENOENT;
+    }
+    os_callout_stop(&conf_save_callout);
+
+    rc = 0;
+    started = 0;
+    for (i = 0; i < MYNEWT_VAL(CONFIG_SAVE_DEFER); i++) {
+        cse = &conf_save_cache[i];
+        if (!cse->cse_dirty) {
+            continue;
+        }
+        if (!started && cs->cs_itf->csi_save_start) {
+            cs->cs_itf->csi_save_start(cs);
+        }
+        started = 1;
+        rc2 = cs->cs_itf->csi_save(cs, cse->cse_name, cse->cse_val);
+        if (rc2) {
+            if (!rc) {
+                rc = rc2;
+            }
+            continue;
+        }
+        cse->cse_dirty = 0;
+    }
+    if (started && cs->cs_itf->csi_save_end) {
+        cs->cs_itf->csi_save_end(cs);
+    }
+    return rc;
+#else
+    return 0;
+#endif
+}
+
 void
 conf_dst_register(struct conf_store *cs)
 {
     conf_save_dst = cs;
+#if MYNEWT_VAL(CONFIG_SAVE_DEFER) > 0
+    /*
+     * Cache is for the previous store; pending changes are dropped.
+     */
+    os_callout_stop(&conf_save_callout);
+    conf_save_cache_clear();
+#endif
 }
 
+/*
+ * cb_arg is the handler being loaded, or NULL when loading everything
+ * except lazy handlers which have not been used yet.
+ */
 static void
 conf_load_cb(char *name, char *val, void *cb_arg)
 {
+#if MYNEWT_VAL(CONFIG_LAZY_LOAD)
+    struct conf_handler *ch;
+
+    ch = conf_handler_of(name);
+    if (!ch) {
+        return;
+    }
+    if (cb_arg) {
+        if (ch != cb_arg) {
+            return;
+        }
+    } else if ((ch->ch_flags & (CONF_HANDLER_F_LAZY | CONF_HANDLER_F_LOADED))
+      == CONF_HANDLER_F_LAZY) {
+        return;
+    }
+#endif
     conf_set_value(name, val);
 }
 
@@ -80,6 +318,42 @@ conf_load(void)
     return conf_commit(NULL);
 }
 
+/*
+ * Load and commit settings of one handler only.  Handlers with
+ * CONF_HANDLER_F_LAZY are skipped by conf_load(); they are loaded here
+ * either explicitly, or on first conf_get_value() or conf_save().
+ */
+int
+conf_load_subtree(char *name)
+{
+    struct conf_handler *ch;
+    struct conf_store *cs;
+
+    ch = conf_handler_of(name);
+    if (!ch) {
+        return OS_ENOENT;
+    }
+    ch->ch_flags |= CONF_HANDLER_F_LOADED;
+    SLIST_FOREACH(cs, &conf_load_srcs, cs_next) {
+        cs->cs_itf->csi_load(cs, conf_load_cb, ch);
+    }
+    if (ch->ch_commit) {
+        return ch->ch_commit();
+    }
+    return 0;
+}
+
+void
+conf_load_lazy(struct conf_handler *ch)
+{
+#if MYNEWT_VAL(CONFIG_LAZY_LOAD)
+    if ((ch->ch_flags & (CONF_HANDLER_F_LAZY | CONF_HANDLER_F_LOADED)) ==
+      CONF_HANDLER_F_LAZY) {
+        conf_load_subtree(ch->ch_name);
+    }
+#endif
+}
+
 static void
 conf_dup_check_cb(char *name, char *val, void *cb_arg)
 {
@@ -111,12 +385,22 @@ conf_save_one(const char *name, char *value)
 {
     struct conf_store *cs;
     struct conf_dup_check_arg cdca;
+#if MYNEWT_VAL(CONFIG_SAVE_DEFER) > 0
+    int rc;
+#endif
 
     cs = conf_save_dst;
     if (!cs) {
         return OS_ENOENT;
     }
 
+#if MYNEWT_VAL(CONFIG_SAVE_DEFER) > 0
+    rc = conf_save_defer(cs, name, value);
+    if (rc != OS_ENOENT) {
+        return rc;
+    }
+#endif
+
     /*
      * Check if we're writing the same value again.
      */
@@ -153,6 +437,13 @@ conf_save(void)
         return OS_ENOENT;
     }
 
+    /*
+     * Don't overwrite stored values with defaults.
+     */
+    SLIST_FOREACH(ch, &conf_handlers, ch_list) {
+        conf_load_lazy(ch);
+    }
+
     if (cs->cs_itf->csi_save_start) {
         cs->cs_itf->csi_save_start(cs);
     }
@@ -168,6 +459,10 @@ conf_save(void)
     if (cs->cs_itf->csi_save_end) {
         cs->cs_itf->csi_save_end(cs);
     }
+    rc2 = conf_save_flush();
+    if (!rc) {
+        rc = rc2;
+    }
     return rc;
 }
 
@@ -175,4 +470,8 @@ void
 conf_store_init(void)
 {
     SLIST_INIT(&conf_load_srcs);
+#if MYNEWT_VAL(CONFIG_SAVE_DEFER) > 0
+    os_callout_init(&conf_save_callout, os_eventq_dflt_get(), conf_save_tmo,
+      NULL);
+#endif
 }
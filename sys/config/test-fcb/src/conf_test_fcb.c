@@ -314,6 +314,8 @@ TEST_CASE_DECL(config_test_insert3)
 TEST_CASE_DECL(config_test_save_3_fcb)
 TEST_CASE_DECL(config_test_compress_reset)
 TEST_CASE_DECL(config_test_save_one_fcb)
+TEST_CASE_DECL(config_test_save_bin_fcb)
+TEST_CASE_DECL(config_test_lazy_load)
 
 TEST_SUITE(config_test_all)
 {
@@ -344,6 +346,10 @@ TEST_SUITE(config_test_all)
     config_test_compress_reset();
 
     config_test_save_one_fcb();
+
+    config_test_save_bin_fcb();
+
+    config_test_lazy_load();
 }
 
 #if MYNEWT_VAL(SELFTEST)
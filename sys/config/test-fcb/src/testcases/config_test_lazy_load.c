@@ -0,0 +1,105 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "conf_test_fcb.h"
+
+static int lazy_val;
+static int lazy_set_called;
+
+static char *
+lazy_handle_get(int argc, char **argv, char *val, int val_len_max)
+{
+    return conf_str_from_value(CONF_INT32, &lazy_val, val, val_len_max);
+}
+
+static int
+lazy_handle_set(int argc, char **argv, char *val)
+{
+    lazy_set_called++;
+    return CONF_VALUE_SET(val, CONF_INT32, lazy_val);
+}
+
+static struct conf_handler lazy_test_handler = {
+    .ch_name = "lazy",
+    .ch_get = lazy_handle_get,
+    .ch_set = lazy_handle_set,
+    .ch_flags = CONF_HANDLER_F_LAZY
+};
+
+TEST_CASE(config_test_lazy_load)
+{
+    char name[16];
+    char buf[16];
+    char *str;
+    int rc;
+    struct conf_fcb cf;
+
+    config_wipe_srcs();
+    config_wipe_fcb(fcb_areas, sizeof(fcb_areas) / sizeof(fcb_areas[0]));
+
+    cf.cf_fcb.f_magic = MYNEWT_VAL(CONFIG_FCB_MAGIC);
+    cf.cf_fcb.f_sectors = fcb_areas;
+    cf.cf_fcb.f_sector_cnt = sizeof(fcb_areas) / sizeof(fcb_areas[0]);
+
+    rc = conf_fcb_src(&cf);
+    TEST_ASSERT(rc == 0);
+
+    rc = conf_fcb_dst(&cf);
+    TEST_ASSERT(rc == 0);
+
+    rc = conf_register(&lazy_test_handler);
+    TEST_ASSERT(rc == 0);
+
+    rc = conf_save_one("lazy/val", "5");
+    TEST_ASSERT(rc == 0);
+
+    /*
+     * Not loaded at boot.
+     */
+    lazy_val = 0;
+    lazy_set_called = 0;
+    rc = conf_load();
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(lazy_set_called == 0);
+
+    /*
+     * First read loads it, later ones don't.
+     */
+    strcpy(name, "lazy/val");
+    str = conf_get_value(name, buf, sizeof(buf));
+    TEST_ASSERT(str && !strcmp(str, "5"));
+    TEST_ASSERT(lazy_set_called == 1);
+
+    strcpy(name, "lazy/val");
+    str = conf_get_value(name, buf, sizeof(buf));
+    TEST_ASSERT(str && !strcmp(str, "5"));
+    TEST_ASSERT(lazy_set_called == 1);
+
+    /*
+     * Explicit load.
+     */
+    lazy_val = 0;
+    strcpy(name, "lazy");
+    rc = conf_load_subtree(name);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(lazy_val == 5);
+
+    strcpy(name, "nosuch");
+    rc = conf_load_subtree(name);
+    TEST_ASSERT(rc == OS_ENOENT);
+}
@@ -58,6 +58,11 @@ int console_handle_char(uint8_t byte);
 extern int console_is_midline;
 extern int console_out(int character);
 
+#if MYNEWT_VAL(CONSOLE_RTT) && MYNEWT_VAL(CONSOLE_RTT_DROP)
+/* Number of writes dropped because RTT output buffer was full. */
+uint32_t rtt_console_drop_cnt(void);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
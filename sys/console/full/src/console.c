@@ -92,6 +92,9 @@ console_echo(int on)
 void
 console_write(const char *str, int cnt)
 {
+#if MYNEWT_VAL(CONSOLE_UART)
+    uart_console_write(str, cnt);
+#else
     int i;
 
     for (i = 0; i < cnt; i++) {
@@ -99,6 +102,7 @@ console_write(const char *str, int cnt)
             break;
         }
     }
+#endif
 }
 
 #if MYNEWT_VAL(CONSOLE_COMPAT)
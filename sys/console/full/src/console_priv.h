@@ -28,6 +28,7 @@ int uart_console_is_init(void);
 int uart_console_init(void);
 void uart_console_blocking_mode(void);
 void uart_console_non_blocking_mode(void);
+void uart_console_write(const char *str, int cnt);
 int rtt_console_is_init(void);
 int rtt_console_init(void);
 
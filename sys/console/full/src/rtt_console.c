@@ -32,21 +32,50 @@
 static struct hal_timer rtt_timer;
 #endif
 
-static const char CR = '\r';
+#if MYNEWT_VAL(CONSOLE_RTT_DROP)
+static uint32_t rtt_console_drops;
+
+/*
+ * Output which doesn't fit is dropped, instead of overwriting data host has
+ * not read yet.
+ */
+static void
+rtt_console_write(const char *data, int len)
+{
+    if (SEGGER_RTT_WriteSkipNoLock(0, data, len) == 0) {
+        rtt_console_drops++;
+    }
+}
+
+uint32_t
+rtt_console_drop_cnt(void)
+{
+    return rtt_console_drops;
+}
+#else
+static void
+rtt_console_write(const char *data, int len)
+{
+    SEGGER_RTT_WriteWithOverwriteNoLock(0, data, len);
+}
+#endif
 
 int
 console_out(int character)
 {
+    static const char crlf[] = { '\r', '\n' };
     char c = (char)character;
+    int sr;
 
+    OS_ENTER_CRITICAL(sr);
     if ('\n' == c) {
-        SEGGER_RTT_WriteWithOverwriteNoLock(0, &CR, 1);
+        rtt_console_write(crlf, sizeof(crlf));
         console_is_midline = 0;
     } else {
+        rtt_console_write(&c, 1);
         console_is_midline = 1;
     }
-
-    SEGGER_RTT_WriteWithOverwriteNoLock(0, &c, 1);
+    OS_EXIT_CRITICAL(sr);
 
     return character;
 }
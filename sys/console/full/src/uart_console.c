@@ -41,12 +41,24 @@ typedef void (*console_write_char)(struct uart_dev*, uint8_t);
 static console_write_char write_char_cb;
 
 struct console_ring {
-    uint8_t cr_head;
-    uint8_t cr_tail;
+    uint16_t cr_head;
+    uint16_t cr_tail;
     uint16_t cr_size;
+    uint16_t cr_tx_len;         /* Bytes before tail given to driver */
     uint8_t *cr_buf;
 };
 
+/*
+ * Ring is full when head would reach the start of data still owned by
+ * the UART driver.
+ */
+static int
+console_ring_full(struct console_ring *cr)
+{
+    return CONSOLE_HEAD_INC(cr) ==
+      ((cr->cr_tail - cr->cr_tx_len) & (cr->cr_size - 1));
+}
+
 static void
 console_add_char(struct console_ring *cr, char ch)
 {
@@ -70,7 +82,7 @@ console_queue_char(struct uart_dev *uart_dev, uint8_t ch)
     int sr;
 
     OS_ENTER_CRITICAL(sr);
-    while (CONSOLE_HEAD_INC(&cr_tx) == cr_tx.cr_tail) {
+    while (console_ring_full(&cr_tx)) {
         /* TX needs to drain */
         uart_start_tx(uart_dev);
         OS_EXIT_CRITICAL(sr);
@@ -145,6 +157,27 @@ console_out(int c)
     return c;
 }
 
+/*
+ * Queues a block of characters, kicking the transmitter once at the end
+ * instead of after every character.
+ */
+void
+uart_console_write(const char *str, int cnt)
+{
+    int i;
+
+    for (i = 0; i < cnt; i++) {
+        if ('\n' == str[i]) {
+            write_char_cb(uart_dev, '\r');
+            console_is_midline = 0;
+        } else {
+            console_is_midline = 1;
+        }
+        write_char_cb(uart_dev, str[i]);
+    }
+    uart_start_tx(uart_dev);
+}
+
 /*
  * Interrupts disabled when console_tx_char/console_rx_char are called.
  * Characters sent only in blocking mode.
@@ -161,6 +194,34 @@ console_tx_char(void *arg)
     return console_pull_char(&cr_tx);
 }
 
+/*
+ * Interrupts disabled when called.  Hands the driver the contiguous part of
+ * queued data, which driver then transmits directly from the ring.
+ */
+static int
+console_tx_buf(void *arg, uint8_t **data, int max)
+{
+    int len;
+
+    /* Previous block has been sent. */
+    cr_tx.cr_tx_len = 0;
+    if (cr_tx.cr_head == cr_tx.cr_tail) {
+        return 0;
+    }
+    if (cr_tx.cr_head > cr_tx.cr_tail) {
+        len = cr_tx.cr_head - cr_tx.cr_tail;
+    } else {
+        len = cr_tx.cr_size - cr_tx.cr_tail;
+    }
+    if (len > max) {
+        len = max;
+    }
+    *data = &cr_tx.cr_buf[cr_tx.cr_tail];
+    cr_tx.cr_tail = (cr_tx.cr_tail + len) & (cr_tx.cr_size - 1);
+    cr_tx.cr_tx_len = len;
+    return len;
+}
+
 /*
  * Interrupts disabled when console_tx_char/console_rx_char are called.
  */
@@ -170,6 +231,23 @@ console_rx_char(void *arg, uint8_t byte)
     return console_handle_char(byte);
 }
 
+/*
+ * Interrupts disabled when called.  Block of data from UARTs that receive
+ * with DMA; stops at the first character console can't take.
+ */
+static int
+console_rx_buf(void *arg, uint8_t *data, int len)
+{
+    int i;
+
+    for (i = 0; i < len; i++) {
+        if (console_handle_char(data[i]) < 0) {
+            break;
+        }
+    }
+    return i;
+}
+
 int
 uart_console_is_init(void)
 {
@@ -187,6 +265,8 @@ uart_console_init(void)
         .uc_flow_ctl = MYNEWT_VAL(CONSOLE_UART_FLOW_CONTROL),
         .uc_tx_char = console_tx_char,
         .uc_rx_char = console_rx_char,
+        .uc_tx_buf = console_tx_buf,
+        .uc_rx_buf = console_rx_buf,
     };
 
     cr_tx.cr_size = MYNEWT_VAL(CONSOLE_UART_TX_BUF_SIZE);
@@ -25,6 +25,7 @@ extern "C" {
 #endif
 
 #include <inttypes.h>
+#include "syscfg/syscfg.h"
 
 #define COREDUMP_MAGIC              0x690c47c3
 
@@ -34,6 +35,19 @@ extern "C" {
 #define COREDUMP_TLV_IMAGE          1   /* SHA256 of image creating this */
 #define COREDUMP_TLV_MEM            2   /* Memory dump */
 #define COREDUMP_TLV_REGS           3   /* CPU registers */
+#define COREDUMP_TLV_MEM_RLE        4   /* Run-length encoded memory dump */
+
+/*
+ * COREDUMP_TLV_MEM_RLE data is a sequence of control bytes, each followed
+ * by data. If COREDUMP_RLE_RUN bit is set, the next byte is repeated
+ * (ctrl & ~COREDUMP_RLE_RUN) + COREDUMP_RLE_RUN_MIN times. Otherwise
+ * ctrl + 1 bytes of literal data follow. ct_off is the address of the
+ * uncompressed memory.
+ */
+#define COREDUMP_RLE_RUN            0x80
+#define COREDUMP_RLE_RUN_MIN        3
+#define COREDUMP_RLE_RUN_MAX        (0x7f + COREDUMP_RLE_RUN_MIN)
+#define COREDUMP_RLE_LIT_MAX        0x80
 
 struct coredump_tlv {
     uint8_t ct_type;
@@ -52,6 +66,15 @@ struct coredump_header {
 
 void coredump_dump(void *regs, int regs_sz);
 
+#if MYNEWT_VAL(COREDUMP_SKIP_REGIONS) > 0
+/*
+ * Leave memory region out of coredumps, e.g. large data buffers like
+ * msys pools. Returns -1 if COREDUMP_SKIP_REGIONS entries have already
+ * been registered.
+ */
+int coredump_skip_region(const void *start, uint32_t size);
+#endif
+
 /*
  * Set this to non-zero to prevent coredump from taking place.
  */
@@ -18,31 +18,335 @@
  */
 
 #include <stddef.h>
+#include <string.h>
 #include <limits.h>
 #include "syscfg/syscfg.h"
 #include "sysflash/sysflash.h"
 #include "hal/hal_bsp.h"
+#include "hal/hal_flash_int.h"
+#include "hal/hal_watchdog.h"
 #include "flash_map/flash_map.h"
 #include "bootutil/image.h"
 #include "imgmgr/imgmgr.h"
 #include "coredump/coredump.h"
 
+/*
+ * Max amount of memory in one MEM TLV.
+ */
+#define COREDUMP_CHUNK_MAX          (SHRT_MAX + 1)
+
 uint8_t coredump_disabled;
 
+/*
+ * State of the corefile being written. Small writes (TLV headers,
+ * compressed data) are gathered into cs_buf; flash is erased one sector at
+ * a time just before it gets written, and sectors which are already blank
+ * are left alone.
+ */
+struct coredump_state {
+    const struct flash_area *cs_fa;
+    uint32_t cs_off;                    /* flash offset of cs_buf[0] */
+    uint32_t cs_erased_off;             /* flash erased up to here */
+    int cs_rc;
+    uint16_t cs_buf_len;
+    uint8_t cs_buf[MYNEWT_VAL(COREDUMP_BUF_SIZE)];
+};
+
+#if MYNEWT_VAL(COREDUMP_SKIP_REGIONS) > 0
+struct coredump_skip {
+    uint32_t cs_start;
+    uint32_t cs_end;
+};
+
+static struct coredump_skip coredump_skip_tbl[MYNEWT_VAL(COREDUMP_SKIP_REGIONS)];
+static int coredump_skip_cnt;
+
+int
+coredump_skip_region(const void *start, uint32_t size)
+{
+    struct coredump_skip *cs;
+
+    if (coredump_skip_cnt >= MYNEWT_VAL(COREDUMP_SKIP_REGIONS)) {
+        return -1;
+    }
+    cs = &coredump_skip_tbl[coredump_skip_cnt];
+    cs->cs_start = (uint32_t)start;
+    cs->cs_end = cs->cs_start + size;
+    coredump_skip_cnt++;
+    return 0;
+}
+#endif
+
+static int
+coredump_sector_empty(const struct flash_area *fa, uint32_t off, uint32_t size)
+{
+    uint32_t data[64 >> 2];
+    uint32_t end;
+    int len;
+    int i;
+
+    end = off + size;
+    while (off < end) {
+        len = end - off;
+        if (len > sizeof(data)) {
+            len = sizeof(data);
+        }
+        if (flash_area_read(fa, off, data, len)) {
+            return 0;
+        }
+        for (i = 0; i < len >> 2; i++) {
+            if (data[i] != (uint32_t)-1) {
+                return 0;
+            }
+        }
+        off += len;
+    }
+    return 1;
+}
+
+/*
+ * Make sure that flash is erased up to offset "end".
+ */
+static void
+coredump_erase_ahead(struct coredump_state *cs, uint32_t end)
+{
+    const struct flash_area *fa;
+    const struct hal_flash *hf;
+    uint32_t start;
+    uint32_t size;
+    int i;
+
+    fa = cs->cs_fa;
+    if (end > fa->fa_size) {
+        end = fa->fa_size;
+    }
+    if (cs->cs_erased_off >= end) {
+        return;
+    }
+    hf = hal_bsp_flash_dev(fa->fa_device_id);
+    for (i = 0; i < hf->hf_sector_cnt; i++) {
+        hf->hf_itf->hff_sector_info(hf, i, &start, &size);
+        if (start < fa->fa_off + cs->cs_erased_off) {
+            continue;
+        }
+        if (start >= fa->fa_off + end) {
+            break;
+        }
+        if (!coredump_sector_empty(fa, start - fa->fa_off, size)) {
+            if (flash_area_erase(fa, start - fa->fa_off, size)) {
+                cs->cs_rc = -1;
+                return;
+            }
+            hal_watchdog_tickle();
+        }
+        cs->cs_erased_off = start - fa->fa_off + size;
+    }
+}
+
+static void
+coredump_flash_write(struct coredump_state *cs, uint32_t off, const void *data,
+  uint32_t len)
+{
+    if (cs->cs_rc) {
+        return;
+    }
+    coredump_erase_ahead(cs, off + len);
+    if (cs->cs_rc == 0 && flash_area_write(cs->cs_fa, off, data, len)) {
+        cs->cs_rc = -1;
+    }
+}
+
+static void
+coredump_flush(struct coredump_state *cs)
+{
+    if (cs->cs_buf_len) {
+        coredump_flash_write(cs, cs->cs_off, cs->cs_buf, cs->cs_buf_len);
+        cs->cs_off += cs->cs_buf_len;
+        cs->cs_buf_len = 0;
+    }
+}
+
+static void
+coredump_write(struct coredump_state *cs, const void *data, uint32_t len)
+{
+    const uint8_t *src;
+    uint32_t cnt;
+
+    if (len >= sizeof(cs->cs_buf)) {
+        coredump_flush(cs);
+        coredump_flash_write(cs, cs->cs_off, data, len);
+        cs->cs_off += len;
+        return;
+    }
+    src = data;
+    while (len) {
+        cnt = sizeof(cs->cs_buf) - cs->cs_buf_len;
+        if (cnt > len) {
+            cnt = len;
+        }
+        memcpy(&cs->cs_buf[cs->cs_buf_len], src, cnt);
+        cs->cs_buf_len += cnt;
+        src += cnt;
+        len -= cnt;
+        if (cs->cs_buf_len == sizeof(cs->cs_buf)) {
+            coredump_flush(cs);
+        }
+    }
+}
+
+static void
+dump_core_tlv(struct coredump_state *cs, struct coredump_tlv *tlv,
+  const void *data)
+{
+    coredump_write(cs, tlv, sizeof(*tlv));
+    coredump_write(cs, data, tlv->ct_len);
+}
+
+#if MYNEWT_VAL(COREDUMP_COMPRESS)
+static void
+coredump_rle_literal(struct coredump_state *cs, const uint8_t *data,
+  uint32_t len)
+{
+    uint8_t ctrl;
+    uint32_t cnt;
+
+    while (len) {
+        cnt = len;
+        if (cnt > COREDUMP_RLE_LIT_MAX) {
+            cnt = COREDUMP_RLE_LIT_MAX;
+        }
+        ctrl = cnt - 1;
+        coredump_write(cs, &ctrl, sizeof(ctrl));
+        coredump_write(cs, data, cnt);
+        data += cnt;
+        len -= cnt;
+    }
+}
+
+/*
+ * Write memory region as COREDUMP_TLV_MEM_RLE. TLV header is written
+ * after the data, once the compressed length is known.
+ */
 static void
-dump_core_tlv(const struct flash_area *fa, uint32_t *off,
-  struct coredump_tlv *tlv, void *data)
+dump_core_rle(struct coredump_state *cs, uint32_t addr, uint32_t len)
 {
-    flash_area_write(fa, *off, tlv, sizeof(*tlv));
-    *off += sizeof(*tlv);
+    struct coredump_tlv tlv;
+    const uint8_t *data;
+    uint32_t tlv_off;
+    uint32_t lit;
+    uint32_t run;
+    uint32_t i;
+    uint8_t rle[2];
+
+    coredump_flush(cs);
+    tlv_off = cs->cs_off;
+    cs->cs_off += sizeof(tlv);
+
+    data = (const uint8_t *)addr;
+    lit = 0;
+    i = 0;
+    while (i < len) {
+        for (run = 1; i + run < len && run < COREDUMP_RLE_RUN_MAX; run++) {
+            if (data[i + run] != data[i]) {
+                break;
+            }
+        }
+        if (run < COREDUMP_RLE_RUN_MIN) {
+            i++;
+            continue;
+        }
+        coredump_rle_literal(cs, &data[lit], i - lit);
+        rle[0] = COREDUMP_RLE_RUN | (run - COREDUMP_RLE_RUN_MIN);
+        rle[1] = data[i];
+        coredump_write(cs, rle, sizeof(rle));
+        i += run;
+        lit = i;
+    }
+    coredump_rle_literal(cs, &data[lit], i - lit);
+    coredump_flush(cs);
 
-    flash_area_write(fa, *off, data, tlv->ct_len);
-    *off += tlv->ct_len;
+    tlv.ct_type = COREDUMP_TLV_MEM_RLE;
+    tlv._pad = 0;
+    tlv.ct_len = cs->cs_off - tlv_off - sizeof(tlv);
+    tlv.ct_off = addr;
+    coredump_flash_write(cs, tlv_off, &tlv, sizeof(tlv));
+}
+#endif
+
+static void
+dump_core_mem(struct coredump_state *cs, uint32_t start, uint32_t end)
+{
+#if !MYNEWT_VAL(COREDUMP_COMPRESS)
+    struct coredump_tlv tlv;
+#endif
+    uint32_t len;
+
+    while (start < end && cs->cs_rc == 0) {
+        len = end - start;
+        if (len > COREDUMP_CHUNK_MAX) {
+            len = COREDUMP_CHUNK_MAX;
+        }
+#if MYNEWT_VAL(COREDUMP_COMPRESS)
+        dump_core_rle(cs, start, len);
+#else
+        tlv.ct_type = COREDUMP_TLV_MEM;
+        tlv._pad = 0;
+        tlv.ct_len = len;
+        tlv.ct_off = start;
+        dump_core_tlv(cs, &tlv, (void *)start);
+#endif
+        start += len;
+        hal_watchdog_tickle();
+    }
+}
+
+/*
+ * Dump memory area, leaving out the parts which have been registered with
+ * coredump_skip_region().
+ */
+static void
+dump_core_area(struct coredump_state *cs, uint32_t start, uint32_t end)
+{
+#if MYNEWT_VAL(COREDUMP_SKIP_REGIONS) > 0
+    struct coredump_skip *skip;
+    uint32_t next;
+    int i;
+
+    while (start < end) {
+        next = end;
+        for (i = 0; i < coredump_skip_cnt; i++) {
+            skip = &coredump_skip_tbl[i];
+            if (skip->cs_start <= start && skip->cs_end > start) {
+                /*
+                 * Start is within skipped region; move past it.
+                 */
+                start = skip->cs_end;
+                next = end;
+                i = -1;
+                continue;
+            }
+            if (skip->cs_start > start && skip->cs_start < next) {
+                next = skip->cs_start;
+            }
+        }
+        if (start >= end) {
+            break;
+        }
+        if (next > end) {
+            next = end;
+        }
+        dump_core_mem(cs, start, next);
+        start = next;
+    }
+#else
+    dump_core_mem(cs, start, end);
+#endif
 }
 
 void
 coredump_dump(void *regs, int regs_sz)
 {
+    static struct coredump_state cs;
     struct coredump_header hdr;
     struct coredump_tlv tlv;
     const struct flash_area *fa;
@@ -50,8 +354,7 @@ coredump_dump(void *regs, int regs_sz)
     const struct hal_bsp_mem_dump *mem, *cur;
     int area_cnt, i;
     uint8_t hash[IMGMGR_HASH_LEN];
-    uint32_t off;
-    uint32_t area_off, area_end;
+    uint32_t area_off;
     int slot;
 
     if (coredump_disabled) {
@@ -81,47 +384,40 @@ coredump_dump(void *regs, int regs_sz)
         }
     }
 
-    if (flash_area_erase(fa, 0, fa->fa_size)) {
-        return;
-    }
-
     /*
-     * First put in data, followed by the header.
+     * First put in data, followed by the header. Flash gets erased as
+     * the data is written.
      */
+    memset(&cs, 0, sizeof(cs));
+    cs.cs_fa = fa;
+    cs.cs_off = sizeof(hdr);
+
     tlv.ct_type = COREDUMP_TLV_REGS;
     tlv._pad = 0;
     tlv.ct_len = regs_sz;
     tlv.ct_off = 0;
 
-    off = sizeof(hdr);
-    dump_core_tlv(fa, &off, &tlv, regs);
+    dump_core_tlv(&cs, &tlv, regs);
 
     if (imgr_read_info(boot_current_slot, &ver, hash, NULL) == 0) {
         tlv.ct_type = COREDUMP_TLV_IMAGE;
         tlv.ct_len = IMGMGR_HASH_LEN;
 
-        dump_core_tlv(fa, &off, &tlv, hash);
+        dump_core_tlv(&cs, &tlv, hash);
     }
 
     mem = hal_bsp_core_dump(&area_cnt);
     for (i = 0; i < area_cnt; i++) {
         cur = &mem[i];
         area_off = (uint32_t)cur->hbmd_start;
-        area_end = area_off + cur->hbmd_size;
-        while (area_off < area_end) {
-            tlv.ct_type = COREDUMP_TLV_MEM;
-            if (cur->hbmd_size > USHRT_MAX) {
-                tlv.ct_len = SHRT_MAX + 1;
-            } else {
-                tlv.ct_len = cur->hbmd_size;
-            }
-            tlv.ct_off = area_off;
-            dump_core_tlv(fa, &off, &tlv, (void *)area_off);
-            area_off += tlv.ct_len;
-        }
+        dump_core_area(&cs, area_off, area_off + cur->hbmd_size);
+    }
+    coredump_flush(&cs);
+    if (cs.cs_rc) {
+        return;
     }
     hdr.ch_magic = COREDUMP_MAGIC;
-    hdr.ch_size = off;
+    hdr.ch_size = cs.cs_off;
 
-    flash_area_write(fa, 0, &hdr, sizeof(hdr));
+    coredump_flash_write(&cs, 0, &hdr, sizeof(hdr));
 }
@@ -150,37 +150,63 @@ struct log_entry_hdr {
 
 #define LOG_NAME_MAX_LEN    (64)
 
+#if MYNEWT_VAL(LOG_DEFERRED)
+#define LOG_PRINTF log_printf_deferred
+#else
+#define LOG_PRINTF log_printf
+#endif
+
 #if MYNEWT_VAL(LOG_LEVEL) <= LOG_LEVEL_DEBUG
-#define LOG_DEBUG(__l, __mod, __msg, ...) log_printf(__l, __mod, \
-        LOG_LEVEL_DEBUG, __msg, ##__VA_ARGS__)
+#define LOG_DEBUG(__l, __mod, __msg, ...) do {                          \
+    if (log_level_enabled(__l, __mod, LOG_LEVEL_DEBUG)) {               \
+        LOG_PRINTF(__l, __mod, LOG_LEVEL_DEBUG, __msg,                  \
+                   ##__VA_ARGS__);                                      \
+    }                                                                   \
+} while (0)
 #else
 #define LOG_DEBUG(__l, __mod, ...) IGNORE(__VA_ARGS__)
 #endif
 
 #if MYNEWT_VAL(LOG_LEVEL) <= LOG_LEVEL_INFO
-#define LOG_INFO(__l, __mod, __msg, ...) log_printf(__l, __mod, \
-        LOG_LEVEL_INFO, __msg, ##__VA_ARGS__)
+#define LOG_INFO(__l, __mod, __msg, ...) do {                           \
+    if (log_level_enabled(__l, __mod, LOG_LEVEL_INFO)) {                \
+        LOG_PRINTF(__l, __mod, LOG_LEVEL_INFO, __msg,                   \
+                   ##__VA_ARGS__);                                      \
+    }                                                                   \
+} while (0)
 #else
 #define LOG_INFO(__l, __mod, ...) IGNORE(__VA_ARGS__)
 #endif
 
 #if MYNEWT_VAL(LOG_LEVEL) <= LOG_LEVEL_WARN
-#define LOG_WARN(__l, __mod, __msg, ...) log_printf(__l, __mod, \
-        LOG_LEVEL_WARN, __msg, ##__VA_ARGS__)
+#define LOG_WARN(__l, __mod, __msg, ...) do {                           \
+    if (log_level_enabled(__l, __mod, LOG_LEVEL_WARN)) {                \
+        LOG_PRINTF(__l, __mod, LOG_LEVEL_WARN, __msg,                   \
+                   ##__VA_ARGS__);                                      \
+    }                                                                   \
+} while (0)
 #else
 #define LOG_WARN(__l, __mod, ...) IGNORE(__VA_ARGS__)
 #endif
 
 #if MYNEWT_VAL(LOG_LEVEL) <= LOG_LEVEL_ERROR
-#define LOG_ERROR(__l, __mod, __msg, ...) log_printf(__l, __mod, \
-        LOG_LEVEL_ERROR, __msg, ##__VA_ARGS__)
+#define LOG_ERROR(__l, __mod, __msg, ...) do {                          \
+    if (log_level_enabled(__l, __mod, LOG_LEVEL_ERROR)) {               \
+        LOG_PRINTF(__l, __mod, LOG_LEVEL_ERROR, __msg,                  \
+                   ##__VA_ARGS__);                                      \
+    }                                                                   \
+} while (0)
 #else
 #define LOG_ERROR(__l, __mod, ...) IGNORE(__VA_ARGS__)
 #endif
 
 #if MYNEWT_VAL(LOG_LEVEL) <= LOG_LEVEL_CRITICAL
-#define LOG_CRITICAL(__l, __mod, __msg, ...) log_printf(__l, __mod, \
-        LOG_LEVEL_CRITICAL, __msg, ##__VA_ARGS__)
+#define LOG_CRITICAL(__l, __mod, __msg, ...) do {                       \
+    if (log_level_enabled(__l, __mod, LOG_LEVEL_CRITICAL)) {            \
+        LOG_PRINTF(__l, __mod, LOG_LEVEL_CRITICAL, __msg,               \
+                   ##__VA_ARGS__);                                      \
+    }                                                                   \
+} while (0)
 #else
 #define LOG_CRITICAL(__l, __mod, ...) IGNORE(__VA_ARGS__)
 #endif
@@ -199,6 +225,35 @@ struct log {
     uint8_t l_level;
 };
 
+#if MYNEWT_VAL(LOG_MODULE_LEVELS) > 0
+extern uint8_t log_module_levels[MYNEWT_VAL(LOG_MODULE_LEVELS)];
+#endif
+
+/**
+ * Minimum level of entries accepted from a module, as set with
+ * log_level_set().
+ */
+static inline uint8_t
+log_level_get(uint8_t module)
+{
+#if MYNEWT_VAL(LOG_MODULE_LEVELS) > 0
+    if (module < MYNEWT_VAL(LOG_MODULE_LEVELS)) {
+        return log_module_levels[module];
+    }
+#endif
+    return 0;
+}
+
+/**
+ * Whether an entry would be stored by log_append().  Used by the LOG_*
+ * macros to skip formatting an entry which would be dropped.
+ */
+static inline int
+log_level_enabled(const struct log *log, uint8_t module, uint8_t level)
+{
+    return level >= log->l_level && level >= log_level_get(module);
+}
+
 /* Newtmgr Log opcodes */
 #define LOGS_NMGR_OP_READ         (0)
 #define LOGS_NMGR_OP_CLEAR        (1)
@@ -215,9 +270,15 @@ struct log *log_list_get_next(struct log *);
 int log_register(char *name, struct log *log, const struct log_handler *,
                  void *arg, uint8_t level);
 int log_append(struct log *, uint16_t, uint16_t, void *, uint16_t);
+int log_level_set(uint8_t module, uint8_t level);
 
 #define LOG_PRINTF_MAX_ENTRY_LEN (128)
 void log_printf(struct log *log, uint16_t, uint16_t, char *, ...);
+#if MYNEWT_VAL(LOG_DEFERRED)
+void log_printf_deferred(struct log *log, uint16_t, uint16_t, const char *,
+                         ...);
+int log_deferred_format(const void *data, int len, char *buf, int buf_len);
+#endif
 int log_read(struct log *log, void *dptr, void *buf, uint16_t off,
         uint16_t len);
 int log_walk(struct log *log, log_walk_func_t walk_func,
@@ -233,11 +294,23 @@ extern const struct log_handler log_cbmem_handler;
 #if MYNEWT_VAL(LOG_FCB)
 extern const struct log_handler log_fcb_handler;
 #endif
+#if MYNEWT_VAL(LOG_RTT)
+extern const struct log_handler log_rtt_handler;
+/* Number of entries dropped because RTT log channel was full. */
+uint32_t log_rtt_drop_cnt(void);
+#endif
 
 /* Private */
 #if MYNEWT_VAL(LOG_NEWTMGR)
 int log_nmgr_register_group(void);
 #endif
+#if MYNEWT_VAL(LOG_RTT)
+void log_rtt_init(void);
+#endif
+#if MYNEWT_VAL(LOG_ASYNC)
+void log_async_init(void);
+int log_async_append(struct log *log, void *data, uint16_t len);
+#endif
 
 #ifdef __cplusplus
 }
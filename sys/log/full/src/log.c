@@ -38,6 +38,17 @@ static STAILQ_HEAD(, log) g_log_list = STAILQ_HEAD_INITIALIZER(g_log_list);
 static uint8_t log_inited;
 static uint8_t log_written;
 
+#if MYNEWT_VAL(LOG_MODULE_LEVELS) > 0
+uint8_t log_module_levels[MYNEWT_VAL(LOG_MODULE_LEVELS)];
+#endif
+
+#if MYNEWT_VAL(LOG_TS_CPUTIME)
+/* Timestamp at log_ts_base_cputime. */
+static int64_t log_ts_base;
+static uint32_t log_ts_base_cputime;
+static uint8_t log_ts_base_valid;
+#endif
+
 #if MYNEWT_VAL(LOG_CLI)
 int shell_log_dump_all_cmd(int, char **);
 struct shell_cmd g_shell_log_cmd = {
@@ -73,6 +84,14 @@ log_init(void)
     rc = log_nmgr_register_group();
     SYSINIT_PANIC_ASSERT(rc == 0);
 #endif
+
+#if MYNEWT_VAL(LOG_RTT)
+    log_rtt_init();
+#endif
+
+#if MYNEWT_VAL(LOG_ASYNC)
+    log_async_init();
+#endif
 }
 
 struct log *
@@ -200,6 +219,79 @@ log_register(char *name, struct log *log, const struct log_handler *lh,
     return (0);
 }
 
+/**
+ * Sets the minimum level of entries accepted from the specified module, in
+ * all logs.
+ *
+ * @return                      0 on success; OS_EINVAL if module is beyond
+ *                                  LOG_MODULE_LEVELS.
+ */
+int
+log_level_set(uint8_t module, uint8_t level)
+{
+#if MYNEWT_VAL(LOG_MODULE_LEVELS) > 0
+    if (module < MYNEWT_VAL(LOG_MODULE_LEVELS)) {
+        log_module_levels[module] = level;
+        return (0);
+    }
+#endif
+    return (OS_EINVAL);
+}
+
+static int64_t
+log_ts_read(void)
+{
+    struct os_timeval tv;
+    int rc;
+
+    /* Try to get UTC Time */
+    rc = os_gettimeofday(&tv, NULL);
+    if (rc || tv.tv_sec < UTC01_01_2016) {
+        return os_get_uptime_usec();
+    } else {
+        return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+    }
+}
+
+/**
+ * Timestamp for a new entry.  With LOG_TS_CPUTIME, the time of day is only
+ * read every LOG_TS_RESYNC_MS; in-between, the elapsed cputime is added to
+ * that.
+ */
+static int64_t
+log_ts_get(void)
+{
+#if MYNEWT_VAL(LOG_TS_CPUTIME)
+    uint32_t now;
+    uint32_t delta;
+    int64_t ts;
+    int sr;
+
+    now = os_cputime_get32();
+
+    OS_ENTER_CRITICAL(sr);
+    delta = os_cputime_ticks_to_usecs(now - log_ts_base_cputime);
+    if (log_ts_base_valid && delta < MYNEWT_VAL(LOG_TS_RESYNC_MS) * 1000) {
+        ts = log_ts_base + delta;
+        OS_EXIT_CRITICAL(sr);
+        return ts;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    ts = log_ts_read();
+
+    OS_ENTER_CRITICAL(sr);
+    log_ts_base = ts;
+    log_ts_base_cputime = now;
+    log_ts_base_valid = 1;
+    OS_EXIT_CRITICAL(sr);
+
+    return ts;
+#else
+    return log_ts_read();
+#endif
+}
+
 int
 log_append(struct log *log, uint16_t module, uint16_t level, void *data,
         uint16_t len)
@@ -207,7 +299,6 @@ log_append(struct log *log, uint16_t module, uint16_t level, void *data,
     struct log_entry_hdr *ue;
     int rc;
     int sr;
-    struct os_timeval tv;
     uint32_t idx;
 
     if (log->l_name == NULL || log->l_log == NULL) {
@@ -224,7 +315,7 @@ log_append(struct log *log, uint16_t module, uint16_t level, void *data,
      * If the log message is below what this log instance is
      * configured to accept, then just drop it.
      */
-    if (level < log->l_level) {
+    if (!log_level_enabled(log, module, level)) {
         rc = -1;
         goto err;
     }
@@ -235,19 +326,16 @@ log_append(struct log *log, uint16_t module, uint16_t level, void *data,
     idx = g_log_info.li_next_index++;
     OS_EXIT_CRITICAL(sr);
 
-    /* Try to get UTC Time */
-    rc = os_gettimeofday(&tv, NULL);
-    if (rc || tv.tv_sec < UTC01_01_2016) {
-        ue->ue_ts = os_get_uptime_usec();
-    } else {
-        ue->ue_ts = tv.tv_sec * 1000000 + tv.tv_usec;
-    }
-
+    ue->ue_ts = log_ts_get();
     ue->ue_level = level;
     ue->ue_module = module;
     ue->ue_index = idx;
 
+#if MYNEWT_VAL(LOG_ASYNC)
+    rc = log_async_append(log, data, len + LOG_ENTRY_HDR_SIZE);
+#else
     rc = log->l_log->log_append(log, data, len + LOG_ENTRY_HDR_SIZE);
+#endif
     if (rc != 0) {
         goto err;
     }
@@ -264,6 +352,10 @@ log_printf(struct log *log, uint16_t module, uint16_t level, char *msg, ...)
     char buf[LOG_ENTRY_HDR_SIZE + LOG_PRINTF_MAX_ENTRY_LEN];
     int len;
 
+    if (!log_level_enabled(log, module, level)) {
+        return;
+    }
+
     va_start(args, msg);
     len = vsnprintf(&buf[LOG_ENTRY_HDR_SIZE], LOG_PRINTF_MAX_ENTRY_LEN, msg,
             args);
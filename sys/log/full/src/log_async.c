@@ -0,0 +1,220 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "sysinit/sysinit.h"
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "stats/stats.h"
+#include "log/log.h"
+
+#if MYNEWT_VAL(LOG_ASYNC)
+
+/*
+ * Entries are staged in a ring buffer, and written to their logs by a
+ * dedicated task.  Producers (tasks or interrupts) only disable interrupts
+ * to reserve space; the entry is copied in with interrupts enabled, and
+ * then marked committed.  The drain task is the only one advancing the
+ * tail, which it does without locking.
+ */
+struct log_async_rec {
+    struct log *lar_log;
+    uint16_t lar_len;		/* Including this header and padding */
+    uint16_t lar_data_len;
+    volatile uint8_t lar_state;
+};
+
+#define LOG_ASYNC_REC_RESERVED  0
+#define LOG_ASYNC_REC_COMMITTED 1
+#define LOG_ASYNC_REC_PAD       2
+
+#define LOG_ASYNC_REC_SZ        sizeof(struct log_async_rec)
+#define LOG_ASYNC_REC_ALIGN(x)  \
+    (((x) + LOG_ASYNC_REC_SZ - 1) / LOG_ASYNC_REC_SZ * LOG_ASYNC_REC_SZ)
+#define LOG_ASYNC_RING_SZ       \
+    (MYNEWT_VAL(LOG_ASYNC_RING_SIZE) / LOG_ASYNC_REC_SZ * LOG_ASYNC_REC_SZ)
+
+STATS_SECT_START(log_async_stats)
+    STATS_SECT_ENTRY(queued)
+    STATS_SECT_ENTRY(dropped)
+    STATS_SECT_ENTRY(written)
+    STATS_SECT_ENTRY(errors)
+STATS_SECT_END
+
+STATS_SECT_DECL(log_async_stats) log_async_stats;
+STATS_NAME_START(log_async_stats)
+    STATS_NAME(log_async_stats, queued)
+    STATS_NAME(log_async_stats, dropped)
+    STATS_NAME(log_async_stats, written)
+    STATS_NAME(log_async_stats, errors)
+STATS_NAME_END(log_async_stats)
+
+static union {
+    struct log_async_rec lar;
+    uint8_t bytes[LOG_ASYNC_RING_SZ];
+} log_async_ring;
+
+/* Free running; offset into ring is value modulo ring size. */
+static uint32_t log_async_head;
+static volatile uint32_t log_async_tail;
+
+static struct os_task log_async_task;
+static struct os_eventq log_async_evq;
+static os_stack_t log_async_stack[
+    OS_STACK_ALIGN(MYNEWT_VAL(LOG_ASYNC_STACK_SIZE))];
+
+static void log_async_drain_ev(struct os_event *ev);
+static struct os_event log_async_ev = {
+    .ev_cb = log_async_drain_ev,
+};
+
+static struct log_async_rec *
+log_async_rec_at(uint32_t off)
+{
+    return (struct log_async_rec *)
+        &log_async_ring.bytes[off % LOG_ASYNC_RING_SZ];
+}
+
+/**
+ * Queues a log entry to be written to its log by the log task.  Can be
+ * called from interrupt context.
+ *
+ * @return                      0 on success; OS_ENOMEM if the entry did not
+ *                                  fit, and was dropped.
+ */
+int
+log_async_append(struct log *log, void *data, uint16_t len)
+{
+    struct log_async_rec *rec;
+    uint32_t contig;
+    uint32_t need;
+    uint32_t pad;
+    int sr;
+
+    need = LOG_ASYNC_REC_ALIGN(LOG_ASYNC_REC_SZ + len);
+
+    OS_ENTER_CRITICAL(sr);
+    contig = LOG_ASYNC_RING_SZ - log_async_head % LOG_ASYNC_RING_SZ;
+    if (contig < need) {
+        /* Does not fit before the end; skip to the start of the ring. */
+        pad = contig;
+    } else {
+        pad = 0;
+    }
+    if (need > LOG_ASYNC_RING_SZ ||
+      log_async_head + pad + need - log_async_tail > LOG_ASYNC_RING_SZ) {
+        OS_EXIT_CRITICAL(sr);
+        STATS_INC(log_async_stats, dropped);
+        return OS_ENOMEM;
+    }
+    if (pad) {
+        rec = log_async_rec_at(log_async_head);
+        rec->lar_len = pad;
+        rec->lar_state = LOG_ASYNC_REC_PAD;
+        log_async_head += pad;
+    }
+    rec = log_async_rec_at(log_async_head);
+    rec->lar_log = log;
+    rec->lar_len = need;
+    rec->lar_data_len = len;
+    rec->lar_state = LOG_ASYNC_REC_RESERVED;
+    log_async_head += need;
+    OS_EXIT_CRITICAL(sr);
+
+    memcpy(rec + 1, data, len);
+    rec->lar_state = LOG_ASYNC_REC_COMMITTED;
+
+    STATS_INC(log_async_stats, queued);
+    os_eventq_put(&log_async_evq, &log_async_ev);
+
+    return 0;
+}
+
+static void
+log_async_drain_ev(struct os_event *ev)
+{
+    struct log_async_rec *rec;
+    uint32_t head;
+    int sr;
+    int rc;
+    int i;
+
+    OS_ENTER_CRITICAL(sr);
+    head = log_async_head;
+    OS_EXIT_CRITICAL(sr);
+
+    for (i = 0; i < MYNEWT_VAL(LOG_ASYNC_BATCH); i++) {
+        if (log_async_tail == head) {
+            return;
+        }
+        rec = log_async_rec_at(log_async_tail);
+        if (rec->lar_state == LOG_ASYNC_REC_RESERVED) {
+            /*
+             * Still being copied in; the producer queues the event again
+             * when it's done.
+             */
+            return;
+        }
+        if (rec->lar_state == LOG_ASYNC_REC_COMMITTED) {
+            rc = rec->lar_log->l_log->log_append(rec->lar_log, rec + 1,
+              rec->lar_data_len);
+            if (rc) {
+                STATS_INC(log_async_stats, errors);
+            } else {
+                STATS_INC(log_async_stats, written);
+            }
+        }
+        log_async_tail += rec->lar_len;
+    }
+
+    /*
+     * More left; let other tasks of the same priority run in-between.
+     */
+    os_eventq_put(&log_async_evq, &log_async_ev);
+}
+
+static void
+log_async_task_handler(void *arg)
+{
+    while (1) {
+        os_eventq_run(&log_async_evq);
+    }
+}
+
+void
+log_async_init(void)
+{
+    int rc;
+
+    os_eventq_init(&log_async_evq);
+
+    rc = os_task_init(&log_async_task, "log", log_async_task_handler, NULL,
+                      MYNEWT_VAL(LOG_ASYNC_TASK_PRIO), OS_WAIT_FOREVER,
+                      log_async_stack,
+                      OS_STACK_ALIGN(MYNEWT_VAL(LOG_ASYNC_STACK_SIZE)));
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
+    rc = stats_init_and_reg(
+        STATS_HDR(log_async_stats), STATS_SIZE_INIT_PARMS(log_async_stats,
+        STATS_SIZE_32), STATS_NAME_INIT_PARMS(log_async_stats), "log_async");
+    SYSINIT_PANIC_ASSERT(rc == 0);
+}
+
+#endif
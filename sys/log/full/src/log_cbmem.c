@@ -82,7 +82,7 @@ log_cbmem_walk(struct log *log, log_walk_func_t walk_func,
         cbmem_iter_start(cbmem, &iter);
         while (1) {
             hdr = cbmem_iter_next(cbmem, &iter);
-            if (!hdr) {
+            if (!hdr || !cbmem_iter_valid(cbmem, &iter)) {
                 break;
             }
 
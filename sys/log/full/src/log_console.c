@@ -30,6 +30,10 @@ static int
 log_console_append(struct log *log, void *buf, int len)
 {
     struct log_entry_hdr *hdr;
+#if MYNEWT_VAL(LOG_DEFERRED)
+    char text[LOG_PRINTF_MAX_ENTRY_LEN];
+    int text_len;
+#endif
 
     if (!console_is_init()) {
         return (0);
@@ -42,6 +46,15 @@ log_console_append(struct log *log, void *buf, int len)
                 hdr->ue_level);
     }
 
+#if MYNEWT_VAL(LOG_DEFERRED)
+    text_len = log_deferred_format((char *) buf + LOG_ENTRY_HDR_SIZE,
+                                   len - LOG_ENTRY_HDR_SIZE, text,
+                                   sizeof(text));
+    if (text_len >= 0) {
+        console_write(text, text_len);
+        return (0);
+    }
+#endif
     console_write((char *) buf + LOG_ENTRY_HDR_SIZE, len - LOG_ENTRY_HDR_SIZE);
 
     return (0);
@@ -0,0 +1,391 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(LOG_DEFERRED)
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "os/os.h"
+#include "crc/crc16.h"
+#include "log/log.h"
+
+/*
+ * Deferred entries store the address of the format string, its CRC (to
+ * detect entries written by a different image), and the arguments packed
+ * in native byte order.  Text is only produced when the entry is read.
+ *
+ * | mark | fmt ptr | fmt crc16 | args ... |
+ */
+#define LOG_DEFERRED_MARK       0xfe
+#define LOG_DEFERRED_HDR_SZ     (1 + sizeof(const char *) + sizeof(uint16_t))
+
+#define LOG_DEFERRED_ARG_INT    0
+#define LOG_DEFERRED_ARG_LONG   1
+#define LOG_DEFERRED_ARG_LLONG  2
+#define LOG_DEFERRED_ARG_DOUBLE 3
+#define LOG_DEFERRED_ARG_PTR    4
+#define LOG_DEFERRED_ARG_STR    5
+#define LOG_DEFERRED_ARG_NONE   6
+
+/**
+ * Parses the conversion specification at fmt, which points at a '%'.
+ *
+ * @return                      Length of the specification; -1 if it is
+ *                                  one which can't be deferred.
+ */
+static int
+log_deferred_spec(const char *fmt, int *type)
+{
+    const char *p;
+    int lng;
+
+    p = fmt + 1;
+    while (*p && strchr("-+ #0", *p)) {
+        p++;
+    }
+    while (*p >= '0' && *p <= '9') {
+        p++;
+    }
+    if (*p == '.') {
+        p++;
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+    }
+    lng = 0;
+    while (*p == 'h') {
+        p++;
+    }
+    while (*p == 'l') {
+        lng++;
+        p++;
+    }
+    if (*p == 'z') {
+        lng = sizeof(size_t) == sizeof(long long) ? 2 : 1;
+        p++;
+    }
+
+    switch (*p) {
+    case 'd':
+    case 'i':
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+    case 'c':
+        if (lng == 0) {
+            *type = LOG_DEFERRED_ARG_INT;
+        } else if (lng == 1) {
+            *type = LOG_DEFERRED_ARG_LONG;
+        } else {
+            *type = LOG_DEFERRED_ARG_LLONG;
+        }
+        break;
+    case 'f':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+        *type = LOG_DEFERRED_ARG_DOUBLE;
+        break;
+    case 'p':
+        *type = LOG_DEFERRED_ARG_PTR;
+        break;
+    case 's':
+        *type = LOG_DEFERRED_ARG_STR;
+        break;
+    case '%':
+        *type = LOG_DEFERRED_ARG_NONE;
+        break;
+    default:
+        /* '*' width, %n, and anything else. */
+        return -1;
+    }
+
+    return p - fmt + 1;
+}
+
+static int
+log_deferred_pack(uint8_t *buf, int max, const char *fmt, va_list ap)
+{
+    const char *str;
+    long long ll;
+    double d;
+    void *ptr;
+    long l;
+    int type;
+    int len;
+    int off;
+    int sz;
+    int i;
+
+    off = 0;
+    while (*fmt) {
+        if (*fmt != '%') {
+            fmt++;
+            continue;
+        }
+        len = log_deferred_spec(fmt, &type);
+        if (len < 0) {
+            return -1;
+        }
+        fmt += len;
+
+        switch (type) {
+        case LOG_DEFERRED_ARG_INT:
+            i = va_arg(ap, int);
+            sz = sizeof(i);
+            ptr = &i;
+            break;
+        case LOG_DEFERRED_ARG_LONG:
+            l = va_arg(ap, long);
+            sz = sizeof(l);
+            ptr = &l;
+            break;
+        case LOG_DEFERRED_ARG_LLONG:
+            ll = va_arg(ap, long long);
+            sz = sizeof(ll);
+            ptr = &ll;
+            break;
+        case LOG_DEFERRED_ARG_DOUBLE:
+            d = va_arg(ap, double);
+            sz = sizeof(d);
+            ptr = &d;
+            break;
+        case LOG_DEFERRED_ARG_PTR:
+            ptr = va_arg(ap, void *);
+            if (off + sizeof(ptr) > max) {
+                return -1;
+            }
+            memcpy(buf + off, &ptr, sizeof(ptr));
+            off += sizeof(ptr);
+            continue;
+        case LOG_DEFERRED_ARG_STR:
+            /*
+             * Strings are copied; length byte first.
+             */
+            str = va_arg(ap, const char *);
+            if (str == NULL) {
+                str = "(null)";
+            }
+            sz = strlen(str);
+            if (sz > MYNEWT_VAL(LOG_DEFERRED_STR_MAX)) {
+                sz = MYNEWT_VAL(LOG_DEFERRED_STR_MAX);
+            }
+            if (off + 1 + sz > max) {
+                return -1;
+            }
+            buf[off++] = sz;
+            memcpy(buf + off, str, sz);
+            off += sz;
+            continue;
+        default:
+            continue;
+        }
+        if (off + sz > max) {
+            return -1;
+        }
+        memcpy(buf + off, ptr, sz);
+        off += sz;
+    }
+    return off;
+}
+
+/**
+ * Like log_printf(), but stores the format string address and arguments
+ * instead of formatted text.  Formats which can't be stored that way (e.g.
+ * '*' width) are formatted immediately, as with log_printf().  Format
+ * strings must stay at the same address for the lifetime of the image.
+ */
+void
+log_printf_deferred(struct log *log, uint16_t module, uint16_t level,
+                    const char *msg, ...)
+{
+    uint8_t buf[LOG_ENTRY_HDR_SIZE + LOG_PRINTF_MAX_ENTRY_LEN];
+    uint8_t *p;
+    uint16_t crc;
+    va_list args;
+    int len;
+
+    if (!log_level_enabled(log, module, level)) {
+        return;
+    }
+
+    p = buf + LOG_ENTRY_HDR_SIZE;
+    va_start(args, msg);
+    len = log_deferred_pack(p + LOG_DEFERRED_HDR_SZ,
+      LOG_PRINTF_MAX_ENTRY_LEN - LOG_DEFERRED_HDR_SZ, msg, args);
+    va_end(args);
+
+    if (len < 0) {
+        va_start(args, msg);
+        len = vsnprintf((char *)p, LOG_PRINTF_MAX_ENTRY_LEN, msg, args);
+        va_end(args);
+        if (len >= LOG_PRINTF_MAX_ENTRY_LEN) {
+            len = LOG_PRINTF_MAX_ENTRY_LEN - 1;
+        }
+    } else {
+        crc = crc16_ccitt(CRC16_INITIAL_CRC, msg, strlen(msg));
+        p[0] = LOG_DEFERRED_MARK;
+        memcpy(p + 1, &msg, sizeof(msg));
+        memcpy(p + 1 + sizeof(msg), &crc, sizeof(crc));
+        len += LOG_DEFERRED_HDR_SZ;
+    }
+
+    log_append(log, module, level, buf, len);
+}
+
+/**
+ * Produces the text of a log entry written by log_printf_deferred().
+ *
+ * @param data                  Entry body, after the log_entry_hdr.
+ * @param len                   Length of the body.
+ * @param buf                   Text gets written here, null-terminated.
+ * @param buf_len               Size of buf.
+ *
+ * @return                      Length of the text; -1 if the entry is not
+ *                                  a deferred one.
+ */
+int
+log_deferred_format(const void *data, int len, char *buf, int buf_len)
+{
+    char str[MYNEWT_VAL(LOG_DEFERRED_STR_MAX) + 1];
+    char spec[16];
+    const uint8_t *arg;
+    const uint8_t *end;
+    const char *fmt;
+    uint16_t crc;
+    long long ll;
+    double d;
+    void *ptr;
+    long l;
+    int type;
+    int off;
+    int sz;
+    int rc;
+    int i;
+
+    arg = data;
+    end = arg + len;
+    if (len < LOG_DEFERRED_HDR_SZ || arg[0] != LOG_DEFERRED_MARK ||
+      buf_len < 1) {
+        return -1;
+    }
+    memcpy(&fmt, arg + 1, sizeof(fmt));
+    memcpy(&crc, arg + 1 + sizeof(fmt), sizeof(crc));
+    arg += LOG_DEFERRED_HDR_SZ;
+
+    if (fmt == NULL ||
+      crc16_ccitt(CRC16_INITIAL_CRC, fmt, strlen(fmt)) != crc) {
+        return snprintf(buf, buf_len, "<fmt %p>", fmt);
+    }
+
+    off = 0;
+    while (*fmt && off < buf_len - 1) {
+        if (*fmt != '%') {
+            buf[off++] = *fmt++;
+            continue;
+        }
+        sz = log_deferred_spec(fmt, &type);
+        if (sz < 0 || sz >= sizeof(spec)) {
+            break;
+        }
+        memcpy(spec, fmt, sz);
+        spec[sz] = '\0';
+        fmt += sz;
+
+        switch (type) {
+        case LOG_DEFERRED_ARG_INT:
+            sz = sizeof(i);
+            break;
+        case LOG_DEFERRED_ARG_LONG:
+            sz = sizeof(l);
+            break;
+        case LOG_DEFERRED_ARG_LLONG:
+        case LOG_DEFERRED_ARG_DOUBLE:
+            sz = sizeof(ll);
+            break;
+        case LOG_DEFERRED_ARG_PTR:
+            sz = sizeof(ptr);
+            break;
+        case LOG_DEFERRED_ARG_STR:
+            if (arg >= end || arg[0] > MYNEWT_VAL(LOG_DEFERRED_STR_MAX)) {
+                sz = end - arg + 1;
+            } else {
+                sz = 1 + arg[0];
+            }
+            break;
+        default:
+            sz = 0;
+            break;
+        }
+        if (arg + sz > end) {
+            break;
+        }
+
+        switch (type) {
+        case LOG_DEFERRED_ARG_INT:
+            memcpy(&i, arg, sz);
+            rc = snprintf(buf + off, buf_len - off, spec, i);
+            break;
+        case LOG_DEFERRED_ARG_LONG:
+            memcpy(&l, arg, sz);
+            rc = snprintf(buf + off, buf_len - off, spec, l);
+            break;
+        case LOG_DEFERRED_ARG_LLONG:
+            memcpy(&ll, arg, sz);
+            rc = snprintf(buf + off, buf_len - off, spec, ll);
+            break;
+        case LOG_DEFERRED_ARG_DOUBLE:
+            memcpy(&d, arg, sz);
+            rc = snprintf(buf + off, buf_len - off, spec, d);
+            break;
+        case LOG_DEFERRED_ARG_PTR:
+            memcpy(&ptr, arg, sz);
+            rc = snprintf(buf + off, buf_len - off, spec, ptr);
+            break;
+        case LOG_DEFERRED_ARG_STR:
+            memcpy(str, arg + 1, sz - 1);
+            str[sz - 1] = '\0';
+            rc = snprintf(buf + off, buf_len - off, spec, str);
+            break;
+        default:
+            buf[off] = '%';
+            rc = 1;
+            break;
+        }
+        arg += sz;
+        if (rc < 0) {
+            break;
+        }
+        off += rc;
+    }
+    if (off > buf_len - 1) {
+        off = buf_len - 1;
+    }
+    buf[off] = '\0';
+
+    return off;
+}
+
+#endif
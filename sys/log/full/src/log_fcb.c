@@ -98,6 +98,60 @@ log_fcb_read(struct log *log, void *dptr, void *buf, uint16_t offset,
     }
 }
 
+/*
+ * Whether every entry logged before ueh is filtered out by log_offset.
+ * Entries are appended in index order, and their timestamps are taken to be
+ * non-decreasing.
+ */
+static int
+log_fcb_hdr_bounds(const struct log_entry_hdr *ueh,
+                   const struct log_offset *log_offset)
+{
+    if (log_offset->lo_ts == 0) {
+        return ueh->ue_index <= log_offset->lo_index;
+    }
+    return ueh->ue_ts < log_offset->lo_ts;
+}
+
+/*
+ * Finds the sector a walk for log_offset starts from.  A sector is skipped
+ * when the first entry of the sector after it shows that none of its
+ * entries pass the filter, so only one entry header is read per sector
+ * skipped.  Lets paginated reads resume near the requested index or
+ * timestamp instead of walking from the oldest entry.
+ */
+static struct flash_area *
+log_fcb_start_area(struct log *log, struct fcb *fcb,
+                   const struct log_offset *log_offset)
+{
+    struct log_entry_hdr ueh;
+    struct fcb_entry loc;
+    struct flash_area *fap;
+    struct flash_area *next;
+
+    fap = fcb->f_oldest;
+    if (log_offset->lo_ts == 0 && log_offset->lo_index == 0) {
+        return fap;
+    }
+
+    while (fap != fcb->f_active.fe_area) {
+        next = fap + 1;
+        if (next >= &fcb->f_sectors[fcb->f_sector_cnt]) {
+            next = &fcb->f_sectors[0];
+        }
+
+        memset(&loc, 0, sizeof(loc));
+        loc.fe_area = next;
+        if (fcb_getnext(fcb, &loc) != 0 ||
+            log_fcb_read(log, &loc, &ueh, 0, sizeof(ueh)) != sizeof(ueh) ||
+            !log_fcb_hdr_bounds(&ueh, log_offset)) {
+            break;
+        }
+        fap = next;
+    }
+    return fap;
+}
+
 static int
 log_fcb_walk(struct log *log, log_walk_func_t walk_func,
              struct log_offset *log_offset)
@@ -119,6 +173,7 @@ log_fcb_walk(struct log *log, log_walk_func_t walk_func,
         locp = &fcb->f_active;
         rc = walk_func(log, log_offset, (void *)locp, locp->fe_data_len);
     } else {
+        loc.fe_area = log_fcb_start_area(log, fcb, log_offset);
         while (fcb_getnext(fcb, &loc) == 0) {
             rc = walk_func(log, log_offset, (void *) &loc, loc.fe_data_len);
             if (rc) {
@@ -64,6 +64,9 @@ log_nmgr_encode_entry(struct log *log, struct log_offset *log_offset,
 {
     struct log_entry_hdr ueh;
     char data[128];
+#if MYNEWT_VAL(LOG_DEFERRED)
+    char text[128];
+#endif
     int dlen;
     int rc;
     int rsp_len;
@@ -109,6 +112,13 @@ log_nmgr_encode_entry(struct log *log, struct log_offset *log_offset,
     }
     data[rc] = 0;
 
+#if MYNEWT_VAL(LOG_DEFERRED)
+    /* Deferred entries are sent as text; newtmgr sees no difference. */
+    if (log_deferred_format(data, rc, text, sizeof(text)) >= 0) {
+        strcpy(data, text);
+    }
+#endif
+
     /*calculate whether this would fit */
     /* create a counting encoder for cbor */
     cbor_cnt_writer_init(&cnt_writer);
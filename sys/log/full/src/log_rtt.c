@@ -0,0 +1,116 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <syscfg/syscfg.h>
+
+#if MYNEWT_VAL(LOG_RTT)
+
+#include <os/os.h>
+#include <os/endian.h>
+#include <rtt/SEGGER_RTT.h>
+#include "log/log.h"
+
+/*
+ * Entries are written to their own RTT channel in binary, each preceded by
+ * its length as 16 bit little endian.  Entries which don't fit are dropped
+ * whole, so that host doesn't lose sync.
+ */
+#define LOG_RTT_CHANNEL     MYNEWT_VAL(LOG_RTT_CHANNEL)
+
+static uint8_t log_rtt_buf[MYNEWT_VAL(LOG_RTT_BUFFER_SIZE)];
+static uint32_t log_rtt_drops;
+
+static unsigned
+log_rtt_space(const SEGGER_RTT_BUFFER_UP *ring)
+{
+    unsigned rd_off;
+    unsigned wr_off;
+
+    rd_off = ring->RdOff;
+    wr_off = ring->WrOff;
+    if (rd_off <= wr_off) {
+        return ring->SizeOfBuffer - 1 - wr_off + rd_off;
+    }
+    return rd_off - wr_off - 1;
+}
+
+static int
+log_rtt_append(struct log *log, void *buf, int len)
+{
+    uint16_t rec_len;
+    int sr;
+
+    OS_ENTER_CRITICAL(sr);
+    if (log_rtt_space(&_SEGGER_RTT.aUp[LOG_RTT_CHANNEL]) <
+        len + sizeof(rec_len)) {
+        log_rtt_drops++;
+        OS_EXIT_CRITICAL(sr);
+        return (OS_ENOMEM);
+    }
+    rec_len = htole16(len);
+    SEGGER_RTT_WriteSkipNoLock(LOG_RTT_CHANNEL, &rec_len, sizeof(rec_len));
+    SEGGER_RTT_WriteSkipNoLock(LOG_RTT_CHANNEL, buf, len);
+    OS_EXIT_CRITICAL(sr);
+
+    return (0);
+}
+
+static int
+log_rtt_read(struct log *log, void *dptr, void *buf, uint16_t offset,
+        uint16_t len)
+{
+    /* Entries are gone once written. */
+    return (OS_EINVAL);
+}
+
+static int
+log_rtt_walk(struct log *log, log_walk_func_t walk_func,
+        struct log_offset *log_offset)
+{
+    return (OS_EINVAL);
+}
+
+static int
+log_rtt_flush(struct log *log)
+{
+    return (OS_EINVAL);
+}
+
+uint32_t
+log_rtt_drop_cnt(void)
+{
+    return log_rtt_drops;
+}
+
+void
+log_rtt_init(void)
+{
+    SEGGER_RTT_ConfigUpBuffer(LOG_RTT_CHANNEL, "Log", log_rtt_buf,
+      sizeof(log_rtt_buf), SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+}
+
+const struct log_handler log_rtt_handler = {
+    .log_type = LOG_TYPE_STREAM,
+    .log_read = log_rtt_read,
+    .log_append = log_rtt_append,
+    .log_walk = log_rtt_walk,
+    .log_flush = log_rtt_flush,
+    .log_rtr_erase = NULL,
+};
+
+#endif
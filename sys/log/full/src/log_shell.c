@@ -40,6 +40,9 @@ shell_log_dump_entry(struct log *log, struct log_offset *log_offset,
 {
     struct log_entry_hdr ueh;
     char data[128];
+#if MYNEWT_VAL(LOG_DEFERRED)
+    char text[128];
+#endif
     int dlen;
     int rc;
 
@@ -56,6 +59,12 @@ shell_log_dump_entry(struct log *log, struct log_offset *log_offset,
     }
     data[rc] = 0;
 
+#if MYNEWT_VAL(LOG_DEFERRED)
+    if (log_deferred_format(data, rc, text, sizeof(text)) >= 0) {
+        strcpy(data, text);
+    }
+#endif
+
     /* XXX: This is evil.  newlib printf does not like 64-bit
      * values, and this causes memory to be overwritten.  Cast to a
      * unsigned 32-bit value for now.
@@ -85,7 +85,10 @@ log_test_walk2(struct log *log, struct log_offset *log_offset,
 TEST_CASE_DECL(log_setup_fcb)
 TEST_CASE_DECL(log_append_fcb)
 TEST_CASE_DECL(log_walk_fcb)
+TEST_CASE_DECL(log_walk_index_fcb)
 TEST_CASE_DECL(log_flush_fcb)
+TEST_CASE_DECL(log_deferred_fcb)
+TEST_CASE_DECL(log_level_fcb)
 
 TEST_SUITE(log_test_all)
 {
@@ -93,6 +96,9 @@ TEST_SUITE(log_test_all)
     log_append_fcb();
     log_walk_fcb();
     log_flush_fcb();
+    log_deferred_fcb();
+    log_level_fcb();
+    log_walk_index_fcb();
 }
 
 #if MYNEWT_VAL(SELFTEST)
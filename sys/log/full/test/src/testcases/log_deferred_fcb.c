@@ -0,0 +1,96 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stdio.h>
+
+#include "log_test.h"
+
+#if MYNEWT_VAL(LOG_DEFERRED)
+
+static char log_deferred_expect[2][64];
+static int log_deferred_idx;
+
+static int
+log_deferred_walk(struct log *log, struct log_offset *log_offset,
+                  void *dptr, uint16_t len)
+{
+    struct log_entry_hdr ueh;
+    char data[128];
+    char text[128];
+    int dlen;
+    int rc;
+
+    TEST_ASSERT(log_deferred_idx < 2);
+
+    rc = log_read(log, dptr, &ueh, 0, sizeof(ueh));
+    TEST_ASSERT(rc == sizeof(ueh));
+
+    dlen = len - sizeof(ueh);
+    rc = log_read(log, dptr, data, sizeof(ueh), dlen);
+    TEST_ASSERT(rc == dlen);
+
+    rc = log_deferred_format(data, dlen, text, sizeof(text));
+    if (log_deferred_idx == 0) {
+        /* Stored in binary, and shorter than text. */
+        TEST_ASSERT(rc == strlen(log_deferred_expect[0]));
+        TEST_ASSERT(dlen < rc);
+    } else {
+        /* '*' width; formatted when logged. */
+        TEST_ASSERT(rc == -1);
+        data[dlen] = '\0';
+        strcpy(text, data);
+    }
+    TEST_ASSERT(strcmp(text, log_deferred_expect[log_deferred_idx]) == 0);
+    log_deferred_idx++;
+
+    return 0;
+}
+
+#endif
+
+TEST_CASE(log_deferred_fcb)
+{
+#if MYNEWT_VAL(LOG_DEFERRED)
+    static const char fmt1[] = "d=%d s=%s lx=%lx f=%5.2f llu=%llu 100%%";
+    static const char fmt2[] = "w=%*d";
+    struct log_offset log_offset = { 0 };
+    char text[8];
+    int rc;
+
+    rc = log_flush(&my_log);
+    TEST_ASSERT(rc == 0);
+
+    snprintf(log_deferred_expect[0], sizeof(log_deferred_expect[0]), fmt1,
+             -42, "some string", 0xbeefUL, 3.25, 1ULL << 40);
+    log_printf_deferred(&my_log, 0, 0, fmt1,
+                        -42, "some string", 0xbeefUL, 3.25, 1ULL << 40);
+
+    snprintf(log_deferred_expect[1], sizeof(log_deferred_expect[1]), fmt2,
+             4, 7);
+    log_printf_deferred(&my_log, 0, 0, fmt2, 4, 7);
+
+    log_deferred_idx = 0;
+    rc = log_walk(&my_log, log_deferred_walk, &log_offset);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(log_deferred_idx == 2);
+
+    /* Not a deferred entry. */
+    rc = log_deferred_format("text", 4, text, sizeof(text));
+    TEST_ASSERT(rc == -1);
+#endif
+}
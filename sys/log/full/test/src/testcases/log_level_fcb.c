@@ -0,0 +1,64 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "log_test.h"
+
+static int log_level_cnt;
+
+static int
+log_level_walk(struct log *log, struct log_offset *log_offset,
+               void *dptr, uint16_t len)
+{
+    struct log_entry_hdr ueh;
+    int rc;
+
+    rc = log_read(log, dptr, &ueh, 0, sizeof(ueh));
+    TEST_ASSERT(rc == sizeof(ueh));
+    TEST_ASSERT(ueh.ue_module != 3 || ueh.ue_level >= LOG_LEVEL_WARN);
+    log_level_cnt++;
+
+    return 0;
+}
+
+TEST_CASE(log_level_fcb)
+{
+    struct log_offset log_offset = { 0 };
+    int rc;
+
+    rc = log_flush(&my_log);
+    TEST_ASSERT(rc == 0);
+
+    rc = log_level_set(3, LOG_LEVEL_WARN);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(log_level_get(3) == LOG_LEVEL_WARN);
+    TEST_ASSERT(log_level_set(MYNEWT_VAL(LOG_MODULE_LEVELS),
+                              LOG_LEVEL_WARN) == OS_EINVAL);
+
+    LOG_INFO(&my_log, 3, "dropped %d", 1);
+    LOG_WARN(&my_log, 3, "kept %d", 2);
+    LOG_INFO(&my_log, 4, "kept %d", 3);
+    log_printf(&my_log, 3, LOG_LEVEL_DEBUG, "dropped %d", 4);
+
+    log_level_cnt = 0;
+    rc = log_walk(&my_log, log_level_walk, &log_offset);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(log_level_cnt == 2);
+
+    rc = log_level_set(3, 0);
+    TEST_ASSERT(rc == 0);
+}
@@ -0,0 +1,71 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "log_test.h"
+
+static struct flash_area *log_walk_index_area;
+static int log_walk_index_cnt;
+
+static int
+log_walk_index_walk(struct log *log, struct log_offset *log_offset,
+                    void *dptr, uint16_t len)
+{
+    struct log_entry_hdr ueh;
+    int rc;
+
+    /* Whole older sector is skipped. */
+    TEST_ASSERT(((struct fcb_entry *)dptr)->fe_area == log_walk_index_area);
+
+    rc = log_read(log, dptr, &ueh, 0, sizeof(ueh));
+    TEST_ASSERT(rc == sizeof(ueh));
+    if (ueh.ue_index >= log_offset->lo_index) {
+        log_walk_index_cnt++;
+    }
+
+    return 0;
+}
+
+TEST_CASE(log_walk_index_fcb)
+{
+    struct log_offset log_offset = { 0 };
+    struct flash_area *first;
+    uint32_t start;
+    int cnt;
+    int rc;
+
+    rc = log_flush(&my_log);
+    TEST_ASSERT(rc == 0);
+
+    /* Fill one sector, and put ten entries in the next one. */
+    LOG_WARN(&my_log, 0, "walk index");
+    first = log_fcb.f_active.fe_area;
+    while (log_fcb.f_active.fe_area == first) {
+        LOG_WARN(&my_log, 0, "walk index");
+    }
+    log_walk_index_area = log_fcb.f_active.fe_area;
+    start = g_log_info.li_next_index - 1;
+    for (cnt = 1; cnt < 10; cnt++) {
+        LOG_WARN(&my_log, 0, "walk index");
+    }
+
+    log_walk_index_cnt = 0;
+    log_offset.lo_index = start + 5;
+    rc = log_walk(&my_log, log_walk_index_walk, &log_offset);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(log_walk_index_cnt == 5);
+}
@@ -101,6 +101,23 @@ void shell_register_prompt_handler(shell_prompt_function_t handler);
  */
 void shell_register_default_module(const char *name);
 
+/** @brief Formatted output from a shell command.
+ *
+ *  Output is collected in a line buffer and handed to the console as one
+ *  block when a line is complete or the buffer fills, rather than character
+ *  by character.  Only to be used from the shell's own context, i.e. from
+ *  command handlers.
+ *
+ *  @return Number of characters formatted, as for printf.
+ */
+int shell_printf(const char *fmt, ...)
+    __attribute__ ((format (printf, 1, 2)));
+
+/** @brief Write out anything buffered by shell_printf(). Called by the
+ *  shell after each command completes.
+ */
+void shell_flush(void);
+
 #if MYNEWT_VAL(SHELL_NEWTMGR)
 struct os_mbuf;
 typedef int (*shell_nlip_input_func_t)(struct os_mbuf *, void *arg);
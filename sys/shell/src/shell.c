@@ -17,6 +17,8 @@
  * under the License.
  */
 
+#include <limits.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
@@ -39,6 +41,29 @@
 static struct shell_module shell_modules[MYNEWT_VAL(SHELL_MAX_MODULES)];
 static size_t num_of_shell_entities;
 
+/* Name hashes of the registered modules, compared before the names. */
+static uint32_t shell_module_hash[MYNEWT_VAL(SHELL_MAX_MODULES)];
+
+#if MYNEWT_VAL(SHELL_CMD_HASH_SIZE) > 0
+/*
+ * Open addressed command index, keyed by (module, command name).  If it ever
+ * fills up, lookups that miss fall back to scanning the command arrays.
+ */
+struct shell_cmd_hash_ent {
+    const struct shell_cmd *sc;
+    uint8_t module;
+};
+
+static struct shell_cmd_hash_ent
+    shell_cmd_hash[MYNEWT_VAL(SHELL_CMD_HASH_SIZE)];
+static uint8_t shell_cmd_hash_full;
+#endif
+
+#if MYNEWT_VAL(SHELL_OUT_BUF_SIZE) > 0
+static char shell_out_buf[MYNEWT_VAL(SHELL_OUT_BUF_SIZE)];
+static int shell_out_len;
+#endif
+
 static const char *prompt;
 static char default_module_prompt[PROMPT_MAX_LEN];
 static int default_module = -1;
@@ -115,6 +140,20 @@ line2argv(char *str, char *argv[], size_t size)
     return argc;
 }
 
+/* FNV-1a over at most len characters of str. */
+static uint32_t
+shell_hash(const char *str, int len)
+{
+    uint32_t h;
+
+    h = 2166136261u;
+    while (len-- > 0 && *str != '\0') {
+        h ^= (uint8_t)*str++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
 static int
 get_destination_module(const char *module_str, uint8_t len)
 {
@@ -130,6 +169,82 @@ get_destination_module(const char *module_str, uint8_t len)
     return -1;
 }
 
+/* Exact match of a full module name. */
+static int
+get_module_by_name(const char *name)
+{
+    uint32_t h;
+    int i;
+
+    h = shell_hash(name, MODULE_NAME_MAX_LEN);
+    for (i = 0; i < num_of_shell_entities; i++) {
+        if (shell_module_hash[i] == h &&
+            !strncmp(name, shell_modules[i].name, MODULE_NAME_MAX_LEN)) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+#if MYNEWT_VAL(SHELL_CMD_HASH_SIZE) > 0
+static void
+shell_cmd_hash_add(int module, const struct shell_cmd *sc)
+{
+    uint32_t idx;
+    int i;
+
+    idx = (shell_hash(sc->sc_cmd, INT_MAX) ^ module) %
+          MYNEWT_VAL(SHELL_CMD_HASH_SIZE);
+    for (i = 0; i < MYNEWT_VAL(SHELL_CMD_HASH_SIZE); i++) {
+        if (shell_cmd_hash[idx].sc == NULL) {
+            shell_cmd_hash[idx].sc = sc;
+            shell_cmd_hash[idx].module = module;
+            return;
+        }
+        idx = (idx + 1) % MYNEWT_VAL(SHELL_CMD_HASH_SIZE);
+    }
+    shell_cmd_hash_full = 1;
+}
+#endif
+
+/* Exact match of a command name within a module. */
+static const struct shell_cmd *
+get_command_by_name(int module, const char *command)
+{
+    const struct shell_module *shell_module;
+    int i;
+
+#if MYNEWT_VAL(SHELL_CMD_HASH_SIZE) > 0
+    uint32_t idx;
+
+    idx = (shell_hash(command, INT_MAX) ^ module) %
+          MYNEWT_VAL(SHELL_CMD_HASH_SIZE);
+    for (i = 0; i < MYNEWT_VAL(SHELL_CMD_HASH_SIZE); i++) {
+        if (shell_cmd_hash[idx].sc == NULL) {
+            break;
+        }
+        if (shell_cmd_hash[idx].module == module &&
+            !strcmp(command, shell_cmd_hash[idx].sc->sc_cmd)) {
+            return shell_cmd_hash[idx].sc;
+        }
+        idx = (idx + 1) % MYNEWT_VAL(SHELL_CMD_HASH_SIZE);
+    }
+    if (!shell_cmd_hash_full) {
+        return NULL;
+    }
+#endif
+
+    shell_module = &shell_modules[module];
+    for (i = 0; shell_module->commands[i].sc_cmd; i++) {
+        if (!strcmp(command, shell_module->commands[i].sc_cmd)) {
+            return &shell_module->commands[i];
+        }
+    }
+
+    return NULL;
+}
+
 /* For a specific command: argv[0] = module name, argv[1] = command name
  * If a default module was selected: argv[0] = command name
  */
@@ -149,7 +264,7 @@ get_command_and_module(char *argv[], int *module)
             return NULL;
         }
 
-        *module = get_destination_module(argv[0], MODULE_NAME_MAX_LEN);
+        *module = get_module_by_name(argv[0]);
         if (*module == -1) {
             console_printf("Illegal module %s\n", argv[0]);
             return NULL;
@@ -167,36 +282,30 @@ show_cmd_help(char *argv[])
 {
     const char *command = NULL;
     int module = -1;
-    const struct shell_module *shell_module = NULL;
-    int i;
+    const struct shell_cmd *cmd;
 
     command = get_command_and_module(argv, &module);
     if ((module == -1) || (command == NULL)) {
         return 0;
     }
 
-    shell_module = &shell_modules[module];
-    for (i = 0; shell_module->commands[i].sc_cmd; i++) {
-        if (!strcmp(command, shell_module->commands[i].sc_cmd)) {
-            console_printf("%s:\n", shell_module->commands[i].sc_cmd);
-
-            if (!shell_module->commands[i].help) {
-                console_printf("\n");
-                return 0;
-            }
-            if (shell_module->commands[i].help->usage) {
-                console_printf("%s\n", shell_module->commands[i].help->usage);
-            } else if (shell_module->commands[i].help->summary) {
-                console_printf("%s\n", shell_module->commands[i].help->summary);
-            } else {
-                console_printf("\n");
-            }
+    cmd = get_command_by_name(module, command);
+    if (cmd == NULL) {
+        console_printf("Unrecognized command: %s\n", argv[0]);
+        return 0;
+    }
 
-            return 0;
-        }
+    shell_printf("%s:\n", cmd->sc_cmd);
+    if (!cmd->help) {
+        shell_printf("\n");
+    } else if (cmd->help->usage) {
+        shell_printf("%s\n", cmd->help->usage);
+    } else if (cmd->help->summary) {
+        shell_printf("%s\n", cmd->help->summary);
+    } else {
+        shell_printf("\n");
     }
 
-    console_printf("Unrecognized command: %s\n", argv[0]);
     return 0;
 }
 
@@ -206,7 +315,7 @@ print_modules(void)
     int module;
 
     for (module = 0; module < num_of_shell_entities; module++) {
-        console_printf("%s\n", shell_modules[module].name);
+        shell_printf("%s\n", shell_modules[module].name);
     }
 }
 
@@ -216,15 +325,15 @@ print_module_commands(const int module)
     const struct shell_module *shell_module = &shell_modules[module];
     int i;
 
-    console_printf("help\n");
+    shell_printf("help\n");
 
     for (i = 0; shell_module->commands[i].sc_cmd; i++) {
-        console_printf("%-30s", shell_module->commands[i].sc_cmd);
+        shell_printf("%-30s", shell_module->commands[i].sc_cmd);
         if (shell_module->commands[i].help &&
             shell_module->commands[i].help->summary) {
-        console_printf("%s", shell_module->commands[i].help->summary);
+        shell_printf("%s", shell_module->commands[i].help->summary);
         }
-        console_printf("\n");
+        shell_printf("\n");
     }
 }
 
@@ -241,7 +350,7 @@ show_help(int argc, char *argv[])
     /* help per module */
     if ((argc == 2) || ((default_module != -1) && (argc == 1))) {
         if (default_module == -1) {
-            module = get_destination_module(argv[1], MODULE_NAME_MAX_LEN);
+            module = get_module_by_name(argv[1]);
             if (module == -1) {
                 console_printf("Illegal module %s\n", argv[1]);
                 return 0;
@@ -271,7 +380,7 @@ set_default_module(const char *name)
         return -1;
     }
 
-    module = get_destination_module(name, MODULE_NAME_MAX_LEN);
+    module = get_module_by_name(name);
 
     if (module == -1) {
         console_printf("Illegal module %s, default is not changed\n", name);
@@ -303,9 +412,8 @@ get_cb(int argc, char *argv[])
 {
     const char *first_string = argv[0];
     int module = -1;
-    const struct shell_module *shell_module;
+    const struct shell_cmd *cmd;
     const char *command;
-    int i;
 
     if (!first_string || first_string[0] == '\0') {
         console_printf("Illegal parameter\n");
@@ -330,15 +438,12 @@ get_cb(int argc, char *argv[])
         return NULL;
     }
 
-    shell_module = &shell_modules[module];
-    console_printf("module: %d, command: %s\n", module, command);
-    for (i = 0; shell_module->commands[i].sc_cmd; i++) {
-        if (!strcmp(command, shell_module->commands[i].sc_cmd)) {
-            return shell_module->commands[i].sc_cmd_func;
-        }
+    cmd = get_command_by_name(module, command);
+    if (cmd == NULL) {
+        return NULL;
     }
 
-    return NULL;
+    return cmd->sc_cmd_func;
 }
 
 static void
@@ -379,6 +484,7 @@ shell_process_command(char *line)
         show_cmd_help(argv);
     }
 
+    shell_flush();
     console_printf("%s", get_prompt());
 }
 
@@ -872,17 +978,88 @@ line_queue_init(void)
 int
 shell_register(const char *module_name, const struct shell_cmd *commands)
 {
+#if MYNEWT_VAL(SHELL_CMD_HASH_SIZE) > 0
+    int i;
+#endif
+
     if (num_of_shell_entities >= MYNEWT_VAL(SHELL_MAX_MODULES)) {
         return -1;
     }
 
     shell_modules[num_of_shell_entities].name = module_name;
     shell_modules[num_of_shell_entities].commands = commands;
+    shell_module_hash[num_of_shell_entities] =
+        shell_hash(module_name, MODULE_NAME_MAX_LEN);
+#if MYNEWT_VAL(SHELL_CMD_HASH_SIZE) > 0
+    for (i = 0; commands[i].sc_cmd; i++) {
+        shell_cmd_hash_add(num_of_shell_entities, &commands[i]);
+    }
+#endif
     ++num_of_shell_entities;
 
     return 0;
 }
 
+void
+shell_flush(void)
+{
+#if MYNEWT_VAL(SHELL_OUT_BUF_SIZE) > 0
+    if (shell_out_len > 0) {
+        console_write(shell_out_buf, shell_out_len);
+        shell_out_len = 0;
+    }
+#endif
+}
+
+int
+shell_printf(const char *fmt, ...)
+{
+    va_list args;
+    int num_chars;
+#if MYNEWT_VAL(SHELL_OUT_BUF_SIZE) > 0
+    int room;
+
+    room = sizeof(shell_out_buf) - shell_out_len;
+    va_start(args, fmt);
+    num_chars = vsnprintf(shell_out_buf + shell_out_len, room, fmt, args);
+    va_end(args);
+    if (num_chars < 0) {
+        return num_chars;
+    }
+
+    if (num_chars >= room && shell_out_len > 0) {
+        /* Did not fit behind what is already buffered; retry on its own. */
+        shell_flush();
+        room = sizeof(shell_out_buf);
+        va_start(args, fmt);
+        num_chars = vsnprintf(shell_out_buf, room, fmt, args);
+        va_end(args);
+    }
+
+    if (num_chars >= room) {
+        /* Longer than the whole buffer; output what fit. */
+        shell_out_len = room - 1;
+        shell_flush();
+    } else {
+        shell_out_len += num_chars;
+        if (shell_out_len > 0 && shell_out_buf[shell_out_len - 1] == '\n') {
+            shell_flush();
+        }
+    }
+#else
+    char buf[128];
+
+    va_start(args, fmt);
+    num_chars = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    if (num_chars > 0) {
+        console_write(buf, min(num_chars, sizeof(buf) - 1));
+    }
+#endif
+
+    return num_chars;
+}
+
 #if MYNEWT_VAL(SHELL_COMPAT)
 #define SHELL_COMPAT_MODULE_NAME "compat"
 static struct shell_cmd compat_commands[MYNEWT_VAL(SHELL_MAX_COMPAT_COMMANDS)];
@@ -892,6 +1069,10 @@ static int module_registered;
 int
 shell_cmd_register(const struct shell_cmd *sc)
 {
+#if MYNEWT_VAL(SHELL_CMD_HASH_SIZE) > 0
+    int module;
+#endif
+
     if (num_compat_commands >= MYNEWT_VAL(SHELL_MAX_COMPAT_COMMANDS)) {
         console_printf("Max number of compat commands reached\n");
         assert(0);
@@ -905,6 +1086,12 @@ shell_cmd_register(const struct shell_cmd *sc)
 
     compat_commands[num_compat_commands].sc_cmd = sc->sc_cmd;
     compat_commands[num_compat_commands].sc_cmd_func = sc->sc_cmd_func;
+#if MYNEWT_VAL(SHELL_CMD_HASH_SIZE) > 0
+    module = get_module_by_name(SHELL_COMPAT_MODULE_NAME);
+    if (module != -1) {
+        shell_cmd_hash_add(module, &compat_commands[num_compat_commands]);
+    }
+#endif
     ++num_compat_commands;
     return 0;
 }
@@ -18,9 +18,11 @@
  */
 
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "syscfg/syscfg.h"
+#include "sysinit/sysinit.h"
 #include "os/os.h"
 #include "datetime/datetime.h"
 #include "console/console.h"
@@ -30,21 +32,102 @@
 
 #define SHELL_OS "os"
 
+#if MYNEWT_VAL(OS_TASK_PROFILE)
+/*
+ * Shows profiler times, in os_task_prof_time() units, and each task's share
+ * of the total in tenths of a percent.
+ */
+static int
+shell_os_tasks_prof_display(const char *name)
+{
+    struct os_task *prev_task;
+    struct os_task_info oti;
+    uint64_t total;
+    int found;
+
+    total = 0;
+    prev_task = NULL;
+    while (1) {
+        prev_task = os_task_info_get_next(prev_task, &oti);
+        if (prev_task == NULL) {
+            break;
+        }
+        total += oti.oti_prof_run + oti.oti_prof_isr;
+    }
+    if (total == 0) {
+        total = 1;
+    }
+
+    found = 0;
+    console_printf("Tasks: \n");
+    console_printf("%8s %3s %10s %10s %10s %8s %6s\n",
+      "task", "pri", "run", "isr", "maxrun", "csw", "cpu%");
+    prev_task = NULL;
+    while (1) {
+        prev_task = os_task_info_get_next(prev_task, &oti);
+        if (prev_task == NULL) {
+            break;
+        }
+
+        if (name) {
+            if (strcmp(name, oti.oti_name)) {
+                continue;
+            } else {
+                found = 1;
+            }
+        }
+
+        console_printf("%8s %3u %10lu %10lu %10lu %8lu %4u.%u\n",
+                oti.oti_name, oti.oti_prio,
+                (unsigned long)oti.oti_prof_run,
+                (unsigned long)oti.oti_prof_isr,
+                (unsigned long)oti.oti_prof_max_run,
+                (unsigned long)oti.oti_cswcnt,
+                (unsigned)(oti.oti_prof_run * 1000ULL / total / 10),
+                (unsigned)(oti.oti_prof_run * 1000ULL / total % 10));
+    }
+
+    if (name && !found) {
+        console_printf("Couldn't find task with name %s\n", name);
+    }
+
+    return 0;
+}
+#endif
+
 int
 shell_os_tasks_display_cmd(int argc, char **argv)
 {
     struct os_task *prev_task;
     struct os_task_info oti;
     char *name;
+    int verbose;
     int found;
 
     name = NULL;
+    verbose = 0;
     found = 0;
 
+    if (argc > 1 && !strcmp(argv[1], "-v")) {
+        verbose = 1;
+        argc--;
+        argv++;
+    }
+
     if (argc > 1 && strcmp(argv[1], "")) {
         name = argv[1];
     }
 
+#if MYNEWT_VAL(OS_TASK_PROFILE)
+    if (verbose) {
+        return shell_os_tasks_prof_display(name);
+    }
+#else
+    if (verbose) {
+        console_printf("Task profiling disabled (OS_TASK_PROFILE)\n");
+    }
+#endif
+
     console_printf("Tasks: \n");
     prev_task = NULL;
     console_printf("%8s %3s %3s %8s %8s %8s %8s %8s %8s %3s\n",
@@ -97,8 +180,8 @@ shell_os_mpool_display_cmd(int argc, char **argv)
 
     console_printf("Mempools: \n");
     mp = NULL;
-    console_printf("%32s %5s %4s %4s %4s\n", "name", "blksz", "cnt", "free",
-                   "min");
+    console_printf("%32s %5s %4s %4s %4s %5s\n", "name", "blksz", "cnt",
+                   "free", "min", "exh");
     while (1) {
         mp = os_mempool_info_get_next(mp, &omi);
         if (mp == NULL) {
@@ -113,9 +196,10 @@ shell_os_mpool_display_cmd(int argc, char **argv)
             }
         }
 
-        console_printf("%32s %5d %4d %4d %4d\n", omi.omi_name,
+        console_printf("%32s %5d %4d %4d %4d %5d\n", omi.omi_name,
                        omi.omi_block_size, omi.omi_num_blocks,
-                       omi.omi_num_free, omi.omi_min_free);
+                       omi.omi_num_free, omi.omi_min_free,
+                       omi.omi_num_exhausted);
     }
 
     if (name && !found) {
@@ -126,6 +210,127 @@ shell_os_mpool_display_cmd(int argc, char **argv)
     return 0;
 }
 
+#if MYNEWT_VAL(OS_MEMPOOL_OWNER)
+int
+shell_os_mpowner_display_cmd(int argc, char **argv)
+{
+    struct os_memblock_owner omo;
+    char *name;
+    int idx;
+
+    name = NULL;
+    if (argc > 1 && strcmp(argv[1], "")) {
+        name = argv[1];
+    }
+
+    console_printf("%32s %10s %10s %4s\n", "pool", "block", "caller",
+                   "task");
+    idx = 0;
+    while (os_memblock_owner_get_next(&idx, &omo) == 0) {
+        if (name && strcmp(name, omo.omo_pool->name)) {
+            continue;
+        }
+        console_printf("%32s %10p %10p %4d\n", omo.omo_pool->name,
+                       omo.omo_block, omo.omo_ra, omo.omo_taskid);
+    }
+    console_printf("untracked: %lu\n",
+                   (unsigned long)os_memblock_owner_untracked());
+
+    return 0;
+}
+#endif
+
+#if MYNEWT_VAL(OS_MUTEX_STATS)
+int
+shell_os_mutex_display_cmd(int argc, char **argv)
+{
+    struct os_mutex *mu;
+    struct os_mutex_info omi;
+
+    console_printf("Mutexes: \n");
+    mu = NULL;
+    console_printf("%16s %5s %5s %5s %10s\n", "name", "owner", "level",
+                   "wait", "contended");
+    while (1) {
+        mu = os_mutex_info_get_next(mu, &omi);
+        if (mu == NULL) {
+            break;
+        }
+
+        if (omi.omi_owner_id == 0xff) {
+            console_printf("%16s %5s", omi.omi_name, "-");
+        } else {
+            console_printf("%16s %5u", omi.omi_name, omi.omi_owner_id);
+        }
+        console_printf(" %5u %5u %10lu\n", omi.omi_level,
+                       omi.omi_num_waiters,
+                       (unsigned long)omi.omi_contended);
+    }
+
+    return 0;
+}
+#endif
+
+#if MYNEWT_VAL(BASELIBC_PRESENT)
+/*
+ * Fragmentation is the share of free memory, in percent, that is not in the
+ * largest free block.
+ */
+int
+shell_os_heap_display_cmd(int argc, char **argv)
+{
+    size_t free_bytes;
+    size_t largest;
+
+    get_malloc_memory_status(&free_bytes, &largest);
+
+    console_printf("Heap: \n");
+    console_printf("%10s %10s %5s\n", "free", "largest", "frag");
+    console_printf("%10lu %10lu %4u%%\n", (unsigned long)free_bytes,
+                   (unsigned long)largest,
+                   free_bytes ?
+                       (unsigned)(100 - (uint64_t)largest * 100 / free_bytes) :
+                       0);
+
+    return 0;
+}
+#endif
+
+#if MYNEWT_VAL(SYSINIT_PROFILE) || MYNEWT_VAL(OS_DEV_INIT_PROFILE)
+int
+shell_os_boot_display_cmd(int argc, char **argv)
+{
+#if MYNEWT_VAL(SYSINIT_PROFILE)
+    const char *name;
+    uint32_t usecs;
+    int i;
+#endif
+#if MYNEWT_VAL(OS_DEV_INIT_PROFILE)
+    struct os_dev *dev;
+#endif
+
+#if MYNEWT_VAL(SYSINIT_PROFILE)
+    console_printf("Boot steps: \n");
+    console_printf("%24s %10s\n", "name", "usecs");
+    for (i = 0; sysinit_profile_get(i, &name, &usecs) == 0; i++) {
+        console_printf("%24s %10lu\n", name, (unsigned long)usecs);
+    }
+#endif
+
+#if MYNEWT_VAL(OS_DEV_INIT_PROFILE)
+    console_printf("Device init: \n");
+    console_printf("%24s %5s %10s\n", "name", "stage", "usecs");
+    dev = NULL;
+    while ((dev = os_dev_get_next(dev)) != NULL) {
+        console_printf("%24s %5u %10lu\n", dev->od_name, dev->od_stage,
+                       (unsigned long)dev->od_init_usecs);
+    }
+#endif
+
+    return 0;
+}
+#endif
+
 int
 shell_os_date_cmd(int argc, char **argv)
 {
@@ -160,6 +365,7 @@ shell_os_date_cmd(int argc, char **argv)
 
 #if MYNEWT_VAL(SHELL_CMD_HELP)
 static const struct shell_param tasks_params[] = {
+    {"-v", "show profiler times"},
     {"", "task name"},
     {NULL, NULL}
 };
@@ -181,6 +387,38 @@ static const struct shell_cmd_help mpool_help = {
     .params = mpool_params,
 };
 
+#if MYNEWT_VAL(OS_MEMPOOL_OWNER)
+static const struct shell_cmd_help mpowner_help = {
+    .summary = "show taken mpool blocks and their owners",
+    .usage = NULL,
+    .params = mpool_params,
+};
+#endif
+
+#if MYNEWT_VAL(OS_MUTEX_STATS)
+static const struct shell_cmd_help mutex_help = {
+    .summary = "show registered mutexes",
+    .usage = NULL,
+    .params = NULL,
+};
+#endif
+
+#if MYNEWT_VAL(SYSINIT_PROFILE) || MYNEWT_VAL(OS_DEV_INIT_PROFILE)
+static const struct shell_cmd_help boot_help = {
+    .summary = "show boot timing",
+    .usage = NULL,
+    .params = NULL,
+};
+#endif
+
+#if MYNEWT_VAL(BASELIBC_PRESENT)
+static const struct shell_cmd_help heap_help = {
+    .summary = "show heap free space and fragmentation",
+    .usage = NULL,
+    .params = NULL,
+};
+#endif
+
 static const struct shell_param date_params[] = {
     {"", "datetime to set"},
     {NULL, NULL}
@@ -208,6 +446,42 @@ static const struct shell_cmd os_commands[] = {
         .help = &mpool_help,
 #endif
     },
+#if MYNEWT_VAL(OS_MEMPOOL_OWNER)
+    {
+        .sc_cmd = "mpowner",
+        .sc_cmd_func = shell_os_mpowner_display_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+        .help = &mpowner_help,
+#endif
+    },
+#endif
+#if MYNEWT_VAL(OS_MUTEX_STATS)
+    {
+        .sc_cmd = "mutex",
+        .sc_cmd_func = shell_os_mutex_display_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+        .help = &mutex_help,
+#endif
+    },
+#endif
+#if MYNEWT_VAL(SYSINIT_PROFILE) || MYNEWT_VAL(OS_DEV_INIT_PROFILE)
+    {
+        .sc_cmd = "boot",
+        .sc_cmd_func = shell_os_boot_display_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+        .help = &boot_help,
+#endif
+    },
+#endif
+#if MYNEWT_VAL(BASELIBC_PRESENT)
+    {
+        .sc_cmd = "heap",
+        .sc_cmd_func = shell_os_heap_display_cmd,
+#if MYNEWT_VAL(SHELL_CMD_HELP)
+        .help = &heap_help,
+#endif
+    },
+#endif
     {
         .sc_cmd = "date",
         .sc_cmd_func = shell_os_date_cmd,
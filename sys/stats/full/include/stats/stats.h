@@ -23,6 +23,9 @@
 #include <stdint.h>
 #include "syscfg/syscfg.h"
 #include "os/queue.h"
+#if MYNEWT_VAL(STATS_ISR_SAFE)
+#include "os/os.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -37,12 +40,20 @@ struct stats_hdr {
     char *s_name;
     uint8_t s_size;
     uint8_t s_cnt;
-    uint16_t s_pad1;
+    uint8_t s_type;
+    uint8_t s_pad1;
+#if MYNEWT_VAL(STATS_ISR_SAFE)
+    uint32_t s_seq;     /* Odd while an update is in progress */
+#endif
 #if MYNEWT_VAL(STATS_NAMES)
     const struct stats_name_map *s_map;
     int s_map_cnt;
 #endif
     STAILQ_ENTRY(stats_hdr) s_next;
+#if MYNEWT_VAL(STATS_GROUP_HASH_SIZE) > 0
+    uint32_t s_hash;
+    struct stats_hdr *s_hash_next;
+#endif
 };
 
 #define STATS_SECT_DECL(__name)             \
@@ -59,14 +70,65 @@ STATS_SECT_DECL(__name) {                   \
 
 #define STATS_HDR(__sectname) &(__sectname).s_hdr
 
+/*
+ * Besides counters, a section can hold histograms, gauges or rate
+ * counters.  All entries in a section are of the same kind; the kind is
+ * told apart by entry size, which is why these sizes differ from counter
+ * sizes.
+ */
+#define STATS_TYPE_CNT      0
+#define STATS_TYPE_HIST     1
+#define STATS_TYPE_GAUGE    2
+#define STATS_TYPE_RATE     3
+
+/*
+ * Log2 histogram.  Bucket n counts values in [2^n, 2^(n+1)); bucket 0 also
+ * counts 0, and the last bucket counts everything above.
+ */
+struct stats_hist {
+    uint32_t sh_bucket[MYNEWT_VAL(STATS_HIST_BUCKETS)];
+};
+
+/*
+ * Min, max and sum of values recorded.  Only 4 byte aligned, so that it
+ * follows struct stats_hdr without padding.
+ */
+struct stats_gauge {
+    uint32_t sg_cnt;
+    uint32_t sg_min;
+    uint32_t sg_max;
+    uint64_t sg_sum;
+} __attribute__((packed, aligned(4)));
+
+/*
+ * Event counter, reported with events per second since the previous read.
+ */
+struct stats_rate {
+    uint32_t sr_cnt;
+    uint32_t sr_prev_cnt;
+    uint32_t sr_prev_time;
+    uint32_t sr_rate;
+};
+
 #define STATS_SIZE_16 (sizeof(uint16_t))
 #define STATS_SIZE_32 (sizeof(uint32_t))
 #define STATS_SIZE_64 (sizeof(uint64_t))
+#define STATS_SIZE_HIST (sizeof(struct stats_hist))
+#define STATS_SIZE_GAUGE (sizeof(struct stats_gauge))
+#define STATS_SIZE_RATE (sizeof(struct stats_rate))
+
+#define STATS_TYPE_OF_SIZE(__size)                                      \
+    ((__size) == STATS_SIZE_HIST ? STATS_TYPE_HIST :                    \
+     (__size) == STATS_SIZE_GAUGE ? STATS_TYPE_GAUGE :                  \
+     (__size) == STATS_SIZE_RATE ? STATS_TYPE_RATE : STATS_TYPE_CNT)
 
 #define STATS_SECT_ENTRY(__var) uint32_t STATS_SECT_VAR(__var);
 #define STATS_SECT_ENTRY16(__var) uint16_t STATS_SECT_VAR(__var);
 #define STATS_SECT_ENTRY32(__var) uint32_t STATS_SECT_VAR(__var);
 #define STATS_SECT_ENTRY64(__var) uint64_t STATS_SECT_VAR(__var);
+#define STATS_SECT_HIST(__var) struct stats_hist STATS_SECT_VAR(__var);
+#define STATS_SECT_GAUGE(__var) struct stats_gauge STATS_SECT_VAR(__var);
+#define STATS_SECT_RATE(__var) struct stats_rate STATS_SECT_VAR(__var);
 #define STATS_RESET(__var)                                              \
     memset((uint8_t *)&__var + sizeof(struct stats_hdr), 0,             \
            sizeof(__var) - sizeof(struct stats_hdr))
@@ -75,14 +137,78 @@ STATS_SECT_DECL(__name) {                   \
     (__size),                                                               \
     ((sizeof (__sectvarname)) - sizeof (struct stats_hdr)) / (__size)
 
-#define STATS_INC(__sectvarname, __var)        \
-    ((__sectvarname).STATS_SECT_VAR(__var)++)
+/*
+ * With STATS_ISR_SAFE, updates are done with interrupts disabled, so that
+ * increments from ISRs and tasks don't get lost and 64-bit counters are
+ * written as a whole.  The section sequence number is bumped around each
+ * update; stats_snapshot() uses it to take a consistent copy.
+ */
+#if MYNEWT_VAL(STATS_ISR_SAFE)
+#define STATS_UPDATE(__sectvarname, __stmt) do {                        \
+    os_sr_t __stats_sr;                                                 \
+                                                                        \
+    OS_ENTER_CRITICAL(__stats_sr);                                      \
+    (__sectvarname).s_hdr.s_seq++;                                      \
+    __stmt;                                                             \
+    (__sectvarname).s_hdr.s_seq++;                                      \
+    OS_EXIT_CRITICAL(__stats_sr);                                       \
+} while (0)
+#else
+#define STATS_UPDATE(__sectvarname, __stmt) do {                        \
+    __stmt;                                                             \
+} while (0)
+#endif
+
+#define STATS_INC(__sectvarname, __var)                                 \
+    STATS_UPDATE(__sectvarname, (__sectvarname).STATS_SECT_VAR(__var)++)
+
+#define STATS_INCN(__sectvarname, __var, __n)                           \
+    STATS_UPDATE(__sectvarname,                                         \
+      (__sectvarname).STATS_SECT_VAR(__var) += (__n))
 
-#define STATS_INCN(__sectvarname, __var, __n)  \
-    ((__sectvarname).STATS_SECT_VAR(__var) += (__n))
+#define STATS_CLEAR(__sectvarname, __var)                               \
+    STATS_UPDATE(__sectvarname, (__sectvarname).STATS_SECT_VAR(__var) = 0)
 
-#define STATS_CLEAR(__sectvarname, __var)        \
-    ((__sectvarname).STATS_SECT_VAR(__var) = 0)
+static inline void
+stats_hist_add(struct stats_hist *sh, uint32_t val)
+{
+    int n;
+
+    n = val ? 31 - __builtin_clz(val) : 0;
+    if (n >= MYNEWT_VAL(STATS_HIST_BUCKETS)) {
+        n = MYNEWT_VAL(STATS_HIST_BUCKETS) - 1;
+    }
+    sh->sh_bucket[n]++;
+}
+
+static inline void
+stats_gauge_add(struct stats_gauge *sg, uint32_t val)
+{
+    if (sg->sg_cnt == 0 || val < sg->sg_min) {
+        sg->sg_min = val;
+    }
+    if (val > sg->sg_max) {
+        sg->sg_max = val;
+    }
+    sg->sg_cnt++;
+    sg->sg_sum += val;
+}
+
+#define STATS_HIST_ADD(__sectvarname, __var, __val)                     \
+    STATS_UPDATE(__sectvarname,                                         \
+      stats_hist_add(&(__sectvarname).STATS_SECT_VAR(__var), (__val)))
+
+#define STATS_GAUGE_ADD(__sectvarname, __var, __val)                    \
+    STATS_UPDATE(__sectvarname,                                         \
+      stats_gauge_add(&(__sectvarname).STATS_SECT_VAR(__var), (__val)))
+
+#define STATS_RATE_INC(__sectvarname, __var)                            \
+    STATS_UPDATE(__sectvarname,                                         \
+      (__sectvarname).STATS_SECT_VAR(__var).sr_cnt++)
+
+#define STATS_RATE_INCN(__sectvarname, __var, __n)                      \
+    STATS_UPDATE(__sectvarname,                                         \
+      (__sectvarname).STATS_SECT_VAR(__var).sr_cnt += (__n))
 
 #if MYNEWT_VAL(STATS_NAMES)
 
@@ -102,15 +228,43 @@ const struct stats_name_map STATS_NAME_MAP_NAME(__sectname)[] = {
     &(STATS_NAME_MAP_NAME(__name)[0]),                                      \
     (sizeof(STATS_NAME_MAP_NAME(__name)) / sizeof(struct stats_name_map))
 
+#define STATS_STATIC_NAME_INIT(__name)                                      \
+    .s_map = &(STATS_NAME_MAP_NAME(__name)[0]),                             \
+    .s_map_cnt = sizeof(STATS_NAME_MAP_NAME(__name)) /                      \
+                 sizeof(struct stats_name_map),
+
 #else /* MYNEWT_VAL(STATS_NAME) */
 
 #define STATS_NAME_START(__name)
 #define STATS_NAME(__name, __entry)
 #define STATS_NAME_END(__name)
 #define STATS_NAME_INIT_PARMS(__name) NULL, 0
+#define STATS_STATIC_NAME_INIT(__name)
 
 #endif /* MYNEWT_VAL(STATS_NAME) */
 
+/*
+ * Define statistics section variable __var, initialized at compile time
+ * and registered as __name by stats_module_init(); there's no need to
+ * call stats_init() or stats_register() for it.  The name map must come
+ * before this.  A pointer to the section is placed in the
+ * "stats_static" linker section, found through the __start_/__stop_
+ * symbols GNU ld provides.
+ */
+#define STATS_SECT_STATIC(__sectname, __var, __size, __name)                \
+STATS_SECT_DECL(__sectname) __var = {                                       \
+    .s_hdr = {                                                              \
+        .s_name = (__name),                                                 \
+        .s_size = (__size),                                                 \
+        .s_cnt = (sizeof(STATS_SECT_DECL(__sectname)) -                     \
+                  sizeof(struct stats_hdr)) / (__size),                     \
+        .s_type = STATS_TYPE_OF_SIZE(__size),                               \
+        STATS_STATIC_NAME_INIT(__sectname)                                  \
+    }                                                                       \
+};                                                                          \
+struct stats_hdr * const stats_static_ ## __var                             \
+    __attribute__((used, section("stats_static"))) = &(__var).s_hdr
+
 int stats_init(struct stats_hdr *shdr, uint8_t size, uint8_t cnt,
     const struct stats_name_map *map, uint8_t map_cnt);
 int stats_register(char *name, struct stats_hdr *shdr);
@@ -118,6 +272,8 @@ int stats_init_and_reg(struct stats_hdr *shdr, uint8_t size, uint8_t cnt,
                        const struct stats_name_map *map, uint8_t map_cnt,
                        char *name);
 void stats_reset(struct stats_hdr *shdr);
+uint32_t stats_rate_read(struct stats_rate *sr);
+int stats_snapshot(struct stats_hdr *hdr, struct stats_hdr *copy, int len);
 
 typedef int (*stats_walk_func_t)(struct stats_hdr *, void *, char *,
         uint16_t);
@@ -59,6 +59,15 @@
  *
  * - STATS_SECT_ENTRY64(): 64-bits.  Useful for storing chunks of data.
  *
+ * A section may instead hold only one of the following, recorded with
+ * STATS_HIST_ADD(), STATS_GAUGE_ADD() and STATS_RATE_INC():
+ *
+ * - STATS_SECT_HIST(): log2 histogram, for latency distributions.
+ *
+ * - STATS_SECT_GAUGE(): min/max/average of recorded values.
+ *
+ * - STATS_SECT_RATE(): counter, reported with its rate per second.
+ *
  * Following the statics entry declaration is the statistic names declaration.
  * This is compiled out when STATS_NAME_ENABLE is set to 0.  This declaration
  * is const, and therefore can be located in .text, not .data.
@@ -78,9 +87,36 @@ STATS_NAME_START(stats)
     STATS_NAME(stats, num_registered)
 STATS_NAME_END(stats)
 
+/* Section type is derived from entry size. */
+#if MYNEWT_VAL(STATS_HIST_BUCKETS) < 7 || MYNEWT_VAL(STATS_HIST_BUCKETS) > 32
+#error "STATS_HIST_BUCKETS must be between 7 and 32"
+#endif
+
 STAILQ_HEAD(, stats_hdr) g_stats_registry =
     STAILQ_HEAD_INITIALIZER(g_stats_registry);
 
+/* Sections defined with STATS_SECT_STATIC(); NULL if there are none. */
+extern struct stats_hdr * const __start_stats_static[] __attribute__((weak));
+extern struct stats_hdr * const __stop_stats_static[] __attribute__((weak));
+
+#if MYNEWT_VAL(STATS_GROUP_HASH_SIZE) > 0
+static struct stats_hdr *stats_group_hash[MYNEWT_VAL(STATS_GROUP_HASH_SIZE)];
+
+static uint32_t
+stats_name_hash(const char *name)
+{
+    uint32_t hash;
+
+    /* FNV-1a */
+    hash = 2166136261u;
+    while (*name) {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+#endif
+
 
 /**
  * Walk a specific statistic entry, and call walk_func with arg for
@@ -170,12 +206,16 @@ err:
 void
 stats_module_init(void)
 {
+    struct stats_hdr * const *sp;
     int rc;
 
     /* Ensure this function only gets called by sysinit. */
     SYSINIT_ASSERT_ACTIVE();
 
     STAILQ_INIT(&g_stats_registry);
+#if MYNEWT_VAL(STATS_GROUP_HASH_SIZE) > 0
+    memset(stats_group_hash, 0, sizeof(stats_group_hash));
+#endif
 
 #if MYNEWT_VAL(STATS_CLI)
     rc = stats_shell_register();
@@ -194,6 +234,11 @@ stats_module_init(void)
 
     rc = stats_register("stat", STATS_HDR(g_stats_stats));
     SYSINIT_PANIC_ASSERT(rc == 0);
+
+    for (sp = __start_stats_static; sp < __stop_stats_static; sp++) {
+        rc = stats_register((*sp)->s_name, *sp);
+        SYSINIT_PANIC_ASSERT(rc == 0);
+    }
 }
 
 
@@ -204,7 +249,8 @@ stats_module_init(void)
  *            like statistic section name, size of statistics entries,
  *            number of statistics, etc.
  * @param size The size of the individual statistics elements, either
- *             2 (16-bits), 4 (32-bits) or 8 (64-bits).
+ *             2 (16-bits), 4 (32-bits) or 8 (64-bits), or one of
+ *             STATS_SIZE_HIST, STATS_SIZE_GAUGE or STATS_SIZE_RATE.
  * @param cnt The number of elements in the statistics structure
  * @param map The mapping of statistics name to statistic entry
  * @param map_cnt The number of items in the statistics map
@@ -219,6 +265,7 @@ stats_init(struct stats_hdr *shdr, uint8_t size, uint8_t cnt,
 
     shdr->s_size = size;
     shdr->s_cnt = cnt;
+    shdr->s_type = STATS_TYPE_OF_SIZE(size);
 #if MYNEWT_VAL(STATS_NAMES)
     shdr->s_map = map;
     shdr->s_map_cnt = map_cnt;
@@ -268,13 +315,25 @@ struct stats_hdr *
 stats_group_find(char *name)
 {
     struct stats_hdr *cur;
+#if MYNEWT_VAL(STATS_GROUP_HASH_SIZE) > 0
+    uint32_t hash;
 
+    hash = stats_name_hash(name);
+    cur = stats_group_hash[hash % MYNEWT_VAL(STATS_GROUP_HASH_SIZE)];
+    while (cur) {
+        if (cur->s_hash == hash && !strcmp(cur->s_name, name)) {
+            break;
+        }
+        cur = cur->s_hash_next;
+    }
+#else
     cur = NULL;
     STAILQ_FOREACH(cur, &g_stats_registry, s_next) {
         if (!strcmp(cur->s_name, name)) {
             break;
         }
     }
+#endif
 
     return (cur);
 }
@@ -293,22 +352,29 @@ stats_group_find(char *name)
 int
 stats_register(char *name, struct stats_hdr *shdr)
 {
-    struct stats_hdr *cur;
     int rc;
+#if MYNEWT_VAL(STATS_GROUP_HASH_SIZE) > 0
+    struct stats_hdr **bucket;
+#endif
 
     /* Don't allow duplicate entries, return an error if this stat
      * is already registered.
      */
-    STAILQ_FOREACH(cur, &g_stats_registry, s_next) {
-        if (!strcmp(cur->s_name, name)) {
-            rc = -1;
-            goto err;
-        }
+    if (stats_group_find(name)) {
+        rc = -1;
+        goto err;
     }
 
     shdr->s_name = name;
 
     STAILQ_INSERT_TAIL(&g_stats_registry, shdr, s_next);
+#if MYNEWT_VAL(STATS_GROUP_HASH_SIZE) > 0
+    shdr->s_hash = stats_name_hash(name);
+    bucket = &stats_group_hash[shdr->s_hash %
+                               MYNEWT_VAL(STATS_GROUP_HASH_SIZE)];
+    shdr->s_hash_next = *bucket;
+    *bucket = shdr;
+#endif
 
     STATS_INC(g_stats_stats, num_registered);
 
@@ -378,6 +444,9 @@ stats_reset(struct stats_hdr *hdr)
             case sizeof(uint64_t):
                 *(uint64_t *)stat_val = 0;
                 break;
+            default:
+                memset(stat_val, 0, hdr->s_size);
+                break;
         }
 
         /*
@@ -388,3 +457,83 @@ stats_reset(struct stats_hdr *hdr)
     }
     return;
 }
+
+/**
+ * Returns the rate of a rate statistic, in events per second since the
+ * previous call.  If less than a second has passed, the previously
+ * computed rate is returned.
+ *
+ * @param sr The rate statistic
+ *
+ * @return Events per second.
+ */
+uint32_t
+stats_rate_read(struct stats_rate *sr)
+{
+    os_time_t now;
+    uint32_t ticks;
+    uint32_t cnt;
+
+    now = os_time_get();
+    ticks = now - sr->sr_prev_time;
+    if (ticks >= OS_TICKS_PER_SEC) {
+        cnt = sr->sr_cnt;
+        sr->sr_rate = (uint64_t)(cnt - sr->sr_prev_cnt) * OS_TICKS_PER_SEC /
+          ticks;
+        sr->sr_prev_cnt = cnt;
+        sr->sr_prev_time = now;
+    }
+    return sr->sr_rate;
+}
+
+/**
+ * Copy a statistics section, header included, so that it can be walked
+ * without values changing underneath.  With STATS_ISR_SAFE, the copy is
+ * retried until no update happened while copying; interrupts stay
+ * enabled.
+ *
+ * Rates are computed on the live section before copying.
+ *
+ * @param hdr The statistics section to copy
+ * @param copy Where to copy it
+ * @param len Size of the buffer at copy
+ *
+ * @return 0 on success, -1 if the section does not fit.
+ */
+int
+stats_snapshot(struct stats_hdr *hdr, struct stats_hdr *copy, int len)
+{
+    int size;
+    int i;
+#if MYNEWT_VAL(STATS_ISR_SAFE)
+    uint32_t seq;
+#endif
+
+    size = sizeof(*hdr) + hdr->s_size * hdr->s_cnt;
+    if (len < size) {
+        return -1;
+    }
+
+    if (hdr->s_type == STATS_TYPE_RATE) {
+        for (i = 0; i < hdr->s_cnt; i++) {
+            stats_rate_read((struct stats_rate *)((uint8_t *)(hdr + 1) +
+              i * hdr->s_size));
+        }
+    }
+
+#if MYNEWT_VAL(STATS_ISR_SAFE)
+    do {
+        seq = *(volatile uint32_t *)&hdr->s_seq;
+        if (seq & 1) {
+            continue;
+        }
+        __asm__ volatile ("" ::: "memory");
+        memcpy(copy, hdr, size);
+        __asm__ volatile ("" ::: "memory");
+    } while ((seq & 1) || *(volatile uint32_t *)&hdr->s_seq != seq);
+#else
+    memcpy(copy, hdr, size);
+#endif
+
+    return 0;
+}
@@ -19,6 +19,7 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "syscfg/syscfg.h"
 
@@ -29,25 +30,112 @@
 #include "cborattr/cborattr.h"
 #include "stats/stats.h"
 
+#if MYNEWT_VAL(STATS_SNAPSHOT_BUF_SIZE) > 0
+static union {
+    struct stats_hdr hdr;
+    uint64_t align;
+    uint8_t buf[MYNEWT_VAL(STATS_SNAPSHOT_BUF_SIZE)];
+} stats_nmgr_snap;
+#endif
+
 /* Source code is only included if the newtmgr library is enabled.  Otherwise
  * this file is compiled out for code size.
  */
 static int stats_nmgr_read(struct mgmt_cbuf *cb);
 static int stats_nmgr_list(struct mgmt_cbuf *cb);
+#if MYNEWT_VAL(STATS_NMGR_STREAM) > 0
+static int stats_nmgr_schema(struct mgmt_cbuf *cb);
+static int stats_nmgr_delta(struct mgmt_cbuf *cb);
+#endif
 
 static struct mgmt_group shell_nmgr_group;
 
-#define STATS_NMGR_ID_READ  (0)
-#define STATS_NMGR_ID_LIST  (1)
+#define STATS_NMGR_ID_READ      (0)
+#define STATS_NMGR_ID_LIST      (1)
+#define STATS_NMGR_ID_SCHEMA    (2)
+#define STATS_NMGR_ID_DELTA     (3)
 
 /* ORDER MATTERS HERE.
  * Each element represents the command ID, referenced from newtmgr.
  */
 static struct mgmt_handler shell_nmgr_group_handlers[] = {
     [STATS_NMGR_ID_READ] = {stats_nmgr_read, stats_nmgr_read},
-    [STATS_NMGR_ID_LIST] = {stats_nmgr_list, stats_nmgr_list}
+    [STATS_NMGR_ID_LIST] = {stats_nmgr_list, stats_nmgr_list},
+#if MYNEWT_VAL(STATS_NMGR_STREAM) > 0
+    [STATS_NMGR_ID_SCHEMA] = {stats_nmgr_schema, stats_nmgr_schema},
+    [STATS_NMGR_ID_DELTA] = {stats_nmgr_delta, stats_nmgr_delta},
+#endif
+};
+
+#if MYNEWT_VAL(STATS_NMGR_STREAM) > 0
+/*
+ * Compact streaming of counter sections.  "schema" subscribes to a
+ * group, and returns a subscription id and the counter names in index
+ * order.  "delta" returns the counters which changed since the previous
+ * schema or delta request, as a byte string of varint (index, increment)
+ * pairs.  Increments are modulo 2^32.  If they don't all fit, "more" is
+ * set and the rest are returned by the next request.
+ */
+struct stats_nmgr_sub {
+    struct stats_hdr *sns_hdr;
+    uint32_t *sns_prev;
 };
 
+static struct stats_nmgr_sub stats_nmgr_subs[MYNEWT_VAL(STATS_NMGR_STREAM)];
+static uint8_t stats_nmgr_delta_buf[MYNEWT_VAL(STATS_NMGR_DELTA_BUF_SIZE)];
+#endif
+
+/*
+ * Histograms are encoded as an array of bucket counts, gauges and rates
+ * as maps.
+ */
+static CborError
+stats_nmgr_encode_typed(struct stats_hdr *hdr, CborEncoder *penc,
+        void *stat_val)
+{
+    struct stats_hist *sh;
+    struct stats_gauge *sg;
+    struct stats_rate *sr;
+    CborEncoder enc;
+    CborError g_err = CborNoError;
+    int i;
+
+    switch (hdr->s_type) {
+        case STATS_TYPE_HIST:
+            sh = stat_val;
+            g_err |= cbor_encoder_create_array(penc, &enc,
+                                               MYNEWT_VAL(STATS_HIST_BUCKETS));
+            for (i = 0; i < MYNEWT_VAL(STATS_HIST_BUCKETS); i++) {
+                g_err |= cbor_encode_uint(&enc, sh->sh_bucket[i]);
+            }
+            break;
+        case STATS_TYPE_GAUGE:
+            sg = stat_val;
+            g_err |= cbor_encoder_create_map(penc, &enc, 4);
+            g_err |= cbor_encode_text_stringz(&enc, "cnt");
+            g_err |= cbor_encode_uint(&enc, sg->sg_cnt);
+            g_err |= cbor_encode_text_stringz(&enc, "min");
+            g_err |= cbor_encode_uint(&enc, sg->sg_min);
+            g_err |= cbor_encode_text_stringz(&enc, "max");
+            g_err |= cbor_encode_uint(&enc, sg->sg_max);
+            g_err |= cbor_encode_text_stringz(&enc, "avg");
+            g_err |= cbor_encode_uint(&enc,
+                                      sg->sg_cnt ? sg->sg_sum / sg->sg_cnt : 0);
+            break;
+        default:
+            sr = stat_val;
+            g_err |= cbor_encoder_create_map(penc, &enc, 2);
+            g_err |= cbor_encode_text_stringz(&enc, "cnt");
+            g_err |= cbor_encode_uint(&enc, sr->sr_cnt);
+            g_err |= cbor_encode_text_stringz(&enc, "rate");
+            g_err |= cbor_encode_uint(&enc, stats_rate_read(sr));
+            break;
+    }
+    g_err |= cbor_encoder_close_container(penc, &enc);
+
+    return (g_err);
+}
+
 static int
 stats_nmgr_walk_func(struct stats_hdr *hdr, void *arg, char *sname,
         uint16_t stat_off)
@@ -60,6 +148,11 @@ stats_nmgr_walk_func(struct stats_hdr *hdr, void *arg, char *sname,
 
     g_err |= cbor_encode_text_stringz(penc, sname);
 
+    if (hdr->s_type != STATS_TYPE_CNT) {
+        g_err |= stats_nmgr_encode_typed(hdr, penc, stat_val);
+        return (g_err);
+    }
+
     switch (hdr->s_size) {
         case sizeof(uint16_t):
             g_err |= cbor_encode_uint(penc, *(uint16_t *) stat_val);
@@ -121,6 +214,11 @@ stats_nmgr_read(struct mgmt_cbuf *cb)
     g_err |= cbor_encoder_create_map(&cb->encoder, &stats,
                                      CborIndefiniteLength);
 
+#if MYNEWT_VAL(STATS_SNAPSHOT_BUF_SIZE) > 0
+    if (!stats_snapshot(hdr, &stats_nmgr_snap.hdr, sizeof(stats_nmgr_snap))) {
+        hdr = &stats_nmgr_snap.hdr;
+    }
+#endif
     stats_walk(hdr, stats_nmgr_walk_func, &stats);
 
     g_err |= cbor_encoder_close_container(&cb->encoder, &stats);
@@ -152,6 +250,191 @@ stats_nmgr_list(struct mgmt_cbuf *cb)
     return (0);
 }
 
+#if MYNEWT_VAL(STATS_NMGR_STREAM) > 0
+static uint32_t
+stats_nmgr_cnt_val(struct stats_hdr *hdr, int idx)
+{
+    uint8_t *stat_val;
+
+    stat_val = (uint8_t *)hdr + sizeof(*hdr) + idx * hdr->s_size;
+    switch (hdr->s_size) {
+        case sizeof(uint16_t):
+            return *(uint16_t *)stat_val;
+        case sizeof(uint32_t):
+            return *(uint32_t *)stat_val;
+        default:
+            return *(uint64_t *)stat_val;
+    }
+}
+
+static int
+stats_nmgr_put_varint(uint8_t *dst, uint32_t val)
+{
+    int len;
+
+    len = 0;
+    while (val >= 0x80) {
+        dst[len++] = val | 0x80;
+        val >>= 7;
+    }
+    dst[len++] = val;
+    return len;
+}
+
+static struct stats_hdr *
+stats_nmgr_stream_src(struct stats_hdr *hdr)
+{
+#if MYNEWT_VAL(STATS_SNAPSHOT_BUF_SIZE) > 0
+    if (!stats_snapshot(hdr, &stats_nmgr_snap.hdr, sizeof(stats_nmgr_snap))) {
+        return &stats_nmgr_snap.hdr;
+    }
+#endif
+    return hdr;
+}
+
+static int
+stats_nmgr_encode_field(struct stats_hdr *hdr, void *arg, char *sname,
+        uint16_t stat_off)
+{
+    return cbor_encode_text_stringz((CborEncoder *)arg, sname);
+}
+
+static int
+stats_nmgr_schema(struct mgmt_cbuf *cb)
+{
+    struct stats_nmgr_sub *sub;
+    struct stats_hdr *hdr;
+    struct stats_hdr *src;
+    char stats_name[STATS_NMGR_NAME_LEN];
+    struct cbor_attr_t attrs[] = {
+        { "name", CborAttrTextStringType, .addr.string = &stats_name[0],
+            .len = sizeof(stats_name) },
+        { NULL },
+    };
+    CborError g_err = CborNoError;
+    CborEncoder fields;
+    int i;
+
+    g_err = cbor_read_object(&cb->it, attrs);
+    if (g_err != 0) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    hdr = stats_group_find(stats_name);
+    if (!hdr || hdr->s_type != STATS_TYPE_CNT) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    sub = NULL;
+    for (i = 0; i < MYNEWT_VAL(STATS_NMGR_STREAM); i++) {
+        if (stats_nmgr_subs[i].sns_hdr == hdr) {
+            sub = &stats_nmgr_subs[i];
+            break;
+        }
+        if (!sub && !stats_nmgr_subs[i].sns_hdr) {
+            sub = &stats_nmgr_subs[i];
+        }
+    }
+    if (!sub) {
+        return MGMT_ERR_ENOMEM;
+    }
+    if (!sub->sns_hdr) {
+        sub->sns_prev = malloc(hdr->s_cnt * sizeof(uint32_t));
+        if (!sub->sns_prev) {
+            return MGMT_ERR_ENOMEM;
+        }
+        sub->sns_hdr = hdr;
+    }
+
+    src = stats_nmgr_stream_src(hdr);
+    for (i = 0; i < hdr->s_cnt; i++) {
+        sub->sns_prev[i] = stats_nmgr_cnt_val(src, i);
+    }
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "rc");
+    g_err |= cbor_encode_int(&cb->encoder, MGMT_ERR_EOK);
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "id");
+    g_err |= cbor_encode_uint(&cb->encoder, sub - stats_nmgr_subs);
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "fields");
+    g_err |= cbor_encoder_create_array(&cb->encoder, &fields,
+                                       CborIndefiniteLength);
+    stats_walk(hdr, stats_nmgr_encode_field, &fields);
+    g_err |= cbor_encoder_close_container(&cb->encoder, &fields);
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return (0);
+}
+
+static int
+stats_nmgr_delta(struct mgmt_cbuf *cb)
+{
+    struct stats_nmgr_sub *sub;
+    struct stats_hdr *src;
+    long long unsigned int id = UINT32_MAX;
+    struct cbor_attr_t attrs[] = {
+        { "id", CborAttrUnsignedIntegerType, .addr.uinteger = &id },
+        { NULL },
+    };
+    CborError g_err = CborNoError;
+    uint32_t cur;
+    uint32_t diff;
+    int more;
+    int len;
+    int i;
+
+    g_err = cbor_read_object(&cb->it, attrs);
+    if (g_err != 0 || id >= MYNEWT_VAL(STATS_NMGR_STREAM)) {
+        return MGMT_ERR_EINVAL;
+    }
+    sub = &stats_nmgr_subs[id];
+    if (!sub->sns_hdr) {
+        return MGMT_ERR_ENOENT;
+    }
+
+    src = stats_nmgr_stream_src(sub->sns_hdr);
+    len = 0;
+    more = 0;
+    for (i = 0; i < src->s_cnt; i++) {
+        cur = stats_nmgr_cnt_val(src, i);
+        diff = cur - sub->sns_prev[i];
+        if (!diff) {
+            continue;
+        }
+        /* Two varints of at most 5 bytes. */
+        if (len + 10 > sizeof(stats_nmgr_delta_buf)) {
+            more = 1;
+            break;
+        }
+        len += stats_nmgr_put_varint(&stats_nmgr_delta_buf[len], i);
+        len += stats_nmgr_put_varint(&stats_nmgr_delta_buf[len], diff);
+        sub->sns_prev[i] = cur;
+    }
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "rc");
+    g_err |= cbor_encode_int(&cb->encoder, MGMT_ERR_EOK);
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "id");
+    g_err |= cbor_encode_uint(&cb->encoder, id);
+
+    g_err |= cbor_encode_text_stringz(&cb->encoder, "d");
+    g_err |= cbor_encode_byte_string(&cb->encoder, stats_nmgr_delta_buf, len);
+
+    if (more) {
+        g_err |= cbor_encode_text_stringz(&cb->encoder, "more");
+        g_err |= cbor_encode_boolean(&cb->encoder, true);
+    }
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return (0);
+}
+#endif
+
 /**
  * Register nmgr group handlers
  */
@@ -30,6 +30,14 @@
 #include "os/os.h"
 #include "stats/stats.h"
 
+#if MYNEWT_VAL(STATS_SNAPSHOT_BUF_SIZE) > 0
+static union {
+    struct stats_hdr hdr;
+    uint64_t align;
+    uint8_t buf[MYNEWT_VAL(STATS_SNAPSHOT_BUF_SIZE)];
+} stats_shell_snap;
+#endif
+
 static int shell_stats_display(int argc, char **argv);
 static struct shell_cmd shell_stats_cmd = {
     .sc_cmd = "stat",
@@ -37,6 +45,39 @@ static struct shell_cmd shell_stats_cmd = {
 };
 uint8_t stats_shell_registered;
 
+static void
+stats_shell_display_typed(struct stats_hdr *hdr, char *name, void *stat_val)
+{
+    struct stats_hist *sh;
+    struct stats_gauge *sg;
+    struct stats_rate *sr;
+    int i;
+
+    switch (hdr->s_type) {
+        case STATS_TYPE_HIST:
+            sh = stat_val;
+            console_printf("%s:", name);
+            for (i = 0; i < MYNEWT_VAL(STATS_HIST_BUCKETS); i++) {
+                console_printf(" %lu", (unsigned long)sh->sh_bucket[i]);
+            }
+            console_printf("\n");
+            break;
+        case STATS_TYPE_GAUGE:
+            sg = stat_val;
+            console_printf("%s: cnt %lu min %lu max %lu avg %lu\n", name,
+                    (unsigned long)sg->sg_cnt, (unsigned long)sg->sg_min,
+                    (unsigned long)sg->sg_max,
+                    (unsigned long)(sg->sg_cnt ? sg->sg_sum / sg->sg_cnt : 0));
+            break;
+        default:
+            sr = stat_val;
+            console_printf("%s: %lu (%lu/s)\n", name,
+                    (unsigned long)sr->sr_cnt,
+                    (unsigned long)stats_rate_read(sr));
+            break;
+    }
+}
+
 static int 
 stats_shell_display_entry(struct stats_hdr *hdr, void *arg, char *name,
         uint16_t stat_off)
@@ -44,6 +85,10 @@ stats_shell_display_entry(struct stats_hdr *hdr, void *arg, char *name,
     void *stat_val;
 
     stat_val = (uint8_t *)hdr + stat_off;
+    if (hdr->s_type != STATS_TYPE_CNT) {
+        stats_shell_display_typed(hdr, name, stat_val);
+        return (0);
+    }
     switch (hdr->s_size) {
         case sizeof(uint16_t):
             console_printf("%s: %u\n", name, *(uint16_t *) stat_val);
@@ -93,6 +138,12 @@ shell_stats_display(int argc, char **argv)
         goto err;
     }
 
+#if MYNEWT_VAL(STATS_SNAPSHOT_BUF_SIZE) > 0
+    if (!stats_snapshot(hdr, &stats_shell_snap.hdr,
+                        sizeof(stats_shell_snap))) {
+        hdr = &stats_shell_snap.hdr;
+    }
+#endif
     rc = stats_walk(hdr, stats_shell_display_entry, NULL);
     if (rc != 0) {
         goto err;
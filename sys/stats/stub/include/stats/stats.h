@@ -36,7 +36,8 @@ struct stats_hdr {
     char *s_name;
     uint8_t s_size;
     uint8_t s_cnt;
-    uint16_t s_pad1;
+    uint8_t s_type;
+    uint8_t s_pad1;
 #if MYNEWT_VAL(STATS_NAMES)
     const struct stats_name_map *s_map;
     int s_map_cnt;
@@ -58,6 +59,9 @@ struct stats_hdr {
 #define STATS_SECT_ENTRY16(__var)
 #define STATS_SECT_ENTRY32(__var)
 #define STATS_SECT_ENTRY64(__var)
+#define STATS_SECT_HIST(__var)
+#define STATS_SECT_GAUGE(__var)
+#define STATS_SECT_RATE(__var)
 #define STATS_RESET(__var)
 
 #define STATS_SIZE_INIT_PARMS(__sectvarname, __size) 0, 0
@@ -65,11 +69,17 @@ struct stats_hdr {
 #define STATS_INC(__sectvarname, __var)
 #define STATS_INCN(__sectvarname, __var, __n)
 #define STATS_CLEAR(__sectvarname, __var)
+#define STATS_HIST_ADD(__sectvarname, __var, __val)
+#define STATS_GAUGE_ADD(__sectvarname, __var, __val)
+#define STATS_RATE_INC(__sectvarname, __var)
+#define STATS_RATE_INCN(__sectvarname, __var, __n)
 
 #define STATS_NAME_START(__name)
 #define STATS_NAME(__name, __entry)
 #define STATS_NAME_END(__name)
 #define STATS_NAME_INIT_PARMS(__name) NULL, 0
+#define STATS_SECT_STATIC(__sectname, __var, __size, __name)            \
+    STATS_SECT_DECL(__sectname) __var
 
 #define stats_init(shdr, size, cnt, map, map_cnt) 0
 #define stats_register(name, shdr) 0
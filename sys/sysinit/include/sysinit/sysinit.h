@@ -44,6 +44,47 @@ extern sysinit_panic_fn *sysinit_panic_cb;
 
 void sysinit_panic_set(sysinit_panic_fn *panic_fn);
 
+typedef void sysinit_deferred_fn(void *arg);
+
+/**
+ * Queues part of a package's initialization to run after sysinit has
+ * finished, so that the application's main task can start sooner.  Deferred
+ * functions run, in the order they were queued, from the default event queue
+ * once the application processes it; OS_DEV_INIT_DEFERRED devices are
+ * initialized just before them.  Can only be called during sysinit.
+ *
+ * @param name                  Name for boot profiling; may be NULL.
+ * @param fn                    The function to call.
+ * @param arg                   Argument to pass to fn.
+ *
+ * @return                      0 on success; OS_ENOMEM if
+ *                                  SYSINIT_DEFER_MAX functions are already
+ *                                  queued.
+ */
+int sysinit_defer(const char *name, sysinit_deferred_fn *fn, void *arg);
+
+#if MYNEWT_VAL(SYSINIT_PROFILE)
+/**
+ * Records the time since the previous mark (or the start of sysinit) under
+ * the given name.  Packages call this at the end of their init function.
+ */
+void sysinit_profile_mark(const char *name);
+
+/**
+ * Reads a boot profile record.
+ *
+ * @param idx                   Index of the record, from 0.
+ * @param name                  On success, the name of the step.
+ * @param usecs                 On success, the time the step took.
+ *
+ * @return                      0 on success; OS_ENOENT if there is no
+ *                                  such record.
+ */
+int sysinit_profile_get(int idx, const char **name, uint32_t *usecs);
+#else
+#define sysinit_profile_mark(name)
+#endif
+
 #if MYNEWT_VAL(SYSINIT_PANIC_MESSAGE)
 
 #if MYNEWT_VAL(SYSINIT_PANIC_FILE_LINE)
@@ -20,6 +20,7 @@
 #include <stdio.h>
 #include <stddef.h>
 #include <limits.h>
+#include "os/os.h"
 #include "os/os_fault.h"
 #include "syscfg/syscfg.h"
 #include "sysinit/sysinit.h"
@@ -41,6 +42,69 @@ sysinit_panic_fn *sysinit_panic_cb = sysinit_dflt_panic_cb;
 
 uint8_t sysinit_active;
 
+struct sysinit_deferred {
+    const char *name;
+    sysinit_deferred_fn *fn;
+    void *arg;
+};
+
+static struct sysinit_deferred
+    sysinit_deferred_list[MYNEWT_VAL(SYSINIT_DEFER_MAX)];
+static int sysinit_deferred_cnt;
+
+static void sysinit_deferred_run(struct os_event *ev);
+
+static struct os_event sysinit_deferred_ev = {
+    .ev_cb = sysinit_deferred_run,
+};
+
+#if MYNEWT_VAL(SYSINIT_PROFILE)
+struct sysinit_profile_rec {
+    const char *name;
+    uint32_t usecs;
+};
+
+static struct sysinit_profile_rec
+    sysinit_profile_recs[MYNEWT_VAL(SYSINIT_PROFILE_MAX)];
+static int sysinit_profile_cnt;
+static uint32_t sysinit_profile_last;
+
+static void
+sysinit_profile_add(const char *name, uint32_t usecs)
+{
+    struct sysinit_profile_rec *rec;
+
+    if (sysinit_profile_cnt >= MYNEWT_VAL(SYSINIT_PROFILE_MAX)) {
+        return;
+    }
+    rec = &sysinit_profile_recs[sysinit_profile_cnt++];
+    rec->name = name ? name : "?";
+    rec->usecs = usecs;
+}
+
+void
+sysinit_profile_mark(const char *name)
+{
+    uint32_t now;
+
+    now = os_cputime_get32();
+    sysinit_profile_add(name,
+                        os_cputime_ticks_to_usecs(now - sysinit_profile_last));
+    sysinit_profile_last = now;
+}
+
+int
+sysinit_profile_get(int idx, const char **name, uint32_t *usecs)
+{
+    if (idx < 0 || idx >= sysinit_profile_cnt) {
+        return OS_ENOENT;
+    }
+    *name = sysinit_profile_recs[idx].name;
+    *usecs = sysinit_profile_recs[idx].usecs;
+    return 0;
+}
+#endif
+
 /**
  * Sets the sysinit panic function; i.e., the function which executes when
  * initialization fails.  By default, a panic triggers a failed assertion.
@@ -51,14 +115,72 @@ sysinit_panic_set(sysinit_panic_fn *panic_cb)
     sysinit_panic_cb = panic_cb;
 }
 
+int
+sysinit_defer(const char *name, sysinit_deferred_fn *fn, void *arg)
+{
+    struct sysinit_deferred *sd;
+
+    SYSINIT_ASSERT_ACTIVE();
+
+    if (sysinit_deferred_cnt >= MYNEWT_VAL(SYSINIT_DEFER_MAX)) {
+        return OS_ENOMEM;
+    }
+    sd = &sysinit_deferred_list[sysinit_deferred_cnt++];
+    sd->name = name;
+    sd->fn = fn;
+    sd->arg = arg;
+
+    return 0;
+}
+
+static void
+sysinit_deferred_run(struct os_event *ev)
+{
+    struct sysinit_deferred *sd;
+    int rc;
+    int i;
+
+#if MYNEWT_VAL(SYSINIT_PROFILE)
+    sysinit_profile_last = os_cputime_get32();
+#endif
+
+    rc = os_dev_initialize_all(OS_DEV_INIT_DEFERRED);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+    sysinit_profile_mark("deferred devices");
+
+    for (i = 0; i < sysinit_deferred_cnt; i++) {
+        sd = &sysinit_deferred_list[i];
+        sd->fn(sd->arg);
+        sysinit_profile_mark(sd->name);
+    }
+    sysinit_deferred_cnt = 0;
+}
+
 void
 sysinit_start(void)
 {
     sysinit_active = 1;
+#if MYNEWT_VAL(SYSINIT_PROFILE)
+    /* The first record is the time from os_cputime_init() until now. */
+    sysinit_profile_cnt = 0;
+    sysinit_profile_last = 0;
+    sysinit_profile_mark("pre-sysinit");
+#endif
 }
 
 void
 sysinit_end(void)
 {
+    sysinit_profile_mark("sysinit");
     sysinit_active = 0;
+
+    /*
+     * Deferred work runs from the default event queue once the OS is
+     * running; before that (e.g. unit tests) there is nothing to gain.
+     */
+    if (g_os_started) {
+        os_eventq_put(os_eventq_dflt_get(), &sysinit_deferred_ev);
+    } else {
+        sysinit_deferred_run(&sysinit_deferred_ev);
+    }
 }
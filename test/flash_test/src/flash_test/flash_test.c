@@ -23,6 +23,7 @@
 #include <hal/hal_bsp.h>
 #include <hal/hal_flash.h>
 #include <hal/hal_flash_int.h>
+#include <flash_map/flash_map.h>
 #include <shell/shell.h>
 #include <stdio.h>
 #include <string.h>
@@ -33,6 +34,247 @@ static struct shell_cmd flash_cmd_struct = {
     .sc_cmd_func = flash_cli_cmd
 };
 
+#define FLASH_BENCH_BUF_SZ      MYNEWT_VAL(FLASH_TEST_BENCH_BUF_SIZE)
+#define FLASH_BENCH_SPAN        MYNEWT_VAL(FLASH_TEST_BENCH_SPAN)
+#define FLASH_BENCH_MIN_CHUNK   16
+
+/* Latency histogram buckets; bucket n counts ops taking < 2^n usecs. */
+#define FLASH_BENCH_HIST_CNT    16
+
+struct flash_bench_stats {
+    uint32_t fbs_ops;
+    uint32_t fbs_bytes;
+    uint32_t fbs_min;
+    uint32_t fbs_max;
+    uint32_t fbs_total;
+    uint16_t fbs_hist[FLASH_BENCH_HIST_CNT];
+};
+
+static uint8_t flash_bench_buf[FLASH_BENCH_BUF_SZ];
+
+static void
+flash_bench_stats_init(struct flash_bench_stats *fbs)
+{
+    memset(fbs, 0, sizeof(*fbs));
+    fbs->fbs_min = UINT32_MAX;
+}
+
+static void
+flash_bench_stats_add(struct flash_bench_stats *fbs, uint32_t usecs,
+                      uint32_t bytes)
+{
+    int i;
+
+    fbs->fbs_ops++;
+    fbs->fbs_bytes += bytes;
+    fbs->fbs_total += usecs;
+    if (usecs < fbs->fbs_min) {
+        fbs->fbs_min = usecs;
+    }
+    if (usecs > fbs->fbs_max) {
+        fbs->fbs_max = usecs;
+    }
+    for (i = 0; i < FLASH_BENCH_HIST_CNT - 1; i++) {
+        if (usecs < (1UL << i)) {
+            break;
+        }
+    }
+    fbs->fbs_hist[i]++;
+}
+
+static void
+flash_bench_stats_print(const char *op, int chunk, int skew,
+                        struct flash_bench_stats *fbs)
+{
+    uint32_t bps;
+    int soff;
+    int i;
+    char pr_str[80];
+
+    if (fbs->fbs_ops == 0) {
+        console_printf("  %-5s chunk %4d +%d: no ops\n", op, chunk, skew);
+        return;
+    }
+    bps = 0;
+    if (fbs->fbs_total) {
+        bps = (uint64_t)fbs->fbs_bytes * 1000000 / fbs->fbs_total;
+    }
+    console_printf("  %-5s chunk %4d +%d: %lu ops %lu B/s, "
+      "usec min %lu avg %lu max %lu\n", op, chunk, skew,
+            (long unsigned int) fbs->fbs_ops,
+            (long unsigned int) bps,
+            (long unsigned int) fbs->fbs_min,
+            (long unsigned int) (fbs->fbs_total / fbs->fbs_ops),
+            (long unsigned int) fbs->fbs_max);
+
+    soff = 0;
+    pr_str[0] = '\0';
+    for (i = 0; i < FLASH_BENCH_HIST_CNT; i++) {
+        if (fbs->fbs_hist[i] && soff < sizeof(pr_str)) {
+            soff += snprintf(pr_str + soff, sizeof(pr_str) - soff,
+              i < FLASH_BENCH_HIST_CNT - 1 ? "<%lu:%u " : ">=%lu:%u ",
+              1UL << (i < FLASH_BENCH_HIST_CNT - 1 ? i : i - 1),
+              fbs->fbs_hist[i]);
+        }
+    }
+    console_printf("    hist %s\n", pr_str);
+}
+
+/*
+ * Times erasing every sector of the area, one sector at a time.
+ */
+static int
+flash_bench_erase(const struct flash_area *fa)
+{
+    const struct hal_flash *hf;
+    struct flash_bench_stats fbs;
+    uint32_t start;
+    uint32_t size;
+    uint32_t t;
+    int i;
+
+    hf = hal_bsp_flash_dev(fa->fa_device_id);
+    flash_bench_stats_init(&fbs);
+    for (i = 0; i < hf->hf_sector_cnt; i++) {
+        hf->hf_itf->hff_sector_info(hf, i, &start, &size);
+        if (start < fa->fa_off || start >= fa->fa_off + fa->fa_size) {
+            continue;
+        }
+        t = os_cputime_get32();
+        if (hal_flash_erase_sector(fa->fa_device_id, start)) {
+            console_printf("flash erase failure at %lx\n",
+                    (long unsigned int) start);
+            return -1;
+        }
+        t = os_cputime_get32() - t;
+        flash_bench_stats_add(&fbs, os_cputime_ticks_to_usecs(t), size);
+    }
+    flash_bench_stats_print("erase", 0, 0, &fbs);
+    return 0;
+}
+
+/*
+ * Times reads or programs of 'chunk' bytes covering FLASH_BENCH_SPAN bytes
+ * of the area, starting 'skew' bytes in.  Programming erases the span
+ * first; erase time is not counted.
+ */
+static int
+flash_bench_rw(const struct flash_area *fa, int write, int chunk, int skew)
+{
+    struct flash_bench_stats fbs;
+    uint32_t span;
+    uint32_t off;
+    uint32_t t;
+    int rc;
+    int i;
+
+    span = FLASH_BENCH_SPAN;
+    if (span + skew > fa->fa_size) {
+        span = fa->fa_size - skew;
+    }
+    span -= span % chunk;
+    if (write) {
+        if (flash_area_erase(fa, 0, span + skew)) {
+            console_printf("flash erase failure\n");
+            return -1;
+        }
+        for (i = 0; i < chunk; i++) {
+            flash_bench_buf[i] = i + 1;
+        }
+    }
+
+    flash_bench_stats_init(&fbs);
+    for (off = skew; off < span + skew; off += chunk) {
+        t = os_cputime_get32();
+        if (write) {
+            rc = flash_area_write(fa, off, flash_bench_buf, chunk);
+        } else {
+            rc = flash_area_read(fa, off, flash_bench_buf, chunk);
+        }
+        t = os_cputime_get32() - t;
+        if (rc) {
+            console_printf("flash %s failure at %lx\n",
+                    write ? "write" : "read", (long unsigned int) off);
+            return -1;
+        }
+        flash_bench_stats_add(&fbs, os_cputime_ticks_to_usecs(t), chunk);
+    }
+    flash_bench_stats_print(write ? "write" : "read", chunk, skew, &fbs);
+    return 0;
+}
+
+/*
+ * flash bench <area> [read|write|erase]
+ *
+ * Sweeps chunk sizes from FLASH_BENCH_MIN_CHUNK to FLASH_BENCH_BUF_SZ, each
+ * once at the start of the area and once skewed by the write alignment
+ * (1 byte for reads), so both chunk-aligned and unaligned accesses are seen.
+ */
+static int
+flash_bench_cmd(int argc, char **argv)
+{
+    const struct flash_area *fa;
+    int do_read;
+    int do_write;
+    int do_erase;
+    int chunk;
+    int skew;
+    int align;
+    int rc;
+    char *eptr;
+    uint8_t id;
+
+    if (argc < 3) {
+        console_printf("flash bench <area> [read|write|erase]\n");
+        return -1;
+    }
+    id = strtoul(argv[2], &eptr, 0);
+    if (*eptr != '\0') {
+        console_printf("Invalid area %s\n", argv[2]);
+        return -1;
+    }
+    do_read = do_write = do_erase = 1;
+    if (argc > 3) {
+        do_read = !strcmp(argv[3], "read");
+        do_write = !strcmp(argv[3], "write");
+        do_erase = !strcmp(argv[3], "erase");
+        if (!do_read && !do_write && !do_erase) {
+            console_printf("Invalid op %s\n", argv[3]);
+            return -1;
+        }
+    }
+    if (flash_area_open(id, &fa)) {
+        console_printf("No flash area %d\n", id);
+        return -1;
+    }
+    align = flash_area_align(fa);
+    console_printf("Bench area %d flash %d at 0x%lx size 0x%lx align %d\n",
+            id, fa->fa_device_id, (long unsigned int) fa->fa_off,
+            (long unsigned int) fa->fa_size, align);
+
+    rc = 0;
+    if (do_erase) {
+        rc = flash_bench_erase(fa);
+    }
+    for (chunk = FLASH_BENCH_MIN_CHUNK; !rc && chunk <= FLASH_BENCH_BUF_SZ;
+         chunk <<= 1) {
+        if (chunk % align || chunk > fa->fa_size) {
+            continue;
+        }
+        for (skew = 0; !rc && skew <= 1; skew++) {
+            if (do_read) {
+                rc = flash_bench_rw(fa, 0, chunk, skew);
+            }
+            if (!rc && do_write) {
+                rc = flash_bench_rw(fa, 1, chunk, skew * align);
+            }
+        }
+    }
+    flash_area_close(fa);
+    console_printf("Done!\n");
+    return rc;
+}
+
 static int
 flash_cli_cmd(int argc, char **argv)
 {
@@ -75,6 +317,9 @@ flash_cli_cmd(int argc, char **argv)
         }
         return 0;
     }
+    if (!strcmp(argv[1], "bench")) {
+        return flash_bench_cmd(argc, argv);
+    }
     if (argc > 2) {
         off = strtoul(argv[2], &eptr, 0);
         if (*eptr != '\0') {
@@ -141,6 +386,8 @@ flash_cli_cmd(int argc, char **argv)
         console_printf("flash read <offset> <size> -- reads bytes from flash \n");
         console_printf("flash write <offset>  <size>  -- writes incrementing data pattern 0-8 to flash \n");
         console_printf("flash erase <offset> <size> -- erases flash \n");
+        console_printf("flash bench <area> [read|write|erase] -- times "
+          "flash area access, erases the area \n");
     }
     return 0;
 err:
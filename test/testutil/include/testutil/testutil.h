@@ -57,6 +57,10 @@ typedef void tu_post_test_fn_t(void *arg);
 
 typedef void tu_testsuite_fn_t(void);
 
+struct tu_bench_result;
+typedef void tu_bench_report_fn_t(const struct tu_bench_result *res,
+                                  void *arg);
+
 /*
  * Private declarations - Test Suite configuration
  */
@@ -66,6 +70,7 @@ void tu_suite_set_pre_test_cb(tu_pre_test_fn_t *cb, void *cb_arg);
 void tu_suite_set_post_test_cb(tu_post_test_fn_t *cb, void *cb_arg);
 void tu_suite_set_pass_cb(tu_case_report_fn_t *cb, void *cb_arg);
 void tu_suite_set_fail_cb(tu_case_report_fn_t *cb, void *cb_arg);
+void tu_suite_set_bench_cb(tu_bench_report_fn_t *cb, void *cb_arg);
 
 void tu_suite_init(const char *name);
 void tu_suite_pre_test(void);
@@ -125,6 +130,12 @@ struct ts_config {
     tu_case_report_fn_t *ts_case_fail_cb;
     void *ts_case_fail_arg;
 
+    /*
+     * Called with the result of every benchmark (TEST_BENCH_END)
+     */
+    tu_bench_report_fn_t *ts_bench_cb;
+    void *ts_bench_arg;
+
     /*
      * restart after running the test suite - self-test only 
      */
@@ -292,6 +303,52 @@ TEST_SUITE_##suite_name(void);                               \
 #define TEST_PASS(...)                                        \
     tu_case_pass_manual(__FILE__, __LINE__, __VA_ARGS__);
 
+/*
+ * Benchmarks.  Within a test case, the code between TEST_BENCH_BEGIN and
+ * TEST_BENCH_END is run 'iters' times and timed as a whole, with the host
+ * clock in self tests and with os_cputime on targets:
+ *
+ *     TEST_BENCH_BEGIN("append", 1000) {
+ *         rc = os_mbuf_append(om, buf, sizeof buf);
+ *     } TEST_BENCH_END();
+ *
+ * The result is passed to the suite's bench callback and, in self tests,
+ * printed as one line:
+ *
+ *     [bench] <suite>/<case>/<name> iters=<n> ns=<total> ns_per_iter=<avg>
+ */
+struct tu_bench {
+    const char *tb_name;
+    uint32_t tb_iters;
+    uint32_t tb_iter;
+    uint64_t tb_start;          /* tu_bench_clock_ns() at start */
+};
+
+struct tu_bench_result {
+    const char *tbr_suite;
+    const char *tbr_case;
+    const char *tbr_name;
+    uint32_t tbr_iters;
+    uint64_t tbr_ns;            /* time for all iterations */
+    uint64_t tbr_ns_per_iter;
+};
+
+uint64_t tu_bench_clock_ns(void);
+void tu_bench_start(struct tu_bench *tb, const char *name, uint32_t iters);
+void tu_bench_end(struct tu_bench *tb);
+
+#define TEST_BENCH_BEGIN(name, iters) do                      \
+{                                                             \
+    struct tu_bench tu_bench_cur;                             \
+                                                              \
+    tu_bench_start(&tu_bench_cur, (name), (iters));           \
+    for (; tu_bench_cur.tb_iter < tu_bench_cur.tb_iters;      \
+         tu_bench_cur.tb_iter++)
+
+#define TEST_BENCH_END()                                      \
+    tu_bench_end(&tu_bench_cur);                              \
+} while (0)
+
 #if MYNEWT_VAL(TEST)
 #define ASSERT_IF_TEST(expr) assert(expr)
 #else
@@ -0,0 +1,91 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdio.h>
+#include "os/os.h"
+#include "testutil/testutil.h"
+#include "testutil_priv.h"
+
+#if MYNEWT_VAL(SELFTEST)
+#include <time.h>
+#endif
+
+/**
+ * Returns a free running time in nanoseconds: the host monotonic clock in
+ * self tests, os_cputime otherwise.  On targets only differences shorter
+ * than the os_cputime wrap are meaningful.
+ */
+uint64_t
+tu_bench_clock_ns(void)
+{
+#if MYNEWT_VAL(SELFTEST)
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+    static uint32_t last;
+    static uint64_t ticks;
+    uint32_t now;
+
+    /* Extend the 32-bit cputime; benches run from a single task. */
+    now = os_cputime_get32();
+    ticks += now - last;
+    last = now;
+
+    return ticks * 1000000000 / MYNEWT_VAL(OS_CPUTIME_FREQ);
+#endif
+}
+
+void
+tu_bench_start(struct tu_bench *tb, const char *name, uint32_t iters)
+{
+    tb->tb_name = name;
+    tb->tb_iters = iters;
+    tb->tb_iter = 0;
+    tb->tb_start = tu_bench_clock_ns();
+}
+
+void
+tu_bench_end(struct tu_bench *tb)
+{
+    struct tu_bench_result res;
+
+    res.tbr_ns = tu_bench_clock_ns() - tb->tb_start;
+    res.tbr_suite = ts_current_config->ts_suite_name;
+    res.tbr_case = tu_case_name;
+    res.tbr_name = tb->tb_name;
+    res.tbr_iters = tb->tb_iters;
+    res.tbr_ns_per_iter = tb->tb_iters ? res.tbr_ns / tb->tb_iters : 0;
+
+#if MYNEWT_VAL(SELFTEST)
+    if (ts_config.ts_print_results) {
+        printf("[bench] %s/%s/%s iters=%lu ns=%llu ns_per_iter=%llu\n",
+               res.tbr_suite, res.tbr_case, res.tbr_name,
+               (unsigned long)res.tbr_iters,
+               (unsigned long long)res.tbr_ns,
+               (unsigned long long)res.tbr_ns_per_iter);
+        fflush(stdout);
+    }
+#endif
+
+    if (ts_config.ts_bench_cb != NULL) {
+        ts_config.ts_bench_cb(&res, ts_config.ts_bench_arg);
+    }
+}
@@ -122,6 +122,13 @@ tu_suite_set_fail_cb(tu_case_report_fn_t *cb, void *cb_arg)
     ts_config.ts_case_fail_arg = cb_arg;
 }
 
+void
+tu_suite_set_bench_cb(tu_bench_report_fn_t *cb, void *cb_arg)
+{
+    ts_config.ts_bench_cb = cb;
+    ts_config.ts_bench_arg = cb_arg;
+}
+
 void
 tu_suite_complete(void)
 {
@@ -38,12 +38,23 @@ struct cbmem {
     uint8_t *c_buf;
     uint8_t *c_buf_end;
     uint8_t *c_buf_cur_end;
+
+    /*
+     * c_seq is odd while the entry list is being changed; c_lap counts
+     * the times the writer has wrapped to the start of the buffer.
+     * These let readers detect entries which were overwritten by
+     * cbmem_append_nolock() while they were looking at them.
+     */
+    volatile uint32_t c_seq;
+    uint32_t c_lap;
 };
 
 struct cbmem_iter {
     struct cbmem_entry_hdr *ci_start;
     struct cbmem_entry_hdr *ci_cur;
     struct cbmem_entry_hdr *ci_end;
+    uint32_t ci_lap;
+    uint32_t ci_last_pos;
 };
 
 #define CBMEM_ENTRY_SIZE(__p) (sizeof(struct cbmem_entry_hdr) \
@@ -51,6 +62,13 @@ struct cbmem_iter {
 #define CBMEM_ENTRY_NEXT(__p) ((struct cbmem_entry_hdr *) \
         ((uint8_t *) (__p) + CBMEM_ENTRY_SIZE(__p)))
 
+/*
+ * Entries are never split across the end of the buffer, so the data of an
+ * entry can be accessed in place.
+ */
+#define CBMEM_ENTRY_DATA(__p) ((void *) ((uint8_t *) (__p) + \
+        sizeof(struct cbmem_entry_hdr)))
+
 typedef int (*cbmem_walk_func_t)(struct cbmem *, struct cbmem_entry_hdr *, 
         void *arg);
 
@@ -58,9 +76,11 @@ int cbmem_lock_acquire(struct cbmem *cbmem);
 int cbmem_lock_release(struct cbmem *cbmem);
 int cbmem_init(struct cbmem *cbmem, void *buf, uint32_t buf_len);
 int cbmem_append(struct cbmem *cbmem, void *data, uint16_t len);
+int cbmem_append_nolock(struct cbmem *cbmem, void *data, uint16_t len);
 void cbmem_iter_start(struct cbmem *cbmem, struct cbmem_iter *iter);
 struct cbmem_entry_hdr *cbmem_iter_next(struct cbmem *cbmem, 
         struct cbmem_iter *iter);
+int cbmem_iter_valid(struct cbmem *cbmem, struct cbmem_iter *iter);
 int cbmem_read(struct cbmem *cbmem, struct cbmem_entry_hdr *hdr, void *buf, 
         uint16_t off, uint16_t len);
 int cbmem_walk(struct cbmem *cbmem, cbmem_walk_func_t walk_func, void *arg);
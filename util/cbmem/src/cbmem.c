@@ -74,18 +74,26 @@ err:
 }
 
 
-int
-cbmem_append(struct cbmem *cbmem, void *data, uint16_t len)
+/*
+ * Seq is bumped around changes to the entry list; readers which do not
+ * hold the lock use it to get a consistent view.
+ */
+static void
+cbmem_seq_bump(struct cbmem *cbmem)
+{
+    __asm__ volatile ("" ::: "memory");
+    cbmem->c_seq++;
+    __asm__ volatile ("" ::: "memory");
+}
+
+static void
+cbmem_append_entry(struct cbmem *cbmem, void *data, uint16_t len)
 {
     struct cbmem_entry_hdr *dst;
     uint8_t *start;
     uint8_t *end;
-    int rc;
 
-    rc = cbmem_lock_acquire(cbmem);
-    if (rc != 0) {
-        goto err;
-    }
+    cbmem_seq_bump(cbmem);
 
     if (cbmem->c_entry_end) {
         dst = CBMEM_ENTRY_NEXT(cbmem->c_entry_end);
@@ -104,6 +112,7 @@ cbmem_append(struct cbmem *cbmem, void *data, uint16_t len)
         if ((uint8_t *) cbmem->c_entry_start >= cbmem->c_buf_cur_end) {
             cbmem->c_entry_start = (struct cbmem_entry_hdr *) cbmem->c_buf;
         }
+        cbmem->c_lap++;
     }
 
     /* If the destination is prior to the start, and would overrwrite the
@@ -133,6 +142,21 @@ cbmem_append(struct cbmem *cbmem, void *data, uint16_t len)
         cbmem->c_entry_start = dst;
     }
 
+    cbmem_seq_bump(cbmem);
+}
+
+int
+cbmem_append(struct cbmem *cbmem, void *data, uint16_t len)
+{
+    int rc;
+
+    rc = cbmem_lock_acquire(cbmem);
+    if (rc != 0) {
+        goto err;
+    }
+
+    cbmem_append_entry(cbmem, data, len);
+
     rc = cbmem_lock_release(cbmem);
     if (rc != 0) {
         goto err;
@@ -143,12 +167,60 @@ err:
     return (-1);
 }
 
+/**
+ * Appends an entry without taking the lock, so this can be called from
+ * an interrupt handler.  There must be only one context calling this for
+ * a given cbmem, cbmem_append() must not be used on it, and readers must
+ * not be able to preempt the writer (e.g. the writer is an interrupt
+ * handler, or runs at higher priority than any reader).
+ *
+ * Holding the lock does not keep entries from being overwritten; readers
+ * check for this with cbmem_iter_valid().
+ */
+int
+cbmem_append_nolock(struct cbmem *cbmem, void *data, uint16_t len)
+{
+    if (len + sizeof(struct cbmem_entry_hdr) >
+            cbmem->c_buf_end - cbmem->c_buf) {
+        return (-1);
+    }
+    cbmem_append_entry(cbmem, data, len);
+
+    return (0);
+}
+
+/*
+ * Position of an entry counting from the creation of the cbmem; this
+ * only grows as entries are written.
+ */
+static uint32_t
+cbmem_entry_pos(struct cbmem *cbmem, struct cbmem_entry_hdr *hdr,
+        uint32_t lap)
+{
+    return lap * (uint32_t) (cbmem->c_buf_end - cbmem->c_buf) +
+        (uint32_t) ((uint8_t *) hdr - cbmem->c_buf);
+}
+
 void
 cbmem_iter_start(struct cbmem *cbmem, struct cbmem_iter *iter)
 {
-    iter->ci_start = cbmem->c_entry_start;
-    iter->ci_cur = cbmem->c_entry_start;
-    iter->ci_end = cbmem->c_entry_end;
+    uint32_t seq;
+
+    do {
+        seq = cbmem->c_seq;
+        __asm__ volatile ("" ::: "memory");
+        iter->ci_start = cbmem->c_entry_start;
+        iter->ci_cur = cbmem->c_entry_start;
+        iter->ci_end = cbmem->c_entry_end;
+        iter->ci_lap = cbmem->c_lap;
+        __asm__ volatile ("" ::: "memory");
+    } while ((seq & 1) || cbmem->c_seq != seq);
+
+    if (iter->ci_start > iter->ci_end) {
+        /* Entries before the wrap were written during the previous lap. */
+        iter->ci_lap--;
+    }
+    iter->ci_last_pos = 0;
 }
 
 struct cbmem_entry_hdr *
@@ -158,11 +230,13 @@ cbmem_iter_next(struct cbmem *cbmem, struct cbmem_iter *iter)
 
     if (iter->ci_start > iter->ci_end) {
         hdr = iter->ci_cur;
+        iter->ci_last_pos = cbmem_entry_pos(cbmem, hdr, iter->ci_lap);
         iter->ci_cur = CBMEM_ENTRY_NEXT(iter->ci_cur);
 
         if ((uint8_t *) iter->ci_cur >= cbmem->c_buf_cur_end) {
             iter->ci_cur = (struct cbmem_entry_hdr *) cbmem->c_buf;
             iter->ci_start = (struct cbmem_entry_hdr *) cbmem->c_buf;
+            iter->ci_lap++;
         }
     } else {
         hdr = iter->ci_cur;
@@ -173,6 +247,7 @@ cbmem_iter_next(struct cbmem *cbmem, struct cbmem_iter *iter)
         if (hdr == CBMEM_ENTRY_NEXT(iter->ci_end)) {
             hdr = NULL;
         } else {
+            iter->ci_last_pos = cbmem_entry_pos(cbmem, hdr, iter->ci_lap);
             iter->ci_cur = CBMEM_ENTRY_NEXT(iter->ci_cur);
         }
     }
@@ -181,6 +256,41 @@ err:
     return (hdr);
 }
 
+/**
+ * Returns 1 if the entry last returned by cbmem_iter_next() has not been
+ * overwritten since; 0 if it has.  Calling this after reading an entry
+ * in place tells whether what was read is intact.  When it returns 0 the
+ * iterator must not be used further.
+ */
+int
+cbmem_iter_valid(struct cbmem *cbmem, struct cbmem_iter *iter)
+{
+    struct cbmem_entry_hdr *start;
+    struct cbmem_entry_hdr *end;
+    uint32_t seq;
+    uint32_t lap;
+
+    do {
+        seq = cbmem->c_seq;
+        __asm__ volatile ("" ::: "memory");
+        start = cbmem->c_entry_start;
+        end = cbmem->c_entry_end;
+        lap = cbmem->c_lap;
+        __asm__ volatile ("" ::: "memory");
+    } while ((seq & 1) || cbmem->c_seq != seq);
+
+    if (!start) {
+        return (0);
+    }
+    if (start > end) {
+        lap--;
+    }
+
+    /* Entries are only overwritten after start has moved past them. */
+    return ((int32_t) (iter->ci_last_pos -
+                cbmem_entry_pos(cbmem, start, lap)) >= 0);
+}
+
 int
 cbmem_flush(struct cbmem *cbmem)
 {
@@ -191,9 +301,12 @@ cbmem_flush(struct cbmem *cbmem)
         goto err;
     }
 
+    cbmem_seq_bump(cbmem);
     cbmem->c_entry_start = NULL;
     cbmem->c_entry_end = NULL;
     cbmem->c_buf_cur_end = NULL;
+    cbmem->c_lap++;
+    cbmem_seq_bump(cbmem);
 
     rc = cbmem_lock_release(cbmem);
     if (rc != 0) {
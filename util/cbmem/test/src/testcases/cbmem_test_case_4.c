@@ -0,0 +1,86 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "cbmem_test.h"
+
+#define CBMEM4_BUF_SIZE 256
+
+TEST_CASE(cbmem_test_case_4)
+{
+    static uint8_t buf[CBMEM4_BUF_SIZE];
+    struct cbmem_entry_hdr *hdr;
+    struct cbmem_iter iter;
+    struct cbmem cbmem;
+    uint8_t entry[60];
+    uint8_t *data;
+    uint8_t expected;
+    int rc;
+    int i;
+
+    rc = cbmem_init(&cbmem, buf, sizeof(buf));
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = cbmem_append_nolock(&cbmem, entry, sizeof(buf));
+    TEST_ASSERT(rc != 0, "Entry larger than buffer was accepted");
+
+    /* 64 byte entries; 4 fit, buffer wraps several times. */
+    for (i = 0; i < 10; i++) {
+        memset(entry, i, sizeof(entry));
+        rc = cbmem_append_nolock(&cbmem, entry, sizeof(entry));
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+
+    /* Read entries in place. */
+    expected = 6;
+    cbmem_iter_start(&cbmem, &iter);
+    while ((hdr = cbmem_iter_next(&cbmem, &iter)) != NULL) {
+        TEST_ASSERT_FATAL(hdr->ceh_len == sizeof(entry));
+        data = CBMEM_ENTRY_DATA(hdr);
+        TEST_ASSERT(data[0] == expected && data[sizeof(entry) - 1] == expected,
+                "Entry data %d, expected %d", data[0], expected);
+        TEST_ASSERT(cbmem_iter_valid(&cbmem, &iter));
+        expected++;
+    }
+    TEST_ASSERT(expected == 10, "Read up to %d", expected);
+
+    /* An entry overwritten while the reader has it must be detected. */
+    cbmem_iter_start(&cbmem, &iter);
+    hdr = cbmem_iter_next(&cbmem, &iter);
+    TEST_ASSERT_FATAL(hdr != NULL);
+    TEST_ASSERT(cbmem_iter_valid(&cbmem, &iter));
+    hdr = cbmem_iter_next(&cbmem, &iter);
+    TEST_ASSERT_FATAL(hdr != NULL);
+
+    rc = cbmem_append_nolock(&cbmem, entry, sizeof(entry));
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(cbmem_iter_valid(&cbmem, &iter));
+
+    rc = cbmem_append_nolock(&cbmem, entry, sizeof(entry));
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(!cbmem_iter_valid(&cbmem, &iter));
+
+    /* As is one dropped by a flush. */
+    cbmem_iter_start(&cbmem, &iter);
+    hdr = cbmem_iter_next(&cbmem, &iter);
+    TEST_ASSERT_FATAL(hdr != NULL);
+    rc = cbmem_flush(&cbmem);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = cbmem_append_nolock(&cbmem, entry, sizeof(entry));
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(!cbmem_iter_valid(&cbmem, &iter));
+}
@@ -0,0 +1,41 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _UTIL_CRC32_H_
+#define _UTIL_CRC32_H_
+
+#include <inttypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * CRC-32 as used by IEEE 802.3 and zlib.  Pre- and post-conditioning are
+ * done inside crc32_calc(), so the result of one call can be passed as
+ * initial_crc of the next to checksum data in pieces.
+ */
+#define CRC32_INITIAL_CRC       0       /* what to seed crc32 with */
+uint32_t crc32_calc(uint32_t initial_crc, const void *buf, int len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif